@@ -344,12 +344,20 @@ void CPUInfo::Detect()
 	// These two require ARMv8 or higher
 	bFP = CheckCPUFeature("fp");
 	bASIMD = CheckCPUFeature("asimd");
+	bCRC32 = CheckCPUFeature("crc32");
 	num_cores = GetCoreCount();
 #endif
 #if PPSSPP_ARCH(ARM64)
 	// Whether the above detection failed or not, on ARM64 we do have ASIMD/NEON.
 	bNEON = true;
 	bASIMD = true;
+#if PPSSPP_PLATFORM(IOS) || PPSSPP_PLATFORM(MAC)
+	// Every Apple ARM64 chip has the CRC32 extension.
+	bCRC32 = true;
+#elif PPSSPP_PLATFORM(WINDOWS)
+	// PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE, missing from some older SDKs.
+	bCRC32 = IsProcessorFeaturePresent(31) != 0;
+#endif
 #endif
 
 #if PPSSPP_ARCH(ARM) && defined(USE_CPU_FEATURES)
@@ -375,6 +383,7 @@ void CPUInfo::Detect()
 	bSVE = info.features.sve;
 	bSVE2 = info.features.sve2;
 	bFRINT = info.features.frint;
+	bCRC32 = info.features.crc32;
 #endif
 }
 
@@ -400,6 +409,7 @@ std::vector<std::string> CPUInfo::Features() {
 		{ bIDIVa, "IDIVa" },
 		{ bIDIVt, "IDIVt" },
 		{ bFRINT, "FRINT" },
+		{ bCRC32, "CRC32" },
 		{ bSVE, "SVE" },
 		{ bSVE2, "SVE2" },
 		{ CPU64bit, "64-bit" },
@@ -232,6 +232,7 @@ void CPUInfo::Detect() {
 	bSSE4_2 = info.features.sse4_2;
 	bSSE4A = info.features.sse4a;
 	bAES = info.features.aes;
+	bPCLMUL = info.features.pclmulqdq;
 	bSHA = info.features.sha;
 	bF16C = info.features.f16c;
 	bAVX = info.features.avx;
@@ -271,6 +272,7 @@ void CPUInfo::Detect() {
 				bFMA3 = true;
 		}
 		if ((cpu_id[2] >> 25) & 1) bAES = true;
+		if ((cpu_id[2] >> 1) & 1) bPCLMUL = true;
 #endif
 
 		if ((cpu_id[3] >> 24) & 1)
@@ -502,6 +504,7 @@ std::vector<std::string> CPUInfo::Features() {
 		{ bFMA3, "FMA3" },
 		{ bFMA4, "FMA4" },
 		{ bAES, "AES" },
+		{ bPCLMUL, "PCLMUL" },
 		{ bSHA, "SHA" },
 		{ bXOP, "XOP" },
 		{ bRTM, "TSX" },
@@ -68,6 +68,7 @@ struct CPUInfo {
 	bool bSSE4_2;
 	bool bSSE4A;
 	bool bAES;
+	bool bPCLMUL;
 	bool bSHA;
 	bool bF16C;
 	// x86 : SIMD 256 bit
@@ -94,6 +95,7 @@ struct CPUInfo {
 	// ARMv8 specific
 	bool bFP;
 	bool bASIMD;
+	bool bCRC32;
 	bool bSVE;
 	bool bSVE2;
 	bool bFRINT;
@@ -104,21 +104,26 @@ class FixedSizeQueue {
 		count_--;
 	}
 
-	/*
 	void push_array(const T *ptr, size_t num) {
-		// TODO: memcpy
-		for (size_t i = 0; i < num; i++) {
-			push(ptr[i]);
-		}
+		T *dest1, *dest2;
+		size_t sz1, sz2;
+		pushPointers(num, &dest1, &sz1, &dest2, &sz2);
+		memcpy(dest1, ptr, sz1 * sizeof(T));
+		if (dest2)
+			memcpy(dest2, ptr + sz1, sz2 * sizeof(T));
+	}
+
+	// Returns how many were actually popped, which is less than num if the queue runs out.
+	size_t pop_array(T *outptr, size_t num) {
+		const T *src1, *src2;
+		size_t sz1, sz2;
+		popPointers(num, &src1, &sz1, &src2, &sz2);
+		memcpy(outptr, src1, sz1 * sizeof(T));
+		if (src2)
+			memcpy(outptr + sz1, src2, sz2 * sizeof(T));
+		return sz1 + sz2;
 	}
 
-	void pop_array(T *outptr, size_t num) {
-		for (size_t i = 0; i < num; i++) {
-			outptr[i] = front();
-			pop();
-		}
-	}*/
-
 	T pop_front() {
 		const T &temp = storage_[head_];
 		pop();
@@ -4,10 +4,23 @@
 #include <cstring>
 #include <vector>
 
+#include "ppsspp_config.h"
 #include "ext/xxhash.h"
+#include "Common/BitSet.h"
+#include "Common/Common.h"
 #include "Common/CommonFuncs.h"
 #include "Common/Log.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#elif PPSSPP_ARCH(ARM64_NEON)
+#if defined(_MSC_VER)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 // TODO: Try hardware CRC. Unfortunately not available on older Intels or ARM32.
 // Seems to be ubiquitous on ARM64 though.
 template<class K>
@@ -336,3 +349,319 @@ class PrehashMap {
 	int count_ = 0;
 	int removedCount_ = 0;
 };
+
+// Control byte matching for SwissHashMap, 16 slots at a time. The masks have one bit set per
+// matching slot, at bit (index << SHIFT), to be walked with FirstIndex().
+struct SwissGroup {
+	enum : uint8_t {
+		// Tags are the top 7 bits of the hash, so these never match one.
+		EMPTY = 0x80,
+		// Only used while removals are deferred during Iterate().
+		DELETED = 0xFE,
+	};
+	static const int WIDTH = 16;
+
+#ifdef _M_SSE
+	typedef uint32_t Mask;
+	static const int SHIFT = 0;
+
+	static inline Mask Match(const uint8_t *ctrl, uint8_t tag) {
+		__m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+		return (Mask)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+	}
+
+	static inline int FirstIndex(Mask mask) {
+		return LeastSignificantSetBit(mask);
+	}
+#elif PPSSPP_ARCH(ARM64_NEON)
+	// No movemask on NEON, so narrow each byte comparison to 4 bits and keep one of them.
+	typedef uint64_t Mask;
+	static const int SHIFT = 2;
+
+	static inline Mask Match(const uint8_t *ctrl, uint8_t tag) {
+		uint8x16_t eq = vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(tag));
+		uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+		return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+	}
+
+	static inline int FirstIndex(Mask mask) {
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return (int)index >> SHIFT;
+#else
+		return __builtin_ctzll(mask) >> SHIFT;
+#endif
+	}
+#else
+	typedef uint32_t Mask;
+	static const int SHIFT = 0;
+
+	static inline Mask Match(const uint8_t *ctrl, uint8_t tag) {
+		Mask mask = 0;
+		for (int i = 0; i < WIDTH; i++) {
+			if (ctrl[i] == tag)
+				mask |= 1U << i;
+		}
+		return mask;
+	}
+
+	static inline int FirstIndex(Mask mask) {
+		return LeastSignificantSetBit(mask);
+	}
+#endif
+	// Keeps only the matches before the first empty slot (which must be set in empty.)
+	static inline Mask Before(Mask mask, Mask empty) {
+		return mask & ((empty & (0 - empty)) - 1);
+	}
+};
+
+struct SwissKeyHash {
+	template<class K>
+	uint32_t operator()(const K &k) const {
+		return HashKey(k);
+	}
+};
+
+// For keys that are already well-distributed hashes.
+struct SwissIdentityHash {
+	uint32_t operator()(uint32_t k) const {
+		return k;
+	}
+};
+
+// Same interface as DenseHashMap, but keeps a byte of metadata per slot (7 bits of the hash, or
+// EMPTY) in a separate array, so a lookup can check 16 slots with a couple of SIMD instructions
+// and only touch the keys that likely match. Still linear probing slot by slot, which means
+// removal can shift the following entries back instead of leaving tombstones, so there's no
+// need for Maintain() and lookups don't slow down as entries come and go.
+//
+// Removing entries from inside Iterate() is allowed, those are shifted out when it returns.
+// Values are still expected to be small, see DenseHashMap.
+template <class Key, class Value, Value NullValue, class Hasher = SwissKeyHash>
+class SwissHashMap {
+public:
+	SwissHashMap(int initialCapacity) {
+		// The group loads need at least one full group of real slots.
+		int capacity = SwissGroup::WIDTH;
+		while (capacity < initialCapacity)
+			capacity *= 2;
+		Allocate(capacity);
+	}
+
+	// Returns NullValue if no entry was found.
+	Value Get(const Key &key) const {
+		return Get(key, Hasher()(key));
+	}
+	// For callers that already have the hash of the key (must be the same as Hasher gives.)
+	Value Get(const Key &key, uint32_t hash) const {
+		int slot = Find(key, hash, Tag(hash));
+		return slot >= 0 ? map[slot].value : NullValue;
+	}
+
+	// Returns false if we already had the key! Which is a bit different.
+	bool Insert(const Key &key, Value value) {
+		return Insert(key, value, Hasher()(key));
+	}
+	bool Insert(const Key &key, Value value, uint32_t hash) {
+		if (Find(key, hash, Tag(hash)) >= 0) {
+			_assert_msg_(false, "SwissHashMap: Duplicate key of size %d inserted", (int)sizeof(Key));
+			return false;
+		}
+		// Linear probing degrades quickly when fuller than this. We never shrink.
+		if (count_ >= capacity_ - capacity_ / 4) {
+			Grow(2);
+		}
+		int slot = FindEmpty(hash);
+		SetCtrl(slot, Tag(hash));
+		map[slot].key = key;
+		map[slot].value = value;
+		count_++;
+		return true;
+	}
+
+	bool Remove(const Key &key) {
+		uint32_t hash = Hasher()(key);
+		int slot = Find(key, hash, Tag(hash));
+		if (slot < 0)
+			return false;
+		count_--;
+		if (iterating_ != 0) {
+			// Can't move anything around under Iterate(), so leave a marker that no tag matches.
+			SetCtrl(slot, SwissGroup::DELETED);
+			deferred_.push_back(key);
+		} else {
+			Erase(slot);
+		}
+		return true;
+	}
+
+	size_t size() const {
+		return count_;
+	}
+
+	template<class T>
+	inline void Iterate(T func) const {
+		iterating_++;
+		for (int i = 0; i < capacity_; i++) {
+			if (IsFull(ctrl_[i])) {
+				func(map[i].key, map[i].value);
+			}
+		}
+		if (--iterating_ == 0 && !deferred_.empty()) {
+			const_cast<SwissHashMap *>(this)->EraseDeferred();
+		}
+	}
+
+	template<class T>
+	inline void IterateMut(T func) {
+		iterating_++;
+		for (int i = 0; i < capacity_; i++) {
+			if (IsFull(ctrl_[i])) {
+				func(map[i].key, map[i].value);
+			}
+		}
+		if (--iterating_ == 0 && !deferred_.empty()) {
+			EraseDeferred();
+		}
+	}
+
+	// Note! Does NOT delete any pointed-to data (in case you stored pointers in the map).
+	void Clear() {
+		memset(ctrl_.data(), SwissGroup::EMPTY, ctrl_.size());
+		count_ = 0;
+		deferred_.clear();
+	}
+
+	void Rebuild() {
+		Grow(1);
+	}
+
+	// Nothing to clean up, removal doesn't leave tombstones. Kept for compatibility with DenseHashMap.
+	void Maintain() {
+	}
+
+private:
+	static inline uint8_t Tag(uint32_t hash) {
+		return (uint8_t)(hash >> 25);
+	}
+	static inline bool IsFull(uint8_t ctrl) {
+		return (ctrl & 0x80) == 0;
+	}
+
+	void Allocate(int capacity) {
+		capacity_ = capacity;
+		map.clear();
+		map.resize(capacity);
+		// The first WIDTH - 1 control bytes are mirrored after the end, so a group can be
+		// loaded at any slot without wrapping.
+		ctrl_.assign(capacity + SwissGroup::WIDTH - 1, SwissGroup::EMPTY);
+	}
+
+	inline void SetCtrl(int slot, uint8_t value) {
+		ctrl_[slot] = value;
+		if (slot < SwissGroup::WIDTH - 1)
+			ctrl_[capacity_ + slot] = value;
+	}
+
+	// Entries sit somewhere between their home slot and the first empty slot after it.
+	int Find(const Key &key, uint32_t hash, uint8_t tag) const {
+		uint32_t mask = capacity_ - 1;
+		uint32_t pos = hash & mask;
+		for (int probed = 0; probed < capacity_; probed += SwissGroup::WIDTH) {
+			const uint8_t *group = &ctrl_[pos];
+			SwissGroup::Mask match = SwissGroup::Match(group, tag);
+			SwissGroup::Mask empty = SwissGroup::Match(group, SwissGroup::EMPTY);
+			if (empty != 0)
+				match = SwissGroup::Before(match, empty);
+			while (match != 0) {
+				uint32_t slot = (pos + SwissGroup::FirstIndex(match)) & mask;
+				if (KeyEquals(key, map[slot].key))
+					return (int)slot;
+				match &= match - 1;
+			}
+			if (empty != 0)
+				return -1;
+			pos = (pos + SwissGroup::WIDTH) & mask;
+		}
+		return -1;
+	}
+
+	int FindEmpty(uint32_t hash) const {
+		uint32_t mask = capacity_ - 1;
+		uint32_t pos = hash & mask;
+		while (true) {
+			SwissGroup::Mask empty = SwissGroup::Match(&ctrl_[pos], SwissGroup::EMPTY);
+			if (empty != 0)
+				return (int)((pos + SwissGroup::FirstIndex(empty)) & mask);
+			pos = (pos + SwissGroup::WIDTH) & mask;
+		}
+	}
+
+	// Backward shift deletion: pull later entries of the same run into the hole, as long as
+	// that doesn't move them before their home slot.
+	void Erase(int slot) {
+		uint32_t mask = capacity_ - 1;
+		uint32_t hole = slot;
+		uint32_t next = hole;
+		while (true) {
+			next = (next + 1) & mask;
+			uint8_t ctrl = ctrl_[next];
+			if (ctrl == SwissGroup::EMPTY)
+				break;
+			uint32_t home = Hasher()(map[next].key) & mask;
+			// Can it stay? Only if its home is cyclically within (hole, next].
+			bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+			if (!stays) {
+				map[hole] = map[next];
+				SetCtrl(hole, ctrl);
+				hole = next;
+			}
+		}
+		SetCtrl(hole, SwissGroup::EMPTY);
+	}
+
+	void EraseDeferred() {
+		std::vector<Key> keys = std::move(deferred_);
+		deferred_.clear();
+		for (const Key &key : keys) {
+			int slot = Find(key, Hasher()(key), SwissGroup::DELETED);
+			_assert_msg_(slot >= 0, "SwissHashMap: Lost a deferred removal");
+			if (slot >= 0)
+				Erase(slot);
+		}
+	}
+
+	void Grow(int factor) {
+		// We simply move out the existing data, then we re-insert the old.
+		// This is extremely non-atomic and will need synchronization.
+		_assert_msg_(iterating_ == 0, "SwissHashMap: Can't grow during Iterate()");
+		std::vector<Pair> old = std::move(map);
+		std::vector<uint8_t> oldCtrl = std::move(ctrl_);
+		int oldCapacity = capacity_;
+		Allocate(capacity_ * factor);
+		for (int i = 0; i < oldCapacity; i++) {
+			if (IsFull(oldCtrl[i])) {
+				uint32_t hash = Hasher()(old[i].key);
+				int slot = FindEmpty(hash);
+				SetCtrl(slot, Tag(hash));
+				map[slot] = old[i];
+			}
+		}
+	}
+
+	struct Pair {
+		Key key;
+		Value value;
+	};
+	std::vector<Pair> map;
+	std::vector<uint8_t> ctrl_;
+	int capacity_ = 0;
+	int count_ = 0;
+	mutable int iterating_ = 0;
+	std::vector<Key> deferred_;
+};
+
+// Like PrehashMap, the keys are expected to already be well-distributed hashes.
+template <class Value, Value NullValue>
+using SwissPrehashMap = SwissHashMap<uint32_t, Value, NullValue, SwissIdentityHash>;
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "Common/Log.h"
+
+// Bump allocator for short-lived data, where everything is thrown away at once with Reset().
+// Individual frees are no-ops, except that the most recent allocation can be given back.
+//
+// After a Reset(), if the previous round needed more than one block, they are merged into one
+// big enough for all of it, so in steady state there's no malloc traffic at all.
+// Not thread safe.
+class LinearArena {
+public:
+	explicit LinearArena(size_t blockSize = 64 * 1024) : blockSize_(blockSize) {}
+	~LinearArena() {
+		for (Block &block : blocks_)
+			free(block.data);
+	}
+
+	LinearArena(const LinearArena &) = delete;
+	LinearArena &operator =(const LinearArena &) = delete;
+
+	void *Allocate(size_t size, size_t align = 16) {
+		if (current_ < blocks_.size()) {
+			Block &block = blocks_[current_];
+			uintptr_t start = (uintptr_t)block.data;
+			size_t pos = (size_t)(((start + block.used + align - 1) & ~(uintptr_t)(align - 1)) - start);
+			if (pos + size <= block.size) {
+				block.used = pos + size;
+				last_ = block.data + pos;
+				return last_;
+			}
+		}
+		return AllocateSlow(size, align);
+	}
+
+	template <class T>
+	T *AllocateArray(size_t count) {
+		return (T *)Allocate(sizeof(T) * count, alignof(T) > 16 ? alignof(T) : 16);
+	}
+
+	// Like new T[count], but nothing is ever destructed.
+	template <class T>
+	T *NewArray(size_t count) {
+		static_assert(std::is_trivially_destructible<T>::value, "LinearArena never runs destructors");
+		T *ptr = AllocateArray<T>(count);
+		for (size_t i = 0; i < count; i++)
+			new (&ptr[i]) T();
+		return ptr;
+	}
+
+	// Only has an effect if ptr was the most recent allocation.
+	void Free(void *ptr, size_t size) {
+		if (ptr != nullptr && ptr == last_) {
+			Block &block = blocks_[current_];
+			if ((uint8_t *)ptr + size == block.data + block.used)
+				block.used -= size;
+			last_ = nullptr;
+		}
+	}
+
+	// Invalidates everything allocated so far.
+	void Reset() {
+		if (blocks_.size() > 1) {
+			size_t total = 0;
+			for (Block &block : blocks_) {
+				total += block.size;
+				free(block.data);
+			}
+			blocks_.clear();
+			AddBlock(total);
+		} else if (!blocks_.empty()) {
+			blocks_[0].used = 0;
+		}
+		current_ = 0;
+		last_ = nullptr;
+	}
+
+	size_t BytesUsed() const {
+		size_t used = 0;
+		for (size_t i = 0; i <= current_ && i < blocks_.size(); i++)
+			used += blocks_[i].used;
+		return used;
+	}
+
+	size_t BytesReserved() const {
+		size_t total = 0;
+		for (const Block &block : blocks_)
+			total += block.size;
+		return total;
+	}
+
+private:
+	struct Block {
+		uint8_t *data;
+		size_t size;
+		size_t used;
+	};
+
+	void *AllocateSlow(size_t size, size_t align) {
+		size_t needed = size + align;
+		AddBlock(needed > blockSize_ ? needed : blockSize_);
+		current_ = blocks_.size() - 1;
+		return Allocate(size, align);
+	}
+
+	void AddBlock(size_t size) {
+		uint8_t *data = (uint8_t *)malloc(size);
+		_assert_msg_(data != nullptr, "LinearArena: Failed to allocate %d bytes", (int)size);
+		blocks_.push_back(Block{ data, size, 0 });
+	}
+
+	std::vector<Block> blocks_;
+	size_t blockSize_;
+	size_t current_ = 0;
+	uint8_t *last_ = nullptr;
+};
+
+// Allocator adapter so standard containers can live in a LinearArena. The containers must not
+// outlive the arena's next Reset().
+template <class T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+
+	ArenaAllocator(LinearArena &arena) : arena_(&arena) {}
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.arena_) {}
+
+	T *allocate(size_t n) {
+		return arena_->AllocateArray<T>(n);
+	}
+	void deallocate(T *p, size_t n) {
+		arena_->Free(p, sizeof(T) * n);
+	}
+
+	template <class U>
+	bool operator ==(const ArenaAllocator<U> &other) const {
+		return arena_ == other.arena_;
+	}
+	template <class U>
+	bool operator !=(const ArenaAllocator<U> &other) const {
+		return arena_ != other.arena_;
+	}
+
+private:
+	template <class U>
+	friend class ArenaAllocator;
+
+	LinearArena *arena_;
+};
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
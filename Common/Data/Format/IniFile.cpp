@@ -4,6 +4,7 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 
 #ifndef _MSC_VER
 #include <strings.h>
@@ -12,7 +13,7 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
-#include <sstream>
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -157,15 +158,43 @@ static std::string EscapeComments(const std::string &value) {
 	return result;
 }
 
+// Without allocating, rules out lines that can't have this key. Lines with escapes in the
+// key part are left to ParseLine.
+static bool LineMayHaveKey(const std::string &line, const char *key, size_t keyLen) {
+	if (line.size() < 2 || line[0] == ';')
+		return keyLen == 0;
+
+	size_t end = line.find_first_of("=#\\");
+	if (end == line.npos || line[end] == '#') {
+		// No key at all, same as when ParseLine fails.
+		return keyLen == 0;
+	} else if (line[end] == '\\') {
+		return true;
+	}
+
+	auto isSpace = [](char c) {
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	};
+	size_t start = 0;
+	while (start < end && isSpace(line[start]))
+		start++;
+	while (end > start && isSpace(line[end - 1]))
+		end--;
+	return end - start == keyLen && strncasecmp(line.c_str() + start, key, keyLen) == 0;
+}
+
 void Section::Clear() {
 	lines.clear();
 }
 
 std::string* Section::GetLine(const char* key, std::string* valueOut, std::string* commentOut)
 {
+	size_t keyLen = strlen(key);
 	for (std::vector<std::string>::iterator iter = lines.begin(); iter != lines.end(); ++iter)
 	{
 		std::string& line = *iter;
+		if (!LineMayHaveKey(line, key, keyLen))
+			continue;
 		std::string lineKey;
 		ParseLine(line, &lineKey, valueOut, commentOut);
 		if (!strcasecmp(lineKey.c_str(), key))
@@ -176,9 +205,12 @@ std::string* Section::GetLine(const char* key, std::string* valueOut, std::strin
 
 const std::string* Section::GetLine(const char* key, std::string* valueOut, std::string* commentOut) const
 {
+	size_t keyLen = strlen(key);
 	for (std::vector<std::string>::const_iterator iter = lines.begin(); iter != lines.end(); ++iter)
 	{
 		const std::string& line = *iter;
+		if (!LineMayHaveKey(line, key, keyLen))
+			continue;
 		std::string lineKey;
 		ParseLine(line, &lineKey, valueOut, commentOut);
 		if (!strcasecmp(lineKey.c_str(), key))
@@ -378,8 +410,11 @@ bool Section::Get(const char* key, double* value, double defaultValue) const
 
 bool Section::Exists(const char *key) const
 {
+	size_t keyLen = strlen(key);
 	for (std::vector<std::string>::const_iterator iter = lines.begin(); iter != lines.end(); ++iter)
 	{
+		if (!LineMayHaveKey(*iter, key, keyLen))
+			continue;
 		std::string lineKey;
 		ParseLine(*iter, &lineKey, NULL, NULL);
 		if (!strcasecmp(lineKey.c_str(), key))
@@ -562,9 +597,7 @@ bool IniFile::Load(const Path &path)
 	if (!File::ReadFileToString(true, path, data)) {
 		return false;
 	}
-	std::stringstream sstream(data);
-	bool success = Load(sstream);
-	return success;
+	return Load(data.data(), data.size());
 }
 
 bool IniFile::LoadFromVFS(VFSInterface &vfs, const std::string &filename) {
@@ -572,59 +605,62 @@ bool IniFile::LoadFromVFS(VFSInterface &vfs, const std::string &filename) {
 	uint8_t *data = vfs.ReadFile(filename.c_str(), &size);
 	if (!data)
 		return false;
-	std::string str((const char*)data, size);
+	bool success = Load((const char *)data, size);
 	delete [] data;
-
-	std::stringstream sstream(str);
-	return Load(sstream);
+	return success;
 }
 
 bool IniFile::Load(std::istream &in) {
-	// Maximum number of letters in a line
-	static const int MAX_BYTES = 1024*32;
-	char *templine = new char[MAX_BYTES];  // avoid using up massive stack space
+	std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	return Load(data.data(), data.size());
+}
 
-	while (!(in.eof() || in.fail()))
-	{
-		in.getline(templine, MAX_BYTES);
-		std::string line = templine;
+bool IniFile::Load(const char *data, size_t size) {
+	// Goes straight over the buffer, each line is only copied once, into its section.
+	const char *end = data + size;
+	const char *pos = data;
+	while (pos < end) {
+		const char *lineEnd = (const char *)memchr(pos, '\n', end - pos);
+		if (!lineEnd)
+			lineEnd = end;
+		const char *lineStart = pos;
+		pos = lineEnd + 1;
 
 		// Remove UTF-8 byte order marks.
-		if (line.substr(0, 3) == "\xEF\xBB\xBF") {
-			line = line.substr(3);
+		if (lineEnd - lineStart >= 3 && memcmp(lineStart, "\xEF\xBB\xBF", 3) == 0) {
+			lineStart += 3;
 		}
-		 
-#ifndef _WIN32
 		// Check for CRLF eol and convert it to LF
-		if (!line.empty() && line.at(line.size()-1) == '\r') {
-			line.erase(line.size()-1);
+		if (lineEnd > lineStart && lineEnd[-1] == '\r') {
+			lineEnd--;
+		}
+		// Like getline, stop at any null.
+		const char *nullChar = (const char *)memchr(lineStart, '\0', lineEnd - lineStart);
+		if (nullChar)
+			lineEnd = nullChar;
+		if (lineEnd == lineStart)
+			continue;
+
+		const char *sectionNameEnd = nullptr;
+		if (lineStart[0] == '[') {
+			sectionNameEnd = (const char *)memchr(lineStart, ']', lineEnd - lineStart);
 		}
-#endif
 
-		if (!line.empty()) {
-			size_t sectionNameEnd = std::string::npos;
-			if (line[0] == '[') {
-				sectionNameEnd = line.find(']');
-			}
+		if (sectionNameEnd) {
+			// New section!
+			sections.push_back(Section(std::string(lineStart + 1, sectionNameEnd)));
 
-			if (sectionNameEnd != std::string::npos) {
-				// New section!
-				std::string sub = line.substr(1, sectionNameEnd - 1);
-				sections.push_back(Section(sub));
-
-				if (sectionNameEnd + 1 < line.size()) {
-					sections[sections.size() - 1].comment = line.substr(sectionNameEnd + 1);
-				}
-			} else {
-				if (sections.empty()) {
-					sections.push_back(Section(""));
-				}
-				sections[sections.size() - 1].lines.push_back(line);
+			if (sectionNameEnd + 1 < lineEnd) {
+				sections.back().comment.assign(sectionNameEnd + 1, lineEnd);
+			}
+		} else {
+			if (sections.empty()) {
+				sections.push_back(Section(""));
 			}
+			sections.back().lines.emplace_back(lineStart, lineEnd);
 		}
 	}
 
-	delete[] templine;
 	return true;
 }
 
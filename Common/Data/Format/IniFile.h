@@ -88,6 +88,8 @@ class IniFile {
 	bool Load(const Path &path);
 	bool Load(const std::string &filename) { return Load(Path(filename)); }
 	bool Load(std::istream &istream);
+	// Appends to the existing sections, like the istream version.
+	bool Load(const char *data, size_t size);
 	bool LoadFromVFS(VFSInterface &vfs, const std::string &filename);
 
 	bool Save(const Path &path);
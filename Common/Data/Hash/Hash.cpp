@@ -1,6 +1,26 @@
+#include "ppsspp_config.h"
 #include <cstdint>
+#include <cstring>
+#include "zlib.h"
+#include "Common/Common.h"
+#include "Common/CPUDetect.h"
 #include "Common/Data/Hash/Hash.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM64) && (defined(__GNUC__) || defined(__clang__))
+#include <arm_acle.h>
+#define HAVE_ARMV8_CRC32 1
+#ifdef __clang__
+#define ARMV8_CRC32_TARGET __attribute__((target("crc")))
+#else
+#define ARMV8_CRC32_TARGET __attribute__((target("+crc")))
+#endif
+#endif
+
 namespace hash {
 
 // Implementation from Wikipedia
@@ -34,4 +54,147 @@ uint32_t Adler32(const uint8_t *data, size_t len) {
 	return (b << 16) | a;
 }
 
+#ifdef _M_SSE
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PCLMUL_TARGET __attribute__((target("pclmul")))
+#else
+#define PCLMUL_TARGET
+#endif
+
+// Folds 64 bytes at a time with carry-less multiplies, then Barrett-reduces down to 32 bits.
+// See Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+// len must be a multiple of 16 and at least 64. Takes and returns the non-inverted CRC state.
+PCLMUL_TARGET static uint32_t Crc32PCLMUL(uint32_t crc, const uint8_t *buf, size_t len) {
+	alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+	alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+	alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+	alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+	__m128i x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+	__m128i x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+	__m128i x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+	__m128i x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+
+	__m128i k = _mm_load_si128((const __m128i *)k1k2);
+	buf += 64;
+	len -= 64;
+
+	while (len >= 64) {
+		__m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+		__m128i x6 = _mm_clmulepi64_si128(x2, k, 0x00);
+		__m128i x7 = _mm_clmulepi64_si128(x3, k, 0x00);
+		__m128i x8 = _mm_clmulepi64_si128(x4, k, 0x00);
+
+		x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, k, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, k, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, k, 0x11);
+
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(buf + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(buf + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(buf + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(buf + 0x30)));
+
+		buf += 64;
+		len -= 64;
+	}
+
+	// Fold the four lanes into one.
+	k = _mm_load_si128((const __m128i *)k3k4);
+	__m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	// Then any remaining 16 byte blocks.
+	while (len >= 16) {
+		x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)buf)), x5);
+		buf += 16;
+		len -= 16;
+	}
+
+	// 128 bits down to 64.
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+	k = _mm_loadl_epi64((const __m128i *)k5k0);
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_clmulepi64_si128(x1, k, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	// Barrett reduction to 32 bits.
+	k = _mm_load_si128((const __m128i *)poly);
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, k, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, k, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	return (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+#endif
+
+#ifdef HAVE_ARMV8_CRC32
+
+ARMV8_CRC32_TARGET static uint32_t Crc32ARMv8(uint32_t crc, const uint8_t *buf, size_t len) {
+	crc = ~crc;
+	for (; len >= 32; len -= 32, buf += 32) {
+		uint64_t v[4];
+		memcpy(v, buf, sizeof(v));
+		crc = __crc32d(crc, v[0]);
+		crc = __crc32d(crc, v[1]);
+		crc = __crc32d(crc, v[2]);
+		crc = __crc32d(crc, v[3]);
+	}
+	for (; len >= 8; len -= 8, buf += 8) {
+		uint64_t v;
+		memcpy(&v, buf, sizeof(v));
+		crc = __crc32d(crc, v);
+	}
+	for (; len > 0; --len, ++buf)
+		crc = __crc32b(crc, *buf);
+	return ~crc;
+}
+
+#endif
+
+uint32_t Crc32(uint32_t crc, const uint8_t *data, size_t len) {
+#ifdef _M_SSE
+	if (cpu_info.bPCLMUL && len >= 64) {
+		size_t chunk = len & ~(size_t)15;
+		crc = ~Crc32PCLMUL(~crc, data, chunk);
+		data += chunk;
+		len -= chunk;
+		if (len == 0)
+			return crc;
+	}
+#endif
+#ifdef HAVE_ARMV8_CRC32
+	if (cpu_info.bCRC32)
+		return Crc32ARMv8(crc, data, len);
+#endif
+	// zlib takes a uInt length.
+	while (len > 0) {
+		uInt chunk = len > 0x40000000 ? 0x40000000 : (uInt)len;
+		crc = (uint32_t)crc32(crc, data, chunk);
+		data += chunk;
+		len -= chunk;
+	}
+	return crc;
+}
+
 }  // namespace hash
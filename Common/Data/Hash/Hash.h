@@ -1,11 +1,16 @@
 #pragma once
 
 #include <cstdlib>
+#include <cstdint>
 
 namespace hash {
 
 // Fairly decent function for hashing strings.
 uint32_t Adler32(const uint8_t *data, size_t len);
 
+// Same result as zlib's crc32(crc, data, len), but uses PCLMUL (x86) or the ARMv8 CRC32
+// instructions when the CPU has them.
+uint32_t Crc32(uint32_t crc, const uint8_t *data, size_t len);
+
 }  // namespace hash
 
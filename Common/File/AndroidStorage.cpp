@@ -1,4 +1,6 @@
 #include <inttypes.h>
+#include <mutex>
+#include <unordered_map>
 
 #include "Common/File/AndroidStorage.h"
 #include "Common/StringUtils.h"
@@ -26,6 +28,73 @@ static jmethodID computeRecursiveDirectorySize;
 
 static jobject g_nativeActivity;
 
+// Every query through the ContentResolver costs a JNI round trip, often milliseconds. Directory
+// listings already return size and mtime for each entry, so remember them for a little while and
+// answer file info and exists queries for those entries without going back to Java.
+// Anything we change ourselves drops the whole cache, changes from outside expire.
+static const double CONTENT_CACHE_LIFETIME = 3.0;
+static const size_t CONTENT_CACHE_MAX_ENTRIES = 8192;
+
+struct CachedListing {
+	double time;
+	std::vector<File::FileInfo> items;
+};
+
+struct CachedFileInfo {
+	double time;
+	File::FileInfo info;
+};
+
+static std::mutex g_contentCacheLock;
+static std::unordered_map<std::string, CachedListing> g_cachedListings;
+static std::unordered_map<std::string, CachedFileInfo> g_cachedFileInfo;
+
+static void InvalidateContentCache() {
+	std::lock_guard<std::mutex> guard(g_contentCacheLock);
+	g_cachedListings.clear();
+	g_cachedFileInfo.clear();
+}
+
+// Returns 1 if found, 0 if known not to exist, -1 if unknown.
+static int LookupCachedFileInfo(const std::string &fileUri, File::FileInfo *info) {
+	double now = time_now_d();
+	std::lock_guard<std::mutex> guard(g_contentCacheLock);
+	auto it = g_cachedFileInfo.find(fileUri);
+	if (it != g_cachedFileInfo.end() && now - it->second.time < CONTENT_CACHE_LIFETIME) {
+		if (info)
+			*info = it->second.info;
+		return 1;
+	}
+
+	// Not in there, but if we recently listed the parent, it doesn't exist. Only trust that if the
+	// URI is spelled the way the listing would have spelled it.
+	Path path(fileUri);
+	if (!path.CanNavigateUp())
+		return -1;
+	Path parent = path.NavigateUp();
+	if ((parent / path.GetFilename()).ToString() != fileUri)
+		return -1;
+	auto listing = g_cachedListings.find(parent.ToString());
+	if (listing != g_cachedListings.end() && now - listing->second.time < CONTENT_CACHE_LIFETIME)
+		return 0;
+	return -1;
+}
+
+static void CacheListing(const std::string &path, const std::vector<File::FileInfo> &items) {
+	double now = time_now_d();
+	std::lock_guard<std::mutex> guard(g_contentCacheLock);
+	if (g_cachedFileInfo.size() + items.size() > CONTENT_CACHE_MAX_ENTRIES) {
+		g_cachedListings.clear();
+		g_cachedFileInfo.clear();
+		if (items.size() > CONTENT_CACHE_MAX_ENTRIES)
+			return;
+	}
+	g_cachedListings[path] = CachedListing{ now, items };
+	for (const File::FileInfo &info : items) {
+		g_cachedFileInfo[info.fullName.ToString()] = CachedFileInfo{ now, info };
+	}
+}
+
 void Android_StorageSetNativeActivity(jobject nativeActivity) {
 	g_nativeActivity = nativeActivity;
 }
@@ -86,6 +155,10 @@ int Android_OpenContentUriFd(const std::string &filename, Android_OpenContentUri
 	jstring j_filename = env->NewStringUTF(fname.c_str());
 	jstring j_mode = env->NewStringUTF(modeStr);
 	int fd = env->CallIntMethod(g_nativeActivity, openContentUri, j_filename, j_mode);
+	if (mode != Android_OpenContentUriMode::READ) {
+		// Might have been created or truncated, and size and mtime will change.
+		InvalidateContentCache();
+	}
 	return fd;
 }
 
@@ -96,7 +169,9 @@ StorageError Android_CreateDirectory(const std::string &rootTreeUri, const std::
 	auto env = getEnv();
 	jstring paramRoot = env->NewStringUTF(rootTreeUri.c_str());
 	jstring paramDirName = env->NewStringUTF(dirName.c_str());
-	return StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriCreateDirectory, paramRoot, paramDirName));
+	StorageError error = StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriCreateDirectory, paramRoot, paramDirName));
+	InvalidateContentCache();
+	return error;
 }
 
 StorageError Android_CreateFile(const std::string &parentTreeUri, const std::string &fileName) {
@@ -106,7 +181,9 @@ StorageError Android_CreateFile(const std::string &parentTreeUri, const std::str
 	auto env = getEnv();
 	jstring paramRoot = env->NewStringUTF(parentTreeUri.c_str());
 	jstring paramFileName = env->NewStringUTF(fileName.c_str());
-	return StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriCreateFile, paramRoot, paramFileName));
+	StorageError error = StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriCreateFile, paramRoot, paramFileName));
+	InvalidateContentCache();
+	return error;
 }
 
 StorageError Android_CopyFile(const std::string &fileUri, const std::string &destParentUri) {
@@ -116,7 +193,9 @@ StorageError Android_CopyFile(const std::string &fileUri, const std::string &des
 	auto env = getEnv();
 	jstring paramFileName = env->NewStringUTF(fileUri.c_str());
 	jstring paramDestParentUri = env->NewStringUTF(destParentUri.c_str());
-	return StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriCopyFile, paramFileName, paramDestParentUri));
+	StorageError error = StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriCopyFile, paramFileName, paramDestParentUri));
+	InvalidateContentCache();
+	return error;
 }
 
 StorageError Android_MoveFile(const std::string &fileUri, const std::string &srcParentUri, const std::string &destParentUri) {
@@ -127,7 +206,9 @@ StorageError Android_MoveFile(const std::string &fileUri, const std::string &src
 	jstring paramFileName = env->NewStringUTF(fileUri.c_str());
 	jstring paramSrcParentUri = env->NewStringUTF(srcParentUri.c_str());
 	jstring paramDestParentUri = env->NewStringUTF(destParentUri.c_str());
-	return StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriMoveFile, paramFileName, paramSrcParentUri, paramDestParentUri));
+	StorageError error = StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriMoveFile, paramFileName, paramSrcParentUri, paramDestParentUri));
+	InvalidateContentCache();
+	return error;
 }
 
 StorageError Android_RemoveFile(const std::string &fileUri) {
@@ -136,7 +217,9 @@ StorageError Android_RemoveFile(const std::string &fileUri) {
 	}
 	auto env = getEnv();
 	jstring paramFileName = env->NewStringUTF(fileUri.c_str());
-	return StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriRemoveFile, paramFileName));
+	StorageError error = StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriRemoveFile, paramFileName));
+	InvalidateContentCache();
+	return error;
 }
 
 StorageError Android_RenameFileTo(const std::string &fileUri, const std::string &newName) {
@@ -146,7 +229,9 @@ StorageError Android_RenameFileTo(const std::string &fileUri, const std::string
 	auto env = getEnv();
 	jstring paramFileUri = env->NewStringUTF(fileUri.c_str());
 	jstring paramNewName = env->NewStringUTF(newName.c_str());
-	return StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriRenameFileTo, paramFileUri, paramNewName));
+	StorageError error = StorageErrorFromInt(env->CallIntMethod(g_nativeActivity, contentUriRenameFileTo, paramFileUri, paramNewName));
+	InvalidateContentCache();
+	return error;
 }
 
 // NOTE: Does not set fullName - you're supposed to already know it.
@@ -183,6 +268,10 @@ bool Android_GetFileInfo(const std::string &fileUri, File::FileInfo *fileInfo) {
 	if (!g_nativeActivity) {
 		return false;
 	}
+	int cached = LookupCachedFileInfo(fileUri, fileInfo);
+	if (cached >= 0) {
+		return cached == 1;
+	}
 	auto env = getEnv();
 	jstring paramFileUri = env->NewStringUTF(fileUri.c_str());
 
@@ -202,6 +291,10 @@ bool Android_FileExists(const std::string &fileUri) {
 	if (!g_nativeActivity) {
 		return false;
 	}
+	int cached = LookupCachedFileInfo(fileUri, nullptr);
+	if (cached >= 0) {
+		return cached == 1;
+	}
 	auto env = getEnv();
 	jstring paramFileUri = env->NewStringUTF(fileUri.c_str());
 	bool exists = env->CallBooleanMethod(g_nativeActivity, contentUriFileExists, paramFileUri);
@@ -213,11 +306,19 @@ std::vector<File::FileInfo> Android_ListContentUri(const std::string &path, bool
 		*exists = false;
 		return std::vector<File::FileInfo>();
 	}
+	double start = time_now_d();
+	{
+		std::lock_guard<std::mutex> guard(g_contentCacheLock);
+		auto it = g_cachedListings.find(path);
+		if (it != g_cachedListings.end() && start - it->second.time < CONTENT_CACHE_LIFETIME) {
+			*exists = true;
+			return it->second.items;
+		}
+	}
+
 	auto env = getEnv();
 	*exists = true;
 
-	double start = time_now_d();
-
 	jstring param = env->NewStringUTF(path.c_str());
 	jobject retval = env->CallObjectMethod(g_nativeActivity, listContentUriDir, param);
 
@@ -244,6 +345,10 @@ std::vector<File::FileInfo> Android_ListContentUri(const std::string &path, bool
 	}
 	env->DeleteLocalRef(fileList);
 
+	if (*exists) {
+		CacheListing(path, items);
+	}
+
 	double elapsed = time_now_d() - start;
 	if (elapsed > 0.1) {
 		INFO_LOG(FILESYS, "Listing directory on content URI took %0.3f s (%d files)", elapsed, (int)items.size());
@@ -13,6 +13,8 @@
 #include "android/jni/AndroidContentURI.h"
 
 #if HOST_IS_CASE_SENSITIVE
+#include <mutex>
+#include <unordered_map>
 #include <dirent.h>
 #include <unistd.h>
 #include <sys/stat.h>
@@ -381,6 +383,12 @@ bool Path::ComputePathTo(const Path &other, std::string &path) const {
 
 #if HOST_IS_CASE_SENSITIVE
 
+// Directory path -> (lowercased name -> name on disk). Hits are verified against the disk
+// before use and misses always rescan, so files created or removed behind our back are fine.
+static std::mutex g_caseCacheLock;
+static std::unordered_map<std::string, std::unordered_map<std::string, std::string>> g_caseCache;
+static const size_t MAX_CASE_CACHE_DIRS = 256;
+
 static bool FixFilenameCase(const std::string &path, std::string &filename) {
 	// Are we lucky?
 	if (File::Exists(Path(path + filename)))
@@ -392,37 +400,42 @@ static bool FixFilenameCase(const std::string &path, std::string &filename) {
 		filename[i] = tolower(filename[i]);
 	}
 
-	//TODO: lookup filename in cache for "path"
-	struct dirent *result = NULL;
+	std::lock_guard<std::mutex> guard(g_caseCacheLock);
+	auto dirIt = g_caseCache.find(path);
+	if (dirIt != g_caseCache.end()) {
+		auto nameIt = dirIt->second.find(filename);
+		if (nameIt != dirIt->second.end() && File::Exists(Path(path + nameIt->second))) {
+			filename = nameIt->second;
+			return true;
+		}
+	}
 
 	DIR *dirp = opendir(path.c_str());
 	if (!dirp)
 		return false;
 
-	bool retValue = false;
+	if (g_caseCache.size() >= MAX_CASE_CACHE_DIRS)
+		g_caseCache.clear();
+	auto &names = g_caseCache[path];
+	names.clear();
 
+	struct dirent *result = NULL;
 	while ((result = readdir(dirp)))
 	{
-		if (strlen(result->d_name) != filenameSize)
-			continue;
-
-		size_t i;
-		for (i = 0; i < filenameSize; i++)
-		{
-			if (filename[i] != tolower(result->d_name[i]))
-				break;
-		}
-
-		if (i < filenameSize)
-			continue;
-
-		filename = result->d_name;
-		retValue = true;
+		std::string lower = result->d_name;
+		for (char &c : lower)
+			c = tolower(c);
+		// Last one wins, like the old linear scan.
+		names[lower] = result->d_name;
 	}
 
 	closedir(dirp);
 
-	return retValue;
+	auto nameIt = names.find(filename);
+	if (nameIt == names.end())
+		return false;
+	filename = nameIt->second;
+	return true;
 }
 
 bool FixPathCase(const Path &realBasePath, std::string &path, FixPathCaseBehavior behavior) {
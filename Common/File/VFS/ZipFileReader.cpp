@@ -1,14 +1,26 @@
+#include "ppsspp_config.h"
+
 #include <algorithm>
 #include <ctype.h>
 #include <set>
 #include <cstdio>
 #include <cstring>
 
+#if PPSSPP_PLATFORM(WINDOWS)
+#include "Common/CommonWindows.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #ifdef SHARED_LIBZIP
 #include <zip.h>
 #else
 #include "ext/libzip/zip.h"
 #endif
+#include <zlib.h>
 
 #include "Common/Common.h"
 #include "Common/Log.h"
@@ -56,18 +68,202 @@ ZipFileReader *ZipFileReader::Create(const Path &zipFile, const char *inZipPath)
 	ZipFileReader *reader = new ZipFileReader();
 	reader->zip_file_ = zip_file;
 	truncate_cpy(reader->inZipPath_, inZipPath);
+	if (reader->MapArchive(zipFile)) {
+		reader->BuildIndex();
+	}
 	return reader;
 }
 
 ZipFileReader::~ZipFileReader() {
 	std::lock_guard<std::mutex> guard(lock_);
 	zip_close(zip_file_);
+	UnmapArchive();
+}
+
+bool ZipFileReader::MapArchive(const Path &zipFile) {
+	void *base = nullptr;
+	size_t size = 0;
+
+#if PPSSPP_PLATFORM(UWP)
+	return false;
+#elif PPSSPP_PLATFORM(WINDOWS)
+	HANDLE file = CreateFile(zipFile.ToWString().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize{};
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+		size = (size_t)fileSize.QuadPart;
+		HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) {
+			base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			// The view keeps the mapping alive.
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	int fd = zipFile.Type() == PathType::CONTENT_URI ? File::OpenFD(zipFile, File::OPEN_READ) : open(zipFile.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st{};
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		size = (size_t)st.st_size;
+		base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+		if (base == MAP_FAILED)
+			base = nullptr;
+	}
+	close(fd);
+#endif
+
+	if (!base)
+		return false;
+	mapBase_ = (const uint8_t *)base;
+	mapSize_ = size;
+	return true;
+}
+
+void ZipFileReader::UnmapArchive() {
+	if (!mapBase_)
+		return;
+#if PPSSPP_PLATFORM(WINDOWS)
+	UnmapViewOfFile(mapBase_);
+#else
+	munmap((void *)mapBase_, mapSize_);
+#endif
+	mapBase_ = nullptr;
+	mapSize_ = 0;
+	index_.clear();
+}
+
+static inline uint16_t ReadLE16(const uint8_t *p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t ReadLE32(const uint8_t *p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static std::string LowerCaseName(const char *name, size_t len) {
+	std::string lower(name, len);
+	for (char &c : lower)
+		c = tolower((unsigned char)c);
+	return lower;
+}
+
+void ZipFileReader::BuildIndex() {
+	const uint8_t *base = mapBase_;
+	const size_t size = mapSize_;
+	static constexpr size_t EOCD_SIZE = 22;
+	static constexpr size_t CENTRAL_HEADER_SIZE = 46;
+	static constexpr size_t LOCAL_HEADER_SIZE = 30;
+	if (size < EOCD_SIZE)
+		return;
+
+	// The end of central directory record is last, but may be followed by a comment of up to 64KB.
+	const size_t minPos = size > EOCD_SIZE + 0xFFFF ? size - EOCD_SIZE - 0xFFFF : 0;
+	size_t eocd = size - EOCD_SIZE;
+	while (ReadLE32(base + eocd) != 0x06054b50) {
+		if (eocd == minPos)
+			return;
+		eocd--;
+	}
+
+	const uint32_t count = ReadLE16(base + eocd + 10);
+	const uint32_t cdSize = ReadLE32(base + eocd + 12);
+	const uint32_t cdOffset = ReadLE32(base + eocd + 16);
+	// Zip64 archives are left to libzip.
+	if (count == 0xFFFF || cdOffset == 0xFFFFFFFF || (uint64_t)cdOffset + cdSize > size)
+		return;
+
+	const size_t cdEnd = (size_t)cdOffset + cdSize;
+	size_t pos = cdOffset;
+	index_.reserve(count);
+	for (uint32_t i = 0; i < count; i++) {
+		if (pos + CENTRAL_HEADER_SIZE > cdEnd || ReadLE32(base + pos) != 0x02014b50) {
+			WARN_LOG(IO, "Bad central directory in zip, using libzip for all reads");
+			index_.clear();
+			return;
+		}
+		const uint8_t *header = base + pos;
+		const uint16_t flags = ReadLE16(header + 8);
+		const uint16_t method = ReadLE16(header + 10);
+		const uint32_t compressedSize = ReadLE32(header + 20);
+		const uint32_t uncompressedSize = ReadLE32(header + 24);
+		const uint16_t nameLen = ReadLE16(header + 28);
+		const uint32_t localOffset = ReadLE32(header + 42);
+		const size_t nameOffset = pos + CENTRAL_HEADER_SIZE;
+		pos = nameOffset + nameLen + ReadLE16(header + 30) + ReadLE16(header + 32);
+		if (pos > cdEnd) {
+			index_.clear();
+			return;
+		}
+
+		// Encrypted entries, zip64 entries and other compression methods stay with libzip.
+		if ((flags & 1) != 0 || (method != 0 && method != Z_DEFLATED))
+			continue;
+		if (compressedSize == 0xFFFFFFFF || uncompressedSize == 0xFFFFFFFF || localOffset == 0xFFFFFFFF)
+			continue;
+		if (method == 0 && compressedSize != uncompressedSize)
+			continue;
+		// The local header can have a different extra field, so the data offset comes from it.
+		if ((uint64_t)localOffset + LOCAL_HEADER_SIZE > size || ReadLE32(base + localOffset) != 0x04034b50)
+			continue;
+		const uint64_t dataOffset = (uint64_t)localOffset + LOCAL_HEADER_SIZE + ReadLE16(base + localOffset + 26) + ReadLE16(base + localOffset + 28);
+		if (dataOffset + compressedSize > size)
+			continue;
+
+		// Like libzip's ZIP_FL_NOCASE lookups, the first match wins.
+		index_.emplace(LowerCaseName((const char *)base + nameOffset, nameLen), IndexEntry{ dataOffset, compressedSize, uncompressedSize, method });
+	}
+}
+
+const ZipFileReader::IndexEntry *ZipFileReader::Lookup(const char *fullPath) const {
+	if (index_.empty())
+		return nullptr;
+	auto it = index_.find(LowerCaseName(fullPath, strlen(fullPath)));
+	return it != index_.end() ? &it->second : nullptr;
+}
+
+uint8_t *ZipFileReader::ReadMapped(const IndexEntry &entry, size_t *size) const {
+	uint8_t *contents = new uint8_t[entry.size + 1];
+	const uint8_t *src = mapBase_ + entry.dataOffset;
+	if (entry.method == 0) {
+		memcpy(contents, src, entry.size);
+	} else {
+		// Own stream per call, so different threads can inflate at the same time.
+		z_stream zs{};
+		if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) {
+			delete[] contents;
+			return nullptr;
+		}
+		zs.next_in = (Bytef *)src;
+		zs.avail_in = entry.compressedSize;
+		zs.next_out = contents;
+		zs.avail_out = entry.size;
+		int ret = inflate(&zs, Z_FINISH);
+		uLong total = zs.total_out;
+		inflateEnd(&zs);
+		if (ret != Z_STREAM_END || total != entry.size) {
+			delete[] contents;
+			return nullptr;
+		}
+	}
+	contents[entry.size] = 0;
+	*size = entry.size;
+	return contents;
 }
 
 uint8_t *ZipFileReader::ReadFile(const char *path, size_t *size) {
 	char temp_path[2048];
 	snprintf(temp_path, sizeof(temp_path), "%s%s", inZipPath_, path);
 
+	const IndexEntry *entry = Lookup(temp_path);
+	if (entry) {
+		uint8_t *data = ReadMapped(*entry, size);
+		if (data)
+			return data;
+	}
+
 	std::lock_guard<std::mutex> guard(lock_);
 	return ReadFromZip(zip_file_, temp_path, size);
 }
@@ -162,7 +358,10 @@ bool ZipFileReader::GetFileInfo(const char *path, File::FileInfo *info) {
 	char temp_path[1024];
 	snprintf(temp_path, sizeof(temp_path), "%s%s", inZipPath_, path);
 
-	{
+	const IndexEntry *entry = Lookup(temp_path);
+	if (entry) {
+		zstat.size = entry->size;
+	} else {
 		std::lock_guard<std::mutex> guard(lock_);
 		if (0 != zip_stat(zip_file_, temp_path, ZIP_FL_NOCASE | ZIP_FL_UNCHANGED, &zstat)) {
 			// ZIP files do not have real directories, so we'll end up here if we
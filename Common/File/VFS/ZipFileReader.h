@@ -9,6 +9,7 @@
 #include <mutex>
 #include <set>
 #include <string>
+#include <unordered_map>
 
 #include "Common/File/VFS/VFS.h"
 #include "Common/File/FileUtil.h"
@@ -40,9 +41,28 @@ class ZipFileReader : public VFSBackend {
 	}
 
 private:
+	struct IndexEntry {
+		uint64_t dataOffset;
+		uint32_t compressedSize;
+		uint32_t size;
+		uint16_t method;
+	};
+
 	void GetZipListings(const char *path, std::set<std::string> &files, std::set<std::string> &directories);
 
+	bool MapArchive(const Path &zipFile);
+	void UnmapArchive();
+	void BuildIndex();
+	const IndexEntry *Lookup(const char *fullPath) const;
+	uint8_t *ReadMapped(const IndexEntry &entry, size_t *size) const;
+
 	zip *zip_file_ = nullptr;
 	std::mutex lock_;
 	char inZipPath_[256];
+
+	// The archive mapped read-only, and the stored and deflated entries in it by lowercase name.
+	// Both are set up in Create() and never change, so reads through them don't take lock_.
+	const uint8_t *mapBase_ = nullptr;
+	size_t mapSize_ = 0;
+	std::unordered_map<std::string, IndexEntry> index_;
 };
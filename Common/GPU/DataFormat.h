@@ -62,6 +62,9 @@ enum class DataFormat : uint8_t {
 	BC7_SRGB_BLOCK,
 
 	ETC1,
+	ETC2_R8G8B8_UNORM_BLOCK,
+	ETC2_R8G8B8A8_UNORM_BLOCK,
+	ASTC_4x4_UNORM_BLOCK,
 
 	S8,
 	D16,
@@ -73,6 +76,8 @@ enum class DataFormat : uint8_t {
 
 size_t DataFormatSizeInBytes(DataFormat fmt);
 bool DataFormatIsDepthStencil(DataFormat fmt);
+// All the compressed formats we support use 4x4 blocks. blockSize is the number of bytes per block.
+bool DataFormatIsBlockCompressed(DataFormat fmt, int *blockSize);
 inline bool DataFormatIsColor(DataFormat fmt) {
 	return !DataFormatIsDepthStencil(fmt);
 }
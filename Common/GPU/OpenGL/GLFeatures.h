@@ -102,6 +102,9 @@ struct GLExtensions {
 	// APPLE
 	bool APPLE_clip_distance;
 
+	// OVR
+	bool OVR_multiview2;
+
 	// EGL
 	bool EGL_NV_system_time;
 	bool EGL_NV_coverage_sample;
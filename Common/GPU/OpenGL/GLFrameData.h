@@ -46,6 +46,9 @@ struct GLFrameData {
 	// Swapchain.
 	bool hasBegun = false;
 
+	// Only used with GLBufferStrategy::PERSISTENT. Signalled when the GPU is done with this frame's push buffers.
+	GLsync fence = nullptr;
+
 	GLDeleter deleter;
 	GLDeleter deleter_prev;
 	std::set<GLPushBuffer *> activePushBuffers;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <vector>
 #include <set>
@@ -13,6 +14,31 @@
 #include "Common/Data/Collections/TinySet.h"
 
 
+// Time the render thread spent waiting on the driver for buffer data, in seconds. Counted on the
+// render thread, and published to the microsecond counters once per presented frame.
+struct GLRStallStats {
+	double subData = 0.0;
+	double map = 0.0;
+	double fence = 0.0;
+
+	std::atomic<int> lastFrameSubDataUs{};
+	std::atomic<int> lastFrameMapUs{};
+	std::atomic<int> lastFrameFenceUs{};
+	std::atomic<int> maxFrameUs{};
+
+	void Publish() {
+		lastFrameSubDataUs = (int)(subData * 1000000.0);
+		lastFrameMapUs = (int)(map * 1000000.0);
+		lastFrameFenceUs = (int)(fence * 1000000.0);
+		int total = lastFrameSubDataUs + lastFrameMapUs + lastFrameFenceUs;
+		if (total > maxFrameUs)
+			maxFrameUs = total;
+		subData = 0.0;
+		map = 0.0;
+		fence = 0.0;
+	}
+};
+
 struct GLRViewport {
 	float x, y, w, h, minZ, maxZ;
 };
@@ -385,6 +411,10 @@ class GLQueueRunner {
 		return sawOutOfMemory_;
 	}
 
+	GLRStallStats &StallStats() {
+		return stallStats_;
+	}
+
 	std::string GetGLString(int name) const {
 		auto it = glStrings_.find(name);
 		return it != glStrings_.end() ? it->second : "";
@@ -409,6 +439,8 @@ class GLQueueRunner {
 
 	GLuint globalVAO_ = 0;
 
+	GLRStallStats stallStats_;
+
 	Draw::DeviceCaps caps_{};  // For sanity checks.
 
 	int curFBWidth_ = 0;
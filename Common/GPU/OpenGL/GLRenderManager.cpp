@@ -63,6 +63,10 @@ void GLRenderManager::ThreadStart(Draw::DrawContext *draw) {
 		newInflightFrames_ = -1;
 	}
 
+	for (int i = 0; i < MAX_INFLIGHT_FRAMES; i++) {
+		frameData_[i].fence = nullptr;
+	}
+
 	// Don't save draw, we don't want any thread safety confusion.
 	bool mapBuffers = draw->GetBugs().Has(Draw::Bugs::ANY_MAP_BUFFER_RANGE_SLOW);
 	bool hasBufferStorage = gl_extensions.ARB_buffer_storage || gl_extensions.EXT_buffer_storage;
@@ -95,6 +99,15 @@ void GLRenderManager::ThreadStart(Draw::DrawContext *draw) {
 	} else {
 		bufferStrategy_ = GLBufferStrategy::SUBDATA;
 	}
+
+#if !defined(USING_GLES2)
+	// Persistent mapping avoids both the glBufferSubData stalls and the map/unmap cost above.
+	// Not on GLES for now, for the same task switching reason the Qualcomm mapping is disabled.
+	if (gl_extensions.ARB_buffer_storage && gl_extensions.VersionGEThan(3, 2, 0)) {
+		bufferStrategy_ = GLBufferStrategy::PERSISTENT;
+	}
+#endif
+	INFO_LOG(G3D, "GL buffer strategy: %d", (int)bufferStrategy_);
 }
 
 void GLRenderManager::ThreadEnd() {
@@ -103,6 +116,19 @@ void GLRenderManager::ThreadEnd() {
 	queueRunner_.DestroyDeviceObjects();
 	VLOG("  PULL: Quitting");
 
+	for (int i = 0; i < MAX_INFLIGHT_FRAMES; i++) {
+		GLFrameData &frameData = frameData_[i];
+		if (frameData.fence) {
+			if (!skipGLCalls_)
+				glDeleteSync(frameData.fence);
+			frameData.fence = nullptr;
+		}
+		// A frame might still be held back by FencePresentedFrame.
+		std::lock_guard<std::mutex> lock(frameData.fenceMutex);
+		frameData.readyForFence = true;
+		frameData.fenceCondVar.notify_one();
+	}
+
 	// Good time to run all the deleters to get rid of leftover objects.
 	for (int i = 0; i < MAX_INFLIGHT_FRAMES; i++) {
 		// Since we're in shutdown, we should skip the GL calls on Android.
@@ -404,12 +430,16 @@ bool GLRenderManager::Run(GLRRenderThreadTask &task) {
 	// queueRunner_.LogSteps(stepsOnThread);
 	queueRunner_.RunInitSteps(task.initSteps, skipGLCalls_);
 
+	GLRStallStats &stallStats = queueRunner_.StallStats();
+
 	// Run this after RunInitSteps so any fresh GLRBuffers for the pushbuffers can get created.
 	if (!skipGLCalls_) {
+		double start = time_now_d();
 		for (auto iter : frameData.activePushBuffers) {
 			iter->Flush();
 			iter->UnmapDevice();
 		}
+		stallStats.map += time_now_d() - start;
 	}
 
 	if (IsVREnabled()) {
@@ -424,9 +454,11 @@ bool GLRenderManager::Run(GLRRenderThreadTask &task) {
 	}
 
 	if (!skipGLCalls_) {
+		double start = time_now_d();
 		for (auto iter : frameData.activePushBuffers) {
 			iter->MapDevice(bufferStrategy_);
 		}
+		stallStats.map += time_now_d() - start;
 	}
 
 	bool swapRequest = false;
@@ -457,12 +489,15 @@ bool GLRenderManager::Run(GLRRenderThreadTask &task) {
 		}
 		frameData.hasBegun = false;
 
-		VLOG("  PULL: Frame %d.readyForFence = true", task.frame);
-
 		{
-			std::lock_guard<std::mutex> lock(frameData.fenceMutex);
-			frameData.readyForFence = true;
-			frameData.fenceCondVar.notify_one();
+			int readyFrame = FencePresentedFrame(task.frame);
+			stallStats.Publish();
+
+			VLOG("  PULL: Frame %d.readyForFence = true", readyFrame);
+			GLFrameData &readyFrameData = frameData_[readyFrame];
+			std::lock_guard<std::mutex> lock(readyFrameData.fenceMutex);
+			readyFrameData.readyForFence = true;
+			readyFrameData.fenceCondVar.notify_one();
 			// At this point, we're done with this framedata (for now).
 		}
 
@@ -487,6 +522,34 @@ bool GLRenderManager::Run(GLRRenderThreadTask &task) {
 	return swapRequest;
 }
 
+// With persistently mapped push buffers, the CPU writes straight into memory the GPU might still be reading,
+// so a frame can't be handed back to the main thread until its fence has passed. Instead of waiting for the frame
+// we just presented, we wait for the one the main thread will begin next, which the GPU should be long done with.
+int GLRenderManager::FencePresentedFrame(int frame) {
+	if (bufferStrategy_ != GLBufferStrategy::PERSISTENT || skipGLCalls_)
+		return frame;
+
+	GLFrameData &frameData = frameData_[frame];
+	if (frameData.fence)
+		glDeleteSync(frameData.fence);
+	frameData.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	int nextFrame = frame + 1 >= inflightFrames_ ? 0 : frame + 1;
+	GLFrameData &nextFrameData = frameData_[nextFrame];
+	if (nextFrameData.fence) {
+		double start = time_now_d();
+		// The flush is needed in case we're waiting on the fence we just inserted (single inflight frame.)
+		GLenum res = glClientWaitSync(nextFrameData.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
+		if (res == GL_TIMEOUT_EXPIRED || res == GL_WAIT_FAILED) {
+			WARN_LOG(G3D, "Frame fence wait failed (%04x)", res);
+		}
+		queueRunner_.StallStats().fence += time_now_d() - start;
+		glDeleteSync(nextFrameData.fence);
+		nextFrameData.fence = nullptr;
+	}
+	return nextFrame;
+}
+
 void GLRenderManager::FlushSync() {
 	{
 		VLOG("PUSH: Frame[%d].readyForRun = true (sync)", curFrame_);
@@ -705,6 +768,11 @@ void GLPushBuffer::MapDevice(GLBufferStrategy strategy) {
 void GLPushBuffer::UnmapDevice() {
 	_dbg_assert_msg_(OnRenderThread(), "UnmapDevice must run on render thread");
 
+	if (strategy_ == GLBufferStrategy::PERSISTENT) {
+		// Stays mapped until the buffer is deleted.
+		return;
+	}
+
 	for (auto &info : buffers_) {
 		if (info.deviceMemory) {
 			// TODO: Technically this can return false?
@@ -727,7 +795,17 @@ void *GLRBuffer::Map(GLBufferStrategy strategy) {
 
 	void *p = nullptr;
 	bool allowNativeBuffer = strategy != GLBufferStrategy::SUBDATA;
-	if (allowNativeBuffer) {
+	if (strategy == GLBufferStrategy::PERSISTENT) {
+#if !defined(USING_GLES2)
+		glBindBuffer(target_, buffer_);
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		if (!hasStorage_) {
+			glBufferStorage(target_, size_, nullptr, flags);
+			hasStorage_ = true;
+		}
+		p = glMapBufferRange(target_, 0, size_, flags);
+#endif
+	} else if (allowNativeBuffer) {
 		glBindBuffer(target_, buffer_);
 
 		if (gl_extensions.ARB_buffer_storage || gl_extensions.EXT_buffer_storage) {
@@ -193,6 +193,9 @@ enum class GLBufferStrategy {
 	FLUSH_UNMAP = MASK_FLUSH,
 	// Map/unmap, invalidate on map, and explicit flush.
 	FLUSH_INVALIDATE_UNMAP = MASK_FLUSH | MASK_INVALIDATE,
+	// Coherent glBufferStorage buffers that stay mapped. Each frame's push buffers are
+	// protected by a fence instead, so there's no orphaning and no per frame map/unmap.
+	PERSISTENT = 2,
 };
 
 static inline int operator &(const GLBufferStrategy &lhs, const GLBufferStrategy &rhs) {
@@ -1007,9 +1010,19 @@ class GLRenderManager {
 		skipGLCalls_ = true;
 	}
 
+	GLBufferStrategy GetBufferStrategy() const {
+		return bufferStrategy_;
+	}
+
+	const GLRStallStats &StallStats() {
+		return queueRunner_.StallStats();
+	}
+
 private:
 	// Bad for performance but sometimes necessary for synchronous CPU readbacks (screenshots and whatnot).
 	void FlushSync();
+	// Returns the frame whose push buffers are safe to write to again.
+	int FencePresentedFrame(int frame);
 
 	// When using legacy functionality for push buffers (glBufferData), we need to flush them
 	// before actually making the glDraw* calls. It's best if the render manager handles that.
@@ -0,0 +1,109 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "Common/File/FileUtil.h"
+#include "Common/GPU/ShaderCompileLog.h"
+#include "Common/Log.h"
+#include "Common/TimeUtil.h"
+
+struct ShaderCompileEntry {
+	double time;
+	ShaderCompileStage stage;
+	std::string id;
+	double seconds;
+	bool blocked;
+};
+
+static std::atomic<bool> logActive;
+static std::mutex logLock;
+static std::vector<ShaderCompileEntry> entries;
+static Path logFilename;
+static double logStartTime;
+
+const char *ShaderCompileStageName(ShaderCompileStage stage) {
+	switch (stage) {
+	case ShaderCompileStage::VERTEX_GEN: return "vsgen";
+	case ShaderCompileStage::FRAGMENT_GEN: return "fsgen";
+	case ShaderCompileStage::GEOMETRY_GEN: return "gsgen";
+	case ShaderCompileStage::SPIRV: return "spirv";
+	case ShaderCompileStage::PIPELINE: return "pipeline";
+	case ShaderCompileStage::PIPELINE_WAIT: return "pipelinewait";
+	}
+	return "unknown";
+}
+
+void ShaderCompileLog_Start(const Path &filename) {
+	ShaderCompileLog_Stop();
+
+	std::lock_guard<std::mutex> guard(logLock);
+	logFilename = filename;
+	logStartTime = time_now_d();
+	entries.clear();
+	logActive = true;
+}
+
+void ShaderCompileLog_Stop() {
+	std::lock_guard<std::mutex> guard(logLock);
+	if (!logActive)
+		return;
+	logActive = false;
+
+	if (entries.empty())
+		return;
+
+	int blockedCount = 0;
+	double blockedSeconds = 0.0;
+	for (const auto &entry : entries) {
+		if (entry.blocked) {
+			blockedCount++;
+			blockedSeconds += entry.seconds;
+		}
+	}
+	INFO_LOG(G3D, "Shader compile log: %d entries, %d blocking for %0.2f ms total", (int)entries.size(), blockedCount, blockedSeconds * 1000.0);
+
+	// Append, so the history across sessions is kept.
+	bool writeHeader = !File::Exists(logFilename);
+	FILE *f = File::OpenCFile(logFilename, "a");
+	if (!f) {
+		WARN_LOG(G3D, "Unable to write shader compile log to %s", logFilename.c_str());
+		entries.clear();
+		return;
+	}
+	if (writeHeader)
+		fprintf(f, "time,stage,id,ms,blocked\n");
+	for (const auto &entry : entries) {
+		fprintf(f, "%0.3f,%s,%s,%0.3f,%d\n", entry.time, ShaderCompileStageName(entry.stage), entry.id.c_str(), entry.seconds * 1000.0, entry.blocked ? 1 : 0);
+	}
+	fclose(f);
+	entries.clear();
+}
+
+bool ShaderCompileLog_IsActive() {
+	return logActive;
+}
+
+void ShaderCompileLog_Record(ShaderCompileStage stage, const std::string &id, double seconds, bool blocked) {
+	if (!logActive)
+		return;
+
+	double now = time_now_d();
+	std::lock_guard<std::mutex> guard(logLock);
+	if (!logActive)
+		return;
+	entries.push_back(ShaderCompileEntry{ now - logStartTime, stage, id, seconds, blocked });
+}
+
+std::string ShaderCompileLog_HexID(const void *data, size_t size) {
+	static const char hex[] = "0123456789abcdef";
+	const uint8_t *p = (const uint8_t *)data;
+	std::string s;
+	s.resize(size * 2);
+	for (size_t i = 0; i < size; ++i) {
+		s[i * 2 + 0] = hex[p[i] >> 4];
+		s[i * 2 + 1] = hex[p[i] & 0xF];
+	}
+	return s;
+}
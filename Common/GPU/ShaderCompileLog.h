@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+#include "Common/File/Path.h"
+
+// Records shader generation, compiles and pipeline creation with their durations, to find out
+// which ones cause stutter.  Appended to a per game CSV file when stopped.
+
+enum class ShaderCompileStage {
+	VERTEX_GEN,
+	FRAGMENT_GEN,
+	GEOMETRY_GEN,
+	SPIRV,
+	PIPELINE,
+	// Time a frame waited for a pipeline that wasn't ready yet.
+	PIPELINE_WAIT,
+};
+
+const char *ShaderCompileStageName(ShaderCompileStage stage);
+
+void ShaderCompileLog_Start(const Path &filename);
+void ShaderCompileLog_Stop();
+bool ShaderCompileLog_IsActive();
+
+// blocked means the emulation or render thread had to wait for this, rather than a background thread.
+// Can be called from any thread, does nothing unless active.
+void ShaderCompileLog_Record(ShaderCompileStage stage, const std::string &id, double seconds, bool blocked);
+
+// IDs are logged as hex, in the same byte order as the shader cache files.
+std::string ShaderCompileLog_HexID(const void *data, size_t size);
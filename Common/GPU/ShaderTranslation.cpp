@@ -87,6 +87,10 @@ cbuffer data : register(b0) {
 	float4 u_timeDelta;
 	float4 u_setting;
 	float u_video;
+	float4 u_halfPixelUnused;
+	float4 u_setting1;
+	float4 u_setting2;
+	float4 u_setting3;
 };
 )";
 
@@ -104,6 +108,10 @@ layout (std140, set = 0, binding = 0) uniform Data {
 	vec4 u_timeDelta;
 	vec4 u_setting;
 	float u_video;
+	vec4 u_halfPixelUnused;
+	vec4 u_setting1;
+	vec4 u_setting2;
+	vec4 u_setting3;
 };
 )";
 
@@ -115,6 +123,9 @@ float4 u_time : register(c3);
 float4 u_timeDelta : register(c4);
 float4 u_setting : register(c5);
 float u_video : register(c6);
+float4 u_setting1 : register(c7);
+float4 u_setting2 : register(c8);
+float4 u_setting3 : register(c9);
 )";
 
 // SPIRV-Cross' HLSL output has some deficiencies we need to work around.
@@ -215,6 +226,31 @@ bool ConvertToVulkanGLSL(std::string *dest, TranslatedShaderMetadata *destMetada
 	return true;
 }
 
+bool ValidateShader(const std::string &src, ShaderLanguage srcLang, ShaderStage stage, std::string *errorMessage) {
+	_assert_(errorMessage != nullptr);
+#if PPSSPP_PLATFORM(UWP)
+	// No glslang here, the D3D11 compiler will have to catch it.
+	return true;
+#else
+	if (srcLang != GLSL_1xx) {
+		*errorMessage = StringFromFormat("Bad src shader language: %s", ShaderLanguageAsString(srcLang));
+		return false;
+	}
+
+	TBuiltInResource Resources{};
+	InitShaderResources(Resources);
+
+	glslang::TShader shader(GetShLanguageFromStage(stage));
+	const char *shaderStrings[1] = { src.c_str() };
+	shader.setStrings(shaderStrings, 1);
+	if (!shader.parse(&Resources, 100, EProfile::ECompatibilityProfile, false, false, EShMessages::EShMsgDefault)) {
+		*errorMessage = StringFromFormat("%s parser failure: %s\n%s", ShaderStageAsString(stage), shader.getInfoLog(), shader.getInfoDebugLog());
+		return false;
+	}
+	return true;
+#endif
+}
+
 bool TranslateShader(std::string *dest, ShaderLanguage destLang, const ShaderLanguageDesc &desc, TranslatedShaderMetadata *destMetadata, std::string src, ShaderLanguage srcLang, ShaderStage stage, std::string *errorMessage) {
 	_assert_(errorMessage != nullptr);
 
@@ -29,4 +29,6 @@ struct TranslatedShaderMetadata {
 void ShaderTranslationInit();
 void ShaderTranslationShutdown();
 
+// Only parses, to catch errors before a backend that compiles lazily would.  Only GLSL_1xx is supported.
+bool ValidateShader(const std::string &src, ShaderLanguage srcLang, ShaderStage stage, std::string *errorMessage);
 bool TranslateShader(std::string *dst, ShaderLanguage destLang, const ShaderLanguageDesc &desc, TranslatedShaderMetadata *destMetadata, std::string src, ShaderLanguage srcLang, ShaderStage stage, std::string *errorMessage);
@@ -8,6 +8,7 @@
 #include "Common/System/System.h"
 #include "Common/System/Display.h"
 #include "Common/Log.h"
+#include "Common/Profiler/MemoryUsage.h"
 #include "Common/GPU/Shader.h"
 #include "Common/GPU/Vulkan/VulkanContext.h"
 #include "Common/GPU/Vulkan/VulkanDebug.h"
@@ -306,6 +307,16 @@ void VulkanContext::BeginFrame(VkCommandBuffer firstCommandBuffer) {
 	if (firstCommandBuffer) {
 		frame->profiler.BeginFrame(this, firstCommandBuffer);
 	}
+
+	if (allocator_) {
+		// Only what VMA has allocated from the driver, which is nearly all of ours.
+		VmaBudget budgets[VK_MAX_MEMORY_HEAPS]{};
+		vmaGetHeapBudgets(allocator_, budgets);
+		int64_t total = 0;
+		for (uint32_t i = 0; i < memory_properties_.memoryHeapCount; ++i)
+			total += (int64_t)budgets[i].statistics.blockBytes;
+		MemUsage_Set(MemoryCategory::VULKAN, total);
+	}
 }
 
 void VulkanContext::EndFrame() {
@@ -327,6 +338,8 @@ void VulkanContext::UpdateInflightFrames(int n) {
 void VulkanContext::WaitUntilQueueIdle() {
 	// Should almost never be used
 	vkQueueWaitIdle(gfx_queue_);
+	if (transfer_queue_)
+		vkQueueWaitIdle(transfer_queue_);
 }
 
 bool VulkanContext::MemoryTypeFromProperties(uint32_t typeBits, VkFlags requirements_mask, uint32_t *typeIndex) {
@@ -592,13 +605,29 @@ void VulkanContext::ChooseDevice(int physical_device) {
 		VkPhysicalDeviceFeatures2 features2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
 		// Add to chain even if not supported, GetPhysicalDeviceFeatures is supposed to ignore unknown structs.
 		VkPhysicalDeviceMultiviewFeatures multiViewFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES };
+		VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR };
+		VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR };
+		VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR };
 		features2.pNext = &multiViewFeatures;
+		multiViewFeatures.pNext = &presentIdFeatures;
+		presentIdFeatures.pNext = &presentWaitFeatures;
+		presentWaitFeatures.pNext = &timelineSemaphoreFeatures;
 		vkGetPhysicalDeviceFeatures2KHR(physical_devices_[physical_device_], &features2);
 		deviceFeatures_.available.standard = features2.features;
 		deviceFeatures_.available.multiview = multiViewFeatures;
+		deviceFeatures_.available.multiview.pNext = nullptr;
+		deviceFeatures_.available.presentId = presentIdFeatures;
+		deviceFeatures_.available.presentId.pNext = nullptr;
+		deviceFeatures_.available.presentWait = presentWaitFeatures;
+		deviceFeatures_.available.presentWait.pNext = nullptr;
+		deviceFeatures_.available.timelineSemaphore = timelineSemaphoreFeatures;
+		deviceFeatures_.available.timelineSemaphore.pNext = nullptr;
 	} else {
 		vkGetPhysicalDeviceFeatures(physical_devices_[physical_device_], &deviceFeatures_.available.standard);
 		deviceFeatures_.available.multiview = {};
+		deviceFeatures_.available.presentId = {};
+		deviceFeatures_.available.presentWait = {};
+		deviceFeatures_.available.timelineSemaphore = {};
 	}
 
 	deviceFeatures_.enabled = {};
@@ -612,10 +641,20 @@ void VulkanContext::ChooseDevice(int physical_device) {
 	deviceFeatures_.enabled.standard.shaderCullDistance = deviceFeatures_.available.standard.shaderCullDistance;
 	deviceFeatures_.enabled.standard.geometryShader = deviceFeatures_.available.standard.geometryShader;
 	deviceFeatures_.enabled.standard.sampleRateShading = deviceFeatures_.available.standard.sampleRateShading;
+	// Used for pre-compressed texture replacements.
+	deviceFeatures_.enabled.standard.textureCompressionBC = deviceFeatures_.available.standard.textureCompressionBC;
+	deviceFeatures_.enabled.standard.textureCompressionETC2 = deviceFeatures_.available.standard.textureCompressionETC2;
+	deviceFeatures_.enabled.standard.textureCompressionASTC_LDR = deviceFeatures_.available.standard.textureCompressionASTC_LDR;
 
 	deviceFeatures_.enabled.multiview = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES };
 	deviceFeatures_.enabled.multiview.multiview = deviceFeatures_.available.multiview.multiview;
 	// deviceFeatures_.enabled.multiview.multiviewGeometryShader = deviceFeatures_.available.multiview.multiviewGeometryShader;
+	deviceFeatures_.enabled.presentId = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR };
+	deviceFeatures_.enabled.presentId.presentId = deviceFeatures_.available.presentId.presentId;
+	deviceFeatures_.enabled.presentWait = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR };
+	deviceFeatures_.enabled.presentWait.presentWait = deviceFeatures_.available.presentWait.presentWait;
+	deviceFeatures_.enabled.timelineSemaphore = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR };
+	deviceFeatures_.enabled.timelineSemaphore.timelineSemaphore = deviceFeatures_.available.timelineSemaphore.timelineSemaphore;
 
 	GetDeviceLayerExtensionList(nullptr, device_extension_properties_);
 
@@ -648,20 +687,31 @@ VkResult VulkanContext::CreateDevice() {
 		return VK_ERROR_INITIALIZATION_FAILED;
 	}
 
-	VkDeviceQueueCreateInfo queue_info{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
+	VkDeviceQueueCreateInfo queue_info[2]{};
 	float queue_priorities[1] = {1.0f};
-	queue_info.queueCount = 1;
-	queue_info.pQueuePriorities = queue_priorities;
+	queue_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queue_info[0].queueCount = 1;
+	queue_info[0].pQueuePriorities = queue_priorities;
 	bool found = false;
 	for (int i = 0; i < (int)queue_count; i++) {
 		if (queueFamilyProperties_[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-			queue_info.queueFamilyIndex = i;
+			queue_info[0].queueFamilyIndex = i;
 			found = true;
 			break;
 		}
 	}
 	_dbg_assert_(found);
 
+	// A transfer-only family is a separate copy engine, uploads there can run alongside rendering.
+	transfer_queue_family_index_ = -1;
+	for (int i = 0; i < (int)queue_count; i++) {
+		const VkQueueFlags flags = queueFamilyProperties_[i].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			transfer_queue_family_index_ = i;
+			break;
+		}
+	}
+
 	// TODO: A lot of these are on by default in later Vulkan versions, should check for that, technically.
 	extensionsLookup_.KHR_maintenance1 = EnableDeviceExtension(VK_KHR_MAINTENANCE1_EXTENSION_NAME);
 	extensionsLookup_.KHR_maintenance2 = EnableDeviceExtension(VK_KHR_MAINTENANCE2_EXTENSION_NAME);
@@ -686,11 +736,34 @@ VkResult VulkanContext::CreateDevice() {
 	extensionsLookup_.EXT_fragment_shader_interlock = EnableDeviceExtension(VK_EXT_FRAGMENT_SHADER_INTERLOCK_EXTENSION_NAME);
 	extensionsLookup_.ARM_rasterization_order_attachment_access = EnableDeviceExtension(VK_ARM_RASTERIZATION_ORDER_ATTACHMENT_ACCESS_EXTENSION_NAME);
 
+	// We only need timeline semaphores for the transfer queue.
+	bool useTransferQueue = false;
+	if (transfer_queue_family_index_ != (uint32_t)-1 && extensionsLookup_.KHR_get_physical_device_properties2 && deviceFeatures_.available.timelineSemaphore.timelineSemaphore) {
+		extensionsLookup_.KHR_timeline_semaphore = EnableDeviceExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+		useTransferQueue = extensionsLookup_.KHR_timeline_semaphore;
+	}
+	if (useTransferQueue) {
+		queue_info[1].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queue_info[1].queueFamilyIndex = transfer_queue_family_index_;
+		queue_info[1].queueCount = 1;
+		queue_info[1].pQueuePriorities = queue_priorities;
+	} else {
+		transfer_queue_family_index_ = -1;
+	}
+
+	// Used by the low latency mode, to know when a frame actually reached the screen.
+	if (deviceFeatures_.available.presentId.presentId && deviceFeatures_.available.presentWait.presentWait) {
+		if (EnableDeviceExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME)) {
+			extensionsLookup_.KHR_present_id = true;
+			extensionsLookup_.KHR_present_wait = EnableDeviceExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+		}
+	}
+
 	VkPhysicalDeviceFeatures2 features2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
 
 	VkDeviceCreateInfo device_info{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
-	device_info.queueCreateInfoCount = 1;
-	device_info.pQueueCreateInfos = &queue_info;
+	device_info.queueCreateInfoCount = useTransferQueue ? 2 : 1;
+	device_info.pQueueCreateInfos = queue_info;
 	device_info.enabledLayerCount = (uint32_t)device_layer_names_.size();
 	device_info.ppEnabledLayerNames = device_info.enabledLayerCount ? device_layer_names_.data() : nullptr;
 	device_info.enabledExtensionCount = (uint32_t)device_extensions_enabled_.size();
@@ -700,6 +773,15 @@ VkResult VulkanContext::CreateDevice() {
 		device_info.pNext = &features2;
 		features2.features = deviceFeatures_.enabled.standard;
 		features2.pNext = &deviceFeatures_.enabled.multiview;
+		// Only chain these if the extensions are on, they're not valid otherwise.
+		if (extensionsLookup_.KHR_present_wait) {
+			deviceFeatures_.enabled.multiview.pNext = &deviceFeatures_.enabled.presentId;
+			deviceFeatures_.enabled.presentId.pNext = &deviceFeatures_.enabled.presentWait;
+		}
+		if (extensionsLookup_.KHR_timeline_semaphore) {
+			deviceFeatures_.enabled.timelineSemaphore.pNext = features2.pNext;
+			features2.pNext = &deviceFeatures_.enabled.timelineSemaphore;
+		}
 	} else {
 		device_info.pEnabledFeatures = &deviceFeatures_.enabled.standard;
 	}
@@ -710,6 +792,10 @@ VkResult VulkanContext::CreateDevice() {
 		ERROR_LOG(G3D, "Unable to create Vulkan device");
 	} else {
 		VulkanLoadDeviceFunctions(device_, extensionsLookup_);
+		if (useTransferQueue) {
+			vkGetDeviceQueue(device_, transfer_queue_family_index_, 0, &transfer_queue_);
+			INFO_LOG(G3D, "Using queue family %d for async transfers", transfer_queue_family_index_);
+		}
 	}
 	INFO_LOG(G3D, "Vulkan Device created: %s", physicalDeviceProperties_[physical_device_].properties.deviceName);
 
@@ -1249,20 +1335,31 @@ bool VulkanContext::InitSwapchain() {
 		}
 	}
 	INFO_LOG(G3D, "Supported present modes: %s", modes.c_str());
-	for (size_t i = 0; i < presentModeCount; i++) {
-		bool match = false;
-		match = match || ((flags_ & VULKAN_FLAG_PRESENT_MAILBOX) && presentModes[i] == VK_PRESENT_MODE_MAILBOX_KHR);
-		match = match || ((flags_ & VULKAN_FLAG_PRESENT_FIFO_RELAXED) && presentModes[i] == VK_PRESENT_MODE_FIFO_RELAXED_KHR);
-		match = match || ((flags_ & VULKAN_FLAG_PRESENT_FIFO) && presentModes[i] == VK_PRESENT_MODE_FIFO_KHR);
-		match = match || ((flags_ & VULKAN_FLAG_PRESENT_IMMEDIATE) && presentModes[i] == VK_PRESENT_MODE_IMMEDIATE_KHR);
-
-		// Default to the first present mode from the list.
-		if (match || swapchainPresentMode == VK_PRESENT_MODE_MAX_ENUM_KHR) {
-			swapchainPresentMode = presentModes[i];
+	// When several are requested, prefer the ones with the least latency.
+	static const struct {
+		uint32_t flag;
+		VkPresentModeKHR mode;
+	} presentModePriority[] = {
+		{ VULKAN_FLAG_PRESENT_IMMEDIATE, VK_PRESENT_MODE_IMMEDIATE_KHR },
+		{ VULKAN_FLAG_PRESENT_MAILBOX, VK_PRESENT_MODE_MAILBOX_KHR },
+		{ VULKAN_FLAG_PRESENT_FIFO_RELAXED, VK_PRESENT_MODE_FIFO_RELAXED_KHR },
+		{ VULKAN_FLAG_PRESENT_FIFO, VK_PRESENT_MODE_FIFO_KHR },
+	};
+	for (const auto &candidate : presentModePriority) {
+		if ((flags_ & candidate.flag) == 0)
+			continue;
+		for (size_t i = 0; i < presentModeCount; i++) {
+			if (presentModes[i] == candidate.mode) {
+				swapchainPresentMode = candidate.mode;
+				break;
+			}
 		}
-		if (match) {
+		if (swapchainPresentMode != VK_PRESENT_MODE_MAX_ENUM_KHR)
 			break;
-		}
+	}
+	// Default to the first present mode from the list.
+	if (swapchainPresentMode == VK_PRESENT_MODE_MAX_ENUM_KHR && presentModeCount > 0) {
+		swapchainPresentMode = presentModes[0];
 	}
 #ifdef __ANDROID__
 	// HACK
@@ -1431,6 +1528,7 @@ void VulkanContext::DestroyDevice() {
 
 	vkDestroyDevice(device_, nullptr);
 	device_ = nullptr;
+	transfer_queue_ = VK_NULL_HANDLE;
 }
 
 bool VulkanContext::CreateShaderModule(const std::vector<uint32_t> &spirv, VkShaderModule *shaderModule, const char *tag) {
@@ -1576,6 +1674,8 @@ void finalize_glslang() {
 	glslang::FinalizeProcess();
 }
 
+std::atomic<uint32_t> VulkanDeleteList::descriptorResourceGeneration_;
+
 void VulkanDeleteList::Take(VulkanDeleteList &del) {
 	_dbg_assert_(cmdPools_.empty());
 	_dbg_assert_(descPools_.empty());
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <string>
 #include <vector>
@@ -26,6 +27,8 @@ enum {
 	VULKAN_FLAG_PRESENT_IMMEDIATE = 4,
 	VULKAN_FLAG_PRESENT_FIFO_RELAXED = 8,
 	VULKAN_FLAG_PRESENT_FIFO = 16,
+	// Wait for each frame to reach the screen before the next one, if VK_KHR_present_wait is available.
+	VULKAN_FLAG_LOW_LATENCY = 32,
 };
 
 enum {
@@ -107,11 +110,11 @@ class VulkanDeleteList {
 	void QueueDeleteCommandPool(VkCommandPool &pool) { _dbg_assert_(pool != VK_NULL_HANDLE); cmdPools_.push_back(pool); pool = VK_NULL_HANDLE; }
 	void QueueDeleteDescriptorPool(VkDescriptorPool &pool) { _dbg_assert_(pool != VK_NULL_HANDLE); descPools_.push_back(pool); pool = VK_NULL_HANDLE; }
 	void QueueDeleteShaderModule(VkShaderModule &module) { _dbg_assert_(module != VK_NULL_HANDLE); modules_.push_back(module); module = VK_NULL_HANDLE; }
-	void QueueDeleteBuffer(VkBuffer &buffer) { _dbg_assert_(buffer != VK_NULL_HANDLE); buffers_.push_back(buffer); buffer = VK_NULL_HANDLE; }
+	void QueueDeleteBuffer(VkBuffer &buffer) { _dbg_assert_(buffer != VK_NULL_HANDLE); buffers_.push_back(buffer); buffer = VK_NULL_HANDLE; descriptorResourceGeneration_++; }
 	void QueueDeleteBufferView(VkBufferView &bufferView) { _dbg_assert_(bufferView != VK_NULL_HANDLE); bufferViews_.push_back(bufferView); bufferView = VK_NULL_HANDLE; }
-	void QueueDeleteImageView(VkImageView &imageView) { _dbg_assert_(imageView != VK_NULL_HANDLE); imageViews_.push_back(imageView); imageView = VK_NULL_HANDLE; }
+	void QueueDeleteImageView(VkImageView &imageView) { _dbg_assert_(imageView != VK_NULL_HANDLE); imageViews_.push_back(imageView); imageView = VK_NULL_HANDLE; descriptorResourceGeneration_++; }
 	void QueueDeleteDeviceMemory(VkDeviceMemory &deviceMemory) { _dbg_assert_(deviceMemory != VK_NULL_HANDLE); deviceMemory_.push_back(deviceMemory); deviceMemory = VK_NULL_HANDLE; }
-	void QueueDeleteSampler(VkSampler &sampler) { _dbg_assert_(sampler != VK_NULL_HANDLE); samplers_.push_back(sampler); sampler = VK_NULL_HANDLE; }
+	void QueueDeleteSampler(VkSampler &sampler) { _dbg_assert_(sampler != VK_NULL_HANDLE); samplers_.push_back(sampler); sampler = VK_NULL_HANDLE; descriptorResourceGeneration_++; }
 	void QueueDeletePipeline(VkPipeline &pipeline) { _dbg_assert_(pipeline != VK_NULL_HANDLE); pipelines_.push_back(pipeline); pipeline = VK_NULL_HANDLE; }
 	void QueueDeletePipelineCache(VkPipelineCache &pipelineCache) { _dbg_assert_(pipelineCache != VK_NULL_HANDLE); pipelineCaches_.push_back(pipelineCache); pipelineCache = VK_NULL_HANDLE; }
 	void QueueDeleteRenderPass(VkRenderPass &renderPass) { _dbg_assert_(renderPass != VK_NULL_HANDLE); renderPasses_.push_back(renderPass); renderPass = VK_NULL_HANDLE; }
@@ -126,6 +129,7 @@ class VulkanDeleteList {
 		buffersWithAllocs_.push_back(BufferWithAlloc{ buffer, alloc });
 		buffer = VK_NULL_HANDLE;
 		alloc = VK_NULL_HANDLE;
+		descriptorResourceGeneration_++;
 	}
 	void QueueDeleteImageAllocation(VkImage &image, VmaAllocation &alloc) {
 		_dbg_assert_(image != VK_NULL_HANDLE && alloc != VK_NULL_HANDLE);
@@ -137,7 +141,13 @@ class VulkanDeleteList {
 	void Take(VulkanDeleteList &del);
 	void PerformDeletes(VulkanContext *vulkan, VmaAllocator allocator);
 
+	// Bumped whenever a buffer, image view or sampler is queued for deletion. Once that happens,
+	// its handle may get reused, so descriptor sets cached across frames can't be trusted anymore.
+	static uint32_t DescriptorResourceGeneration() { return descriptorResourceGeneration_; }
+
 private:
+	static std::atomic<uint32_t> descriptorResourceGeneration_;
+
 	std::vector<VkCommandPool> cmdPools_;
 	std::vector<VkDescriptorPool> descPools_;
 	std::vector<VkShaderModule> modules_;
@@ -254,6 +264,18 @@ class VulkanContext {
 		return graphics_queue_family_index_;
 	}
 
+	// Only available if the device has a queue family that can do nothing but transfers (usually a DMA
+	// engine), and supports timeline semaphores to sync it with the graphics queue.
+	bool HasAsyncTransferQueue() const {
+		return transfer_queue_ != VK_NULL_HANDLE;
+	}
+	VkQueue GetTransferQueue() const {
+		return transfer_queue_;
+	}
+	int GetTransferQueueFamilyIndex() const {
+		return transfer_queue_family_index_;
+	}
+
 	struct PhysicalDeviceProps {
 		VkPhysicalDeviceProperties properties;
 		VkPhysicalDevicePushDescriptorPropertiesKHR pushDescriptorProperties;
@@ -264,6 +286,9 @@ class VulkanContext {
 	struct AllPhysicalDeviceFeatures {
 		VkPhysicalDeviceFeatures standard;
 		VkPhysicalDeviceMultiviewFeatures multiview;
+		VkPhysicalDevicePresentIdFeaturesKHR presentId;
+		VkPhysicalDevicePresentWaitFeaturesKHR presentWait;
+		VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphore;
 	};
 
 	const PhysicalDeviceProps &GetPhysicalDeviceProperties(int i = -1) const {
@@ -400,6 +425,7 @@ class VulkanContext {
 	VkInstance instance_ = VK_NULL_HANDLE;
 	VkDevice device_ = VK_NULL_HANDLE;
 	VkQueue gfx_queue_ = VK_NULL_HANDLE;
+	VkQueue transfer_queue_ = VK_NULL_HANDLE;
 	VkSurfaceKHR surface_ = VK_NULL_HANDLE;
 
 	std::string init_error_;
@@ -421,6 +447,7 @@ class VulkanContext {
 	int physical_device_ = -1;
 
 	uint32_t graphics_queue_family_index_ = -1;
+	uint32_t transfer_queue_family_index_ = -1;
 	std::vector<PhysicalDeviceProps> physicalDeviceProperties_;
 	std::vector<VkQueueFamilyProperties> queueFamilyProperties_;
 
@@ -22,6 +22,15 @@ void FrameData::Init(VulkanContext *vulkan, int index) {
 	_dbg_assert_(res == VK_SUCCESS);
 	res = vkCreateCommandPool(device, &cmd_pool_info, nullptr, &cmdPoolMain);
 	_dbg_assert_(res == VK_SUCCESS);
+	for (int i = 0; i < MAX_RECORD_THREADS; i++) {
+		res = vkCreateCommandPool(device, &cmd_pool_info, nullptr, &cmdPoolSecondary[i]);
+		_dbg_assert_(res == VK_SUCCESS);
+	}
+	if (vulkan->HasAsyncTransferQueue()) {
+		cmd_pool_info.queueFamilyIndex = vulkan->GetTransferQueueFamilyIndex();
+		res = vkCreateCommandPool(device, &cmd_pool_info, nullptr, &cmdPoolTransfer);
+		_dbg_assert_(res == VK_SUCCESS);
+	}
 
 	VkCommandBufferAllocateInfo cmd_alloc = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
 	cmd_alloc.commandPool = cmdPoolInit;
@@ -33,6 +42,12 @@ void FrameData::Init(VulkanContext *vulkan, int index) {
 	res = vkAllocateCommandBuffers(device, &cmd_alloc, &mainCmd);
 	res = vkAllocateCommandBuffers(device, &cmd_alloc, &presentCmd);
 	_dbg_assert_(res == VK_SUCCESS);
+	if (cmdPoolTransfer) {
+		cmd_alloc.commandPool = cmdPoolTransfer;
+		res = vkAllocateCommandBuffers(device, &cmd_alloc, &transferCmd);
+		_dbg_assert_(res == VK_SUCCESS);
+		vulkan->SetDebugName(transferCmd, VK_OBJECT_TYPE_COMMAND_BUFFER, StringFromFormat("transferCmd%d", index).c_str());
+	}
 
 	vulkan->SetDebugName(initCmd, VK_OBJECT_TYPE_COMMAND_BUFFER, StringFromFormat("initCmd%d", index).c_str());
 	vulkan->SetDebugName(mainCmd, VK_OBJECT_TYPE_COMMAND_BUFFER, StringFromFormat("mainCmd%d", index).c_str());
@@ -53,6 +68,17 @@ void FrameData::Destroy(VulkanContext *vulkan) {
 	VkDevice device = vulkan->GetDevice();
 	vkDestroyCommandPool(device, cmdPoolInit, nullptr);
 	vkDestroyCommandPool(device, cmdPoolMain, nullptr);
+	if (cmdPoolTransfer) {
+		vkDestroyCommandPool(device, cmdPoolTransfer, nullptr);
+		cmdPoolTransfer = VK_NULL_HANDLE;
+		transferCmd = VK_NULL_HANDLE;
+	}
+	for (int i = 0; i < MAX_RECORD_THREADS; i++) {
+		// Frees the secondary command buffers too.
+		vkDestroyCommandPool(device, cmdPoolSecondary[i], nullptr);
+		secondaryCmds[i].clear();
+		secondaryCmdsUsed[i] = 0;
+	}
 	vkDestroyFence(device, fence, nullptr);
 	vkDestroyQueryPool(device, profile.queryPool, nullptr);
 
@@ -104,9 +130,43 @@ VkResult FrameData::QueuePresent(VulkanContext *vulkan, FrameDataShared &shared)
 	present.pWaitSemaphores = &shared.renderingCompleteSemaphore;
 	present.waitSemaphoreCount = 1;
 
+	VkPresentIdKHR presentId{ VK_STRUCTURE_TYPE_PRESENT_ID_KHR };
+	uint64_t id = shared.lastPresentId + 1;
+	if (vulkan->Extensions().KHR_present_id) {
+		presentId.swapchainCount = 1;
+		presentId.pPresentIds = &id;
+		present.pNext = &presentId;
+		shared.lastPresentId = id;
+	}
+
 	return vkQueuePresentKHR(vulkan->GetGraphicsQueue(), &present);
 }
 
+void FrameData::ResetSecondaryCmds(VulkanContext *vulkan) {
+	for (int i = 0; i < MAX_RECORD_THREADS; i++) {
+		if (secondaryCmdsUsed[i] == 0)
+			continue;
+		vkResetCommandPool(vulkan->GetDevice(), cmdPoolSecondary[i], 0);
+		secondaryCmdsUsed[i] = 0;
+	}
+}
+
+VkCommandBuffer FrameData::GetSecondaryCmd(VulkanContext *vulkan, int pool) {
+	std::vector<VkCommandBuffer> &cmds = secondaryCmds[pool];
+	if (secondaryCmdsUsed[pool] == cmds.size()) {
+		VkCommandBufferAllocateInfo cmd_alloc = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+		cmd_alloc.commandPool = cmdPoolSecondary[pool];
+		cmd_alloc.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		cmd_alloc.commandBufferCount = 1;
+		VkCommandBuffer cmd = VK_NULL_HANDLE;
+		VkResult res = vkAllocateCommandBuffers(vulkan->GetDevice(), &cmd_alloc, &cmd);
+		if (res != VK_SUCCESS)
+			return VK_NULL_HANDLE;
+		cmds.push_back(cmd);
+	}
+	return cmds[secondaryCmdsUsed[pool]++];
+}
+
 VkCommandBuffer FrameData::GetInitCmd(VulkanContext *vulkan) {
 	if (!hasInitCommands) {
 		VkCommandBufferBeginInfo begin = {
@@ -131,12 +191,52 @@ VkCommandBuffer FrameData::GetInitCmd(VulkanContext *vulkan) {
 	return initCmd;
 }
 
+VkCommandBuffer FrameData::GetTransferCmd(VulkanContext *vulkan) {
+	if (!transferCmd)
+		return VK_NULL_HANDLE;
+	if (!hasTransferCommands) {
+		VkCommandBufferBeginInfo begin = {
+			VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			nullptr,
+			VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+		};
+		vkResetCommandPool(vulkan->GetDevice(), cmdPoolTransfer, 0);
+		VkResult res = vkBeginCommandBuffer(transferCmd, &begin);
+		if (res != VK_SUCCESS) {
+			return VK_NULL_HANDLE;
+		}
+		hasTransferCommands = true;
+	}
+	return transferCmd;
+}
+
 void FrameData::SubmitPending(VulkanContext *vulkan, FrameSubmitType type, FrameDataShared &sharedData) {
 	VkCommandBuffer cmdBufs[3];
 	int numCmdBufs = 0;
 
 	VkFence fenceToTrigger = VK_NULL_HANDLE;
 
+	if (hasTransferCommands) {
+		VkResult res = vkEndCommandBuffer(transferCmd);
+		_assert_msg_(res == VK_SUCCESS, "vkEndCommandBuffer failed (transfer)! result=%s", VulkanResultToString(res));
+		hasTransferCommands = false;
+
+		// Runs on its own queue, the graphics submit below (or a later one) waits for it.
+		const uint64_t signalValue = ++sharedData.transferSignaled;
+		VkTimelineSemaphoreSubmitInfoKHR timelineInfo{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR };
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+		VkSubmitInfo transferSubmit{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		transferSubmit.pNext = &timelineInfo;
+		transferSubmit.commandBufferCount = 1;
+		transferSubmit.pCommandBuffers = &transferCmd;
+		transferSubmit.signalSemaphoreCount = 1;
+		transferSubmit.pSignalSemaphores = &sharedData.transferSemaphore;
+		res = vkQueueSubmit(vulkan->GetTransferQueue(), 1, &transferSubmit, VK_NULL_HANDLE);
+		_assert_msg_(res == VK_SUCCESS, "vkQueueSubmit failed (transfer)! result=%s", VulkanResultToString(res));
+	}
+
 	if (hasInitCommands) {
 		if (profilingEnabled_) {
 			// Pre-allocated query ID 1 - end of init cmdbuf.
@@ -180,13 +280,33 @@ void FrameData::SubmitPending(VulkanContext *vulkan, FrameSubmitType type, Frame
 	}
 
 	VkSubmitInfo submit_info{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
-	VkPipelineStageFlags waitStage[1]{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+	VkSemaphore waitSemaphores[2];
+	VkPipelineStageFlags waitStages[2];
+	uint64_t waitValues[2]{};
+	uint32_t waitCount = 0;
 	if (type == FrameSubmitType::Present && !skipSwap) {
 		_dbg_assert_(hasAcquired);
-		submit_info.waitSemaphoreCount = 1;
-		submit_info.pWaitSemaphores = &sharedData.acquireSemaphore;
-		submit_info.pWaitDstStageMask = waitStage;
+		waitSemaphores[waitCount] = sharedData.acquireSemaphore;
+		waitStages[waitCount] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		waitCount++;
+	}
+	VkTimelineSemaphoreSubmitInfoKHR timelineInfo{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR };
+	if (sharedData.transferSignaled > sharedData.transferWaited) {
+		// Uploaded textures are only read by shaders and copies.
+		waitSemaphores[waitCount] = sharedData.transferSemaphore;
+		waitStages[waitCount] = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		waitValues[waitCount] = sharedData.transferSignaled;
+		waitCount++;
+		sharedData.transferWaited = sharedData.transferSignaled;
+
+		// The values for binary semaphores are ignored.
+		timelineInfo.waitSemaphoreValueCount = waitCount;
+		timelineInfo.pWaitSemaphoreValues = waitValues;
+		submit_info.pNext = &timelineInfo;
 	}
+	submit_info.waitSemaphoreCount = waitCount;
+	submit_info.pWaitSemaphores = waitCount ? waitSemaphores : nullptr;
+	submit_info.pWaitDstStageMask = waitCount ? waitStages : nullptr;
 	submit_info.commandBufferCount = (uint32_t)numCmdBufs;
 	submit_info.pCommandBuffers = cmdBufs;
 	if (type == FrameSubmitType::Present && !skipSwap) {
@@ -230,11 +350,26 @@ void FrameDataShared::Init(VulkanContext *vulkan) {
 	// This fence is used for synchronizing readbacks. Does not need preinitialization.
 	readbackFence = vulkan->CreateFence(false);
 	vulkan->SetDebugName(readbackFence, VK_OBJECT_TYPE_FENCE, "readbackFence");
+
+	if (vulkan->HasAsyncTransferQueue()) {
+		VkSemaphoreTypeCreateInfoKHR typeCreateInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR };
+		typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+		typeCreateInfo.initialValue = 0;
+		semaphoreCreateInfo.pNext = &typeCreateInfo;
+		res = vkCreateSemaphore(vulkan->GetDevice(), &semaphoreCreateInfo, nullptr, &transferSemaphore);
+		_dbg_assert_(res == VK_SUCCESS);
+		transferSignaled = 0;
+		transferWaited = 0;
+	}
 }
 
 void FrameDataShared::Destroy(VulkanContext *vulkan) {
 	VkDevice device = vulkan->GetDevice();
 	vkDestroySemaphore(device, acquireSemaphore, nullptr);
 	vkDestroySemaphore(device, renderingCompleteSemaphore, nullptr);
+	if (transferSemaphore) {
+		vkDestroySemaphore(device, transferSemaphore, nullptr);
+		transferSemaphore = VK_NULL_HANDLE;
+	}
 	vkDestroyFence(device, readbackFence, nullptr);
 }
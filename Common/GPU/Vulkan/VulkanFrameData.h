@@ -10,6 +10,8 @@
 
 enum {
 	MAX_TIMESTAMP_QUERIES = 128,
+	// Render passes can be recorded into secondary command buffers on this many threads at once.
+	MAX_RECORD_THREADS = 4,
 };
 
 enum class VKRRunType {
@@ -30,8 +32,11 @@ class VKRFramebuffer;
 
 struct ReadbackKey {
 	const VKRFramebuffer *framebuf;
+	// Color and depth of the same framebuffer are read back separately.
+	int aspectMask;
 	int width;
 	int height;
+	int pad;
 };
 
 struct CachedReadback {
@@ -51,6 +56,14 @@ struct FrameDataShared {
 	// For synchronous readbacks.
 	VkFence readbackFence = VK_NULL_HANDLE;
 
+	// Timeline semaphore signaled by the transfer queue, if we have one. Only touched on the render thread.
+	VkSemaphore transferSemaphore = VK_NULL_HANDLE;
+	uint64_t transferSignaled = 0;
+	uint64_t transferWaited = 0;
+
+	// Last id passed with VK_KHR_present_id, if enabled.  Only touched on the render thread.
+	uint64_t lastPresentId = 0;
+
 	void Init(VulkanContext *vulkan);
 	void Destroy(VulkanContext *vulkan);
 };
@@ -74,12 +87,17 @@ struct FrameData {
 	// These are on different threads so need separate pools.
 	VkCommandPool cmdPoolInit = VK_NULL_HANDLE;  // Written to from main thread
 	VkCommandPool cmdPoolMain = VK_NULL_HANDLE;  // Written to from render thread, which also submits
+	VkCommandPool cmdPoolTransfer = VK_NULL_HANDLE;  // Like cmdPoolInit, but for the transfer queue family
+	// For parallel render pass recording. Each pool is only used by one recording task at a time.
+	VkCommandPool cmdPoolSecondary[MAX_RECORD_THREADS]{};
 
 	VkCommandBuffer initCmd = VK_NULL_HANDLE;
 	VkCommandBuffer mainCmd = VK_NULL_HANDLE;
 	VkCommandBuffer presentCmd = VK_NULL_HANDLE;
+	VkCommandBuffer transferCmd = VK_NULL_HANDLE;
 
 	bool hasInitCommands = false;
+	bool hasTransferCommands = false;
 	bool hasMainCommands = false;
 	bool hasPresentCommands = false;
 
@@ -88,6 +106,10 @@ struct FrameData {
 
 	bool syncDone = false;
 
+	// Secondary command buffers are kept around and reused after the pools are reset.
+	std::vector<VkCommandBuffer> secondaryCmds[MAX_RECORD_THREADS];
+	size_t secondaryCmdsUsed[MAX_RECORD_THREADS]{};
+
 	// Swapchain.
 	uint32_t curSwapchainImage = -1;
 
@@ -108,6 +130,14 @@ struct FrameData {
 
 	// Generally called from the main thread, unlike most of the rest.
 	VkCommandBuffer GetInitCmd(VulkanContext *vulkan);
+	// Same, but executes on the transfer queue before anything else in the frame that reads from it.
+	// Returns VK_NULL_HANDLE if there's no transfer queue.
+	VkCommandBuffer GetTransferCmd(VulkanContext *vulkan);
+
+	// Called from the render thread, together with the reset of cmdPoolMain.
+	void ResetSecondaryCmds(VulkanContext *vulkan);
+	// Safe to call from several threads at once, as long as they use different pools.
+	VkCommandBuffer GetSecondaryCmd(VulkanContext *vulkan, int pool);
 
 	// This will only submit if we are actually recording init commands.
 	void SubmitPending(VulkanContext *vulkan, FrameSubmitType type, FrameDataShared &shared);
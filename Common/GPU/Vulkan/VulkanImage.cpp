@@ -37,7 +37,7 @@ static bool IsDepthStencilFormat(VkFormat format) {
 	}
 }
 
-bool VulkanTexture::CreateDirect(VkCommandBuffer cmd, int w, int h, int depth, int numMips, VkFormat format, VkImageLayout initialLayout, VkImageUsageFlags usage, const VkComponentMapping *mapping) {
+bool VulkanTexture::CreateDirect(VkCommandBuffer cmd, int w, int h, int depth, int numMips, VkFormat format, VkImageLayout initialLayout, VkImageUsageFlags usage, const VkComponentMapping *mapping, bool shareWithTransferQueue) {
 	if (w == 0 || h == 0 || numMips == 0) {
 		ERROR_LOG(G3D, "Can't create a zero-size VulkanTexture");
 		return false;
@@ -69,6 +69,16 @@ bool VulkanTexture::CreateDirect(VkCommandBuffer cmd, int w, int h, int depth, i
 	image_create_info.flags = 0;
 	image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
 	image_create_info.usage = usage;
+	uint32_t queueFamilies[2];
+	if (shareWithTransferQueue) {
+		_dbg_assert_(vulkan_->HasAsyncTransferQueue());
+		queueFamilies[0] = vulkan_->GetGraphicsQueueFamilyIndex();
+		queueFamilies[1] = vulkan_->GetTransferQueueFamilyIndex();
+		// Avoids queue family ownership transfers, which would need barriers on both queues.
+		image_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		image_create_info.queueFamilyIndexCount = 2;
+		image_create_info.pQueueFamilyIndices = queueFamilies;
+	}
 	if (initialLayout == VK_IMAGE_LAYOUT_PREINITIALIZED) {
 		image_create_info.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
 	} else {
@@ -237,6 +247,14 @@ void VulkanTexture::EndCreate(VkCommandBuffer cmd, bool vertexTexture, VkPipelin
 		prevStage == VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
 }
 
+void VulkanTexture::EndCreateOnTransferQueue(VkCommandBuffer cmd) {
+	TransitionImageLayout2(cmd, image_, 0, numMips_, 1,
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		VK_ACCESS_TRANSFER_WRITE_BIT, 0);
+}
+
 VkImageView VulkanTexture::CreateViewForMip(int mip) {
 	VkImageViewCreateInfo view_info = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
 	view_info.image = image_;
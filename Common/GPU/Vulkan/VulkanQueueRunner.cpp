@@ -1,10 +1,14 @@
 #include <unordered_map>
 
 #include "Common/GPU/DataFormat.h"
+#include "Common/GPU/ShaderCompileLog.h"
 #include "Common/GPU/Vulkan/VulkanQueueRunner.h"
 #include "Common/GPU/Vulkan/VulkanRenderManager.h"
 #include "Common/VR/PPSSPPVR.h"
 #include "Common/Log.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Common/TimeUtil.h"
 
 using namespace PPSSPP_VK;
@@ -336,6 +340,7 @@ void VulkanQueueRunner::PreprocessSteps(std::vector<VKRStep *> &steps) {
 					steps[i]->render.numReads += steps[j]->render.numReads;
 					// Cheaply skip the first step.
 					steps[j]->stepType = VKRStepType::RENDER_SKIP;
+					stepStats_.merged++;
 					break;
 				} else if (steps[i]->stepType == VKRStepType::COPY &&
 					steps[i]->copy.src == steps[j]->render.framebuffer) {
@@ -348,6 +353,9 @@ void VulkanQueueRunner::PreprocessSteps(std::vector<VKRStep *> &steps) {
 		}
 	}
 
+	RemoveDeadSteps(steps);
+	MergeAdjacentRenderSteps(steps);
+
 	// Queue hacks.
 	if (hacksEnabled_) {
 		if (hacksEnabled_ & QUEUE_HACK_MGS2_ACID) {
@@ -373,8 +381,12 @@ void VulkanQueueRunner::RunSteps(std::vector<VKRStep *> &steps, FrameData &frame
 
 	VkCommandBuffer cmd = frameData.hasPresentCommands ? frameData.presentCmd : frameData.mainCmd;
 
+	// The big render passes get recorded up front, the loop below then only has to sequence them.
+	RecordRenderPassesInParallel(steps, frameData, profile != nullptr);
+
 	for (size_t i = 0; i < steps.size(); i++) {
 		const VKRStep &step = *steps[i];
+		double stepStartTime = profile ? time_now_d() : 0.0;
 
 		if (emitLabels) {
 			VkDebugUtilsLabelEXT labelInfo{ VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT };
@@ -411,7 +423,7 @@ void VulkanQueueRunner::RunSteps(std::vector<VKRStep *> &steps, FrameData &frame
 				}
 				cmd = frameData.presentCmd;
 			}
-			PerformRenderPass(step, cmd);
+			PerformRenderPass(step, cmd, secondaryCmds_[i]);
 			break;
 		case VKRStepType::COPY:
 			PerformCopy(step, cmd);
@@ -431,7 +443,9 @@ void VulkanQueueRunner::RunSteps(std::vector<VKRStep *> &steps, FrameData &frame
 
 		if (profile && profile->timestampDescriptions.size() + 1 < MAX_TIMESTAMP_QUERIES) {
 			vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, profile->queryPool, (uint32_t)profile->timestampDescriptions.size());
-			profile->timestampDescriptions.push_back(StepToString(step));
+			// Parallel recorded passes also count the time spent on the worker.
+			double cpuTime = time_now_d() - stepStartTime + secondaryRecordTime_[i];
+			profile->timestampDescriptions.push_back(StepToString(step) + StringFromFormat(" [CPU %0.3f ms%s]", cpuTime * 1000.0, secondaryCmds_[i] ? ", parallel" : ""));
 		}
 
 		if (emitLabels) {
@@ -452,6 +466,126 @@ void VulkanQueueRunner::RunSteps(std::vector<VKRStep *> &steps, FrameData &frame
 		profile->cpuEndTime = time_now_d();
 }
 
+static RPKey RenderStepRPKey(const VKRStep &step) {
+	return RPKey{
+		step.render.colorLoad, step.render.depthLoad, step.render.stencilLoad,
+		step.render.colorStore, step.render.depthStore, step.render.stencilStore,
+	};
+}
+
+// Recording a render pass on a worker only pays off for passes with lots of commands.
+static const size_t PARALLEL_RECORD_MIN_COMMANDS = 128;
+
+// Called on the render thread. Also does the pipeline fixup of PerformRenderPassCommands up front, so the
+// workers never create anything. Nothing on a worker may wait for a pipeline compile either, since the compiles
+// run on the same thread pool, so passes with pipelines that aren't ready (and have no ready fallback) are left inline.
+bool VulkanQueueRunner::CanRecordRenderPassInParallel(const VKRStep &step) {
+	if (step.stepType != VKRStepType::RENDER || !step.render.framebuffer || step.commands.size() < PARALLEL_RECORD_MIN_COMMANDS)
+		return false;
+	if (step.render.pipelineFlags & PipelineFlags::USES_INPUT_ATTACHMENT)
+		return false;
+
+	VKRFramebuffer *fb = step.render.framebuffer;
+	const RenderPassType rpType = step.render.renderPassType;
+	VKRRenderPass *renderPass = GetRenderPass(RenderStepRPKey(step));
+
+	bool hasViewport = false;
+	bool hasScissor = false;
+	for (const VkRenderData &c : step.commands) {
+		switch (c.cmd) {
+		case VKRRenderCommand::BIND_GRAPHICS_PIPELINE:
+		{
+			VKRGraphicsPipeline *graphicsPipeline = c.graphics_pipeline.pipeline;
+			if (!graphicsPipeline->pipeline[(size_t)rpType]) {
+				graphicsPipeline->pipeline[(size_t)rpType] = Promise<VkPipeline>::CreateEmpty();
+				graphicsPipeline->Create(vulkan_, renderPass->Get(vulkan_, rpType, fb->sampleCount), rpType, fb->sampleCount, time_now_d(), -1);
+				pipelineStats_.waited++;
+			}
+			if (graphicsPipeline->pipeline[(size_t)rpType]->Poll() == VK_NULL_HANDLE) {
+				VKRGraphicsPipeline *fallback = graphicsPipeline->fallback;
+				if (!fallback || !fallback->pipeline[(size_t)rpType] || fallback->pipeline[(size_t)rpType]->Poll() == VK_NULL_HANDLE)
+					return false;
+			}
+			break;
+		}
+		case VKRRenderCommand::BIND_COMPUTE_PIPELINE:
+			if (c.compute_pipeline.pipeline->pipeline->Poll() == VK_NULL_HANDLE)
+				return false;
+			break;
+		case VKRRenderCommand::VIEWPORT:
+			hasViewport = true;
+			break;
+		case VKRRenderCommand::SCISSOR:
+			hasScissor = true;
+			break;
+		case VKRRenderCommand::DRAW:
+		case VKRRenderCommand::DRAW_INDEXED:
+			// Dynamic state isn't inherited by secondary command buffers, so it must be set in the pass itself.
+			if (!hasViewport || !hasScissor)
+				return false;
+			break;
+		default:
+			break;
+		}
+	}
+	return true;
+}
+
+void VulkanQueueRunner::RecordRenderPassesInParallel(const std::vector<VKRStep *> &steps, FrameData &frameData, bool profile) {
+	secondaryCmds_.assign(steps.size(), VK_NULL_HANDLE);
+	secondaryRecordTime_.assign(steps.size(), 0.0);
+	if (!parallelRecording_)
+		return;
+
+	struct ParallelPass {
+		size_t index;
+		VKRRenderPass *renderPass;
+		VkRenderPass vkRenderPass;
+	};
+	std::vector<ParallelPass> passes;
+	for (size_t i = 0; i < steps.size(); i++) {
+		const VKRStep &step = *steps[i];
+		if (!CanRecordRenderPassInParallel(step))
+			continue;
+		// Only needs to be compatible with the one PerformBindFramebufferAsRenderTarget picks, but it's the same anyway.
+		VKRRenderPass *renderPass = GetRenderPass(RenderStepRPKey(step));
+		passes.push_back(ParallelPass{ i, renderPass, renderPass->Get(vulkan_, step.render.renderPassType, step.render.framebuffer->sampleCount) });
+	}
+	// With a single pass, the render thread would just sit and wait for it.
+	if (passes.size() < 2)
+		return;
+
+	const int numTasks = std::min((int)passes.size(), (int)MAX_RECORD_THREADS);
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		for (int task = lower; task < upper; task++) {
+			// Each task owns one of the secondary command pools.
+			for (size_t j = task; j < passes.size(); j += numTasks) {
+				const ParallelPass &pass = passes[j];
+				VkCommandBuffer cmd = frameData.GetSecondaryCmd(vulkan_, task);
+				if (cmd == VK_NULL_HANDLE)
+					continue;
+				double startTime = profile ? time_now_d() : 0.0;
+
+				VkCommandBufferInheritanceInfo inherit{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+				inherit.renderPass = pass.vkRenderPass;
+				inherit.subpass = 0;
+				VkCommandBufferBeginInfo begin{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+				begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+				begin.pInheritanceInfo = &inherit;
+				vkBeginCommandBuffer(cmd, &begin);
+				PerformRenderPassCommands(*steps[pass.index], pass.renderPass, cmd);
+				if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
+					continue;
+
+				// Different indices from each task, no locking needed.
+				secondaryCmds_[pass.index] = cmd;
+				if (profile)
+					secondaryRecordTime_[pass.index] = time_now_d() - startTime;
+			}
+		}
+	}, 0, numTasks, 1, TaskPriority::HIGH);
+}
+
 void VulkanQueueRunner::ApplyMGSHack(std::vector<VKRStep *> &steps) {
 	// Really need a sane way to express transforms of steps.
 
@@ -838,6 +972,143 @@ void VulkanQueueRunner::ApplyRenderPassMerge(std::vector<VKRStep *> &steps) {
 	}
 }
 
+// Returns true if everything in the framebuffer gets overwritten by a step before anything reads it,
+// scanning from the step after start. If we get to the end of the frame, it's live, it might be displayed
+// or read next frame.
+static bool IsOverwrittenBeforeRead(const std::vector<VKRStep *> &steps, size_t start, VKRFramebuffer *fb) {
+	for (size_t i = start; i < steps.size(); i++) {
+		const VKRStep *step = steps[i];
+		if (step->dependencies.contains(fb))
+			return false;
+		switch (step->stepType) {
+		case VKRStepType::RENDER:
+			if (step->render.framebuffer == fb) {
+				const auto &r = step->render;
+				// Load ops only apply inside the render area.
+				bool fullArea = r.renderArea.offset.x == 0 && r.renderArea.offset.y == 0 &&
+					(int)r.renderArea.extent.width >= fb->width && (int)r.renderArea.extent.height >= fb->height;
+				return fullArea && r.colorLoad != VKRRenderPassLoadAction::KEEP && r.depthLoad != VKRRenderPassLoadAction::KEEP && r.stencilLoad != VKRRenderPassLoadAction::KEEP;
+			}
+			break;
+		case VKRStepType::COPY:
+			if (step->copy.src == fb)
+				return false;
+			break;
+		case VKRStepType::BLIT:
+			if (step->blit.src == fb)
+				return false;
+			break;
+		case VKRStepType::READBACK:
+			if (step->readback.src == fb)
+				return false;
+			break;
+		case VKRStepType::READBACK_IMAGE:
+		case VKRStepType::RENDER_SKIP:
+			break;
+		default:
+			// We added a new step? Might be unsafe.
+			return false;
+		}
+	}
+	return false;
+}
+
+// Drops render passes, copies and blits into framebuffers that get fully cleared again before anything
+// reads them. Vulkan load ops can't take their contents from another image, so copies and blits can't be
+// folded into the next pass, but when nothing reads the result they can go away entirely.
+void VulkanQueueRunner::RemoveDeadSteps(std::vector<VKRStep *> &steps) {
+	for (size_t i = 0; i < steps.size(); i++) {
+		VKRStep *step = steps[i];
+		switch (step->stepType) {
+		case VKRStepType::RENDER:
+			// The backbuffer is always presented, and reads we don't see as dependencies (downloads) keep it alive.
+			if (step->render.framebuffer && step->render.numReads == 0 && IsOverwrittenBeforeRead(steps, i + 1, step->render.framebuffer)) {
+				step->dependencies.clear();
+				step->stepType = VKRStepType::RENDER_SKIP;
+				stepStats_.dead++;
+			}
+			break;
+		case VKRStepType::COPY:
+			if (IsOverwrittenBeforeRead(steps, i + 1, step->copy.dst)) {
+				step->dependencies.clear();
+				step->stepType = VKRStepType::RENDER_SKIP;
+				stepStats_.deadCopies++;
+			}
+			break;
+		case VKRStepType::BLIT:
+			if (IsOverwrittenBeforeRead(steps, i + 1, step->blit.dst)) {
+				step->dependencies.clear();
+				step->stepType = VKRStepType::RENDER_SKIP;
+				stepStats_.deadCopies++;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+// Merges render passes to the same framebuffer that end up right after each other, like when a game
+// rebinds the same target, or the steps between them got removed. Unlike ApplyRenderPassMerge,
+// this never reorders anything so it's always safe.
+void VulkanQueueRunner::MergeAdjacentRenderSteps(std::vector<VKRStep *> &steps) {
+	VKRStep *prev = nullptr;
+	for (size_t i = 0; i < steps.size(); i++) {
+		VKRStep *step = steps[i];
+		if (step->stepType == VKRStepType::RENDER_SKIP)
+			continue;
+		if (step->stepType != VKRStepType::RENDER) {
+			prev = nullptr;
+			continue;
+		}
+
+		VKRFramebuffer *fb = step->render.framebuffer;
+		bool canMerge = prev && fb && prev->render.framebuffer == fb &&
+			step->render.colorLoad != VKRRenderPassLoadAction::CLEAR &&
+			step->render.depthLoad != VKRRenderPassLoadAction::CLEAR &&
+			step->render.stencilLoad != VKRRenderPassLoadAction::CLEAR &&
+			!step->dependencies.contains(fb);
+		for (size_t j = 0; canMerge && j < step->preTransitions.size(); j++) {
+			if (step->preTransitions[j].fb == fb)
+				canMerge = false;
+		}
+		if (!canMerge) {
+			prev = step;
+			continue;
+		}
+
+		// The later pass decides what's stored, and what layout things are left in.
+		auto &dst = prev->render;
+		const auto &src = step->render;
+		prev->preTransitions.append(step->preTransitions);
+		prev->commands.insert(prev->commands.end(), step->commands.begin(), step->commands.end());
+		MergeRenderAreaRectInto(&dst.renderArea, src.renderArea);
+		dst.colorStore = src.colorStore;
+		dst.depthStore = src.depthStore;
+		dst.stencilStore = src.stencilStore;
+		dst.finalColorLayout = src.finalColorLayout;
+		dst.finalDepthStencilLayout = src.finalDepthStencilLayout;
+		dst.numDraws += src.numDraws;
+		dst.numReads += src.numReads;
+		dst.pipelineFlags |= src.pipelineFlags;
+		dst.renderPassType = MergeRPTypes(dst.renderPassType, src.renderPassType);
+
+		step->dependencies.clear();
+		step->stepType = VKRStepType::RENDER_SKIP;
+		stepStats_.merged++;
+	}
+}
+
+void VulkanQueueRunner::PublishStepOptimizerStats() {
+	stepStats_.lastFrameMerged = stepStats_.merged;
+	stepStats_.lastFrameDead = stepStats_.dead;
+	stepStats_.lastFrameDeadCopies = stepStats_.deadCopies;
+	stepStats_.totalRemoved += stepStats_.merged + stepStats_.dead + stepStats_.deadCopies;
+	stepStats_.merged = 0;
+	stepStats_.dead = 0;
+	stepStats_.deadCopies = 0;
+}
+
 void VulkanQueueRunner::LogSteps(const std::vector<VKRStep *> &steps, bool verbose) {
 	INFO_LOG(G3D, "===================  FRAME  ====================");
 	for (size_t i = 0; i < steps.size(); i++) {
@@ -1143,7 +1414,7 @@ void TransitionFromOptimal(VkCommandBuffer cmd, VkImage colorImage, VkImageLayou
 	}
 }
 
-void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer cmd) {
+void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer cmd, VkCommandBuffer secondary) {
 	for (size_t i = 0; i < step.preTransitions.size(); i++) {
 		const TransitionRequest &iter = step.preTransitions[i];
 		if (iter.aspect == VK_IMAGE_ASPECT_COLOR_BIT && iter.fb->color.layout != iter.targetLayout) {
@@ -1223,8 +1494,26 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 	// will transition to the desired final layout.
 	//
 	// NOTE: Flushes recordBarrier_.
-	VKRRenderPass *renderPass = PerformBindFramebufferAsRenderTarget(step, cmd);
+	VKRRenderPass *renderPass = PerformBindFramebufferAsRenderTarget(step, cmd, secondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 
+	if (secondary) {
+		vkCmdExecuteCommands(cmd, 1, &secondary);
+	} else {
+		PerformRenderPassCommands(step, renderPass, cmd);
+	}
+	vkCmdEndRenderPass(cmd);
+
+	VKRFramebuffer *fb = step.render.framebuffer;
+	if (fb) {
+		// If the desired final layout aren't the optimal layout for rendering, transition.
+		TransitionFromOptimal(cmd, fb->color.image, step.render.finalColorLayout, fb->depth.image, fb->numLayers, step.render.finalDepthStencilLayout);
+
+		fb->color.layout = step.render.finalColorLayout;
+		fb->depth.layout = step.render.finalDepthStencilLayout;
+	}
+}
+
+void VulkanQueueRunner::PerformRenderPassCommands(const VKRStep &step, VKRRenderPass *renderPass, VkCommandBuffer cmd) {
 	int curWidth = step.render.framebuffer ? step.render.framebuffer->width : vulkan_->GetBackbufferWidth();
 	int curHeight = step.render.framebuffer ? step.render.framebuffer->height : vulkan_->GetBackbufferHeight();
 
@@ -1247,6 +1536,35 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 	int lastStencilCompareMask = -1;
 	int lastStencilReference = -1;
 
+	// Draws that only switch texture still come with the same index and often vertex buffer,
+	// so only the descriptor set actually needs rebinding. Track the rest.
+	VkDescriptorSet lastDs = VK_NULL_HANDLE;
+	VkPipelineLayout lastDsLayout = VK_NULL_HANDLE;
+	int lastNumUboOffsets = -1;
+	uint32_t lastUboOffsets[3]{};
+	VkBuffer lastIBuffer = VK_NULL_HANDLE;
+	uint32_t lastIOffset = 0;
+	int lastIndexType = -1;
+	VkBuffer lastVBuffer = VK_NULL_HANDLE;
+	VkDeviceSize lastVOffset = 0;
+
+	auto bindDescriptorSet = [&](VkDescriptorSet ds, int numUboOffsets, const uint32_t *uboOffsets) {
+		if (ds == lastDs && pipelineLayout == lastDsLayout && numUboOffsets == lastNumUboOffsets && !memcmp(uboOffsets, lastUboOffsets, numUboOffsets * sizeof(uint32_t)))
+			return;
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &ds, numUboOffsets, uboOffsets);
+		lastDs = ds;
+		lastDsLayout = pipelineLayout;
+		lastNumUboOffsets = numUboOffsets;
+		memcpy(lastUboOffsets, uboOffsets, numUboOffsets * sizeof(uint32_t));
+	};
+	auto bindVertexBuffer = [&](VkBuffer vbuffer, VkDeviceSize voffset) {
+		if (vbuffer == lastVBuffer && voffset == lastVOffset)
+			return;
+		vkCmdBindVertexBuffers(cmd, 0, 1, &vbuffer, &voffset);
+		lastVBuffer = vbuffer;
+		lastVOffset = voffset;
+	};
+
 	const RenderPassType rpType = step.render.renderPassType;
 
 	for (size_t i = 0; i < commands.size(); i++) {
@@ -1275,9 +1593,27 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 					// happen all that much.
 					graphicsPipeline->pipeline[(size_t)rpType] = Promise<VkPipeline>::CreateEmpty();
 					graphicsPipeline->Create(vulkan_, renderPass->Get(vulkan_, rpType, fbSampleCount), rpType, fbSampleCount, time_now_d(), -1);
+					pipelineStats_.waited++;
 				}
 
-				VkPipeline pipeline = graphicsPipeline->pipeline[(size_t)rpType]->BlockUntilReady();
+				VkPipeline pipeline = graphicsPipeline->pipeline[(size_t)rpType]->Poll();
+				if (pipeline == VK_NULL_HANDLE) {
+					// Rather than stalling on the compile, draw with the fallback if that's ready.
+					VKRGraphicsPipeline *fallback = graphicsPipeline->fallback;
+					if (fallback && fallback->pipeline[(size_t)rpType])
+						pipeline = fallback->pipeline[(size_t)rpType]->Poll();
+					if (pipeline != VK_NULL_HANDLE) {
+						pipelineStats_.usedFallback++;
+					} else {
+						double waitStart = time_now_d();
+						pipeline = graphicsPipeline->pipeline[(size_t)rpType]->BlockUntilReady();
+						ShaderCompileLog_Record(ShaderCompileStage::PIPELINE_WAIT, graphicsPipeline->Tag(), time_now_d() - waitStart, true);
+						if (pipeline != VK_NULL_HANDLE)
+							pipelineStats_.waited++;
+						else
+							pipelineStats_.skipped++;
+					}
+				}
 
 				if (pipeline != VK_NULL_HANDLE) {
 					vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
@@ -1391,19 +1727,29 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 
 		case VKRRenderCommand::DRAW_INDEXED:
 			if (pipelineOK) {
-				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &c.drawIndexed.ds, c.drawIndexed.numUboOffsets, c.drawIndexed.uboOffsets);
-				vkCmdBindIndexBuffer(cmd, c.drawIndexed.ibuffer, c.drawIndexed.ioffset, (VkIndexType)c.drawIndexed.indexType);
-				VkDeviceSize voffset = c.drawIndexed.voffset;
-				vkCmdBindVertexBuffers(cmd, 0, 1, &c.drawIndexed.vbuffer, &voffset);
-				vkCmdDrawIndexed(cmd, c.drawIndexed.count, c.drawIndexed.instances, 0, 0, 0);
+				bindDescriptorSet(c.drawIndexed.ds, c.drawIndexed.numUboOffsets, c.drawIndexed.uboOffsets);
+				// Indices of consecutive draws are usually pushed into the same buffer, so keep it bound
+				// and start further in with firstIndex, when the offset allows it.
+				const uint32_t indexSize = c.drawIndexed.indexType == VK_INDEX_TYPE_UINT32 ? 4 : 2;
+				uint32_t firstIndex = 0;
+				if (c.drawIndexed.ibuffer == lastIBuffer && c.drawIndexed.indexType == lastIndexType && c.drawIndexed.ioffset >= lastIOffset && (c.drawIndexed.ioffset - lastIOffset) % indexSize == 0) {
+					firstIndex = (c.drawIndexed.ioffset - lastIOffset) / indexSize;
+				} else {
+					vkCmdBindIndexBuffer(cmd, c.drawIndexed.ibuffer, c.drawIndexed.ioffset, (VkIndexType)c.drawIndexed.indexType);
+					lastIBuffer = c.drawIndexed.ibuffer;
+					lastIOffset = c.drawIndexed.ioffset;
+					lastIndexType = c.drawIndexed.indexType;
+				}
+				bindVertexBuffer(c.drawIndexed.vbuffer, c.drawIndexed.voffset);
+				vkCmdDrawIndexed(cmd, c.drawIndexed.count, c.drawIndexed.instances, firstIndex, 0, 0);
 			}
 			break;
 
 		case VKRRenderCommand::DRAW:
 			if (pipelineOK) {
-				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &c.draw.ds, c.draw.numUboOffsets, c.draw.uboOffsets);
+				bindDescriptorSet(c.draw.ds, c.draw.numUboOffsets, c.draw.uboOffsets);
 				if (c.draw.vbuffer) {
-					vkCmdBindVertexBuffers(cmd, 0, 1, &c.draw.vbuffer, &c.draw.voffset);
+					bindVertexBuffer(c.draw.vbuffer, c.draw.voffset);
 				}
 				vkCmdDraw(cmd, c.draw.count, 1, c.draw.offset, 0);
 			}
@@ -1456,18 +1802,9 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 			break;
 		}
 	}
-	vkCmdEndRenderPass(cmd);
-
-	if (fb) {
-		// If the desired final layout aren't the optimal layout for rendering, transition.
-		TransitionFromOptimal(cmd, fb->color.image, step.render.finalColorLayout, fb->depth.image, fb->numLayers, step.render.finalDepthStencilLayout);
-
-		fb->color.layout = step.render.finalColorLayout;
-		fb->depth.layout = step.render.finalDepthStencilLayout;
-	}
 }
 
-VKRRenderPass *VulkanQueueRunner::PerformBindFramebufferAsRenderTarget(const VKRStep &step, VkCommandBuffer cmd) {
+VKRRenderPass *VulkanQueueRunner::PerformBindFramebufferAsRenderTarget(const VKRStep &step, VkCommandBuffer cmd, VkSubpassContents contents) {
 	VKRRenderPass *renderPass;
 	int numClearVals = 0;
 	VkClearValue clearVal[4]{};
@@ -1483,11 +1820,7 @@ VKRRenderPass *VulkanQueueRunner::PerformBindFramebufferAsRenderTarget(const VKR
 		_dbg_assert_(step.render.finalColorLayout != VK_IMAGE_LAYOUT_UNDEFINED);
 		_dbg_assert_(step.render.finalDepthStencilLayout != VK_IMAGE_LAYOUT_UNDEFINED);
 
-		RPKey key{
-			step.render.colorLoad, step.render.depthLoad, step.render.stencilLoad,
-			step.render.colorStore, step.render.depthStore, step.render.stencilStore,
-		};
-		renderPass = GetRenderPass(key);
+		renderPass = GetRenderPass(RenderStepRPKey(step));
 
 		VKRFramebuffer *fb = step.render.framebuffer;
 		framebuf = fb->Get(renderPass, step.render.renderPassType);
@@ -1578,7 +1911,7 @@ VKRRenderPass *VulkanQueueRunner::PerformBindFramebufferAsRenderTarget(const VKR
 	rp_begin.renderArea = rc;
 	rp_begin.clearValueCount = numClearVals;
 	rp_begin.pClearValues = numClearVals ? clearVal : nullptr;
-	vkCmdBeginRenderPass(cmd, &rp_begin, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(cmd, &rp_begin, contents);
 
 	return renderPass;
 }
@@ -2013,8 +2346,9 @@ void VulkanQueueRunner::PerformReadback(const VKRStep &step, VkCommandBuffer cmd
 	CachedReadback *cached = nullptr;
 
 	if (step.readback.delayed) {
-		ReadbackKey key;
+		ReadbackKey key{};
 		key.framebuf = step.readback.src;
+		key.aspectMask = step.readback.aspectMask;
 		key.width = step.readback.srcRect.extent.width;
 		key.height = step.readback.srcRect.extent.height;
 
@@ -2091,13 +2425,14 @@ void VulkanQueueRunner::PerformReadbackImage(const VKRStep &step, VkCommandBuffe
 	// Doing that will also act like a heavyweight barrier ensuring that device writes are visible on the host.
 }
 
-bool VulkanQueueRunner::CopyReadbackBuffer(FrameData &frameData, VKRFramebuffer *src, int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels) {
+bool VulkanQueueRunner::CopyReadbackBuffer(FrameData &frameData, VKRFramebuffer *src, int aspectMask, int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels) {
 	CachedReadback *readback = &syncReadback_;
 
 	// Look up in readback cache.
 	if (src) {
-		ReadbackKey key;
+		ReadbackKey key{};
 		key.framebuf = src;
+		key.aspectMask = aspectMask;
 		key.width = width;
 		key.height = height;
 		CachedReadback *cached = frameData.readbacks_.Get(key);
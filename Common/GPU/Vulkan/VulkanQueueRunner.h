@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <condition_variable>
@@ -20,6 +21,34 @@ struct VKRComputePipeline;
 struct VKRImage;
 struct FrameData;
 
+// Pipeline compile telemetry, updated from the compile tasks and the render thread.
+struct VKRPipelineStats {
+	// Handed to compile tasks, but not done yet.
+	std::atomic<int> pending{};
+	std::atomic<int> maxPending{};
+	std::atomic<int> compiled{};
+	std::atomic<int> failed{};
+	std::atomic<int64_t> totalCompileUs{};
+	std::atomic<int> maxCompileUs{};
+
+	// What happened when binding pipelines that weren't done yet.
+	std::atomic<int> waited{};
+	std::atomic<int> usedFallback{};
+	std::atomic<int> skipped{};
+};
+
+// Steps removed by PreprocessSteps. Counted on the render thread, published once per presented frame.
+struct VKRStepOptimizerStats {
+	int merged = 0;
+	int dead = 0;
+	int deadCopies = 0;
+
+	std::atomic<int> lastFrameMerged{};
+	std::atomic<int> lastFrameDead{};
+	std::atomic<int> lastFrameDeadCopies{};
+	std::atomic<int64_t> totalRemoved{};
+};
+
 enum {
 	QUEUE_HACK_MGS2_ACID = 1,
 	QUEUE_HACK_SONIC = 2,
@@ -254,7 +283,7 @@ class VulkanQueueRunner {
 	}
 
 	// src == 0 means to copy from the sync readback buffer.
-	bool CopyReadbackBuffer(FrameData &frameData, VKRFramebuffer *src, int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels);
+	bool CopyReadbackBuffer(FrameData &frameData, VKRFramebuffer *src, int aspectMask, int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels);
 
 	VKRRenderPass *GetRenderPass(const RPKey &key);
 
@@ -282,12 +311,32 @@ class VulkanQueueRunner {
 		compileDone_.wait(lock);
 	}
 
+	// Records big render passes into secondary command buffers on the thread pool.
+	void EnableParallelRecording(bool enable) {
+		parallelRecording_ = enable;
+	}
+
+	VKRPipelineStats &PipelineStats() {
+		return pipelineStats_;
+	}
+
+	const VKRStepOptimizerStats &StepOptimizerStats() const {
+		return stepStats_;
+	}
+	// Called on the render thread when a frame is presented.
+	void PublishStepOptimizerStats();
+
 private:
 	bool InitBackbufferFramebuffers(int width, int height);
 	bool InitDepthStencilBuffer(VkCommandBuffer cmd);  // Used for non-buffered rendering.
 
-	VKRRenderPass *PerformBindFramebufferAsRenderTarget(const VKRStep &pass, VkCommandBuffer cmd);
-	void PerformRenderPass(const VKRStep &pass, VkCommandBuffer cmd);
+	VKRRenderPass *PerformBindFramebufferAsRenderTarget(const VKRStep &pass, VkCommandBuffer cmd, VkSubpassContents contents);
+	// If secondary is set, it must already contain the commands of the pass (see RecordRenderPassesInParallel).
+	void PerformRenderPass(const VKRStep &pass, VkCommandBuffer cmd, VkCommandBuffer secondary = VK_NULL_HANDLE);
+	// Records the commands inside the render pass. Doesn't touch any member state except the pipeline stats.
+	void PerformRenderPassCommands(const VKRStep &pass, VKRRenderPass *renderPass, VkCommandBuffer cmd);
+	bool CanRecordRenderPassInParallel(const VKRStep &pass);
+	void RecordRenderPassesInParallel(const std::vector<VKRStep *> &steps, FrameData &frameData, bool profile);
 	void PerformCopy(const VKRStep &pass, VkCommandBuffer cmd);
 	void PerformBlit(const VKRStep &pass, VkCommandBuffer cmd);
 	void PerformReadback(const VKRStep &pass, VkCommandBuffer cmd, FrameData &frameData);
@@ -304,6 +353,8 @@ class VulkanQueueRunner {
 	void ApplyMGSHack(std::vector<VKRStep *> &steps);
 	void ApplySonicHack(std::vector<VKRStep *> &steps);
 	void ApplyRenderPassMerge(std::vector<VKRStep *> &steps);
+	void RemoveDeadSteps(std::vector<VKRStep *> &steps);
+	void MergeAdjacentRenderSteps(std::vector<VKRStep *> &steps);
 
 	static void SetupTransitionToTransferSrc(VKRImage &img, VkImageAspectFlags aspect, VulkanBarrier *recordBarrier);
 	static void SetupTransitionToTransferDst(VKRImage &img, VkImageAspectFlags aspect, VulkanBarrier *recordBarrier);
@@ -334,6 +385,14 @@ class VulkanQueueRunner {
 	std::mutex compileDoneMutex_;
 	std::condition_variable compileDone_;
 
+	VKRPipelineStats pipelineStats_;
+	VKRStepOptimizerStats stepStats_;
+
+	// Per step, filled in by RecordRenderPassesInParallel. Null for steps recorded inline.
+	std::vector<VkCommandBuffer> secondaryCmds_;
+	std::vector<double> secondaryRecordTime_;
+	bool parallelRecording_ = false;
+
 	// Image barrier helper used during command buffer record (PerformRenderPass etc).
 	// Stored here to help reuse the allocation.
 
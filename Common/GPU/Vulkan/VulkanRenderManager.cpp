@@ -4,6 +4,7 @@
 #include <map>
 #include <sstream>
 
+#include "Common/GPU/ShaderCompileLog.h"
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
@@ -12,6 +13,7 @@
 #include "Common/GPU/Vulkan/VulkanContext.h"
 #include "Common/GPU/Vulkan/VulkanRenderManager.h"
 
+#include "Common/Thread/CorePlacement.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/VR/PPSSPPVR.h"
 
@@ -123,6 +125,8 @@ bool VKRGraphicsPipeline::Create(VulkanContext *vulkan, VkRenderPass compatibleR
 	double now = time_now_d();
 	double taken_ms_since_scheduling = (now - scheduleTime) * 1000.0;
 	double taken_ms = (now - start) * 1000.0;
+	// A countToCompile of -1 means the render thread is creating it right when it's needed.
+	ShaderCompileLog_Record(ShaderCompileStage::PIPELINE, tag_, now - start, countToCompile < 0);
 
 	if (taken_ms < 0.1) {
 		DEBUG_LOG(G3D, "Pipeline (x/%d) time on %s: %0.2f ms, %0.2f ms since scheduling (fast) rpType: %04x sampleBits: %d (%s)",
@@ -262,6 +266,8 @@ VulkanRenderManager::VulkanRenderManager(VulkanContext *vulkan)
 	}
 
 	queueRunner_.CreateDeviceObjects();
+	// With only one worker, the render thread would just end up waiting for it.
+	queueRunner_.EnableParallelRecording(g_threadManager.GetNumLooperThreads() > 1);
 }
 
 bool VulkanRenderManager::CreateBackbuffers() {
@@ -352,6 +358,10 @@ void VulkanRenderManager::StopThread() {
 			vkEndCommandBuffer(frameData.initCmd);
 			frameData.hasInitCommands = false;
 		}
+		if (frameData.hasTransferCommands) {
+			vkEndCommandBuffer(frameData.transferCmd);
+			frameData.hasTransferCommands = false;
+		}
 		if (frameData.hasMainCommands) {
 			vkEndCommandBuffer(frameData.mainCmd);
 			frameData.hasMainCommands = false;
@@ -396,7 +406,8 @@ struct SinglePipelineTask {
 
 class CreateMultiPipelinesTask : public Task {
 public:
-	CreateMultiPipelinesTask(VulkanContext *vulkan, std::vector<SinglePipelineTask> tasks) : vulkan_(vulkan), tasks_(tasks) {}
+	CreateMultiPipelinesTask(VulkanContext *vulkan, std::vector<SinglePipelineTask> tasks, TaskPriority priority, VKRPipelineStats *stats)
+		: vulkan_(vulkan), tasks_(tasks), priority_(priority), stats_(stats) {}
 	~CreateMultiPipelinesTask() {}
 
 	TaskType Type() const override {
@@ -404,21 +415,36 @@ class CreateMultiPipelinesTask : public Task {
 	}
 
 	TaskPriority Priority() const override {
-		return TaskPriority::HIGH;
+		return priority_;
 	}
 
 	void Run() override {
 		for (auto &task : tasks_) {
-			task.pipeline->Create(vulkan_, task.compatibleRenderPass, task.rpType, task.sampleCount, task.scheduleTime, task.countToCompile);
+			double start = time_now_d();
+			bool success = task.pipeline->Create(vulkan_, task.compatibleRenderPass, task.rpType, task.sampleCount, task.scheduleTime, task.countToCompile);
+			int micros = (int)((time_now_d() - start) * 1000000.0);
+
+			stats_->pending--;
+			if (success)
+				stats_->compiled++;
+			else
+				stats_->failed++;
+			stats_->totalCompileUs += micros;
+			int prevMax = stats_->maxCompileUs;
+			while (micros > prevMax && !stats_->maxCompileUs.compare_exchange_weak(prevMax, micros)) {
+			}
 		}
 	}
 
 	VulkanContext *vulkan_;
 	std::vector<SinglePipelineTask> tasks_;
+	TaskPriority priority_;
+	VKRPipelineStats *stats_;
 };
 
 void VulkanRenderManager::CompileThreadFunc() {
 	SetCurrentThreadName("ShaderCompile");
+	SetCurrentThreadRole(ThreadRole::BACKGROUND);
 	while (true) {
 		std::vector<CompileQueueEntry> toCompile;
 		{
@@ -438,8 +464,10 @@ void VulkanRenderManager::CompileThreadFunc() {
 
 		int countToCompile = (int)toCompile.size();
 
-		// Here we sort the pending pipelines by vertex and fragment shaders,
-		std::map<std::pair<Promise<VkShaderModule> *, Promise<VkShaderModule> *>, std::vector<SinglePipelineTask>> map;
+		// Here we sort the pending pipelines by priority, then vertex and fragment shaders.
+		typedef std::pair<Promise<VkShaderModule> *, Promise<VkShaderModule> *> ShaderPair;
+		std::map<std::pair<TaskPriority, ShaderPair>, std::vector<SinglePipelineTask>> map;
+		VKRPipelineStats &stats = queueRunner_.PipelineStats();
 
 		double scheduleTime = time_now_d();
 
@@ -450,7 +478,8 @@ void VulkanRenderManager::CompileThreadFunc() {
 		for (auto &entry : toCompile) {
 			switch (entry.type) {
 			case CompileQueueEntry::Type::GRAPHICS:
-				map[std::pair< Promise<VkShaderModule> *, Promise<VkShaderModule> *>(entry.graphics->desc->vertexShader, entry.graphics->desc->fragmentShader)].push_back(
+				stats.pending++;
+				map[std::make_pair(entry.priority, ShaderPair(entry.graphics->desc->vertexShader, entry.graphics->desc->fragmentShader))].push_back(
 					SinglePipelineTask{
 						entry.graphics,
 						entry.compatibleRenderPass,
@@ -468,13 +497,18 @@ void VulkanRenderManager::CompileThreadFunc() {
 			}
 		}
 
+		int pending = stats.pending;
+		if (pending > stats.maxPending)
+			stats.maxPending = pending;
+
+		// The map is ordered, so the high priority ones get queued first.
 		for (auto iter : map) {
-			auto &shaders = iter.first;
+			TaskPriority priority = iter.first.first;
 			auto &entries = iter.second;
 
 			// NOTICE_LOG(G3D, "For this shader pair, we have %d pipelines to create", (int)entries.size());
 
-			Task *task = new CreateMultiPipelinesTask(vulkan_, entries);
+			Task *task = new CreateMultiPipelinesTask(vulkan_, entries, priority, &stats);
 			g_threadManager.EnqueueTask(task);
 		}
 
@@ -492,6 +526,7 @@ void VulkanRenderManager::DrainCompileQueue() {
 
 void VulkanRenderManager::ThreadFunc() {
 	SetCurrentThreadName("RenderMan");
+	SetCurrentThreadRole(ThreadRole::RENDER);
 	while (true) {
 		// Pop a task of the queue and execute it.
 		VKRRenderThreadTask task;
@@ -521,12 +556,112 @@ void VulkanRenderManager::ThreadFunc() {
 	VLOG("PULL: Quitting");
 }
 
+void VulkanRenderManager::WaitForPresent() {
+	// Blocking here until the frame is on screen keeps the driver from queueing up more frames,
+	// which is most of the latency with FIFO.  Bounded, in case the surface is hidden or similar.
+	const uint64_t timeoutNs = 100 * 1000 * 1000;
+	double start = time_now_d();
+	VkResult res = vkWaitForPresentKHR(vulkan_->GetDevice(), vulkan_->GetSwapchain(), frameDataShared_.lastPresentId, timeoutNs);
+	if (res == VK_SUCCESS) {
+		presentLatencyMs_ = (float)((time_now_d() - start) * 1000.0);
+	} else {
+		presentLatencyMs_ = -1.0f;
+	}
+}
+
+bool VulkanRenderManager::IsFrameDone(FrameData &frameData) {
+	// Until it's been submitted, the render thread owns the fence.
+	std::unique_lock<std::mutex> lock(frameData.fenceMutex);
+	if (!frameData.readyForFence)
+		return false;
+	return vkGetFenceStatus(vulkan_->GetDevice(), frameData.fence) == VK_SUCCESS;
+}
+
+// The fence wait in BeginFrame only limits us to ringSize frames in flight. Here we additionally
+// wait for the frame pacingDepth_ frames back, so with a depth of 1 the CPU won't start on a frame
+// before the GPU is done with the previous one. That's the lowest latency, but costs throughput
+// whenever the GPU is the bottleneck, so the depth is adjusted from what we measure:
+// * Blocking here for a noticeable part of the frame means the GPU is behind, so allow one more frame.
+// * The previous frame consistently being done by the time we get here means the GPU keeps up,
+//   so we can go back to a shallower queue without slowing down.
+void VulkanRenderManager::PaceFrames(int curFrame, int ringSize, double beginTime) {
+	// Frames to see in a row before changing the depth. Going deeper should be quick, to not
+	// lose frames in a heavy scene, but going back is not urgent.
+	const int SLOW_FRAMES_TO_DEEPEN = 4;
+	const int MIN_FAST_FRAMES_TO_SHALLOW = 120;
+	const int MAX_FAST_FRAMES_TO_SHALLOW = 3600;
+
+	// Time the CPU spent on the last frame, not counting any fence waits.
+	double cpuFrameTime = pacingLastWaitEnd_ > 0.0 ? beginTime - pacingLastWaitEnd_ : 0.0;
+	double start = time_now_d();
+
+	if (pacingDepth_ > ringSize)
+		pacingDepth_ = ringSize;
+
+	// Check before waiting, the wait below makes it true at a depth of 1.
+	FrameData &prevFrame = frameData_[(curFrame + ringSize - 1) % ringSize];
+	bool prevDone = IsFrameDone(prevFrame);
+
+	double waitTime = 0.0;
+	if (pacingDepth_ < ringSize) {
+		FrameData &waitFrame = frameData_[(curFrame + ringSize - pacingDepth_) % ringSize];
+		{
+			std::unique_lock<std::mutex> lock(waitFrame.fenceMutex);
+			while (!waitFrame.readyForFence) {
+				waitFrame.fenceCondVar.wait(lock);
+			}
+		}
+		// Not resetting it, that happens when that frame comes around again.
+		if (vkWaitForFences(vulkan_->GetDevice(), 1, &waitFrame.fence, true, UINT64_MAX) == VK_ERROR_DEVICE_LOST) {
+			_assert_msg_(false, "Device lost in vkWaitForFences");
+		}
+		waitTime = time_now_d() - start;
+	}
+	pacingLastWaitEnd_ = time_now_d();
+
+	// A tenth of the frame, or a millisecond if we don't know the frame time yet. If the GPU
+	// timestamps are available, they tell us directly whether a frame takes the GPU longer than the CPU.
+	double slowThreshold = cpuFrameTime > 0.0 ? cpuFrameTime * 0.1 : 0.001;
+	bool gpuSlower = gpuFrameTimeMs_ > 0.0f && cpuFrameTime > 0.0 && gpuFrameTimeMs_ * 0.001 > cpuFrameTime;
+	bool slow = (pacingDepth_ < ringSize && waitTime > slowThreshold) || gpuSlower;
+
+	if (pacingFramesSinceShallow_ < MAX_FAST_FRAMES_TO_SHALLOW)
+		pacingFramesSinceShallow_++;
+
+	if (slow && pacingDepth_ < ringSize) {
+		pacingFastFrames_ = 0;
+		if (++pacingSlowFrames_ >= SLOW_FRAMES_TO_DEEPEN) {
+			pacingDepth_++;
+			pacingSlowFrames_ = 0;
+			// If the GPU only just kept up at the shallower depth, don't keep flip-flopping.
+			if (pacingFramesSinceShallow_ < pacingFastFramesNeeded_) {
+				pacingFastFramesNeeded_ = std::min(pacingFastFramesNeeded_ * 2, MAX_FAST_FRAMES_TO_SHALLOW);
+			} else {
+				pacingFastFramesNeeded_ = MIN_FAST_FRAMES_TO_SHALLOW;
+			}
+			DEBUG_LOG(G3D, "Frame pacing: GPU behind (waited %0.2f ms), depth now %d", waitTime * 1000.0, pacingDepth_);
+		}
+	} else if (!slow && prevDone && pacingDepth_ > 1) {
+		pacingSlowFrames_ = 0;
+		if (++pacingFastFrames_ >= pacingFastFramesNeeded_) {
+			pacingDepth_--;
+			pacingFastFrames_ = 0;
+			pacingFramesSinceShallow_ = 0;
+			DEBUG_LOG(G3D, "Frame pacing: GPU keeping up, depth now %d", pacingDepth_);
+		}
+	} else {
+		pacingSlowFrames_ = 0;
+		pacingFastFrames_ = 0;
+	}
+}
+
 void VulkanRenderManager::BeginFrame(bool enableProfiling, bool enableLogProfiler) {
 	VLOG("BeginFrame");
 	VkDevice device = vulkan_->GetDevice();
 
 	int curFrame = vulkan_->GetCurFrame();
 	FrameData &frameData = frameData_[curFrame];
+	double beginTime = time_now_d();
 
 	VLOG("PUSH: Fencing %d", curFrame);
 
@@ -547,6 +682,16 @@ void VulkanRenderManager::BeginFrame(bool enableProfiling, bool enableLogProfile
 	}
 	vkResetFences(device, 1, &frameData.fence);
 
+	int ringSize = vulkan_->GetInflightFrames();
+	if (adaptiveInflightFrames_ && ringSize > 1) {
+		PaceFrames(curFrame, ringSize, beginTime);
+	} else {
+		pacingDepth_ = ringSize;
+		pacingSlowFrames_ = 0;
+		pacingFastFrames_ = 0;
+		pacingLastWaitEnd_ = 0.0;
+	}
+
 	int validBits = vulkan_->GetQueueFamilyProperties(vulkan_->GetGraphicsQueueFamilyIndex()).timestampValidBits;
 
 	// Can't set this until after the fence.
@@ -554,6 +699,8 @@ void VulkanRenderManager::BeginFrame(bool enableProfiling, bool enableLogProfile
 
 	uint64_t queryResults[MAX_TIMESTAMP_QUERIES];
 
+	if (!frameData.profilingEnabled_)
+		gpuFrameTimeMs_ = -1.0f;
 	if (frameData.profilingEnabled_) {
 		// Pull the profiling results from last time and produce a summary!
 		if (!frameData.profile.timestampDescriptions.empty()) {
@@ -568,7 +715,8 @@ void VulkanRenderManager::BeginFrame(bool enableProfiling, bool enableLogProfile
 				std::stringstream str;
 
 				char line[256];
-				totalGPUTimeMs_.Update(((double)((queryResults[numQueries - 1] - queryResults[0]) & timestampDiffMask) * timestampConversionFactor));
+				gpuFrameTimeMs_ = (float)((double)((queryResults[numQueries - 1] - queryResults[0]) & timestampDiffMask) * timestampConversionFactor);
+				totalGPUTimeMs_.Update(gpuFrameTimeMs_);
 				totalGPUTimeMs_.Format(line, sizeof(line));
 				str << line;
 				renderCPUTimeMs_.Update((frameData.profile.cpuEndTime - frameData.profile.cpuStartTime) * 1000.0);
@@ -621,6 +769,11 @@ VkCommandBuffer VulkanRenderManager::GetInitCmd() {
 	return frameData_[curFrame].GetInitCmd(vulkan_);
 }
 
+VkCommandBuffer VulkanRenderManager::GetTransferCmd() {
+	int curFrame = vulkan_->GetCurFrame();
+	return frameData_[curFrame].GetTransferCmd(vulkan_);
+}
+
 VKRGraphicsPipeline *VulkanRenderManager::CreateGraphicsPipeline(VKRGraphicsPipelineDesc *desc, PipelineFlags pipelineFlags, uint32_t variantBitmask, VkSampleCountFlagBits sampleCount, bool cacheLoad, const char *tag) {
 	VKRGraphicsPipeline *pipeline = new VKRGraphicsPipeline(pipelineFlags, tag);
 
@@ -668,7 +821,8 @@ VKRGraphicsPipeline *VulkanRenderManager::CreateGraphicsPipeline(VKRGraphicsPipe
 			}
 
 			pipeline->pipeline[i] = Promise<VkPipeline>::CreateEmpty();
-			compileQueue_.push_back(CompileQueueEntry(pipeline, compatibleRenderPass->Get(vulkan_, rpType, sampleCount), rpType, sampleCount));
+			TaskPriority priority = cacheLoad ? TaskPriority::LOW : TaskPriority::HIGH;
+			compileQueue_.push_back(CompileQueueEntry(pipeline, compatibleRenderPass->Get(vulkan_, rpType, sampleCount), rpType, sampleCount, priority));
 			needsCompile = true;
 		}
 		if (needsCompile)
@@ -977,7 +1131,7 @@ bool VulkanRenderManager::CopyFramebufferToMemory(VKRFramebuffer *src, VkImageAs
 
 	// Need to call this after FlushSync so the pixels are guaranteed to be ready in CPU-accessible VRAM.
 	return queueRunner_.CopyReadbackBuffer(frameData_[vulkan_->GetCurFrame()],
-		mode == Draw::ReadbackMode::OLD_DATA_OK ? src : nullptr, w, h, srcFormat, destFormat, pixelStride, pixels);
+		mode == Draw::ReadbackMode::OLD_DATA_OK ? src : nullptr, aspectBits, w, h, srcFormat, destFormat, pixelStride, pixels);
 }
 
 void VulkanRenderManager::CopyImageToMemorySync(VkImage image, int mipLevel, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride, const char *tag) {
@@ -996,7 +1150,7 @@ void VulkanRenderManager::CopyImageToMemorySync(VkImage image, int mipLevel, int
 	FlushSync();
 
 	// Need to call this after FlushSync so the pixels are guaranteed to be ready in CPU-accessible VRAM.
-	queueRunner_.CopyReadbackBuffer(frameData_[vulkan_->GetCurFrame()], nullptr, w, h, destFormat, destFormat, pixelStride, pixels);
+	queueRunner_.CopyReadbackBuffer(frameData_[vulkan_->GetCurFrame()], nullptr, VK_IMAGE_ASPECT_COLOR_BIT, w, h, destFormat, destFormat, pixelStride, pixels);
 }
 
 static void RemoveDrawCommands(std::vector<VkRenderData> *cmds) {
@@ -1301,6 +1455,7 @@ void VulkanRenderManager::Run(VKRRenderThreadTask &task) {
 		// Effectively resets both main and present command buffers, since they both live in this pool.
 		// We always record main commands first, so we don't need to reset the present command buffer separately.
 		vkResetCommandPool(vulkan_->GetDevice(), frameData.cmdPoolMain, 0);
+		frameData.ResetSecondaryCmds(vulkan_);
 
 		VkCommandBufferBeginInfo begin{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
 		begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
@@ -1328,6 +1483,7 @@ void VulkanRenderManager::Run(VKRRenderThreadTask &task) {
 	switch (task.runType) {
 	case VKRRunType::PRESENT:
 		frameData.SubmitPending(vulkan_, FrameSubmitType::Present, frameDataShared_);
+		queueRunner_.PublishStepOptimizerStats();
 
 		if (!frameData.skipSwap) {
 			VkResult res = frameData.QueuePresent(vulkan_, frameDataShared_);
@@ -1342,6 +1498,9 @@ void VulkanRenderManager::Run(VKRRenderThreadTask &task) {
 			} else {
 				// Success
 				outOfDateFrames_ = 0;
+				if ((vulkan_->GetFlags() & VULKAN_FLAG_LOW_LATENCY) && vulkan_->Extensions().KHR_present_wait) {
+					WaitForPresent();
+				}
 			}
 		} else {
 			// We only get here if vkAcquireNextImage returned VK_ERROR_OUT_OF_DATE.
@@ -133,6 +133,9 @@ struct VKRGraphicsPipeline {
 
 	VKRGraphicsPipelineDesc *desc = nullptr;
 	Promise<VkPipeline> *pipeline[(size_t)RenderPassType::TYPE_COUNT]{};
+	// A more generic, compatible pipeline that's drawn with instead while this one is still compiling.
+	// Not owned, the owner has to delete both together.
+	VKRGraphicsPipeline *fallback = nullptr;
 
 	VkSampleCountFlagBits SampleCount() const { return sampleCount_; }
 
@@ -161,8 +164,8 @@ struct VKRComputePipeline {
 };
 
 struct CompileQueueEntry {
-	CompileQueueEntry(VKRGraphicsPipeline *p, VkRenderPass _compatibleRenderPass, RenderPassType _renderPassType, VkSampleCountFlagBits _sampleCount)
-		: type(Type::GRAPHICS), graphics(p), compatibleRenderPass(_compatibleRenderPass), renderPassType(_renderPassType), sampleCount(_sampleCount) {}
+	CompileQueueEntry(VKRGraphicsPipeline *p, VkRenderPass _compatibleRenderPass, RenderPassType _renderPassType, VkSampleCountFlagBits _sampleCount, TaskPriority _priority = TaskPriority::HIGH)
+		: type(Type::GRAPHICS), graphics(p), compatibleRenderPass(_compatibleRenderPass), renderPassType(_renderPassType), sampleCount(_sampleCount), priority(_priority) {}
 	CompileQueueEntry(VKRComputePipeline *p) : type(Type::COMPUTE), compute(p), renderPassType(RenderPassType::DEFAULT), sampleCount(VK_SAMPLE_COUNT_1_BIT), compatibleRenderPass(VK_NULL_HANDLE) {}  // renderpasstype here shouldn't matter
 	enum class Type {
 		GRAPHICS,
@@ -174,6 +177,8 @@ struct CompileQueueEntry {
 	VKRGraphicsPipeline *graphics = nullptr;
 	VKRComputePipeline *compute = nullptr;
 	VkSampleCountFlagBits sampleCount;
+	// Pipelines needed by the current frame go first, cache preloads after.
+	TaskPriority priority = TaskPriority::HIGH;
 };
 
 class VulkanRenderManager {
@@ -231,6 +236,14 @@ class VulkanRenderManager {
 	VKRGraphicsPipeline *CreateGraphicsPipeline(VKRGraphicsPipelineDesc *desc, PipelineFlags pipelineFlags, uint32_t variantBitmask, VkSampleCountFlagBits sampleCount, bool cacheLoad, const char *tag);
 	VKRComputePipeline *CreateComputePipeline(VKRComputePipelineDesc *desc);
 
+	VKRPipelineStats &PipelineStats() {
+		return queueRunner_.PipelineStats();
+	}
+
+	const VKRStepOptimizerStats &StepOptimizerStats() const {
+		return queueRunner_.StepOptimizerStats();
+	}
+
 	void NudgeCompilerThread() {
 		compileMutex_.lock();
 		compileCond_.notify_one();
@@ -241,6 +254,9 @@ class VulkanRenderManager {
 		_dbg_assert_(curRenderStep_ && curRenderStep_->stepType == VKRStepType::RENDER);
 		_dbg_assert_(pipeline != nullptr);
 		VkRenderData data{ VKRRenderCommand::BIND_GRAPHICS_PIPELINE };
+		// The fallback needs a variant for this render pass type too, to be of any use.
+		if (pipeline->fallback)
+			pipelinesToCheck_.push_back(pipeline->fallback);
 		pipelinesToCheck_.push_back(pipeline);
 		data.graphics_pipeline.pipeline = pipeline;
 		data.graphics_pipeline.pipelineLayout = pipelineLayout;
@@ -423,6 +439,8 @@ class VulkanRenderManager {
 	}
 
 	VkCommandBuffer GetInitCmd();
+	// Only for copies into images and buffers shared with the transfer queue. Null if there's no such queue.
+	VkCommandBuffer GetTransferCmd();
 
 	bool CreateBackbuffers();
 	void DestroyBackbuffers();
@@ -434,6 +452,15 @@ class VulkanRenderManager {
 	void SetInflightFrames(int f) {
 		newInflightFrames_ = f < 1 || f > VulkanContext::MAX_INFLIGHT_FRAMES ? VulkanContext::MAX_INFLIGHT_FRAMES : f;
 	}
+	// When enabled, the inflight frames setting becomes a maximum, and BeginFrame waits for
+	// earlier frames as long as the GPU keeps up, to keep latency down.
+	void SetAdaptiveInflightFrames(bool enable) {
+		adaptiveInflightFrames_ = enable;
+	}
+	// Number of frames currently allowed in flight, including the one being recorded.
+	int GetPacingDepth() const {
+		return pacingDepth_;
+	}
 
 	VulkanContext *GetVulkanContext() {
 		return vulkan_;
@@ -448,6 +475,15 @@ class VulkanRenderManager {
 		return frameData_[vulkan_->GetCurFrame()].profile.profileSummary;
 	}
 
+	// Only measured in low latency mode, with VK_KHR_present_wait.  Negative if unknown.
+	float GetPresentLatencyMs() const {
+		return presentLatencyMs_;
+	}
+	// Only measured while profiling is enabled.
+	float GetGPUFrameTimeMs() const {
+		return gpuFrameTimeMs_;
+	}
+
 	bool NeedsSwapchainRecreate() const {
 		// Accepting a few of these makes shutdown simpler.
 		return outOfDateFrames_ > VulkanContext::MAX_INFLIGHT_FRAMES;
@@ -465,6 +501,9 @@ class VulkanRenderManager {
 	void DrainCompileQueue();
 
 	void Run(VKRRenderThreadTask &task);
+	void WaitForPresent();
+	void PaceFrames(int curFrame, int ringSize, double beginTime);
+	bool IsFrameDone(FrameData &frameData);
 
 	// Bad for performance but sometimes necessary for synchronous CPU readbacks (screenshots and whatnot).
 	void FlushSync();
@@ -476,7 +515,20 @@ class VulkanRenderManager {
 	int newInflightFrames_ = -1;
 	int inflightFramesAtStart_ = 0;
 
+	// Adaptive frame pacing, see PaceFrames().
+	bool adaptiveInflightFrames_ = false;
+	int pacingDepth_ = VulkanContext::MAX_INFLIGHT_FRAMES;
+	int pacingSlowFrames_ = 0;
+	int pacingFastFrames_ = 0;
+	// Fast frames needed to step down. Grows when stepping down had to be undone right away.
+	int pacingFastFramesNeeded_ = 120;
+	int pacingFramesSinceShallow_ = 0;
+	// When the previous BeginFrame was done waiting, for measuring CPU time per frame.
+	double pacingLastWaitEnd_ = 0.0;
+
 	int outOfDateFrames_ = 0;
+	// Time from queueing the last present until it was shown, or -1 if unknown.
+	std::atomic<float> presentLatencyMs_{ -1.0f };
 
 	// Submission time state
 
@@ -529,6 +581,7 @@ class VulkanRenderManager {
 	// For nicer output in the little internal GPU profiler.
 	SimpleStat initTimeMs_;
 	SimpleStat totalGPUTimeMs_;
+	float gpuFrameTimeMs_ = -1.0f;
 	SimpleStat renderCPUTimeMs_;
 
 	std::function<void(InvalidationCallbackFlags)> invalidationCallback_;
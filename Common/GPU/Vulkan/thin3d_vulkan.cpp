@@ -386,6 +386,13 @@ class VKContext : public DrawContext {
 	const DeviceCaps &GetDeviceCaps() const override {
 		return caps_;
 	}
+	float GetPresentLatencyMs() const override {
+		return renderManager_.GetPresentLatencyMs();
+	}
+	float GetGPUFrameTimeMs() const override {
+		return renderManager_.GetGPUFrameTimeMs();
+	}
+
 	std::vector<std::string> GetDeviceList() const override {
 		std::vector<std::string> list;
 		for (int i = 0; i < vulkan_->GetNumPhysicalDevices(); i++) {
@@ -632,6 +639,11 @@ static VkFormat DataFormatToVulkan(DataFormat format) {
 	case DataFormat::BC6H_UFLOAT_BLOCK: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
 	case DataFormat::BC7_UNORM_BLOCK: return VK_FORMAT_BC7_UNORM_BLOCK;
 	case DataFormat::BC7_SRGB_BLOCK:  return VK_FORMAT_BC7_SRGB_BLOCK;
+	// ETC2 decoders also handle ETC1 data.
+	case DataFormat::ETC1: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+	case DataFormat::ETC2_R8G8B8_UNORM_BLOCK: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+	case DataFormat::ETC2_R8G8B8A8_UNORM_BLOCK: return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+	case DataFormat::ASTC_4x4_UNORM_BLOCK: return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
 	default:
 		return VK_FORMAT_UNDEFINED;
 	}
@@ -831,6 +843,7 @@ VKContext::VKContext(VulkanContext *vulkan)
 	caps_.logicOpSupported = vulkan->GetDeviceFeatures().enabled.standard.logicOp != 0;
 	caps_.multiViewSupported = vulkan->GetDeviceFeatures().enabled.multiview.multiview != 0;
 	caps_.sampleRateShadingSupported = vulkan->GetDeviceFeatures().enabled.standard.sampleRateShading != 0;
+	caps_.delayedReadbackSupported = true;
 
 	const auto &limits = vulkan->GetPhysicalDeviceProperties().properties.limits;
 
@@ -1739,6 +1752,8 @@ uint64_t VKContext::GetNativeObject(NativeObject obj, void *srcObject) {
 		return (uint64_t)vulkan_;
 	case NativeObject::INIT_COMMANDBUFFER:
 		return (uint64_t)renderManager_.GetInitCmd();
+	case NativeObject::TRANSFER_COMMANDBUFFER:
+		return (uint64_t)renderManager_.GetTransferCmd();
 	case NativeObject::BOUND_TEXTURE0_IMAGEVIEW:
 		return (uint64_t)boundImageView_[0];
 	case NativeObject::BOUND_TEXTURE1_IMAGEVIEW:
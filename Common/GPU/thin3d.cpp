@@ -93,6 +93,39 @@ bool DataFormatIsDepthStencil(DataFormat fmt) {
 	}
 }
 
+bool DataFormatIsBlockCompressed(DataFormat fmt, int *blockSize) {
+	int size = 0;
+	switch (fmt) {
+	case DataFormat::BC1_RGBA_UNORM_BLOCK:
+	case DataFormat::BC1_RGBA_SRGB_BLOCK:
+	case DataFormat::BC4_UNORM_BLOCK:
+	case DataFormat::BC4_SNORM_BLOCK:
+	case DataFormat::ETC1:
+	case DataFormat::ETC2_R8G8B8_UNORM_BLOCK:
+		size = 8;
+		break;
+	case DataFormat::BC2_UNORM_BLOCK:
+	case DataFormat::BC2_SRGB_BLOCK:
+	case DataFormat::BC3_UNORM_BLOCK:
+	case DataFormat::BC3_SRGB_BLOCK:
+	case DataFormat::BC5_UNORM_BLOCK:
+	case DataFormat::BC5_SNORM_BLOCK:
+	case DataFormat::BC6H_UFLOAT_BLOCK:
+	case DataFormat::BC6H_SFLOAT_BLOCK:
+	case DataFormat::BC7_UNORM_BLOCK:
+	case DataFormat::BC7_SRGB_BLOCK:
+	case DataFormat::ETC2_R8G8B8A8_UNORM_BLOCK:
+	case DataFormat::ASTC_4x4_UNORM_BLOCK:
+		size = 16;
+		break;
+	default:
+		return false;
+	}
+	if (blockSize)
+		*blockSize = size;
+	return true;
+}
+
 RefCountedObject::~RefCountedObject() {
 	_dbg_assert_(refcount_ == 0xDEDEDE);
 }
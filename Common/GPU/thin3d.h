@@ -243,6 +243,7 @@ enum class NativeObject {
 	BACKBUFFER_DEPTH_TEX,
 	FEATURE_LEVEL,
 	INIT_COMMANDBUFFER,
+	TRANSFER_COMMANDBUFFER,  // Vulkan only, and can be null.
 	BOUND_TEXTURE0_IMAGEVIEW,  // Layer etc depends on how you bound it...
 	BOUND_TEXTURE1_IMAGEVIEW,  // Layer etc depends on how you bound it...
 	BOUND_FRAMEBUFFER_COLOR_IMAGEVIEW_ALL_LAYERS,
@@ -581,6 +582,7 @@ struct DeviceCaps {
 	bool multiViewSupported;
 	bool isTilingGPU;  // This means that it benefits from correct store-ops, msaa without backing memory, etc.
 	bool sampleRateShadingSupported;
+	bool delayedReadbackSupported;  // ReadbackMode::OLD_DATA_OK doesn't wait for the GPU.
 
 	bool verySlowShaderCompiler;
 
@@ -677,6 +679,11 @@ class DrawContext {
 	virtual void DebugAnnotate(const char *annotation) {}
 	virtual void SetDebugFlags(DebugFlags flags) {}
 
+	// Time between queueing the last present and it reaching the screen, negative if not known.
+	virtual float GetPresentLatencyMs() const { return -1.0f; }
+	// GPU time of the most recent frame with results, negative if not known. Needs DebugFlags::PROFILE_TIMESTAMPS.
+	virtual float GetGPUFrameTimeMs() const { return -1.0f; }
+
 	// Partial pipeline state, used to create pipelines. (in practice, in d3d11 they'll use the native state objects directly).
 	// TODO: Possibly ditch these and just put the descs directly in PipelineDesc since only D3D11 benefits.
 	virtual DepthStencilState *CreateDepthStencilState(const DepthStencilStateDesc &desc) = 0;
@@ -22,6 +22,7 @@
 
 #include "Common/CommonTypes.h"
 #include "Common/Log.h"
+#include "Common/LogManager.h"
 #include "StringUtils.h"
 #include "Common/Data/Encoding/Utf8.h"
 
@@ -61,6 +62,9 @@ bool HandleAssert(const char *function, const char *file, int line, const char *
 
 	// Normal logging (will also log to Android log)
 	ERROR_LOG(SYSTEM, "%s", formatted);
+	// Make sure it (and whatever led up to it) is written before we possibly crash.
+	if (LogManager::GetInstance())
+		LogManager::GetInstance()->FlushAsync();
 	// Also do a simple printf for good measure, in case logging of SYSTEM is disabled (should we disallow that?)
 	fprintf(stderr, "%s\n", formatted);
 
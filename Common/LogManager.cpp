@@ -24,6 +24,7 @@
 #endif
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 
 #include "Common/Data/Encoding/Utf8.h"
@@ -33,6 +34,7 @@
 #include "Common/TimeUtil.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadUtil.h"
 
 // Don't need to savestate this.
 const char *hleCurrentThreadName = nullptr;
@@ -77,6 +79,42 @@ bool GenericLogEnabled(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type) {
 
 LogManager *LogManager::logManager_ = NULL;
 
+// Longer messages get truncated in async mode.
+static const size_t ASYNC_LOG_MSG_SIZE = 384;
+static const uint32_t ASYNC_LOG_RING_SIZE = 512;
+
+struct AsyncLogEntry {
+	uint64_t sequence;
+	LogTypes::LOG_LEVELS level;
+	const char *log;
+	char timestamp[16];
+	char header[64];
+	char msg[ASYNC_LOG_MSG_SIZE];
+};
+
+// Single producer (the owning thread), single consumer (whoever holds asyncDrainLock_.)
+struct AsyncLogRing {
+	AsyncLogEntry entries[ASYNC_LOG_RING_SIZE];
+	std::atomic<uint32_t> head{ 0 };
+	std::atomic<uint32_t> tail{ 0 };
+	std::atomic<uint32_t> dropped{ 0 };
+	// Set when the thread exits, so the ring can be freed once drained.
+	std::atomic<bool> orphaned{ false };
+};
+
+struct AsyncLogRingHolder {
+	~AsyncLogRingHolder() {
+		if (ring)
+			ring->orphaned = true;
+	}
+
+	std::shared_ptr<AsyncLogRing> ring;
+	uint32_t instanceId = 0;
+};
+
+static thread_local AsyncLogRingHolder asyncRingHolder;
+static std::atomic<uint32_t> nextInstanceId{ 1 };
+
 struct LogNameTableEntry {
 	LogTypes::LOG_TYPE logType;
 	const char *name;
@@ -118,6 +156,7 @@ static const LogNameTableEntry logTable[] = {
 
 LogManager::LogManager(bool *enabledSetting) {
 	g_bLogEnabledSetting = enabledSetting;
+	instanceId_ = nextInstanceId++;
 
 	for (size_t i = 0; i < ARRAY_SIZE(logTable); i++) {
 		_assert_msg_(i == logTable[i].logType, "Bad logtable at %i", (int)i);
@@ -158,6 +197,8 @@ LogManager::LogManager(bool *enabledSetting) {
 }
 
 LogManager::~LogManager() {
+	SetAsync(false);
+
 	for (int i = 0; i < LogTypes::NUMBER_OF_LOGS; ++i) {
 #if !defined(MOBILE_DEVICE) || defined(_DEBUG)
 		RemoveListener(fileLog_);
@@ -189,6 +230,7 @@ void LogManager::ChangeFileLog(const char *filename) {
 
 	if (filename) {
 		fileLog_ = new FileLogListener(filename);
+		fileLog_->SetBatched(async_);
 		AddListener(fileLog_);
 	}
 }
@@ -211,15 +253,7 @@ void LogManager::LoadConfig(const Section *section, bool debugDefaults) {
 	}
 }
 
-void LogManager::Log(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type, const char *file, int line, const char *format, va_list args) {
-	const LogChannel &log = log_[type];
-	if (level > log.level || !log.enabled)
-		return;
-
-	LogMessage message;
-	message.level = level;
-	message.log = log.m_shortName;
-
+void LogManager::FormatHeader(char *timestamp, char *header, size_t headerSize, LogTypes::LOG_LEVELS level, const LogChannel &log, const char *file, int line) {
 #ifdef _WIN32
 	static const char sep = '\\';
 #else
@@ -234,18 +268,34 @@ void LogManager::Log(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type, const
 			file = fileshort + 1;
 	}
 
-	GetTimeFormatted(message.timestamp);
+	GetTimeFormatted(timestamp);
 
 	if (hleCurrentThreadName) {
-		snprintf(message.header, sizeof(message.header), "%-12.12s %c[%s]: %s:%d",
+		snprintf(header, headerSize, "%-12.12s %c[%s]: %s:%d",
 			hleCurrentThreadName, level_to_char[(int)level],
 			log.m_shortName,
 			file, line);
 	} else {
-		snprintf(message.header, sizeof(message.header), "%s:%d %c[%s]:",
+		snprintf(header, headerSize, "%s:%d %c[%s]:",
 			file, line, level_to_char[(int)level],
 			log.m_shortName);
 	}
+}
+
+void LogManager::Log(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type, const char *file, int line, const char *format, va_list args) {
+	const LogChannel &log = log_[type];
+	if (level > log.level || !log.enabled)
+		return;
+
+	if (async_) {
+		LogAsync(level, log, file, line, format, args);
+		return;
+	}
+
+	LogMessage message;
+	message.level = level;
+	message.log = log.m_shortName;
+	FormatHeader(message.timestamp, message.header, sizeof(message.header), level, log, file, line);
 
 	char msgBuf[1024];
 	va_list args_copy;
@@ -268,6 +318,156 @@ void LogManager::Log(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type, const
 	}
 }
 
+AsyncLogRing *LogManager::GetAsyncRing() {
+	AsyncLogRingHolder &holder = asyncRingHolder;
+	if (holder.ring && holder.instanceId == instanceId_)
+		return holder.ring.get();
+
+	// First message from this thread (or since the LogManager was recreated.)
+	if (holder.ring)
+		holder.ring->orphaned = true;
+	holder.ring = std::make_shared<AsyncLogRing>();
+	holder.instanceId = instanceId_;
+
+	std::lock_guard<std::mutex> guard(asyncRingsLock_);
+	asyncRings_.push_back(holder.ring);
+	return holder.ring.get();
+}
+
+void LogManager::LogAsync(LogTypes::LOG_LEVELS level, const LogChannel &log, const char *file, int line, const char *format, va_list args) {
+	AsyncLogRing *ring = GetAsyncRing();
+	uint32_t head = ring->head.load(std::memory_order_relaxed);
+	uint32_t tail = ring->tail.load(std::memory_order_acquire);
+	if (head - tail >= ASYNC_LOG_RING_SIZE) {
+		// Never block the caller, that's the point.
+		ring->dropped++;
+		return;
+	}
+
+	AsyncLogEntry &entry = ring->entries[head % ASYNC_LOG_RING_SIZE];
+	entry.sequence = asyncSequence_++;
+	entry.level = level;
+	entry.log = log.m_shortName;
+	FormatHeader(entry.timestamp, entry.header, sizeof(entry.header), level, log, file, line);
+
+	int len = vsnprintf(entry.msg, sizeof(entry.msg) - 1, format, args);
+	len = std::max(0, std::min(len, (int)sizeof(entry.msg) - 2));
+	entry.msg[len] = '\n';
+	entry.msg[len + 1] = '\0';
+
+	ring->head.store(head + 1, std::memory_order_release);
+
+	// Getting full, don't wait for the timer.
+	if (head - tail >= ASYNC_LOG_RING_SIZE / 2)
+		asyncCond_.notify_one();
+}
+
+void LogManager::DrainAsync() {
+	std::lock_guard<std::mutex> drainGuard(asyncDrainLock_);
+
+	std::vector<std::shared_ptr<AsyncLogRing>> rings;
+	{
+		std::lock_guard<std::mutex> guard(asyncRingsLock_);
+		rings = asyncRings_;
+	}
+
+	std::vector<std::pair<uint64_t, LogMessage>> batch;
+	uint32_t dropped = 0;
+	for (auto &ring : rings) {
+		uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+		uint32_t head = ring->head.load(std::memory_order_acquire);
+		for (; tail != head; ++tail) {
+			const AsyncLogEntry &entry = ring->entries[tail % ASYNC_LOG_RING_SIZE];
+			batch.emplace_back();
+			batch.back().first = entry.sequence;
+			LogMessage &message = batch.back().second;
+			memcpy(message.timestamp, entry.timestamp, sizeof(message.timestamp));
+			memcpy(message.header, entry.header, sizeof(message.header));
+			message.level = entry.level;
+			message.log = entry.log;
+			message.msg = entry.msg;
+		}
+		ring->tail.store(tail, std::memory_order_release);
+		dropped += ring->dropped.exchange(0);
+	}
+
+	{
+		// Forget the rings of threads that have exited, now that they're empty.
+		std::lock_guard<std::mutex> guard(asyncRingsLock_);
+		asyncRings_.erase(std::remove_if(asyncRings_.begin(), asyncRings_.end(), [](const std::shared_ptr<AsyncLogRing> &ring) {
+			return ring->orphaned && ring->head == ring->tail;
+		}), asyncRings_.end());
+	}
+
+	if (dropped != 0) {
+		asyncDropped_ += dropped;
+		batch.emplace_back();
+		batch.back().first = asyncSequence_++;
+		LogMessage &message = batch.back().second;
+		message.level = LogTypes::LWARNING;
+		message.log = log_[LogTypes::SYSTEM].m_shortName;
+		GetTimeFormatted(message.timestamp);
+		snprintf(message.header, sizeof(message.header), "%c[%s]:", level_to_char[(int)message.level], message.log);
+		message.msg = StringFromFormat("%u log messages dropped, queue full\n", dropped);
+	}
+
+	if (batch.empty())
+		return;
+
+	// Each ring is in order, but interleave them back the way they were logged.
+	std::sort(batch.begin(), batch.end(), [](const std::pair<uint64_t, LogMessage> &a, const std::pair<uint64_t, LogMessage> &b) {
+		return a.first < b.first;
+	});
+
+	std::lock_guard<std::mutex> listeners_lock(listeners_lock_);
+	for (const auto &entry : batch) {
+		for (auto &iter : listeners_) {
+			iter->Log(entry.second);
+		}
+	}
+	for (auto &iter : listeners_) {
+		iter->Flush();
+	}
+}
+
+void LogManager::AsyncThreadFunc() {
+	SetCurrentThreadName("AsyncLog");
+
+	while (async_) {
+		{
+			std::unique_lock<std::mutex> lock(asyncCondLock_);
+			asyncCond_.wait_for(lock, std::chrono::milliseconds(10));
+		}
+		DrainAsync();
+	}
+}
+
+void LogManager::SetAsync(bool async) {
+	if (async == async_)
+		return;
+
+	if (async) {
+		if (fileLog_)
+			fileLog_->SetBatched(true);
+		async_ = true;
+		asyncThread_ = std::thread(&LogManager::AsyncThreadFunc, this);
+	} else {
+		async_ = false;
+		asyncCond_.notify_one();
+		if (asyncThread_.joinable())
+			asyncThread_.join();
+		// Whatever made it in before we switched.
+		DrainAsync();
+		if (fileLog_)
+			fileLog_->SetBatched(false);
+	}
+}
+
+void LogManager::FlushAsync() {
+	if (async_)
+		DrainAsync();
+}
+
 bool LogManager::IsEnabled(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type) {
 	LogChannel &log = log_[type];
 	if (level > log.level || !log.enabled)
@@ -317,6 +517,15 @@ void FileLogListener::Log(const LogMessage &message) {
 
 	std::lock_guard<std::mutex> lk(m_log_lock);
 	fprintf(fp_, "%s %s %s", message.timestamp, message.header, message.msg.c_str());
+	if (!batched_)
+		fflush(fp_);
+}
+
+void FileLogListener::Flush() {
+	if (!IsValid())
+		return;
+
+	std::lock_guard<std::mutex> lk(m_log_lock);
 	fflush(fp_);
 }
 
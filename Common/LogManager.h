@@ -19,7 +19,11 @@
 
 #include "ppsspp_config.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 #include <cstdarg>
 #include <cstdio>
@@ -48,6 +52,8 @@ class LogListener {
 	virtual ~LogListener() {}
 
 	virtual void Log(const LogMessage &msg) = 0;
+	// Called after each batch of messages in async mode.
+	virtual void Flush() {}
 };
 
 class FileLogListener : public LogListener {
@@ -56,10 +62,13 @@ class FileLogListener : public LogListener {
 	~FileLogListener();
 
 	void Log(const LogMessage &msg) override;
+	void Flush() override;
 
 	bool IsValid() { if (!fp_) return false; else return true; }
 	bool IsEnabled() const { return m_enable; }
 	void SetEnabled(bool enable) { m_enable = enable; }
+	// When batched, flushes only in Flush() rather than after every message.
+	void SetBatched(bool batched) { batched_ = batched; }
 
 	const char *GetName() const { return "file"; }
 
@@ -67,6 +76,7 @@ class FileLogListener : public LogListener {
 	std::mutex m_log_lock;
 	FILE *fp_ = nullptr;
 	bool m_enable;
+	bool batched_ = false;
 };
 
 class OutputDebugStringLogListener : public LogListener {
@@ -104,6 +114,7 @@ struct LogChannel {
 };
 
 class ConsoleListener;
+struct AsyncLogRing;
 
 class LogManager {
 private:
@@ -124,6 +135,25 @@ class LogManager {
 	std::mutex listeners_lock_;
 	std::vector<LogListener*> listeners_;
 
+	void FormatHeader(char *timestamp, char *header, size_t headerSize, LogTypes::LOG_LEVELS level, const LogChannel &log, const char *file, int line);
+	void LogAsync(LogTypes::LOG_LEVELS level, const LogChannel &log, const char *file, int line, const char *format, va_list args);
+	AsyncLogRing *GetAsyncRing();
+	void AsyncThreadFunc();
+	void DrainAsync();
+
+	std::atomic<bool> async_{ false };
+	std::thread asyncThread_;
+	std::mutex asyncCondLock_;
+	std::condition_variable asyncCond_;
+	// Held while handing queued messages to listeners.
+	std::mutex asyncDrainLock_;
+	std::mutex asyncRingsLock_;
+	std::vector<std::shared_ptr<AsyncLogRing>> asyncRings_;
+	std::atomic<uint64_t> asyncSequence_{ 0 };
+	std::atomic<uint64_t> asyncDropped_{ 0 };
+	// Lets threads notice a ring belongs to an older LogManager.
+	uint32_t instanceId_;
+
 public:
 	void AddListener(LogListener *listener);
 	void RemoveListener(LogListener *listener);
@@ -135,6 +165,15 @@ class LogManager {
 			 const char *file, int line, const char *fmt, va_list args);
 	bool IsEnabled(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type);
 
+	// In async mode, messages are formatted into a queue per thread, and handed to listeners in
+	// batches from a background thread.  If a queue fills up, messages are dropped (and counted)
+	// rather than blocking the caller.
+	void SetAsync(bool async);
+	bool IsAsync() const { return async_; }
+	// Waits until everything queued so far has been handed to listeners.
+	void FlushAsync();
+	uint64_t GetAsyncDroppedCount() const { return asyncDropped_; }
+
 	LogChannel *GetLogChannel(LogTypes::LOG_TYPE type) {
 		return &log_[type];
 	}
@@ -47,8 +47,16 @@ class MemArena {
 
 private:
 #ifdef _WIN32
-	HANDLE hMemoryMapping;
-	SYSTEM_INFO sysInfo;
+	void ReleasePlaceholder();
+	bool InPlaceholder(const void *ptr, size_t size) const;
+
+	HANDLE hMemoryMapping = 0;
+	SYSTEM_INFO sysInfo{};
+	// With VirtualAlloc2 (Windows 10+), the whole range stays reserved while views replace pieces
+	// of it, so nothing else can take the space between finding a base and mapping the views.
+	bool usePlaceholders = false;
+	u8 *placeholderBase = nullptr;
+	size_t placeholderSize = 0;
 #elif defined(__APPLE__)
 	size_t vm_size;
 	vm_address_t vm_mem;  // same type as vm_address_t
@@ -19,9 +19,48 @@
 
 #ifdef _WIN32
 
+#include "Common/Log.h"
+#include "Common/SysError.h"
 #include "MemArena.h"
 #include "CommonWindows.h"
 
+#if !PPSSPP_PLATFORM(UWP)
+
+// These are Windows 10 1803+ only, so they're looked up at runtime.  Declared here so we
+// don't depend on the SDK version either.
+#ifndef MEM_RESERVE_PLACEHOLDER
+#define MEM_RESERVE_PLACEHOLDER 0x00040000
+#define MEM_REPLACE_PLACEHOLDER 0x00004000
+#endif
+#ifndef MEM_COALESCE_PLACEHOLDERS
+#define MEM_COALESCE_PLACEHOLDERS 0x00000001
+#define MEM_PRESERVE_PLACEHOLDER 0x00000002
+#endif
+
+typedef PVOID (WINAPI *VirtualAlloc2Func)(HANDLE process, PVOID baseAddress, SIZE_T size, ULONG allocationType, ULONG pageProtection, void *extendedParameters, ULONG parameterCount);
+typedef PVOID (WINAPI *MapViewOfFile3Func)(HANDLE fileMapping, HANDLE process, PVOID baseAddress, ULONG64 offset, SIZE_T viewSize, ULONG allocationType, ULONG pageProtection, void *extendedParameters, ULONG parameterCount);
+typedef BOOL (WINAPI *UnmapViewOfFile2Func)(HANDLE process, PVOID baseAddress, ULONG unmapFlags);
+
+static VirtualAlloc2Func ptr_VirtualAlloc2;
+static MapViewOfFile3Func ptr_MapViewOfFile3;
+static UnmapViewOfFile2Func ptr_UnmapViewOfFile2;
+
+static bool LoadPlaceholderFuncs() {
+	static bool loaded = false;
+	if (!loaded) {
+		HMODULE kernelBase = GetModuleHandleW(L"kernelbase.dll");
+		if (kernelBase) {
+			ptr_VirtualAlloc2 = (VirtualAlloc2Func)GetProcAddress(kernelBase, "VirtualAlloc2");
+			ptr_MapViewOfFile3 = (MapViewOfFile3Func)GetProcAddress(kernelBase, "MapViewOfFile3");
+			ptr_UnmapViewOfFile2 = (UnmapViewOfFile2Func)GetProcAddress(kernelBase, "UnmapViewOfFile2");
+		}
+		loaded = true;
+	}
+	return ptr_VirtualAlloc2 && ptr_MapViewOfFile3 && ptr_UnmapViewOfFile2;
+}
+
+#endif
+
 // Windows mappings need to be on 64K boundaries, due to Alpha legacy.
 size_t MemArena::roundup(size_t x) {
 	int gran = sysInfo.dwAllocationGranularity ? sysInfo.dwAllocationGranularity : 0x10000;
@@ -32,6 +71,11 @@ bool MemArena::GrabMemSpace(size_t size) {
 #if !PPSSPP_PLATFORM(UWP)
 	hMemoryMapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)(size), NULL);
 	GetSystemInfo(&sysInfo);
+	if (!hMemoryMapping) {
+		ERROR_LOG(MEMMAP, "Failed to create a %d byte file mapping: %s", (int)size, GetLastErrorMsg().c_str());
+		return false;
+	}
+	usePlaceholders = LoadPlaceholderFuncs();
 #else
 	hMemoryMapping = 0;
 #endif
@@ -41,6 +85,25 @@ bool MemArena::GrabMemSpace(size_t size) {
 void MemArena::ReleaseSpace() {
 	CloseHandle(hMemoryMapping);
 	hMemoryMapping = 0;
+	ReleasePlaceholder();
+}
+
+void MemArena::ReleasePlaceholder() {
+#if !PPSSPP_PLATFORM(UWP)
+	if (!placeholderBase)
+		return;
+	// The views must all be gone by now.  Merge the split pieces back so it can be freed in one go.
+	// This fails harmlessly if it was never split.
+	VirtualFree(placeholderBase, placeholderSize, MEM_RELEASE | MEM_COALESCE_PLACEHOLDERS);
+	VirtualFree(placeholderBase, 0, MEM_RELEASE);
+	placeholderBase = nullptr;
+	placeholderSize = 0;
+#endif
+}
+
+bool MemArena::InPlaceholder(const void *ptr, size_t size) const {
+	const u8 *p = (const u8 *)ptr;
+	return placeholderBase && p >= placeholderBase && p + size <= placeholderBase + placeholderSize;
 }
 
 void *MemArena::CreateView(s64 offset, size_t size, void *viewbase) {
@@ -49,6 +112,21 @@ void *MemArena::CreateView(s64 offset, size_t size, void *viewbase) {
 	// We just grabbed some RAM before using RESERVE. This commits it.
 	void *ptr = VirtualAllocFromApp(viewbase, size, MEM_COMMIT, PAGE_READWRITE);
 #else
+	if (InPlaceholder(viewbase, size)) {
+		// Carve the view's range out as its own placeholder first, unless it already is exactly that.
+		MEMORY_BASIC_INFORMATION info{};
+		if (VirtualQuery(viewbase, &info, sizeof(info)) == 0 || info.State != MEM_RESERVE) {
+			DEBUG_LOG(MEMMAP, "View at %p overlaps an existing view", viewbase);
+			return nullptr;
+		}
+		if (info.AllocationBase != viewbase || info.RegionSize != size) {
+			if (!VirtualFree(viewbase, size, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER)) {
+				DEBUG_LOG(MEMMAP, "Failed to split placeholder at %p: %s", viewbase, GetLastErrorMsg().c_str());
+				return nullptr;
+			}
+		}
+		return ptr_MapViewOfFile3(hMemoryMapping, GetCurrentProcess(), viewbase, (ULONG64)offset, size, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0);
+	}
 	void *ptr = MapViewOfFileEx(hMemoryMapping, FILE_MAP_ALL_ACCESS, 0, (DWORD)((u64)offset), size, viewbase);
 #endif
 	return ptr;
@@ -57,13 +135,19 @@ void *MemArena::CreateView(s64 offset, size_t size, void *viewbase) {
 void MemArena::ReleaseView(void* view, size_t size) {
 #if PPSSPP_PLATFORM(UWP)
 #else
+	if (InPlaceholder(view, roundup(size))) {
+		// Leaves a placeholder behind, so the space stays ours.
+		ptr_UnmapViewOfFile2(GetCurrentProcess(), view, MEM_PRESERVE_PLACEHOLDER);
+		return;
+	}
 	UnmapViewOfFile(view);
 #endif
 }
 
 bool MemArena::NeedsProbing() {
 #if PPSSPP_ARCH(32BIT)
-	return true;
+	// With placeholders, we can just ask for a free range instead.
+	return !usePlaceholders;
 #else
 	return false;
 #endif
@@ -71,19 +155,37 @@ bool MemArena::NeedsProbing() {
 
 u8* MemArena::Find4GBBase() {
 	// Now, create views in high memory where there's plenty of space.
-#if PPSSPP_ARCH(32BIT)
-	// Caller will need to find one in a different way.
-	return nullptr;
+#if PPSSPP_ARCH(64BIT)
+	const size_t size = 0xE1000000;
+#elif PPSSPP_ARCH(32BIT)
+	// 32-bit only maps what's inside MEMVIEW32_MASK and skips the mirrors, see CanIgnoreView().
+	const size_t size = 0x10000000;
+#else
+#error Arch not supported
+#endif
 
-#elif PPSSPP_ARCH(64BIT)
-	u8 *base = (u8*)VirtualAlloc(0, 0xE1000000, MEM_RESERVE, PAGE_READWRITE);
+#if !PPSSPP_PLATFORM(UWP)
+	if (usePlaceholders) {
+		// In case a previous attempt failed.
+		ReleasePlaceholder();
+		u8 *base = (u8 *)ptr_VirtualAlloc2(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS, nullptr, 0);
+		if (base) {
+			INFO_LOG(MEMMAP, "Reserved %08x bytes at %p as placeholder", (int)size, base);
+			placeholderBase = base;
+			placeholderSize = size;
+			return base;
+		}
+		WARN_LOG(MEMMAP, "Failed to reserve placeholder, falling back: %s", GetLastErrorMsg().c_str());
+		usePlaceholders = false;
+	}
+#endif
+
+	// Note that this is only free until something else allocates, the caller should retry on failure.
+	u8 *base = (u8*)VirtualAlloc(0, size, MEM_RESERVE, PAGE_READWRITE);
 	if (base) {
 		VirtualFree(base, 0, MEM_RELEASE);
 	}
 	return base;
-#else
-#error Arch not supported
-#endif
 }
 
 #endif // _WIN32
@@ -24,6 +24,15 @@
 
 #endif
 
+#if PPSSPP_PLATFORM(SWITCH)
+#define fseeko fseek
+#endif
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#define HTTP_USE_SENDFILE
+#endif
+
 #if PPSSPP_PLATFORM(UWP)
 #define in6addr_any IN6ADDR_ANY_INIT
 #endif
@@ -45,14 +54,31 @@
 
 
 void NewThreadExecutor::Run(std::function<void()> func) {
-	threads_.push_back(std::thread(func));
+	// Each connection gets a thread, so don't keep the finished ones around until shutdown.
+	for (size_t i = 0; i < workers_.size(); ) {
+		if (*workers_[i].done) {
+			workers_[i].thread.join();
+			workers_.erase(workers_.begin() + i);
+		} else {
+			++i;
+		}
+	}
+
+	Worker worker;
+	worker.done.reset(new std::atomic<bool>(false));
+	std::atomic<bool> *done = worker.done.get();
+	worker.thread = std::thread([func, done] {
+		func();
+		*done = true;
+	});
+	workers_.push_back(std::move(worker));
 }
 
 NewThreadExecutor::~NewThreadExecutor() {
 	// If Run was ever called...
-	for (auto &thread : threads_)
-		thread.join();
-	threads_.clear();
+	for (auto &worker : workers_)
+		worker.thread.join();
+	workers_.clear();
 }
 
 namespace http {
@@ -60,10 +86,12 @@ namespace http {
 // Note: charset here helps prevent XSS.
 const char *const DEFAULT_MIME_TYPE = "text/html; charset=utf-8";
 
-Request::Request(int fd)
-	: fd_(fd) {
-	in_ = new net::InputSink(fd);
-	out_ = new net::OutputSink(fd);
+// Max time to wait for another request on a kept alive connection, and how many to serve.
+static const double KEEPALIVE_TIMEOUT = 5.0;
+static const int KEEPALIVE_MAX_REQUESTS = 100;
+
+Request::Request(int fd, net::InputSink *in, net::OutputSink *out)
+	: in_(in), out_(out), fd_(fd) {
 	header_.ParseHeaders(in_);
 
 	if (header_.ok) {
@@ -76,14 +104,25 @@ Request::Request(int fd)
 Request::~Request() {
 	Close();
 
-	if (!in_->Empty()) {
+	// With keep-alive, the next request may already be waiting in the input.
+	if (!keepAlive_ && !in_->Empty()) {
 		ERROR_LOG(IO, "Input not empty - invalid request?");
 	}
-	delete in_;
 	if (!out_->Empty()) {
 		ERROR_LOG(IO, "Output not empty - connection abort? (%s)", this->header_.resource);
 	}
-	delete out_;
+}
+
+bool Request::WantsKeepAlive() const {
+	// We'd have to skip any unread body otherwise.
+	if (header_.content_length > 0)
+		return false;
+
+	std::string connection;
+	if (!GetHeader("connection", &connection))
+		return false;
+	std::transform(connection.begin(), connection.end(), connection.begin(), ::tolower);
+	return connection.find("keep-alive") != std::string::npos;
 }
 
 void Request::WriteHttpResponseHeader(const char *ver, int status, int64_t size, const char *mimeType, const char *otherHeaders) const {
@@ -107,12 +146,16 @@ void Request::WriteHttpResponseHeader(const char *ver, int status, int64_t size,
 	default: statusStr = "OK"; break;
 	}
 
+	bool websocket = mimeType && strcmp(mimeType, "websocket") == 0;
+	// Without a length, the client can only tell the response ended by the connection closing.
+	keepAlive_ = !websocket && size >= 0 && WantsKeepAlive();
+
 	net::OutputSink *buffer = Out();
 	buffer->Printf("HTTP/%s %03d %s\r\n", ver, status, statusStr);
 	buffer->Push("Server: PPSSPPServer v0.1\r\n");
-	if (!mimeType || strcmp(mimeType, "websocket") != 0) {
+	if (!websocket) {
 		buffer->Printf("Content-Type: %s\r\n", mimeType ? mimeType : DEFAULT_MIME_TYPE);
-		buffer->Push("Connection: close\r\n");
+		buffer->Push(keepAlive_ ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
 	}
 	if (size >= 0) {
 		buffer->Printf("Content-Length: %llu\r\n", size);
@@ -123,6 +166,62 @@ void Request::WriteHttpResponseHeader(const char *ver, int status, int64_t size,
 	buffer->Push("\r\n");
 }
 
+bool Request::WriteFileRange(FILE *fp, int64_t offset, int64_t size) const {
+	// If anything fails, we've already promised a length, so the client can only tell by the connection closing.
+	bool keepAlive = keepAlive_;
+	keepAlive_ = false;
+
+#ifdef HTTP_USE_SENDFILE
+	// A 32-bit off_t can't reach far into big ISOs.
+	if (sizeof(off_t) >= 8 || offset + size <= 0x7FFFFFFF) {
+		// The header has to go out first.
+		if (!out_->Flush())
+			return false;
+
+		off_t pos = (off_t)offset;
+		int64_t left = size;
+		while (left > 0) {
+			ssize_t sent = sendfile(fd_, fileno(fp), &pos, (size_t)std::min(left, (int64_t)0x40000000));
+			if (sent > 0) {
+				left -= sent;
+			} else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+				// The socket is non-blocking.
+				if (!fd_util::WaitUntilReady(fd_, 5.0, true))
+					return false;
+			} else {
+				// Either an error, or the file got shorter.
+				ERROR_LOG(IO, "sendfile failed with %d bytes left (%s)", (int)left, header_.resource);
+				return false;
+			}
+		}
+		keepAlive_ = keepAlive;
+		return true;
+	}
+#endif
+
+#ifdef _WIN32
+	if (_fseeki64(fp, offset, SEEK_SET) != 0)
+		return false;
+#else
+	if (fseeko(fp, offset, SEEK_SET) != 0)
+		return false;
+#endif
+
+	const size_t CHUNK_SIZE = 16 * 1024;
+	char buf[CHUNK_SIZE];
+	for (int64_t pos = 0; pos < size; pos += CHUNK_SIZE) {
+		size_t chunklen = (size_t)std::min(size - pos, (int64_t)CHUNK_SIZE);
+		if (fread(buf, chunklen, 1, fp) != 1)
+			return false;
+		if (!out_->Push(buf, chunklen))
+			return false;
+	}
+	if (!out_->Flush())
+		return false;
+	keepAlive_ = keepAlive;
+	return true;
+}
+
 void Request::WritePartial() const {
 	_assert_(fd_);
 	out_->Flush();
@@ -135,10 +234,8 @@ void Request::Write() {
 }
 
 void Request::Close() {
-	if (fd_) {
-		closesocket(fd_);
-		fd_ = 0;
-	}
+	// The connection owns the socket, this just marks the request done.
+	fd_ = 0;
 }
 
 Server::Server(NewThreadExecutor *executor)
@@ -317,18 +414,32 @@ void Server::Stop() {
 }
 
 void Server::HandleConnection(int conn_fd) {
-	Request request(conn_fd);
-	if (!request.IsOK()) {
-		WARN_LOG(IO, "Bad request, ignoring.");
-		return;
+	net::InputSink in(conn_fd);
+	net::OutputSink out(conn_fd);
+
+	for (int handled = 0; handled < KEEPALIVE_MAX_REQUESTS; ++handled) {
+		// Give the client a moment to send the next request on a kept alive connection.
+		if (handled != 0 && in.Empty() && !fd_util::WaitUntilReady(conn_fd, KEEPALIVE_TIMEOUT))
+			break;
+
+		Request request(conn_fd, &in, &out);
+		if (!request.IsOK()) {
+			// A client closing a kept alive connection looks the same, so only warn on the first.
+			if (handled == 0)
+				WARN_LOG(IO, "Bad request, ignoring.");
+			break;
+		}
+		HandleRequest(request);
+
+		// TODO: Way to mark the content body as read, read it here if never read.
+		// This allows the handler to stream if need be.
+		bool keepAlive = request.KeepAlive();
+		request.Write();
+		if (!keepAlive)
+			break;
 	}
-	HandleRequest(request);
-
-	// TODO: Way to mark the content body as read, read it here if never read.
-	// This allows the handler to stream if need be.
 
-	// TODO: Could handle keep alive here.
-	request.Write();
+	closesocket(conn_fd);
 }
 
 void Server::HandleRequest(const Request &request) {
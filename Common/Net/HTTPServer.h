@@ -1,8 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <cstdio>
 #include <functional>
 #include <map>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include "Common/Net/HTTPHeaders.h"
 #include "Common/Net/Resolve.h"
@@ -10,10 +14,15 @@
 class NewThreadExecutor {
 public:
 	~NewThreadExecutor();
+	// Also joins any threads from previous calls that have finished.
 	void Run(std::function<void()> func);
 
 private:
-	std::vector<std::thread> threads_;
+	struct Worker {
+		std::thread thread;
+		std::unique_ptr<std::atomic<bool>> done;
+	};
+	std::vector<Worker> workers_;
 };
 
 namespace net {
@@ -27,7 +36,8 @@ namespace http {
 
 class Request {
 public:
-	Request(int fd);
+	// The sinks belong to the connection, which may carry several requests with keep-alive.
+	Request(int fd, net::InputSink *in, net::OutputSink *out);
 	~Request();
 
 	const char *resource() const {
@@ -57,15 +67,24 @@ class Request {
 	void Close();
 
 	bool IsOK() const { return fd_ > 0; }
+	// Whether the connection can be used for another request after this one.
+	bool KeepAlive() const { return keepAlive_; }
 
-	// If size is negative, no Content-Length: line is written.
+	// If size is negative, no Content-Length: line is written, and the connection is closed after.
 	void WriteHttpResponseHeader(const char *ver, int status, int64_t size = -1, const char *mimeType = nullptr, const char *otherHeaders = nullptr) const;
 
+	// Writes size bytes from fp starting at offset, after the header.  Where possible the
+	// kernel copies straight from the file (sendfile), otherwise it goes through Out().
+	bool WriteFileRange(FILE *fp, int64_t offset, int64_t size) const;
+
 private:
+	bool WantsKeepAlive() const;
+
 	net::InputSink *in_;
 	net::OutputSink *out_;
 	RequestHeader header_;
 	int fd_;
+	mutable bool keepAlive_ = false;
 };
 
 // Register handlers on this class to serve stuff.
@@ -133,10 +133,14 @@ void WebSocketServer::Send(const std::string &str) {
 }
 
 void WebSocketServer::Send(const std::vector<uint8_t> &payload) {
+	Send(payload.data(), payload.size());
+}
+
+void WebSocketServer::Send(const void *payload, size_t sz) {
 	_assert_(open_);
 	_assert_(fragmentOpcode_ == -1);
-	SendHeader(true, (int)Opcode::BINARY, payload.size());
-	SendBytes((const char *)&payload[0], payload.size());
+	SendHeader(true, (int)Opcode::BINARY, sz);
+	SendBytes(payload, sz);
 }
 
 void WebSocketServer::AddFragment(bool finish, const std::string &str) {
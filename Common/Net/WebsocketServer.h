@@ -33,6 +33,8 @@ class WebSocketServer {
 
 	void Send(const std::string &str);
 	void Send(const std::vector<uint8_t> &payload);
+	// Sends a binary message without copying into a vector first.
+	void Send(const void *payload, size_t sz);
 
 	// Call with finish = false to start and continue, then finally with finish = true to complete.
 	// Note: Fragmented data cannot be interleaved, per protocol.
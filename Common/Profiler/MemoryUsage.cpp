@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "Common/Profiler/MemoryUsage.h"
+
+struct MemoryPressureListener {
+	MemoryCategory cat;
+	MemoryPressureCallback callback;
+	void *userdata;
+};
+
+static const int CATEGORY_COUNT = (int)MemoryCategory::COUNT;
+
+static std::atomic<int64_t> usage[CATEGORY_COUNT];
+static std::atomic<int64_t> peak[CATEGORY_COUNT];
+static std::atomic<int64_t> budget[CATEGORY_COUNT];
+
+static std::mutex listenersLock;
+static std::vector<MemoryPressureListener> listeners;
+
+static const char *const categoryNames[] = {
+	"textureCache",
+	"textureReplacement",
+	"jitCode",
+	"vulkan",
+	"rewind",
+	"fileCache",
+};
+static_assert(sizeof(categoryNames) / sizeof(categoryNames[0]) == CATEGORY_COUNT, "Category names out of sync");
+
+const char *MemUsageCategoryName(MemoryCategory cat) {
+	if ((int)cat < 0 || cat >= MemoryCategory::COUNT)
+		return "invalid";
+	return categoryNames[(int)cat];
+}
+
+MemoryCategory MemUsageCategoryFromName(const char *name) {
+	for (int i = 0; i < CATEGORY_COUNT; ++i) {
+		if (!strcmp(categoryNames[i], name))
+			return (MemoryCategory)i;
+	}
+	return MemoryCategory::COUNT;
+}
+
+static void UpdatePeakAndPressure(MemoryCategory cat, int64_t bytes) {
+	int i = (int)cat;
+	int64_t prevPeak = peak[i].load();
+	while (bytes > prevPeak && !peak[i].compare_exchange_weak(prevPeak, bytes)) {
+		continue;
+	}
+
+	int64_t limit = budget[i].load();
+	if (limit == 0 || bytes <= limit)
+		return;
+
+	// Copy them out so callbacks can unregister themselves.
+	std::vector<MemoryPressureListener> notify;
+	{
+		std::lock_guard<std::mutex> guard(listenersLock);
+		for (const auto &listener : listeners) {
+			if (listener.cat == cat)
+				notify.push_back(listener);
+		}
+	}
+	for (const auto &listener : notify)
+		listener.callback(cat, listener.userdata);
+}
+
+void MemUsage_Set(MemoryCategory cat, int64_t bytes) {
+	if (cat >= MemoryCategory::COUNT)
+		return;
+	usage[(int)cat] = bytes;
+	UpdatePeakAndPressure(cat, bytes);
+}
+
+void MemUsage_Add(MemoryCategory cat, int64_t delta) {
+	if (cat >= MemoryCategory::COUNT)
+		return;
+	int64_t bytes = usage[(int)cat].fetch_add(delta) + delta;
+	UpdatePeakAndPressure(cat, bytes);
+}
+
+int64_t MemUsage_Get(MemoryCategory cat) {
+	if (cat >= MemoryCategory::COUNT)
+		return 0;
+	return usage[(int)cat];
+}
+
+int64_t MemUsage_GetPeak(MemoryCategory cat) {
+	if (cat >= MemoryCategory::COUNT)
+		return 0;
+	return peak[(int)cat];
+}
+
+void MemUsage_ResetPeaks() {
+	for (int i = 0; i < CATEGORY_COUNT; ++i)
+		peak[i] = usage[i].load();
+}
+
+void MemUsage_SetBudget(MemoryCategory cat, int64_t bytes) {
+	if (cat >= MemoryCategory::COUNT)
+		return;
+	budget[(int)cat] = std::max(bytes, (int64_t)0);
+}
+
+int64_t MemUsage_GetBudget(MemoryCategory cat) {
+	if (cat >= MemoryCategory::COUNT)
+		return 0;
+	return budget[(int)cat];
+}
+
+bool MemUsage_IsOverBudget(MemoryCategory cat) {
+	if (cat >= MemoryCategory::COUNT)
+		return false;
+	int64_t limit = budget[(int)cat];
+	return limit != 0 && usage[(int)cat] > limit;
+}
+
+void MemUsage_ListenPressure(MemoryCategory cat, MemoryPressureCallback callback, void *userdata) {
+	std::lock_guard<std::mutex> guard(listenersLock);
+	listeners.push_back({ cat, callback, userdata });
+}
+
+void MemUsage_ForgetPressure(MemoryCategory cat, MemoryPressureCallback callback, void *userdata) {
+	std::lock_guard<std::mutex> guard(listenersLock);
+	listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [&](const MemoryPressureListener &l) {
+		return l.cat == cat && l.callback == callback && l.userdata == userdata;
+	}), listeners.end());
+}
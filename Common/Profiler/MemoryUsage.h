@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+// Tracks how much host memory the larger caches are holding, so it can be shown live
+// and so caches can be asked to shrink when they go over a budget.
+
+enum class MemoryCategory {
+	TEXTURE_CACHE,
+	TEXTURE_REPLACEMENT,
+	JIT_CODE,
+	VULKAN,
+	REWIND,
+	FILE_CACHE,
+
+	COUNT,
+};
+
+const char *MemUsageCategoryName(MemoryCategory cat);
+// Returns MemoryCategory::COUNT if not found.
+MemoryCategory MemUsageCategoryFromName(const char *name);
+
+// Owners either report their total, or adjust it as they allocate and free.
+void MemUsage_Set(MemoryCategory cat, int64_t bytes);
+void MemUsage_Add(MemoryCategory cat, int64_t delta);
+int64_t MemUsage_Get(MemoryCategory cat);
+int64_t MemUsage_GetPeak(MemoryCategory cat);
+void MemUsage_ResetPeaks();
+
+// A budget of 0 means unlimited.
+void MemUsage_SetBudget(MemoryCategory cat, int64_t bytes);
+int64_t MemUsage_GetBudget(MemoryCategory cat);
+bool MemUsage_IsOverBudget(MemoryCategory cat);
+
+// Called from whichever thread reported usage over the budget, on each such report.
+// Should just set a flag, and let the owner trim at a safe point.
+typedef void (*MemoryPressureCallback)(MemoryCategory cat, void *userdata);
+void MemUsage_ListenPressure(MemoryCategory cat, MemoryPressureCallback callback, void *userdata);
+void MemUsage_ForgetPressure(MemoryCategory cat, MemoryPressureCallback callback, void *userdata);
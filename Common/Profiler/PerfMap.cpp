@@ -0,0 +1,55 @@
+#include "ppsspp_config.h"
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+
+#if PPSSPP_PLATFORM(LINUX)
+#include <unistd.h>
+#endif
+
+#include "Common/Log.h"
+#include "Common/Profiler/PerfMap.h"
+
+static std::atomic<bool> perfMapEnabled;
+static std::mutex perfMapLock;
+static FILE *perfMapFile = nullptr;
+
+void PerfMap_SetEnabled(bool enabled) {
+#if PPSSPP_PLATFORM(LINUX)
+	std::lock_guard<std::mutex> guard(perfMapLock);
+	if (enabled && !perfMapFile) {
+		char filename[64];
+		snprintf(filename, sizeof(filename), "/tmp/perf-%d.map", (int)getpid());
+		// Append, in case it's toggled or the JIT code is from a previous game in the same process.
+		perfMapFile = fopen(filename, "a");
+		if (!perfMapFile) {
+			WARN_LOG(SYSTEM, "Unable to open %s for JIT symbols", filename);
+			return;
+		}
+		INFO_LOG(SYSTEM, "Writing JIT symbols to %s", filename);
+	} else if (!enabled && perfMapFile) {
+		fclose(perfMapFile);
+		perfMapFile = nullptr;
+	}
+	perfMapEnabled = perfMapFile != nullptr;
+#endif
+}
+
+bool PerfMap_IsEnabled() {
+	return perfMapEnabled.load(std::memory_order_relaxed);
+}
+
+void PerfMap_AddSymbol(const void *start, size_t size, const std::string &name) {
+	if (!PerfMap_IsEnabled() || size == 0)
+		return;
+
+	std::lock_guard<std::mutex> guard(perfMapLock);
+	if (!perfMapFile)
+		return;
+	fprintf(perfMapFile, "%" PRIxPTR " %zx %s\n", (uintptr_t)start, size, name.c_str());
+	// Keep it usable even if we crash or get killed in the middle of profiling.
+	fflush(perfMapFile);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Writes /tmp/perf-<pid>.map, so Linux perf can put names on JIT generated code.
+// Does nothing on other platforms, or until enabled.
+
+void PerfMap_SetEnabled(bool enabled);
+bool PerfMap_IsEnabled();
+
+// Code space is reused after a JIT cache clear, so the same address may show up more than once.
+void PerfMap_AddSymbol(const void *start, size_t size, const std::string &name);
@@ -1,6 +1,8 @@
 // Ultra-lightweight category profiler with history.
 
 #include <algorithm>
+#include <chrono>
+#include <cinttypes>
 #include <mutex>
 #include <vector>
 #include <cstring>
@@ -11,6 +13,7 @@
 
 #include "Common/TimeUtil.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Common/Log.h"
 
 #define MAX_CATEGORIES 64 // Can be any number, represents max profiled names.
@@ -262,3 +265,129 @@ void Profiler_GetHistory(int category, int thread, float *data, int count) {
 		data[i] = history[MAX_THREADS * x + thread].time_taken[category];
 	}
 }
+
+#define TRACE_EVENTS_PER_THREAD 32768 // Must be power of 2, 24 bytes each.
+
+struct TraceEvent {
+	const char *name;
+	uint64_t start;
+	uint64_t duration;
+};
+
+struct TraceBuffer {
+	TraceEvent events[TRACE_EVENTS_PER_THREAD];
+	// Only written by the owning thread.
+	std::atomic<uint64_t> written{};
+	int threadId;
+	std::string threadName;
+};
+
+std::atomic<bool> g_tracerActive;
+static uint64_t tracerEpoch = 0;
+// Buffers are never freed, since threads keep pointers to them.
+static std::vector<TraceBuffer *> traceBuffers;
+static std::mutex traceBuffersLock;
+#if MAX_THREADS > 1
+thread_local TraceBuffer *traceThreadBuffer = nullptr;
+#else
+static TraceBuffer *traceThreadBuffer = nullptr;
+#endif
+
+uint64_t internal_tracer_now() {
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+static TraceBuffer *internal_tracer_find_buffer() {
+	if (traceThreadBuffer)
+		return traceThreadBuffer;
+
+	std::lock_guard<std::mutex> guard(traceBuffersLock);
+	TraceBuffer *buf = new TraceBuffer();
+	buf->threadId = (int)traceBuffers.size();
+	const char *name = GetCurrentThreadName();
+	buf->threadName = name && name[0] ? name : "Thread " + std::to_string(buf->threadId);
+	traceBuffers.push_back(buf);
+	traceThreadBuffer = buf;
+	return buf;
+}
+
+void internal_tracer_record(const char *name, uint64_t start) {
+	uint64_t now = internal_tracer_now();
+	TraceBuffer *buf = internal_tracer_find_buffer();
+
+	uint64_t pos = buf->written.load(std::memory_order_relaxed);
+	TraceEvent &ev = buf->events[pos & (TRACE_EVENTS_PER_THREAD - 1)];
+	ev.name = name;
+	ev.start = start;
+	ev.duration = now - start;
+	buf->written.store(pos + 1, std::memory_order_release);
+}
+
+void Tracer_Start() {
+	tracerEpoch = internal_tracer_now();
+	g_tracerActive = true;
+}
+
+void Tracer_Stop() {
+	g_tracerActive = false;
+}
+
+bool Tracer_IsActive() {
+	return g_tracerActive;
+}
+
+static void AppendMicros(std::string &out, uint64_t ns) {
+	char temp[32];
+	snprintf(temp, sizeof(temp), "%" PRIu64 ".%03d", ns / 1000, (int)(ns % 1000));
+	out += temp;
+}
+
+std::string Tracer_ExportJSON() {
+	std::vector<TraceBuffer *> buffers;
+	{
+		std::lock_guard<std::mutex> guard(traceBuffersLock);
+		buffers = traceBuffers;
+	}
+
+	std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool first = true;
+	std::vector<TraceEvent> events;
+	for (TraceBuffer *buf : buffers) {
+		uint64_t end = buf->written.load(std::memory_order_acquire);
+		uint64_t begin = end > TRACE_EVENTS_PER_THREAD ? end - TRACE_EVENTS_PER_THREAD : 0;
+		events.clear();
+		for (uint64_t i = begin; i < end; ++i)
+			events.push_back(buf->events[i & (TRACE_EVENTS_PER_THREAD - 1)]);
+
+		// The thread may have kept writing meanwhile, drop anything it could have overwritten.
+		// That includes the slot for an event it's in the middle of writing.
+		uint64_t after = buf->written.load(std::memory_order_acquire) + 1;
+		size_t skip = after > begin + TRACE_EVENTS_PER_THREAD ? (size_t)std::min(after - begin - TRACE_EVENTS_PER_THREAD, end - begin) : 0;
+
+		char temp[64];
+		snprintf(temp, sizeof(temp), "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,", first ? "" : ",", buf->threadId);
+		out += temp;
+		// Thread names are set by us, no escaping needed.
+		out += "\"name\":\"thread_name\",\"args\":{\"name\":\"" + buf->threadName + "\"}}";
+		first = false;
+
+		for (size_t i = skip; i < events.size(); ++i) {
+			const TraceEvent &ev = events[i];
+			if (ev.start < tracerEpoch)
+				continue;
+			// Names are string literals from PROFILE_THIS_SCOPE, also no escaping.
+			out += ",{\"ph\":\"X\",\"pid\":1,\"tid\":";
+			out += std::to_string(buf->threadId);
+			out += ",\"name\":\"";
+			out += ev.name;
+			out += "\",\"ts\":";
+			AppendMicros(out, ev.start - tracerEpoch);
+			out += ",\"dur\":";
+			AppendMicros(out, ev.duration);
+			out += "}";
+		}
+	}
+	out += "]}";
+	return out;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <string>
 
 // #define USE_PROFILER
 
@@ -35,14 +37,46 @@ class ProfileThis {
 	int thread_;
 };
 
+#endif
+
+// Event tracer, for a timeline rather than averages.  Always compiled in, but only records
+// between Tracer_Start() and Tracer_Stop() - until then a scope costs one relaxed atomic load.
+// Each thread writes into its own ring buffer without locking, so old events get overwritten.
+extern std::atomic<bool> g_tracerActive;
+
+uint64_t internal_tracer_now();
+void internal_tracer_record(const char *name, uint64_t start);
+
+void Tracer_Start();
+void Tracer_Stop();
+bool Tracer_IsActive();
+// Events since the last Tracer_Start(), as Chrome trace event JSON (also opens in Perfetto.)
+std::string Tracer_ExportJSON();
+
+class TraceThis {
+public:
+	TraceThis(const char *name) : name_(name) {
+		start_ = g_tracerActive.load(std::memory_order_relaxed) ? internal_tracer_now() : 0;
+	}
+	~TraceThis() {
+		if (start_ != 0)
+			internal_tracer_record(name_, start_);
+	}
+private:
+	const char *name_;
+	uint64_t start_;
+};
+
+#ifdef USE_PROFILER
+
 #define PROFILE_INIT() internal_profiler_init();
-#define PROFILE_THIS_SCOPE(cat) ProfileThis _profile_scoped(cat);
+#define PROFILE_THIS_SCOPE(cat) ProfileThis _profile_scoped(cat); TraceThis _trace_scoped(cat);
 #define PROFILE_END_FRAME() internal_profiler_end_frame();
 
 #else
 
 #define PROFILE_INIT()
-#define PROFILE_THIS_SCOPE(cat)
+#define PROFILE_THIS_SCOPE(cat) TraceThis _trace_scoped(cat);
 #define PROFILE_END_FRAME()
 
 #endif
@@ -7,6 +7,7 @@
 #include "Common/Data/Encoding/Utf8.h"
 
 #include "Common/Render/Text/draw_text.h"
+#include "Common/Render/Text/draw_text_atlas.h"
 #include "Common/Render/Text/draw_text_win.h"
 #include "Common/Render/Text/draw_text_uwp.h"
 #include "Common/Render/Text/draw_text_qt.h"
@@ -15,6 +16,7 @@
 TextDrawer::TextDrawer(Draw::DrawContext *draw) : draw_(draw) {
 	// These probably shouldn't be state.
 	dpiScale_ = CalculateDPIScale();
+	atlas_.reset(new TextDrawerAtlas(draw, this));
 }
 TextDrawer::~TextDrawer() {
 }
@@ -30,6 +32,12 @@ void TextDrawer::WrapString(std::string &out, const char *str, float maxW, int f
 	out = wrapper.Wrapped();
 }
 
+bool TextDrawer::DrawStringFromAtlas(DrawBuffer &target, uint32_t fontHash, const char *str, float x, float y, uint32_t color, int align) {
+	if (!TextDrawerAtlas::CanDraw(str))
+		return false;
+	return atlas_->DrawString(target, fontHash, str, x, y, color, align, fontScaleX_ * dpiScale_, fontScaleY_ * dpiScale_, frameCount_);
+}
+
 void TextDrawer::SetFontScale(float xscale, float yscale) {
 	fontScaleX_ = xscale;
 	fontScaleY_ = yscale;
@@ -3,8 +3,8 @@
 // Uses system fonts to draw text. 
 // Platform support will be added over time, initially just Win32.
 
-// Caches strings in individual textures. Might later combine them into a big one
-// with dynamically allocated space but too much trouble for now.
+// Caches strings in individual textures, except CJK text which is drawn glyph by glyph
+// from a shared atlas, see draw_text_atlas.h.
 
 #pragma once
 
@@ -21,6 +21,8 @@ namespace Draw {
 	class Texture;
 }
 
+class TextDrawerAtlas;
+
 struct TextStringEntry {
 	Draw::Texture *texture;
 	int width;
@@ -68,6 +70,10 @@ class TextDrawer {
 	Draw::DrawContext *draw_;
 	virtual void ClearCache() = 0;
 	void WrapString(std::string &out, const char *str, float maxWidth, int flags);
+	// Returns false if the string isn't suitable for the atlas, then draw it as a whole instead.
+	bool DrawStringFromAtlas(DrawBuffer &target, uint32_t fontHash, const char *str, float x, float y, uint32_t color, int align);
+
+	std::unique_ptr<TextDrawerAtlas> atlas_;
 
 	struct CacheKey {
 		bool operator < (const CacheKey &other) const {
@@ -237,6 +237,9 @@ void TextDrawerAndroid::DrawString(DrawBuffer &target, const char *str, float x,
 	if (text.empty())
 		return;
 
+	if (DrawStringFromAtlas(target, fontHash_, text.c_str(), x, y, color, align))
+		return;
+
 	CacheKey key{ std::string(str), fontHash_ };
 	target.Flush(true);
 
@@ -290,6 +293,7 @@ void TextDrawerAndroid::ClearCache() {
 	}
 	cache_.clear();
 	sizeCache_.clear();
+	atlas_->Clear();
 }
 
 void TextDrawerAndroid::OncePerFrame() {
@@ -304,6 +308,8 @@ void TextDrawerAndroid::OncePerFrame() {
 		fontMap_.clear();  // size is precomputed using dpiScale_.
 	}
 
+	atlas_->OncePerFrame(frameCount_);
+
 	// Drop old strings. Use a prime number to reduce clashing with other rhythms
 	if (frameCount_ % 23 == 0) {
 		for (auto iter = cache_.begin(); iter != cache_.end();) {
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cstring>
+
+#include "Common/Data/Encoding/Utf8.h"
+#include "Common/Log.h"
+#include "Common/Render/DrawBuffer.h"
+#include "Common/Render/Text/draw_text.h"
+#include "Common/Render/Text/draw_text_atlas.h"
+
+enum {
+	ATLAS_PAGE_SIZE = 512,
+	ATLAS_MAX_PAGES = 8,
+	// Pages nobody has drawn from in this long are freed.
+	ATLAS_PAGE_IDLE_FRAMES = 600,
+};
+
+static bool IsAtlasChar(uint32_t c) {
+	if (c >= 0x20 && c < 0x7F)
+		return c != '&';  // Windows treats these as prefixes, best to leave them to the full string path.
+	if (c == '\n')
+		return true;
+	// Latin-1 and extended Latin, Greek, Cyrillic. No combining marks.
+	if ((c >= 0xA0 && c < 0x250) || (c >= 0x370 && c < 0x500))
+		return true;
+	// Punctuation, but not the zero width and direction controls.
+	if ((c >= 0x2010 && c < 0x2028) || (c >= 0x2030 && c < 0x205F))
+		return true;
+	// Letterlike symbols, arrows, math, box drawing, shapes, dingbats.
+	if (c >= 0x2100 && c < 0x2C00)
+		return true;
+	return c >= 0x2E80;
+}
+
+static bool IsWideChar(uint32_t c) {
+	return (c >= 0x2E80 && c < 0xA000) || (c >= 0xAC00 && c < 0xD7A4) || (c >= 0xF900 && c < 0xFB00) || (c >= 0xFF01 && c < 0xFFF0);
+}
+
+TextDrawerAtlas::TextDrawerAtlas(Draw::DrawContext *draw, TextDrawer *drawer) : draw_(draw), drawer_(drawer) {
+	using namespace Draw;
+	// Can't use a single channel format since we need white, same as the string textures.
+	if (draw_->GetDataFormatSupport(DataFormat::A4R4G4B4_UNORM_PACK16) & FMT_TEXTURE)
+		texFormat_ = DataFormat::A4R4G4B4_UNORM_PACK16;
+	else if (draw_->GetDataFormatSupport(DataFormat::R4G4B4A4_UNORM_PACK16) & FMT_TEXTURE)
+		texFormat_ = DataFormat::R4G4B4A4_UNORM_PACK16;
+	else if (draw_->GetDataFormatSupport(DataFormat::B4G4R4A4_UNORM_PACK16) & FMT_TEXTURE)
+		texFormat_ = DataFormat::B4G4R4A4_UNORM_PACK16;
+	else
+		texFormat_ = DataFormat::R8G8B8A8_UNORM;
+}
+
+TextDrawerAtlas::~TextDrawerAtlas() {
+	Clear();
+}
+
+bool TextDrawerAtlas::CanDraw(const char *str) {
+	// Only bother when there's CJK or similar, where there are lots of different characters, no
+	// kerning, and the platform rasterizers are at their slowest. Everything else is left exactly
+	// as the platform lays it out.
+	bool anyWide = false;
+	UTF8 utf(str);
+	while (!utf.end()) {
+		if (utf.invalid())
+			return false;
+		uint32_t c = utf.next();
+		if (c > 0xFFFF || !IsAtlasChar(c))
+			return false;
+		anyWide = anyWide || IsWideChar(c);
+	}
+	return anyWide;
+}
+
+const TextDrawerAtlas::Glyph *TextDrawerAtlas::GetGlyph(uint32_t fontHash, uint32_t c, int frame) {
+	uint64_t key = ((uint64_t)fontHash << 32) | c;
+	auto iter = glyphs_.find(key);
+	if (iter != glyphs_.end()) {
+		pages_[iter->second.page].lastUsedFrame = frame;
+		return &iter->second;
+	}
+
+	char utf8[8]{};
+	u8_wc_toutf8(utf8, c);
+	TextStringEntry entry{};
+	drawer_->DrawStringBitmap(bitmapScratch_, entry, Draw::DataFormat::R8_UNORM, utf8, ALIGN_TOPLEFT);
+	if (bitmapScratch_.size() < (size_t)(entry.bmWidth * entry.bmHeight))
+		return nullptr;
+
+	// One pixel of padding so filtering doesn't pick up the neighbors.
+	Glyph glyph{};
+	if (!Allocate(entry.bmWidth + 1, entry.bmHeight + 1, frame, &glyph.page, &glyph.x, &glyph.y))
+		return nullptr;
+	glyph.bmWidth = entry.bmWidth;
+	glyph.bmHeight = entry.bmHeight;
+	glyph.advance = entry.width;
+	glyph.height = entry.height;
+
+	Page &page = pages_[glyph.page];
+	glyph.generation = ++page.generation;
+	for (int y = 0; y < glyph.bmHeight; y++) {
+		memcpy(&page.alpha[(glyph.y + y) * ATLAS_PAGE_SIZE + glyph.x], &bitmapScratch_[y * glyph.bmWidth], glyph.bmWidth);
+	}
+	page.lastUsedFrame = frame;
+
+	return &(glyphs_[key] = glyph);
+}
+
+bool TextDrawerAtlas::AllocateInPage(Page &page, int w, int h, int *x, int *y) {
+	if (page.shelfX + w > ATLAS_PAGE_SIZE) {
+		page.shelfY += page.shelfHeight;
+		page.shelfX = 0;
+		page.shelfHeight = 0;
+	}
+	if (page.shelfY + h > ATLAS_PAGE_SIZE)
+		return false;
+
+	if (page.alpha.empty())
+		page.alpha.resize(ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE);
+	*x = page.shelfX;
+	*y = page.shelfY;
+	page.shelfX += w;
+	page.shelfHeight = std::max(page.shelfHeight, h);
+	return true;
+}
+
+bool TextDrawerAtlas::Allocate(int w, int h, int frame, int *page, int *x, int *y) {
+	if (w > ATLAS_PAGE_SIZE || h > ATLAS_PAGE_SIZE)
+		return false;
+
+	for (size_t i = 0; i < pages_.size(); i++) {
+		if (AllocateInPage(pages_[i], w, h, x, y)) {
+			*page = (int)i;
+			return true;
+		}
+	}
+
+	if (pages_.size() < ATLAS_MAX_PAGES) {
+		pages_.push_back(Page());
+		*page = (int)pages_.size() - 1;
+		return AllocateInPage(pages_.back(), w, h, x, y);
+	}
+
+	// All full, so evict the least recently used page, unless they're all in use right now.
+	int oldest = -1;
+	for (size_t i = 0; i < pages_.size(); i++) {
+		if (pages_[i].lastUsedFrame != frame && (oldest < 0 || pages_[i].lastUsedFrame < pages_[oldest].lastUsedFrame))
+			oldest = (int)i;
+	}
+	if (oldest < 0)
+		return false;
+	ClearPage(oldest);
+	*page = oldest;
+	return AllocateInPage(pages_[oldest], w, h, x, y);
+}
+
+void TextDrawerAtlas::ClearPage(int index) {
+	for (auto iter = glyphs_.begin(); iter != glyphs_.end(); ) {
+		if (iter->second.page == index)
+			iter = glyphs_.erase(iter);
+		else
+			++iter;
+	}
+
+	Page &page = pages_[index];
+	if (page.texture)
+		page.texture->Release();
+	page = Page();
+}
+
+void TextDrawerAtlas::Upload(Page &page, int frame) {
+	using namespace Draw;
+	const int pixels = ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE;
+	const uint8_t *alpha = page.alpha.data();
+	if (texFormat_ == DataFormat::R8G8B8A8_UNORM) {
+		uploadScratch_.resize(pixels * sizeof(uint32_t));
+		uint32_t *dst = (uint32_t *)uploadScratch_.data();
+		for (int i = 0; i < pixels; i++)
+			dst[i] = (alpha[i] << 24) | 0x00FFFFFF;
+	} else {
+		uploadScratch_.resize(pixels * sizeof(uint16_t));
+		uint16_t *dst = (uint16_t *)uploadScratch_.data();
+		if (texFormat_ == DataFormat::A4R4G4B4_UNORM_PACK16) {
+			for (int i = 0; i < pixels; i++)
+				dst[i] = ((alpha[i] >> 4) << 12) | 0x0FFF;
+		} else {
+			for (int i = 0; i < pixels; i++)
+				dst[i] = (alpha[i] >> 4) | 0xFFF0;
+		}
+	}
+
+	TextureDesc desc{};
+	desc.type = TextureType::LINEAR2D;
+	desc.format = texFormat_;
+	desc.width = ATLAS_PAGE_SIZE;
+	desc.height = ATLAS_PAGE_SIZE;
+	desc.depth = 1;
+	desc.mipLevels = 1;
+	desc.tag = "TextDrawerAtlas";
+	desc.initData.push_back(uploadScratch_.data());
+
+	if (page.texture)
+		page.texture->Release();
+	page.texture = draw_->CreateTexture(desc);
+	page.uploadedGeneration = page.generation;
+	page.uploadedFrame = frame;
+}
+
+bool TextDrawerAtlas::DrawString(DrawBuffer &target, uint32_t fontHash, const char *str, float x, float y, uint32_t color, int align, float scaleX, float scaleY, int frame) {
+	if (align & (ROTATE_90DEG_LEFT | ROTATE_90DEG_RIGHT))
+		return false;
+
+	// Fetch everything first, a page can't be evicted once it's been used this frame.
+	std::vector<const Glyph *> &glyphs = glyphScratch_;
+	std::vector<int> &lineWidths = lineWidthScratch_;
+	glyphs.clear();
+	lineWidths.assign(1, 0);
+	int lineHeight = 0;
+	UTF8 utf(str);
+	while (!utf.end()) {
+		uint32_t c = utf.next();
+		if (c == '\n') {
+			glyphs.push_back(nullptr);
+			lineWidths.push_back(0);
+			continue;
+		}
+		const Glyph *glyph = GetGlyph(fontHash, c, frame);
+		if (!glyph)
+			return false;
+		glyphs.push_back(glyph);
+		lineWidths.back() += glyph->advance;
+		lineHeight = std::max(lineHeight, glyph->height);
+	}
+
+	for (const Glyph *glyph : glyphs) {
+		if (!glyph)
+			continue;
+		Page &page = pages_[glyph->page];
+		if (glyph->generation > page.uploadedGeneration || !page.texture) {
+			// Recreating a page is not cheap, so only do it once a frame. Until the next one,
+			// strings with glyphs that haven't made it into the texture go the slow way.
+			if (page.texture && page.uploadedFrame == frame)
+				return false;
+			Upload(page, frame);
+			if (!page.texture)
+				return false;
+		}
+	}
+
+	int totalWidth = *std::max_element(lineWidths.begin(), lineWidths.end());
+	float w = totalWidth * scaleX;
+	float h = lineHeight * (int)lineWidths.size() * scaleY;
+	DrawBuffer::DoAlign(align, &x, &y, &w, &h);
+
+	const float texelScale = 1.0f / ATLAS_PAGE_SIZE;
+	target.Flush(true);
+	// Usually everything is on one page, but batch per page in case it isn't.
+	for (size_t p = 0; p < pages_.size(); p++) {
+		bool bound = false;
+		float penY = y;
+		size_t line = 0;
+		float penX = x;
+		if (align & ALIGN_HCENTER)
+			penX += (totalWidth - lineWidths[0]) * 0.5f * scaleX;
+		for (const Glyph *glyph : glyphs) {
+			if (!glyph) {
+				line++;
+				penY += lineHeight * scaleY;
+				penX = x;
+				if (align & ALIGN_HCENTER)
+					penX += (totalWidth - lineWidths[line]) * 0.5f * scaleX;
+				continue;
+			}
+			if (glyph->page == (int)p) {
+				if (!bound) {
+					draw_->BindTexture(0, pages_[p].texture);
+					bound = true;
+				}
+				float u1 = glyph->x * texelScale;
+				float v1 = glyph->y * texelScale;
+				float u2 = (glyph->x + glyph->bmWidth) * texelScale;
+				float v2 = (glyph->y + glyph->bmHeight) * texelScale;
+				target.DrawTexRect(penX, penY, penX + glyph->bmWidth * scaleX, penY + glyph->bmHeight * scaleY, u1, v1, u2, v2, color);
+			}
+			penX += glyph->advance * scaleX;
+		}
+		if (bound)
+			target.Flush(true);
+	}
+	return true;
+}
+
+void TextDrawerAtlas::OncePerFrame(int frame) {
+	for (size_t i = 0; i < pages_.size(); i++) {
+		if (!pages_[i].alpha.empty() && frame - pages_[i].lastUsedFrame > ATLAS_PAGE_IDLE_FRAMES)
+			ClearPage((int)i);
+	}
+}
+
+void TextDrawerAtlas::Clear() {
+	for (Page &page : pages_) {
+		if (page.texture)
+			page.texture->Release();
+	}
+	pages_.clear();
+	glyphs_.clear();
+}
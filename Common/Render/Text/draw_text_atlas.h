@@ -0,0 +1,81 @@
+// Shared glyph atlas for TextDrawer.
+
+// Rasterizes each character once per font through the platform's DrawStringBitmap, and packs
+// them into a few large textures. Strings made of cached characters are then just a batch of
+// quads, instead of a platform rasterization and a new texture per string, which is what made
+// scrolling through lists of CJK titles stutter.
+//
+// Only used for strings that can be laid out by simply advancing glyph by glyph, see CanDraw().
+// Everything else keeps using whole-string textures.
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/GPU/thin3d.h"
+
+class DrawBuffer;
+class TextDrawer;
+
+class TextDrawerAtlas {
+public:
+	TextDrawerAtlas(Draw::DrawContext *draw, TextDrawer *drawer);
+	~TextDrawerAtlas();
+
+	// Whether str is worth drawing through the atlas and safe to lay out per glyph.
+	static bool CanDraw(const char *str);
+
+	// The font identified by fontHash must be the one currently set on the drawer.
+	// Returns false if the caller should draw the string some other way.
+	bool DrawString(DrawBuffer &target, uint32_t fontHash, const char *str, float x, float y, uint32_t color, int align, float scaleX, float scaleY, int frame);
+
+	void OncePerFrame(int frame);
+	// Drops all glyphs, for example after a DPI change.
+	void Clear();
+
+private:
+	struct Glyph {
+		int page;
+		int x;
+		int y;
+		int bmWidth;
+		int bmHeight;
+		int advance;
+		int height;
+		// Page generation it was added in, to know if the page texture has it yet.
+		int generation;
+	};
+
+	struct Page {
+		std::vector<uint8_t> alpha;
+		Draw::Texture *texture = nullptr;
+		// Bumped for each glyph added, compared to what's in the texture.
+		int generation = 0;
+		int uploadedGeneration = 0;
+		int uploadedFrame = -1;
+		int lastUsedFrame = 0;
+		// Simple shelf packing.
+		int shelfX = 0;
+		int shelfY = 0;
+		int shelfHeight = 0;
+	};
+
+	const Glyph *GetGlyph(uint32_t fontHash, uint32_t c, int frame);
+	bool Allocate(int w, int h, int frame, int *page, int *x, int *y);
+	bool AllocateInPage(Page &page, int w, int h, int *x, int *y);
+	void ClearPage(int index);
+	void Upload(Page &page, int frame);
+
+	Draw::DrawContext *draw_;
+	TextDrawer *drawer_;
+	Draw::DataFormat texFormat_;
+
+	std::vector<Page> pages_;
+	std::unordered_map<uint64_t, Glyph> glyphs_;
+	std::vector<uint8_t> bitmapScratch_;
+	std::vector<const Glyph *> glyphScratch_;
+	std::vector<int> lineWidthScratch_;
+	std::vector<uint8_t> uploadScratch_;
+};
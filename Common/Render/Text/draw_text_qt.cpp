@@ -143,6 +143,9 @@ void TextDrawerQt::DrawString(DrawBuffer &target, const char *str, float x, floa
 	if (!strlen(str))
 		return;
 
+	if (DrawStringFromAtlas(target, fontHash_, str, x, y, color, align))
+		return;
+
 	CacheKey key{ std::string(str), fontHash_ };
 	target.Flush(true);
 
@@ -193,6 +196,7 @@ void TextDrawerQt::ClearCache() {
 	}
 	cache_.clear();
 	sizeCache_.clear();
+	atlas_->Clear();
 	// Also wipe the font map.
 	for (auto iter : fontMap_) {
 		delete iter.second;
@@ -210,6 +214,8 @@ void TextDrawerQt::OncePerFrame() {
 		ClearCache();
 	}
 
+	atlas_->OncePerFrame(frameCount_);
+
 	// Drop old strings. Use a prime number to reduce clashing with other rhythms
 	if (frameCount_ % 23 == 0) {
 		for (auto iter = cache_.begin(); iter != cache_.end();) {
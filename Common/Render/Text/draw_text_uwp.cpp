@@ -441,6 +441,9 @@ void TextDrawerUWP::DrawString(DrawBuffer &target, const char *str, float x, flo
 	if (!strlen(str))
 		return;
 
+	if (DrawStringFromAtlas(target, fontHash_, str, x, y, color, align))
+		return;
+
 	CacheKey key{ std::string(str), fontHash_ };
 	target.Flush(true);
 
@@ -510,6 +513,7 @@ void TextDrawerUWP::ClearCache() {
 	}
 	cache_.clear();
 	sizeCache_.clear();
+	atlas_->Clear();
 }
 
 void TextDrawerUWP::OncePerFrame() {
@@ -522,6 +526,8 @@ void TextDrawerUWP::OncePerFrame() {
 		RecreateFonts();
 	}
 
+	atlas_->OncePerFrame(frameCount_);
+
 	// Drop old strings. Use a prime number to reduce clashing with other rhythms
 	if (frameCount_ % 23 == 0) {
 		for (auto iter = cache_.begin(); iter != cache_.end();) {
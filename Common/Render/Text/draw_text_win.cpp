@@ -297,6 +297,9 @@ void TextDrawerWin32::DrawString(DrawBuffer &target, const char *str, float x, f
 	if (!strlen(str))
 		return;
 
+	if (DrawStringFromAtlas(target, fontHash_, str, x, y, color, align))
+		return;
+
 	CacheKey key{ std::string(str), fontHash_ };
 	target.Flush(true);
 
@@ -368,6 +371,7 @@ void TextDrawerWin32::ClearCache() {
 	}
 	cache_.clear();
 	sizeCache_.clear();
+	atlas_->Clear();
 }
 
 void TextDrawerWin32::OncePerFrame() {
@@ -380,6 +384,8 @@ void TextDrawerWin32::OncePerFrame() {
 		RecreateFonts();
 	}
 
+	atlas_->OncePerFrame(frameCount_);
+
 	// Drop old strings. Use a prime number to reduce clashing with other rhythms
 	if (frameCount_ % 23 == 0) {
 		for (auto iter = cache_.begin(); iter != cache_.end();) {
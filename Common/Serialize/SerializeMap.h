@@ -46,8 +46,8 @@ void DoMap(PointerWrap &p, M &x, typename M::mapped_type &default_val) {
 	{
 		typename M::iterator itr = x.begin();
 		while (number > 0) {
-			typename M::key_type first = itr->first;
-			Do(p, first);
+			// Keys aren't modified outside MODE_READ, and copying them might allocate.
+			Do(p, const_cast<typename M::key_type &>(itr->first));
 			Do(p, itr->second);
 			--number;
 			++itr;
@@ -15,8 +15,11 @@
 // Official SVN repository and contact information can be found at
 // http://code.google.com/p/dolphin-emu/
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 #include <snappy-c.h>
 #include <zstd.h>
 
@@ -24,6 +27,7 @@
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
 
 enum class SerializeCompressType {
 	NONE = 0,
@@ -32,6 +36,117 @@ enum class SerializeCompressType {
 };
 
 static constexpr SerializeCompressType SAVE_TYPE = SerializeCompressType::ZSTD;
+// States are written as a series of independent zstd frames of this size, so they can be
+// compressed and decompressed in parallel. Concatenated frames are still a valid zstd stream.
+static constexpr size_t ZSTD_CHUNK_SIZE = 4 * 1024 * 1024;
+
+static void RunChunks(int count, const std::function<void(int, int)> &func) {
+	if (count > 1 && g_threadManager.IsInitialized()) {
+		ParallelRangeLoop(&g_threadManager, func, 0, count, 1);
+	} else {
+		func(0, count);
+	}
+}
+
+static size_t CompressChunkedZstd(u8 *dest, size_t destSize, const u8 *src, size_t sz) {
+	const int count = std::max(1, (int)((sz + ZSTD_CHUNK_SIZE - 1) / ZSTD_CHUNK_SIZE));
+	const size_t boundPerChunk = ZSTD_compressBound(std::min(sz, ZSTD_CHUNK_SIZE));
+	if (boundPerChunk * count > destSize)
+		return 0;
+
+	// Each chunk compresses into its own slot, then they're packed together.
+	std::vector<size_t> sizes(count);
+	std::atomic<bool> failed(false);
+	RunChunks(count, [&](int l, int h) {
+		ZSTD_CCtx *ctx = ZSTD_createCCtx();
+		if (!ctx) {
+			failed = true;
+			return;
+		}
+		for (int i = l; i < h; ++i) {
+			size_t offset = (size_t)i * ZSTD_CHUNK_SIZE;
+			size_t len = std::min(ZSTD_CHUNK_SIZE, sz - offset);
+			// TODO: If free disk space is low, we could max this out to 22?
+			ZSTD_CCtx_reset(ctx, ZSTD_reset_session_and_parameters);
+			ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+			ZSTD_CCtx_setParameter(ctx, ZSTD_c_checksumFlag, 1);
+			ZSTD_CCtx_setPledgedSrcSize(ctx, len);
+			sizes[i] = ZSTD_compress2(ctx, dest + boundPerChunk * i, boundPerChunk, src + offset, len);
+			if (ZSTD_isError(sizes[i]))
+				failed = true;
+		}
+		ZSTD_freeCCtx(ctx);
+	});
+	if (failed)
+		return 0;
+
+	size_t pos = 0;
+	for (int i = 0; i < count; ++i) {
+		memmove(dest + pos, dest + boundPerChunk * i, sizes[i]);
+		pos += sizes[i];
+	}
+	return pos;
+}
+
+// Also handles states written as a single frame.
+static bool DecompressChunkedZstd(u8 *dest, size_t destSize, const u8 *src, size_t sz) {
+	struct Frame {
+		size_t srcOffset;
+		size_t srcSize;
+		size_t destOffset;
+		size_t destSize;
+	};
+	std::vector<Frame> frames;
+	size_t srcPos = 0;
+	size_t destPos = 0;
+	while (srcPos < sz) {
+		size_t frameSize = ZSTD_findFrameCompressedSize(src + srcPos, sz - srcPos);
+		unsigned long long contentSize = ZSTD_getFrameContentSize(src + srcPos, sz - srcPos);
+		if (ZSTD_isError(frameSize) || contentSize == ZSTD_CONTENTSIZE_ERROR || contentSize == ZSTD_CONTENTSIZE_UNKNOWN) {
+			// Can't split it up, let zstd figure it out.
+			size_t result = ZSTD_decompress(dest, destSize, src, sz);
+			return !ZSTD_isError(result) && result == destSize;
+		}
+		if (contentSize > destSize - destPos)
+			return false;
+		frames.push_back(Frame{ srcPos, frameSize, destPos, (size_t)contentSize });
+		srcPos += frameSize;
+		destPos += (size_t)contentSize;
+	}
+	if (destPos != destSize)
+		return false;
+
+	std::atomic<bool> failed(false);
+	RunChunks((int)frames.size(), [&](int l, int h) {
+		ZSTD_DCtx *ctx = ZSTD_createDCtx();
+		if (!ctx) {
+			failed = true;
+			return;
+		}
+		for (int i = l; i < h; ++i) {
+			const Frame &frame = frames[i];
+			size_t result = ZSTD_decompressDCtx(ctx, dest + frame.destOffset, frame.destSize, src + frame.srcOffset, frame.srcSize);
+			if (ZSTD_isError(result) || result != frame.destSize)
+				failed = true;
+		}
+		ZSTD_freeDCtx(ctx);
+	});
+	return !failed;
+}
+
+PointerWrap::PointerWrap(std::vector<u8> *growBuffer, size_t sizeHint) : ptr(&growPtr_), mode(MODE_WRITE), growBuffer_(growBuffer) {
+	// Resizing within capacity only clears the new part, so a reused buffer is cheap.
+	growBuffer->resize(std::max(growBuffer->capacity(), sizeHint));
+	growPtr_ = growBuffer->data();
+	ptrStart_ = growPtr_;
+}
+
+void PointerWrap::Grow(size_t size) {
+	size_t offset = Offset();
+	growBuffer_->resize(std::max(growBuffer_->size() * 2, offset + size));
+	ptrStart_ = growBuffer_->data();
+	*ptr = ptrStart_ + offset;
+}
 
 void PointerWrap::RewindForWrite(u8 *writePtr) {
 	_assert_(mode == MODE_MEASURE);
@@ -66,6 +181,9 @@ PointerWrapSection PointerWrap::Section(const char *title, int minVer, int ver)
 
 	// Compare the measure and write passes. Sanity check to catch bugs, doesn't do anything for output.
 	size_t offset = Offset();
+	if (sectionLog_ && mode == MODE_WRITE) {
+		sectionLog_->emplace_back(marker, offset);
+	}
 	if (mode == MODE_MEASURE) {
 		checkpoints_.emplace_back(marker, offset);
 	} else if (mode == MODE_WRITE) {
@@ -83,7 +201,7 @@ PointerWrapSection PointerWrap::Section(const char *title, int minVer, int ver)
 				SetError(ERROR_FAILURE);
 				return PointerWrapSection(*this, -1, title);
 			}
-		} else {
+		} else if (!growBuffer_) {
 			WARN_LOG(SAVESTATE, "Writing savestate without checkpoints. This is OK but should be fixed.");
 		}
 		curCheckpoint_++;
@@ -126,6 +244,7 @@ void PointerWrap::SetError(Error error_) {
 }
 
 bool PointerWrap::ExpectVoid(void *data, int size) {
+	ReserveWrite(size);
 	switch (mode) {
 	case MODE_READ:	if (memcmp(data, *ptr, size) != 0) return false; break;
 	case MODE_WRITE: memcpy(*ptr, data, size); break;
@@ -141,6 +260,7 @@ bool PointerWrap::ExpectVoid(void *data, int size) {
 }
 
 void PointerWrap::DoVoid(void *data, int size) {
+	ReserveWrite(size);
 	switch (mode) {
 	case MODE_READ:	memcpy(data, *ptr, size); break;
 	case MODE_WRITE: memcpy(*ptr, data, size); break;
@@ -167,6 +287,7 @@ void Do(PointerWrap &p, std::string &x) {
 		return;
 	}
 
+	p.ReserveWrite(stringLen);
 	switch (p.mode) {
 	case PointerWrap::MODE_READ: x = (char*)*p.ptr; break;
 	case PointerWrap::MODE_WRITE: memcpy(*p.ptr, x.c_str(), stringLen); break;
@@ -195,6 +316,7 @@ void Do(PointerWrap &p, std::wstring &x) {
 		return r;
 	};
 
+	p.ReserveWrite(stringLen);
 	switch (p.mode) {
 	case PointerWrap::MODE_READ: x = read(); break;
 	case PointerWrap::MODE_WRITE: memcpy(*p.ptr, x.c_str(), stringLen); break;
@@ -223,6 +345,7 @@ void Do(PointerWrap &p, std::u16string &x) {
 		return r;
 	};
 
+	p.ReserveWrite(stringLen);
 	switch (p.mode) {
 	case PointerWrap::MODE_READ: x = read(); break;
 	case PointerWrap::MODE_WRITE: memcpy(*p.ptr, x.c_str(), stringLen); break;
@@ -373,11 +496,7 @@ CChunkFileReader::Error CChunkFileReader::LoadFile(const Path &filename, std::st
 			auto status = snappy_uncompress((const char *)buffer, sz, (char *)uncomp_buffer, &uncomp_size);
 			success = status == SNAPPY_OK;
 		} else if (SerializeCompressType(header.Compress) == SerializeCompressType::ZSTD) {
-			size_t status = ZSTD_decompress((char *)uncomp_buffer, uncomp_size, (const char *)buffer, sz);
-			success = !ZSTD_isError(status);
-			if (success) {
-				uncomp_size = status;
-			}
+			success = DecompressChunkedZstd(uncomp_buffer, uncomp_size, buffer, sz);
 		} else {
 			ERROR_LOG(SAVESTATE, "ChunkReader: Unexpected compression type %d", header.Compress);
 		}
@@ -409,6 +528,18 @@ CChunkFileReader::Error CChunkFileReader::LoadFile(const Path &filename, std::st
 	return ERROR_NONE;
 }
 
+size_t CChunkFileReader::CompressBound(size_t sz) {
+	return ZSTD_compressBound(std::min(sz, ZSTD_CHUNK_SIZE)) * std::max((size_t)1, (sz + ZSTD_CHUNK_SIZE - 1) / ZSTD_CHUNK_SIZE);
+}
+
+size_t CChunkFileReader::Compress(u8 *dest, size_t destSize, const u8 *src, size_t sz) {
+	return CompressChunkedZstd(dest, destSize, src, sz);
+}
+
+bool CChunkFileReader::Decompress(u8 *dest, size_t destSize, const u8 *src, size_t sz) {
+	return DecompressChunkedZstd(dest, destSize, src, sz);
+}
+
 // Takes ownership of buffer.
 CChunkFileReader::Error CChunkFileReader::SaveFile(const Path &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz) {
 	INFO_LOG(SAVESTATE, "ChunkReader: Writing %s", filename.c_str());
@@ -431,7 +562,7 @@ CChunkFileReader::Error CChunkFileReader::SaveFile(const Path &filename, const s
 		write_len = snappy_max_compressed_length(sz);
 		break;
 	case SerializeCompressType::ZSTD:
-		write_len = ZSTD_compressBound(sz);
+		write_len = CompressBound(sz);
 		break;
 	}
 	u8 *compressed_buffer = write_len == 0 ? nullptr : (u8 *)malloc(write_len);
@@ -452,20 +583,8 @@ CChunkFileReader::Error CChunkFileReader::SaveFile(const Path &filename, const s
 			success = snappy_compress((const char *)buffer, sz, (char *)compressed_buffer, &write_len) == SNAPPY_OK;
 			break;
 		case SerializeCompressType::ZSTD:
-			{
-				auto ctx = ZSTD_createCCtx();
-				if (!ctx) {
-					success = false;
-				} else {
-					// TODO: If free disk space is low, we could max this out to 22?
-					ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
-					ZSTD_CCtx_setParameter(ctx, ZSTD_c_checksumFlag, 1);
-					ZSTD_CCtx_setPledgedSrcSize(ctx, sz);
-					write_len = ZSTD_compress2(ctx, compressed_buffer, write_len, buffer, sz);
-					success = !ZSTD_isError(write_len);
-				}
-				ZSTD_freeCCtx(ctx);
-			}
+			write_len = CompressChunkedZstd(compressed_buffer, write_len, buffer, sz);
+			success = write_len != 0;
 			break;
 		}
 
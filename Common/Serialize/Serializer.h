@@ -120,6 +120,9 @@ class PointerWrap
 			checkpoints_.reserve(750);
 		}
 	}
+	// Writes into a buffer that grows as needed, so no measure pass is needed first.
+	// The buffer is left at its capacity plus sizeHint, use Offset() for the real size.
+	PointerWrap(std::vector<u8> *growBuffer, size_t sizeHint);
 
 	void RewindForWrite(u8 *writePtr);
 	bool CheckAfterWrite();
@@ -147,11 +150,25 @@ class PointerWrap
 
 	void DoMarker(const char *prevName, u32 arbitraryNumber = 0x42);
 
+	// Collects where each section starts while writing, for comparing states section by section.
+	void LogSections(std::vector<SerializeCheckpoint> *log) { sectionLog_ = log; }
+
+	// Must be called before writing size bytes directly to *ptr in MODE_WRITE.
+	void ReserveWrite(size_t size) {
+		if (growBuffer_ && mode == MODE_WRITE && growBuffer_->size() - Offset() < size)
+			Grow(size);
+	}
+
 	size_t Offset() const { return *ptr - ptrStart_; }
 
 private:
+	void Grow(size_t size);
+
 	const char *firstBadSectionTitle_ = nullptr;
 	u8 *ptrStart_;
+	std::vector<u8> *growBuffer_ = nullptr;
+	u8 *growPtr_ = nullptr;
+	std::vector<SerializeCheckpoint> *sectionLog_ = nullptr;
 	std::vector<SerializeCheckpoint> checkpoints_;
 	size_t curCheckpoint_ = 0;
 	size_t measuredSize_ = 0;
@@ -227,30 +244,24 @@ class CChunkFileReader
 		}
 	}
 
-	// Duplicate of the above but takes and modifies a vector. Less invasive
-	// than modifying the rewind manager to keep things in something else than vectors.
+	// Saves in a single pass, growing the vector as needed. Less invasive than modifying the
+	// rewind manager to keep things in something else than vectors.
+	// sizeHint avoids growing along the way for new buffers, for example the last state's size.
+	// If sections is set, it receives the start of each section.
 	template<class T>
-	static Error MeasureAndSavePtr(T &_class, std::vector<u8> *saved)
+	static Error SavePtr(T &_class, std::vector<u8> *saved, size_t sizeHint = 0, std::vector<SerializeCheckpoint> *sections = nullptr)
 	{
-		u8 *ptr = nullptr;
-		PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+		PointerWrap p(saved, sizeHint);
+		p.LogSections(sections);
 		_class.DoState(p);
-		_assert_(p.error == PointerWrap::ERROR_NONE);
-
-		size_t measuredSize = p.Offset();
-		saved->resize(measuredSize);
-		u8 *data = saved->data();
-		p.RewindForWrite(data);
-		_class.DoState(p);
-		if (p.CheckAfterWrite()) {
-			return ERROR_NONE;
-		} else {
+		if (p.error == PointerWrap::ERROR_FAILURE) {
 			saved->clear();
 			return ERROR_BROKEN_STATE;
 		}
+		saved->resize(p.Offset());
+		return ERROR_NONE;
 	}
 
-
 	// Load file template
 	template<class T>
 	static Error Load(const Path &filename, std::string *gitVersion, T& _class, std::string *failureReason)
@@ -310,6 +321,13 @@ class CChunkFileReader
 	}
 
 	static Error GetFileTitle(const Path &filename, std::string *title);
+	// Compresses and writes a buffer from MeasureAndSavePtr. Takes ownership of buffer (malloc/free).
+	static Error SaveFile(const Path &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz);
+
+	// The compression SaveFile uses, without the file. Compress returns 0 on failure.
+	static size_t CompressBound(size_t sz);
+	static size_t Compress(u8 *dest, size_t destSize, const u8 *src, size_t sz);
+	static bool Decompress(u8 *dest, size_t destSize, const u8 *src, size_t sz);
 
 private:
 	struct SChunkHeader
@@ -328,6 +346,5 @@ class CChunkFileReader
 	};
 
 	static Error LoadFile(const Path &filename, std::string *gitVersion, u8 *&buffer, size_t &sz, std::string *failureReason);
-	static Error SaveFile(const Path &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz);
 	static Error LoadFileHeader(File::IOFile &pFile, SChunkHeader &header, std::string *title);
 };
@@ -0,0 +1,207 @@
+#include "ppsspp_config.h"
+
+#if (PPSSPP_PLATFORM(ANDROID) || PPSSPP_PLATFORM(LINUX)) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+#if PPSSPP_PLATFORM(WINDOWS)
+#include "Common/CommonWindows.h"
+#elif PPSSPP_PLATFORM(ANDROID) || PPSSPP_PLATFORM(LINUX)
+#include <sched.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <pthread/qos.h>
+#endif
+
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Common/Log.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/CorePlacement.h"
+
+static std::mutex policyLock;
+static bool policyEnabled = false;
+static CoreTopology policyCores;
+// Bumped on each policy change, so threads know to reapply.
+static std::atomic<int> policyGeneration{ 0 };
+
+static thread_local bool threadHasRole = false;
+static thread_local ThreadRole threadRole = ThreadRole::COMPUTE_WORKER;
+static thread_local int threadGeneration = -1;
+static thread_local bool threadPlaced = false;
+
+std::vector<int> ParseCoreList(const std::string &list) {
+	std::vector<int> results;
+	std::vector<std::string> ranges;
+	SplitString(list, ',', ranges);
+	for (const std::string &range : ranges) {
+		int low = 0, high = 0;
+		int parts = sscanf(range.c_str(), "%d-%d", &low, &high);
+		if (parts <= 0)
+			continue;
+		if (parts == 1)
+			high = low;
+		for (int i = std::max(low, 0); i <= high && i < 1024; ++i)
+			results.push_back(i);
+	}
+	return results;
+}
+
+#if PPSSPP_PLATFORM(ANDROID) || PPSSPP_PLATFORM(LINUX)
+static int ReadCoreValue(int core, const char *name) {
+	std::string data;
+	if (!File::ReadFileToString(true, Path(StringFromFormat("/sys/devices/system/cpu/cpu%d/%s", core, name)), data))
+		return 0;
+	return atoi(data.c_str());
+}
+#endif
+
+static CoreTopology DetectCoreTopology() {
+	CoreTopology topology;
+#if PPSSPP_PLATFORM(ANDROID) || PPSSPP_PLATFORM(LINUX)
+	std::string present;
+	if (!File::ReadFileToString(true, Path("/sys/devices/system/cpu/present"), present))
+		return topology;
+
+	// cpu_capacity is what the kernel scheduler itself uses on ARM.  The max frequency is a decent fallback.
+	std::vector<std::pair<int, int>> capacities;
+	for (int core : ParseCoreList(present)) {
+		int capacity = ReadCoreValue(core, "cpu_capacity");
+		if (capacity <= 0)
+			capacity = ReadCoreValue(core, "cpufreq/cpuinfo_max_freq");
+		if (capacity <= 0)
+			return topology;
+		capacities.push_back(std::make_pair(core, capacity));
+	}
+	if (capacities.empty())
+		return topology;
+
+	// With three tiers (prime, big, little), only the lowest counts as efficiency cores.
+	int lowest = capacities[0].second;
+	for (const auto &c : capacities)
+		lowest = std::min(lowest, c.second);
+	for (const auto &c : capacities) {
+		if (c.second > lowest)
+			topology.performance.push_back(c.first);
+		else
+			topology.efficiency.push_back(c.first);
+	}
+	// All the same, nothing to choose between.
+	if (topology.performance.empty())
+		topology.efficiency.clear();
+#endif
+	return topology;
+}
+
+const CoreTopology &GetCoreTopology() {
+	static CoreTopology topology = DetectCoreTopology();
+	return topology;
+}
+
+void SetCorePlacementPolicy(bool enabled, const std::string &performanceCores, const std::string &efficiencyCores) {
+	const CoreTopology &detected = GetCoreTopology();
+
+	std::lock_guard<std::mutex> guard(policyLock);
+	policyEnabled = enabled;
+	policyCores.performance = performanceCores.empty() ? detected.performance : ParseCoreList(performanceCores);
+	policyCores.efficiency = efficiencyCores.empty() ? detected.efficiency : ParseCoreList(efficiencyCores);
+	policyGeneration++;
+
+	if (enabled) {
+		INFO_LOG(SYSTEM, "Core placement: %d performance cores, %d efficiency cores", (int)policyCores.performance.size(), (int)policyCores.efficiency.size());
+	}
+}
+
+// Empty means any core.
+static bool ApplyCores(const std::vector<int> &cores) {
+#if PPSSPP_PLATFORM(ANDROID) || PPSSPP_PLATFORM(LINUX)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (cores.empty()) {
+		long count = sysconf(_SC_NPROCESSORS_CONF);
+		for (long i = 0; i < count && i < CPU_SETSIZE; ++i)
+			CPU_SET(i, &set);
+	} else {
+		for (int core : cores) {
+			if (core < CPU_SETSIZE)
+				CPU_SET(core, &set);
+		}
+	}
+	// 0 means the calling thread here.
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif PPSSPP_PLATFORM(WINDOWS) && !PPSSPP_PLATFORM(UWP)
+	DWORD_PTR processMask = 0, systemMask = 0;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+		return false;
+	DWORD_PTR mask = 0;
+	for (int core : cores) {
+		if (core < (int)sizeof(mask) * 8)
+			mask |= (DWORD_PTR)1 << core;
+	}
+	mask &= processMask;
+	if (mask == 0)
+		mask = processMask;
+	return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+	return cores.empty();
+#endif
+}
+
+static void ApplyRole(ThreadRole role) {
+	bool enabled;
+	std::vector<int> cores;
+	{
+		std::lock_guard<std::mutex> guard(policyLock);
+		enabled = policyEnabled;
+		if (enabled && (role == ThreadRole::EMU || role == ThreadRole::RENDER)) {
+			cores = policyCores.performance;
+		} else if (enabled && role == ThreadRole::BACKGROUND && policyCores.IsHybrid()) {
+			// Only if there's both kinds, otherwise the emu thread might be left alone on the fast ones.
+			cores = policyCores.efficiency;
+		}
+	}
+
+	// Don't touch threads that were never placed, so the OS or other code keeps full control.
+	if (!enabled && !threadPlaced)
+		return;
+	threadPlaced = enabled;
+
+#if defined(__APPLE__)
+	// Apple doesn't allow affinity, but the QoS class decides between P and E cores.
+	qos_class_t qos = QOS_CLASS_DEFAULT;
+	if (enabled) {
+		if (role == ThreadRole::EMU || role == ThreadRole::RENDER)
+			qos = QOS_CLASS_USER_INTERACTIVE;
+		else if (role == ThreadRole::BACKGROUND)
+			qos = QOS_CLASS_UTILITY;
+	}
+	pthread_set_qos_class_self_np(qos, 0);
+#endif
+
+	if (!ApplyCores(cores)) {
+		WARN_LOG(SYSTEM, "Unable to set core placement for thread");
+	}
+}
+
+void SetCurrentThreadRole(ThreadRole role) {
+	threadHasRole = true;
+	threadRole = role;
+	threadGeneration = policyGeneration.load();
+	ApplyRole(role);
+}
+
+void UpdateCurrentThreadRole() {
+	if (!threadHasRole)
+		return;
+	int generation = policyGeneration.load(std::memory_order_relaxed);
+	if (generation == threadGeneration)
+		return;
+	threadGeneration = generation;
+	ApplyRole(threadRole);
+}
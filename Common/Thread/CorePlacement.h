@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Places threads on performance or efficiency cores, on CPUs that have both (big.LITTLE, hybrid.)
+// On CPUs with only one kind of core this does nothing unless cores are given explicitly.
+
+enum class ThreadRole {
+	// The emulation and render threads.  Prefer performance cores.
+	EMU,
+	RENDER,
+	// Parallel compute workers.  Left to the OS, since they want every core.
+	COMPUTE_WORKER,
+	// Shader compiles, texture replacement loading, general I/O.  Prefer efficiency cores.
+	BACKGROUND,
+};
+
+struct CoreTopology {
+	std::vector<int> performance;
+	std::vector<int> efficiency;
+
+	bool IsHybrid() const {
+		return !performance.empty() && !efficiency.empty();
+	}
+};
+
+// Detected once, from the OS.  Where not available, everything is empty.
+const CoreTopology &GetCoreTopology();
+
+// Core lists are like "0-3,6" and override the detected topology if not empty.
+// Threads that already set a role pick up the change before their next task or frame.
+void SetCorePlacementPolicy(bool enabled, const std::string &performanceCores, const std::string &efficiencyCores);
+
+// Call on the thread itself, usually right after SetCurrentThreadName.
+void SetCurrentThreadRole(ThreadRole role);
+// For long-lived threads to call now and then: reapplies the role if the policy changed.  Cheap.
+void UpdateCurrentThreadRole();
+
+std::vector<int> ParseCoreList(const std::string &list);
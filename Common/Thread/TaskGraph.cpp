@@ -0,0 +1,129 @@
+#include <chrono>
+
+#include "Common/Log.h"
+#include "Common/Thread/TaskGraph.h"
+
+struct TaskGraph::Node {
+	std::function<void()> func;
+	TaskType type;
+	TaskPriority priority;
+	// Unfinished dependencies, plus one while Add() is still wiring it up.
+	std::atomic<int> pending;
+	bool done = false;
+	std::vector<Node *> continuations;
+};
+
+class TaskGraphTask : public Task {
+public:
+	TaskGraphTask(TaskGraph *graph, TaskGraph::Node *node) : graph_(graph), node_(node) {}
+
+	TaskType Type() const override {
+		return node_->type;
+	}
+
+	TaskPriority Priority() const override {
+		return node_->priority;
+	}
+
+	void Run() override {
+		node_->func();
+		graph_->Complete(node_);
+	}
+
+private:
+	TaskGraph *graph_;
+	TaskGraph::Node *node_;
+};
+
+TaskGraph::~TaskGraph() {
+	Wait();
+	for (Node *node : nodes_)
+		delete node;
+}
+
+TaskGraph::Node *TaskGraph::Add(std::function<void()> func, std::initializer_list<Node *> deps, TaskType type, TaskPriority priority) {
+	return Add(func, std::vector<Node *>(deps), type, priority);
+}
+
+TaskGraph::Node *TaskGraph::Add(std::function<void()> func, const std::vector<Node *> &deps, TaskType type, TaskPriority priority) {
+	_assert_msg_(type != TaskType::DEDICATED_THREAD, "Task graph nodes can't use dedicated threads");
+
+	Node *node = new Node();
+	node->func = func;
+	node->type = type;
+	node->priority = priority;
+	node->pending = 1;
+	outstanding_++;
+
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		nodes_.push_back(node);
+		for (Node *dep : deps) {
+			if (dep->done)
+				continue;
+			node->pending++;
+			dep->continuations.push_back(node);
+		}
+	}
+
+	// Drop the hold, dependencies may all have finished already.
+	if (--node->pending == 0)
+		Schedule(node);
+	return node;
+}
+
+void TaskGraph::Schedule(Node *node) {
+	threadMan_->EnqueueTask(new TaskGraphTask(this, node));
+}
+
+void TaskGraph::Complete(Node *node) {
+	std::vector<Node *> ready;
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		node->done = true;
+		for (Node *next : node->continuations) {
+			if (--next->pending == 0)
+				ready.push_back(next);
+		}
+		node->continuations.clear();
+	}
+
+	for (Node *next : ready)
+		Schedule(next);
+
+	// Decrement under the lock, so a waiter can't miss the notify (or destroy us in between.)
+	std::lock_guard<std::mutex> guard(mutex_);
+	outstanding_--;
+	cond_.notify_all();
+}
+
+bool TaskGraph::IsDone(const Node *node) const {
+	std::lock_guard<std::mutex> guard(mutex_);
+	return node->done;
+}
+
+void TaskGraph::Wait() {
+	HelpWait([&] { return outstanding_ == 0; });
+}
+
+void TaskGraph::Wait(const Node *node) {
+	HelpWait([&] { return node->done; });
+}
+
+void TaskGraph::HelpWait(const std::function<bool()> &done) {
+	while (true) {
+		{
+			std::lock_guard<std::mutex> guard(mutex_);
+			if (done())
+				return;
+		}
+
+		// Might be one of ours, or someone else's.  Either way it gets us closer to done.
+		if (threadMan_->RunPendingTask(TaskType::CPU_COMPUTE))
+			continue;
+
+		// Nothing to help with right now.  Wake up now and then, in case continuations get queued.
+		std::unique_lock<std::mutex> lock(mutex_);
+		cond_.wait_for(lock, std::chrono::milliseconds(1), done);
+	}
+}
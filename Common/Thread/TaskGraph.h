@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
+
+#include "Common/Thread/ThreadManager.h"
+
+// Runs functions on the ThreadManager once the nodes they depend on have finished, without
+// blocking any worker in between.  Continuations can be added while the graph is running, by
+// depending on nodes that were added earlier.
+//
+//   TaskGraph graph(&g_threadManager);
+//   TaskGraph::Node *decode = graph.Add([&] { Decode(); });
+//   TaskGraph::Node *scale = graph.Add([&] { Scale(); }, { decode });
+//   graph.Add([&] { Upload(); }, { scale }, TaskType::IO_BLOCKING);
+//   graph.Wait();
+//
+// Wait() runs other queued compute tasks while waiting, rather than just sleeping.
+class TaskGraph {
+public:
+	struct Node;
+
+	TaskGraph(ThreadManager *threadMan) : threadMan_(threadMan) {}
+	// Waits for anything still running.
+	~TaskGraph();
+
+	// Enqueued immediately if the dependencies are already done.  Dependencies must be nodes of this graph.
+	Node *Add(std::function<void()> func, std::initializer_list<Node *> deps = {}, TaskType type = TaskType::CPU_COMPUTE, TaskPriority priority = TaskPriority::NORMAL);
+	Node *Add(std::function<void()> func, const std::vector<Node *> &deps, TaskType type = TaskType::CPU_COMPUTE, TaskPriority priority = TaskPriority::NORMAL);
+
+	bool IsDone(const Node *node) const;
+	bool IsDone() const {
+		return outstanding_ == 0;
+	}
+
+	// Waits for all nodes added so far (and any continuations they add.)
+	void Wait();
+	// Same, but only until this node is done.
+	void Wait(const Node *node);
+
+private:
+	friend class TaskGraphTask;
+
+	void Schedule(Node *node);
+	void Complete(Node *node);
+	void HelpWait(const std::function<bool()> &done);
+
+	ThreadManager *threadMan_;
+	std::atomic<int> outstanding_{ 0 };
+
+	// Protects nodes_ and each node's continuations, and signals completions.
+	mutable std::mutex mutex_;
+	std::condition_variable cond_;
+	std::vector<Node *> nodes_;
+};
@@ -8,6 +8,7 @@
 #include <atomic>
 
 #include "Common/Log.h"
+#include "Common/Thread/CorePlacement.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/Thread/ThreadManager.h"
 
@@ -19,37 +20,124 @@
 //   They should always be scheduled to the first N threads.
 // * For some tasks, splitting the input values up linearly between the threads
 //   is not fair. However, we ignore that for now.
+// * There's no global queue. Each worker has its own work-stealing deques for tasks it enqueues
+//   itself, and locked queues for tasks from other threads. Idle workers steal from others of the
+//   same type, spin for a bit, and then park until woken by an enqueue.
 
 const int MAX_CORES_TO_USE = 16;
 const int MIN_IO_BLOCKING_THREADS = 4;
 static constexpr size_t TASK_PRIORITY_COUNT = (size_t)TaskPriority::COUNT;
+// How many times an idle worker looks for work to steal before it parks.
+static constexpr int IDLE_SPIN_COUNT = 64;
+
+// Chase-Lev work stealing deque (with the memory orderings from Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models".)  Only the owning worker may Push() and Pop() at the bottom,
+// any thread may Steal() from the top.  Fixed capacity - Push() fails when full and the caller
+// falls back to a locked queue, which avoids having to reclaim grown buffers.
+struct WorkStealingDeque {
+	static constexpr int64_t CAPACITY = 256;
+	static constexpr int64_t MASK = CAPACITY - 1;
+
+	WorkStealingDeque() {
+		for (auto &slot : buffer)
+			slot.store(nullptr, std::memory_order_relaxed);
+	}
+
+	bool Push(Task *task) {
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		int64_t t = top.load(std::memory_order_acquire);
+		if (b - t >= CAPACITY)
+			return false;
+		buffer[b & MASK].store(task, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	Task *Pop() {
+		int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_relaxed);
+		if (t > b) {
+			// Was empty.
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Task *task = buffer[b & MASK].load(std::memory_order_relaxed);
+		if (t == b) {
+			// Last one, race any thieves for it.
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				task = nullptr;
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return task;
+	}
+
+	// Can spuriously return nullptr if another thief won the race.
+	Task *Steal() {
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = bottom.load(std::memory_order_acquire);
+		if (t >= b)
+			return nullptr;
+
+		Task *task = buffer[t & MASK].load(std::memory_order_relaxed);
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+		return task;
+	}
+
+	bool MaybeHasWork() const {
+		return top.load(std::memory_order_acquire) < bottom.load(std::memory_order_acquire);
+	}
+
+	std::atomic<int64_t> top{ 0 };
+	std::atomic<int64_t> bottom{ 0 };
+	std::atomic<Task *> buffer[CAPACITY];
+};
+static_assert((WorkStealingDeque::CAPACITY & WorkStealingDeque::MASK) == 0, "Deque capacity must be a power of 2");
 
 struct GlobalThreadContext {
-	std::mutex mutex; // associated with each respective condition variable
-	std::deque<Task *> compute_queue[TASK_PRIORITY_COUNT];
-	std::atomic<int> compute_queue_size;
-	std::deque<Task *> io_queue[TASK_PRIORITY_COUNT];
-	std::atomic<int> io_queue_size;
 	std::vector<ThreadContext *> threads_;
 
+	// Tasks that couldn't be cancelled at teardown, scheduled again on the next Init.
+	std::mutex leftoverMutex;
+	std::vector<Task *> leftover;
+
 	std::atomic<int> roundRobin;
 };
 
 struct ThreadContext {
+	GlobalThreadContext *global;
 	std::thread thread; // the worker thread
-	std::condition_variable cond; // used to signal new work
-	std::mutex mutex; // protects the local queue.
-	std::atomic<int> queue_size;
+	std::condition_variable cond; // used to wake the thread when parked
+	std::mutex mutex; // associated with cond.
+	std::atomic<bool> parked;
 	int index;
 	TaskType type;
 	std::atomic<bool> cancelled;
+	uint32_t stealSeed;
+
+	// Tasks enqueued by this worker itself, which others can steal.
+	WorkStealingDeque deque[TASK_PRIORITY_COUNT];
+
+	// Protects the queues below, which are filled by other threads.
+	std::mutex queueMutex;
+	// Anyone of the right type can take these.
+	std::deque<Task *> shared_queue[TASK_PRIORITY_COUNT];
+	std::atomic<int> shared_size;
+	// From EnqueueTaskOnThread, never stolen.
 	std::deque<Task *> private_queue[TASK_PRIORITY_COUNT];
+	std::atomic<int> private_size;
+
 	char name[16];
 };
 
+static thread_local ThreadContext *tlsCurrentWorker;
+
 ThreadManager::ThreadManager() : global_(new GlobalThreadContext()) {
-	global_->compute_queue_size = 0;
-	global_->io_queue_size = 0;
 	global_->roundRobin = 0;
 }
 
@@ -64,32 +152,20 @@ void ThreadManager::Teardown() {
 		threadCtx->cond.notify_one();
 	}
 
-	// Purge any cancellable tasks while the threads shut down.
-	if (global_->compute_queue_size > 0 || global_->io_queue_size > 0) {
-		auto drainQueue = [&](std::deque<Task *> queue[TASK_PRIORITY_COUNT], std::atomic<int> &size) {
-			for (size_t i = 0; i < TASK_PRIORITY_COUNT; ++i) {
-				for (auto it = queue[i].begin(); it != queue[i].end(); ++it) {
-					if (TeardownTask(*it, false)) {
-						queue[i].erase(it);
-						size--;
-						return false;
-					}
-				}
-			}
-			return true;
-		};
-
-		std::unique_lock<std::mutex> lock(global_->mutex);
-		while (!drainQueue(global_->compute_queue, global_->compute_queue_size))
-			continue;
-		while (!drainQueue(global_->io_queue, global_->io_queue_size))
-			continue;
+	for (ThreadContext *&threadCtx : global_->threads_) {
+		threadCtx->thread.join();
 	}
 
+	// Now that nothing is running, purge any cancellable tasks and keep the rest.
 	for (ThreadContext *&threadCtx : global_->threads_) {
-		threadCtx->thread.join();
-		// TODO: Is it better to just delete these?
 		for (size_t i = 0; i < TASK_PRIORITY_COUNT; ++i) {
+			// Safe to pop from here, the owner is gone.
+			while (Task *task = threadCtx->deque[i].Pop()) {
+				TeardownTask(task, true);
+			}
+			for (Task *task : threadCtx->shared_queue[i]) {
+				TeardownTask(task, true);
+			}
 			for (Task *task : threadCtx->private_queue[i]) {
 				TeardownTask(task, true);
 			}
@@ -98,7 +174,8 @@ void ThreadManager::Teardown() {
 	}
 	global_->threads_.clear();
 
-	if (global_->compute_queue_size > 0 || global_->io_queue_size > 0) {
+	std::lock_guard<std::mutex> guard(global_->leftoverMutex);
+	if (!global_->leftover.empty()) {
 		WARN_LOG(SYSTEM, "ThreadManager::Teardown() with tasks still enqueued");
 	}
 }
@@ -114,21 +191,120 @@ bool ThreadManager::TeardownTask(Task *task, bool enqueue) {
 	}
 
 	if (enqueue) {
-		size_t queueIndex = (size_t)task->Priority();
-		if (task->Type() == TaskType::CPU_COMPUTE) {
-			global_->compute_queue[queueIndex].push_back(task);
-			global_->compute_queue_size++;
-		} else if (task->Type() == TaskType::IO_BLOCKING) {
-			global_->io_queue[queueIndex].push_back(task);
-			global_->io_queue_size++;
-		} else {
-			_assert_(false);
+		_assert_(task->Type() == TaskType::CPU_COMPUTE || task->Type() == TaskType::IO_BLOCKING);
+		std::lock_guard<std::mutex> guard(global_->leftoverMutex);
+		global_->leftover.push_back(task);
+	}
+	return false;
+}
+
+static bool TryWakeThread(ThreadContext *thread) {
+	// Whoever flips parked gets to wake it, so each park is only woken once.
+	bool expected = true;
+	if (!thread->parked.compare_exchange_strong(expected, false))
+		return false;
+
+	std::unique_lock<std::mutex> lock(thread->mutex);
+	thread->cond.notify_one();
+	return true;
+}
+
+static void WakeIdleThread(GlobalThreadContext *global, int minThread, int maxThread) {
+	int count = maxThread - minThread;
+	int start = (global->roundRobin++) % count;
+	for (int i = 0; i < count; ++i) {
+		ThreadContext *thread = global->threads_[minThread + (start + i) % count];
+		if (thread->parked.load() && TryWakeThread(thread))
+			return;
+	}
+}
+
+static void GetThreadRange(const GlobalThreadContext *global, TaskType type, int numComputeThreads, int *minThread, int *maxThread) {
+	if (type == TaskType::CPU_COMPUTE) {
+		// only the threads reserved for heavy compute.
+		*minThread = 0;
+		*maxThread = numComputeThreads;
+	} else {
+		// Only IO blocking threads (to avoid starving compute threads.)
+		*minThread = numComputeThreads;
+		*maxThread = (int)global->threads_.size();
+	}
+}
+
+static Task *PopLockedQueue(ThreadContext *thread, std::deque<Task *> &queue, std::atomic<int> &size, bool tryOnly) {
+	std::unique_lock<std::mutex> lock(thread->queueMutex, std::defer_lock);
+	if (tryOnly) {
+		if (!lock.try_lock())
+			return nullptr;
+	} else {
+		lock.lock();
+	}
+	if (queue.empty())
+		return nullptr;
+	Task *task = queue.front();
+	queue.pop_front();
+	size--;
+	return task;
+}
+
+static Task *StealTask(GlobalThreadContext *global, const ThreadContext *thief, size_t p, int minThread, int maxThread, int start) {
+	int count = maxThread - minThread;
+	for (int i = 0; i < count; ++i) {
+		ThreadContext *victim = global->threads_[minThread + (start + i) % count];
+		if (victim == thief)
+			continue;
+		Task *task = victim->deque[p].Steal();
+		if (!task && victim->shared_size.load() != 0)
+			task = PopLockedQueue(victim, victim->shared_queue[p], victim->shared_size, true);
+		if (task)
+			return task;
+	}
+	return nullptr;
+}
+
+static Task *FindTask(GlobalThreadContext *global, ThreadContext *thread, int minThread, int maxThread) {
+	int count = maxThread - minThread;
+	// Randomize where we start stealing, so thieves don't all pile onto the same victim.
+	thread->stealSeed ^= thread->stealSeed << 13;
+	thread->stealSeed ^= thread->stealSeed >> 17;
+	thread->stealSeed ^= thread->stealSeed << 5;
+	int start = (int)(thread->stealSeed % (uint32_t)count);
+
+	// Higher priorities first, even if they have to be stolen.
+	for (size_t p = 0; p < TASK_PRIORITY_COUNT; ++p) {
+		Task *task = nullptr;
+		if (thread->private_size.load() != 0)
+			task = PopLockedQueue(thread, thread->private_queue[p], thread->private_size, false);
+		if (!task)
+			task = thread->deque[p].Pop();
+		if (!task && thread->shared_size.load() != 0)
+			task = PopLockedQueue(thread, thread->shared_queue[p], thread->shared_size, false);
+
+		if (!task)
+			task = StealTask(global, thread, p, minThread, maxThread, start);
+		if (task)
+			return task;
+	}
+	return nullptr;
+}
+
+// Unlike FindTask, doesn't take anything or give up on contention.  Used to check before parking.
+static bool HasAvailableWork(GlobalThreadContext *global, ThreadContext *thread, int minThread, int maxThread) {
+	if (thread->private_size.load() != 0)
+		return true;
+	for (int i = minThread; i < maxThread; ++i) {
+		ThreadContext *other = global->threads_[i];
+		if (other->shared_size.load() != 0)
+			return true;
+		for (size_t p = 0; p < TASK_PRIORITY_COUNT; ++p) {
+			if (other->deque[p].MaybeHasWork())
+				return true;
 		}
 	}
 	return false;
 }
 
-static void WorkerThreadFunc(GlobalThreadContext *global, ThreadContext *thread) {
+static void WorkerThreadFunc(GlobalThreadContext *global, ThreadContext *thread, int minThread, int maxThread) {
 	if (thread->type == TaskType::CPU_COMPUTE) {
 		snprintf(thread->name, sizeof(thread->name), "PoolWorker %d", thread->index);
 	} else {
@@ -136,78 +312,56 @@ static void WorkerThreadFunc(GlobalThreadContext *global, ThreadContext *thread)
 		snprintf(thread->name, sizeof(thread->name), "PoolWorkerIO %d", thread->index);
 	}
 	SetCurrentThreadName(thread->name);
+	SetCurrentThreadRole(thread->type == TaskType::CPU_COMPUTE ? ThreadRole::COMPUTE_WORKER : ThreadRole::BACKGROUND);
+	tlsCurrentWorker = thread;
 
 	if (thread->type == TaskType::IO_BLOCKING) {
 		AttachThreadToJNI();
 	}
 
-	const bool isCompute = thread->type == TaskType::CPU_COMPUTE;
-	const auto global_queue_size = [isCompute, &global]() -> int {
-		return isCompute ? global->compute_queue_size.load() : global->io_queue_size.load();
-	};
-
+	int idleCount = 0;
 	while (!thread->cancelled) {
-		Task *task = nullptr;
-
-		// Check the global queue first, then check the private queue and wait if there's nothing to do.
-		if (global_queue_size() > 0) {
-			// Grab one from the global queue if there is any.
-			std::unique_lock<std::mutex> lock(global->mutex);
-			auto queue = isCompute ? global->compute_queue : global->io_queue;
-			auto &queue_size = isCompute ? global->compute_queue_size : global->io_queue_size;
-
-			for (size_t p = 0; p < TASK_PRIORITY_COUNT; ++p) {
-				if (!queue[p].empty()) {
-					task = queue[p].front();
-					queue[p].pop_front();
-					queue_size--;
-
-					// We are processing one now, so mark that.
-					thread->queue_size++;
-				} else if (thread->queue_size != 0) {
-					// Check the thread, as we prefer a HIGH thread task to a global NORMAL task.
-					std::unique_lock<std::mutex> lock(thread->mutex);
-					if (!thread->private_queue[p].empty()) {
-						task = thread->private_queue[p].front();
-						thread->private_queue[p].pop_front();
-					}
-				}
-			}
-		}
-
-		if (!task) {
-			// We didn't have any global, do we have anything on the thread?
-			std::unique_lock<std::mutex> lock(thread->mutex);
-			for (size_t p = 0; p < TASK_PRIORITY_COUNT; ++p) {
-				if (thread->private_queue[p].empty())
-					continue;
-
-				task = thread->private_queue[p].front();
-				thread->private_queue[p].pop_front();
-				break;
-			}
+		Task *task = FindTask(global, thread, minThread, maxThread);
 
-			// We must check both queue and single again, while locked.
-			bool wait = !thread->cancelled && !task && global_queue_size() == 0;
-
-			if (wait)
-				thread->cond.wait(lock);
-		}
 		// The task itself takes care of notifying anyone waiting on it. Not the
 		// responsibility of the ThreadManager (although it could be!).
 		if (task) {
+			// The pool is usually started before the config is loaded.
+			UpdateCurrentThreadRole();
 			task->Run();
 			task->Release();
+			idleCount = 0;
+			continue;
+		}
 
-			// Reduce the queue size once complete.
-			thread->queue_size--;
+		// Spin a little first, for workloads that enqueue lots of small tasks back to back.
+		if (++idleCount < IDLE_SPIN_COUNT) {
+			std::this_thread::yield();
+			continue;
+		}
+		idleCount = 0;
+
+		// Mark ourselves parked before checking again, so an enqueue either sees us parked or we see its task.
+		thread->parked = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (thread->cancelled || HasAvailableWork(global, thread, minThread, maxThread)) {
+			bool expected = true;
+			thread->parked.compare_exchange_strong(expected, false);
+			continue;
 		}
+
+		std::unique_lock<std::mutex> lock(thread->mutex);
+		thread->cond.wait(lock, [&] {
+			return !thread->parked.load() || thread->cancelled.load();
+		});
+		thread->parked = false;
 	}
 
 	// In case it got attached to JNI, detach it. Don't think this has any side effects if called redundantly.
 	if (thread->type == TaskType::IO_BLOCKING) {
 		DetachThreadFromJNI();
 	}
+	tlsCurrentWorker = nullptr;
 }
 
 void ThreadManager::Init(int numRealCores, int numLogicalCoresPerCpu) {
@@ -222,14 +376,33 @@ void ThreadManager::Init(int numRealCores, int numLogicalCoresPerCpu) {
 
 	INFO_LOG(SYSTEM, "ThreadManager::Init(compute threads: %d, all: %d)", numComputeThreads_, numThreads_);
 
+	// Create all contexts first, since workers steal from each other.
 	for (int i = 0; i < numThreads; i++) {
 		ThreadContext *thread = new ThreadContext();
+		thread->global = global_;
 		thread->cancelled.store(false);
+		thread->parked.store(false);
+		thread->shared_size.store(0);
+		thread->private_size.store(0);
 		thread->type = i < numComputeThreads_ ? TaskType::CPU_COMPUTE : TaskType::IO_BLOCKING;
 		thread->index = i;
-		thread->thread = std::thread(&WorkerThreadFunc, global_, thread);
+		thread->stealSeed = 0x9E3779B9U * (uint32_t)(i + 1);
 		global_->threads_.push_back(thread);
 	}
+	for (ThreadContext *thread : global_->threads_) {
+		int minThread, maxThread;
+		GetThreadRange(global_, thread->type, numComputeThreads_, &minThread, &maxThread);
+		thread->thread = std::thread(&WorkerThreadFunc, global_, thread, minThread, maxThread);
+	}
+
+	std::vector<Task *> leftover;
+	{
+		std::lock_guard<std::mutex> guard(global_->leftoverMutex);
+		leftover.swap(global_->leftover);
+	}
+	for (Task *task : leftover) {
+		EnqueueTask(task);
+	}
 }
 
 void ThreadManager::EnqueueTask(Task *task) {
@@ -248,52 +421,41 @@ void ThreadManager::EnqueueTask(Task *task) {
 	size_t queueIndex = (size_t)task->Priority();
 	int minThread;
 	int maxThread;
-	if (task->Type() == TaskType::CPU_COMPUTE) {
-		// only the threads reserved for heavy compute.
-		minThread = 0;
-		maxThread = numComputeThreads_;
-	} else {
-		// Only IO blocking threads (to avoid starving compute threads.)
-		minThread = numComputeThreads_;
-		maxThread = numThreads_;
-	}
-
-	// Find a thread with no outstanding work.
+	GetThreadRange(global_, task->Type(), numComputeThreads_, &minThread, &maxThread);
 	_assert_(maxThread <= (int)global_->threads_.size());
-	for (int threadNum = minThread; threadNum < maxThread; threadNum++) {
-		ThreadContext *thread = global_->threads_[threadNum];
-		if (thread->queue_size.load() == 0) {
-			std::unique_lock<std::mutex> lock(thread->mutex);
-			thread->private_queue[queueIndex].push_back(task);
-			thread->queue_size++;
-			thread->cond.notify_one();
-			// Found it - done.
+
+	// From a worker of the same type, keep it local without any locking.  Idle workers will steal it.
+	ThreadContext *current = tlsCurrentWorker;
+	if (current && current->global == global_ && current->type == task->Type()) {
+		if (current->deque[queueIndex].Push(task)) {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			WakeIdleThread(global_, minThread, maxThread);
 			return;
 		}
 	}
 
-	// Still not scheduled? Put it on the global queue and notify a thread chosen by round-robin.
-	// Not particularly scientific, but hopefully we should not run into this too much.
-	{
-		std::unique_lock<std::mutex> lock(global_->mutex);
-		if (task->Type() == TaskType::CPU_COMPUTE) {
-			global_->compute_queue[queueIndex].push_back(task);
-			global_->compute_queue_size++;
-		} else if (task->Type() == TaskType::IO_BLOCKING) {
-			global_->io_queue[queueIndex].push_back(task);
-			global_->io_queue_size++;
-		} else {
-			_assert_(false);
+	// Prefer a thread that has nothing to do.  Otherwise pick by round-robin, anyone idle will steal it anyway.
+	int count = maxThread - minThread;
+	int start = (global_->roundRobin++) % count;
+	ThreadContext *target = global_->threads_[minThread + start];
+	for (int i = 0; i < count; ++i) {
+		ThreadContext *thread = global_->threads_[minThread + (start + i) % count];
+		if (thread->parked.load()) {
+			target = thread;
+			break;
 		}
 	}
 
-	int chosenIndex = global_->roundRobin++;
-	chosenIndex = minThread + (chosenIndex % (maxThread - minThread));
-	ThreadContext *&chosenThread = global_->threads_[chosenIndex];
+	{
+		std::lock_guard<std::mutex> guard(target->queueMutex);
+		target->shared_queue[queueIndex].push_back(task);
+		target->shared_size++;
+	}
 
-	// Lock the thread to ensure it gets the message.
-	std::unique_lock<std::mutex> lock(chosenThread->mutex);
-	chosenThread->cond.notify_one();
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!TryWakeThread(target)) {
+		WakeIdleThread(global_, minThread, maxThread);
+	}
 }
 
 void ThreadManager::EnqueueTaskOnThread(int threadNum, Task *task) {
@@ -303,11 +465,41 @@ void ThreadManager::EnqueueTaskOnThread(int threadNum, Task *task) {
 	ThreadContext *thread = global_->threads_[threadNum];
 	size_t queueIndex = (size_t)task->Priority();
 
-	thread->queue_size++;
+	{
+		std::lock_guard<std::mutex> guard(thread->queueMutex);
+		thread->private_queue[queueIndex].push_back(task);
+		thread->private_size++;
+	}
 
-	std::unique_lock<std::mutex> lock(thread->mutex);
-	thread->private_queue[queueIndex].push_back(task);
-	thread->cond.notify_one();
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	TryWakeThread(thread);
+}
+
+bool ThreadManager::RunPendingTask(TaskType type) {
+	_assert_msg_(type != TaskType::DEDICATED_THREAD, "Dedicated thread tasks are never queued");
+	if (!IsInitialized())
+		return false;
+
+	int minThread;
+	int maxThread;
+	GetThreadRange(global_, type, numComputeThreads_, &minThread, &maxThread);
+
+	Task *task = nullptr;
+	ThreadContext *current = tlsCurrentWorker;
+	if (current && current->global == global_ && current->type == type) {
+		// A worker waiting inside a task, it can take from its own queues too.
+		task = FindTask(global_, current, minThread, maxThread);
+	} else {
+		int start = (global_->roundRobin++) % (maxThread - minThread);
+		for (size_t p = 0; p < TASK_PRIORITY_COUNT && !task; ++p)
+			task = StealTask(global_, nullptr, p, minThread, maxThread, start);
+	}
+
+	if (!task)
+		return false;
+	task->Run();
+	task->Release();
+	return true;
 }
 
 int ThreadManager::GetNumLooperThreads() const {
@@ -61,6 +61,10 @@ class ThreadManager {
 	void EnqueueTaskOnThread(int threadNum, Task *task);
 	void Teardown();
 
+	// Runs one queued task of this type on the calling thread, if there's one that can be taken.
+	// For waits to help out instead of blocking.  Tasks pinned with EnqueueTaskOnThread are never taken.
+	bool RunPendingTask(TaskType type);
+
 	bool IsInitialized() const;
 
 	// Currently does nothing. It will always be best-effort - maybe it cancels,
@@ -62,6 +62,8 @@ void AsyncImageFileView::SetFilename(const Path &filename) {
 		textureFailed_ = false;
 		filename_ = filename;
 		texture_.reset(nullptr);
+		textureLoaded_ = false;
+		UI::InvalidateLayout();
 	}
 }
 
@@ -87,8 +89,15 @@ void AsyncImageFileView::Draw(UIContext &dc) {
 		dc.FillRect(dc.theme->itemFocusedStyle.background, bounds_.Expand(3));
 	}
 
+	// The texture loads in the background, and our size depends on it.
+	bool loaded = texture_ && texture_->GetTexture();
+	if (loaded != textureLoaded_) {
+		textureLoaded_ = loaded;
+		UI::InvalidateLayout();
+	}
+
 	// TODO: involve sizemode
-	if (texture_ && texture_->GetTexture()) {
+	if (loaded) {
 		dc.Flush();
 		dc.GetDrawContext()->BindTexture(0, texture_->GetTexture());
 		dc.Draw()->Rect(bounds_.x, bounds_.y, bounds_.w, bounds_.h, color_);
@@ -39,6 +39,7 @@ class AsyncImageFileView : public UI::Clickable {
 
 	std::unique_ptr<ManagedTexture> texture_;
 	bool textureFailed_;
+	bool textureLoaded_ = false;
 	float fixedSizeW_;
 	float fixedSizeH_;
 };
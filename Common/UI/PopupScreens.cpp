@@ -114,11 +114,17 @@ void PopupMultiChoice::UpdateText() {
 	if (!choices_)
 		return;
 	auto category = GetI18NCategory(category_);
+	std::string text;
 	// Clamp the value to be safe.
 	if (*value_ < minVal_ || *value_ > minVal_ + numChoices_ - 1) {
-		valueText_ = "(invalid choice)";  // Shouldn't happen. Should be no need to translate this.
+		text = "(invalid choice)";  // Shouldn't happen. Should be no need to translate this.
 	} else {
-		valueText_ = category ? category->T(choices_[*value_ - minVal_]) : choices_[*value_ - minVal_];
+		text = category ? category->T(choices_[*value_ - minVal_]) : choices_[*value_ - minVal_];
+	}
+	// This runs every frame, so only relayout on actual changes.
+	if (text != valueText_) {
+		valueText_ = text;
+		InvalidateLayout();
 	}
 }
 
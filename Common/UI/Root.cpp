@@ -24,6 +24,9 @@ static std::mutex eventMutex_;
 static std::function<void(UISound)> soundCallback;
 static bool soundEnabled = true;
 
+// Starts above zero, so new roots always get laid out once.
+static std::atomic<uint32_t> layoutGeneration{ 1 };
+
 struct DispatchQueueItem {
 	Event *e;
 	EventParams params;
@@ -54,6 +57,8 @@ void DispatchEvents() {
 		}
 		if (item.e) {
 			item.e->Dispatch(item.params);
+			// Handlers can change almost anything.
+			InvalidateLayout();
 		}
 	}
 }
@@ -88,7 +93,12 @@ View *GetFocusedView() {
 	return focusedView;
 }
 
+void InvalidateLayout() {
+	layoutGeneration++;
+}
+
 void SetFocusedView(View *view, bool force) {
+	InvalidateLayout();
 	if (focusedView) {
 		focusedView->FocusChanged(FF_LOSTFOCUS);
 	}
@@ -123,6 +133,14 @@ void LayoutViewHierarchy(const UIContext &dc, ViewGroup *root, bool ignoreInsets
 
 	Bounds rootBounds = ignoreInsets ? dc.GetBounds() : dc.GetLayoutBounds();
 
+	// Most frames on menus nothing changes at all, so reuse the previous layout then.
+	// Read the generation first, so anything invalidated during layout is caught next frame.
+	uint32_t generation = layoutGeneration;
+	const Bounds &prevBounds = root->rootLayoutBounds_;
+	if (root->rootLayoutGeneration_ == generation && prevBounds.x == rootBounds.x && prevBounds.y == rootBounds.y && prevBounds.w == rootBounds.w && prevBounds.h == rootBounds.h) {
+		return;
+	}
+
 	MeasureSpec horiz(EXACTLY, rootBounds.w);
 	MeasureSpec vert(EXACTLY, rootBounds.h);
 
@@ -131,6 +149,9 @@ void LayoutViewHierarchy(const UIContext &dc, ViewGroup *root, bool ignoreInsets
 	// Root has a specified size. Set it, then let root layout all its children.
 	root->SetBounds(rootBounds);
 	root->Layout();
+
+	root->rootLayoutGeneration_ = generation;
+	root->rootLayoutBounds_ = rootBounds;
 }
 
 void MoveFocus(ViewGroup *root, FocusDirection direction) {
@@ -242,6 +263,7 @@ bool KeyEvent(const KeyInput &key, ViewGroup *root) {
 	}
 
 	retval = root->Key(key);
+	InvalidateLayout();
 
 	// Ignore volume keys and stuff here. Not elegant but need to propagate bools through the view hierarchy as well...
 	switch (key.keyCode) {
@@ -282,6 +304,7 @@ static void ProcessHeldKeys(ViewGroup *root) {
 }
 
 bool TouchEvent(const TouchInput &touch, ViewGroup *root) {
+	InvalidateLayout();
 	focusForced = false;
 	root->Touch(touch);
 	if ((touch.flags & TOUCH_DOWN) && !focusForced) {
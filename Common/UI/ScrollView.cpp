@@ -487,6 +487,10 @@ void ScrollView::Update() {
 	if (rememberPos_ && ClampedScrollPos(scrollPos_) != ClampedScrollPos(*rememberPos_)) {
 		*rememberPos_ = scrollPos_;
 	}
+
+	// Layout positions the contents, so it needs to run again while scrolling.
+	if (ClampedScrollPos(scrollPos_) != layoutScrollPos_)
+		InvalidateLayout();
 }
 
 ListView::ListView(ListAdaptor *a, std::set<int> hidden, LayoutParams *layoutParams)
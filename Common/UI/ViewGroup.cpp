@@ -53,6 +53,7 @@ void ViewGroup::RemoveSubview(View *view) {
 		if (views_[i] == view) {
 			views_.erase(views_.begin() + i);
 			delete view;
+			InvalidateLayout();
 			return;
 		}
 	}
@@ -73,6 +74,7 @@ void ViewGroup::Clear() {
 		views_[i] = nullptr;
 	}
 	views_.clear();
+	InvalidateLayout();
 }
 
 void ViewGroup::PersistData(PersistStatus status, std::string anonId, PersistMap &storage) {
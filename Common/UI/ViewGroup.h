@@ -48,6 +48,7 @@ class ViewGroup : public View {
 	T *Add(T *view) {
 		std::lock_guard<std::mutex> guard(modifyLock_);
 		views_.push_back(view);
+		InvalidateLayout();
 		return view;
 	}
 
@@ -97,6 +98,13 @@ class ViewGroup : public View {
 	bool clickableBackground_ = false;
 	bool clip_ = false;
 	bool exclusiveTouch_ = false;
+
+private:
+	friend void LayoutViewHierarchy(const UIContext &dc, ViewGroup *root, bool ignoreInsets);
+
+	// What this was last laid out for, when used as a root.
+	uint32_t rootLayoutGeneration_ = 0;
+	Bounds rootLayoutBounds_{};
 };
 
 // A frame layout contains a single child view (normally).
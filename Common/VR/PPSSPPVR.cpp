@@ -4,6 +4,7 @@
 #if XR_USE_GRAPHICS_API_OPENGL || XR_USE_GRAPHICS_API_OPENGL_ES
 #include "Common/GPU/OpenGL/GLRenderManager.h"
 #endif
+#include "Common/GPU/OpenGL/GLFeatures.h"
 
 #include "Common/VR/VRInput.h"
 #include "Common/VR/VRMath.h"
@@ -808,7 +809,14 @@ int GetVRPassesCount() {
 }
 
 bool IsMultiviewSupported() {
-	return false;
+	// Only the OpenGL shaders have per-eye matrices indexed by gl_ViewID_OVR so far.
+	// Decided once, since the VR framebuffers and the shaders are created to match.
+	static int supported = -1;
+	if (supported == -1) {
+		bool useGL = (GPUBackend)g_Config.iGPUBackend == GPUBackend::OPENGL;
+		supported = g_Config.bVRMultiview && g_Config.bEnableStereo && IsVREnabled() && useGL && gl_extensions.OVR_multiview2 ? 1 : 0;
+	}
+	return supported == 1;
 }
 
 bool IsFlatVRGame() {
@@ -8,9 +8,14 @@
 #define __STDC_CONSTANT_MACROS 1
 #endif
 
-#include <string>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #ifdef USE_FFMPEG
 
@@ -26,6 +31,7 @@ extern "C" {
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/File/FileUtil.h"
 #include "Common/File/Path.h"
+#include "Common/Thread/ThreadUtil.h"
 
 #include "Core/Config.h"
 #include "Core/AVIDump.h"
@@ -52,6 +58,26 @@ static AVFrame *s_src_frame = nullptr;
 static AVFrame *s_scaled_frame = nullptr;
 static SwsContext *s_sws_context = nullptr;
 
+// Frames are read back on the emu thread, but scaled and encoded on this one.
+struct DumpFrame {
+	std::vector<u8> pixels;  // RGB24
+	u32 w;
+	u32 h;
+};
+
+// Enough to absorb a slow keyframe without stalling, small enough to not hog memory at high res.
+static const size_t MAX_QUEUED_FRAMES = 4;
+
+static std::thread s_encode_thread;
+static std::mutex s_queue_lock;
+static std::condition_variable s_queue_cond;
+static std::deque<DumpFrame> s_queue;
+static std::vector<std::vector<u8>> s_free_buffers;
+static bool s_encode_stop = false;
+
+static void EncodeFrame(const u8 *buffer, u32 w, u32 h);
+static void EncodeThread();
+
 #endif
 
 static int s_bytes_per_pixel;
@@ -86,6 +112,12 @@ bool AVIDump::Start(int w, int h)
 	bool success = CreateAVI();
 	if (!success)
 		CloseFile();
+#ifdef USE_FFMPEG
+	if (success) {
+		s_encode_stop = false;
+		s_encode_thread = std::thread(EncodeThread);
+	}
+#endif
 	return success;
 }
 
@@ -205,7 +237,59 @@ void AVIDump::AddFrame() {
 	const u8 *buffer = ConvertBufferToScreenshot(buf, false, flipbuffer, w, h);
 
 #ifdef USE_FFMPEG
+	if (!buffer || !s_encode_thread.joinable()) {
+		delete[] flipbuffer;
+		return;
+	}
+
+	DumpFrame frame;
+	frame.w = w;
+	frame.h = h;
+	{
+		std::unique_lock<std::mutex> guard(s_queue_lock);
+		// Rather than dropping frames, hold the emu thread back if encoding can't keep up.
+		s_queue_cond.wait(guard, [] { return s_queue.size() < MAX_QUEUED_FRAMES; });
+		if (!s_free_buffers.empty()) {
+			frame.pixels = std::move(s_free_buffers.back());
+			s_free_buffers.pop_back();
+		}
+	}
+	frame.pixels.assign(buffer, buffer + w * h * 3);
 
+	{
+		std::lock_guard<std::mutex> guard(s_queue_lock);
+		s_queue.push_back(std::move(frame));
+	}
+	s_queue_cond.notify_all();
+#endif
+	delete[] flipbuffer;
+}
+
+#ifdef USE_FFMPEG
+
+static void EncodeThread() {
+	SetCurrentThreadName("AVIDump");
+
+	std::unique_lock<std::mutex> guard(s_queue_lock);
+	while (true) {
+		s_queue_cond.wait(guard, [] { return s_encode_stop || !s_queue.empty(); });
+		// Even when stopping, everything already queued still goes into the file.
+		if (s_queue.empty())
+			break;
+
+		DumpFrame frame = std::move(s_queue.front());
+		s_queue.pop_front();
+		guard.unlock();
+		s_queue_cond.notify_all();
+
+		EncodeFrame(frame.pixels.data(), frame.w, frame.h);
+
+		guard.lock();
+		s_free_buffers.push_back(std::move(frame.pixels));
+	}
+}
+
+static void EncodeFrame(const u8 *buffer, u32 w, u32 h) {
 	s_src_frame->data[0] = const_cast<u8*>(buffer);
 	s_src_frame->linesize[0] = w * 3;
 	s_src_frame->format = AV_PIX_FMT_RGB24;
@@ -267,12 +351,21 @@ void AVIDump::AddFrame() {
 	if (error < 0)
 		ERROR_LOG(G3D, "Error while encoding video: %d", error);
 #endif
-#endif
-	delete[] flipbuffer;
 }
 
+#endif
+
 void AVIDump::Stop() {
 #ifdef USE_FFMPEG
+	if (s_encode_thread.joinable()) {
+		{
+			std::lock_guard<std::mutex> guard(s_queue_lock);
+			s_encode_stop = true;
+		}
+		s_queue_cond.notify_all();
+		s_encode_thread.join();
+		s_free_buffers.clear();
+	}
 
 	av_write_trailer(s_format_context);
 	CloseFile();
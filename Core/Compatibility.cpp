@@ -16,15 +16,64 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include "ext/xxhash.h"
 
 #include "Common/Log.h"
 #include "Common/Data/Format/IniFile.h"
+#include "Common/File/FileUtil.h"
 #include "Common/File/VFS/VFS.h"
 #include "Common/StringUtils.h"
 #include "Core/Compatibility.h"
 #include "Core/Config.h"
 #include "Core/System.h"
 
+struct CachedCompatIni {
+	uint64_t hash = 0;
+	IniFile ini;
+};
+
+// The compat files are read again on every game boot, but only parsed again if their contents
+// changed (which in practice only happens when someone is editing the user one.)
+static std::mutex compatCacheLock;
+static std::map<std::string, CachedCompatIni> compatCache;
+
+static void WithCachedIni(const std::string &key, const char *data, size_t size, const std::function<void(IniFile &)> &func) {
+	uint64_t hash = XXH3_64bits(data, size);
+
+	std::lock_guard<std::mutex> guard(compatCacheLock);
+	auto iter = compatCache.find(key);
+	if (iter == compatCache.end() || iter->second.hash != hash) {
+		CachedCompatIni &cached = compatCache[key];
+		cached.hash = hash;
+		cached.ini = IniFile();
+		cached.ini.Load(data, size);
+		iter = compatCache.find(key);
+	}
+	func(iter->second.ini);
+}
+
+static bool LoadCompatFromVFS(const char *filename, const std::function<void(IniFile &)> &func) {
+	size_t size;
+	uint8_t *data = g_VFS.ReadFile(filename, &size);
+	if (!data)
+		return false;
+	WithCachedIni(std::string("vfs:") + filename, (const char *)data, size, func);
+	delete[] data;
+	return true;
+}
+
+static bool LoadCompatFromFile(const Path &path, const std::function<void(IniFile &)> &func) {
+	std::string data;
+	if (!File::ReadFileToString(true, path, data))
+		return false;
+	WithCachedIni(path.ToString(), data.data(), data.size(), func);
+	return true;
+}
+
 void Compatibility::Load(const std::string &gameID) {
 	Clear();
 
@@ -36,39 +85,20 @@ void Compatibility::Load(const std::string &gameID) {
 	if (ignored_.find("ALL") != ignored_.end())
 		return;
 
-	{
-		IniFile compat;
-		// This loads from assets.
-		if (compat.LoadFromVFS(g_VFS, "compat.ini")) {
-			CheckSettings(compat, gameID);
-		}
-	}
-
-	{
-		IniFile compat2;
-		// This one is user-editable. Need to load it after the system one.
-		Path path = GetSysDirectory(DIRECTORY_SYSTEM) / "compat.ini";
-		if (compat2.Load(path)) {
-			CheckSettings(compat2, gameID);
-		}
-	}
+	auto checkSettings = [&](IniFile &compat) {
+		CheckSettings(compat, gameID);
+	};
+	auto checkVRSettings = [&](IniFile &compat) {
+		CheckVRSettings(compat, gameID);
+	};
 
-	{
-		IniFile compat;
-		// This loads from assets.
-		if (compat.LoadFromVFS(g_VFS, "compatvr.ini")) {
-			CheckVRSettings(compat, gameID);
-		}
-	}
+	// This loads from assets.
+	LoadCompatFromVFS("compat.ini", checkSettings);
+	// This one is user-editable. Need to load it after the system one.
+	LoadCompatFromFile(GetSysDirectory(DIRECTORY_SYSTEM) / "compat.ini", checkSettings);
 
-	{
-		IniFile compat2;
-		// This one is user-editable. Need to load it after the system one.
-		Path path = GetSysDirectory(DIRECTORY_SYSTEM) / "compatvr.ini";
-		if (compat2.Load(path)) {
-			CheckVRSettings(compat2, gameID);
-		}
-	}
+	LoadCompatFromVFS("compatvr.ini", checkVRSettings);
+	LoadCompatFromFile(GetSysDirectory(DIRECTORY_SYSTEM) / "compatvr.ini", checkVRSettings);
 }
 
 void Compatibility::Clear() {
@@ -129,6 +159,7 @@ void Compatibility::CheckSettings(IniFile &iniFile, const std::string &gameID) {
 	CheckSetting(iniFile, gameID, "ReadbackDepth", &flags_.ReadbackDepth);
 	CheckSetting(iniFile, gameID, "BlockTransferDepth", &flags_.BlockTransferDepth);
 	CheckSetting(iniFile, gameID, "DaxterRotatedAnalogStick", &flags_.DaxterRotatedAnalogStick);
+	CheckSetting(iniFile, gameID, "DelayedFramebufferReadbacks", &flags_.DelayedFramebufferReadbacks);
 }
 
 void Compatibility::CheckVRSettings(IniFile &iniFile, const std::string &gameID) {
@@ -481,6 +481,11 @@ static int DefaultCpuCore() {
 	if (System_GetPropertyBool(SYSPROP_CAN_JIT))
 		return (int)CPUCore::JIT;
 	return (int)CPUCore::IR_JIT;
+#elif PPSSPP_ARCH(RISCV64)
+	// No direct jit, but the IR can still be converted to native code.
+	if (System_GetPropertyBool(SYSPROP_CAN_JIT))
+		return (int)CPUCore::JIT_IR;
+	return (int)CPUCore::IR_JIT;
 #else
 	return (int)CPUCore::IR_JIT;
 #endif
@@ -510,6 +515,7 @@ static const ConfigSetting generalSettings[] = {
 	ConfigSetting("FirstRun", &g_Config.bFirstRun, true),
 	ConfigSetting("RunCount", &g_Config.iRunCount, 0),
 	ConfigSetting("Enable Logging", &g_Config.bEnableLogging, true),
+	ConfigSetting("AsyncLogging", &g_Config.bAsyncLogging, false),
 	ConfigSetting("AutoRun", &g_Config.bAutoRun, true),
 	ConfigSetting("Browse", &g_Config.bBrowse, false),
 	ConfigSetting("IgnoreBadMemAccess", &g_Config.bIgnoreBadMemAccess, true, true),
@@ -522,6 +528,7 @@ static const ConfigSetting generalSettings[] = {
 	ConfigSetting("UISound", &g_Config.bUISound, false, true, false),
 
 	ConfigSetting("AutoLoadSaveState", &g_Config.iAutoLoadSaveState, 0, true, true),
+	ConfigSetting("BootSnapshotSeconds", &g_Config.iBootSnapshotSeconds, 0, true, true),
 	ReportedConfigSetting("EnableCheats", &g_Config.bEnableCheats, false, true, true),
 	ConfigSetting("CwCheatRefreshRate", &g_Config.iCwCheatRefreshRate, 77, true, true),
 	ConfigSetting("CwCheatScrollPosition", &g_Config.fCwCheatScrollPosition, 0.0f, true, true),
@@ -539,6 +546,8 @@ static const ConfigSetting generalSettings[] = {
 	ConfigSetting("StateUndoLastSaveGame", &g_Config.sStateUndoLastSaveGame, "NA", true, false),
 	ConfigSetting("StateUndoLastSaveSlot", &g_Config.iStateUndoLastSaveSlot, -5, true, false), // Start with an "invalid" value
 	ConfigSetting("RewindSnapshotInterval", &g_Config.iRewindSnapshotInterval, 0, true, true),
+	ReportedConfigSetting("RewindWriteTracking", &g_Config.bRewindWriteTracking, false, true, true),
+	ConfigSetting("RewindMemoryBudget", &g_Config.iRewindMemoryBudget, 256, true, true),
 
 	ConfigSetting("ShowOnScreenMessage", &g_Config.bShowOnScreenMessages, true, true, false),
 	ConfigSetting("ShowRegionOnGameIcon", &g_Config.bShowRegionOnGameIcon, false),
@@ -599,6 +608,7 @@ static const ConfigSetting generalSettings[] = {
 	ConfigSetting("ShowMenuBar", &g_Config.bShowMenuBar, true, true, false),
 
 	ReportedConfigSetting("MemStickInserted", &g_Config.bMemStickInserted, true, true, true),
+	ConfigSetting("MemStickWriteBack", &g_Config.bMemStickWriteBack, false, true, true),
 	ConfigSetting("EnablePlugins", &g_Config.bLoadPlugins, true, true, true),
 
 	ReportedConfigSetting("IgnoreCompatSettings", &g_Config.sIgnoreCompatSettings, "", true, true),
@@ -608,15 +618,32 @@ static bool DefaultSasThread() {
 	return cpu_info.num_cores > 1;
 }
 
+static bool DefaultThreadCorePlacement() {
+	// Android schedulers are the most likely to put the emu thread on a little core.
+#if PPSSPP_PLATFORM(ANDROID)
+	return true;
+#else
+	return false;
+#endif
+}
+
 static const ConfigSetting cpuSettings[] = {
 	ReportedConfigSetting("CPUCore", &g_Config.iCpuCore, &DefaultCpuCore, true, true),
 	ReportedConfigSetting("SeparateSASThread", &g_Config.bSeparateSASThread, &DefaultSasThread, true, true),
+	ConfigSetting("ThreadCorePlacement", &g_Config.bThreadCorePlacement, &DefaultThreadCorePlacement, true, false),
+	ConfigSetting("PerformanceCores", &g_Config.sPerformanceCores, "", true, false),
+	ConfigSetting("EfficiencyCores", &g_Config.sEfficiencyCores, "", true, false),
 	ReportedConfigSetting("IOTimingMethod", &g_Config.iIOTimingMethod, IOTIMING_FAST, true, true),
 	ConfigSetting("FastMemoryAccess", &g_Config.bFastMemory, true, true, true),
 	ReportedConfigSetting("FunctionReplacements", &g_Config.bFuncReplacements, true, true, true),
+	ConfigSetting("FuncScanCache", &g_Config.bFuncScanCache, true, true, true),
 	ConfigSetting("HideSlowWarnings", &g_Config.bHideSlowWarnings, false, true, false),
 	ConfigSetting("HideStateWarnings", &g_Config.bHideStateWarnings, false, true, false),
 	ConfigSetting("PreloadFunctions", &g_Config.bPreloadFunctions, false, true, true),
+	ConfigSetting("IRJitDiskCache", &g_Config.bIRJitDiskCache, true, true, true),
+	ConfigSetting("IRJitTierThreshold", &g_Config.iIRJitTierThreshold, 50, true, true),
+	ConfigSetting("JitBackgroundCompile", &g_Config.bJitBackgroundCompile, false, true, true),
+	ConfigSetting("IRJitTraces", &g_Config.bIRJitTraces, false, true, true),
 	ConfigSetting("JitDisableFlags", &g_Config.uJitDisableFlags, (uint32_t)0, true, true),
 	ReportedConfigSetting("CPUSpeed", &g_Config.iLockedCPUSpeed, 0, true, true),
 };
@@ -836,6 +863,7 @@ static const ConfigSetting graphicsSettings[] = {
 	ReportedConfigSetting("TextureFiltering", &g_Config.iTexFiltering, 1, true, true),
 	ReportedConfigSetting("BufferFiltering", &g_Config.iBufFilter, SCALE_LINEAR, true, true),
 	ReportedConfigSetting("InternalResolution", &g_Config.iInternalResolution, &DefaultInternalResolution, true, true),
+	ReportedConfigSetting("DynamicResolution", &g_Config.bDynamicResolution, false, true, true),
 	ReportedConfigSetting("HighQualityDepth", &g_Config.bHighQualityDepth, true, true, true),
 	ReportedConfigSetting("FrameSkip", &g_Config.iFrameSkip, 0, true, true),
 	ReportedConfigSetting("FrameSkipType", &g_Config.iFrameSkipType, 0, true, true),
@@ -856,6 +884,8 @@ static const ConfigSetting graphicsSettings[] = {
 	ConfigSetting("MultiSampleLevel", &g_Config.iMultiSampleLevel, 0, true, true),  // Number of samples is 1 << iMultiSampleLevel
 
 	ReportedConfigSetting("VertexDecCache", &g_Config.bVertexCache, false, true, true),
+	ReportedConfigSetting("CullOffscreenDraws", &g_Config.bCullOffscreenDraws, false, true, true),
+	ReportedConfigSetting("SkipStaticDisplayLists", &g_Config.bSkipStaticDisplayLists, false, true, true),
 	ReportedConfigSetting("TextureBackoffCache", &g_Config.bTextureBackoffCache, false, true, true),
 	ReportedConfigSetting("VertexDecJit", &g_Config.bVertexDecoderJit, &DefaultCodeGen, false),
 
@@ -878,12 +908,17 @@ static const ConfigSetting graphicsSettings[] = {
 	ReportedConfigSetting("SaveNewTextures", &g_Config.bSaveNewTextures, false, true, true),
 	ConfigSetting("IgnoreTextureFilenames", &g_Config.bIgnoreTextureFilenames, false, true, true),
 	ConfigSetting("ReplaceTexturesAllowLate", &g_Config.bReplaceTexturesAllowLate, true, true, true),
+	ConfigSetting("ReplacementPrefetchMB", &g_Config.iReplacementPrefetchMB, 256, true, true),
 
 	ReportedConfigSetting("TexScalingLevel", &g_Config.iTexScalingLevel, 1, true, true),
 	ReportedConfigSetting("TexScalingType", &g_Config.iTexScalingType, 0, true, true),
 	ReportedConfigSetting("TexDeposterize", &g_Config.bTexDeposterize, false, true, true),
 	ReportedConfigSetting("TexHardwareScaling", &g_Config.bTexHardwareScaling, false, true, true),
+	ReportedConfigSetting("TexGPUDecode", &g_Config.bTexGPUDecode, false, true, true),
+	ReportedConfigSetting("TexHashSampledRows", &g_Config.bTexHashSampledRows, false, true, true),
+	ReportedConfigSetting("TexWriteTracking", &g_Config.bTexWriteTracking, false, true, true),
 	ConfigSetting("VSyncInterval", &g_Config.bVSync, false, true, true),
+	ConfigSetting("LowLatencyPresent", &g_Config.bLowLatencyPresent, false, true, true),
 	ReportedConfigSetting("BloomHack", &g_Config.iBloomHack, 0, true, true),
 
 	// Not really a graphics setting...
@@ -898,6 +933,7 @@ static const ConfigSetting graphicsSettings[] = {
 	ConfigSetting("LogFrameDrops", &g_Config.bLogFrameDrops, false, true, false),
 
 	ConfigSetting("InflightFrames", &g_Config.iInflightFrames, 3, true, false),
+	ConfigSetting("AdaptiveInflightFrames", &g_Config.bAdaptiveInflightFrames, false, true, false),
 	ConfigSetting("RenderDuplicateFrames", &g_Config.bRenderDuplicateFrames, false, true, true),
 
 	ConfigSetting("ShaderCache", &g_Config.bShaderCache, true, false, false),  // Doesn't save. Ini-only.
@@ -908,6 +944,8 @@ static const ConfigSetting soundSettings[] = {
 	ConfigSetting("Enable", &g_Config.bEnableSound, true, true, true),
 	ConfigSetting("AudioBackend", &g_Config.iAudioBackend, 0, true, true),
 	ConfigSetting("ExtraAudioBuffering", &g_Config.bExtraAudioBuffering, false, true, false),
+	ConfigSetting("AudioResampler", &g_Config.iAudioResampler, AUDIO_RESAMPLER_LINEAR, true, false),
+	ConfigSetting("AudioDecodeAhead", &g_Config.bAudioDecodeAhead, false, true, true),
 	ConfigSetting("GlobalVolume", &g_Config.iGlobalVolume, VOLUME_FULL, true, true),
 	ConfigSetting("ReverbVolume", &g_Config.iReverbVolume, VOLUME_FULL, true, true),
 	ConfigSetting("AltSpeedVolume", &g_Config.iAltSpeedVolume, -1, true, true),
@@ -1119,8 +1157,12 @@ static const ConfigSetting debuggerSettings[] = {
 	ConfigSetting("ShowGpuProfile", &g_Config.bShowGpuProfile, false, false),
 	ConfigSetting("SkipDeadbeefFilling", &g_Config.bSkipDeadbeefFilling, false),
 	ConfigSetting("FuncHashMap", &g_Config.bFuncHashMap, false),
+	ConfigSetting("MemInfo", &g_Config.bDebugMemInfo, true),
 	ConfigSetting("MemInfoDetailed", &g_Config.bDebugMemInfoDetailed, false),
 	ConfigSetting("DrawFrameGraph", &g_Config.bDrawFrameGraph, false),
+	ConfigSetting("JitPerfMap", &g_Config.bJitPerfMap, false, false),
+	ConfigSetting("ShaderCompileLog", &g_Config.bShaderCompileLog, false, false),
+	ConfigSetting("MemCheckPageProtect", &g_Config.bMemCheckPageProtect, false, false),
 };
 
 static const ConfigSetting jitSettings[] = {
@@ -1145,6 +1187,7 @@ static const ConfigSetting vrSettings[] = {
 	ConfigSetting("VREnableMotions", &g_Config.bEnableMotions, true),
 	ConfigSetting("VRForce72Hz", &g_Config.bForce72Hz, true),
 	ConfigSetting("VRManualForceVR", &g_Config.bManualForceVR, false),
+	ConfigSetting("VRMultiview", &g_Config.bVRMultiview, false),
 	ConfigSetting("VRCameraDistance", &g_Config.fCameraDistance, 0.0f),
 	ConfigSetting("VRCameraHeight", &g_Config.fCameraHeight, 0.0f),
 	ConfigSetting("VRCameraSide", &g_Config.fCameraSide, 0.0f),
@@ -1563,6 +1606,10 @@ void Config::PostLoadCleanup(bool gameSpecific) {
 	if (jitForcedOff) {
 		g_Config.iCpuCore = (int)CPUCore::IR_JIT;
 	}
+	// The native IR backend also needs executable memory.
+	if (!System_GetPropertyBool(SYSPROP_CAN_JIT) && g_Config.iCpuCore == (int)CPUCore::JIT_IR) {
+		g_Config.iCpuCore = (int)CPUCore::IR_JIT;
+	}
 
 	// This caps the exponent 4 (so 16x.)
 	if (iAnisotropyLevel > 4) {
@@ -88,6 +88,8 @@ struct Config {
 	bool bDumpAudio;
 	bool bSaveLoadResetsAVdumping;
 	bool bEnableLogging;
+	// Queue log messages and write them from a background thread, dropping instead of blocking when full.
+	bool bAsyncLogging;
 	bool bDumpDecryptedEboot;
 	bool bFullscreenOnDoubleclick;
 
@@ -114,12 +116,26 @@ struct Config {
 	bool bCheckForNewVersion;
 	bool bForceLagSync;
 	bool bFuncReplacements;
+	// Remember function scan results per game, so later boots can skip scanning unchanged code.
+	bool bFuncScanCache;
 	bool bHideSlowWarnings;
 	bool bHideStateWarnings;
 	bool bPreloadFunctions;
+	bool bIRJitDiskCache;
+	// Runs before an IR block is converted to native code.  0 converts every block right away.
+	int iIRJitTierThreshold;
+	// Compile new IR blocks on a background thread, interpreting until ready.  Not deterministic.
+	bool bJitBackgroundCompile;
+	// Let IR blocks continue across jumps and likely branches.
+	bool bIRJitTraces;
 	uint32_t uJitDisableFlags;
 
 	bool bSeparateSASThread;
+	// Keep the emu and render threads on performance cores, and background work on efficiency cores.
+	bool bThreadCorePlacement;
+	// Override the detected cores, like "4-7".  Empty to detect.
+	std::string sPerformanceCores;
+	std::string sEfficiencyCores;
 	int iIOTimingMethod;
 	int iLockedCPUSpeed;
 	bool bAutoSaveSymbolMap;
@@ -132,6 +148,7 @@ struct Config {
 	std::string sRemoteISOSubdir;
 	bool bRemoteDebuggerOnStartup;
 	bool bMemStickInserted;
+	bool bMemStickWriteBack;
 	int iMemStickSizeGB;
 	bool bLoadPlugins;
 
@@ -180,6 +197,8 @@ struct Config {
 	bool bSustainedPerformanceMode;  // Android: Slows clocks down to avoid overheating/speed fluctuations.
 	bool bIgnoreScreenInsets;  // Android: Center screen disregarding insets if this is enabled.
 	bool bVSync;
+	// Starts emulating each frame as late as possible, and keeps the present queue short where supported.
+	bool bLowLatencyPresent;
 
 	int iFrameSkip;
 	int iFrameSkipType;
@@ -201,12 +220,16 @@ struct Config {
 	float fUISaturation;
 
 	bool bVertexCache;
+	bool bCullOffscreenDraws;
+	bool bSkipStaticDisplayLists;
 	bool bTextureBackoffCache;
 	bool bVertexDecoderJit;
 	bool bFullScreen;
 	bool bFullScreenMulti;
 	int iForceFullScreen = -1; // -1 = nope, 0 = force off, 1 = force on (not saved.)
 	int iInternalResolution;  // 0 = Auto (native), 1 = 1x (480x272), 2 = 2x, 3 = 3x, 4 = 4x and so on.
+	// Lowers the internal resolution, down to about half of the above, when the GPU can't keep up.
+	bool bDynamicResolution;
 	int iAnisotropyLevel;  // 0 - 5, powers of 2: 0 = 1x = no aniso
 	int iMultiSampleLevel;
 	int bHighQualityDepth;
@@ -214,10 +237,14 @@ struct Config {
 	bool bSaveNewTextures;
 	bool bIgnoreTextureFilenames;
 	bool bReplaceTexturesAllowLate;
+	int iReplacementPrefetchMB;  // Texture replacements to load ahead of time, based on the last run. 0 = off.
 	int iTexScalingLevel; // 0 = auto, 1 = off, 2 = 2x, ..., 5 = 5x
 	int iTexScalingType; // 0 = xBRZ, 1 = Hybrid
 	bool bTexDeposterize;
 	bool bTexHardwareScaling;
+	bool bTexGPUDecode;
+	bool bTexHashSampledRows;
+	bool bTexWriteTracking;
 	int iFpsLimit1;
 	int iFpsLimit2;
 	int iAnalogFpsLimit;
@@ -225,12 +252,15 @@ struct Config {
 	int iMaxRecent;
 	int iCurrentStateSlot;
 	int iRewindSnapshotInterval;
+	bool bRewindWriteTracking;  // Keep RAM out of rewind states, copying only pages written since.
+	int iRewindMemoryBudget;  // In MB, for all rewind states together.
 	bool bUISound;
 	bool bEnableStateUndo;
 	std::string sStateLoadUndoGame;
 	std::string sStateUndoLastSaveGame;
 	int iStateUndoLastSaveSlot;
 	int iAutoLoadSaveState; // 0 = off, 1 = oldest, 2 = newest, >2 = slot number + 3
+	int iBootSnapshotSeconds;  // Emulated seconds after boot to save a state that later boots resume from, 0 = off.
 	bool bEnableCheats;
 	bool bReloadCheats;
 	int iCwCheatRefreshRate;
@@ -254,6 +284,7 @@ struct Config {
 	std::string sTextureShaderName;
 	bool bGfxDebugOutput;
 	int iInflightFrames;
+	bool bAdaptiveInflightFrames;
 	bool bRenderDuplicateFrames;
 
 	// Sound
@@ -263,6 +294,8 @@ struct Config {
 	int iReverbVolume;
 	int iAltSpeedVolume;
 	bool bExtraAudioBuffering;  // For bluetooth
+	int iAudioResampler;  // enum AudioResamplerType
+	bool bAudioDecodeAhead;  // Decode the next MP3 frame on a worker thread.
 	std::string sAudioDevice;
 	bool bAutoAudioDevice;
 
@@ -463,6 +496,7 @@ struct Config {
 	bool bEnableMotions;
 	bool bForce72Hz;
 	bool bManualForceVR;
+	bool bVRMultiview;
 	float fCameraDistance;
 	float fCameraHeight;
 	float fCameraSide;
@@ -497,8 +531,16 @@ struct Config {
 	// Double edged sword: much easier debugging, but not accurate.
 	bool bSkipDeadbeefFilling;
 	bool bFuncHashMap;
+	// Track allocations and writes for the debugger.  Off skips it all, unless a debugger asks for it.
+	bool bDebugMemInfo;
 	bool bDebugMemInfoDetailed;
 	bool bDrawFrameGraph;
+	// Write /tmp/perf-<pid>.map for JIT code, Linux only.
+	bool bJitPerfMap;
+	// Append shader and pipeline compile times to <discID>.shadercompile.csv in the cache directory.
+	bool bShaderCompileLog;
+	// Use page protection for memory breakpoints, so jit blocks only check once they touch a watched page.
+	bool bMemCheckPageProtect;
 
 	// Volatile development settings
 	bool bShowFrameProfiler;
@@ -35,6 +35,8 @@ enum class CPUCore {
 	INTERPRETER = 0,
 	JIT = 1,
 	IR_JIT = 2,
+	// IR, converted to native code after all passes.  Currently x86-64 and RISC-V 64 only, otherwise same as IR_JIT.
+	JIT_IR = 3,
 };
 
 enum {
@@ -106,6 +108,12 @@ enum AudioBackendType {
 	AUDIO_BACKEND_WASAPI,
 };
 
+// For iAudioResampler.
+enum AudioResamplerType {
+	AUDIO_RESAMPLER_LINEAR = 0,
+	AUDIO_RESAMPLER_SINC = 1,
+};
+
 // For iIOTimingMethod.
 enum IOTimingMethods {
 	IOTIMING_FAST = 0,
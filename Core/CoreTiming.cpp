@@ -15,6 +15,7 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <atomic>
 #include <climits>
 #include <cstdio>
@@ -26,10 +27,11 @@
 #include "Common/Profiler/Profiler.h"
 
 #include "Common/Serialize/Serializer.h"
-#include "Common/Serialize/SerializeList.h"
+#include "Common/Serialize/SerializeFuncs.h"
 #include "Core/CoreTiming.h"
 #include "Core/Core.h"
 #include "Core/Config.h"
+#include "Core/Debugger/GuestProfiler.h"
 #include "Core/HLE/sceKernelThread.h"
 #include "Core/MIPS/MIPS.h"
 
@@ -60,16 +62,16 @@ struct BaseEvent {
 	int type;
 };
 
-typedef LinkedListItem<BaseEvent> Event;
-
-Event *first;
-Event *tsFirst;
-Event *tsLast;
+// The order keeps events with the same time running in the order they were scheduled.
+struct QueuedEvent : public BaseEvent {
+	u64 order;
+};
 
-// event pools
-Event *eventPool = 0;
-Event *eventTsPool = 0;
-int allocatedTsEvents = 0;
+// Scheduled events, as a binary min-heap on (time, order).
+static std::vector<QueuedEvent> eventQueue;
+static u64 nextEventOrder = 0;
+// Scheduled from other threads, moved into eventQueue by MoveEvents().
+static std::vector<BaseEvent> tsEvents;
 // Optimization to skip MoveEvents when possible.
 std::atomic<u32> hasTsEvents;
 
@@ -130,39 +132,88 @@ u64 GetGlobalTimeUs() {
 	return lastGlobalTimeUs + usSinceLast;
 }
 
-Event* GetNewEvent()
-{
-	if(!eventPool)
-		return new Event;
+static inline bool EventBefore(const QueuedEvent &a, const QueuedEvent &b) {
+	return a.time < b.time || (a.time == b.time && a.order < b.order);
+}
 
-	Event* ev = eventPool;
-	eventPool = ev->next;
-	return ev;
+static void SiftUp(size_t i) {
+	QueuedEvent ev = eventQueue[i];
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		if (!EventBefore(ev, eventQueue[parent]))
+			break;
+		eventQueue[i] = eventQueue[parent];
+		i = parent;
+	}
+	eventQueue[i] = ev;
 }
 
-Event* GetNewTsEvent()
-{
-	allocatedTsEvents++;
+static void SiftDown(size_t i) {
+	const size_t n = eventQueue.size();
+	QueuedEvent ev = eventQueue[i];
+	while (true) {
+		size_t child = i * 2 + 1;
+		if (child >= n)
+			break;
+		if (child + 1 < n && EventBefore(eventQueue[child + 1], eventQueue[child]))
+			child++;
+		if (!EventBefore(eventQueue[child], ev))
+			break;
+		eventQueue[i] = eventQueue[child];
+		i = child;
+	}
+	eventQueue[i] = ev;
+}
 
-	if(!eventTsPool)
-		return new Event;
+static void AddEventToQueue(const BaseEvent &ev) {
+	QueuedEvent qe;
+	static_cast<BaseEvent &>(qe) = ev;
+	qe.order = nextEventOrder++;
+	eventQueue.push_back(qe);
+	SiftUp(eventQueue.size() - 1);
+}
 
-	Event* ev = eventTsPool;
-	eventTsPool = ev->next;
-	return ev;
+static void RemoveQueuedEventAt(size_t i) {
+	eventQueue[i] = eventQueue.back();
+	eventQueue.pop_back();
+	if (i < eventQueue.size()) {
+		// The moved event may belong either above or below.
+		SiftDown(i);
+		SiftUp(i);
+	}
 }
 
-void FreeEvent(Event* ev)
-{
-	ev->next = eventPool;
-	eventPool = ev;
+// Removes all matching events.  If any matched, last receives the one that would have run last.
+template <typename Pred>
+static bool RemoveQueuedEvents(Pred pred, BaseEvent *last) {
+	size_t found = eventQueue.size();
+	int count = 0;
+	for (size_t i = 0; i < eventQueue.size(); ++i) {
+		if (pred(eventQueue[i])) {
+			if (found == eventQueue.size() || EventBefore(eventQueue[found], eventQueue[i]))
+				found = i;
+			count++;
+		}
+	}
+	if (count == 0)
+		return false;
+
+	if (last)
+		*last = eventQueue[found];
+	if (count == 1) {
+		RemoveQueuedEventAt(found);
+	} else {
+		eventQueue.erase(std::remove_if(eventQueue.begin(), eventQueue.end(), pred), eventQueue.end());
+		for (size_t i = eventQueue.size() / 2; i-- > 0; )
+			SiftDown(i);
+	}
+	return true;
 }
 
-void FreeTsEvent(Event* ev)
-{
-	ev->next = eventTsPool;
-	eventTsPool = ev;
-	allocatedTsEvents--;
+static std::vector<QueuedEvent> SortedEvents() {
+	std::vector<QueuedEvent> sorted = eventQueue;
+	std::sort(sorted.begin(), sorted.end(), &EventBefore);
+	return sorted;
 }
 
 int RegisterEvent(const char *name, TimedCallback callback) {
@@ -208,7 +259,7 @@ void RestoreRegisterEvent(int &event_type, const char *name, TimedCallback callb
 }
 
 void UnregisterAllEvents() {
-	_dbg_assert_msg_(first == nullptr, "Unregistering events with events pending - this isn't good.");
+	_dbg_assert_msg_(eventQueue.empty(), "Unregistering events with events pending - this isn't good.");
 	event_types.clear();
 	usedEventTypes.clear();
 	restoredEventTypes.clear();
@@ -233,18 +284,12 @@ void Shutdown()
 	ClearPendingEvents();
 	UnregisterAllEvents();
 
-	while (eventPool) {
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
+	eventQueue.shrink_to_fit();
+	nextEventOrder = 0;
 
 	std::lock_guard<std::mutex> lk(externalEventLock);
-	while (eventTsPool) {
-		Event *ev = eventTsPool;
-		eventTsPool = ev->next;
-		delete ev;
-	}
+	tsEvents.clear();
+	tsEvents.shrink_to_fit();
 }
 
 u64 GetTicks()
@@ -268,16 +313,7 @@ u64 GetIdleTicks()
 void ScheduleEvent_Threadsafe(s64 cyclesIntoFuture, int event_type, u64 userdata)
 {
 	std::lock_guard<std::mutex> lk(externalEventLock);
-	Event *ne = GetNewTsEvent();
-	ne->time = GetTicks() + cyclesIntoFuture;
-	ne->type = event_type;
-	ne->next = 0;
-	ne->userdata = userdata;
-	if(!tsFirst)
-		tsFirst = ne;
-	if(tsLast)
-		tsLast->next = ne;
-	tsLast = ne;
+	tsEvents.push_back(BaseEvent{ (s64)GetTicks() + cyclesIntoFuture, userdata, event_type });
 
 	hasTsEvents.store(1, std::memory_order::memory_order_release);
 }
@@ -297,30 +333,7 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 
 void ClearPendingEvents()
 {
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
-	}
-}
-
-void AddEventToQueue(Event* ne)
-{
-	Event* prev = NULL;
-	Event** pNext = &first;
-	for(;;)
-	{
-		Event*& next = *pNext;
-		if(!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
-			break;
-		}
-		prev = next;
-		pNext = &prev->next;
-	}
+	eventQueue.clear();
 }
 
 // This must be run ONLY from within the cpu thread
@@ -328,106 +341,33 @@ void AddEventToQueue(Event* ne)
 // than Advance
 void ScheduleEvent(s64 cyclesIntoFuture, int event_type, u64 userdata)
 {
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = GetTicks() + cyclesIntoFuture;
-	AddEventToQueue(ne);
+	AddEventToQueue(BaseEvent{ (s64)GetTicks() + cyclesIntoFuture, userdata, event_type });
 }
 
 // Returns cycles left in timer.
 s64 UnscheduleEvent(int event_type, u64 userdata)
 {
-	s64 result = 0;
-	if (!first)
-		return result;
-	while(first)
-	{
-		if (first->type == event_type && first->userdata == userdata)
-		{
-			result = first->time - GetTicks();
-
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
-		return result;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type && ptr->userdata == userdata)
-		{
-			result = ptr->time - GetTicks();
-
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
-	}
-
-	return result;
+	BaseEvent last;
+	auto match = [&](const QueuedEvent &ev) {
+		return ev.type == event_type && ev.userdata == userdata;
+	};
+	if (!RemoveQueuedEvents(match, &last))
+		return 0;
+	return last.time - GetTicks();
 }
 
 s64 UnscheduleThreadsafeEvent(int event_type, u64 userdata)
 {
 	s64 result = 0;
 	std::lock_guard<std::mutex> lk(externalEventLock);
-	if (!tsFirst)
-		return result;
-	while(tsFirst)
-	{
-		if (tsFirst->type == event_type && tsFirst->userdata == userdata)
-		{
-			result = tsFirst->time - GetTicks();
-
-			Event *next = tsFirst->next;
-			FreeTsEvent(tsFirst);
-			tsFirst = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!tsFirst)
-	{
-		tsLast = NULL;
-		return result;
-	}
-
-	Event *prev = tsFirst;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type && ptr->userdata == userdata)
-		{
-			result = ptr->time - GetTicks();
-
-			prev->next = ptr->next;
-			if (ptr == tsLast)
-				tsLast = prev;
-			FreeTsEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
-	}
-
+	auto match = [&](const BaseEvent &ev) {
+		return ev.type == event_type && ev.userdata == userdata;
+	};
+	for (const BaseEvent &ev : tsEvents) {
+		if (match(ev))
+			result = ev.time - GetTicks();
+	}
+	tsEvents.erase(std::remove_if(tsEvents.begin(), tsEvents.end(), match), tsEvents.end());
 	return result;
 }
 
@@ -437,97 +377,26 @@ void RegisterMHzChangeCallback(MHzChangeCallback callback) {
 
 bool IsScheduled(int event_type)
 {
-	if (!first)
-		return false;
-	Event *e = first;
-	while (e) {
-		if (e->type == event_type)
+	for (const QueuedEvent &ev : eventQueue) {
+		if (ev.type == event_type)
 			return true;
-		e = e->next;
 	}
 	return false;
 }
 
 void RemoveEvent(int event_type)
 {
-	if (!first)
-		return;
-	while(first)
-	{
-		if (first->type == event_type)
-		{
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
-		return;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
-	}
+	RemoveQueuedEvents([&](const QueuedEvent &ev) {
+		return ev.type == event_type;
+	}, nullptr);
 }
 
 void RemoveThreadsafeEvent(int event_type)
 {
 	std::lock_guard<std::mutex> lk(externalEventLock);
-	if (!tsFirst)
-	{
-		return;
-	}
-	while(tsFirst)
-	{
-		if (tsFirst->type == event_type)
-		{
-			Event *next = tsFirst->next;
-			FreeTsEvent(tsFirst);
-			tsFirst = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!tsFirst)
-	{
-		tsLast = NULL;
-		return;
-	}
-	Event *prev = tsFirst;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			if (ptr == tsLast)
-				tsLast = prev;
-			FreeTsEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
-	}
+	tsEvents.erase(std::remove_if(tsEvents.begin(), tsEvents.end(), [&](const BaseEvent &ev) {
+		return ev.type == event_type;
+	}), tsEvents.end());
 }
 
 void RemoveAllEvents(int event_type)
@@ -539,21 +408,12 @@ void RemoveAllEvents(int event_type)
 //This raise only the events required while the fifo is processing data
 void ProcessFifoWaitEvents()
 {
-	while (first)
+	while (!eventQueue.empty() && eventQueue[0].time <= (s64)GetTicks())
 	{
-		if (first->time <= (s64)GetTicks())
-		{
-//			LOG(CPU, "[Scheduler] %s		 (%lld, %lld) ",
-//				first->name ? first->name : "?", (u64)GetTicks(), (u64)first->time);
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(GetTicks() - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
+		// The callback may schedule more, so take it off the queue first.
+		BaseEvent evt = eventQueue[0];
+		RemoveQueuedEventAt(0);
+		event_types[evt.type].callback(evt.userdata, (int)(GetTicks() - evt.time));
 	}
 }
 
@@ -563,23 +423,9 @@ void MoveEvents()
 
 	std::lock_guard<std::mutex> lk(externalEventLock);
 	// Move events from async queue into main queue
-	while (tsFirst)
-	{
-		Event *next = tsFirst->next;
-		AddEventToQueue(tsFirst);
-		tsFirst = next;
-	}
-	tsLast = NULL;
-
-	// Move free events to threadsafe pool
-	while(allocatedTsEvents > 0 && eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		ev->next = eventTsPool;
-		eventTsPool = ev;
-		allocatedTsEvents--;
-	}
+	for (const BaseEvent &ev : tsEvents)
+		AddEventToQueue(ev);
+	tsEvents.clear();
 }
 
 void ForceCheck()
@@ -606,7 +452,7 @@ void Advance() {
 		MoveEvents();
 	ProcessFifoWaitEvents();
 
-	if (!first) {
+	if (eventQueue.empty()) {
 		// This should never happen in PPSSPP.
 		if (slicelength < 10000) {
 			slicelength += 10000;
@@ -614,7 +460,7 @@ void Advance() {
 		}
 	} else {
 		// Note that events can eat cycles as well.
-		int target = (int)(first->time - globalTimer);
+		int target = (int)(eventQueue[0].time - globalTimer);
 		if (target > MAX_SLICE_LENGTH)
 			target = MAX_SLICE_LENGTH;
 
@@ -622,13 +468,21 @@ void Advance() {
 		slicelength += diff;
 		currentMIPS->downcount += diff;
 	}
+
+	// The PC is accurate here, and this doesn't need an event (which would end up in states.)
+	if (GuestProfiler::IsActive()) {
+		GuestProfiler::Sample();
+		const int untilSample = GuestProfiler::CyclesUntilSample();
+		if (untilSample < slicelength) {
+			currentMIPS->downcount += untilSample - slicelength;
+			slicelength = untilSample;
+		}
+	}
 }
 
 void LogPendingEvents() {
-	Event *ptr = first;
-	while (ptr) {
-		//INFO_LOG(CPU, "PENDING: Now: %lld Pending: %lld Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
+	for (const QueuedEvent &ev : SortedEvents()) {
+		DEBUG_LOG(CPU, "PENDING: Now: %lld Pending: %lld Type: %d", (long long)globalTimer, (long long)ev.time, ev.type);
 	}
 }
 
@@ -637,9 +491,9 @@ void Idle(int maxIdle) {
 	if (maxIdle != 0 && cyclesDown > maxIdle)
 		cyclesDown = maxIdle;
 
-	if (first && cyclesDown > 0) {
+	if (!eventQueue.empty() && cyclesDown > 0) {
 		int cyclesExecuted = slicelength - currentMIPS->downcount;
-		int cyclesNextEvent = (int) (first->time - globalTimer);
+		int cyclesNextEvent = (int) (eventQueue[0].time - globalTimer);
 
 		if (cyclesNextEvent < cyclesExecuted + cyclesDown)
 			cyclesDown = cyclesNextEvent - cyclesExecuted;
@@ -658,23 +512,20 @@ void Idle(int maxIdle) {
 }
 
 std::string GetScheduledEventsSummary() {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr) {
-		unsigned int t = ptr->type;
+	for (const QueuedEvent &ev : SortedEvents()) {
+		unsigned int t = ev.type;
 		if (t >= event_types.size()) {
 			_dbg_assert_msg_(false, "Invalid event type %d", t);
-			ptr = ptr->next;
 			continue;
 		}
 		const char *name = event_types[t].name;
 		if (!name)
 			name = "[unknown]";
 		char temp[512];
-		sprintf(temp, "%s : %i %08x%08x\n", name, (int)ptr->time, (u32)(ptr->userdata >> 32), (u32)(ptr->userdata));
+		sprintf(temp, "%s : %i %08x%08x\n", name, (int)ev.time, (u32)(ev.userdata >> 32), (u32)(ev.userdata));
 		text += temp;
-		ptr = ptr->next;
 	}
 	return text;
 }
@@ -694,6 +545,47 @@ void Event_DoStateOld(PointerWrap &p, BaseEvent *ev)
 	usedEventTypes.insert(ev->type);
 }
 
+// Same layout as DoLinkedList(), which the queues used to be saved with.
+template <void (*TDo)(PointerWrap &, BaseEvent *)>
+static void DoEventList(PointerWrap &p, std::vector<BaseEvent> &events) {
+	if (p.mode == PointerWrap::MODE_READ)
+		events.clear();
+
+	for (size_t i = 0; ; ++i) {
+		u8 shouldExist = i < events.size() ? 1 : 0;
+		Do(p, shouldExist);
+		if (shouldExist != 1) {
+			if (shouldExist != 0) {
+				WARN_LOG(SAVESTATE, "Savestate failure: incorrect item marker %d", shouldExist);
+				p.SetError(p.ERROR_FAILURE);
+			}
+			break;
+		}
+
+		if (p.mode == PointerWrap::MODE_READ)
+			events.push_back(BaseEvent{});
+		TDo(p, &events[i]);
+	}
+}
+
+// Saves the queue in the order it will run.
+template <void (*TDo)(PointerWrap &, BaseEvent *)>
+static void DoEventQueue(PointerWrap &p) {
+	std::vector<BaseEvent> events;
+	if (p.mode != PointerWrap::MODE_READ) {
+		std::vector<QueuedEvent> sorted = SortedEvents();
+		events.assign(sorted.begin(), sorted.end());
+	}
+
+	DoEventList<TDo>(p, events);
+
+	if (p.mode == PointerWrap::MODE_READ) {
+		eventQueue.clear();
+		for (const BaseEvent &ev : events)
+			AddEventToQueue(ev);
+	}
+}
+
 void DoState(PointerWrap &p) {
 	std::lock_guard<std::mutex> lk(externalEventLock);
 
@@ -720,12 +612,13 @@ void DoState(PointerWrap &p) {
 	restoredEventTypes.clear();
 
 	if (s >= 3) {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoState>(p, first, (Event **) NULL);
-		DoLinkedList<BaseEvent, GetNewTsEvent, FreeTsEvent, Event_DoState>(p, tsFirst, &tsLast);
+		DoEventQueue<Event_DoState>(p);
+		DoEventList<Event_DoState>(p, tsEvents);
 	} else {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoStateOld>(p, first, (Event **) NULL);
-		DoLinkedList<BaseEvent, GetNewTsEvent, FreeTsEvent, Event_DoStateOld>(p, tsFirst, &tsLast);
+		DoEventQueue<Event_DoStateOld>(p);
+		DoEventList<Event_DoStateOld>(p, tsEvents);
 	}
+	hasTsEvents.store(tsEvents.empty() ? 0 : 1, std::memory_order::memory_order_release);
 
 	Do(p, CPU_HZ);
 	Do(p, slicelength);
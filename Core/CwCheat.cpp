@@ -2,6 +2,7 @@
 #include <cctype>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include "Common/Data/Text/I18n.h"
 #include "Common/StringUtils.h"
 #include "Common/Serialize/Serializer.h"
@@ -362,59 +363,6 @@ void hleCheat(u64 userdata, int cyclesLate) {
 	cheatEngine->Run();
 }
 
-CWCheatEngine::CWCheatEngine(const std::string &gameID) : gameID_(gameID) {
-	filename_ = GetSysDirectory(DIRECTORY_CHEATS) / (gameID_ + ".ini");
-}
-
-void CWCheatEngine::CreateCheatFile() {
-	File::CreateFullPath(GetSysDirectory(DIRECTORY_CHEATS));
-
-	if (!File::Exists(filename_)) {
-		FILE *f = File::OpenCFile(filename_, "wb");
-		if (f) {
-			fwrite("\xEF\xBB\xBF\n", 1, 4, f);
-			fclose(f);
-		}
-		if (!File::Exists(filename_)) {
-			auto err = GetI18NCategory("Error");
-			host->NotifyUserMessage(err->T("Unable to create cheat file, disk may be full"));
-		}
-	}
-}
-
-Path CWCheatEngine::CheatFilename() {
-	return filename_;
-}
-
-void CWCheatEngine::ParseCheats() {
-	CheatFileParser parser(filename_, gameID_);
-
-	parser.Parse();
-	// TODO: Report errors.
-
-	cheats_ = parser.GetCheats();
-}
-
-u32 CWCheatEngine::GetAddress(u32 value) {
-	// Returns static address used by ppsspp. Some games may not like this, and causes cheats to not work without offset
-	u32 address = (value + 0x08800000) & 0x3FFFFFFF;
-	return address;
-}
-
-std::vector<CheatFileInfo> CWCheatEngine::FileInfo() {
-	CheatFileParser parser(filename_, gameID_);
-
-	parser.Parse();
-	return parser.GetFileInfo();
-}
-
-void CWCheatEngine::InvalidateICache(u32 addr, int size) {
-	// Round start down and size up to the nearest word.
-	u32 aligned = addr & ~3;
-	int alignedSize = (addr + size - aligned + 3) & ~3;
-	currentMIPS->InvalidateICache(aligned, alignedSize);
-}
-
 enum class CheatOp {
 	Invalid,
 	Noop,
@@ -499,6 +447,113 @@ struct CheatOperation {
 	};
 };
 
+struct DecodedCheatOp {
+	CheatOperation op;
+	// Line following the op's own lines.
+	size_t next;
+};
+
+struct DecodedCheat {
+	// Index into ops for the op starting at each line, or -1 if not decoded yet.
+	std::vector<int> opAtLine;
+	std::vector<DecodedCheatOp> ops;
+};
+
+CWCheatEngine::CWCheatEngine(const std::string &gameID) : gameID_(gameID) {
+	filename_ = GetSysDirectory(DIRECTORY_CHEATS) / (gameID_ + ".ini");
+}
+
+CWCheatEngine::~CWCheatEngine() {
+}
+
+void CWCheatEngine::CreateCheatFile() {
+	File::CreateFullPath(GetSysDirectory(DIRECTORY_CHEATS));
+
+	if (!File::Exists(filename_)) {
+		FILE *f = File::OpenCFile(filename_, "wb");
+		if (f) {
+			fwrite("\xEF\xBB\xBF\n", 1, 4, f);
+			fclose(f);
+		}
+		if (!File::Exists(filename_)) {
+			auto err = GetI18NCategory("Error");
+			host->NotifyUserMessage(err->T("Unable to create cheat file, disk may be full"));
+		}
+	}
+}
+
+Path CWCheatEngine::CheatFilename() {
+	return filename_;
+}
+
+void CWCheatEngine::ParseCheats() {
+	CheatFileParser parser(filename_, gameID_);
+
+	parser.Parse();
+	// TODO: Report errors.
+
+	cheats_ = parser.GetCheats();
+	decoded_.clear();
+	decoded_.resize(cheats_.size());
+	for (size_t i = 0; i < cheats_.size(); ++i)
+		decoded_[i].opAtLine.resize(cheats_[i].lines.size(), -1);
+}
+
+u32 CWCheatEngine::GetAddress(u32 value) {
+	// Returns static address used by ppsspp. Some games may not like this, and causes cheats to not work without offset
+	u32 address = (value + 0x08800000) & 0x3FFFFFFF;
+	return address;
+}
+
+std::vector<CheatFileInfo> CWCheatEngine::FileInfo() {
+	CheatFileParser parser(filename_, gameID_);
+
+	parser.Parse();
+	return parser.GetFileInfo();
+}
+
+void CWCheatEngine::InvalidateICache(u32 addr, int size) {
+	// Round start down and size up to the nearest word.
+	u32 aligned = addr & ~3;
+	int alignedSize = (addr + size - aligned + 3) & ~3;
+	currentMIPS->InvalidateICache(aligned, alignedSize);
+}
+
+bool CWCheatEngine::InvalidateICacheIfJitted(u32 addr, int size) {
+	// A jit block replaces its first instruction in memory, so reading there would see the emuhack.
+	// Anywhere else, memory already has the real values and the block can stay.
+	u32 end = addr + size;
+	for (u32 a = addr & ~3; a < end; a += 4) {
+		if (MIPS_IS_EMUHACK(Memory::ReadUnchecked_U32(a))) {
+			InvalidateICache(addr, size);
+			return true;
+		}
+	}
+	return false;
+}
+
+void CWCheatEngine::WriteIfChanged(u32 addr, int sz, u32 val) {
+	// Most cheats keep rewriting the value that's already there, skip the write and the jit work then.
+	bool invalidated = InvalidateICacheIfJitted(addr, sz);
+	if (sz == 1) {
+		if (Memory::Read_U8(addr) == (u8)val)
+			return;
+		Memory::Write_U8((u8)val, addr);
+	} else if (sz == 2) {
+		if (Memory::Read_U16(addr) == (u16)val)
+			return;
+		Memory::Write_U16((u16)val, addr);
+	} else if (sz == 4) {
+		if (Memory::Read_U32(addr) == val)
+			return;
+		Memory::Write_U32(val, addr);
+	} else {
+		return;
+	}
+	if (!invalidated)
+		InvalidateICache(addr, sz);
+}
+
 CheatOperation CWCheatEngine::InterpretNextCwCheat(const CheatCode &cheat, size_t &i) {
 	const CheatLine &line1 = cheat.lines[i++];
 	const uint32_t &arg = line1.part2;
@@ -804,19 +859,19 @@ CheatOperation CWCheatEngine::InterpretNextOp(const CheatCode &cheat, size_t &i)
 
 void CWCheatEngine::ApplyMemoryOperator(const CheatOperation &op, uint32_t(*oper)(uint32_t, uint32_t)) {
 	if (Memory::IsValidRange(op.addr, op.sz)) {
-		InvalidateICache(op.addr, op.sz);
+		InvalidateICacheIfJitted(op.addr, op.sz);
 		if (op.sz == 1)
-			Memory::Write_U8((u8)oper(Memory::Read_U8(op.addr), op.val), op.addr);
+			WriteIfChanged(op.addr, op.sz, oper(Memory::Read_U8(op.addr), op.val));
 		else if (op.sz == 2)
-			Memory::Write_U16((u16)oper(Memory::Read_U16(op.addr), op.val),op. addr);
+			WriteIfChanged(op.addr, op.sz, oper(Memory::Read_U16(op.addr), op.val));
 		else if (op.sz == 4)
-			Memory::Write_U32((u32)oper(Memory::Read_U32(op.addr), op.val), op.addr);
+			WriteIfChanged(op.addr, op.sz, oper(Memory::Read_U32(op.addr), op.val));
 	}
 }
 
 bool CWCheatEngine::TestIf(const CheatOperation &op, bool(*oper)(int, int)) {
 	if (Memory::IsValidRange(op.addr, op.sz)) {
-		InvalidateICache(op.addr, op.sz);
+		InvalidateICacheIfJitted(op.addr, op.sz);
 
 		int memoryValue = 0;
 		if (op.sz == 1)
@@ -833,8 +888,8 @@ bool CWCheatEngine::TestIf(const CheatOperation &op, bool(*oper)(int, int)) {
 
 bool CWCheatEngine::TestIfAddr(const CheatOperation &op, bool(*oper)(int, int)) {
 	if (Memory::IsValidRange(op.addr, op.sz) && Memory::IsValidRange(op.ifAddrTypes.compareAddr, op.sz)) {
-		InvalidateICache(op.addr, op.sz);
-		InvalidateICache(op.addr, op.ifAddrTypes.compareAddr);
+		InvalidateICacheIfJitted(op.addr, op.sz);
+		InvalidateICacheIfJitted(op.ifAddrTypes.compareAddr, op.sz);
 
 		int memoryValue1 = 0;
 		int memoryValue2 = 0;
@@ -865,13 +920,7 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 	case CheatOp::Write:
 		if (Memory::IsValidRange(op.addr, op.sz)) {
-			InvalidateICache(op.addr, op.sz);
-			if (op.sz == 1)
-				Memory::Write_U8((u8)op.val, op.addr);
-			else if (op.sz == 2)
-				Memory::Write_U16((u16)op.val, op.addr);
-			else if (op.sz == 4)
-				Memory::Write_U32((u32)op.val, op.addr);
+			WriteIfChanged(op.addr, op.sz, op.val);
 		}
 		break;
 
@@ -907,18 +956,11 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 	case CheatOp::MultiWrite:
 		if (Memory::IsValidAddress(op.addr)) {
-			InvalidateICache(op.addr, op.multiWrite.count * op.multiWrite.step + op.sz);
-
 			uint32_t data = op.val;
 			uint32_t addr = op.addr;
 			for (uint32_t a = 0; a < op.multiWrite.count; a++) {
-				if (Memory::IsValidAddress(addr)) {
-					if (op.sz == 1)
-						Memory::Write_U8((u8)data, addr);
-					else if (op.sz == 2)
-						Memory::Write_U16((u16)data, addr);
-					else if (op.sz == 4)
-						Memory::Write_U32((u32)data, addr);
+				if (Memory::IsValidRange(addr, op.sz)) {
+					WriteIfChanged(addr, op.sz, data);
 				}
 				addr += op.multiWrite.step;
 				data += op.multiWrite.add;
@@ -928,10 +970,13 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 	case CheatOp::CopyBytesFrom:
 		if (Memory::IsValidRange(op.addr, op.val) && Memory::IsValidRange(op.copyBytesFrom.destAddr, op.val)) {
-			InvalidateICache(op.addr, op.val);
-			InvalidateICache(op.copyBytesFrom.destAddr, op.val);
+			InvalidateICacheIfJitted(op.addr, op.val);
+			InvalidateICacheIfJitted(op.copyBytesFrom.destAddr, op.val);
 
-			Memory::Memcpy(op.copyBytesFrom.destAddr, op.addr, op.val, "CwCheat");
+			if (memcmp(Memory::GetPointerUnchecked(op.copyBytesFrom.destAddr), Memory::GetPointerUnchecked(op.addr), op.val) != 0) {
+				Memory::Memcpy(op.copyBytesFrom.destAddr, op.addr, op.val, "CwCheat");
+				InvalidateICache(op.copyBytesFrom.destAddr, op.val);
+			}
 		}
 		break;
 
@@ -1005,7 +1050,7 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 	case CheatOp::Assert:
 		if (Memory::IsValidRange(op.addr, 4)) {
-			InvalidateICache(op.addr, 4);
+			InvalidateICacheIfJitted(op.addr, 4);
 			if (Memory::Read_U32(op.addr) != op.val) {
 				i = cheat.lines.size();
 			}
@@ -1192,11 +1237,22 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 }
 
 void CWCheatEngine::Run() {
-	for (CheatCode cheat : cheats_) {
-		// InterpretNextOp and ExecuteOp move i.
+	for (size_t c = 0; c < cheats_.size(); ++c) {
+		const CheatCode &cheat = cheats_[c];
+		DecodedCheat &decoded = decoded_[c];
+		// Each line is only decoded the first time execution reaches it, ExecuteOp moves i.
 		for (size_t i = 0; i < cheat.lines.size(); ) {
-			CheatOperation op = InterpretNextOp(cheat, i);
-			ExecuteOp(op, cheat, i);
+			int index = decoded.opAtLine[i];
+			if (index < 0) {
+				size_t next = i;
+				CheatOperation op = InterpretNextOp(cheat, next);
+				index = (int)decoded.ops.size();
+				decoded.ops.push_back({ op, next });
+				decoded.opAtLine[i] = index;
+			}
+			const DecodedCheatOp &op = decoded.ops[index];
+			i = op.next;
+			ExecuteOp(op.op, cheat, i);
 		}
 	}
 }
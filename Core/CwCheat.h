@@ -42,10 +42,12 @@ struct CheatFileInfo {
 };
 
 struct CheatOperation;
+struct DecodedCheat;
 
 class CWCheatEngine {
 public:
 	CWCheatEngine(const std::string &gameID);
+	~CWCheatEngine();
 	std::vector<CheatFileInfo> FileInfo();
 	void ParseCheats();
 	void CreateCheatFile();
@@ -54,6 +56,9 @@ class CWCheatEngine {
 	bool HasCheats();
 	void InvalidateICache(u32 addr, int size);
 private:
+	// Only invalidates if a jit block starts inside the range, so reads see the original instructions.
+	bool InvalidateICacheIfJitted(u32 addr, int size);
+	void WriteIfChanged(u32 addr, int sz, u32 val);
 	u32 GetAddress(u32 value);
 
 	CheatOperation InterpretNextOp(const CheatCode &cheat, size_t &i);
@@ -66,6 +71,8 @@ class CWCheatEngine {
 	bool TestIfAddr(const CheatOperation &op, bool(*oper)(int a, int b));
 
 	std::vector<CheatCode> cheats_;
+	// Parallel to cheats_, ops decoded from each cheat's lines.  Reset whenever cheats_ changes.
+	std::vector<DecodedCheat> decoded_;
 	std::string gameID_;
 	Path filename_;
 };
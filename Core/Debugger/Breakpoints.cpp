@@ -20,16 +20,19 @@
 #include <mutex>
 
 #include "Common/Log.h"
+#include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/Debugger/Breakpoints.h"
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/Host.h"
+#include "Core/MemFault.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/CoreTiming.h"
+#include "Core/System.h"
 
 std::atomic<bool> anyBreakPoints_(false);
 std::atomic<bool> anyMemChecks_(false);
@@ -654,6 +657,40 @@ bool CBreakPoints::HasMemChecks() {
 	return anyMemChecks_;
 }
 
+bool CBreakPoints::HasMemChecksForBlock(u32 blockAddress) {
+	if (!anyMemChecks_)
+		return false;
+	if (!Memory::MemCheckWatch_IsActive())
+		return true;
+	return Memory::MemCheckWatch_IsCheckedBlock(blockAddress);
+}
+
+// Call with the core stopped, before clearing the jit cache.
+static void UpdateMemCheckPages() {
+	Memory::MemCheckWatch_Clear();
+	// Only the jit's own memory accesses get checked from faults, not the interpreters.
+	bool usePages = g_Config.bMemCheckPageProtect && g_Config.bFastMemory && PSP_CoreParameter().cpuCore == CPUCore::JIT;
+	if (!usePages || !MIPSComp::jit || !MIPSComp::jit->GetBlockCache())
+		return;
+
+	const std::vector<MemCheck> checks = CBreakPoints::GetMemChecks();
+	for (const MemCheck &check : checks) {
+		if (check.end != 0 && check.end <= check.start) {
+			usePages = false;
+			break;
+		}
+		u32 size = check.end != 0 ? check.end - check.start : 1;
+		if (!Memory::MemCheckWatch_Add(check.start, size, (check.cond & MEMCHECK_READ) != 0)) {
+			usePages = false;
+			break;
+		}
+	}
+
+	// If anything is outside watchable RAM, just check in every block like before.
+	if (!usePages)
+		Memory::MemCheckWatch_Clear();
+}
+
 void CBreakPoints::Update(u32 addr) {
 	if (MIPSComp::jit) {
 		bool resume = false;
@@ -664,10 +701,12 @@ void CBreakPoints::Update(u32 addr) {
 		}
 
 		// In case this is a delay slot, clear the previous instruction too.
-		if (addr != 0)
+		if (addr != 0) {
 			mipsr4k.InvalidateICache(addr - 4, 8);
-		else
+		} else {
+			UpdateMemCheckPages();
 			mipsr4k.ClearJitCache();
+		}
 
 		if (resume)
 			Core_EnableStepping(false);
@@ -169,6 +169,9 @@ class CBreakPoints
 
 	static bool HasBreakPoints();
 	static bool HasMemChecks();
+	// Whether the jit should emit memchecks in this block. With page protected memchecks,
+	// blocks only get them after they touch a watched page.
+	static bool HasMemChecksForBlock(u32 blockAddress);
 
 	static void Update(u32 addr = 0);
 
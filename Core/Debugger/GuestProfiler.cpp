@@ -0,0 +1,217 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Common/StringUtils.h"
+#include "Core/CoreTiming.h"
+#include "Core/Debugger/GuestProfiler.h"
+#include "Core/Debugger/SymbolMap.h"
+#include "Core/HLE/sceKernelThread.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/MIPSStackWalk.h"
+#include "Core/MIPS/JitCommon/JitBlockCache.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
+
+namespace GuestProfiler {
+
+static std::atomic<bool> active;
+
+// Samples are recorded on the emu thread, but read (and started) from the UI.
+static std::mutex profileLock;
+static int intervalCycles = 0;
+static s64 nextSampleTicks = 0;
+// Function start addresses, outermost first.
+static std::map<std::vector<u32>, int> stackSamples;
+static std::unordered_map<u32, int> blockSamples;
+static int totalSamples = 0;
+
+void Start(int intervalUs) {
+	std::lock_guard<std::mutex> guard(profileLock);
+	intervalCycles = std::max(1, (int)usToCycles((u64)std::max(1, intervalUs)));
+	nextSampleTicks = 0;
+	active = true;
+}
+
+void Stop() {
+	active = false;
+}
+
+bool IsActive() {
+	return active;
+}
+
+void Reset() {
+	std::lock_guard<std::mutex> guard(profileLock);
+	stackSamples.clear();
+	blockSamples.clear();
+	totalSamples = 0;
+}
+
+static u32 FunctionFor(u32 pc, u32 guessedEntry) {
+	u32 start = g_symbolMap ? g_symbolMap->GetFunctionStart(pc) : SymbolMap::INVALID_ADDRESS;
+	if (start != SymbolMap::INVALID_ADDRESS)
+		return start;
+	return guessedEntry != 0xFFFFFFFF ? guessedEntry : pc;
+}
+
+void Sample() {
+	std::lock_guard<std::mutex> guard(profileLock);
+	s64 now = CoreTiming::GetTicks();
+	// After loading a state, time might have gone backwards.
+	if (now + intervalCycles < nextSampleTicks)
+		nextSampleTicks = now;
+	if (now < nextSampleTicks)
+		return;
+	nextSampleTicks = now + intervalCycles;
+
+	u32 pc = currentMIPS->pc;
+	if (!Memory::IsValidAddress(pc))
+		return;
+
+	u32 entry = __KernelGetCurThreadEntry();
+	u32 stackTop = __KernelGetCurThreadStackStart();
+	auto frames = MIPSStackWalk::Walk(pc, currentMIPS->r[MIPS_REG_RA], currentMIPS->r[MIPS_REG_SP], entry, stackTop);
+
+	std::vector<u32> stack;
+	stack.reserve(frames.size() + 1);
+	for (auto it = frames.rbegin(); it != frames.rend(); ++it)
+		stack.push_back(FunctionFor(it->pc, it->entry));
+	if (stack.empty())
+		stack.push_back(FunctionFor(pc, 0xFFFFFFFF));
+
+	// Usually we're at a block exit, so try the quick lookup first.
+	u32 blockAddress = 0;
+	JitBlockCache *blocks = MIPSComp::jit ? MIPSComp::jit->GetBlockCache() : nullptr;
+	if (blocks) {
+		int num = blocks->GetBlockNumberFromStartAddress(pc);
+		if (num < 0)
+			num = blocks->GetBlockNumberFromAddress(pc);
+		if (num >= 0)
+			blockAddress = blocks->GetBlock(num)->originalAddress;
+	}
+
+	stackSamples[stack]++;
+	if (blockAddress != 0)
+		blockSamples[blockAddress]++;
+	totalSamples++;
+}
+
+int CyclesUntilSample() {
+	std::lock_guard<std::mutex> guard(profileLock);
+	s64 cycles = nextSampleTicks - CoreTiming::GetTicks();
+	if (cycles < 1)
+		return 1;
+	return (int)std::min(cycles, (s64)intervalCycles);
+}
+
+int TotalSamples() {
+	std::lock_guard<std::mutex> guard(profileLock);
+	return totalSamples;
+}
+
+static std::string FunctionName(u32 address) {
+	std::string name = g_symbolMap ? g_symbolMap->GetLabelString(address) : "";
+	if (name.empty())
+		return StringFromFormat("z_un_%08x", address);
+	return name;
+}
+
+std::vector<FunctionStats> GetFunctionStats() {
+	std::unordered_map<u32, FunctionStats> funcs;
+	{
+		std::lock_guard<std::mutex> guard(profileLock);
+		std::unordered_set<u32> seen;
+		for (const auto &it : stackSamples) {
+			const std::vector<u32> &stack = it.first;
+			seen.clear();
+			for (u32 func : stack) {
+				FunctionStats &stats = funcs[func];
+				stats.address = func;
+				// Recursion shouldn't count more than once.
+				if (seen.insert(func).second)
+					stats.totalSamples += it.second;
+			}
+			funcs[stack.back()].selfSamples += it.second;
+		}
+	}
+
+	std::vector<FunctionStats> result;
+	result.reserve(funcs.size());
+	for (auto &it : funcs) {
+		it.second.name = FunctionName(it.first);
+		result.push_back(it.second);
+	}
+	std::sort(result.begin(), result.end(), [](const FunctionStats &a, const FunctionStats &b) {
+		if (a.selfSamples != b.selfSamples)
+			return a.selfSamples > b.selfSamples;
+		return a.totalSamples > b.totalSamples;
+	});
+	return result;
+}
+
+std::vector<BlockStats> GetBlockStats() {
+	std::vector<BlockStats> result;
+	{
+		std::lock_guard<std::mutex> guard(profileLock);
+		result.reserve(blockSamples.size());
+		for (const auto &it : blockSamples)
+			result.push_back(BlockStats{ it.first, it.second });
+	}
+	std::sort(result.begin(), result.end(), [](const BlockStats &a, const BlockStats &b) {
+		return a.samples > b.samples;
+	});
+	return result;
+}
+
+bool ExportCollapsedStacks(const Path &filename) {
+	std::map<std::vector<u32>, int> stacks;
+	{
+		std::lock_guard<std::mutex> guard(profileLock);
+		stacks = stackSamples;
+	}
+
+	FILE *fp = File::OpenCFile(filename, "wb");
+	if (!fp)
+		return false;
+
+	std::unordered_map<u32, std::string> names;
+	for (const auto &it : stacks) {
+		std::string line;
+		for (u32 func : it.first) {
+			auto name = names.find(func);
+			if (name == names.end())
+				name = names.emplace(func, FunctionName(func)).first;
+			if (!line.empty())
+				line += ';';
+			line += name->second;
+		}
+		fprintf(fp, "%s %d\n", line.c_str(), it.second);
+	}
+	fclose(fp);
+	return true;
+}
+
+}  // namespace GuestProfiler
@@ -0,0 +1,63 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Path;
+
+// Sampling profiler for the emulated program, to find which game functions are worth
+// replacing or optimizing.  Samples are taken on the emu thread at regular emulated time
+// intervals, and include a stack walk so they can be shown as a call tree.
+namespace GuestProfiler {
+
+struct FunctionStats {
+	uint32_t address;
+	std::string name;
+	// Samples with this function at the top of the stack.
+	int selfSamples;
+	// Samples with this function anywhere in the stack.
+	int totalSamples;
+};
+
+struct BlockStats {
+	uint32_t address;
+	int samples;
+};
+
+void Start(int intervalUs = 1000);
+void Stop();
+bool IsActive();
+void Reset();
+
+// Called from CoreTiming::Advance(), at which point the PC is accurate on all cores.
+void Sample();
+// Cycles until the next sample is due, so CoreTiming can keep slices short enough.
+int CyclesUntilSample();
+
+int TotalSamples();
+// Sorted by self samples, most first.
+std::vector<FunctionStats> GetFunctionStats();
+// JIT blocks the PC was in, sorted by samples.  Empty when not using a block JIT.
+std::vector<BlockStats> GetBlockStats();
+
+// Writes "outer;inner;leaf count" lines, which flamegraph.pl and speedscope can read.
+bool ExportCollapsedStacks(const Path &filename);
+
+}  // namespace GuestProfiler
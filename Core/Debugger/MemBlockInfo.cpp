@@ -18,6 +18,8 @@
 #include <algorithm>
 #include <atomic>
 #include <cstring>
+#include <map>
+#include <memory>
 #include <mutex>
 
 #include "Common/Log.h"
@@ -33,7 +35,6 @@
 class MemSlabMap {
 public:
 	MemSlabMap();
-	~MemSlabMap();
 
 	bool Mark(uint32_t addr, uint32_t size, uint64_t ticks, uint32_t pc, bool allocated, const char *tag);
 	bool Find(MemBlockFlags flags, uint32_t addr, uint32_t size, std::vector<MemBlockInfo> &results);
@@ -44,37 +45,30 @@ class MemSlabMap {
 
 private:
 	struct Slab {
-		uint32_t start = 0;
 		uint32_t end = 0;
 		uint64_t ticks = 0;
 		uint32_t pc = 0;
 		bool allocated = false;
 		char tag[128]{};
-		Slab *prev = nullptr;
-		Slab *next = nullptr;
-
-		void DoState(PointerWrap &p);
 	};
+	// Keyed by start address.  The slabs always cover all of [0, MAX_SIZE) without gaps.
+	typedef std::map<uint32_t, Slab> SlabMap;
 
 	static constexpr uint32_t MAX_SIZE = 0x40000000;
-	static constexpr uint32_t SLICES = 16384;
-	static constexpr uint32_t SLICE_SIZE = MAX_SIZE / SLICES;
 
-	Slab *FindSlab(uint32_t addr);
-	void Clear();
+	static void DoSlabState(PointerWrap &p, uint32_t &start, Slab &slab);
+	SlabMap::iterator FindSlab(uint32_t addr);
 	// Returns the new slab after size.
-	Slab *Split(Slab *slab, uint32_t size);
-	void MergeAdjacent(Slab *slab);
-	static inline bool Same(const Slab *a, const Slab *b);
-	void Merge(Slab *a, Slab *b);
-	void FillHeads(Slab *slab);
-
-	Slab *first_ = nullptr;
-	Slab *lastFind_ = nullptr;
-	std::vector<Slab *> heads_;
+	SlabMap::iterator Split(SlabMap::iterator it, uint32_t size);
+	void MergeAdjacent(SlabMap::iterator it);
+	static inline bool Same(const Slab &a, const Slab &b);
+
+	SlabMap slabs_;
 };
 
 struct PendingNotifyMem {
+	// Orders notifies from different threads.
+	uint64_t sequence;
 	MemBlockFlags flags;
 	uint32_t start;
 	uint32_t size;
@@ -83,54 +77,70 @@ struct PendingNotifyMem {
 	char tag[128];
 };
 
-static constexpr size_t MAX_PENDING_NOTIFIES = 512;
+static constexpr uint32_t MAX_PENDING_NOTIFIES = 512;
+
+// Single producer (the notifying thread), single consumer (whoever holds mapMutex.)
+struct PendingNotifyRing {
+	PendingNotifyMem entries[MAX_PENDING_NOTIFIES];
+	std::atomic<uint32_t> head{ 0 };
+	std::atomic<uint32_t> tail{ 0 };
+	// Set when the thread exits, so the ring can be freed once drained.
+	std::atomic<bool> orphaned{ false };
+};
+
+struct PendingNotifyRingHolder {
+	~PendingNotifyRingHolder() {
+		if (ring)
+			ring->orphaned = true;
+	}
+
+	std::shared_ptr<PendingNotifyRing> ring;
+};
+
 static MemSlabMap allocMap;
 static MemSlabMap suballocMap;
 static MemSlabMap writeMap;
 static MemSlabMap textureMap;
-static std::vector<PendingNotifyMem> pendingNotifies;
-static std::atomic<uint32_t> pendingNotifyMinAddr1;
-static std::atomic<uint32_t> pendingNotifyMaxAddr1;
-static std::atomic<uint32_t> pendingNotifyMinAddr2;
-static std::atomic<uint32_t> pendingNotifyMaxAddr2;
-static std::mutex pendingMutex;
-static int detailedOverride;
+// Protects the maps, and draining the rings.
+static std::mutex mapMutex;
+static std::mutex ringsMutex;
+static std::vector<std::shared_ptr<PendingNotifyRing>> pendingRings;
+static thread_local PendingNotifyRingHolder pendingRingHolder;
+static std::atomic<uint64_t> pendingSequence;
+static std::atomic<int> detailedOverride;
 
 MemSlabMap::MemSlabMap() {
 	Reset();
 }
 
-MemSlabMap::~MemSlabMap() {
-	Clear();
-}
-
 bool MemSlabMap::Mark(uint32_t addr, uint32_t size, uint64_t ticks, uint32_t pc, bool allocated, const char *tag) {
 	uint32_t end = addr + size;
-	Slab *slab = FindSlab(addr);
-	Slab *firstMatch = nullptr;
-	while (slab != nullptr && slab->start < end) {
-		if (slab->start < addr)
-			slab = Split(slab, addr - slab->start);
-		// Don't replace slab, the return is the after part.
-		if (slab->end > end) {
-			Split(slab, end - slab->start);
+	SlabMap::iterator it = FindSlab(addr);
+	SlabMap::iterator firstMatch = slabs_.end();
+	while (it != slabs_.end() && it->first < end) {
+		if (it->first < addr)
+			it = Split(it, addr - it->first);
+		// Don't replace it, the return is the after part.
+		if (it->second.end > end) {
+			Split(it, end - it->first);
 		}
 
-		slab->allocated = allocated;
+		Slab &slab = it->second;
+		slab.allocated = allocated;
 		if (pc != 0) {
-			slab->ticks = ticks;
-			slab->pc = pc;
+			slab.ticks = ticks;
+			slab.pc = pc;
 		}
 		if (tag)
-			truncate_cpy(slab->tag, tag);
+			truncate_cpy(slab.tag, tag);
 
 		// Move on to the next one.
-		if (firstMatch == nullptr)
-			firstMatch = slab;
-		slab = slab->next;
+		if (firstMatch == slabs_.end())
+			firstMatch = it;
+		++it;
 	}
 
-	if (firstMatch != nullptr) {
+	if (firstMatch != slabs_.end()) {
 		// This will merge all those blocks to one.
 		MergeAdjacent(firstMatch);
 		return true;
@@ -140,38 +150,31 @@ bool MemSlabMap::Mark(uint32_t addr, uint32_t size, uint64_t ticks, uint32_t pc,
 
 bool MemSlabMap::Find(MemBlockFlags flags, uint32_t addr, uint32_t size, std::vector<MemBlockInfo> &results) {
 	uint32_t end = addr + size;
-	Slab *slab = FindSlab(addr);
 	bool found = false;
-	while (slab != nullptr && slab->start < end) {
-		if (slab->pc != 0 || slab->tag[0] != '\0') {
-			results.push_back({ flags, slab->start, slab->end - slab->start, slab->ticks, slab->pc, slab->tag, slab->allocated });
+	for (SlabMap::iterator it = FindSlab(addr); it != slabs_.end() && it->first < end; ++it) {
+		const Slab &slab = it->second;
+		if (slab.pc != 0 || slab.tag[0] != '\0') {
+			results.push_back({ flags, it->first, slab.end - it->first, slab.ticks, slab.pc, slab.tag, slab.allocated });
 			found = true;
 		}
-		slab = slab->next;
 	}
 	return found;
 }
 
 const char *MemSlabMap::FastFindWriteTag(MemBlockFlags flags, uint32_t addr, uint32_t size) {
 	uint32_t end = addr + size;
-	Slab *slab = FindSlab(addr);
-	while (slab != nullptr && slab->start < end) {
-		if (slab->pc != 0 || slab->tag[0] != '\0') {
-			return slab->tag;
+	for (SlabMap::iterator it = FindSlab(addr); it != slabs_.end() && it->first < end; ++it) {
+		const Slab &slab = it->second;
+		if (slab.pc != 0 || slab.tag[0] != '\0') {
+			return slab.tag;
 		}
-		slab = slab->next;
 	}
 	return nullptr;
 }
 
 void MemSlabMap::Reset() {
-	Clear();
-
-	first_ = new Slab();
-	first_->end = MAX_SIZE;
-	lastFind_ = first_;
-
-	heads_.resize(SLICES, first_);
+	slabs_.clear();
+	slabs_[0].end = MAX_SIZE;
 }
 
 void MemSlabMap::DoState(PointerWrap &p) {
@@ -179,224 +182,173 @@ void MemSlabMap::DoState(PointerWrap &p) {
 	if (!s)
 		return;
 
-	int count = 0;
+	int count = (int)slabs_.size();
+	Do(p, count);
 	if (p.mode == p.MODE_READ) {
-		// Since heads_ is a static size, let's avoid clearing it.
-		// This helps in case a debugger call happens concurrently.
-		Slab *old = first_;
-		Do(p, count);
-
-		first_ = new Slab();
-		first_->DoState(p);
-		lastFind_ = first_;
-		--count;
-
-		FillHeads(first_);
-
-		Slab *slab = first_;
+		SlabMap slabs;
 		for (int i = 0; i < count; ++i) {
-			slab->next = new Slab();
-			slab->next->DoState(p);
-
-			slab->next->prev = slab;
-			slab = slab->next;
-
-			FillHeads(slab);
-		}
-
-		// Now that it's entirely disconnected, delete the old slabs.
-		while (old != nullptr) {
-			Slab *next = old->next;
-			delete old;
-			old = next;
+			uint32_t start = 0;
+			Slab slab;
+			DoSlabState(p, start, slab);
+			slabs.emplace_hint(slabs.end(), start, slab);
 		}
+		if (slabs.empty())
+			slabs[0].end = MAX_SIZE;
+		slabs_.swap(slabs);
 	} else {
-		for (Slab *slab = first_; slab != nullptr; slab = slab->next)
-			++count;
-		Do(p, count);
-
-		first_->DoState(p);
-		--count;
-
-		Slab *slab = first_;
-		for (int i = 0; i < count; ++i) {
-			slab->next->DoState(p);
-			slab = slab->next;
+		for (auto &it : slabs_) {
+			uint32_t start = it.first;
+			DoSlabState(p, start, it.second);
 		}
 	}
 }
 
-void MemSlabMap::Slab::DoState(PointerWrap &p) {
+void MemSlabMap::DoSlabState(PointerWrap &p, uint32_t &start, Slab &slab) {
 	auto s = p.Section("MemSlabMapSlab", 1, 3);
 	if (!s)
 		return;
 
 	Do(p, start);
-	Do(p, end);
-	Do(p, ticks);
-	Do(p, pc);
-	Do(p, allocated);
+	Do(p, slab.end);
+	Do(p, slab.ticks);
+	Do(p, slab.pc);
+	Do(p, slab.allocated);
 	if (s >= 3) {
-		Do(p, tag);
+		Do(p, slab.tag);
 	} else if (s >= 2) {
 		char shortTag[32];
 		Do(p, shortTag);
-		memcpy(tag, shortTag, sizeof(shortTag));
+		memcpy(slab.tag, shortTag, sizeof(shortTag));
 	} else {
 		std::string stringTag;
 		Do(p, stringTag);
-		truncate_cpy(tag, stringTag.c_str());
-	}
-}
-
-void MemSlabMap::Clear() {
-	Slab *s = first_;
-	while (s != nullptr) {
-		Slab *next = s->next;
-		delete s;
-		s = next;
+		truncate_cpy(slab.tag, stringTag.c_str());
 	}
-	first_ = nullptr;
-	lastFind_ = nullptr;
-	heads_.clear();
 }
 
-MemSlabMap::Slab *MemSlabMap::FindSlab(uint32_t addr) {
-	// Jump ahead using our index.
-	Slab *slab = heads_[addr / SLICE_SIZE];
-	// We often move forward, so check the last find.
-	if (lastFind_->start > slab->start && lastFind_->start <= addr)
-		slab = lastFind_;
-
-	while (slab != nullptr && slab->start <= addr) {
-		if (slab->end > addr) {
-			lastFind_ = slab;
-			return slab;
-		}
-		slab = slab->next;
-	}
-	return nullptr;
+MemSlabMap::SlabMap::iterator MemSlabMap::FindSlab(uint32_t addr) {
+	if (addr >= MAX_SIZE)
+		return slabs_.end();
+	// The first slab starting after addr, so the one before contains it.
+	SlabMap::iterator it = slabs_.upper_bound(addr);
+	if (it == slabs_.begin())
+		return slabs_.end();
+	--it;
+	return it->second.end > addr ? it : slabs_.end();
 }
 
-MemSlabMap::Slab *MemSlabMap::Split(Slab *slab, uint32_t size) {
-	Slab *next = new Slab();
-	next->start = slab->start + size;
-	next->end = slab->end;
-	next->ticks = slab->ticks;
-	next->pc = slab->pc;
-	next->allocated = slab->allocated;
-	truncate_cpy(next->tag, slab->tag);
-	next->prev = slab;
-	next->next = slab->next;
-
-	slab->next = next;
-	if (next->next)
-		next->next->prev = next;
-
-	// If the split is big, we might have to update our index.
-	FillHeads(next);
-
-	slab->end = slab->start + size;
-	return next;
+MemSlabMap::SlabMap::iterator MemSlabMap::Split(SlabMap::iterator it, uint32_t size) {
+	Slab next = it->second;
+	it->second.end = it->first + size;
+	return slabs_.emplace_hint(std::next(it), it->first + size, next);
 }
 
-bool MemSlabMap::Same(const Slab *a, const Slab *b) {
-	if (a->allocated != b->allocated)
+bool MemSlabMap::Same(const Slab &a, const Slab &b) {
+	if (a.allocated != b.allocated)
 		return false;
-	if (a->pc != b->pc)
+	if (a.pc != b.pc)
 		return false;
-	if (strcmp(a->tag, b->tag))
+	if (strcmp(a.tag, b.tag))
 		return false;
 	return true;
 }
 
-void MemSlabMap::MergeAdjacent(Slab *slab) {
-	while (slab->next != nullptr && Same(slab, slab->next)) {
-		Merge(slab, slab->next);
+void MemSlabMap::MergeAdjacent(SlabMap::iterator it) {
+	SlabMap::iterator next = std::next(it);
+	while (next != slabs_.end() && Same(it->second, next->second)) {
+		_assert_(it->second.end == next->first);
+		it->second.end = next->second.end;
+		it->second.ticks = std::max(it->second.ticks, next->second.ticks);
+		next = slabs_.erase(next);
 	}
-	while (slab->prev != nullptr && Same(slab, slab->prev)) {
-		Merge(slab, slab->prev);
+	while (it != slabs_.begin()) {
+		SlabMap::iterator prev = std::prev(it);
+		if (!Same(prev->second, it->second))
+			break;
+		_assert_(prev->second.end == it->first);
+		// Keep the earlier one, since the start is the key.
+		prev->second.end = it->second.end;
+		prev->second.ticks = std::max(prev->second.ticks, it->second.ticks);
+		slabs_.erase(it);
+		it = prev;
 	}
 }
 
-void MemSlabMap::Merge(Slab *a, Slab *b) {
-	if (a->next == b) {
-		_assert_(a->end == b->start);
-		a->end = b->end;
-		a->next = b->next;
-
-		if (a->next)
-			a->next->prev = a;
-	} else if (a->prev == b) {
-		_assert_(b->end == a->start);
-		a->start = b->start;
-		a->prev = b->prev;
-
-		if (a->prev)
-			a->prev->next = a;
-		else if (first_ == b)
-			first_ = a;
-	} else {
-		_assert_(false);
+static void ApplyPendingMemInfo(const PendingNotifyMem &info) {
+	if (info.flags & MemBlockFlags::ALLOC) {
+		allocMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
+	} else if (info.flags & MemBlockFlags::FREE) {
+		// Maintain the previous allocation tag for debugging.
+		allocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
+		suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
+	}
+	if (info.flags & MemBlockFlags::SUB_ALLOC) {
+		suballocMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
+	} else if (info.flags & MemBlockFlags::SUB_FREE) {
+		// Maintain the previous allocation tag for debugging.
+		suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
+	}
+	if (info.flags & MemBlockFlags::TEXTURE) {
+		textureMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
 	}
-	// Take over index entries b had.
-	FillHeads(a);
-	if (b->ticks > a->ticks) {
-		a->ticks = b->ticks;
-		// In case we ignore PC for same.
-		a->pc = b->pc;
+	if (info.flags & MemBlockFlags::WRITE) {
+		writeMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
 	}
-	if (lastFind_ == b)
-		lastFind_ = a;
-	delete b;
 }
 
-void MemSlabMap::FillHeads(Slab *slab) {
-	uint32_t slice = slab->start / SLICE_SIZE;
-	uint32_t endSlice = (slab->end - 1) / SLICE_SIZE;
+// Must hold mapMutex.  Merges what every thread has notified so far into the maps.
+static void FlushPendingMemInfoLocked(bool discard = false) {
+	std::vector<std::shared_ptr<PendingNotifyRing>> rings;
+	{
+		std::lock_guard<std::mutex> guard(ringsMutex);
+		rings = pendingRings;
+	}
 
-	// For the first slice, only replace if it's the one we're removing.
-	if (slab->start == slice * SLICE_SIZE) {
-		heads_[slice] = slab;
+	static std::vector<const PendingNotifyMem *> batch;
+	std::vector<uint32_t> heads(rings.size());
+	for (size_t i = 0; i < rings.size(); ++i) {
+		uint32_t tail = rings[i]->tail.load(std::memory_order_relaxed);
+		heads[i] = rings[i]->head.load(std::memory_order_acquire);
+		for (; !discard && tail != heads[i]; ++tail)
+			batch.push_back(&rings[i]->entries[tail % MAX_PENDING_NOTIFIES]);
 	}
 
-	// Now replace all the rest - we definitely cover the start of them.
-	Slab **next = &heads_[slice + 1];
-	// We want to set slice + 1 through endSlice, inclusive.
-	size_t c = endSlice - slice;
-	for (size_t i = 0; i < c; ++i) {
-		next[i] = slab;
+	// Usually only one thread had anything, in which case this is already sorted.
+	if (rings.size() > 1) {
+		std::sort(batch.begin(), batch.end(), [](const PendingNotifyMem *a, const PendingNotifyMem *b) {
+			return a->sequence < b->sequence;
+		});
 	}
+	for (const PendingNotifyMem *info : batch)
+		ApplyPendingMemInfo(*info);
+	batch.clear();
+
+	// Only now let the producers reuse the entries.
+	for (size_t i = 0; i < rings.size(); ++i)
+		rings[i]->tail.store(heads[i], std::memory_order_release);
+
+	// Forget the rings of threads that have exited, now that they're empty.
+	std::lock_guard<std::mutex> guard(ringsMutex);
+	pendingRings.erase(std::remove_if(pendingRings.begin(), pendingRings.end(), [](const std::shared_ptr<PendingNotifyRing> &ring) {
+		return ring->orphaned && ring->head == ring->tail;
+	}), pendingRings.end());
 }
 
 void FlushPendingMemInfo() {
-	std::lock_guard<std::mutex> guard(pendingMutex);
-	for (auto info : pendingNotifies) {
-		if (info.flags & MemBlockFlags::ALLOC) {
-			allocMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
-		} else if (info.flags & MemBlockFlags::FREE) {
-			// Maintain the previous allocation tag for debugging.
-			allocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
-			suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
-		}
-		if (info.flags & MemBlockFlags::SUB_ALLOC) {
-			suballocMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
-		} else if (info.flags & MemBlockFlags::SUB_FREE) {
-			// Maintain the previous allocation tag for debugging.
-			suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
-		}
-		if (info.flags & MemBlockFlags::TEXTURE) {
-			textureMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
-		}
-		if (info.flags & MemBlockFlags::WRITE) {
-			writeMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
-		}
-	}
-	pendingNotifies.clear();
-	pendingNotifyMinAddr1 = 0xFFFFFFFF;
-	pendingNotifyMaxAddr1 = 0;
-	pendingNotifyMinAddr2 = 0xFFFFFFFF;
-	pendingNotifyMaxAddr2 = 0;
+	std::lock_guard<std::mutex> guard(mapMutex);
+	FlushPendingMemInfoLocked();
+}
+
+static PendingNotifyRing *GetPendingRing() {
+	PendingNotifyRingHolder &holder = pendingRingHolder;
+	if (holder.ring)
+		return holder.ring.get();
+
+	// First notify from this thread.
+	holder.ring = std::make_shared<PendingNotifyRing>();
+	std::lock_guard<std::mutex> guard(ringsMutex);
+	pendingRings.push_back(holder.ring);
+	return holder.ring.get();
 }
 
 static inline uint32_t NormalizeAddress(uint32_t addr) {
@@ -405,29 +357,6 @@ static inline uint32_t NormalizeAddress(uint32_t addr) {
 	return addr & 0x3FFFFFFF;
 }
 
-static inline bool MergeRecentMemInfo(const PendingNotifyMem &info, size_t copyLength) {
-	if (pendingNotifies.size() < 4)
-		return false;
-
-	for (size_t i = 1; i <= 4; ++i) {
-		auto &prev = pendingNotifies[pendingNotifies.size() - i];
-		if (prev.start >= info.start + info.size || prev.start + prev.size <= info.start)
-			continue;
-
-		// This means there's overlap, but not a match, so we can't combine any.
-		if (prev.start != info.start || prev.size > info.size)
-			return false;
-
-		memcpy(prev.tag, info.tag, copyLength + 1);
-		prev.size = info.size;
-		prev.ticks = info.ticks;
-		prev.pc = info.pc;
-		return true;
-	}
-
-	return false;
-}
-
 void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_t pc, const char *tagStr, size_t strLength) {
 	if (size == 0) {
 		return;
@@ -435,10 +364,22 @@ void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_
 	// Clear the uncached and kernel bits.
 	start = NormalizeAddress(start);
 
-	bool needFlush = false;
+	// Reads are only for memchecks, they're never recorded.
+	const MemBlockFlags recorded = MemBlockFlags::ALLOC | MemBlockFlags::SUB_ALLOC | MemBlockFlags::WRITE | MemBlockFlags::TEXTURE | MemBlockFlags::FREE | MemBlockFlags::SUB_FREE;
 	// When the setting is off, we skip smaller info to keep things fast.
-	if (MemBlockInfoDetailed(size)) {
-		PendingNotifyMem info{ flags, start, size };
+	if ((flags & recorded) && MemBlockInfoDetailed(size)) {
+		PendingNotifyRing *ring = GetPendingRing();
+		uint32_t head = ring->head.load(std::memory_order_relaxed);
+		if (head - ring->tail.load(std::memory_order_acquire) >= MAX_PENDING_NOTIFIES) {
+			// Full, so merge everything now.  Afterward ours is empty, since only we add to it.
+			FlushPendingMemInfo();
+		}
+
+		PendingNotifyMem &info = ring->entries[head % MAX_PENDING_NOTIFIES];
+		info.sequence = pendingSequence.fetch_add(1, std::memory_order_relaxed);
+		info.flags = flags;
+		info.start = start;
+		info.size = size;
 		info.ticks = CoreTiming::GetTicks();
 		info.pc = pc;
 
@@ -449,23 +390,7 @@ void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_
 		memcpy(info.tag, tagStr, copyLength);
 		info.tag[copyLength] = 0;
 
-		std::lock_guard<std::mutex> guard(pendingMutex);
-		// Sometimes we get duplicates, quickly check.
-		if (!MergeRecentMemInfo(info, copyLength)) {
-			if (start < 0x08000000) {
-				pendingNotifyMinAddr1 = std::min(pendingNotifyMinAddr1.load(), start);
-				pendingNotifyMaxAddr1 = std::max(pendingNotifyMaxAddr1.load(), start + size);
-			} else {
-				pendingNotifyMinAddr2 = std::min(pendingNotifyMinAddr2.load(), start);
-				pendingNotifyMaxAddr2 = std::max(pendingNotifyMaxAddr2.load(), start + size);
-			}
-			pendingNotifies.push_back(info);
-		}
-		needFlush = pendingNotifies.size() > MAX_PENDING_NOTIFIES;
-	}
-
-	if (needFlush) {
-		FlushPendingMemInfo();
+		ring->head.store(head + 1, std::memory_order_release);
 	}
 
 	if (!(flags & MemBlockFlags::SKIP_MEMCHECK)) {
@@ -484,12 +409,9 @@ void NotifyMemInfo(MemBlockFlags flags, uint32_t start, uint32_t size, const cha
 std::vector<MemBlockInfo> FindMemInfo(uint32_t start, uint32_t size) {
 	start = NormalizeAddress(start);
 
-	if (pendingNotifyMinAddr1 < start + size && pendingNotifyMaxAddr1 >= start)
-		FlushPendingMemInfo();
-	if (pendingNotifyMinAddr2 < start + size && pendingNotifyMaxAddr2 >= start)
-		FlushPendingMemInfo();
-
 	std::vector<MemBlockInfo> results;
+	std::lock_guard<std::mutex> guard(mapMutex);
+	FlushPendingMemInfoLocked();
 	allocMap.Find(MemBlockFlags::ALLOC, start, size, results);
 	suballocMap.Find(MemBlockFlags::SUB_ALLOC, start, size, results);
 	writeMap.Find(MemBlockFlags::WRITE, start, size, results);
@@ -500,12 +422,9 @@ std::vector<MemBlockInfo> FindMemInfo(uint32_t start, uint32_t size) {
 std::vector<MemBlockInfo> FindMemInfoByFlag(MemBlockFlags flags, uint32_t start, uint32_t size) {
 	start = NormalizeAddress(start);
 
-	if (pendingNotifyMinAddr1 < start + size && pendingNotifyMaxAddr1 >= start)
-		FlushPendingMemInfo();
-	if (pendingNotifyMinAddr2 < start + size && pendingNotifyMaxAddr2 >= start)
-		FlushPendingMemInfo();
-
 	std::vector<MemBlockInfo> results;
+	std::lock_guard<std::mutex> guard(mapMutex);
+	FlushPendingMemInfoLocked();
 	if (flags & MemBlockFlags::ALLOC)
 		allocMap.Find(MemBlockFlags::ALLOC, start, size, results);
 	if (flags & MemBlockFlags::SUB_ALLOC)
@@ -517,14 +436,10 @@ std::vector<MemBlockInfo> FindMemInfoByFlag(MemBlockFlags flags, uint32_t start,
 	return results;
 }
 
-static const char *FindWriteTagByFlag(MemBlockFlags flags, uint32_t start, uint32_t size) {
+// Must hold mapMutex, and the pending info should already be flushed.
+static const char *FindWriteTagByFlagLocked(MemBlockFlags flags, uint32_t start, uint32_t size) {
 	start = NormalizeAddress(start);
 
-	if (pendingNotifyMinAddr1 < start + size && pendingNotifyMaxAddr1 >= start)
-		FlushPendingMemInfo();
-	if (pendingNotifyMinAddr2 < start + size && pendingNotifyMaxAddr2 >= start)
-		FlushPendingMemInfo();
-
 	if (flags & MemBlockFlags::ALLOC) {
 		const char *tag = allocMap.FastFindWriteTag(MemBlockFlags::ALLOC, start, size);
 		if (tag)
@@ -549,34 +464,36 @@ static const char *FindWriteTagByFlag(MemBlockFlags flags, uint32_t start, uint3
 }
 
 size_t FormatMemWriteTagAt(char *buf, size_t sz, const char *prefix, uint32_t start, uint32_t size) {
-	const char *tag = FindWriteTagByFlag(MemBlockFlags::WRITE, start, size);
-	if (tag && strcmp(tag, "MemInit") != 0) {
-		return snprintf(buf, sz, "%s%s", prefix, tag);
-	}
-	// Fall back to alloc and texture, especially for VRAM.  We prefer write above.
-	tag = FindWriteTagByFlag(MemBlockFlags::ALLOC | MemBlockFlags::TEXTURE, start, size);
-	if (tag) {
-		return snprintf(buf, sz, "%s%s", prefix, tag);
+	if (MemBlockInfoEnabled()) {
+		// The tags point into the maps, so keep them locked until copied.
+		std::lock_guard<std::mutex> guard(mapMutex);
+		FlushPendingMemInfoLocked();
+		const char *tag = FindWriteTagByFlagLocked(MemBlockFlags::WRITE, start, size);
+		if (tag && strcmp(tag, "MemInit") != 0) {
+			return snprintf(buf, sz, "%s%s", prefix, tag);
+		}
+		// Fall back to alloc and texture, especially for VRAM.  We prefer write above.
+		tag = FindWriteTagByFlagLocked(MemBlockFlags::ALLOC | MemBlockFlags::TEXTURE, start, size);
+		if (tag) {
+			return snprintf(buf, sz, "%s%s", prefix, tag);
+		}
 	}
 	return snprintf(buf, sz, "%s%08x_size_%08x", prefix, start, size);
 }
 
 void MemBlockInfoInit() {
-	std::lock_guard<std::mutex> guard(pendingMutex);
-	pendingNotifies.reserve(MAX_PENDING_NOTIFIES);
-	pendingNotifyMinAddr1 = 0xFFFFFFFF;
-	pendingNotifyMaxAddr1 = 0;
-	pendingNotifyMinAddr2 = 0xFFFFFFFF;
-	pendingNotifyMaxAddr2 = 0;
+	std::lock_guard<std::mutex> guard(mapMutex);
+	// Anything notified before now is from a previous game.
+	FlushPendingMemInfoLocked(true);
 }
 
 void MemBlockInfoShutdown() {
-	std::lock_guard<std::mutex> guard(pendingMutex);
+	std::lock_guard<std::mutex> guard(mapMutex);
+	FlushPendingMemInfoLocked(true);
 	allocMap.Reset();
 	suballocMap.Reset();
 	writeMap.Reset();
 	textureMap.Reset();
-	pendingNotifies.clear();
 }
 
 void MemBlockInfoDoState(PointerWrap &p) {
@@ -584,7 +501,8 @@ void MemBlockInfoDoState(PointerWrap &p) {
 	if (!s)
 		return;
 
-	FlushPendingMemInfo();
+	std::lock_guard<std::mutex> guard(mapMutex);
+	FlushPendingMemInfoLocked();
 	allocMap.DoState(p);
 	suballocMap.DoState(p);
 	writeMap.DoState(p);
@@ -603,3 +521,7 @@ void MemBlockReleaseDetailed() {
 bool MemBlockInfoDetailed() {
 	return g_Config.bDebugMemInfoDetailed || detailedOverride != 0;
 }
+
+bool MemBlockInfoEnabled() {
+	return g_Config.bDebugMemInfo || MemBlockInfoDetailed();
+}
@@ -77,11 +77,13 @@ void MemBlockInfoDoState(PointerWrap &p);
 void MemBlockOverrideDetailed();
 void MemBlockReleaseDetailed();
 bool MemBlockInfoDetailed();
+// If false, nothing is recorded at all (memchecks still run.)  Detailed implies enabled.
+bool MemBlockInfoEnabled();
 
 static inline bool MemBlockInfoDetailed(uint32_t size) {
-	return size >= MEMINFO_MIN_SIZE || MemBlockInfoDetailed();
+	return (size >= MEMINFO_MIN_SIZE && MemBlockInfoEnabled()) || MemBlockInfoDetailed();
 }
 
 static inline bool MemBlockInfoDetailed(uint32_t size1, uint32_t size2) {
-	return size1 >= MEMINFO_MIN_SIZE || size2 >= MEMINFO_MIN_SIZE || MemBlockInfoDetailed();
+	return ((size1 >= MEMINFO_MIN_SIZE || size2 >= MEMINFO_MIN_SIZE) && MemBlockInfoEnabled()) || MemBlockInfoDetailed();
 }
@@ -40,6 +40,10 @@
 //  - "level": Integer severity level. (1 = NOTICE, 2 = ERROR, 3 = WARN, 4 = INFO, 5 = DEBUG, 6 = VERBOSE)
 //  - "ticket": Optional, present if in response to an event with a "ticket" field, simply repeats that value.
 //
+// Some events that return large buffers (memory.read, gpu.buffer.*, gpu.record.dump) accept a 'binary' type.
+// Their response then has a "binary" field with a size in bytes, and is immediately followed by a single
+// binary message with that many bytes of raw data.  This avoids the cost of base64.
+//
 // At start, please send a "version" event.  See WebSocket/GameSubscriber.cpp for more details.
 //
 // For other events, look inside Core/Debugger/WebSocket/ for details on each event.
@@ -60,6 +64,7 @@
 #include "Core/Debugger/WebSocket/InputSubscriber.h"
 #include "Core/Debugger/WebSocket/MemoryInfoSubscriber.h"
 #include "Core/Debugger/WebSocket/MemorySubscriber.h"
+#include "Core/Debugger/WebSocket/ProfilerSubscriber.h"
 #include "Core/Debugger/WebSocket/ReplaySubscriber.h"
 #include "Core/Debugger/WebSocket/SteppingSubscriber.h"
 
@@ -76,6 +81,7 @@ static const std::vector<SubscriberInit> subscribers({
 	&WebSocketInputInit,
 	&WebSocketMemoryInfoInit,
 	&WebSocketMemoryInit,
+	&WebSocketProfilerInit,
 	&WebSocketReplayInit,
 	&WebSocketSteppingInit,
 });
@@ -24,6 +24,7 @@
 #include "Core/HLE/sceKernelThread.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
+#include "Core/MIPS/IR/IRPassSimplify.h"
 #include "Core/Reporting.h"
 
 DebuggerSubscriber *WebSocketCPUCoreInit(DebuggerEventHandlerMap &map) {
@@ -35,6 +36,7 @@ DebuggerSubscriber *WebSocketCPUCoreInit(DebuggerEventHandlerMap &map) {
 	map["cpu.getReg"] = &WebSocketCPUGetReg;
 	map["cpu.setReg"] = &WebSocketCPUSetReg;
 	map["cpu.evaluate"] = &WebSocketCPUEvaluate;
+	map["cpu.irPassStats"] = &WebSocketCPUIRPassStats;
 
 	return nullptr;
 }
@@ -413,3 +415,33 @@ void WebSocketCPUEvaluate(DebuggerRequest &req) {
 	json.writeUint("uintValue", val);
 	json.writeString("floatValue", RegValueAsFloat(val));
 }
+
+// Retrieve statistics for the IR optimization passes (cpu.irPassStats)
+//
+// No parameters.
+//
+// Response (same event name):
+//  - passes: array of objects, in the order the passes first ran:
+//     - name: string name of the pass.
+//     - runs: number of blocks the pass ran on this game session.
+//     - changed: number of those runs that modified the block.
+//     - instructionsIn: total IR instructions given to the pass.
+//     - instructionsOut: total IR instructions produced by the pass.
+//     - seconds: total time spent in the pass, as a float.
+//
+// Only the IR based CPU cores collect these, so the array may be empty.
+void WebSocketCPUIRPassStats(DebuggerRequest &req) {
+	JsonWriter &json = req.Respond();
+	json.pushArray("passes");
+	for (const IRPassStats &pass : IRGetPassStats()) {
+		json.pushDict();
+		json.writeString("name", pass.name);
+		json.writeUint("runs", (uint32_t)pass.runs);
+		json.writeUint("changed", (uint32_t)pass.changed);
+		json.writeFloat("instructionsIn", (double)pass.instructionsIn);
+		json.writeFloat("instructionsOut", (double)pass.instructionsOut);
+		json.writeFloat("seconds", pass.seconds);
+		json.pop();
+	}
+	json.pop();
+}
@@ -223,6 +223,23 @@ static bool StreamBufferToBase64(DebuggerRequest &req, const GPUDebugBuffer &buf
 	return true;
 }
 
+// Note: Calls req.Respond().  Other data can be added afterward.
+static bool SendBufferAsBinary(DebuggerRequest &req, const GPUDebugBuffer &buf, bool isFramebuffer) {
+	size_t length = buf.GetStride() * buf.GetHeight() * buf.PixelSize();
+
+	auto &json = req.Respond();
+	json.writeInt("width", buf.GetStride());
+	json.writeInt("height", buf.GetHeight());
+	json.writeBool("flipped", buf.GetFlipped());
+	json.writeString("format", DescribeFormat(buf.GetFormat()));
+	if (isFramebuffer) {
+		json.writeBool("isFramebuffer", isFramebuffer);
+	}
+
+	req.RespondBinary(std::vector<uint8_t>(buf.GetData(), buf.GetData() + length));
+	return true;
+}
+
 static void GenericStreamBuffer(DebuggerRequest &req, std::function<bool(const GPUDebugBuffer *&, bool *isFramebuffer)> func) {
 	if (!currentDebugMIPS->isAlive()) {
 		return req.Fail("CPU not started");
@@ -240,8 +257,8 @@ static void GenericStreamBuffer(DebuggerRequest &req, std::function<bool(const G
 	std::string type = "uri";
 	if (!req.ParamString("type", &type, DebuggerParamType::OPTIONAL))
 		return;
-	if (type != "uri" && type != "base64")
-		return req.Fail("Parameter 'type' must be either 'uri' or 'base64'");
+	if (type != "uri" && type != "base64" && type != "binary")
+		return req.Fail("Parameter 'type' must be either 'uri', 'base64', or 'binary'");
 
 	const GPUDebugBuffer *buf = nullptr;
 	bool isFramebuffer = false;
@@ -252,6 +269,8 @@ static void GenericStreamBuffer(DebuggerRequest &req, std::function<bool(const G
 
 	if (type == "base64") {
 		StreamBufferToBase64(req, *buf, isFramebuffer);
+	} else if (type == "binary") {
+		SendBufferAsBinary(req, *buf, isFramebuffer);
 	} else if (type == "uri") {
 		StreamBufferToDataURI(req, *buf, isFramebuffer, includeAlpha, stackWidth);
 	} else {
@@ -262,7 +281,7 @@ static void GenericStreamBuffer(DebuggerRequest &req, std::function<bool(const G
 // Retrieve a screenshot (gpu.buffer.screenshot)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: either 'uri', 'base64', or 'binary'.
 //  - alpha: boolean to include the alpha channel for 'uri' type (not normally useful for screenshots.)
 //
 // Response (same event name) for 'uri' type:
@@ -270,12 +289,13 @@ static void GenericStreamBuffer(DebuggerRequest &req, std::function<bool(const G
 //  - height: numeric height of screenshot.
 //  - uri: data: URI of PNG image for display.
 //
-// Response (same event name) for 'base64' type:
+// Response (same event name) for 'base64' or 'binary' type:
 //  - width: numeric width of screenshot (also stride, in pixels, of binary data.)
 //  - height: numeric height of screenshot.
 //  - flipped: boolean to indicate whether buffer is vertically flipped.
 //  - format: string indicating format, such as 'R8G8B8A8_UNORM' or 'B8G8R8A8_UNORM'.
-//  - base64: base64 encode of binary data.
+//  - base64: base64 encode of binary data, for 'base64' type.
+//  - binary: for 'binary' type, size of the binary message that immediately follows with the data.
 void WebSocketGPUBufferScreenshot(DebuggerRequest &req) {
 	GenericStreamBuffer(req, [](const GPUDebugBuffer *&buf, bool *isFramebuffer) {
 		*isFramebuffer = false;
@@ -286,7 +306,7 @@ void WebSocketGPUBufferScreenshot(DebuggerRequest &req) {
 // Retrieve current color render buffer (gpu.buffer.renderColor)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: either 'uri', 'base64', or 'binary'.
 //  - alpha: boolean to include the alpha channel for 'uri' type.
 //
 // Response (same event name) for 'uri' type:
@@ -294,12 +314,13 @@ void WebSocketGPUBufferScreenshot(DebuggerRequest &req) {
 //  - height: numeric height of render buffer.
 //  - uri: data: URI of PNG image for display.
 //
-// Response (same event name) for 'base64' type:
+// Response (same event name) for 'base64' or 'binary' type:
 //  - width: numeric width of render buffer (also stride, in pixels, of binary data.)
 //  - height: numeric height of render buffer.
 //  - flipped: boolean to indicate whether buffer is vertically flipped.
 //  - format: string indicating format, such as 'R8G8B8A8_UNORM' or 'B8G8R8A8_UNORM'.
-//  - base64: base64 encode of binary data.
+//  - base64: base64 encode of binary data, for 'base64' type.
+//  - binary: for 'binary' type, size of the binary message that immediately follows with the data.
 void WebSocketGPUBufferRenderColor(DebuggerRequest &req) {
 	GenericStreamBuffer(req, [](const GPUDebugBuffer *&buf, bool *isFramebuffer) {
 		*isFramebuffer = false;
@@ -310,7 +331,7 @@ void WebSocketGPUBufferRenderColor(DebuggerRequest &req) {
 // Retrieve current depth render buffer (gpu.buffer.renderDepth)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: either 'uri', 'base64', or 'binary'.
 //  - alpha: true to use alpha to encode depth, otherwise red for 'uri' type.
 //
 // Response (same event name) for 'uri' type:
@@ -318,12 +339,13 @@ void WebSocketGPUBufferRenderColor(DebuggerRequest &req) {
 //  - height: numeric height of render buffer.
 //  - uri: data: URI of PNG image for display.
 //
-// Response (same event name) for 'base64' type:
+// Response (same event name) for 'base64' or 'binary' type:
 //  - width: numeric width of render buffer (also stride, in pixels, of binary data.)
 //  - height: numeric height of render buffer.
 //  - flipped: boolean to indicate whether buffer is vertically flipped.
 //  - format: string indicating format, such as 'D16', 'D24_X8' or 'D32F'.
-//  - base64: base64 encode of binary data.
+//  - base64: base64 encode of binary data, for 'base64' type.
+//  - binary: for 'binary' type, size of the binary message that immediately follows with the data.
 void WebSocketGPUBufferRenderDepth(DebuggerRequest &req) {
 	GenericStreamBuffer(req, [](const GPUDebugBuffer *&buf, bool *isFramebuffer) {
 		*isFramebuffer = false;
@@ -334,7 +356,7 @@ void WebSocketGPUBufferRenderDepth(DebuggerRequest &req) {
 // Retrieve current stencil render buffer (gpu.buffer.renderStencil)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: either 'uri', 'base64', or 'binary'.
 //  - alpha: true to use alpha to encode stencil, otherwise red for 'uri' type.
 //
 // Response (same event name) for 'uri' type:
@@ -342,12 +364,13 @@ void WebSocketGPUBufferRenderDepth(DebuggerRequest &req) {
 //  - height: numeric height of render buffer.
 //  - uri: data: URI of PNG image for display.
 //
-// Response (same event name) for 'base64' type:
+// Response (same event name) for 'base64' or 'binary' type:
 //  - width: numeric width of render buffer (also stride, in pixels, of binary data.)
 //  - height: numeric height of render buffer.
 //  - flipped: boolean to indicate whether buffer is vertically flipped.
 //  - format: string indicating format, such as 'X24_S8' or 'S8'.
-//  - base64: base64 encode of binary data.
+//  - base64: base64 encode of binary data, for 'base64' type.
+//  - binary: for 'binary' type, size of the binary message that immediately follows with the data.
 void WebSocketGPUBufferRenderStencil(DebuggerRequest &req) {
 	GenericStreamBuffer(req, [](const GPUDebugBuffer *&buf, bool *isFramebuffer) {
 		*isFramebuffer = false;
@@ -358,7 +381,7 @@ void WebSocketGPUBufferRenderStencil(DebuggerRequest &req) {
 // Retrieve current texture (gpu.buffer.texture)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: either 'uri', 'base64', or 'binary'.
 //  - alpha: boolean to include the alpha channel for 'uri' type.
 //  - level: texture mip level, default 0.
 //
@@ -368,13 +391,14 @@ void WebSocketGPUBufferRenderStencil(DebuggerRequest &req) {
 //  - isFramebuffer: optional, present and true if this came from a hardware framebuffer.
 //  - uri: data: URI of PNG image for display.
 //
-// Response (same event name) for 'base64' type:
+// Response (same event name) for 'base64' or 'binary' type:
 //  - width: numeric width and stride of the texture (often wider than visual.)
 //  - height: numeric height of the texture (often wider than visual.)
 //  - flipped: boolean to indicate whether buffer is vertically flipped.
 //  - format: string indicating format, such as 'R8G8B8A8_UNORM' or 'B8G8R8A8_UNORM'.
 //  - isFramebuffer: optional, present and true if this came from a hardware framebuffer.
-//  - base64: base64 encode of binary data.
+//  - base64: base64 encode of binary data, for 'base64' type.
+//  - binary: for 'binary' type, size of the binary message that immediately follows with the data.
 void WebSocketGPUBufferTexture(DebuggerRequest &req) {
 	u32 level = 0;
 	if (!req.ParamU32("level", &level, false, DebuggerParamType::OPTIONAL))
@@ -388,7 +412,7 @@ void WebSocketGPUBufferTexture(DebuggerRequest &req) {
 // Retrieve current CLUT (gpu.buffer.clut)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: either 'uri', 'base64', or 'binary'.
 //  - alpha: boolean to include the alpha channel for 'uri' type.
 //  - stackWidth: forced width for 'uri' type (increases height.)
 //
@@ -397,12 +421,13 @@ void WebSocketGPUBufferTexture(DebuggerRequest &req) {
 //  - height: numeric height of CLUT.
 //  - uri: data: URI of PNG image for display.
 //
-// Response (same event name) for 'base64' type:
+// Response (same event name) for 'base64' or 'binary' type:
 //  - width: number of pixels in CLUT.
 //  - height: always 1.
 //  - flipped: boolean to indicate whether buffer is vertically flipped.
 //  - format: string indicating format, such as 'R8G8B8A8_UNORM' or 'B8G8R8A8_UNORM'.
-//  - base64: base64 encode of binary data.
+//  - base64: base64 encode of binary data, for 'base64' type.
+//  - binary: for 'binary' type, size of the binary message that immediately follows with the data.
 void WebSocketGPUBufferClut(DebuggerRequest &req) {
 	GenericStreamBuffer(req, [](const GPUDebugBuffer *&buf, bool *isFramebuffer) {
 		// TODO: Or maybe it could be?
@@ -30,6 +30,7 @@ struct WebSocketGPURecordState : public DebuggerSubscriber {
 
 protected:
 	bool pending_ = false;
+	bool binary_ = false;
 	std::string lastTicket_;
 	Path lastFilename_;
 };
@@ -49,20 +50,31 @@ WebSocketGPURecordState::~WebSocketGPURecordState() {
 
 // Begin recording (gpu.record.dump)
 //
-// No parameters.
+// Parameters:
+//  - type: optional, 'uri' (default) or 'binary'.
 //
-// Response (same event name):
+// Response (same event name) for 'uri':
 //  - uri: data: URI containing debug dump data.
 //
+// Response (same event name) for 'binary':
+//  - binary: size of the binary message that immediately follows, containing the debug dump data.
+//
 // Note: recording may take a moment.
 void WebSocketGPURecordState::Dump(DebuggerRequest &req) {
 	if (!PSP_IsInited())
 		return req.Fail("CPU not started");
 
+	std::string type = "uri";
+	if (!req.ParamString("type", &type, DebuggerParamType::OPTIONAL))
+		return;
+	if (type != "uri" && type != "binary")
+		return req.Fail("Parameter 'type' must be either 'uri' or 'binary'");
+
 	if (!GPURecord::Activate())
 		return req.Fail("Recording already in progress");
 
 	pending_ = true;
+	binary_ = type == "binary";
 	GPURecord::SetCallback([=](const Path &filename) {
 		lastFilename_ = filename;
 		pending_ = false;
@@ -81,6 +93,29 @@ void WebSocketGPURecordState::Broadcast(net::WebSocketServer *ws) {
 			return;
 		}
 
+		if (binary_) {
+			std::vector<uint8_t> data;
+			uint8_t buf[16384];
+			size_t bytes;
+			while ((bytes = fread(buf, 1, sizeof(buf), fp)) != 0)
+				data.insert(data.end(), buf, buf + bytes);
+			fclose(fp);
+
+			JsonWriter json;
+			json.begin();
+			json.writeString("event", "gpu.record.dump");
+			if (!lastTicket_.empty())
+				json.writeRaw("ticket", lastTicket_);
+			json.writeUint("binary", (uint32_t)data.size());
+			json.end();
+			ws->Send(json.str());
+			ws->Send(data);
+
+			lastFilename_.clear();
+			lastTicket_.clear();
+			return;
+		}
+
 		// We write directly to the stream since this is a large chunk of data.
 		ws->AddFragment(false, R"({"event":"gpu.record.dump")");
 		if (!lastTicket_.empty()) {
@@ -20,6 +20,9 @@
 #include "Core/Debugger/WebSocket/GPUStatsSubscriber.h"
 #include "Core/HW/Display.h"
 #include "Core/System.h"
+#include "GPU/GeDisasm.h"
+#include "GPU/GPU.h"
+#include "GPU/Debugger/Debugger.h"
 
 struct CollectedStats {
 	float vps;
@@ -66,11 +69,61 @@ struct DebuggerGPUStatsEvent {
 	}
 };
 
+// Counters since the previous flip.
+struct FrameCounters {
+	int frame;
+	GPUStatistics stats;
+};
+
+struct DebuggerGPUCountersEvent {
+	const FrameCounters &c;
+
+	operator std::string() {
+		const GPUStatistics &s = c.stats;
+		JsonWriter j;
+		j.begin();
+		j.writeString("event", "gpu.stats.counters");
+		j.writeInt("frame", c.frame);
+		j.writeInt("drawCalls", s.numDrawCalls);
+		j.writeInt("vertices", s.numVertsSubmitted);
+		j.pushDict("flushes");
+		j.writeInt("total", s.numFlushes);
+		j.writeInt("stateChange", s.numFlushesStateChange);
+		j.writeInt("primChange", s.numFlushesPrimChange);
+		j.writeInt("bufferFull", s.numFlushesBufferFull);
+		j.pop();
+		j.pushDict("textures");
+		j.writeInt("decoded", s.numTexturesDecoded);
+		j.writeInt("uploadBytes", s.numTextureDataBytesUploaded);
+		j.writeInt("cacheHits", s.numTextureCacheHits);
+		j.writeInt("cacheMisses", s.numTextureCacheMisses);
+		j.writeInt("invalidations", s.numTextureInvalidations);
+		j.pop();
+		j.pushDict("framebuffers");
+		j.writeInt("created", s.numFramebufferCreations);
+		j.writeInt("renderTargetSwitches", s.numRenderTargetSwitches);
+		j.writeInt("readbacks", s.numReadbacks);
+		j.writeInt("blockingReadbacks", s.numBlockingReadbacks);
+		j.writeInt("uploads", s.numUploads);
+		j.writeInt("clears", s.numClears);
+		j.pop();
+		j.pushDict("shaders");
+		j.writeInt("compiles", s.numShaderCompiles);
+		j.writeInt("pipelineCreations", s.numPipelineCreations);
+		j.pop();
+		j.end();
+		return j.str();
+	}
+};
+
 struct WebSocketGPUStatsState : public DebuggerSubscriber {
 	WebSocketGPUStatsState();
 	~WebSocketGPUStatsState();
 	void Get(DebuggerRequest &req);
 	void Feed(DebuggerRequest &req);
+	void Counters(DebuggerRequest &req);
+	void ProfileEnable(DebuggerRequest &req);
+	void ProfileGet(DebuggerRequest &req);
 
 	void Broadcast(net::WebSocketServer *ws) override;
 
@@ -78,19 +131,28 @@ struct WebSocketGPUStatsState : public DebuggerSubscriber {
 	void FlipListener();
 
 protected:
+	void CollectCounters();
+
 	bool forced_ = false;
 	bool sendNext_ = false;
 	bool sendFeed_ = false;
+	bool sendCounters_ = false;
+	bool profiling_ = false;
 
 	std::string lastTicket_;
 	std::mutex pendingLock_;
 	std::vector<CollectedStats> pendingStats_;
+	std::vector<FrameCounters> pendingCounters_;
+	GPUStatistics lastCounters_{};
 };
 
 DebuggerSubscriber *WebSocketGPUStatsInit(DebuggerEventHandlerMap &map) {
 	auto p = new WebSocketGPUStatsState();
 	map["gpu.stats.get"] = std::bind(&WebSocketGPUStatsState::Get, p, std::placeholders::_1);
 	map["gpu.stats.feed"] = std::bind(&WebSocketGPUStatsState::Feed, p, std::placeholders::_1);
+	map["gpu.stats.counters"] = std::bind(&WebSocketGPUStatsState::Counters, p, std::placeholders::_1);
+	map["gpu.profile.enable"] = std::bind(&WebSocketGPUStatsState::ProfileEnable, p, std::placeholders::_1);
+	map["gpu.profile.get"] = std::bind(&WebSocketGPUStatsState::ProfileGet, p, std::placeholders::_1);
 
 	return p;
 }
@@ -102,6 +164,8 @@ WebSocketGPUStatsState::WebSocketGPUStatsState() {
 WebSocketGPUStatsState::~WebSocketGPUStatsState() {
 	if (forced_)
 		Core_ForceDebugStats(false);
+	if (profiling_)
+		GPUDebug::SetProfiling(false);
 	__DisplayForgetFlip(&WebSocketGPUStatsState::FlipForwarder, this);
 }
 
@@ -111,6 +175,8 @@ void WebSocketGPUStatsState::FlipForwarder(void *thiz) {
 }
 
 void WebSocketGPUStatsState::FlipListener() {
+	if (sendCounters_)
+		CollectCounters();
 	if (!sendNext_ && !sendFeed_)
 		return;
 
@@ -134,6 +200,45 @@ void WebSocketGPUStatsState::FlipListener() {
 	sendNext_ = false;
 }
 
+void WebSocketGPUStatsState::CollectCounters() {
+	// The UI resets gpuStats each host frame, but nothing runs between a flip and that reset.
+	// So if a counter went down, its current value is what happened since the last flip.
+	auto delta = [](int cur, int &last) {
+		int d = cur >= last ? cur - last : cur;
+		last = cur;
+		return d;
+	};
+
+	std::lock_guard<std::mutex> guard(pendingLock_);
+	// Don't grow without bound if the client isn't keeping up.
+	if (pendingCounters_.size() >= 600)
+		pendingCounters_.erase(pendingCounters_.begin());
+
+	FrameCounters c{};
+	c.frame = gpuStats.numFlips;
+	GPUStatistics &last = lastCounters_;
+	c.stats.numDrawCalls = delta(gpuStats.numDrawCalls, last.numDrawCalls);
+	c.stats.numVertsSubmitted = delta(gpuStats.numVertsSubmitted, last.numVertsSubmitted);
+	c.stats.numFlushes = delta(gpuStats.numFlushes, last.numFlushes);
+	c.stats.numFlushesStateChange = delta(gpuStats.numFlushesStateChange, last.numFlushesStateChange);
+	c.stats.numFlushesPrimChange = delta(gpuStats.numFlushesPrimChange, last.numFlushesPrimChange);
+	c.stats.numFlushesBufferFull = delta(gpuStats.numFlushesBufferFull, last.numFlushesBufferFull);
+	c.stats.numTexturesDecoded = delta(gpuStats.numTexturesDecoded, last.numTexturesDecoded);
+	c.stats.numTextureDataBytesUploaded = delta(gpuStats.numTextureDataBytesUploaded, last.numTextureDataBytesUploaded);
+	c.stats.numTextureCacheHits = delta(gpuStats.numTextureCacheHits, last.numTextureCacheHits);
+	c.stats.numTextureCacheMisses = delta(gpuStats.numTextureCacheMisses, last.numTextureCacheMisses);
+	c.stats.numTextureInvalidations = delta(gpuStats.numTextureInvalidations, last.numTextureInvalidations);
+	c.stats.numFramebufferCreations = delta(gpuStats.numFramebufferCreations, last.numFramebufferCreations);
+	c.stats.numRenderTargetSwitches = delta(gpuStats.numRenderTargetSwitches, last.numRenderTargetSwitches);
+	c.stats.numReadbacks = delta(gpuStats.numReadbacks, last.numReadbacks);
+	c.stats.numBlockingReadbacks = delta(gpuStats.numBlockingReadbacks, last.numBlockingReadbacks);
+	c.stats.numUploads = delta(gpuStats.numUploads, last.numUploads);
+	c.stats.numClears = delta(gpuStats.numClears, last.numClears);
+	c.stats.numShaderCompiles = delta(gpuStats.numShaderCompiles, last.numShaderCompiles);
+	c.stats.numPipelineCreations = delta(gpuStats.numPipelineCreations, last.numPipelineCreations);
+	pendingCounters_.push_back(c);
+}
+
 // Get next GPU stats (gpu.stats.get)
 //
 // No parameters.
@@ -183,8 +288,129 @@ void WebSocketGPUStatsState::Feed(DebuggerRequest &req) {
 	}
 }
 
+// Setup GPU counters feed (gpu.stats.counters)
+//
+// Parameters:
+//  - enable: optional boolean, pass false to stop the feed.
+//
+// No immediate response.  Events sent each frame (as gpu.stats.counters) with:
+//  - frame: number, flip count of the frame.
+//  - drawCalls: number of draw calls.
+//  - vertices: number of vertices submitted.
+//  - flushes: object with "total", "stateChange", "primChange", and "bufferFull" counts.
+//  - textures: object with "decoded", "uploadBytes", "cacheHits", "cacheMisses", and "invalidations".
+//  - framebuffers: object with "created", "renderTargetSwitches", "readbacks", "blockingReadbacks",
+//    "uploads", and "clears".
+//  - shaders: object with "compiles" and "pipelineCreations" (Vulkan pipelines or GL programs.)
+//
+// Note: unlike gpu.stats.feed, this doesn't enable debug stats, so it has little overhead.
+void WebSocketGPUStatsState::Counters(DebuggerRequest &req) {
+	if (!PSP_IsInited())
+		return req.Fail("CPU not started");
+	bool enable = true;
+	if (!req.ParamBool("enable", &enable, DebuggerParamType::OPTIONAL))
+		return;
+
+	std::lock_guard<std::mutex> guard(pendingLock_);
+	if (enable && !sendCounters_) {
+		// Start counting from now.
+		lastCounters_ = gpuStats;
+	}
+	sendCounters_ = enable;
+	if (!enable)
+		pendingCounters_.clear();
+}
+
+// Enable or disable GE command profiling (gpu.profile.enable)
+//
+// While enabled, host time spent on each GE command and display list is summed by address.
+// This runs the GPU in the slower debugger mode, so totals are higher than normal.
+//
+// Parameters:
+//  - enable: optional boolean, pass false to stop profiling.
+//  - reset: optional boolean, pass true to discard previous results.
+//
+// Empty response.
+void WebSocketGPUStatsState::ProfileEnable(DebuggerRequest &req) {
+	bool enable = true;
+	bool reset = false;
+	if (!req.ParamBool("enable", &enable, DebuggerParamType::OPTIONAL))
+		return;
+	if (!req.ParamBool("reset", &reset, DebuggerParamType::OPTIONAL))
+		return;
+
+	if (reset)
+		GPUDebug::ResetProfile();
+	GPUDebug::SetProfiling(enable);
+	profiling_ = enable;
+	req.Respond();
+}
+
+// Retrieve GE command profile (gpu.profile.get)
+//
+// Parameters:
+//  - count: optional number of commands to return, most expensive first (default 100.)
+//
+// Response (same event name):
+//  - active: boolean, whether still profiling.
+//  - commands: array of objects:
+//     - address: unsigned integer, GE address of the command.
+//     - op: unsigned integer, full command word.
+//     - desc: string, disassembly of the command.
+//     - count: number of times executed.
+//     - seconds: host seconds spent, including any flush or framebuffer work it caused.
+//     - flushSeconds: part of seconds spent flushing draws before a state change.
+//     - cycles: estimated PSP GE cycles.
+//  - lists: array of objects, all lists most expensive first:
+//     - address: unsigned integer, start address of the display list.
+//     - count: number of times run, counting each resume after a stall.
+//     - seconds: host seconds spent.
+//     - cycles: estimated PSP GE cycles.
+void WebSocketGPUStatsState::ProfileGet(DebuggerRequest &req) {
+	uint32_t count = 100;
+	if (!req.ParamU32("count", &count, false, DebuggerParamType::OPTIONAL))
+		return;
+
+	JsonWriter &json = req.Respond();
+	json.writeBool("active", GPUDebug::IsProfiling());
+
+	std::vector<GPUDebug::CommandCost> commands = GPUDebug::GetCommandCosts();
+	json.pushArray("commands");
+	for (size_t i = 0; i < commands.size() && i < count; ++i) {
+		const auto &c = commands[i];
+		char desc[256];
+		GeDisassembleOp(c.pc, c.op, 0, desc, sizeof(desc));
+
+		json.pushDict();
+		json.writeUint("address", c.pc);
+		json.writeUint("op", c.op);
+		json.writeString("desc", desc);
+		json.writeInt("count", c.count);
+		json.writeFloat("seconds", c.seconds);
+		json.writeFloat("flushSeconds", c.flushSeconds);
+		json.writeFloat("cycles", (double)c.cycles);
+		json.pop();
+	}
+	json.pop();
+
+	json.pushArray("lists");
+	for (const auto &l : GPUDebug::GetListCosts()) {
+		json.pushDict();
+		json.writeUint("address", l.startpc);
+		json.writeInt("count", l.count);
+		json.writeFloat("seconds", l.seconds);
+		json.writeFloat("cycles", (double)l.cycles);
+		json.pop();
+	}
+	json.pop();
+}
+
 void WebSocketGPUStatsState::Broadcast(net::WebSocketServer *ws) {
 	std::lock_guard<std::mutex> guard(pendingLock_);
+	for (const FrameCounters &c : pendingCounters_)
+		ws->Send(DebuggerGPUCountersEvent{ c });
+	pendingCounters_.clear();
+
 	if (lastTicket_.empty() && !sendFeed_) {
 		pendingStats_.clear();
 		return;
@@ -26,13 +26,32 @@
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/MIPS/MIPSStackWalk.h"
+#include "Core/HLE/HLE.h"
 #include "Core/HLE/sceKernelThread.h"
 #include "Core/Reporting.h"
+#include "Core/System.h"
+
+class WebSocketHLEStatsState : public DebuggerSubscriber {
+public:
+	~WebSocketHLEStatsState() {
+		UpdateForced(false);
+	}
+
+	void Stats(DebuggerRequest &req);
+
+protected:
+	void UpdateForced(bool flag);
+
+	bool forced_ = false;
+};
 
 DebuggerSubscriber *WebSocketHLEInit(DebuggerEventHandlerMap &map) {
+	auto p = new WebSocketHLEStatsState();
+	map["hle.stats"] = std::bind(&WebSocketHLEStatsState::Stats, p, std::placeholders::_1);
 	map["hle.thread.list"] = &WebSocketHLEThreadList;
 	map["hle.thread.wake"] = &WebSocketHLEThreadWake;
 	map["hle.thread.stop"] = &WebSocketHLEThreadStop;
+	map["hle.scheduler.stats"] = &WebSocketHLESchedulerStats;
 	map["hle.func.list"] = &WebSocketHLEFuncList;
 	map["hle.func.add"] = &WebSocketHLEFuncAdd;
 	map["hle.func.remove"] = &WebSocketHLEFuncRemove;
@@ -42,7 +61,60 @@ DebuggerSubscriber *WebSocketHLEInit(DebuggerEventHandlerMap &map) {
 	map["hle.module.list"] = &WebSocketHLEModuleList;
 	map["hle.backtrace"] = &WebSocketHLEBacktrace;
 
-	return nullptr;
+	return p;
+}
+
+void WebSocketHLEStatsState::UpdateForced(bool flag) {
+	if (forced_ != flag)
+		Core_ForceDebugStats(flag);
+	forced_ = flag;
+}
+
+// Get and control per-syscall profiling (hle.stats)
+//
+// Parameters:
+//  - enable: optional boolean, true to start collecting and false to stop (for this connection.)
+//  - reset: optional boolean, pass true to clear all counters after responding.
+//
+// Response (same event name):
+//  - enabled: boolean, true if syscalls are currently being profiled.
+//  - calls: array of objects, slowest total host time first, each with properties:
+//     - module: string name of the module, e.g. 'sceCtrl'.
+//     - name: string name of the function.
+//     - count: number of times the syscall was called.
+//     - hostNanos: number of nanoseconds spent in the syscall on the host.
+//     - cycles: number of emulated cycles the syscall ate.
+//
+// Note: collection starts applying after the next frame, and stays on if enabled elsewhere (debug stats.)
+void WebSocketHLEStatsState::Stats(DebuggerRequest &req) {
+	if (!PSP_IsInited())
+		return req.Fail("CPU not active");
+
+	bool enable = forced_;
+	if (!req.ParamBool("enable", &enable, DebuggerParamType::OPTIONAL))
+		return;
+	bool reset = false;
+	if (!req.ParamBool("reset", &reset, DebuggerParamType::OPTIONAL))
+		return;
+
+	UpdateForced(enable);
+	std::vector<HLESyscallProfile> profile = hleGetSyscallProfile();
+	if (reset)
+		hleResetSyscallProfile();
+
+	JsonWriter &json = req.Respond();
+	json.writeBool("enabled", coreCollectDebugStats || forced_);
+	json.pushArray("calls");
+	for (const HLESyscallProfile &entry : profile) {
+		json.pushDict();
+		json.writeString("module", entry.module);
+		json.writeString("name", entry.name);
+		json.writeFloat("count", (double)entry.calls);
+		json.writeFloat("hostNanos", (double)entry.hostNanos);
+		json.writeFloat("cycles", (double)entry.cycles);
+		json.pop();
+	}
+	json.pop();
 }
 
 // List all current HLE threads (hle.thread.list)
@@ -195,6 +267,43 @@ void WebSocketHLEThreadStop(DebuggerRequest &req) {
 	json.writeString("status", "dormant");
 }
 
+// Get thread scheduler counters (hle.scheduler.stats)
+//
+// No parameters.
+//
+// Response (same event name):
+//  - reschedules: number of times the scheduler ran since the game started.
+//  - contextSwitches: number of times the running thread changed since the game started.
+//  - frameReschedules: unsigned integer, reschedules during the last vblank.
+//  - frameContextSwitches: unsigned integer, context switches during the last vblank.
+//  - waits: array of objects, one for each wait type used at least once, each with properties:
+//     - type: numeric wait type, as in hle.thread.list.
+//     - name: string name of the wait type, e.g. 'Semaphore'.
+//     - count: number of times a thread started waiting this way.
+void WebSocketHLESchedulerStats(DebuggerRequest &req) {
+	if (!PSP_IsInited())
+		return req.Fail("CPU not active");
+
+	KernelSchedulerStats stats = __KernelGetSchedulerStats();
+
+	JsonWriter &json = req.Respond();
+	json.writeFloat("reschedules", (double)stats.reschedules);
+	json.writeFloat("contextSwitches", (double)stats.contextSwitches);
+	json.writeUint("frameReschedules", stats.frameReschedules);
+	json.writeUint("frameContextSwitches", stats.frameContextSwitches);
+	json.pushArray("waits");
+	for (int i = 0; i < NUM_WAITTYPES; ++i) {
+		if (stats.waits[i] == 0)
+			continue;
+		json.pushDict();
+		json.writeInt("type", i);
+		json.writeString("name", getWaitTypeName((WaitType)i));
+		json.writeFloat("count", (double)stats.waits[i]);
+		json.pop();
+	}
+	json.pop();
+}
+
 // List all current known function symbols (hle.func.list)
 //
 // No parameters.
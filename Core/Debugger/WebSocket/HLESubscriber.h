@@ -24,6 +24,7 @@ DebuggerSubscriber *WebSocketHLEInit(DebuggerEventHandlerMap &map);
 void WebSocketHLEThreadList(DebuggerRequest &req);
 void WebSocketHLEThreadWake(DebuggerRequest &req);
 void WebSocketHLEThreadStop(DebuggerRequest &req);
+void WebSocketHLESchedulerStats(DebuggerRequest &req);
 void WebSocketHLEFuncList(DebuggerRequest &req);
 void WebSocketHLEFuncAdd(DebuggerRequest &req);
 void WebSocketHLEFuncRemove(DebuggerRequest &req);
@@ -187,9 +187,15 @@ void WebSocketMemoryReadU32(DebuggerRequest &req) {
 //  - address: unsigned integer address for the start of the memory range.
 //  - size: unsigned integer specifying size of memory range.
 //  - replacements: optional, false to ignore PPSSPP replacements in MIPS code.
+//  - type: optional, 'base64' (default) or 'binary'.
 //
-// Response (same event name):
+// Response (same event name) for 'base64':
 //  - base64: base64 encode of binary data.
+//
+// Response (same event name) for 'binary':
+//  - binary: size in bytes of the binary message that immediately follows, containing the data.
+//
+// Note: the CPU is only paused while the range is copied, not while it's encoded or sent.
 void WebSocketMemoryRead(DebuggerRequest &req) {
 	uint32_t addr;
 	if (!req.ParamU32("address", &addr))
@@ -200,17 +206,33 @@ void WebSocketMemoryRead(DebuggerRequest &req) {
 	bool replacements = true;
 	if (!req.ParamBool("replacements", &replacements, DebuggerParamType::OPTIONAL))
 		return;
-
-	auto memLock = LockMemoryAndCPU(addr, replacements);
-	if (!currentDebugMIPS->isAlive() || !Memory::IsActive())
-		return req.Fail("CPU not started");
-
-	if (!Memory::IsValidAddress(addr))
-		return req.Fail("Invalid address");
-	else if (!Memory::IsValidRange(addr, size))
-		return req.Fail("Invalid size");
+	std::string type = "base64";
+	if (!req.ParamString("type", &type, DebuggerParamType::OPTIONAL))
+		return;
+	if (type != "base64" && type != "binary")
+		return req.Fail("Invalid type, must be either base64 or binary");
+
+	std::vector<uint8_t> data;
+	{
+		auto memLock = LockMemoryAndCPU(addr, replacements);
+		if (!currentDebugMIPS->isAlive() || !Memory::IsActive())
+			return req.Fail("CPU not started");
+
+		if (!Memory::IsValidAddress(addr))
+			return req.Fail("Invalid address");
+		else if (!Memory::IsValidRange(addr, size))
+			return req.Fail("Invalid size");
+
+		const uint8_t *p = Memory::GetPointerUnchecked(addr);
+		data.assign(p, p + size);
+	}
 
 	JsonWriter &json = req.Respond();
+	if (type == "binary") {
+		req.RespondBinary(std::move(data));
+		return;
+	}
+
 	// Start a value without any actual data yet...
 	json.writeRaw("base64", "");
 	req.Flush();
@@ -221,7 +243,7 @@ void WebSocketMemoryRead(DebuggerRequest &req) {
 	static const size_t CHUNK_SIZE = 65535;
 	for (size_t i = 0; i < size; i += CHUNK_SIZE) {
 		size_t left = std::min(size - i, CHUNK_SIZE);
-		req.ws->AddFragment(false, Base64Encode(Memory::GetPointerUnchecked(addr) + i, left));
+		req.ws->AddFragment(false, Base64Encode(data.data() + i, left));
 	}
 	req.ws->AddFragment(false, "\"");
 }
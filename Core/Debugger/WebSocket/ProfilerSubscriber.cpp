@@ -0,0 +1,127 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "Common/Profiler/MemoryUsage.h"
+#include "Common/Profiler/Profiler.h"
+#include "Core/Debugger/WebSocket/ProfilerSubscriber.h"
+
+DebuggerSubscriber *WebSocketProfilerInit(DebuggerEventHandlerMap &map) {
+	// The tracer is global, nothing to alloc.
+	map["profiler.trace.start"] = &WebSocketProfilerTraceStart;
+	map["profiler.trace.stop"] = &WebSocketProfilerTraceStop;
+	map["profiler.trace.get"] = &WebSocketProfilerTraceGet;
+	map["profiler.memory.get"] = &WebSocketProfilerMemoryGet;
+	map["profiler.memory.setBudget"] = &WebSocketProfilerMemorySetBudget;
+
+	return nullptr;
+}
+
+// Start recording trace events (profiler.trace.start)
+//
+// Discards any events recorded before.  Each thread keeps only its most recent events, so
+// fetch the trace soon after the interesting part.
+//
+// No parameters.
+//
+// Empty response.
+void WebSocketProfilerTraceStart(DebuggerRequest &req) {
+	Tracer_Start();
+	req.Respond();
+}
+
+// Stop recording trace events (profiler.trace.stop)
+//
+// Recorded events are kept until the next start.
+//
+// No parameters.
+//
+// Empty response.
+void WebSocketProfilerTraceStop(DebuggerRequest &req) {
+	Tracer_Stop();
+	req.Respond();
+}
+
+// Retrieve recorded trace events (profiler.trace.get)
+//
+// Can be used while still recording.
+//
+// No parameters.
+//
+// Response (same event name):
+//  - active: boolean, whether events are still being recorded.
+//  - trace: object in Chrome trace event format, can be saved to a file and opened in
+//    Perfetto or chrome://tracing.
+void WebSocketProfilerTraceGet(DebuggerRequest &req) {
+	JsonWriter &json = req.Respond();
+	json.writeBool("active", Tracer_IsActive());
+	json.writeRaw("trace", Tracer_ExportJSON());
+}
+
+// Retrieve host memory used by caches (profiler.memory.get)
+//
+// Only the larger caches are tracked, and some are estimates.
+//
+// No parameters.
+//
+// Response (same event name):
+//  - categories: array of objects:
+//     - name: string, e.g. "textureCache" or "rewind".
+//     - bytes: number of bytes currently used.
+//     - peak: highest number of bytes used since startup or a reset of peaks in the UI.
+//     - budget: number of bytes allowed before the cache is asked to trim, or 0 for none.
+//     - overBudget: boolean, whether currently over budget.
+void WebSocketProfilerMemoryGet(DebuggerRequest &req) {
+	JsonWriter &json = req.Respond();
+	json.pushArray("categories");
+	for (int i = 0; i < (int)MemoryCategory::COUNT; ++i) {
+		MemoryCategory cat = (MemoryCategory)i;
+		json.pushDict();
+		json.writeString("name", MemUsageCategoryName(cat));
+		json.writeFloat("bytes", (double)MemUsage_Get(cat));
+		json.writeFloat("peak", (double)MemUsage_GetPeak(cat));
+		json.writeFloat("budget", (double)MemUsage_GetBudget(cat));
+		json.writeBool("overBudget", MemUsage_IsOverBudget(cat));
+		json.pop();
+	}
+	json.pop();
+}
+
+// Set a memory budget for a cache (profiler.memory.setBudget)
+//
+// Caches over budget trim themselves at their next safe point, more aggressively than usual.
+// Budgets are not saved.
+//
+// Parameters:
+//  - category: string, name as returned by profiler.memory.get.
+//  - megabytes: unsigned integer, budget in MB, or 0 to remove the budget.
+//
+// Empty response.
+void WebSocketProfilerMemorySetBudget(DebuggerRequest &req) {
+	std::string name;
+	uint32_t megabytes;
+	if (!req.ParamString("category", &name))
+		return;
+	if (!req.ParamU32("megabytes", &megabytes))
+		return;
+
+	MemoryCategory cat = MemUsageCategoryFromName(name.c_str());
+	if (cat == MemoryCategory::COUNT)
+		return req.Fail("Unknown memory category");
+
+	MemUsage_SetBudget(cat, (int64_t)megabytes * 1024 * 1024);
+	req.Respond();
+}
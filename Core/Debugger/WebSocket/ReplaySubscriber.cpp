@@ -32,6 +32,8 @@ DebuggerSubscriber *WebSocketReplayInit(DebuggerEventHandlerMap &map) {
 	map["replay.status"] = &WebSocketReplayStatus;
 	map["replay.time.get"] = &WebSocketReplayTimeGet;
 	map["replay.time.set"] = &WebSocketReplayTimeSet;
+	map["replay.keyframes"] = &WebSocketReplayKeyframes;
+	map["replay.seek"] = &WebSocketReplaySeek;
 
 	return nullptr;
 }
@@ -155,3 +157,47 @@ void WebSocketReplayTimeSet(DebuggerRequest &req) {
 	RtcSetBaseTime((int32_t)value);
 	req.Respond();
 }
+
+// Save keyframes while recording or executing (replay.keyframes)
+//
+// Keyframes are save states, named by emulated time, used by replay.seek.  Each one can also be
+// loaded by a separate instance to execute the replay from that point.
+//
+// Parameters:
+//  - directory: string, where to save them (created if needed.)
+//  - interval: unsigned integer, emulated seconds between keyframes, or 0 to stop.
+//
+// Empty response.
+void WebSocketReplayKeyframes(DebuggerRequest &req) {
+	std::string directory;
+	if (!req.ParamString("directory", &directory))
+		return;
+	uint32_t interval;
+	if (!req.ParamU32("interval", &interval))
+		return;
+
+	ReplaySetKeyframes(Path(directory), (int)interval);
+	req.Respond();
+}
+
+// Seek an executing replay using keyframes (replay.seek)
+//
+// Loads the latest keyframe at or before the specified time, and continues the replay from there.
+// The replay must have been executed from the start of the session.
+//
+// Parameters:
+//  - ms: unsigned integer, emulated time in milliseconds since boot.
+//
+// Empty response, sent once the keyframe load is queued.
+void WebSocketReplaySeek(DebuggerRequest &req) {
+	if (!PSP_IsInited())
+		return req.Fail("Game not running");
+
+	uint32_t ms;
+	if (!req.ParamU32("ms", &ms))
+		return;
+
+	if (!ReplaySeekKeyframe((uint64_t)ms * 1000ULL))
+		return req.Fail("Replay not executing or no keyframe found");
+	req.Respond();
+}
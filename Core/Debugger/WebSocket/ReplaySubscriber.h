@@ -28,3 +28,5 @@ void WebSocketReplayExecute(DebuggerRequest &req);
 void WebSocketReplayStatus(DebuggerRequest &req);
 void WebSocketReplayTimeGet(DebuggerRequest &req);
 void WebSocketReplayTimeSet(DebuggerRequest &req);
+void WebSocketReplayKeyframes(DebuggerRequest &req);
+void WebSocketReplaySeek(DebuggerRequest &req);
@@ -45,6 +45,11 @@ bool DebuggerRequest::Finish() {
 			ws->AddFragment(true, writer_.str());
 		else
 			ws->Send(writer_.str());
+		if (hasBinary_) {
+			ws->Send(binary_);
+			binary_.clear();
+			hasBinary_ = false;
+		}
 		responseBegun_ = false;
 		responseSent_ = true;
 		responsePartial_ = false;
@@ -54,10 +59,18 @@ bool DebuggerRequest::Finish() {
 }
 
 void DebuggerRequest::Flush() {
+	_assert_(!hasBinary_);
 	ws->AddFragment(false, writer_.flush());
 	responsePartial_ = true;
 }
 
+void DebuggerRequest::RespondBinary(std::vector<uint8_t> &&payload) {
+	_assert_(responseBegun_ && !responsePartial_);
+	writer_.writeUint("binary", (uint32_t)payload.size());
+	binary_ = std::move(payload);
+	hasBinary_ = true;
+}
+
 static bool U32FromString(const char *str, uint32_t *out, bool allowFloat) {
 	if (TryParse(str, out))
 		return true;
@@ -20,6 +20,7 @@
 #include "ppsspp_config.h"
 
 #include <string>
+#include <vector>
 
 #include "Common/Log.h"
 #include "Common/Data/Format/JSONReader.h"
@@ -92,8 +93,14 @@ struct DebuggerRequest {
 	void Flush();
 	bool Finish();
 
+	// Call after Respond().  Adds a "binary" size to the response, and sends the payload right
+	// after it as a single binary message.  Can't be combined with Flush().
+	void RespondBinary(std::vector<uint8_t> &&payload);
+
 private:
 	JsonWriter writer_;
+	std::vector<uint8_t> binary_;
+	bool hasBinary_ = false;
 	bool responseBegun_ = false;
 	bool responseSent_ = false;
 	bool responsePartial_ = false;
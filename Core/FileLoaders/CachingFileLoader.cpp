@@ -19,6 +19,8 @@
 #include <thread>
 #include <algorithm>
 
+#include "Common/Log.h"
+#include "Common/Profiler/MemoryUsage.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/TimeUtil.h"
 #include "Core/FileLoaders/CachingFileLoader.h"
@@ -81,11 +83,15 @@ size_t CachingFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flag
 	if ((flags & Flags::HINT_UNCACHED) != 0) {
 		readSize = backend_->ReadAt(absolutePos, bytes, data, flags);
 	} else {
-		readSize = ReadFromCache(absolutePos, bytes, data);
+		readSize = ReadFromCache(absolutePos, bytes, data, true);
+		if (readSize < bytes) {
+			std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+			stats_.misses += ((absolutePos + bytes - 1) >> BLOCK_SHIFT) - ((absolutePos + readSize) >> BLOCK_SHIFT) + 1;
+		}
 		// While in case the cache size is too small for the entire read.
 		while (readSize < bytes) {
 			SaveIntoCache(absolutePos + readSize, bytes - readSize, flags);
-			size_t bytesFromCache = ReadFromCache(absolutePos + readSize, bytes - readSize, (u8 *)data + readSize);
+			size_t bytesFromCache = ReadFromCache(absolutePos + readSize, bytes - readSize, (u8 *)data + readSize, false);
 			readSize += bytesFromCache;
 			if (bytesFromCache == 0) {
 				// We can't read any more.
@@ -93,12 +99,17 @@ size_t CachingFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flag
 			}
 		}
 
-		StartReadAhead(absolutePos + readSize);
+		PredictReadAhead(absolutePos, readSize);
 	}
 
 	return readSize;
 }
 
+CachingFileLoader::Stats CachingFileLoader::GetStats() {
+	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+	return stats_;
+}
+
 void CachingFileLoader::InitCache() {
 	cacheSize_ = 0;
 	oldestGeneration_ = 0;
@@ -109,6 +120,10 @@ void CachingFileLoader::ShutdownCache() {
 	// TODO: Maybe add some hint that deletion is coming soon?
 	// We can't delete while the thread is running, so have to wait.
 	// This should only happen from the menu.
+	{
+		std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+		aheadQueue_.clear();
+	}
 	while (aheadThreadRunning_) {
 		sleep_ms(1);
 	}
@@ -120,10 +135,15 @@ void CachingFileLoader::ShutdownCache() {
 		delete [] block.second.ptr;
 	}
 	blocks_.clear();
+	MemUsage_Add(MemoryCategory::FILE_CACHE, -(int64_t)cacheSize_ * BLOCK_SIZE);
 	cacheSize_ = 0;
+
+	INFO_LOG(LOADER, "Read cache: %llu hits, %llu misses, %llu read ahead (%llu unused)",
+		(unsigned long long)stats_.hits, (unsigned long long)stats_.misses,
+		(unsigned long long)stats_.prefetched, (unsigned long long)stats_.prefetchWasted);
 }
 
-size_t CachingFileLoader::ReadFromCache(s64 pos, size_t bytes, void *data) {
+size_t CachingFileLoader::ReadFromCache(s64 pos, size_t bytes, void *data, bool countHits) {
 	s64 cacheStartPos = pos >> BLOCK_SHIFT;
 	s64 cacheEndPos = (pos + bytes - 1) >> BLOCK_SHIFT;
 	// TODO: Smarter.
@@ -138,6 +158,9 @@ size_t CachingFileLoader::ReadFromCache(s64 pos, size_t bytes, void *data) {
 			return readSize;
 		}
 		block->second.generation = generation_;
+		block->second.prefetched = false;
+		if (countHits)
+			stats_.hits++;
 
 		size_t toRead = std::min(bytes - readSize, (size_t)BLOCK_SIZE - offset);
 		memcpy(p + readSize, block->second.ptr + offset, toRead);
@@ -180,7 +203,9 @@ void CachingFileLoader::SaveIntoCache(s64 pos, size_t bytes, Flags flags, bool r
 		// While blocksMutex_ was unlocked, another thread may have read.
 		// If so, free the one we just read.
 		if (blocks_.find(cacheStartPos) == blocks_.end()) {
-			blocks_[cacheStartPos] = BlockInfo(buf);
+			blocks_[cacheStartPos] = BlockInfo(buf, readingAhead);
+			if (readingAhead)
+				stats_.prefetched++;
 		} else {
 			delete [] buf;
 		}
@@ -198,17 +223,23 @@ void CachingFileLoader::SaveIntoCache(s64 pos, size_t bytes, Flags flags, bool r
 			}
 			u8 *buf = new u8[BLOCK_SIZE];
 			memcpy(buf, wholeRead + (i << BLOCK_SHIFT), BLOCK_SIZE);
-			blocks_[cacheStartPos + i] = BlockInfo(buf);
+			blocks_[cacheStartPos + i] = BlockInfo(buf, readingAhead);
+			if (readingAhead)
+				stats_.prefetched++;
 		}
 		delete[] wholeRead;
 	}
 
 	cacheSize_ += blocksToRead;
+	MemUsage_Add(MemoryCategory::FILE_CACHE, (int64_t)blocksToRead * BLOCK_SIZE);
 	++generation_;
 }
 
 bool CachingFileLoader::MakeCacheSpaceFor(size_t blocks, bool readingAhead) {
 	size_t goal = MAX_BLOCKS_CACHED - blocks;
+	// Over budget, so keep a lot less around (and stop reading ahead.)
+	if (MemUsage_IsOverBudget(MemoryCategory::FILE_CACHE))
+		goal = MAX_BLOCKS_CACHED / 4 - blocks;
 
 	if (readingAhead && cacheSize_ > goal) {
 		return false;
@@ -229,9 +260,12 @@ bool CachingFileLoader::MakeCacheSpaceFor(size_t blocks, bool readingAhead) {
 			// 0 means it was never used yet or was the first read (e.g. block descriptor.)
 			if (it->second.generation == oldestGeneration_ || it->second.generation == 0) {
 				s64 pos = it->first;
+				if (it->second.prefetched)
+					stats_.prefetchWasted++;
 				delete it->second.ptr;
 				blocks_.erase(it);
 				--cacheSize_;
+				MemUsage_Add(MemoryCategory::FILE_CACHE, -(int64_t)BLOCK_SIZE);
 
 				// Our iterator is invalid now.  Keep going?
 				if (cacheSize_ > goal) {
@@ -252,36 +286,110 @@ bool CachingFileLoader::MakeCacheSpaceFor(size_t blocks, bool readingAhead) {
 	return true;
 }
 
-void CachingFileLoader::StartReadAhead(s64 pos) {
+void CachingFileLoader::PredictReadAhead(s64 pos, size_t bytes) {
+	if (bytes == 0)
+		return;
+
+	const s64 startBlock = pos >> BLOCK_SHIFT;
+	const s64 endBlock = (pos + bytes - 1) >> BLOCK_SHIFT;
+
+	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+	// Find the stream this read continues.  Starting in the last block read still counts as sequential.
+	ReadStream *stream = nullptr;
+	ReadStream *oldest = &streams_[0];
+	for (ReadStream &s : streams_) {
+		if (s.nextBlock >= 0 && startBlock >= s.nextBlock - 1 && startBlock <= s.nextBlock + MAX_STREAM_GAP) {
+			if (!stream || startBlock - s.nextBlock < startBlock - stream->nextBlock)
+				stream = &s;
+		}
+		if (s.lastUse < oldest->lastUse)
+			oldest = &s;
+	}
+
+	if (stream) {
+		s64 gap = std::max(startBlock - stream->nextBlock, (s64)0);
+		if (gap == stream->gap) {
+			stream->confidence = std::min(stream->confidence + 1, 3);
+		} else {
+			stream->gap = gap;
+			stream->confidence = 0;
+		}
+	} else {
+		// Unknown, so start assuming it's sequential.
+		stream = oldest;
+		stream->gap = 0;
+		stream->confidence = 0;
+	}
+	stream->nextBlock = endBlock + 1;
+	stream->lastBlocks = endBlock - startBlock + 1;
+	stream->lastUse = ++streamUse_;
+
+	if (stream->gap == 0) {
+		QueueReadAhead(stream->nextBlock, BLOCK_READAHEAD);
+	} else if (stream->confidence > 0) {
+		// Strided, so skip the gaps and fetch where the next reads should land.
+		s64 next = stream->nextBlock + stream->gap;
+		for (s64 remaining = BLOCK_READAHEAD; remaining > 0; ) {
+			s64 blocks = std::min(stream->lastBlocks, remaining);
+			QueueReadAhead(next, blocks);
+			remaining -= blocks;
+			next += stream->lastBlocks + stream->gap;
+		}
+	}
+
+	StartReadAhead();
+}
+
+void CachingFileLoader::QueueReadAhead(s64 startBlock, s64 blocks) {
+	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+	const s64 lastFileBlock = (filesize_ - 1) >> BLOCK_SHIFT;
+	blocks = std::min(blocks, lastFileBlock - startBlock + 1);
+	// Skip what's already cached, SaveIntoCache stops at the first cached block anyway.
+	while (blocks > 0 && blocks_.find(startBlock) != blocks_.end()) {
+		++startBlock;
+		--blocks;
+	}
+	if (blocks <= 0)
+		return;
+
+	for (const ReadAheadRange &range : aheadQueue_) {
+		if (range.startBlock == startBlock)
+			return;
+	}
+	// Older predictions are the most likely to be stale, so drop those first.
+	if (aheadQueue_.size() >= MAX_QUEUED_READAHEAD)
+		aheadQueue_.pop_front();
+	aheadQueue_.push_back(ReadAheadRange{ startBlock, blocks });
+}
+
+void CachingFileLoader::StartReadAhead() {
 	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
-	if (aheadThreadRunning_) {
-		// Already going.
+	if (aheadThreadRunning_ || aheadQueue_.empty()) {
+		// Already going, it'll pick up anything queued.
 		return;
 	}
 	if (cacheSize_ + BLOCK_READAHEAD > MAX_BLOCKS_CACHED) {
 		// Not enough space to readahead.
+		aheadQueue_.clear();
 		return;
 	}
 
 	aheadThreadRunning_ = true;
 	if (aheadThread_.joinable())
 		aheadThread_.join();
-	aheadThread_ = std::thread([this, pos] {
+	aheadThread_ = std::thread([this] {
 		SetCurrentThreadName("FileLoaderReadAhead");
 
 		AndroidJNIThreadContext jniContext;
 
 		std::unique_lock<std::recursive_mutex> guard(blocksMutex_);
-		s64 cacheStartPos = pos >> BLOCK_SHIFT;
-		s64 cacheEndPos = cacheStartPos + BLOCK_READAHEAD - 1;
-
-		for (s64 i = cacheStartPos; i <= cacheEndPos; ++i) {
-			auto block = blocks_.find(i);
-			if (block == blocks_.end()) {
-				guard.unlock();
-				SaveIntoCache(i << BLOCK_SHIFT, BLOCK_SIZE * BLOCK_READAHEAD, Flags::NONE, true);
-				break;
-			}
+		while (!aheadQueue_.empty()) {
+			ReadAheadRange range = aheadQueue_.front();
+			aheadQueue_.pop_front();
+
+			guard.unlock();
+			SaveIntoCache(range.startBlock << BLOCK_SHIFT, (size_t)(range.blocks << BLOCK_SHIFT), Flags::NONE, true);
+			guard.lock();
 		}
 
 		aheadThreadRunning_ = false;
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <deque>
 #include <map>
 #include <mutex>
 #include <thread>
@@ -39,15 +40,28 @@ class CachingFileLoader : public ProxiedFileLoader {
 	}
 	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override;
 
+	// All counts are in blocks.
+	struct Stats {
+		u64 hits = 0;
+		u64 misses = 0;
+		u64 prefetched = 0;
+		// Read ahead, but dropped from the cache before anything used them.
+		u64 prefetchWasted = 0;
+	};
+	Stats GetStats();
+
 private:
 	void Prepare();
 	void InitCache();
 	void ShutdownCache();
-	size_t ReadFromCache(s64 pos, size_t bytes, void *data);
+	size_t ReadFromCache(s64 pos, size_t bytes, void *data, bool countHits);
 	// Guaranteed to read at least one block into the cache.
 	void SaveIntoCache(s64 pos, size_t bytes, Flags flags, bool readingAhead = false);
 	bool MakeCacheSpaceFor(size_t blocks, bool readingAhead);
-	void StartReadAhead(s64 pos);
+	// Tracks the access pattern the read belongs to, and queues read ahead for it.
+	void PredictReadAhead(s64 pos, size_t bytes);
+	void QueueReadAhead(s64 startBlock, s64 blocks);
+	void StartReadAhead();
 
 	enum {
 		BLOCK_SIZE = 65536,
@@ -55,6 +69,11 @@ class CachingFileLoader : public ProxiedFileLoader {
 		MAX_BLOCKS_PER_READ = 16,
 		MAX_BLOCKS_CACHED = 4096, // 256 MB
 		BLOCK_READAHEAD = 4,
+		// Interleaved streams, like PMF video and audio, each get their own read ahead.
+		MAX_READ_STREAMS = 4,
+		// How far past the end of a stream's last read still counts as that stream.
+		MAX_STREAM_GAP = 16,
+		MAX_QUEUED_READAHEAD = MAX_READ_STREAMS * 2,
 	};
 
 	s64 filesize_ = 0;
@@ -67,15 +86,36 @@ class CachingFileLoader : public ProxiedFileLoader {
 	struct BlockInfo {
 		u8 *ptr;
 		u64 generation;
+		// Read ahead, and not used yet.
+		bool prefetched;
 
-		BlockInfo() : ptr(nullptr), generation(0) {
+		BlockInfo() : ptr(nullptr), generation(0), prefetched(false) {
 		}
-		BlockInfo(u8 *p) : ptr(p), generation(0) {
+		BlockInfo(u8 *p, bool ahead = false) : ptr(p), generation(0), prefetched(ahead) {
 		}
 	};
 
+	struct ReadStream {
+		// Block after the last read, and the gap from the previous read's end to this read's start.
+		s64 nextBlock = -1;
+		s64 gap = 0;
+		s64 lastBlocks = 0;
+		// How many times in a row the gap repeated.
+		int confidence = 0;
+		u64 lastUse = 0;
+	};
+
+	struct ReadAheadRange {
+		s64 startBlock;
+		s64 blocks;
+	};
+
 	std::map<s64, BlockInfo> blocks_;
 	std::recursive_mutex blocksMutex_;
+	ReadStream streams_[MAX_READ_STREAMS];
+	u64 streamUse_ = 0;
+	std::deque<ReadAheadRange> aheadQueue_;
+	Stats stats_;
 	bool aheadThreadRunning_ = false;
 	std::thread aheadThread_;
 	std::once_flag preparedFlag_;
@@ -37,9 +37,14 @@
 #include <fileapifromapp.h>
 #endif
 
-#if PPSSPP_PLATFORM(SWITCH)
-// Far from optimal, but I guess it works...
-#define fseeko fseek
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#if !PPSSPP_PLATFORM(SWITCH)
+#include <sys/file.h>
+#endif
 #endif
 
 static const char *CACHEFILE_MAGIC = "ppssppDC";
@@ -181,8 +186,9 @@ void DiskCachingFileLoaderCache::InitCache(const Path &filename) {
 
 	// We do some basic locking to protect against two things: crashes and concurrency.
 	// Concurrency will break the file.  Crashes will probably leave it inconsistent.
+	// If another running process has it, leave it alone - its cache is fine, we just can't use it.
 	if (fileLoaded && !LockCacheFile(true)) {
-		if (RemoveCacheFile(cacheFilePath)) {
+		if (!lockedByOtherProcess_ && RemoveCacheFile(cacheFilePath)) {
 			// Create a new one.
 			fileLoaded = false;
 		} else {
@@ -220,119 +226,166 @@ void DiskCachingFileLoaderCache::ShutdownCache() {
 
 	index_.clear();
 	blockIndexLookup_.clear();
+	blockSequence_.clear();
 	cacheSize_ = 0;
 }
 
 size_t DiskCachingFileLoaderCache::ReadFromCache(s64 pos, size_t bytes, void *data) {
-	std::lock_guard<std::mutex> guard(lock_);
+	struct PendingRead {
+		u32 block;
+		u32 sequence;
+		size_t offset;
+		size_t size;
+	};
+	std::vector<PendingRead> reads;
+
+	// Only the index is used under the lock, the block data is read afterward.
+	// That way, several threads can read from the cache at once.
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (!f_) {
+			return 0;
+		}
 
-	if (!f_) {
-		return 0;
-	}
+		size_t cacheStartPos = (size_t)(pos / blockSize_);
+		size_t cacheEndPos = (size_t)((pos + bytes - 1) / blockSize_);
+		size_t offset = (size_t)(pos - (cacheStartPos * (u64)blockSize_));
+		size_t plannedSize = 0;
 
-	size_t cacheStartPos = (size_t)(pos / blockSize_);
-	size_t cacheEndPos = (size_t)((pos + bytes - 1) / blockSize_);
-	size_t readSize = 0;
-	size_t offset = (size_t)(pos - (cacheStartPos * (u64)blockSize_));
-	u8 *p = (u8 *)data;
+		reads.reserve(cacheEndPos - cacheStartPos + 1);
+		for (size_t i = cacheStartPos; i <= cacheEndPos; ++i) {
+			auto &info = index_[i];
+			if (info.block == INVALID_BLOCK) {
+				break;
+			}
+			info.generation = generation_;
+			if (info.hits < std::numeric_limits<u16>::max()) {
+				++info.hits;
+			}
 
-	for (size_t i = cacheStartPos; i <= cacheEndPos; ++i) {
-		auto &info = index_[i];
-		if (info.block == INVALID_BLOCK) {
-			return readSize;
-		}
-		info.generation = generation_;
-		if (info.hits < std::numeric_limits<u16>::max()) {
-			++info.hits;
-		}
+			size_t toRead = std::min(bytes - plannedSize, (size_t)blockSize_ - offset);
+			reads.push_back(PendingRead{ info.block, blockSequence_[info.block], offset, toRead });
+			plannedSize += toRead;
 
-		size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
-		if (!ReadBlockData(p + readSize, info, offset, toRead)) {
-			return readSize;
+			// Don't need an offset after the first read.
+			offset = 0;
 		}
-		readSize += toRead;
+	}
 
-		// Don't need an offset after the first read.
-		offset = 0;
+	if (reads.empty()) {
+		return 0;
 	}
-	return readSize;
-}
 
-size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, size_t bytes, void *data, FileLoader::Flags flags) {
-	std::lock_guard<std::mutex> guard(lock_);
+	u8 *p = (u8 *)data;
+	size_t readSize = 0;
+	bool failed = false;
+	{
+		std::shared_lock<std::shared_mutex> guard(fileLock_);
+		for (const PendingRead &read : reads) {
+			if (!f_ || !ReadBlockData(p + readSize, read.block, read.offset, read.size)) {
+				failed = true;
+				break;
+			}
+			readSize += read.size;
+		}
+	}
 
-	if (!f_) {
-		// Just to keep things working.
-		return backend->ReadAt(pos, bytes, data, flags);
+	std::lock_guard<std::mutex> guard(lock_);
+	if (failed && f_) {
+		ERROR_LOG(LOADER, "Unable to read disk cache data entry.");
+		CloseFileHandle();
 	}
 
-	size_t cacheStartPos = (size_t)(pos / blockSize_);
-	size_t cacheEndPos = (size_t)((pos + bytes - 1) / blockSize_);
-	size_t readSize = 0;
-	size_t offset = (size_t)(pos - (cacheStartPos * (u64)blockSize_));
-	u8 *p = (u8 *)data;
+	// If a block was evicted while we read it, it may have been reused for other data.
+	size_t validSize = 0;
+	for (const PendingRead &read : reads) {
+		if (validSize >= readSize || blockSequence_[read.block] != read.sequence) {
+			break;
+		}
+		validSize += read.size;
+	}
+	return validSize;
+}
 
+size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, size_t bytes, void *data, FileLoader::Flags flags) {
+	size_t cacheStartPos;
+	size_t offset;
 	size_t blocksToRead = 0;
-	for (size_t i = cacheStartPos; i <= cacheEndPos; ++i) {
-		auto &info = index_[i];
-		if (info.block != INVALID_BLOCK) {
-			break;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (!f_) {
+			// Just to keep things working.
+			return backend->ReadAt(pos, bytes, data, flags);
 		}
-		++blocksToRead;
-		if (blocksToRead >= MAX_BLOCKS_PER_READ) {
-			break;
+
+		cacheStartPos = (size_t)(pos / blockSize_);
+		size_t cacheEndPos = (size_t)((pos + bytes - 1) / blockSize_);
+		offset = (size_t)(pos - (cacheStartPos * (u64)blockSize_));
+
+		for (size_t i = cacheStartPos; i <= cacheEndPos; ++i) {
+			auto &info = index_[i];
+			if (info.block != INVALID_BLOCK) {
+				break;
+			}
+			++blocksToRead;
+			if (blocksToRead >= MAX_BLOCKS_PER_READ) {
+				break;
+			}
 		}
 	}
 
-	if (!MakeCacheSpaceFor(blocksToRead) || blocksToRead == 0) {
+	if (blocksToRead == 0) {
 		return 0;
 	}
 
-	if (blocksToRead == 1) {
-		auto &info = index_[cacheStartPos];
+	// The backend is usually the slow part (it's often HTTP), so don't block other readers meanwhile.
+	u8 *wholeRead = new u8[blocksToRead * blockSize_];
+	size_t readBytes = backend->ReadAt(cacheStartPos * (u64)blockSize_, blocksToRead * blockSize_, wholeRead, flags);
+	if (readBytes == 0) {
+		delete[] wholeRead;
+		return 0;
+	}
 
-		u8 *buf = new u8[blockSize_];
-		size_t readBytes = backend->ReadAt(cacheStartPos * (u64)blockSize_, blockSize_, buf, flags);
+	{
+		std::lock_guard<std::mutex> guard(lock_);
 
-		// Check if it was written while we were busy.  Might happen if we thread.
-		if (info.block == INVALID_BLOCK && readBytes != 0) {
-			info.block = AllocateBlock((u32)cacheStartPos);
-			WriteBlockData(info, buf);
-			WriteIndexData((u32)cacheStartPos, info);
+		// Another thread might have cached some of these while we were busy.
+		size_t blocksToAdd = 0;
+		for (size_t i = 0; i < blocksToRead; ++i) {
+			if (index_[cacheStartPos + i].block == INVALID_BLOCK) {
+				++blocksToAdd;
+			}
 		}
 
-		size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
-		memcpy(p + readSize, buf + offset, toRead);
-		readSize += toRead;
+		if (f_ && blocksToAdd != 0 && MakeCacheSpaceFor(blocksToAdd)) {
+			for (size_t i = 0; i < blocksToRead; ++i) {
+				auto &info = index_[cacheStartPos + i];
+				if (info.block == INVALID_BLOCK) {
+					info.block = AllocateBlock((u32)cacheStartPos + (u32)i);
+					WriteBlockData(info, wholeRead + (i * blockSize_));
+					// TODO: Doing each index together would probably be better.
+					WriteIndexData((u32)cacheStartPos + (u32)i, info);
+				}
+			}
 
-		delete [] buf;
-	} else {
-		u8 *wholeRead = new u8[blocksToRead * blockSize_];
-		size_t readBytes = backend->ReadAt(cacheStartPos * (u64)blockSize_, blocksToRead * blockSize_, wholeRead, flags);
+			cacheSize_ += blocksToAdd;
+			++generation_;
 
-		for (size_t i = 0; i < blocksToRead; ++i) {
-			auto &info = index_[cacheStartPos + i];
-			// Check if it was written while we were busy.  Might happen if we thread.
-			if (info.block == INVALID_BLOCK && readBytes != 0) {
-				info.block = AllocateBlock((u32)cacheStartPos + (u32)i);
-				WriteBlockData(info, wholeRead + (i * blockSize_));
-				// TODO: Doing each index together would probably be better.
-				WriteIndexData((u32)cacheStartPos + (u32)i, info);
+			if (generation_ == std::numeric_limits<u16>::max()) {
+				RebalanceGenerations();
 			}
-
-			size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
-			memcpy(p + readSize, wholeRead + (i * blockSize_) + offset, toRead);
-			readSize += toRead;
 		}
-		delete[] wholeRead;
 	}
 
-	cacheSize_ += blocksToRead;
-	++generation_;
-
-	if (generation_ == std::numeric_limits<u16>::max()) {
-		RebalanceGenerations();
+	u8 *p = (u8 *)data;
+	size_t readSize = 0;
+	for (size_t i = 0; i < blocksToRead; ++i) {
+		size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
+		memcpy(p + readSize, wholeRead + (i * blockSize_) + offset, toRead);
+		readSize += toRead;
+		offset = 0;
 	}
+	delete[] wholeRead;
 
 	return readSize;
 }
@@ -358,6 +411,8 @@ bool DiskCachingFileLoaderCache::MakeCacheSpaceFor(size_t blocks) {
 
 			// 0 means it was never used yet or was the first read (e.g. block descriptor.)
 			if (info.generation == oldestGeneration_ || info.generation == 0) {
+				// Any reader that's still copying this block's old data will throw it away.
+				++blockSequence_[i];
 				info.block = INVALID_BLOCK;
 				info.generation = 0;
 				info.hits = 0;
@@ -445,63 +500,131 @@ s64 DiskCachingFileLoaderCache::GetBlockOffset(u32 block) {
 	return blockOffset + (s64)block * (s64)blockSize_;
 }
 
-bool DiskCachingFileLoaderCache::ReadBlockData(u8 *dest, BlockInfo &info, size_t offset, size_t size) {
-	if (!f_) {
+bool DiskCachingFileLoaderCache::ReadFileAt(s64 offset, void *dest, size_t size) {
+	u8 *p = (u8 *)dest;
+#if PPSSPP_PLATFORM(SWITCH)
+	std::lock_guard<std::mutex> guard(ioLock_);
+	int fd = fileno(f_);
+	if (lseek(fd, offset, SEEK_SET) != offset) {
 		return false;
 	}
-	if (size == 0) {
-		return true;
+	while (size > 0) {
+		ssize_t result = read(fd, p, size);
+		if (result <= 0) {
+			return false;
+		}
+		p += result;
+		size -= result;
 	}
-	s64 blockOffset = GetBlockOffset(info.block);
-
-	// Before we read, make sure the buffers are flushed.
-	// We might be trying to read an area we've recently written.
-	fflush(f_);
+	return true;
+#elif defined(_WIN32)
+	HANDLE handle = (HANDLE)_get_osfhandle(_fileno(f_));
+	while (size > 0) {
+		DWORD toRead = (DWORD)std::min(size, (size_t)0x40000000);
+		DWORD result = 0;
+		OVERLAPPED overlapped{};
+		overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		if (!ReadFile(handle, p, toRead, &result, &overlapped) || result == 0) {
+			return false;
+		}
+		p += result;
+		offset += result;
+		size -= result;
+	}
+	return true;
+#else
+	int fd = fileno(f_);
+	while (size > 0) {
+#if defined(_FILE_OFFSET_BITS) && _FILE_OFFSET_BITS < 64
+		ssize_t result = pread64(fd, p, size, offset);
+#else
+		ssize_t result = pread(fd, p, size, offset);
+#endif
+		if (result < 0 && errno == EINTR) {
+			continue;
+		}
+		if (result <= 0) {
+			return false;
+		}
+		p += result;
+		offset += result;
+		size -= result;
+	}
+	return true;
+#endif
+}
 
-	bool failed = false;
-#ifdef __ANDROID__
-	if (lseek64(fd_, blockOffset, SEEK_SET) != blockOffset) {
-		failed = true;
-	} else if (read(fd_, dest + offset, size) != (ssize_t)size) {
-		failed = true;
+bool DiskCachingFileLoaderCache::WriteFileAt(s64 offset, const void *src, size_t size) {
+	const u8 *p = (const u8 *)src;
+#if PPSSPP_PLATFORM(SWITCH)
+	std::lock_guard<std::mutex> guard(ioLock_);
+	int fd = fileno(f_);
+	if (lseek(fd, offset, SEEK_SET) != offset) {
+		return false;
+	}
+	while (size > 0) {
+		ssize_t result = write(fd, p, size);
+		if (result <= 0) {
+			return false;
+		}
+		p += result;
+		size -= result;
+	}
+	return true;
+#elif defined(_WIN32)
+	HANDLE handle = (HANDLE)_get_osfhandle(_fileno(f_));
+	while (size > 0) {
+		DWORD toWrite = (DWORD)std::min(size, (size_t)0x40000000);
+		DWORD result = 0;
+		OVERLAPPED overlapped{};
+		overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		if (!WriteFile(handle, p, toWrite, &result, &overlapped) || result == 0) {
+			return false;
+		}
+		p += result;
+		offset += result;
+		size -= result;
 	}
+	return true;
 #else
-	if (fseeko(f_, blockOffset, SEEK_SET) != 0) {
-		failed = true;
-	} else if (fread(dest + offset, size, 1, f_) != 1) {
-		failed = true;
+	int fd = fileno(f_);
+	while (size > 0) {
+#if defined(_FILE_OFFSET_BITS) && _FILE_OFFSET_BITS < 64
+		ssize_t result = pwrite64(fd, p, size, offset);
+#else
+		ssize_t result = pwrite(fd, p, size, offset);
+#endif
+		if (result < 0 && errno == EINTR) {
+			continue;
+		}
+		if (result <= 0) {
+			return false;
+		}
+		p += result;
+		offset += result;
+		size -= result;
 	}
+	return true;
 #endif
+}
 
-	if (failed) {
-		ERROR_LOG(LOADER, "Unable to read disk cache data entry.");
-		CloseFileHandle();
+// Called without lock_, but with fileLock_ held shared.  Failures are handled by the caller.
+bool DiskCachingFileLoaderCache::ReadBlockData(u8 *dest, u32 block, size_t offset, size_t size) {
+	if (size == 0) {
+		return true;
 	}
-	return !failed;
+	// Block and index writes go straight to the file (see WriteFileAt), so there's nothing to flush.
+	return ReadFileAt(GetBlockOffset(block) + (s64)offset, dest, size);
 }
 
 void DiskCachingFileLoaderCache::WriteBlockData(BlockInfo &info, const u8 *src) {
 	if (!f_) {
 		return;
 	}
-	s64 blockOffset = GetBlockOffset(info.block);
-
-	bool failed = false;
-#ifdef __ANDROID__
-	if (lseek64(fd_, blockOffset, SEEK_SET) != blockOffset) {
-		failed = true;
-	} else if (write(fd_, src, blockSize_) != (ssize_t)blockSize_) {
-		failed = true;
-	}
-#else
-	if (fseeko(f_, blockOffset, SEEK_SET) != 0) {
-		failed = true;
-	} else if (fwrite(src, blockSize_, 1, f_) != 1) {
-		failed = true;
-	}
-#endif
 
-	if (failed) {
+	if (!WriteFileAt(GetBlockOffset(info.block), src, blockSize_)) {
 		ERROR_LOG(LOADER, "Unable to write disk cache data entry.");
 		CloseFileHandle();
 	}
@@ -513,15 +636,7 @@ void DiskCachingFileLoaderCache::WriteIndexData(u32 indexPos, BlockInfo &info) {
 	}
 
 	u32 offset = (u32)sizeof(FileHeader) + indexPos * (u32)sizeof(BlockInfo);
-
-	bool failed = false;
-	if (fseek(f_, offset, SEEK_SET) != 0) {
-		failed = true;
-	} else if (fwrite(&info, sizeof(BlockInfo), 1, f_) != 1) {
-		failed = true;
-	}
-
-	if (failed) {
+	if (!WriteFileAt(offset, &info, sizeof(BlockInfo))) {
 		ERROR_LOG(LOADER, "Unable to write disk cache index entry.");
 		CloseFileHandle();
 	}
@@ -552,11 +667,6 @@ bool DiskCachingFileLoaderCache::LoadCacheFile(const Path &path) {
 	if (valid) {
 		f_ = fp;
 
-#ifdef __ANDROID__
-		// Android NDK does not support 64-bit file I/O using C streams
-		fd_ = fileno(f_);
-#endif
-
 		// Now let's load the index.
 		blockSize_ = header.blockSize;
 		maxBlocks_ = header.maxBlocks;
@@ -580,6 +690,7 @@ void DiskCachingFileLoaderCache::LoadCacheIndex() {
 	index_.resize(indexCount_);
 	blockIndexLookup_.resize(maxBlocks_);
 	memset(&blockIndexLookup_[0], INVALID_INDEX, maxBlocks_ * sizeof(blockIndexLookup_[0]));
+	blockSequence_.assign(maxBlocks_, 0);
 
 	if (fread(&index_[0], sizeof(BlockInfo), indexCount_, f_) != indexCount_) {
 		CloseFileHandle();
@@ -592,7 +703,7 @@ void DiskCachingFileLoaderCache::LoadCacheIndex() {
 	cacheSize_ = 0;
 
 	for (size_t i = 0; i < index_.size(); ++i) {
-		if (index_[i].block > maxBlocks_) {
+		if (index_[i].block >= maxBlocks_) {
 			index_[i].block = INVALID_BLOCK;
 		}
 		if (index_[i].block == INVALID_BLOCK) {
@@ -630,10 +741,6 @@ void DiskCachingFileLoaderCache::CreateCacheFile(const Path &path) {
 		ERROR_LOG(LOADER, "Could not create disk cache file");
 		return;
 	}
-#ifdef __ANDROID__
-	// Android NDK does not support 64-bit file I/O using C streams
-	fd_ = fileno(f_);
-#endif
 
 	blockSize_ = DEFAULT_BLOCK_SIZE;
 
@@ -655,6 +762,7 @@ void DiskCachingFileLoaderCache::CreateCacheFile(const Path &path) {
 	index_.resize(indexCount_);
 	blockIndexLookup_.resize(maxBlocks_);
 	memset(&blockIndexLookup_[0], INVALID_INDEX, maxBlocks_ * sizeof(blockIndexLookup_[0]));
+	blockSequence_.assign(maxBlocks_, 0);
 
 	if (fwrite(&index_[0], sizeof(BlockInfo), indexCount_, f_) != indexCount_) {
 		CloseFileHandle();
@@ -673,6 +781,13 @@ bool DiskCachingFileLoaderCache::LockCacheFile(bool lockStatus) {
 		return false;
 	}
 
+	// The flag catches crashes, but only an OS lock can tell if another process has it open right now.
+	if (lockStatus && !LockCacheFileForProcess(true)) {
+		ERROR_LOG(LOADER, "Disk cache file for %s is in use by another process", origPath_.c_str());
+		lockedByOtherProcess_ = true;
+		return false;
+	}
+
 	u32 offset = (u32)offsetof(FileHeader, flags);
 
 	bool failed = false;
@@ -688,7 +803,6 @@ bool DiskCachingFileLoaderCache::LockCacheFile(bool lockStatus) {
 		return false;
 	}
 
-	// TODO: Also use flock where supported?
 	if (lockStatus) {
 		if ((flags_ & FLAG_LOCKED) != 0) {
 			ERROR_LOG(LOADER, "Could not lock disk cache file for %s", origPath_.c_str());
@@ -720,11 +834,40 @@ bool DiskCachingFileLoaderCache::LockCacheFile(bool lockStatus) {
 	if (lockStatus) {
 		INFO_LOG(LOADER, "Locked disk cache file for %s", origPath_.c_str());
 	} else {
+		LockCacheFileForProcess(false);
 		INFO_LOG(LOADER, "Unlocked disk cache file for %s", origPath_.c_str());
 	}
 	return true;
 }
 
+bool DiskCachingFileLoaderCache::LockCacheFileForProcess(bool lockStatus) {
+	// Note that these locks go away on their own if the process dies, unlike FLAG_LOCKED.
+#if PPSSPP_PLATFORM(SWITCH)
+	return true;
+#elif defined(_WIN32)
+	HANDLE handle = (HANDLE)_get_osfhandle(_fileno(f_));
+	// Lock a byte far past the end, since Windows locks block reads and writes of the range.
+	OVERLAPPED overlapped{};
+	overlapped.Offset = 0xFFFFFFFE;
+	overlapped.OffsetHigh = 0x7FFFFFFF;
+	if (lockStatus) {
+		return LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &overlapped) != 0;
+	}
+	return UnlockFileEx(handle, 0, 1, 0, &overlapped) != 0;
+#else
+	int result;
+	do {
+		result = flock(fileno(f_), lockStatus ? (LOCK_EX | LOCK_NB) : LOCK_UN);
+	} while (result != 0 && errno == EINTR);
+	if (result != 0 && errno != EWOULDBLOCK) {
+		// Not supported on this filesystem, most likely.  Fall back to just the flag.
+		WARN_LOG(LOADER, "Unable to flock disk cache file: %d", errno);
+		return true;
+	}
+	return result == 0;
+#endif
+}
+
 bool DiskCachingFileLoaderCache::RemoveCacheFile(const Path &path) {
 	// Note that some platforms, you can't delete open files.  So we check.
 	CloseFileHandle();
@@ -732,11 +875,11 @@ bool DiskCachingFileLoaderCache::RemoveCacheFile(const Path &path) {
 }
 
 void DiskCachingFileLoaderCache::CloseFileHandle() {
+	std::unique_lock<std::shared_mutex> guard(fileLock_);
 	if (f_) {
 		fclose(f_);
 	}
 	f_ = nullptr;
-	fd_ = 0;
 }
 
 bool DiskCachingFileLoaderCache::HasData() const {
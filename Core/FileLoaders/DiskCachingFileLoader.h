@@ -20,7 +20,9 @@
 #include <vector>
 #include <map>
 #include <mutex>
+#include <shared_mutex>
 
+#include "ppsspp_config.h"
 #include "Common/CommonTypes.h"
 #include "Common/File/Path.h"
 #include "Common/Swap.h"
@@ -53,8 +55,8 @@ class DiskCachingFileLoader : public ProxiedFileLoader {
 	s64 filesize_ = 0;
 	DiskCachingFileLoaderCache *cache_ = nullptr;
 
-	// We don't support concurrent disk cache access (we use memory cached indexes.)
-	// So we have to ensure there's only one of these per.
+	// The index is cached in memory, so there must be only one cache object per file.
+	// It can be used from several threads, and other processes are kept out with a file lock.
 	static std::map<Path, DiskCachingFileLoaderCache *> caches_;
 	static std::mutex cachesMutex_;
 };
@@ -94,10 +96,13 @@ class DiskCachingFileLoaderCache {
 	u32 AllocateBlock(u32 indexPos);
 
 	struct BlockInfo;
-	bool ReadBlockData(u8 *dest, BlockInfo &info, size_t offset, size_t size);
+	bool ReadBlockData(u8 *dest, u32 block, size_t offset, size_t size);
 	void WriteBlockData(BlockInfo &info, const u8 *src);
 	void WriteIndexData(u32 indexPos, BlockInfo &info);
 	s64 GetBlockOffset(u32 block);
+	// Positional I/O, doesn't disturb (or depend on) the position of f_.
+	bool ReadFileAt(s64 offset, void *dest, size_t size);
+	bool WriteFileAt(s64 offset, const void *src, size_t size);
 
 	Path MakeCacheFilePath(const Path &filename);
 	std::string MakeCacheFilename(const Path &path);
@@ -105,6 +110,7 @@ class DiskCachingFileLoaderCache {
 	void LoadCacheIndex();
 	void CreateCacheFile(const Path &path);
 	bool LockCacheFile(bool lockStatus);
+	bool LockCacheFileForProcess(bool lockStatus);
 	bool RemoveCacheFile(const Path &path);
 	void CloseFileHandle();
 
@@ -146,7 +152,11 @@ class DiskCachingFileLoaderCache {
 	u32 flags_;
 	size_t cacheSize_;
 	size_t indexCount_;
+	// Protects the index and allocation.  Not held while reading block data.
 	std::mutex lock_;
+	// Held shared while reading block data without lock_, so the file isn't closed underneath.
+	std::shared_mutex fileLock_;
+	bool lockedByOtherProcess_ = false;
 	Path origPath_;
 
 	struct FileHeader {
@@ -173,9 +183,14 @@ class DiskCachingFileLoaderCache {
 
 	std::vector<BlockInfo> index_;
 	std::vector<u32> blockIndexLookup_;
+	// Bumped whenever a block is evicted, so readers can tell if data changed under them.
+	std::vector<u32> blockSequence_;
 
 	FILE *f_ = nullptr;
-	int fd_ = 0;
+#if PPSSPP_PLATFORM(SWITCH)
+	// No positional I/O, so reads and writes must seek under a lock.
+	std::mutex ioLock_;
+#endif
 
 	static Path cacheDir_;
 };
@@ -16,9 +16,11 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <thread>
 
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Core/Config.h"
 #include "Core/FileLoaders/HTTPFileLoader.h"
 
@@ -178,16 +180,85 @@ Path HTTPFileLoader::GetPath() const {
 
 size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags) {
 	Prepare();
-	std::lock_guard<std::mutex> guard(readAtMutex_);
 
 	s64 absoluteEnd = std::min(absolutePos + (s64)bytes, filesize_);
 	if (absolutePos >= filesize_ || bytes == 0) {
 		// Read outside of the file or no read at all, just fail immediately.
 		return 0;
 	}
+	bytes = (size_t)(absoluteEnd - absolutePos);
+	// Like Connect(), a cancel only applies to reads already in progress.
+	cancel_ = false;
 
-	Connect();
-	if (!connected_) {
+	int parts = std::min((int)MAX_CONNECTIONS, (int)(bytes / PARALLEL_RANGE_MIN));
+	if (parts <= 1) {
+		return ReadRange(absolutePos, bytes, (u8 *)data);
+	}
+
+	// Each round trip is mostly latency, so send them at once.  Keep parts 4KB aligned.
+	size_t partSize = ((bytes + parts - 1) / parts + 4095) & ~(size_t)4095;
+	std::vector<size_t> partBytes(parts);
+	std::vector<size_t> partRead(parts);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < parts; ++i) {
+		size_t offset = partSize * i;
+		partBytes[i] = offset < bytes ? std::min(partSize, bytes - offset) : 0;
+		if (i == 0 || partBytes[i] == 0)
+			continue;
+		threads.emplace_back([=, &partRead] {
+			SetCurrentThreadName("HTTPRangeRead");
+			AndroidJNIThreadContext jniContext;
+			partRead[i] = ReadRange(absolutePos + offset, partBytes[i], (u8 *)data + offset);
+		});
+	}
+	partRead[0] = ReadRange(absolutePos, partBytes[0], (u8 *)data);
+	for (std::thread &th : threads)
+		th.join();
+
+	// Only what we got contiguously from the start counts.
+	size_t readBytes = 0;
+	for (int i = 0; i < parts; ++i) {
+		readBytes += partRead[i];
+		if (partRead[i] != partBytes[i])
+			break;
+	}
+	return readBytes;
+}
+
+HTTPFileLoader::PooledClient *HTTPFileLoader::AcquireClient() {
+	std::unique_lock<std::mutex> guard(poolMutex_);
+	while (true) {
+		for (PooledClient &pooled : pool_) {
+			if (!pooled.inUse) {
+				pooled.inUse = true;
+				return &pooled;
+			}
+		}
+		poolCond_.wait(guard);
+	}
+}
+
+void HTTPFileLoader::ReleaseClient(PooledClient *pooled) {
+	std::lock_guard<std::mutex> guard(poolMutex_);
+	pooled->inUse = false;
+	poolCond_.notify_one();
+}
+
+size_t HTTPFileLoader::ReadRange(s64 absolutePos, size_t bytes, u8 *data) {
+	s64 absoluteEnd = absolutePos + (s64)bytes;
+	PooledClient *pooled = AcquireClient();
+	http::Client &client = pooled->client;
+	http::RequestProgress progress(&cancel_);
+
+	if (!pooled->resolved) {
+		client.SetUserAgent(StringFromFormat("PPSSPP/%s", PPSSPP_GIT_VERSION));
+		client.SetDataTimeout(20.0);
+		pooled->resolved = client.Resolve(url_.Host().c_str(), url_.Port());
+	}
+
+	// Latency is important here, so reduce the timeout.
+	if (!pooled->resolved || !client.Connect(3, 10.0, &cancel_)) {
+		ReleaseClient(pooled);
 		return 0;
 	}
 
@@ -197,20 +268,22 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 		"Range: bytes=%lld-%lld\r\n", absolutePos, absoluteEnd - 1);
 
 	http::RequestParams req(url_.Resource(), "*/*");
-	int err = client_.SendRequest("GET", req, requestHeaders, &progress_);
+	int err = client.SendRequest("GET", req, requestHeaders, &progress);
 	if (err < 0) {
 		latestError_ = "Invalid response reading data";
-		Disconnect();
+		client.Disconnect();
+		ReleaseClient(pooled);
 		return 0;
 	}
 
 	net::Buffer readbuf;
 	std::vector<std::string> responseHeaders;
-	int code = client_.ReadResponseHeaders(&readbuf, responseHeaders, &progress_);
+	int code = client.ReadResponseHeaders(&readbuf, responseHeaders, &progress);
 	if (code != 206) {
 		ERROR_LOG(LOADER, "HTTP server did not respond with range, received code=%03d", code);
 		latestError_ = "Invalid response reading data";
-		Disconnect();
+		client.Disconnect();
+		ReleaseClient(pooled);
 		return 0;
 	}
 
@@ -237,14 +310,15 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 
 	// TODO: Would be nice to read directly.
 	net::Buffer output;
-	int res = client_.ReadResponseEntity(&readbuf, responseHeaders, &output, &progress_);
+	int res = client.ReadResponseEntity(&readbuf, responseHeaders, &output, &progress);
 	if (res != 0) {
 		ERROR_LOG(LOADER, "Unable to read HTTP response entity: %d", res);
 		// Let's take anything we got anyway.  Not worse than returning nothing?
 	}
 
-	// TODO: Keepalive instead.
-	Disconnect();
+	// TODO: Keepalive instead.  The client sends Connection: close and reads the entity until EOF.
+	client.Disconnect();
+	ReleaseClient(pooled);
 
 	if (!supportedResponse) {
 		ERROR_LOG(LOADER, "HTTP server did not respond with the range we wanted.");
@@ -252,9 +326,8 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 		return 0;
 	}
 
-	size_t readBytes = output.size();
+	size_t readBytes = std::min(output.size(), bytes);
 	output.Take(readBytes, (char *)data);
-	filepos_ = absolutePos + readBytes;
 	return readBytes;
 }
 
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <mutex>
 #include <vector>
 
@@ -60,6 +61,16 @@ class HTTPFileLoader : public FileLoader {
 
 	void Connect();
 
+	struct PooledClient {
+		http::Client client;
+		bool resolved = false;
+		bool inUse = false;
+	};
+
+	size_t ReadRange(s64 absolutePos, size_t bytes, u8 *data);
+	PooledClient *AcquireClient();
+	void ReleaseClient(PooledClient *pooled);
+
 	void Disconnect() {
 		if (connected_) {
 			client_.Disconnect();
@@ -67,8 +78,13 @@ class HTTPFileLoader : public FileLoader {
 		connected_ = false;
 	}
 
+	enum {
+		// Large reads are split into range requests on separate connections, to hide latency.
+		MAX_CONNECTIONS = 4,
+		PARALLEL_RANGE_MIN = 256 * 1024,
+	};
+
 	s64 filesize_ = 0;
-	s64 filepos_ = 0;
 	Url url_;
 	http::Client client_;
 	http::RequestProgress progress_;
@@ -78,5 +94,8 @@ class HTTPFileLoader : public FileLoader {
 	const char *latestError_ = "";
 
 	std::once_flag preparedFlag_;
-	std::mutex readAtMutex_;
+	// Used for reads, so a read ahead doesn't have to wait on another read.
+	PooledClient pool_[MAX_CONNECTIONS];
+	std::mutex poolMutex_;
+	std::condition_variable poolCond_;
 };
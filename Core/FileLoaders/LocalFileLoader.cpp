@@ -15,7 +15,9 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 
 #include "ppsspp_config.h"
 
@@ -36,6 +38,15 @@
 #endif
 #else
 #include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+// Mapping needs address space for the whole ISO.  On Android, the file may be on removable storage,
+// where a vanished file means SIGBUS instead of a read error, so stick to pread there.
+#if !defined(_WIN32) && !defined(HAVE_LIBRETRO_VFS) && PPSSPP_ARCH(64BIT) && !PPSSPP_PLATFORM(ANDROID) && !PPSSPP_PLATFORM(SWITCH)
+#define LOCAL_FILE_LOADER_MMAP 1
+#else
+#define LOCAL_FILE_LOADER_MMAP 0
 #endif
 
 #ifdef HAVE_LIBRETRO_VFS
@@ -55,6 +66,21 @@ void LocalFileLoader::DetectSizeFd() {
 	lseek(fd_, 0, SEEK_SET);
 #endif
 }
+
+void LocalFileLoader::TryMapFile() {
+#if LOCAL_FILE_LOADER_MMAP
+	if (filesize_ == 0 || filesize_ != (u64)(size_t)filesize_)
+		return;
+
+	void *ptr = mmap(nullptr, (size_t)filesize_, PROT_READ, MAP_SHARED, fd_, 0);
+	if (ptr == MAP_FAILED) {
+		// Not a regular file, or similar.  Reads will just use pread.
+		VERBOSE_LOG(FILESYS, "LocalFileLoader could not map '%s', using reads", filename_.c_str());
+		return;
+	}
+	mapped_ = (const u8 *)ptr;
+#endif
+}
 #endif
 
 LocalFileLoader::LocalFileLoader(const Path &filename)
@@ -98,6 +124,7 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 	}
 
 	DetectSizeFd();
+	TryMapFile();
 
 #else // _WIN32
 
@@ -127,6 +154,11 @@ LocalFileLoader::~LocalFileLoader() {
 #if defined(HAVE_LIBRETRO_VFS)
     filestream_close(handle_);
 #elif !defined(_WIN32)
+#if LOCAL_FILE_LOADER_MMAP
+	if (mapped_) {
+		munmap((void *)mapped_, (size_t)filesize_);
+	}
+#endif
 	if (fd_ != -1) {
 		close(fd_);
 	}
@@ -208,6 +240,16 @@ size_t LocalFileLoader::ReadAt(s64 absolutePos, size_t bytes, size_t count, void
 		return read(fd_, data, bytes * count) / bytes;
 	}
 #elif !defined(_WIN32)
+#if LOCAL_FILE_LOADER_MMAP
+	if (mapped_) {
+		if (absolutePos < 0 || (u64)absolutePos >= filesize_)
+			return 0;
+		size_t available = (size_t)(filesize_ - absolutePos);
+		count = std::min(count, available / bytes);
+		memcpy(data, mapped_ + absolutePos, bytes * count);
+		return count;
+	}
+#endif
 #if defined(_FILE_OFFSET_BITS) && _FILE_OFFSET_BITS < 64
 	return pread64(fd_, data, bytes * count, absolutePos) / bytes;
 #else
@@ -48,7 +48,10 @@ class LocalFileLoader : public FileLoader {
 private:
 #if !defined(_WIN32) && !defined(HAVE_LIBRETRO_VFS)
 	void DetectSizeFd();
+	void TryMapFile();
 	int fd_ = -1;
+	// When the whole file could be mapped, reads are just a copy (often straight into PSP RAM.)
+	const u8 *mapped_ = nullptr;
 #else
 	HANDLE handle_ = 0;
 #endif
@@ -18,15 +18,20 @@
 #include <cstdio>
 #include <cstring>
 #include <algorithm>
+#include <vector>
 
+#include "Common/Data/Hash/Hash.h"
 #include "Common/Data/Text/I18n.h"
 #include "Common/File/FileUtil.h"
 #include "Common/Log.h"
 #include "Common/Swap.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Core/Loaders.h"
 #include "Core/Host.h"
 #include "Core/FileSystems/BlockDevices.h"
 
+#include <zstd.h>
+
 extern "C"
 {
 #include "zlib.h"
@@ -42,7 +47,7 @@ BlockDevice *constructBlockDevice(FileLoader *fileLoader) {
 		return nullptr;
 	char buffer[4]{};
 	size_t size = fileLoader->ReadAt(0, 1, 4, buffer);
-	if (size == 4 && !memcmp(buffer, "CISO", 4))
+	if (size == 4 && (!memcmp(buffer, "CISO", 4) || !memcmp(buffer, "ZCSO", 4)))
 		return new CISOFileBlockDevice(fileLoader);
 	if (size == 4 && !memcmp(buffer, "\x00PBP", 4)) {
 		uint32_t psarOffset = 0;
@@ -54,18 +59,64 @@ BlockDevice *constructBlockDevice(FileLoader *fileLoader) {
 }
 
 u32 BlockDevice::CalculateCRC(volatile bool *cancel) {
+	// Read in large batches, which lets compressed devices decode frames in parallel, and CRC each
+	// batch in slices on the thread pool while the next one is read. The slices are then stitched
+	// together with crc32_combine.
+	static const u32 BATCH_BLOCKS = 4096;
+	static const u32 SLICE_BLOCKS = 256;
+	static const u32 SLICES_PER_BATCH = BATCH_BLOCKS / SLICE_BLOCKS;
+
+	const u32 numBlocks = GetNumBlocks();
+	std::vector<u8> buffers[2];
+	u32 sliceCRCs[2][SLICES_PER_BATCH];
+
 	u32 crc = crc32(0, Z_NULL, 0);
+	WaitableCounter *pending = nullptr;
+	u32 pendingBlocks = 0;
+	int pendingIndex = 0;
+
+	auto finishPending = [&]() {
+		if (!pending)
+			return;
+		pending->WaitAndRelease();
+		pending = nullptr;
+		for (u32 i = 0; i * SLICE_BLOCKS < pendingBlocks; ++i) {
+			u32 blocks = std::min(SLICE_BLOCKS, pendingBlocks - i * SLICE_BLOCKS);
+			crc = crc32_combine(crc, sliceCRCs[pendingIndex][i], blocks * 2048);
+		}
+	};
 
-	u8 block[2048];
-	for (u32 i = 0; i < GetNumBlocks(); ++i) {
-		if (cancel && *cancel)
+	int index = 0;
+	for (u32 start = 0; start < numBlocks; start += BATCH_BLOCKS, index ^= 1) {
+		if (cancel && *cancel) {
+			finishPending();
 			return 0;
-		if (!ReadBlock(i, block, true)) {
+		}
+
+		const u32 count = std::min(BATCH_BLOCKS, numBlocks - start);
+		buffers[index].resize(BATCH_BLOCKS * 2048);
+		if (!ReadBlocks(start, count, buffers[index].data())) {
+			finishPending();
 			ERROR_LOG(FILESYS, "Failed to read block for CRC");
 			return 0;
 		}
-		crc = crc32(crc, block, 2048);
+
+		// The previous batch has had the whole read to finish.
+		finishPending();
+
+		const u8 *data = buffers[index].data();
+		u32 *out = sliceCRCs[index];
+		auto crcSlices = [=](int l, int h) {
+			for (int i = l; i < h; ++i) {
+				u32 blocks = std::min(SLICE_BLOCKS, count - i * SLICE_BLOCKS);
+				out[i] = hash::Crc32(0, data + i * SLICE_BLOCKS * 2048, blocks * 2048);
+			}
+		};
+		pending = ParallelRangeLoopWaitable(&g_threadManager, crcSlices, 0, (count + SLICE_BLOCKS - 1) / SLICE_BLOCKS, 1, TaskPriority::LOW);
+		pendingBlocks = count;
+		pendingIndex = index;
 	}
+	finishPending();
 
 	return crc;
 }
@@ -111,7 +162,7 @@ bool FileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 // compressed ISO(9660) header format
 typedef struct ciso_header
 {
-	unsigned char magic[4];         // +00 : 'C','I','S','O'
+	unsigned char magic[4];         // +00 : 'C','I','S','O' (or 'Z','C','S','O')
 	u32_le header_size;             // +04 : header size (==0x18)
 	u64_le total_bytes;             // +08 : number of original data size
 	u32_le block_size;              // +10 : number of compressed block size
@@ -135,6 +186,8 @@ typedef struct ciso_header
 // TODO: Need much better error handling.
 
 static const u32 CSO_READ_BUFFER_SIZE = 256 * 1024;
+// Below this many compressed frames in a read, threads cost more than they save.
+static const int CSO_PARALLEL_MIN_FRAMES = 8;
 
 CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 	: fileLoader_(fileLoader)
@@ -143,10 +196,12 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 
 	CISO_H hdr;
 	size_t readSize = fileLoader->ReadAt(0, sizeof(CISO_H), 1, &hdr);
-	if (readSize != 1 || memcmp(hdr.magic, "CISO", 4) != 0) {
+	if (readSize == 1 && !memcmp(hdr.magic, "ZCSO", 4)) {
+		zstd_ = true;
+	} else if (readSize != 1 || memcmp(hdr.magic, "CISO", 4) != 0) {
 		WARN_LOG(LOADER, "Invalid CSO!");
 	}
-	if (hdr.ver > 1) {
+	if (hdr.ver > 1 && !zstd_) {
 		WARN_LOG(LOADER, "CSO version too high!");
 	}
 
@@ -165,15 +220,19 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 	const u64 totalSize = hdr.total_bytes;
 	numFrames = (u32)((totalSize + frameSize - 1) / frameSize);
 	numBlocks = (u32)(totalSize / GetBlockSize());
-	VERBOSE_LOG(LOADER, "CSO numBlocks=%i numFrames=%i align=%i", numBlocks, numFrames, indexShift);
+	VERBOSE_LOG(LOADER, "CSO numBlocks=%i numFrames=%i align=%i zstd=%d", numBlocks, numFrames, indexShift, zstd_ ? 1 : 0);
 
 	// We might read a bit of alignment too, so be prepared.
 	if (frameSize + (1 << indexShift) < CSO_READ_BUFFER_SIZE)
 		readBuffer = new u8[CSO_READ_BUFFER_SIZE];
 	else
 		readBuffer = new u8[frameSize + (1 << indexShift)];
-	zlibBuffer = new u8[frameSize + (1 << indexShift)];
-	zlibBufferFrame = numFrames;
+	for (DecodedFrame &decoded : decodedFrames_) {
+		decoded.frame = numFrames;
+		decoded.lastUse = 0;
+		decoded.decoding = false;
+		decoded.data = new u8[frameSize];
+	}
 
 	const u32 indexSize = numFrames + 1;
 	const size_t headerEnd = hdr.ver > 1 ? (size_t)hdr.header_size : sizeof(hdr);
@@ -216,7 +275,104 @@ CISOFileBlockDevice::~CISOFileBlockDevice()
 {
 	delete [] index;
 	delete [] readBuffer;
-	delete [] zlibBuffer;
+	FreeDecompressContext(decompressCtx_);
+	for (DecodedFrame &decoded : decodedFrames_)
+		delete [] decoded.data;
+}
+
+bool CISOFileBlockDevice::IsFramePlain(u32 frame) const {
+	if (ver_ >= 2) {
+		// CSO v2+ requires blocks be uncompressed if large enough to be.  High bit means other things.
+		const u64 readPos = (u64)(index[frame] & 0x7FFFFFFF) << indexShift;
+		const u64 readEnd = (u64)(index[frame + 1] & 0x7FFFFFFF) << indexShift;
+		return readEnd - readPos >= frameSize;
+	}
+	return (index[frame] & 0x80000000) != 0;
+}
+
+u8 *CISOFileBlockDevice::FindDecodedFrame(u32 frame) {
+	for (DecodedFrame &decoded : decodedFrames_) {
+		if (decoded.frame == frame) {
+			decoded.lastUse = ++decodedFrameUse_;
+			return decoded.data;
+		}
+	}
+	return nullptr;
+}
+
+CISOFileBlockDevice::DecodedFrame &CISOFileBlockDevice::ReserveDecodedFrame(u32 frame) {
+	// At most two are ever decoding (the partial first and last frames), so there's always one free.
+	DecodedFrame *oldest = nullptr;
+	for (DecodedFrame &decoded : decodedFrames_) {
+		if (!decoded.decoding && (!oldest || decoded.lastUse < oldest->lastUse))
+			oldest = &decoded;
+	}
+	// Not valid until decoded, the caller sets frame on success.
+	oldest->frame = numFrames;
+	oldest->lastUse = ++decodedFrameUse_;
+	return *oldest;
+}
+
+void *CISOFileBlockDevice::CreateDecompressContext() {
+	if (zstd_)
+		return ZSTD_createDCtx();
+
+	z_stream *z = new z_stream{};
+	if (inflateInit2(z, -15) != Z_OK) {
+		ERROR_LOG(LOADER, "Unable to initialize inflate: %s\n", (z->msg) ? z->msg : "?");
+		delete z;
+		return nullptr;
+	}
+	return z;
+}
+
+void CISOFileBlockDevice::FreeDecompressContext(void *ctx) {
+	if (!ctx)
+		return;
+	if (zstd_) {
+		ZSTD_freeDCtx((ZSTD_DCtx *)ctx);
+	} else {
+		inflateEnd((z_stream *)ctx);
+		delete (z_stream *)ctx;
+	}
+}
+
+bool CISOFileBlockDevice::DecompressFrame(void *ctx, u32 frame, const u8 *src, u32 srcSize, u8 *dst) {
+	if (!ctx)
+		return false;
+
+	if (zstd_) {
+		// Unlike inflate, zstd won't ignore the alignment padding after the frame.
+		size_t compressedSize = ZSTD_findFrameCompressedSize(src, srcSize);
+		size_t result = ZSTD_isError(compressedSize) ? compressedSize : ZSTD_decompressDCtx((ZSTD_DCtx *)ctx, dst, frameSize, src, compressedSize);
+		if (ZSTD_isError(result)) {
+			ERROR_LOG(LOADER, "Decompress frame %d: failed - %s\n", frame, ZSTD_getErrorName(result));
+			return false;
+		}
+		if (result != frameSize) {
+			ERROR_LOG(LOADER, "Decompress frame %d: block size error %d != %d\n", frame, (u32)result, frameSize);
+			return false;
+		}
+		return true;
+	}
+
+	z_stream *z = (z_stream *)ctx;
+	inflateReset(z);
+	z->avail_in = srcSize;
+	z->next_out = dst;
+	z->avail_out = frameSize;
+	z->next_in = (Bytef *)src;
+
+	int status = inflate(z, Z_FINISH);
+	if (status != Z_STREAM_END) {
+		ERROR_LOG(LOADER, "Inflate frame %d: failed - %s[%d]\n", frame, (z->msg) ? z->msg : "error", status);
+		return false;
+	}
+	if (z->total_out != frameSize) {
+		ERROR_LOG(LOADER, "Inflate frame %d: block size error %d != %d\n", frame, (u32)z->total_out, frameSize);
+		return false;
+	}
+	return true;
 }
 
 bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
@@ -228,66 +384,39 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 	}
 
 	const u32 frameNumber = blockNumber >> blockShift;
-	const u32 idx = index[frameNumber];
-	const u32 indexPos = idx & 0x7FFFFFFF;
+	const u32 indexPos = index[frameNumber] & 0x7FFFFFFF;
 	const u32 nextIndexPos = index[frameNumber + 1] & 0x7FFFFFFF;
-	z_stream z{};
 
 	const u64 compressedReadPos = (u64)indexPos << indexShift;
 	const u64 compressedReadEnd = (u64)nextIndexPos << indexShift;
 	const size_t compressedReadSize = (size_t)(compressedReadEnd - compressedReadPos);
 	const u32 compressedOffset = (blockNumber & ((1 << blockShift) - 1)) * GetBlockSize();
 
-	bool plain = (idx & 0x80000000) != 0;
-	if (ver_ >= 2) {
-		// CSO v2+ requires blocks be uncompressed if large enough to be.  High bit means other things.
-		plain = compressedReadSize >= frameSize;
-	}
-	if (plain) {
+	if (IsFramePlain(frameNumber)) {
 		int readSize = (u32)fileLoader_->ReadAt(compressedReadPos + compressedOffset, 1, GetBlockSize(), outPtr, flags);
 		if (readSize < GetBlockSize())
 			memset(outPtr + readSize, 0, GetBlockSize() - readSize);
-	} else if (zlibBufferFrame == frameNumber) {
-		// We already have it.  Just apply the offset and copy.
-		memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
-	} else {
+		return true;
+	}
+
+	const u8 *decoded = FindDecodedFrame(frameNumber);
+	if (!decoded) {
 		const u32 readSize = (u32)fileLoader_->ReadAt(compressedReadPos, 1, compressedReadSize, readBuffer, flags);
 
-		z.zalloc = Z_NULL;
-		z.zfree = Z_NULL;
-		z.opaque = Z_NULL;
-		if (inflateInit2(&z, -15) != Z_OK) {
-			ERROR_LOG(LOADER, "GetBlockSize() ERROR: %s\n", (z.msg) ? z.msg : "?");
-			NotifyReadError();
-			return false;
-		}
-		z.avail_in = readSize;
-		z.next_out = frameSize == (u32)GetBlockSize() ? outPtr : zlibBuffer;
-		z.avail_out = frameSize;
-		z.next_in = readBuffer;
-
-		int status = inflate(&z, Z_FINISH);
-		if (status != Z_STREAM_END) {
-			ERROR_LOG(LOADER, "block %d: inflate : %s[%d]\n", blockNumber, (z.msg) ? z.msg : "error", status);
+		DecodedFrame &slot = ReserveDecodedFrame(frameNumber);
+		if (!decompressCtx_)
+			decompressCtx_ = CreateDecompressContext();
+		if (!DecompressFrame(decompressCtx_, frameNumber, readBuffer, readSize, slot.data)) {
 			NotifyReadError();
-			inflateEnd(&z);
 			memset(outPtr, 0, GetBlockSize());
 			return false;
 		}
-		if (z.total_out != frameSize) {
-			ERROR_LOG(LOADER, "block %d: block size error %d != %d\n", blockNumber, (u32)z.total_out, frameSize);
-			NotifyReadError();
-			inflateEnd(&z);
-			memset(outPtr, 0, GetBlockSize());
-			return false;
-		}
-		inflateEnd(&z);
 
-		if (frameSize != (u32)GetBlockSize()) {
-			zlibBufferFrame = frameNumber;
-			memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
-		}
+		slot.frame = frameNumber;
+		decoded = slot.data;
 	}
+
+	memcpy(outPtr, decoded + compressedOffset, GetBlockSize());
 	return true;
 }
 
@@ -301,83 +430,121 @@ bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	}
 
 	const u32 lastBlock = std::min(minBlock + count, numBlocks) - 1;
-	const u32 missingBlocks = (lastBlock + 1 - minBlock) - count;
-	if (lastBlock < minBlock + count) {
+	const u32 missingBlocks = count - (lastBlock + 1 - minBlock);
+	if (missingBlocks != 0) {
 		memset(outPtr + GetBlockSize() * (count - missingBlocks), 0, GetBlockSize() * missingBlocks);
 	}
 
 	const u32 minFrameNumber = minBlock >> blockShift;
 	const u32 lastFrameNumber = lastBlock >> blockShift;
-	const u32 afterLastIndexPos = index[lastFrameNumber + 1] & 0x7FFFFFFF;
-	const u64 totalReadEnd = (u64)afterLastIndexPos << indexShift;
+	const u32 blocksPerFrame = 1 << blockShift;
 
-	z_stream z{};
-	if (inflateInit2(&z, -15) != Z_OK) {
-		ERROR_LOG(LOADER, "Unable to initialize inflate: %s\n", (z.msg) ? z.msg : "?");
-		return false;
-	}
+	struct PendingFrame {
+		u32 frame;
+		const u8 *src;
+		u32 srcSize;
+		// Either straight into outPtr, or a decoded frame slot when only part is wanted.
+		u8 *dst;
+		DecodedFrame *slot;
+		u8 *partialOut;
+		u32 partialOffset;
+		u32 partialSize;
+		bool success;
+	};
+	std::vector<PendingFrame> pending;
+	// Small reads are usually streaming, which tends to reread the same frames.  Keep those too.
+	const bool cacheFullFrames = lastFrameNumber - minFrameNumber < DECODED_FRAME_CACHE_SIZE / 2;
+
+	auto decodePendingWith = [&](void *ctx, int lower, int upper) {
+		for (int i = lower; i < upper; ++i) {
+			PendingFrame &p = pending[i];
+			p.success = DecompressFrame(ctx, p.frame, p.src, p.srcSize, p.dst);
+		}
+	};
+	auto decodePending = [&](int lower, int upper) {
+		void *ctx = CreateDecompressContext();
+		decodePendingWith(ctx, lower, upper);
+		FreeDecompressContext(ctx);
+	};
+
+	// Decodes everything pending that is already in readBuffer, spread across threads.
+	auto flushPending = [&]() {
+		if ((int)pending.size() >= CSO_PARALLEL_MIN_FRAMES) {
+			ParallelRangeLoop(&g_threadManager, decodePending, 0, (int)pending.size(), CSO_PARALLEL_MIN_FRAMES / 2);
+		} else {
+			if (!decompressCtx_)
+				decompressCtx_ = CreateDecompressContext();
+			decodePendingWith(decompressCtx_, 0, (int)pending.size());
+		}
+
+		for (PendingFrame &p : pending) {
+			if (p.slot)
+				p.slot->decoding = false;
+			if (!p.success) {
+				NotifyReadError();
+				memset(p.partialOut ? p.partialOut : p.dst, 0, p.partialOut ? p.partialSize : frameSize);
+			} else if (p.slot) {
+				p.slot->frame = p.frame;
+				memcpy(p.partialOut, p.dst + p.partialOffset, p.partialSize);
+			} else if (cacheFullFrames) {
+				DecodedFrame &slot = ReserveDecodedFrame(p.frame);
+				memcpy(slot.data, p.dst, frameSize);
+				slot.frame = p.frame;
+			}
+		}
+		pending.clear();
+	};
 
 	u64 readBufferStart = 0;
 	u64 readBufferEnd = 0;
 	u32 block = minBlock;
-	const u32 blocksPerFrame = 1 << blockShift;
 	for (u32 frame = minFrameNumber; frame <= lastFrameNumber; ++frame) {
-		const u32 idx = index[frame];
-		const u32 indexPos = idx & 0x7FFFFFFF;
-		const u32 nextIndexPos = index[frame + 1] & 0x7FFFFFFF;
-
-		const u64 frameReadPos = (u64)indexPos << indexShift;
-		const u64 frameReadEnd = (u64)nextIndexPos << indexShift;
+		const u64 frameReadPos = (u64)(index[frame] & 0x7FFFFFFF) << indexShift;
+		const u64 frameReadEnd = (u64)(index[frame + 1] & 0x7FFFFFFF) << indexShift;
 		const u32 frameReadSize = (u32)(frameReadEnd - frameReadPos);
 		const u32 frameBlockOffset = block & ((1 << blockShift) - 1);
 		const u32 frameBlocks = std::min(lastBlock - block + 1, blocksPerFrame - frameBlockOffset);
+		const bool plain = IsFramePlain(frame);
+		const u8 *decoded = plain ? nullptr : FindDecodedFrame(frame);
 
-		if (frameReadEnd > readBufferEnd) {
-			const s64 maxNeeded = totalReadEnd - frameReadPos;
-			const size_t chunkSize = (size_t)std::min(maxNeeded, (s64)std::max(frameReadSize, CSO_READ_BUFFER_SIZE));
+		if (decoded) {
+			memcpy(outPtr, decoded + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
+		} else {
+			if (frameReadEnd > readBufferEnd || frameReadPos < readBufferStart) {
+				// Pending frames point into readBuffer, so decode them before reusing it.
+				flushPending();
 
-			const u32 readSize = (u32)fileLoader_->ReadAt(frameReadPos, 1, chunkSize, readBuffer);
-			if (readSize < chunkSize) {
-				memset(readBuffer + readSize, 0, chunkSize - readSize);
-			}
+				const u64 totalReadEnd = (u64)(index[lastFrameNumber + 1] & 0x7FFFFFFF) << indexShift;
+				const s64 maxNeeded = totalReadEnd - frameReadPos;
+				const size_t chunkSize = (size_t)std::min(maxNeeded, (s64)std::max(frameReadSize, CSO_READ_BUFFER_SIZE));
 
-			readBufferStart = frameReadPos;
-			readBufferEnd = frameReadPos + readSize;
-		}
+				const u32 readSize = (u32)fileLoader_->ReadAt(frameReadPos, 1, chunkSize, readBuffer);
+				if (readSize < chunkSize) {
+					memset(readBuffer + readSize, 0, chunkSize - readSize);
+				}
 
-		u8 *rawBuffer = &readBuffer[frameReadPos - readBufferStart];
-		const int plain = idx & 0x80000000;
-		if (plain) {
-			memcpy(outPtr, rawBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
-		} else {
-			z.avail_in = frameReadSize;
-			z.next_out = frameBlocks == blocksPerFrame ? outPtr : zlibBuffer;
-			z.avail_out = frameSize;
-			z.next_in = rawBuffer;
-
-			int status = inflate(&z, Z_FINISH);
-			if (status != Z_STREAM_END) {
-				ERROR_LOG(LOADER, "Inflate frame %d: failed - %s[%d]\n", frame, (z.msg) ? z.msg : "error", status);
-				NotifyReadError();
-				memset(outPtr, 0, frameBlocks * GetBlockSize());
-			} else if (z.total_out != frameSize) {
-				ERROR_LOG(LOADER, "Inflate frame %d: block size error %d != %d\n", frame, (u32)z.total_out, frameSize);
-				NotifyReadError();
-				memset(outPtr, 0, frameBlocks * GetBlockSize());
-			} else if (frameBlocks != blocksPerFrame) {
-				memcpy(outPtr, zlibBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
-				// In case we end up reusing it in a single read later.
-				zlibBufferFrame = frame;
+				readBufferStart = frameReadPos;
+				readBufferEnd = frameReadPos + readSize;
 			}
 
-			inflateReset(&z);
+			u8 *rawBuffer = &readBuffer[frameReadPos - readBufferStart];
+			if (plain) {
+				memcpy(outPtr, rawBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
+			} else if (frameBlocks == blocksPerFrame) {
+				pending.push_back(PendingFrame{ frame, rawBuffer, frameReadSize, outPtr, nullptr, nullptr, 0, 0, false });
+			} else {
+				// We only want part, so keep the whole frame in case the next read wants the rest.
+				DecodedFrame &slot = ReserveDecodedFrame(frame);
+				slot.decoding = true;
+				pending.push_back(PendingFrame{ frame, rawBuffer, frameReadSize, slot.data, &slot, outPtr, frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize(), false });
+			}
 		}
 
 		block += frameBlocks;
 		outPtr += frameBlocks * GetBlockSize();
 	}
 
-	inflateEnd(&z);
+	flushPending();
 	return true;
 }
 
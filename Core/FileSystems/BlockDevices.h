@@ -18,7 +18,7 @@
 #pragma once
 
 // Abstractions around read-only blockdevices, such as PSP UMD discs.
-// CISOFileBlockDevice implements compressed iso images, CISO format.
+// CISOFileBlockDevice implements compressed iso images, CISO format, and its zstd variant ZCSO.
 //
 // The ISOFileSystemReader reads from a BlockDevice, so it automatically works
 // with CISO images.
@@ -64,17 +64,40 @@ class CISOFileBlockDevice : public BlockDevice {
 	bool IsDisc() override { return true; }
 
 private:
+	struct DecodedFrame {
+		u32 frame;
+		u32 lastUse;
+		u8 *data;
+		// Waiting on a batch decode in ReadBlocks, so can't be reused yet.
+		bool decoding;
+	};
+
+	bool IsFramePlain(u32 frame) const;
+	u8 *FindDecodedFrame(u32 frame);
+	DecodedFrame &ReserveDecodedFrame(u32 frame);
+	// Ranges of frames are decoded in parallel, so ctx is per thread (z_stream or ZSTD_DCtx.)
+	bool DecompressFrame(void *ctx, u32 frame, const u8 *src, u32 srcSize, u8 *dst);
+	void *CreateDecompressContext();
+	void FreeDecompressContext(void *ctx);
+
+	// Keep a few recently decoded frames, most reads are small and sequential.
+	static constexpr int DECODED_FRAME_CACHE_SIZE = 8;
+
 	FileLoader *fileLoader_;
 	u32 *index;
 	u8 *readBuffer;
-	u8 *zlibBuffer;
-	u32 zlibBufferFrame;
+	DecodedFrame decodedFrames_[DECODED_FRAME_CACHE_SIZE];
+	u32 decodedFrameUse_ = 0;
+	// Reused (via inflateReset) for reads decoded on the calling thread.
+	void *decompressCtx_ = nullptr;
 	u8 indexShift;
 	u8 blockShift;
 	u32 frameSize;
 	u32 numBlocks;
 	u32 numFrames;
 	int ver_;
+	// ZCSO (.zso) has the same layout, but frames are zstd instead of raw deflate.
+	bool zstd_ = false;
 };
 
 
@@ -25,8 +25,10 @@
 #endif
 
 #include <algorithm>
+#include <condition_variable>
 #include <ctime>
 #include <limits>
+#include <mutex>
 
 #include "Common/Data/Text/I18n.h"
 #include "Common/Data/Encoding/Utf8.h"
@@ -37,6 +39,8 @@
 #include "Common/File/DiskFree.h"
 #include "Common/File/VFS/VFS.h"
 #include "Common/SysError.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
 #include "Core/FileSystems/DirectoryFileSystem.h"
 #include "Core/FileSystems/ISOFileSystem.h"
 #include "Core/HLE/sceKernel.h"
@@ -69,6 +73,163 @@
 #include <fcntl.h>
 #endif
 
+// Writes smaller than this are buffered with WRITE_BACK, and the buffer is flushed when it
+// reaches the limit or gets too old, in addition to before any read or seek.
+static const s64 WRITE_BACK_MAX_WRITE = 64 * 1024;
+static const size_t WRITE_BACK_BUFFER_LIMIT = 1024 * 1024;
+static const double WRITE_BACK_MAX_AGE = 1.0;
+
+static std::mutex g_writeBackLock;
+static std::condition_variable g_writeBackCond;
+// Local paths of files still being finished in the background.
+static std::vector<std::string> g_writeBackPending;
+static WriteBackStats g_writeBackStats;
+
+#ifdef _WIN32
+typedef HANDLE HostFileHandle;
+static const HostFileHandle INVALID_HOST_FILE = (HANDLE)-1;
+#else
+typedef int HostFileHandle;
+static const HostFileHandle INVALID_HOST_FILE = -1;
+#endif
+
+static bool WriteAllToHost(HostFileHandle hFile, const u8 *data, size_t size, bool *diskFull) {
+	while (size > 0) {
+#ifdef _WIN32
+		DWORD chunk = (DWORD)std::min(size, (size_t)0x40000000);
+		DWORD written = 0;
+		if (::WriteFile(hFile, (LPVOID)data, chunk, &written, 0) == FALSE) {
+			DWORD err = GetLastError();
+			*diskFull = err == ERROR_DISK_FULL || err == ERROR_NOT_ENOUGH_QUOTA;
+			return false;
+		}
+#else
+		ssize_t written = write(hFile, data, size);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			*diskFull = errno == ENOSPC;
+			return false;
+		}
+#endif
+		if (written == 0)
+			return false;
+		data += written;
+		size -= written;
+	}
+	return true;
+}
+
+static void NotifyDiskFull() {
+	ERROR_LOG(FILESYS, "Disk full");
+	auto err = GetI18NCategory("Error");
+	host->NotifyUserMessage(err->T("Disk full while writing data"));
+}
+
+static bool IsPendingWriteTo(const std::string &pending, const std::string &path, bool children) {
+	if (pending.size() == path.size())
+		return startsWithNoCase(pending, path);
+	return children && pending.size() > path.size() && pending[path.size()] == '/' && startsWithNoCase(pending, path);
+}
+
+// Waits for background writes to path, or anything under it if children is set.
+static void WaitForPendingWritesTo(const Path &path, bool children) {
+	std::unique_lock<std::mutex> guard(g_writeBackLock);
+	if (g_writeBackPending.empty())
+		return;
+
+	const std::string pathStr = path.ToString();
+	auto isPending = [&]() {
+		for (const std::string &pending : g_writeBackPending) {
+			if (IsPendingWriteTo(pending, pathStr, children))
+				return true;
+		}
+		return false;
+	};
+	if (!isPending())
+		return;
+
+	double start = time_now_d();
+	while (isPending())
+		g_writeBackCond.wait(guard);
+	g_writeBackStats.waitedSeconds += time_now_d() - start;
+}
+
+void WaitForPendingWrites() {
+	std::unique_lock<std::mutex> guard(g_writeBackLock);
+	if (g_writeBackPending.empty())
+		return;
+
+	double start = time_now_d();
+	while (!g_writeBackPending.empty())
+		g_writeBackCond.wait(guard);
+	g_writeBackStats.waitedSeconds += time_now_d() - start;
+}
+
+WriteBackStats GetWriteBackStats() {
+	std::lock_guard<std::mutex> guard(g_writeBackLock);
+	return g_writeBackStats;
+}
+
+// Writes out the rest of a file, truncates it if needed, and closes it.
+class WriteBackCloseTask : public Task {
+public:
+	WriteBackCloseTask(HostFileHandle hFile, std::vector<u8> &&data, s64 truncateTo, const std::string &path)
+		: hFile_(hFile), data_(std::move(data)), truncateTo_(truncateTo), path_(path) {}
+
+	TaskType Type() const override {
+		return TaskType::IO_BLOCKING;
+	}
+
+	TaskPriority Priority() const override {
+		return TaskPriority::HIGH;
+	}
+
+	void Run() override {
+		double start = time_now_d();
+
+		bool diskFull = false;
+		if (!WriteAllToHost(hFile_, data_.data(), data_.size(), &diskFull)) {
+			ERROR_LOG(FILESYS, "Failed to finish writing %s", path_.c_str());
+			if (diskFull)
+				NotifyDiskFull();
+		}
+		if (truncateTo_ != -1) {
+#ifdef _WIN32
+			LARGE_INTEGER distance;
+			distance.QuadPart = truncateTo_;
+			if (SetFilePointerEx(hFile_, distance, nullptr, FILE_BEGIN) == 0 || SetEndOfFile(hFile_) == 0) {
+				ERROR_LOG_REPORT(FILESYS, "Failed to truncate file.");
+			}
+#elif !PPSSPP_PLATFORM(SWITCH)
+			if (ftruncate(hFile_, (off_t)truncateTo_) != 0) {
+				ERROR_LOG_REPORT(FILESYS, "Failed to truncate file.");
+			}
+#endif
+		}
+#ifdef _WIN32
+		CloseHandle(hFile_);
+#else
+		close(hFile_);
+#endif
+
+		double elapsed = time_now_d() - start;
+		std::lock_guard<std::mutex> guard(g_writeBackLock);
+		auto it = std::find(g_writeBackPending.begin(), g_writeBackPending.end(), path_);
+		if (it != g_writeBackPending.end())
+			g_writeBackPending.erase(it);
+		g_writeBackStats.backgroundSeconds += elapsed;
+		g_writeBackStats.maxBackgroundSeconds = std::max(g_writeBackStats.maxBackgroundSeconds, elapsed);
+		g_writeBackCond.notify_all();
+	}
+
+private:
+	HostFileHandle hFile_;
+	std::vector<u8> data_;
+	s64 truncateTo_;
+	std::string path_;
+};
+
 DirectoryFileSystem::DirectoryFileSystem(IHandleAllocator *_hAlloc, const Path & _basePath, FileSystemFlags _flags) : basePath(_basePath), flags(_flags) {
 	File::CreateFullPath(basePath);
 	hAlloc = _hAlloc;
@@ -76,6 +237,13 @@ DirectoryFileSystem::DirectoryFileSystem(IHandleAllocator *_hAlloc, const Path &
 
 DirectoryFileSystem::~DirectoryFileSystem() {
 	CloseAll();
+	if (flags & FileSystemFlags::WRITE_BACK) {
+		WaitForPendingWrites();
+		WriteBackStats stats = GetWriteBackStats();
+		INFO_LOG(FILESYS, "Write-back: %lld writes batched into %lld, %lld files closed in the background, %0.3fs hidden (max %0.3fs), %0.3fs waited",
+			(long long)stats.bufferedWrites, (long long)stats.flushes, (long long)stats.backgroundCloses,
+			stats.backgroundSeconds, stats.maxBackgroundSeconds, stats.waitedSeconds);
+	}
 }
 
 // TODO(scoped): Merge the two below functions somehow.
@@ -132,6 +300,10 @@ bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, File
 #endif
 
 	Path fullName = GetLocalPath(basePath, fileName);
+	// Don't race a background write of the same file.
+	WaitForPendingWritesTo(fullName, false);
+	if (fileSystemFlags_ & FileSystemFlags::WRITE_BACK)
+		localPath_ = fullName;
 
 	// On the PSP, truncating doesn't lose data.  If you seek later, you'll recover it.
 	// This is abnormal, so we deviate from the PSP's behavior and truncate on write/close.
@@ -261,6 +433,8 @@ bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, File
 			return false;
 		}
 		fullName = GetLocalPath(basePath, fileName);
+		if (fileSystemFlags_ & FileSystemFlags::WRITE_BACK)
+			localPath_ = fullName;
 		const char *fullNameC = fullName.c_str();
 
 		DEBUG_LOG(FILESYS, "Case may have been incorrect, second try opening %s (%s)", fullNameC, fileName.c_str());
@@ -309,6 +483,8 @@ bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, File
 
 size_t DirectoryFileHandle::Read(u8* pointer, s64 size)
 {
+	FlushWrites();
+
 	size_t bytesRead = 0;
 	if (needsTrunc_ != -1) {
 		// If the file was marked to be truncated, pretend there's nothing.
@@ -333,6 +509,45 @@ size_t DirectoryFileHandle::Read(u8* pointer, s64 size)
 
 size_t DirectoryFileHandle::Write(const u8* pointer, s64 size)
 {
+	if ((fileSystemFlags_ & FileSystemFlags::WRITE_BACK) && size > 0 && size <= WRITE_BACK_MAX_WRITE) {
+		if (writeBuffer_.empty()) {
+			writeBufferTime_ = time_now_d();
+#ifdef _WIN32
+			LARGE_INTEGER zero{};
+			LARGE_INTEGER cursor;
+			SetFilePointerEx(hFile, zero, &cursor, FILE_CURRENT);
+			writeBufferPos_ = cursor.QuadPart;
+#else
+			writeBufferPos_ = lseek(hFile, 0, SEEK_CUR);
+#endif
+		}
+		writeBuffer_.insert(writeBuffer_.end(), pointer, pointer + size);
+		wroteData_ = true;
+		{
+			std::lock_guard<std::mutex> guard(g_writeBackLock);
+			g_writeBackStats.bufferedWrites++;
+		}
+
+		s64 end = writeBufferPos_ + (s64)writeBuffer_.size();
+		if (needsTrunc_ != -1 && needsTrunc_ < end) {
+			needsTrunc_ = end;
+		}
+		if (writeBuffer_.size() >= WRITE_BACK_BUFFER_LIMIT || time_now_d() - writeBufferTime_ >= WRITE_BACK_MAX_AGE) {
+			FlushWrites();
+		}
+
+		bool diskFull = false;
+		size_t bytesWritten = (size_t)size;
+		if (replay_) {
+			bytesWritten = ReplayApplyDiskWrite(pointer, (uint64_t)bytesWritten, (uint64_t)size, &diskFull, inGameDir_, CoreTiming::GetGlobalTimeUs());
+		}
+		MemoryStick_NotifyWrite();
+		return bytesWritten;
+	}
+
+	// Keep the order with anything buffered.
+	FlushWrites();
+
 	size_t bytesWritten = 0;
 	bool diskFull = false;
 
@@ -378,6 +593,8 @@ size_t DirectoryFileHandle::Write(const u8* pointer, s64 size)
 
 size_t DirectoryFileHandle::Seek(s32 position, FileMove type)
 {
+	FlushWrites();
+
 	if (needsTrunc_ != -1) {
 		// If the file is "currently truncated" move to the end based on that position.
 		// The actual, underlying file hasn't been truncated (yet.)
@@ -414,8 +631,37 @@ size_t DirectoryFileHandle::Seek(s32 position, FileMove type)
 	return replay_ ? (size_t)ReplayApplyDisk64(ReplayAction::FILE_SEEK, result, CoreTiming::GetGlobalTimeUs()) : result;
 }
 
+void DirectoryFileHandle::FlushWrites() {
+	if (writeBuffer_.empty())
+		return;
+
+	bool diskFull = false;
+	if (!WriteAllToHost(hFile, writeBuffer_.data(), writeBuffer_.size(), &diskFull)) {
+		ERROR_LOG(FILESYS, "Failed to write %d buffered bytes", (int)writeBuffer_.size());
+		if (diskFull)
+			NotifyDiskFull();
+	}
+	writeBuffer_.clear();
+
+	std::lock_guard<std::mutex> guard(g_writeBackLock);
+	g_writeBackStats.flushes++;
+}
+
 void DirectoryFileHandle::Close()
 {
+	if ((fileSystemFlags_ & FileSystemFlags::WRITE_BACK) && wroteData_ && hFile != INVALID_HOST_FILE) {
+		// Let a thread finish up, closing can be slow too on network and SD card storage.
+		{
+			std::lock_guard<std::mutex> guard(g_writeBackLock);
+			g_writeBackPending.push_back(localPath_.ToString());
+			g_writeBackStats.backgroundCloses++;
+		}
+		g_threadManager.EnqueueTask(new WriteBackCloseTask(hFile, std::move(writeBuffer_), needsTrunc_, localPath_.ToString()));
+		writeBuffer_.clear();
+		hFile = INVALID_HOST_FILE;
+		return;
+	}
+
 	if (needsTrunc_ != -1) {
 #ifdef _WIN32
 		Seek((s32)needsTrunc_, FILEMOVE_BEGIN);
@@ -466,6 +712,7 @@ bool DirectoryFileSystem::MkDir(const std::string &dirname) {
 
 bool DirectoryFileSystem::RmDir(const std::string &dirname) {
 	Path fullName = GetLocalPath(dirname);
+	WaitForPendingWritesTo(fullName, true);
 
 #if HOST_IS_CASE_SENSITIVE
 	// Maybe we're lucky?
@@ -505,6 +752,7 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 		return ReplayApplyDisk(ReplayAction::FILE_RENAME, SCE_KERNEL_ERROR_ERRNO_FILE_ALREADY_EXISTS, CoreTiming::GetGlobalTimeUs());
 
 	Path fullFrom = GetLocalPath(from);
+	WaitForPendingWritesTo(fullFrom, true);
 
 #if HOST_IS_CASE_SENSITIVE
 	// In case TO should overwrite a file with different case.  Check error code?
@@ -513,6 +761,7 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 #endif
 
 	Path fullToPath = GetLocalPath(fullTo);
+	WaitForPendingWritesTo(fullToPath, true);
 
 	bool retValue = File::Rename(fullFrom, fullToPath);
 
@@ -537,6 +786,7 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 
 bool DirectoryFileSystem::RemoveFile(const std::string &filename) {
 	Path localPath = GetLocalPath(filename);
+	WaitForPendingWritesTo(localPath, false);
 
 	bool retValue = File::Delete(localPath);
 
@@ -678,6 +928,7 @@ PSPFileInfo DirectoryFileSystem::GetFileInfo(std::string filename) {
 
 	File::FileInfo info;
 	Path fullName = GetLocalPath(filename);
+	WaitForPendingWritesTo(fullName, false);
 	if (!File::GetFileInfo(fullName, &info)) {
 #if HOST_IS_CASE_SENSITIVE
 		if (! FixPathCase(basePath, filename, FPC_FILE_MUST_EXIST))
@@ -784,6 +1035,7 @@ static std::string SimulateVFATBug(std::string filename) {
 
 bool DirectoryFileSystem::ComputeRecursiveDirSizeIfFast(const std::string &path, int64_t *size) {
 	Path localPath = GetLocalPath(path);
+	WaitForPendingWritesTo(localPath, true);
 
 	int64_t sizeTemp = File::ComputeRecursiveDirectorySize(localPath);
 	if (sizeTemp >= 0) {
@@ -799,6 +1051,7 @@ std::vector<PSPFileInfo> DirectoryFileSystem::GetDirListing(const std::string &p
 
 	std::vector<File::FileInfo> files;
 	Path localPath = GetLocalPath(path);
+	WaitForPendingWritesTo(localPath, true);
 	const int flags = File::GETFILES_GETHIDDEN | File::GETFILES_GET_NAVIGATION_ENTRIES;
 	bool success = File::GetFilesInDir(localPath, &files, nullptr, flags);
 #if HOST_IS_CASE_SENSITIVE
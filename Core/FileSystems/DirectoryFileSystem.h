@@ -20,6 +20,7 @@
 // TODO: Remove the Windows-specific code, FILE is fine there too.
 
 #include <map>
+#include <vector>
 
 #include "Common/File/Path.h"
 #include "Core/FileSystems/FileSystem.h"
@@ -44,6 +45,13 @@ struct DirectoryFileHandle {
 	bool inGameDir_ = false;
 	FileSystemFlags fileSystemFlags_ = (FileSystemFlags)0;
 
+	// For FileSystemFlags::WRITE_BACK only.
+	Path localPath_;
+	std::vector<u8> writeBuffer_;
+	s64 writeBufferPos_ = 0;
+	double writeBufferTime_ = 0.0;
+	bool wroteData_ = false;
+
 	DirectoryFileHandle() {}
 
 	DirectoryFileHandle(Flags flags, FileSystemFlags fileSystemFlags)
@@ -55,8 +63,23 @@ struct DirectoryFileHandle {
 	size_t Write(const u8* pointer, s64 size);
 	size_t Seek(s32 position, FileMove type);
 	void Close();
+	void FlushWrites();
+};
+
+// Stats for FileSystemFlags::WRITE_BACK, across all file systems using it.
+struct WriteBackStats {
+	u64 bufferedWrites;  // Writes that didn't go to the host right away.
+	u64 flushes;  // Host writes they were batched into.
+	u64 backgroundCloses;
+	double backgroundSeconds;  // Host time spent finishing files in the background, i.e. hidden.
+	double maxBackgroundSeconds;
+	double waitedSeconds;  // Time the emulator still had to wait for background work.
 };
 
+WriteBackStats GetWriteBackStats();
+// Blocks until all files closed with WRITE_BACK are fully written.
+void WaitForPendingWrites();
+
 class DirectoryFileSystem : public IFileSystem {
 public:
 	DirectoryFileSystem(IHandleAllocator *_hAlloc, const Path &_basePath, FileSystemFlags _flags = FileSystemFlags::NONE);
@@ -64,6 +64,7 @@ enum class FileSystemFlags {
 	CARD = 4,
 	FLASH = 8,
 	STRIP_PSP = 16,
+	WRITE_BACK = 32,  // Batch small writes and finish writing files in the background on close.
 };
 ENUM_CLASS_BITOPS(FileSystemFlags);
 
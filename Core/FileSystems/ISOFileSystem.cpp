@@ -178,6 +178,7 @@ ISOFileSystem::~ISOFileSystem() {
 }
 
 void ISOFileSystem::ReadDirectory(TreeEntry *root) {
+	const std::string prefix = root == treeroot ? "" : EntryFullPath(root).substr(1) + "/";
 	for (u32 secnum = root->startsector, endsector = root->startsector + (root->dirsize + 2047) / 2048; secnum < endsector; ++secnum) {
 		u8 theSector[2048];
 		if (!blockDevice->ReadBlock(secnum, theSector)) {
@@ -243,6 +244,8 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 				}
 			}
 			root->children.push_back(entry);
+			if (!relative)
+				pathIndex_.emplace(prefix + entry->name, entry);
 		}
 	}
 	root->valid = true;
@@ -269,6 +272,15 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 	if (pathLength <= pathIndex)
 		return treeroot;
 
+	// Fast path: anything inside a directory we've already read is in the index.
+	auto indexed = pathIndex_.find(pathIndex == 0 ? path : path.substr(pathIndex));
+	if (indexed != pathIndex_.end()) {
+		TreeEntry *entry = indexed->second;
+		if (!entry->valid)
+			ReadDirectory(entry);
+		return entry;
+	}
+
 	TreeEntry *entry = treeroot;
 	while (true) {
 		if (!entry->valid) {
@@ -20,6 +20,7 @@
 #include <map>
 #include <list>
 #include <memory>
+#include <unordered_map>
 
 #include "FileSystem.h"
 
@@ -92,6 +93,8 @@ class ISOFileSystem : public IFileSystem {
 	u32 lastReadBlock_;
 
 	TreeEntry entireISO;
+	// Full paths (no leading slash) of every entry read so far, filled by ReadDirectory.
+	std::unordered_map<std::string, TreeEntry *> pathIndex_;
 
 	void ReadDirectory(TreeEntry *root);
 	TreeEntry *GetFromPath(const std::string &path, bool catchError = true);
@@ -153,6 +153,7 @@ void VirtualDiscFileSystem::LoadFileListIndex() {
 			currentBlockIndex = nextBlock;
 		}
 
+		fileListIndex_.emplace(entry.fileName, (int)fileList.size());
 		fileList.push_back(entry);
 	}
 
@@ -182,6 +183,12 @@ void VirtualDiscFileSystem::DoState(PointerWrap &p)
 		Do(p, fileList[i].totalSize);
 	}
 
+	if (p.mode == p.MODE_READ) {
+		fileListIndex_.clear();
+		for (int i = 0; i < fileListSize; i++)
+			fileListIndex_.emplace(fileList[i].fileName, i);
+	}
+
 	if (p.mode == p.MODE_READ)
 	{
 		entries.clear();
@@ -267,11 +274,9 @@ int VirtualDiscFileSystem::getFileListIndex(std::string &fileName)
 		normalized = fileName;
 	}
 
-	for (size_t i = 0; i < fileList.size(); i++)
-	{
-		if (fileList[i].fileName == normalized)
-			return (int)i;
-	}
+	auto it = fileListIndex_.find(normalized);
+	if (it != fileListIndex_.end())
+		return it->second;
 
 	// unknown file - add it
 	Path fullName = GetLocalPath(fileName);
@@ -297,6 +302,7 @@ int VirtualDiscFileSystem::getFileListIndex(std::string &fileName)
 	entry.firstBlock = currentBlockIndex;
 	currentBlockIndex += (entry.totalSize+2047)/2048;
 
+	fileListIndex_.emplace(entry.fileName, (int)fileList.size());
 	fileList.push_back(entry);
 
 	return (int)fileList.size()-1;
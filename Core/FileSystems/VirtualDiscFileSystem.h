@@ -20,6 +20,7 @@
 // TODO: Remove the Windows-specific code, FILE is fine there too.
 
 #include <map>
+#include <unordered_map>
 
 #include "Common/File/Path.h"
 #include "Core/FileSystems/FileSystem.h"
@@ -186,6 +187,8 @@ class VirtualDiscFileSystem: public IFileSystem {
 	};
 
 	std::vector<FileListEntry> fileList;
+	// Normalized file name (no leading slash) -> index into fileList.
+	std::unordered_map<std::string, int> fileListIndex_;
 	u32 currentBlockIndex;
 	u32 lastReadBlock_;
 
@@ -142,6 +142,8 @@ void PGF::DoState(PointerWrap &p) {
 		if (fontData) {
 			delete [] fontData;
 		}
+		decodedGlyphs_.clear();
+		decodedGlyphBytes_ = 0;
 		if (fontDataSize) {
 			fontData = new u8[fontDataSize];
 			DoArray(p, fontData, (int)fontDataSize);
@@ -188,6 +190,8 @@ bool PGF::ReadPtr(const u8 *ptr, size_t dataSize) {
 
 	DEBUG_LOG(SCEFONT, "Reading %d bytes of PGF header", (int)sizeof(header));
 	memcpy(&header, ptr, sizeof(header));
+	decodedGlyphs_.clear();
+	decodedGlyphBytes_ = 0;
 	ptr += sizeof(header);
 
 	fileName = header.fontName;
@@ -580,10 +584,6 @@ void PGF::DrawCharacter(const GlyphImage *image, int clipX, int clipY, int clipW
 		return;
 	}
 
-	size_t bitPtr = glyph.ptr * 8;
-	int numberPixels = glyph.w * glyph.h;
-	int pixelIndex = 0;
-
 	int x = image->xPos64 >> 6;
 	int y = image->yPos64 >> 6;
 	u8 xFrac = image->xPos64 & 0x3F;
@@ -599,11 +599,88 @@ void PGF::DrawCharacter(const GlyphImage *image, int clipX, int clipY, int clipW
 	if (clipHeight < 0)
 		clipHeight = 8192;
 
+	const FontPixelFormat pixelformat = (FontPixelFormat)(u32)image->pixelFormat;
+	if (pixelformat < 0 || pixelformat > PSP_FONT_PIXELFORMAT_32) {
+		ERROR_LOG_REPORT_ONCE(pfgbadformat, SCEFONT, "Invalid image format in image: %d", (int)pixelformat);
+		return;
+	}
+
 	// Use a buffer so we can apply subpixel rendering.
-	// TODO: Cache this buffer per glyph?  Maybe even transpose it first?
-	std::vector<u8> decodedPixels;
-	decodedPixels.resize(numberPixels);
+	const std::vector<u8> &decodedPixels = GetDecodedGlyph(glyph);
+
+	auto samplePixel = [&](int xx, int yy) -> u8 {
+		if (xx < 0 || yy < 0 || xx >= glyph.w || yy >= glyph.h) {
+			return 0;
+		}
+		return decodedPixels[yy * glyph.w + xx];
+	};
+
+	int renderX1 = std::max(clipX, x) - x;
+	int renderY1 = std::max(clipY, y) - y;
+	// We can render up to frac beyond the glyph w/h, so add 1px if necessary.
+	int renderX2 = std::min(clipX + clipWidth - x, glyph.w + (xFrac > 0 ? 1 : 0));
+	int renderY2 = std::min(clipY + clipHeight - y, glyph.h + (yFrac > 0 ? 1 : 0));
+
+	// Clip to the buffer once here, same limits as SetFontPixel().
+	static const u8 fontPixelSizeInBytes[] = { 0, 0, 1, 3, 4 }; // 0 means 2 pixels per byte
+	const int pixelBytes = fontPixelSizeInBytes[pixelformat];
+	const int bufMaxWidth = std::min((int)image->bufWidth, pixelBytes == 0 ? image->bytesPerLine * 2 : image->bytesPerLine / pixelBytes);
+	renderX1 = std::max(renderX1, -x);
+	renderY1 = std::max(renderY1, -y);
+	renderX2 = std::min(renderX2, bufMaxWidth - x);
+	renderY2 = std::min(renderY2, (int)image->bufHeight - y);
+	if (renderX1 >= renderX2 || renderY1 >= renderY2) {
+		return;
+	}
+
+	u8 row[512];
+	const int rowCount = std::min(renderX2 - renderX1, (int)sizeof(row));
+	for (int yy = renderY1; yy < renderY2; ++yy) {
+		if (xFrac == 0 && yFrac == 0) {
+			for (int i = 0; i < rowCount; ++i) {
+				row[i] = samplePixel(renderX1 + i, yy);
+			}
+		} else {
+			for (int i = 0; i < rowCount; ++i) {
+				int xx = renderX1 + i;
+				// First, blend horizontally.  Tests show we blend swizzled to 8 bit.
+				u32 horiz1 = samplePixel(xx - 1, yy - 1) * xFrac + samplePixel(xx, yy - 1) * (64 - xFrac);
+				u32 horiz2 = samplePixel(xx - 1, yy + 0) * xFrac + samplePixel(xx, yy + 0) * (64 - xFrac);
+				// Now blend those together vertically.
+				u32 blended = horiz1 * yFrac + horiz2 * (64 - yFrac);
+
+				// We multiplied an 8 bit value by 64 twice, so now we have a 20 bit value.
+				row[i] = blended >> 12;
+			}
+		}
+		SetFontPixelRow(image->bufferPtr, image->bytesPerLine, image->bufWidth, image->bufHeight, x + renderX1, y + yy, row, rowCount, pixelformat);
+	}
+
+	gpu->InvalidateCache(image->bufferPtr, image->bytesPerLine * image->bufHeight, GPU_INVALIDATE_SAFE);
+}
+
+const std::vector<u8> &PGF::GetDecodedGlyph(const Glyph &glyph) const {
+	const int numberPixels = glyph.w * glyph.h;
+	auto it = decodedGlyphs_.find(glyph.ptr);
+	if (it != decodedGlyphs_.end() && (int)it->second.size() == numberPixels) {
+		return it->second;
+	}
 
+	// CJK fonts have a lot of glyphs, don't let this grow forever.
+	static const size_t MAX_DECODED_GLYPH_BYTES = 4 * 1024 * 1024;
+	if (decodedGlyphBytes_ + numberPixels > MAX_DECODED_GLYPH_BYTES) {
+		decodedGlyphs_.clear();
+		decodedGlyphBytes_ = 0;
+	}
+
+	std::vector<u8> &decodedPixels = decodedGlyphs_[glyph.ptr];
+	decodedGlyphBytes_ -= decodedPixels.size();
+	decodedPixels.assign(numberPixels, 0);
+	decodedGlyphBytes_ += numberPixels;
+
+	const bool hRows = (glyph.flags & FONT_PGF_BMP_OVERLAY) == FONT_PGF_BMP_H_ROWS;
+	size_t bitPtr = glyph.ptr * 8;
+	int pixelIndex = 0;
 	while (pixelIndex < numberPixels && bitPtr + 8 < fontDataSize * 8) {
 		// This is some kind of nibble based RLE compression.
 		int nibble = consumeBits(4, fontData, bitPtr);
@@ -622,55 +699,64 @@ void PGF::DrawCharacter(const GlyphImage *image, int clipX, int clipY, int clipW
 				value = consumeBits(4, fontData, bitPtr);
 			}
 
-			decodedPixels[pixelIndex++] = value | (value << 4);
+			// Transpose column ordered glyphs while we're at it.
+			int index = hRows ? pixelIndex : (pixelIndex % glyph.h) * glyph.w + pixelIndex / glyph.h;
+			decodedPixels[index] = value | (value << 4);
+			pixelIndex++;
 		}
 	}
 
-	auto samplePixel = [&](int xx, int yy) -> u8 {
-		if (xx < 0 || yy < 0 || xx >= glyph.w || yy >= glyph.h) {
-			return 0;
-		}
+	return decodedPixels;
+}
 
-		int index;
-		if ((glyph.flags & FONT_PGF_BMP_OVERLAY) == FONT_PGF_BMP_H_ROWS) {
-			index = yy * glyph.w + xx;
-		} else {
-			index = xx * glyph.h + yy;
+void PGF::SetFontPixelRow(u32 base, int bpl, int bufWidth, int bufHeight, int x, int y, const u8 *pixelColors, int count, FontPixelFormat pixelformat) const {
+	static const u8 fontPixelSizeInBytes[] = { 0, 0, 1, 3, 4 }; // 0 means 2 pixels per byte
+	const int pixelBytes = fontPixelSizeInBytes[pixelformat];
+	const u32 rowAddr = base + (y * bpl) + (pixelBytes == 0 ? x / 2 : x * pixelBytes);
+	const u32 rowBytes = pixelBytes == 0 ? (x + count + 1) / 2 - x / 2 : count * pixelBytes;
+
+	if (!Memory::IsValidRange(rowAddr, rowBytes)) {
+		// Let the slow path deal with (and report) it.
+		for (int i = 0; i < count; ++i) {
+			SetFontPixel(base, bpl, bufWidth, bufHeight, x + i, y, pixelColors[i], pixelformat);
 		}
+		return;
+	}
 
-		return decodedPixels[index];
-	};
-
-	int renderX1 = std::max(clipX, x) - x;
-	int renderY1 = std::max(clipY, y) - y;
-	// We can render up to frac beyond the glyph w/h, so add 1px if necessary.
-	int renderX2 = std::min(clipX + clipWidth - x, glyph.w + (xFrac > 0 ? 1 : 0));
-	int renderY2 = std::min(clipY + clipHeight - y, glyph.h + (yFrac > 0 ? 1 : 0));
-
-	if (xFrac == 0 && yFrac == 0) {
-		for (int yy = renderY1; yy < renderY2; ++yy) {
-			for (int xx = renderX1; xx < renderX2; ++xx) {
-				u8 pixelColor = samplePixel(xx, yy);
-				SetFontPixel(image->bufferPtr, image->bytesPerLine, image->bufWidth, image->bufHeight, x + xx, y + yy, pixelColor, (FontPixelFormat)(u32)image->pixelFormat);
+	u8 *dst = Memory::GetPointerWriteUnchecked(rowAddr);
+	switch (pixelformat) {
+	case PSP_FONT_PIXELFORMAT_4:
+	case PSP_FONT_PIXELFORMAT_4_REV:
+		for (int i = 0; i < count; ++i) {
+			// We always get a 8-bit value, so take only the top 4 bits.
+			const u8 pix4 = pixelColors[i] >> 4;
+			u8 *p = dst + ((x + i) / 2 - x / 2);
+			if (((x + i) & 1) != pixelformat) {
+				*p = (pix4 << 4) | (*p & 0xF);
+			} else {
+				*p = (*p & 0xF0) | pix4;
 			}
 		}
-	} else {
-		for (int yy = renderY1; yy < renderY2; ++yy) {
-			for (int xx = renderX1; xx < renderX2; ++xx) {
-				// First, blend horizontally.  Tests show we blend swizzled to 8 bit.
-				u32 horiz1 = samplePixel(xx - 1, yy - 1) * xFrac + samplePixel(xx, yy - 1) * (64 - xFrac);
-				u32 horiz2 = samplePixel(xx - 1, yy + 0) * xFrac + samplePixel(xx, yy + 0) * (64 - xFrac);
-				// Now blend those together vertically.
-				u32 blended = horiz1 * yFrac + horiz2 * (64 - yFrac);
-
-				// We multiplied an 8 bit value by 64 twice, so now we have a 20 bit value.
-				u8 pixelColor = blended >> 12;
-				SetFontPixel(image->bufferPtr, image->bytesPerLine, image->bufWidth, image->bufHeight, x + xx, y + yy, pixelColor, (FontPixelFormat)(u32)image->pixelFormat);
-			}
+		break;
+	case PSP_FONT_PIXELFORMAT_8:
+		memcpy(dst, pixelColors, count);
+		break;
+	case PSP_FONT_PIXELFORMAT_24:
+		// Each channel has the same value.
+		for (int i = 0; i < count; ++i) {
+			dst[i * 3 + 0] = pixelColors[i];
+			dst[i * 3 + 1] = pixelColors[i];
+			dst[i * 3 + 2] = pixelColors[i];
+		}
+		break;
+	case PSP_FONT_PIXELFORMAT_32:
+		for (int i = 0; i < count; ++i) {
+			// Spread the 8 bits out into all channels.
+			u32_le pix32 = pixelColors[i] * 0x01010101;
+			memcpy(dst + i * 4, &pix32, 4);
 		}
+		break;
 	}
-
-	gpu->InvalidateCache(image->bufferPtr, image->bytesPerLine * image->bufHeight, GPU_INVALIDATE_SAFE);
 }
 
 void PGF::SetFontPixel(u32 base, int bpl, int bufWidth, int bufHeight, int x, int y, u8 pixelColor, FontPixelFormat pixelformat) const {
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -281,6 +282,10 @@ class PGF {
 	int GetCharIndex(int charCode, const std::vector<int> &charmapCompressed);
 
 	void SetFontPixel(u32 base, int bpl, int bufWidth, int bufHeight, int x, int y, u8 pixelColor, FontPixelFormat pixelformat) const;
+	// Writes count pixels starting at x, y, which must already be clipped to the buffer.
+	void SetFontPixelRow(u32 base, int bpl, int bufWidth, int bufHeight, int x, int y, const u8 *pixelColors, int count, FontPixelFormat pixelformat) const;
+	// Decodes the RLE bitmap once, always returned as rows of glyph.w pixels.
+	const std::vector<u8> &GetDecodedGlyph(const Glyph &glyph) const;
 
 	PGFHeaderRev3Extra rev3extra;
 
@@ -305,4 +310,8 @@ class PGF {
 	std::vector<Glyph> glyphs;
 	std::vector<Glyph> shadowGlyphs;
 	int firstGlyph;
+
+	// Decoded glyph bitmaps by glyph.ptr. Text drawing hits the same glyphs over and over.
+	mutable std::unordered_map<u32, std::vector<u8>> decodedGlyphs_;
+	mutable size_t decodedGlyphBytes_ = 0;
 };
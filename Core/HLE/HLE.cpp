@@ -16,7 +16,9 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <cstdarg>
+#include <algorithm>
 #include <map>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -28,7 +30,9 @@
 #include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/Debugger/Breakpoints.h"
 #include "Core/Host.h"
+#include "Core/HW/Display.h"
 #include "Core/MemMapHelpers.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
@@ -70,6 +74,16 @@ static const HLEFunction *latestSyscall = nullptr;
 static uint32_t latestSyscallPC = 0;
 static int idleOp;
 
+struct HLESyscallProfileCounts {
+	u64 calls;
+	u64 hostNanos;
+	u64 cycles;
+};
+
+// Keyed by module and func index, only updated when coreCollectDebugStats is on.
+static std::map<std::pair<int, int>, HLESyscallProfileCounts> syscallProfile;
+static std::mutex syscallProfileLock;
+
 struct HLEMipsCallInfo {
 	u32 func;
 	PSPAction *action;
@@ -152,6 +166,7 @@ void HLEDoState(PointerWrap &p) {
 }
 
 void HLEShutdown() {
+	hleResetSyscallProfile();
 	hleAfterSyscall = HLE_AFTER_NOTHING;
 	latestSyscall = nullptr;
 	latestSyscallPC = 0;
@@ -587,6 +602,41 @@ inline void hleFinishSyscall(const HLEFunction &info)
 	hleAfterSyscallReschedReason = 0;
 }
 
+static void updateSyscallProfile(int modulenum, int funcnum, double total, s64 cycles) {
+	std::lock_guard<std::mutex> guard(syscallProfileLock);
+	HLESyscallProfileCounts &counts = syscallProfile[std::make_pair(modulenum, funcnum)];
+	counts.calls++;
+	if (total > 0.0)
+		counts.hostNanos += (u64)(total * 1000000000.0);
+	if (cycles > 0)
+		counts.cycles += cycles;
+}
+
+std::vector<HLESyscallProfile> hleGetSyscallProfile() {
+	std::vector<HLESyscallProfile> result;
+	std::lock_guard<std::mutex> guard(syscallProfileLock);
+	result.reserve(syscallProfile.size());
+	for (const auto &it : syscallProfile) {
+		int modulenum = it.first.first;
+		int funcnum = it.first.second;
+		if (modulenum >= (int)moduleDB.size() || funcnum >= moduleDB[modulenum].numFunctions)
+			continue;
+
+		const HLEModule &module = moduleDB[modulenum];
+		result.push_back({ module.name, module.funcTable[funcnum].name, it.second.calls, it.second.hostNanos, it.second.cycles });
+	}
+
+	std::sort(result.begin(), result.end(), [](const HLESyscallProfile &a, const HLESyscallProfile &b) {
+		return a.hostNanos > b.hostNanos;
+	});
+	return result;
+}
+
+void hleResetSyscallProfile() {
+	std::lock_guard<std::mutex> guard(syscallProfileLock);
+	syscallProfile.clear();
+}
+
 static void updateSyscallStats(int modulenum, int funcnum, double total)
 {
 	const char *name = moduleDB[modulenum].funcTable[funcnum].name;
@@ -662,6 +712,26 @@ inline void CallSyscallWithoutFlags(const HLEFunction *info)
 		SetDeadbeefRegs();
 }
 
+inline void CallSyscallPure(const HLEFunction *info)
+{
+	latestSyscall = info;
+	latestSyscallPC = currentMIPS->pc;
+	info->func();
+
+	_dbg_assert_msg_(hleAfterSyscall == HLE_AFTER_NOTHING, "Syscall %s is flagged pure but needs after syscall work", info->name);
+	if (hleAfterSyscall != HLE_AFTER_NOTHING)
+		hleFinishSyscall(*info);
+	else
+		SetDeadbeefRegs();
+}
+
+static bool IsPureSyscallInfo(const HLEFunction *info) {
+	if (!info || !info->func || (info->flags & HLE_PURE) == 0)
+		return false;
+	// Any other check flag might return early or needs the normal path.
+	return (info->flags & ~(HLE_PURE | HLE_KERNEL_SYSCALL)) == 0;
+}
+
 const HLEFunction *GetSyscallFuncPointer(MIPSOpcode op)
 {
 	u32 callno = (op >> 6) & 0xFFFFF; //20 bits
@@ -694,11 +764,20 @@ void *GetQuickSyscallFunc(MIPSOpcode op) {
 	// TODO: Do this with a flag?
 	if (op == idleOp)
 		return (void *)info->func;
-	if (info->flags != 0)
+	if (IsPureSyscallInfo(info))
+		return (void *)&CallSyscallPure;
+	if ((info->flags & ~HLE_PURE) != 0)
 		return (void *)&CallSyscallWithFlags;
 	return (void *)&CallSyscallWithoutFlags;
 }
 
+bool IsPureSyscall(MIPSOpcode op) {
+	// Stats and memchecks both want to see the block exit after the syscall.
+	if (coreCollectDebugStats || op == idleOp || CBreakPoints::HasMemChecks())
+		return false;
+	return IsPureSyscallInfo(GetSyscallFuncPointer(op));
+}
+
 static double hleSteppingTime = 0.0;
 void hleSetSteppingTime(double t) {
 	hleSteppingTime += t;
@@ -712,9 +791,12 @@ void hleSetFlipTime(double t) {
 void CallSyscall(MIPSOpcode op)
 {
 	PROFILE_THIS_SCOPE("syscall");
+	FrameTimeScope frameTimeScope(FrameTimeCategory::HLE);
 	double start = 0.0;  // need to initialize to fix the race condition where coreCollectDebugStats is enabled in the middle of this func.
+	u64 startTicks = 0;
 	if (coreCollectDebugStats) {
 		start = time_now_d();
+		startTicks = CoreTiming::GetTicks();
 	}
 
 	const HLEFunction *info = GetSyscallFuncPointer(op);
@@ -726,7 +808,7 @@ void CallSyscall(MIPSOpcode op)
 	if (info->func) {
 		if (op == idleOp)
 			info->func();
-		else if (info->flags != 0)
+		else if ((info->flags & ~HLE_PURE) != 0)
 			CallSyscallWithFlags(info);
 		else
 			CallSyscallWithoutFlags(info);
@@ -736,7 +818,7 @@ void CallSyscall(MIPSOpcode op)
 		ERROR_LOG_REPORT(HLE, "Unimplemented HLE function %s", info->name ? info->name : "(\?\?\?)");
 	}
 
-	if (coreCollectDebugStats) {
+	if (coreCollectDebugStats && start != 0.0) {
 		u32 callno = (op >> 6) & 0xFFFFF; //20 bits
 		int funcnum = callno & 0xFFF;
 		int modulenum = (callno & 0xFF000) >> 12;
@@ -747,6 +829,8 @@ void CallSyscall(MIPSOpcode op)
 		hleSteppingTime = 0.0;
 		hleFlipTime = 0.0;
 		updateSyscallStats(modulenum, funcnum, total);
+		if (op != idleOp)
+			updateSyscallProfile(modulenum, funcnum, total, (s64)(CoreTiming::GetTicks() - startTicks));
 	}
 }
 
@@ -20,6 +20,7 @@
 #include <cstdio>
 #include <cstdarg>
 #include <type_traits>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Log.h"
@@ -42,6 +43,9 @@ enum {
 	HLE_CLEAR_STACK_BYTES = 1 << 10,
 	// Indicates that this call operates in kernel mode.
 	HLE_KERNEL_SYSCALL = 1 << 11,
+	// Indicates the call never reschedules, delays, or otherwise needs hleFinishSyscall().
+	// The jit may then call it directly and keep compiling the block after the syscall.
+	HLE_PURE = 1 << 12,
 };
 
 struct HLEFunction
@@ -156,6 +160,22 @@ void HLEReturnFromMipsCall();
 const HLEFunction *GetSyscallFuncPointer(MIPSOpcode op);
 // For jit, takes arg: const HLEFunction *
 void *GetQuickSyscallFunc(MIPSOpcode op);
+// For jit, true if the block can continue after calling this syscall.
+bool IsPureSyscall(MIPSOpcode op);
+
+struct HLESyscallProfile {
+	const char *module;
+	const char *name;
+	u64 calls;
+	// Host time spent inside the call, not counting time in the debugger.
+	u64 hostNanos;
+	// Emulated cycles eaten by the call (i.e. hleEatCycles.)
+	u64 cycles;
+};
+
+// Only collected while debug stats are on (see Core_ForceDebugStats), sorted by hostNanos.
+std::vector<HLESyscallProfile> hleGetSyscallProfile();
+void hleResetSyscallProfile();
 
 void hleDoLogInternal(LogTypes::LOG_TYPE t, LogTypes::LOG_LEVELS level, u64 res, const char *file, int line, const char *reportTag, char retmask, const char *reason, const char *formatted_reason);
 
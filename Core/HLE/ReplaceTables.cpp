@@ -20,6 +20,7 @@
 #include <map>
 #include <unordered_map>
 
+#include "Common/BitSet.h"
 #include "Common/CommonTypes.h"
 #include "Common/Data/Convert/SmallDataConvert.h"
 #include "Common/Log.h"
@@ -44,6 +45,12 @@
 
 #if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
 #include <emmintrin.h>
+#elif PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
 #endif
 
 enum class GPUReplacementSkip {
@@ -118,6 +125,111 @@ static int Replace_ceilf() {
 	return 30;  // guess number of cycles
 }
 
+// Copies in 16 byte blocks, each read fully before it's written.  Star Ocean relies on this with overlap.
+static void CopyBlocks16(u8 *dst, const u8 *src, u32 bytes) {
+	const u32 blocks = bytes & ~0x0f;
+	for (u32 offset = 0; offset < blocks; offset += 0x10) {
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+		_mm_storeu_si128((__m128i *)(dst + offset), _mm_loadu_si128((const __m128i *)(src + offset)));
+#elif PPSSPP_ARCH(ARM_NEON)
+		vst1q_u8(dst + offset, vld1q_u8(src + offset));
+#else
+		u8 block[0x10];
+		memcpy(block, src + offset, 0x10);
+		memcpy(dst + offset, block, 0x10);
+#endif
+	}
+	for (u32 offset = blocks; offset < bytes; ++offset) {
+		dst[offset] = src[offset];
+	}
+}
+
+// Same result as a forward byte loop, which repeats a pattern when dst overlaps the end of src.
+static void CopyForward(u8 *dst, const u8 *src, u32 bytes) {
+	if (dst <= src || dst >= src + bytes) {
+		memmove(dst, src, bytes);
+		return;
+	}
+
+	// Each chunk only reads what the previous chunk wrote, so they never overlap.
+	const u32 distance = (u32)(dst - src);
+	for (u32 offset = 0; offset < bytes; offset += distance) {
+		memcpy(dst + offset, src + offset, std::min(distance, bytes - offset));
+	}
+}
+
+// Returns the offset of the first byte equal to c or zero, or size if there's none.
+static u32 FindCharOrNull(const u8 *p, u32 size, u8 c) {
+	u32 i = 0;
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	const __m128i needle = _mm_set1_epi8((char)c);
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= size; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+		u32 mask = (u32)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, needle), _mm_cmpeq_epi8(v, zero)));
+		if (mask != 0)
+			return i + LeastSignificantSetBit(mask);
+	}
+#elif PPSSPP_ARCH(ARM64_NEON)
+	const uint8x16_t needle = vdupq_n_u8(c);
+	const uint8x16_t zero = vdupq_n_u8(0);
+	for (; i + 16 <= size; i += 16) {
+		uint8x16_t v = vld1q_u8(p + i);
+		// The scalar loop below finds the exact position.
+		if (vmaxvq_u8(vorrq_u8(vceqq_u8(v, needle), vceqq_u8(v, zero))) != 0)
+			break;
+	}
+#endif
+	for (; i < size; ++i) {
+		if (p[i] == c || p[i] == 0)
+			return i;
+	}
+	return size;
+}
+
+// Returns the offset of the first differing byte, or size if they're the same.
+static u32 FindMismatch(const u8 *a, const u8 *b, u32 size) {
+	u32 i = 0;
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	for (; i + 16 <= size; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+		u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xFFFF;
+		if (mask != 0)
+			return i + LeastSignificantSetBit(mask);
+	}
+#elif PPSSPP_ARCH(ARM64_NEON)
+	for (; i + 16 <= size; i += 16) {
+		if (vminvq_u8(vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i))) != 0xFF)
+			break;
+	}
+#endif
+	for (; i < size; ++i) {
+		if (a[i] != b[i])
+			return i;
+	}
+	return size;
+}
+
+// Looks up the tag once per copy.  Reads aren't recorded, so they're only posted for memchecks.
+static void NotifyReplaceCopy(const char *prefix, u32 destPtr, u32 srcPtr, u32 bytes, bool checkVideo) {
+	if (!MemBlockInfoDetailed(bytes))
+		return;
+
+	char tagData[128];
+	size_t tagSize = FormatMemWriteTagAt(tagData, sizeof(tagData), prefix, srcPtr, bytes);
+	if (CBreakPoints::HasMemChecks())
+		NotifyMemInfo(MemBlockFlags::READ, srcPtr, bytes, tagData, tagSize);
+	NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, tagData, tagSize);
+
+	// It's pretty common that games will copy video data.
+	if (checkVideo && bytes == 512 * 272 * 4) {
+		if (!strcmp(tagData, "ReplaceMemcpy/VideoDecode") || !strcmp(tagData, "ReplaceMemcpy/VideoDecodeRange")) {
+			gpu->PerformWriteFormattedFromMemory(destPtr, bytes, 512, GE_FORMAT_8888);
+		}
+	}
+}
+
 // Should probably do JIT versions of this, possibly ones that only delegate
 // large copies to a C function.
 static int Replace_memcpy() {
@@ -145,32 +257,14 @@ static int Replace_memcpy() {
 			// Already logged.
 		} else if (std::min(destPtr, srcPtr) + bytes > std::max(destPtr, srcPtr)) {
 			// Overlap.  Star Ocean breaks if it's not handled in 16 bytes blocks.
-			const u32 blocks = bytes & ~0x0f;
-			for (u32 offset = 0; offset < blocks; offset += 0x10) {
-				memcpy(dst + offset, src + offset, 0x10);
-			}
-			for (u32 offset = blocks; offset < bytes; ++offset) {
-				dst[offset] = src[offset];
-			}
+			CopyBlocks16(dst, src, bytes);
 		} else {
 			memmove(dst, src, bytes);
 		}
 	}
 	RETURN(destPtr);
 
-	if (MemBlockInfoDetailed(bytes)) {
-		char tagData[128];
-		size_t tagSize = FormatMemWriteTagAt(tagData, sizeof(tagData), "ReplaceMemcpy/", srcPtr, bytes);
-		NotifyMemInfo(MemBlockFlags::READ, srcPtr, bytes, tagData, tagSize);
-		NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, tagData, tagSize);
-
-		// It's pretty common that games will copy video data.
-		if (!strcmp(tagData, "ReplaceMemcpy/VideoDecode") || !strcmp(tagData, "ReplaceMemcpy/VideoDecodeRange")) {
-			if (bytes == 512 * 272 * 4) {
-				gpu->PerformWriteFormattedFromMemory(destPtr, bytes, 512, GE_FORMAT_8888);
-			}
-		}
-	}
+	NotifyReplaceCopy("ReplaceMemcpy/", destPtr, srcPtr, bytes, true);
 
 	return 10 + bytes / 4;  // approximation
 }
@@ -194,12 +288,9 @@ static int Replace_memcpy_jak() {
 		u8 *dst = Memory::GetPointerWriteRange(destPtr, bytes);
 		const u8 *src = Memory::GetPointerRange(srcPtr, bytes);
 
-		if (!dst || !src) {
-		} else {
+		if (dst && src) {
 			// Jak style overlap.
-			for (u32 i = 0; i < bytes; i++) {
-				dst[i] = src[i];
-			}
+			CopyForward(dst, src, bytes);
 		}
 	}
 
@@ -211,19 +302,7 @@ static int Replace_memcpy_jak() {
 	currentMIPS->r[MIPS_REG_A3] = destPtr + bytes;
 	RETURN(destPtr);
 
-	if (MemBlockInfoDetailed(bytes)) {
-		char tagData[128];
-		size_t tagSize = FormatMemWriteTagAt(tagData, sizeof(tagData), "ReplaceMemcpy/", srcPtr, bytes);
-		NotifyMemInfo(MemBlockFlags::READ, srcPtr, bytes, tagData, tagSize);
-		NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, tagData, tagSize);
-
-		// It's pretty common that games will copy video data.
-		if (!strcmp(tagData, "ReplaceMemcpy/VideoDecode") || !strcmp(tagData, "ReplaceMemcpy/VideoDecodeRange")) {
-			if (bytes == 512 * 272 * 4) {
-				gpu->PerformWriteFormattedFromMemory(destPtr, bytes, 512, GE_FORMAT_8888);
-			}
-		}
-	}
+	NotifyReplaceCopy("ReplaceMemcpy/", destPtr, srcPtr, bytes, true);
 
 	return 5 + bytes * 8 + 2;  // approximation. This is a slow memcpy - a byte copy loop..
 }
@@ -251,12 +330,7 @@ static int Replace_memcpy16() {
 	}
 	RETURN(destPtr);
 
-	if (MemBlockInfoDetailed(bytes)) {
-		char tagData[128];
-		size_t tagSize = FormatMemWriteTagAt(tagData, sizeof(tagData), "ReplaceMemcpy16/", srcPtr, bytes);
-		NotifyMemInfo(MemBlockFlags::READ, srcPtr, bytes, tagData, tagSize);
-		NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, tagData, tagSize);
-	}
+	NotifyReplaceCopy("ReplaceMemcpy16/", destPtr, srcPtr, bytes, false);
 
 	return 10 + bytes / 4;  // approximation
 }
@@ -293,12 +367,7 @@ static int Replace_memcpy_swizzled() {
 
 	RETURN(0);
 
-	if (MemBlockInfoDetailed(pitch * h)) {
-		char tagData[128];
-		size_t tagSize = FormatMemWriteTagAt(tagData, sizeof(tagData), "ReplaceMemcpySwizzle/", srcPtr, pitch * h);
-		NotifyMemInfo(MemBlockFlags::READ, srcPtr, pitch * h, tagData, tagSize);
-		NotifyMemInfo(MemBlockFlags::WRITE, destPtr, pitch * h, tagData, tagSize);
-	}
+	NotifyReplaceCopy("ReplaceMemcpySwizzle/", destPtr, srcPtr, pitch * h, false);
 
 	return 10 + (pitch * h) / 4;  // approximation
 }
@@ -325,20 +394,12 @@ static int Replace_memmove() {
 	}
 	RETURN(destPtr);
 
-	if (MemBlockInfoDetailed(bytes)) {
-		char tagData[128];
-		size_t tagSize = FormatMemWriteTagAt(tagData, sizeof(tagData), "ReplaceMemmove/", srcPtr, bytes);
-		NotifyMemInfo(MemBlockFlags::READ, srcPtr, bytes, tagData, tagSize);
-		NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, tagData, tagSize);
-	}
+	NotifyReplaceCopy("ReplaceMemmove/", destPtr, srcPtr, bytes, false);
 
 	return 10 + bytes / 4;  // approximation
 }
 
-static int Replace_memset() {
-	u32 destPtr = PARAM(0);
-	u8 value = PARAM(1);
-	u32 bytes = PARAM(2);
+static void ReplaceMemsetBulk(u32 destPtr, u8 value, u32 bytes) {
 	bool skip = false;
 	if (Memory::IsVRAMAddress(destPtr) && (skipGPUReplacements & (int)GPUReplacementSkip::MEMSET) == 0) {
 		skip = gpu->PerformMemorySet(destPtr, value, bytes);
@@ -349,10 +410,23 @@ static int Replace_memset() {
 			memset(dst, value, bytes);
 		}
 	}
-	RETURN(destPtr);
 
 	NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, "ReplaceMemset");
+}
+
+static int Replace_memset() {
+	u32 destPtr = PARAM(0);
+	u8 value = PARAM(1);
+	u32 bytes = PARAM(2);
+	ReplaceMemsetBulk(destPtr, value, bytes);
+	RETURN(destPtr);
+	return 10 + bytes / 4;  // approximation
+}
 
+static int Replace_bzero() {
+	u32 destPtr = PARAM(0);
+	u32 bytes = PARAM(1);
+	ReplaceMemsetBulk(destPtr, 0, bytes);
 	return 10 + bytes / 4;  // approximation
 }
 
@@ -366,24 +440,13 @@ static int Replace_memset_jak() {
 		return 5;
 	}
 
-	bool skip = false;
-	if (Memory::IsVRAMAddress(destPtr) && (skipGPUReplacements & (int)GPUReplacementSkip::MEMSET) == 0) {
-		skip = gpu->PerformMemorySet(destPtr, value, bytes);
-	}
-	if (!skip && bytes != 0) {
-		u8 *dst = Memory::GetPointerWriteRange(destPtr, bytes);
-		if (dst) {
-			memset(dst, value, bytes);
-		}
-	}
+	ReplaceMemsetBulk(destPtr, value, bytes);
 
 	currentMIPS->r[MIPS_REG_T0] = destPtr + bytes;
 	currentMIPS->r[MIPS_REG_A2] = -1;
 	currentMIPS->r[MIPS_REG_A3] = -1;
 	RETURN(destPtr);
 
-	NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, "ReplaceMemset");
-
 	return 5 + bytes * 6 + 2;  // approximation (hm, inspecting the disasm this should be 5 + 6 * bytes + 2, but this is what works..)
 }
 
@@ -459,6 +522,35 @@ static int Replace_strncmp() {
 	return 10 + bytes / 4;  // approximation
 }
 
+static int Replace_memcmp() {
+	u32 bytes = PARAM(2);
+	const u8 *a = Memory::GetPointerRange(PARAM(0), bytes);
+	const u8 *b = Memory::GetPointerRange(PARAM(1), bytes);
+	u32 offset = a && b ? FindMismatch(a, b, bytes) : bytes;
+	// The PSP's libc returns the difference of the bytes, not just the sign.
+	if (offset < bytes) {
+		RETURN((int)a[offset] - (int)b[offset]);
+	} else {
+		RETURN(0);
+	}
+	return 10 + offset / 4;  // approximation
+}
+
+static int Replace_strchr() {
+	u32 srcPtr = PARAM(0);
+	u8 c = PARAM(1);
+	u32 maxLen = Memory::ValidSize(srcPtr, 0x07FFFFFF);
+	const u8 *src = Memory::GetPointerRange(srcPtr, maxLen);
+	u32 offset = src ? FindCharOrNull(src, maxLen, c) : maxLen;
+	// Searching for the terminator itself finds it, like strchr().
+	if (offset < maxLen && src[offset] == c) {
+		RETURN(srcPtr + offset);
+	} else {
+		RETURN(0);
+	}
+	return 7 + offset * 4;  // approximation
+}
+
 static int Replace_fabsf() {
 	RETURNF(fabsf(PARAMF(0)));
 	return 4;
@@ -1458,11 +1550,14 @@ static const ReplacementTableEntry entries[] = {
 	{ "memmove", &Replace_memmove, 0, 0 },
 	{ "memset", &Replace_memset, 0, 0 },
 	{ "memset_jak", &Replace_memset_jak, 0, 0 },
+	{ "bzero", &Replace_bzero, 0, 0 },
+	{ "memcmp", &Replace_memcmp, 0, 0 },
 	{ "strlen", &Replace_strlen, 0, REPFLAG_DISABLED },
 	{ "strcpy", &Replace_strcpy, 0, REPFLAG_DISABLED },
 	{ "strncpy", &Replace_strncpy, 0, REPFLAG_DISABLED },
 	{ "strcmp", &Replace_strcmp, 0, REPFLAG_DISABLED },
 	{ "strncmp", &Replace_strncmp, 0, REPFLAG_DISABLED },
+	{ "strchr", &Replace_strchr, 0, REPFLAG_DISABLED },
 	{ "fabsf", &Replace_fabsf, JITFUNC(Replace_fabsf), REPFLAG_ALLOWINLINE | REPFLAG_DISABLED },
 	{ "dl_write_matrix", &Replace_dl_write_matrix, 0, REPFLAG_DISABLED }, // &MIPSComp::Jit::Replace_dl_write_matrix, REPFLAG_DISABLED },
 	{ "dl_write_matrix_2", &Replace_dl_write_matrix, 0, REPFLAG_DISABLED },
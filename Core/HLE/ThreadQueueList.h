@@ -18,6 +18,7 @@
 #pragma once
 
 #include "Core/HLE/sceKernel.h"
+#include "Common/BitSet.h"
 #include "Common/Serialize/Serializer.h"
 
 struct ThreadQueueList {
@@ -25,6 +26,8 @@ struct ThreadQueueList {
 	static const int NUM_QUEUES = 128;
 	// Initial number of threads a single queue can handle.
 	static const int INITIAL_CAPACITY = 32;
+	// Number of 32-bit words in the non-empty queue bitmap.
+	static const int NUM_BITMAP_WORDS = NUM_QUEUES / 32;
 
 	struct Queue {
 		// Next ever-been-used queue (worse priority.)
@@ -51,6 +54,7 @@ struct ThreadQueueList {
 
 	ThreadQueueList() {
 		memset(queues, 0, sizeof(queues));
+		memset(nonEmpty, 0, sizeof(nonEmpty));
 		first = invalid();
 	}
 
@@ -75,37 +79,27 @@ struct ThreadQueueList {
 	}
 
 	inline SceUID pop_first() {
-		Queue *cur = first;
-		while (cur != invalid()) {
-			if (cur->size() > 0)
-				return cur->data[cur->first++];
-			cur = cur->next;
-		}
+		int priority = first_priority(NUM_QUEUES);
+		if (priority >= 0)
+			return pop_from(priority);
 
 		_dbg_assert_msg_(false, "ThreadQueueList should not be empty.");
 		return 0;
 	}
 
 	inline SceUID pop_first_better(u32 priority) {
-		Queue *cur = first;
 		// Don't bother looking past (worse than) this priority.
-		Queue *stop = &queues[priority];
-		while (cur < stop) {
-			if (cur->size() > 0)
-				return cur->data[cur->first++];
-			cur = cur->next;
-		}
+		int best = first_priority(priority);
+		if (best >= 0)
+			return pop_from(best);
 
 		return 0;
 	}
 
 	inline SceUID peek_first() {
-		Queue *cur = first;
-		while (cur != invalid()) {
-			if (cur->size() > 0)
-				return cur->data[cur->first];
-			cur = cur->next;
-		}
+		int priority = first_priority(NUM_QUEUES);
+		if (priority >= 0)
+			return queues[priority].data[queues[priority].first];
 
 		return 0;
 	}
@@ -113,6 +107,7 @@ struct ThreadQueueList {
 	inline void push_front(u32 priority, const SceUID threadID) {
 		Queue *cur = &queues[priority];
 		cur->data[--cur->first] = threadID;
+		mark_non_empty(priority);
 		// If we ran out of room toward the front, add more room for next time.
 		if (cur->first == 0)
 			rebalance(priority);
@@ -121,6 +116,7 @@ struct ThreadQueueList {
 	inline void push_back(u32 priority, const SceUID threadID) {
 		Queue *cur = &queues[priority];
 		cur->data[cur->end++] = threadID;
+		mark_non_empty(priority);
 		if (cur->full())
 			rebalance(priority);
 	}
@@ -139,6 +135,8 @@ struct ThreadQueueList {
 
 				// Now we're one shorter.
 				--cur->end;
+				if (cur->empty())
+					mark_empty(priority);
 				return;
 			}
 		}
@@ -164,6 +162,7 @@ struct ThreadQueueList {
 				free(queues[i].data);
 		}
 		memset(queues, 0, sizeof(queues));
+		memset(nonEmpty, 0, sizeof(nonEmpty));
 		first = invalid();
 	}
 
@@ -210,8 +209,11 @@ struct ThreadQueueList {
 				cur->end = cur->first + size;
 			}
 
-			if (size != 0)
+			if (size != 0) {
 				DoArray(p, &cur->data[cur->first], size);
+				if (p.mode == p.MODE_READ)
+					mark_non_empty(i);
+			}
 		}
 	}
 
@@ -220,6 +222,33 @@ struct ThreadQueueList {
 		return (Queue *)-1;
 	}
 
+	inline void mark_non_empty(u32 priority) {
+		nonEmpty[priority / 32] |= 1U << (priority & 31);
+	}
+
+	inline void mark_empty(u32 priority) {
+		nonEmpty[priority / 32] &= ~(1U << (priority & 31));
+	}
+
+	// Returns the best priority with any threads, if better than limit, or -1.
+	inline int first_priority(u32 limit) const {
+		for (int i = 0; i < NUM_BITMAP_WORDS; ++i) {
+			if (nonEmpty[i] != 0) {
+				int priority = i * 32 + LeastSignificantSetBit(nonEmpty[i]);
+				return priority < (int)limit ? priority : -1;
+			}
+		}
+		return -1;
+	}
+
+	inline SceUID pop_from(u32 priority) {
+		Queue *cur = &queues[priority];
+		SceUID threadID = cur->data[cur->first++];
+		if (cur->empty())
+			mark_empty(priority);
+		return threadID;
+	}
+
 	// Initialize a priority level and link to other queues.
 	void link(u32 priority, int size) {
 		_dbg_assert_msg_(queues[priority].data == nullptr, "ThreadQueueList::Queue should only be initialized once.");
@@ -286,4 +315,6 @@ struct ThreadQueueList {
 	Queue *first;
 	// The priority level queues of thread ids.
 	Queue queues[NUM_QUEUES];
+	// One bit per priority level with threads in its queue, so the best can be found quickly.
+	u32 nonEmpty[NUM_BITMAP_WORDS];
 };
@@ -15,6 +15,7 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 
@@ -23,6 +24,7 @@
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Data/Collections/FixedSizeQueue.h"
+#include "Common/Profiler/Profiler.h"
 
 #ifdef _M_SSE
 #include <emmintrin.h>
@@ -278,11 +280,26 @@ u32 __AudioEnqueue(AudioChannel &chan, int chanNum, bool blocking) {
 				}
 			}
 		} else if (chan.format == PSP_AUDIO_FORMAT_MONO) {
-			// Rare, so unoptimized. Expands to stereo.
-			for (u32 i = 0; i < chan.sampleCount; i++) {
-				s16 sample = (s16)Memory::Read_U16(chan.sampleAddress + 2 * i);
-				chanSampleQueues[chanNum].push(ApplySampleVolume(sample, leftVol));
-				chanSampleQueues[chanNum].push(ApplySampleVolume(sample, rightVol));
+			// Rare, so not vectorized. Expands to stereo a chunk at a time.
+			const s16_le *sampleData = (const s16_le *)Memory::GetPointer(chan.sampleAddress);
+			if (chan.sampleCount != 0 && Memory::IsValidAddress(chan.sampleAddress + (chan.sampleCount - 1) * sizeof(s16_le))) {
+				s16 stereo[512];
+				for (u32 i = 0; i < chan.sampleCount; ) {
+					const u32 n = std::min(chan.sampleCount - i, (u32)ARRAY_SIZE(stereo) / 2);
+					for (u32 j = 0; j < n; j++) {
+						s16 sample = sampleData[i + j];
+						stereo[j * 2] = ApplySampleVolume(sample, leftVol);
+						stereo[j * 2 + 1] = ApplySampleVolume(sample, rightVol);
+					}
+					chanSampleQueues[chanNum].push_array(stereo, n * 2);
+					i += n;
+				}
+			} else {
+				for (u32 i = 0; i < chan.sampleCount; i++) {
+					s16 sample = (s16)Memory::Read_U16(chan.sampleAddress + 2 * i);
+					chanSampleQueues[chanNum].push(ApplySampleVolume(sample, leftVol));
+					chanSampleQueues[chanNum].push(ApplySampleVolume(sample, rightVol));
+				}
 			}
 		}
 	}
@@ -340,6 +357,7 @@ void __AudioUpdate(bool resetRecording) {
 	// Audio throttle doesn't really work on the PSP since the mixing intervals are so closely tied
 	// to the CPU. Much better to throttle the frame rate on frame display and just throw away audio
 	// if the buffer somehow gets full.
+	PROFILE_THIS_SCOPE("audiomix");
 	bool firstChannel = true;
 	const int16_t srcBufferSize = hwBlockSize * 2;
 	int16_t srcBuffer[srcBufferSize];
@@ -402,22 +420,14 @@ void __AudioUpdate(bool resetRecording) {
 		}
 
 		if (firstChannel) {
-			for (size_t s = 0; s < sz1; s++)
-				mixBuffer[s] = buf1[s];
-			if (buf2) {
-				for (size_t s = 0; s < sz2; s++)
-					mixBuffer[s + sz1] = buf2[s];
-			}
+			ConvertS16ToS32(mixBuffer, buf1, sz1);
+			if (buf2)
+				ConvertS16ToS32(mixBuffer + sz1, buf2, sz2);
 			firstChannel = false;
 		} else {
-			// Surprisingly hard to SIMD efficiently on SSE2 due to lack of 16-to-32-bit sign extension. NEON should be straight-forward though, and SSE4.1 can do it nicely.
-			// Actually, the cmple/pack trick should work fine...
-			for (size_t s = 0; s < sz1; s++)
-				mixBuffer[s] += buf1[s];
-			if (buf2) {
-				for (size_t s = 0; s < sz2; s++)
-					mixBuffer[s + sz1] += buf2[s];
-			}
+			AccumulateS16ToS32(mixBuffer, buf1, sz1);
+			if (buf2)
+				AccumulateS16ToS32(mixBuffer + sz1, buf2, sz2);
 		}
 	}
 
@@ -453,9 +463,7 @@ void __AudioUpdate(bool resetRecording) {
 			}
 		} else {
 			if (g_Config.bDumpAudio) {
-				for (int i = 0; i < hwBlockSize * 2; i++) {
-					clampedMixBuffer[i] = clamp_s16(mixBuffer[i]);
-				}
+				ClampS32ToS16(clampedMixBuffer, mixBuffer, hwBlockSize * 2);
 				g_wave_writer.AddStereoSamples(clampedMixBuffer, hwBlockSize);
 			} else {
 				__StopLogAudio();
@@ -28,6 +28,9 @@
 #include <string.h>
 #include <signal.h>
 
+#include <algorithm>
+#include <vector>
+
 #if defined(HAVE_LIBNX) || PPSSPP_PLATFORM(SWITCH)
 #include <netdb.h>
 #include <switch.h>
@@ -52,6 +55,12 @@ extern "C" struct hostent *gethostbyname(const char *name);
 
 #include <fcntl.h>
 #include <errno.h>
+
+#if defined(__linux__)
+// Linux and Android get an edge triggered event loop, others use select.
+#include <sys/epoll.h>
+#define ADHOCSERVER_USE_EPOLL
+#endif
 //#include <sqlite3.h>
 
 #ifndef MSG_NOSIGNAL
@@ -83,6 +92,26 @@ SceNetAdhocctlGameNode * _db_game = NULL;
 std::atomic<bool> adhocServerRunning(false);
 std::thread adhocServerThread;
 
+// Status Logfile needs rewriting (done at most once per second)
+static bool statusUpdatePending = false;
+
+#ifdef ADHOCSERVER_USE_EPOLL
+// Event Loop Descriptor
+static int serverEpoll = -1;
+#endif
+
+// Connection and Throughput Statistics
+struct AdhocServerStats {
+	uint64_t accepted;
+	uint64_t dropped;
+	uint64_t bytesReceived;
+	uint64_t bytesSent;
+	uint64_t sendCalls;
+	uint64_t packetsReceived;
+	uint32_t peakUsers;
+};
+static AdhocServerStats serverStats;
+
 // Crosslink database for cross region Adhoc play
 std::vector<db_crosslink> crosslinks;
 static const db_crosslink default_crosslinks[] = {
@@ -550,14 +579,25 @@ void login_user_stream(int fd, uint32_t ip)
 				// Initialize Death Clock
 				user->last_recv = time(NULL);
 
+#ifdef ADHOCSERVER_USE_EPOLL
+				// Watch Socket (closing it removes it again)
+				struct epoll_event ev;
+				memset(&ev, 0, sizeof(ev));
+				ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+				ev.data.ptr = user;
+				epoll_ctl(serverEpoll, EPOLL_CTL_ADD, fd, &ev);
+#endif
+
 				// Notify User
 				INFO_LOG(SCENET, "AdhocServer: New Connection from %s", ip2str(*(in_addr*)&user->resolver.ip).c_str());
 
 				// Fix User Counter
 				_db_user_count++;
+				serverStats.accepted++;
+				if (_db_user_count > serverStats.peakUsers) serverStats.peakUsers = _db_user_count;
 
 				// Update Status Log
-				update_status();
+				statusUpdatePending = true;
 
 				// Exit Function
 				return;
@@ -574,7 +614,7 @@ void login_user_stream(int fd, uint32_t ip)
  * @param user User Node
  * @param data Login Packet
  */
-void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S * data)
+int login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S * data)
 {
 	// Product Code Check
 	int valid_product_code = 1;
@@ -648,10 +688,10 @@ void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S
 			INFO_LOG(SCENET, "AdhocServer: %s (MAC: %s - IP: %s) started playing %s", (char *)user->resolver.name.data, mac2str(&user->resolver.mac).c_str(), ip2str(*(in_addr*)&user->resolver.ip).c_str(), safegamestr);
 
 			// Update Status Log
-			update_status();
+			statusUpdatePending = true;
 
 			// Leave Function
-			return;
+			return 0;
 		}
 	}
 
@@ -664,6 +704,7 @@ void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S
 
 	// Logout User - Out of Memory or Invalid Arguments
 	logout_user(user);
+	return -1;
 }
 
 /**
@@ -684,6 +725,9 @@ void logout_user(SceNetAdhocctlUserNode * user)
 	// Unlink Rightside
 	if(user->next != NULL) user->next->prev = user->prev;
 
+	// Send what we can of any last Messages
+	if(!user->closing) flush_user_txbuf(user);
+
 	// Close Stream
 	closesocket(user->stream);
 
@@ -724,13 +768,15 @@ void logout_user(SceNetAdhocctlUserNode * user)
 	}
 
 	// Free Memory
+	free(user->tx);
 	free(user);
 
 	// Fix User Counter
 	_db_user_count--;
+	serverStats.dropped++;
 
 	// Update Status Log
-	update_status();
+	statusUpdatePending = true;
 }
 
 /**
@@ -863,8 +909,7 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 					packet.ip = user->resolver.ip;
 
 					// Send Data
-					int iResult = send(peer->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-					if (iResult < 0) ERROR_LOG(SCENET, "AdhocServer: connect_user[send peer] (Socket error %d)", errno);
+					send_user_data(peer, &packet, sizeof(packet));
 
 					// Set Player Name
 					packet.name = peer->resolver.name;
@@ -876,8 +921,7 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 					packet.ip = peer->resolver.ip;
 
 					// Send Data
-					iResult = send(user->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-					if (iResult < 0) ERROR_LOG(SCENET, "AdhocServer: connect_user[send user] (Socket error %d)", errno);
+					send_user_data(user, &packet, sizeof(packet));
 
 					// Set BSSID
 					if(peer->group_next == NULL) bssid.mac = peer->resolver.mac;
@@ -898,8 +942,7 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 				g->playercount++;
 
 				// Send Network BSSID to User
-				int iResult = send(user->stream, (const char*)&bssid, sizeof(bssid), MSG_NOSIGNAL);
-				if (iResult < 0) ERROR_LOG(SCENET, "AdhocServer: connect_user[send user bssid] (Socket error %d)", errno);
+				send_user_data(user, &bssid, sizeof(bssid));
 
 				// Notify User
 				char safegamestr[10];
@@ -911,7 +954,7 @@ void connect_user(SceNetAdhocctlUserNode * user, SceNetAdhocctlGroupName * group
 				INFO_LOG(SCENET, "AdhocServer: %s (MAC: %s - IP: %s) joined %s group %s", (char *)user->resolver.name.data, mac2str(&user->resolver.mac).c_str(), ip2str(*(in_addr*)&user->resolver.ip).c_str(), safegamestr, safegroupstr);
 
 				// Update Status Log
-				update_status();
+				statusUpdatePending = true;
 
 				// Exit Function
 				return;
@@ -990,8 +1033,7 @@ void disconnect_user(SceNetAdhocctlUserNode * user)
 			packet.ip = user->resolver.ip;
 
 			// Send Data
-			int iResult = send(peer->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-			if (iResult < 0) ERROR_LOG(SCENET, "AdhocServer: disconnect_user[send peer] (Socket error %d)", errno);
+			send_user_data(peer, &packet, sizeof(packet));
 
 			// Move Pointer
 			peer = peer->group_next;
@@ -1031,7 +1073,7 @@ void disconnect_user(SceNetAdhocctlUserNode * user)
 		user->group_prev = NULL;
 
 		// Update Status Log
-		update_status();
+		statusUpdatePending = true;
 
 		// Exit Function
 		return;
@@ -1089,14 +1131,12 @@ void send_scan_results(SceNetAdhocctlUserNode * user)
 			}
 
 			// Send Group Packet
-			int iResult = send(user->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-			if (iResult < 0) ERROR_LOG(SCENET, "AdhocServer: send_scan_result[send user] (Socket error %d)", errno);
+			send_user_data(user, &packet, sizeof(packet));
 		}
 
 		// Notify Player of End of Scan
 		uint8_t opcode = OPCODE_SCAN_COMPLETE;
-		int iResult = send(user->stream, (const char*)&opcode, 1, MSG_NOSIGNAL);
-		if (iResult < 0) ERROR_LOG(SCENET, "AdhocServer: send_scan_result[send peer complete] (Socket error %d)", errno);
+		send_user_data(user, &opcode, 1);
 
 		// Notify User
 		char safegamestr[10];
@@ -1154,8 +1194,7 @@ void spread_message(SceNetAdhocctlUserNode *user, const char *message)
 				strcpy(packet.base.message, message);
 
 				// Send Data
-				int iResult = send(user->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-				if (iResult < 0) ERROR_LOG(SCENET, "AdhocServer: spread_message[send user chat] (Socket error %d)", errno);
+				send_user_data(user, &packet, sizeof(packet));
 			}
 		}
 
@@ -1196,8 +1235,7 @@ void spread_message(SceNetAdhocctlUserNode *user, const char *message)
 			packet.name = user->resolver.name;
 
 			// Send Data
-			int iResult = send(peer->stream, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL);
-			if (iResult < 0) ERROR_LOG(SCENET, "AdhocServer: spread_message[send peer chat] (Socket error %d)", errno);
+			send_user_data(peer, &packet, sizeof(packet));
 
 			// Move Pointer
 			peer = peer->group_next;
@@ -1270,6 +1308,192 @@ void clear_user_rxbuf(SceNetAdhocctlUserNode * user, int clear)
 	user->rxpos -= clear;
 }
 
+void send_user_data(SceNetAdhocctlUserNode * user, const void * data, uint32_t size)
+{
+	// Already being dropped
+	if(user->closing) return;
+
+	// Grow TX Buffer
+	if(user->txpos + size > user->txsize)
+	{
+		uint32_t newsize = std::max(std::max(user->txsize * 2, user->txpos + size), (uint32_t)1024);
+		uint8_t * tx = newsize <= SERVER_USER_TXBUF_MAXIMUM ? (uint8_t *)realloc(user->tx, newsize) : NULL;
+
+		// Not reading their Data, or out of Memory
+		if(tx == NULL)
+		{
+			WARN_LOG(SCENET, "AdhocServer: TX Buffer Overflow for %s, dropping", ip2str(*(in_addr*)&user->resolver.ip).c_str());
+			user->closing = 1;
+			return;
+		}
+
+		user->tx = tx;
+		user->txsize = newsize;
+	}
+
+	// Queue Data
+	memcpy(user->tx + user->txpos, data, size);
+	user->txpos += size;
+}
+
+void flush_user_txbuf(SceNetAdhocctlUserNode * user)
+{
+	uint32_t sent = 0;
+	while(sent < user->txpos)
+	{
+		int result = send(user->stream, (const char *)user->tx + sent, user->txpos - sent, MSG_NOSIGNAL);
+		serverStats.sendCalls++;
+		if(result > 0)
+		{
+			sent += result;
+			serverStats.bytesSent += result;
+			continue;
+		}
+
+		// Socket is full, try again when it's writable
+		if(result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+		// Broken Connection
+		ERROR_LOG(SCENET, "AdhocServer: flush_user_txbuf[send] (Socket error %d)", errno);
+		user->closing = 1;
+		break;
+	}
+
+	// Remove Sent Data
+	if(sent > 0)
+	{
+		memmove(user->tx, user->tx + sent, user->txpos - sent);
+		user->txpos -= sent;
+	}
+}
+
+int process_user_rxbuf(SceNetAdhocctlUserNode * user)
+{
+	// Handle every complete Packet, stop when more Data is needed
+	while(user->rxpos > 0 && !user->closing)
+	{
+		// Waiting for Login Packet
+		if(get_user_state(user) == USER_STATE_WAITING)
+		{
+			// Valid Opcode
+			if(user->rx[0] == OPCODE_LOGIN)
+			{
+				// Not enough Data available yet
+				if(user->rxpos < sizeof(SceNetAdhocctlLoginPacketC2S)) return 0;
+
+				// Clone Packet
+				SceNetAdhocctlLoginPacketC2S packet = *(SceNetAdhocctlLoginPacketC2S *)user->rx;
+
+				// Remove Packet from RX Buffer
+				clear_user_rxbuf(user, sizeof(SceNetAdhocctlLoginPacketC2S));
+
+				// Login User (Data)
+				if(login_user_data(user, &packet) < 0) return -1;
+			}
+
+			// Invalid Opcode
+			else
+			{
+				// Notify User
+				WARN_LOG(SCENET, "AdhocServer: Invalid Opcode 0x%02X in Waiting State from %s", user->rx[0], ip2str(*(in_addr*)&user->resolver.ip).c_str());
+
+				// Logout User
+				logout_user(user);
+				return -1;
+			}
+		}
+
+		// Logged-In User
+		else if(get_user_state(user) == USER_STATE_LOGGED_IN)
+		{
+			// Ping Packet
+			if(user->rx[0] == OPCODE_PING)
+			{
+				// Delete Packet from RX Buffer
+				clear_user_rxbuf(user, 1);
+			}
+
+			// Group Connect Packet
+			else if(user->rx[0] == OPCODE_CONNECT)
+			{
+				// Not enough Data available yet
+				if(user->rxpos < sizeof(SceNetAdhocctlConnectPacketC2S)) return 0;
+
+				// Cast Packet
+				SceNetAdhocctlConnectPacketC2S * packet = (SceNetAdhocctlConnectPacketC2S *)user->rx;
+
+				// Clone Group Name
+				SceNetAdhocctlGroupName group = packet->group;
+
+				// Remove Packet from RX Buffer
+				clear_user_rxbuf(user, sizeof(SceNetAdhocctlConnectPacketC2S));
+
+				// Change Game Group
+				connect_user(user, &group);
+			}
+
+			// Group Disconnect Packet
+			else if(user->rx[0] == OPCODE_DISCONNECT)
+			{
+				// Remove Packet from RX Buffer
+				clear_user_rxbuf(user, 1);
+
+				// Leave Game Group
+				disconnect_user(user);
+			}
+
+			// Network Scan Packet
+			else if(user->rx[0] == OPCODE_SCAN)
+			{
+				// Remove Packet from RX Buffer
+				clear_user_rxbuf(user, 1);
+
+				// Send Network List
+				send_scan_results(user);
+			}
+
+			// Chat Text Packet
+			else if(user->rx[0] == OPCODE_CHAT)
+			{
+				// Not enough Data available yet
+				if(user->rxpos < sizeof(SceNetAdhocctlChatPacketC2S)) return 0;
+
+				// Cast Packet
+				SceNetAdhocctlChatPacketC2S * packet = (SceNetAdhocctlChatPacketC2S *)user->rx;
+
+				// Clone Buffer for Message
+				char message[64];
+				memset(message, 0, sizeof(message));
+				strncpy(message, packet->message, sizeof(message) - 1);
+
+				// Remove Packet from RX Buffer
+				clear_user_rxbuf(user, sizeof(SceNetAdhocctlChatPacketC2S));
+
+				// Spread Chat Message
+				spread_message(user, message);
+			}
+
+			// Invalid Opcode
+			else
+			{
+				// Notify User
+				WARN_LOG(SCENET, "AdhocServer: Invalid Opcode 0x%02X in Logged-In State from %s (MAC: %s - IP: %s)", user->rx[0], (char *)user->resolver.name.data, mac2str(&user->resolver.mac).c_str(), ip2str(*(in_addr*)&user->resolver.ip).c_str());
+
+				// Logout User
+				logout_user(user);
+				return -1;
+			}
+		}
+
+		// Timed Out, handled by the Server Loop
+		else return 0;
+
+		serverStats.packetsReceived++;
+	}
+
+	return 0;
+}
+
 /**
  * Patch Game Product Code
  * @param product To-be-patched Product Code
@@ -1439,8 +1663,8 @@ void update_status()
 		// Write XSL Processor Information
 		fprintf(log, "<?xml-stylesheet type=\"text/xsl\" href=\"status.xsl\"?>\n");
 
-		// Output Root Tag + User Count
-		fprintf(log, "<prometheus usercount=\"%u\">\n", _db_user_count);
+		// Output Root Tag + User Count + Statistics
+		fprintf(log, "<prometheus usercount=\"%u\" peakusercount=\"%u\" connections=\"%llu\" bytesreceived=\"%llu\" bytessent=\"%llu\">\n", _db_user_count, serverStats.peakUsers, (unsigned long long)serverStats.accepted, (unsigned long long)serverStats.bytesReceived, (unsigned long long)serverStats.bytesSent);
 
 		// Database Handle
 		//sqlite3 * db = NULL;
@@ -1881,211 +2105,259 @@ int create_listen_socket(uint16_t port)
  * @param server Server Listening Socket
  * @return OS Error Code
  */
-int server_loop(int server)
+/**
+ * Accept all pending Logins
+ * @param server Server Listening Socket
+ */
+static void accept_logins(int server)
 {
-	// Set Running Status
-	//_status = 1;
-	adhocServerRunning = true;
-
-	// Create Empty Status Logfile
-	update_status();
+	// Login Result
+	int loginresult = 0;
 
-	// Handling Loop
-	while (adhocServerRunning) //(_status == 1)
+	// Login Processing Loop
+	do
 	{
-		// Login Block
+		// Prepare Address Structure
+		struct sockaddr_in addr;
+		socklen_t addrlen = sizeof(addr);
+		memset(&addr, 0, sizeof(addr));
+
+		// Accept Login Requests
+		// loginresult = accept4(server, (struct sockaddr *)&addr, &addrlen, SOCK_NONBLOCK);
+
+		// Alternative Accept Approach (some Linux Kernel don't support the accept4 Syscall... wtf?)
+		loginresult = accept(server, (struct sockaddr *)&addr, &addrlen);
+		if(loginresult != -1)
 		{
-			// Login Result
-			int loginresult = 0;
+			// Switch Socket into Non-Blocking Mode
+			change_blocking_mode(loginresult, 1);
+		}
 
-			// Login Processing Loop
-			do
-			{
-				// Prepare Address Structure
-				struct sockaddr_in addr;
-				socklen_t addrlen = sizeof(addr);
-				memset(&addr, 0, sizeof(addr));
+		// Login User (Stream)
+		if (loginresult != -1) {
+			u32_le sip = addr.sin_addr.s_addr;
+			/* // Replacing 127.0.0.x with Ethernet IP will cause issue with multiple-instance of localhost (127.0.0.x)
+			if (sip == 0x0100007f) { //127.0.0.1 should be replaced with LAN/WAN IP whenever available
+				char str[100];
+				gethostname(str, 100);
+				u8 *pip = (u8*)&sip;
+				if (gethostbyname(str)->h_addrtype == AF_INET && gethostbyname(str)->h_addr_list[0] != NULL) pip = (u8*)gethostbyname(str)->h_addr_list[0];
+				sip = *(u32_le*)pip;
+				WARN_LOG(SCENET, "AdhocServer: Replacing IP %s with %s", inet_ntoa(addr.sin_addr), inet_ntoa(*(in_addr*)&pip));
+			}
+			*/
+			login_user_stream(loginresult, sip);
+		}
+	} while(loginresult != -1);
+}
 
-				// Accept Login Requests
-				// loginresult = accept4(server, (struct sockaddr *)&addr, &addrlen, SOCK_NONBLOCK);
+/**
+ * Receive and handle all available Data from User
+ * @param user User Node
+ */
+static void receive_user_data(SceNetAdhocctlUserNode * user)
+{
+	// Read until the Socket is drained, as edge triggered events won't repeat
+	while(!user->closing)
+	{
+		// Receive Data from User
+		int recvresult = recv(user->stream, (char*)user->rx + user->rxpos, sizeof(user->rx) - user->rxpos, MSG_NOSIGNAL);
 
-				// Alternative Accept Approach (some Linux Kernel don't support the accept4 Syscall... wtf?)
-				loginresult = accept(server, (struct sockaddr *)&addr, &addrlen);
-				if(loginresult != -1)
-				{
-					// Switch Socket into Non-Blocking Mode
-					change_blocking_mode(loginresult, 1);
-				}
+		// Nothing more for now
+		if(recvresult == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
 
-				// Login User (Stream)
-				if (loginresult != -1) {
-					u32_le sip = addr.sin_addr.s_addr;
-					/* // Replacing 127.0.0.x with Ethernet IP will cause issue with multiple-instance of localhost (127.0.0.x)
-					if (sip == 0x0100007f) { //127.0.0.1 should be replaced with LAN/WAN IP whenever available
-						char str[100];
-						gethostname(str, 100);
-						u8 *pip = (u8*)&sip;
-						if (gethostbyname(str)->h_addrtype == AF_INET && gethostbyname(str)->h_addr_list[0] != NULL) pip = (u8*)gethostbyname(str)->h_addr_list[0];
-						sip = *(u32_le*)pip;
-						WARN_LOG(SCENET, "AdhocServer: Replacing IP %s with %s", inet_ntoa(addr.sin_addr), inet_ntoa(*(in_addr*)&pip));
-					}
-					*/
-					login_user_stream(loginresult, sip);
-				}
-			} while(loginresult != -1);
+		// Connection Closed
+		if(recvresult <= 0)
+		{
+			// Logout User
+			logout_user(user);
+			return;
 		}
 
-		// Receive Data from Users
-		SceNetAdhocctlUserNode * user = _db_user;
-		while(user != NULL)
-		{
-			// Next User (for safe delete)
-			SceNetAdhocctlUserNode * next = user->next;
+		// Move RX Pointer
+		user->rxpos += recvresult;
+		serverStats.bytesReceived += recvresult;
 
-			// Receive Data from User
-			int recvresult = recv(user->stream, (char*)user->rx + user->rxpos, sizeof(user->rx) - user->rxpos, MSG_NOSIGNAL);
+		// Update Death Clock
+		user->last_recv = time(NULL);
 
-			// Connection Closed or Timed Out
-			if(recvresult == 0 || (recvresult == -1 && errno != EAGAIN && errno != EWOULDBLOCK) || get_user_state(user) == USER_STATE_TIMED_OUT)
-			{
-				// Logout User
-				logout_user(user);
-			}
+		// Handle Packets
+		if(process_user_rxbuf(user) < 0) return;
+	}
+}
 
-			// Received Data (or leftovers in RX-Buffer)
-			else if(recvresult > 0 || user->rxpos > 0)
-			{
-				// New Incoming Data
-				if(recvresult > 0)
-				{
-					// Move RX Pointer
-					user->rxpos += recvresult;
+/**
+ * Wait for Socket Events
+ * @param server Server Listening Socket
+ * @param timeoutMs Maximum Wait
+ * @param ready OUT: Users with Data to receive
+ * @return true if there are Logins to accept
+ */
+static bool wait_for_events(int server, int timeoutMs, std::vector<SceNetAdhocctlUserNode *> &ready)
+{
+	ready.clear();
+	bool serverReady = false;
 
-					// Update Death Clock
-					user->last_recv = time(NULL);
-				}
+#ifdef ADHOCSERVER_USE_EPOLL
+	struct epoll_event events[64];
+	int count = epoll_wait(serverEpoll, events, 64, timeoutMs);
+	for(int i = 0; i < count; i++)
+	{
+		// Server Socket is registered without User
+		if(events[i].data.ptr == NULL) serverReady = true;
 
-				// Waiting for Login Packet
-				if(get_user_state(user) == USER_STATE_WAITING)
-				{
-					// Valid Opcode
-					if(user->rx[0] == OPCODE_LOGIN)
-					{
-						// Enough Data available
-						if(user->rxpos >= sizeof(SceNetAdhocctlLoginPacketC2S))
-						{
-							// Clone Packet
-							SceNetAdhocctlLoginPacketC2S packet = *(SceNetAdhocctlLoginPacketC2S *)user->rx;
+		// Read Events (Errors and Hangups show up in recv)
+		else if(events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) ready.push_back((SceNetAdhocctlUserNode *)events[i].data.ptr);
+	}
+#else
+	fd_set readfds, writefds;
+	FD_ZERO(&readfds);
+	FD_ZERO(&writefds);
+	FD_SET(server, &readfds);
+	int maxfd = server;
+	int count = 1;
 
-							// Remove Packet from RX Buffer
-							clear_user_rxbuf(user, sizeof(SceNetAdhocctlLoginPacketC2S));
+	// More Sockets than select can handle, just try all of them
+	bool overflow = false;
 
-							// Login User (Data)
-							login_user_data(user, &packet);
-						}
-					}
+	for(SceNetAdhocctlUserNode * user = _db_user; user != NULL; user = user->next)
+	{
+#ifndef _WIN32
+		if(user->stream >= FD_SETSIZE) overflow = true;
+#endif
+		if(++count > FD_SETSIZE) overflow = true;
+		if(overflow) break;
 
-					// Invalid Opcode
-					else
-					{
-						// Notify User
-						WARN_LOG(SCENET, "AdhocServer: Invalid Opcode 0x%02X in Waiting State from %s", user->rx[0], ip2str(*(in_addr*)&user->resolver.ip).c_str());
+		FD_SET(user->stream, &readfds);
+		if(user->txpos > 0) FD_SET(user->stream, &writefds);
+		if(user->stream > maxfd) maxfd = user->stream;
+	}
 
-						// Logout User
-						logout_user(user);
-					}
-				}
+	timeval tmout;
+	tmout.tv_sec = 0;
+	tmout.tv_usec = (overflow ? 10 : timeoutMs) * 1000;
+	int result = select(maxfd + 1, &readfds, &writefds, NULL, &tmout);
 
-				// Logged-In User
-				else if(get_user_state(user) == USER_STATE_LOGGED_IN)
-				{
-					// Ping Packet
-					if(user->rx[0] == OPCODE_PING)
-					{
-						// Delete Packet from RX Buffer
-						clear_user_rxbuf(user, 1);
-					}
+	serverReady = overflow || (result > 0 && FD_ISSET(server, &readfds));
+	for(SceNetAdhocctlUserNode * user = _db_user; user != NULL; user = user->next)
+	{
+		if(overflow || (result > 0 && FD_ISSET(user->stream, &readfds))) ready.push_back(user);
+	}
+#endif
 
-					// Group Connect Packet
-					else if(user->rx[0] == OPCODE_CONNECT)
-					{
-						// Enough Data available
-						if(user->rxpos >= sizeof(SceNetAdhocctlConnectPacketC2S))
-						{
-							// Cast Packet
-							SceNetAdhocctlConnectPacketC2S * packet = (SceNetAdhocctlConnectPacketC2S *)user->rx;
+	return serverReady;
+}
 
-							// Clone Group Name
-							SceNetAdhocctlGroupName group = packet->group;
+/**
+ * Log Connection and Throughput Statistics
+ * @param elapsed Seconds since the last Call
+ */
+static void log_server_stats(double elapsed)
+{
+	static AdhocServerStats last;
+	if(memcmp(&last, &serverStats, sizeof(last)) == 0) return;
+
+	INFO_LOG(SCENET, "AdhocServer: %u users (peak %u), %llu connected / %llu dropped, in %0.1f KB/s, out %0.1f KB/s, %0.1f packets/s, %0.1f send calls/s",
+		_db_user_count, serverStats.peakUsers,
+		(unsigned long long)(serverStats.accepted - last.accepted), (unsigned long long)(serverStats.dropped - last.dropped),
+		(serverStats.bytesReceived - last.bytesReceived) / 1024.0 / elapsed, (serverStats.bytesSent - last.bytesSent) / 1024.0 / elapsed,
+		(serverStats.packetsReceived - last.packetsReceived) / elapsed, (serverStats.sendCalls - last.sendCalls) / elapsed);
+	last = serverStats;
+}
 
-							// Remove Packet from RX Buffer
-							clear_user_rxbuf(user, sizeof(SceNetAdhocctlConnectPacketC2S));
+int server_loop(int server)
+{
+	// Set Running Status
+	//_status = 1;
+	adhocServerRunning = true;
+	memset(&serverStats, 0, sizeof(serverStats));
 
-							// Change Game Group
-							connect_user(user, &group);
-						}
-					}
+#ifdef ADHOCSERVER_USE_EPOLL
+	// Create Event Loop, with the Server Socket registered without User
+	serverEpoll = epoll_create1(EPOLL_CLOEXEC);
+	if(serverEpoll == -1)
+	{
+		ERROR_LOG(SCENET, "AdhocServer: epoll_create1 failed (Socket error %d)", errno);
+		adhocServerRunning = false;
+		closesocket(server);
+		return -1;
+	}
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLET;
+	ev.data.ptr = NULL;
+	epoll_ctl(serverEpoll, EPOLL_CTL_ADD, server, &ev);
+#endif
 
-					// Group Disconnect Packet
-					else if(user->rx[0] == OPCODE_DISCONNECT)
-					{
-						// Remove Packet from RX Buffer
-						clear_user_rxbuf(user, 1);
+	// Create Empty Status Logfile
+	update_status();
 
-						// Leave Game Group
-						disconnect_user(user);
-					}
+	// Users with Data to receive
+	std::vector<SceNetAdhocctlUserNode *> ready;
 
-					// Network Scan Packet
-					else if(user->rx[0] == OPCODE_SCAN)
-					{
-						// Remove Packet from RX Buffer
-						clear_user_rxbuf(user, 1);
+	double lastSweep = time_now_d();
+	double lastStatus = lastSweep;
+	double lastStats = lastSweep;
 
-						// Send Network List
-						send_scan_results(user);
-					}
+	// Handling Loop
+	while (adhocServerRunning) //(_status == 1)
+	{
+		// Wait for Activity (wakes up regularly for Timeouts and Shutdown)
+		bool serverReady = wait_for_events(server, 100, ready);
 
-					// Chat Text Packet
-					else if(user->rx[0] == OPCODE_CHAT)
-					{
-						// Enough Data available
-						if(user->rxpos >= sizeof(SceNetAdhocctlChatPacketC2S))
-						{
-							// Cast Packet
-							SceNetAdhocctlChatPacketC2S * packet = (SceNetAdhocctlChatPacketC2S *)user->rx;
+		// Login Block
+		if(serverReady) accept_logins(server);
+
+		// Receive Data from Users (only ever logs out the User itself, so the others stay valid)
+		for(SceNetAdhocctlUserNode * user : ready) receive_user_data(user);
+
+		// Send queued Data, and drop Users that broke
+		SceNetAdhocctlUserNode * user = _db_user;
+		while(user != NULL)
+		{
+			// Next User (for safe delete)
+			SceNetAdhocctlUserNode * next = user->next;
 
-							// Clone Buffer for Message
-							char message[64];
-							memset(message, 0, sizeof(message));
-							strncpy(message, packet->message, sizeof(message) - 1);
+			if(user->txpos > 0 && !user->closing) flush_user_txbuf(user);
+			if(user->closing) logout_user(user);
 
-							// Remove Packet from RX Buffer
-							clear_user_rxbuf(user, sizeof(SceNetAdhocctlChatPacketC2S));
+			// Move Pointer
+			user = next;
+		}
 
-							// Spread Chat Message
-							spread_message(user, message);
-						}
-					}
+		double now = time_now_d();
 
-					// Invalid Opcode
-					else
-					{
-						// Notify User
-						WARN_LOG(SCENET, "AdhocServer: Invalid Opcode 0x%02X in Logged-In State from %s (MAC: %s - IP: %s)", user->rx[0], (char *)user->resolver.name.data, mac2str(&user->resolver.mac).c_str(), ip2str(*(in_addr*)&user->resolver.ip).c_str());
+		// Timed Out Users
+		if(now - lastSweep >= 1.0)
+		{
+			user = _db_user;
+			while(user != NULL)
+			{
+				// Next User (for safe delete)
+				SceNetAdhocctlUserNode * next = user->next;
 
-						// Logout User
-						logout_user(user);
-					}
-				}
+				if(get_user_state(user) == USER_STATE_TIMED_OUT) logout_user(user);
+
+				// Move Pointer
+				user = next;
 			}
+			lastSweep = now;
+		}
 
-			// Move Pointer
-			user = next;
+		// Update Status Log
+		if(statusUpdatePending && now - lastStatus >= 1.0)
+		{
+			update_status();
+			statusUpdatePending = false;
+			lastStatus = now;
 		}
 
-		// Prevent needless CPU Overload (1ms Sleep)
-		sleep_ms(10);
+		// Statistics
+		if(now - lastStats >= SERVER_STATS_INTERVAL)
+		{
+			log_server_stats(now - lastStats);
+			lastStats = now;
+		}
 
 		// Don't do anything if it's paused, otherwise the log will be flooded
 		while (adhocServerRunning && Core_IsStepping() && coreState != CORE_POWERDOWN) sleep_ms(10);
@@ -2093,6 +2365,14 @@ int server_loop(int server)
 
 	// Free User Database Memory
 	free_database();
+	update_status();
+	statusUpdatePending = false;
+
+#ifdef ADHOCSERVER_USE_EPOLL
+	// Close Event Loop
+	close(serverEpoll);
+	serverEpoll = -1;
+#endif
 
 	// Close Server Socket
 	closesocket(server);
@@ -39,6 +39,12 @@
 // Server User Timeout (in seconds)
 #define SERVER_USER_TIMEOUT 15
 
+// Server User TX Buffer Maximum (users that don't read their data get dropped)
+#define SERVER_USER_TXBUF_MAXIMUM (256 * 1024)
+
+// Server Statistics Log Interval (in seconds)
+#define SERVER_STATS_INTERVAL 60
+
 // Server SQLite3 Database
 #define SERVER_DATABASE "database.db"
 
@@ -220,6 +226,14 @@ typedef struct SceNetAdhocctlUserNode {
 	// RX Buffer
 	uint8_t rx[1024];
 	uint32_t rxpos;
+
+	// TX Buffer (data queued by send_user_data)
+	uint8_t * tx;
+	uint32_t txpos;
+	uint32_t txsize;
+
+	// Dropped at the end of the current server loop iteration
+	int closing;
 } SceNetAdhocctlUserNode;
 
 // Double-Linked Game List
@@ -286,8 +300,9 @@ void login_user_stream(int fd, uint32_t ip);
  * Login User into Database (Login Data)
  * @param user User Node
  * @param data Login Packet
+ * @return 0 on success, -1 if the user was logged out (and freed)
  */
-void login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S * data);
+int login_user_data(SceNetAdhocctlUserNode * user, SceNetAdhocctlLoginPacketC2S * data);
 
 /**
  * Logout User from Database
@@ -339,6 +354,27 @@ int get_user_state(SceNetAdhocctlUserNode * user);
  */
 void clear_user_rxbuf(SceNetAdhocctlUserNode * user, int clear);
 
+/**
+ * Queue Data for User (sent by flush_user_txbuf, so packets are batched per loop iteration)
+ * @param user User Node
+ * @param data Data
+ * @param size Number of Bytes
+ */
+void send_user_data(SceNetAdhocctlUserNode * user, const void * data, uint32_t size);
+
+/**
+ * Send as much of the TX Buffer as the Socket takes
+ * @param user User Node
+ */
+void flush_user_txbuf(SceNetAdhocctlUserNode * user);
+
+/**
+ * Handle all complete Packets in the RX Buffer
+ * @param user User Node
+ * @return 0 if the user is still logged in, -1 if the user was logged out (and freed)
+ */
+int process_user_rxbuf(SceNetAdhocctlUserNode * user);
+
 /**
  * Patch Game Product Code
  * @param product To-be-patched Product Code
@@ -114,6 +114,19 @@ static double curFrameTime;
 static double lastFrameTime;
 static double nextFrameTime;
 static int numVBlanksSinceFlip;
+// Set by the host, not the game, so not part of the state either.
+static bool skipRendering;
+
+// Low latency mode: instead of sleeping between the flip and presenting it, sleep before
+// emulating the next frame, so input is read as late as possible.
+static double lowLatencyStartTime;
+static double frameStartTime;
+// How long recent frames took from start to flip, to predict how late we can start.
+static double frameEmulationHistory[8];
+static int frameEmulationPos;
+// Averages for the latency estimate.
+static double avgFrameEmulation;
+static double avgFlipWait;
 
 const int PSP_DISPLAY_MODE_LCD = 0;
 
@@ -347,6 +360,18 @@ void __DisplaySetWasPaused() {
 	wasPaused = true;
 }
 
+void __DisplaySetSkipRendering(bool skip) {
+	if (skipRendering && !skip) {
+		// Don't try to catch up on the time spent skipping.
+		wasPaused = true;
+	}
+	skipRendering = skip;
+}
+
+bool __DisplayIsSkippingRendering() {
+	return skipRendering;
+}
+
 static int FrameTimingLimit() {
 	if (PSP_CoreParameter().fpsLimit == FPSLimit::CUSTOM1)
 		return g_Config.iFpsLimit1;
@@ -374,11 +399,36 @@ static void DoFrameDropLogging(float scaledTimestep) {
 }
 
 // Let's collect all the throttling and frameskipping logic here.
+static void UpdateFrameEmulationTime(double flipTime) {
+	if (frameStartTime == 0.0 || flipTime < frameStartTime)
+		return;
+	double emulation = flipTime - frameStartTime;
+	frameEmulationHistory[frameEmulationPos] = emulation;
+	frameEmulationPos = (frameEmulationPos + 1) % (int)ARRAY_SIZE(frameEmulationHistory);
+	avgFrameEmulation = avgFrameEmulation * 0.9 + emulation * 0.1;
+}
+
+static double PredictFrameEmulationTime() {
+	// Being late costs a dropped frame, so go with the slowest recent one plus some slack for sleep accuracy.
+	double worst = 0.0;
+	for (double t : frameEmulationHistory)
+		worst = std::max(worst, t);
+	return worst + 0.002;
+}
+
 static void DoFrameTiming(bool &throttle, bool &skipFrame, float timestep) {
 	PROFILE_THIS_SCOPE("timing");
 	int fpsLimit = FrameTimingLimit();
 	throttle = FrameTimingThrottled();
 	skipFrame = false;
+	lowLatencyStartTime = 0.0;
+
+	// Nothing is drawn or shown, so just run as fast as the CPU allows.
+	if (skipRendering) {
+		throttle = false;
+		skipFrame = true;
+		return;
+	}
 
 	// Check if the frameskipping code should be enabled. If neither throttling or frameskipping is on,
 	// we have nothing to do here.
@@ -401,6 +451,8 @@ static void DoFrameTiming(bool &throttle, bool &skipFrame, float timestep) {
 		nextFrameTime = std::max(lastFrameTime + scaledTimestep, time_now_d() - maxFallBehindFrames * scaledTimestep);
 	}
 	curFrameTime = time_now_d();
+	const double flipTime = curFrameTime;
+	UpdateFrameEmulationTime(flipTime);
 
 	if (g_Config.bLogFrameDrops) {
 		DoFrameDropLogging(scaledTimestep);
@@ -442,11 +494,48 @@ static void DoFrameTiming(bool &throttle, bool &skipFrame, float timestep) {
 		}
 		curFrameTime = time_now_d();
 	}
+	avgFlipWait = avgFlipWait * 0.9 + (curFrameTime - flipTime) * 0.1;
+
+	if (g_Config.bLowLatencyPresent && throttle && !skipFrame) {
+		// Assume the next frame is as long as this one, and aim to flip it right at its deadline.
+		double predicted = PredictFrameEmulationTime();
+		if (predicted < scaledTimestep)
+			lowLatencyStartTime = nextFrameTime + scaledTimestep - predicted;
+	}
 
 	lastFrameTime = nextFrameTime;
 	wasPaused = false;
 }
 
+void __DisplayWaitForFrameStart() {
+	if (lowLatencyStartTime != 0.0) {
+		double before = time_now_d();
+		// If it's far off, something like a pause happened in between, so don't bother.
+		if (before < lowLatencyStartTime && lowLatencyStartTime - before < 0.1) {
+			PROFILE_THIS_SCOPE("timing");
+			double cur_time;
+			while ((cur_time = time_now_d()) < lowLatencyStartTime) {
+#ifdef _WIN32
+				sleep_ms(1);
+#else
+				const double left = lowLatencyStartTime - cur_time;
+				usleep((long)(left * 1000000));
+#endif
+			}
+			if (g_Config.bDrawFrameGraph || coreCollectDebugStats) {
+				DisplayNotifySleep(time_now_d() - before);
+			}
+		}
+		lowLatencyStartTime = 0.0;
+	}
+	frameStartTime = time_now_d();
+}
+
+void __DisplayGetLatencyEstimate(double *emulationMs, double *flipWaitMs) {
+	*emulationMs = avgFrameEmulation * 1000.0;
+	*flipWaitMs = avgFlipWait * 1000.0;
+}
+
 static void DoFrameIdleTiming() {
 	PROFILE_THIS_SCOPE("timing");
 	if (!FrameTimingThrottled() || !g_Config.bEnableSound || wasPaused) {
@@ -520,6 +609,7 @@ void hleEnterVblank(u64 userdata, int cyclesLate) {
 	}
 
 	numVBlanksSinceFlip++;
+	__KernelSchedulerStatsEndFrame();
 
 	// TODO: Should this be done here or in hleLeaveVblank?
 	if (framebufIsLatched) {
@@ -601,7 +691,8 @@ void __DisplayFlip(int cyclesLate) {
 		const bool fbReallyDirty = gpu->FramebufferReallyDirty();
 		if (fbReallyDirty || noRecentFlip || postEffectRequiresFlip) {
 			// Check first though, might've just quit / been paused.
-			if (!forceNoFlip && Core_NextFrame()) {
+			if (!forceNoFlip && Core_NextFrame() && !skipRendering) {
+				FrameTimeScope frameTimeScope(FrameTimeCategory::PRESENT);
 				gpu->CopyDisplayToOutput(fbReallyDirty);
 				if (fbReallyDirty) {
 					DisplayFireActualFlip();
@@ -622,7 +713,7 @@ void __DisplayFlip(int cyclesLate) {
 			// 4 here means 1 drawn, 4 skipped - so 12 fps minimum.
 			maxFrameskip = frameSkipNum;
 		}
-		if (numSkippedFrames >= maxFrameskip || GPURecord::IsActivePending()) {
+		if ((numSkippedFrames >= maxFrameskip && !skipRendering) || GPURecord::IsActivePending()) {
 			skipFrame = false;
 		}
 
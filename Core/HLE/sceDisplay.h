@@ -32,6 +32,17 @@ void __DisplaySetFramebuf(u32 topaddr, int linesize, int pixelformat, int sync);
 // Call this when resuming to avoid a small speedup burst
 void __DisplaySetWasPaused();
 
+// Skip every frame: GE lists still run for framebuffer tracking and block transfers,
+// but nothing is drawn or presented, and frame timing is unthrottled.
+// Meant for fast re-simulation (replays, rollback, batch tests.)
+void __DisplaySetSkipRendering(bool skip);
+bool __DisplayIsSkippingRendering();
+
+// Call before emulating each host frame.  Sleeps there instead of after the flip in low latency mode.
+void __DisplayWaitForFrameStart();
+// From starting a frame to its flip, and from the flip to handing it off for presentation.
+void __DisplayGetLatencyEstimate(double *emulationMs, double *flipWaitMs);
+
 void Register_sceDisplay_driver();
 void __DisplayWaitForVblanks(const char* reason, int vblanks, bool callbacks = false);
 
@@ -34,6 +34,7 @@
 #include "Core/ConfigValues.h"
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/ELF/ParamSFO.h"
+#include "Core/MemFault.h"
 #include "Core/MemMapHelpers.h"
 #include "Core/System.h"
 #include "Core/HDRemaster.h"
@@ -661,6 +662,9 @@ void __IoInit() {
 		INFO_LOG(SCEIO, "Enabling /PSP compatibility mode");
 		memstickFlags |= FileSystemFlags::STRIP_PSP;
 	}
+	if (g_Config.bMemStickWriteBack) {
+		memstickFlags |= FileSystemFlags::WRITE_BACK;
+	}
 
 	auto memstickSystem = std::shared_ptr<IFileSystem>(new DirectoryFileSystem(&pspFileSystem, g_Config.memStickDirectory, memstickFlags));
 
@@ -1089,6 +1093,7 @@ static bool __IoRead(int &result, int id, u32 data_addr, int size, int &us) {
 				ioManager.ScheduleOperation(ev);
 				return false;
 			} else {
+				Memory::MemWriteWatch_NotifyHostWrite(data, validSize);
 				if (GetIOTimingMethod() != IOTIMING_REALISTIC) {
 					result = (int)pspFileSystem.ReadFile(f->handle, data, validSize);
 				} else {
@@ -1218,6 +1223,7 @@ static bool __IoWrite(int &result, int id, u32 data_addr, int size, int &us) {
 				ioManager.SyncThread();
 			}
 		}
+		Memory::MemCheckWatch_NotifyHostRead(data_ptr, validSize);
 		if (useThread) {
 			AsyncIOEvent ev = IO_EVENT_WRITE;
 			ev.handle = f->handle;
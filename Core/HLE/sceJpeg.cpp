@@ -16,6 +16,21 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include "ppsspp_config.h"
+#include "Common/Common.h"
+
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 #include "ext/jpge/jpgd.h"
 
 #include "Common/CommonTypes.h"
@@ -257,8 +272,104 @@ static int sceJpegMJpegCsc(u32 imageAddr, u32 yCbCrAddr, int widthHeight, int bu
 	return result;
 }
 
-static u32 convertARGBtoABGR(u32 argb) {
-	return ((argb & 0xFF00FF00)) | ((argb & 0x000000FF) << 16) | ((argb & 0x00FF0000) >> 16);
+// Decodes one row at a time (jpgd's IDCT and upsampling already use SSE2 where available),
+// so each row can be converted straight into PSP memory instead of through a full image copy.
+class JpegRowDecoder {
+public:
+	JpegRowDecoder(const u8 *buf, int size) : stream_(buf, size), decoder_(&stream_) {}
+
+	bool Begin() {
+		if (decoder_.get_error_code() != jpgd::JPGD_SUCCESS)
+			return false;
+		// We only handle grayscale and YCbCr, like before.
+		if (decoder_.get_num_components() != 1 && decoder_.get_num_components() != 3)
+			return false;
+		return decoder_.begin_decoding() == jpgd::JPGD_SUCCESS;
+	}
+
+	int Width() const {
+		return decoder_.get_width();
+	}
+	int Height() const {
+		return decoder_.get_height();
+	}
+	// Grayscale rows have one byte per pixel, color rows are RGBX.
+	bool IsGrayscale() const {
+		return decoder_.get_num_components() == 1;
+	}
+
+	// Returns nullptr on corrupt data.
+	const u8 *NextRow() {
+		const void *line = nullptr;
+		jpgd::uint len = 0;
+		if (decoder_.decode(&line, &len) != jpgd::JPGD_SUCCESS)
+			return nullptr;
+		return (const u8 *)line;
+	}
+
+	bool SkipRows() {
+		for (int y = 0; y < Height(); ++y) {
+			if (!NextRow())
+				return false;
+		}
+		return true;
+	}
+
+private:
+	jpgd::jpeg_decoder_mem_stream stream_;
+	jpgd::jpeg_decoder decoder_;
+};
+
+// The output is ABGR with zero alpha, so in memory it's just R, G, B, 0.
+static void ConvertRGBXRowToABGR(u32_le *dst, const u8 *src, int width) {
+	int x = 0;
+#if defined(_M_SSE)
+	const __m128i mask = _mm_set1_epi32(0x00FFFFFF);
+	for (; x + 4 <= width; x += 4) {
+		__m128i pixels = _mm_loadu_si128((const __m128i *)(src + x * 4));
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_and_si128(pixels, mask));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint32x4_t mask = vdupq_n_u32(0x00FFFFFF);
+	for (; x + 4 <= width; x += 4) {
+		uint32x4_t pixels = vld1q_u32((const uint32_t *)(src + x * 4));
+		vst1q_u32((uint32_t *)(dst + x), vandq_u32(pixels, mask));
+	}
+#endif
+	for (; x < width; ++x) {
+		const u8 *p = src + x * 4;
+		dst[x] = p[0] | (p[1] << 8) | (p[2] << 16);
+	}
+}
+
+static void ConvertGrayRowToABGR(u32_le *dst, const u8 *src, int width) {
+	int x = 0;
+#if defined(_M_SSE)
+	const __m128i zero = _mm_setzero_si128();
+	for (; x + 16 <= width; x += 16) {
+		__m128i luma = _mm_loadu_si128((const __m128i *)(src + x));
+		__m128i lumaLumaLo = _mm_unpacklo_epi8(luma, luma);
+		__m128i lumaLumaHi = _mm_unpackhi_epi8(luma, luma);
+		__m128i lumaZeroLo = _mm_unpacklo_epi8(luma, zero);
+		__m128i lumaZeroHi = _mm_unpackhi_epi8(luma, zero);
+		_mm_storeu_si128((__m128i *)(dst + x + 0), _mm_unpacklo_epi16(lumaLumaLo, lumaZeroLo));
+		_mm_storeu_si128((__m128i *)(dst + x + 4), _mm_unpackhi_epi16(lumaLumaLo, lumaZeroLo));
+		_mm_storeu_si128((__m128i *)(dst + x + 8), _mm_unpacklo_epi16(lumaLumaHi, lumaZeroHi));
+		_mm_storeu_si128((__m128i *)(dst + x + 12), _mm_unpackhi_epi16(lumaLumaHi, lumaZeroHi));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x4_t pixels;
+		pixels.val[0] = vld1q_u8(src + x);
+		pixels.val[1] = pixels.val[0];
+		pixels.val[2] = pixels.val[0];
+		pixels.val[3] = vdupq_n_u8(0);
+		vst4q_u8((uint8_t *)(dst + x), pixels);
+	}
+#endif
+	for (; x < width; ++x) {
+		dst[x] = src[x] * 0x00010101;
+	}
 }
 
 static int DecodeJpeg(u32 jpegAddr, int jpegSize, u32 imageAddr, int &usec) {
@@ -273,53 +384,40 @@ static int DecodeJpeg(u32 jpegAddr, int jpegSize, u32 imageAddr, int &usec) {
 	if (jpegSize < 2 || buf[0] != 0xFF || buf[1] != 0xD8)
 		return hleLogError(ME, ERROR_JPEG_NO_SOI, "no SOI found, invalid data");
 
-	int width, height, actual_components;
-	unsigned char *jpegBuf = jpgd::decompress_jpeg_image_from_memory(buf, jpegSize, &width, &height, &actual_components, 3);
-
-	if (actual_components != 3 && actual_components != 1) {
-		// The assumption that the image was RGB was wrong...
-		// Try again.
-		int components = actual_components;
-		jpegBuf = jpgd::decompress_jpeg_image_from_memory(buf, jpegSize, &width, &height, &actual_components, components);
-	}
-
-	if (jpegBuf == nullptr) {
+	JpegRowDecoder decoder(buf, jpegSize);
+	if (!decoder.Begin())
 		return hleLogError(ME, ERROR_JPEG_INVALID_DATA, "unable to decompress jpeg");
-	}
 
+	int width = decoder.Width();
+	int height = decoder.Height();
 	usec += (width * height) / 14;
 
-	if (!Memory::IsValidRange(imageAddr, mjpegWidth * mjpegHeight * 4)) {
-		free(jpegBuf);
+	if (!Memory::IsValidRange(imageAddr, mjpegWidth * mjpegHeight * 4))
 		return hleLogError(ME, SCE_KERNEL_ERROR_INVALID_POINTER, "invalid output address");
-	}
 	// Note: even if you Delete, the size is still allowed.
-	if (width > mjpegWidth || height > mjpegHeight) {
-		free(jpegBuf);
+	if (width > mjpegWidth || height > mjpegHeight)
 		return hleLogError(ME, ERROR_JPEG_INVALID_SIZE, "invalid output address");
-	}
 	if (mjpegInited == 0) {
 		// If you finish after setting the size, then call this - you get an interesting error.
-		free(jpegBuf);
 		return hleLogError(ME, 0x80000001, "mjpeg not inited");
 	}
 
 	usec += (width * height) / 110;
 
-	if (actual_components == 3 || actual_components == 1) {
-		u24_be *imageBuffer = (u24_be*)jpegBuf;
-		u32_le *abgr = (u32_le *)Memory::GetPointerUnchecked(imageAddr);
-		for (int y = 0; y < height; ++y) {
-			for (int x = 0; x < width; x++)	{
-				abgr[x] = convertARGBtoABGR(imageBuffer[x]);
-			}
-			imageBuffer += width;
-			abgr += mjpegWidth;
-		}
-		NotifyMemInfo(MemBlockFlags::WRITE, imageAddr, mjpegWidth * height, "JpegDecodeMJpeg");
+	u32_le *abgr = (u32_le *)Memory::GetPointerWriteUnchecked(imageAddr);
+	bool grayscale = decoder.IsGrayscale();
+	for (int y = 0; y < height; ++y) {
+		const u8 *row = decoder.NextRow();
+		if (!row)
+			return hleLogError(ME, ERROR_JPEG_INVALID_DATA, "unable to decompress jpeg");
+		if (grayscale)
+			ConvertGrayRowToABGR(abgr, row, width);
+		else
+			ConvertRGBXRowToABGR(abgr, row, width);
+		abgr += mjpegWidth;
 	}
+	NotifyMemInfo(MemBlockFlags::WRITE, imageAddr, mjpegWidth * height, "JpegDecodeMJpeg");
 
-	free(jpegBuf);
 	return hleLogSuccessX(ME, getWidthHeight(width, height));
 }
 
@@ -370,22 +468,14 @@ static int JpegGetOutputInfo(u32 jpegAddr, int jpegSize, u32 colourInfoAddr) {
 	if (jpegSize < 2 || buf[0] != 0xFF || buf[1] != 0xD8)
 		return hleLogError(ME, ERROR_JPEG_NO_SOI, "no SOI found, invalid data");
 
-	int width, height, actual_components;
-	unsigned char *jpegBuf = jpgd::decompress_jpeg_image_from_memory(buf, jpegSize, &width, &height, &actual_components, 3);
-
-	if (actual_components != 3 && actual_components != 1) {
-		// The assumption that the image was RGB was wrong...
-		// Try again.
-		int components = actual_components;
-		jpegBuf = jpgd::decompress_jpeg_image_from_memory(buf, jpegSize, &width, &height, &actual_components, components);
-	}
-
-	if (jpegBuf == nullptr) {
+	// Still decode all of it, since corrupt data is reported here too, but there's no need to keep the image.
+	JpegRowDecoder decoder(buf, jpegSize);
+	if (!decoder.Begin() || !decoder.SkipRows())
 		return hleLogError(ME, ERROR_JPEG_INVALID_DATA, "unable to decompress jpeg");
-	}
 
-	free(jpegBuf);
-	
+	int width = decoder.Width();
+	int height = decoder.Height();
+
 	// Buffer to store info about the color space in use.
 	// - Bits 24 to 32 (Always empty): 0x00
 	// - Bits 16 to 24 (Color mode): 0x00 (Unknown), 0x01 (Greyscale) or 0x02 (YCbCr) 
@@ -424,11 +514,8 @@ static int sceJpegGetOutputInfo(u32 jpegAddr, int jpegSize, u32 colourInfoAddr,
 	return hleDelayResult(result, "jpeg get output info", 250);
 }
 
-static u32 convertRGBToYCbCr(u32 rgb) {
+static u32 convertRGBToYCbCr(u8 r, u8 g, u8 b) {
 	//see http://en.wikipedia.org/wiki/Yuv#Y.27UV444_to_RGB888_conversion for more information.
-	u8  r = (rgb >> 16) & 0xFF;
-	u8  g = (rgb >>  8) & 0xFF;
-	u8  b = (rgb >>  0) & 0xFF;
 	int  y = 0.299f * r + 0.587f * g + 0.114f * b + 0;
 	int cb = -0.169f * r - 0.331f * g + 0.499f * b + 128.0f;
 	int cr = 0.499f * r - 0.418f * g - 0.0813f * b + 128.0f;
@@ -441,50 +528,35 @@ static u32 convertRGBToYCbCr(u32 rgb) {
 	return (y << 16) | (cb << 8) | cr;
 }
 
-static int JpegConvertRGBToYCbCr(const void *data, u8 *output, int width, int height) {
-	u24_be *imageBuffer = (u24_be *)data;
+// Chroma is simply taken from the top left pixel of each 2x2 block.  Ideally, would average,
+// but I suppose these just came from a JPEG, so they ought to match.
+static void JpegConvertRowToYCbCr(const u8 *row, bool grayscale, u8 *output, int width, int height, int y) {
 	int sizeY = width * height;
 	int sizeCb = sizeY >> 2;
-	u8 *Y = output;
-	u8 *Cb = Y + sizeY;
+	u8 *Y = output + width * y;
+	u8 *Cb = output + sizeY + (width >> 1) * (y >> 1);
 	u8 *Cr = Cb + sizeCb;
 
-	if ((width & 1) == 0 && (height & 1) == 0) {
-		for (int y = 0; y < height; y += 2) {
-			for (int x = 0; x < width; x += 2) {
-				u32 rgb0 = imageBuffer[width * y + x];
-				u32 rgb1 = imageBuffer[width * y + x + 1];
-				u32 rgb2 = imageBuffer[width * (y + 1) + x];
-				u32 rgb3 = imageBuffer[width * (y + 1) + x + 1];
-
-				u32 yCbCr0 = convertRGBToYCbCr(rgb0);
-				u32 yCbCr1 = convertRGBToYCbCr(rgb1);
-				u32 yCbCr2 = convertRGBToYCbCr(rgb2);
-				u32 yCbCr3 = convertRGBToYCbCr(rgb3);
-
-				Y[width * y + x] = (yCbCr0 >> 16) & 0xFF;
-				Y[width * y + x + 1] = (yCbCr1 >> 16) & 0xFF;
-				Y[width * (y + 1) + x] = (yCbCr2 >> 16) & 0xFF;
-				Y[width * (y + 1) + x + 1] = (yCbCr3 >> 16) & 0xFF;
-				Cb[(width >> 1) * (y >> 1) + (x >> 1)] = (yCbCr0 >> 8) & 0xFF;
-				Cr[(width >> 1) * (y >> 1) + (x >> 1)] = yCbCr0 & 0xFF;
+	if (grayscale) {
+		for (int x = 0; x < width; ++x) {
+			u32 yCbCr = convertRGBToYCbCr(row[x], row[x], row[x]);
+			Y[x] = (yCbCr >> 16) & 0xFF;
+			if ((y & 1) == 0 && (x & 1) == 0) {
+				Cb[x >> 1] = (yCbCr >> 8) & 0xFF;
+				Cr[x >> 1] = yCbCr & 0xFF;
 			}
 		}
 	} else {
-		for (int y = 0; y < height; ++y) {
-			for (int x = 0; x < width; ++x) {
-				u32 rgb = imageBuffer[width * y + x];
-				u32 yCbCr = convertRGBToYCbCr(rgb);
-				Y[width * y + x] = (yCbCr >> 16) & 0xFF;
-				if ((y & 1) == 0 && (x & 1) == 0) {
-					// Ideally, would average, but I suppose these just came from a JPEG, so they ought to match.
-					Cb[(width >> 1) * (y >> 1) + (x >> 1)] = (yCbCr >> 8) & 0xFF;
-					Cr[(width >> 1) * (y >> 1) + (x >> 1)] = yCbCr & 0xFF;
-				}
+		for (int x = 0; x < width; ++x) {
+			const u8 *p = row + x * 4;
+			u32 yCbCr = convertRGBToYCbCr(p[0], p[1], p[2]);
+			Y[x] = (yCbCr >> 16) & 0xFF;
+			if ((y & 1) == 0 && (x & 1) == 0) {
+				Cb[x >> 1] = (yCbCr >> 8) & 0xFF;
+				Cr[x >> 1] = yCbCr & 0xFF;
 			}
 		}
 	}
-	return getWidthHeight(width, height);
 }
 
 static int JpegDecodeMJpegYCbCr(u32 jpegAddr, int jpegSize, u32 yCbCrAddr, int yCbCrSize, int &usec) {
@@ -499,38 +571,33 @@ static int JpegDecodeMJpegYCbCr(u32 jpegAddr, int jpegSize, u32 yCbCrAddr, int y
 	if (jpegSize < 2 || buf[0] != 0xFF || buf[1] != 0xD8)
 		return hleLogError(ME, ERROR_JPEG_NO_SOI, "no SOI found, invalid data");
 
-	int width, height, actual_components;
-	unsigned char *jpegBuf = jpgd::decompress_jpeg_image_from_memory(buf, jpegSize, &width, &height, &actual_components, 3);
-
-	if (actual_components != 3 && actual_components != 1) {
-		// The assumption that the image was RGB was wrong...
-		// Try again.
-		int components = actual_components;
-		jpegBuf = jpgd::decompress_jpeg_image_from_memory(buf, jpegSize, &width, &height, &actual_components, components);
-	}
-
-	if (jpegBuf == nullptr) {
+	JpegRowDecoder decoder(buf, jpegSize);
+	if (!decoder.Begin())
 		return hleLogError(ME, ERROR_JPEG_INVALID_DATA, "unable to decompress jpeg");
-	}
 
-	if (yCbCrSize < getYCbCrBufferSize(width, height)) {
-		free(jpegBuf);
+	int width = decoder.Width();
+	int height = decoder.Height();
+	if (yCbCrSize < getYCbCrBufferSize(width, height))
 		return hleLogError(ME, ERROR_JPEG_OUT_OF_MEMORY, "buffer not large enough");
-	}
 
 	// Technically, it seems like the PSP doesn't support grayscale, but we might as well.
-	if (actual_components == 3 || actual_components == 1) {
-		if (Memory::IsValidRange(yCbCrAddr, getYCbCrBufferSize(width, height))) {
-			JpegConvertRGBToYCbCr(jpegBuf, Memory::GetPointerWriteUnchecked(yCbCrAddr), width, height);
-			NotifyMemInfo(MemBlockFlags::WRITE, yCbCrAddr, getYCbCrBufferSize(width, height), "JpegDecodeMJpegYCbCr");
-		} else {
-			// There's some weird behavior on the PSP where it writes data around the last passed address.
-			WARN_LOG_REPORT(ME, "JpegDecodeMJpegYCbCr: Invalid output address (%08x / %08x) for %dx%d", yCbCrAddr, yCbCrSize, width, height);
+	if (Memory::IsValidRange(yCbCrAddr, getYCbCrBufferSize(width, height))) {
+		u8 *output = Memory::GetPointerWriteUnchecked(yCbCrAddr);
+		bool grayscale = decoder.IsGrayscale();
+		for (int y = 0; y < height; ++y) {
+			const u8 *row = decoder.NextRow();
+			if (!row)
+				return hleLogError(ME, ERROR_JPEG_INVALID_DATA, "unable to decompress jpeg");
+			JpegConvertRowToYCbCr(row, grayscale, output, width, height, y);
 		}
+		NotifyMemInfo(MemBlockFlags::WRITE, yCbCrAddr, getYCbCrBufferSize(width, height), "JpegDecodeMJpegYCbCr");
+	} else {
+		if (!decoder.SkipRows())
+			return hleLogError(ME, ERROR_JPEG_INVALID_DATA, "unable to decompress jpeg");
+		// There's some weird behavior on the PSP where it writes data around the last passed address.
+		WARN_LOG_REPORT(ME, "JpegDecodeMJpegYCbCr: Invalid output address (%08x / %08x) for %dx%d", yCbCrAddr, yCbCrSize, width, height);
 	}
 
-	free(jpegBuf);
-
 	// Rough estimate based on observed timing.
 	usec += (width * height) / 14;
 	return hleLogSuccessX(ME, getWidthHeight(width, height));
@@ -222,6 +222,8 @@ void __KernelDoState(PointerWrap &p)
 			return;
 
 		Do(p, kernelRunning);
+		if (p.mode != PointerWrap::MODE_READ)
+			__KernelFlushLazyVFPU();
 		kernelObjects.DoState(p);
 
 		if (s >= 2)
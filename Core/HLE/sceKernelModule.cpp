@@ -19,11 +19,13 @@
 #include <set>
 
 #include "zlib.h"
+#include "ext/xxhash.h"
 
 #include "Common/Data/Convert/SmallDataConvert.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Serialize/SerializeSet.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
 #include "Core/Config.h"
@@ -924,6 +926,106 @@ static void __SaveDecryptedEbootToStorageMedia(const u8 *decryptedEbootDataPtr,
 	INFO_LOG(SCEMODULE, "Successfully wrote decrypted EBOOT to %s", fullPath.c_str());
 }
 
+// KIRK decryption of big modules is slow on weak devices, so decrypted modules are cached,
+// keyed by a hash of the encrypted data.  The decrypted data is hashed too, to verify it on load.
+struct DecryptedModuleHeader {
+	u32_le magic;
+	u32_le inputSize;
+	u32_le outputSize;
+	u32_le reserved;
+	u64_le inputHashLow;
+	u64_le inputHashHigh;
+	u64_le outputHash;
+};
+
+static const u32 DECRYPTED_MODULE_MAGIC = 0x31435250;  // "PRC1"
+static const u64 DECRYPTED_MODULE_CACHE_MAX_SIZE = 256 * 1024 * 1024;
+
+static Path DecryptedModuleCacheDir() {
+	return GetSysDirectory(DIRECTORY_APP_CACHE) / "prxcache";
+}
+
+static Path DecryptedModuleCachePath(const XXH128_hash_t &inputHash) {
+	return DecryptedModuleCacheDir() / StringFromFormat("%016llx%016llx.prx", (unsigned long long)inputHash.high64, (unsigned long long)inputHash.low64);
+}
+
+// Returns the decrypted size like pspDecryptPRX, or 0 if not cached.
+static int LoadDecryptedModule(const XXH128_hash_t &inputHash, u32 inputSize, u8 *out, u32 outSize) {
+	FILE *f = File::OpenCFile(DecryptedModuleCachePath(inputHash), "rb");
+	if (!f)
+		return 0;
+
+	DecryptedModuleHeader header{};
+	bool valid = fread(&header, sizeof(header), 1, f) == 1;
+	valid = valid && header.magic == DECRYPTED_MODULE_MAGIC && header.inputSize == inputSize;
+	valid = valid && header.inputHashLow == inputHash.low64 && header.inputHashHigh == inputHash.high64;
+	valid = valid && header.outputSize != 0 && header.outputSize <= outSize;
+	valid = valid && fread(out, 1, header.outputSize, f) == header.outputSize;
+	fclose(f);
+
+	if (!valid || XXH3_64bits(out, header.outputSize) != header.outputHash) {
+		WARN_LOG(SCEMODULE, "Ignoring invalid cached decrypted module");
+		return 0;
+	}
+	return (int)header.outputSize;
+}
+
+static void PruneDecryptedModuleCache() {
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(DecryptedModuleCacheDir(), &files, "prx");
+
+	u64 totalSize = 0;
+	for (const auto &file : files) {
+		if (!file.isDirectory)
+			totalSize += file.size;
+	}
+	if (totalSize <= DECRYPTED_MODULE_CACHE_MAX_SIZE)
+		return;
+
+	// Oldest first.
+	std::sort(files.begin(), files.end(), [](const File::FileInfo &a, const File::FileInfo &b) {
+		return a.mtime < b.mtime;
+	});
+	for (const auto &file : files) {
+		if (totalSize <= DECRYPTED_MODULE_CACHE_MAX_SIZE)
+			break;
+		if (!file.isDirectory && File::Delete(file.fullName))
+			totalSize -= file.size;
+	}
+}
+
+static void SaveDecryptedModule(const XXH128_hash_t &inputHash, u32 inputSize, const u8 *data, u32 size) {
+	Path dir = DecryptedModuleCacheDir();
+	if (!File::Exists(dir) && !File::CreateFullPath(dir))
+		return;
+
+	DecryptedModuleHeader header{};
+	header.magic = DECRYPTED_MODULE_MAGIC;
+	header.inputSize = inputSize;
+	header.outputSize = size;
+	header.inputHashLow = inputHash.low64;
+	header.inputHashHigh = inputHash.high64;
+	header.outputHash = XXH3_64bits(data, size);
+
+	// Write to a temporary name first, so a partial file is never picked up.
+	Path path = DecryptedModuleCachePath(inputHash);
+	Path tempPath = path.WithExtraExtension(".tmp");
+	FILE *f = File::OpenCFile(tempPath, "wb");
+	if (!f)
+		return;
+	bool success = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(data, 1, size, f) == size;
+	fclose(f);
+
+	// Might be an invalid one from before, and Rename won't replace files everywhere.
+	if (success && File::Exists(path))
+		File::Delete(path);
+	if (!success || !File::Rename(tempPath, path)) {
+		File::Delete(tempPath);
+		return;
+	}
+	PruneDecryptedModuleCache();
+}
+
 static bool IsHLEVersionedModule(const char *name) {
 	// TODO: Only some of these are currently known to be versioned.
 	// Potentially only sceMpeg_library matters.
@@ -1200,16 +1302,10 @@ static PSPModule *__KernelLoadELFFromPtr(const u8 *ptr, size_t elfSize, u32 load
 			error = SCE_KERNEL_ERROR_FILEERR;
 			return nullptr;
 		}
-		const auto maxElfSize = std::max(head->elf_size, head->psp_size);
-		newptr = new u8[maxElfSize];
-		elfSize = maxElfSize;
-		ptr = newptr;
-		magicPtr = (u32_le *)ptr;
-		int ret = pspDecryptPRX(in, (u8*)ptr, head->psp_size);
 		if (reportedModule) {
 			// This should happen for all "kernel" modules.
+			// We'd just throw away the decrypted data anyway, so don't bother decrypting it.
 			*error_string = "Missing key";
-			delete [] newptr;
 			module->isFake = true;
 			strncpy(module->nm.name, head->modname, ARRAY_SIZE(module->nm.name));
 			module->nm.entry_addr = -1;
@@ -1239,7 +1335,26 @@ static PSPModule *__KernelLoadELFFromPtr(const u8 *ptr, size_t elfSize, u32 load
 			}
 
 			return module;
-		} else if (ret <= 0) {
+		}
+
+		const auto maxElfSize = std::max(head->elf_size, head->psp_size);
+		newptr = new u8[maxElfSize];
+		elfSize = maxElfSize;
+		ptr = newptr;
+		magicPtr = (u32_le *)ptr;
+
+		XXH128_hash_t inputHash = XXH3_128bits(in, head->psp_size);
+		int ret = LoadDecryptedModule(inputHash, head->psp_size, newptr, maxElfSize);
+		if (ret > 0) {
+			DEBUG_LOG(SCEMODULE, "Using cached decrypted module");
+			memset(newptr + ret, 0, maxElfSize - ret);
+		} else {
+			ret = pspDecryptPRX(in, newptr, head->psp_size);
+			if (ret > 0 && (u32)ret <= maxElfSize)
+				SaveDecryptedModule(inputHash, head->psp_size, newptr, ret);
+		}
+
+		if (ret <= 0) {
 			ERROR_LOG(SCEMODULE, "Failed decrypting PRX! That's not normal! ret = %i\n", ret);
 			Reporting::ReportMessage("Failed decrypting the PRX (ret = %i, size = %i, psp_size = %i)!", ret, head->elf_size, head->psp_size);
 			// Fall through to safe exit in the next check.
@@ -1399,6 +1514,7 @@ static PSPModule *__KernelLoadELFFromPtr(const u8 *ptr, size_t elfSize, u32 load
 
 		// If the ELF has debug symbols, don't add entries to the symbol table.
 		bool insertSymbols = scan && !reader.LoadSymbols();
+		std::vector<MIPSAnalyst::ScanRange> scanRanges;
 		std::vector<SectionID> codeSections = reader.GetCodeSections();
 		for (SectionID id : codeSections) {
 			u32 start = reader.GetSectionAddr(id);
@@ -1416,7 +1532,7 @@ static PSPModule *__KernelLoadELFFromPtr(const u8 *ptr, size_t elfSize, u32 load
 				module->textEnd = end;
 
 			if (scan) {
-				insertSymbols = MIPSAnalyst::ScanForFunctions(start, end, insertSymbols);
+				scanRanges.push_back({ start, end });
 			}
 		}
 
@@ -1428,20 +1544,22 @@ static PSPModule *__KernelLoadELFFromPtr(const u8 *ptr, size_t elfSize, u32 load
 			if (Memory::IsValidRange(scanStart, scanEnd - scanStart)) {
 				// Skip the exports and imports sections, they're not code.
 				if (scanEnd >= std::min(modinfo->libent, modinfo->libstub)) {
-					insertSymbols = MIPSAnalyst::ScanForFunctions(scanStart, std::min(modinfo->libent, modinfo->libstub) - 4, insertSymbols);
+					scanRanges.push_back({ scanStart, std::min(modinfo->libent, modinfo->libstub) - 4 });
 					scanStart = std::min(modinfo->libentend, modinfo->libstubend);
 				}
 				if (scanEnd >= std::max(modinfo->libent, modinfo->libstub)) {
-					insertSymbols = MIPSAnalyst::ScanForFunctions(scanStart, std::max(modinfo->libent, modinfo->libstub) - 4, insertSymbols);
+					scanRanges.push_back({ scanStart, std::max(modinfo->libent, modinfo->libstub) - 4 });
 					scanStart = std::max(modinfo->libentend, modinfo->libstubend);
 				}
-				insertSymbols = MIPSAnalyst::ScanForFunctions(scanStart, scanEnd, insertSymbols);
+				scanRanges.push_back({ scanStart, scanEnd });
 			} else {
 				ERROR_LOG(LOADER, "Bad text scan range %08x-%08x", scanStart, scanEnd);
 			}
 		}
 
 		if (scan) {
+			// Each range is scanned on its own task.
+			insertSymbols = MIPSAnalyst::ScanForFunctions(scanRanges, insertSymbols);
 			MIPSAnalyst::FinalizeScan(insertSymbols);
 		}
 	}
@@ -647,6 +647,13 @@ std::mutex threadqueueLock;
 // Lists only ready thread ids.
 ThreadQueueList threadReadyQueue;
 
+// Only updated on the CPU thread, and published to the debugger once per vblank.
+static KernelSchedulerStats schedulerStats;
+static KernelSchedulerStats publishedSchedulerStats;
+static u32 frameReschedules;
+static u32 frameContextSwitches;
+static std::mutex schedulerStatsLock;
+
 SceUID threadIdleID[2];
 
 int eventScheduledWakeup;
@@ -666,6 +673,9 @@ WaitTypeFuncs waitTypeFuncs[NUM_WAITTYPES];
 
 // Doesn't really need state saving, just for logging purposes.
 static u64 lastSwitchCycles = 0;
+// The thread whose VFPU state currently lives in currentMIPS.  Threads without the VFPU
+// attribute never touch it, so it's only written back when another VFPU thread needs it.
+static SceUID vfpuOwner = 0;
 
 //////////////////////////////////////////////////////////////////////////
 //STATE END
@@ -932,6 +942,13 @@ void __KernelThreadingInit()
 	currentCallbackThreadID = 0;
 	readyCallbacksCount = 0;
 	lastSwitchCycles = 0;
+	memset(&schedulerStats, 0, sizeof(schedulerStats));
+	frameReschedules = 0;
+	frameContextSwitches = 0;
+	{
+		std::lock_guard<std::mutex> guard(schedulerStatsLock);
+		publishedSchedulerStats = schedulerStats;
+	}
 	idleThreadHackAddr = kernelMemory.Alloc(blockSize, false, "threadrethack");
 
 	Memory::Memcpy(idleThreadHackAddr, idleThreadCode, sizeof(idleThreadCode), "ThreadMIPS");
@@ -1002,6 +1019,11 @@ void __KernelThreadingDoState(PointerWrap &p)
 	Do(p, pausedDelays);
 
 	__SetCurrentThread(kernelObjects.GetFast<PSPThread>(currentThread), currentThread, __KernelGetThreadName(currentThread));
+	if (p.mode == PointerWrap::MODE_READ) {
+		// Contexts were flushed before saving, so the CPU matches the current thread.
+		PSPThread *cur = __GetCurrentThread();
+		vfpuOwner = cur && (cur->nt.attr & PSP_THREAD_ATTR_VFPU) != 0 ? currentThread : 0;
+	}
 	lastSwitchCycles = CoreTiming::GetTicks();
 
 	if (s >= 2)
@@ -1179,6 +1201,7 @@ void __KernelThreadingShutdown() {
 	threadReadyQueue.clear();
 	threadEndListeners.clear();
 	mipsCalls.clear();
+	vfpuOwner = 0;
 	threadReturnHackAddr = 0;
 	cbReturnHackAddr = 0;
 	hleReturnHackAddr = 0;
@@ -1465,6 +1488,27 @@ void __KernelSaveContext(PSPThreadContext *ctx, bool vfpuEnabled) {
 	memcpy(ctx->other, currentMIPS->other, sizeof(ctx->other));
 }
 
+void __KernelFlushLazyVFPU() {
+	if (vfpuOwner == 0)
+		return;
+	u32 error;
+	PSPThread *owner = kernelObjects.Get<PSPThread>(vfpuOwner, error);
+	if (owner) {
+		memcpy(owner->context.v, currentMIPS->v, sizeof(owner->context.v));
+		memcpy(owner->context.vfpuCtrl, currentMIPS->vfpuCtrl, sizeof(owner->context.vfpuCtrl));
+	}
+}
+
+// Loads a thread's context, only swapping the VFPU registers if it uses them and doesn't already own them.
+static void __KernelLoadThreadContext(PSPThread *thread) {
+	bool needVFPU = (thread->nt.attr & PSP_THREAD_ATTR_VFPU) != 0 && vfpuOwner != thread->GetUID();
+	if (needVFPU) {
+		__KernelFlushLazyVFPU();
+		vfpuOwner = thread->GetUID();
+	}
+	__KernelLoadContext(&thread->context, needVFPU);
+}
+
 // Loads a CPU context
 void __KernelLoadContext(const PSPThreadContext *ctx, bool vfpuEnabled) {
 	// r and f are immediately next to each other and must be.
@@ -1535,6 +1579,8 @@ void __KernelWaitCurThread(WaitType type, SceUID waitID, u32 waitValue, u32 time
 		WARN_LOG_REPORT(SCEKERNEL, "Waiting thread for %d that was already waiting for %d", type, thread->nt.waitType);
 	thread->nt.waitID = waitID;
 	thread->nt.waitType = type;
+	if (type >= 0 && type < NUM_WAITTYPES)
+		schedulerStats.waits[type]++;
 	__KernelChangeThreadState(thread, ThreadStatus(THREADSTATUS_WAIT | (thread->nt.status & THREADSTATUS_SUSPEND)));
 	thread->nt.numReleases++;
 	thread->waitInfo.waitValue = waitValue;
@@ -1557,6 +1603,8 @@ void __KernelWaitCallbacksCurThread(WaitType type, SceUID waitID, u32 waitValue,
 		WARN_LOG_REPORT(SCEKERNEL, "Waiting thread for %d that was already waiting for %d", type, thread->nt.waitType);
 	thread->nt.waitID = waitID;
 	thread->nt.waitType = type;
+	if (type >= 0 && type < NUM_WAITTYPES)
+		schedulerStats.waits[type]++;
 	__KernelChangeThreadState(thread, ThreadStatus(THREADSTATUS_WAIT | (thread->nt.status & THREADSTATUS_SUSPEND)));
 	// TODO: Probably not...?
 	thread->nt.numReleases++;
@@ -1655,6 +1703,8 @@ u32 __KernelDeleteThread(SceUID threadID, int exitStatus, const char *reason)
 
 	if (currentThread == threadID)
 		__SetCurrentThread(NULL, 0, NULL);
+	if (vfpuOwner == threadID)
+		vfpuOwner = 0;
 	if (currentCallbackThreadID == threadID)
 	{
 		currentCallbackThreadID = 0;
@@ -1752,6 +1802,9 @@ static PSPThread *__KernelNextThread() {
 
 void __KernelReSchedule(const char *reason)
 {
+	schedulerStats.reschedules++;
+	frameReschedules++;
+
 	// First, let's check if there are any pending callbacks to trigger.
 	// TODO: Could probably take this out of __KernelReSchedule() which is a bit hot.
 	__KernelCheckCallbacks();
@@ -1787,6 +1840,21 @@ void __KernelReSchedule(bool doCallbacks, const char *reason)
 	}
 }
 
+void __KernelSchedulerStatsEndFrame() {
+	schedulerStats.frameReschedules = frameReschedules;
+	schedulerStats.frameContextSwitches = frameContextSwitches;
+	frameReschedules = 0;
+	frameContextSwitches = 0;
+
+	std::lock_guard<std::mutex> guard(schedulerStatsLock);
+	publishedSchedulerStats = schedulerStats;
+}
+
+KernelSchedulerStats __KernelGetSchedulerStats() {
+	std::lock_guard<std::mutex> guard(schedulerStatsLock);
+	return publishedSchedulerStats;
+}
+
 int sceKernelCheckThreadStack()
 {
 	u32 error;
@@ -1837,6 +1905,9 @@ void PSPThreadContext::reset() {
 
 void __KernelResetThread(PSPThread *t, int lowestPriority) {
 	t->context.reset();
+	// Its VFPU registers in the CPU are stale now, make sure they're reloaded.
+	if (vfpuOwner == t->GetUID())
+		vfpuOwner = 0;
 	t->context.pc = t->nt.entrypoint;
 
 	// If the thread would be better than lowestPriority, reset to its initial.  Yes, kinda odd...
@@ -1928,7 +1999,7 @@ SceUID __KernelSetupRootThread(SceUID moduleID, int args, const char *argp, int
 
 	KernelValidateThreadTarget(thread->context.pc);
 
-	__KernelLoadContext(&thread->context, (attr & PSP_THREAD_ATTR_VFPU) != 0);
+	__KernelLoadThreadContext(thread);
 	currentMIPS->r[MIPS_REG_A0] = args;
 	currentMIPS->r[MIPS_REG_SP] -= (args + 0xf) & ~0xf;
 	u32 location = currentMIPS->r[MIPS_REG_SP];
@@ -2400,6 +2471,13 @@ u32 __KernelGetCurThreadStackStart() {
 	return 0;
 }
 
+u32 __KernelGetCurThreadEntry() {
+	PSPThread *t = __GetCurrentThread();
+	if (t)
+		return t->nt.entrypoint;
+	return 0;
+}
+
 SceUID sceKernelGetThreadId()
 {
 	VERBOSE_LOG(SCEKERNEL, "%i = sceKernelGetThreadId()", currentThread);
@@ -3055,7 +3133,8 @@ void __KernelSwitchContext(PSPThread *target, const char *reason) {
 	PSPThread *cur = __GetCurrentThread();
 	if (cur)  // It might just have been deleted.
 	{
-		__KernelSaveContext(&cur->context, (cur->nt.attr & PSP_THREAD_ATTR_VFPU) != 0);
+		// VFPU state stays in the CPU until another VFPU thread runs, see __KernelLoadThreadContext().
+		__KernelSaveContext(&cur->context, false);
 		oldPC = currentMIPS->pc;
 		oldUID = cur->GetUID();
 
@@ -3070,13 +3149,17 @@ void __KernelSwitchContext(PSPThread *target, const char *reason) {
 		__KernelChangeReadyState(target, currentThread, false);
 		target->nt.status = (target->nt.status | THREADSTATUS_RUNNING) & ~THREADSTATUS_READY;
 
-		__KernelLoadContext(&target->context, (target->nt.attr & PSP_THREAD_ATTR_VFPU) != 0);
+		__KernelLoadThreadContext(target);
 	}
 	else
 		__SetCurrentThread(NULL, 0, NULL);
 
 	const bool fromIdle = oldUID == threadIdleID[0] || oldUID == threadIdleID[1];
 	const bool toIdle = currentThread == threadIdleID[0] || currentThread == threadIdleID[1];
+	if (oldUID != currentThread) {
+		schedulerStats.contextSwitches++;
+		frameContextSwitches++;
+	}
 #if DEBUG_LEVEL <= MAX_LOGLEVEL || DEBUG_LOG == NOTICE_LOG
 	if (!(fromIdle && toIdle))
 	{
@@ -172,12 +172,15 @@ int KernelCurThreadPriority();
 bool KernelChangeThreadPriority(SceUID threadID, int priority);
 u32 __KernelGetCurThreadStack();
 u32 __KernelGetCurThreadStackStart();
+u32 __KernelGetCurThreadEntry();
 const char *__KernelGetThreadName(SceUID threadID);
 bool KernelIsThreadDormant(SceUID threadID);
 bool KernelIsThreadWaiting(SceUID threadID);
 
 void __KernelSaveContext(PSPThreadContext *ctx, bool vfpuEnabled);
 void __KernelLoadContext(const PSPThreadContext *ctx, bool vfpuEnabled);
+// Writes the VFPU registers back to the thread that last used them, they're switched lazily.
+void __KernelFlushLazyVFPU();
 
 u32 __KernelResumeThreadFromWait(SceUID threadID, u32 retval); // can return an error value
 u32 __KernelResumeThreadFromWait(SceUID threadID, u64 retval);
@@ -330,6 +333,21 @@ struct DebugThreadInfo
 };
 
 std::vector<DebugThreadInfo> GetThreadsInfo();
+
+struct KernelSchedulerStats {
+	// Totals since the game started.
+	u64 reschedules;
+	u64 contextSwitches;
+	u64 waits[NUM_WAITTYPES];
+	// Counts during the last vblank.
+	u32 frameReschedules;
+	u32 frameContextSwitches;
+};
+
+// Called each vblank to publish the stats and start the next frame's counts.
+void __KernelSchedulerStatsEndFrame();
+// Thread safe, returns the stats as of the last vblank.
+KernelSchedulerStats __KernelGetSchedulerStats();
 DebugInterface *KernelDebugThread(SceUID threadID);
 void __KernelChangeThreadState(SceUID threadId, ThreadStatus newStatus);
 
@@ -1512,19 +1512,18 @@ void PostPutAction::run(MipsCall &call) {
 
 	// It seems validation is done only by older mpeg libs.
 	if (mpegLibVersion < 0x0105 && packetsAddedThisRound > 0) {
-		// TODO: Faster / less wasteful validation.
-		std::unique_ptr<MpegDemux> demuxer(new MpegDemux(packetsAddedThisRound * 2048, 0));
+		// This parses straight from the ringbuffer, so the demuxer only needs room for a packet
+		// split between chunks (a PES packet is at most 64 KB) plus the next chunk.
+		std::unique_ptr<MpegDemux> demuxer(new MpegDemux(std::min(packetsAddedThisRound, 34) * 2048, 0));
 		int readOffset = ringbuffer->packetsRead % (s32)ringbuffer->packets;
 		uint32_t bufSize = Memory::ValidSize(ringbuffer->data + readOffset * 2048, packetsAddedThisRound * 2048);
 		const u8 *buf = Memory::GetPointer(ringbuffer->data + readOffset * 2048);
 		bool invalid = false;
 		for (uint32_t i = 0; i < bufSize / 2048; ++i) {
-			demuxer->addStreamData(buf, 2048);
-			buf += 2048;
-
-			if (!demuxer->demux(0xFFFF)) {
+			if (!demuxer->addStreamDataAndDemux(buf, 2048, 0xFFFF)) {
 				invalid = true;
 			}
+			buf += 2048;
 		}
 		if (invalid) {
 			// Bail out early - don't accept any of the packets, even the good ones.
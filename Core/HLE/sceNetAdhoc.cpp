@@ -29,6 +29,19 @@
 #define MSG_NOSIGNAL 0x00
 #endif
 
+// Linux can report the full size of a datagram without copying it, by peeking with MSG_TRUNC.
+#if defined(__linux__)
+#define PDP_PEEK_TRUNC
+#endif
+
+// sendmmsg needs Android API 21, so only use it on desktop Linux.
+#if defined(__linux__) && !defined(__ANDROID__)
+#define PDP_SENDMMSG
+#endif
+
+// Max number of targets per batched send.
+#define PDP_SEND_BATCH 16
+
 #include <mutex>
 #include "Common/Thread/ThreadUtil.h"
 // sceNetAdhoc
@@ -39,6 +52,7 @@
 #include "Core/Core.h"
 #include "Core/Host.h"
 #include "Core/Reporting.h"
+#include "Core/MemFault.h"
 #include "Core/MemMapHelpers.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
@@ -460,6 +474,78 @@ int StartGameModeScheduler() {
 	return 0;
 }
 
+// Returns the full size of the next datagram and its sender, without removing it from the socket buffer.
+static int PeekPdpDatagram(int fd, struct sockaddr_in *sin) {
+	socklen_t sinlen = sizeof(*sin);
+	memset(sin, 0, sinlen);
+#ifdef PDP_PEEK_TRUNC
+	return recvfrom(fd, dummyPeekBuf64k, 0, MSG_PEEK | MSG_TRUNC | MSG_NOSIGNAL, (struct sockaddr*)sin, &sinlen);
+#else
+	// On Windows: MSG_TRUNC are not supported on recvfrom (socket error WSAEOPNOTSUPP), so we use dummy buffer as an alternative
+	return recvfrom(fd, dummyPeekBuf64k, dummyPeekBuf64kSize, MSG_PEEK | MSG_NOSIGNAL, (struct sockaddr*)sin, &sinlen);
+#endif
+}
+
+// Copies the start of the datagram seen by PeekPdpDatagram into buf, still without removing it.
+static void CopyPeekedPdpDatagram(int fd, void *buf, int len, int size) {
+	if (size <= 0 || len <= 0)
+		return;
+#ifdef PDP_PEEK_TRUNC
+	recv(fd, (char*)buf, len, MSG_PEEK | MSG_NOSIGNAL);
+#else
+	memcpy(buf, dummyPeekBuf64k, std::min(size, len));
+#endif
+}
+
+// Removes the next datagram from the socket buffer.
+static void DiscardPdpDatagram(int fd) {
+#ifdef PDP_PEEK_TRUNC
+	recv(fd, dummyPeekBuf64k, 0, MSG_NOSIGNAL);
+#else
+	recv(fd, dummyPeekBuf64k, dummyPeekBuf64kSize, MSG_NOSIGNAL);
+#endif
+}
+
+// Sends the same datagram to up to PDP_SEND_BATCH targets, straight from the game's buffer.
+// results[i] is the sendto result for targets[i], and errors[i] the errno if it failed.
+static void SendPdpToTargets(int fd, const void *data, int len, const struct sockaddr_in *targets, int count, int *results, int *errors) {
+#ifdef PDP_SENDMMSG
+	struct mmsghdr msgs[PDP_SEND_BATCH];
+	struct iovec iov;
+	iov.iov_base = (void *)data;
+	iov.iov_len = len;
+	for (int i = 0; i < count; i++) {
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_name = (void *)&targets[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(targets[i]);
+		msgs[i].msg_hdr.msg_iov = &iov;
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int done = 0;
+	while (done < count) {
+		int sent = sendmmsg(fd, msgs + done, count - done, MSG_NOSIGNAL);
+		if (sent <= 0) {
+			// The first unsent one failed, skip it and keep going with the rest.
+			results[done] = SOCKET_ERROR;
+			errors[done] = errno;
+			done++;
+			continue;
+		}
+		for (int i = done; i < done + sent; i++) {
+			results[i] = (int)msgs[i].msg_len;
+			errors[i] = 0;
+		}
+		done += sent;
+	}
+#else
+	for (int i = 0; i < count; i++) {
+		results[i] = sendto(fd, (const char*)data, len, MSG_NOSIGNAL, (const struct sockaddr*)&targets[i], sizeof(targets[i]));
+		errors[i] = results[i] == SOCKET_ERROR ? errno : 0;
+	}
+#endif
+}
+
 int DoBlockingPdpRecv(AdhocSocketRequest& req, s64& result) {
 	auto sock = adhocSockets[req.id - 1];
 	if (!sock) {
@@ -479,11 +565,7 @@ int DoBlockingPdpRecv(AdhocSocketRequest& req, s64& result) {
 	struct sockaddr_in sin;
 	socklen_t sinlen;
 
-	sinlen = sizeof(sin);
-	memset(&sin, 0, sinlen);
-
-	// On Windows: MSG_TRUNC are not supported on recvfrom (socket error WSAEOPNOTSUPP), so we use dummy buffer as an alternative
-	ret = recvfrom(pdpsocket.id, dummyPeekBuf64k, dummyPeekBuf64kSize, MSG_PEEK | MSG_NOSIGNAL, (struct sockaddr*)&sin, &sinlen);
+	ret = PeekPdpDatagram(pdpsocket.id, &sin);
 	sockerr = errno;
 
 	// Discard packets from IP that can't be translated into MAC address to prevent confusing the game, since the sender MAC won't be updated and may contains invalid/undefined value.
@@ -493,9 +575,7 @@ int DoBlockingPdpRecv(AdhocSocketRequest& req, s64& result) {
 	//       (in case the IP was resolvable but came from a different App, which will need to be discarded too)
 	if (ret != SOCKET_ERROR && !resolveIP(sin.sin_addr.s_addr, &mac)) {
 		// Remove the packet from socket buffer
-		sinlen = sizeof(sin);
-		memset(&sin, 0, sinlen);
-		recvfrom(pdpsocket.id, dummyPeekBuf64k, dummyPeekBuf64kSize, MSG_NOSIGNAL, (struct sockaddr*)&sin, &sinlen);
+		DiscardPdpDatagram(pdpsocket.id);
 		// Try again later, until timeout reached
 		u64 now = (u64)(time_now_d() * 1000000.0);
 		if (req.timeout != 0 && now - req.startTime > req.timeout) {
@@ -508,13 +588,11 @@ int DoBlockingPdpRecv(AdhocSocketRequest& req, s64& result) {
 	}
 
 	// At this point we assumed that the packet is a valid PPSSPP packet
-	if (ret > 0 && *req.length > 0)
-		memcpy(req.buffer, dummyPeekBuf64k, std::min(ret, *req.length));
-
 	// Note: UDP must not be received partially, otherwise leftover data in socket's buffer will be discarded
 	if (ret >= 0 && ret <= *req.length) {
 		sinlen = sizeof(sin);
         memset(&sin, 0, sinlen);
+		Memory::MemWriteWatch_NotifyHostWrite(req.buffer, std::max(0, *req.length));
 		ret = recvfrom(pdpsocket.id, (char*)req.buffer, std::max(0, *req.length), MSG_NOSIGNAL, (struct sockaddr*)&sin, &sinlen);
 		// UDP can also receives 0 data, while on TCP receiving 0 data = connection gracefully closed, but not sure whether PDP can send/recv 0 data or not tho
 		*req.length = 0;
@@ -559,6 +637,7 @@ int DoBlockingPdpRecv(AdhocSocketRequest& req, s64& result) {
 	// Returning required buffer size when available data in recv buffer is larger than provided buffer size
 	else if (ret > *req.length) {
 		WARN_LOG(SCENET, "sceNetAdhocPdpRecv[%i:%u]: Peeked %u/%u bytes from %s:%u\n", req.id, getLocalPort(pdpsocket.id), ret, *req.length, ip2str(sin.sin_addr).c_str(), ntohs(sin.sin_port));
+		CopyPeekedPdpDatagram(pdpsocket.id, req.buffer, *req.length, ret);
 		*req.length = ret;
 
 		// Find Peer MAC
@@ -600,23 +679,34 @@ int DoBlockingPdpSend(AdhocSocketRequest& req, s64& result, AdhocSendTargets& ta
 
 	result = 0;
 	bool retry = false;
-	for (auto peer = targetPeers.peers.begin(); peer != targetPeers.peers.end(); ) {
-		// Fill in Target Structure
-		struct sockaddr_in target {};
-		target.sin_family = AF_INET;
-		target.sin_addr.s_addr = peer->ip;
-		target.sin_port = htons(peer->port + peer->portOffset);
+	size_t next = 0;
+	while (next < targetPeers.peers.size()) {
+		// Fill in Target Structures
+		struct sockaddr_in targets[PDP_SEND_BATCH]{};
+		int results[PDP_SEND_BATCH];
+		int errors[PDP_SEND_BATCH];
+		int count = (int)std::min(targetPeers.peers.size() - next, (size_t)PDP_SEND_BATCH);
+		for (int i = 0; i < count; i++) {
+			const AdhocSendTarget &peer = targetPeers.peers[next + i];
+			targets[i].sin_family = AF_INET;
+			targets[i].sin_addr.s_addr = peer.ip;
+			targets[i].sin_port = htons(peer.port + peer.portOffset);
+		}
 
-		int ret = sendto(pdpsocket.id, (const char*)req.buffer, targetPeers.length, MSG_NOSIGNAL, (struct sockaddr*)&target, sizeof(target));
-		int sockerr = errno;
+		SendPdpToTargets(pdpsocket.id, req.buffer, targetPeers.length, targets, count, results, errors);
 
-		if (ret >= 0) {
-			DEBUG_LOG(SCENET, "sceNetAdhocPdpSend[%i:%u](B): Sent %u bytes to %s:%u\n", req.id, getLocalPort(pdpsocket.id), ret, ip2str(target.sin_addr).c_str(), ntohs(target.sin_port));
-			// Remove successfully sent to peer to prevent sending the same data again during a retry
-			peer = targetPeers.peers.erase(peer);
-		}
-		else {
-			if (ret == SOCKET_ERROR && (sockerr == EAGAIN || sockerr == EWOULDBLOCK)) {
+		// Keep only the ones to retry in place, in front of the ones not tried yet.
+		size_t kept = next;
+		for (int i = 0; i < count; i++) {
+			int ret = results[i];
+			int sockerr = errors[i];
+			if (ret >= 0) {
+				DEBUG_LOG(SCENET, "sceNetAdhocPdpSend[%i:%u](B): Sent %u bytes to %s:%u\n", req.id, getLocalPort(pdpsocket.id), ret, ip2str(targets[i].sin_addr).c_str(), ntohs(targets[i].sin_port));
+				// Remove successfully sent to peer to prevent sending the same data again during a retry
+				continue;
+			}
+
+			if (sockerr == EAGAIN || sockerr == EWOULDBLOCK) {
 				u64 now = (u64)(time_now_d() * 1000000.0);
 				if (req.timeout == 0 || now - req.startTime <= req.timeout) {
 					retry = true;
@@ -625,11 +715,11 @@ int DoBlockingPdpSend(AdhocSocketRequest& req, s64& result, AdhocSendTargets& ta
 					// FIXME: Does Broadcast always success? even with timeout/blocking?
 					result = ERROR_NET_ADHOC_TIMEOUT;
 			}
-			++peer;
+			DEBUG_LOG(SCENET, "Socket Error (%i) on sceNetAdhocPdpSend[%i:%u->%u](B) [size=%i]", sockerr, req.id, getLocalPort(pdpsocket.id), ntohs(targets[i].sin_port), targetPeers.length);
+			targetPeers.peers[kept++] = targetPeers.peers[next + i];
 		}
-
-		if (ret == SOCKET_ERROR)
-			DEBUG_LOG(SCENET, "Socket Error (%i) on sceNetAdhocPdpSend[%i:%u->%u](B) [size=%i]", sockerr, req.id, getLocalPort(pdpsocket.id), ntohs(target.sin_port), targetPeers.length);
+		targetPeers.peers.erase(targetPeers.peers.begin() + kept, targetPeers.peers.begin() + next + count);
+		next = kept;
 	}
 
 	if (retry)
@@ -704,6 +794,7 @@ int DoBlockingPtpRecv(AdhocSocketRequest& req, s64& result) {
 		return 0;
 	}
 
+	Memory::MemWriteWatch_NotifyHostWrite(req.buffer, std::max(0, *req.length));
 	int ret = recv(ptpsocket.id, (char*)req.buffer, std::max(0, *req.length), MSG_NOSIGNAL);
 	int sockerr = errno;
 
@@ -1723,21 +1814,28 @@ static int sceNetAdhocPdpSend(int id, const char *mac, u32 port, void *data, int
 								// Non-blocking
 								else {
 									// Iterate Peers
-									for (auto& peer : dest.peers) {
-										// Fill in Target Structure
-										struct sockaddr_in target {};
-										target.sin_family = AF_INET;
-										target.sin_addr.s_addr = peer.ip;
-										target.sin_port = htons(dport + peer.portOffset);
-
-										int sent = sendto(pdpsocket.id, (const char*)data, len, MSG_NOSIGNAL, (struct sockaddr*)&target, sizeof(target));
-										int error = errno;
-										if (sent == SOCKET_ERROR) {
-											DEBUG_LOG(SCENET, "Socket Error (%i) on sceNetAdhocPdpSend[%i:%u->%u](BC) [size=%i]", error, id, getLocalPort(pdpsocket.id), ntohs(target.sin_port), len);
+									for (size_t next = 0; next < dest.peers.size(); next += PDP_SEND_BATCH) {
+										// Fill in Target Structures
+										struct sockaddr_in targets[PDP_SEND_BATCH]{};
+										int results[PDP_SEND_BATCH];
+										int errors[PDP_SEND_BATCH];
+										int count = (int)std::min(dest.peers.size() - next, (size_t)PDP_SEND_BATCH);
+										for (int i = 0; i < count; i++) {
+											targets[i].sin_family = AF_INET;
+											targets[i].sin_addr.s_addr = dest.peers[next + i].ip;
+											targets[i].sin_port = htons(dport + dest.peers[next + i].portOffset);
 										}
 
-										if (sent >= 0) {
-											DEBUG_LOG(SCENET, "sceNetAdhocPdpSend[%i:%u](BC): Sent %u bytes to %s:%u\n", id, getLocalPort(pdpsocket.id), sent, ip2str(target.sin_addr).c_str(), ntohs(target.sin_port));
+										SendPdpToTargets(pdpsocket.id, data, len, targets, count, results, errors);
+
+										for (int i = 0; i < count; i++) {
+											if (results[i] == SOCKET_ERROR) {
+												DEBUG_LOG(SCENET, "Socket Error (%i) on sceNetAdhocPdpSend[%i:%u->%u](BC) [size=%i]", errors[i], id, getLocalPort(pdpsocket.id), ntohs(targets[i].sin_port), len);
+											}
+
+											if (results[i] >= 0) {
+												DEBUG_LOG(SCENET, "sceNetAdhocPdpSend[%i:%u](BC): Sent %u bytes to %s:%u\n", id, getLocalPort(pdpsocket.id), results[i], ip2str(targets[i].sin_addr).c_str(), ntohs(targets[i].sin_port));
+											}
 										}
 									}
 								}
@@ -1861,10 +1959,7 @@ static int sceNetAdhocPdpRecv(int id, void *addr, void * port, void *buf, void *
 				{
 					// Receive Data. PDP always sent in full size or nothing(failed), recvfrom will always receive in full size as requested (blocking) or failed (non-blocking). If available UDP data is larger than buffer, excess data is lost.
 					// Should peek first for the available data size if it's more than len return ERROR_NET_ADHOC_NOT_ENOUGH_SPACE along with required size in len to prevent losing excess data
-					// On Windows: MSG_TRUNC are not supported on recvfrom (socket error WSAEOPNOTSUPP), so we use dummy buffer as an alternative
-					sinlen = sizeof(sin);
-					memset(&sin, 0, sinlen);
-					received = recvfrom(pdpsocket.id, dummyPeekBuf64k, dummyPeekBuf64kSize, MSG_PEEK | MSG_NOSIGNAL, (struct sockaddr*)&sin, &sinlen);
+					received = PeekPdpDatagram(pdpsocket.id, &sin);
 					error = errno;
 					// Discard packets from IP that can't be translated into MAC address to prevent confusing the game, since the sender MAC won't be updated and may contains invalid/undefined value.
 					// TODO: In order to discard packets from unresolvable IP (can't be translated into player's MAC) properly, we'll need to manage the socket buffer ourself, 
@@ -1874,9 +1969,7 @@ static int sceNetAdhocPdpRecv(int id, void *addr, void * port, void *buf, void *
 					// Note: Looping to check too many packets (ie. contiguous) to discard per one non-blocking PdpRecv syscall may cause a slow down
 					if (received != SOCKET_ERROR && !resolveIP(sin.sin_addr.s_addr, &mac)) {
 						// Remove the packet from socket buffer
-						sinlen = sizeof(sin);
-						memset(&sin, 0, sinlen);
-						recvfrom(pdpsocket.id, dummyPeekBuf64k, dummyPeekBuf64kSize, MSG_NOSIGNAL, (struct sockaddr*)&sin, &sinlen);
+						DiscardPdpDatagram(pdpsocket.id);
 						if (flag) {
 							VERBOSE_LOG(SCENET, "%08x=sceNetAdhocPdpRecv: would block (disc)", ERROR_NET_ADHOC_WOULD_BLOCK); // Temporary fix to avoid a crash on the Logs due to trying to Logs syscall's argument from another thread (ie. AdhocMatchingInput thread)
 							return ERROR_NET_ADHOC_WOULD_BLOCK; // hleLogSuccessVerboseX(SCENET, ERROR_NET_ADHOC_WOULD_BLOCK, "would block (disc)");
@@ -1895,8 +1988,8 @@ static int sceNetAdhocPdpRecv(int id, void *addr, void * port, void *buf, void *
 				if (received != SOCKET_ERROR && *len < received) {
 					INFO_LOG(SCENET, "sceNetAdhocPdpRecv[%i:%u]: Peeked %u/%u bytes from %s:%u\n", id, getLocalPort(pdpsocket.id), received, *len, ip2str(sin.sin_addr).c_str(), ntohs(sin.sin_port));
 
-					if (received > 0 && *len > 0)
-						memcpy(buf, dummyPeekBuf64k, std::min(received, *len));
+					Memory::MemWriteWatch_NotifyHostWrite(buf, std::max(0, std::min(received, *len)));
+					CopyPeekedPdpDatagram(pdpsocket.id, buf, *len, received);
 
 					// Return the actual available data size
 					*len = received;
@@ -1917,6 +2010,7 @@ static int sceNetAdhocPdpRecv(int id, void *addr, void * port, void *buf, void *
 				sinlen = sizeof(sin);
 				memset(&sin, 0, sinlen);
 				// On Windows: Socket Error 10014 may happen when buffer size is less than the minimum allowed/required (ie. negative number on Vulcanus Seek and Destroy), the address is not a valid part of the user address space (ie. on the stack or when buffer overflow occurred), or the address is not properly aligned (ie. multiple of 4 on 32bit and multiple of 8 on 64bit) https://stackoverflow.com/questions/861154/winsock-error-code-10014
+				Memory::MemWriteWatch_NotifyHostWrite(buf, std::max(0, *len));
 				received = recvfrom(pdpsocket.id, (char*)buf, std::max(0, *len), MSG_NOSIGNAL, (struct sockaddr*)&sin, &sinlen);
 				error = errno;
 
@@ -4295,6 +4389,7 @@ static int sceNetAdhocPtpRecv(int id, u32 dataAddr, u32 dataSizeAddr, int timeou
 					int error = 0;
 
 					// Receive Data. POSIX: May received 0 bytes when the remote peer already closed the connection.
+					Memory::MemWriteWatch_NotifyHostWrite(buf, std::max(0, *len));
 					received = recv(ptpsocket.id, (char*)buf, std::max(0, *len), MSG_NOSIGNAL);
 					error = errno;
 
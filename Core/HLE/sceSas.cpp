@@ -28,6 +28,7 @@
 
 #include <cstdlib>
 #include <functional>
+#include <vector>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -98,6 +99,9 @@ static std::condition_variable sasWake;
 static std::condition_variable sasDone;
 static volatile int sasThreadState = SasThreadState::DISABLED;
 static SasThreadParams sasThreadParams;
+// Parameter changes made while a mix is queued, applied in order by the SAS thread right after it.
+// Protected by sasDoneMutex.
+static std::vector<std::function<void()>> sasDeferred;
 static int sasMixEvent = -1;
 
 int __SasThread() {
@@ -110,6 +114,9 @@ int __SasThread() {
 			sas->Mix(sasThreadParams.outAddr, sasThreadParams.inAddr, sasThreadParams.leftVol, sasThreadParams.rightVol);
 
 			std::lock_guard<std::mutex> doneGuard(sasDoneMutex);
+			for (auto &func : sasDeferred)
+				func();
+			sasDeferred.clear();
 			sasThreadState = SasThreadState::READY;
 			sasDone.notify_one();
 		}
@@ -123,6 +130,19 @@ static void __SasDrain() {
 		sasDone.wait(guard);
 }
 
+// For setters whose result doesn't depend on voice state: instead of waiting for a queued mix,
+// let the SAS thread apply the change once it's done, so the emu thread can keep going.
+static void __SasApplyOrDefer(std::function<void()> func) {
+	{
+		std::lock_guard<std::mutex> guard(sasDoneMutex);
+		if (sasThreadState == SasThreadState::QUEUED) {
+			sasDeferred.push_back(std::move(func));
+			return;
+		}
+	}
+	func();
+}
+
 static void __SasEnqueueMix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int rightVol = 0) {
 	if (sasThreadState == SasThreadState::DISABLED) {
 		// No thread, call it immediately.
@@ -151,6 +171,8 @@ static void __SasEnqueueMix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int ri
 
 static void __SasDisableThread() {
 	if (sasThreadState != SasThreadState::DISABLED) {
+		// Let any queued mix and its deferred parameter changes finish first.
+		__SasDrain();
 		sasWakeMutex.lock();
 		sasThreadState = SasThreadState::DISABLED;
 		sasWake.notify_one();
@@ -420,13 +442,15 @@ static u32 sceSasGetPauseFlag(u32 core) {
 static u32 sceSasSetPause(u32 core, u32 voicebit, int pause) {
 	DEBUG_LOG(SCESAS, "sceSasSetPause(%08x, %08x, %i)", core, voicebit, pause);
 
-	__SasDrain();
-	for (int i = 0; voicebit != 0; i++, voicebit >>= 1) {
-		if (i < PSP_SAS_VOICES_MAX && i >= 0) {
-			if ((voicebit & 1) != 0)
-				sas->voices[i].paused = pause ? true : false;
+	__SasApplyOrDefer([=]() {
+		u32 bits = voicebit;
+		for (int i = 0; bits != 0; i++, bits >>= 1) {
+			if (i < PSP_SAS_VOICES_MAX && i >= 0) {
+				if ((bits & 1) != 0)
+					sas->voices[i].paused = pause ? true : false;
+			}
 		}
-	}
+	});
 
 	return 0;
 }
@@ -443,12 +467,13 @@ static u32 sceSasSetVolume(u32 core, int voiceNum, int leftVol, int rightVol, in
 	if (overVolume)
 		return ERROR_SAS_INVALID_VOLUME;
 
-	__SasDrain();
-	SasVoice &v = sas->voices[voiceNum];
-	v.volumeLeft = leftVol;
-	v.volumeRight = rightVol;
-	v.effectLeft = effectLeftVol;
-	v.effectRight = effectRightVol;
+	__SasApplyOrDefer([=]() {
+		SasVoice &v = sas->voices[voiceNum];
+		v.volumeLeft = leftVol;
+		v.volumeRight = rightVol;
+		v.effectLeft = effectLeftVol;
+		v.effectRight = effectRightVol;
+	});
 	return 0;
 }
 
@@ -463,10 +488,11 @@ static u32 sceSasSetPitch(u32 core, int voiceNum, int pitch) {
 	}
 
 	DEBUG_LOG(SCESAS, "sceSasSetPitch(%08x, %i, %i)", core, voiceNum, pitch);
-	__SasDrain();
-	SasVoice &v = sas->voices[voiceNum];
-	v.pitch = pitch;
-	v.ChangedParams(false);
+	__SasApplyOrDefer([=]() {
+		SasVoice &v = sas->voices[voiceNum];
+		v.pitch = pitch;
+		v.ChangedParams(false);
+	});
 	return 0;
 }
 
@@ -519,11 +545,12 @@ static u32 sceSasSetNoise(u32 core, int voiceNum, int freq) {
 
 	DEBUG_LOG(SCESAS, "sceSasSetNoise(%08x, %i, %i)", core, voiceNum, freq);
 
-	__SasDrain();
-	SasVoice &v = sas->voices[voiceNum];
-	v.type = VOICETYPE_NOISE;
-	v.noiseFreq = freq;
-	v.ChangedParams(true);
+	__SasApplyOrDefer([=]() {
+		SasVoice &v = sas->voices[voiceNum];
+		v.type = VOICETYPE_NOISE;
+		v.noiseFreq = freq;
+		v.ChangedParams(true);
+	});
 	return 0;
 }
 
@@ -534,9 +561,9 @@ static u32 sceSasSetSL(u32 core, int voiceNum, int level) {
 	}
 
 	DEBUG_LOG(SCESAS, "sceSasSetSL(%08x, %i, %08x)", core, voiceNum, level);
-	__SasDrain();
-	SasVoice &v = sas->voices[voiceNum];
-	v.envelope.SetSustainLevel(level);
+	__SasApplyOrDefer([=]() {
+		sas->voices[voiceNum].envelope.SetSustainLevel(level);
+	});
 	return 0;
 }
 
@@ -554,9 +581,9 @@ static u32 sceSasSetADSR(u32 core, int voiceNum, int flag, int a, int d, int s,
 
 	DEBUG_LOG(SCESAS, "0=sceSasSetADSR(%08x, %i, %i, %08x, %08x, %08x, %08x)", core, voiceNum, flag, a, d, s, r);
 
-	__SasDrain();
-	SasVoice &v = sas->voices[voiceNum];
-	v.envelope.SetRate(flag, a, d, s, r);
+	__SasApplyOrDefer([=]() {
+		sas->voices[voiceNum].envelope.SetRate(flag, a, d, s, r);
+	});
 	return 0;
 }
 
@@ -597,9 +624,9 @@ static u32 sceSasSetADSRMode(u32 core, int voiceNum, int flag, int a, int d, int
 	}
 
 	DEBUG_LOG(SCESAS, "sceSasSetADSRMode(%08x, %i, %i, %08x, %08x, %08x, %08x)", core, voiceNum, flag, a, d, s, r);
-	__SasDrain();
-	SasVoice &v = sas->voices[voiceNum];
-	v.envelope.SetEnvelope(flag, a, d, s, r);
+	__SasApplyOrDefer([=]() {
+		sas->voices[voiceNum].envelope.SetEnvelope(flag, a, d, s, r);
+	});
 	return 0;
 }
 
@@ -617,9 +644,9 @@ static u32 sceSasSetSimpleADSR(u32 core, int voiceNum, u32 ADSREnv1, u32 ADSREnv
 
 	DEBUG_LOG(SCESAS, "sasSetSimpleADSR(%08x, %i, %08x, %08x)", core, voiceNum, ADSREnv1, ADSREnv2);
 
-	__SasDrain();
-	SasVoice &v = sas->voices[voiceNum];
-	v.envelope.SetSimpleEnvelope(ADSREnv1 & 0xFFFF, ADSREnv2 & 0xFFFF);
+	__SasApplyOrDefer([=]() {
+		sas->voices[voiceNum].envelope.SetSimpleEnvelope(ADSREnv1 & 0xFFFF, ADSREnv2 & 0xFFFF);
+	});
 	return 0;
 }
 
@@ -641,8 +668,9 @@ static u32 sceSasRevType(u32 core, int type) {
 		return hleLogError(SCESAS, ERROR_SAS_REV_INVALID_TYPE, "invalid type");
 	}
 
-	__SasDrain();
-	sas->SetWaveformEffectType(type);
+	__SasApplyOrDefer([=]() {
+		sas->SetWaveformEffectType(type);
+	});
 	return hleLogSuccessI(SCESAS, 0);
 }
 
@@ -654,9 +682,10 @@ static u32 sceSasRevParam(u32 core, int delay, int feedback) {
 		return hleLogError(SCESAS, ERROR_SAS_REV_INVALID_FEEDBACK, "invalid feedback value");
 	}
 
-	__SasDrain();
-	sas->waveformEffect.delay = delay;
-	sas->waveformEffect.feedback = feedback;
+	__SasApplyOrDefer([=]() {
+		sas->waveformEffect.delay = delay;
+		sas->waveformEffect.feedback = feedback;
+	});
 	return hleLogSuccessI(SCESAS, 0);
 }
 
@@ -665,16 +694,18 @@ static u32 sceSasRevEVOL(u32 core, u32 lv, u32 rv) {
 		return hleReportDebug(SCESAS, ERROR_SAS_REV_INVALID_VOLUME, "invalid volume");
 	}
 
-	__SasDrain();
-	sas->waveformEffect.leftVol = lv;
-	sas->waveformEffect.rightVol = rv;
+	__SasApplyOrDefer([=]() {
+		sas->waveformEffect.leftVol = lv;
+		sas->waveformEffect.rightVol = rv;
+	});
 	return hleLogSuccessI(SCESAS, 0);
 }
 
 static u32 sceSasRevVON(u32 core, int dry, int wet) {
-	__SasDrain();
-	sas->waveformEffect.isDryOn = dry != 0;
-	sas->waveformEffect.isWetOn = wet != 0;
+	__SasApplyOrDefer([=]() {
+		sas->waveformEffect.isDryOn = dry != 0;
+		sas->waveformEffect.isWetOn = wet != 0;
+	});
 	return hleLogSuccessI(SCESAS, 0);
 }
 
@@ -22,6 +22,7 @@
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Serialize/SerializeMap.h"
 #include "Common/Serialize/SerializeSet.h"
+#include "Core/MemFault.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
@@ -130,6 +131,7 @@ void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
 
 void AsyncIOManager::Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr) {
 	int usec = 0;
+	Memory::MemWriteWatch_NotifyHostWrite(buf, bytes);
 	s64 result = pspFileSystem.ReadFile(handle, buf, bytes, usec);
 	EventResult(handle, AsyncIOResult(result, usec, invalidateAddr));
 }
@@ -17,7 +17,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <mutex>
+#include <thread>
 #include <vector>
 #include "Common/CommonTypes.h"
 #include "Common/Serialize/SerializeFuncs.h"
@@ -28,6 +30,7 @@
 #include "Core/CoreTiming.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/HW/Display.h"
+#include "Core/MemFault.h"
 #include "GPU/GPU.h"
 #include "GPU/GPUInterface.h"
 
@@ -70,6 +73,57 @@ static int frameTimeHistoryPos = 0;
 static int frameTimeHistoryValid = 0;
 static double lastFrameTimeHistory = 0.0;
 
+// Frame time breakdown, only tracked on the thread that flips (the emu thread.)
+static double frameBreakdownHistory[(int)FrameTimeCategory::COUNT][600];
+static double frameBreakdown[(int)FrameTimeCategory::COUNT];
+static double frameBreakdownTotals[(int)FrameTimeCategory::COUNT];
+static bool frameBreakdownEnabled = false;
+static std::thread::id frameBreakdownThread;
+static FrameTimeCategory frameBreakdownStack[16];
+static int frameBreakdownDepth = 0;
+static double frameBreakdownLast = 0.0;
+
+static void AccumulateFrameBreakdown(double now) {
+	if (frameBreakdownDepth > 0 && frameBreakdownDepth <= (int)ARRAY_SIZE(frameBreakdownStack))
+		frameBreakdown[(int)frameBreakdownStack[frameBreakdownDepth - 1]] += now - frameBreakdownLast;
+	frameBreakdownLast = now;
+}
+
+bool DisplayFrameTimeEnter(FrameTimeCategory cat) {
+	if (!frameBreakdownEnabled || std::this_thread::get_id() != frameBreakdownThread)
+		return false;
+	AccumulateFrameBreakdown(time_now_d());
+	if (frameBreakdownDepth < (int)ARRAY_SIZE(frameBreakdownStack))
+		frameBreakdownStack[frameBreakdownDepth] = cat;
+	frameBreakdownDepth++;
+	return true;
+}
+
+void DisplayFrameTimeLeave() {
+	if (frameBreakdownDepth <= 0)
+		return;
+	AccumulateFrameBreakdown(time_now_d());
+	frameBreakdownDepth--;
+}
+
+static void UpdateFrameBreakdown(double now, int pos) {
+	if (frameBreakdownEnabled) {
+		AccumulateFrameBreakdown(now);
+		for (int i = 0; i < (int)FrameTimeCategory::COUNT; ++i) {
+			frameBreakdownHistory[i][pos] = frameBreakdown[i];
+			frameBreakdownTotals[i] += frameBreakdown[i];
+			frameBreakdown[i] = 0.0;
+		}
+	} else {
+		// Scopes opened before this point won't call leave.
+		frameBreakdownThread = std::this_thread::get_id();
+		frameBreakdownDepth = 0;
+		frameBreakdownLast = now;
+		memset(frameBreakdown, 0, sizeof(frameBreakdown));
+		frameBreakdownEnabled = true;
+	}
+}
+
 static void CalculateFPS() {
 	double now = time_now_d();
 
@@ -93,6 +147,7 @@ static void CalculateFPS() {
 	}
 
 	if (g_Config.bDrawFrameGraph || coreCollectDebugStats) {
+		UpdateFrameBreakdown(now, frameTimeHistoryPos);
 		frameTimeHistory[frameTimeHistoryPos++] = now - lastFrameTimeHistory;
 		lastFrameTimeHistory = now;
 		frameTimeHistoryPos = frameTimeHistoryPos % frameTimeHistorySize;
@@ -100,6 +155,8 @@ static void CalculateFPS() {
 			++frameTimeHistoryValid;
 		}
 		frameSleepHistory[frameTimeHistoryPos] = 0.0;
+	} else {
+		frameBreakdownEnabled = false;
 	}
 }
 
@@ -170,6 +227,47 @@ double *__DisplayGetFrameTimes(int *out_valid, int *out_pos, double **out_sleep)
 	return frameTimeHistory;
 }
 
+double *__DisplayGetFrameBreakdown(FrameTimeCategory cat) {
+	return frameBreakdownHistory[(int)cat];
+}
+
+void __DisplayGetFrameBreakdownTotals(double totals[(int)FrameTimeCategory::COUNT]) {
+	memcpy(totals, frameBreakdownTotals, sizeof(frameBreakdownTotals));
+}
+
+void __DisplayResetFrameBreakdownTotals() {
+	memset(frameBreakdownTotals, 0, sizeof(frameBreakdownTotals));
+}
+
+void __DisplayGetFrameTimeStats(FrameTimeStats *stats) {
+	static const double histogramLimits[] = { 1.001 / 60.0, 0.020, 0.025, 1.001 / 30.0, 0.050, 0.100 };
+	*stats = {};
+
+	std::vector<double> sorted(frameTimeHistory, frameTimeHistory + frameTimeHistoryValid);
+	if (sorted.empty())
+		return;
+	std::sort(sorted.begin(), sorted.end());
+
+	double sum = 0.0;
+	for (double t : sorted) {
+		sum += t;
+		int bucket = 0;
+		while (bucket < (int)ARRAY_SIZE(histogramLimits) && t > histogramLimits[bucket])
+			bucket++;
+		stats->histogram[bucket]++;
+	}
+
+	size_t slowCount = std::max((size_t)1, sorted.size() / 100);
+	double slowSum = 0.0;
+	for (size_t i = sorted.size() - slowCount; i < sorted.size(); ++i)
+		slowSum += sorted[i];
+
+	stats->frames = (int)sorted.size();
+	stats->averageMs = sum * 1000.0 / sorted.size();
+	stats->slowestPercentMs = slowSum * 1000.0 / slowCount;
+	stats->worstMs = sorted.back() * 1000.0;
+}
+
 int DisplayGetSleepPos() {
 	return frameTimeHistoryPos;
 }
@@ -184,15 +282,23 @@ void __DisplayGetDebugStats(char *stats, size_t bufsize) {
 	char statbuf[4096];
 	gpu->GetStats(statbuf, sizeof(statbuf));
 
+	char faultbuf[128] = "";
+	std::vector<Memory::MemFaultSite> faultSites = Memory::MemFault_GetTopSites(1);
+	if (!faultSites.empty()) {
+		snprintf(faultbuf, sizeof(faultbuf), "Ignored bad memory accesses: %llu (most in block %08x: %u)\n",
+			(unsigned long long)Memory::MemFault_GetNumIgnoredFaults(), faultSites[0].blockAddress, faultSites[0].count);
+	}
+
 	snprintf(stats, bufsize,
 		"Kernel processing time: %0.2f ms\n"
 		"Slowest syscall: %s : %0.2f ms\n"
-		"Most active syscall: %s : %0.2f ms\n%s",
+		"Most active syscall: %s : %0.2f ms\n%s%s",
 		kernelStats.msInSyscalls * 1000.0f,
 		kernelStats.slowestSyscallName ? kernelStats.slowestSyscallName : "(none)",
 		kernelStats.slowestSyscallTime * 1000.0f,
 		kernelStats.summedSlowestSyscallName ? kernelStats.summedSlowestSyscallName : "(none)",
 		kernelStats.summedSlowestSyscallTime * 1000.0f,
+		faultbuf,
 		statbuf);
 }
 
@@ -44,6 +44,49 @@ void __DisplayGetVPS(float *out_vps);
 double *__DisplayGetFrameTimes(int *out_valid, int *out_pos, double **out_sleep);
 int DisplayGetSleepPos();
 void DisplayNotifySleep(double t, int pos = -1);
+
+// Where the emu thread's time goes within a frame, collected along with the frame times above.
+// Anything not in a category (or sleeping) counts as emulated CPU time.
+enum class FrameTimeCategory {
+	HLE,
+	GE,
+	FLUSH,
+	TEXTURE,
+	PRESENT,
+	COUNT,
+};
+
+// Time in nested categories only counts for the innermost one.
+bool DisplayFrameTimeEnter(FrameTimeCategory cat);
+void DisplayFrameTimeLeave();
+// Same layout as __DisplayGetFrameTimes().
+double *__DisplayGetFrameBreakdown(FrameTimeCategory cat);
+// Running totals in seconds across frames, until reset.
+void __DisplayGetFrameBreakdownTotals(double totals[(int)FrameTimeCategory::COUNT]);
+void __DisplayResetFrameBreakdownTotals();
+
+struct FrameTimeStats {
+	int frames;
+	double averageMs;
+	// Average of the slowest 1% of frames, reported as "1% low" fps.
+	double slowestPercentMs;
+	double worstMs;
+	// Frames up to 16.7, 20, 25, 33.3, 50, 100 ms, and slower.
+	int histogram[7];
+};
+void __DisplayGetFrameTimeStats(FrameTimeStats *stats);
+
+class FrameTimeScope {
+public:
+	FrameTimeScope(FrameTimeCategory cat) : active_(DisplayFrameTimeEnter(cat)) {}
+	~FrameTimeScope() {
+		if (active_)
+			DisplayFrameTimeLeave();
+	}
+
+private:
+	bool active_;
+};
 bool DisplayIsRunningSlow();
 
 void DisplayFireVblankStart();
@@ -15,6 +15,7 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include "ppsspp_config.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Core/Config.h"
 #include "Core/Debugger/MemBlockInfo.h"
@@ -29,6 +30,18 @@
 
 #include <algorithm>
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif // PPSSPP_ARCH(ARM_NEON)
+
 #ifdef USE_FFMPEG
 
 extern "C" {
@@ -740,12 +753,26 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 // Helpers that null out alpha (which seems to be the case on the PSP.)
 // Some games depend on this, for example Sword Art Online (doesn't clear A's from buffer.)
 inline void writeVideoLineRGBA(void *destp, const void *srcp, int width) {
-	// TODO: Use SSE/NEON, investigate why AV_PIX_FMT_RGB0 does not work.
+	// TODO: Investigate why AV_PIX_FMT_RGB0 does not work.
 	u32_le *dest = (u32_le *)destp;
 	const u32_le *src = (u32_le *)srcp;
 
 	const u32 mask = 0x00FFFFFF;
-	for (int i = 0; i < width; ++i) {
+	int i = 0;
+#if defined(_M_SSE)
+	const __m128i maskx4 = _mm_set1_epi32(mask);
+	for (; i + 4 <= width; i += 4) {
+		__m128i c = _mm_loadu_si128((const __m128i *)&src[i]);
+		_mm_storeu_si128((__m128i *)&dest[i], _mm_and_si128(c, maskx4));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint32x4_t maskx4 = vdupq_n_u32(mask);
+	for (; i + 4 <= width; i += 4) {
+		uint32x4_t c = vld1q_u32((const uint32_t *)&src[i]);
+		vst1q_u32((uint32_t *)&dest[i], vandq_u32(c, maskx4));
+	}
+#endif
+	for (; i < width; ++i) {
 		dest[i] = src[i] & mask;
 	}
 }
@@ -754,26 +781,35 @@ inline void writeVideoLineABGR5650(void *destp, const void *srcp, int width) {
 	memcpy(destp, srcp, width * sizeof(u16));
 }
 
-inline void writeVideoLineABGR5551(void *destp, const void *srcp, int width) {
-	// TODO: Use SSE/NEON.
+inline void writeVideoLine16Masked(void *destp, const void *srcp, int width, u16 mask) {
 	u16_le *dest = (u16_le *)destp;
 	const u16_le *src = (u16_le *)srcp;
 
-	const u16 mask = 0x7FFF;
-	for (int i = 0; i < width; ++i) {
+	int i = 0;
+#if defined(_M_SSE)
+	const __m128i maskx8 = _mm_set1_epi16((short)mask);
+	for (; i + 8 <= width; i += 8) {
+		__m128i c = _mm_loadu_si128((const __m128i *)&src[i]);
+		_mm_storeu_si128((__m128i *)&dest[i], _mm_and_si128(c, maskx8));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t maskx8 = vdupq_n_u16(mask);
+	for (; i + 8 <= width; i += 8) {
+		uint16x8_t c = vld1q_u16((const uint16_t *)&src[i]);
+		vst1q_u16((uint16_t *)&dest[i], vandq_u16(c, maskx8));
+	}
+#endif
+	for (; i < width; ++i) {
 		dest[i] = src[i] & mask;
 	}
 }
 
-inline void writeVideoLineABGR4444(void *destp, const void *srcp, int width) {
-	// TODO: Use SSE/NEON.
-	u16_le *dest = (u16_le *)destp;
-	const u16_le *src = (u16_le *)srcp;
+inline void writeVideoLineABGR5551(void *destp, const void *srcp, int width) {
+	writeVideoLine16Masked(destp, srcp, width, 0x7FFF);
+}
 
-	const u16 mask = 0x0FFF;
-	for (int i = 0; i < width; ++i) {
-		dest[i] = src[i] & mask;
-	}
+inline void writeVideoLineABGR4444(void *destp, const void *srcp, int width) {
+	writeVideoLine16Masked(destp, srcp, width, 0x0FFF);
 }
 
 int MediaEngine::writeVideoImage(u32 bufferPtr, int frameWidth, int videoPixelMode) {
@@ -22,6 +22,7 @@ const int PRIVATE_STREAM_2         = 0x000001bf;
 
 MpegDemux::MpegDemux(int size, int offset) : m_audioStream(size) {
 	m_buf = new u8[size];
+	m_data = m_buf;
 
 	m_len = size;
 	m_index = offset;
@@ -146,7 +147,7 @@ int MpegDemux::demuxStream(bool bdemux, int startCode, int length, int channel)
 		length = readPesHeader(pesHeader, length, startCode);
 		if (pesHeader.channel == channel || channel < 0) {
 			channel = pesHeader.channel;
-			m_audioStream.push(m_buf + m_index, length, pesHeader.pts);
+			m_audioStream.push(m_data + m_index, length, pesHeader.pts);
 		}
 		skip(length);
 	} else {
@@ -187,11 +188,8 @@ bool MpegDemux::skipPackHeader() {
 	return true;
 }
 
-bool MpegDemux::demux(int audioChannel)
+bool MpegDemux::demuxPackets()
 {
-	if (audioChannel >= 0)
-		m_audioChannel = audioChannel;
-
 	bool looksValid = false;
 	bool needMore = false;
 	while (m_index < m_readSize && !needMore)
@@ -240,7 +238,7 @@ bool MpegDemux::demux(int audioChannel)
 			// Audio stream
 			int length = read16();
 			// Check for PES header marker.
-			looksValid = (m_buf[m_index] & 0xC0) == 0x80;
+			looksValid = (m_data[m_index] & 0xC0) == 0x80;
 			if (m_readSize - m_index < length) {
 				m_index -= 4 + 2;
 				needMore = true;
@@ -257,7 +255,7 @@ bool MpegDemux::demux(int audioChannel)
 			// Video Stream
 			int length = read16();
 			// Check for PES header marker.
-			looksValid = (m_buf[m_index] & 0xC0) == 0x80;
+			looksValid = (m_data[m_index] & 0xC0) == 0x80;
 			if (m_readSize - m_index < length) {
 				m_index -= 4 + 2;
 				needMore = true;
@@ -275,6 +273,15 @@ bool MpegDemux::demux(int audioChannel)
 			break;
 		}
 	}
+	return looksValid;
+}
+
+bool MpegDemux::demux(int audioChannel)
+{
+	if (audioChannel >= 0)
+		m_audioChannel = audioChannel;
+
+	bool looksValid = demuxPackets();
 	if (m_index < m_readSize) {
 		int size = m_readSize - m_index;
 		memmove(m_buf, m_buf + m_index, size);
@@ -288,6 +295,44 @@ bool MpegDemux::demux(int audioChannel)
 	return looksValid;
 }
 
+bool MpegDemux::addStreamDataAndDemux(const u8 *buf, int addSize, int audioChannel)
+{
+	if (m_index < m_readSize) {
+		// Part of a packet is still pending, so it has to be joined with the new data.
+		if (!addStreamData(buf, addSize))
+			return false;
+		return demux(audioChannel);
+	}
+
+	if (audioChannel >= 0)
+		m_audioChannel = audioChannel;
+
+	// Anything pending in m_buf was skipped, and we might still need to skip more.
+	int skipSize = m_index - m_readSize;
+	if (skipSize >= addSize) {
+		m_index = skipSize - addSize;
+		m_readSize = 0;
+		return false;
+	}
+
+	m_data = buf;
+	m_index = skipSize;
+	m_readSize = addSize;
+	bool looksValid = demuxPackets();
+	m_data = m_buf;
+
+	int remaining = m_readSize - m_index;
+	if (remaining > 0 && remaining <= m_len) {
+		memcpy(m_buf, buf + m_index, remaining);
+		m_readSize = remaining;
+	} else {
+		m_readSize = 0;
+	}
+	m_index = 0;
+
+	return looksValid;
+}
+
 static bool isHeader(const u8 *audioStream, int offset)
 {
 	const u8 header1 = (u8)0x0F;
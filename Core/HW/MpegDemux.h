@@ -16,6 +16,9 @@ class MpegDemux
 
 	bool addStreamData(const u8 *buf, int addSize);
 	bool demux(int audioChannel);
+	// Same as addStreamData() + demux(), but parses buf in place when nothing is pending.
+	// Only an incomplete packet at the end gets copied.  buf doesn't need to outlive the call.
+	bool addStreamDataAndDemux(const u8 *buf, int addSize, int audioChannel);
 
 	// return its framesize
 	int getNextAudioFrame(u8 **buf, int *headerCode1, int *headerCode2, s64 *pts = NULL);
@@ -41,7 +44,7 @@ class MpegDemux
 	};
 
 	int read8() {
-		return m_buf[m_index++];
+		return m_data[m_index++];
 	}
 	int read16() {
 		return (read8() << 8) | read8();
@@ -66,10 +69,13 @@ class MpegDemux
 	int readPesHeader(PesHeader &pesHeader, int length, int startCode);
 	int demuxStream(bool bdemux, int startCode, int length, int channel);
 	bool skipPackHeader();
+	bool demuxPackets();
 
 	int m_index;
 	int m_len;
 	u8 *m_buf;
+	// What m_index and m_readSize refer to.  Normally m_buf, but see addStreamDataAndDemux().
+	const u8 *m_data;
 	BufferQueue m_audioStream;
 	u8  m_audioFrame[0x2000];
 	int m_audioChannel;
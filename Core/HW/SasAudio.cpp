@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <cstring>
 
 #include "Common/Profiler/Profiler.h"
 
@@ -28,6 +29,18 @@
 #include "Core/Core.h"
 #include "SasAudio.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 // #define AUDIO_TO_FILE
 
 static const u8 f[16][2] = {
@@ -65,6 +78,48 @@ void VagDecoder::Start(u32 data, u32 vagSize, bool loopEnabled) {
 	s_2 = 0;
 }
 
+// Expands the 14 data bytes of a VAG block into 28 shifted samples, low nibble first.
+// Writes 32 samples, the last 4 are garbage.
+static void UnpackVagNibbles(s16 *out, const u8 *in, int shift_factor) {
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	// Don't read past the block, it may be the last one in memory.
+	alignas(16) u8 data[16]{};
+	memcpy(data, in, 14);
+#endif
+
+#ifdef _M_SSE
+	const __m128i mask = _mm_set1_epi8((char)0xF0);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i d = _mm_load_si128((const __m128i *)data);
+	__m128i lo = _mm_and_si128(_mm_slli_epi16(d, 4), mask);
+	__m128i hi = _mm_and_si128(d, mask);
+	// Interleave, then put each nibble in the top of a 16-bit lane.
+	__m128i pairs1 = _mm_unpacklo_epi8(lo, hi);
+	__m128i pairs2 = _mm_unpackhi_epi8(lo, hi);
+	const __m128i shift = _mm_cvtsi32_si128(shift_factor);
+	_mm_store_si128((__m128i *)out + 0, _mm_sra_epi16(_mm_unpacklo_epi8(zero, pairs1), shift));
+	_mm_store_si128((__m128i *)out + 1, _mm_sra_epi16(_mm_unpackhi_epi8(zero, pairs1), shift));
+	_mm_store_si128((__m128i *)out + 2, _mm_sra_epi16(_mm_unpacklo_epi8(zero, pairs2), shift));
+	_mm_store_si128((__m128i *)out + 3, _mm_sra_epi16(_mm_unpackhi_epi8(zero, pairs2), shift));
+#elif PPSSPP_ARCH(ARM_NEON)
+	uint8x16_t d = vld1q_u8(data);
+	uint8x16_t lo = vshlq_n_u8(d, 4);
+	uint8x16_t hi = vandq_u8(d, vdupq_n_u8(0xF0));
+	uint8x16x2_t pairs = vzipq_u8(lo, hi);
+	const int16x8_t shift = vdupq_n_s16(-shift_factor);
+	vst1q_s16(out + 0, vshlq_s16(vreinterpretq_s16_u16(vshll_n_u8(vget_low_u8(pairs.val[0]), 8)), shift));
+	vst1q_s16(out + 8, vshlq_s16(vreinterpretq_s16_u16(vshll_n_u8(vget_high_u8(pairs.val[0]), 8)), shift));
+	vst1q_s16(out + 16, vshlq_s16(vreinterpretq_s16_u16(vshll_n_u8(vget_low_u8(pairs.val[1]), 8)), shift));
+	vst1q_s16(out + 24, vshlq_s16(vreinterpretq_s16_u16(vshll_n_u8(vget_high_u8(pairs.val[1]), 8)), shift));
+#else
+	for (int i = 0; i < 28; i += 2) {
+		u8 d = *in++;
+		out[i] = (short)((d & 0xf) << 12) >> shift_factor;
+		out[i + 1] = (short)((d & 0xf0) << 8) >> shift_factor;
+	}
+#endif
+}
+
 void VagDecoder::DecodeBlock(const u8 *&read_pointer) {
 	if (curBlock_ == numBlocks_ - 1) {
 		end_ = true;
@@ -97,13 +152,14 @@ void VagDecoder::DecodeBlock(const u8 *&read_pointer) {
 	int coef1 = f[predict_nr][0];
 	int coef2 = -f[predict_nr][1];
 
-	// TODO: Unroll once more and interleave the unpacking with the decoding more?
+	// The prediction is a recurrence, but the nibbles can be unpacked up front.
+	alignas(16) s16 nibbles[32];
+	UnpackVagNibbles(nibbles, readp, shift_factor);
+	readp += 14;
+
 	for (int i = 0; i < 28; i += 2) {
-		u8 d = *readp++;
-		int sample1 = (short)((d & 0xf) << 12) >> shift_factor;
-		int sample2 = (short)((d & 0xf0) << 8) >> shift_factor;
-		s2 = clamp_s16(sample1 + ((s1 * coef1 + s2 * coef2) >> 6));
-		s1 = clamp_s16(sample2 + ((s2 * coef1 + s1 * coef2) >> 6));
+		s2 = clamp_s16(nibbles[i] + ((s1 * coef1 + s2 * coef2) >> 6));
+		s1 = clamp_s16(nibbles[i + 1] + ((s2 * coef1 + s1 * coef2) >> 6));
 		samples[i] = s2;
 		samples[i + 1] = s1;
 	}
@@ -571,15 +627,16 @@ void SasInstance::MixVoice(SasVoice &voice) {
 
 			// We just scale by the envelope before we scale by volumes.
 			// Again, we round up by adding (1 << 14) first (*after* multiplying.)
-			sample = ((sample * envelopeValue) + (1 << 14)) >> 15;
-
-			// We mix into this 32-bit temp buffer and clip in a second loop
-			// Ideally, the shift right should be there too but for now I'm concerned about
-			// not overflowing.
-			mixBuffer[i * 2] += (sample * voice.volumeLeft) >> 12;
-			mixBuffer[i * 2 + 1] += (sample * voice.volumeRight) >> 12;
-			sendBuffer[i * 2] += sample * voice.effectLeft >> 12;
-			sendBuffer[i * 2 + 1] += sample * voice.effectRight >> 12;
+			// The envelope is at most 0x8000 here, so this still fits in 16 bits.
+			voiceTemp_[i] = ((sample * envelopeValue) + (1 << 14)) >> 15;
+		}
+
+		// We mix into this 32-bit temp buffer and clip in a second loop
+		// Ideally, the shift right should be there too but for now I'm concerned about
+		// not overflowing.
+		if (grainSize > delay) {
+			AccumulateStereoVolume12(mixBuffer + delay * 2, voiceTemp_ + delay, grainSize - delay, voice.volumeLeft, voice.volumeRight);
+			AccumulateStereoVolume12(sendBuffer + delay * 2, voiceTemp_ + delay, grainSize - delay, voice.effectLeft, voice.effectRight);
 		}
 
 		voice.resampleHist[0] = mixTemp_[tempPos - 2];
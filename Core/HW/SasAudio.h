@@ -317,4 +317,5 @@ class SasInstance {
 	SasReverb reverb_;
 	int grainSize = 0;
 	int16_t mixTemp_[PSP_SAS_MAX_GRAIN * 4 + 2 + 8];  // some extra margin for very high pitches.
+	int16_t voiceTemp_[PSP_SAS_MAX_GRAIN];  // resampled and enveloped, before volume.
 };
@@ -15,6 +15,7 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 
@@ -23,6 +24,18 @@
 #include "Core/HW/SasReverb.h"
 #include "Core/Util/AudioFormat.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 // This is under the assumption that the reverb used in Sas is the same as the PSX SPU reverb.
 
 // Source: http://problemkaputt.de/psx-spx.htm#spureverbformula
@@ -174,11 +187,75 @@ void SasReverb::SetPreset(int preset) {
 	if (preset_ != -1) {
 		pos_ = BUFSIZE - presets[preset_].size;
 		memset(workspace_, 0, sizeof(int16_t) * BUFSIZE);
+		blockSize_ = CalculateBlockSize(presets[preset_]);
 	} else {
 		pos_ = 0;
+		blockSize_ = 1;
 	}
 }
 
+// The block path runs each stage of the filter for a whole block of samples before moving on to
+// the next stage, instead of all stages per sample. That only gives the same result if no buffer
+// position touched by one stage is written by another within the block, which depends on the
+// tap offsets of the preset. So we just try it out on the offsets.
+int SasReverb::CalculateBlockSize(const SasReverbData &d) {
+	struct Access {
+		int stage;
+		int offset;
+		bool write;
+	};
+	// In the order the per-sample loop does them.
+	// Stage 0 (the reflections) stays a per-sample loop, the others are run per block: all reads
+	// first, then the writes one tap at a time.
+	const Access accesses[] = {
+		{ 0, d.dLSAME, false }, { 0, d.mLSAME - 1, false }, { 0, d.mLSAME, true },
+		{ 0, d.dRSAME, false }, { 0, d.mRSAME - 1, false }, { 0, d.mRSAME, true },
+		{ 0, d.dRDIFF, false }, { 0, d.mLDIFF - 1, false }, { 0, d.mLDIFF, true },
+		{ 0, d.dLDIFF, false }, { 0, d.mRDIFF - 1, false }, { 0, d.mRDIFF, true },
+		{ 1, d.mLCOMB1, false }, { 1, d.mLCOMB2, false }, { 1, d.mLCOMB3, false }, { 1, d.mLCOMB4, false },
+		{ 1, d.mRCOMB1, false }, { 1, d.mRCOMB2, false }, { 1, d.mRCOMB3, false }, { 1, d.mRCOMB4, false },
+		{ 2, d.mLAPF1 - d.dAPF1, false }, { 2, d.mLAPF1, true }, { 2, d.mRAPF1 - d.dAPF1, false }, { 2, d.mRAPF1, true },
+		{ 3, d.mLAPF2 - d.dAPF2, false }, { 3, d.mLAPF2, true }, { 3, d.mRAPF2 - d.dAPF2, false }, { 3, d.mRAPF2, true },
+	};
+	const int numAccesses = (int)ARRAY_SIZE(accesses);
+
+	auto conflicts = [&](int blockSize) {
+		for (int xi = 0; xi < numAccesses; ++xi) {
+			for (int yi = xi + 1; yi < numAccesses; ++yi) {
+				const Access &x = accesses[xi];
+				const Access &y = accesses[yi];
+				if (!x.write && !y.write)
+					continue;
+				// Access x at sample 0 hits the same spot as y at sample j.
+				int j = x.offset - y.offset;
+				if (j <= -blockSize || j >= blockSize)
+					continue;
+
+				// xi < yi, so within a sample x goes first.
+				bool perSample = j >= 0;
+				bool perBlock;
+				if (x.stage != y.stage) {
+					perBlock = x.stage < y.stage;
+				} else if (x.stage == 0) {
+					perBlock = perSample;
+				} else if (x.write != y.write) {
+					perBlock = !x.write;
+				} else {
+					perBlock = true;
+				}
+				if (perSample != perBlock)
+					return true;
+			}
+		}
+		return false;
+	};
+
+	int blockSize = MAX_BLOCK;
+	while (blockSize > 1 && conflicts(blockSize))
+		blockSize /= 2;
+	return blockSize;
+}
+
 // Wraps around the upper part of a buffer.
 template<int bufsize>
 class BufferWrapper {
@@ -198,8 +275,34 @@ class BufferWrapper {
 			pos_ -= size_;
 		}
 	}
+	void Advance(int count) {
+		pos_ += count;
+		if (pos_ >= end_) {
+			pos_ -= size_;
+		}
+	}
+
+	// Copies count consecutive samples starting at index, taking care of the wrap.
+	void Gather(int16_t *dst, int index, int count) {
+		int addr = Wrap(pos_ + index);
+		int first = std::min(count, end_ - addr);
+		memcpy(dst, buf_ + addr, first * sizeof(int16_t));
+		memcpy(dst + first, buf_ + base_, (count - first) * sizeof(int16_t));
+	}
+	void Scatter(int index, const int16_t *src, int count) {
+		int addr = Wrap(pos_ + index);
+		int first = std::min(count, end_ - addr);
+		memcpy(buf_ + addr, src, first * sizeof(int16_t));
+		memcpy(buf_ + base_, src + first, (count - first) * sizeof(int16_t));
+	}
 
 private:
+	int Wrap(int addr) {
+		if (addr >= end_) { addr -= size_; }
+		if (addr < base_) { addr += size_; }
+		return addr;
+	}
+
 	int16_t *buf_;
 	int pos_;
 	int end_;
@@ -207,6 +310,139 @@ class BufferWrapper {
 	int size_;
 };
 
+// out[i] = (c1 * t1[i] + c2 * t2[i] + c3 * t3[i] + c4 * t4[i]) >> 15
+static void ReverbComb(int32_t *out, const int16_t *t1, const int16_t *t2, const int16_t *t3, const int16_t *t4, int16_t c1, int16_t c2, int16_t c3, int16_t c4, int count) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i c12 = _mm_set_epi16(c2, c1, c2, c1, c2, c1, c2, c1);
+	const __m128i c34 = _mm_set_epi16(c4, c3, c4, c3, c4, c3, c4, c3);
+	for (; i + 8 <= count; i += 8) {
+		__m128i v1 = _mm_loadu_si128((const __m128i *)(t1 + i));
+		__m128i v2 = _mm_loadu_si128((const __m128i *)(t2 + i));
+		__m128i v3 = _mm_loadu_si128((const __m128i *)(t3 + i));
+		__m128i v4 = _mm_loadu_si128((const __m128i *)(t4 + i));
+		__m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(v1, v2), c12), _mm_madd_epi16(_mm_unpacklo_epi16(v3, v4), c34));
+		__m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(v1, v2), c12), _mm_madd_epi16(_mm_unpackhi_epi16(v3, v4), c34));
+		_mm_storeu_si128((__m128i *)(out + i), _mm_srai_epi32(lo, 15));
+		_mm_storeu_si128((__m128i *)(out + i + 4), _mm_srai_epi32(hi, 15));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 4 <= count; i += 4) {
+		int32x4_t sum = vmull_n_s16(vld1_s16(t1 + i), c1);
+		sum = vmlal_n_s16(sum, vld1_s16(t2 + i), c2);
+		sum = vmlal_n_s16(sum, vld1_s16(t3 + i), c3);
+		sum = vmlal_n_s16(sum, vld1_s16(t4 + i), c4);
+		vst1q_s32(out + i, vshrq_n_s32(sum, 15));
+	}
+#endif
+	for (; i < count; ++i) {
+		out[i] = (c1 * t1[i] + c2 * t2[i] + c3 * t3[i] + c4 * t4[i]) >> 15;
+	}
+}
+
+// One all-pass filter: w[i] = clamp_s16(io[i] - (v * t[i] >> 15)), then io[i] = t[i] + (w[i] * v >> 15).
+static void ReverbAllPass(int32_t *io, int16_t *w, const int16_t *t, int16_t v, int count) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i vv = _mm_set1_epi16(v);
+	for (; i + 8 <= count; i += 8) {
+		__m128i tv = _mm_loadu_si128((const __m128i *)(t + i));
+		__m128i plo = _mm_mullo_epi16(tv, vv);
+		__m128i phi = _mm_mulhi_epi16(tv, vv);
+		__m128i in1 = _mm_loadu_si128((const __m128i *)(io + i));
+		__m128i in2 = _mm_loadu_si128((const __m128i *)(io + i + 4));
+		__m128i d1 = _mm_sub_epi32(in1, _mm_srai_epi32(_mm_unpacklo_epi16(plo, phi), 15));
+		__m128i d2 = _mm_sub_epi32(in2, _mm_srai_epi32(_mm_unpackhi_epi16(plo, phi), 15));
+		// Saturating pack is exactly clamp_s16.
+		__m128i wv = _mm_packs_epi32(d1, d2);
+		_mm_storeu_si128((__m128i *)(w + i), wv);
+
+		__m128i qlo = _mm_mullo_epi16(wv, vv);
+		__m128i qhi = _mm_mulhi_epi16(wv, vv);
+		__m128i t1 = _mm_srai_epi32(_mm_unpacklo_epi16(tv, tv), 16);
+		__m128i t2 = _mm_srai_epi32(_mm_unpackhi_epi16(tv, tv), 16);
+		_mm_storeu_si128((__m128i *)(io + i), _mm_add_epi32(t1, _mm_srai_epi32(_mm_unpacklo_epi16(qlo, qhi), 15)));
+		_mm_storeu_si128((__m128i *)(io + i + 4), _mm_add_epi32(t2, _mm_srai_epi32(_mm_unpackhi_epi16(qlo, qhi), 15)));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 4 <= count; i += 4) {
+		int16x4_t tv = vld1_s16(t + i);
+		int32x4_t diff = vsubq_s32(vld1q_s32(io + i), vshrq_n_s32(vmull_n_s16(tv, v), 15));
+		int16x4_t wv = vqmovn_s32(diff);
+		vst1_s16(w + i, wv);
+		vst1q_s32(io + i, vaddq_s32(vmovl_s16(tv), vshrq_n_s32(vmull_n_s16(wv, v), 15)));
+	}
+#endif
+	for (; i < count; ++i) {
+		w[i] = clamp_s16(io[i] - (v * t[i] >> 15));
+		io[i] = t[i] + (w[i] * v >> 15);
+	}
+}
+
+void SasReverb::ProcessReverbBlocks(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight, uint8_t finalShift) {
+	const SasReverbData &d = presets[preset_];
+	BufferWrapper<BUFSIZE> b(workspace_, pos_, d.size);
+
+	int16_t taps[8][MAX_BLOCK];
+	int16_t written[2][MAX_BLOCK];
+	int32_t Lout[MAX_BLOCK];
+	int32_t Rout[MAX_BLOCK];
+
+	for (size_t start = 0; start < inputSize; start += blockSize_) {
+		const int count = (int)std::min(inputSize - start, (size_t)blockSize_);
+		const int16_t *in = input + start * 2;
+
+		// The reflections feed back on the previous sample, so they stay one at a time.
+		for (int i = 0; i < count; ++i) {
+			int16_t Lin = in[i * 2] >> 1;
+			int16_t Rin = in[i * 2 + 1] >> 1;
+			b[d.mLSAME + i] = clamp_s16(Lin + (b[d.dLSAME + i] * d.vWALL >> 15) - (b[d.mLSAME - 1 + i]*d.vIIR >> 15) + b[d.mLSAME - 1 + i]);
+			b[d.mRSAME + i] = clamp_s16(Rin + (b[d.dRSAME + i] * d.vWALL >> 15) - (b[d.mRSAME - 1 + i]*d.vIIR >> 15) + b[d.mRSAME - 1 + i]);
+			b[d.mLDIFF + i] = clamp_s16(Lin + (b[d.dRDIFF + i] * d.vWALL >> 15) - (b[d.mLDIFF - 1 + i]*d.vIIR >> 15) + b[d.mLDIFF - 1 + i]);
+			b[d.mRDIFF + i] = clamp_s16(Rin + (b[d.dLDIFF + i] * d.vWALL >> 15) - (b[d.mRDIFF - 1 + i]*d.vIIR >> 15) + b[d.mRDIFF - 1 + i]);
+		}
+
+		// Early echo.
+		b.Gather(taps[0], d.mLCOMB1, count);
+		b.Gather(taps[1], d.mLCOMB2, count);
+		b.Gather(taps[2], d.mLCOMB3, count);
+		b.Gather(taps[3], d.mLCOMB4, count);
+		b.Gather(taps[4], d.mRCOMB1, count);
+		b.Gather(taps[5], d.mRCOMB2, count);
+		b.Gather(taps[6], d.mRCOMB3, count);
+		b.Gather(taps[7], d.mRCOMB4, count);
+		ReverbComb(Lout, taps[0], taps[1], taps[2], taps[3], d.vCOMB1, d.vCOMB2, d.vCOMB3, d.vCOMB4, count);
+		ReverbComb(Rout, taps[4], taps[5], taps[6], taps[7], d.vCOMB1, d.vCOMB2, d.vCOMB3, d.vCOMB4, count);
+
+		// Late reverb, APF1 then APF2.
+		b.Gather(taps[0], d.mLAPF1 - d.dAPF1, count);
+		b.Gather(taps[1], d.mRAPF1 - d.dAPF1, count);
+		ReverbAllPass(Lout, written[0], taps[0], d.vAPF1, count);
+		ReverbAllPass(Rout, written[1], taps[1], d.vAPF1, count);
+		b.Scatter(d.mLAPF1, written[0], count);
+		b.Scatter(d.mRAPF1, written[1], count);
+
+		b.Gather(taps[0], d.mLAPF2 - d.dAPF2, count);
+		b.Gather(taps[1], d.mRAPF2 - d.dAPF2, count);
+		ReverbAllPass(Lout, written[0], taps[0], d.vAPF2, count);
+		ReverbAllPass(Rout, written[1], taps[1], d.vAPF2, count);
+		b.Scatter(d.mLAPF2, written[0], count);
+		b.Scatter(d.mRAPF2, written[1], count);
+
+		int16_t *out = output + start * 4;
+		for (int i = 0; i < count; ++i) {
+			out[i * 4 + 0] = clamp_s16((Lout[i] * volLeft) >> finalShift);
+			out[i * 4 + 1] = clamp_s16((Rout[i] * volRight) >> finalShift);
+			out[i * 4 + 2] = 0;
+			out[i * 4 + 3] = 0;
+		}
+
+		b.Advance(count);
+	}
+
+	pos_ = b.GetPosition();
+}
+
 void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight) {
 	// This means replicate the input signal in the processed buffer.
 	// Can also be used to verify that the error is in here...
@@ -230,6 +466,11 @@ void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inpu
 		return;
 	}
 
+	if (useBlocks_ && blockSize_ > 1) {
+		ProcessReverbBlocks(output, input, inputSize, volLeft, volRight, finalShift);
+		return;
+	}
+
 	const SasReverbData &d = presets[preset_];
 
 	// We put this on the stack instead of in the object to let the compiler optimize better (avoid mem r/w).
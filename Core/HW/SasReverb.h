@@ -33,12 +33,22 @@ class SasReverb {
 	// Output is written back at 44khz.
 	void ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight);
 
+	// Forces the plain per-sample loop, for comparisons. Output is identical either way.
+	void SetUseBlocks(bool enable) { useBlocks_ = enable; }
+
 private:
 	enum {
 		BUFSIZE = 0x20000,
+		MAX_BLOCK = 32,
 	};
 
+	void ProcessReverbBlocks(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight, uint8_t finalShift);
+	static int CalculateBlockSize(const SasReverbData &d);
+
 	int16_t *workspace_;
 	int preset_;
 	int pos_;
+	// How many samples can be run through each filter stage at once without changing the result.
+	int blockSize_ = 1;
+	bool useBlocks_ = true;
 };
\ No newline at end of file
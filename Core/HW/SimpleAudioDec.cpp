@@ -18,6 +18,8 @@
 #include <algorithm>
 
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/Thread/Waitable.h"
 #include "Core/Config.h"
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/HLE/FunctionWrappers.h"
@@ -277,6 +279,13 @@ bool SimpleAudio::Decode(const uint8_t *inbuf, int inbytes, uint8_t *outbuf, int
 #endif  // USE_FFMPEG
 }
 
+void SimpleAudio::Flush() {
+#ifdef USE_FFMPEG
+	if (codecOpen_)
+		avcodec_flush_buffers(codecCtx_);
+#endif  // USE_FFMPEG
+}
+
 int SimpleAudio::GetOutSamples() {
 	return outSamples;
 }
@@ -315,10 +324,59 @@ bool IsValidCodec(int codec){
 
 // sceAu module starts from here
 
+// Enough for a 1152 sample stereo frame, with room to spare if resampled upwards.
+static const int DECODE_AHEAD_PCM_BYTES = 1152 * 2 * 2 * 2;
+
+class AuDecodeAheadTask : public Task {
+public:
+	AuDecodeAheadTask(SimpleAudio *decoder, AuDecodeAhead *ahead, LimitedWaitable *waitable)
+		: decoder_(decoder), ahead_(ahead), waitable_(waitable) {}
+
+	TaskType Type() const override { return TaskType::CPU_COMPUTE; }
+	TaskPriority Priority() const override { return TaskPriority::HIGH; }
+
+	void Run() override {
+		ahead_->pcmBytes = 0;
+		decoder_->Decode(ahead_->input.data(), (int)ahead_->input.size(), ahead_->pcm.data(), &ahead_->pcmBytes);
+		waitable_->Notify();
+	}
+
+private:
+	SimpleAudio *decoder_;
+	AuDecodeAhead *ahead_;
+	LimitedWaitable *waitable_;
+};
+
+// Returns the size of the layer 3 frame starting at header, or 0 if it's not one we can size.
+static int Mp3FrameSize(const u8 *header, size_t avail) {
+	static const int bitrates[2][16] = {
+		{ 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 },
+		{ 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+	};
+	static const int sampleRates[3] = { 44100, 48000, 32000 };
+
+	if (avail < 4 || header[0] != 0xFF || (header[1] & 0xE0) != 0xE0)
+		return 0;
+	int version = (header[1] >> 3) & 3;
+	int layer = (header[1] >> 1) & 3;
+	int bitrateIndex = header[2] >> 4;
+	int rateIndex = (header[2] >> 2) & 3;
+	int padding = (header[2] >> 1) & 1;
+	// Version 1 is reserved, and we only size layer 3 (value 1.)  Free format has no fixed size.
+	if (version == 1 || layer != 1 || rateIndex == 3 || bitrates[0][bitrateIndex] == 0)
+		return 0;
+
+	bool mpeg1 = version == 3;
+	int sampleRate = sampleRates[rateIndex] >> (mpeg1 ? 0 : (version == 2 ? 1 : 2));
+	int bitrate = bitrates[mpeg1 ? 0 : 1][bitrateIndex] * 1000;
+	return (mpeg1 ? 144 : 72) * bitrate / sampleRate + padding;
+}
+
 AuCtx::AuCtx() {
 }
 
 AuCtx::~AuCtx() {
+	CancelDecodeAhead();
 	if (decoder) {
 		AudioClose(&decoder);
 		decoder = nullptr;
@@ -338,6 +396,56 @@ size_t AuCtx::FindNextMp3Sync() {
 	return 0;
 }
 
+// Decodes the next frame on a worker, so AuDecode() only copies the result.
+// Since the decoder carries state between frames, this only starts when the frame is complete,
+// and FinishDecodeAhead() verifies it was still the right one.
+void AuCtx::StartDecodeAhead() {
+	if (!g_Config.bAudioDecodeAhead || aheadWaitable_ || !decoder || audioType != PSP_CODEC_MP3)
+		return;
+	if (sourcebuff.size() < 4 || !g_threadManager.IsInitialized())
+		return;
+	// Without a valid output buffer, AuDecode() wouldn't produce samples at all.
+	if (!Memory::IsValidRange(PCMBuf, PCMBufSize))
+		return;
+
+	size_t nextSync = FindNextMp3Sync();
+	int frameSize = Mp3FrameSize(&sourcebuff[nextSync], sourcebuff.size() - nextSync);
+	if (frameSize == 0 || nextSync + frameSize > sourcebuff.size())
+		return;
+
+	ahead_.input.assign(sourcebuff.begin() + nextSync, sourcebuff.begin() + nextSync + frameSize);
+	ahead_.pcm.resize(DECODE_AHEAD_PCM_BYTES);
+	aheadWaitable_ = new LimitedWaitable();
+	g_threadManager.EnqueueTask(new AuDecodeAheadTask(decoder, &ahead_, aheadWaitable_));
+}
+
+bool AuCtx::FinishDecodeAhead(const u8 *inbuf, int inbytes, u8 *outbuf, int *outbytes) {
+	if (!aheadWaitable_)
+		return false;
+	aheadWaitable_->WaitAndRelease();
+	aheadWaitable_ = nullptr;
+
+	if ((int)ahead_.input.size() != inbytes || memcmp(ahead_.input.data(), inbuf, inbytes) != 0) {
+		// The stream moved since, so the decoder has already seen a frame it shouldn't have.
+		decoder->Flush();
+		return false;
+	}
+
+	*outbytes = ahead_.pcmBytes;
+	if (outbuf != nullptr && ahead_.pcmBytes > 0)
+		memcpy(outbuf, ahead_.pcm.data(), ahead_.pcmBytes);
+	return true;
+}
+
+void AuCtx::CancelDecodeAhead() {
+	if (!aheadWaitable_)
+		return;
+	aheadWaitable_->WaitAndRelease();
+	aheadWaitable_ = nullptr;
+	if (decoder)
+		decoder->Flush();
+}
+
 // return output pcm size, <0 error
 u32 AuCtx::AuDecode(u32 pcmAddr) {
 	u32 outptr = PCMBuf + nextOutputHalf * PCMBufSize / 2;
@@ -351,7 +459,15 @@ u32 AuCtx::AuDecode(u32 pcmAddr) {
 	if (!sourcebuff.empty()) {
 		// FFmpeg doesn't seem to search for a sync for us, so let's do that.
 		int nextSync = (int)FindNextMp3Sync();
-		decoder->Decode(&sourcebuff[nextSync], (int)sourcebuff.size() - nextSync, outbuf, &outpcmbufsize);
+		int inbytes = (int)sourcebuff.size() - nextSync;
+		if (g_Config.bAudioDecodeAhead) {
+			// Give the decoder exactly one frame, so a decode ahead sees the same input.
+			int frameSize = Mp3FrameSize(&sourcebuff[nextSync], inbytes);
+			if (frameSize != 0 && frameSize < inbytes)
+				inbytes = frameSize;
+		}
+		if (!FinishDecodeAhead(&sourcebuff[nextSync], inbytes, outbuf, &outpcmbufsize))
+			decoder->Decode(&sourcebuff[nextSync], inbytes, outbuf, &outpcmbufsize);
 
 		if (outpcmbufsize == 0) {
 			// Nothing was output, hopefully we're at the end of the stream.
@@ -395,6 +511,7 @@ u32 AuCtx::AuDecode(u32 pcmAddr) {
 		NotifyMemInfo(MemBlockFlags::WRITE, outptr, outpcmbufsize, "AuDecode");
 
 	nextOutputHalf ^= 1;
+	StartDecodeAhead();
 	return outpcmbufsize;
 }
 
@@ -460,6 +577,8 @@ u32 AuCtx::AuNotifyAddStreamData(int size) {
 	if (Memory::IsValidRange(AuBuf, size)) {
 		sourcebuff.resize(sourcebuff.size() + size);
 		Memory::MemcpyUnchecked(&sourcebuff[sourcebuff.size() - size], AuBuf + offset, size);
+		// Data is only ever appended here, so this can't change a frame already decoded ahead.
+		StartDecodeAhead();
 	}
 
 	return 0;
@@ -502,6 +621,7 @@ u32 AuCtx::AuResetPlayPositionByFrame(int frame) {
 		readPos -= 1;
 	SumDecodedSamples = frame * MaxOutputSample;
 	AuBufAvailable = 0;
+	CancelDecodeAhead();
 	sourcebuff.clear();
 	return 0;
 }
@@ -510,6 +630,7 @@ u32 AuCtx::AuResetPlayPosition() {
 	readPos = startPos;
 	SumDecodedSamples = 0;
 	AuBufAvailable = 0;
+	CancelDecodeAhead();
 	sourcebuff.clear();
 	return 0;
 }
@@ -519,6 +640,10 @@ void AuCtx::DoState(PointerWrap &p) {
 	if (!s)
 		return;
 
+	// The decoder itself isn't saved, but it's about to be replaced.
+	if (p.mode == p.MODE_READ)
+		CancelDecodeAhead();
+
 	Do(p, startPos);
 	Do(p, endPos);
 	Do(p, AuBuf);
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <cmath>
+#include <vector>
 
 #include "Core/HW/MediaEngine.h"
 #include "Core/HLE/sceAudio.h"
@@ -26,6 +27,7 @@ struct AVFrame;
 struct AVCodec;
 struct AVCodecContext;
 struct SwrContext;
+class LimitedWaitable;
 
 // Wraps FFMPEG for audio decoding in a nice interface.
 // Decodes packet by packet - does NOT demux.
@@ -47,6 +49,8 @@ class SimpleAudio {
 
 	bool Decode(const uint8_t* inbuf, int inbytes, uint8_t *outbuf, int *outbytes);
 	bool IsOK() const;
+	// Drops any state carried between frames, like the MP3 bit reservoir.
+	void Flush();
 
 	int GetOutSamples();
 	int GetSourcePos();
@@ -89,6 +93,13 @@ void AudioClose(SimpleAudio **ctx);
 const char *GetCodecName(int codec);  // audioType
 bool IsValidCodec(int codec);
 
+// The frame decoded early by AuCtx, while the game is busy with something else.
+struct AuDecodeAhead {
+	std::vector<u8> input;  // The exact source bytes given to the decoder.
+	std::vector<u8> pcm;
+	int pcmBytes = 0;
+};
+
 class AuCtx {
 public:
 	AuCtx();
@@ -124,8 +135,10 @@ class AuCtx {
 		if (amount > (int)sourcebuff.size()) {
 			amount = (int)sourcebuff.size();
 		}
-		if (amount > 0)
+		if (amount > 0) {
+			CancelDecodeAhead();
 			sourcebuff.erase(sourcebuff.begin(), sourcebuff.begin() + amount);
+		}
 		AuBufAvailable -= amount;
 	}
 	// Au source information. Written to from for example sceAacInit so public for now.
@@ -156,6 +169,10 @@ class AuCtx {
 private:
 	size_t FindNextMp3Sync();
 
+	void StartDecodeAhead();
+	bool FinishDecodeAhead(const u8 *inbuf, int inbytes, u8 *outbuf, int *outbytes);
+	void CancelDecodeAhead();
+
 	std::vector<u8> sourcebuff; // source buffer
 
 	// buffers informations
@@ -163,6 +180,10 @@ class AuCtx {
 	int readPos; // read position in audio source file
 	int askedReadSize = 0; // the size of data requied to be read from file by the game
 	int nextOutputHalf = 0;
+
+	// Non-null while a decode ahead is running or its result is unused. Not save stated.
+	LimitedWaitable *aheadWaitable_ = nullptr;
+	AuDecodeAhead ahead_;
 };
 
 
@@ -33,12 +33,16 @@
 #define CONTROL_AVG     32.0f
 
 #include "ppsspp_config.h"
-#include <cstring>
+#include <algorithm>
 #include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 #include "Common/Common.h"
 #include "Common/System/System.h"
 #include "Common/Math/math_util.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Log.h"
 #include "Common/TimeUtil.h"
@@ -86,20 +90,40 @@ StereoResampler::~StereoResampler() {
 }
 
 void StereoResampler::UpdateBufferSize() {
+	int maxBufsize;
+	int targetBufsize;
 	if (g_Config.bExtraAudioBuffering) {
-		m_maxBufsize = MAX_BUFSIZE_EXTRA;
-		m_targetBufsize = TARGET_BUFSIZE_EXTRA;
+		maxBufsize = MAX_BUFSIZE_EXTRA;
+		targetBufsize = TARGET_BUFSIZE_EXTRA;
 	} else {
-		m_maxBufsize = MAX_BUFSIZE_DEFAULT;
-		m_targetBufsize = TARGET_BUFSIZE_DEFAULT;
+		maxBufsize = MAX_BUFSIZE_DEFAULT;
+		targetBufsize = TARGET_BUFSIZE_DEFAULT;
 
 		int systemBufsize = System_GetPropertyInt(SYSPROP_AUDIO_FRAMES_PER_BUFFER);
-		if (systemBufsize > 0 && m_targetBufsize < systemBufsize + TARGET_BUFSIZE_MARGIN) {
-			m_targetBufsize = std::min(4096, systemBufsize + TARGET_BUFSIZE_MARGIN);
-			if (m_targetBufsize * 2 > MAX_BUFSIZE_DEFAULT)
-				m_maxBufsize = MAX_BUFSIZE_EXTRA;
+		if (systemBufsize > 0 && targetBufsize < systemBufsize + TARGET_BUFSIZE_MARGIN) {
+			targetBufsize = std::min(4096, systemBufsize + TARGET_BUFSIZE_MARGIN);
+			if (targetBufsize * 2 > MAX_BUFSIZE_DEFAULT)
+				maxBufsize = MAX_BUFSIZE_EXTRA;
 		}
 	}
+	m_maxBufsize.store(maxBufsize, std::memory_order_relaxed);
+	m_targetBufsize.store(targetBufsize, std::memory_order_relaxed);
+}
+
+// The ring is always allocated and indexed for the largest size, so the mask never changes
+// under the audio thread's feet when the buffering setting does.
+static const u32 INDEX_MASK = MAX_BUFSIZE_EXTRA * 2 - 1;
+
+static inline int LatencyBucket(int samples, float sampleRate) {
+	int ms = sampleRate > 0.0f ? (int)(samples * 1000.0f / sampleRate) : 0;
+	return std::min(ms / 10, 7);
+}
+
+static inline int SizeBucket(u32 samples) {
+	int bucket = 0;
+	for (u32 size = 128; size <= samples && bucket < 7; size <<= 1)
+		bucket++;
+	return bucket;
 }
 
 template<bool useShift>
@@ -161,15 +185,123 @@ inline void ClampBufferToS16WithVolume(s16 *out, const s32 *in, size_t size) {
 }
 
 void StereoResampler::Clear() {
-	memset(m_buffer, 0, m_maxBufsize * 2 * sizeof(int16_t));
+	memset(m_buffer, 0, MAX_BUFSIZE_EXTRA * 2 * sizeof(int16_t));
 }
 
 inline int16_t MixSingleSample(int16_t s1, int16_t s2, uint16_t frac) {
 	return s1 + (((s2 - s1) * frac) >> 16);
 }
 
+// Blackman windowed sinc, one set of taps per fractional position. Each phase is normalized to unity
+// gain so a constant signal stays constant. When going down in rate, the cutoff follows the output.
+void StereoResampler::BuildSincBank(int outputSampleRate) {
+	const double cutoff = std::min(1.0, (double)outputSampleRate / (double)m_input_sample_rate) * 0.95;
+	const double halfWidth = SINC_TAPS / 2;
+	for (int phase = 0; phase < SINC_PHASES; ++phase) {
+		const double t = (double)phase / SINC_PHASES;
+		double taps[SINC_TAPS];
+		double sum = 0.0;
+		for (int k = 0; k < SINC_TAPS; ++k) {
+			// Tap k is the frame at k - (SINC_TAPS / 2 - 1) relative to the current one.
+			double x = (k - (SINC_TAPS / 2 - 1)) - t;
+			double sinc = x == 0.0 ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+			double window = 0.42 + 0.5 * cos(M_PI * x / halfWidth) + 0.08 * cos(2.0 * M_PI * x / halfWidth);
+			taps[k] = sinc * window;
+			sum += taps[k];
+		}
+
+		int total = 0;
+		int largest = 0;
+		for (int k = 0; k < SINC_TAPS; ++k) {
+			sincBank_[phase][k] = (int16_t)lrint(taps[k] * 32768.0 / sum);
+			total += sincBank_[phase][k];
+			if (abs(sincBank_[phase][k]) > abs(sincBank_[phase][largest]))
+				largest = k;
+		}
+		// Put the rounding error on the largest tap, so the gain is exactly 1.0.
+		// With the cutoff below 1.0 that tap stays well below 32767.
+		sincBank_[phase][largest] = (int16_t)std::min(32767, sincBank_[phase][largest] + 32768 - total);
+	}
+	sincBankRate_ = outputSampleRate;
+}
+
+// Filters one stereo frame out of SINC_TAPS interleaved frames.
+static inline void SincFrame(short *out, const int16_t *frames, const int16_t *taps) {
+#ifdef _M_SSE
+	__m128i acc = _mm_setzero_si128();
+	for (int k = 0; k < 16; k += 4) {
+		// L0 R0 L1 R1 ... -> L0 L1 R0 R1 ..., so each madd pair is one channel.
+		__m128i d = _mm_loadu_si128((const __m128i *)(frames + k * 2));
+		d = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+		// h0 h1 h2 h3 -> h0 h1 h0 h1 h2 h3 h2 h3.
+		__m128i h = _mm_shuffle_epi32(_mm_loadl_epi64((const __m128i *)(taps + k)), _MM_SHUFFLE(1, 1, 0, 0));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(d, h));
+	}
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+	acc = _mm_srai_epi32(_mm_add_epi32(acc, _mm_set1_epi32(1 << 14)), 15);
+	u32 packed = (u32)_mm_cvtsi128_si32(_mm_packs_epi32(acc, acc));
+	memcpy(out, &packed, sizeof(packed));
+#elif PPSSPP_ARCH(ARM_NEON)
+	int16x8x2_t lo = vld2q_s16(frames);
+	int16x8x2_t hi = vld2q_s16(frames + 16);
+	int16x8_t h1 = vld1q_s16(taps);
+	int16x8_t h2 = vld1q_s16(taps + 8);
+	int32x4_t accL = vmull_s16(vget_low_s16(lo.val[0]), vget_low_s16(h1));
+	int32x4_t accR = vmull_s16(vget_low_s16(lo.val[1]), vget_low_s16(h1));
+	accL = vmlal_s16(accL, vget_high_s16(lo.val[0]), vget_high_s16(h1));
+	accR = vmlal_s16(accR, vget_high_s16(lo.val[1]), vget_high_s16(h1));
+	accL = vmlal_s16(accL, vget_low_s16(hi.val[0]), vget_low_s16(h2));
+	accR = vmlal_s16(accR, vget_low_s16(hi.val[1]), vget_low_s16(h2));
+	accL = vmlal_s16(accL, vget_high_s16(hi.val[0]), vget_high_s16(h2));
+	accR = vmlal_s16(accR, vget_high_s16(hi.val[1]), vget_high_s16(h2));
+	int32x2_t sums = vpadd_s32(vadd_s32(vget_low_s32(accL), vget_high_s32(accL)), vadd_s32(vget_low_s32(accR), vget_high_s32(accR)));
+	int16x4_t result = vqrshrn_n_s32(vcombine_s32(sums, sums), 15);
+	out[0] = vget_lane_s16(result, 0);
+	out[1] = vget_lane_s16(result, 1);
+#else
+	int sumL = 0;
+	int sumR = 0;
+	for (int k = 0; k < 16; ++k) {
+		sumL += frames[k * 2] * taps[k];
+		sumR += frames[k * 2 + 1] * taps[k];
+	}
+	out[0] = clamp_s16((sumL + (1 << 14)) >> 15);
+	out[1] = clamp_s16((sumR + (1 << 14)) >> 15);
+#endif
+}
+
+unsigned int StereoResampler::ResampleSinc(short *samples, unsigned int numSamples, u32 &indexR, u32 indexW, u32 &frac, u32 ratio) {
+	static_assert(SINC_TAPS == 16, "SincFrame assumes 16 taps");
+	// Only for the rare case that the window straddles the end of the ring.
+	int16_t wrapped[SINC_TAPS * 2];
+
+	unsigned int currentSample;
+	for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
+		// We need SINC_TAPS / 2 frames after the current one.
+		if (((indexW - indexR) & INDEX_MASK) <= SINC_TAPS) {
+			underrunCount_++;
+			break;
+		}
+		// PushSamples leaves the frames behind indexR alone, see SINC_TAPS there.
+		u32 start = (indexR - (SINC_TAPS / 2 - 1) * 2) & INDEX_MASK;
+		const int16_t *frames = m_buffer + start;
+		if (start + SINC_TAPS * 2 > INDEX_MASK + 1) {
+			u32 first = INDEX_MASK + 1 - start;
+			memcpy(wrapped, m_buffer + start, first * sizeof(int16_t));
+			memcpy(wrapped + first, m_buffer, (SINC_TAPS * 2 - first) * sizeof(int16_t));
+			frames = wrapped;
+		}
+		SincFrame(samples + currentSample, frames, sincBank_[(frac & 0xFFFF) >> (16 - SINC_PHASE_BITS)]);
+		frac += ratio;
+		indexR += 2 * (frac >> 16);
+		frac &= 0xffff;
+	}
+	return currentSample;
+}
+
 // Executed from sound stream thread, pulling sound out of the buffer.
 unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool consider_framelimit, int sample_rate) {
+	PROFILE_THIS_SCOPE("resample");
 	if (!samples)
 		return 0;
 
@@ -182,13 +314,13 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 	// so we will just ignore new written data while interpolating (until it wraps...).
 	// Without this cache, the compiler wouldn't be allowed to optimize the
 	// interpolation loop.
-	u32 indexR = m_indexR.load();
-	u32 indexW = m_indexW.load();
-
-	const int INDEX_MASK = (m_maxBufsize * 2 - 1);
+	u32 indexR = m_indexR.load(std::memory_order_relaxed);
+	// Acquire pairs with the release in PushSamples, so the samples up to indexW are visible.
+	u32 indexW = m_indexW.load(std::memory_order_acquire);
 
 	// This is only for debug visualization, not used for anything.
 	lastBufSize_ = ((indexW - indexR) & INDEX_MASK) / 2;
+	latencyHistogram_[LatencyBucket(lastBufSize_, output_sample_rate_)].fetch_add(1, std::memory_order_relaxed);
 
 	// Drift prevention mechanism.
 	float numLeft = (float)(((indexW - indexR) & INDEX_MASK) / 2);
@@ -206,37 +338,46 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 	// Note that the speed of adjustment here does not take the buffer size into
 	// account. Since this is called once per "output frame", the frame size
 	// will affect how fast this algorithm reacts, which can't be a good thing.
-	float offset = (m_numLeftI - (float)m_targetBufsize) * CONTROL_FACTOR;
+	float offset = (m_numLeftI - (float)m_targetBufsize.load(std::memory_order_relaxed)) * CONTROL_FACTOR;
 	if (offset > MAX_FREQ_SHIFT) offset = MAX_FREQ_SHIFT;
 	if (offset < -MAX_FREQ_SHIFT) offset = -MAX_FREQ_SHIFT;
 
 	output_sample_rate_ = (float)(m_input_sample_rate + offset);
 	const u32 ratio = (u32)(65536.0 * output_sample_rate_ / (double)sample_rate);
 	ratio_ = ratio;
-	// TODO: consider a higher-quality resampling algorithm.
 	// TODO: Add a fast path for 1:1.
 	u32 frac = m_frac;
-	for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
-		if (((indexW - indexR) & INDEX_MASK) <= 2) {
-			// Ran out!
-			// int missing = numSamples * 2 - currentSample;
-			// ILOG("Resampler underrun: %d (numSamples: %d, currentSample: %d)", missing, numSamples, currentSample / 2);
-			underrunCount_++;
-			break;
+	resamplerType_ = g_Config.iAudioResampler;
+	if (resamplerType_ == AUDIO_RESAMPLER_SINC) {
+		if (sincBankRate_ != sample_rate)
+			BuildSincBank(sample_rate);
+		currentSample = ResampleSinc(samples, numSamples, indexR, indexW, frac, ratio);
+	} else {
+		for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
+			if (((indexW - indexR) & INDEX_MASK) <= 2) {
+				// Ran out!
+				// int missing = numSamples * 2 - currentSample;
+				// ILOG("Resampler underrun: %d (numSamples: %d, currentSample: %d)", missing, numSamples, currentSample / 2);
+				underrunCount_++;
+				break;
+			}
+			u32 indexR2 = indexR + 2; //next sample
+			s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
+			s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
+			s16 l2 = m_buffer[indexR2 & INDEX_MASK]; //next
+			s16 r2 = m_buffer[(indexR2 + 1) & INDEX_MASK]; //next
+			samples[currentSample] = MixSingleSample(l1, l2, (u16)frac);
+			samples[currentSample + 1] = MixSingleSample(r1, r2, (u16)frac);
+			frac += ratio;
+			indexR += 2 * (frac >> 16);
+			frac &= 0xffff;
 		}
-		u32 indexR2 = indexR + 2; //next sample
-		s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
-		s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
-		s16 l2 = m_buffer[indexR2 & INDEX_MASK]; //next
-		s16 r2 = m_buffer[(indexR2 + 1) & INDEX_MASK]; //next
-		samples[currentSample] = MixSingleSample(l1, l2, (u16)frac);
-		samples[currentSample + 1] = MixSingleSample(r1, r2, (u16)frac);
-		frac += ratio;
-		indexR += 2 * (frac >> 16);
-		frac &= 0xffff;
 	}
 	m_frac = frac;
 
+	if (currentSample < numSamples * 2)
+		underrunHistogram_[SizeBucket(numSamples - currentSample / 2)].fetch_add(1, std::memory_order_relaxed);
+
 	// Let's not count the underrun padding here.
 	outputSampleCount_ += currentSample / 2;
 
@@ -249,8 +390,8 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 		samples[currentSample + 1] = s[1];
 	}
 
-	// Flush cached variable
-	m_indexR.store(indexR);
+	// Flush cached variable, releasing the space we've read to the producer.
+	m_indexR.store(indexR, std::memory_order_release);
 
 	// TODO: What should we actually return here?
 	return currentSample / 2;
@@ -261,30 +402,32 @@ void StereoResampler::PushSamples(const s32 *samples, unsigned int numSamples) {
 	inputSampleCount_ += numSamples;
 
 	UpdateBufferSize();
-	const int INDEX_MASK = (m_maxBufsize * 2 - 1);
 	// Cache access in non-volatile variable
 	// indexR isn't allowed to cache in the audio throttling loop as it
 	// needs to get updates to not deadlock.
-	u32 indexW = m_indexW.load();
+	u32 indexW = m_indexW.load(std::memory_order_relaxed);
 
-	u32 cap = m_maxBufsize * 2;
+	u32 cap = m_maxBufsize.load(std::memory_order_relaxed) * 2;
 	// If fast-forwarding, no need to fill up the entire buffer, just screws up timing after releasing the fast-forward button.
 	if (PSP_CoreParameter().fastForward) {
-		cap = m_targetBufsize * 2;
+		cap = m_targetBufsize.load(std::memory_order_relaxed) * 2;
 	}
+	// The sinc resampler still reads a few frames behind indexR, don't overwrite those.
+	cap = std::min(cap, INDEX_MASK + 1 - SINC_TAPS * 2);
 
 	// Check if we have enough free space
 	// indexW == m_indexR results in empty buffer, so indexR must always be smaller than indexW
-	if (numSamples * 2 + ((indexW - m_indexR.load()) & INDEX_MASK) >= cap) {
+	if (numSamples * 2 + ((indexW - m_indexR.load(std::memory_order_acquire)) & INDEX_MASK) >= cap) {
 		if (!PSP_CoreParameter().fastForward) {
 			overrunCount_++;
+			overrunHistogram_[SizeBucket(numSamples)].fetch_add(1, std::memory_order_relaxed);
 		}
 		// TODO: "Timestretch" by doing a windowed overlap with existing buffer content?
 		return;
 	}
 
 	// Check if we need to roll over to the start of the buffer during the copy.
-	unsigned int indexW_left_samples = m_maxBufsize * 2 - (indexW & INDEX_MASK);
+	unsigned int indexW_left_samples = MAX_BUFSIZE_EXTRA * 2 - (indexW & INDEX_MASK);
 	if (numSamples * 2 > indexW_left_samples) {
 		ClampBufferToS16WithVolume(&m_buffer[indexW & INDEX_MASK], samples, indexW_left_samples);
 		ClampBufferToS16WithVolume(&m_buffer[0], samples + indexW_left_samples, numSamples * 2 - indexW_left_samples);
@@ -292,16 +435,30 @@ void StereoResampler::PushSamples(const s32 *samples, unsigned int numSamples) {
 		ClampBufferToS16WithVolume(&m_buffer[indexW & INDEX_MASK], samples, numSamples * 2);
 	}
 
-	m_indexW += numSamples * 2;
+	// Release publishes the samples written above to Mix.
+	m_indexW.store(indexW + numSamples * 2, std::memory_order_release);
 	lastPushSize_ = numSamples;
 }
 
+static size_t FormatHistogram(char *buf, size_t bufSize, const char *title, const char *const *labels, const std::atomic<u32> *histogram, int count) {
+	size_t len = snprintf(buf, bufSize, "%s:", title);
+	for (int i = 0; i < count && len < bufSize; ++i) {
+		len += snprintf(buf + len, bufSize - len, " %s:%u", labels[i], histogram[i].load(std::memory_order_relaxed));
+	}
+	if (len < bufSize)
+		len += snprintf(buf + len, bufSize - len, "\n");
+	return std::min(len, bufSize);
+}
+
 void StereoResampler::GetAudioDebugStats(char *buf, size_t bufSize) {
 	double elapsed = time_now_d() - startTime_;
 
+	underrunCountTotal_ += underrunCount_.exchange(0);
+	overrunCountTotal_ += overrunCount_.exchange(0);
+
 	double effective_input_sample_rate = (double)inputSampleCount_ / elapsed;
 	double effective_output_sample_rate = (double)outputSampleCount_ / elapsed;
-	snprintf(buf, bufSize,
+	size_t len = snprintf(buf, bufSize,
 		"Audio buffer: %d/%d (target: %d)\n"
 		"Filtered: %0.2f\n"
 		"Underruns: %d\n"
@@ -310,10 +467,11 @@ void StereoResampler::GetAudioDebugStats(char *buf, size_t bufSize) {
 		"Effective input sample rate: %0.2f\n"
 		"Effective output sample rate: %0.2f\n"
 		"Push size: %d\n"
-		"Ratio: %0.6f\n",
+		"Ratio: %0.6f\n"
+		"Resampler: %s\n",
 		lastBufSize_,
-		m_maxBufsize,
-		m_targetBufsize,
+		m_maxBufsize.load(),
+		m_targetBufsize.load(),
 		m_numLeftI,
 		underrunCountTotal_,
 		overrunCountTotal_,
@@ -322,11 +480,15 @@ void StereoResampler::GetAudioDebugStats(char *buf, size_t bufSize) {
 		effective_input_sample_rate,
 		effective_output_sample_rate,
 		lastPushSize_,
-		(float)ratio_ / 65536.0f);
-	underrunCountTotal_ += underrunCount_;
-	overrunCountTotal_ += overrunCount_;
-	underrunCount_ = 0;
-	overrunCount_ = 0;
+		(float)ratio_ / 65536.0f,
+		resamplerType_ == AUDIO_RESAMPLER_SINC ? "windowed sinc" : "linear");
+	len = std::min(len, bufSize);
+
+	static const char *const latencyLabels[HISTOGRAM_BUCKETS] = { "<10", "<20", "<30", "<40", "<50", "<60", "<70", "70+" };
+	static const char *const sizeLabels[HISTOGRAM_BUCKETS] = { "<128", "<256", "<512", "<1k", "<2k", "<4k", "<8k", "8k+" };
+	len += FormatHistogram(buf + len, bufSize - len, "Latency ms", latencyLabels, latencyHistogram_, HISTOGRAM_BUCKETS);
+	len += FormatHistogram(buf + len, bufSize - len, "Underrun samples", sizeLabels, underrunHistogram_, HISTOGRAM_BUCKETS);
+	FormatHistogram(buf + len, bufSize - len, "Overrun samples", sizeLabels, overrunHistogram_, HISTOGRAM_BUCKETS);
 
 	// Use this to remove the bias from the startup.
 	// if (elapsed > 3.0) {
@@ -339,6 +501,11 @@ void StereoResampler::ResetStatCounters() {
 	overrunCount_ = 0;
 	underrunCountTotal_ = 0;
 	overrunCountTotal_ = 0;
+	for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+		latencyHistogram_[i] = 0;
+		underrunHistogram_[i] = 0;
+		overrunHistogram_[i] = 0;
+	}
 	inputSampleCount_ = 0;
 	outputSampleCount_ = 0;
 	startTime_ = time_now_d();
@@ -47,16 +47,29 @@ class StereoResampler {
 	void ResetStatCounters();
 
 private:
+	enum {
+		HISTOGRAM_BUCKETS = 8,
+		// Windowed sinc resampler: taps per output sample, and filter phases (picked by the top bits of frac.)
+		SINC_TAPS = 16,
+		SINC_PHASE_BITS = 7,
+		SINC_PHASES = 1 << SINC_PHASE_BITS,
+	};
+
 	void UpdateBufferSize();
+	void BuildSincBank(int outputSampleRate);
+	unsigned int ResampleSinc(short *samples, unsigned int numSamples, u32 &indexR, u32 indexW, u32 &frac, u32 ratio);
 
-	int m_maxBufsize;
-	int m_targetBufsize;
+	// These only change the fill limits, the ring itself always uses the largest size.
+	std::atomic<int> m_maxBufsize;
+	std::atomic<int> m_targetBufsize;
 
 	unsigned int m_input_sample_rate = 44100;
 	int16_t *m_buffer;
-	std::atomic<u32> m_indexW;
-	std::atomic<u32> m_indexR;
-	float m_numLeftI = 0.0f;
+	// Single producer (PushSamples), single consumer (Mix). Each index is only written by its owner,
+	// kept on separate cache lines so the two threads don't keep stealing them from each other.
+	alignas(64) std::atomic<u32> m_indexW;
+	alignas(64) std::atomic<u32> m_indexR;
+	alignas(64) float m_numLeftI = 0.0f;
 
 	u32 m_frac = 0;
 	float output_sample_rate_ = 0.0;
@@ -64,15 +77,26 @@ class StereoResampler {
 	int lastPushSize_ = 0;
 	u32 ratio_ = 0;
 
-	int underrunCount_ = 0;
-	int overrunCount_ = 0;
+	std::atomic<int> underrunCount_{};
+	std::atomic<int> overrunCount_{};
 	int underrunCountTotal_ = 0;
 	int overrunCountTotal_ = 0;
 
+	// Buffered audio when the host pulls (10ms steps), and missing / dropped samples per
+	// underrun / overrun (powers of two, from below 128.)
+	std::atomic<u32> latencyHistogram_[HISTOGRAM_BUCKETS]{};
+	std::atomic<u32> underrunHistogram_[HISTOGRAM_BUCKETS]{};
+	std::atomic<u32> overrunHistogram_[HISTOGRAM_BUCKETS]{};
+
 	int droppedSamples_ = 0;
 
 	int64_t inputSampleCount_ = 0;
 	int64_t outputSampleCount_ = 0;
 
 	double startTime_ = 0.0;
+
+	// Only touched by the audio thread, rebuilt when the output rate changes.
+	alignas(16) int16_t sincBank_[SINC_PHASES][SINC_TAPS];
+	int sincBankRate_ = 0;
+	std::atomic<int> resamplerType_{};
 };
@@ -705,6 +705,9 @@ void ArmJit::Comp_Syscall(MIPSOpcode op)
 	ApplyRoundingMode();
 	RestoreDowncount();
 
+	// Pure syscalls can't change the thread or PC, so we can keep going.
+	if (!js.inDelaySlot && IsPureSyscall(op))
+		return;
 	WriteSyscallExit();
 	js.compiling = false;
 }
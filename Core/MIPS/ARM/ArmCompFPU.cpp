@@ -104,7 +104,7 @@ void ArmJit::Comp_FPULS(MIPSOpcode op)
 	switch(op >> 26)
 	{
 	case 49: //FI(ft) = Memory::Read_U32(addr); break; //lwc1
-		if (!gpr.IsImm(rs) && jo.cachePointers && g_Config.bFastMemory && (offset & 3) == 0 && offset < 0x400 && offset > -0x400) {
+		if (!gpr.IsImm(rs) && jo.cachePointers && js.fastMemory && (offset & 3) == 0 && offset < 0x400 && offset > -0x400) {
 			gpr.MapRegAsPointer(rs);
 			fpr.MapReg(ft, MAP_NOINIT | MAP_DIRTY);
 			VLDR(fpr.R(ft), gpr.RPtr(rs), offset);
@@ -118,7 +118,7 @@ void ArmJit::Comp_FPULS(MIPSOpcode op)
 			gpr.SetRegImm(R0, addr + (u32)Memory::base);
 		} else {
 			gpr.MapReg(rs);
-			if (g_Config.bFastMemory) {
+			if (js.fastMemory) {
 				SetR0ToEffectiveAddress(rs, offset);
 			} else {
 				SetCCAndR0ForSafeAddress(rs, offset, SCRATCHREG2);
@@ -148,7 +148,7 @@ void ArmJit::Comp_FPULS(MIPSOpcode op)
 		break;
 
 	case 57: //Memory::Write_U32(FI(ft), addr); break; //swc1
-		if (!gpr.IsImm(rs) && jo.cachePointers && g_Config.bFastMemory && (offset & 3) == 0 && offset < 0x400 && offset > -0x400) {
+		if (!gpr.IsImm(rs) && jo.cachePointers && js.fastMemory && (offset & 3) == 0 && offset < 0x400 && offset > -0x400) {
 			gpr.MapRegAsPointer(rs);
 			fpr.MapReg(ft, 0);
 			VSTR(fpr.R(ft), gpr.RPtr(rs), offset);
@@ -161,7 +161,7 @@ void ArmJit::Comp_FPULS(MIPSOpcode op)
 			gpr.SetRegImm(R0, addr + (u32)Memory::base);
 		} else {
 			gpr.MapReg(rs);
-			if (g_Config.bFastMemory) {
+			if (js.fastMemory) {
 				SetR0ToEffectiveAddress(rs, offset);
 			} else {
 				SetCCAndR0ForSafeAddress(rs, offset, SCRATCHREG2);
@@ -30,6 +30,7 @@
 #include "Core/CoreTiming.h"
 #include "Core/Debugger/Breakpoints.h"
 #include "Core/Debugger/SymbolMap.h"
+#include "Core/MemFault.h"
 #include "Core/MemMap.h"
 
 #include "Core/MIPS/MIPS.h"
@@ -292,6 +293,7 @@ const u8 *ArmJit::DoJit(u32 em_address, JitBlock *b)
 	js.downcountAmount = 0;
 	js.curBlock = b;
 	js.compiling = true;
+	js.fastMemory = g_Config.bFastMemory && !Memory::MemFault_IsSlowMemBlock(js.blockStart);
 	js.inDelaySlot = false;
 	js.PrefixStart();
 
@@ -777,7 +779,7 @@ bool ArmJit::CheckJitBreakpoint(u32 addr, int downcountOffset) {
 }
 
 bool ArmJit::CheckMemoryBreakpoint(int instructionOffset) {
-	if (CBreakPoints::HasMemChecks()) {
+	if (CBreakPoints::HasMemChecksForBlock(js.blockStart)) {
 		int off = instructionOffset + (js.inDelaySlot ? 1 : 0);
 
 		MRS(R8);
@@ -600,6 +600,7 @@ void Arm64Jit::Comp_JumpReg(MIPSOpcode op)
 	CONDITIONAL_NICE_DELAYSLOT;
 
 	ARM64Reg destReg = INVALID_REG;
+	u32 predictedTarget = js.PredictJumpRegTarget(mips_, rs);
 	if (IsSyscall(delaySlotOp)) {
 		gpr.MapReg(rs);
 		MovToPC(gpr.R(rs));  // For syscall to be able to return.
@@ -659,7 +660,7 @@ void Arm64Jit::Comp_JumpReg(MIPSOpcode op)
 		break;
 	}
 
-	WriteExitDestInR(destReg);
+	WriteExitDestInR(destReg, predictedTarget);
 	js.compiling = false;
 }
 
@@ -718,6 +719,9 @@ void Arm64Jit::Comp_Syscall(MIPSOpcode op)
 	LoadStaticRegisters();
 	ApplyRoundingMode();
 
+	// Pure syscalls can't change the thread or PC, so we can keep going.
+	if (!js.inDelaySlot && IsPureSyscall(op))
+		return;
 	WriteSyscallExit();
 	js.compiling = false;
 }
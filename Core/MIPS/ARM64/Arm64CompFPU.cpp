@@ -92,7 +92,7 @@ void Arm64Jit::Comp_FPULS(MIPSOpcode op)
 	std::vector<FixupBranch> skips;
 	switch (op >> 26) {
 	case 49: //FI(ft) = Memory::Read_U32(addr); break; //lwc1
-		if (!gpr.IsImm(rs) && jo.cachePointers && g_Config.bFastMemory && (offset & 3) == 0 && offset <= 16380 && offset >= 0) {
+		if (!gpr.IsImm(rs) && jo.cachePointers && js.fastMemory && (offset & 3) == 0 && offset <= 16380 && offset >= 0) {
 			gpr.MapRegAsPointer(rs);
 			fpr.MapReg(ft, MAP_NOINIT | MAP_DIRTY);
 			fp.LDR(32, INDEX_UNSIGNED, fpr.R(ft), gpr.RPtr(rs), offset);
@@ -110,7 +110,7 @@ void Arm64Jit::Comp_FPULS(MIPSOpcode op)
 			gpr.SetRegImm(SCRATCH1, addr);
 		} else {
 			gpr.MapReg(rs);
-			if (g_Config.bFastMemory) {
+			if (js.fastMemory) {
 				SetScratch1ToEffectiveAddress(rs, offset);
 			} else {
 				skips = SetScratch1ForSafeAddress(rs, offset, SCRATCH2);
@@ -124,7 +124,7 @@ void Arm64Jit::Comp_FPULS(MIPSOpcode op)
 		break;
 
 	case 57: //Memory::Write_U32(FI(ft), addr); break; //swc1
-		if (!gpr.IsImm(rs) && jo.cachePointers && g_Config.bFastMemory && (offset & 3) == 0 && offset <= 16380 && offset >= 0) {
+		if (!gpr.IsImm(rs) && jo.cachePointers && js.fastMemory && (offset & 3) == 0 && offset <= 16380 && offset >= 0) {
 			gpr.MapRegAsPointer(rs);
 			fpr.MapReg(ft, 0);
 			fp.STR(32, INDEX_UNSIGNED, fpr.R(ft), gpr.RPtr(rs), offset);
@@ -141,7 +141,7 @@ void Arm64Jit::Comp_FPULS(MIPSOpcode op)
 			gpr.SetRegImm(SCRATCH1, addr);
 		} else {
 			gpr.MapReg(rs);
-			if (g_Config.bFastMemory) {
+			if (js.fastMemory) {
 				SetScratch1ToEffectiveAddress(rs, offset);
 			} else {
 				skips = SetScratch1ForSafeAddress(rs, offset, SCRATCH2);
@@ -214,7 +214,7 @@ namespace MIPSComp {
 		switch (op >> 26) {
 		case 50: //lv.s  // VI(vt) = Memory::Read_U32(addr);
 		{
-			if (!gpr.IsImm(rs) && jo.cachePointers && g_Config.bFastMemory && (offset & 3) == 0 && offset >= 0 && offset < 16384) {
+			if (!gpr.IsImm(rs) && jo.cachePointers && js.fastMemory && (offset & 3) == 0 && offset >= 0 && offset < 16384) {
 				gpr.MapRegAsPointer(rs);
 				fpr.MapRegV(vt, MAP_NOINIT | MAP_DIRTY);
 				fp.LDR(32, INDEX_UNSIGNED, fpr.V(vt), gpr.RPtr(rs), offset);
@@ -232,7 +232,7 @@ namespace MIPSComp {
 				gpr.SetRegImm(SCRATCH1, addr);
 			} else {
 				gpr.MapReg(rs);
-				if (g_Config.bFastMemory) {
+				if (js.fastMemory) {
 					SetScratch1ToEffectiveAddress(rs, offset);
 				} else {
 					skips = SetScratch1ForSafeAddress(rs, offset, SCRATCH2);
@@ -247,7 +247,7 @@ namespace MIPSComp {
 
 		case 58: //sv.s   // Memory::Write_U32(VI(vt), addr);
 		{
-			if (!gpr.IsImm(rs) && jo.cachePointers && g_Config.bFastMemory && (offset & 3) == 0 && offset >= 0 && offset < 16384) {
+			if (!gpr.IsImm(rs) && jo.cachePointers && js.fastMemory && (offset & 3) == 0 && offset >= 0 && offset < 16384) {
 				gpr.MapRegAsPointer(rs);
 				fpr.MapRegV(vt, 0);
 				fp.STR(32, INDEX_UNSIGNED, fpr.V(vt), gpr.RPtr(rs), offset);
@@ -265,7 +265,7 @@ namespace MIPSComp {
 				gpr.SetRegImm(SCRATCH1, addr);
 			} else {
 				gpr.MapReg(rs);
-				if (g_Config.bFastMemory) {
+				if (js.fastMemory) {
 					SetScratch1ToEffectiveAddress(rs, offset);
 				} else {
 					skips = SetScratch1ForSafeAddress(rs, offset, SCRATCH2);
@@ -311,7 +311,7 @@ namespace MIPSComp {
 					gpr.SetRegImm(SCRATCH1_64, addr + (uintptr_t)Memory::base);
 				} else {
 					gpr.MapReg(rs);
-					if (g_Config.bFastMemory) {
+					if (js.fastMemory) {
 						SetScratch1ToEffectiveAddress(rs, imm);
 					} else {
 						skips = SetScratch1ForSafeAddress(rs, imm, SCRATCH2);
@@ -348,7 +348,7 @@ namespace MIPSComp {
 					gpr.SetRegImm(SCRATCH1_64, addr + (uintptr_t)Memory::base);
 				} else {
 					gpr.MapReg(rs);
-					if (g_Config.bFastMemory) {
+					if (js.fastMemory) {
 						SetScratch1ToEffectiveAddress(rs, imm);
 					} else {
 						skips = SetScratch1ForSafeAddress(rs, imm, SCRATCH2);
@@ -31,6 +31,7 @@
 #include "Core/CoreTiming.h"
 #include "Core/Debugger/Breakpoints.h"
 #include "Core/Debugger/SymbolMap.h"
+#include "Core/MemFault.h"
 #include "Core/MemMap.h"
 
 #include "Core/MIPS/MIPS.h"
@@ -292,6 +293,8 @@ const u8 *Arm64Jit::DoJit(u32 em_address, JitBlock *b) {
 	js.downcountAmount = 0;
 	js.curBlock = b;
 	js.compiling = true;
+	js.fastMemory = g_Config.bFastMemory && !Memory::MemFault_IsSlowMemBlock(js.blockStart);
+	b->regContract = gpr.GetRegContract();
 	js.inDelaySlot = false;
 	js.PrefixStart();
 
@@ -702,8 +705,8 @@ void Arm64Jit::WriteExit(u32 destination, int exit_num) {
 
 	// Link opportunity!
 	int block = blocks.GetBlockNumberFromStartAddress(destination);
-	if (block >= 0 && jo.enableBlocklink) {
-		// The target block exists! Directly link to its checked entrypoint.
+	if (block >= 0 && jo.enableBlocklink && blocks.GetBlock(block)->regContract == b->regContract) {
+		// The target block exists and expects our static registers! Directly link to its checked entrypoint.
 		B(blocks.GetBlock(block)->checkedEntry);
 		b->linkStatus[exit_num] = true;
 	} else {
@@ -712,7 +715,15 @@ void Arm64Jit::WriteExit(u32 destination, int exit_num) {
 	}
 }
 
-void Arm64Jit::WriteExitDestInR(ARM64Reg Reg) {
+void Arm64Jit::WriteExitDestInR(ARM64Reg Reg, u32 predictedTarget) {
+	// Check for the expected target first, if it matches this is a normal (linkable) exit.
+	if (predictedTarget != 0 && jo.enableBlocklink && js.nextExit < MAX_JIT_BLOCK_EXITS) {
+		CMPI2R(Reg, predictedTarget, Reg == SCRATCH2 ? SCRATCH1 : SCRATCH2);
+		FixupBranch miss = B(CC_NEQ);
+		WriteExit(predictedTarget, js.nextExit++);
+		SetJumpTarget(miss);
+	}
+
 	// TODO: If not fast memory, check for invalid address in reg and trigger exception.
 	MovToPC(Reg);
 	WriteDownCount();
@@ -755,7 +766,7 @@ bool Arm64Jit::CheckJitBreakpoint(u32 addr, int downcountOffset) {
 }
 
 bool Arm64Jit::CheckMemoryBreakpoint(int instructionOffset) {
-	if (CBreakPoints::HasMemChecks()) {
+	if (CBreakPoints::HasMemChecksForBlock(js.blockStart)) {
 		int off = instructionOffset + (js.inDelaySlot ? 1 : 0);
 
 		MRS(FLAGTEMPREG, FIELD_NZCV);
@@ -217,7 +217,7 @@ class Arm64Jit : public Arm64Gen::ARM64CodeBlock, public JitInterface, public MI
 	void LoadStaticRegisters();
 
 	void WriteExit(u32 destination, int exit_num);
-	void WriteExitDestInR(Arm64Gen::ARM64Reg Reg);
+	void WriteExitDestInR(Arm64Gen::ARM64Reg Reg, u32 predictedTarget = 0);
 	void WriteSyscallExit();
 	bool CheckJitBreakpoint(u32 addr, int downcountOffset);
 	bool CheckMemoryBreakpoint(int instructionOffset = 0);
@@ -129,6 +129,20 @@ void Arm64RegCache::EmitSaveStaticRegisters() {
 	}
 }
 
+u32 Arm64RegCache::GetRegContract() {
+	int count;
+	const StaticAllocation *allocs = GetStaticAllocations(count);
+	// Zero means "everything in memory", which is also what the other backends use.
+	u32 contract = 0;
+	for (int i = 0; i < count; i++) {
+		u32 entry = (u32)allocs[i].mr | ((u32)(allocs[i].ar & 0x1F) << 8);
+		if (allocs[i].pointerified && jo_->enablePointerify)
+			entry |= 0x2000;
+		contract = (contract * 0x01000193) ^ (entry + 1);
+	}
+	return contract;
+}
+
 void Arm64RegCache::FlushBeforeCall() {
 	// These registers are not preserved by function calls.
 	for (int i = 0; i < 19; ++i) {
@@ -144,6 +144,10 @@ class Arm64RegCache {
 	void EmitLoadStaticRegisters();
 	void EmitSaveStaticRegisters();
 
+	// Signature of the statically allocated registers, which stay mapped across linked exits
+	// instead of being flushed and reloaded. Blocks with different contracts must not link.
+	u32 GetRegContract();
+
 private:
 	struct StaticAllocation {
 		MIPSGPReg mr;
@@ -113,12 +113,8 @@ void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 			ir.WriteSetConstant(MIPS_GET_RD(branchInfo.delaySlotOp), GetCompilerPC() + 12);
 	}
 
-	FlushAll();
-	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
-
-	// Account for the delay slot.
-	js.compilerPC += 4;
-	js.compiling = false;
+	// Taken.  Likely branches are usually taken, so a trace can continue there with the above as a side exit.
+	BranchExitOrContinue(targetAddr, likely && opts.continueBranches && !branchInfo.delaySlotIsBranch);
 }
 
 void IRFrontend::BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink, bool likely) {
@@ -164,12 +160,7 @@ void IRFrontend::BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink,
 	}
 
 	// Taken
-	FlushAll();
-	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
-
-	// Account for the delay slot.
-	js.compilerPC += 4;
-	js.compiling = false;
+	BranchExitOrContinue(targetAddr, likely && opts.continueBranches && !branchInfo.delaySlotIsBranch);
 }
 
 void IRFrontend::Comp_RelBranch(MIPSOpcode op) {
@@ -243,12 +234,8 @@ void IRFrontend::BranchFPFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 			ir.WriteSetConstant(MIPS_GET_RD(branchInfo.delaySlotOp), GetCompilerPC() + 12);
 	}
 
-	FlushAll();
-	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
-
-	// Account for the delay slot.
-	js.compilerPC += 4;
-	js.compiling = false;
+	// Taken
+	BranchExitOrContinue(targetAddr, likely && opts.continueBranches && !branchInfo.delaySlotIsBranch);
 }
 
 void IRFrontend::Comp_FPUBranch(MIPSOpcode op) {
@@ -305,12 +292,7 @@ void IRFrontend::BranchVFPUFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 	}
 
 	// Taken
-	FlushAll();
-	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
-
-	// Account for the delay slot.
-	js.compilerPC += 4;
-	js.compiling = false;
+	BranchExitOrContinue(targetAddr, likely && opts.continueBranches && !branchInfo.delaySlotIsBranch);
 }
 
 void IRFrontend::Comp_VBranch(MIPSOpcode op) {
@@ -357,16 +339,18 @@ void IRFrontend::Comp_Jump(MIPSOpcode op) {
 		break;
 	}
 
+	if (opts.continueJumps && CanContinueTo(targetAddr)) {
+		// The downcount keeps accumulating until the next exit.
+		AddContinuedRange(targetAddr);
+		js.compilerPC = targetAddr - 4;
+		return;
+	}
+
 	int dcAmount = js.downcountAmount;
 	ir.Write(IROp::Downcount, 0, ir.AddConstant(dcAmount));
 	js.downcountAmount = 0;
 
-	FlushAll();
-	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
-
-	// Account for the delay slot.
-	js.compilerPC += 4;
-	js.compiling = false;
+	BranchExitOrContinue(targetAddr, false);
 }
 
 void IRFrontend::Comp_JumpReg(MIPSOpcode op) {
@@ -23,6 +23,7 @@
 #include "Core/Reporting.h"
 #include "Core/HLE/ReplaceTables.h"
 #include "Core/MemMap.h"
+#include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSTables.h"
 #include "Core/MIPS/IR/IRFrontend.h"
 #include "Core/MIPS/IR/IRRegCache.h"
@@ -236,6 +237,9 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 	js.inDelaySlot = false;
 	js.PrefixStart();
 	ir.Clear();
+	rangeStart_ = em_address;
+	initialBlockBytes_ = 0;
+	continuedRanges_.clear();
 
 	js.numInstructions = 0;
 	while (js.compiling) {
@@ -254,7 +258,13 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 		ir.Clear();
 	}
 
-	mipsBytes = js.compilerPC - em_address;
+	if (js.lastContinuedPC == 0) {
+		mipsBytes = js.compilerPC - em_address;
+	} else {
+		// The first range is the block itself, the rest are only used for invalidation and hashing.
+		continuedRanges_.push_back({ rangeStart_, js.compilerPC - rangeStart_ });
+		mipsBytes = initialBlockBytes_;
+	}
 
 	IRWriter simplified;
 	IRWriter *code = &ir;
@@ -265,9 +275,11 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 			&OptimizeFPMoves,
 			&PropagateConstants,
 			&PurgeTemps,
+			&PurgeDeadFPRStores,
 			// &ReorderLoadStore,
 			// &MergeLoadStore,
 			// &ThreeOpToTwoOp,
+			&FuseOpPairs,
 		};
 		if (IRApplyPasses(passes, ARRAY_SIZE(passes), ir, simplified, opts))
 			logBlocks = 1;
@@ -281,11 +293,19 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 	if (logBlocks > 0 && dontLogBlocks == 0) {
 		char temp2[256];
 		NOTICE_LOG(JIT, "=============== mips %08x ===============", em_address);
-		for (u32 cpc = em_address; cpc != GetCompilerPC(); cpc += 4) {
+		for (u32 cpc = em_address; cpc != em_address + mipsBytes; cpc += 4) {
 			temp2[0] = 0;
 			MIPSDisAsm(Memory::Read_Opcode_JIT(cpc), cpc, temp2, true);
 			NOTICE_LOG(JIT, "M: %08x   %s", cpc, temp2);
 		}
+		for (const IRCodeRange &range : continuedRanges_) {
+			NOTICE_LOG(JIT, "=============== continued at %08x ===============", range.start);
+			for (u32 cpc = range.start; cpc != range.start + range.size; cpc += 4) {
+				temp2[0] = 0;
+				MIPSDisAsm(Memory::Read_Opcode_JIT(cpc), cpc, temp2, true);
+				NOTICE_LOG(JIT, "M: %08x   %s", cpc, temp2);
+			}
+		}
 	}
 
 	if (logBlocks > 0 && dontLogBlocks == 0) {
@@ -314,6 +334,57 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 		dontLogBlocks--;
 }
 
+bool IRFrontend::CanContinueTo(u32 targetAddr) {
+	// The delay slot might have ended the block (syscall, break.)
+	if (!js.compiling || js.numInstructions >= opts.continueMaxInstructions)
+		return false;
+	if (!targetAddr || !Memory::IsValidAddress(targetAddr))
+		return false;
+
+	// Don't unroll loops, they're better off as a block of their own.
+	u32 rangeEnd = GetCompilerPC() + 8;
+	if (targetAddr >= rangeStart_ && targetAddr < rangeEnd)
+		return false;
+	if (js.lastContinuedPC != 0 && targetAddr >= js.blockStart && targetAddr < js.blockStart + initialBlockBytes_)
+		return false;
+	for (const IRCodeRange &range : continuedRanges_) {
+		if (targetAddr >= range.start && targetAddr < range.start + range.size)
+			return false;
+	}
+	return true;
+}
+
+void IRFrontend::AddContinuedRange(u32 targetAddr) {
+	// Ends after the branch and its delay slot.
+	u32 rangeEnd = GetCompilerPC() + 8;
+	if (js.lastContinuedPC == 0)
+		initialBlockBytes_ = rangeEnd - js.blockStart;
+	else
+		continuedRanges_.push_back({ rangeStart_, rangeEnd - rangeStart_ });
+	rangeStart_ = targetAddr;
+	js.lastContinuedPC = targetAddr;
+}
+
+void IRFrontend::BranchExitOrContinue(u32 targetAddr, bool tryContinue) {
+	FlushAll();
+	// If we're branching back in a loop that only polls memory, it'll keep doing so until
+	// an event (interrupt, thread switch, etc.) changes something.  Just skip ahead to it.
+	if (opts.idleLoops && targetAddr <= GetCompilerPC() && MIPSAnalyst::IsIdleLoop(targetAddr, GetCompilerPC()))
+		ir.Write(IROp::Idle);
+	if (tryContinue && CanContinueTo(targetAddr)) {
+		AddContinuedRange(targetAddr);
+		// Account for the increment in the loop.
+		js.compilerPC = targetAddr - 4;
+		return;
+	}
+
+	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
+
+	// Account for the delay slot.
+	js.compilerPC += 4;
+	js.compiling = false;
+}
+
 void IRFrontend::Comp_RunBlock(MIPSOpcode op) {
 	// This shouldn't be necessary, the dispatcher should catch us before we get here.
 	ERROR_LOG(JIT, "Comp_RunBlock should never be reached!");
@@ -89,6 +89,10 @@ class IRFrontend : public MIPSFrontendInterface {
 	bool CheckRounding(u32 blockAddress);  // returns true if we need a do-over
 
 	void DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
+	// Code the last DoJit() continued into, after the mipsBytes at em_address.
+	const std::vector<IRCodeRange> &GetContinuedRanges() const {
+		return continuedRanges_;
+	}
 
 	void EatPrefix() override {
 		js.EatPrefix();
@@ -97,6 +101,9 @@ class IRFrontend : public MIPSFrontendInterface {
 	void SetOptions(const IROptions &o) {
 		opts = o;
 	}
+	const IROptions &GetOptions() const {
+		return opts;
+	}
 
 private:
 	void RestoreRoundingMode(bool force = false);
@@ -111,6 +118,10 @@ class IRFrontend : public MIPSFrontendInterface {
 	void EatInstruction(MIPSOpcode op);
 	MIPSOpcode GetOffsetInstruction(int offset);
 
+	bool CanContinueTo(u32 targetAddr);
+	void AddContinuedRange(u32 targetAddr);
+	void BranchExitOrContinue(u32 targetAddr, bool tryContinue);
+
 	void CheckBreakpoint(u32 addr);
 	void CheckMemoryBreakpoint(int rs, int offset);
 
@@ -136,6 +147,9 @@ class IRFrontend : public MIPSFrontendInterface {
 	JitState js;
 	IRWriter ir;
 	IROptions opts{};
+	u32 rangeStart_ = 0;
+	u32 initialBlockBytes_ = 0;
+	std::vector<IRCodeRange> continuedRanges_;
 
 	int dontLogBlocks = 0;
 	int logBlocks = 0;
@@ -157,6 +157,7 @@ static const IRMeta irMeta[] = {
 	{ IROp::ExitToReg, "ExitToReg", "_G", IRFLAG_EXIT },
 	{ IROp::Syscall, "Syscall", "_C", IRFLAG_EXIT },
 	{ IROp::Break, "Break", "", IRFLAG_EXIT },
+	{ IROp::Idle, "Idle", "" },
 	{ IROp::SetPC, "SetPC", "_G" },
 	{ IROp::SetPCConst, "SetPC", "_C" },
 	{ IROp::CallReplacement, "CallRepl", "_C" },
@@ -168,6 +169,12 @@ static const IRMeta irMeta[] = {
 	{ IROp::ValidateAddress32, "ValidAddr32", "_GC", IRFLAG_EXIT },
 	{ IROp::ValidateAddress128, "ValidAddr128", "_GC", IRFLAG_EXIT },
 
+	{ IROp::FusedLoad32Add, "Load32+Add", "GGC" },
+	{ IROp::FusedAddConstLoad32, "AddConst+Load32", "GGC" },
+	{ IROp::FusedLoadVec4Vec4Mul, "LoadVec4+Vec4Mul", "VGC" },
+	{ IROp::FusedSltExitIf, "Slt+ExitIf", "GGG" },
+	{ IROp::FusedSltConstExitIf, "SltConst+ExitIf", "GGC" },
+
 	{ IROp::RestoreRoundingMode, "RestoreRoundingMode", "" },
 	{ IROp::ApplyRoundingMode, "ApplyRoundingMode", "" },
 	{ IROp::UpdateRoundingMode, "UpdateRoundingMode", "" },
@@ -213,6 +213,8 @@ enum class IROp : u8 {
 	SetPCConst,  // hack to make replacement know PC
 	CallReplacement,
 	Break,
+	// Advances CoreTiming to the next event, emitted when a polling loop branches back.
+	Idle,
 
 	// Debugging breakpoints.
 	Breakpoint,
@@ -222,6 +224,14 @@ enum class IROp : u8 {
 	ValidateAddress16,
 	ValidateAddress32,
 	ValidateAddress128,
+
+	// Interpreter only: the first op of a common pair, with its operands.  The next
+	// instruction is the second op as usual, which the interpreter jumps to directly.
+	FusedLoad32Add,
+	FusedAddConstLoad32,
+	FusedLoadVec4Vec4Mul,
+	FusedSltExitIf,
+	FusedSltConstExitIf,
 };
 
 enum IRComparison {
@@ -378,6 +388,20 @@ class IRWriter {
 struct IROptions {
 	uint32_t disableFlags;
 	bool unalignedLoadStore;
+	// Skip ahead to the next CoreTiming event when a loop just polls memory.
+	bool idleLoops;
+	// Only when blocks are never handed to a native backend, see FuseOpPairs.
+	bool fuseOpPairs;
+	// Trace formation: keep compiling through jumps and likely branches, with side exits.
+	bool continueJumps;
+	bool continueBranches;
+	int continueMaxInstructions;
+};
+
+// A contiguous range of MIPS code, blocks have several when compiled as a trace.
+struct IRCodeRange {
+	u32 start;
+	u32 size;
 };
 
 const IRMeta *GetIRMeta(IROp op);
@@ -98,110 +98,287 @@ u32 RunValidateAddress(u32 pc, u32 addr, u32 isWrite) {
 	return 0;
 }
 
+#if defined(__GNUC__)
+// Labels as values: each op jumps straight to the next op's handler, instead of all of them
+// going back through the one indirect jump of the switch.  Much easier on the branch predictor.
+#define IR_COMPUTED_GOTO
+#define IR_CASE(name) case IROp::name: op_##name
+#define IR_DEFAULT default: op_default
+// For the second half of fused ops, skips the dispatch entirely.
+#define IR_THEN(name) { inst++; goto op_##name; }
+#else
+#define IR_CASE(name) case IROp::name
+#define IR_DEFAULT default
+#define IR_THEN(name) { inst++; continue; }
+#endif
+
 // We cannot use NEON on ARM32 here until we make it a hard dependency. We can, however, on ARM64.
 u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 	const IRInst *end = inst + count;
+#ifdef IR_COMPUTED_GOTO
+	static const void *dispatch[256];
+	static bool dispatchReady = false;
+	if (!dispatchReady) {
+		for (const void *&target : dispatch)
+			target = &&op_default;
+		dispatch[(int)IROp::Nop] = &&op_Nop;
+		dispatch[(int)IROp::SetConst] = &&op_SetConst;
+		dispatch[(int)IROp::SetConstF] = &&op_SetConstF;
+		dispatch[(int)IROp::Add] = &&op_Add;
+		dispatch[(int)IROp::Sub] = &&op_Sub;
+		dispatch[(int)IROp::And] = &&op_And;
+		dispatch[(int)IROp::Or] = &&op_Or;
+		dispatch[(int)IROp::Xor] = &&op_Xor;
+		dispatch[(int)IROp::Mov] = &&op_Mov;
+		dispatch[(int)IROp::AddConst] = &&op_AddConst;
+		dispatch[(int)IROp::SubConst] = &&op_SubConst;
+		dispatch[(int)IROp::AndConst] = &&op_AndConst;
+		dispatch[(int)IROp::OrConst] = &&op_OrConst;
+		dispatch[(int)IROp::XorConst] = &&op_XorConst;
+		dispatch[(int)IROp::Neg] = &&op_Neg;
+		dispatch[(int)IROp::Not] = &&op_Not;
+		dispatch[(int)IROp::Ext8to32] = &&op_Ext8to32;
+		dispatch[(int)IROp::Ext16to32] = &&op_Ext16to32;
+		dispatch[(int)IROp::ReverseBits] = &&op_ReverseBits;
+		dispatch[(int)IROp::ValidateAddress8] = &&op_ValidateAddress8;
+		dispatch[(int)IROp::ValidateAddress16] = &&op_ValidateAddress16;
+		dispatch[(int)IROp::ValidateAddress32] = &&op_ValidateAddress32;
+		dispatch[(int)IROp::ValidateAddress128] = &&op_ValidateAddress128;
+		dispatch[(int)IROp::Load8] = &&op_Load8;
+		dispatch[(int)IROp::Load8Ext] = &&op_Load8Ext;
+		dispatch[(int)IROp::Load16] = &&op_Load16;
+		dispatch[(int)IROp::Load16Ext] = &&op_Load16Ext;
+		dispatch[(int)IROp::Load32] = &&op_Load32;
+		dispatch[(int)IROp::Load32Left] = &&op_Load32Left;
+		dispatch[(int)IROp::Load32Right] = &&op_Load32Right;
+		dispatch[(int)IROp::LoadFloat] = &&op_LoadFloat;
+		dispatch[(int)IROp::Store8] = &&op_Store8;
+		dispatch[(int)IROp::Store16] = &&op_Store16;
+		dispatch[(int)IROp::Store32] = &&op_Store32;
+		dispatch[(int)IROp::Store32Left] = &&op_Store32Left;
+		dispatch[(int)IROp::Store32Right] = &&op_Store32Right;
+		dispatch[(int)IROp::StoreFloat] = &&op_StoreFloat;
+		dispatch[(int)IROp::LoadVec4] = &&op_LoadVec4;
+		dispatch[(int)IROp::StoreVec4] = &&op_StoreVec4;
+		dispatch[(int)IROp::Vec4Init] = &&op_Vec4Init;
+		dispatch[(int)IROp::Vec4Shuffle] = &&op_Vec4Shuffle;
+		dispatch[(int)IROp::Vec4Mov] = &&op_Vec4Mov;
+		dispatch[(int)IROp::Vec4Add] = &&op_Vec4Add;
+		dispatch[(int)IROp::Vec4Sub] = &&op_Vec4Sub;
+		dispatch[(int)IROp::Vec4Mul] = &&op_Vec4Mul;
+		dispatch[(int)IROp::Vec4Div] = &&op_Vec4Div;
+		dispatch[(int)IROp::Vec4Scale] = &&op_Vec4Scale;
+		dispatch[(int)IROp::Vec4Neg] = &&op_Vec4Neg;
+		dispatch[(int)IROp::Vec4Abs] = &&op_Vec4Abs;
+		dispatch[(int)IROp::Vec2Unpack16To31] = &&op_Vec2Unpack16To31;
+		dispatch[(int)IROp::Vec2Unpack16To32] = &&op_Vec2Unpack16To32;
+		dispatch[(int)IROp::Vec4Unpack8To32] = &&op_Vec4Unpack8To32;
+		dispatch[(int)IROp::Vec2Pack32To16] = &&op_Vec2Pack32To16;
+		dispatch[(int)IROp::Vec2Pack31To16] = &&op_Vec2Pack31To16;
+		dispatch[(int)IROp::Vec4Pack32To8] = &&op_Vec4Pack32To8;
+		dispatch[(int)IROp::Vec4Pack31To8] = &&op_Vec4Pack31To8;
+		dispatch[(int)IROp::Vec2ClampToZero] = &&op_Vec2ClampToZero;
+		dispatch[(int)IROp::Vec4ClampToZero] = &&op_Vec4ClampToZero;
+		dispatch[(int)IROp::Vec4DuplicateUpperBitsAndShift1] = &&op_Vec4DuplicateUpperBitsAndShift1;
+		dispatch[(int)IROp::FCmpVfpuBit] = &&op_FCmpVfpuBit;
+		dispatch[(int)IROp::FCmpVfpuAggregate] = &&op_FCmpVfpuAggregate;
+		dispatch[(int)IROp::FCmovVfpuCC] = &&op_FCmovVfpuCC;
+		dispatch[(int)IROp::Vec4Dot] = &&op_Vec4Dot;
+		dispatch[(int)IROp::FSin] = &&op_FSin;
+		dispatch[(int)IROp::FCos] = &&op_FCos;
+		dispatch[(int)IROp::FRSqrt] = &&op_FRSqrt;
+		dispatch[(int)IROp::FRecip] = &&op_FRecip;
+		dispatch[(int)IROp::FAsin] = &&op_FAsin;
+		dispatch[(int)IROp::ShlImm] = &&op_ShlImm;
+		dispatch[(int)IROp::ShrImm] = &&op_ShrImm;
+		dispatch[(int)IROp::SarImm] = &&op_SarImm;
+		dispatch[(int)IROp::RorImm] = &&op_RorImm;
+		dispatch[(int)IROp::Shl] = &&op_Shl;
+		dispatch[(int)IROp::Shr] = &&op_Shr;
+		dispatch[(int)IROp::Sar] = &&op_Sar;
+		dispatch[(int)IROp::Ror] = &&op_Ror;
+		dispatch[(int)IROp::Clz] = &&op_Clz;
+		dispatch[(int)IROp::Slt] = &&op_Slt;
+		dispatch[(int)IROp::SltU] = &&op_SltU;
+		dispatch[(int)IROp::SltConst] = &&op_SltConst;
+		dispatch[(int)IROp::SltUConst] = &&op_SltUConst;
+		dispatch[(int)IROp::MovZ] = &&op_MovZ;
+		dispatch[(int)IROp::MovNZ] = &&op_MovNZ;
+		dispatch[(int)IROp::Max] = &&op_Max;
+		dispatch[(int)IROp::Min] = &&op_Min;
+		dispatch[(int)IROp::MtLo] = &&op_MtLo;
+		dispatch[(int)IROp::MtHi] = &&op_MtHi;
+		dispatch[(int)IROp::MfLo] = &&op_MfLo;
+		dispatch[(int)IROp::MfHi] = &&op_MfHi;
+		dispatch[(int)IROp::Mult] = &&op_Mult;
+		dispatch[(int)IROp::MultU] = &&op_MultU;
+		dispatch[(int)IROp::Madd] = &&op_Madd;
+		dispatch[(int)IROp::MaddU] = &&op_MaddU;
+		dispatch[(int)IROp::Msub] = &&op_Msub;
+		dispatch[(int)IROp::MsubU] = &&op_MsubU;
+		dispatch[(int)IROp::Div] = &&op_Div;
+		dispatch[(int)IROp::DivU] = &&op_DivU;
+		dispatch[(int)IROp::BSwap16] = &&op_BSwap16;
+		dispatch[(int)IROp::BSwap32] = &&op_BSwap32;
+		dispatch[(int)IROp::FAdd] = &&op_FAdd;
+		dispatch[(int)IROp::FSub] = &&op_FSub;
+		dispatch[(int)IROp::FMul] = &&op_FMul;
+		dispatch[(int)IROp::FDiv] = &&op_FDiv;
+		dispatch[(int)IROp::FMin] = &&op_FMin;
+		dispatch[(int)IROp::FMax] = &&op_FMax;
+		dispatch[(int)IROp::FMov] = &&op_FMov;
+		dispatch[(int)IROp::FAbs] = &&op_FAbs;
+		dispatch[(int)IROp::FSqrt] = &&op_FSqrt;
+		dispatch[(int)IROp::FNeg] = &&op_FNeg;
+		dispatch[(int)IROp::FSat0_1] = &&op_FSat0_1;
+		dispatch[(int)IROp::FSatMinus1_1] = &&op_FSatMinus1_1;
+		dispatch[(int)IROp::FSign] = &&op_FSign;
+		dispatch[(int)IROp::FpCondToReg] = &&op_FpCondToReg;
+		dispatch[(int)IROp::VfpuCtrlToReg] = &&op_VfpuCtrlToReg;
+		dispatch[(int)IROp::FRound] = &&op_FRound;
+		dispatch[(int)IROp::FTrunc] = &&op_FTrunc;
+		dispatch[(int)IROp::FCeil] = &&op_FCeil;
+		dispatch[(int)IROp::FFloor] = &&op_FFloor;
+		dispatch[(int)IROp::FCmp] = &&op_FCmp;
+		dispatch[(int)IROp::FCvtSW] = &&op_FCvtSW;
+		dispatch[(int)IROp::FCvtWS] = &&op_FCvtWS;
+		dispatch[(int)IROp::ZeroFpCond] = &&op_ZeroFpCond;
+		dispatch[(int)IROp::FMovFromGPR] = &&op_FMovFromGPR;
+		dispatch[(int)IROp::FMovToGPR] = &&op_FMovToGPR;
+		dispatch[(int)IROp::ExitToConst] = &&op_ExitToConst;
+		dispatch[(int)IROp::ExitToReg] = &&op_ExitToReg;
+		dispatch[(int)IROp::ExitToConstIfEq] = &&op_ExitToConstIfEq;
+		dispatch[(int)IROp::ExitToConstIfNeq] = &&op_ExitToConstIfNeq;
+		dispatch[(int)IROp::ExitToConstIfGtZ] = &&op_ExitToConstIfGtZ;
+		dispatch[(int)IROp::ExitToConstIfGeZ] = &&op_ExitToConstIfGeZ;
+		dispatch[(int)IROp::ExitToConstIfLtZ] = &&op_ExitToConstIfLtZ;
+		dispatch[(int)IROp::ExitToConstIfLeZ] = &&op_ExitToConstIfLeZ;
+		dispatch[(int)IROp::Downcount] = &&op_Downcount;
+		dispatch[(int)IROp::SetPC] = &&op_SetPC;
+		dispatch[(int)IROp::SetPCConst] = &&op_SetPCConst;
+		dispatch[(int)IROp::Syscall] = &&op_Syscall;
+		dispatch[(int)IROp::ExitToPC] = &&op_ExitToPC;
+		dispatch[(int)IROp::Interpret] = &&op_Interpret;
+		dispatch[(int)IROp::CallReplacement] = &&op_CallReplacement;
+		dispatch[(int)IROp::Break] = &&op_Break;
+		dispatch[(int)IROp::Idle] = &&op_Idle;
+		dispatch[(int)IROp::SetCtrlVFPU] = &&op_SetCtrlVFPU;
+		dispatch[(int)IROp::SetCtrlVFPUReg] = &&op_SetCtrlVFPUReg;
+		dispatch[(int)IROp::SetCtrlVFPUFReg] = &&op_SetCtrlVFPUFReg;
+		dispatch[(int)IROp::Breakpoint] = &&op_Breakpoint;
+		dispatch[(int)IROp::MemoryCheck] = &&op_MemoryCheck;
+		dispatch[(int)IROp::FusedLoad32Add] = &&op_FusedLoad32Add;
+		dispatch[(int)IROp::FusedAddConstLoad32] = &&op_FusedAddConstLoad32;
+		dispatch[(int)IROp::FusedLoadVec4Vec4Mul] = &&op_FusedLoadVec4Vec4Mul;
+		dispatch[(int)IROp::FusedSltExitIf] = &&op_FusedSltExitIf;
+		dispatch[(int)IROp::FusedSltConstExitIf] = &&op_FusedSltConstExitIf;
+		dispatch[(int)IROp::ApplyRoundingMode] = &&op_ApplyRoundingMode;
+		dispatch[(int)IROp::RestoreRoundingMode] = &&op_RestoreRoundingMode;
+		dispatch[(int)IROp::UpdateRoundingMode] = &&op_UpdateRoundingMode;
+		dispatchReady = true;
+	}
+#endif
 	while (inst != end) {
 		switch (inst->op) {
-		case IROp::Nop:
+		IR_CASE(Nop):
 			_assert_(false);
 			break;
-		case IROp::SetConst:
+		IR_CASE(SetConst):
 			mips->r[inst->dest] = inst->constant;
 			break;
-		case IROp::SetConstF:
+		IR_CASE(SetConstF):
 			memcpy(&mips->f[inst->dest], &inst->constant, 4);
 			break;
-		case IROp::Add:
+		IR_CASE(Add):
 			mips->r[inst->dest] = mips->r[inst->src1] + mips->r[inst->src2];
 			break;
-		case IROp::Sub:
+		IR_CASE(Sub):
 			mips->r[inst->dest] = mips->r[inst->src1] - mips->r[inst->src2];
 			break;
-		case IROp::And:
+		IR_CASE(And):
 			mips->r[inst->dest] = mips->r[inst->src1] & mips->r[inst->src2];
 			break;
-		case IROp::Or:
+		IR_CASE(Or):
 			mips->r[inst->dest] = mips->r[inst->src1] | mips->r[inst->src2];
 			break;
-		case IROp::Xor:
+		IR_CASE(Xor):
 			mips->r[inst->dest] = mips->r[inst->src1] ^ mips->r[inst->src2];
 			break;
-		case IROp::Mov:
+		IR_CASE(Mov):
 			mips->r[inst->dest] = mips->r[inst->src1];
 			break;
-		case IROp::AddConst:
+		IR_CASE(AddConst):
 			mips->r[inst->dest] = mips->r[inst->src1] + inst->constant;
 			break;
-		case IROp::SubConst:
+		IR_CASE(SubConst):
 			mips->r[inst->dest] = mips->r[inst->src1] - inst->constant;
 			break;
-		case IROp::AndConst:
+		IR_CASE(AndConst):
 			mips->r[inst->dest] = mips->r[inst->src1] & inst->constant;
 			break;
-		case IROp::OrConst:
+		IR_CASE(OrConst):
 			mips->r[inst->dest] = mips->r[inst->src1] | inst->constant;
 			break;
-		case IROp::XorConst:
+		IR_CASE(XorConst):
 			mips->r[inst->dest] = mips->r[inst->src1] ^ inst->constant;
 			break;
-		case IROp::Neg:
+		IR_CASE(Neg):
 			mips->r[inst->dest] = -(s32)mips->r[inst->src1];
 			break;
-		case IROp::Not:
+		IR_CASE(Not):
 			mips->r[inst->dest] = ~mips->r[inst->src1];
 			break;
-		case IROp::Ext8to32:
+		IR_CASE(Ext8to32):
 			mips->r[inst->dest] = SignExtend8ToU32(mips->r[inst->src1]);
 			break;
-		case IROp::Ext16to32:
+		IR_CASE(Ext16to32):
 			mips->r[inst->dest] = SignExtend16ToU32(mips->r[inst->src1]);
 			break;
-		case IROp::ReverseBits:
+		IR_CASE(ReverseBits):
 			mips->r[inst->dest] = ReverseBits32(mips->r[inst->src1]);
 			break;
 
-		case IROp::ValidateAddress8:
+		IR_CASE(ValidateAddress8):
 			if (RunValidateAddress<1>(mips->pc, mips->r[inst->src1] + inst->constant, inst->src2)) {
 				CoreTiming::ForceCheck();
 				return mips->pc;
 			}
 		break;
-		case IROp::ValidateAddress16:
+		IR_CASE(ValidateAddress16):
 			if (RunValidateAddress<2>(mips->pc, mips->r[inst->src1] + inst->constant, inst->src2)) {
 				CoreTiming::ForceCheck();
 				return mips->pc;
 			}
 			break;
-		case IROp::ValidateAddress32:
+		IR_CASE(ValidateAddress32):
 			if (RunValidateAddress<4>(mips->pc, mips->r[inst->src1] + inst->constant, inst->src2)) {
 				CoreTiming::ForceCheck();
 				return mips->pc;
 			}
 			break;
-		case IROp::ValidateAddress128:
+		IR_CASE(ValidateAddress128):
 			if (RunValidateAddress<16>(mips->pc, mips->r[inst->src1] + inst->constant, inst->src2)) {
 				CoreTiming::ForceCheck();
 				return mips->pc;
 			}
 			break;
 
-		case IROp::Load8:
+		IR_CASE(Load8):
 			mips->r[inst->dest] = Memory::ReadUnchecked_U8(mips->r[inst->src1] + inst->constant);
 			break;
-		case IROp::Load8Ext:
+		IR_CASE(Load8Ext):
 			mips->r[inst->dest] = SignExtend8ToU32(Memory::ReadUnchecked_U8(mips->r[inst->src1] + inst->constant));
 			break;
-		case IROp::Load16:
+		IR_CASE(Load16):
 			mips->r[inst->dest] = Memory::ReadUnchecked_U16(mips->r[inst->src1] + inst->constant);
 			break;
-		case IROp::Load16Ext:
+		IR_CASE(Load16Ext):
 			mips->r[inst->dest] = SignExtend16ToU32(Memory::ReadUnchecked_U16(mips->r[inst->src1] + inst->constant));
 			break;
-		case IROp::Load32:
+		IR_CASE(Load32):
 			mips->r[inst->dest] = Memory::ReadUnchecked_U32(mips->r[inst->src1] + inst->constant);
 			break;
-		case IROp::Load32Left:
+		IR_CASE(Load32Left):
 		{
 			u32 addr = mips->r[inst->src1] + inst->constant;
 			u32 shift = (addr & 3) * 8;
@@ -210,7 +387,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			mips->r[inst->dest] = (mips->r[inst->dest] & destMask) | (mem << (24 - shift));
 			break;
 		}
-		case IROp::Load32Right:
+		IR_CASE(Load32Right):
 		{
 			u32 addr = mips->r[inst->src1] + inst->constant;
 			u32 shift = (addr & 3) * 8;
@@ -219,20 +396,20 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			mips->r[inst->dest] = (mips->r[inst->dest] & destMask) | (mem >> shift);
 			break;
 		}
-		case IROp::LoadFloat:
+		IR_CASE(LoadFloat):
 			mips->f[inst->dest] = Memory::ReadUnchecked_Float(mips->r[inst->src1] + inst->constant);
 			break;
 
-		case IROp::Store8:
+		IR_CASE(Store8):
 			Memory::WriteUnchecked_U8(mips->r[inst->src3], mips->r[inst->src1] + inst->constant);
 			break;
-		case IROp::Store16:
+		IR_CASE(Store16):
 			Memory::WriteUnchecked_U16(mips->r[inst->src3], mips->r[inst->src1] + inst->constant);
 			break;
-		case IROp::Store32:
+		IR_CASE(Store32):
 			Memory::WriteUnchecked_U32(mips->r[inst->src3], mips->r[inst->src1] + inst->constant);
 			break;
-		case IROp::Store32Left:
+		IR_CASE(Store32Left):
 		{
 			u32 addr = mips->r[inst->src1] + inst->constant;
 			u32 shift = (addr & 3) * 8;
@@ -242,7 +419,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			Memory::WriteUnchecked_U32(result, addr & 0xfffffffc);
 			break;
 		}
-		case IROp::Store32Right:
+		IR_CASE(Store32Right):
 		{
 			u32 addr = mips->r[inst->src1] + inst->constant;
 			u32 shift = (addr & 3) * 8;
@@ -252,26 +429,30 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			Memory::WriteUnchecked_U32(result, addr & 0xfffffffc);
 			break;
 		}
-		case IROp::StoreFloat:
+		IR_CASE(StoreFloat):
 			Memory::WriteUnchecked_Float(mips->f[inst->src3], mips->r[inst->src1] + inst->constant);
 			break;
 
-		case IROp::LoadVec4:
+		IR_CASE(LoadVec4):
 		{
 			u32 base = mips->r[inst->src1] + inst->constant;
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_load_ps((const float *)Memory::GetPointerUnchecked(base)));
+#elif PPSSPP_ARCH(ARM64_NEON)
+			vst1q_f32(&mips->f[inst->dest], vld1q_f32((const float *)Memory::GetPointerUnchecked(base)));
 #else
 			for (int i = 0; i < 4; i++)
 				mips->f[inst->dest + i] = Memory::ReadUnchecked_Float(base + 4 * i);
 #endif
 			break;
 		}
-		case IROp::StoreVec4:
+		IR_CASE(StoreVec4):
 		{
 			u32 base = mips->r[inst->src1] + inst->constant;
 #if defined(_M_SSE)
 			_mm_store_ps((float *)Memory::GetPointerUnchecked(base), _mm_load_ps(&mips->f[inst->dest]));
+#elif PPSSPP_ARCH(ARM64_NEON)
+			vst1q_f32((float *)Memory::GetPointerUnchecked(base), vld1q_f32(&mips->f[inst->dest]));
 #else
 			for (int i = 0; i < 4; i++)
 				Memory::WriteUnchecked_Float(mips->f[inst->dest + i], base + 4 * i);
@@ -279,17 +460,19 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4Init:
+		IR_CASE(Vec4Init):
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_load_ps(vec4InitValues[inst->src1]));
+#elif PPSSPP_ARCH(ARM64_NEON)
+			vst1q_f32(&mips->f[inst->dest], vld1q_f32(vec4InitValues[inst->src1]));
 #else
 			memcpy(&mips->f[inst->dest], vec4InitValues[inst->src1], 4 * sizeof(float));
 #endif
 			break;
 		}
 
-		case IROp::Vec4Shuffle:
+		IR_CASE(Vec4Shuffle):
 		{
 			// Can't use the SSE shuffle here because it takes an immediate. pshufb with a table would work though,
 			// or a big switch - there are only 256 shuffles possible (4^4)
@@ -298,7 +481,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4Mov:
+		IR_CASE(Vec4Mov):
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_load_ps(&mips->f[inst->src1]));
@@ -310,7 +493,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4Add:
+		IR_CASE(Vec4Add):
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_add_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_load_ps(&mips->f[inst->src2])));
@@ -323,7 +506,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4Sub:
+		IR_CASE(Vec4Sub):
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_sub_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_load_ps(&mips->f[inst->src2])));
@@ -336,7 +519,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4Mul:
+		IR_CASE(Vec4Mul):
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_mul_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_load_ps(&mips->f[inst->src2])));
@@ -349,10 +532,12 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4Div:
+		IR_CASE(Vec4Div):
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_div_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_load_ps(&mips->f[inst->src2])));
+#elif PPSSPP_ARCH(ARM64_NEON)
+			vst1q_f32(&mips->f[inst->dest], vdivq_f32(vld1q_f32(&mips->f[inst->src1]), vld1q_f32(&mips->f[inst->src2])));
 #else
 			for (int i = 0; i < 4; i++)
 				mips->f[inst->dest + i] = mips->f[inst->src1 + i] / mips->f[inst->src2 + i];
@@ -360,10 +545,12 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4Scale:
+		IR_CASE(Vec4Scale):
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_mul_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_set1_ps(mips->f[inst->src2])));
+#elif PPSSPP_ARCH(ARM64_NEON)
+			vst1q_f32(&mips->f[inst->dest], vmulq_n_f32(vld1q_f32(&mips->f[inst->src1]), mips->f[inst->src2]));
 #else
 			for (int i = 0; i < 4; i++)
 				mips->f[inst->dest + i] = mips->f[inst->src1 + i] * mips->f[inst->src2];
@@ -371,7 +558,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4Neg:
+		IR_CASE(Vec4Neg):
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_xor_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_load_ps((const float *)signBits)));
@@ -384,7 +571,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4Abs:
+		IR_CASE(Vec4Abs):
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_and_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_load_ps((const float *)noSignMask)));
@@ -397,21 +584,21 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec2Unpack16To31:
+		IR_CASE(Vec2Unpack16To31):
 		{
 			mips->fi[inst->dest] = (mips->fi[inst->src1] << 16) >> 1;
 			mips->fi[inst->dest + 1] = (mips->fi[inst->src1] & 0xFFFF0000) >> 1;
 			break;
 		}
 
-		case IROp::Vec2Unpack16To32:
+		IR_CASE(Vec2Unpack16To32):
 		{
 			mips->fi[inst->dest] = (mips->fi[inst->src1] << 16);
 			mips->fi[inst->dest + 1] = (mips->fi[inst->src1] & 0xFFFF0000);
 			break;
 		}
 
-		case IROp::Vec4Unpack8To32:
+		IR_CASE(Vec4Unpack8To32):
 		{
 #if defined(_M_SSE)
 			__m128i src = _mm_cvtsi32_si128(mips->fi[inst->src1]);
@@ -427,14 +614,14 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec2Pack32To16:
+		IR_CASE(Vec2Pack32To16):
 		{
 			u32 val = mips->fi[inst->src1] >> 16;
 			mips->fi[inst->dest] = (mips->fi[inst->src1 + 1] & 0xFFFF0000) | val;
 			break;
 		}
 
-		case IROp::Vec2Pack31To16:
+		IR_CASE(Vec2Pack31To16):
 		{
 			u32 val = (mips->fi[inst->src1] >> 15) & 0xFFFF;
 			val |= (mips->fi[inst->src1 + 1] << 1) & 0xFFFF0000;
@@ -442,7 +629,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4Pack32To8:
+		IR_CASE(Vec4Pack32To8):
 		{
 			// Removed previous SSE code due to the need for unsigned 16-bit pack, which I'm too lazy to work around the lack of in SSE2.
 			// pshufb or SSE4 instructions can be used instead.
@@ -454,7 +641,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4Pack31To8:
+		IR_CASE(Vec4Pack31To8):
 		{
 			// Removed previous SSE code due to the need for unsigned 16-bit pack, which I'm too lazy to work around the lack of in SSE2.
 			// pshufb or SSE4 instructions can be used instead.
@@ -466,7 +653,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec2ClampToZero:
+		IR_CASE(Vec2ClampToZero):
 		{
 			for (int i = 0; i < 2; i++) {
 				u32 val = mips->fi[inst->src1 + i];
@@ -475,7 +662,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4ClampToZero:
+		IR_CASE(Vec4ClampToZero):
 		{
 #if defined(_M_SSE)
 			// Trickery: Expand the sign bit, and use andnot to zero negative values.
@@ -492,7 +679,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Vec4DuplicateUpperBitsAndShift1:  // For vuc2i, the weird one.
+		IR_CASE(Vec4DuplicateUpperBitsAndShift1):  // For vuc2i, the weird one.
 		{
 			for (int i = 0; i < 4; i++) {
 				u32 val = mips->fi[inst->src1 + i];
@@ -504,7 +691,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::FCmpVfpuBit:
+		IR_CASE(FCmpVfpuBit):
 		{
 			int op = inst->dest & 0xF;
 			int bit = inst->dest >> 4;
@@ -537,7 +724,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::FCmpVfpuAggregate:
+		IR_CASE(FCmpVfpuAggregate):
 		{
 			u32 mask = inst->dest;
 			u32 cc = mips->vfpuCtrl[VFPU_CTRL_CC];
@@ -547,48 +734,62 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::FCmovVfpuCC:
+		IR_CASE(FCmovVfpuCC):
 			if (((mips->vfpuCtrl[VFPU_CTRL_CC] >> (inst->src2 & 0xf)) & 1) == ((u32)inst->src2 >> 7)) {
 				mips->f[inst->dest] = mips->f[inst->src1];
 			}
 			break;
 
-		// Not quickly implementable on all platforms, unfortunately.
-		case IROp::Vec4Dot:
+		// The multiplies can be done wide, but the sum must stay in order to match the scalar code exactly.
+		IR_CASE(Vec4Dot):
 		{
+#if defined(_M_SSE)
+			__m128 prod = _mm_mul_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_load_ps(&mips->f[inst->src2]));
+			__m128 dot = _mm_add_ss(prod, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(1, 1, 1, 1)));
+			dot = _mm_add_ss(dot, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(2, 2, 2, 2)));
+			dot = _mm_add_ss(dot, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(3, 3, 3, 3)));
+			_mm_store_ss(&mips->f[inst->dest], dot);
+#elif PPSSPP_ARCH(ARM64_NEON)
+			float32x4_t prod = vmulq_f32(vld1q_f32(&mips->f[inst->src1]), vld1q_f32(&mips->f[inst->src2]));
+			float dot = vgetq_lane_f32(prod, 0) + vgetq_lane_f32(prod, 1);
+			dot += vgetq_lane_f32(prod, 2);
+			dot += vgetq_lane_f32(prod, 3);
+			mips->f[inst->dest] = dot;
+#else
 			float dot = mips->f[inst->src1] * mips->f[inst->src2];
 			for (int i = 1; i < 4; i++)
 				dot += mips->f[inst->src1 + i] * mips->f[inst->src2 + i];
 			mips->f[inst->dest] = dot;
+#endif
 			break;
 		}
 
-		case IROp::FSin:
+		IR_CASE(FSin):
 			mips->f[inst->dest] = vfpu_sin(mips->f[inst->src1]);
 			break;
-		case IROp::FCos:
+		IR_CASE(FCos):
 			mips->f[inst->dest] = vfpu_cos(mips->f[inst->src1]);
 			break;
-		case IROp::FRSqrt:
+		IR_CASE(FRSqrt):
 			mips->f[inst->dest] = 1.0f / sqrtf(mips->f[inst->src1]);
 			break;
-		case IROp::FRecip:
+		IR_CASE(FRecip):
 			mips->f[inst->dest] = 1.0f / mips->f[inst->src1];
 			break;
-		case IROp::FAsin:
+		IR_CASE(FAsin):
 			mips->f[inst->dest] = vfpu_asin(mips->f[inst->src1]);
 			break;
 
-		case IROp::ShlImm:
+		IR_CASE(ShlImm):
 			mips->r[inst->dest] = mips->r[inst->src1] << (int)inst->src2;
 			break;
-		case IROp::ShrImm:
+		IR_CASE(ShrImm):
 			mips->r[inst->dest] = mips->r[inst->src1] >> (int)inst->src2;
 			break;
-		case IROp::SarImm:
+		IR_CASE(SarImm):
 			mips->r[inst->dest] = (s32)mips->r[inst->src1] >> (int)inst->src2;
 			break;
-		case IROp::RorImm:
+		IR_CASE(RorImm):
 		{
 			u32 x = mips->r[inst->src1];
 			int sa = inst->src2;
@@ -596,16 +797,16 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 		}
 		break;
 
-		case IROp::Shl:
+		IR_CASE(Shl):
 			mips->r[inst->dest] = mips->r[inst->src1] << (mips->r[inst->src2] & 31);
 			break;
-		case IROp::Shr:
+		IR_CASE(Shr):
 			mips->r[inst->dest] = mips->r[inst->src1] >> (mips->r[inst->src2] & 31);
 			break;
-		case IROp::Sar:
+		IR_CASE(Sar):
 			mips->r[inst->dest] = (s32)mips->r[inst->src1] >> (mips->r[inst->src2] & 31);
 			break;
-		case IROp::Ror:
+		IR_CASE(Ror):
 		{
 			u32 x = mips->r[inst->src1];
 			int sa = mips->r[inst->src2] & 31;
@@ -613,70 +814,70 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Clz:
+		IR_CASE(Clz):
 		{
 			mips->r[inst->dest] = clz32(mips->r[inst->src1]);
 			break;
 		}
 
-		case IROp::Slt:
+		IR_CASE(Slt):
 			mips->r[inst->dest] = (s32)mips->r[inst->src1] < (s32)mips->r[inst->src2];
 			break;
 
-		case IROp::SltU:
+		IR_CASE(SltU):
 			mips->r[inst->dest] = mips->r[inst->src1] < mips->r[inst->src2];
 			break;
 
-		case IROp::SltConst:
+		IR_CASE(SltConst):
 			mips->r[inst->dest] = (s32)mips->r[inst->src1] < (s32)inst->constant;
 			break;
 
-		case IROp::SltUConst:
+		IR_CASE(SltUConst):
 			mips->r[inst->dest] = mips->r[inst->src1] < inst->constant;
 			break;
 
-		case IROp::MovZ:
+		IR_CASE(MovZ):
 			if (mips->r[inst->src1] == 0)
 				mips->r[inst->dest] = mips->r[inst->src2];
 			break;
-		case IROp::MovNZ:
+		IR_CASE(MovNZ):
 			if (mips->r[inst->src1] != 0)
 				mips->r[inst->dest] = mips->r[inst->src2];
 			break;
 
-		case IROp::Max:
+		IR_CASE(Max):
 			mips->r[inst->dest] = (s32)mips->r[inst->src1] > (s32)mips->r[inst->src2] ? mips->r[inst->src1] : mips->r[inst->src2];
 			break;
-		case IROp::Min:
+		IR_CASE(Min):
 			mips->r[inst->dest] = (s32)mips->r[inst->src1] < (s32)mips->r[inst->src2] ? mips->r[inst->src1] : mips->r[inst->src2];
 			break;
 
-		case IROp::MtLo:
+		IR_CASE(MtLo):
 			mips->lo = mips->r[inst->src1];
 			break;
-		case IROp::MtHi:
+		IR_CASE(MtHi):
 			mips->hi = mips->r[inst->src1];
 			break;
-		case IROp::MfLo:
+		IR_CASE(MfLo):
 			mips->r[inst->dest] = mips->lo;
 			break;
-		case IROp::MfHi:
+		IR_CASE(MfHi):
 			mips->r[inst->dest] = mips->hi;
 			break;
 
-		case IROp::Mult:
+		IR_CASE(Mult):
 		{
 			s64 result = (s64)(s32)mips->r[inst->src1] * (s64)(s32)mips->r[inst->src2];
 			memcpy(&mips->lo, &result, 8);
 			break;
 		}
-		case IROp::MultU:
+		IR_CASE(MultU):
 		{
 			u64 result = (u64)mips->r[inst->src1] * (u64)mips->r[inst->src2];
 			memcpy(&mips->lo, &result, 8);
 			break;
 		}
-		case IROp::Madd:
+		IR_CASE(Madd):
 		{
 			s64 result;
 			memcpy(&result, &mips->lo, 8);
@@ -684,7 +885,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			memcpy(&mips->lo, &result, 8);
 			break;
 		}
-		case IROp::MaddU:
+		IR_CASE(MaddU):
 		{
 			s64 result;
 			memcpy(&result, &mips->lo, 8);
@@ -692,7 +893,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			memcpy(&mips->lo, &result, 8);
 			break;
 		}
-		case IROp::Msub:
+		IR_CASE(Msub):
 		{
 			s64 result;
 			memcpy(&result, &mips->lo, 8);
@@ -700,7 +901,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			memcpy(&mips->lo, &result, 8);
 			break;
 		}
-		case IROp::MsubU:
+		IR_CASE(MsubU):
 		{
 			s64 result;
 			memcpy(&result, &mips->lo, 8);
@@ -709,7 +910,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Div:
+		IR_CASE(Div):
 		{
 			s32 numerator = (s32)mips->r[inst->src1];
 			s32 denominator = (s32)mips->r[inst->src2];
@@ -725,7 +926,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			}
 			break;
 		}
-		case IROp::DivU:
+		IR_CASE(DivU):
 		{
 			u32 numerator = mips->r[inst->src1];
 			u32 denominator = mips->r[inst->src2];
@@ -739,64 +940,64 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::BSwap16:
+		IR_CASE(BSwap16):
 		{
 			u32 x = mips->r[inst->src1];
 			mips->r[inst->dest] = ((x & 0xFF00FF00) >> 8) | ((x & 0x00FF00FF) << 8);
 			break;
 		}
-		case IROp::BSwap32:
+		IR_CASE(BSwap32):
 		{
 			u32 x = mips->r[inst->src1];
 			mips->r[inst->dest] = ((x & 0xFF000000) >> 24) | ((x & 0x00FF0000) >> 8) | ((x & 0x0000FF00) << 8) | ((x & 0x000000FF) << 24);
 			break;
 		}
 
-		case IROp::FAdd:
+		IR_CASE(FAdd):
 			mips->f[inst->dest] = mips->f[inst->src1] + mips->f[inst->src2];
 			break;
-		case IROp::FSub:
+		IR_CASE(FSub):
 			mips->f[inst->dest] = mips->f[inst->src1] - mips->f[inst->src2];
 			break;
-		case IROp::FMul:
+		IR_CASE(FMul):
 			if ((my_isinf(mips->f[inst->src1]) && mips->f[inst->src2] == 0.0f) || (my_isinf(mips->f[inst->src2]) && mips->f[inst->src1] == 0.0f)) {
 				mips->fi[inst->dest] = 0x7fc00000;
 			} else {
 				mips->f[inst->dest] = mips->f[inst->src1] * mips->f[inst->src2];
 			}
 			break;
-		case IROp::FDiv:
+		IR_CASE(FDiv):
 			mips->f[inst->dest] = mips->f[inst->src1] / mips->f[inst->src2];
 			break;
-		case IROp::FMin:
+		IR_CASE(FMin):
 			mips->f[inst->dest] = std::min(mips->f[inst->src1], mips->f[inst->src2]);
 			break;
-		case IROp::FMax:
+		IR_CASE(FMax):
 			mips->f[inst->dest] = std::max(mips->f[inst->src1], mips->f[inst->src2]);
 			break;
 
-		case IROp::FMov:
+		IR_CASE(FMov):
 			mips->f[inst->dest] = mips->f[inst->src1];
 			break;
-		case IROp::FAbs:
+		IR_CASE(FAbs):
 			mips->f[inst->dest] = fabsf(mips->f[inst->src1]);
 			break;
-		case IROp::FSqrt:
+		IR_CASE(FSqrt):
 			mips->f[inst->dest] = sqrtf(mips->f[inst->src1]);
 			break;
-		case IROp::FNeg:
+		IR_CASE(FNeg):
 			mips->f[inst->dest] = -mips->f[inst->src1];
 			break;
-		case IROp::FSat0_1:
+		IR_CASE(FSat0_1):
 			// We have to do this carefully to handle NAN and -0.0f.
 			mips->f[inst->dest] = vfpu_clamp(mips->f[inst->src1], 0.0f, 1.0f);
 			break;
-		case IROp::FSatMinus1_1:
+		IR_CASE(FSatMinus1_1):
 			mips->f[inst->dest] = vfpu_clamp(mips->f[inst->src1], -1.0f, 1.0f);
 			break;
 
 		// Bitwise trickery
-		case IROp::FSign:
+		IR_CASE(FSign):
 		{
 			u32 val;
 			memcpy(&val, &mips->f[inst->src1], sizeof(u32));
@@ -809,13 +1010,13 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::FpCondToReg:
+		IR_CASE(FpCondToReg):
 			mips->r[inst->dest] = mips->fpcond;
 			break;
-		case IROp::VfpuCtrlToReg:
+		IR_CASE(VfpuCtrlToReg):
 			mips->r[inst->dest] = mips->vfpuCtrl[inst->src1];
 			break;
-		case IROp::FRound:
+		IR_CASE(FRound):
 		{
 			float value = mips->f[inst->src1];
 			if (my_isnanorinf(value)) {
@@ -826,7 +1027,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			}
 			break;
 		}
-		case IROp::FTrunc:
+		IR_CASE(FTrunc):
 		{
 			float value = mips->f[inst->src1];
 			if (my_isnanorinf(value)) {
@@ -846,7 +1047,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 				break;
 			}
 		}
-		case IROp::FCeil:
+		IR_CASE(FCeil):
 		{
 			float value = mips->f[inst->src1];
 			if (my_isnanorinf(value)) {
@@ -857,7 +1058,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			}
 			break;
 		}
-		case IROp::FFloor:
+		IR_CASE(FFloor):
 		{
 			float value = mips->f[inst->src1];
 			if (my_isnanorinf(value)) {
@@ -868,7 +1069,7 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			}
 			break;
 		}
-		case IROp::FCmp:
+		IR_CASE(FCmp):
 			switch (inst->dest) {
 			case IRFpCompareMode::False:
 				mips->fpcond = 0;
@@ -901,10 +1102,10 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			}
 			break;
 
-		case IROp::FCvtSW:
+		IR_CASE(FCvtSW):
 			mips->f[inst->dest] = (float)mips->fs[inst->src1];
 			break;
-		case IROp::FCvtWS:
+		IR_CASE(FCvtWS):
 		{
 			float src = mips->f[inst->src1];
 			if (my_isnanorinf(src)) {
@@ -920,61 +1121,61 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break; //cvt.w.s
 		}
 
-		case IROp::ZeroFpCond:
+		IR_CASE(ZeroFpCond):
 			mips->fpcond = 0;
 			break;
 
-		case IROp::FMovFromGPR:
+		IR_CASE(FMovFromGPR):
 			memcpy(&mips->f[inst->dest], &mips->r[inst->src1], 4);
 			break;
-		case IROp::FMovToGPR:
+		IR_CASE(FMovToGPR):
 			memcpy(&mips->r[inst->dest], &mips->f[inst->src1], 4);
 			break;
 
-		case IROp::ExitToConst:
+		IR_CASE(ExitToConst):
 			return inst->constant;
 
-		case IROp::ExitToReg:
+		IR_CASE(ExitToReg):
 			return mips->r[inst->src1];
 
-		case IROp::ExitToConstIfEq:
+		IR_CASE(ExitToConstIfEq):
 			if (mips->r[inst->src1] == mips->r[inst->src2])
 				return inst->constant;
 			break;
-		case IROp::ExitToConstIfNeq:
+		IR_CASE(ExitToConstIfNeq):
 			if (mips->r[inst->src1] != mips->r[inst->src2])
 				return inst->constant;
 			break;
-		case IROp::ExitToConstIfGtZ:
+		IR_CASE(ExitToConstIfGtZ):
 			if ((s32)mips->r[inst->src1] > 0)
 				return inst->constant;
 			break;
-		case IROp::ExitToConstIfGeZ:
+		IR_CASE(ExitToConstIfGeZ):
 			if ((s32)mips->r[inst->src1] >= 0)
 				return inst->constant;
 			break;
-		case IROp::ExitToConstIfLtZ:
+		IR_CASE(ExitToConstIfLtZ):
 			if ((s32)mips->r[inst->src1] < 0)
 				return inst->constant;
 			break;
-		case IROp::ExitToConstIfLeZ:
+		IR_CASE(ExitToConstIfLeZ):
 			if ((s32)mips->r[inst->src1] <= 0)
 				return inst->constant;
 			break;
 
-		case IROp::Downcount:
+		IR_CASE(Downcount):
 			mips->downcount -= inst->constant;
 			break;
 
-		case IROp::SetPC:
+		IR_CASE(SetPC):
 			mips->pc = mips->r[inst->src1];
 			break;
 
-		case IROp::SetPCConst:
+		IR_CASE(SetPCConst):
 			mips->pc = inst->constant;
 			break;
 
-		case IROp::Syscall:
+		IR_CASE(Syscall):
 			// IROp::SetPC was (hopefully) executed before.
 		{
 			MIPSOpcode op(inst->constant);
@@ -984,17 +1185,17 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::ExitToPC:
+		IR_CASE(ExitToPC):
 			return mips->pc;
 
-		case IROp::Interpret:  // SLOW fallback. Can be made faster. Ideally should be removed but may be useful for debugging.
+		IR_CASE(Interpret):  // SLOW fallback. Can be made faster. Ideally should be removed but may be useful for debugging.
 		{
 			MIPSOpcode op(inst->constant);
 			MIPSInterpret(op);
 			break;
 		}
 
-		case IROp::CallReplacement:
+		IR_CASE(CallReplacement):
 		{
 			int funcIndex = inst->constant;
 			const ReplacementTableEntry *f = GetReplacementFunc(funcIndex);
@@ -1003,47 +1204,81 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
-		case IROp::Break:
+		IR_CASE(Break):
 			Core_Break(mips->pc);
 			return mips->pc + 4;
 
-		case IROp::SetCtrlVFPU:
+		IR_CASE(Idle):
+			CoreTiming::Idle();
+			break;
+
+		IR_CASE(SetCtrlVFPU):
 			mips->vfpuCtrl[inst->dest] = inst->constant;
 			break;
 
-		case IROp::SetCtrlVFPUReg:
+		IR_CASE(SetCtrlVFPUReg):
 			mips->vfpuCtrl[inst->dest] = mips->r[inst->src1];
 			break;
 
-		case IROp::SetCtrlVFPUFReg:
+		IR_CASE(SetCtrlVFPUFReg):
 			memcpy(&mips->vfpuCtrl[inst->dest], &mips->f[inst->src1], 4);
 			break;
 
-		case IROp::Breakpoint:
+		IR_CASE(Breakpoint):
 			if (RunBreakpoint(mips->pc)) {
 				CoreTiming::ForceCheck();
 				return mips->pc;
 			}
 			break;
 
-		case IROp::MemoryCheck:
+		IR_CASE(MemoryCheck):
 			if (RunMemCheck(mips->pc, mips->r[inst->src1] + inst->constant)) {
 				CoreTiming::ForceCheck();
 				return mips->pc;
 			}
 			break;
 
-		case IROp::ApplyRoundingMode:
+		IR_CASE(FusedLoad32Add):
+			mips->r[inst->dest] = Memory::ReadUnchecked_U32(mips->r[inst->src1] + inst->constant);
+			IR_THEN(Add);
+		IR_CASE(FusedAddConstLoad32):
+			mips->r[inst->dest] = mips->r[inst->src1] + inst->constant;
+			IR_THEN(Load32);
+		IR_CASE(FusedLoadVec4Vec4Mul):
+		{
+			u32 base = mips->r[inst->src1] + inst->constant;
+#if defined(_M_SSE)
+			_mm_store_ps(&mips->f[inst->dest], _mm_load_ps((const float *)Memory::GetPointerUnchecked(base)));
+#elif PPSSPP_ARCH(ARM64_NEON)
+			vst1q_f32(&mips->f[inst->dest], vld1q_f32((const float *)Memory::GetPointerUnchecked(base)));
+#else
+			for (int i = 0; i < 4; i++)
+				mips->f[inst->dest + i] = Memory::ReadUnchecked_Float(base + 4 * i);
+#endif
+			IR_THEN(Vec4Mul);
+		}
+		IR_CASE(FusedSltExitIf):
+			mips->r[inst->dest] = (s32)mips->r[inst->src1] < (s32)mips->r[inst->src2];
+			if (inst[1].op == IROp::ExitToConstIfEq)
+				IR_THEN(ExitToConstIfEq);
+			IR_THEN(ExitToConstIfNeq);
+		IR_CASE(FusedSltConstExitIf):
+			mips->r[inst->dest] = (s32)mips->r[inst->src1] < (s32)inst->constant;
+			if (inst[1].op == IROp::ExitToConstIfEq)
+				IR_THEN(ExitToConstIfEq);
+			IR_THEN(ExitToConstIfNeq);
+
+		IR_CASE(ApplyRoundingMode):
 			// TODO: Implement
 			break;
-		case IROp::RestoreRoundingMode:
+		IR_CASE(RestoreRoundingMode):
 			// TODO: Implement
 			break;
-		case IROp::UpdateRoundingMode:
+		IR_CASE(UpdateRoundingMode):
 			// TODO: Implement
 			break;
 
-		default:
+		IR_DEFAULT:
 			// Unimplemented IR op. Bad.
 			Crash();
 		}
@@ -1052,6 +1287,10 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			Crash();
 #endif
 		inst++;
+#ifdef IR_COMPUTED_GOTO
+		if (inst != end)
+			goto *dispatch[(int)inst->op];
+#endif
 	}
 
 	// If we got here, the block was badly constructed.
@@ -15,18 +15,25 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <set>
 
 #include "ext/xxhash.h"
 #include "Common/Profiler/Profiler.h"
 
 #include "Common/Log.h"
+#include "Common/MemoryUtil.h"
+#include "Common/File/FileUtil.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadManager.h"
 
 #include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/System.h"
+#include "Core/Debugger/Breakpoints.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/HLE/sceKernelMemory.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
@@ -40,23 +47,193 @@
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/Reporting.h"
 
+#if PPSSPP_ARCH(AMD64)
+#include "Core/MIPS/x86/IRToX86.h"
+#elif PPSSPP_ARCH(RISCV64)
+#include "Core/MIPS/RiscV/IRToRiscV.h"
+#endif
+
 namespace MIPSComp {
 
-IRJit::IRJit(MIPSState *mipsState) : frontend_(mipsState->HasDefaultPrefix()), mips_(mipsState) {
+IRJit::IRJit(MIPSState *mipsState, bool useNative) : frontend_(mipsState->HasDefaultPrefix()), mips_(mipsState) {
 	// u32 size = 128 * 1024;
 	// blTrampolines_ = kernelMemory.Alloc(size, true, "trampoline");
 	InitIR();
+	IRResetPassStats();
 
 	IROptions opts{};
 	opts.disableFlags = g_Config.uJitDisableFlags;
 	opts.unalignedLoadStore = (opts.disableFlags & (uint32_t)JitDisable::LSU_UNALIGNED) == 0;
+	opts.idleLoops = (opts.disableFlags & (uint32_t)JitDisable::IDLE_LOOPS) == 0;
+	opts.continueJumps = g_Config.bIRJitTraces;
+	opts.continueBranches = g_Config.bIRJitTraces;
+	opts.continueMaxInstructions = jo.continueMaxInstructions;
+
+#if PPSSPP_ARCH(AMD64)
+	if (useNative)
+		native_ = new IRToX86();
+#elif PPSSPP_ARCH(RISCV64)
+	if (useNative)
+		native_ = new IRToRiscV();
+#endif
+	if (useNative && !native_)
+		WARN_LOG(JIT, "IRJit: No native backend for this platform, interpreting IR instead");
+	opts.fuseOpPairs = native_ == nullptr;
 	frontend_.SetOptions(opts);
+	if (native_) {
+		tierThreshold_ = std::max(0, g_Config.iIRJitTierThreshold);
+		asyncTierUp_ = tierThreshold_ != 0 && !PlatformIsWXExclusive() && g_threadManager.IsInitialized();
+		blocks_.SetTierThreshold(tierThreshold_);
+	}
+	asyncCompile_ = g_Config.bJitBackgroundCompile && g_threadManager.IsInitialized();
+
+	LoadDiskCache();
 }
 
 IRJit::~IRJit() {
+	WaitForBackgroundCompiles();
+	SaveDiskCache();
+	delete native_;
+}
+
+static const u32 IRDISKCACHE_MAGIC = 0x43424952;  // "IRBC"
+// Bump on any change to the IR or to this format.  The git version is also checked.
+static const u32 IRDISKCACHE_VERSION = 2;
+
+struct IRDiskCacheHeader {
+	u32 magic;
+	u32 version;
+	char gitVersion[32];
+	u32 disableFlags;
+	u32 unalignedLoadStore;
+	u32 fuseOpPairs;
+	u32 numBlocks;
+	u32 instSize;
+};
+
+struct IRDiskCacheBlock {
+	u32 origAddr;
+	u32 origSize;
+	u64 hash;
+	u32 numInstructions;
+	u32 reserved;
+};
+
+static_assert(sizeof(IRInst) == 8, "IRInst is written to disk as-is");
+
+static void FillDiskCacheHeader(IRDiskCacheHeader &header, const IROptions &opts) {
+	memset(&header, 0, sizeof(header));
+	header.magic = IRDISKCACHE_MAGIC;
+	header.version = IRDISKCACHE_VERSION;
+	truncate_cpy(header.gitVersion, PPSSPP_GIT_VERSION);
+	header.disableFlags = opts.disableFlags;
+	header.unalignedLoadStore = opts.unalignedLoadStore ? 1 : 0;
+	header.fuseOpPairs = opts.fuseOpPairs ? 1 : 0;
+	header.instSize = (u32)sizeof(IRInst);
+}
+
+void IRJit::LoadDiskCache() {
+	if (!g_Config.bIRJitDiskCache)
+		return;
+	std::string discID = g_paramSFO.GetDiscID();
+	if (discID.empty())
+		return;
+
+	File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+	diskCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".irjitcache");
+
+	FILE *f = File::OpenCFile(diskCachePath_, "rb");
+	if (!f)
+		return;
+
+	IRDiskCacheHeader expected, header;
+	FillDiskCacheHeader(expected, frontend_.GetOptions());
+	bool valid = fread(&header, sizeof(header), 1, f) == 1;
+	valid = valid && header.magic == expected.magic && header.version == expected.version && header.instSize == expected.instSize;
+	valid = valid && memcmp(header.gitVersion, expected.gitVersion, sizeof(header.gitVersion)) == 0;
+	valid = valid && header.disableFlags == expected.disableFlags && header.unalignedLoadStore == expected.unalignedLoadStore;
+	valid = valid && header.fuseOpPairs == expected.fuseOpPairs;
+	if (!valid) {
+		INFO_LOG(JIT, "IRJit: Ignoring incompatible disk cache %s", diskCachePath_.c_str());
+		fclose(f);
+		return;
+	}
+
+	std::vector<IRInst> instructions;
+	u32 loaded = 0;
+	for (u32 i = 0; i < header.numBlocks; ++i) {
+		IRDiskCacheBlock entry;
+		if (fread(&entry, sizeof(entry), 1, f) != 1)
+			break;
+		// Sanity check, the count is stored as u16 in IRBlock.
+		if (entry.numInstructions == 0 || entry.numInstructions > 0xFFFF)
+			break;
+		instructions.resize(entry.numInstructions);
+		if (fread(&instructions[0], sizeof(IRInst), entry.numInstructions, f) != entry.numInstructions)
+			break;
+		if (!Memory::IsValidRange(entry.origAddr, entry.origSize))
+			continue;
+
+		int block_num = blocks_.AddCachedBlock(entry.origAddr, entry.origSize, entry.hash, instructions);
+		if ((block_num & ~MIPS_EMUHACK_VALUE_MASK) != 0)
+			break;
+		loaded++;
+	}
+	fclose(f);
+
+	if (loaded != header.numBlocks) {
+		WARN_LOG(JIT, "IRJit: Disk cache truncated, loaded %d of %d blocks", loaded, header.numBlocks);
+	} else {
+		NOTICE_LOG(JIT, "IRJit: Loaded %d blocks from disk cache", loaded);
+	}
+	diskCacheLoaded_ = loaded != 0;
+}
+
+void IRJit::SaveDiskCache() {
+	// Nothing new to write out, the file on disk is already as good as it gets.
+	if (diskCachePath_.empty() || blocksCompiled_ == 0)
+		return;
+
+	std::vector<int> toSave;
+	for (int i = 0; i < blocks_.GetNumBlocks(); ++i) {
+		const IRBlock *b = blocks_.GetBlock(i);
+		u32 start, size;
+		b->GetRange(start, size);
+		// Destroyed blocks have a zero address, and unhashed ones couldn't be validated.
+		// Traces aren't saved, the format only has room for one range.
+		if (start != 0 && b->GetHash() != 0 && b->GetNumInstructions() != 0 && b->GetContinuedRanges().empty())
+			toSave.push_back(i);
+	}
+
+	FILE *f = File::OpenCFile(diskCachePath_, "wb");
+	if (!f)
+		return;
+
+	IRDiskCacheHeader header;
+	FillDiskCacheHeader(header, frontend_.GetOptions());
+	header.numBlocks = (u32)toSave.size();
+	bool writeFailed = fwrite(&header, sizeof(header), 1, f) != 1;
+	for (int i : toSave) {
+		const IRBlock *b = blocks_.GetBlock(i);
+		IRDiskCacheBlock entry{};
+		b->GetRange(entry.origAddr, entry.origSize);
+		entry.hash = b->GetHash();
+		entry.numInstructions = b->GetNumInstructions();
+		writeFailed = writeFailed || fwrite(&entry, sizeof(entry), 1, f) != 1;
+		writeFailed = writeFailed || fwrite(b->GetInstructions(), sizeof(IRInst), entry.numInstructions, f) != entry.numInstructions;
+	}
+	fclose(f);
+
+	if (writeFailed) {
+		ERROR_LOG(JIT, "IRJit: Failed to write disk cache, disk full?");
+		File::Delete(diskCachePath_);
+	} else {
+		INFO_LOG(JIT, "IRJit: Saved %d blocks to disk cache", (int)toSave.size());
+	}
 }
 
 void IRJit::DoState(PointerWrap &p) {
+	WaitForBackgroundCompiles(false);
 	frontend_.DoState(p);
 }
 
@@ -65,35 +242,60 @@ void IRJit::UpdateFCR31() {
 
 void IRJit::ClearCache() {
 	INFO_LOG(JIT, "IRJit: Clearing the cache!");
+	// Can't clear the code space while a background compile is writing to it.
+	WaitForBackgroundCompiles();
 	blocks_.Clear();
+	if (native_)
+		native_->ClearCode();
 }
 
 void IRJit::InvalidateCacheAt(u32 em_address, int length) {
+	// Restores original ops, which a background compile may be reading.
+	std::lock_guard<std::mutex> guard(blockCacheLock_);
 	blocks_.InvalidateICache(em_address, length);
 }
 
+bool IRJit::ReusePreloadBlock(u32 em_address) {
+	if (!g_Config.bPreloadFunctions && !diskCacheLoaded_)
+		return false;
+
+	// Look to see if we've preloaded this block, or have it from the disk cache.
+	int block_num = blocks_.FindPreloadBlock(em_address);
+	IRBlock *b = blocks_.GetBlock(block_num);
+	if (b) {
+		// These were compiled without any breakpoint checks, so only reuse when there are none.
+		u32 start, size;
+		b->GetRange(start, size);
+		if (CBreakPoints::HasMemChecks() || CBreakPoints::RangeContainsBreakPoint(start, size))
+			b = nullptr;
+	}
+	if (b && tierThreshold_ == 0 && !b->GetNativeEntry() && !CompileNative(block_num)) {
+		// Out of native code space, start over and let the caller compile fresh.
+		ClearCache();
+		b = nullptr;
+	}
+	if (b) {
+		// Okay, let's link and finalize the block now.
+		std::lock_guard<std::mutex> guard(blockCacheLock_);
+		b->Finalize(block_num);
+		return b->IsValid();
+	}
+	return false;
+}
+
 void IRJit::Compile(u32 em_address) {
 	PROFILE_THIS_SCOPE("jitc");
 
-	if (g_Config.bPreloadFunctions) {
-		// Look to see if we've preloaded this block.
-		int block_num = blocks_.FindPreloadBlock(em_address);
-		if (block_num != -1) {
-			IRBlock *b = blocks_.GetBlock(block_num);
-			// Okay, let's link and finalize the block now.
-			b->Finalize(block_num);
-			if (b->IsValid()) {
-				// Success, we're done.
-				return;
-			}
-		}
+	if (ReusePreloadBlock(em_address)) {
+		// Success, we're done.
+		return;
 	}
 
 	std::vector<IRInst> instructions;
 	u32 mipsBytes;
 	if (!CompileBlock(em_address, instructions, mipsBytes, false)) {
-		// Ran out of block numbers - need to reset.
-		ERROR_LOG(JIT, "Ran out of block numbers, clearing cache");
+		// Ran out of block numbers or native code space - need to reset.
+		ERROR_LOG(JIT, "Ran out of block numbers or code space, clearing cache");
 		ClearCache();
 		CompileBlock(em_address, instructions, mipsBytes, false);
 	}
@@ -122,21 +324,267 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 	IRBlock *b = blocks_.GetBlock(block_num);
 	b->SetInstructions(instructions);
 	b->SetOriginalSize(mipsBytes);
+	b->SetContinuedRanges(frontend_.GetContinuedRanges());
 	if (preload) {
 		// Hash, then only update page stats, don't link yet.
 		b->UpdateHash();
 		blocks_.FinalizeBlock(block_num, true);
 	} else {
+		// Hash for the disk cache, so the block can be validated and reused next time.
+		if (!diskCachePath_.empty())
+			b->UpdateHash();
 		// Overwrites the first instruction, and also updates stats.
-		// TODO: Should we always hash?  Then we can reuse blocks.
 		blocks_.FinalizeBlock(block_num);
+		// Preloaded blocks are only converted once they're actually used, tiered ones once hot.
+		if (tierThreshold_ == 0 && !CompileNative(block_num))
+			return false;
+	}
+
+	blocksCompiled_++;
+	return true;
+}
+
+bool IRJit::CompileNative(int block_num) {
+	if (!native_)
+		return true;
+
+	IRBlock *b = blocks_.GetBlock(block_num);
+	int nativeSize = 0;
+	const u8 *entry = native_->ConvertIRToNative(b->GetInstructions(), b->GetNumInstructions(), &nativeSize);
+	if (!entry)
+		return false;
+	b->SetNativeCode(entry, nativeSize);
+	return true;
+}
+
+class IRCompileTask : public Task {
+public:
+	IRCompileTask(IRJit *jit) : jit_(jit) {}
+
+	TaskType Type() const override { return TaskType::CPU_COMPUTE; }
+	TaskPriority Priority() const override { return TaskPriority::HIGH; }
+
+	void Run() override {
+		jit_->RunCompileQueue();
+	}
+
+private:
+	IRJit *jit_;
+};
+
+void IRJit::TierUpBlock(int block_num) {
+	if (!asyncTierUp_) {
+		if (!CompileNative(block_num)) {
+			if (!EvictNativeCode()) {
+				ERROR_LOG(JIT, "Ran out of native code space, clearing cache");
+				ClearCache();
+			} else if (!CompileNative(block_num)) {
+				blocks_.GetBlock(block_num)->SetRunCount(0);
+			}
+		}
+		return;
+	}
+
+	// Copy the IR, so the block cache can be modified while the compile is running.
+	const IRBlock *b = blocks_.GetBlock(block_num);
+	CompileRequest req{ CompileRequestType::NATIVE, 0, block_num };
+	req.instructions.assign(b->GetInstructions(), b->GetInstructions() + b->GetNumInstructions());
+
+	std::lock_guard<std::mutex> guard(compileLock_);
+	compileQueue_.push_back(std::move(req));
+	// Only one task at a time, since the emitter isn't thread safe.
+	if (!compileTaskRunning_) {
+		compileTaskRunning_ = true;
+		g_threadManager.EnqueueTask(new IRCompileTask(this));
+	}
+}
+
+// Makes room in the native code space by re-emitting only the hottest native blocks.
+// The rest go back to being interpreted, and tier up again if they get hot.
+bool IRJit::EvictNativeCode() {
+	// Without tiering, nothing would ever convert the evicted blocks again.
+	if (!native_ || tierThreshold_ == 0)
+		return false;
+
+	// Finished native compiles point into the code we're about to clear.
+	WaitForBackgroundCompiles(false);
+	{
+		std::lock_guard<std::mutex> guard(compileLock_);
+		compileDone_.erase(std::remove_if(compileDone_.begin(), compileDone_.end(), [](const CompileResult &result) {
+			return result.type == CompileRequestType::NATIVE;
+		}), compileDone_.end());
+		compileDonePending_ = !compileDone_.empty();
+	}
+
+	std::vector<std::pair<u32, int>> hotness;
+	size_t totalSize = 0;
+	for (int i = 0; i < blocks_.GetNumBlocks(); ++i) {
+		IRBlock *b = blocks_.GetBlock(i);
+		if (!b->GetNativeEntry())
+			continue;
+		hotness.push_back(std::make_pair(b->GetRunCount(), i));
+		totalSize += b->GetNativeSize();
+		b->SetNativeCode(nullptr, 0);
+	}
+	std::sort(hotness.begin(), hotness.end(), [](const std::pair<u32, int> &a, const std::pair<u32, int> &b) {
+		return a.first > b.first;
+	});
+
+	native_->ClearCode();
+
+	// Keep the hottest half of the code, so there's room to grow before the next eviction.
+	size_t keptSize = 0;
+	int kept = 0;
+	for (const auto &entry : hotness) {
+		IRBlock *b = blocks_.GetBlock(entry.second);
+		if (keptSize < totalSize / 2 && CompileNative(entry.second)) {
+			keptSize += b->GetNativeSize();
+			// Halve so that blocks which were only hot a long time ago eventually age out.
+			b->SetRunCount(std::max(entry.first / 2, (u32)tierThreshold_));
+			kept++;
+		} else {
+			b->SetRunCount(0);
+		}
 	}
 
+	int evicted = (int)hotness.size() - kept;
+	INFO_LOG(JIT, "IRJit: Native code space full, kept %d hot blocks and evicted %d", kept, evicted);
+	blocks_.RecordNativeEviction(evicted);
 	return true;
 }
 
+void IRJit::CompileInBackground(u32 em_address) {
+	if (!pendingCompiles_.insert(em_address).second)
+		return;
+
+	std::lock_guard<std::mutex> guard(compileLock_);
+	compileQueue_.push_back(CompileRequest{ CompileRequestType::IR, em_address, -1 });
+	if (!compileTaskRunning_) {
+		compileTaskRunning_ = true;
+		g_threadManager.EnqueueTask(new IRCompileTask(this));
+	}
+}
+
+void IRJit::RunCompileQueue() {
+	std::unique_lock<std::mutex> guard(compileLock_);
+	while (!compileQueue_.empty()) {
+		CompileRequest req = std::move(compileQueue_.front());
+		compileQueue_.pop_front();
+		guard.unlock();
+
+		CompileResult result{ req.type, req.emAddr, req.blockNum };
+		if (req.type == CompileRequestType::IR) {
+			std::lock_guard<std::mutex> blockGuard(blockCacheLock_);
+			frontend_.DoJit(req.emAddr, result.instructions, result.mipsBytes, false);
+			result.cleanSlate = frontend_.CheckRounding(req.emAddr);
+			result.continuedRanges = frontend_.GetContinuedRanges();
+
+			// The game may write to this code meanwhile, so verify the hash again when publishing.
+			IRBlock temp(req.emAddr);
+			temp.SetOriginalSize(result.mipsBytes);
+			temp.SetContinuedRanges(result.continuedRanges);
+			temp.UpdateHash();
+			result.hash = temp.GetHash();
+		} else {
+			result.entry = native_->ConvertIRToNative(req.instructions.data(), (int)req.instructions.size(), &result.size);
+		}
+
+		guard.lock();
+		compileDone_.push_back(std::move(result));
+		compileDonePending_ = true;
+		// If out of space, stop and let the CPU thread clear.
+		if (req.type == CompileRequestType::NATIVE && !compileDone_.back().entry)
+			compileQueue_.clear();
+	}
+	compileTaskRunning_ = false;
+	compileCond_.notify_all();
+}
+
+void IRJit::PublishBackgroundCompiles() {
+	std::vector<CompileResult> done;
+	{
+		std::lock_guard<std::mutex> guard(compileLock_);
+		done.swap(compileDone_);
+		compileDonePending_ = false;
+	}
+
+	for (CompileResult &result : done) {
+		if (result.type == CompileRequestType::NATIVE) {
+			if (!result.entry) {
+				if (!EvictNativeCode()) {
+					ERROR_LOG(JIT, "Ran out of native code space, clearing cache");
+					ClearCache();
+					return;
+				}
+				// There's room now, so try this one again.
+				TierUpBlock(result.blockNum);
+				continue;
+			}
+			// Until this point, the block is still interpreted.  No need to touch the emuhack.
+			blocks_.GetBlock(result.blockNum)->SetNativeCode(result.entry, result.size);
+			continue;
+		}
+
+		pendingCompiles_.erase(result.emAddr);
+		if (result.cleanSlate) {
+			// Our assumptions are all wrong so it's clean-slate time.
+			ClearCache();
+			return;
+		}
+
+		// Skip if something else compiled it meanwhile, or the code changed (will just be requested again.)
+		IRBlock temp(result.emAddr);
+		temp.SetOriginalSize(result.mipsBytes);
+		temp.SetContinuedRanges(result.continuedRanges);
+		temp.SetHash(result.hash);
+		if (result.instructions.empty() || MIPS_IS_RUNBLOCK(Memory::ReadUnchecked_U32(result.emAddr)) || !temp.HashMatches())
+			continue;
+
+		int block_num;
+		{
+			std::lock_guard<std::mutex> blockGuard(blockCacheLock_);
+			block_num = blocks_.AllocateBlock(result.emAddr);
+		}
+		if ((block_num & ~MIPS_EMUHACK_VALUE_MASK) != 0) {
+			ERROR_LOG(JIT, "Ran out of block numbers, clearing cache");
+			ClearCache();
+			return;
+		}
+
+		IRBlock *b = blocks_.GetBlock(block_num);
+		b->SetInstructions(result.instructions);
+		b->SetOriginalSize(result.mipsBytes);
+		b->SetContinuedRanges(result.continuedRanges);
+		b->SetHash(result.hash);
+		// Same as a synchronous compile from here: patches the emuhack, so the dispatcher finds it next time.
+		blocks_.FinalizeBlock(block_num);
+		blocksCompiled_++;
+
+		if (tierThreshold_ == 0 && !CompileNative(block_num)) {
+			ERROR_LOG(JIT, "Ran out of native code space, clearing cache");
+			ClearCache();
+			return;
+		}
+	}
+}
+
+void IRJit::WaitForBackgroundCompiles(bool discard) {
+	std::unique_lock<std::mutex> guard(compileLock_);
+	if (discard)
+		compileQueue_.clear();
+	compileCond_.wait(guard, [&] { return !compileTaskRunning_; });
+	if (discard) {
+		// These point at blocks or code that is about to be cleared.
+		compileDone_.clear();
+		compileDonePending_ = false;
+		pendingCompiles_.clear();
+	}
+}
+
 void IRJit::CompileFunction(u32 start_address, u32 length) {
 	PROFILE_THIS_SCOPE("jitc");
+	// Uses the frontend and adds blocks, so can't overlap with a background compile.
+	WaitForBackgroundCompiles(false);
 
 	// Note: we don't actually write emuhacks yet, so we can validate hashes.
 	// This way, if the game changes the code afterward, we'll catch even without icache invalidation.
@@ -221,6 +669,8 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 		if (coreState != 0) {
 			break;
 		}
+		if (compileDonePending_)
+			PublishBackgroundCompiles();
 		while (mips_->downcount >= 0) {
 			u32 inst = Memory::ReadUnchecked_U32(mips_->pc);
 			u32 opcode = inst & 0xFF000000;
@@ -228,15 +678,34 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 				u32 data = inst & 0xFFFFFF;
 				IRBlock *block = blocks_.GetBlock(data);
 				u32 startPC = mips_->pc;
-				mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetNumInstructions());
+				if (block->GetNativeEntry()) {
+					// Still counted, so eviction knows which native blocks to keep.
+					block->IncrementRunCount();
+					mips_->pc = native_->RunBlock(mips_, block->GetNativeEntry());
+				} else {
+					// Count before running, the block may be gone after (e.g. a syscall clearing the cache.)
+					bool tierUp = tierThreshold_ != 0 && block->IncrementRunCount() == (u32)tierThreshold_;
+					mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetNumInstructions());
+					if (tierUp && blocks_.GetBlock(data) == block)
+						TierUpBlock(data);
+				}
 				if (!Memory::IsValidAddress(mips_->pc) || (mips_->pc & 3) != 0) {
 					Core_ExecException(mips_->pc, startPC, ExecExceptionType::JUMP);
 					break;
 				}
-			} else {
+			} else if (!asyncCompile_) {
 				// RestoreRoundingMode(true);
 				Compile(mips_->pc);
 				// ApplyRoundingMode(true);
+			} else if (compileDonePending_) {
+				// It might be this block, so check before interpreting.
+				PublishBackgroundCompiles();
+			} else if (!ReusePreloadBlock(mips_->pc)) {
+				CompileInBackground(mips_->pc);
+				// Step through the block with the interpreter until the IR is published.
+				do {
+					mips_->downcount -= MIPS_SingleStep();
+				} while (mips_->inDelaySlot && coreState == CORE_RUNNING);
 			}
 		}
 	}
@@ -246,7 +715,22 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 
 bool IRJit::DescribeCodePtr(const u8 *ptr, std::string &name) {
 	// Used in target disassembly viewer.
-	return false;
+	if (!native_ || !native_->CodeInRange(ptr))
+		return false;
+
+	for (int i = 0; i < blocks_.GetNumBlocks(); ++i) {
+		const IRBlock *b = blocks_.GetBlock(i);
+		const u8 *entry = b->GetNativeEntry();
+		if (entry && ptr >= entry && ptr < entry + b->GetNativeSize()) {
+			u32 start, size;
+			b->GetRange(start, size);
+			name = StringFromFormat("(IR native block %d at %08x)", i, start);
+			return true;
+		}
+	}
+
+	name = "(IR native fixed code)";
+	return true;
 }
 
 void IRJit::LinkBlock(u8 *exitPoint, const u8 *checkedEntry) {
@@ -274,18 +758,33 @@ void IRBlockCache::InvalidateICache(u32 address, u32 length) {
 	u32 startPage = AddressToPage(address);
 	u32 endPage = AddressToPage(address + length);
 
-	for (u32 page = startPage; page <= endPage; ++page) {
-		const auto iter = byPage_.find(page);
-		if (iter == byPage_.end())
-			continue;
-
-		const std::vector<int> &blocksInPage = iter->second;
+	auto checkPage = [&](const std::vector<int> &blocksInPage) {
 		for (int i : blocksInPage) {
+			// Dormant blocks are checked against their hash before use, so they can survive.
+			// This matters for the disk cache, since games often invalidate everything after loading.
+			if (blocks_[i].IsDormant())
+				continue;
 			if (blocks_[i].OverlapsRange(address, length)) {
 				// Not removing from the page, hopefully doesn't build up with small recompiles.
 				blocks_[i].Destroy(i);
 			}
 		}
+	};
+
+	if (endPage >= startPage && endPage - startPage >= byPage_.size()) {
+		// Invalidating everything would otherwise look up a million pages.
+		for (const auto &iter : byPage_) {
+			if (iter.first >= startPage && iter.first <= endPage)
+				checkPage(iter.second);
+		}
+		return;
+	}
+
+	for (u32 page = startPage; page <= endPage; ++page) {
+		const auto iter = byPage_.find(page);
+		if (iter == byPage_.end())
+			continue;
+		checkPage(iter->second);
 	}
 }
 
@@ -296,7 +795,12 @@ void IRBlockCache::FinalizeBlock(int i, bool preload) {
 
 	u32 startAddr, size;
 	blocks_[i].GetRange(startAddr, size);
+	AddToPages(i, startAddr, size);
+	for (const IRCodeRange &range : blocks_[i].GetContinuedRanges())
+		AddToPages(i, range.start, range.size);
+}
 
+void IRBlockCache::AddToPages(int i, u32 startAddr, u32 size) {
 	u32 startPage = AddressToPage(startAddr);
 	u32 endPage = AddressToPage(startAddr + size);
 
@@ -331,6 +835,22 @@ int IRBlockCache::FindPreloadBlock(u32 em_address) {
 	return -1;
 }
 
+int IRBlockCache::AddCachedBlock(u32 emAddr, u32 mipsBytes, u64 hash, const std::vector<IRInst> &inst) {
+	int block_num = AllocateBlock(emAddr);
+	if ((block_num & ~MIPS_EMUHACK_VALUE_MASK) != 0) {
+		blocks_.pop_back();
+		return block_num;
+	}
+
+	IRBlock &b = blocks_[block_num];
+	b.SetInstructions(inst);
+	b.SetOriginalSize(mipsBytes);
+	b.SetHash(hash);
+	// Only registers the pages, just like a preload.
+	FinalizeBlock(block_num, true);
+	return block_num;
+}
+
 std::vector<u32> IRBlockCache::SaveAndClearEmuHackOps() {
 	std::vector<u32> result;
 	result.resize(blocks_.size());
@@ -375,6 +895,14 @@ JitBlockDebugInfo IRBlockCache::GetBlockDebugInfo(int blockNum) const {
 		std::string mipsDis = temp;
 		debugInfo.origDisasm.push_back(mipsDis);
 	}
+	for (const IRCodeRange &range : ir.GetContinuedRanges()) {
+		debugInfo.origDisasm.push_back(StringFromFormat("(continued at %08x)", range.start));
+		for (u32 addr = range.start; addr < range.start + range.size; addr += 4) {
+			char temp[256];
+			MIPSDisAsm(Memory::Read_Instruction(addr), addr, temp, true);
+			debugInfo.origDisasm.push_back(temp);
+		}
+	}
 
 	for (int i = 0; i < ir.GetNumInstructions(); i++) {
 		IRInst inst = ir.GetInstructions()[i];
@@ -382,6 +910,14 @@ JitBlockDebugInfo IRBlockCache::GetBlockDebugInfo(int blockNum) const {
 		DisassembleIR(buffer, sizeof(buffer), inst);
 		debugInfo.irDisasm.push_back(buffer);
 	}
+
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	if (ir.GetNativeEntry())
+		debugInfo.targetDisasm = DisassembleX86(ir.GetNativeEntry(), ir.GetNativeSize());
+#elif PPSSPP_ARCH(RISCV64)
+	if (ir.GetNativeEntry())
+		debugInfo.targetDisasm = DisassembleRV64(ir.GetNativeEntry(), ir.GetNativeSize());
+#endif
 	return debugInfo;
 }
 
@@ -410,6 +946,32 @@ void IRBlockCache::ComputeStats(BlockCacheStats &bcStats) const {
 		bcStats.bloatMap[bloat] = origAddr;
 	}
 	bcStats.numBlocks = (int)blocks_.size();
+	bcStats.tierThreshold = tierThreshold_;
+	bcStats.numNativeEvictions = nativeEvictions_;
+	bcStats.numEvictedNativeBlocks = evictedNativeBlocks_;
+	bcStats.numNativeBlocks = 0;
+	bcStats.numPendingNativeBlocks = 0;
+	bcStats.numTraceBlocks = 0;
+	bcStats.traceLengthHistogram.clear();
+	for (const auto &b : blocks_) {
+		if (!b.GetContinuedRanges().empty()) {
+			u32 origAddr, mipsBytes;
+			b.GetRange(origAddr, mipsBytes);
+			for (const IRCodeRange &range : b.GetContinuedRanges())
+				mipsBytes += range.size;
+			// Bucket by the next power of two of MIPS instructions.
+			int bucket = 1;
+			while (bucket < (int)(mipsBytes / 4))
+				bucket <<= 1;
+			bcStats.traceLengthHistogram[bucket]++;
+			bcStats.numTraceBlocks++;
+		}
+
+		if (b.GetNativeEntry())
+			bcStats.numNativeBlocks++;
+		else if (tierThreshold_ != 0 && b.GetRunCount() >= (u32)tierThreshold_)
+			bcStats.numPendingNativeBlocks++;
+	}
 	bcStats.minBloat = minBloat;
 	bcStats.maxBloat = maxBloat;
 	bcStats.avgBloat = totalBloat / (double)blocks_.size();
@@ -475,15 +1037,18 @@ u64 IRBlock::CalculateHash() const {
 	if (origAddr_) {
 		// This is unfortunate.  In case of emuhacks, we have to make a copy.
 		std::vector<u32> buffer;
-		buffer.resize(origSize_ / 4);
-		size_t pos = 0;
+		buffer.reserve(origSize_ / 4);
 		for (u32 off = 0; off < origSize_; off += 4) {
 			// Let's actually hash the replacement, if any.
 			MIPSOpcode instr = Memory::ReadUnchecked_Instruction(origAddr_ + off, false);
-			buffer[pos++] = instr.encoding;
+			buffer.push_back(instr.encoding);
+		}
+		for (const IRCodeRange &range : continuedRanges_) {
+			for (u32 off = 0; off < range.size; off += 4)
+				buffer.push_back(Memory::ReadUnchecked_Instruction(range.start + off, false).encoding);
 		}
 
-		return XXH3_64bits(&buffer[0], origSize_);
+		return XXH3_64bits(&buffer[0], buffer.size() * sizeof(u32));
 	}
 
 	return 0;
@@ -492,7 +1057,14 @@ u64 IRBlock::CalculateHash() const {
 bool IRBlock::OverlapsRange(u32 addr, u32 size) const {
 	addr &= 0x3FFFFFFF;
 	u32 origAddr = origAddr_ & 0x3FFFFFFF;
-	return addr + size > origAddr && addr < origAddr + origSize_;
+	if (addr + size > origAddr && addr < origAddr + origSize_)
+		return true;
+	for (const IRCodeRange &range : continuedRanges_) {
+		u32 start = range.start & 0x3FFFFFFF;
+		if (addr + size > start && addr < start + range.size)
+			return true;
+	}
+	return false;
 }
 
 MIPSOpcode IRJit::GetOriginalOp(MIPSOpcode op) {
@@ -17,11 +17,17 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "Common/CommonTypes.h"
 #include "Common/CPUDetect.h"
+#include "Common/File/Path.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/IR/IRRegCache.h"
@@ -47,6 +53,10 @@ class IRBlock {
 		origSize_ = b.origSize_;
 		origFirstOpcode_ = b.origFirstOpcode_;
 		hash_ = b.hash_;
+		nativeEntry_ = b.nativeEntry_;
+		nativeSize_ = b.nativeSize_;
+		runCount_ = b.runCount_;
+		continuedRanges_ = std::move(b.continuedRanges_);
 		b.instr_ = nullptr;
 	}
 
@@ -64,6 +74,17 @@ class IRBlock {
 
 	const IRInst *GetInstructions() const { return instr_; }
 	int GetNumInstructions() const { return numInstructions_; }
+	// Set when a native backend has translated the IR, otherwise null and the IR is interpreted.
+	void SetNativeCode(const u8 *entry, int size) {
+		nativeEntry_ = entry;
+		nativeSize_ = size;
+	}
+	const u8 *GetNativeEntry() const { return nativeEntry_; }
+	int GetNativeSize() const { return nativeSize_; }
+	// Counts interpreted runs, for tiering up to native code.
+	u32 IncrementRunCount() { return ++runCount_; }
+	u32 GetRunCount() const { return runCount_; }
+	void SetRunCount(u32 count) { runCount_ = count; }
 	MIPSOpcode GetOriginalFirstOp() const { return origFirstOpcode_; }
 	bool HasOriginalFirstOp() const;
 	bool RestoreOriginalFirstOp(int number);
@@ -71,12 +92,24 @@ class IRBlock {
 	void SetOriginalSize(u32 size) {
 		origSize_ = size;
 	}
+	// Other code compiled into this block, when it's a trace.  Set before hashing.
+	void SetContinuedRanges(const std::vector<IRCodeRange> &ranges) {
+		continuedRanges_ = ranges;
+	}
+	const std::vector<IRCodeRange> &GetContinuedRanges() const { return continuedRanges_; }
 	void UpdateHash() {
 		hash_ = CalculateHash();
 	}
+	// Used when restoring blocks from the disk cache, validated later by HashMatches().
+	void SetHash(u64 hash) {
+		hash_ = hash;
+	}
+	u64 GetHash() const { return hash_; }
 	bool HashMatches() const {
 		return origAddr_ && hash_ == CalculateHash();
 	}
+	// Compiled (preloaded or from disk) but not yet linked into memory.
+	bool IsDormant() const { return origAddr_ != 0 && !IsValid() && hash_ != 0; }
 	bool OverlapsRange(u32 addr, u32 size) const;
 
 	void GetRange(u32 &start, u32 &size) const {
@@ -95,9 +128,27 @@ class IRBlock {
 	u32 origAddr_;
 	u32 origSize_;
 	u64 hash_ = 0;
+	const u8 *nativeEntry_ = nullptr;
+	int nativeSize_ = 0;
+	u32 runCount_ = 0;
+	std::vector<IRCodeRange> continuedRanges_;
 	MIPSOpcode origFirstOpcode_ = MIPSOpcode(0x68FFFFFF);
 };
 
+// Optional backend that turns finished IR blocks into host code.
+class IRToNativeInterface {
+public:
+	virtual ~IRToNativeInterface() {}
+
+	// Returns the entry point, or nullptr if out of space (the caller should clear the cache.)
+	virtual const u8 *ConvertIRToNative(const IRInst *instructions, int count, int *nativeSize) = 0;
+	// Runs a block and returns the next PC, just like IRInterpret().
+	virtual u32 RunBlock(MIPSState *mips, const u8 *entry) = 0;
+	virtual void ClearCode() = 0;
+	virtual bool CodeInRange(const u8 *ptr) const = 0;
+	virtual const u8 *GetCrashHandler() const = 0;
+};
+
 class IRBlockCache : public JitBlockCacheDebugInterface {
 public:
 	IRBlockCache() {}
@@ -118,6 +169,14 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 	}
 
 	int FindPreloadBlock(u32 em_address);
+	// Only used for stats.
+	void SetTierThreshold(int threshold) { tierThreshold_ = threshold; }
+	void RecordNativeEviction(int evictedBlocks) {
+		nativeEvictions_++;
+		evictedNativeBlocks_ += evictedBlocks;
+	}
+	// Adds a dormant block restored from the disk cache.  It's only used if the hash still matches.
+	int AddCachedBlock(u32 emAddr, u32 mipsBytes, u64 hash, const std::vector<IRInst> &inst);
 
 	std::vector<u32> SaveAndClearEmuHackOps();
 	void RestoreSavedEmuHackOps(std::vector<u32> saved);
@@ -128,14 +187,18 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 
 private:
 	u32 AddressToPage(u32 addr) const;
+	void AddToPages(int i, u32 startAddr, u32 size);
 
 	std::vector<IRBlock> blocks_;
 	std::unordered_map<u32, std::vector<int>> byPage_;
+	int tierThreshold_ = 0;
+	int nativeEvictions_ = 0;
+	int evictedNativeBlocks_ = 0;
 };
 
 class IRJit : public JitInterface {
 public:
-	IRJit(MIPSState *mipsState);
+	IRJit(MIPSState *mipsState, bool useNative = false);
 	~IRJit();
 
 	void DoState(PointerWrap &p) override;
@@ -161,25 +224,87 @@ class IRJit : public JitInterface {
 	void UpdateFCR31() override;
 
 	bool CodeInRange(const u8 *ptr) const override {
-		return false;
+		return native_ && native_->CodeInRange(ptr);
 	}
 
 	const u8 *GetDispatcher() const override { return nullptr; }
-	const u8 *GetCrashHandler() const override { return nullptr; }
+	const u8 *GetCrashHandler() const override { return native_ ? native_->GetCrashHandler() : nullptr; }
 
 	void LinkBlock(u8 *exitPoint, const u8 *checkedEntry) override;
 	void UnlinkBlock(u8 *checkedEntry, u32 originalAddress) override;
 
 private:
 	bool CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
+	bool ReusePreloadBlock(u32 em_address);
+	bool CompileNative(int block_num);
+	void TierUpBlock(int block_num);
+	bool EvictNativeCode();
+	void CompileInBackground(u32 em_address);
+	void PublishBackgroundCompiles();
+	// Without discard, finished compiles stay queued for the dispatcher to publish.
+	void WaitForBackgroundCompiles(bool discard = true);
+
+	friend class IRCompileTask;
+	void RunCompileQueue();
 	bool ReplaceJalTo(u32 dest);
 
+	void LoadDiskCache();
+	void SaveDiskCache();
+
 	JitOptions jo;
 
 	IRFrontend frontend_;
 	IRBlockCache blocks_;
 
 	MIPSState *mips_;
+	IRToNativeInterface *native_ = nullptr;
+	// Blocks are interpreted this many times before converting to native.  0 means convert right away.
+	int tierThreshold_ = 0;
+	// Whether tier ups compile on a background thread, not possible where code can't be written while running.
+	bool asyncTierUp_ = false;
+	// Whether new blocks are compiled to IR on a background thread, interpreting with MIPSInt meanwhile.
+	bool asyncCompile_ = false;
+
+	// A single background task handles both kinds in order, since neither the frontend nor the emitter are thread safe.
+	enum class CompileRequestType {
+		IR,
+		NATIVE,
+	};
+	struct CompileRequest {
+		CompileRequestType type;
+		u32 emAddr;
+		int blockNum;
+		std::vector<IRInst> instructions;
+	};
+	struct CompileResult {
+		CompileRequestType type;
+		u32 emAddr;
+		int blockNum;
+		// For IR: the block, validated against memory again when published.
+		std::vector<IRInst> instructions;
+		u32 mipsBytes;
+		std::vector<IRCodeRange> continuedRanges;
+		u64 hash;
+		bool cleanSlate;
+		// For NATIVE: nullptr if out of space.
+		const u8 *entry;
+		int size;
+	};
+	std::mutex compileLock_;
+	std::condition_variable compileCond_;
+	std::deque<CompileRequest> compileQueue_;
+	std::vector<CompileResult> compileDone_;
+	std::atomic<bool> compileDonePending_{};
+	bool compileTaskRunning_ = false;
+	// Held by the background task while reading blocks_ (through emuhacks) and by the CPU thread while adding to it.
+	std::mutex blockCacheLock_;
+	// Only accessed on the CPU thread.
+	std::unordered_set<u32> pendingCompiles_;
+
+	// Persistent IR cache, keyed by disc ID.  Empty if disabled.
+	Path diskCachePath_;
+	bool diskCacheLoaded_ = false;
+	int blocksCompiled_ = 0;
 
 	// where to write branch-likely trampolines. not used atm
 	// u32 blTrampolines_;
@@ -1,10 +1,12 @@
 #include <algorithm>
 #include <cstring>
+#include <mutex>
 #include <utility>
 
 #include "Common/BitSet.h"
 #include "Common/Data/Convert/SmallDataConvert.h"
 #include "Common/Log.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/MIPS/IR/IRInterpreter.h"
 #include "Core/MIPS/IR/IRPassSimplify.h"
@@ -84,9 +86,84 @@ IROp ShiftToShiftImm(IROp op) {
 	}
 }
 
+struct IRPassStatsEntry {
+	IRPassFunc func;
+	IRPassStats stats;
+};
+
+// Blocks may be compiled on a background thread, so this is locked.
+static std::mutex passStatsLock;
+static std::vector<IRPassStatsEntry> passStats;
+
+static const char *IRPassName(IRPassFunc func) {
+	static const struct {
+		IRPassFunc func;
+		const char *name;
+	} names[] = {
+		{ &RemoveLoadStoreLeftRight, "RemoveLoadStoreLeftRight" },
+		{ &PropagateConstants, "PropagateConstants" },
+		{ &PurgeTemps, "PurgeTemps" },
+		{ &ReduceLoads, "ReduceLoads" },
+		{ &ThreeOpToTwoOp, "ThreeOpToTwoOp" },
+		{ &OptimizeFPMoves, "OptimizeFPMoves" },
+		{ &ReorderLoadStore, "ReorderLoadStore" },
+		{ &MergeLoadStore, "MergeLoadStore" },
+		{ &ApplyMemoryValidation, "ApplyMemoryValidation" },
+		{ &PurgeDeadFPRStores, "PurgeDeadFPRStores" },
+	};
+	for (const auto &entry : names) {
+		if (entry.func == func)
+			return entry.name;
+	}
+	return "(unknown)";
+}
+
+static void RecordPassStats(IRPassFunc func, bool changed, size_t countIn, size_t countOut, double seconds) {
+	std::lock_guard<std::mutex> guard(passStatsLock);
+	IRPassStatsEntry *entry = nullptr;
+	for (auto &e : passStats) {
+		if (e.func == func) {
+			entry = &e;
+			break;
+		}
+	}
+	if (!entry) {
+		passStats.push_back(IRPassStatsEntry{ func, IRPassStats{ IRPassName(func) } });
+		entry = &passStats.back();
+	}
+
+	entry->stats.runs++;
+	if (changed)
+		entry->stats.changed++;
+	entry->stats.instructionsIn += countIn;
+	entry->stats.instructionsOut += countOut;
+	entry->stats.seconds += seconds;
+}
+
+static bool RunPass(IRPassFunc func, const IRWriter &in, IRWriter &out, const IROptions &opts) {
+	double start = time_now_d();
+	bool changed = func(in, out, opts);
+	RecordPassStats(func, changed, in.GetInstructions().size(), out.GetInstructions().size(), time_now_d() - start);
+	return changed;
+}
+
+void IRResetPassStats() {
+	std::lock_guard<std::mutex> guard(passStatsLock);
+	passStats.clear();
+}
+
+std::vector<IRPassStats> IRGetPassStats() {
+	std::lock_guard<std::mutex> guard(passStatsLock);
+	std::vector<IRPassStats> result;
+	result.reserve(passStats.size());
+	for (const auto &entry : passStats)
+		result.push_back(entry.stats);
+	return result;
+}
+
 bool IRApplyPasses(const IRPassFunc *passes, size_t c, const IRWriter &in, IRWriter &out, const IROptions &opts) {
 	if (c == 1) {
-		return passes[0](in, out, opts);
+		return RunPass(passes[0], in, out, opts);
 	}
 
 	bool logBlocks = false;
@@ -95,7 +172,7 @@ bool IRApplyPasses(const IRPassFunc *passes, size_t c, const IRWriter &in, IRWri
 	const IRWriter *nextIn = &in;
 	IRWriter *nextOut = &temp[1];
 	for (size_t i = 0; i < c - 1; ++i) {
-		if (passes[i](*nextIn, *nextOut, opts)) {
+		if (RunPass(passes[i], *nextIn, *nextOut, opts)) {
 			logBlocks = true;
 		}
 
@@ -103,7 +180,7 @@ bool IRApplyPasses(const IRPassFunc *passes, size_t c, const IRWriter &in, IRWri
 		nextIn = &temp[0];
 	}
 
-	if (passes[c - 1](*nextIn, out, opts)) {
+	if (RunPass(passes[c - 1], *nextIn, out, opts)) {
 		logBlocks = true;
 	}
 
@@ -1027,6 +1104,139 @@ bool ReduceLoads(const IRWriter &in, IRWriter &out, const IROptions &opts) {
 	return logBlocks;
 }
 
+// Calls fn(reg) for each FPR (relative to f[0]) used by an operand of the given type.
+template <typename F>
+static void ForEachFPROperand(char type, u8 reg, F fn) {
+	switch (type) {
+	case 'F':
+		fn(reg);
+		break;
+	case '2':
+		fn(reg);
+		fn(reg + 1);
+		break;
+	case 'V':
+		for (int i = 0; i < 4; ++i)
+			fn(reg + i);
+		break;
+	default:
+		break;
+	}
+}
+
+static bool IsVFPUPrefixCtrl(int ctrl) {
+	return ctrl == VFPU_CTRL_SPREFIX || ctrl == VFPU_CTRL_TPREFIX || ctrl == VFPU_CTRL_DPREFIX;
+}
+
+bool PurgeDeadFPRStores(const IRWriter &in, IRWriter &out, const IROptions &opts) {
+	CONDITIONAL_DISABLE;
+	const std::vector<IRInst> &insts = in.GetInstructions();
+	std::vector<bool> dead(insts.size(), false);
+
+	// Walking backwards, a reg is live if a later inst (or the next block) might read it.
+	// The VFPU temps don't persist between blocks, everything else does.
+	bool liveFPR[256];
+	bool livePrefix[3];
+	auto setAllLive = [&]() {
+		for (int r = 0; r < 256; ++r)
+			liveFPR[r] = r < IRVTEMP_PFX_S || r > IRVTEMP_0 + 3;
+		for (int c = 0; c < 3; ++c)
+			livePrefix[c] = true;
+	};
+	setAllLive();
+
+	bool logBlocks = false;
+	for (int i = (int)insts.size() - 1; i >= 0; --i) {
+		const IRInst &inst = insts[i];
+		const IRMeta *m = GetIRMeta(inst.op);
+
+		if ((m->flags & IRFLAG_EXIT) != 0 || inst.op == IROp::Interpret || inst.op == IROp::CallReplacement) {
+			// Exits, and anything that might read arbitrary state.
+			setAllLive();
+			continue;
+		}
+
+		bool destIsSrc = (m->flags & IRFLAG_SRC3) != 0;
+		char destType = m->types[0];
+		switch (inst.op) {
+		case IROp::SetCtrlVFPU:
+		case IROp::SetCtrlVFPUReg:
+		case IROp::SetCtrlVFPUFReg:
+			if (IsVFPUPrefixCtrl(inst.dest)) {
+				if (!livePrefix[inst.dest - VFPU_CTRL_SPREFIX]) {
+					dead[i] = true;
+					logBlocks = true;
+					continue;
+				}
+				livePrefix[inst.dest - VFPU_CTRL_SPREFIX] = false;
+			}
+			break;
+
+		case IROp::VfpuCtrlToReg:
+			if (IsVFPUPrefixCtrl(inst.src1))
+				livePrefix[inst.src1 - VFPU_CTRL_SPREFIX] = true;
+			break;
+
+		case IROp::FCmovVfpuCC:
+			// Conditional, so the dest keeps its value otherwise.
+			destIsSrc = true;
+			break;
+
+		case IROp::LoadFloat:
+		case IROp::LoadVec4:
+			// Keep loads, they might still report bad memory accesses.
+			destIsSrc = true;
+			break;
+
+		case IROp::Vec2Pack32To16:
+		case IROp::Vec2Pack31To16:
+			// The meta says "2", but these only write a single reg.
+			destType = 'F';
+			break;
+
+		default:
+			break;
+		}
+
+		// Reading a prefix through the GPR view of the VFPU control regs.
+		for (int c = 0; c < 3; ++c) {
+			if (IRReadsFromGPR(inst, IRREG_VFPU_CTRL_BASE + VFPU_CTRL_SPREFIX + c, true))
+				livePrefix[c] = true;
+		}
+
+		if (!destIsSrc && (destType == 'F' || destType == '2' || destType == 'V')) {
+			bool anyLive = false;
+			ForEachFPROperand(destType, inst.dest, [&](int r) {
+				if (liveFPR[r])
+					anyLive = true;
+			});
+			if (!anyLive) {
+				dead[i] = true;
+				logBlocks = true;
+				continue;
+			}
+			ForEachFPROperand(destType, inst.dest, [&](int r) {
+				liveFPR[r] = false;
+			});
+		}
+
+		auto markLive = [&](int r) {
+			liveFPR[r] = true;
+		};
+		if (destIsSrc)
+			ForEachFPROperand(destType, inst.src3, markLive);
+		ForEachFPROperand(m->types[1], inst.src1, markLive);
+		ForEachFPROperand(m->types[2], inst.src2, markLive);
+	}
+
+	for (size_t i = 0; i < insts.size(); ++i) {
+		if (!dead[i])
+			out.Write(insts[i]);
+	}
+
+	return logBlocks;
+}
+
 static std::vector<IRInst> ReorderLoadStoreOps(std::vector<IRInst> &ops) {
 	if (ops.size() < 2) {
 		return ops;
@@ -1496,3 +1706,44 @@ bool ApplyMemoryValidation(const IRWriter &in, IRWriter &out, const IROptions &o
 	}
 	return logBlocks;
 }
+
+bool FuseOpPairs(const IRWriter &in, IRWriter &out, const IROptions &opts) {
+	CONDITIONAL_DISABLE;
+	if (!opts.fuseOpPairs)
+		DISABLE;
+
+	// These are the pairs the frontend most often emits back to back: address math and loads
+	// from lw/addiu sequences and vector loads, and slt before a beq/bne against zero.
+	const auto fusedOp = [](const IRInst &first, const IRInst &second) {
+		switch (first.op) {
+		case IROp::Load32:
+			return second.op == IROp::Add ? IROp::FusedLoad32Add : IROp::Nop;
+		case IROp::AddConst:
+			return second.op == IROp::Load32 ? IROp::FusedAddConstLoad32 : IROp::Nop;
+		case IROp::LoadVec4:
+			return second.op == IROp::Vec4Mul ? IROp::FusedLoadVec4Vec4Mul : IROp::Nop;
+		case IROp::Slt:
+			return second.op == IROp::ExitToConstIfEq || second.op == IROp::ExitToConstIfNeq ? IROp::FusedSltExitIf : IROp::Nop;
+		case IROp::SltConst:
+			return second.op == IROp::ExitToConstIfEq || second.op == IROp::ExitToConstIfNeq ? IROp::FusedSltConstExitIf : IROp::Nop;
+		default:
+			return IROp::Nop;
+		}
+	};
+
+	const std::vector<IRInst> &insts = in.GetInstructions();
+	for (size_t i = 0; i < insts.size(); ++i) {
+		IRInst inst = insts[i];
+		IROp fused = i + 1 < insts.size() ? fusedOp(inst, insts[i + 1]) : IROp::Nop;
+		if (fused != IROp::Nop) {
+			// The operands stay as they were, only the op changes.
+			inst.op = fused;
+			out.Write(inst);
+			out.Write(insts[i + 1]);
+			++i;
+		} else {
+			out.Write(inst);
+		}
+	}
+	return false;
+}
@@ -1,17 +1,35 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
 #include "Core/MIPS/IR/IRInst.h"
 
 typedef bool (*IRPassFunc)(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool IRApplyPasses(const IRPassFunc *passes, size_t c, const IRWriter &in, IRWriter &out, const IROptions &opts);
 
+// Accumulated by IRApplyPasses for every pass it runs, until reset (once per game session.)
+struct IRPassStats {
+	const char *name;
+	uint64_t runs;
+	uint64_t changed;
+	uint64_t instructionsIn;
+	uint64_t instructionsOut;
+	double seconds;
+};
+
+void IRResetPassStats();
+std::vector<IRPassStats> IRGetPassStats();
+
 // Block optimizer passes of varying usefulness.
 bool RemoveLoadStoreLeftRight(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool PropagateConstants(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool PurgeTemps(const IRWriter &in, IRWriter &out, const IROptions &opts);
+bool PurgeDeadFPRStores(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool ReduceLoads(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool ThreeOpToTwoOp(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool OptimizeFPMoves(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool ReorderLoadStore(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool MergeLoadStore(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool ApplyMemoryValidation(const IRWriter &in, IRWriter &out, const IROptions &opts);
+// Must run last, the fused ops are only understood by IRInterpret.
+bool FuseOpPairs(const IRWriter &in, IRWriter &out, const IROptions &opts);
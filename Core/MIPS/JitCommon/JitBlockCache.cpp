@@ -21,7 +21,10 @@
 
 #include "ext/xxhash.h"
 #include "Common/CommonTypes.h"
+#include "Common/Profiler/MemoryUsage.h"
+#include "Common/Profiler/PerfMap.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/StringUtils.h"
 
 #ifdef _WIN32
 #include "Common/CommonWindows.h"
@@ -31,6 +34,7 @@
 #include "Core/MemMap.h"
 #include "Core/CoreTiming.h"
 #include "Core/Reporting.h"
+#include "Core/Debugger/SymbolMap.h"
 
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSTables.h"
@@ -61,6 +65,16 @@ op_agent_t agent;
 
 const u32 INVALID_EXIT = 0xFFFFFFFF;
 
+static std::string PerfMapBlockName(u32 addr) {
+	u32 funcStart = g_symbolMap ? g_symbolMap->GetFunctionStart(addr) : SymbolMap::INVALID_ADDRESS;
+	if (funcStart != SymbolMap::INVALID_ADDRESS) {
+		std::string label = g_symbolMap->GetLabelString(funcStart);
+		if (!label.empty())
+			return StringFromFormat("EmuCode %s+0x%x [%08x]", label.c_str(), addr - funcStart, addr);
+	}
+	return StringFromFormat("EmuCode [%08x]", addr);
+}
+
 static uint64_t HashJitBlock(const JitBlock &b) {
 	PROFILE_THIS_SCOPE("jithash");
 	if (JIT_USE_COMPILEDHASH) {
@@ -119,6 +133,7 @@ void JitBlockCache::Shutdown() {
 // is full and when saving and loading states.
 void JitBlockCache::Clear() {
 	block_map_.clear();
+	byPage_.clear();
 	proxyBlockMap_.clear();
 	for (int i = 0; i < num_blocks_; i++)
 		DestroyBlock(i, DestroyType::CLEAR);
@@ -128,6 +143,9 @@ void JitBlockCache::Clear() {
 	blockMemRanges_[JITBLOCK_RANGE_SCRATCH] = std::make_pair(0xFFFFFFFF, 0x00000000);
 	blockMemRanges_[JITBLOCK_RANGE_RAMBOTTOM] = std::make_pair(0xFFFFFFFF, 0x00000000);
 	blockMemRanges_[JITBLOCK_RANGE_RAMTOP] = std::make_pair(0xFFFFFFFF, 0x00000000);
+
+	// The code space is reset right after this.
+	MemUsage_Set(MemoryCategory::JIT_CODE, 0);
 }
 
 void JitBlockCache::Reset() {
@@ -164,6 +182,7 @@ int JitBlockCache::AllocateBlock(u32 startAddress) {
 
 	b.invalid = false;
 	b.originalAddress = startAddress;
+	b.regContract = 0;
 	for (int i = 0; i < MAX_JIT_BLOCK_EXITS; ++i) {
 		b.exitAddress[i] = INVALID_EXIT;
 		b.exitPtrs[i] = 0;
@@ -214,7 +233,12 @@ void JitBlockCache::AddBlockMap(int block_num) {
 	// Convert the logical address to a physical address for the block map
 	// Yeah, this'll work fine for PSP too I think.
 	u32 pAddr = b.originalAddress & 0x1FFFFFFF;
-	block_map_[std::make_pair(pAddr + 4 * b.originalSize, pAddr)] = block_num;
+	u32 pEnd = pAddr + 4 * b.originalSize;
+	block_map_[std::make_pair(pEnd, pAddr)] = block_num;
+
+	u32 endPage = AddressToPage(pEnd > pAddr ? pEnd - 1 : pAddr);
+	for (u32 page = AddressToPage(pAddr); page <= endPage; ++page)
+		byPage_[page].push_back(block_num);
 }
 
 void JitBlockCache::RemoveBlockMap(int block_num) {
@@ -224,7 +248,19 @@ void JitBlockCache::RemoveBlockMap(int block_num) {
 	}
 
 	const u32 pAddr = b.originalAddress & 0x1FFFFFFF;
-	auto it = block_map_.find(std::make_pair(pAddr + 4 * b.originalSize, pAddr));
+	const u32 pEnd = pAddr + 4 * b.originalSize;
+	const u32 endPage = AddressToPage(pEnd > pAddr ? pEnd - 1 : pAddr);
+	for (u32 page = AddressToPage(pAddr); page <= endPage; ++page) {
+		auto pageIt = byPage_.find(page);
+		if (pageIt == byPage_.end())
+			continue;
+		std::vector<int> &blocksInPage = pageIt->second;
+		blocksInPage.erase(std::remove(blocksInPage.begin(), blocksInPage.end(), block_num), blocksInPage.end());
+		if (blocksInPage.empty())
+			byPage_.erase(pageIt);
+	}
+
+	auto it = block_map_.find(std::make_pair(pEnd, pAddr));
 	if (it != block_map_.end() && it->second == (u32)block_num) {
 		block_map_.erase(it);
 	} else {
@@ -254,6 +290,7 @@ void JitBlockCache::FinalizeBlock(int block_num, bool block_link) {
 	b.compiledHash = HashJitBlock(b);
 
 	AddBlockMap(block_num);
+	MemUsage_Set(MemoryCategory::JIT_CODE, (int64_t)codeBlock_->GetOffset(codeBlock_->GetCodePtr()));
 
 	if (block_link) {
 		for (int i = 0; i < MAX_JIT_BLOCK_EXITS; i++) {
@@ -298,6 +335,9 @@ void JitBlockCache::FinalizeBlock(int block_num, bool block_link) {
 	jmethod.method_name = b.blockName;
 	iJIT_NotifyEvent(iJVM_EVENT_TYPE_METHOD_LOAD_FINISHED, (void*)&jmethod);
 #endif
+
+	if (PerfMap_IsEnabled())
+		PerfMap_AddSymbol(b.checkedEntry, b.normalEntry + b.codeSize - b.checkedEntry, PerfMapBlockName(b.originalAddress));
 }
 
 bool JitBlockCache::RangeMayHaveEmuHacks(u32 start, u32 end) const {
@@ -430,8 +470,8 @@ void JitBlockCache::LinkBlockExits(int i) {
 			}
 
 			JitBlock &eb = blocks_[destinationBlock];
-			// Make sure the destination is not invalid.
-			if (!eb.invalid) {
+			// Make sure the destination is not invalid, and expects registers the way we leave them.
+			if (!eb.invalid && eb.regContract == b.regContract) {
 				MIPSComp::jit->LinkBlock(b.exitPtrs[e], eb.checkedEntry);
 				b.linkStatus[e] = true;
 			}
@@ -592,25 +632,42 @@ void JitBlockCache::InvalidateICache(u32 address, const u32 length) {
 		return;
 	}
 
-	// Blocks may start and end in overlapping ways, and destroying one invalidates iterators.
-	// So after destroying one, we start over.
-	do {
-	restart:
-		auto next = block_map_.lower_bound(std::make_pair(pAddr, 0));
-		auto last = block_map_.upper_bound(std::make_pair(pEnd + MAX_BLOCK_INSTRUCTIONS, 0));
-		// Note that if next is end(), last will be end() too (equal.)
-		for (; next != last; ++next) {
-			const u32 blockStart = next->first.second;
-			const u32 blockEnd = next->first.first;
-			if (blockStart < pEnd && blockEnd > pAddr) {
-				DestroyBlock(next->second, DestroyType::INVALIDATE);
-				// Our iterator is now invalid.  Break and search again.
-				// Most of the time there shouldn't be a bunch of matching blocks.
-				goto restart;
-			}
+	// Collect first, since destroying blocks modifies the page lists.
+	std::vector<int> overlapping;
+	auto checkPage = [&](const std::vector<int> &blocksInPage) {
+		for (int block_num : blocksInPage) {
+			const JitBlock &b = blocks_[block_num];
+			const u32 blockStart = b.originalAddress & 0x1FFFFFFF;
+			const u32 blockEnd = blockStart + 4 * b.originalSize;
+			if (!b.invalid && blockStart < pEnd && blockEnd > pAddr)
+				overlapping.push_back(block_num);
+		}
+	};
+
+	const u32 startPage = AddressToPage(pAddr);
+	const u32 endPage = AddressToPage(pEnd > pAddr ? pEnd - 1 : pAddr);
+	if (endPage - startPage >= byPage_.size()) {
+		// Large range (like a module unload), cheaper to walk the pages that have blocks.
+		for (const auto &it : byPage_) {
+			if (it.first >= startPage && it.first <= endPage)
+				checkPage(it.second);
+		}
+	} else {
+		for (u32 page = startPage; page <= endPage; ++page) {
+			auto it = byPage_.find(page);
+			if (it != byPage_.end())
+				checkPage(it->second);
 		}
-		// We got here - it wasn't in the map at all (or anymore.)
-	} while (false);
+	}
+
+	// Blocks spanning several pages will be found more than once.
+	std::sort(overlapping.begin(), overlapping.end());
+	overlapping.erase(std::unique(overlapping.begin(), overlapping.end()), overlapping.end());
+	for (int block_num : overlapping) {
+		// Might've been destroyed already via a proxy.
+		if (!blocks_[block_num].invalid)
+			DestroyBlock(block_num, DestroyType::INVALIDATE);
+	}
 }
 
 void JitBlockCache::InvalidateChangedBlocks() {
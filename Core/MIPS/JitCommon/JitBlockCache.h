@@ -43,6 +43,16 @@ struct BlockCacheStats {
 	float maxBloat;
 	u32 maxBloatBlock;
 	std::map<float, u32> bloatMap;
+	// Only used by tiered backends (IR interpreted first, then native.)
+	int tierThreshold = 0;
+	int numNativeBlocks = 0;
+	int numPendingNativeBlocks = 0;
+	// Times native code space ran out and only the hottest blocks were kept, and how many were dropped.
+	int numNativeEvictions = 0;
+	int numEvictedNativeBlocks = 0;
+	// Blocks that continued across jumps, by instruction count rounded up to a power of two.
+	int numTraceBlocks = 0;
+	std::map<int, int> traceLengthHistogram;
 };
 
 enum class DestroyType {
@@ -73,6 +83,9 @@ struct JitBlock {
 	u16 codeSize;
 	u16 originalSize;
 	u16 blockNum;
+	// Backend-defined signature of the guest register state expected at checkedEntry.
+	// Exits are only linked directly between blocks with the same contract.
+	u32 regContract;
 
 	bool invalid;
 	bool linkStatus[MAX_JIT_BLOCK_EXITS];
@@ -181,6 +194,10 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 	void AddBlockMap(int block_num);
 	void RemoveBlockMap(int block_num);
 
+	static u32 AddressToPage(u32 pAddr) {
+		return pAddr >> 12;
+	}
+
 	MIPSOpcode GetEmuHackOpForBlock(int block_num) const;
 
 	CodeBlockCommon *codeBlock_;
@@ -190,6 +207,8 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 	int num_blocks_;
 	std::unordered_multimap<u32, int> links_to_;
 	std::map<std::pair<u32,u32>, u32> block_map_; // (end_addr, start_addr) -> number
+	// Physical 4KB page -> blocks overlapping that page, so invalidation only looks at touched pages.
+	std::unordered_map<u32, std::vector<int>> byPage_;
 
 	enum {
 		JITBLOCK_RANGE_SCRATCH = 0,
@@ -18,10 +18,27 @@
 #include "ppsspp_config.h"
 #include "Common/CPUDetect.h"
 #include "Core/Config.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/JitCommon/JitState.h"
 #include "Common/MemoryUtil.h"
 
 namespace MIPSComp {
+	u32 JitState::PredictJumpRegTarget(const MIPSState *mips, MIPSGPReg rs) const {
+		// Only safe to guess if we're compiling the block being run, and it doesn't change rs first.
+		if (preloading || lastContinuedPC != 0 || mips->pc != blockStart || compilerPC < blockStart)
+			return 0;
+		for (u32 addr = blockStart; addr < compilerPC; addr += 4) {
+			if (MIPSAnalyst::GetOutGPReg(Memory::Read_Instruction(addr, true)) == rs)
+				return 0;
+		}
+
+		u32 target = mips->r[rs];
+		if (!Memory::IsValidAddress(target) || (target & 3) != 0)
+			return 0;
+		return target;
+	}
+
 	JitOptions::JitOptions() {
 		disableFlags = g_Config.uJitDisableFlags;
 
@@ -71,6 +71,8 @@ namespace MIPSComp {
 		bool compiling;	// TODO: get rid of this in favor of using analysis results to determine end of block
 		bool hadBreakpoints;
 		bool preloading = false;
+		// g_Config.bFastMemory, unless this block kept faulting (see MemFault_IsSlowMemBlock.)
+		bool fastMemory = true;
 		JitBlock *curBlock;
 
 		u8 hasSetRounding = 0;
@@ -112,6 +114,10 @@ namespace MIPSComp {
 			return (prefixDFlag & PREFIX_KNOWN) == 0 || prefixD != 0x0;
 		}
 
+		// Guesses the target of a jr/jalr at compilerPC from the current register value, or returns 0.
+		// Blocks are compiled right before they run, so this is what it'll be at least the first time.
+		u32 PredictJumpRegTarget(const MIPSState *mips, MIPSGPReg rs) const;
+
 		bool MayHavePrefix() const {
 			if (HasUnknownPrefix()) {
 				return true;
@@ -211,8 +217,9 @@ namespace MIPSComp {
 		VFPU_MTX_VMMOV = 0x08000000,
 		VFPU_MTX_VMMUL = 0x10000000,
 		VFPU_MTX_VMSCL = 0x20000000,
+		IDLE_LOOPS = 0x40000000,
 
-		ALL_FLAGS = 0x3FFFFFFF,
+		ALL_FLAGS = 0x7FFFFFFF,
 	};
 
 	struct JitOptions {
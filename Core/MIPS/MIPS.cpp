@@ -26,6 +26,7 @@
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Core/ConfigValues.h"
+#include "Core/MemFault.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSInt.h"
 #include "Core/MIPS/MIPSTables.h"
@@ -217,6 +218,8 @@ void MIPSState::Init() {
 		MIPSComp::jit = MIPSComp::CreateNativeJit(this);
 	} else if (PSP_CoreParameter().cpuCore == CPUCore::IR_JIT) {
 		MIPSComp::jit = new MIPSComp::IRJit(this);
+	} else if (PSP_CoreParameter().cpuCore == CPUCore::JIT_IR) {
+		MIPSComp::jit = new MIPSComp::IRJit(this, true);
 	} else {
 		MIPSComp::jit = nullptr;
 	}
@@ -256,6 +259,16 @@ void MIPSState::UpdateCore(CPUCore desired) {
 		newjit = new MIPSComp::IRJit(this);
 		break;
 
+	case CPUCore::JIT_IR:
+		INFO_LOG(CPU, "Switching to JIT using IR");
+		if (oldjit) {
+			std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+			MIPSComp::jit = nullptr;
+			delete oldjit;
+		}
+		newjit = new MIPSComp::IRJit(this, true);
+		break;
+
 	case CPUCore::INTERPRETER:
 		INFO_LOG(CPU, "Switching to interpreter");
 		if (oldjit) {
@@ -331,6 +344,7 @@ int MIPSState::RunLoopUntil(u64 globalTicks) {
 	switch (PSP_CoreParameter().cpuCore) {
 	case CPUCore::JIT:
 	case CPUCore::IR_JIT:
+	case CPUCore::JIT_IR:
 		while (inDelaySlot) {
 			// We must get out of the delay slot before going into jit.
 			SingleStep();
@@ -338,6 +352,7 @@ int MIPSState::RunLoopUntil(u64 globalTicks) {
 		insideJit = true;
 		if (hasPendingClears)
 			ProcessPendingClears();
+		Memory::MemCheckWatch_Rearm();
 		MIPSComp::jit->RunLoopUntil(globalTicks);
 		insideJit = false;
 		break;
@@ -372,6 +387,14 @@ void MIPSState::InvalidateICache(u32 address, int length) {
 	}
 }
 
+void MIPSState::InvalidateICacheLater(u32 address, int length) {
+	std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+	if (MIPSComp::jit && length != 0) {
+		pendingClears.emplace_back(address, length);
+		hasPendingClears = true;
+	}
+}
+
 void MIPSState::ClearJitCache() {
 	std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
 	if (MIPSComp::jit) {
@@ -264,6 +264,8 @@ class MIPSState
 	int RunLoopUntil(u64 globalTicks);
 	// To clear jit caches, etc.
 	void InvalidateICache(u32 address, int length = 4);
+	// Like InvalidateICache, but waits until the jit is next entered (safe from inside jit code.)
+	void InvalidateICacheLater(u32 address, int length = 4);
 
 	void ClearJitCache();
 
@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include "ppsspp_config.h"
+#include <algorithm>
 #include <map>
 #include <set>
 #include <unordered_map>
@@ -25,8 +26,11 @@
 #include "ext/cityhash/city.h"
 #include "ext/xxhash.h"
 
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
 #include "Common/Log.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/MemMap.h"
@@ -38,6 +42,7 @@
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/Debugger/DebugInterface.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/HLE/ReplaceTables.h"
 
 using namespace MIPSCodeUtils;
@@ -79,6 +84,78 @@ static std::unordered_set<HashMapFunc> hashMap;
 
 static Path hashmapFileName;
 
+// knownfuncs.bin is a sorted copy of knownfuncs.ini, written alongside it.  It's read in one go
+// and searched in place, instead of parsing the text file on every module load.
+static const u32 HASHMAP_BIN_MAGIC = 0x4D484650;  // "PFHM"
+static const u32 HASHMAP_BIN_VERSION = 1;
+
+struct HashMapBinHeader {
+	u32 magic;
+	u32 version;
+	u32 entrySize;
+	u32 count;
+};
+
+struct HashMapBinEntry {
+	u64 hash;
+	u32 size;
+	char name[64];
+	u32 reserved;
+
+	bool operator <(const HashMapBinEntry &other) const {
+		return hash < other.hash || (hash == other.hash && size < other.size);
+	}
+};
+
+static std::vector<HashMapBinEntry> sortedHashMap;
+
+// Per game cache of scan results, so later boots can skip scanning and hashing unchanged code.
+static const u32 FUNCSCANCACHE_MAGIC = 0x43534650;  // "PFSC"
+// Bump on any change to the scanner or to the function hash, old results would be wrong.
+static const u32 FUNCSCANCACHE_VERSION = 1;
+// Overlays can leave a lot of variants of the same range behind, keep the newest ones.
+static const size_t FUNCSCANCACHE_MAX_RANGES = 256;
+
+struct FuncScanCacheHeader {
+	u32 magic;
+	u32 version;
+	u32 numRanges;
+	u32 reserved;
+};
+
+struct FuncScanCacheRange {
+	u32 start;
+	u32 end;
+	// The last function may end after the range, so the memory hash covers up to here.
+	u32 hashEnd;
+	u32 numFunctions;
+	u64 memoryHash;
+};
+
+enum : u32 {
+	FUNCSCANCACHE_HAS_HASH = 1,
+	FUNCSCANCACHE_STRAIGHT_LEAF = 2,
+};
+
+struct FuncScanCacheFunction {
+	u32 start;
+	u32 end;
+	u64 hash;
+	u32 flags;
+	u32 reserved;
+};
+
+struct CachedScan {
+	FuncScanCacheRange range;
+	std::vector<FuncScanCacheFunction> functions;
+};
+
+static std::vector<CachedScan> scanCache;
+// Scanned since the last FinalizeScan(), saved once their hashes are known.
+static std::vector<CachedScan> pendingScans;
+static Path scanCachePath;
+static bool scanCacheLoaded = false;
+
 #define MIPSTABLE_IMM_MASK 0xFC000000
 
 // Similar to HashMapFunc but has a char pointer for the name for efficiency.
@@ -626,6 +703,58 @@ namespace MIPSAnalyst {
 		return (info & DELAYSLOT) != 0;
 	}
 
+	bool IsIdleLoop(u32 loopStart, u32 branchAddr) {
+		static const u32 MAX_IDLE_LOOP_INSTRUCTIONS = 16;
+		// Only simple integer ops and loads, no stores, calls, HI/LO, FPU or VFPU.
+		static const u64 ALLOWED = MEMTYPE_MASK | CONDTYPE_MASK | DELAYSLOT | LIKELY | IS_CONDBRANCH | IS_JUMP | IN_RS | IN_RS_ADDR | IN_RS_SHIFT | IN_RT | IN_SA | IN_IMM16 | IN_IMM26 | IN_MEM | OUT_RT | OUT_RD;
+
+		if (loopStart > branchAddr || (branchAddr - loopStart) / 4 + 2 > MAX_IDLE_LOOP_INSTRUCTIONS)
+			return false;
+		if (!Memory::IsValidAddress(loopStart) || !Memory::IsValidAddress(branchAddr + 4))
+			return false;
+
+		MIPSOpcode ops[MAX_IDLE_LOOP_INSTRUCTIONS];
+		u32 count = 0;
+		u32 loopWritten = 0;
+		for (u32 addr = loopStart; addr <= branchAddr + 4; addr += 4) {
+			MIPSOpcode op = Memory::Read_Instruction(addr, true);
+			MIPSInfo info = MIPSGetInfo(op);
+			if ((info & ~ALLOWED) != 0 || IsSyscall(op))
+				return false;
+			// The only branch must be the one closing the loop.
+			if ((info & DELAYSLOT) != 0 && addr != branchAddr)
+				return false;
+			if ((info & IS_JUMP) != 0 && (info & IN_RS) != 0)
+				return false;
+
+			MIPSGPReg out = GetOutGPReg(op);
+			if (out != MIPS_REG_INVALID && out != MIPS_REG_ZERO)
+				loopWritten |= 1 << out;
+			ops[count++] = op;
+		}
+
+		// Any register the loop changes must be written before it's read in each iteration.
+		// Otherwise it carries state between iterations, like a timeout counter.
+		u32 written = 0;
+		for (u32 i = 0; i < count; ++i) {
+			MIPSOpcode op = ops[i];
+			MIPSInfo info = MIPSGetInfo(op);
+			u32 reads = 0;
+			if (info & IN_RS)
+				reads |= 1 << MIPS_GET_RS(op);
+			if (info & IN_RT)
+				reads |= 1 << MIPS_GET_RT(op);
+			if ((reads & loopWritten & ~written) != 0)
+				return false;
+
+			MIPSGPReg out = GetOutGPReg(op);
+			if (out != MIPS_REG_INVALID && out != MIPS_REG_ZERO)
+				written |= 1 << out;
+		}
+
+		return true;
+	}
+
 	bool OpWouldChangeMemory(u32 pc, u32 addr, u32 size) {
 		const auto op = Memory::Read_Instruction(pc, true);
 
@@ -743,6 +872,11 @@ namespace MIPSAnalyst {
 		std::lock_guard<std::recursive_mutex> guard(functions_lock);
 		functions.clear();
 		hashToFunction.clear();
+		// The scan cache is per game, so pick it up again on the next scan.
+		scanCache.clear();
+		pendingScans.clear();
+		scanCachePath.clear();
+		scanCacheLoaded = false;
 	}
 
 	void UpdateHashToFunctionMap() {
@@ -867,12 +1001,11 @@ namespace MIPSAnalyst {
 		return DetermineRegisterUsage(reg, addr, instrs) == USAGE_CLOBBERED;
 	}
 
-	void HashFunctions() {
-		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+	static void HashFunctionRange(const std::vector<int> &pending, int lower, int upper) {
 		std::vector<u32> buffer;
 
-		for (auto iter = functions.begin(), end = functions.end(); iter != end; iter++) {
-			AnalyzedFunction &f = *iter;
+		for (int i = lower; i < upper; i++) {
+			AnalyzedFunction &f = functions[pending[i]];
 			if (!Memory::IsValidRange(f.start, f.end - f.start + 4)) {
 				continue;
 			}
@@ -903,6 +1036,30 @@ namespace MIPSAnalyst {
 		}
 	}
 
+	// Only hashes functions that were added since the last call.
+	void HashFunctions() {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+
+		std::vector<int> pending;
+		for (size_t i = 0; i < functions.size(); ++i) {
+			if (!functions[i].hashed) {
+				functions[i].hashed = true;
+				pending.push_back((int)i);
+			}
+		}
+
+		auto hashRange = [&](int lower, int upper) {
+			HashFunctionRange(pending, lower, upper);
+		};
+		if (g_threadManager.IsInitialized() && pending.size() >= 128) {
+			// Instruction reads may look at the jit's block cache, so keep it still while the tasks run.
+			std::lock_guard<std::recursive_mutex> jitGuard(MIPSComp::jitLock);
+			ParallelRangeLoop(&g_threadManager, hashRange, 0, (int)pending.size(), 64);
+		} else {
+			hashRange(0, (int)pending.size());
+		}
+	}
+
 	void PrecompileFunction(u32 startAddr, u32 length) {
 		// Direct calls to this ignore the bPreloadFunctions flag, since it's just for stubs.
 		std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
@@ -919,15 +1076,21 @@ namespace MIPSAnalyst {
 
 		// TODO: Load from cache file if available instead.
 
+		// Functions from previously loaded modules are already done.
 		double st = time_now_d();
+		int count = 0;
 		for (auto iter = functions.begin(), end = functions.end(); iter != end; iter++) {
-			const AnalyzedFunction &f = *iter;
+			AnalyzedFunction &f = *iter;
+			if (f.precompiled)
+				continue;
 
 			PrecompileFunction(f.start, f.end - f.start + 4);
+			f.precompiled = true;
+			count++;
 		}
 		double et = time_now_d();
 
-		NOTICE_LOG(JIT, "Precompiled %d MIPS functions in %0.2f milliseconds", (int)functions.size(), (et - st) * 1000.0);
+		NOTICE_LOG(JIT, "Precompiled %d MIPS functions in %0.2f milliseconds", count, (et - st) * 1000.0);
 	}
 
 	static const char *DefaultFunctionName(char buffer[256], u32 startAddr) {
@@ -1015,11 +1178,11 @@ namespace MIPSAnalyst {
 		return furthestJumpbackAddr;
 	}
 
-	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols) {
-		std::lock_guard<std::recursive_mutex> guard(functions_lock);
-
-		FunctionsVector new_functions;
-
+	// Finds the functions in [startAddr, endAddr] without touching the function list or adding symbols.
+	// Only reads memory and the symbol map, so several ranges can be scanned at once.
+	// Returns false if a function disagreed with an existing symbol, which means symbols shouldn't be inserted.
+	static bool ScanRangeForFunctions(u32 startAddr, u32 endAddr, FunctionsVector &new_functions) {
+		bool insertSymbols = true;
 		AnalyzedFunction currentFunction = {startAddr};
 
 		u32 furthestBranch = 0;
@@ -1160,19 +1323,257 @@ namespace MIPSAnalyst {
 
 		for (auto iter = new_functions.begin(); iter != new_functions.end(); iter++) {
 			iter->size = iter->end - iter->start + 4;
-			if (insertSymbols && !iter->foundInSymbolMap) {
-				char temp[256];
-				g_symbolMap->AddFunction(DefaultFunctionName(temp, iter->start), iter->start, iter->end - iter->start + 4);
+		}
+		return insertSymbols;
+	}
+
+	// Drops analyzed functions starting in [startAddr, endAddr] and returns how many were removed.
+	static size_t EraseFunctions(u32 startAddr, u32 endAddr) {
+		// Most of the time, functions from the same module will be contiguous in functions.
+		FunctionsVector::iterator prevMatch = functions.end();
+		size_t originalSize = functions.size();
+		for (auto iter = functions.begin(); iter != functions.end(); ++iter) {
+			const bool hadPrevMatch = prevMatch != functions.end();
+			const bool match = iter->start >= startAddr && iter->start <= endAddr;
+
+			if (!hadPrevMatch && match) {
+				// Entering a range.
+				prevMatch = iter;
+			} else if (hadPrevMatch && !match) {
+				// Left a range.
+				iter = functions.erase(prevMatch, iter);
+				prevMatch = functions.end();
 			}
 		}
+		if (prevMatch != functions.end()) {
+			// Cool, this is the fastest way.
+			functions.erase(prevMatch, functions.end());
+		}
+		return originalSize - functions.size();
+	}
 
-		// Concatenate the new functions to the end of the old ones.
-		functions.insert(functions.end(), new_functions.begin(), new_functions.end());
+	static void LoadScanCache() {
+		if (scanCacheLoaded)
+			return;
+		scanCacheLoaded = true;
+		std::string discID = g_paramSFO.GetDiscID();
+		if (!g_Config.bFuncScanCache || discID.empty())
+			return;
+
+		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+		scanCachePath = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".funcscan");
+
+		FILE *file = File::OpenCFile(scanCachePath, "rb");
+		if (!file)
+			return;
+
+		FuncScanCacheHeader header;
+		bool valid = fread(&header, sizeof(header), 1, file) == 1;
+		valid = valid && header.magic == FUNCSCANCACHE_MAGIC && header.version == FUNCSCANCACHE_VERSION;
+		for (u32 i = 0; valid && i < header.numRanges; ++i) {
+			CachedScan scan;
+			valid = fread(&scan.range, sizeof(scan.range), 1, file) == 1;
+			// Sanity check, there can't be more functions than instructions.
+			valid = valid && scan.range.hashEnd > scan.range.start && scan.range.numFunctions <= (scan.range.hashEnd - scan.range.start) / 4;
+			if (valid && scan.range.numFunctions != 0) {
+				scan.functions.resize(scan.range.numFunctions);
+				valid = fread(&scan.functions[0], sizeof(FuncScanCacheFunction), scan.range.numFunctions, file) == scan.range.numFunctions;
+			}
+			if (valid)
+				scanCache.push_back(std::move(scan));
+		}
+		fclose(file);
+
+		if (!valid) {
+			WARN_LOG(LOADER, "Ignoring bad function scan cache %s", scanCachePath.c_str());
+			scanCache.clear();
+		} else {
+			INFO_LOG(LOADER, "Loaded %d cached function scans", (int)scanCache.size());
+		}
+	}
+
+	static void SaveScanCache() {
+		FILE *file = File::OpenCFile(scanCachePath, "wb");
+		if (!file)
+			return;
+
+		FuncScanCacheHeader header{};
+		header.magic = FUNCSCANCACHE_MAGIC;
+		header.version = FUNCSCANCACHE_VERSION;
+		header.numRanges = (u32)scanCache.size();
+		bool writeFailed = fwrite(&header, sizeof(header), 1, file) != 1;
+		for (const CachedScan &scan : scanCache) {
+			writeFailed = writeFailed || fwrite(&scan.range, sizeof(scan.range), 1, file) != 1;
+			if (!scan.functions.empty())
+				writeFailed = writeFailed || fwrite(&scan.functions[0], sizeof(FuncScanCacheFunction), scan.functions.size(), file) != scan.functions.size();
+		}
+		fclose(file);
+
+		if (writeFailed) {
+			ERROR_LOG(LOADER, "Failed to write function scan cache, disk full?");
+			File::Delete(scanCachePath);
+		}
+	}
+
+	static bool HashScanMemory(u32 start, u32 hashEnd, u64 *hash) {
+		if (!Memory::IsValidRange(start, hashEnd - start))
+			return false;
+		*hash = XXH3_64bits(Memory::GetPointerUnchecked(start), hashEnd - start);
+		return true;
+	}
+
+	// Only a match if the memory is exactly the same as when the range was scanned.
+	static const CachedScan *FindCachedScan(u32 start, u32 end) {
+		// Newest first, in case an overlay was scanned again after a change.
+		for (auto it = scanCache.rbegin(); it != scanCache.rend(); ++it) {
+			u64 memoryHash;
+			if (it->range.start == start && it->range.end == end && HashScanMemory(start, it->range.hashEnd, &memoryHash) && memoryHash == it->range.memoryHash)
+				return &*it;
+		}
+		return nullptr;
+	}
+
+	// Produces the same results as ScanRangeForFunctions() did for this memory, already hashed.
+	static bool RestoreCachedScan(const CachedScan &scan, FunctionsVector &new_functions) {
+		bool insertSymbols = true;
+		for (const FuncScanCacheFunction &cf : scan.functions) {
+			AnalyzedFunction f{};
+			f.start = cf.start;
+			f.end = cf.end;
+			f.size = f.end - f.start + 4;
+			f.hash = cf.hash;
+			f.hasHash = (cf.flags & FUNCSCANCACHE_HAS_HASH) != 0;
+			f.isStraightLeaf = (cf.flags & FUNCSCANCACHE_STRAIGHT_LEAF) != 0;
+			f.hashed = true;
+
+			// The symbol map may differ from last time, so this is checked again.
+			u32 existingSize = g_symbolMap->GetFunctionSize(f.start);
+			if (existingSize != SymbolMap::INVALID_ADDRESS) {
+				f.foundInSymbolMap = true;
+				if (existingSize != f.size)
+					insertSymbols = false;
+			}
+			new_functions.push_back(f);
+		}
+		return insertSymbols;
+	}
+
+	static void AddPendingScan(const ScanRange &range, const FunctionsVector &found) {
+		CachedScan scan{};
+		scan.range.start = range.start;
+		scan.range.end = range.end;
+		scan.range.hashEnd = range.end + 4;
+		for (const AnalyzedFunction &f : found) {
+			FuncScanCacheFunction cf{};
+			cf.start = f.start;
+			cf.end = f.end;
+			cf.flags = f.isStraightLeaf ? FUNCSCANCACHE_STRAIGHT_LEAF : 0;
+			scan.functions.push_back(cf);
+			scan.range.hashEnd = std::max(scan.range.hashEnd, f.end + 4);
+		}
+		scan.range.numFunctions = (u32)scan.functions.size();
+		if (HashScanMemory(scan.range.start, scan.range.hashEnd, &scan.range.memoryHash))
+			pendingScans.push_back(std::move(scan));
+	}
+
+	// Called once the functions are hashed, to store the new scans with their hashes.
+	static void CommitPendingScans() {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+		if (pendingScans.empty())
+			return;
+
+		std::unordered_map<u32, const AnalyzedFunction *> byStart;
+		for (const AnalyzedFunction &f : functions)
+			byStart[f.start] = &f;
+
+		for (CachedScan &scan : pendingScans) {
+			for (FuncScanCacheFunction &cf : scan.functions) {
+				auto it = byStart.find(cf.start);
+				if (it != byStart.end() && it->second->end == cf.end && it->second->hasHash) {
+					cf.hash = it->second->hash;
+					cf.flags |= FUNCSCANCACHE_HAS_HASH;
+				}
+			}
+
+			// Replace any older result for the same memory.
+			scanCache.erase(std::remove_if(scanCache.begin(), scanCache.end(), [&](const CachedScan &old) {
+				return old.range.start == scan.range.start && old.range.end == scan.range.end && old.range.memoryHash == scan.range.memoryHash;
+			}), scanCache.end());
+			scanCache.push_back(std::move(scan));
+		}
+		pendingScans.clear();
+
+		if (scanCache.size() > FUNCSCANCACHE_MAX_RANGES)
+			scanCache.erase(scanCache.begin(), scanCache.begin() + (scanCache.size() - FUNCSCANCACHE_MAX_RANGES));
+		SaveScanCache();
+	}
+
+	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols) {
+		return ScanForFunctions(std::vector<ScanRange>{ { startAddr, endAddr } }, insertSymbols);
+	}
+
+	bool ScanForFunctions(const std::vector<ScanRange> &ranges, bool insertSymbols) {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+
+		LoadScanCache();
+		std::vector<const CachedScan *> cached(ranges.size());
+		if (!scanCachePath.empty()) {
+			for (size_t i = 0; i < ranges.size(); ++i)
+				cached[i] = FindCachedScan(ranges[i].start, ranges[i].end);
+		}
+
+		std::vector<FunctionsVector> results(ranges.size());
+		std::vector<char> symbolsMatched(ranges.size());
+		auto scanRanges = [&](int lower, int upper) {
+			for (int i = lower; i < upper; ++i) {
+				if (cached[i])
+					symbolsMatched[i] = RestoreCachedScan(*cached[i], results[i]);
+				else
+					symbolsMatched[i] = ScanRangeForFunctions(ranges[i].start, ranges[i].end, results[i]);
+			}
+		};
+		if (g_threadManager.IsInitialized() && ranges.size() > 1) {
+			// Instruction reads may look at the jit's block cache, so keep it still while the tasks run.
+			std::lock_guard<std::recursive_mutex> jitGuard(MIPSComp::jitLock);
+			ParallelRangeLoop(&g_threadManager, scanRanges, 0, (int)ranges.size(), 1);
+		} else {
+			scanRanges(0, (int)ranges.size());
+		}
+
+		// Merge in order, so symbols end up exactly as if the ranges were scanned one by one.
+		size_t erased = 0;
+		for (size_t i = 0; i < ranges.size(); ++i) {
+			if (!symbolsMatched[i])
+				insertSymbols = false;
+
+			// Anything we knew about in this range is stale now, and would otherwise stay as a duplicate.
+			erased += EraseFunctions(ranges[i].start, ranges[i].end);
+
+			if (insertSymbols) {
+				for (const AnalyzedFunction &f : results[i]) {
+					if (!f.foundInSymbolMap) {
+						char temp[256];
+						g_symbolMap->AddFunction(DefaultFunctionName(temp, f.start), f.start, f.size);
+					}
+				}
+			}
+
+			if (!cached[i] && !scanCachePath.empty())
+				AddPendingScan(ranges[i], results[i]);
+
+			// Concatenate the new functions to the end of the old ones.
+			functions.insert(functions.end(), results[i].begin(), results[i].end());
+		}
+
+		// The map points into functions, which just moved around.
+		if (erased != 0 || !hashToFunction.empty())
+			UpdateHashToFunctionMap();
 		return insertSymbols;
 	}
 
 	void FinalizeScan(bool insertSymbols) {
 		HashFunctions();
+		CommitPendingScans();
 
 		Path hashMapFilename = GetSysDirectory(DIRECTORY_SYSTEM) / "knownfuncs.ini";
 		if (g_Config.bFuncHashMap || g_Config.bFuncReplacements) {
@@ -1212,7 +1613,7 @@ namespace MIPSAnalyst {
 		}
 
 		// Cheats a little.
-		AnalyzedFunction fun;
+		AnalyzedFunction fun{};
 		fun.start = startAddr;
 		fun.end = startAddr + size - 4;
 		fun.isStraightLeaf = false;  // dunno really
@@ -1230,32 +1631,13 @@ namespace MIPSAnalyst {
 		// the easy way of saving a hashmap by unloading and loading a game. I added
 		// an alternative way.
 
-		// Most of the time, functions from the same module will be contiguous in functions.
-		FunctionsVector::iterator prevMatch = functions.end();
-		size_t originalSize = functions.size();
-		for (auto iter = functions.begin(); iter != functions.end(); ++iter) {
-			const bool hadPrevMatch = prevMatch != functions.end();
-			const bool match = iter->start >= startAddr && iter->start <= endAddr;
-
-			if (!hadPrevMatch && match) {
-				// Entering a range.
-				prevMatch = iter;
-			} else if (hadPrevMatch && !match) {
-				// Left a range.
-				iter = functions.erase(prevMatch, iter);
-				prevMatch = functions.end();
-			}
-		}
-		if (prevMatch != functions.end()) {
-			// Cool, this is the fastest way.
-			functions.erase(prevMatch, functions.end());
-		}
+		size_t erased = EraseFunctions(startAddr, endAddr);
 
 		RestoreReplacedInstructions(startAddr, endAddr);
 
 		if (functions.empty()) {
 			hashToFunction.clear();
-		} else if (originalSize != functions.size()) {
+		} else if (erased != 0) {
 			UpdateHashToFunctionMap();
 		}
 	}
@@ -1295,6 +1677,14 @@ namespace MIPSAnalyst {
 		if (it != hashMap.end()) {
 			return it->name;
 		}
+
+		HashMapBinEntry key{};
+		key.hash = hash;
+		key.size = funcsize;
+		auto bin = std::lower_bound(sortedHashMap.begin(), sortedHashMap.end(), key);
+		if (bin != sortedHashMap.end() && bin->hash == hash && bin->size == funcsize) {
+			return bin->name;
+		}
 		return 0;
 	}
 
@@ -1310,50 +1700,123 @@ namespace MIPSAnalyst {
 			filename = hashmapFileName;
 
 		UpdateHashMap();
-		if (hashMap.empty()) {
+		if (hashMap.empty() && sortedHashMap.empty()) {
 			return;
 		}
 
+		// Entries found this session win over the ones from the binary file.
+		std::vector<HashMapBinEntry> merged;
+		merged.reserve(hashMap.size() + sortedHashMap.size());
+		for (const HashMapFunc &mf : hashMap) {
+			if (mf.hardcoded)
+				continue;
+			HashMapBinEntry entry{};
+			entry.hash = mf.hash;
+			entry.size = mf.size;
+			truncate_cpy(entry.name, mf.name);
+			merged.push_back(entry);
+		}
+		for (const HashMapBinEntry &entry : sortedHashMap) {
+			const HashMapFunc key = { "", entry.hash, entry.size };
+			auto it = hashMap.find(key);
+			if (it == hashMap.end() || it->hardcoded)
+				merged.push_back(entry);
+		}
+		std::sort(merged.begin(), merged.end());
+
 		FILE *file = File::OpenCFile(filename, "wt");
 		if (!file) {
 			WARN_LOG(LOADER, "Could not store hash map: %s", filename.c_str());
 			return;
 		}
 
-		for (auto it = hashMap.begin(), end = hashMap.end(); it != end; ++it) {
-			const HashMapFunc &mf = *it;
-			if (!mf.hardcoded) {
-				if (fprintf(file, "%016llx:%d = %s\n", mf.hash, mf.size, mf.name) <= 0) {
-					WARN_LOG(LOADER, "Could not store hash map: %s", filename.c_str());
-					break;
-				}
+		for (const HashMapBinEntry &entry : merged) {
+			if (fprintf(file, "%016llx:%d = %s\n", (unsigned long long)entry.hash, entry.size, entry.name) <= 0) {
+				WARN_LOG(LOADER, "Could not store hash map: %s", filename.c_str());
+				break;
 			}
 		}
 		fclose(file);
+
+		// Written after the text file, so it's only used if it's at least as new.
+		Path binFilename = filename.WithReplacedExtension(".bin");
+		file = File::OpenCFile(binFilename, "wb");
+		if (!file) {
+			return;
+		}
+		HashMapBinHeader header{};
+		header.magic = HASHMAP_BIN_MAGIC;
+		header.version = HASHMAP_BIN_VERSION;
+		header.entrySize = (u32)sizeof(HashMapBinEntry);
+		header.count = (u32)merged.size();
+		bool writeFailed = fwrite(&header, sizeof(header), 1, file) != 1;
+		writeFailed = writeFailed || (!merged.empty() && fwrite(&merged[0], sizeof(HashMapBinEntry), merged.size(), file) != merged.size());
+		fclose(file);
+		if (writeFailed) {
+			WARN_LOG(LOADER, "Could not store binary hash map: %s", binFilename.c_str());
+			File::Delete(binFilename);
+		}
+	}
+
+	// Reads knownfuncs.bin if it's up to date with the text file, replacing anything loaded from it before.
+	static bool LoadBinaryHashMap(const Path &filename) {
+		Path binFilename = filename.WithReplacedExtension(".bin");
+		File::FileInfo textInfo, binInfo;
+		if (!File::GetFileInfo(binFilename, &binInfo) || !binInfo.exists)
+			return false;
+		// If someone edited the text file by hand, that's what we want.
+		if (File::GetFileInfo(filename, &textInfo) && textInfo.exists && textInfo.mtime > binInfo.mtime)
+			return false;
+
+		FILE *file = File::OpenCFile(binFilename, "rb");
+		if (!file)
+			return false;
+
+		HashMapBinHeader header;
+		std::vector<HashMapBinEntry> entries;
+		bool valid = fread(&header, sizeof(header), 1, file) == 1;
+		valid = valid && header.magic == HASHMAP_BIN_MAGIC && header.version == HASHMAP_BIN_VERSION;
+		valid = valid && header.entrySize == sizeof(HashMapBinEntry) && (u64)header.count * sizeof(HashMapBinEntry) + sizeof(header) <= binInfo.size;
+		if (valid && header.count != 0) {
+			entries.resize(header.count);
+			valid = fread(&entries[0], sizeof(HashMapBinEntry), header.count, file) == header.count;
+		}
+		fclose(file);
+		// Lookups rely on the order, so don't trust it blindly.
+		if (!valid || !std::is_sorted(entries.begin(), entries.end())) {
+			WARN_LOG(LOADER, "Ignoring bad binary hash map: %s", binFilename.c_str());
+			return false;
+		}
+
+		for (HashMapBinEntry &entry : entries)
+			entry.name[sizeof(entry.name) - 1] = 0;
+		sortedHashMap = std::move(entries);
+		return true;
 	}
 
 	void ApplyHashMap() {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
 		UpdateHashToFunctionMap();
 
-		for (auto mf = hashMap.begin(), end = hashMap.end(); mf != end; ++mf) {
-			auto range = hashToFunction.equal_range(mf->hash);
-			if (range.first == range.second) {
+		// Look up each function, rather than each known hash, so the binary map can be searched in place.
+		for (AnalyzedFunction &f : functions) {
+			// Same filter as hashToFunction.
+			if (!f.hasHash || f.size <= 16) {
+				continue;
+			}
+			const char *name = LookupHash(f.hash, f.size);
+			if (!name) {
 				continue;
 			}
 
 			// Yay, found a function.
-			for (auto iter = range.first; iter != range.second; ++iter) {
-				AnalyzedFunction &f = *iter->second;
-				if (f.hash == mf->hash && f.size == mf->size) {
-					strncpy(f.name, mf->name, sizeof(mf->name) - 1);
-
-					std::string existingLabel = g_symbolMap->GetLabelString(f.start);
-					char defaultLabel[256];
-					// If it was renamed, keep it.  Only change the name if it's still the default.
-					if (existingLabel.empty() || existingLabel == DefaultFunctionName(defaultLabel, f.start)) {
-						g_symbolMap->SetLabelName(mf->name, f.start);
-					}
-				}
+			strncpy(f.name, name, sizeof(f.name) - 1);
+
+			std::string existingLabel = g_symbolMap->GetLabelString(f.start);
+			char defaultLabel[256];
+			// If it was renamed, keep it.  Only change the name if it's still the default.
+			if (existingLabel.empty() || existingLabel == DefaultFunctionName(defaultLabel, f.start)) {
+				g_symbolMap->SetLabelName(name, f.start);
 			}
 		}
 	}
@@ -1371,12 +1834,19 @@ namespace MIPSAnalyst {
 	}
 
 	void LoadHashMap(const Path &filename) {
+		if (LoadBinaryHashMap(filename)) {
+			hashmapFileName = filename;
+			return;
+		}
+
 		FILE *file = File::OpenCFile(filename, "rt");
 		if (!file) {
 			WARN_LOG(LOADER, "Could not load hash map: %s", filename.c_str());
 			return;
 		}
 		hashmapFileName = filename;
+		// Everything is in the text file, and the binary one is out of date.
+		sortedHashMap.clear();
 
 		while (!feof(file)) {
 			HashMapFunc mf = { "" };
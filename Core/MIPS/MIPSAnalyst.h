@@ -92,9 +92,18 @@ namespace MIPSAnalyst
 		bool hasHash;
 		bool usesVFPU;
 		bool foundInSymbolMap;
+		// Later scans only hash and precompile functions that haven't been yet.
+		bool hashed;
+		bool precompiled;
 		char name[64];
 	};
 
+	// Inclusive address range to scan for functions.
+	struct ScanRange {
+		u32 start;
+		u32 end;
+	};
+
 	struct ReplacementTableEntry;
 
 	void Reset();
@@ -108,6 +117,9 @@ namespace MIPSAnalyst
 	void RegisterFunction(u32 startAddr, u32 size, const char *name);
 	// Returns new insertSymbols value for FinalizeScan().
 	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols);
+	// Scans each range on a separate task, then merges the results in order.
+	// Functions previously found inside the ranges are replaced by the new results.
+	bool ScanForFunctions(const std::vector<ScanRange> &ranges, bool insertSymbols);
 	void FinalizeScan(bool insertSymbols);
 	void ForgetFunctions(u32 startAddr, u32 endAddr);
 	void PrecompileFunctions();
@@ -138,6 +150,9 @@ namespace MIPSAnalyst
 	int OpMemoryAccessSize(u32 pc);
 	bool IsOpMemoryWrite(u32 pc);
 	bool OpHasDelaySlot(u32 pc);
+	// Whether the loop from loopStart to the branch at branchAddr (and its delay slot) only
+	// reads memory and recomputes the same registers, so repeating it can't change anything.
+	bool IsIdleLoop(u32 loopStart, u32 branchAddr);
 
 	typedef struct {
 		DebugInterface* cpu;
@@ -180,6 +180,10 @@ static void RetainInvalidSwizzleST(float *d, VectorSize sz) {
 	}
 }
 
+static inline bool HasNoPrefixes() {
+	return currentMIPS->vfpuCtrl[VFPU_CTRL_SPREFIX] == 0xe4 && currentMIPS->vfpuCtrl[VFPU_CTRL_TPREFIX] == 0xe4 && currentMIPS->vfpuCtrl[VFPU_CTRL_DPREFIX] == 0;
+}
+
 void EatPrefixes()
 {
 	currentMIPS->vfpuCtrl[VFPU_CTRL_SPREFIX] = 0xe4;  // passthru
@@ -477,6 +481,15 @@ namespace MIPSInt
 
 		// TODO: Always use the more accurate path in interpreter?
 		bool useAccurateDot = USE_VFPU_DOT || PSP_CoreParameter().compat.flags().MoreAccurateVMMUL;
+		if (sz == M_4x4 && !useAccurateDot && HasNoPrefixes()) {
+			// The common case, no special handling of the last dot.
+			vfpu_mmul_q(d, s, t);
+			WriteMatrix(d, sz, vd);
+			PC += 4;
+			EatPrefixes();
+			return;
+		}
+
 		for (int a = 0; a < n; a++) {
 			for (int b = 0; b < n; b++) {
 				union { float f; uint32_t u; } sum = { 0.0f };
@@ -1655,6 +1668,17 @@ namespace MIPSInt
 		ReadMatrix(s, msz, vs);
 		ReadVector(t, sz, vt);
 
+		if (ins == 3 && n >= 3 && !USE_VFPU_DOT && HasNoPrefixes()) {
+			// vtfm4 and vhtfm4.  For vhtfm4, the fourth term is the matrix value times 1.0f.
+			if (n == 3)
+				t[3] = 1.0f;
+			vfpu_tfm_q(d.f, s, t);
+			WriteVector(d.f, sz, vd);
+			PC += 4;
+			EatPrefixes();
+			return;
+		}
+
 		if (USE_VFPU_DOT) {
 			float t2[4];
 			for (int i = 0; i < 4; i++) {
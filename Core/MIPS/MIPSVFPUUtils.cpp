@@ -20,6 +20,20 @@
 #include <cstdio>
 #include <cstring>
 
+#include "ppsspp_config.h"
+
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 #include "Common/BitScan.h"
 #include "Common/CommonFuncs.h"
 #include "Core/Reporting.h"
@@ -164,6 +178,33 @@ void GetMatrixRows(int matrixReg, MatrixSize msize, u8 vecs[4]) {
 	}
 }
 
+// dst[j * 4 + i] = src[i * 4 + j].  dst and src must not overlap.
+static inline void Transpose4x4(float *dst, const float *src) {
+#if defined(_M_SSE)
+	__m128 r0 = _mm_loadu_ps(src + 0);
+	__m128 r1 = _mm_loadu_ps(src + 4);
+	__m128 r2 = _mm_loadu_ps(src + 8);
+	__m128 r3 = _mm_loadu_ps(src + 12);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_storeu_ps(dst + 0, r0);
+	_mm_storeu_ps(dst + 4, r1);
+	_mm_storeu_ps(dst + 8, r2);
+	_mm_storeu_ps(dst + 12, r3);
+#elif PPSSPP_ARCH(ARM_NEON)
+	float32x4x4_t cols = vld4q_f32(src);
+	vst1q_f32(dst + 0, cols.val[0]);
+	vst1q_f32(dst + 4, cols.val[1]);
+	vst1q_f32(dst + 8, cols.val[2]);
+	vst1q_f32(dst + 12, cols.val[3]);
+#else
+	for (int j = 0; j < 4; j++) {
+		for (int i = 0; i < 4; i++) {
+			dst[j * 4 + i] = src[i * 4 + j];
+		}
+	}
+#endif
+}
+
 void ReadVector(float *rd, VectorSize size, int reg) {
 	int row = 0;
 	int length = 0;
@@ -263,12 +304,8 @@ void ReadMatrix(float *rd, MatrixSize size, int reg) {
 	const float *v = currentMIPS->v + (size_t)mtx * 16;
 	if (transpose) {
 		if (side == 4 && col == 0 && row == 0) {
-			// Fast path: Simple 4x4 transpose. TODO: Optimize.
-			for (int j = 0; j < 4; j++) {
-				for (int i = 0; i < 4; i++) {
-					rd[j * 4 + i] = v[i * 4 + j];
-				}
-			}
+			// Fast path: Simple 4x4 transpose.
+			Transpose4x4(rd, v);
 		} else {
 			for (int j = 0; j < side; j++) {
 				for (int i = 0; i < side; i++) {
@@ -317,12 +354,8 @@ void WriteMatrix(const float *rd, MatrixSize size, int reg) {
 	float *v = currentMIPS->v + (size_t)mtx * 16;
 	if (transpose) {
 		if (side == 4 && row == 0 && col == 0 && currentMIPS->VfpuWriteMask() == 0x0) {
-			// Fast path: Simple 4x4 transpose. TODO: Optimize.
-			for (int j = 0; j < side; j++) {
-				for (int i = 0; i < side; i++) {
-					v[i * 4 + j] = rd[j * 4 + i];
-				}
-			}
+			// Fast path: Simple 4x4 transpose.
+			Transpose4x4(v, rd);
 		} else {
 			for (int j = 0; j < side; j++) {
 				for (int i = 0; i < side; i++) {
@@ -685,6 +718,77 @@ static int32_t get_sign(uint32_t x) {
 	return x & 0x80000000;
 }
 
+// These build each sum in exactly the same order as the scalar loops in MIPSIntVFPU.cpp,
+// with separately rounded multiplies and adds (no FMA), so the results match bit for bit.
+void vfpu_mmul_q(float d[16], const float s[16], const float t[16]) {
+	// d[a * 4 + b] = 0 + s[b * 4 + 0] * t[a * 4 + 0] + ... + s[b * 4 + 3] * t[a * 4 + 3].
+#if defined(_M_SSE)
+	__m128 c0 = _mm_loadu_ps(s + 0);
+	__m128 c1 = _mm_loadu_ps(s + 4);
+	__m128 c2 = _mm_loadu_ps(s + 8);
+	__m128 c3 = _mm_loadu_ps(s + 12);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	for (int a = 0; a < 4; a++) {
+		__m128 sum = _mm_setzero_ps();
+		sum = _mm_add_ps(sum, _mm_mul_ps(c0, _mm_set1_ps(t[a * 4 + 0])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_set1_ps(t[a * 4 + 1])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_set1_ps(t[a * 4 + 2])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(c3, _mm_set1_ps(t[a * 4 + 3])));
+		_mm_storeu_ps(d + a * 4, sum);
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	float32x4x4_t c = vld4q_f32(s);
+	for (int a = 0; a < 4; a++) {
+		float32x4_t sum = vdupq_n_f32(0.0f);
+		sum = vaddq_f32(sum, vmulq_n_f32(c.val[0], t[a * 4 + 0]));
+		sum = vaddq_f32(sum, vmulq_n_f32(c.val[1], t[a * 4 + 1]));
+		sum = vaddq_f32(sum, vmulq_n_f32(c.val[2], t[a * 4 + 2]));
+		sum = vaddq_f32(sum, vmulq_n_f32(c.val[3], t[a * 4 + 3]));
+		vst1q_f32(d + a * 4, sum);
+	}
+#else
+	for (int a = 0; a < 4; a++) {
+		for (int b = 0; b < 4; b++) {
+			float sum = 0.0f;
+			for (int c = 0; c < 4; c++) {
+				sum += s[b * 4 + c] * t[a * 4 + c];
+			}
+			d[a * 4 + b] = sum;
+		}
+	}
+#endif
+}
+
+void vfpu_tfm_q(float d[4], const float m[16], const float t[4]) {
+	// d[i] = m[i * 4 + 0] * t[0] + m[i * 4 + 1] * t[1] + ... + m[i * 4 + 3] * t[3].
+#if defined(_M_SSE)
+	__m128 c0 = _mm_loadu_ps(m + 0);
+	__m128 c1 = _mm_loadu_ps(m + 4);
+	__m128 c2 = _mm_loadu_ps(m + 8);
+	__m128 c3 = _mm_loadu_ps(m + 12);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	__m128 sum = _mm_mul_ps(c0, _mm_set1_ps(t[0]));
+	sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_set1_ps(t[1])));
+	sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_set1_ps(t[2])));
+	sum = _mm_add_ps(sum, _mm_mul_ps(c3, _mm_set1_ps(t[3])));
+	_mm_storeu_ps(d, sum);
+#elif PPSSPP_ARCH(ARM_NEON)
+	float32x4x4_t c = vld4q_f32(m);
+	float32x4_t sum = vmulq_n_f32(c.val[0], t[0]);
+	sum = vaddq_f32(sum, vmulq_n_f32(c.val[1], t[1]));
+	sum = vaddq_f32(sum, vmulq_n_f32(c.val[2], t[2]));
+	sum = vaddq_f32(sum, vmulq_n_f32(c.val[3], t[3]));
+	vst1q_f32(d, sum);
+#else
+	for (int i = 0; i < 4; i++) {
+		d[i] = m[i * 4] * t[0];
+		for (int k = 1; k < 4; k++) {
+			d[i] += m[i * 4 + k] * t[k];
+		}
+	}
+#endif
+}
+
 float vfpu_dot(const float a[4], const float b[4]) {
 	static const int EXTRA_BITS = 2;
 	float2int result;
@@ -64,6 +64,9 @@ inline float vfpu_clamp(float v, float min, float max) {
 }
 
 float vfpu_dot(const float a[4], const float b[4]);
+// Fast paths for vmmul.q and vtfm4.q without prefixes, matching the interpreter's plain float math.
+void vfpu_mmul_q(float d[16], const float s[16], const float t[16]);
+void vfpu_tfm_q(float d[4], const float m[16], const float t[4]);
 float vfpu_sqrt(float a);
 float vfpu_rsqrt(float a);
 
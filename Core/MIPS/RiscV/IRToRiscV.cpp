@@ -0,0 +1,1028 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(RISCV64)
+
+#include <cstddef>
+#include <cstring>
+
+#include "Common/Log.h"
+#include "Common/MemoryUtil.h"
+#include "Core/CoreTiming.h"
+#include "Core/MemMap.h"
+#include "Core/System.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
+#include "Core/MIPS/RiscV/IRToRiscV.h"
+
+namespace MIPSComp {
+
+using namespace RiscVGen;
+
+// Converts IR directly to RISC-V 64, after all the IR passes have run.
+// Mirrors IRToX86, see there for the overall design.
+//
+// Register usage:
+//   X26 (s10) - base pointer of PSP memory
+//   X27 (s11) - pointer to MIPSState
+//   X5, X6, X7 (t0-t2) - scratch, never allocated.
+//   X10 (a0) - next PC when jumping to the exit thunk, and the first call argument.
+//   X1 (ra) - clobbered by calls, saved by the entry thunk.
+//   Everything else except sp/gp/tp - greedily allocated GPRs, written back at exits.
+// GPR values are always kept sign extended from 32 bits, like the W instructions produce.
+// FPRs are not cached, FP ops go through F0-F4 scratch registers directly from MIPSState.
+
+static const RiscVReg CTXREG = X27;
+static const RiscVReg MEMBASEREG = X26;
+static const RiscVReg SCRATCH1 = X5;
+static const RiscVReg SCRATCH2 = X6;
+static const RiscVReg SCRATCH3 = X7;
+static const RiscVReg EXITPCREG = X10;
+
+// Callee saved regs first, since those are preserved across calls we might add later.
+static const RiscVReg allocOrder[] = {
+	X8, X9, X18, X19, X20, X21, X22, X23, X24, X25,
+	X28, X29, X30, X31, X11, X12, X13, X14, X15, X16, X17,
+};
+static const int NUM_ALLOC_REGS = (int)ARRAY_SIZE(allocOrder);
+// IR register operands are a u8, covering everything in MIPSState up to fpcond and beyond.
+static const int IR_NUM_REGS = 256;
+
+// The entry thunk saves ra and s0-s11 here.
+static const RiscVReg savedRegs[] = {
+	R_RA, X8, X9, X18, X19, X20, X21, X22, X23, X24, X25, X26, X27,
+};
+static const int SAVED_STACK_SIZE = ((int)ARRAY_SIZE(savedRegs) * 8 + 15) & ~15;
+
+static const float vec4InitValues[8][4] = {
+	{ 0.0f, 0.0f, 0.0f, 0.0f },
+	{ 1.0f, 1.0f, 1.0f, 1.0f },
+	{ -1.0f, -1.0f, -1.0f, -1.0f },
+	{ 1.0f, 0.0f, 0.0f, 0.0f },
+	{ 0.0f, 1.0f, 0.0f, 0.0f },
+	{ 0.0f, 0.0f, 1.0f, 0.0f },
+	{ 0.0f, 0.0f, 0.0f, 1.0f },
+};
+
+// Everything we touch in MIPSState is well within the 12-bit signed offset of loads and stores.
+static_assert(offsetof(MIPSState, downcount) < 2048, "MIPSState offsets must fit in simm12");
+
+// GPR indices are relative to r[0], so they also reach the temps, vfpuCtrl, lo, hi, etc.
+static s32 GPROffset(int reg) {
+	return (s32)offsetof(MIPSState, r) + reg * 4;
+}
+
+// FPR indices are relative to f[0], and continue into v[] and the vector temps.
+static s32 FPROffset(int reg) {
+	return (s32)offsetof(MIPSState, f) + reg * 4;
+}
+
+static bool FitsSImm12(s32 value) {
+	return value >= -2048 && value < 2048;
+}
+
+// Used for anything not implemented natively.  Runs a single op through the IR interpreter.
+// Returns 0 to continue, or a PC to exit to (for example after a failed address validation.)
+static u32 IRRV64InterpretFallback(MIPSState *mips, u64 instBits) {
+	IRInst inst[2];
+	memcpy(&inst[0], &instBits, sizeof(IRInst));
+	inst[1] = { IROp::ExitToConst, { 0 }, 0, 0, 0 };
+	return IRInterpret(mips, inst, 2);
+}
+
+// Greedy per-block GPR allocator.  Values stay mapped across instructions, and are only
+// written back at exits and before falling back to the interpreter.
+class IRRV64RegCache {
+public:
+	void Start(RiscVEmitter *emit) {
+		emit_ = emit;
+		for (int i = 0; i < IR_NUM_REGS; ++i)
+			mapping_[i] = -1;
+		for (int i = 0; i < NUM_ALLOC_REGS; ++i)
+			host_[i] = HostReg{};
+		useCounter_ = 0;
+	}
+
+	// Call after each instruction so mapped regs can be spilled again.
+	void ReleaseLocks() {
+		for (int i = 0; i < NUM_ALLOC_REGS; ++i)
+			host_[i].locked = false;
+	}
+
+	RiscVReg MapIn(int mreg) {
+		// The zero register is always zero, no need to waste a host reg on it.
+		if (mreg == MIPS_REG_ZERO)
+			return R_ZERO;
+		return Map(mreg, true, false);
+	}
+	RiscVReg MapOut(int mreg) {
+		return Map(mreg, false, true);
+	}
+	RiscVReg MapInOut(int mreg) {
+		return Map(mreg, true, true);
+	}
+
+	// Writes back dirty regs, but keeps them mapped.  Used before (conditional) exits.
+	void FlushDirty() {
+		for (int i = 0; i < NUM_ALLOC_REGS; ++i) {
+			if (host_[i].mreg != -1 && host_[i].dirty) {
+				emit_->SW(allocOrder[i], CTXREG, GPROffset(host_[i].mreg));
+				host_[i].dirty = false;
+			}
+		}
+	}
+
+	// Writes back and forgets everything.  Used before calls that may read or write any reg.
+	void FlushAndDiscard() {
+		FlushDirty();
+		for (int i = 0; i < NUM_ALLOC_REGS; ++i) {
+			if (host_[i].mreg != -1)
+				mapping_[host_[i].mreg] = -1;
+			host_[i] = HostReg{};
+		}
+	}
+
+private:
+	struct HostReg {
+		int mreg = -1;
+		bool dirty = false;
+		bool locked = false;
+		u32 lastUse = 0;
+	};
+
+	RiscVReg Map(int mreg, bool load, bool dirty) {
+		int index = mapping_[mreg];
+		if (index == -1) {
+			index = AllocHostReg();
+			if (load)
+				emit_->LW(allocOrder[index], CTXREG, GPROffset(mreg));
+			host_[index].mreg = mreg;
+			mapping_[mreg] = index;
+		}
+
+		HostReg &h = host_[index];
+		// Writes to the zero register are ignored, it always reads back as zero.
+		if (dirty && mreg != MIPS_REG_ZERO)
+			h.dirty = true;
+		h.locked = true;
+		h.lastUse = ++useCounter_;
+		return allocOrder[index];
+	}
+
+	int AllocHostReg() {
+		int best = -1;
+		for (int i = 0; i < NUM_ALLOC_REGS; ++i) {
+			if (host_[i].mreg == -1)
+				return i;
+			if (!host_[i].locked && (best == -1 || host_[i].lastUse < host_[best].lastUse))
+				best = i;
+		}
+
+		_assert_msg_(best != -1, "IRRV64RegCache: All regs locked");
+		HostReg &h = host_[best];
+		if (h.dirty)
+			emit_->SW(allocOrder[best], CTXREG, GPROffset(h.mreg));
+		mapping_[h.mreg] = -1;
+		h = HostReg{};
+		return best;
+	}
+
+	RiscVEmitter *emit_ = nullptr;
+	s8 mapping_[IR_NUM_REGS];
+	HostReg host_[NUM_ALLOC_REGS];
+	u32 useCounter_ = 0;
+};
+
+static IRRV64RegCache gpr;
+
+IRToRiscV::IRToRiscV() {
+	AllocCodeSpace(1024 * 1024 * 16);
+	GenerateFixedCode();
+}
+
+void IRToRiscV::GenerateFixedCode() {
+	BeginWrite(GetMemoryProtectPageSize());
+	AlignCodePage();
+
+	// Blocks jump here with the next PC in X10.
+	exit_ = AlignCode16();
+	for (int i = 0; i < (int)ARRAY_SIZE(savedRegs); ++i)
+		LD(savedRegs[i], R_SP, i * 8);
+	ADDI(R_SP, R_SP, SAVED_STACK_SIZE);
+	// The ABI wants 32-bit return values sign extended.
+	ADDIW(X10, EXITPCREG, 0);
+	RET();
+
+	enter_ = (EnterFunc)AlignCode16();
+	ADDI(R_SP, R_SP, -SAVED_STACK_SIZE);
+	for (int i = 0; i < (int)ARRAY_SIZE(savedRegs); ++i)
+		SD(savedRegs[i], R_SP, i * 8);
+	MV(CTXREG, X10);
+	// Memory::base is fixed while the jit exists, but let's not bake it in.
+	LI(SCRATCH1, &Memory::base);
+	LD(MEMBASEREG, SCRATCH1, 0);
+	JR(X11);
+
+	// Used by the memory exception handler, the stack is still as set up by enter_.
+	crashHandler_ = AlignCode16();
+	LI(SCRATCH1, (const void *)&coreState);
+	LI(SCRATCH2, (s32)CORE_RUNTIME_ERROR);
+	SW(SCRATCH2, SCRATCH1, 0);
+	LI(SCRATCH1, (const void *)&CoreTiming::ForceCheck);
+	JALR(R_RA, SCRATCH1, 0);
+	LW(EXITPCREG, CTXREG, (s32)offsetof(MIPSState, pc));
+	J(exit_);
+
+	endOfFixedCode_ = AlignCodePage();
+	FlushIcache();
+	EndWrite();
+}
+
+void IRToRiscV::ClearCode() {
+	// New code is flushed from the icache as it's written, so no need to flush here.
+	ClearCodeSpace((int)GetOffset(endOfFixedCode_));
+}
+
+u32 IRToRiscV::RunBlock(MIPSState *mips, const u8 *entry) {
+	return enter_(mips, entry);
+}
+
+const u8 *IRToRiscV::ConvertIRToNative(const IRInst *instructions, int count, int *nativeSize) {
+	// Worst case is a fallback call per op, which is around 60 bytes with the 64-bit constants.
+	const size_t estimate = 96 * (size_t)count + 64;
+	if (GetSpaceLeft() < estimate + 0x1000)
+		return nullptr;
+
+	BeginWrite(estimate);
+	const u8 *start = AlignCode16();
+	gpr.Start(this);
+
+	for (int i = 0; i < count; i++) {
+		CompileInstruction(instructions[i]);
+		gpr.ReleaseLocks();
+	}
+
+	// A well formed block always exits.  Blocks that don't would have crashed the interpreter too.
+	EBREAK();
+
+	FlushIcache();
+	EndWrite();
+	*nativeSize = (int)(GetCodePointer() - start);
+	return start;
+}
+
+void IRToRiscV::JumpToExit() {
+	if (JInRange(exit_)) {
+		J(exit_);
+		return;
+	}
+
+	// The code space is much smaller than the +/-2GB AUIPC reaches.
+	s32 offset = (s32)(exit_ - GetCodePointer());
+	s32 lo = (s32)((u32)offset << 20) >> 20;
+	AUIPC(SCRATCH1, offset - lo);
+	JALR(R_ZERO, SCRATCH1, lo);
+}
+
+void IRToRiscV::CompileInstruction(const IRInst &inst) {
+	switch (inst.op) {
+	case IROp::Nop:
+	// The IR interpreter ignores these, so the native code ignores them too.
+	case IROp::ApplyRoundingMode:
+	case IROp::RestoreRoundingMode:
+	case IROp::UpdateRoundingMode:
+		break;
+
+	case IROp::SetConst:
+		LI(gpr.MapOut(inst.dest), (s32)inst.constant);
+		break;
+
+	case IROp::Mov:
+		if (inst.dest != inst.src1) {
+			RiscVReg a = gpr.MapIn(inst.src1);
+			RiscVReg d = gpr.MapOut(inst.dest);
+			MV(d, a);
+		}
+		break;
+
+	case IROp::Add:
+	case IROp::Sub:
+	case IROp::And:
+	case IROp::Or:
+	case IROp::Xor:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		RiscVReg b = gpr.MapIn(inst.src2);
+		RiscVReg d = gpr.MapOut(inst.dest);
+		// Logical ops of sign extended values stay sign extended, add/sub need the W forms.
+		switch (inst.op) {
+		case IROp::Add: ADDW(d, a, b); break;
+		case IROp::Sub: SUBW(d, a, b); break;
+		case IROp::And: AND(d, a, b); break;
+		case IROp::Or: OR(d, a, b); break;
+		case IROp::Xor: XOR(d, a, b); break;
+		default: break;
+		}
+		break;
+	}
+
+	case IROp::AddConst:
+	case IROp::SubConst:
+	case IROp::AndConst:
+	case IROp::OrConst:
+	case IROp::XorConst:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		RiscVReg d = gpr.MapOut(inst.dest);
+		s32 imm = (s32)inst.constant;
+		if (inst.op == IROp::SubConst && imm != INT32_MIN) {
+			imm = -imm;
+		} else if (inst.op == IROp::SubConst) {
+			LI(SCRATCH1, imm);
+			SUBW(d, a, SCRATCH1);
+			break;
+		}
+
+		if (FitsSImm12(imm)) {
+			switch (inst.op) {
+			case IROp::AddConst:
+			case IROp::SubConst: ADDIW(d, a, imm); break;
+			case IROp::AndConst: ANDI(d, a, imm); break;
+			case IROp::OrConst: ORI(d, a, imm); break;
+			case IROp::XorConst: XORI(d, a, imm); break;
+			default: break;
+			}
+			break;
+		}
+
+		LI(SCRATCH1, imm);
+		switch (inst.op) {
+		case IROp::AddConst:
+		case IROp::SubConst: ADDW(d, a, SCRATCH1); break;
+		case IROp::AndConst: AND(d, a, SCRATCH1); break;
+		case IROp::OrConst: OR(d, a, SCRATCH1); break;
+		case IROp::XorConst: XOR(d, a, SCRATCH1); break;
+		default: break;
+		}
+		break;
+	}
+
+	case IROp::Neg:
+	case IROp::Not:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		RiscVReg d = gpr.MapOut(inst.dest);
+		if (inst.op == IROp::Neg)
+			NEGW(d, a);
+		else
+			NOT(d, a);
+		break;
+	}
+
+	case IROp::Ext8to32:
+	case IROp::Ext16to32:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		RiscVReg d = gpr.MapOut(inst.dest);
+		int shift = inst.op == IROp::Ext8to32 ? 56 : 48;
+		SLLI(d, a, shift);
+		SRAI(d, d, shift);
+		break;
+	}
+
+	case IROp::Shl:
+	case IROp::Shr:
+	case IROp::Sar:
+	case IROp::Ror:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		RiscVReg b = gpr.MapIn(inst.src2);
+		RiscVReg d = gpr.MapOut(inst.dest);
+		// The W shifts only use the low 5 bits, just like the interpreter masks explicitly.
+		switch (inst.op) {
+		case IROp::Shl: SLLW(d, a, b); break;
+		case IROp::Shr: SRLW(d, a, b); break;
+		case IROp::Sar: SRAW(d, a, b); break;
+		case IROp::Ror:
+			// (a >> b) | (a << (-b & 31)), which is still correct for b == 0.
+			SRLW(SCRATCH1, a, b);
+			NEGW(SCRATCH2, b);
+			SLLW(SCRATCH2, a, SCRATCH2);
+			OR(d, SCRATCH1, SCRATCH2);
+			break;
+		default: break;
+		}
+		break;
+	}
+
+	case IROp::ShlImm:
+	case IROp::ShrImm:
+	case IROp::SarImm:
+	case IROp::RorImm:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		RiscVReg d = gpr.MapOut(inst.dest);
+		int sa = inst.src2 & 31;
+		switch (inst.op) {
+		case IROp::ShlImm: SLLIW(d, a, sa); break;
+		case IROp::ShrImm: SRLIW(d, a, sa); break;
+		case IROp::SarImm: SRAIW(d, a, sa); break;
+		case IROp::RorImm:
+			if (sa == 0) {
+				MV(d, a);
+				break;
+			}
+			SRLIW(SCRATCH1, a, sa);
+			SLLIW(SCRATCH2, a, 32 - sa);
+			OR(d, SCRATCH1, SCRATCH2);
+			break;
+		default: break;
+		}
+		break;
+	}
+
+	case IROp::Slt:
+	case IROp::SltU:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		RiscVReg b = gpr.MapIn(inst.src2);
+		RiscVReg d = gpr.MapOut(inst.dest);
+		// Sign extension keeps the unsigned order of 32-bit values, so SLTU just works.
+		if (inst.op == IROp::Slt)
+			SLT(d, a, b);
+		else
+			SLTU(d, a, b);
+		break;
+	}
+
+	case IROp::SltConst:
+	case IROp::SltUConst:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		RiscVReg d = gpr.MapOut(inst.dest);
+		s32 imm = (s32)inst.constant;
+		if (FitsSImm12(imm)) {
+			if (inst.op == IROp::SltConst)
+				SLTI(d, a, imm);
+			else
+				SLTIU(d, a, imm);
+		} else {
+			LI(SCRATCH1, imm);
+			if (inst.op == IROp::SltConst)
+				SLT(d, a, SCRATCH1);
+			else
+				SLTU(d, a, SCRATCH1);
+		}
+		break;
+	}
+
+	case IROp::MovZ:
+	case IROp::MovNZ:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		RiscVReg b = gpr.MapIn(inst.src2);
+		RiscVReg d = gpr.MapInOut(inst.dest);
+		FixupBranch skip = inst.op == IROp::MovZ ? BNE(a, R_ZERO) : BEQ(a, R_ZERO);
+		MV(d, b);
+		SetJumpTarget(skip);
+		break;
+	}
+
+	case IROp::Max:
+	case IROp::Min:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		RiscVReg b = gpr.MapIn(inst.src2);
+		RiscVReg d = gpr.MapOut(inst.dest);
+		MV(SCRATCH1, a);
+		FixupBranch keepA = inst.op == IROp::Max ? BGE(a, b) : BGE(b, a);
+		MV(SCRATCH1, b);
+		SetJumpTarget(keepA);
+		MV(d, SCRATCH1);
+		break;
+	}
+
+	// These are all just moves in our register numbering.
+	case IROp::MtLo:
+	case IROp::MtHi:
+	case IROp::MfLo:
+	case IROp::MfHi:
+	case IROp::FpCondToReg:
+	case IROp::VfpuCtrlToReg:
+	case IROp::SetCtrlVFPUReg:
+	{
+		int src = inst.src1;
+		int dest = inst.dest;
+		switch (inst.op) {
+		case IROp::MtLo: dest = IRREG_LO; break;
+		case IROp::MtHi: dest = IRREG_HI; break;
+		case IROp::MfLo: src = IRREG_LO; break;
+		case IROp::MfHi: src = IRREG_HI; break;
+		case IROp::FpCondToReg: src = IRREG_FPCOND; break;
+		case IROp::VfpuCtrlToReg: src = IRREG_VFPU_CTRL_BASE + inst.src1; break;
+		case IROp::SetCtrlVFPUReg: dest = IRREG_VFPU_CTRL_BASE + inst.dest; break;
+		default: break;
+		}
+		RiscVReg a = gpr.MapIn(src);
+		RiscVReg d = gpr.MapOut(dest);
+		if (d != a)
+			MV(d, a);
+		break;
+	}
+
+	case IROp::ZeroFpCond:
+		MV(gpr.MapOut(IRREG_FPCOND), R_ZERO);
+		break;
+
+	case IROp::SetCtrlVFPU:
+		LI(gpr.MapOut(IRREG_VFPU_CTRL_BASE + inst.dest), (s32)inst.constant);
+		break;
+
+	case IROp::SetCtrlVFPUFReg:
+		LW(gpr.MapOut(IRREG_VFPU_CTRL_BASE + inst.dest), CTXREG, FPROffset(inst.src1));
+		break;
+
+	case IROp::FMovFromGPR:
+		SW(gpr.MapIn(inst.src1), CTXREG, FPROffset(inst.dest));
+		break;
+
+	case IROp::FMovToGPR:
+		LW(gpr.MapOut(inst.dest), CTXREG, FPROffset(inst.src1));
+		break;
+
+	case IROp::Mult:
+	case IROp::MultU:
+	case IROp::Madd:
+	case IROp::MaddU:
+	case IROp::Msub:
+	case IROp::MsubU:
+		CompileMultiply(inst);
+		break;
+
+	case IROp::Load8:
+	case IROp::Load8Ext:
+	case IROp::Load16:
+	case IROp::Load16Ext:
+	case IROp::Load32:
+	case IROp::LoadFloat:
+	case IROp::LoadVec4:
+	case IROp::Store8:
+	case IROp::Store16:
+	case IROp::Store32:
+	case IROp::StoreFloat:
+	case IROp::StoreVec4:
+		CompileLoadStore(inst);
+		break;
+
+	case IROp::SetConstF:
+	case IROp::FAdd:
+	case IROp::FSub:
+	case IROp::FMul:
+	case IROp::FDiv:
+	case IROp::FMin:
+	case IROp::FMax:
+	case IROp::FMov:
+	case IROp::FAbs:
+	case IROp::FNeg:
+	case IROp::FSqrt:
+		CompileFPU(inst);
+		break;
+
+	case IROp::Vec4Init:
+	case IROp::Vec4Shuffle:
+	case IROp::Vec4Mov:
+	case IROp::Vec4Add:
+	case IROp::Vec4Sub:
+	case IROp::Vec4Mul:
+	case IROp::Vec4Div:
+	case IROp::Vec4Scale:
+	case IROp::Vec4Dot:
+	case IROp::Vec4Neg:
+	case IROp::Vec4Abs:
+	case IROp::Vec4ClampToZero:
+		CompileVec4(inst);
+		break;
+
+	case IROp::Downcount:
+		LW(SCRATCH1, CTXREG, (s32)offsetof(MIPSState, downcount));
+		if (FitsSImm12(-(s32)inst.constant)) {
+			ADDIW(SCRATCH1, SCRATCH1, -(s32)inst.constant);
+		} else {
+			LI(SCRATCH2, (s32)inst.constant);
+			SUBW(SCRATCH1, SCRATCH1, SCRATCH2);
+		}
+		SW(SCRATCH1, CTXREG, (s32)offsetof(MIPSState, downcount));
+		break;
+
+	case IROp::SetPC:
+		SW(gpr.MapIn(inst.src1), CTXREG, (s32)offsetof(MIPSState, pc));
+		break;
+
+	case IROp::SetPCConst:
+		LI(SCRATCH1, (s32)inst.constant);
+		SW(SCRATCH1, CTXREG, (s32)offsetof(MIPSState, pc));
+		break;
+
+	case IROp::ExitToConst:
+	case IROp::ExitToReg:
+	case IROp::ExitToPC:
+	case IROp::ExitToConstIfEq:
+	case IROp::ExitToConstIfNeq:
+	case IROp::ExitToConstIfGtZ:
+	case IROp::ExitToConstIfGeZ:
+	case IROp::ExitToConstIfLtZ:
+	case IROp::ExitToConstIfLeZ:
+	case IROp::ExitToConstIfFpTrue:
+	case IROp::ExitToConstIfFpFalse:
+		CompileExit(inst);
+		break;
+
+	default:
+		CompileFallback(inst);
+		break;
+	}
+}
+
+void IRToRiscV::CompileFallback(const IRInst &inst) {
+	// The interpreter reads and writes MIPSState directly, and we don't know which regs.
+	gpr.FlushAndDiscard();
+
+	u64 instBits;
+	memcpy(&instBits, &inst, sizeof(instBits));
+	MV(X10, CTXREG);
+	LI(X11, instBits, SCRATCH2);
+	LI(SCRATCH1, (const void *)&IRRV64InterpretFallback);
+	JALR(R_RA, SCRATCH1, 0);
+
+	// Nothing is mapped anymore, so we can exit directly with the PC in X10.
+	FixupBranch skip = BEQ(X10, R_ZERO);
+	JumpToExit();
+	SetJumpTarget(skip);
+}
+
+void IRToRiscV::CompileExit(const IRInst &inst) {
+	switch (inst.op) {
+	case IROp::ExitToConst:
+		gpr.FlushDirty();
+		LI(EXITPCREG, (s32)inst.constant);
+		JumpToExit();
+		return;
+
+	case IROp::ExitToReg:
+		MV(EXITPCREG, gpr.MapIn(inst.src1));
+		gpr.FlushDirty();
+		JumpToExit();
+		return;
+
+	case IROp::ExitToPC:
+		gpr.FlushDirty();
+		LW(EXITPCREG, CTXREG, (s32)offsetof(MIPSState, pc));
+		JumpToExit();
+		return;
+
+	default:
+		break;
+	}
+
+	// Conditional exits: write back, but keep everything mapped for the fallthrough path.
+	FixupBranch skip;
+	switch (inst.op) {
+	case IROp::ExitToConstIfEq:
+	case IROp::ExitToConstIfNeq:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		RiscVReg b = gpr.MapIn(inst.src2);
+		gpr.FlushDirty();
+		skip = inst.op == IROp::ExitToConstIfEq ? BNE(a, b) : BEQ(a, b);
+		break;
+	}
+
+	case IROp::ExitToConstIfGtZ:
+	case IROp::ExitToConstIfGeZ:
+	case IROp::ExitToConstIfLtZ:
+	case IROp::ExitToConstIfLeZ:
+	{
+		RiscVReg a = gpr.MapIn(inst.src1);
+		gpr.FlushDirty();
+		switch (inst.op) {
+		case IROp::ExitToConstIfGtZ: skip = BGE(R_ZERO, a); break;
+		case IROp::ExitToConstIfGeZ: skip = BLT(a, R_ZERO); break;
+		case IROp::ExitToConstIfLtZ: skip = BGE(a, R_ZERO); break;
+		case IROp::ExitToConstIfLeZ: skip = BLT(R_ZERO, a); break;
+		default: break;
+		}
+		break;
+	}
+
+	case IROp::ExitToConstIfFpTrue:
+	case IROp::ExitToConstIfFpFalse:
+	{
+		RiscVReg a = gpr.MapIn(IRREG_FPCOND);
+		gpr.FlushDirty();
+		skip = inst.op == IROp::ExitToConstIfFpTrue ? BEQ(a, R_ZERO) : BNE(a, R_ZERO);
+		break;
+	}
+
+	default:
+		_assert_msg_(false, "Unexpected exit op");
+		return;
+	}
+
+	LI(EXITPCREG, (s32)inst.constant);
+	JumpToExit();
+	SetJumpTarget(skip);
+}
+
+void IRToRiscV::CompileLoadStore(const IRInst &inst) {
+	// Compute the 32-bit address into SCRATCH1, zero extended for the 64-bit address below.
+	s32 imm = (s32)inst.constant;
+	if (inst.src1 == MIPS_REG_ZERO) {
+		LI(SCRATCH1, (u32)inst.constant);
+	} else {
+		RiscVReg a = gpr.MapIn(inst.src1);
+		if (FitsSImm12(imm)) {
+			ADDI(SCRATCH1, a, imm);
+		} else {
+			LI(SCRATCH1, imm);
+			ADD(SCRATCH1, a, SCRATCH1);
+		}
+		SLLI(SCRATCH1, SCRATCH1, 32);
+		SRLI(SCRATCH1, SCRATCH1, 32);
+	}
+#ifdef MASKED_PSP_MEMORY
+	LI(SCRATCH2, Memory::MEMVIEW32_MASK);
+	AND(SCRATCH1, SCRATCH1, SCRATCH2);
+#endif
+	ADD(SCRATCH1, SCRATCH1, MEMBASEREG);
+
+	switch (inst.op) {
+	case IROp::Load8:
+		LBU(gpr.MapOut(inst.dest), SCRATCH1, 0);
+		break;
+	case IROp::Load8Ext:
+		LB(gpr.MapOut(inst.dest), SCRATCH1, 0);
+		break;
+	case IROp::Load16:
+		LHU(gpr.MapOut(inst.dest), SCRATCH1, 0);
+		break;
+	case IROp::Load16Ext:
+		LH(gpr.MapOut(inst.dest), SCRATCH1, 0);
+		break;
+	case IROp::Load32:
+		LW(gpr.MapOut(inst.dest), SCRATCH1, 0);
+		break;
+	case IROp::LoadFloat:
+		LW(SCRATCH2, SCRATCH1, 0);
+		SW(SCRATCH2, CTXREG, FPROffset(inst.dest));
+		break;
+	case IROp::LoadVec4:
+		for (int i = 0; i < 4; ++i) {
+			LW(SCRATCH2, SCRATCH1, i * 4);
+			SW(SCRATCH2, CTXREG, FPROffset(inst.dest + i));
+		}
+		break;
+
+	case IROp::Store8:
+		SB(gpr.MapIn(inst.src3), SCRATCH1, 0);
+		break;
+	case IROp::Store16:
+		SH(gpr.MapIn(inst.src3), SCRATCH1, 0);
+		break;
+	case IROp::Store32:
+		SW(gpr.MapIn(inst.src3), SCRATCH1, 0);
+		break;
+	case IROp::StoreFloat:
+		LW(SCRATCH2, CTXREG, FPROffset(inst.src3));
+		SW(SCRATCH2, SCRATCH1, 0);
+		break;
+	case IROp::StoreVec4:
+		for (int i = 0; i < 4; ++i) {
+			LW(SCRATCH2, CTXREG, FPROffset(inst.src3 + i));
+			SW(SCRATCH2, SCRATCH1, i * 4);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void IRToRiscV::CompileFPU(const IRInst &inst) {
+	switch (inst.op) {
+	case IROp::SetConstF:
+		LI(SCRATCH1, (s32)inst.constant);
+		SW(SCRATCH1, CTXREG, FPROffset(inst.dest));
+		break;
+
+	case IROp::FAdd:
+	case IROp::FSub:
+	case IROp::FMul:
+	case IROp::FDiv:
+		// RISC-V always produces the default positive NAN for inf * 0, like the PSP.
+		FL(32, F0, CTXREG, FPROffset(inst.src1));
+		FL(32, F1, CTXREG, FPROffset(inst.src2));
+		switch (inst.op) {
+		case IROp::FAdd: FADD(32, F0, F0, F1); break;
+		case IROp::FSub: FSUB(32, F0, F0, F1); break;
+		case IROp::FMul: FMUL(32, F0, F0, F1); break;
+		case IROp::FDiv: FDIV(32, F0, F0, F1); break;
+		default: break;
+		}
+		FS(32, F0, CTXREG, FPROffset(inst.dest));
+		break;
+
+	case IROp::FMin:
+	case IROp::FMax:
+	{
+		// std::min(a, b) is b < a ? b : a and std::max(a, b) is a < b ? b : a.
+		// FMIN/FMAX differ for NAN and zeros, so compare and pick the raw bits.
+		FL(32, F0, CTXREG, FPROffset(inst.src1));
+		FL(32, F1, CTXREG, FPROffset(inst.src2));
+		LW(SCRATCH2, CTXREG, FPROffset(inst.src1));
+		if (inst.op == IROp::FMin)
+			FLT(32, SCRATCH1, F1, F0);
+		else
+			FLT(32, SCRATCH1, F0, F1);
+		FixupBranch keepA = BEQ(SCRATCH1, R_ZERO);
+		LW(SCRATCH2, CTXREG, FPROffset(inst.src2));
+		SetJumpTarget(keepA);
+		SW(SCRATCH2, CTXREG, FPROffset(inst.dest));
+		break;
+	}
+
+	case IROp::FSqrt:
+		FL(32, F0, CTXREG, FPROffset(inst.src1));
+		FSQRT(32, F0, F0);
+		FS(32, F0, CTXREG, FPROffset(inst.dest));
+		break;
+
+	case IROp::FMov:
+	case IROp::FAbs:
+	case IROp::FNeg:
+		if (inst.op == IROp::FMov && inst.dest == inst.src1)
+			break;
+		// Sign injection never changes NAN payloads, so these are exact bit operations.
+		FL(32, F0, CTXREG, FPROffset(inst.src1));
+		if (inst.op == IROp::FAbs)
+			FABS(32, F0, F0);
+		else if (inst.op == IROp::FNeg)
+			FNEG(32, F0, F0);
+		FS(32, F0, CTXREG, FPROffset(inst.dest));
+		break;
+
+	default:
+		break;
+	}
+}
+
+void IRToRiscV::CompileVec4(const IRInst &inst) {
+	static const RiscVReg lanes[4] = { F0, F1, F2, F3 };
+
+	switch (inst.op) {
+	case IROp::Vec4Init:
+		for (int i = 0; i < 4; ++i) {
+			u32 bits;
+			memcpy(&bits, &vec4InitValues[inst.src1][i], sizeof(bits));
+			if (bits == 0) {
+				SW(R_ZERO, CTXREG, FPROffset(inst.dest + i));
+			} else {
+				LI(SCRATCH1, (s32)bits);
+				SW(SCRATCH1, CTXREG, FPROffset(inst.dest + i));
+			}
+		}
+		break;
+
+	case IROp::Vec4Shuffle:
+	case IROp::Vec4Mov:
+		// Load everything first, since the source and dest may be the same.
+		for (int i = 0; i < 4; ++i)
+			FL(32, lanes[i], CTXREG, FPROffset(inst.src1 + i));
+		for (int i = 0; i < 4; ++i) {
+			int lane = inst.op == IROp::Vec4Shuffle ? (inst.src2 >> (i * 2)) & 3 : i;
+			FS(32, lanes[lane], CTXREG, FPROffset(inst.dest + i));
+		}
+		break;
+
+	case IROp::Vec4Add:
+	case IROp::Vec4Sub:
+	case IROp::Vec4Mul:
+	case IROp::Vec4Div:
+		for (int i = 0; i < 4; ++i) {
+			FL(32, F0, CTXREG, FPROffset(inst.src1 + i));
+			FL(32, F1, CTXREG, FPROffset(inst.src2 + i));
+			switch (inst.op) {
+			case IROp::Vec4Add: FADD(32, F0, F0, F1); break;
+			case IROp::Vec4Sub: FSUB(32, F0, F0, F1); break;
+			case IROp::Vec4Mul: FMUL(32, F0, F0, F1); break;
+			case IROp::Vec4Div: FDIV(32, F0, F0, F1); break;
+			default: break;
+			}
+			FS(32, F0, CTXREG, FPROffset(inst.dest + i));
+		}
+		break;
+
+	case IROp::Vec4Scale:
+		// The scalar might be part of the dest, so grab it first.
+		FL(32, F4, CTXREG, FPROffset(inst.src2));
+		for (int i = 0; i < 4; ++i) {
+			FL(32, F0, CTXREG, FPROffset(inst.src1 + i));
+			FMUL(32, F0, F0, F4);
+			FS(32, F0, CTXREG, FPROffset(inst.dest + i));
+		}
+		break;
+
+	case IROp::Vec4Dot:
+		// Add in the same order as the interpreter, for identical rounding.  No FMADD for the same reason.
+		FL(32, F0, CTXREG, FPROffset(inst.src1));
+		FL(32, F1, CTXREG, FPROffset(inst.src2));
+		FMUL(32, F4, F0, F1);
+		for (int i = 1; i < 4; ++i) {
+			FL(32, F0, CTXREG, FPROffset(inst.src1 + i));
+			FL(32, F1, CTXREG, FPROffset(inst.src2 + i));
+			FMUL(32, F0, F0, F1);
+			FADD(32, F4, F4, F0);
+		}
+		FS(32, F4, CTXREG, FPROffset(inst.dest));
+		break;
+
+	case IROp::Vec4Neg:
+	case IROp::Vec4Abs:
+		for (int i = 0; i < 4; ++i) {
+			FL(32, F0, CTXREG, FPROffset(inst.src1 + i));
+			if (inst.op == IROp::Vec4Neg)
+				FNEG(32, F0, F0);
+			else
+				FABS(32, F0, F0);
+			FS(32, F0, CTXREG, FPROffset(inst.dest + i));
+		}
+		break;
+
+	case IROp::Vec4ClampToZero:
+		// Expand the sign bit, and use it as a mask to zero negative values.
+		for (int i = 0; i < 4; ++i) {
+			LW(SCRATCH1, CTXREG, FPROffset(inst.src1 + i));
+			SRAIW(SCRATCH2, SCRATCH1, 31);
+			NOT(SCRATCH2, SCRATCH2);
+			AND(SCRATCH1, SCRATCH1, SCRATCH2);
+			SW(SCRATCH1, CTXREG, FPROffset(inst.dest + i));
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void IRToRiscV::CompileMultiply(const IRInst &inst) {
+	RiscVReg a = gpr.MapIn(inst.src1);
+	RiscVReg b = gpr.MapIn(inst.src2);
+	bool accumulate = inst.op != IROp::Mult && inst.op != IROp::MultU;
+	RiscVReg lo = accumulate ? gpr.MapInOut(IRREG_LO) : gpr.MapOut(IRREG_LO);
+	RiscVReg hi = accumulate ? gpr.MapInOut(IRREG_HI) : gpr.MapOut(IRREG_HI);
+
+	// Compute the full 64-bit product into SCRATCH1.  Inputs are already sign extended.
+	bool isSigned = inst.op == IROp::Mult || inst.op == IROp::Madd || inst.op == IROp::Msub;
+	if (isSigned) {
+		MUL(SCRATCH1, a, b);
+	} else {
+		SLLI(SCRATCH1, a, 32);
+		SRLI(SCRATCH1, SCRATCH1, 32);
+		SLLI(SCRATCH2, b, 32);
+		SRLI(SCRATCH2, SCRATCH2, 32);
+		MUL(SCRATCH1, SCRATCH1, SCRATCH2);
+	}
+
+	if (accumulate) {
+		SLLI(SCRATCH2, hi, 32);
+		SLLI(SCRATCH3, lo, 32);
+		SRLI(SCRATCH3, SCRATCH3, 32);
+		OR(SCRATCH2, SCRATCH2, SCRATCH3);
+		// The low 64 bits are the same for signed and unsigned.
+		if (inst.op == IROp::Madd || inst.op == IROp::MaddU)
+			ADD(SCRATCH1, SCRATCH2, SCRATCH1);
+		else
+			SUB(SCRATCH1, SCRATCH2, SCRATCH1);
+	}
+
+	ADDIW(lo, SCRATCH1, 0);
+	SRAI(hi, SCRATCH1, 32);
+}
+
+}  // namespace MIPSComp
+
+#endif // PPSSPP_ARCH(RISCV64)
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ppsspp_config.h"
+#include "Common/RiscVEmitter.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRJit.h"
+
+namespace MIPSComp {
+
+#if PPSSPP_ARCH(RISCV64)
+
+// Converts IR blocks (after the full pass pipeline) into RISC-V 64 code.
+// Works the same way as IRToX86: blocks are entered through a shared thunk and return the next PC.
+// Ops without a native implementation are handed to the IR interpreter one at a time.
+class IRToRiscV : public IRToNativeInterface, public RiscVGen::RiscVCodeBlock {
+public:
+	IRToRiscV();
+
+	const u8 *ConvertIRToNative(const IRInst *instructions, int count, int *nativeSize) override;
+	u32 RunBlock(MIPSState *mips, const u8 *entry) override;
+	void ClearCode() override;
+	bool CodeInRange(const u8 *ptr) const override { return IsInSpace(ptr); }
+	const u8 *GetCrashHandler() const override { return crashHandler_; }
+
+private:
+	void GenerateFixedCode();
+	void CompileInstruction(const IRInst &inst);
+	void CompileFallback(const IRInst &inst);
+	void CompileExit(const IRInst &inst);
+	void CompileLoadStore(const IRInst &inst);
+	void CompileFPU(const IRInst &inst);
+	void CompileVec4(const IRInst &inst);
+	void CompileMultiply(const IRInst &inst);
+	void JumpToExit();
+
+	typedef u32 (*EnterFunc)(MIPSState *mips, const u8 *entry);
+	EnterFunc enter_ = nullptr;
+	const u8 *exit_ = nullptr;
+	const u8 *crashHandler_ = nullptr;
+	const u8 *endOfFixedCode_ = nullptr;
+};
+
+#endif
+
+}  // namespace
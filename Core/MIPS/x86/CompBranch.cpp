@@ -723,6 +723,7 @@ void Jit::Comp_JumpReg(MIPSOpcode op)
 	CONDITIONAL_NICE_DELAYSLOT;
 
 	X64Reg destReg = EAX;
+	u32 predictedTarget = js.PredictJumpRegTarget(mips_, rs);
 	if (IsSyscall(delaySlotOp))
 	{
 		// If this is a syscall, write the pc (for thread switching and other good reasons.)
@@ -792,7 +793,7 @@ void Jit::Comp_JumpReg(MIPSOpcode op)
 	}
 
 	CONDITIONAL_LOG_EXIT_EAX();
-	WriteExitDestInReg(destReg);
+	WriteExitDestInReg(destReg, predictedTarget);
 	js.compiling = false;
 }
 
@@ -842,6 +843,10 @@ void Jit::Comp_Syscall(MIPSOpcode op)
 #endif
 
 	ApplyRoundingMode();
+
+	// Pure syscalls can't change the thread or PC, so we can keep going.
+	if (!js.inDelaySlot && IsPureSyscall(op))
+		return;
 	WriteSyscallExit();
 	js.compiling = false;
 }
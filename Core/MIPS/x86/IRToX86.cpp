@@ -1,299 +1,978 @@
-#include "ppsspp_config.h"
-#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(AMD64)
+
+#include <cstddef>
+#include <cstring>
+
+#include "Common/ABI.h"
+#include "Common/Log.h"
+#include "Common/MemoryUtil.h"
+#include "Core/CoreTiming.h"
+#include "Core/MemMap.h"
+#include "Core/System.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
 #include "Core/MIPS/x86/IRToX86.h"
 
 namespace MIPSComp {
 
-// Initial attempt at converting IR directly to x86.
-// This is intended to be an easy way to benefit from the IR with the current infrastructure.
-// Later tries may go across multiple blocks and a different representation.
-
-struct GPRMapping {
-	Gen::OpArg dest;
-	Gen::OpArg src1;
-	Gen::OpArg src2;
+using namespace Gen;
+
+// Converts IR directly to x86-64, after all the IR passes have run.
+// This way the x86 backend benefits from the same optimizations as the IR interpreter.
+//
+// Register usage:
+//   RBX - base pointer of PSP memory
+//   R14 - pointer to MIPSState (not offset, unlike the old jit.)
+//   RAX, RCX, RDX - scratch.  Never allocated so that shifts/mul/div are easy.
+//   Everything else - greedily allocated GPRs, written back at exits.
+// FPRs are not cached, FP ops go through XMM0/XMM1 scratch registers directly from MIPSState.
+
+static const X64Reg CTXREG = R14;
+static const X64Reg MEMBASEREG = RBX;
+
+static const X64Reg allocOrder[] = { RBP, R12, R13, R15, RSI, RDI, R8, R9, R10, R11 };
+static const int NUM_ALLOC_REGS = (int)ARRAY_SIZE(allocOrder);
+// IR register operands are a u8, covering everything in MIPSState up to fpcond and beyond.
+static const int IR_NUM_REGS = 256;
+
+alignas(16) static const float vec4InitValues[8][4] = {
+	{ 0.0f, 0.0f, 0.0f, 0.0f },
+	{ 1.0f, 1.0f, 1.0f, 1.0f },
+	{ -1.0f, -1.0f, -1.0f, -1.0f },
+	{ 1.0f, 0.0f, 0.0f, 0.0f },
+	{ 0.0f, 1.0f, 0.0f, 0.0f },
+	{ 0.0f, 0.0f, 1.0f, 0.0f },
+	{ 0.0f, 0.0f, 0.0f, 1.0f },
 };
 
-struct FPRMapping {
-	Gen::OpArg dest;
-	Gen::OpArg src1;
-	Gen::OpArg src2;
-};
+// GPR indices are relative to r[0], so they also reach the temps, vfpuCtrl, lo, hi, etc.
+static OpArg GPRArg(int reg) {
+	return MDisp(CTXREG, (int)offsetof(MIPSState, r) + reg * 4);
+}
 
+// FPR indices are relative to f[0], and continue into v[] and the vector temps.
+static OpArg FPRArg(int reg) {
+	return MDisp(CTXREG, (int)offsetof(MIPSState, f) + reg * 4);
+}
+
+static OpArg StateArg(size_t offset) {
+	return MDisp(CTXREG, (int)offset);
+}
+
+// Used for anything not implemented natively.  Runs a single op through the IR interpreter.
+// Returns 0 to continue, or a PC to exit to (for example after a failed address validation.)
+static u32 IRX64InterpretFallback(MIPSState *mips, u64 instBits) {
+	IRInst inst[2];
+	memcpy(&inst[0], &instBits, sizeof(IRInst));
+	inst[1] = { IROp::ExitToConst, { 0 }, 0, 0, 0 };
+	return IRInterpret(mips, inst, 2);
+}
 
-class GreedyRegallocGPR {
+// Greedy per-block GPR allocator.  Values stay mapped across instructions, and are only
+// written back at exits and before falling back to the interpreter.
+class IRX64RegCache {
 public:
-	GPRMapping Map(IRInst inst, const IRMeta &meta);
+	void Start(XEmitter *emit) {
+		emit_ = emit;
+		for (int i = 0; i < IR_NUM_REGS; ++i)
+			mapping_[i] = -1;
+		for (int i = 0; i < NUM_ALLOC_REGS; ++i)
+			host_[i] = HostReg{};
+		useCounter_ = 0;
+	}
+
+	// Call after each instruction so mapped regs can be spilled again.
+	void ReleaseLocks() {
+		for (int i = 0; i < NUM_ALLOC_REGS; ++i)
+			host_[i].locked = false;
+	}
+
+	X64Reg MapIn(int mreg) {
+		return Map(mreg, true, false);
+	}
+	X64Reg MapOut(int mreg) {
+		return Map(mreg, false, true);
+	}
+	X64Reg MapInOut(int mreg) {
+		return Map(mreg, true, true);
+	}
+
+	// Writes back dirty regs, but keeps them mapped.  Used before (conditional) exits.
+	void FlushDirty() {
+		for (int i = 0; i < NUM_ALLOC_REGS; ++i) {
+			if (host_[i].mreg != -1 && host_[i].dirty) {
+				emit_->MOV(32, GPRArg(host_[i].mreg), R(allocOrder[i]));
+				host_[i].dirty = false;
+			}
+		}
+	}
+
+	// Writes back and forgets everything.  Used before calls that may read or write any reg.
+	void FlushAndDiscard() {
+		FlushDirty();
+		for (int i = 0; i < NUM_ALLOC_REGS; ++i) {
+			if (host_[i].mreg != -1)
+				mapping_[host_[i].mreg] = -1;
+			host_[i] = HostReg{};
+		}
+	}
 
 private:
-	
-};
+	struct HostReg {
+		int mreg = -1;
+		bool dirty = false;
+		bool locked = false;
+		u32 lastUse = 0;
+	};
+
+	X64Reg Map(int mreg, bool load, bool dirty) {
+		int index = mapping_[mreg];
+		if (index == -1) {
+			index = AllocHostReg();
+			if (load)
+				emit_->MOV(32, R(allocOrder[index]), GPRArg(mreg));
+			host_[index].mreg = mreg;
+			mapping_[mreg] = index;
+		}
 
+		HostReg &h = host_[index];
+		// Writes to the zero register are ignored, it always reads back as zero.
+		if (dirty && mreg != MIPS_REG_ZERO)
+			h.dirty = true;
+		h.locked = true;
+		h.lastUse = ++useCounter_;
+		return allocOrder[index];
+	}
 
-GPRMapping GreedyRegallocGPR::Map(IRInst inst, const IRMeta &meta) {
-	GPRMapping mapping;
-	if (meta.types[0] == 'G') {
+	int AllocHostReg() {
+		int best = -1;
+		for (int i = 0; i < NUM_ALLOC_REGS; ++i) {
+			if (host_[i].mreg == -1)
+				return i;
+			if (!host_[i].locked && (best == -1 || host_[i].lastUse < host_[best].lastUse))
+				best = i;
+		}
 
+		_assert_msg_(best != -1, "IRX64RegCache: All regs locked");
+		HostReg &h = host_[best];
+		if (h.dirty)
+			emit_->MOV(32, GPRArg(h.mreg), R(allocOrder[best]));
+		mapping_[h.mreg] = -1;
+		h = HostReg{};
+		return best;
 	}
-	// etc..
-	return mapping;
-}
 
-// Every 4 registers can also be mapped into an SSE register.
-// When changing from single to vec4 mapping, we'll just flush, for now.
-class GreedyRegallocFPR {
-public:
-	FPRMapping Map(IRInst inst, const IRMeta &meta);
+	XEmitter *emit_ = nullptr;
+	s8 mapping_[IR_NUM_REGS];
+	HostReg host_[NUM_ALLOC_REGS];
+	u32 useCounter_ = 0;
 };
 
-FPRMapping GreedyRegallocFPR::Map(IRInst inst, const IRMeta &meta) {
-	FPRMapping mapping;
+static IRX64RegCache gpr;
+
+IRToX86::IRToX86() {
+	AllocCodeSpace(1024 * 1024 * 16);
+	GenerateFixedCode();
+}
+
+void IRToX86::GenerateFixedCode() {
+	BeginWrite(GetMemoryProtectPageSize());
+	AlignCodePage();
+
+	enter_ = (EnterFunc)AlignCode16();
+	ABI_PushAllCalleeSavedRegsAndAdjustStack();
+	MOV(64, R(CTXREG), R(ABI_PARAM1));
+	// Memory::base is fixed while the jit exists, but let's not bake it in.
+	MOV(64, R(RAX), ImmPtr(&Memory::base));
+	MOV(64, R(MEMBASEREG), MatR(RAX));
+	JMPptr(R(ABI_PARAM2));
+
+	// Blocks jump here with the next PC in EAX.
+	exit_ = AlignCode16();
+	ABI_PopAllCalleeSavedRegsAndAdjustStack();
+	RET();
+
+	// Used by the memory exception handler, the stack is still as set up by enter_.
+	crashHandler_ = AlignCode16();
+	MOV(64, R(RAX), ImmPtr((const void *)&coreState));
+	MOV(32, MatR(RAX), Imm32(CORE_RUNTIME_ERROR));
+	ABI_CallFunction((const void *)&CoreTiming::ForceCheck);
+	MOV(32, R(EAX), StateArg(offsetof(MIPSState, pc)));
+	JMP(exit_, true);
+
+	endOfFixedCode_ = AlignCodePage();
+	EndWrite();
+}
 
-	return mapping;
+void IRToX86::ClearCode() {
+	ClearCodeSpace((int)GetOffset(endOfFixedCode_));
 }
 
+u32 IRToX86::RunBlock(MIPSState *mips, const u8 *entry) {
+	return enter_(mips, entry);
+}
 
-// This requires that ThreeOpToTwoOp has been run as the last pass.
-void IRToX86::ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) {
-	// Set up regcaches
-	using namespace Gen;
+const u8 *IRToX86::ConvertIRToNative(const IRInst *instructions, int count, int *nativeSize) {
+	// Worst case is a fallback call per op, which is around 40 bytes.
+	const size_t estimate = 64 * (size_t)count + 64;
+	if (GetSpaceLeft() < estimate + 0x1000)
+		return nullptr;
 
-	GreedyRegallocGPR gprAlloc;
-	GreedyRegallocFPR fprAlloc;
+	BeginWrite(estimate);
+	const u8 *start = AlignCode16();
+	gpr.Start(this);
 
-	// Loop through all the instructions, emitting code as we go.
-	// Note that we do need to implement them all - fallbacks are not permitted.
 	for (int i = 0; i < count; i++) {
-		const IRInst *inst = &instructions[i];
-		const IRMeta &meta = *GetIRMeta(inst->op);
-		GPRMapping gpr = gprAlloc.Map(*inst, meta);
-		FPRMapping fpr = fprAlloc.Map(*inst, meta);
-
-		bool symmetric = false;
-		switch (inst->op) {
-		case IROp::Nop:
-			_assert_(false);
-			break;
+		CompileInstruction(instructions[i]);
+		gpr.ReleaseLocks();
+	}
 
-			// Output-only
-		case IROp::SetConst:
-			code_->MOV(32, gpr.dest, Imm32(constants[inst->src1]));
-			break;
-		case IROp::SetConstF:
-			code_->MOV(32, gpr.dest, Imm32(constants[inst->src1]));
-			break;
+	// A well formed block always exits.  Blocks that don't would have crashed the interpreter too.
+	INT3();
 
-			// Add gets to be special cased because we have LEA.
-		case IROp::Add:
-			if (gpr.dest.IsSimpleReg() && gpr.src1.IsSimpleReg() && gpr.src2.IsSimpleReg()) {
-				code_->LEA(32, gpr.dest.GetSimpleReg(), MRegSum(gpr.src1.GetSimpleReg(), gpr.src2.GetSimpleReg()));
-				break;
-			}
-			// Else fall through.
-			// 3-op arithmetic that directly corresponds to x86
-			// (often 2-op in practice if src1 == dst). x86 only does 2-op though so some of these will need splitting.
-		case IROp::Sub:
-		case IROp::And:
-		case IROp::Or:
-		case IROp::Xor:
-			if (inst->src1 != inst->dest) {
-				code_->MOV(32, gpr.dest, gpr.src1);
-			}
-			// Emit directly
-			switch (inst->op) {
-			case IROp::Add: code_->ADD(32, gpr.dest, gpr.src2); break;
-			case IROp::Sub: code_->SUB(32, gpr.dest, gpr.src2); break;
-			case IROp::And: code_->AND(32, gpr.dest, gpr.src2); break;
-			case IROp::Or: code_->OR(32, gpr.dest, gpr.src2); break;
-			case IROp::Xor: code_->XOR(32, gpr.dest, gpr.src2); break;
-			}
-			break;
+	EndWrite();
+	*nativeSize = (int)(GetCodePtr() - start);
+	return start;
+}
 
-			// Variable shifts.
-		case IROp::Shl:
-		case IROp::Shr:
-		case IROp::Sar:
-		case IROp::Ror:
-
-		case IROp::Slt:
-		case IROp::SltU:
-		case IROp::MovZ:
-		case IROp::MovNZ:
-		case IROp::Max:
-		case IROp::Min:
-			break;
+void IRToX86::CompileInstruction(const IRInst &inst) {
+	switch (inst.op) {
+	case IROp::Nop:
+	// The IR interpreter ignores these, so the native code ignores them too.
+	case IROp::ApplyRoundingMode:
+	case IROp::RestoreRoundingMode:
+	case IROp::UpdateRoundingMode:
+		break;
+
+	case IROp::SetConst:
+	{
+		X64Reg d = gpr.MapOut(inst.dest);
+		if (inst.constant == 0)
+			XOR(32, R(d), R(d));
+		else
+			MOV(32, R(d), Imm32(inst.constant));
+		break;
+	}
 
-			// 2-op arithmetic with constant
-		case IROp::AddConst:
-		case IROp::SubConst:
-		case IROp::AndConst:
-		case IROp::OrConst:
-		case IROp::XorConst:
-		case IROp::SltConst:
-		case IROp::SltUConst:
-
-			// 2-op arithmetic with immediate
-		case IROp::ShlImm:
-		case IROp::ShrImm:
-		case IROp::SarImm:
-		case IROp::RorImm:
-
-			// 2-op arithmetic
-		case IROp::Mov:
-			code_->MOV(32, gpr.dest, gpr.src1);
+	case IROp::Mov:
+		if (inst.dest != inst.src1) {
+			X64Reg a = gpr.MapIn(inst.src1);
+			X64Reg d = gpr.MapOut(inst.dest);
+			MOV(32, R(d), R(a));
+		}
+		break;
+
+	case IROp::Add:
+	case IROp::Sub:
+	case IROp::And:
+	case IROp::Or:
+	case IROp::Xor:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		X64Reg b = gpr.MapIn(inst.src2);
+		X64Reg d = gpr.MapOut(inst.dest);
+		bool commutative = inst.op != IROp::Sub;
+		if (inst.op == IROp::Add && d != a && d != b) {
+			LEA(32, d, MRegSum(a, b));
 			break;
+		}
+		if (d == b && commutative) {
+			std::swap(a, b);
+		}
+		// If dest is src2 for a sub, we need a temp.
+		X64Reg target = d == b && d != a ? EAX : d;
+		if (target != a)
+			MOV(32, R(target), R(a));
+		switch (inst.op) {
+		case IROp::Add: ADD(32, R(target), R(b)); break;
+		case IROp::Sub: SUB(32, R(target), R(b)); break;
+		case IROp::And: AND(32, R(target), R(b)); break;
+		case IROp::Or: OR(32, R(target), R(b)); break;
+		case IROp::Xor: XOR(32, R(target), R(b)); break;
+		default: break;
+		}
+		if (target != d)
+			MOV(32, R(d), R(target));
+		break;
+	}
 
-		case IROp::Neg:
-		case IROp::Not:
-		case IROp::Ext8to32:
-		case IROp::Ext16to32:
-		case IROp::ReverseBits:
-		case IROp::BSwap16:
-		case IROp::BSwap32:
-		case IROp::Clz:
-			if (inst->dest != inst->src1) {
-				code_->NEG(32, gpr.dest); break;
-			}
-			break;
-				// Multiplier control
-		case IROp::MtLo:
-		case IROp::MtHi:
-		case IROp::MfLo:
-		case IROp::MfHi:
-		case IROp::Mult:
-		case IROp::MultU:
-		case IROp::Madd:
-		case IROp::MaddU:
-		case IROp::Msub:
-		case IROp::MsubU:
-		case IROp::Div:
-		case IROp::DivU:
-
-			// Memory access
-		case IROp::Load8:
-		case IROp::Load8Ext:
-		case IROp::Load16:
-		case IROp::Load16Ext:
-		case IROp::Load32:
-		case IROp::LoadFloat:
-		case IROp::Store8:
-		case IROp::Store16:
-		case IROp::Store32:
-		case IROp::StoreFloat:
-		case IROp::LoadVec4:
-		case IROp::StoreVec4:
-
-			// Output-only SIMD functions
-		case IROp::Vec4Init:
-		case IROp::Vec4Shuffle:
-
-			// 2-op SIMD functions
-		case IROp::Vec4Mov:
-			code_->MOVAPS(fpr.dest.GetSimpleReg(), fpr.src1);
+	case IROp::AddConst:
+	case IROp::SubConst:
+	case IROp::AndConst:
+	case IROp::OrConst:
+	case IROp::XorConst:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		X64Reg d = gpr.MapOut(inst.dest);
+		if (inst.op == IROp::AddConst && d != a) {
+			LEA(32, d, MDisp(a, (s32)inst.constant));
 			break;
-		case IROp::Vec4Neg:
-		case IROp::Vec4Abs:
-			break;
-		case IROp::Vec4ClampToZero:
-			code_->PXOR(XMM0, R(XMM0));
-			code_->PMAXSW(XMM0, fpr.src1);
-			code_->MOVAPD(fpr.dest, XMM0);
+		}
+		if (d != a)
+			MOV(32, R(d), R(a));
+		switch (inst.op) {
+		case IROp::AddConst: ADD(32, R(d), Imm32(inst.constant)); break;
+		case IROp::SubConst: SUB(32, R(d), Imm32(inst.constant)); break;
+		case IROp::AndConst: AND(32, R(d), Imm32(inst.constant)); break;
+		case IROp::OrConst: OR(32, R(d), Imm32(inst.constant)); break;
+		case IROp::XorConst: XOR(32, R(d), Imm32(inst.constant)); break;
+		default: break;
+		}
+		break;
+	}
+
+	case IROp::Neg:
+	case IROp::Not:
+	case IROp::BSwap32:
+	case IROp::BSwap16:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		X64Reg d = gpr.MapOut(inst.dest);
+		if (d != a)
+			MOV(32, R(d), R(a));
+		if (inst.op == IROp::Neg) {
+			NEG(32, R(d));
+		} else if (inst.op == IROp::Not) {
+			NOT(32, R(d));
+		} else {
+			BSWAP(32, d);
+			// Swapping all four and rotating swaps within each halfword.
+			if (inst.op == IROp::BSwap16)
+				ROR(32, R(d), Imm8(16));
+		}
+		break;
+	}
+
+	case IROp::Ext8to32:
+	case IROp::Ext16to32:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		X64Reg d = gpr.MapOut(inst.dest);
+		MOVSX(32, inst.op == IROp::Ext8to32 ? 8 : 16, d, R(a));
+		break;
+	}
+
+	case IROp::Shl:
+	case IROp::Shr:
+	case IROp::Sar:
+	case IROp::Ror:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		X64Reg b = gpr.MapIn(inst.src2);
+		X64Reg d = gpr.MapOut(inst.dest);
+		// x86 masks 32-bit shift counts by 31, just like the interpreter does explicitly.
+		MOV(32, R(ECX), R(b));
+		MOV(32, R(EAX), R(a));
+		switch (inst.op) {
+		case IROp::Shl: SHL(32, R(EAX), R(CL)); break;
+		case IROp::Shr: SHR(32, R(EAX), R(CL)); break;
+		case IROp::Sar: SAR(32, R(EAX), R(CL)); break;
+		case IROp::Ror: ROR(32, R(EAX), R(CL)); break;
+		default: break;
+		}
+		MOV(32, R(d), R(EAX));
+		break;
+	}
+
+	case IROp::ShlImm:
+	case IROp::ShrImm:
+	case IROp::SarImm:
+	case IROp::RorImm:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		X64Reg d = gpr.MapOut(inst.dest);
+		if (d != a)
+			MOV(32, R(d), R(a));
+		if (inst.src2 == 0)
 			break;
-		case IROp::Vec4DuplicateUpperBitsAndShift1:
-		case IROp::Vec2ClampToZero:
-
-			// 3-op SIMD functions
-		case IROp::Vec4Add:
-		case IROp::Vec4Sub:
-		case IROp::Vec4Mul:
-		case IROp::Vec4Div:
-
-		case IROp::Vec4Scale:
-		case IROp::Vec4Dot:
-
-			// Pack-unpack
-		case IROp::Vec2Unpack16To31:
-		case IROp::Vec2Unpack16To32:
-		case IROp::Vec4Unpack8To32:
-		case IROp::Vec2Pack32To16:
-		case IROp::Vec2Pack31To16:
-		case IROp::Vec4Pack32To8:
-		case IROp::Vec4Pack31To8:
-
-		case IROp::FCmpVfpuBit:
-		case IROp::FCmpVfpuAggregate:
-		case IROp::FCmovVfpuCC:
-
-			// Trancendental functions (non-simd)
-		case IROp::FSin:
-		case IROp::FCos:
-		case IROp::FRSqrt:
-		case IROp::FRecip:
-		case IROp::FAsin:
-
-			// 3-Op FP
-		case IROp::FAdd:
-		case IROp::FSub:
-		case IROp::FMul:
-		case IROp::FDiv:
-		case IROp::FMin:
-		case IROp::FMax:
-
-			// 2-Op FP
-		case IROp::FMov:
-		case IROp::FAbs:
-		case IROp::FSqrt:
-		case IROp::FNeg:
-		case IROp::FSat0_1:
-		case IROp::FSatMinus1_1:
-		case IROp::FSign:
-		case IROp::FCeil:
-		case IROp::FFloor:
-		case IROp::FCmp:
-		case IROp::FCvtSW:
-		case IROp::FCvtWS:
-		case IROp::FRound:
-		case IROp::FTrunc:
-
-			// Cross moves
-		case IROp::FMovFromGPR:
-		case IROp::FMovToGPR:
-		case IROp::FpCondToReg:
-		case IROp::VfpuCtrlToReg:
-
-			// VFPU flag/control
-		case IROp::SetCtrlVFPU:
-		case IROp::SetCtrlVFPUReg:
-		case IROp::SetCtrlVFPUFReg:
-		case IROp::ZeroFpCond:
-
-			// Block Exits
-		case IROp::ExitToConst:
-		case IROp::ExitToReg:
-		case IROp::ExitToConstIfEq:
-		case IROp::ExitToConstIfNeq:
-		case IROp::ExitToConstIfGtZ:
-		case IROp::ExitToConstIfGeZ:
-		case IROp::ExitToConstIfLtZ:
-		case IROp::ExitToConstIfLeZ:
-		case IROp::ExitToPC:
-
-			// Utilities
-		case IROp::Downcount:
-		case IROp::SetPC:
-		case IROp::SetPCConst:
-		case IROp::Syscall:
-		case IROp::Interpret:  // SLOW fallback. Can be made faster.
-		case IROp::CallReplacement:
-		case IROp::Break:
-		default:
+		switch (inst.op) {
+		case IROp::ShlImm: SHL(32, R(d), Imm8(inst.src2)); break;
+		case IROp::ShrImm: SHR(32, R(d), Imm8(inst.src2)); break;
+		case IROp::SarImm: SAR(32, R(d), Imm8(inst.src2)); break;
+		case IROp::RorImm: ROR(32, R(d), Imm8(inst.src2)); break;
+		default: break;
+		}
+		break;
+	}
+
+	case IROp::Slt:
+	case IROp::SltU:
+	case IROp::SltConst:
+	case IROp::SltUConst:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		OpArg b = Imm32(inst.constant);
+		if (inst.op == IROp::Slt || inst.op == IROp::SltU)
+			b = R(gpr.MapIn(inst.src2));
+		X64Reg d = gpr.MapOut(inst.dest);
+		bool isSigned = inst.op == IROp::Slt || inst.op == IROp::SltConst;
+		XOR(32, R(EAX), R(EAX));
+		CMP(32, R(a), b);
+		SETcc(isSigned ? CC_L : CC_B, R(AL));
+		MOV(32, R(d), R(EAX));
+		break;
+	}
+
+	case IROp::Clz:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		X64Reg d = gpr.MapOut(inst.dest);
+		// BSR leaves dest undefined for zero, so use 63 which becomes 32 after the XOR.
+		MOV(32, R(ECX), Imm32(63));
+		BSR(32, EAX, R(a));
+		CMOVcc(32, EAX, R(ECX), CC_Z);
+		XOR(32, R(EAX), Imm8(31));
+		MOV(32, R(d), R(EAX));
+		break;
+	}
+
+	case IROp::MovZ:
+	case IROp::MovNZ:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		X64Reg b = gpr.MapIn(inst.src2);
+		X64Reg d = gpr.MapInOut(inst.dest);
+		TEST(32, R(a), R(a));
+		CMOVcc(32, d, R(b), inst.op == IROp::MovZ ? CC_Z : CC_NZ);
+		break;
+	}
+
+	case IROp::Max:
+	case IROp::Min:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		X64Reg b = gpr.MapIn(inst.src2);
+		X64Reg d = gpr.MapOut(inst.dest);
+		MOV(32, R(EAX), R(a));
+		CMP(32, R(EAX), R(b));
+		CMOVcc(32, EAX, R(b), inst.op == IROp::Max ? CC_L : CC_G);
+		MOV(32, R(d), R(EAX));
+		break;
+	}
+
+	// These are all just moves in our register numbering.
+	case IROp::MtLo:
+	case IROp::MtHi:
+	case IROp::MfLo:
+	case IROp::MfHi:
+	case IROp::FpCondToReg:
+	case IROp::VfpuCtrlToReg:
+	case IROp::SetCtrlVFPUReg:
+	{
+		int src = inst.src1;
+		int dest = inst.dest;
+		switch (inst.op) {
+		case IROp::MtLo: dest = IRREG_LO; break;
+		case IROp::MtHi: dest = IRREG_HI; break;
+		case IROp::MfLo: src = IRREG_LO; break;
+		case IROp::MfHi: src = IRREG_HI; break;
+		case IROp::FpCondToReg: src = IRREG_FPCOND; break;
+		case IROp::VfpuCtrlToReg: src = IRREG_VFPU_CTRL_BASE + inst.src1; break;
+		case IROp::SetCtrlVFPUReg: dest = IRREG_VFPU_CTRL_BASE + inst.dest; break;
+		default: break;
+		}
+		X64Reg a = gpr.MapIn(src);
+		X64Reg d = gpr.MapOut(dest);
+		if (d != a)
+			MOV(32, R(d), R(a));
+		break;
+	}
+
+	case IROp::ZeroFpCond:
+	case IROp::SetCtrlVFPU:
+	{
+		X64Reg d = gpr.MapOut(inst.op == IROp::ZeroFpCond ? IRREG_FPCOND : IRREG_VFPU_CTRL_BASE + inst.dest);
+		u32 value = inst.op == IROp::ZeroFpCond ? 0 : inst.constant;
+		MOV(32, R(d), Imm32(value));
+		break;
+	}
+
+	case IROp::SetCtrlVFPUFReg:
+	{
+		X64Reg d = gpr.MapOut(IRREG_VFPU_CTRL_BASE + inst.dest);
+		MOV(32, R(d), FPRArg(inst.src1));
+		break;
+	}
+
+	case IROp::FMovFromGPR:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		MOV(32, FPRArg(inst.dest), R(a));
+		break;
+	}
+
+	case IROp::FMovToGPR:
+	{
+		X64Reg d = gpr.MapOut(inst.dest);
+		MOV(32, R(d), FPRArg(inst.src1));
+		break;
+	}
+
+	case IROp::Mult:
+	case IROp::MultU:
+	case IROp::Madd:
+	case IROp::MaddU:
+	case IROp::Msub:
+	case IROp::MsubU:
+		CompileMultiply(inst);
+		break;
+
+	case IROp::Load8:
+	case IROp::Load8Ext:
+	case IROp::Load16:
+	case IROp::Load16Ext:
+	case IROp::Load32:
+	case IROp::LoadFloat:
+	case IROp::LoadVec4:
+	case IROp::Store8:
+	case IROp::Store16:
+	case IROp::Store32:
+	case IROp::StoreFloat:
+	case IROp::StoreVec4:
+		CompileLoadStore(inst);
+		break;
+
+	case IROp::SetConstF:
+	case IROp::FAdd:
+	case IROp::FSub:
+	case IROp::FMul:
+	case IROp::FDiv:
+	case IROp::FMin:
+	case IROp::FMax:
+	case IROp::FMov:
+	case IROp::FAbs:
+	case IROp::FNeg:
+	case IROp::FSqrt:
+		CompileFPU(inst);
+		break;
+
+	case IROp::Vec4Init:
+	case IROp::Vec4Shuffle:
+	case IROp::Vec4Mov:
+	case IROp::Vec4Add:
+	case IROp::Vec4Sub:
+	case IROp::Vec4Mul:
+	case IROp::Vec4Div:
+	case IROp::Vec4Scale:
+	case IROp::Vec4Dot:
+	case IROp::Vec4Neg:
+	case IROp::Vec4Abs:
+	case IROp::Vec4ClampToZero:
+		CompileVec4(inst);
+		break;
+
+	case IROp::Downcount:
+		SUB(32, StateArg(offsetof(MIPSState, downcount)), Imm32(inst.constant));
+		break;
+
+	case IROp::SetPC:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		MOV(32, StateArg(offsetof(MIPSState, pc)), R(a));
+		break;
+	}
+
+	case IROp::SetPCConst:
+		MOV(32, StateArg(offsetof(MIPSState, pc)), Imm32(inst.constant));
+		break;
+
+	case IROp::ExitToConst:
+	case IROp::ExitToReg:
+	case IROp::ExitToPC:
+	case IROp::ExitToConstIfEq:
+	case IROp::ExitToConstIfNeq:
+	case IROp::ExitToConstIfGtZ:
+	case IROp::ExitToConstIfGeZ:
+	case IROp::ExitToConstIfLtZ:
+	case IROp::ExitToConstIfLeZ:
+	case IROp::ExitToConstIfFpTrue:
+	case IROp::ExitToConstIfFpFalse:
+		CompileExit(inst);
+		break;
+
+	default:
+		CompileFallback(inst);
+		break;
+	}
+}
+
+void IRToX86::CompileFallback(const IRInst &inst) {
+	// The interpreter reads and writes MIPSState directly, and we don't know which regs.
+	gpr.FlushAndDiscard();
+
+	u64 instBits;
+	memcpy(&instBits, &inst, sizeof(instBits));
+	MOV(64, R(ABI_PARAM1), R(CTXREG));
+	MOV(64, R(ABI_PARAM2), Imm64(instBits));
+	ABI_CallFunction((const void *)&IRX64InterpretFallback);
+
+	// Nothing is mapped anymore, so we can exit directly with the PC in EAX.
+	TEST(32, R(EAX), R(EAX));
+	FixupBranch skip = J_CC(CC_Z);
+	JMP(exit_, true);
+	SetJumpTarget(skip);
+}
+
+void IRToX86::CompileExit(const IRInst &inst) {
+	switch (inst.op) {
+	case IROp::ExitToConst:
+		gpr.FlushDirty();
+		MOV(32, R(EAX), Imm32(inst.constant));
+		JMP(exit_, true);
+		return;
+
+	case IROp::ExitToReg:
+		MOV(32, R(EAX), R(gpr.MapIn(inst.src1)));
+		gpr.FlushDirty();
+		JMP(exit_, true);
+		return;
+
+	case IROp::ExitToPC:
+		gpr.FlushDirty();
+		MOV(32, R(EAX), StateArg(offsetof(MIPSState, pc)));
+		JMP(exit_, true);
+		return;
+
+	default:
+		break;
+	}
+
+	// Conditional exits: write back, but keep everything mapped for the fallthrough path.
+	CCFlags skipCond = CC_NZ;
+	switch (inst.op) {
+	case IROp::ExitToConstIfEq:
+	case IROp::ExitToConstIfNeq:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		X64Reg b = gpr.MapIn(inst.src2);
+		gpr.FlushDirty();
+		CMP(32, R(a), R(b));
+		skipCond = inst.op == IROp::ExitToConstIfEq ? CC_NE : CC_E;
+		break;
+	}
+
+	case IROp::ExitToConstIfGtZ:
+	case IROp::ExitToConstIfGeZ:
+	case IROp::ExitToConstIfLtZ:
+	case IROp::ExitToConstIfLeZ:
+	{
+		X64Reg a = gpr.MapIn(inst.src1);
+		gpr.FlushDirty();
+		CMP(32, R(a), Imm8(0));
+		switch (inst.op) {
+		case IROp::ExitToConstIfGtZ: skipCond = CC_LE; break;
+		case IROp::ExitToConstIfGeZ: skipCond = CC_L; break;
+		case IROp::ExitToConstIfLtZ: skipCond = CC_GE; break;
+		case IROp::ExitToConstIfLeZ: skipCond = CC_G; break;
+		default: break;
+		}
+		break;
+	}
+
+	case IROp::ExitToConstIfFpTrue:
+	case IROp::ExitToConstIfFpFalse:
+	{
+		X64Reg a = gpr.MapIn(IRREG_FPCOND);
+		gpr.FlushDirty();
+		TEST(32, R(a), R(a));
+		skipCond = inst.op == IROp::ExitToConstIfFpTrue ? CC_Z : CC_NZ;
+		break;
+	}
+
+	default:
+		_assert_msg_(false, "Unexpected exit op");
+		break;
+	}
+
+	FixupBranch skip = J_CC(skipCond);
+	MOV(32, R(EAX), Imm32(inst.constant));
+	JMP(exit_, true);
+	SetJumpTarget(skip);
+}
+
+void IRToX86::CompileLoadStore(const IRInst &inst) {
+	// Compute the address into EAX, which zero extends for the 64-bit address below.
+	if (inst.src1 == MIPS_REG_ZERO) {
+		MOV(32, R(EAX), Imm32(inst.constant));
+	} else {
+		X64Reg a = gpr.MapIn(inst.src1);
+		LEA(32, EAX, MDisp(a, (s32)inst.constant));
+	}
+#ifdef MASKED_PSP_MEMORY
+	AND(32, R(EAX), Imm32(Memory::MEMVIEW32_MASK));
+#endif
+	OpArg mem = MComplex(MEMBASEREG, RAX, SCALE_1, 0);
+
+	switch (inst.op) {
+	case IROp::Load8:
+		MOVZX(32, 8, gpr.MapOut(inst.dest), mem);
+		break;
+	case IROp::Load8Ext:
+		MOVSX(32, 8, gpr.MapOut(inst.dest), mem);
+		break;
+	case IROp::Load16:
+		MOVZX(32, 16, gpr.MapOut(inst.dest), mem);
+		break;
+	case IROp::Load16Ext:
+		MOVSX(32, 16, gpr.MapOut(inst.dest), mem);
+		break;
+	case IROp::Load32:
+		MOV(32, R(gpr.MapOut(inst.dest)), mem);
+		break;
+	case IROp::LoadFloat:
+		MOV(32, R(ECX), mem);
+		MOV(32, FPRArg(inst.dest), R(ECX));
+		break;
+	case IROp::LoadVec4:
+		MOVUPS(XMM0, mem);
+		MOVAPS(FPRArg(inst.dest), XMM0);
+		break;
+
+	case IROp::Store8:
+		MOV(8, mem, R(gpr.MapIn(inst.src3)));
+		break;
+	case IROp::Store16:
+		MOV(16, mem, R(gpr.MapIn(inst.src3)));
+		break;
+	case IROp::Store32:
+		MOV(32, mem, R(gpr.MapIn(inst.src3)));
+		break;
+	case IROp::StoreFloat:
+		MOV(32, R(ECX), FPRArg(inst.src3));
+		MOV(32, mem, R(ECX));
+		break;
+	case IROp::StoreVec4:
+		MOVAPS(XMM0, FPRArg(inst.src3));
+		MOVUPS(mem, XMM0);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void IRToX86::CompileFPU(const IRInst &inst) {
+	switch (inst.op) {
+	case IROp::SetConstF:
+		MOV(32, FPRArg(inst.dest), Imm32(inst.constant));
+		break;
+
+	case IROp::FAdd:
+	case IROp::FSub:
+	case IROp::FDiv:
+		MOVSS(XMM0, FPRArg(inst.src1));
+		if (inst.op == IROp::FAdd)
+			ADDSS(XMM0, FPRArg(inst.src2));
+		else if (inst.op == IROp::FSub)
+			SUBSS(XMM0, FPRArg(inst.src2));
+		else
+			DIVSS(XMM0, FPRArg(inst.src2));
+		MOVSS(FPRArg(inst.dest), XMM0);
+		break;
+
+	case IROp::FMul:
+	{
+		MOVSS(XMM0, FPRArg(inst.src1));
+		MULSS(XMM0, FPRArg(inst.src2));
+		MOVSS(FPRArg(inst.dest), XMM0);
+		// The PSP gives a positive NAN for inf * 0, unlike x86's default NAN.
+		UCOMISS(XMM0, R(XMM0));
+		FixupBranch notNAN = J_CC(CC_NP);
+		// NAN inputs propagate the same as on the interpreter, so only fix up if neither was NAN.
+		MOVSS(XMM1, FPRArg(inst.src1));
+		UCOMISS(XMM1, FPRArg(inst.src2));
+		FixupBranch inputNAN = J_CC(CC_P);
+		MOV(32, FPRArg(inst.dest), Imm32(0x7fc00000));
+		SetJumpTarget(inputNAN);
+		SetJumpTarget(notNAN);
+		break;
+	}
+
+	case IROp::FMin:
+	case IROp::FMax:
+		// std::min(a, b) is b < a ? b : a, which is exactly MINSS with swapped operands.  Same for max.
+		MOVSS(XMM0, FPRArg(inst.src2));
+		if (inst.op == IROp::FMin)
+			MINSS(XMM0, FPRArg(inst.src1));
+		else
+			MAXSS(XMM0, FPRArg(inst.src1));
+		MOVSS(FPRArg(inst.dest), XMM0);
+		break;
+
+	case IROp::FSqrt:
+		SQRTSS(XMM0, FPRArg(inst.src1));
+		MOVSS(FPRArg(inst.dest), XMM0);
+		break;
+
+	case IROp::FMov:
+	case IROp::FAbs:
+	case IROp::FNeg:
+		if (inst.op == IROp::FMov && inst.dest == inst.src1)
 			break;
-			}
+		MOV(32, R(EAX), FPRArg(inst.src1));
+		if (inst.op == IROp::FAbs)
+			AND(32, R(EAX), Imm32(0x7FFFFFFF));
+		else if (inst.op == IROp::FNeg)
+			XOR(32, R(EAX), Imm32(0x80000000));
+		MOV(32, FPRArg(inst.dest), R(EAX));
+		break;
+
+	default:
+		break;
+	}
+}
+
+void IRToX86::CompileVec4(const IRInst &inst) {
+	switch (inst.op) {
+	case IROp::Vec4Init:
+		MOV(64, R(RAX), ImmPtr(vec4InitValues[inst.src1]));
+		MOVAPS(XMM0, MatR(RAX));
+		break;
+
+	case IROp::Vec4Shuffle:
+		// SHUFPS takes exactly the same 2 bits per lane encoding.
+		MOVAPS(XMM0, FPRArg(inst.src1));
+		SHUFPS(XMM0, R(XMM0), inst.src2);
+		break;
+
+	case IROp::Vec4Mov:
+		MOVAPS(XMM0, FPRArg(inst.src1));
+		break;
+
+	case IROp::Vec4Add:
+	case IROp::Vec4Sub:
+	case IROp::Vec4Mul:
+	case IROp::Vec4Div:
+		MOVAPS(XMM0, FPRArg(inst.src1));
+		switch (inst.op) {
+		case IROp::Vec4Add: ADDPS(XMM0, FPRArg(inst.src2)); break;
+		case IROp::Vec4Sub: SUBPS(XMM0, FPRArg(inst.src2)); break;
+		case IROp::Vec4Mul: MULPS(XMM0, FPRArg(inst.src2)); break;
+		case IROp::Vec4Div: DIVPS(XMM0, FPRArg(inst.src2)); break;
+		default: break;
+		}
+		break;
+
+	case IROp::Vec4Scale:
+		MOVSS(XMM1, FPRArg(inst.src2));
+		SHUFPS(XMM1, R(XMM1), 0);
+		MOVAPS(XMM0, FPRArg(inst.src1));
+		MULPS(XMM0, R(XMM1));
+		break;
+
+	case IROp::Vec4Dot:
+		// Add in the same order as the interpreter, for identical rounding.
+		MOVAPS(XMM0, FPRArg(inst.src1));
+		MULPS(XMM0, FPRArg(inst.src2));
+		for (int i = 1; i < 4; ++i) {
+			MOVAPS(XMM1, R(XMM0));
+			SHUFPS(XMM1, R(XMM1), (u8)(i * 0x55));
+			if (i == 1)
+				MOVAPS(XMM2, R(XMM0));
+			ADDSS(XMM2, R(XMM1));
 		}
+		MOVSS(FPRArg(inst.dest), XMM2);
+		return;
+
+	case IROp::Vec4Neg:
+	case IROp::Vec4Abs:
+		PCMPEQD(XMM1, R(XMM1));
+		if (inst.op == IROp::Vec4Neg) {
+			PSLLD(XMM1, 31);
+			MOVAPS(XMM0, FPRArg(inst.src1));
+			XORPS(XMM0, R(XMM1));
+		} else {
+			PSRLD(XMM1, 1);
+			MOVAPS(XMM0, FPRArg(inst.src1));
+			ANDPS(XMM0, R(XMM1));
+		}
+		break;
+
+	case IROp::Vec4ClampToZero:
+		// Expand the sign bit, and use andnot to zero negative values.
+		MOVAPS(XMM1, FPRArg(inst.src1));
+		MOVAPS(XMM0, R(XMM1));
+		PSRAD(XMM1, 31);
+		PANDN(XMM1, R(XMM0));
+		MOVAPS(XMM0, R(XMM1));
+		break;
+
+	default:
+		return;
+	}
+
+	MOVAPS(FPRArg(inst.dest), XMM0);
+}
+
+void IRToX86::CompileMultiply(const IRInst &inst) {
+	X64Reg a = gpr.MapIn(inst.src1);
+	X64Reg b = gpr.MapIn(inst.src2);
+	bool accumulate = inst.op != IROp::Mult && inst.op != IROp::MultU;
+	X64Reg lo = accumulate ? gpr.MapInOut(IRREG_LO) : gpr.MapOut(IRREG_LO);
+	X64Reg hi = accumulate ? gpr.MapInOut(IRREG_HI) : gpr.MapOut(IRREG_HI);
+
+	switch (inst.op) {
+	case IROp::Mult:
+	case IROp::MultU:
+		MOV(32, R(EAX), R(a));
+		if (inst.op == IROp::Mult)
+			IMUL(32, R(b));
+		else
+			MUL(32, R(b));
+		MOV(32, R(lo), R(EAX));
+		MOV(32, R(hi), R(EDX));
+		return;
+
+	case IROp::Madd:
+	case IROp::Msub:
+		MOVSX(64, 32, RAX, R(a));
+		MOVSX(64, 32, RDX, R(b));
+		break;
+
+	case IROp::MaddU:
+	case IROp::MsubU:
+		// 32-bit moves zero extend.
+		MOV(32, R(EAX), R(a));
+		MOV(32, R(EDX), R(b));
+		break;
+
+	default:
+		return;
 	}
 
+	// The low 64 bits of the product are the same for signed and unsigned.
+	IMUL(64, RAX, R(RDX));
+	MOV(32, R(EDX), R(hi));
+	SHL(64, R(RDX), Imm8(32));
+	MOV(32, R(ECX), R(lo));
+	OR(64, R(RDX), R(RCX));
+	if (inst.op == IROp::Madd || inst.op == IROp::MaddU)
+		ADD(64, R(RDX), R(RAX));
+	else
+		SUB(64, R(RDX), R(RAX));
+	MOV(32, R(lo), R(EDX));
+	SHR(64, R(RDX), Imm8(32));
+	MOV(32, R(hi), R(EDX));
+}
 
-}  // namespace
+}  // namespace MIPSComp
 
-#endif // PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#endif // PPSSPP_ARCH(AMD64)
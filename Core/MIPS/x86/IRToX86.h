@@ -1,23 +1,44 @@
-#include "Core/MIPS/IR/IRInst.h"
+#pragma once
+
+#include "ppsspp_config.h"
 #include "Common/x64Emitter.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRJit.h"
 
 namespace MIPSComp {
 
-class IRToNativeInterface {
-public:
-	virtual ~IRToNativeInterface() {}
-
-	virtual void ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) = 0;
-};
-
+#if PPSSPP_ARCH(AMD64)
 
-class IRToX86 : public IRToNativeInterface {
+// Converts IR blocks (after the full pass pipeline) into x86-64 code.
+// Each block is entered through a shared thunk and returns the next PC, just like IRInterpret().
+// Ops without a native implementation are handed to the IR interpreter one at a time.
+class IRToX86 : public IRToNativeInterface, public Gen::XCodeBlock {
 public:
-	void SetCodeBlock(Gen::XCodeBlock *code) { code_ = code; }
-	void ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) override;
+	IRToX86();
+
+	const u8 *ConvertIRToNative(const IRInst *instructions, int count, int *nativeSize) override;
+	u32 RunBlock(MIPSState *mips, const u8 *entry) override;
+	void ClearCode() override;
+	bool CodeInRange(const u8 *ptr) const override { return IsInSpace(ptr); }
+	const u8 *GetCrashHandler() const override { return crashHandler_; }
 
 private:
-	Gen::XCodeBlock *code_;
+	void GenerateFixedCode();
+	void CompileInstruction(const IRInst &inst);
+	void CompileFallback(const IRInst &inst);
+	void CompileExit(const IRInst &inst);
+	void CompileLoadStore(const IRInst &inst);
+	void CompileFPU(const IRInst &inst);
+	void CompileVec4(const IRInst &inst);
+	void CompileMultiply(const IRInst &inst);
+
+	typedef u32 (*EnterFunc)(MIPSState *mips, const u8 *entry);
+	EnterFunc enter_ = nullptr;
+	const u8 *exit_ = nullptr;
+	const u8 *crashHandler_ = nullptr;
+	const u8 *endOfFixedCode_ = nullptr;
 };
 
+#endif
+
 }  // namespace
@@ -27,6 +27,7 @@
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Core/Core.h"
+#include "Core/MemFault.h"
 #include "Core/MemMap.h"
 #include "Core/System.h"
 #include "Core/CoreTiming.h"
@@ -341,6 +342,7 @@ const u8 *Jit::DoJit(u32 em_address, JitBlock *b) {
 	js.downcountAmount = 0;
 	js.curBlock = b;
 	js.compiling = true;
+	js.fastMemory = g_Config.bFastMemory && !Memory::MemFault_IsSlowMemBlock(js.blockStart);
 	js.inDelaySlot = false;
 	js.afterOp = JitState::AFTER_NONE;
 	js.PrefixStart();
@@ -736,7 +738,7 @@ static void HitInvalidJumpReg(uint32_t source) {
 	currentMIPS->pc = source + 8;
 }
 
-void Jit::WriteExitDestInReg(X64Reg reg) {
+void Jit::WriteExitDestInReg(X64Reg reg, u32 predictedTarget) {
 	// If we need to verify coreState and rewind, we may not jump yet.
 	if (js.afterOp & (JitState::AFTER_CORE_STATE | JitState::AFTER_REWIND_PC_BAD_STATE)) {
 		// CORE_RUNNING is <= CORE_NEXTFRAME.
@@ -753,6 +755,14 @@ void Jit::WriteExitDestInReg(X64Reg reg) {
 		SetJumpTarget(skipCheck);
 	}
 
+	// Check for the expected target first, if it matches this is a normal (linkable) exit.
+	if (predictedTarget != 0 && jo.enableBlocklink && js.nextExit < MAX_JIT_BLOCK_EXITS) {
+		CMP(32, R(reg), Imm32(predictedTarget));
+		FixupBranch miss = J_CC(CC_NE, true);
+		WriteExit(predictedTarget, js.nextExit++);
+		SetJumpTarget(miss);
+	}
+
 	MOV(32, MIPSSTATE_VAR(pc), R(reg));
 	WriteDowncount();
 
@@ -199,7 +199,7 @@ class Jit : public Gen::XCodeBlock, public JitInterface, public MIPSFrontendInte
 	MIPSOpcode GetOffsetInstruction(int offset);
 
 	void WriteExit(u32 destination, int exit_num);
-	void WriteExitDestInReg(Gen::X64Reg reg);
+	void WriteExitDestInReg(Gen::X64Reg reg, u32 predictedTarget = 0);
 
 //	void WriteRfiExitDestInEAX();
 	void WriteSyscallExit();
@@ -60,7 +60,7 @@ JitSafeMem::JitSafeMem(Jit *jit, MIPSGPReg raddr, s32 offset, u32 alignMask)
 	else
 		iaddr_ = (u32) -1;
 
-	fast_ = g_Config.bFastMemory || raddr == MIPS_REG_SP;
+	fast_ = jit_->js.fastMemory || raddr == MIPS_REG_SP;
 
 	// If raddr_ is going to get loaded soon, load it now for more optimal code.
 	// We assume that it was already locked.
@@ -378,6 +378,9 @@ void JitSafeMem::Finish()
 }
 
 void JitSafeMem::MemCheckImm(MemoryOpType type) {
+	if (!CBreakPoints::HasMemChecksForBlock(jit_->js.blockStart))
+		return;
+
 	MemCheck check;
 	if (CBreakPoints::GetMemCheckInRange(iaddr_, size_, &check)) {
 		if (!(check.cond & MEMCHECK_READ) && type == MEM_READ)
@@ -405,6 +408,9 @@ void JitSafeMem::MemCheckImm(MemoryOpType type) {
 
 void JitSafeMem::MemCheckAsm(MemoryOpType type)
 {
+	if (!CBreakPoints::HasMemChecksForBlock(jit_->js.blockStart))
+		return;
+
 	const auto memchecks = CBreakPoints::GetMemCheckRanges(type == MEM_WRITE);
 	bool possible = !memchecks.empty();
 	for (auto it = memchecks.begin(), end = memchecks.end(); it != end; ++it)
@@ -17,7 +17,10 @@
 
 #include "ppsspp_config.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <unordered_map>
 #include <unordered_set>
 #include <mutex>
 
@@ -33,10 +36,14 @@
 #endif
 
 #include "Common/Log.h"
+#include "Common/MemoryUtil.h"
 #include "Core/Config.h"
 #include "Core/Core.h"
+#include "Core/Debugger/Breakpoints.h"
 #include "Core/MemFault.h"
 #include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 
 namespace Memory {
@@ -48,11 +55,363 @@ static bool inCrashHandler = false;
 
 std::unordered_set<const uint8_t *> g_ignoredAddresses;
 
+// After this many ignored faults at one host instruction, its block is recompiled with safe memory.
+static const uint32_t SLOWMEM_FAULT_THRESHOLD = 16;
+
+static std::mutex g_faultSiteLock;
+static std::unordered_map<const uint8_t *, MemFaultSite> g_faultSites;
+// Guest addresses of blocks to compile without fastmem.  Survives jit clears.
+static std::unordered_set<uint32_t> g_slowMemBlocks;
+
+extern u8 *m_pPhysicalRAM[3];
+extern u8 *m_pUncachedRAM[3];
+extern u8 *m_pKernelRAM[3];
+extern u8 *m_pUncachedKernelRAM[3];
+
+// Only the main RAM views are watched. Above this, the extra RAM views may be mapped on top.
+static const uint32_t WRITEWATCH_MAX_SIZE = 0x01F00000;
+
+// Per page memory breakpoint flags.
+enum : uint8_t {
+	MEMCHECK_PAGE_READ = 1,
+	MEMCHECK_PAGE_WRITE = 2,
+	// Currently protected. The first access opens it up until MemCheckWatch_Rearm().
+	MEMCHECK_PAGE_ARMED = 4,
+};
+
+static std::mutex g_writeWatchLock;
+// Stamp of the last write fault per host page, and whether we currently have it protected.
+static std::vector<uint32_t> g_pageWriteStamps;
+static std::vector<uint8_t> g_pageProtected;
+static std::vector<uint8_t> g_pageMemChecks;
+static uint32_t g_writeWatchStamp = 1;
+static uint32_t g_writeWatchPageShift = 0;
+static uint32_t g_writeWatchSize = 0;
+static std::atomic<bool> g_writeWatchActive{ false };
+static std::atomic<bool> g_memCheckWatchActive{ false };
+static std::atomic<bool> g_memCheckNeedsRearm{ false };
+// Guest addresses of blocks that touched a memcheck page.  Protected by g_faultSiteLock.
+static std::unordered_set<uint32_t> g_memCheckBlocks;
+
+static void SetPageProtection(uint32_t firstPage, uint32_t numPages, uint32_t flags) {
+	const size_t offset = (size_t)firstPage << g_writeWatchPageShift;
+	const size_t size = (size_t)numPages << g_writeWatchPageShift;
+	u8 *const mirrors[] = { m_pPhysicalRAM[0], m_pUncachedRAM[0], m_pKernelRAM[0], m_pUncachedKernelRAM[0] };
+	for (u8 *mirror : mirrors) {
+		if (mirror)
+			ProtectMemoryPages(mirror + offset, size, flags);
+	}
+}
+
+// Memchecks and write watching share pages, so this picks the strictest protection needed.
+static void UpdatePageProtectionLocked(uint32_t page) {
+	const uint8_t memCheck = g_pageMemChecks[page];
+	uint32_t flags = MEM_PROT_READ | MEM_PROT_WRITE;
+	if ((memCheck & MEMCHECK_PAGE_ARMED) && (memCheck & MEMCHECK_PAGE_READ))
+		flags = 0;
+	else if ((memCheck & MEMCHECK_PAGE_ARMED) || g_pageProtected[page])
+		flags = MEM_PROT_READ;
+	SetPageProtection(page, 1, flags);
+}
+
+// Returns true if the page range is within watchable RAM.
+static bool WriteWatchPages(uint32_t address, uint32_t size, uint32_t *firstPage, uint32_t *endPage) {
+	const uint32_t offset = (address & 0x3FFFFFFF) - PSP_GetKernelMemoryBase();
+	if (size == 0 || offset >= g_writeWatchSize || size > g_writeWatchSize - offset)
+		return false;
+	*firstPage = offset >> g_writeWatchPageShift;
+	*endPage = (offset + size - 1) >> g_writeWatchPageShift;
+	return true;
+}
+
+// Finds the offset from the kernel memory base for a host pointer into any of the RAM views.
+static bool WatchedHostOffset(uintptr_t ptr, uint32_t *offset) {
+	u8 *const mirrors[] = { m_pPhysicalRAM[0], m_pUncachedRAM[0], m_pKernelRAM[0], m_pUncachedKernelRAM[0] };
+	for (u8 *mirror : mirrors) {
+		if (mirror && ptr >= (uintptr_t)mirror && ptr < (uintptr_t)mirror + g_writeWatchSize) {
+			*offset = (uint32_t)(ptr - (uintptr_t)mirror);
+			return true;
+		}
+	}
+	return false;
+}
+
+static void WriteWatchUnprotectLocked(uint32_t firstPage, uint32_t endPage) {
+	for (uint32_t page = firstPage; page <= endPage; ++page) {
+		if (g_pageProtected[page]) {
+			g_pageProtected[page] = 0;
+			UpdatePageProtectionLocked(page);
+		}
+		g_pageWriteStamps[page] = ++g_writeWatchStamp;
+	}
+}
+
+static void MemCheckDisarmLocked(uint32_t firstPage, uint32_t endPage, uint8_t mask) {
+	for (uint32_t page = firstPage; page <= endPage; ++page) {
+		if ((g_pageMemChecks[page] & MEMCHECK_PAGE_ARMED) && (g_pageMemChecks[page] & mask)) {
+			g_pageMemChecks[page] &= ~MEMCHECK_PAGE_ARMED;
+			UpdatePageProtectionLocked(page);
+			g_memCheckNeedsRearm = true;
+		}
+	}
+}
+
+static void WriteWatchInit() {
+	std::lock_guard<std::mutex> guard(g_writeWatchLock);
+	g_pageWriteStamps.clear();
+	g_pageProtected.clear();
+	g_pageMemChecks.clear();
+	g_writeWatchActive = false;
+	g_memCheckWatchActive = false;
+	g_memCheckNeedsRearm = false;
+	g_writeWatchSize = 0;
+
+#ifdef MACHINE_CONTEXT_SUPPORTED
+	const int pageSize = GetMemoryProtectPageSize();
+	if (pageSize <= 0 || (pageSize & (pageSize - 1)) != 0)
+		return;
+	g_writeWatchPageShift = 0;
+	while ((1 << g_writeWatchPageShift) < pageSize)
+		g_writeWatchPageShift++;
+	g_writeWatchSize = std::min(g_MemorySize, WRITEWATCH_MAX_SIZE) & ~(pageSize - 1);
+	g_pageWriteStamps.resize(g_writeWatchSize >> g_writeWatchPageShift);
+	g_pageProtected.resize(g_writeWatchSize >> g_writeWatchPageShift);
+	g_pageMemChecks.resize(g_writeWatchSize >> g_writeWatchPageShift);
+#endif
+}
+
+uint32_t MemWriteWatch_Protect(uint32_t address, uint32_t size) {
+	std::lock_guard<std::mutex> guard(g_writeWatchLock);
+	uint32_t firstPage, endPage;
+	if (!WriteWatchPages(address, size, &firstPage, &endPage))
+		return 0;
+
+	// Protect runs of pages at once, to keep the number of calls down.
+	uint32_t runStart = firstPage;
+	for (uint32_t page = firstPage; page <= endPage + 1; ++page) {
+		if (page <= endPage && !g_pageProtected[page]) {
+			g_pageProtected[page] = 1;
+			// Armed memcheck pages are already at least read only.
+			if (!(g_pageMemChecks[page] & MEMCHECK_PAGE_ARMED))
+				continue;
+		}
+		if (page > runStart)
+			SetPageProtection(runStart, page - runStart, MEM_PROT_READ);
+		runStart = page + 1;
+	}
+	g_writeWatchActive = true;
+	return g_writeWatchStamp;
+}
+
+bool MemWriteWatch_WrittenSince(uint32_t address, uint32_t size, uint32_t stamp) {
+	std::lock_guard<std::mutex> guard(g_writeWatchLock);
+	uint32_t firstPage, endPage;
+	if (stamp == 0 || !WriteWatchPages(address, size, &firstPage, &endPage))
+		return true;
+	for (uint32_t page = firstPage; page <= endPage; ++page) {
+		if (g_pageWriteStamps[page] > stamp)
+			return true;
+	}
+	return false;
+}
+
+void MemWriteWatch_NotifyHostWrite(const void *ptr, size_t size) {
+	if ((!g_writeWatchActive && !g_memCheckWatchActive) || size == 0)
+		return;
+	std::lock_guard<std::mutex> guard(g_writeWatchLock);
+	uint32_t offset;
+	if (WatchedHostOffset((uintptr_t)ptr, &offset)) {
+		const uint32_t clampedSize = (uint32_t)std::min(size, (size_t)(g_writeWatchSize - offset));
+		const uint32_t firstPage = offset >> g_writeWatchPageShift;
+		const uint32_t endPage = (offset + clampedSize - 1) >> g_writeWatchPageShift;
+		MemCheckDisarmLocked(firstPage, endPage, MEMCHECK_PAGE_READ | MEMCHECK_PAGE_WRITE);
+		WriteWatchUnprotectLocked(firstPage, endPage);
+	}
+}
+
+void MemWriteWatch_Reset() {
+	std::lock_guard<std::mutex> guard(g_writeWatchLock);
+	if (!g_writeWatchActive && !g_memCheckWatchActive)
+		return;
+	for (uint32_t page = 0; page < (uint32_t)g_pageProtected.size(); ++page) {
+		// Memcheck pages are rearmed next time the jit is entered.
+		if (g_pageProtected[page] || (g_pageMemChecks[page] & MEMCHECK_PAGE_ARMED)) {
+			g_pageProtected[page] = 0;
+			if (g_pageMemChecks[page] & MEMCHECK_PAGE_ARMED) {
+				g_pageMemChecks[page] &= ~MEMCHECK_PAGE_ARMED;
+				g_memCheckNeedsRearm = true;
+			}
+			UpdatePageProtectionLocked(page);
+		}
+	}
+	// Anything watched before this may have been overwritten.
+	++g_writeWatchStamp;
+	std::fill(g_pageWriteStamps.begin(), g_pageWriteStamps.end(), g_writeWatchStamp);
+	g_writeWatchActive = false;
+}
+
+uint32_t MemWriteWatch_GetPageSize() {
+	std::lock_guard<std::mutex> guard(g_writeWatchLock);
+	return g_writeWatchSize != 0 ? 1U << g_writeWatchPageShift : 0;
+}
+
+uint32_t MemWriteWatch_GetWatchableSize() {
+	std::lock_guard<std::mutex> guard(g_writeWatchLock);
+	return g_writeWatchSize;
+}
+
+bool MemCheckWatch_Add(uint32_t address, uint32_t size, bool read) {
+	std::lock_guard<std::mutex> guard(g_writeWatchLock);
+	uint32_t firstPage, endPage;
+	if (!WriteWatchPages(address, size, &firstPage, &endPage))
+		return false;
+
+	for (uint32_t page = firstPage; page <= endPage; ++page) {
+		g_pageMemChecks[page] |= (read ? MEMCHECK_PAGE_READ : MEMCHECK_PAGE_WRITE) | MEMCHECK_PAGE_ARMED;
+		UpdatePageProtectionLocked(page);
+	}
+	g_memCheckWatchActive = true;
+	return true;
+}
+
+static void MemCheckWatchClearLocked() {
+	for (uint32_t page = 0; page < (uint32_t)g_pageMemChecks.size(); ++page) {
+		if (g_pageMemChecks[page] != 0) {
+			const bool wasArmed = (g_pageMemChecks[page] & MEMCHECK_PAGE_ARMED) != 0;
+			g_pageMemChecks[page] = 0;
+			if (wasArmed)
+				UpdatePageProtectionLocked(page);
+		}
+	}
+	g_memCheckWatchActive = false;
+	g_memCheckNeedsRearm = false;
+}
+
+void MemCheckWatch_Clear() {
+	{
+		std::lock_guard<std::mutex> guard(g_writeWatchLock);
+		MemCheckWatchClearLocked();
+	}
+	std::lock_guard<std::mutex> guard(g_faultSiteLock);
+	g_memCheckBlocks.clear();
+}
+
+bool MemCheckWatch_IsActive() {
+	return g_memCheckWatchActive;
+}
+
+bool MemCheckWatch_IsCheckedBlock(uint32_t blockAddress) {
+	std::lock_guard<std::mutex> guard(g_faultSiteLock);
+	return g_memCheckBlocks.count(blockAddress) != 0;
+}
+
+void MemCheckWatch_Rearm() {
+	if (!g_memCheckNeedsRearm)
+		return;
+	std::lock_guard<std::mutex> guard(g_writeWatchLock);
+	g_memCheckNeedsRearm = false;
+	if (!g_memCheckWatchActive)
+		return;
+	for (uint32_t page = 0; page < (uint32_t)g_pageMemChecks.size(); ++page) {
+		if (g_pageMemChecks[page] != 0 && !(g_pageMemChecks[page] & MEMCHECK_PAGE_ARMED)) {
+			g_pageMemChecks[page] |= MEMCHECK_PAGE_ARMED;
+			UpdatePageProtectionLocked(page);
+		}
+	}
+}
+
+void MemCheckWatch_NotifyHostRead(const void *ptr, size_t size) {
+	if (!g_memCheckWatchActive || size == 0)
+		return;
+	std::lock_guard<std::mutex> guard(g_writeWatchLock);
+	uint32_t offset;
+	if (WatchedHostOffset((uintptr_t)ptr, &offset)) {
+		const uint32_t clampedSize = (uint32_t)std::min(size, (size_t)(g_writeWatchSize - offset));
+		// Only read checks make pages unreadable.
+		MemCheckDisarmLocked(offset >> g_writeWatchPageShift, (offset + clampedSize - 1) >> g_writeWatchPageShift, MEMCHECK_PAGE_READ);
+	}
+}
+
+// Called first from HandleFault. Returns true if this was a write to a page we protected.
+static bool HandleWriteWatchFault(uintptr_t hostAddress) {
+	if (!g_writeWatchActive)
+		return false;
+	std::lock_guard<std::mutex> guard(g_writeWatchLock);
+	uint32_t offset;
+	if (!WatchedHostOffset(hostAddress, &offset))
+		return false;
+	// If another thread got here first, the page is already writable, so just retry.
+	WriteWatchUnprotectLocked(offset >> g_writeWatchPageShift, offset >> g_writeWatchPageShift);
+	return true;
+}
+
 void MemFault_Init() {
 	g_numReportedBadAccesses = 0;
 	g_lastCrashAddress = nullptr;
 	g_lastMemoryExceptionType = MemoryExceptionType::NONE;
 	g_ignoredAddresses.clear();
+
+	std::lock_guard<std::mutex> guard(g_faultSiteLock);
+	g_faultSites.clear();
+	g_slowMemBlocks.clear();
+	g_memCheckBlocks.clear();
+
+	WriteWatchInit();
+}
+
+std::vector<MemFaultSite> MemFault_GetTopSites(size_t maxSites) {
+	std::vector<MemFaultSite> sites;
+	{
+		std::lock_guard<std::mutex> guard(g_faultSiteLock);
+		sites.reserve(g_faultSites.size());
+		for (const auto &it : g_faultSites)
+			sites.push_back(it.second);
+	}
+
+	std::sort(sites.begin(), sites.end(), [](const MemFaultSite &a, const MemFaultSite &b) {
+		return a.count > b.count;
+	});
+	if (sites.size() > maxSites)
+		sites.resize(maxSites);
+	return sites;
+}
+
+uint64_t MemFault_GetNumIgnoredFaults() {
+	return (uint64_t)g_numReportedBadAccesses;
+}
+
+bool MemFault_IsSlowMemBlock(uint32_t blockAddress) {
+	std::lock_guard<std::mutex> guard(g_faultSiteLock);
+	return !g_slowMemBlocks.empty() && g_slowMemBlocks.count(blockAddress) != 0;
+}
+
+// Called with the jit lock held, when a fault at codePtr was skipped.
+static void CountIgnoredFault(const uint8_t *codePtr, bool isWrite) {
+	std::lock_guard<std::mutex> guard(g_faultSiteLock);
+	auto it = g_faultSites.find(codePtr);
+	if (it == g_faultSites.end()) {
+		MemFaultSite site{};
+		site.isWrite = isWrite;
+		// Only the classic jits know which block a host address is in (may be slow, but once per site.)
+		JitBlockCache *blocks = MIPSComp::jit ? MIPSComp::jit->GetBlockCache() : nullptr;
+		if (blocks) {
+			u32 blockAddress = blocks->GetAddressFromBlockPtr(codePtr);
+			int blockNum = blockAddress != 0 && blockAddress != (u32)-1 ? blocks->GetBlockNumberFromStartAddress(blockAddress) : -1;
+			if (blockNum != -1) {
+				site.blockAddress = blockAddress;
+				site.hostOffset = (uint32_t)(codePtr - blocks->GetBlock(blockNum)->checkedEntry);
+			}
+		}
+		it = g_faultSites.emplace(codePtr, site).first;
+	}
+
+	MemFaultSite &site = it->second;
+	site.count++;
+	if (site.count == SLOWMEM_FAULT_THRESHOLD && site.blockAddress != 0 && g_slowMemBlocks.insert(site.blockAddress).second) {
+		// We're inside the block right now, so let it be recompiled next time we enter the jit.
+		WARN_LOG(MEMMAP, "Block at %08x keeps hitting bad memory, recompiling with safe memory access", site.blockAddress);
+		currentMIPS->InvalidateICacheLater(site.blockAddress, 4);
+	}
 }
 
 bool MemFault_MayBeResumable() {
@@ -94,7 +453,105 @@ static bool DisassembleNativeAt(const uint8_t *codePtr, int instructionSize, std
 	return false;
 }
 
+// Size and direction of the faulting access, for memchecks.
+static bool AnalyzeAccess(const uint8_t *codePtr, int *size, bool *isWrite) {
+#if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
+	LSInstructionInfo info{};
+	if (X86AnalyzeMOV(codePtr, info)) {
+		*size = info.operandSize;
+		*isWrite = info.isMemoryWrite;
+		return true;
+	}
+#elif PPSSPP_ARCH(ARM64)
+	uint32_t word;
+	memcpy(&word, codePtr, 4);
+	Arm64LSInstructionInfo info{};
+	if (Arm64AnalyzeLoadStore((uint64_t)codePtr, word, &info)) {
+		*size = 1 << info.size;
+		*isWrite = info.isMemoryWrite;
+		return true;
+	}
+#elif PPSSPP_ARCH(ARM)
+	uint32_t word;
+	memcpy(&word, codePtr, 4);
+	ArmLSInstructionInfo info{};
+	if (ArmAnalyzeLoadStore((uint32_t)codePtr, word, &info)) {
+		*size = 1 << info.size;
+		*isWrite = info.isMemoryWrite;
+		return true;
+	}
+#endif
+	return false;
+}
+
+// Called first from HandleFault, for any thread. Opens up a memcheck page on first access.
+// If it was the jit, the block gets memchecks from now on, and we check this access here since
+// its code had none. Like a hardware watchpoint, that breaks after the access (and the rest of
+// the block), and the reported PC is the start of the block.
+static bool HandleMemCheckFault(uintptr_t hostAddress, SContext *context) {
+	if (!g_memCheckWatchActive)
+		return false;
+
+	uint32_t offset;
+	uint8_t pageFlags;
+	{
+		std::lock_guard<std::mutex> guard(g_writeWatchLock);
+		if (!WatchedHostOffset(hostAddress, &offset))
+			return false;
+		const uint32_t page = offset >> g_writeWatchPageShift;
+		pageFlags = g_pageMemChecks[page];
+		if (pageFlags == 0)
+			return false;
+		MemCheckDisarmLocked(page, page, MEMCHECK_PAGE_READ | MEMCHECK_PAGE_WRITE);
+	}
+	if (!(pageFlags & MEMCHECK_PAGE_ARMED)) {
+		// Another thread opened it up first, but it may still be write watched.  Either way, retry.
+		HandleWriteWatchFault(hostAddress);
+		return true;
+	}
+
+	const uint8_t *codePtr = (const uint8_t *)context->CTX_PC;
+	u32 blockAddress = 0;
+	int size = 4;
+	// If it can only be a read fault, this must have been a write.
+	bool isWrite = (pageFlags & MEMCHECK_PAGE_READ) == 0;
+	{
+		std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+		// Accesses from HLE, the GPU, etc. aren't checked here.
+		if (!MIPSComp::jit || !MIPSComp::jit->CodeInRange(codePtr))
+			return true;
+
+		AnalyzeAccess(codePtr, &size, &isWrite);
+		JitBlockCache *blocks = MIPSComp::jit->GetBlockCache();
+		blockAddress = blocks ? blocks->GetAddressFromBlockPtr(codePtr) : 0;
+		if (blockAddress == 0 || blockAddress == (u32)-1) {
+			// Can't tell which block to recompile, so go back to memchecks everywhere.
+			WARN_LOG(MEMMAP, "Memory breakpoint page hit outside a known block, using memchecks in all blocks");
+			{
+				std::lock_guard<std::mutex> pageGuard(g_writeWatchLock);
+				MemCheckWatchClearLocked();
+			}
+			currentMIPS->ClearJitCache();
+			return true;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(g_faultSiteLock);
+		// We're inside the block right now, so let it be recompiled next time we enter the jit.
+		if (g_memCheckBlocks.insert(blockAddress).second)
+			currentMIPS->InvalidateICacheLater(blockAddress, 4);
+	}
+
+	CBreakPoints::ExecMemCheck(PSP_GetKernelMemoryBase() + offset, isWrite, size, blockAddress, "fault");
+	return true;
+}
+
 bool HandleFault(uintptr_t hostAddress, void *ctx) {
+	if (HandleMemCheckFault(hostAddress, (SContext *)ctx))
+		return true;
+	if (HandleWriteWatchFault(hostAddress))
+		return true;
 	if (inCrashHandler)
 		return false;
 	inCrashHandler = true;
@@ -281,6 +738,7 @@ bool HandleFault(uintptr_t hostAddress, void *ctx) {
 		// Move on to the next instruction. Note that handling bad accesses like this is pretty slow.
 		context->CTX_PC += info.instructionSize;
 		g_numReportedBadAccesses++;
+		CountIgnoredFault(codePtr, info.isMemoryWrite);
 		if (g_numReportedBadAccesses < 100) {
 			ERROR_LOG(MEMMAP, "Bad memory access detected and ignored: %08x (%p)", guestAddress, (void *)hostAddress);
 		}
@@ -310,6 +768,8 @@ bool HandleFault(uintptr_t hostAddress, void *ctx) {
 #else
 
 bool HandleFault(uintptr_t hostAddress, void *ctx) {
+	if (HandleWriteWatchFault(hostAddress))
+		return true;
 	ERROR_LOG(MEMMAP, "Exception handling not supported");
 	return false;
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
 namespace Memory {
 
@@ -14,6 +16,55 @@ void MemFault_Init();
 bool MemFault_MayBeResumable();
 void MemFault_IgnoreLastCrash();
 
+struct MemFaultSite {
+	// Start of the jit block with the faulting access, 0 if unknown.
+	uint32_t blockAddress;
+	// Offset of the host instruction from the start of the block's code.
+	uint32_t hostOffset;
+	uint32_t count;
+	bool isWrite;
+};
+
+// Ignored bad accesses, most frequent first.
+std::vector<MemFaultSite> MemFault_GetTopSites(size_t maxSites);
+uint64_t MemFault_GetNumIgnoredFaults();
+
+// True if the jit should compile this block with safe (checked) memory accesses,
+// because fastmem accesses in it fault over and over.
+bool MemFault_IsSlowMemBlock(uint32_t blockAddress);
+
+// Write watching of PSP RAM using host page protection. The first write to a protected page
+// faults, which makes it writable again and bumps its write stamp.
+// Returns a stamp for MemWriteWatch_WrittenSince, or 0 if the range can't be watched.
+uint32_t MemWriteWatch_Protect(uint32_t address, uint32_t size);
+// True if any page in the range may have been written after the stamp was taken.
+bool MemWriteWatch_WrittenSince(uint32_t address, uint32_t size, uint32_t stamp);
+// Writes by the host OS (like file reads and sockets) don't fault, they fail instead.
+// Call this first with the destination, if it might be PSP RAM.
+void MemWriteWatch_NotifyHostWrite(const void *ptr, size_t size);
+// Unprotects all pages, and treats them all as written. For savestates and shutdown.
+void MemWriteWatch_Reset();
+// Host page size used for watching, or 0 if write watching isn't supported.
+uint32_t MemWriteWatch_GetPageSize();
+// How much of RAM, from the kernel memory base, can be watched.
+uint32_t MemWriteWatch_GetWatchableSize();
+
+// Memory breakpoints using the same page protection. Pages covering the ranges are made read only,
+// or inaccessible for read checks, so jit blocks can skip memchecks until they touch one. Such an
+// access is checked from the fault handler, and its block is recompiled with memchecks.
+// Returns false if the range can't be watched this way.
+bool MemCheckWatch_Add(uint32_t address, uint32_t size, bool read);
+// Unprotects and forgets all pages, and forgets which blocks need memchecks.
+void MemCheckWatch_Clear();
+// False if there are no watched pages, in which case every block needs memchecks.
+bool MemCheckWatch_IsActive();
+// True if the block touched a watched page, so the jit should give it memchecks.
+bool MemCheckWatch_IsCheckedBlock(uint32_t blockAddress);
+// Pages stay open after the access that faulted, until this is called when entering the jit.
+void MemCheckWatch_Rearm();
+// Like MemWriteWatch_NotifyHostWrite, for reads by the host OS (like file writes.)
+void MemCheckWatch_NotifyHostRead(const void *ptr, size_t size);
+
 // Called by exception handlers. We simply filter out accesses to PSP RAM and otherwise
 // just leave it as-is.
 bool HandleFault(uintptr_t hostAddress, void *context);
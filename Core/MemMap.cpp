@@ -29,6 +29,7 @@
 #include "Common/MemArena.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/StringUtils.h"
 
 #include "Core/Core.h"
 #include "Core/Config.h"
@@ -113,6 +114,8 @@ static MemoryView views[] =
 
 static const int num_views = sizeof(views) / sizeof(MemoryView);
 
+static std::string g_memoryMapError;
+
 inline static bool CanIgnoreView(const MemoryView &view) {
 #ifdef MASKED_PSP_MEMORY
 	// Basically, 32-bit platforms can ignore views that are masked out anyway.
@@ -158,8 +161,8 @@ static bool Memory_TryBase(u32 flags) {
 		*view.out_ptr = (u8*)g_arena.CreateView(
 			position, view.size, base + view.virtual_address);
 		if (!*view.out_ptr) {
-			goto bail;
 			DEBUG_LOG(MEMMAP, "Failed at view %d", i);
+			goto bail;
 		}
 #else
 		if (CanIgnoreView(view)) {
@@ -182,9 +185,9 @@ static bool Memory_TryBase(u32 flags) {
 bail:
 	// Argh! ERROR! Free what we grabbed so far so we can try again.
 	for (int j = 0; j <= i; j++) {
-		if (views[i].size == 0)
+		if (views[j].size == 0)
 			continue;
-		SKIP(flags, views[i].flags);
+		SKIP(flags, views[j].flags);
 		if (*views[j].out_ptr) {
 			if (!CanIgnoreView(views[j])) {
 				g_arena.ReleaseView(*views[j].out_ptr, views[j].size);
@@ -195,7 +198,12 @@ static bool Memory_TryBase(u32 flags) {
 	return false;
 }
 
+const std::string &MemoryMap_Error() {
+	return g_memoryMapError;
+}
+
 bool MemoryMap_Setup(u32 flags) {
+	g_memoryMapError.clear();
 #if PPSSPP_PLATFORM(UWP)
 	// We reserve the memory, then simply commit in TryBase.
 	base = (u8*)VirtualAllocFromApp(0, 0x10000000, MEM_RESERVE, PAGE_READWRITE);
@@ -214,6 +222,7 @@ bool MemoryMap_Setup(u32 flags) {
 	// Grab some pagefile backed memory out of the void ...
 	if (!g_arena.GrabMemSpace(total_mem)) {
 		// It'll already have logged.
+		g_memoryMapError = "Unable to allocate memory for PSP RAM";
 		return false;
 	}
 #endif
@@ -247,16 +256,31 @@ bool MemoryMap_Setup(u32 flags) {
 			}
 		}
 		ERROR_LOG(MEMMAP, "MemoryMap_Setup: Failed finding a memory base.");
+		g_memoryMapError = StringFromFormat("No free address range found after %d tries", base_attempts);
 		return false;
 	}
 	else
 #endif
 	{
 #if !PPSSPP_PLATFORM(UWP)
-		base = g_arena.Find4GBBase();
-		if (!base) {
-			return false;
+		// Find4GBBase may not be able to keep the range reserved, so something else can take it
+		// before the views are mapped.  Just try again a few times in that case.
+		const int MAX_ATTEMPTS = 4;
+		for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+			base = g_arena.Find4GBBase();
+			if (!base) {
+				ERROR_LOG(MEMMAP, "MemoryMap_Setup: Failed to find a free address range.");
+				g_memoryMapError = "No free address range for the PSP memory map";
+				return false;
+			}
+			if (Memory_TryBase(flags)) {
+				return true;
+			}
+			WARN_LOG(MEMMAP, "MemoryMap_Setup: Failed to map views at %p, retrying", base);
 		}
+		ERROR_LOG(MEMMAP, "MemoryMap_Setup: Failed to map views after %d tries.", MAX_ATTEMPTS);
+		g_memoryMapError = "Unable to map PSP memory views";
+		return false;
 #endif
 	}
 
@@ -321,6 +345,8 @@ static void DoMemoryVoid(PointerWrap &p, uint32_t start, uint32_t size) {
 	if ((size & 0x3F) != 0 || ((uintptr_t)d & 0x3F) != 0)
 		return p.DoVoid(d, size);
 
+	p.ReserveWrite(size);
+
 	switch (p.mode) {
 	case PointerWrap::MODE_READ:
 		ParallelMemcpy(&g_threadManager, d, storage, size);
@@ -343,7 +369,7 @@ static void DoMemoryVoid(PointerWrap &p, uint32_t start, uint32_t size) {
 	storage += size;
 }
 
-void DoState(PointerWrap &p) {
+void DoState(PointerWrap &p, bool includeRAM) {
 	auto s = p.Section("Memory", 1, 3);
 	if (!s)
 		return;
@@ -375,7 +401,10 @@ void DoState(PointerWrap &p) {
 		}
 	}
 
-	DoMemoryVoid(p, PSP_GetKernelMemoryBase(), g_MemorySize);
+	if (p.mode == PointerWrap::MODE_READ)
+		MemWriteWatch_Reset();
+	if (includeRAM)
+		DoMemoryVoid(p, PSP_GetKernelMemoryBase(), g_MemorySize);
 	p.DoMarker("RAM");
 
 	DoMemoryVoid(p, PSP_GetVidMemBase(), VRAM_SIZE);
@@ -386,6 +415,7 @@ void DoState(PointerWrap &p) {
 
 void Shutdown() {
 	std::lock_guard<std::recursive_mutex> guard(g_shutdownLock);
+	MemWriteWatch_Reset();
 	u32 flags = 0;
 	MemoryMap_Shutdown(flags);
 	base = nullptr;
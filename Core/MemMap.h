@@ -21,6 +21,7 @@
 
 #include <cstring>
 #include <cstdint>
+#include <string>
 #ifndef offsetof
 #include <stddef.h>
 #endif
@@ -107,11 +108,14 @@ struct MemoryView
 // Uses a memory arena to set up an emulator-friendly memory map
 bool MemoryMap_Setup(u32 flags);
 void MemoryMap_Shutdown(u32 flags);
+// Why MemoryMap_Setup last failed, empty if it didn't.
+const std::string &MemoryMap_Error();
 
 // Init and Shutdown
 bool Init();
 void Shutdown();
-void DoState(PointerWrap &p);
+// Rewind states keep main RAM outside of the state, and pass includeRAM = false.
+void DoState(PointerWrap &p, bool includeRAM = true);
 void Clear();
 // False when shutdown has already been called.
 bool IsActive();
@@ -23,14 +23,18 @@
 #endif
 
 #include <cstring>
+#include <cstdlib>
 #include <ctime>
 #include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Log.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Core/CoreTiming.h"
 #include "Core/Replay.h"
+#include "Core/SaveState.h"
 #include "Core/FileSystems/FileSystem.h"
 #include "Core/HLE/sceCtrl.h"
 #include "Core/HLE/sceKernelTime.h"
@@ -136,6 +140,11 @@ static uint8_t lastAnalog[2][2]{};
 static size_t replayDiskPos = 0;
 static bool diskFailed = false;
 
+static Path keyframeDirectory;
+static uint64_t keyframeInterval = 0;
+static uint64_t lastKeyframeTime = 0;
+static bool lastKeyframeValid = false;
+
 bool ReplayExecuteBlob(int version, const std::vector<uint8_t> &data) {
 	if (version < REPLAY_VERSION_MIN || version > REPLAY_VERSION_CURRENT) {
 		ERROR_LOG(SYSTEM, "Bad replay data version: %d", version);
@@ -335,6 +344,87 @@ void ReplayAbort() {
 
 	replayDiskPos = 0;
 	diskFailed = false;
+
+	lastKeyframeValid = false;
+}
+
+void ReplaySetKeyframes(const Path &directory, int intervalSeconds) {
+	keyframeDirectory = directory;
+	keyframeInterval = intervalSeconds > 0 ? (uint64_t)intervalSeconds * 1000000ULL : 0;
+	lastKeyframeValid = false;
+	if (keyframeInterval != 0)
+		File::CreateFullPath(directory);
+}
+
+bool ReplayNextKeyframe(uint64_t t, Path *filename) {
+	if (replayState == ReplayState::IDLE || keyframeInterval == 0)
+		return false;
+	// The first one is right away, so seeking works from the start of the recording.
+	if (lastKeyframeValid && t < lastKeyframeTime + keyframeInterval)
+		return false;
+
+	lastKeyframeTime = t;
+	lastKeyframeValid = true;
+	*filename = keyframeDirectory / StringFromFormat("%016llx.ppst", (unsigned long long)t);
+	return true;
+}
+
+// Positions execution at the first event at or after t, as if everything before had been executed.
+static void ReplaySeekExecute(uint64_t t) {
+	lastButtons = 0;
+	memset(lastAnalog, 0, sizeof(lastAnalog));
+
+	size_t pos = 0;
+	for (; pos < replayItems.size() && replayItems[pos].info.timestamp < t; ++pos) {
+		const auto &item = replayItems[pos];
+		if (item.info.action == ReplayAction::BUTTONS) {
+			lastButtons = item.info.buttons;
+		} else if (item.info.action == ReplayAction::ANALOG) {
+			memcpy(lastAnalog, item.info.analog, sizeof(lastAnalog));
+		}
+	}
+
+	replayExecPos = pos;
+	replayCtrlPos = pos;
+	replayDiskPos = pos;
+	diskFailed = false;
+}
+
+bool ReplaySeekKeyframe(uint64_t t) {
+	if (replayState != ReplayState::EXECUTE || keyframeDirectory.empty())
+		return false;
+
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(keyframeDirectory, &files, "ppst");
+
+	Path best;
+	uint64_t bestTime = 0;
+	for (const auto &file : files) {
+		char *end = nullptr;
+		uint64_t fileTime = strtoull(file.name.c_str(), &end, 16);
+		if (end == file.name.c_str() || fileTime > t)
+			continue;
+		if (best.empty() || fileTime > bestTime) {
+			best = file.fullName;
+			bestTime = fileTime;
+		}
+	}
+
+	if (best.empty()) {
+		WARN_LOG(SYSTEM, "No replay keyframe at or before %lld", (long long)t);
+		return false;
+	}
+
+	INFO_LOG(SYSTEM, "Seeking replay to keyframe %s", best.c_str());
+	SaveState::Load(best, -1, [](SaveState::Status status, const std::string &message, void *) {
+		if (status == SaveState::Status::FAILURE) {
+			ERROR_LOG(SYSTEM, "Failed to load replay keyframe: %s", message.c_str());
+			return;
+		}
+		if (replayState == ReplayState::EXECUTE)
+			ReplaySeekExecute(CoreTiming::GetGlobalTimeUs());
+	});
+	return true;
 }
 
 bool ReplayIsExecuting() {
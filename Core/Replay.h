@@ -68,6 +68,15 @@ int ReplayVersion();
 // Abort any execute or record operation in progress.
 void ReplayAbort();
 
+// Keyframes are savestates taken while recording or executing, so playback can start near any point.
+// They're saved as directory/<time>.ppst.  Set intervalSeconds to 0 to stop taking them.
+void ReplaySetKeyframes(const Path &directory, int intervalSeconds);
+// Called once per frame.  Returns true with the filename when a keyframe should be saved now.
+bool ReplayNextKeyframe(uint64_t t, Path *filename);
+// Loads the latest keyframe at or before t (async), then continues executing the replay from there.
+// The replay must be executing, with data from the start of the session.
+bool ReplaySeekKeyframe(uint64_t t);
+
 // Check if replay data is being executed or saved.
 bool ReplayIsExecuting();
 bool ReplayIsSaving();
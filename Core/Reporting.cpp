@@ -202,6 +202,11 @@ namespace Reporting
 		PurgeCRC();
 	}
 
+	void SetKnownCRC(const Path &gamePath, uint32_t crc) {
+		std::lock_guard<std::mutex> guard(crcLock);
+		crcResults.emplace(gamePath, crc);
+	}
+
 	// Returns the full host (e.g. report.ppsspp.org:80.)
 	std::string ServerHost()
 	{
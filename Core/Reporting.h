@@ -71,6 +71,9 @@ namespace Reporting
 
 	void CancelCRC();
 
+	// Provides a hash calculated earlier (e.g. remembered from a previous run) so it's not recalculated.
+	void SetKnownCRC(const Path &gamePath, uint32_t crc);
+
 	// Blocks until the CRC hash is available for game, and returns it.
 	// To avoid stalling, call HasCRC() in update() or similar and call this if it returns true.
 	uint32_t RetrieveCRC(const Path &gamePath);
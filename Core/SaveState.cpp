@@ -16,15 +16,25 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
-#include <vector>
-#include <thread>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
+
+#include <zstd.h>
+
+#include "ext/xxhash.h"
 
 #include "Common/Data/Text/I18n.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Common/Thread/ThreadUtil.h"
+#include "Common/Thread/Waitable.h"
 #include "Common/Data/Text/Parsers.h"
 
 #include "Common/File/FileUtil.h"
+#include "Common/Profiler/MemoryUsage.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/StringUtils.h"
@@ -44,11 +54,14 @@
 #include "Core/HLE/sceDisplay.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceUtility.h"
+#include "Core/MemFault.h"
 #include "Core/MemMap.h"
+#include "Core/Replay.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "HW/MemoryStick.h"
 #include "GPU/GPUState.h"
+#include "GPU/Common/GPUDebugInterface.h"
 
 #ifndef MOBILE_DEVICE
 #include "Core/AVIDump.h"
@@ -89,9 +102,15 @@ namespace SaveState
 		void *cbUserData;
 	};
 
+	// Lets new buffers start out big enough.
+	static size_t lastStateSize = 0;
+
 	CChunkFileReader::Error SaveToRam(std::vector<u8> &data) {
 		SaveStart state;
-		return CChunkFileReader::MeasureAndSavePtr(state, &data);
+		CChunkFileReader::Error err = CChunkFileReader::SavePtr(state, &data, lastStateSize);
+		if (err == CChunkFileReader::ERROR_NONE)
+			lastStateSize = data.size();
+		return err;
 	}
 
 	CChunkFileReader::Error LoadFromRam(std::vector<u8> &data, std::string *errorString) {
@@ -99,23 +118,209 @@ namespace SaveState
 		return CChunkFileReader::LoadPtr(&data[0], state, errorString);
 	}
 
+	// Pages of main RAM a rewind state changed, as they were in the state before it.
+	struct RewindRAMUndo {
+		std::vector<u32> pages;
+		std::vector<u8> data;
+		// False for the first state after a reset, which has nothing older to return to.
+		bool valid = false;
+		// If data is zstd packed, see StateRingbuffer::Compress.
+		bool packed = false;
+	};
+
+	// With write tracking, rewind states leave main RAM out of the serialized state.
+	// Instead, shadow_ is a copy of RAM as of the newest state, and each state keeps only the
+	// pages written since the one before (see MemWriteWatch_Protect.)  Restoring copies shadow_
+	// back and then walks it back one state using that state's undo pages.
+	class RewindRAM {
+	public:
+		static bool Supported() {
+			return Memory::MemWriteWatch_GetPageSize() != 0;
+		}
+
+		// Must happen while the jit's emuhacks are cleared out of RAM, so called from SaveStart.
+		void DoState(PointerWrap &p) {
+			if (p.mode == PointerWrap::MODE_WRITE) {
+				Capture();
+			} else if (p.mode == PointerWrap::MODE_READ) {
+				if (shadow_.size() != Memory::g_MemorySize) {
+					ERROR_LOG(SAVESTATE, "Rewind: RAM size changed since the state was saved");
+					p.SetError(PointerWrap::ERROR_FAILURE);
+					return;
+				}
+				u8 *ram = Memory::GetPointerWriteUnchecked(PSP_GetKernelMemoryBase());
+				if (restorePagesValid_) {
+					const u32 pageSize = Memory::MemWriteWatch_GetPageSize();
+					for (u32 page : restorePages_) {
+						const size_t offset = (size_t)page * pageSize;
+						memcpy(ram + offset, &shadow_[offset], std::min((size_t)pageSize, shadow_.size() - offset));
+					}
+					restorePages_.clear();
+					restorePagesValid_ = false;
+				} else {
+					memcpy(ram, shadow_.data(), shadow_.size());
+				}
+			}
+		}
+
+		// RAM pages that differ from shadow_, plus the pages of undo records about to be reverted.
+		// The next DoState(MODE_READ) then copies only these.  Must be called before the load,
+		// which resets write watching.
+		void SetRestorePages(const std::vector<const RewindRAMUndo *> &reverting) {
+			const u32 base = PSP_GetKernelMemoryBase();
+			const u32 pageSize = Memory::MemWriteWatch_GetPageSize();
+			const size_t numPages = (shadow_.size() + pageSize - 1) / pageSize;
+			std::vector<bool> dirty(numPages);
+			for (size_t page = 0; page < numPages; ++page) {
+				const size_t offset = page * pageSize;
+				dirty[page] = stamp_ == 0 || Memory::MemWriteWatch_WrittenSince(base + (u32)offset, (u32)std::min((size_t)pageSize, shadow_.size() - offset), stamp_);
+			}
+			for (const RewindRAMUndo *undo : reverting) {
+				for (u32 page : undo->pages)
+					dirty[page] = true;
+			}
+			restorePages_.clear();
+			for (size_t page = 0; page < numPages; ++page) {
+				if (dirty[page])
+					restorePages_.push_back((u32)page);
+			}
+			restorePagesValid_ = true;
+		}
+
+		// After a load, RAM matches shadow_, so only pages written from here on need checking.
+		void Rearm() {
+			const u32 watchSize = std::min((u32)shadow_.size(), Memory::MemWriteWatch_GetWatchableSize());
+			stamp_ = watchSize != 0 ? Memory::MemWriteWatch_Protect(PSP_GetKernelMemoryBase(), watchSize) : 0;
+		}
+
+		// The undo pages of the state saved by the next DoState(MODE_WRITE).
+		void SetCaptureTarget(RewindRAMUndo *undo) {
+			captureTarget_ = undo;
+		}
+
+		// After restoring the state owning undo, step shadow_ back to the state before it.
+		void Revert(const RewindRAMUndo &undo) {
+			if (!undo.valid) {
+				Clear();
+				return;
+			}
+			const u32 pageSize = Memory::MemWriteWatch_GetPageSize();
+			const u8 *src = undo.data.data();
+			for (u32 page : undo.pages) {
+				const size_t offset = (size_t)page * pageSize;
+				const size_t len = std::min((size_t)pageSize, shadow_.size() - offset);
+				memcpy(&shadow_[offset], src, len);
+				src += len;
+			}
+		}
+
+		void Clear() {
+			shadow_.clear();
+			stamp_ = 0;
+			restorePages_.clear();
+			restorePagesValid_ = false;
+		}
+
+		size_t MemoryUsed() const {
+			return shadow_.capacity();
+		}
+
+	private:
+		void Capture() {
+			RewindRAMUndo *undo = captureTarget_;
+			captureTarget_ = nullptr;
+			const u32 base = PSP_GetKernelMemoryBase();
+			const size_t size = Memory::g_MemorySize;
+			const u8 *ram = Memory::GetPointerUnchecked(base);
+			const u32 pageSize = Memory::MemWriteWatch_GetPageSize();
+
+			// Protect before looking, so anything written from here on is seen by the next state.
+			const u32 watchSize = std::min((u32)size, Memory::MemWriteWatch_GetWatchableSize());
+			const u32 stamp = watchSize != 0 ? Memory::MemWriteWatch_Protect(base, watchSize) : 0;
+
+			if (shadow_.size() != size || pageSize == 0) {
+				shadow_.assign(ram, ram + size);
+				if (undo) {
+					undo->pages.clear();
+					undo->data.clear();
+					undo->valid = false;
+				}
+				stamp_ = stamp;
+				return;
+			}
+
+			std::vector<u32> pages;
+			std::vector<u8> data;
+			for (size_t offset = 0; offset < size; offset += pageSize) {
+				const size_t len = std::min((size_t)pageSize, size - offset);
+				// Outside the watched range (or without a stamp), WrittenSince() says yes.
+				if (stamp_ != 0 && !Memory::MemWriteWatch_WrittenSince(base + (u32)offset, (u32)len, stamp_))
+					continue;
+				// Written pages often end up the same, like jit emuhacks being cleared for the save.
+				if (memcmp(&shadow_[offset], ram + offset, len) == 0)
+					continue;
+				pages.push_back((u32)(offset / pageSize));
+				data.insert(data.end(), shadow_.begin() + offset, shadow_.begin() + offset + len);
+				memcpy(&shadow_[offset], ram + offset, len);
+			}
+			stamp_ = stamp;
+
+			if (undo) {
+				undo->pages = std::move(pages);
+				undo->data = std::move(data);
+				undo->valid = true;
+			}
+			DEBUG_LOG(SAVESTATE, "Rewind: %d RAM pages changed", (int)(undo ? undo->pages.size() : pages.size()));
+		}
+
+		std::vector<u8> shadow_;
+		u32 stamp_ = 0;
+		RewindRAMUndo *captureTarget_ = nullptr;
+		std::vector<u32> restorePages_;
+		bool restorePagesValid_ = false;
+	};
+
+	// Set while the rewind ring saves or restores a state that leaves RAM out.
+	static RewindRAM *activeRewindRAM = nullptr;
+
+	// Runs StateRingbuffer compression on the thread pool.
+	class RewindCompressTask : public Task {
+	public:
+		RewindCompressTask(std::function<void()> func, LimitedWaitable *waitable) : func_(std::move(func)), waitable_(waitable) {}
+
+		TaskType Type() const override { return TaskType::CPU_COMPUTE; }
+		TaskPriority Priority() const override { return TaskPriority::LOW; }
+
+		void Run() override {
+			func_();
+			waitable_->Notify();
+		}
+
+	private:
+		std::function<void()> func_;
+		LimitedWaitable *waitable_;
+	};
+
 	// This ring buffer of states is for rewind save states, which are kept in RAM.
-	// Save states are compressed against one of two reference saves (bases_), and the reference
+	// Save states are compressed against a reference save (a base), and the reference
 	// is switched to a fresh save every N saves, where N is BASE_USAGE_INTERVAL.
-	// The compression is a simple block based scheme where 0 means to copy a block from the base,
-	// and 1 means that the following bytes are the next block. See Compress/LockedDecompress.
+	// The delta is a simple block based scheme where 0 means to copy a block from the base,
+	// and 1 means that the following bytes are the next block, and is then packed with zstd.
+	// See Compress/LockedDecompress.
+	// Old states are dropped to stay within iRewindMemoryBudget, and bases are freed along with
+	// the last state using them.
+	// With bRewindWriteTracking, main RAM is kept separately by RewindRAM.
 	class StateRingbuffer {
 	public:
 		StateRingbuffer() {
-			size_ = REWIND_NUM_STATES;
+			size_ = MAX_REWIND_STATES;
 			states_.resize(size_);
-			baseMapping_.resize(size_);
+			ramUndo_.resize(size_);
+			stateBases_.resize(size_);
 		}
 
 		~StateRingbuffer() {
-			if (compressThread_.joinable()) {
-				compressThread_.join();
-			}
+			WaitForCompress();
 		}
 
 		CChunkFileReader::Error Save()
@@ -124,70 +329,104 @@ namespace SaveState
 
 			// Make sure we're not processing a previous save. That'll cause a hitch though, but at least won't
 			// crash due to contention over buffer_.
-			if (compressThread_.joinable())
-				compressThread_.join();
+			WaitForCompress();
+
+			// States with and without RAM can't be mixed, since the bases would mismatch.
+			bool trackRAM = g_Config.bRewindWriteTracking && RewindRAM::Supported();
+			if (trackRAM != trackRAM_) {
+				Clear();
+				trackRAM_ = trackRAM;
+			}
 
 			std::lock_guard<std::mutex> guard(lock_);
 
+			if (next_ - first_ >= size_)
+				EvictOldestLocked();
 			int n = next_++ % size_;
-			if ((next_ % size_) == first_)
-				++first_;
 
 			std::vector<u8> *compressBuffer = &buffer_;
 			CChunkFileReader::Error err;
 
-			if (base_ == -1 || ++baseUsage_ > BASE_USAGE_INTERVAL)
+			if (trackRAM_) {
+				activeRewindRAM = &ram_;
+				ram_.SetCaptureTarget(&ramUndo_[n]);
+			}
+			if (!base_ || ++baseUsage_ > BASE_USAGE_INTERVAL)
 			{
-				base_ = (base_ + 1) % ARRAY_SIZE(bases_);
+				base_ = std::make_shared<StateBuffer>();
 				baseUsage_ = 0;
-				err = SaveToRam(bases_[base_]);
+				err = SaveToRam(*base_);
 				// Let's not bother savestating twice.
-				compressBuffer = &bases_[base_];
+				compressBuffer = base_.get();
 			}
 			else
 				err = SaveToRam(buffer_);
+			activeRewindRAM = nullptr;
+
+			if (trackRAM_ && err != CChunkFileReader::ERROR_NONE) {
+				// The RAM copy may already have moved on, so older states can't be trusted.
+				ram_.Clear();
+			}
 
+			stateBases_[n] = base_;
 			if (err == CChunkFileReader::ERROR_NONE)
-				ScheduleCompress(&states_[n], compressBuffer, &bases_[base_]);
+				ScheduleCompress(&states_[n], compressBuffer, base_.get(), trackRAM_ ? &ramUndo_[n] : nullptr);
 			else
 				states_[n].clear();
 
-			baseMapping_[n] = base_;
 			return err;
 		}
 
 		CChunkFileReader::Error Restore(std::string *errorString)
 		{
+			// The newest state might not be packed yet.
+			WaitForCompress();
+
 			std::lock_guard<std::mutex> guard(lock_);
 
 			// No valid states left.
 			if (Empty())
 				return CChunkFileReader::ERROR_BAD_FILE;
 
-			int n = (--next_ + size_) % size_;
-			if (states_[n].empty())
+			int n = --next_ % size_;
+			if (states_[n].empty() || !stateBases_[n])
 				return CChunkFileReader::ERROR_BAD_FILE;
 
 			static std::vector<u8> buffer;
-			LockedDecompress(buffer, states_[n], bases_[baseMapping_[n]]);
+			if (!LockedDecompress(buffer, states_[n], *stateBases_[n])) {
+				ERROR_LOG(SAVESTATE, "Rewind: Failed to decompress state");
+				return CChunkFileReader::ERROR_BAD_FILE;
+			}
+			if (trackRAM_)
+				activeRewindRAM = &ram_;
 			CChunkFileReader::Error error = LoadFromRam(buffer, errorString);
+			activeRewindRAM = nullptr;
+			if (trackRAM_) {
+				if (error == CChunkFileReader::ERROR_NONE && UnpackUndo(ramUndo_[n]))
+					ram_.Revert(ramUndo_[n]);
+				else
+					ram_.Clear();
+				ramUndo_[n] = RewindRAMUndo();
+			}
 			rewindLastTime_ = time_now_d();
 			return error;
 		}
 
-		void ScheduleCompress(std::vector<u8> *result, const std::vector<u8> *state, const std::vector<u8> *base)
+		void ScheduleCompress(std::vector<u8> *result, const std::vector<u8> *state, const std::vector<u8> *base, RewindRAMUndo *undo)
 		{
-			if (compressThread_.joinable())
-				compressThread_.join();
-			compressThread_ = std::thread([=]{
-				SetCurrentThreadName("SaveStateCompress");
-
-				// Should do no I/O, so no JNI thread context needed.
-				Compress(*result, *state, *base);
-			});
+			WaitForCompress();
+			auto func = [=] {
+				Compress(*result, *state, *base, undo);
+			};
+			if (!g_threadManager.IsInitialized()) {
+				func();
+				return;
+			}
+			compressWaitable_ = new LimitedWaitable();
+			g_threadManager.EnqueueTask(new RewindCompressTask(func, compressWaitable_));
 		}
 
-		void Compress(std::vector<u8> &result, const std::vector<u8> &state, const std::vector<u8> &base)
+		void Compress(std::vector<u8> &result, const std::vector<u8> &state, const std::vector<u8> &base, RewindRAMUndo *undo)
 		{
 			std::lock_guard<std::mutex> guard(lock_);
 			// Bail if we were cleared before locking.
@@ -195,32 +434,45 @@ namespace SaveState
 				return;
 
 			double start_time = time_now_d();
-			result.clear();
-			result.reserve(512 * 1024);
+			delta_.clear();
+			delta_.reserve(512 * 1024);
 			for (size_t i = 0; i < state.size(); i += BLOCK_SIZE)
 			{
 				int blockSize = std::min(BLOCK_SIZE, (int)(state.size() - i));
 				if (i + blockSize > base.size() || memcmp(&state[i], &base[i], blockSize) != 0)
 				{
-					result.push_back(1);
-					result.insert(result.end(), state.begin() + i, state.begin() + i + blockSize);
+					delta_.push_back(1);
+					delta_.insert(delta_.end(), state.begin() + i, state.begin() + i + blockSize);
 				}
 				else
-					result.push_back(0);
+					delta_.push_back(0);
+			}
+			Pack(result, delta_);
+
+			size_t undoSize = 0;
+			if (undo && undo->valid && !undo->data.empty()) {
+				std::vector<u8> packed;
+				Pack(packed, undo->data);
+				undo->data = std::move(packed);
+				undo->packed = true;
+				undoSize = undo->data.size();
 			}
 
 			double taken_s = time_now_d() - start_time;
-			DEBUG_LOG(SAVESTATE, "Rewind: Compressed save from %d bytes to %d in %0.2f ms.", (int)state.size(), (int)result.size(), taken_s * 1000.0);
+			DEBUG_LOG(SAVESTATE, "Rewind: Compressed save from %d bytes to %d (+%d RAM) in %0.2f ms.", (int)state.size(), (int)result.size(), (int)undoSize, taken_s * 1000.0);
 		}
 
-		void LockedDecompress(std::vector<u8> &result, const std::vector<u8> &compressed, const std::vector<u8> &base)
+		bool LockedDecompress(std::vector<u8> &result, const std::vector<u8> &compressed, const std::vector<u8> &base)
 		{
+			if (!Unpack(delta_, compressed))
+				return false;
+
 			result.clear();
 			result.reserve(base.size());
 			auto basePos = base.begin();
-			for (size_t i = 0; i < compressed.size(); )
+			for (size_t i = 0; i < delta_.size(); )
 			{
-				if (compressed[i] == 0)
+				if (delta_[i] == 0)
 				{
 					++i;
 					int blockSize = std::min(BLOCK_SIZE, (int)(base.size() - result.size()));
@@ -230,8 +482,8 @@ namespace SaveState
 				else
 				{
 					++i;
-					int blockSize = std::min(BLOCK_SIZE, (int)(compressed.size() - i));
-					result.insert(result.end(), compressed.begin() + i, compressed.begin() + i + blockSize);
+					int blockSize = std::min(BLOCK_SIZE, (int)(delta_.size() - i));
+					result.insert(result.end(), delta_.begin() + i, delta_.begin() + i + blockSize);
 					i += blockSize;
 					// This check is to avoid advancing basePos out of range, which MSVC catches.
 					// When this happens, we're at the end of decoding anyway.
@@ -240,29 +492,33 @@ namespace SaveState
 					}
 				}
 			}
+			return true;
 		}
 
 		void Clear()
 		{
-			if (compressThread_.joinable())
-				compressThread_.join();
+			WaitForCompress();
 
 			// This lock is mainly for shutdown.
 			std::lock_guard<std::mutex> guard(lock_);
 			first_ = 0;
 			next_ = 0;
-			for (auto &b : bases_) {
-				b.clear();
+			base_.reset();
+			for (auto &b : stateBases_) {
+				b.reset();
 			}
-			baseMapping_.clear();
-			baseMapping_.resize(size_);
 			for (auto &s : states_) {
 				s.clear();
 			}
+			for (auto &undo : ramUndo_) {
+				undo = RewindRAMUndo();
+			}
+			ram_.Clear();
 			buffer_.clear();
-			base_ = -1;
+			delta_.clear();
 			baseUsage_ = 0;
 			rewindLastTime_ = time_now_d();
+			MemUsage_Set(MemoryCategory::REWIND, 0);
 		}
 
 		bool Empty() const
@@ -283,6 +539,7 @@ namespace SaveState
 
 			DEBUG_LOG(SAVESTATE, "Saving rewind state");
 			Save();
+			TrimToBudget();
 		}
 
 		void NotifyState() {
@@ -291,25 +548,111 @@ namespace SaveState
 		}
 
 	private:
+		typedef std::vector<u8> StateBuffer;
+
+		void WaitForCompress() {
+			if (compressWaitable_) {
+				compressWaitable_->WaitAndRelease();
+				compressWaitable_ = nullptr;
+			}
+		}
+
+		static void Pack(std::vector<u8> &result, const std::vector<u8> &data) {
+			result.resize(ZSTD_compressBound(data.size()));
+			size_t size = ZSTD_compress(result.data(), result.size(), data.data(), data.size(), ZSTD_LEVEL);
+			if (ZSTD_isError(size)) {
+				result.clear();
+				return;
+			}
+			result.resize(size);
+			result.shrink_to_fit();
+		}
+
+		static bool Unpack(std::vector<u8> &result, const std::vector<u8> &packed) {
+			unsigned long long size = ZSTD_getFrameContentSize(packed.data(), packed.size());
+			if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN)
+				return false;
+			result.resize((size_t)size);
+			return !ZSTD_isError(ZSTD_decompress(result.data(), result.size(), packed.data(), packed.size()));
+		}
+
+		static bool UnpackUndo(RewindRAMUndo &undo) {
+			if (!undo.packed)
+				return true;
+			std::vector<u8> data;
+			if (!Unpack(data, undo.data))
+				return false;
+			undo.data = std::move(data);
+			undo.packed = false;
+			return true;
+		}
+
+		void EvictOldestLocked() {
+			int n = first_++ % size_;
+			states_[n].clear();
+			states_[n].shrink_to_fit();
+			stateBases_[n].reset();
+			ramUndo_[n] = RewindRAMUndo();
+		}
+
+		// Bases are shared by many states, so only count each once.
+		size_t MemoryUsedLocked() const {
+			size_t used = buffer_.capacity() + delta_.capacity() + ram_.MemoryUsed();
+			const StateBuffer *lastBase = nullptr;
+			for (int i = first_; i < next_; ++i) {
+				int n = i % size_;
+				used += states_[n].size() + ramUndo_[n].data.size() + ramUndo_[n].pages.size() * sizeof(u32);
+				if (stateBases_[n] && stateBases_[n].get() != lastBase) {
+					lastBase = stateBases_[n].get();
+					used += lastBase->size();
+				}
+			}
+			return used;
+		}
+
+		void TrimToBudget() {
+			// Sizes are only known once packed.
+			WaitForCompress();
+
+			std::lock_guard<std::mutex> guard(lock_);
+			size_t budget = (size_t)std::max(g_Config.iRewindMemoryBudget, 1) * 1024 * 1024;
+			int64_t trackedBudget = MemUsage_GetBudget(MemoryCategory::REWIND);
+			if (trackedBudget != 0)
+				budget = std::min(budget, (size_t)trackedBudget);
+			size_t used = MemoryUsedLocked();
+			// Always keep the newest state, or rewind couldn't work at all.
+			while (used > budget && next_ - first_ > 1) {
+				EvictOldestLocked();
+				used = MemoryUsedLocked();
+			}
+			MemUsage_Set(MemoryCategory::REWIND, (int64_t)used);
+		}
+
 		const int BLOCK_SIZE = 8192;
-		const int REWIND_NUM_STATES = 20;
+		// The real limit is the memory budget, this is just so the bookkeeping stays fixed size.
+		const int MAX_REWIND_STATES = 1000;
 		// TODO: Instead, based on size of compressed state?
 		const int BASE_USAGE_INTERVAL = 15;
+		// Fast levels keep up with a snapshot a second even on slow devices.
+		static const int ZSTD_LEVEL = 1;
 
-		typedef std::vector<u8> StateBuffer;
-
+		// Both count up from the first state since Clear(), slots are these modulo size_.
 		int first_ = 0;
 		int next_ = 0;
 		int size_;
 
 		std::vector<StateBuffer> states_;
-		StateBuffer bases_[2];
-		std::vector<int> baseMapping_;
+		std::vector<RewindRAMUndo> ramUndo_;
+		std::vector<std::shared_ptr<StateBuffer>> stateBases_;
+		std::shared_ptr<StateBuffer> base_;
+		RewindRAM ram_;
+		bool trackRAM_ = false;
 		std::mutex lock_;
-		std::thread compressThread_;
+		LimitedWaitable *compressWaitable_ = nullptr;
 		std::vector<u8> buffer_;
+		// Unpacked delta, only touched under lock_.
+		std::vector<u8> delta_;
 
-		int base_ = -1;
 		int baseUsage_ = 0;
 
 		double rewindLastTime_ = 0.0f;
@@ -328,11 +671,183 @@ namespace SaveState
 	static int saveDataGeneration = 0;
 	static int lastSaveDataGeneration = 0;
 	static std::string saveStateInitialGitVersion = "";
+	// Whether this boot has saved or loaded its boot snapshot yet, see iBootSnapshotSeconds.
+	static bool bootSnapshotChecked = false;
+	static bool bootSnapshotDone = false;
 
 	// TODO: Should this be configurable?
 	static const int SCREENSHOT_FAILURE_RETRIES = 15;
 	static StateRingbuffer rewindStates;
 
+	// Uncompressed snapshots of the last few frames, for rollback.  With write tracking, RAM is kept by
+	// RewindRAM, so saving copies only pages written since the last frame, and loading copies only
+	// pages that differ from the target frame.
+	class RollbackStates {
+	public:
+		CChunkFileReader::Error Save(int frame) {
+			trackRAM_ = RewindRAM::Supported();
+
+			// Right after loading a frame, it's already saved.
+			if (count_ > 0 && Newest().frame == frame)
+				return CChunkFileReader::ERROR_NONE;
+			// Going back without loading leaves nothing to step back from, so start over.
+			if (count_ > 0 && Newest().frame > frame)
+				Clear();
+			if (count_ == MAX_ROLLBACK_FRAMES) {
+				first_ = (first_ + 1) % MAX_ROLLBACK_FRAMES;
+				count_--;
+				// The oldest state left has nothing older to step back to now.
+				frames_[first_].undo = RewindRAMUndo();
+			}
+
+			Frame &slot = frames_[(first_ + count_) % MAX_ROLLBACK_FRAMES];
+			slot.frame = frame;
+			if (trackRAM_) {
+				ram_.SetCaptureTarget(&slot.undo);
+				activeRewindRAM = &ram_;
+			}
+			SaveStart state;
+			CChunkFileReader::Error err = CChunkFileReader::SavePtr(state, &slot.state, lastSize_);
+			activeRewindRAM = nullptr;
+
+			if (err != CChunkFileReader::ERROR_NONE) {
+				// The RAM copy may already have moved on past the older frames.
+				Clear();
+				return err;
+			}
+			lastSize_ = slot.state.size();
+			count_++;
+			return err;
+		}
+
+		CChunkFileReader::Error Load(int frame, std::string *errorString) {
+			int index = -1;
+			for (int i = 0; i < count_; ++i) {
+				if (frames_[(first_ + i) % MAX_ROLLBACK_FRAMES].frame == frame)
+					index = i;
+			}
+			if (index < 0) {
+				*errorString = "No snapshot for that frame";
+				return CChunkFileReader::ERROR_BAD_FILE;
+			}
+
+			if (trackRAM_) {
+				// Step the RAM copy back to the target frame, noting every page that might differ.
+				std::vector<const RewindRAMUndo *> reverting;
+				for (int i = count_ - 1; i > index; --i)
+					reverting.push_back(&frames_[(first_ + i) % MAX_ROLLBACK_FRAMES].undo);
+				ram_.SetRestorePages(reverting);
+				for (const RewindRAMUndo *undo : reverting)
+					ram_.Revert(*undo);
+				activeRewindRAM = &ram_;
+			}
+			// Newer frames will be simulated again.
+			while (count_ > index + 1)
+				DropNewest();
+
+			CChunkFileReader::Error err = LoadFromRam(frames_[(first_ + index) % MAX_ROLLBACK_FRAMES].state, errorString);
+			activeRewindRAM = nullptr;
+			if (err != CChunkFileReader::ERROR_NONE) {
+				Clear();
+				return err;
+			}
+			if (trackRAM_)
+				ram_.Rearm();
+			return err;
+		}
+
+		void Clear() {
+			while (count_ > 0)
+				DropNewest();
+			first_ = 0;
+			ram_.Clear();
+		}
+
+	private:
+		// Enough for a quarter second of latency at 60 fps.
+		static const int MAX_ROLLBACK_FRAMES = 16;
+
+		struct Frame {
+			int frame = 0;
+			std::vector<u8> state;
+			RewindRAMUndo undo;
+		};
+
+		Frame &Newest() {
+			return frames_[(first_ + count_ - 1) % MAX_ROLLBACK_FRAMES];
+		}
+
+		void DropNewest() {
+			// Keep the buffers around, they're reused for the next save.
+			Newest().undo = RewindRAMUndo();
+			count_--;
+		}
+
+		Frame frames_[MAX_ROLLBACK_FRAMES];
+		int first_ = 0;
+		int count_ = 0;
+		RewindRAM ram_;
+		bool trackRAM_ = false;
+		size_t lastSize_ = 0;
+	};
+
+	static RollbackStates rollbackStates;
+
+	// Compressing and writing states and screenshots doesn't need the emulator stopped.
+	class AsyncWriteTask : public Task {
+	public:
+		AsyncWriteTask(std::function<void()> work, LimitedWaitable *waitable) : work_(std::move(work)), waitable_(waitable) {}
+
+		TaskType Type() const override { return TaskType::IO_BLOCKING; }
+		TaskPriority Priority() const override { return TaskPriority::NORMAL; }
+
+		void Run() override {
+			work_();
+			waitable_->Notify();
+		}
+
+	private:
+		std::function<void()> work_;
+		LimitedWaitable *waitable_;
+	};
+
+	struct PendingWrite {
+		LimitedWaitable *waitable;
+		// Runs on the emu thread once the work is done, to call back like other operations.
+		std::function<void()> finish;
+	};
+	static std::vector<PendingWrite> pendingWrites;
+
+	static void StartAsyncWrite(std::function<void()> work, std::function<void()> finish) {
+		if (!g_threadManager.IsInitialized()) {
+			work();
+			finish();
+			return;
+		}
+		LimitedWaitable *waitable = new LimitedWaitable();
+		pendingWrites.push_back(PendingWrite{ waitable, std::move(finish) });
+		g_threadManager.EnqueueTask(new AsyncWriteTask(std::move(work), waitable));
+	}
+
+	static void FinishPendingWrites(bool wait) {
+		// Finish callbacks may queue more operations, so copy out first.
+		std::vector<PendingWrite> done;
+		for (auto it = pendingWrites.begin(); it != pendingWrites.end(); ) {
+			if (wait) {
+				it->waitable->Wait();
+			} else if (!it->waitable->WaitFor(0.0)) {
+				++it;
+				continue;
+			}
+			done.push_back(std::move(*it));
+			it = pendingWrites.erase(it);
+		}
+		for (PendingWrite &write : done) {
+			delete write.waitable;
+			write.finish();
+		}
+	}
+
 	void SaveStart::DoState(PointerWrap &p)
 	{
 		auto s = p.Section("SaveStart", 1, 3);
@@ -362,6 +877,13 @@ namespace SaveState
 			CoreTiming::DoState(p);
 		}
 
+		// Rewind may keep main RAM itself, but it still needs it without emuhacks.
+		auto doMemoryState = [&]() {
+			Memory::DoState(p, activeRewindRAM == nullptr);
+			if (activeRewindRAM)
+				activeRewindRAM->DoState(p);
+		};
+
 		// Memory is a bit tricky when jit is enabled, since there's emuhacks in it.
 		auto savedReplacements = SaveAndClearReplacements();
 		if (MIPSComp::jit && p.mode == p.MODE_WRITE) {
@@ -369,13 +891,13 @@ namespace SaveState
 			if (MIPSComp::jit) {
 				std::vector<u32> savedBlocks;
 				savedBlocks = MIPSComp::jit->SaveAndClearEmuHackOps();
-				Memory::DoState(p);
+				doMemoryState();
 				MIPSComp::jit->RestoreSavedEmuHackOps(savedBlocks);
 			} else {
-				Memory::DoState(p);
+				doMemoryState();
 			}
 		} else {
-			Memory::DoState(p);
+			doMemoryState();
 		}
 
 		if (s >= 3) {
@@ -439,6 +961,21 @@ namespace SaveState
 		Enqueue(Operation(SAVESTATE_SAVE_SCREENSHOT, filename, -1, callback, cbUserData));
 	}
 
+	CChunkFileReader::Error RollbackSave(int frame)
+	{
+		return rollbackStates.Save(frame);
+	}
+
+	CChunkFileReader::Error RollbackLoad(int frame, std::string *errorString)
+	{
+		return rollbackStates.Load(frame, errorString);
+	}
+
+	void RollbackClear()
+	{
+		rollbackStates.Clear();
+	}
+
 	bool CanRewind()
 	{
 		return !rewindStates.Empty();
@@ -520,6 +1057,15 @@ namespace SaveState
 		return GetSysDirectory(DIRECTORY_SAVESTATE) / filename;
 	}
 
+	Path GenerateBootSnapshotFilename(const Path &gameFilename)
+	{
+		// A snapshot from another version or with other settings would boot the game differently.
+		std::string key = StringFromFormat("%s %d %d %d %d %d %d", PPSSPP_GIT_VERSION, g_Config.iPSPModel, g_Config.iFirmwareVersion, g_Config.iLanguage, g_Config.iButtonPreference, g_Config.iLockedCPUSpeed, g_Config.iBootSnapshotSeconds);
+		u32 hash = (u32)XXH3_64bits(key.data(), key.size());
+		std::string filename = StringFromFormat("%s_%08x.%s", GenerateFullDiscId(gameFilename).c_str(), hash, BOOT_SNAPSHOT_EXTENSION);
+		return GetSysDirectory(DIRECTORY_SAVESTATE) / filename;
+	}
+
 	int GetCurrentSlot()
 	{
 		return g_Config.iCurrentStateSlot;
@@ -887,9 +1433,171 @@ namespace SaveState
 		return Status::SUCCESS;
 	}
 
+	struct DeterminismSample {
+		std::string title;
+		u64 hash;
+	};
+	static FILE *determinismLog = nullptr;
+	static bool determinismCompare = false;
+	static u64 determinismInterval = 0;
+	static u64 determinismNext = 0;
+	static std::map<u64, std::vector<DeterminismSample>> determinismReference;
+	static std::string determinismResult;
+
+	bool DeterminismCheckBegin(const Path &filename, bool compare, int intervalMs) {
+		std::string message;
+		DeterminismCheckEnd(&message);
+
+		determinismReference.clear();
+		determinismResult.clear();
+		determinismCompare = compare;
+		determinismInterval = (u64)std::max(intervalMs, 1) * 1000;
+		determinismNext = 0;
+
+		if (!compare) {
+			determinismLog = File::OpenCFile(filename, "w");
+			if (!determinismLog) {
+				ERROR_LOG(SAVESTATE, "Determinism: Unable to create %s", filename.c_str());
+				determinismInterval = 0;
+				return false;
+			}
+			return true;
+		}
+
+		std::string data;
+		if (!File::ReadFileToString(true, filename, data)) {
+			ERROR_LOG(SAVESTATE, "Determinism: Unable to read %s", filename.c_str());
+			determinismInterval = 0;
+			return false;
+		}
+		std::vector<std::string> lines;
+		SplitString(data, '\n', lines);
+		for (const std::string &line : lines) {
+			unsigned long long t, hash;
+			char title[17]{};
+			if (sscanf(line.c_str(), "%llu %16s %llx", &t, title, &hash) == 3)
+				determinismReference[t].push_back(DeterminismSample{ title, hash });
+		}
+		INFO_LOG(SAVESTATE, "Determinism: Comparing against %d samples", (int)determinismReference.size());
+		return true;
+	}
+
+	bool DeterminismCheckEnd(std::string *message) {
+		if (determinismLog) {
+			fclose(determinismLog);
+			determinismLog = nullptr;
+		}
+		determinismInterval = 0;
+		determinismReference.clear();
+		*message = determinismResult;
+		return determinismResult.empty();
+	}
+
+	static void ProcessDeterminismCheck() {
+		if (determinismInterval == 0 || !determinismResult.empty() || !__KernelIsRunning())
+			return;
+		u64 t = CoreTiming::GetGlobalTimeUs();
+		// After a reboot, start over from the beginning.
+		if (t + determinismInterval < determinismNext)
+			determinismNext = 0;
+
+		std::vector<DeterminismSample> *reference = nullptr;
+		if (determinismCompare) {
+			// Sample exactly when the reference did, so frame timing is checked too.
+			auto it = determinismReference.lower_bound(determinismNext);
+			if (it == determinismReference.end() || t < it->first)
+				return;
+			if (t != it->first) {
+				determinismResult = StringFromFormat("Frame timing diverged, at %llu us instead of %llu us", (unsigned long long)t, (unsigned long long)it->first);
+				ERROR_LOG(SAVESTATE, "Determinism: %s", determinismResult.c_str());
+				return;
+			}
+			reference = &it->second;
+			determinismNext = t + 1;
+		} else {
+			if (t < determinismNext)
+				return;
+			determinismNext = t + determinismInterval;
+		}
+
+		static std::vector<u8> buffer;
+		std::vector<SerializeCheckpoint> sections;
+		SaveStart state;
+		if (CChunkFileReader::SavePtr(state, &buffer, lastStateSize, &sections) != CChunkFileReader::ERROR_NONE) {
+			ERROR_LOG(SAVESTATE, "Determinism: Failed to save state at %llu us", (unsigned long long)t);
+			return;
+		}
+
+		// Nested sections are split where the next one starts.
+		for (size_t i = 0; i < sections.size(); ++i) {
+			size_t start = sections[i].offset;
+			size_t end = i + 1 < sections.size() ? sections[i + 1].offset : buffer.size();
+			u64 hash = XXH3_64bits(buffer.data() + start, end - start);
+			// Titles are at most 16 characters, but may have spaces.
+			std::string title = ReplaceAll(sections[i].title, " ", "_");
+
+			if (determinismLog) {
+				fprintf(determinismLog, "%llu %s %016llx\n", (unsigned long long)t, title.c_str(), (unsigned long long)hash);
+			} else if (i >= reference->size() || (*reference)[i].title != title || (*reference)[i].hash != hash) {
+				determinismResult = StringFromFormat("State diverged at %llu us in section %s (#%d)", (unsigned long long)t, title.c_str(), (int)i);
+				ERROR_LOG(SAVESTATE, "Determinism: %s", determinismResult.c_str());
+				return;
+			}
+		}
+		if (reference && reference->size() != sections.size()) {
+			determinismResult = StringFromFormat("State diverged at %llu us, %d sections instead of %d", (unsigned long long)t, (int)sections.size(), (int)reference->size());
+			ERROR_LOG(SAVESTATE, "Determinism: %s", determinismResult.c_str());
+		}
+	}
+
+	static void ProcessBootSnapshot() {
+		if (bootSnapshotDone || g_Config.iBootSnapshotSeconds <= 0)
+			return;
+
+		Path filename = GenerateBootSnapshotFilename(PSP_CoreParameter().fileToStart);
+		if (filename.empty()) {
+			bootSnapshotDone = true;
+			return;
+		}
+
+		if (!bootSnapshotChecked) {
+			bootSnapshotChecked = true;
+			// Don't get in the way of an auto load or anything else already queued.
+			if (!needsProcess && File::Exists(filename)) {
+				INFO_LOG(SAVESTATE, "Resuming from boot snapshot %s", filename.c_str());
+				bootSnapshotDone = true;
+				Load(filename, -1);
+				return;
+			}
+		}
+
+		// Loading any other state means this is no longer a plain boot.
+		if (hasLoadedState || needsProcess) {
+			bootSnapshotDone = hasLoadedState;
+			return;
+		}
+
+		if (CoreTiming::GetGlobalTimeUs() >= (u64)g_Config.iBootSnapshotSeconds * 1000000ULL) {
+			INFO_LOG(SAVESTATE, "Saving boot snapshot %s", filename.c_str());
+			bootSnapshotDone = true;
+			Path tempFilename = filename.WithExtraExtension(".tmp");
+			Save(tempFilename, -1, [=](Status status, const std::string &message, void *) {
+				if (status != Status::FAILURE)
+					File::Rename(tempFilename, filename);
+			});
+		}
+	}
+
 	void Process()
 	{
 		rewindStates.Process();
+		FinishPendingWrites(false);
+		ProcessBootSnapshot();
+		ProcessDeterminismCheck();
+
+		Path keyframe;
+		if (ReplayNextKeyframe(CoreTiming::GetGlobalTimeUs(), &keyframe))
+			Save(keyframe, -1);
 
 		if (!needsProcess)
 			return;
@@ -928,6 +1636,8 @@ namespace SaveState
 			{
 			case SAVESTATE_LOAD:
 				INFO_LOG(SAVESTATE, "Loading state from '%s'", op.filename.c_str());
+				// The state might still be on its way to disk.
+				FinishPendingWrites(true);
 				// Use the state's latest version as a guess for saveStateInitialGitVersion.
 				result = CChunkFileReader::Load(op.filename, &saveStateInitialGitVersion, state, &errorString);
 				if (result == CChunkFileReader::ERROR_NONE) {
@@ -962,6 +1672,7 @@ namespace SaveState
 				break;
 
 			case SAVESTATE_SAVE:
+			{
 				INFO_LOG(SAVESTATE, "Saving state to %s", op.filename.c_str());
 				title = g_paramSFO.GetValueString("TITLE");
 				if (title.empty()) {
@@ -970,31 +1681,57 @@ namespace SaveState
 					std::size_t lslash = title.find_last_of("/");
 					title = title.substr(lslash + 1);
 				}
-				result = CChunkFileReader::Save(op.filename, title, PPSSPP_GIT_VERSION, state);
-				if (result == CChunkFileReader::ERROR_NONE) {
-					callbackMessage = slot_prefix + sc->T("Saved State");
-					callbackResult = Status::SUCCESS;
-#ifndef MOBILE_DEVICE
-					if (g_Config.bSaveLoadResetsAVdumping) {
-						if (g_Config.bDumpFrames) {
-							AVIDump::Stop();
-							AVIDump::Start(PSP_CoreParameter().renderWidth, PSP_CoreParameter().renderHeight);
-						}
-						if (g_Config.bDumpAudio) {
-							WAVDump::Reset();
-						}
+				// Only the snapshot needs the emulator stopped, the rest happens in the background.
+				auto data = std::make_shared<std::vector<u8>>();
+				result = CChunkFileReader::SavePtr(state, data.get(), lastStateSize);
+				if (result != CChunkFileReader::ERROR_NONE) {
+					if (result == CChunkFileReader::ERROR_BROKEN_STATE) {
+						// TODO: What else might we want to do here? This should be very unusual.
+						ERROR_LOG(SAVESTATE, "Save state failure");
 					}
-#endif
-				} else if (result == CChunkFileReader::ERROR_BROKEN_STATE) {
-					// TODO: What else might we want to do here? This should be very unusual.
-					callbackMessage = i18nSaveFailure;
-					ERROR_LOG(SAVESTATE, "Save state failure");
-					callbackResult = Status::FAILURE;
-				} else {
 					callbackMessage = i18nSaveFailure;
 					callbackResult = Status::FAILURE;
+					break;
 				}
-				break;
+				lastStateSize = data->size();
+
+				auto writeResult = std::make_shared<CChunkFileReader::Error>(CChunkFileReader::ERROR_NONE);
+				StartAsyncWrite([=] {
+					// SaveFile takes ownership of a malloc buffer.
+					u8 *buffer = (u8 *)malloc(data->size());
+					if (!buffer) {
+						*writeResult = CChunkFileReader::ERROR_BAD_ALLOC;
+						return;
+					}
+					memcpy(buffer, data->data(), data->size());
+					*writeResult = CChunkFileReader::SaveFile(op.filename, title, PPSSPP_GIT_VERSION, buffer, data->size());
+				}, [=] {
+					std::string message;
+					Status status;
+					if (*writeResult == CChunkFileReader::ERROR_NONE) {
+						message = slot_prefix + sc->T("Saved State");
+						status = Status::SUCCESS;
+#ifndef MOBILE_DEVICE
+						if (g_Config.bSaveLoadResetsAVdumping) {
+							if (g_Config.bDumpFrames) {
+								AVIDump::Stop();
+								AVIDump::Start(PSP_CoreParameter().renderWidth, PSP_CoreParameter().renderHeight);
+							}
+							if (g_Config.bDumpAudio) {
+								WAVDump::Reset();
+							}
+						}
+#endif
+					} else {
+						message = i18nSaveFailure;
+						status = Status::FAILURE;
+					}
+					if (op.callback)
+						op.callback(status, message, op.cbUserData);
+				});
+				// Called back once written.
+				continue;
+			}
 
 			case SAVESTATE_VERIFY:
 				tempResult = CChunkFileReader::Verify(state) == CChunkFileReader::ERROR_NONE;
@@ -1035,18 +1772,31 @@ namespace SaveState
 			case SAVESTATE_SAVE_SCREENSHOT:
 			{
 				int maxRes = g_Config.iInternalResolution > 2 ? 2 : -1;
-				tempResult = TakeGameScreenshot(op.filename, ScreenshotFormat::JPG, SCREENSHOT_DISPLAY, nullptr, nullptr, maxRes);
-				callbackResult = tempResult ? Status::SUCCESS : Status::FAILURE;
+				auto buf = std::make_shared<GPUDebugBuffer>();
+				u32 w, h;
+				tempResult = CaptureGameScreenshot(*buf, SCREENSHOT_DISPLAY, w, h, maxRes);
 				if (!tempResult) {
 					ERROR_LOG(SAVESTATE, "Failed to take a screenshot for the savestate! %s", op.filename.c_str());
 					if (screenshotFailures++ < SCREENSHOT_FAILURE_RETRIES) {
 						// Requeue for next frame.
 						SaveScreenshot(op.filename, op.callback, op.cbUserData);
 					}
-				} else {
-					screenshotFailures = 0;
+					callbackResult = Status::FAILURE;
+					break;
 				}
-				break;
+				screenshotFailures = 0;
+
+				// The conversion and JPG encode are the slow part.
+				auto saved = std::make_shared<bool>(false);
+				StartAsyncWrite([=] {
+					*saved = SaveGameScreenshot(op.filename, ScreenshotFormat::JPG, *buf, w, h);
+				}, [=] {
+					if (!*saved)
+						ERROR_LOG(SAVESTATE, "Failed to write the screenshot for the savestate! %s", op.filename.c_str());
+					if (op.callback)
+						op.callback(*saved ? Status::SUCCESS : Status::FAILURE, "", op.cbUserData);
+				});
+				continue;
 			}
 			default:
 				ERROR_LOG(SAVESTATE, "Savestate failure: unknown operation type %d", op.type);
@@ -1091,8 +1841,11 @@ namespace SaveState
 
 		std::lock_guard<std::mutex> guard(mutex);
 		rewindStates.Clear();
+		rollbackStates.Clear();
 
 		hasLoadedState = false;
+		bootSnapshotChecked = false;
+		bootSnapshotDone = false;
 		saveStateGeneration = 0;
 		saveDataGeneration = 0;
 		lastSaveDataGeneration = 0;
@@ -1101,7 +1854,11 @@ namespace SaveState
 
 	void Shutdown()
 	{
+		// Let saves in flight finish, so they get renamed into place.
+		FinishPendingWrites(true);
+
 		std::lock_guard<std::mutex> guard(mutex);
 		rewindStates.Clear();
+		rollbackStates.Clear();
 	}
 }
@@ -38,6 +38,7 @@ namespace SaveState
 	static const char *UNDO_SCREENSHOT_EXTENSION = "undo.jpg";
 
 	static const char *LOAD_UNDO_NAME = "load_undo.ppst";
+	static const char *BOOT_SNAPSHOT_EXTENSION = "boot.ppst";
 
 	void Init();
 	void Shutdown();
@@ -65,6 +66,8 @@ namespace SaveState
 	std::string GetSlotDateAsString(const Path &gameFilename, int slot);
 	std::string GenerateFullDiscId(const Path &gameFilename);
 	Path GenerateSaveSlotFilename(const Path &gameFilename, int slot, const char *extension);
+	// Also depends on the version and settings that change what the game sees at boot.
+	Path GenerateBootSnapshotFilename(const Path &gameFilename);
 
 	std::string GetTitle(const Path &filename);
 
@@ -83,10 +86,24 @@ namespace SaveState
 	// Warning: callback will be called on a different thread.
 	void Verify(Callback callback = Callback(), void *cbUserData = 0);
 
+	// Determinism checking: hashes each section of the state every intervalMs of emulated time.
+	// Records the hashes to filename as text, or if compare is set, checks against a recording
+	// made earlier, and reports the first section that differs. Stays active across boots.
+	bool DeterminismCheckBegin(const Path &filename, bool compare, int intervalMs);
+	// Returns false if a difference was found, with details in *message.
+	bool DeterminismCheckEnd(std::string *message);
+
 	// To go back to a previous snapshot (only if enabled.)
 	// Warning: callback will be called on a different thread.
 	void Rewind(Callback callback = Callback(), void *cbUserData = 0);
 
+	// Rollback snapshots of recent frames, for netplay style re-simulation.  Unlike the rest, these are
+	// synchronous and must be called from the emu thread between frames.  Loading a frame drops any
+	// newer ones.  Saving the newest frame again does nothing, and saving an older one starts over.
+	CChunkFileReader::Error RollbackSave(int frame);
+	CChunkFileReader::Error RollbackLoad(int frame, std::string *errorString);
+	void RollbackClear();
+
 	// Returns true if there are rewind snapshots available.
 	bool CanRewind();
 
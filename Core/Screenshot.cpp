@@ -26,6 +26,7 @@
 #include "Common/File/Path.h"
 #include "Common/Log.h"
 #include "Common/System/Display.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Core/Config.h"
 #include "Core/Screenshot.h"
 #include "Core/Core.h"
@@ -253,6 +254,24 @@ const u8 *ConvertBufferToScreenshot(const GPUDebugBuffer &buf, bool alpha, u8 *&
 		bool brswap = (buf.GetFormat() & GPU_DBG_FORMAT_BRSWAP_FLAG) != 0;
 		bool flip = buf.GetFlipped();
 
+		if (baseFmt == GPU_DBG_FORMAT_8888 && !rev && !alpha) {
+			// By far the most common case, readbacks of the output. Just drop the alpha.
+			const int rIndex = brswap ? 2 : 0;
+			const int bIndex = brswap ? 0 : 2;
+			for (u32 y = 0; y < h; y++) {
+				const u32 *src = (const u32 *)buffer + y * buf.GetStride();
+				u8 *dst = &temp[(flip ? h - y - 1 : y) * w * pixelSize];
+				for (u32 x = 0; x < w; x++) {
+					u32 c = src[x];
+					dst[rIndex] = c & 0xFF;
+					dst[1] = (c >> 8) & 0xFF;
+					dst[bIndex] = (c >> 16) & 0xFF;
+					dst += 3;
+				}
+			}
+			return temp;
+		}
+
 		// This is pretty inefficient.
 		for (u32 y = 0; y < h; y++) {
 			for (u32 x = 0; x < w; x++) {
@@ -328,15 +347,14 @@ static GPUDebugBuffer ApplyRotation(const GPUDebugBuffer &buf, DisplayRotation r
 	return rotated;
 }
 
-bool TakeGameScreenshot(const Path &filename, ScreenshotFormat fmt, ScreenshotType type, int *width, int *height, int maxRes) {
+bool CaptureGameScreenshot(GPUDebugBuffer &buf, ScreenshotType type, u32 &w, u32 &h, int maxRes) {
 	if (!gpuDebug) {
 		ERROR_LOG(SYSTEM, "Can't take screenshots when GPU not running");
 		return false;
 	}
-	GPUDebugBuffer buf;
 	bool success = false;
-	u32 w = (u32)-1;
-	u32 h = (u32)-1;
+	w = (u32)-1;
+	h = (u32)-1;
 
 	if (type == SCREENSHOT_DISPLAY || type == SCREENSHOT_RENDER) {
 		success = gpuDebug->GetCurrentFramebuffer(buf, type == SCREENSHOT_RENDER ? GPU_DBG_FRAMEBUF_RENDER : GPU_DBG_FRAMEBUF_DISPLAY, maxRes);
@@ -358,19 +376,20 @@ bool TakeGameScreenshot(const Path &filename, ScreenshotFormat fmt, ScreenshotTy
 		ERROR_LOG(G3D, "Failed to obtain screenshot data.");
 		return false;
 	}
+	return true;
+}
 
+bool SaveGameScreenshot(const Path &filename, ScreenshotFormat fmt, const GPUDebugBuffer &buf, u32 w, u32 h, int *width, int *height) {
 	u8 *flipbuffer = nullptr;
+	const u8 *buffer = ConvertBufferToScreenshot(buf, false, flipbuffer, w, h);
+	bool success = buffer != nullptr;
 	if (success) {
-		const u8 *buffer = ConvertBufferToScreenshot(buf, false, flipbuffer, w, h);
-		success = buffer != nullptr;
-		if (success) {
-			if (width)
-				*width = w;
-			if (height)
-				*height = h;
+		if (width)
+			*width = w;
+		if (height)
+			*height = h;
 
-			success = Save888RGBScreenshot(filename, fmt, buffer, w, h);
-		}
+		success = Save888RGBScreenshot(filename, fmt, buffer, w, h);
 	}
 	delete [] flipbuffer;
 
@@ -380,6 +399,58 @@ bool TakeGameScreenshot(const Path &filename, ScreenshotFormat fmt, ScreenshotTy
 	return success;
 }
 
+bool TakeGameScreenshot(const Path &filename, ScreenshotFormat fmt, ScreenshotType type, int *width, int *height, int maxRes) {
+	GPUDebugBuffer buf;
+	u32 w, h;
+	if (!CaptureGameScreenshot(buf, type, w, h, maxRes))
+		return false;
+	return SaveGameScreenshot(filename, fmt, buf, w, h, width, height);
+}
+
+class ScreenshotSaveTask : public Task {
+public:
+	ScreenshotSaveTask(const Path &filename, ScreenshotFormat fmt, GPUDebugBuffer *buf, u32 w, u32 h, std::function<void(bool)> callback)
+		: filename_(filename), fmt_(fmt), buf_(buf), w_(w), h_(h), callback_(std::move(callback)) {}
+	~ScreenshotSaveTask() {
+		delete buf_;
+	}
+
+	TaskType Type() const override { return TaskType::IO_BLOCKING; }
+	TaskPriority Priority() const override { return TaskPriority::NORMAL; }
+
+	void Run() override {
+		bool success = SaveGameScreenshot(filename_, fmt_, *buf_, w_, h_);
+		if (callback_)
+			callback_(success);
+	}
+
+private:
+	Path filename_;
+	ScreenshotFormat fmt_;
+	GPUDebugBuffer *buf_;
+	u32 w_;
+	u32 h_;
+	std::function<void(bool)> callback_;
+};
+
+bool TakeGameScreenshotAsync(const Path &filename, ScreenshotFormat fmt, ScreenshotType type, std::function<void(bool success)> callback, int maxRes) {
+	GPUDebugBuffer *buf = new GPUDebugBuffer();
+	u32 w, h;
+	if (!CaptureGameScreenshot(*buf, type, w, h, maxRes)) {
+		delete buf;
+		return false;
+	}
+
+	ScreenshotSaveTask *task = new ScreenshotSaveTask(filename, fmt, buf, w, h, std::move(callback));
+	if (g_threadManager.IsInitialized()) {
+		g_threadManager.EnqueueTask(task);
+	} else {
+		task->Run();
+		task->Release();
+	}
+	return true;
+}
+
 bool Save888RGBScreenshot(const Path &filename, ScreenshotFormat fmt, const u8 *bufferRGB888, int w, int h) {
 	if (fmt == ScreenshotFormat::PNG) {
 		png_image png;
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "Common/File/Path.h"
 
 struct GPUDebugBuffer;
@@ -40,6 +42,14 @@ const u8 *ConvertBufferToScreenshot(const GPUDebugBuffer &buf, bool alpha, u8 *&
 // Can only be used while in game.
 bool TakeGameScreenshot(const Path &filename, ScreenshotFormat fmt, ScreenshotType type, int *width = nullptr, int *height = nullptr, int maxRes = -1);
 
+// TakeGameScreenshot in two steps: only the capture needs the GPU, so the save can happen on another thread.
+// Can only be used while in game.
+bool CaptureGameScreenshot(GPUDebugBuffer &buf, ScreenshotType type, u32 &w, u32 &h, int maxRes = -1);
+bool SaveGameScreenshot(const Path &filename, ScreenshotFormat fmt, const GPUDebugBuffer &buf, u32 w, u32 h, int *width = nullptr, int *height = nullptr);
+// Captures right away, then converts and saves on a worker thread. The callback is called on that thread.
+// Returns false (without calling the callback) if the capture failed.
+bool TakeGameScreenshotAsync(const Path &filename, ScreenshotFormat fmt, ScreenshotType type, std::function<void(bool success)> callback, int maxRes = -1);
+
 bool Save888RGBScreenshot(const Path &filename, ScreenshotFormat fmt, const u8 *bufferRGB888, int w, int h);
 bool Save8888RGBAScreenshot(const Path &filename, const u8 *bufferRGBA8888, int w, int h);
 // Overallocate bufferPNG for better encoding speed.
@@ -35,6 +35,7 @@
 #include "Common/System/System.h"
 #include "Common/File/Path.h"
 #include "Common/Math/math_util.h"
+#include "Common/Profiler/PerfMap.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/Data/Encoding/Utf8.h"
 
@@ -55,6 +56,7 @@
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceKernelMemory.h"
 #include "Core/HLE/sceAudio.h"
+#include "Core/HLE/sceDisplay.h"
 #include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -297,6 +299,8 @@ bool CPU_Init(std::string *errorString) {
 	if (!Memory::Init()) {
 		// We're screwed.
 		*errorString = "Memory init failed";
+		if (!Memory::MemoryMap_Error().empty())
+			*errorString += ": " + Memory::MemoryMap_Error();
 		return false;
 	}
 	mipsr4k.Reset();
@@ -339,6 +343,8 @@ PSP_LoadingLock::~PSP_LoadingLock() {
 }
 
 void CPU_Shutdown() {
+	// Nothing can catch the faults of write watched pages anymore.
+	Memory::MemWriteWatch_Reset();
 	UninstallExceptionHandler();
 
 	// Since we load on a background thread, wait for startup to complete.
@@ -431,6 +437,9 @@ bool PSP_InitStart(const CoreParameter &coreParam, std::string *error_string) {
 	pspIsIniting = true;
 	PSP_SetLoading("Loading game...");
 
+	// Before anything gets jitted.
+	PerfMap_SetEnabled(g_Config.bJitPerfMap);
+
 	if (!CPU_Init(&g_CoreParameter.errorString)) {
 		*error_string = g_CoreParameter.errorString;
 		if (error_string->empty()) {
@@ -569,6 +578,8 @@ bool PSP_Reboot(std::string *error_string) {
 }
 
 void PSP_BeginHostFrame() {
+	__DisplayWaitForFrameStart();
+
 	// Reapply the graphics state of the PSP
 	if (gpu) {
 		gpu->BeginHostFrame();
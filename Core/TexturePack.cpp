@@ -0,0 +1,243 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+#if PPSSPP_PLATFORM(WINDOWS)
+#include "Common/CommonWindows.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Core/TexturePack.h"
+
+bool TexturePackFile::Open(const Path &filename) {
+	Close();
+
+	std::lock_guard<std::mutex> guard(lock);
+	void *base = nullptr;
+	size_t size = 0;
+
+#if PPSSPP_PLATFORM(UWP)
+	// No file mappings outside the app folder, stick to textures.zip.
+	return false;
+#elif PPSSPP_PLATFORM(WINDOWS)
+	HANDLE file = CreateFile(filename.ToWString().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize{};
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+		size = (size_t)fileSize.QuadPart;
+		HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) {
+			base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			// The view keeps the mapping alive.
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	int fd = filename.Type() == PathType::CONTENT_URI ? File::OpenFD(filename, File::OPEN_READ) : open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st{};
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		size = (size_t)st.st_size;
+		base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+		if (base == MAP_FAILED)
+			base = nullptr;
+	}
+	close(fd);
+#endif
+
+	if (!base)
+		return false;
+
+	base_ = (const u8 *)base;
+	size_ = size;
+
+	TexturePackHeader header;
+	bool valid = size_ >= sizeof(header);
+	if (valid) {
+		memcpy(&header, base_, sizeof(header));
+		valid = header.magic == TEXTURE_PACK_MAGIC && header.version == TEXTURE_PACK_VERSION;
+	}
+	valid = valid && header.indexOffset <= size_ && (header.indexOffset % alignof(TexturePackEntry)) == 0;
+	valid = valid && (size_ - header.indexOffset) / sizeof(TexturePackEntry) >= header.entryCount;
+	valid = valid && header.iniOffset <= size_ && size_ - header.iniOffset >= header.iniSize;
+	if (!valid) {
+		ERROR_LOG(G3D, "Invalid texture pack: %s", filename.c_str());
+		Unmap();
+		return false;
+	}
+
+	entries_ = (const TexturePackEntry *)(base_ + header.indexOffset);
+	count_ = header.entryCount;
+	INFO_LOG(G3D, "Opened texture pack with %d entries: %s", count_, filename.c_str());
+	return true;
+}
+
+void TexturePackFile::Close() {
+	std::lock_guard<std::mutex> guard(lock);
+	Unmap();
+}
+
+void TexturePackFile::Unmap() {
+	if (!base_)
+		return;
+
+#if PPSSPP_PLATFORM(WINDOWS)
+	UnmapViewOfFile(base_);
+#else
+	munmap((void *)base_, size_);
+#endif
+	base_ = nullptr;
+	size_ = 0;
+	entries_ = nullptr;
+	count_ = 0;
+}
+
+static bool EntryLess(const TexturePackEntry &a, u64 cachekey, u32 hash, u32 level) {
+	if (a.cachekey != cachekey)
+		return a.cachekey < cachekey;
+	if (a.hash != hash)
+		return a.hash < hash;
+	return a.level < level;
+}
+
+const TexturePackEntry *TexturePackFile::Find(u64 cachekey, u32 hash, u32 level) const {
+	if (!entries_)
+		return nullptr;
+
+	const TexturePackEntry *last = entries_ + count_;
+	const TexturePackEntry *it = std::lower_bound(entries_, last, 0, [&](const TexturePackEntry &e, int) {
+		return EntryLess(e, cachekey, hash, level);
+	});
+	if (it == last || it->cachekey != cachekey || it->hash != hash || it->level != level)
+		return nullptr;
+	// Don't trust the file to stay within bounds.
+	if (it->offset > size_ || size_ - it->offset < it->size)
+		return nullptr;
+	return it;
+}
+
+std::string TexturePackFile::GetIni() const {
+	if (!base_)
+		return "";
+	TexturePackHeader header;
+	memcpy(&header, base_, sizeof(header));
+	return std::string((const char *)base_ + header.iniOffset, (size_t)header.iniSize);
+}
+
+// We track the position ourselves, ftell() is only 32-bit on some platforms.
+static bool WritePadding(FILE *fp, u64 &pos, u64 alignment) {
+	static const u8 zeros[TEXTURE_PACK_ALIGNMENT]{};
+	u64 padding = (alignment - (pos % alignment)) % alignment;
+	pos += padding;
+	return padding == 0 || fwrite(zeros, 1, (size_t)padding, fp) == padding;
+}
+
+bool WriteTexturePack(const Path &filename, const std::string &ini, std::vector<TexturePackSource> sources) {
+	// Stable, so the first source for a key wins.
+	std::stable_sort(sources.begin(), sources.end(), [](const TexturePackSource &a, const TexturePackSource &b) {
+		if (a.cachekey != b.cachekey)
+			return a.cachekey < b.cachekey;
+		if (a.hash != b.hash)
+			return a.hash < b.hash;
+		return a.level < b.level;
+	});
+
+	FILE *fp = File::OpenCFile(filename, "wb");
+	if (!fp) {
+		ERROR_LOG(G3D, "Unable to open texture pack for writing: %s", filename.c_str());
+		return false;
+	}
+
+	TexturePackHeader header{};
+	header.magic = TEXTURE_PACK_MAGIC;
+	header.version = TEXTURE_PACK_VERSION;
+	bool good = fwrite(&header, sizeof(header), 1, fp) == 1;
+
+	header.iniOffset = sizeof(header);
+	header.iniSize = ini.size();
+	good = good && fwrite(ini.data(), 1, ini.size(), fp) == ini.size();
+	u64 pos = header.iniOffset + header.iniSize;
+
+	std::vector<TexturePackEntry> entries;
+	entries.reserve(sources.size());
+	std::map<Path, std::pair<u64, u64>> written;
+	for (const TexturePackSource &source : sources) {
+		if (!good)
+			break;
+		if (!entries.empty()) {
+			const TexturePackEntry &prev = entries.back();
+			if (prev.cachekey == source.cachekey && prev.hash == source.hash && prev.level == source.level)
+				continue;
+		}
+
+		TexturePackEntry entry{ source.cachekey, source.hash, source.level, 0, 0 };
+		if (!source.file.empty()) {
+			auto it = written.find(source.file);
+			if (it != written.end()) {
+				entry.offset = it->second.first;
+				entry.size = it->second.second;
+			} else {
+				std::string data;
+				if (!File::ReadFileToString(false, source.file, data)) {
+					WARN_LOG(G3D, "Skipping missing texture for pack: %s", source.file.c_str());
+					continue;
+				}
+				good = WritePadding(fp, pos, TEXTURE_PACK_ALIGNMENT);
+				entry.offset = pos;
+				entry.size = data.size();
+				good = good && fwrite(data.data(), 1, data.size(), fp) == data.size();
+				pos += data.size();
+				written[source.file] = std::make_pair(entry.offset, entry.size);
+			}
+		}
+		entries.push_back(entry);
+	}
+
+	good = good && WritePadding(fp, pos, alignof(TexturePackEntry));
+	header.indexOffset = pos;
+	header.entryCount = (u32)entries.size();
+	if (good && !entries.empty())
+		good = fwrite(entries.data(), sizeof(TexturePackEntry), entries.size(), fp) == entries.size();
+
+	// Now that we know where everything went.
+	good = good && fseek(fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1;
+	fclose(fp);
+
+	if (!good) {
+		ERROR_LOG(G3D, "Failed to write texture pack: %s", filename.c_str());
+		File::Delete(filename);
+		return false;
+	}
+
+	INFO_LOG(G3D, "Wrote texture pack with %d entries (%d files): %s", (int)entries.size(), (int)written.size(), filename.c_str());
+	return true;
+}
@@ -0,0 +1,116 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
+
+// textures.pack is a read-only alternative to textures.zip, generated from a texture folder.
+// The file is memory mapped, and looked up through a sorted index directly in the mapping,
+// so opening even a huge pack costs nothing up front.  Everything is little endian.
+//
+// Layout: header, textures.ini (without [hashes]), payloads (each page aligned), index.
+// Payloads are the original PNG/ZIM/DDS/KTX2 files, unmodified.
+
+static const u32 TEXTURE_PACK_MAGIC = 0x50545050;  // "PPTP"
+static const u32 TEXTURE_PACK_VERSION = 1;
+static const u32 TEXTURE_PACK_ALIGNMENT = 4096;
+
+struct TexturePackHeader {
+	u32 magic;
+	u32 version;
+	u32 entryCount;
+	u32 reserved;
+	u64 indexOffset;
+	u64 iniOffset;
+	u64 iniSize;
+};
+
+// Sorted by cachekey, then hash, then level.  Keys can have zeroed parts, just like [hashes].
+struct TexturePackEntry {
+	u64 cachekey;
+	u32 hash;
+	u32 level;
+	// A size of zero means the texture is explicitly ignored.
+	u64 offset;
+	u64 size;
+};
+
+static_assert(sizeof(TexturePackHeader) == 40, "TexturePackHeader is part of the file format");
+static_assert(sizeof(TexturePackEntry) == 32, "TexturePackEntry is part of the file format");
+
+class TexturePackFile {
+public:
+	~TexturePackFile() {
+		Close();
+	}
+
+	bool Open(const Path &filename);
+	void Close();
+
+	bool IsOpen() const {
+		return base_ != nullptr;
+	}
+
+	// Exact key match.  No allocations, this is a binary search in the mapped index.
+	const TexturePackEntry *Find(u64 cachekey, u32 hash, u32 level) const;
+	// Returns nullptr if the range isn't inside the file (or the pack was closed.)
+	const u8 *GetData(u64 offset, u64 size) const {
+		if (!base_ || offset > size_ || size_ - offset < size)
+			return nullptr;
+		return base_ + offset;
+	}
+	std::string GetIni() const;
+
+	// Lets the wildcard lookups treat this like a map of alias keys.
+	template <typename Key>
+	const TexturePackEntry *find(const Key &key) const {
+		return Find(key.cachekey, key.hash, key.level);
+	}
+	const TexturePackEntry *end() const {
+		return nullptr;
+	}
+
+	// Held while reading from the mapping, so we can't unmap under a loading thread.
+	std::mutex lock;
+
+private:
+	void Unmap();
+
+	const u8 *base_ = nullptr;
+	size_t size_ = 0;
+	const TexturePackEntry *entries_ = nullptr;
+	u32 count_ = 0;
+};
+
+struct TexturePackSource {
+	u64 cachekey;
+	u32 hash;
+	u32 level;
+	// Empty for ignored textures.
+	Path file;
+};
+
+// Builds a pack.  If several sources use the same key, the first one wins.
+// Sources using the same file share one payload.
+bool WriteTexturePack(const Path &filename, const std::string &ini, std::vector<TexturePackSource> sources);
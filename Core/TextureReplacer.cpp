@@ -34,9 +34,11 @@
 #include "Common/Data/Format/ZIMLoad.h"
 #include "Common/Data/Text/I18n.h"
 #include "Common/Data/Text/Parsers.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
 #include "Common/File/VFS/VFS.h"
 #include "Common/LogReporting.h"
+#include "Common/Profiler/MemoryUsage.h"
 #include "Common/StringUtils.h"
 #include "Common/Thread/ParallelLoop.h"
 #include "Common/Thread/Waitable.h"
@@ -52,10 +54,23 @@
 
 static const std::string INI_FILENAME = "textures.ini";
 static const std::string ZIP_FILENAME = "textures.zip";
+static const std::string PACK_FILENAME = "textures.pack";
 static const std::string NEW_TEXTURE_DIR = "new/";
 static const int VERSION = 1;
 static const int MAX_MIP_LEVELS = 12;  // 12 should be plenty, 8 is the max mip levels supported by the PSP.
 static const double MAX_CACHE_SIZE = 4.0;
+// How far ahead in the recorded order to look when a replacement is needed.
+static const size_t PREFETCH_LOOKAHEAD = 16;
+static const size_t MAX_PREFETCH_ENTRIES = 16384;
+static const u32 PREFETCH_MAGIC = 0x46505254;  // "TRPF"
+static const u32 PREFETCH_VERSION = 1;
+
+struct ReplacementPrefetchHeader {
+	u32 magic;
+	u32 version;
+	u32 count;
+	u32 reserved;
+};
 
 TextureReplacer::TextureReplacer() {
 	none_.initDone_ = true;
@@ -72,7 +87,9 @@ void ReplacerZipInfo::Close() {
 }
 
 TextureReplacer::~TextureReplacer() {
+	SavePrefetchOrder();
 	zip_.Close();
+	pack_.Close();
 }
 
 void TextureReplacer::Init() {
@@ -80,6 +97,8 @@ void TextureReplacer::Init() {
 }
 
 void TextureReplacer::NotifyConfigChanged() {
+	// Might be switching games, so save what we have for the previous one.
+	SavePrefetchOrder();
 	gameID_ = g_paramSFO.GetDiscID();
 
 	bool wasEnabled = enabled_;
@@ -98,12 +117,123 @@ void TextureReplacer::NotifyConfigChanged() {
 		enabled_ = File::IsDirectory(basePath_);
 	} else if (wasEnabled) {
 		zip_.Close();
+		pack_.Close();
 		Decimate(ReplacerDecimateMode::ALL);
 	}
 
 	if (enabled_) {
 		enabled_ = LoadIni();
 	}
+	if (enabled_) {
+		LoadPrefetchOrder();
+	}
+}
+
+void TextureReplacer::LoadPrefetchOrder() {
+	prefetchOrder_.clear();
+	prefetchIndex_.clear();
+	accessOrder_.clear();
+	if (gameID_.empty())
+		return;
+
+	File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+	prefetchPath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (gameID_ + ".texprefetch");
+
+	FILE *f = File::OpenCFile(prefetchPath_, "rb");
+	if (!f)
+		return;
+
+	ReplacementPrefetchHeader header;
+	bool valid = fread(&header, sizeof(header), 1, f) == 1;
+	valid = valid && header.magic == PREFETCH_MAGIC && header.version == PREFETCH_VERSION && header.count <= MAX_PREFETCH_ENTRIES;
+	if (valid) {
+		prefetchOrder_.resize(header.count);
+		if (header.count != 0 && fread(&prefetchOrder_[0], sizeof(ReplacementPrefetchEntry), header.count, f) != header.count)
+			prefetchOrder_.clear();
+	}
+	fclose(f);
+
+	for (size_t i = 0; i < prefetchOrder_.size(); ++i) {
+		ReplacementCacheKey key(prefetchOrder_[i].cachekey, prefetchOrder_[i].hash);
+		prefetchIndex_.emplace(key, i);
+	}
+	INFO_LOG(G3D, "Loaded %d texture replacements to prefetch", (int)prefetchOrder_.size());
+}
+
+void TextureReplacer::SavePrefetchOrder() {
+	if (prefetchPath_.empty() || accessOrder_.empty())
+		return;
+
+	// This run's order goes first, then anything from before we didn't get to this time.
+	std::vector<ReplacementPrefetchEntry> order;
+	std::unordered_map<ReplacementCacheKey, bool> seen;
+	for (const auto &entry : accessOrder_) {
+		ReplacementCacheKey key(entry.cachekey, entry.hash);
+		auto it = cache_.find(key);
+		// Skip anything without a replacement.
+		if (it != cache_.end() && it->second.prepareDone_ && it->second.levels_.empty())
+			continue;
+		if (seen.emplace(key, true).second)
+			order.push_back(entry);
+	}
+	for (const auto &entry : prefetchOrder_) {
+		if (order.size() >= MAX_PREFETCH_ENTRIES)
+			break;
+		if (seen.emplace(ReplacementCacheKey(entry.cachekey, entry.hash), true).second)
+			order.push_back(entry);
+	}
+	if (order.size() > MAX_PREFETCH_ENTRIES)
+		order.resize(MAX_PREFETCH_ENTRIES);
+	accessOrder_.clear();
+
+	FILE *f = File::OpenCFile(prefetchPath_, "wb");
+	if (!f)
+		return;
+
+	ReplacementPrefetchHeader header{ PREFETCH_MAGIC, PREFETCH_VERSION, (u32)order.size(), 0 };
+	bool writeFailed = fwrite(&header, sizeof(header), 1, f) != 1;
+	if (!order.empty())
+		writeFailed = writeFailed || fwrite(&order[0], sizeof(ReplacementPrefetchEntry), order.size(), f) != order.size();
+	fclose(f);
+
+	if (writeFailed) {
+		ERROR_LOG(G3D, "Failed to write texture prefetch order, disk full?");
+		File::Delete(prefetchPath_);
+	}
+}
+
+void TextureReplacer::RecordAccess(const ReplacementCacheKey &key, int w, int h) {
+	if (accessOrder_.size() < MAX_PREFETCH_ENTRIES)
+		accessOrder_.push_back(ReplacementPrefetchEntry{ key.cachekey, key.hash, (u16)w, (u16)h });
+}
+
+void TextureReplacer::PrefetchAfter(const ReplacementCacheKey &key) {
+	// Without threaded loading, prefetching would just stall now instead of later.
+	if (g_Config.iReplacementPrefetchMB <= 0 || !g_Config.bReplaceTexturesAllowLate)
+		return;
+	auto pos = prefetchIndex_.find(key);
+	if (pos == prefetchIndex_.end())
+		return;
+
+	const size_t budget = (size_t)g_Config.iReplacementPrefetchMB * 1024 * 1024;
+	const size_t last = std::min(prefetchOrder_.size(), pos->second + 1 + PREFETCH_LOOKAHEAD);
+	for (size_t i = pos->second + 1; i < last && prefetchedBytes_ < budget; ++i) {
+		const ReplacementPrefetchEntry &entry = prefetchOrder_[i];
+		ReplacementCacheKey nextKey(entry.cachekey, entry.hash);
+		if (cache_.find(nextKey) != cache_.end())
+			continue;
+
+		// This only reads headers, the data is loaded on a thread.
+		ReplacedTexture &next = cache_[nextKey];
+		PopulateReplacement(&next, entry.cachekey, entry.hash, entry.w, entry.h);
+		if (next.levels_.empty())
+			continue;
+
+		size_t size = next.EstimatedSize();
+		next.Prefetch();
+		prefetched_[nextKey] = size;
+		prefetchedBytes_ += size;
+	}
 }
 
 static struct zip *ZipOpenPath(Path fileName) {
@@ -160,12 +290,19 @@ bool TextureReplacer::LoadIni() {
 	ignoreMipmap_ = false;
 
 	zip_.Close();
+	pack_.Close();
 
 	IniFile ini;
 	bool iniLoaded = false;
 
-	// First, check for textures.zip, which is used to reduce IO.
-	zip *z = ZipOpenPath(basePath_ / ZIP_FILENAME);
+	// A textures.pack (see GeneratePack) replaces everything else, and carries its own ini.
+	if (pack_.Open(basePath_ / PACK_FILENAME)) {
+		std::stringstream sstream(pack_.GetIni());
+		iniLoaded = ini.Load(sstream);
+	}
+
+	// Otherwise, check for textures.zip, which is used to reduce IO.
+	zip *z = iniLoaded ? nullptr : ZipOpenPath(basePath_ / ZIP_FILENAME);
 	if (z) {
 		iniLoaded = LoadIniZip(ini, z, INI_FILENAME);
 		// Require the zip have textures.ini to use it.
@@ -475,6 +612,14 @@ ReplacedTexture &TextureReplacer::FindReplacement(u64 cachekey, u32 hash, int w,
 			// We don't do this on a thread, but we only do it while within budget.
 			PopulateReplacement(&it->second, cachekey, hash, w, h);
 		}
+		auto prefetched = prefetched_.find(replacementKey);
+		if (prefetched != prefetched_.end()) {
+			// A correct guess.  This counts as the first use.
+			prefetchedBytes_ -= prefetched->second;
+			prefetched_.erase(prefetched);
+			RecordAccess(replacementKey, w, h);
+			PrefetchAfter(replacementKey);
+		}
 		return it->second;
 	}
 
@@ -483,9 +628,57 @@ ReplacedTexture &TextureReplacer::FindReplacement(u64 cachekey, u32 hash, int w,
 	if (!g_Config.bReplaceTexturesAllowLate || budget > 0.0) {
 		PopulateReplacement(&result, cachekey, hash, w, h);
 	}
+	RecordAccess(replacementKey, w, h);
+	PrefetchAfter(replacementKey);
 	return result;
 }
 
+// Works with the alias/filtering maps, and TexturePackFile.
+template <typename Map, typename Key>
+static auto LookupWildcard(const Map &map, Key &key, u64 cachekey, u32 hash, bool ignoreAddress) -> decltype(map.find(key)) {
+	auto alias = map.find(key);
+	if (alias != map.end())
+		return alias;
+
+	// Also check for a few more aliases with zeroed portions:
+	// Only clut hash (very dangerous in theory, in practice not more than missing "just" data hash)
+	key.cachekey = cachekey & 0xFFFFFFFFULL;
+	key.hash = 0;
+	alias = map.find(key);
+	if (alias != map.end())
+		return alias;
+
+	if (!ignoreAddress) {
+		// No data hash.
+		key.cachekey = cachekey;
+		key.hash = 0;
+		alias = map.find(key);
+		if (alias != map.end())
+			return alias;
+	}
+
+	// No address.
+	key.cachekey = cachekey & 0xFFFFFFFFULL;
+	key.hash = hash;
+	alias = map.find(key);
+	if (alias != map.end())
+		return alias;
+
+	if (!ignoreAddress) {
+		// Address, but not clut hash (in case of garbage clut data.)
+		key.cachekey = cachekey & ~0xFFFFFFFFULL;
+		key.hash = hash;
+		alias = map.find(key);
+		if (alias != map.end())
+			return alias;
+	}
+
+	// Anything with this data hash (a little dangerous.)
+	key.cachekey = 0;
+	key.hash = hash;
+	return map.find(key);
+}
+
 void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h) {
 	int newW = w;
 	int newH = h;
@@ -496,9 +689,27 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 	}
 
 	for (int i = 0; i < MAX_MIP_LEVELS; ++i) {
-		const std::string hashfile = LookupHashFile(cachekey, hash, i);
-		const Path filename = basePath_ / hashfile;
-		if (hashfile.empty()) {
+		std::string hashfile;
+		const TexturePackEntry *packEntry = nullptr;
+		if (pack_.IsOpen()) {
+			// Aliases can only come from override inis here, and those point to loose files.
+			ReplacementAliasKey key(cachekey, hash, i);
+			auto alias = LookupWildcard(aliases_, key, cachekey, hash, ignoreAddress_);
+			if (alias != aliases_.end()) {
+				hashfile = alias->second;
+			} else {
+				key = ReplacementAliasKey(cachekey, hash, i);
+				packEntry = LookupWildcard(pack_, key, cachekey, hash, ignoreAddress_);
+				// The pack includes all files, so if it's not there (or ignored), we're out of mips.
+				if (!packEntry || packEntry->size == 0)
+					break;
+			}
+		} else {
+			hashfile = LookupHashFile(cachekey, hash, i);
+		}
+
+		const Path filename = packEntry ? basePath_ / PACK_FILENAME : basePath_ / hashfile;
+		if (!packEntry && hashfile.empty()) {
 			// Out of valid mip levels.  Bail out.
 			break;
 		}
@@ -508,15 +719,28 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 		level.file = filename;
 
 		bool good;
+		int fileLevels = 1;
 		bool logError = hashfile != HashName(cachekey, hash, i) + ".png";
-		if (zip_.z) {
+		if (packEntry) {
+			level.pack = &pack_;
+			level.packOffset = packEntry->offset;
+			level.packSize = packEntry->size;
+			good = PopulateLevelFromPack(level, &fileLevels);
+		} else if (zip_.z) {
 			level.zinfo = &zip_;
 
 			std::lock_guard<std::mutex> guard(zip_.lock);
 			level.zi = zip_name_locate(zip_.z, hashfile.c_str(), ZIP_FL_NOCASE);
-			good = PopulateLevelFromZip(level, !logError);
+			good = PopulateLevelFromZip(level, !logError, &fileLevels);
 		} else {
-			good = PopulateLevelFromPath(level, !logError);
+			good = PopulateLevelFromPath(level, !logError, &fileLevels);
+		}
+
+		const bool compressed = Draw::DataFormatIsBlockCompressed(level.fmt, nullptr);
+		if (good && compressed && (newW != w || newH != h)) {
+			// We can't pad compressed data, so these can't be used with hashranges.
+			WARN_LOG(G3D, "Compressed replacement can't be used with a hashrange: '%s'", filename.c_str());
+			good = false;
 		}
 
 		// We pad files that have been hashrange'd so they are the same texture size.
@@ -528,6 +752,9 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 			if (level.w != (result->levels_[0].w >> i) || level.h != (result->levels_[0].h >> i)) {
 				 WARN_LOG(G3D, "Replacement mipmap invalid: size=%dx%d, expected=%dx%d (level %d, '%s')", level.w, level.h, result->levels_[0].w >> i, result->levels_[0].h >> i, i, filename.c_str());
 				 good = false;
+			} else if (level.fmt != result->levels_[0].fmt) {
+				WARN_LOG(G3D, "Replacement mipmap format doesn't match level 0 (level %d, '%s')", i, filename.c_str());
+				good = false;
 			}
 		}
 
@@ -536,6 +763,18 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 		// Otherwise, we're done loading mips (bad PNG or bad size, either way.)
 		else
 			break;
+
+		if (compressed && i == 0) {
+			// The file has its own mip chain (or none), so we don't look for separate mip files.
+			for (int j = 1; j < fileLevels; ++j) {
+				ReplacedTextureLevel mip = level;
+				mip.fileLevel = j;
+				mip.w = std::max(1, level.w >> j);
+				mip.h = std::max(1, level.h >> j);
+				result->levels_.push_back(mip);
+			}
+			break;
+		}
 	}
 
 	// Populate the level data pointers for each level.
@@ -550,6 +789,8 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 enum class ReplacedImageType {
 	PNG,
 	ZIM,
+	DDS,
+	KTX2,
 	INVALID,
 };
 
@@ -558,9 +799,159 @@ static ReplacedImageType Identify(const uint8_t magic[4]) {
 		return ReplacedImageType::ZIM;
 	if (magic[0] == 0x89 && strncmp((const char *)&magic[1], "PNG", 3) == 0)
 		return ReplacedImageType::PNG;
+	if (strncmp((const char *)magic, "DDS ", 4) == 0)
+		return ReplacedImageType::DDS;
+	// The full 12 byte identifier is checked when parsing the header.
+	if (magic[0] == 0xAB && strncmp((const char *)&magic[1], "KTX", 3) == 0)
+		return ReplacedImageType::KTX2;
 	return ReplacedImageType::INVALID;
 }
 
+static bool IsCompressedImageType(ReplacedImageType type) {
+	return type == ReplacedImageType::DDS || type == ReplacedImageType::KTX2;
+}
+
+// DDS and KTX2 files hold pre-compressed data that we upload as is, including all mips.
+struct CompressedImageHeader {
+	Draw::DataFormat fmt = Draw::DataFormat::UNDEFINED;
+	int w = 0;
+	int h = 0;
+	int levels = 0;
+	uint64_t levelOffset[MAX_MIP_LEVELS]{};
+	uint64_t levelSize[MAX_MIP_LEVELS]{};
+};
+
+// Enough for a KTX2 level index with MAX_MIP_LEVELS entries, and more than enough for DDS.
+static const size_t COMPRESSED_HEADER_SIZE = 80 + 24 * MAX_MIP_LEVELS;
+
+static uint32_t ReadHeaderU32(const uint8_t *data, size_t offset) {
+	uint32_t value;
+	memcpy(&value, data + offset, sizeof(value));
+	return value;
+}
+
+static uint64_t ReadHeaderU64(const uint8_t *data, size_t offset) {
+	uint64_t value;
+	memcpy(&value, data + offset, sizeof(value));
+	return value;
+}
+
+static uint64_t CompressedLevelSize(Draw::DataFormat fmt, int w, int h) {
+	int blockSize = 0;
+	if (!Draw::DataFormatIsBlockCompressed(fmt, &blockSize))
+		return 0;
+	return (uint64_t)((w + 3) / 4) * (uint64_t)((h + 3) / 4) * blockSize;
+}
+
+static bool ParseDDSHeader(const uint8_t *data, size_t size, CompressedImageHeader *header) {
+	// Magic, then the 124 byte DDS_HEADER.
+	size_t dataOffset = 4 + 124;
+	if (size < dataOffset || ReadHeaderU32(data, 4) != 124)
+		return false;
+
+	header->h = ReadHeaderU32(data, 4 + 8);
+	header->w = ReadHeaderU32(data, 4 + 12);
+	header->levels = std::max(1, (int)ReadHeaderU32(data, 4 + 24));
+
+	const uint32_t fourCC = ReadHeaderU32(data, 4 + 80);
+	auto makeFourCC = [](const char *s) {
+		return (uint32_t)s[0] | ((uint32_t)s[1] << 8) | ((uint32_t)s[2] << 16) | ((uint32_t)s[3] << 24);
+	};
+	if (fourCC == makeFourCC("DXT1")) {
+		header->fmt = Draw::DataFormat::BC1_RGBA_UNORM_BLOCK;
+	} else if (fourCC == makeFourCC("DXT3")) {
+		header->fmt = Draw::DataFormat::BC2_UNORM_BLOCK;
+	} else if (fourCC == makeFourCC("DXT5")) {
+		header->fmt = Draw::DataFormat::BC3_UNORM_BLOCK;
+	} else if (fourCC == makeFourCC("DX10")) {
+		// DDS_HEADER_DXT10 follows, we only need dxgiFormat.
+		if (size < dataOffset + 20)
+			return false;
+		switch (ReadHeaderU32(data, dataOffset)) {
+		case 71: header->fmt = Draw::DataFormat::BC1_RGBA_UNORM_BLOCK; break;
+		case 74: header->fmt = Draw::DataFormat::BC2_UNORM_BLOCK; break;
+		case 77: header->fmt = Draw::DataFormat::BC3_UNORM_BLOCK; break;
+		case 98: header->fmt = Draw::DataFormat::BC7_UNORM_BLOCK; break;
+		default: return false;
+		}
+		dataOffset += 20;
+	} else {
+		return false;
+	}
+
+	// Levels are stored back to back.
+	header->levels = std::min(header->levels, MAX_MIP_LEVELS);
+	uint64_t offset = dataOffset;
+	for (int i = 0; i < header->levels; ++i) {
+		header->levelOffset[i] = offset;
+		header->levelSize[i] = CompressedLevelSize(header->fmt, std::max(1, header->w >> i), std::max(1, header->h >> i));
+		offset += header->levelSize[i];
+	}
+	return true;
+}
+
+static bool ParseKTX2Header(const uint8_t *data, size_t size, CompressedImageHeader *header) {
+	static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	if (size < 80 || memcmp(data, identifier, sizeof(identifier)) != 0)
+		return false;
+
+	switch (ReadHeaderU32(data, 12)) {
+	case 133: header->fmt = Draw::DataFormat::BC1_RGBA_UNORM_BLOCK; break;
+	case 135: header->fmt = Draw::DataFormat::BC2_UNORM_BLOCK; break;
+	case 137: header->fmt = Draw::DataFormat::BC3_UNORM_BLOCK; break;
+	case 145: header->fmt = Draw::DataFormat::BC7_UNORM_BLOCK; break;
+	case 147: header->fmt = Draw::DataFormat::ETC2_R8G8B8_UNORM_BLOCK; break;
+	case 151: header->fmt = Draw::DataFormat::ETC2_R8G8B8A8_UNORM_BLOCK; break;
+	case 157: header->fmt = Draw::DataFormat::ASTC_4x4_UNORM_BLOCK; break;
+	default:
+		// Includes VK_FORMAT_UNDEFINED, which is what Basis Universal files use.
+		return false;
+	}
+
+	header->w = ReadHeaderU32(data, 20);
+	header->h = ReadHeaderU32(data, 24);
+	const uint32_t depth = ReadHeaderU32(data, 28);
+	const uint32_t layers = ReadHeaderU32(data, 32);
+	const uint32_t faces = ReadHeaderU32(data, 36);
+	const uint32_t supercompression = ReadHeaderU32(data, 44);
+	if (depth > 1 || layers > 1 || faces != 1 || supercompression != 0)
+		return false;
+
+	header->levels = std::min(std::max(1, (int)ReadHeaderU32(data, 40)), MAX_MIP_LEVELS);
+	if (size < 80 + 24 * (size_t)header->levels)
+		return false;
+	for (int i = 0; i < header->levels; ++i) {
+		header->levelOffset[i] = ReadHeaderU64(data, 80 + 24 * i);
+		header->levelSize[i] = CompressedLevelSize(header->fmt, std::max(1, header->w >> i), std::max(1, header->h >> i));
+		if (ReadHeaderU64(data, 80 + 24 * i + 8) < header->levelSize[i])
+			return false;
+	}
+	return true;
+}
+
+static bool ParseCompressedHeader(ReplacedImageType type, const uint8_t *data, size_t size, CompressedImageHeader *header) {
+	bool good = false;
+	if (type == ReplacedImageType::DDS)
+		good = ParseDDSHeader(data, size, header);
+	else if (type == ReplacedImageType::KTX2)
+		good = ParseKTX2Header(data, size, header);
+	return good && header->w > 0 && header->h > 0;
+}
+
+static bool ReadCompressedHeader(ReplacedImageType type, FILE *fp, CompressedImageHeader *header) {
+	uint8_t data[COMPRESSED_HEADER_SIZE];
+	fseek(fp, 0, SEEK_SET);
+	size_t size = fread(data, 1, sizeof(data), fp);
+	return ParseCompressedHeader(type, data, size, header);
+}
+
+static bool ReadCompressedHeader(ReplacedImageType type, zip_file_t *zf, CompressedImageHeader *header) {
+	// Must be a freshly opened file, we can't seek.
+	uint8_t data[COMPRESSED_HEADER_SIZE];
+	zip_int64_t size = zip_fread(zf, data, sizeof(data));
+	return size > 0 && ParseCompressedHeader(type, data, (size_t)size, header);
+}
+
 static ReplacedImageType Identify(FILE *fp) {
 	uint8_t magic[4];
 	if (fread(magic, 1, 4, fp) != 4)
@@ -578,8 +969,9 @@ static ReplacedImageType Identify(zip_file_t *zf) {
 	return Identify(magic);
 }
 
-bool TextureReplacer::PopulateLevelFromPath(ReplacedTextureLevel &level, bool ignoreError) {
+bool TextureReplacer::PopulateLevelFromPath(ReplacedTextureLevel &level, bool ignoreError, int *fileLevels) {
 	bool good = false;
+	*fileLevels = 1;
 
 	FILE *fp = File::OpenCFile(level.file, "rb");
 	if (!fp) {
@@ -609,6 +1001,17 @@ bool TextureReplacer::PopulateLevelFromPath(ReplacedTextureLevel &level, bool ig
 			ERROR_LOG(G3D, "Could not load texture replacement info: %s - %s", level.file.ToVisualString().c_str(), png.message);
 		}
 		png_image_free(&png);
+	} else if (IsCompressedImageType(imageType)) {
+		CompressedImageHeader header;
+		if (ReadCompressedHeader(imageType, fp, &header)) {
+			level.w = header.w;
+			level.h = header.h;
+			level.fmt = header.fmt;
+			*fileLevels = header.levels;
+			good = true;
+		} else {
+			ERROR_LOG(G3D, "Could not load texture replacement info: %s - unsupported compressed format", level.file.ToVisualString().c_str());
+		}
 	} else {
 		ERROR_LOG(G3D, "Could not load texture replacement info: %s - unsupported format", level.file.ToVisualString().c_str());
 	}
@@ -617,8 +1020,9 @@ bool TextureReplacer::PopulateLevelFromPath(ReplacedTextureLevel &level, bool ig
 	return good;
 }
 
-bool TextureReplacer::PopulateLevelFromZip(ReplacedTextureLevel &level, bool ignoreError) {
+bool TextureReplacer::PopulateLevelFromZip(ReplacedTextureLevel &level, bool ignoreError, int *fileLevels) {
 	bool good = false;
+	*fileLevels = 1;
 
 	// Everything in here is within a lock, so we don't need to relock.
 	if (!level.zinfo || !level.zinfo->z || level.zi < 0) {
@@ -666,6 +1070,17 @@ bool TextureReplacer::PopulateLevelFromZip(ReplacedTextureLevel &level, bool ign
 			ERROR_LOG(G3D, "Could not load texture replacement info: %s - %s (zip)", level.file.ToVisualString().c_str(), png.message);
 		}
 		png_image_free(&png);
+	} else if (IsCompressedImageType(imageType)) {
+		CompressedImageHeader header;
+		if (ReadCompressedHeader(imageType, zf, &header)) {
+			level.w = header.w;
+			level.h = header.h;
+			level.fmt = header.fmt;
+			*fileLevels = header.levels;
+			good = true;
+		} else {
+			ERROR_LOG(G3D, "Could not load texture replacement info: %s - unsupported compressed format (zip)", level.file.ToVisualString().c_str());
+		}
 	} else {
 		ERROR_LOG(G3D, "Could not load texture replacement info: %s - unsupported format (zip)", level.file.ToVisualString().c_str());
 	}
@@ -674,6 +1089,52 @@ bool TextureReplacer::PopulateLevelFromZip(ReplacedTextureLevel &level, bool ign
 	return good;
 }
 
+bool TextureReplacer::PopulateLevelFromPack(ReplacedTextureLevel &level, int *fileLevels) {
+	bool good = false;
+	*fileLevels = 1;
+
+	std::lock_guard<std::mutex> guard(level.pack->lock);
+	const uint8_t *data = level.pack->GetData(level.packOffset, level.packSize);
+	if (!data || level.packSize < 16)
+		return false;
+	const size_t size = (size_t)level.packSize;
+
+	auto imageType = Identify(data);
+	if (imageType == ReplacedImageType::ZIM) {
+		int flags;
+		memcpy(&level.w, data + 4, 4);
+		memcpy(&level.h, data + 8, 4);
+		memcpy(&flags, data + 12, 4);
+		good = (flags & ZIM_FORMAT_MASK) == ZIM_RGBA8888;
+	} else if (imageType == ReplacedImageType::PNG) {
+		png_image png = {};
+		png.version = PNG_IMAGE_VERSION;
+		if (png_image_begin_read_from_memory(&png, data, size)) {
+			level.w = png.width;
+			level.h = png.height;
+			good = true;
+		} else {
+			ERROR_LOG(G3D, "Could not load texture replacement info: %s - %s (pack)", level.file.ToVisualString().c_str(), png.message);
+		}
+		png_image_free(&png);
+	} else if (IsCompressedImageType(imageType)) {
+		CompressedImageHeader header;
+		if (ParseCompressedHeader(imageType, data, size, &header)) {
+			level.w = header.w;
+			level.h = header.h;
+			level.fmt = header.fmt;
+			*fileLevels = header.levels;
+			good = true;
+		} else {
+			ERROR_LOG(G3D, "Could not load texture replacement info: %s - unsupported compressed format (pack)", level.file.ToVisualString().c_str());
+		}
+	} else {
+		ERROR_LOG(G3D, "Could not load texture replacement info: %s - unsupported format (pack)", level.file.ToVisualString().c_str());
+	}
+
+	return good;
+}
+
 static bool WriteTextureToPNG(png_imagep image, const Path &filename, int convert_to_8bit, const void *buffer, png_int_32 row_stride, const void *colormap) {
 	FILE *fp = File::OpenCFile(filename, "wb");
 	if (!fp) {
@@ -869,6 +1330,17 @@ void TextureReplacer::Decimate(ReplacerDecimateMode mode) {
 		item.second.PurgeIfOlder(threshold);
 	}
 
+	// Prefetched textures that were never used get purged like anything else.
+	for (auto it = prefetched_.begin(); it != prefetched_.end(); ) {
+		auto tex = cache_.find(it->first);
+		if (tex == cache_.end() || tex->second.lastUsed_ < threshold) {
+			prefetchedBytes_ -= it->second;
+			it = prefetched_.erase(it);
+		} else {
+			++it;
+		}
+	}
+
 	size_t totalSize = 0;
 	for (auto &item : levelCache_) {
 		std::lock_guard<std::mutex> guard(item.second.lock);
@@ -880,51 +1352,7 @@ void TextureReplacer::Decimate(ReplacerDecimateMode mode) {
 		WARN_LOG(G3D, "Decimated replacements older than %fs, currently using %f GB of RAM", age, totalSizeGB);
 	}
 	lastTextureCacheSizeGB_ = totalSizeGB;
-}
-
-template <typename Key, typename Value>
-static typename std::unordered_map<Key, Value>::const_iterator LookupWildcard(const std::unordered_map<Key, Value> &map, Key &key, u64 cachekey, u32 hash, bool ignoreAddress) {
-	auto alias = map.find(key);
-	if (alias != map.end())
-		return alias;
-
-	// Also check for a few more aliases with zeroed portions:
-	// Only clut hash (very dangerous in theory, in practice not more than missing "just" data hash)
-	key.cachekey = cachekey & 0xFFFFFFFFULL;
-	key.hash = 0;
-	alias = map.find(key);
-	if (alias != map.end())
-		return alias;
-
-	if (!ignoreAddress) {
-		// No data hash.
-		key.cachekey = cachekey;
-		key.hash = 0;
-		alias = map.find(key);
-		if (alias != map.end())
-			return alias;
-	}
-
-	// No address.
-	key.cachekey = cachekey & 0xFFFFFFFFULL;
-	key.hash = hash;
-	alias = map.find(key);
-	if (alias != map.end())
-		return alias;
-
-	if (!ignoreAddress) {
-		// Address, but not clut hash (in case of garbage clut data.)
-		key.cachekey = cachekey & ~0xFFFFFFFFULL;
-		key.hash = hash;
-		alias = map.find(key);
-		if (alias != map.end())
-			return alias;
-	}
-
-	// Anything with this data hash (a little dangerous.)
-	key.cachekey = 0;
-	key.hash = hash;
-	return map.find(key);
+	MemUsage_Set(MemoryCategory::TEXTURE_REPLACEMENT, (int64_t)totalSize);
 }
 
 bool TextureReplacer::FindFiltering(u64 cachekey, u32 hash, TextureFiltering *forceFiltering) {
@@ -996,14 +1424,14 @@ float TextureReplacer::LookupReduceHashRange(int& w, int& h) {
 
 class ReplacedTextureTask : public Task {
 public:
-	ReplacedTextureTask(ReplacedTexture &tex, LimitedWaitable *w) : tex_(tex), waitable_(w) {}
+	ReplacedTextureTask(ReplacedTexture &tex, LimitedWaitable *w, TaskPriority priority = TaskPriority::NORMAL) : tex_(tex), waitable_(w), priority_(priority) {}
 
 	TaskType Type() const override {
 		return TaskType::IO_BLOCKING;
 	}
 
 	TaskPriority Priority() const override {
-		return TaskPriority::NORMAL;
+		return priority_;
 	}
 
 	void Run() override {
@@ -1014,6 +1442,7 @@ class ReplacedTextureTask : public Task {
 private:
 	ReplacedTexture &tex_;
 	LimitedWaitable *waitable_;
+	TaskPriority priority_;
 };
 
 bool ReplacedTexture::IsReady(double budget) {
@@ -1054,6 +1483,28 @@ bool ReplacedTexture::IsReady(double budget) {
 	return false;
 }
 
+void ReplacedTexture::Prefetch() {
+	// Counts as used, so it's not decimated before it gets a chance.
+	lastUsed_ = time_now_d();
+	if (threadWaitable_ || initDone_ || !prepareDone_)
+		return;
+
+	threadWaitable_ = new LimitedWaitable();
+	g_threadManager.EnqueueTask(new ReplacedTextureTask(*this, threadWaitable_, TaskPriority::LOW));
+}
+
+size_t ReplacedTexture::EstimatedSize() const {
+	size_t total = 0;
+	for (const auto &level : levels_) {
+		int blockSize = 0;
+		if (Draw::DataFormatIsBlockCompressed(level.fmt, &blockSize))
+			total += (size_t)((level.w + 3) / 4) * ((level.h + 3) / 4) * blockSize;
+		else
+			total += (size_t)level.w * level.h * 4;
+	}
+	return total;
+}
+
 void ReplacedTexture::Prepare() {
 	std::unique_lock<std::mutex> lock(mutex_);
 	if (cancelPrepare_) {
@@ -1088,9 +1539,18 @@ void ReplacedTexture::PrepareData(int level) {
 
 	FILE *fp = nullptr;
 	zip_file_t *zf = nullptr;
+	const uint8_t *packData = nullptr;
 	ReplacedImageType imageType;
 	std::unique_lock<std::mutex> zguard;
-	if (info.zinfo && info.zinfo->z) {
+	if (info.pack) {
+		// Must stay locked while we use the mapping.
+		zguard = std::unique_lock<std::mutex>(info.pack->lock);
+		packData = info.pack->GetData(info.packOffset, info.packSize);
+		if (!packData || info.packSize < 4)
+			return;
+
+		imageType = Identify(packData);
+	} else if (info.zinfo && info.zinfo->z) {
 		zguard = std::unique_lock<std::mutex>(info.zinfo->lock);
 		zf = zip_fopen_index(info.zinfo->z, info.zi, 0);
 		if (!zf)
@@ -1124,17 +1584,23 @@ void ReplacedTexture::PrepareData(int level) {
 		} else if (zf) {
 			zip_uint64_t zsize = ZipFileSize(info.zinfo->z, info.zi);
 			zimSize = zsize == INVALID_ZIP_SIZE ? 0 : (size_t)zsize;
+		} else if (packData) {
+			zimSize = (size_t)info.packSize;
 		} else {
 			_assert_(false);
 		}
-		std::unique_ptr<uint8_t[]> zim(new uint8_t[zimSize]);
-		if (!zim) {
+		// The pack can be read directly.
+		std::unique_ptr<uint8_t[]> zim(packData ? nullptr : new uint8_t[zimSize]);
+		if (!zim && !packData) {
 			ERROR_LOG(G3D, "Failed to allocate memory for texture replacement");
 			cleanup();
 			return;
 		}
+		const uint8_t *zimData = packData ? packData : &zim[0];
 
-		if (fp) {
+		if (packData) {
+			// Nothing to read.
+		} else if (fp) {
 			if (fread(&zim[0], 1, zimSize, fp) != zimSize) {
 				ERROR_LOG(G3D, "Could not load texture replacement: %s - failed to read ZIM", info.file.c_str());
 				cleanup();
@@ -1155,7 +1621,7 @@ void ReplacedTexture::PrepareData(int level) {
 		int w, h, f;
 		uint8_t *image;
 
-		if (LoadZIMPtr(&zim[0], zimSize, &w, &h, &f, &image)) {
+		if (LoadZIMPtr(zimData, zimSize, &w, &h, &f, &image)) {
 			if (w > info.w || h > info.h) {
 				ERROR_LOG(G3D, "Texture replacement changed since header read: %s", info.file.c_str());
 				cleanup();
@@ -1204,6 +1670,12 @@ void ReplacedTexture::PrepareData(int level) {
 				cleanup();
 				return;
 			}
+		} else if (packData) {
+			if (!png_image_begin_read_from_memory(&png, packData, (size_t)info.packSize)) {
+				ERROR_LOG(G3D, "Could not load texture replacement info: %s - %s (pack)", info.file.c_str(), png.message);
+				cleanup();
+				return;
+			}
 		} else {
 			_assert_(false);
 		}
@@ -1239,6 +1711,54 @@ void ReplacedTexture::PrepareData(int level) {
 				alphaStatus_ = ReplacedTextureAlpha(res);
 			}
 		}
+	} else if (IsCompressedImageType(imageType)) {
+		CompressedImageHeader header;
+		bool good;
+		if (packData)
+			good = ParseCompressedHeader(imageType, packData, (size_t)info.packSize, &header);
+		else
+			good = fp ? ReadCompressedHeader(imageType, fp, &header) : ReadCompressedHeader(imageType, zf, &header);
+		if (!good || header.fmt != info.fmt || info.fileLevel >= header.levels || std::max(1, header.w >> info.fileLevel) != info.w || std::max(1, header.h >> info.fileLevel) != info.h) {
+			ERROR_LOG(G3D, "Texture replacement changed since header read: %s", info.file.c_str());
+			cleanup();
+			return;
+		}
+
+		const uint64_t offset = header.levelOffset[info.fileLevel];
+		const size_t size = (size_t)header.levelSize[info.fileLevel];
+		out.resize(size);
+		if (packData) {
+			good = offset <= info.packSize && info.packSize - offset >= size;
+			if (good)
+				memcpy(&out[0], packData + offset, size);
+		} else if (fp) {
+			good = fseek(fp, (long)offset, SEEK_SET) == 0 && fread(&out[0], 1, size, fp) == size;
+		} else if (zf) {
+			// Can't seek, so reopen and skip up to the level's data.
+			zip_fclose(zf);
+			zf = zip_fopen_index(info.zinfo->z, info.zi, 0);
+			uint8_t skipBuffer[4096];
+			uint64_t skipped = 0;
+			while (zf && skipped < offset) {
+				zip_int64_t chunk = zip_fread(zf, skipBuffer, (zip_uint64_t)std::min((uint64_t)sizeof(skipBuffer), offset - skipped));
+				if (chunk <= 0)
+					break;
+				skipped += chunk;
+			}
+			good = zf && skipped == offset && zip_fread(zf, &out[0], size) == (zip_int64_t)size;
+			// Try to unlock early to prevent blocking threads.
+			zguard.unlock();
+		} else {
+			_assert_(false);
+		}
+
+		if (!good) {
+			ERROR_LOG(G3D, "Could not load texture replacement: %s - failed to read level %d", info.file.c_str(), info.fileLevel);
+			out.resize(0);
+		} else if (level == 0) {
+			// We don't decode the blocks to check, but ETC2 RGB can't have alpha at all.
+			alphaStatus_ = info.fmt == Draw::DataFormat::ETC2_R8G8B8_UNORM_BLOCK ? ReplacedTextureAlpha::FULL : ReplacedTextureAlpha::UNKNOWN;
+		}
 	}
 
 	cleanup();
@@ -1290,21 +1810,31 @@ bool ReplacedTexture::Load(int level, void *out, int rowPitch) {
 
 	if (data.empty())
 		return false;
-	if (rowPitch < info.w * 4) {
-		ERROR_LOG_REPORT(G3D, "Replacement rowPitch=%d, but w=%d (level=%d)", rowPitch, info.w * 4, level);
+
+	// For compressed formats, a "line" is a row of 4x4 blocks.
+	int lineBytes = info.w * 4;
+	int lines = info.h;
+	int blockSize = 0;
+	if (Draw::DataFormatIsBlockCompressed(info.fmt, &blockSize)) {
+		lineBytes = ((info.w + 3) / 4) * blockSize;
+		lines = (info.h + 3) / 4;
+	}
+
+	if (rowPitch < lineBytes) {
+		ERROR_LOG_REPORT(G3D, "Replacement rowPitch=%d, but w=%d (level=%d)", rowPitch, lineBytes, level);
 		return false;
 	}
-	_assert_msg_(data.size() == info.w * info.h * 4, "Data has wrong size");
+	_assert_msg_(data.size() == (size_t)lineBytes * lines, "Data has wrong size");
 
-	if (rowPitch == info.w * 4) {
-		ParallelMemcpy(&g_threadManager, out, &data[0], info.w * 4 * info.h);
+	if (rowPitch == lineBytes) {
+		ParallelMemcpy(&g_threadManager, out, &data[0], lineBytes * lines);
 	} else {
 		const int MIN_LINES_PER_THREAD = 4;
 		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
 			for (int y = l; y < h; ++y) {
-				memcpy((uint8_t *)out + rowPitch * y, &data[0] + info.w * 4 * y, info.w * 4);
+				memcpy((uint8_t *)out + rowPitch * y, &data[0] + lineBytes * y, lineBytes);
 			}
-		}, 0, info.h, MIN_LINES_PER_THREAD);
+		}, 0, lines, MIN_LINES_PER_THREAD);
 	}
 
 	return true;
@@ -1363,3 +1893,60 @@ bool TextureReplacer::GenerateIni(const std::string &gameID, Path &generatedFile
 	}
 	return File::Exists(generatedFilename);
 }
+
+bool TextureReplacer::GeneratePack(const std::string &gameID, Path &generatedFilename) {
+	if (gameID.empty())
+		return false;
+
+	Path texturesDirectory = GetSysDirectory(DIRECTORY_TEXTURES) / gameID;
+	std::string iniText;
+	if (File::Exists(texturesDirectory / INI_FILENAME) && !File::ReadFileToString(true, texturesDirectory / INI_FILENAME, iniText))
+		return false;
+
+	IniFile ini;
+	std::stringstream sstream(iniText);
+	ini.Load(sstream);
+
+	std::vector<TexturePackSource> sources;
+	if (ini.HasSection("hashes")) {
+		auto hashes = ini.GetOrCreateSection("hashes")->ToMap();
+		for (const auto &item : hashes) {
+			TexturePackSource source{ 0, 0, 0 };
+			if (sscanf(item.first.c_str(), "%16llx%8x_%d", &source.cachekey, &source.hash, &source.level) >= 1) {
+				if (!item.second.empty())
+					source.file = texturesDirectory / item.second;
+				sources.push_back(source);
+			}
+		}
+	}
+
+	// Textures using the default names don't need to be listed in the ini.
+	// The sort in WriteTexturePack is stable, so these lose to the explicit aliases above.
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(texturesDirectory, &files, "png");
+	for (const auto &file : files) {
+		TexturePackSource source{ 0, 0, 0 };
+		if (sscanf(file.name.c_str(), "%16llx%8x_%d", &source.cachekey, &source.hash, &source.level) >= 2) {
+			if (file.name == HashName(source.cachekey, source.hash, source.level) + ".png") {
+				source.file = file.fullName;
+				sources.push_back(source);
+			}
+		}
+	}
+
+	// The index replaces [hashes], so leave it out of the ini to keep loading quick.
+	std::string packIni;
+	bool inHashes = false;
+	std::stringstream lines(iniText);
+	std::string line;
+	while (std::getline(lines, line)) {
+		std::string trimmed = StripSpaces(line);
+		if (!trimmed.empty() && trimmed[0] == '[')
+			inHashes = strcasecmp(trimmed.c_str(), "[hashes]") == 0;
+		if (!inHashes)
+			packIni += line + "\n";
+	}
+
+	generatedFilename = texturesDirectory / PACK_FILENAME;
+	return WriteTexturePack(generatedFilename, packIni, sources);
+}
@@ -28,6 +28,7 @@
 #include "Common/MemoryUtil.h"
 #include "Common/File/Path.h"
 #include "Common/GPU/DataFormat.h"
+#include "Core/TexturePack.h"
 
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/ge_constants.h"
@@ -62,17 +63,24 @@ struct ReplacerZipInfo {
 struct ReplacedTextureLevel {
 	int w;
 	int h;
-	Draw::DataFormat fmt;  // NOTE: Right now, the only supported format is Draw::DataFormat::R8G8B8A8_UNORM.
+	// R8G8B8A8_UNORM for PNG/ZIM, or a block compressed format from a DDS/KTX2 file.
+	Draw::DataFormat fmt;
 	Path file;
+	// DDS and KTX2 files can contain a whole mip chain, this is the level within the file.
+	int fileLevel = 0;
 	// Can be ignored for hashing/equal, since file has all uniqueness.
 	// To be able to reload, we need to be able to reopen, unfortunate we can't use zip_file_t.
 	ReplacerZipInfo *zinfo = nullptr;
 	int64_t zi = -1;
+	// For textures.pack, the file is the pack itself and the range identifies the texture.
+	TexturePackFile *pack = nullptr;
+	u64 packOffset = 0;
+	u64 packSize = 0;
 
 	bool operator ==(const ReplacedTextureLevel &other) const {
-		if (w != other.w || h != other.h || fmt != other.fmt)
+		if (w != other.w || h != other.h || fmt != other.fmt || fileLevel != other.fileLevel)
 			return false;
-		return file == other.file;
+		return file == other.file && packOffset == other.packOffset;
 	}
 };
 
@@ -202,6 +210,9 @@ struct ReplacedTexture {
 	}
 
 	bool IsReady(double budget);
+	// Starts loading on a thread (if not already loaded), without waiting for it.
+	void Prefetch();
+	size_t EstimatedSize() const;
 
 	bool Load(int level, void *out, int rowPitch);
 
@@ -234,6 +245,14 @@ struct ReplacedTextureDecodeInfo {
 	Draw::DataFormat fmt;
 };
 
+// Saved per game, in the order replacements were first needed.
+struct ReplacementPrefetchEntry {
+	u64 cachekey;
+	u32 hash;
+	u16 w;
+	u16 h;
+};
+
 enum class ReplacerDecimateMode {
 	NEW_FRAME,
 	FORCE_PRESSURE,
@@ -269,6 +288,8 @@ class TextureReplacer {
 	void Decimate(ReplacerDecimateMode mode);
 
 	static bool GenerateIni(const std::string &gameID, Path &generatedFilename);
+	// Packs textures.ini and all the textures it references into textures.pack.
+	static bool GeneratePack(const std::string &gameID, Path &generatedFilename);
 	static bool IniExists(const std::string &gameID);
 
 protected:
@@ -280,10 +301,15 @@ class TextureReplacer {
 	bool LookupHashRange(u32 addr, int &w, int &h);
 	float LookupReduceHashRange(int& w, int& h);
 	std::string LookupHashFile(u64 cachekey, u32 hash, int level);
-	std::string HashName(u64 cachekey, u32 hash, int level);
+	static std::string HashName(u64 cachekey, u32 hash, int level);
 	void PopulateReplacement(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h);
-	bool PopulateLevelFromPath(ReplacedTextureLevel &level, bool ignoreError);
-	bool PopulateLevelFromZip(ReplacedTextureLevel &level, bool ignoreError);
+	bool PopulateLevelFromPath(ReplacedTextureLevel &level, bool ignoreError, int *fileLevels);
+	bool PopulateLevelFromZip(ReplacedTextureLevel &level, bool ignoreError, int *fileLevels);
+	bool PopulateLevelFromPack(ReplacedTextureLevel &level, int *fileLevels);
+	void RecordAccess(const ReplacementCacheKey &key, int w, int h);
+	void PrefetchAfter(const ReplacementCacheKey &key);
+	void LoadPrefetchOrder();
+	void SavePrefetchOrder();
 
 	bool enabled_ = false;
 	bool allowVideo_ = false;
@@ -297,6 +323,7 @@ class TextureReplacer {
 	Path basePath_;
 	ReplacedTextureHash hash_ = ReplacedTextureHash::QUICK;
 	ReplacerZipInfo zip_;
+	TexturePackFile pack_;
 
 	typedef std::pair<int, int> WidthHeightPair;
 	std::unordered_map<u64, WidthHeightPair> hashranges_;
@@ -308,4 +335,14 @@ class TextureReplacer {
 	std::unordered_map<ReplacementCacheKey, ReplacedTexture> cache_;
 	std::unordered_map<ReplacementCacheKey, std::pair<ReplacedTextureLevel, double>> savedCache_;
 	std::unordered_map<ReplacedTextureLevel, ReplacedLevelCache> levelCache_;
+
+	Path prefetchPath_;
+	// From previous runs, and where each key is in that order.
+	std::vector<ReplacementPrefetchEntry> prefetchOrder_;
+	std::unordered_map<ReplacementCacheKey, size_t> prefetchIndex_;
+	// What this run needed so far, to be saved for the next run.
+	std::vector<ReplacementPrefetchEntry> accessOrder_;
+	// Prefetched, but not yet needed.  These count against iReplacementPrefetchMB.
+	std::unordered_map<ReplacementCacheKey, size_t> prefetched_;
+	size_t prefetchedBytes_ = 0;
 };
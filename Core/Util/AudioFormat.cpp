@@ -151,3 +151,136 @@ void ConvertS16ToF32(float *out, const s16 *in, size_t size) {
 		out[i] = in[i] * (1.0f / 32767.0f);
 	}
 }
+
+void AccumulateStereoVolume12(int *out, const s16 *in, size_t count, int leftVol, int rightVol) {
+	// The 16-bit multiplies need the volumes to fit, SAS clamps them to 0x1000 anyway.
+	const bool volumeFits = leftVol <= 0x7fff && -leftVol <= 0x8000 && rightVol <= 0x7fff && -rightVol <= 0x8000;
+#ifdef _M_SSE
+	if (volumeFits) {
+		const __m128i volume = _mm_set_epi16(rightVol, leftVol, rightVol, leftVol, rightVol, leftVol, rightVol, leftVol);
+		while (count >= 8) {
+			__m128i indata = _mm_loadu_si128((const __m128i *)in);
+			// Duplicate each sample so the pairs line up with left and right.
+			__m128i dup1 = _mm_unpacklo_epi16(indata, indata);
+			__m128i dup2 = _mm_unpackhi_epi16(indata, indata);
+			__m128i lo1 = _mm_mullo_epi16(dup1, volume);
+			__m128i hi1 = _mm_mulhi_epi16(dup1, volume);
+			__m128i lo2 = _mm_mullo_epi16(dup2, volume);
+			__m128i hi2 = _mm_mulhi_epi16(dup2, volume);
+
+			__m128i *dst = (__m128i *)out;
+			_mm_storeu_si128(dst + 0, _mm_add_epi32(_mm_loadu_si128(dst + 0), _mm_srai_epi32(_mm_unpacklo_epi16(lo1, hi1), 12)));
+			_mm_storeu_si128(dst + 1, _mm_add_epi32(_mm_loadu_si128(dst + 1), _mm_srai_epi32(_mm_unpackhi_epi16(lo1, hi1), 12)));
+			_mm_storeu_si128(dst + 2, _mm_add_epi32(_mm_loadu_si128(dst + 2), _mm_srai_epi32(_mm_unpacklo_epi16(lo2, hi2), 12)));
+			_mm_storeu_si128(dst + 3, _mm_add_epi32(_mm_loadu_si128(dst + 3), _mm_srai_epi32(_mm_unpackhi_epi16(lo2, hi2), 12)));
+			in += 8;
+			out += 16;
+			count -= 8;
+		}
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	if (volumeFits) {
+		const int16x4_t volume = vzip_s16(vdup_n_s16(leftVol), vdup_n_s16(rightVol)).val[0];
+		while (count >= 8) {
+			int16x8_t indata = vld1q_s16(in);
+			int16x8x2_t dup = vzipq_s16(indata, indata);
+
+			int32x4_t out1 = vmull_s16(vget_low_s16(dup.val[0]), volume);
+			int32x4_t out2 = vmull_s16(vget_high_s16(dup.val[0]), volume);
+			int32x4_t out3 = vmull_s16(vget_low_s16(dup.val[1]), volume);
+			int32x4_t out4 = vmull_s16(vget_high_s16(dup.val[1]), volume);
+			vst1q_s32(out + 0, vsraq_n_s32(vld1q_s32(out + 0), out1, 12));
+			vst1q_s32(out + 4, vsraq_n_s32(vld1q_s32(out + 4), out2, 12));
+			vst1q_s32(out + 8, vsraq_n_s32(vld1q_s32(out + 8), out3, 12));
+			vst1q_s32(out + 12, vsraq_n_s32(vld1q_s32(out + 12), out4, 12));
+			in += 8;
+			out += 16;
+			count -= 8;
+		}
+	}
+#else
+	(void)volumeFits;
+#endif
+	for (size_t i = 0; i < count; i++) {
+		out[i * 2] += (in[i] * leftVol) >> 12;
+		out[i * 2 + 1] += (in[i] * rightVol) >> 12;
+	}
+}
+
+void ConvertS16ToS32(s32 *out, const s16 *in, size_t size) {
+#ifdef _M_SSE
+	while (size >= 8) {
+		__m128i indata = _mm_loadu_si128((const __m128i *)in);
+		// No sign extension in SSE2, so put the sample in the top half and shift it down.
+		_mm_storeu_si128((__m128i *)out, _mm_srai_epi32(_mm_unpacklo_epi16(indata, indata), 16));
+		_mm_storeu_si128((__m128i *)(out + 4), _mm_srai_epi32(_mm_unpackhi_epi16(indata, indata), 16));
+		in += 8;
+		out += 8;
+		size -= 8;
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	while (size >= 8) {
+		int16x8_t indata = vld1q_s16(in);
+		vst1q_s32(out, vmovl_s16(vget_low_s16(indata)));
+		vst1q_s32(out + 4, vmovl_s16(vget_high_s16(indata)));
+		in += 8;
+		out += 8;
+		size -= 8;
+	}
+#endif
+	for (size_t i = 0; i < size; i++) {
+		out[i] = in[i];
+	}
+}
+
+void AccumulateS16ToS32(s32 *out, const s16 *in, size_t size) {
+#ifdef _M_SSE
+	while (size >= 8) {
+		__m128i indata = _mm_loadu_si128((const __m128i *)in);
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(indata, indata), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(indata, indata), 16);
+		_mm_storeu_si128((__m128i *)out, _mm_add_epi32(_mm_loadu_si128((const __m128i *)out), lo));
+		_mm_storeu_si128((__m128i *)(out + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(out + 4)), hi));
+		in += 8;
+		out += 8;
+		size -= 8;
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	while (size >= 8) {
+		int16x8_t indata = vld1q_s16(in);
+		vst1q_s32(out, vaddw_s16(vld1q_s32(out), vget_low_s16(indata)));
+		vst1q_s32(out + 4, vaddw_s16(vld1q_s32(out + 4), vget_high_s16(indata)));
+		in += 8;
+		out += 8;
+		size -= 8;
+	}
+#endif
+	for (size_t i = 0; i < size; i++) {
+		out[i] += in[i];
+	}
+}
+
+void ClampS32ToS16(s16 *out, const s32 *in, size_t size) {
+#ifdef _M_SSE
+	while (size >= 8) {
+		__m128i in1 = _mm_loadu_si128((const __m128i *)in);
+		__m128i in2 = _mm_loadu_si128((const __m128i *)(in + 4));
+		_mm_storeu_si128((__m128i *)out, _mm_packs_epi32(in1, in2));
+		in += 8;
+		out += 8;
+		size -= 8;
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	while (size >= 8) {
+		int16x4_t packed1 = vqmovn_s32(vld1q_s32(in));
+		int16x4_t packed2 = vqmovn_s32(vld1q_s32(in + 4));
+		vst1q_s16(out, vcombine_s16(packed1, packed2));
+		in += 8;
+		out += 8;
+		size -= 8;
+	}
+#endif
+	for (size_t i = 0; i < size; i++) {
+		out[i] = clamp_s16(in[i]);
+	}
+}
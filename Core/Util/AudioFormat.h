@@ -67,3 +67,11 @@ static inline s16 ApplySampleVolume20Bit(s16 sample, int vol20) {
 
 void AdjustVolumeBlock(s16 *out, s16 *in, size_t size, int leftVol, int rightVol);
 void ConvertS16ToF32(float *ou, const s16 *in, size_t size);
+// Mixes mono samples into an interleaved stereo 32-bit buffer: out[i * 2] += (in[i] * leftVol) >> 12.
+// Results are bit-exact with the scalar formula for any volume.
+void AccumulateStereoVolume12(int *out, const s16 *in, size_t count, int leftVol, int rightVol);
+// Widen samples into a 32-bit mix buffer, either overwriting or adding to it.
+void ConvertS16ToS32(s32 *out, const s16 *in, size_t size);
+void AccumulateS16ToS32(s32 *out, const s16 *in, size_t size);
+// Saturates a 32-bit mix buffer back to samples.
+void ClampS32ToS16(s16 *out, const s32 *in, size_t size);
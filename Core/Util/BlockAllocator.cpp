@@ -17,6 +17,7 @@
 
 #include <cstring>
 
+#include "Common/BitScan.h"
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
@@ -25,7 +26,24 @@
 #include "Core/Util/BlockAllocator.h"
 #include "Core/Reporting.h"
 
-// Slow freaking thing but works (eventually) :)
+// Block list in address order, with an index by address and free lists by size class on the side.
+
+static inline int SizeClass(u32 size) {
+	return 31 - (int)clz32_nonzero(size);
+}
+
+// These have to match exactly what the allocation does below.
+static inline bool FitsFromBottom(u32 start, u32 blockSize, u32 size, u32 grain) {
+	u32 offset = start % grain;
+	if (offset != 0)
+		offset = grain - offset;
+	return blockSize >= offset + size;
+}
+
+static inline bool FitsFromTop(u32 start, u32 blockSize, u32 size, u32 grain) {
+	u32 offset = (start + blockSize - size) % grain;
+	return blockSize >= offset + size;
+}
 
 BlockAllocator::BlockAllocator(int grain) : bottom_(NULL), top_(NULL), grain_(grain)
 {
@@ -44,6 +62,7 @@ void BlockAllocator::Init(u32 rangeStart, u32 rangeSize, bool suballoc) {
 	top_ = new Block(rangeStart_, rangeSize_, false, NULL, NULL);
 	bottom_ = top_;
 	suballoc_ = suballoc;
+	IndexBlock(top_);
 }
 
 void BlockAllocator::Shutdown()
@@ -55,6 +74,78 @@ void BlockAllocator::Shutdown()
 		bottom_ = next;
 	}
 	top_ = NULL;
+
+	blocksByStart_.clear();
+	for (auto &freeList : freeBlocks_)
+		freeList.clear();
+}
+
+void BlockAllocator::IndexBlock(Block *b) {
+	if (b->size == 0)
+		return;
+	blocksByStart_[b->start] = b;
+	if (!b->taken)
+		freeBlocks_[SizeClass(b->size)][b->start] = b;
+}
+
+void BlockAllocator::UnindexBlock(Block *b) {
+	if (b->size == 0)
+		return;
+	blocksByStart_.erase(b->start);
+	if (!b->taken)
+		freeBlocks_[SizeClass(b->size)].erase(b->start);
+}
+
+void BlockAllocator::SetTaken(Block *b, bool taken) {
+	UnindexBlock(b);
+	b->taken = taken;
+	IndexBlock(b);
+}
+
+// Same result as walking every block from the bottom (or top) and taking the first free one that fits.
+BlockAllocator::Block *BlockAllocator::FindFreeBlock(u32 size, u32 grain, bool fromTop) const {
+	// At least this big and it fits, however it's aligned.
+	u64 alwaysFits = (u64)size + grain - 1;
+	auto better = [fromTop](const Block *candidate, const Block *best) {
+		return !best || (fromTop ? candidate->start > best->start : candidate->start < best->start);
+	};
+
+	Block *best = nullptr;
+	for (int c = SizeClass(size); c < SIZE_CLASSES; ++c) {
+		const auto &freeList = freeBlocks_[c];
+		if (freeList.empty())
+			continue;
+
+		if (((u64)1 << c) >= alwaysFits) {
+			// Everything in this class fits, so only the outermost matters.
+			Block *candidate = fromTop ? freeList.rbegin()->second : freeList.begin()->second;
+			if (better(candidate, best))
+				best = candidate;
+			continue;
+		}
+
+		// Some of these are too small once aligned, go in order until one fits or we pass the best so far.
+		if (fromTop) {
+			for (auto it = freeList.rbegin(); it != freeList.rend(); ++it) {
+				if (best && !better(it->second, best))
+					break;
+				if (FitsFromTop(it->second->start, it->second->size, size, grain)) {
+					best = it->second;
+					break;
+				}
+			}
+		} else {
+			for (auto it = freeList.begin(); it != freeList.end(); ++it) {
+				if (best && !better(it->second, best))
+					break;
+				if (FitsFromBottom(it->second->start, it->second->size, size, grain)) {
+					best = it->second;
+					break;
+				}
+			}
+		}
+	}
+	return best;
 }
 
 u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromTop, const char *tag)
@@ -74,67 +165,36 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 	// upalign size to grain
 	size = (size + sizeGrain - 1) & ~(sizeGrain - 1);
 
-	if (!fromTop)
+	Block *bp = FindFreeBlock(size, grain, fromTop);
+	if (bp && !fromTop)
 	{
 		//Allocate from bottom of mem
-		for (Block *bp = bottom_; bp != NULL; bp = bp->next)
-		{
-			Block &b = *bp;
-			u32 offset = b.start % grain;
-			if (offset != 0)
-				offset = grain - offset;
-			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
-			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeAfter(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-			}
-		}
+		Block &b = *bp;
+		u32 offset = b.start % grain;
+		if (offset != 0)
+			offset = grain - offset;
+		u32 needed = offset + size;
+		if (b.size != needed)
+			InsertFreeAfter(&b, b.size - needed);
+		if (offset >= grain_)
+			InsertFreeBefore(&b, offset);
+		SetTaken(&b, true);
+		b.SetAllocated(tag, suballoc_);
+		return b.start;
 	}
-	else
+	else if (bp)
 	{
 		// Allocate from top of mem.
-		for (Block *bp = top_; bp != NULL; bp = bp->prev)
-		{
-			Block &b = *bp;
-			u32 offset = (b.start + b.size - size) % grain;
-			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
-			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeBefore(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-			}
-		}
+		Block &b = *bp;
+		u32 offset = (b.start + b.size - size) % grain;
+		u32 needed = offset + size;
+		if (b.size != needed)
+			InsertFreeBefore(&b, b.size - needed);
+		if (offset >= grain_)
+			InsertFreeAfter(&b, offset);
+		SetTaken(&b, true);
+		b.SetAllocated(tag, suballoc_);
+		return b.start;
 	}
 
 	//Out of memory :(
@@ -195,7 +255,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 			{
 				if (b.size != alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
-				b.taken = true;
+				SetTaken(&b, true);
 				b.SetAllocated(tag, suballoc_);
 				CheckBlocks();
 				return position;
@@ -205,7 +265,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 				InsertFreeBefore(&b, alignedPosition - b.start);
 				if (b.size > alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
-				b.taken = true;
+				SetTaken(&b, true);
 				b.SetAllocated(tag, suballoc_);
 
 				return position;
@@ -227,11 +287,13 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 {
 	DEBUG_LOG(SCEKERNEL, "Merging Blocks");
+	UnindexBlock(fromBlock);
 
 	Block *prev = fromBlock->prev;
 	while (prev != NULL && prev->taken == false)
 	{
 		DEBUG_LOG(SCEKERNEL, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(prev);
 		prev->size += fromBlock->size;
 		if (fromBlock->next == NULL)
 			top_ = prev;
@@ -252,6 +314,7 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 	while (next != NULL && next->taken == false)
 	{
 		DEBUG_LOG(SCEKERNEL, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(next);
 		fromBlock->size += next->size;
 		fromBlock->next = next->next;
 		delete next;
@@ -262,6 +325,8 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 		top_ = fromBlock;
 	else
 		next->prev = fromBlock;
+
+	IndexBlock(fromBlock);
 }
 
 bool BlockAllocator::Free(u32 position)
@@ -270,7 +335,7 @@ bool BlockAllocator::Free(u32 position)
 	if (b && b->taken)
 	{
 		NotifyMemInfo(suballoc_ ? MemBlockFlags::SUB_FREE : MemBlockFlags::FREE, b->start, b->size, "");
-		b->taken = false;
+		SetTaken(b, false);
 		MergeFreeBlocks(b);
 		return true;
 	}
@@ -287,7 +352,7 @@ bool BlockAllocator::FreeExact(u32 position)
 	if (b && b->taken && b->start == position)
 	{
 		NotifyMemInfo(suballoc_ ? MemBlockFlags::SUB_FREE : MemBlockFlags::FREE, b->start, b->size, "");
-		b->taken = false;
+		SetTaken(b, false);
 		MergeFreeBlocks(b);
 		return true;
 	}
@@ -300,6 +365,7 @@ bool BlockAllocator::FreeExact(u32 position)
 
 BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 {
+	UnindexBlock(b);
 	Block *inserted = new Block(b->start, size, false, b->prev, b);
 	b->prev = inserted;
 	if (inserted->prev == NULL)
@@ -309,11 +375,14 @@ BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 
 	b->start += size;
 	b->size -= size;
+	IndexBlock(inserted);
+	IndexBlock(b);
 	return inserted;
 }
 
 BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 {
+	UnindexBlock(b);
 	Block *inserted = new Block(b->start + b->size - size, size, false, b, b->next);
 	b->next = inserted;
 	if (inserted->next == NULL)
@@ -322,6 +391,8 @@ BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 		inserted->next->prev = inserted;
 
 	b->size -= size;
+	IndexBlock(inserted);
+	IndexBlock(b);
 	return inserted;
 }
 
@@ -345,31 +416,22 @@ const char *BlockAllocator::GetBlockTag(u32 addr) const {
 	return b->tag;
 }
 
-inline BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr)
+BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr)
 {
-	for (Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
-	}
-	return NULL;
+	const BlockAllocator *self = this;
+	return const_cast<Block *>(self->GetBlockFromAddress(addr));
 }
 
 const BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr) const
 {
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		const Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
-	}
+	// The last block starting at or before addr.
+	auto it = blocksByStart_.upper_bound(addr);
+	if (it == blocksByStart_.begin())
+		return NULL;
+	--it;
+	const Block *b = it->second;
+	if (b->start <= addr && b->start + b->size > addr)
+		return b;
 	return NULL;
 }
 
@@ -405,13 +467,13 @@ void BlockAllocator::ListBlocks() const
 u32 BlockAllocator::GetLargestFreeBlockSize() const
 {
 	u32 maxFreeBlock = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
+	// Only the largest non-empty class can have it.
+	for (int c = SIZE_CLASSES - 1; c >= 0 && maxFreeBlock == 0; --c)
 	{
-		const Block &b = *bp;
-		if (!b.taken)
+		for (const auto &it : freeBlocks_[c])
 		{
-			if (b.size > maxFreeBlock)
-				maxFreeBlock = b.size;
+			if (it.second->size > maxFreeBlock)
+				maxFreeBlock = it.second->size;
 		}
 	}
 	if (maxFreeBlock & (grain_ - 1))
@@ -422,13 +484,10 @@ u32 BlockAllocator::GetLargestFreeBlockSize() const
 u32 BlockAllocator::GetTotalFreeBytes() const
 {
 	u32 sum = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
+	for (const auto &freeList : freeBlocks_)
 	{
-		const Block &b = *bp;
-		if (!b.taken)
-		{
-			sum += b.size;
-		}
+		for (const auto &it : freeList)
+			sum += it.second->size;
 	}
 	if (sum & (grain_ - 1))
 		WARN_LOG_REPORT(HLE, "GetTotalFreeBytes: free size %08x does not align to grain %08x.", sum, grain_);
@@ -459,6 +518,9 @@ void BlockAllocator::DoState(PointerWrap &p)
 			top_->next->DoState(p);
 			top_ = top_->next;
 		}
+
+		for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+			IndexBlock(bp);
 	}
 	else
 	{
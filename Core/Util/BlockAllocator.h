@@ -19,6 +19,8 @@
 
 class PointerWrap;
 
+#include <map>
+
 #include "Common/CommonTypes.h"
 
 class BlockAllocator
@@ -72,6 +74,13 @@ class BlockAllocator
 		Block *next;
 	};
 
+	// Blocks are kept in a list in address order, and also indexed for lookup.
+	// Zero-sized blocks are never indexed.
+	static const int SIZE_CLASSES = 32;
+	std::map<u32, Block *> blocksByStart_;
+	// Free blocks by floor(log2(size)), each ordered by address so first fit still picks the lowest (or highest.)
+	std::map<u32, Block *> freeBlocks_[SIZE_CLASSES];
+
 	Block *bottom_;
 	Block *top_;
 	u32 rangeStart_;
@@ -80,6 +89,11 @@ class BlockAllocator
 	u32 grain_;
 	bool suballoc_;
 
+	void IndexBlock(Block *b);
+	void UnindexBlock(Block *b);
+	void SetTaken(Block *b, bool taken);
+	Block *FindFreeBlock(u32 size, u32 grain, bool fromTop) const;
+
 	void MergeFreeBlocks(Block *fromBlock);
 	Block *GetBlockFromAddress(u32 addr);
 	const Block *GetBlockFromAddress(u32 addr) const;
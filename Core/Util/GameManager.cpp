@@ -38,7 +38,10 @@
 #include "Common/Log.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Common/Thread/ThreadUtil.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/Loaders.h"
 #include "Core/ELF/ParamSFO.h"
@@ -472,7 +475,12 @@ std::string GameManager::GetISOGameID(FileLoader *loader) const {
 	return sfo.GetValueString("DISC_ID");
 }
 
-bool GameManager::ExtractFile(struct zip *z, int file_index, const Path &outFilename, size_t *bytesCopied, size_t allBytes) {
+// Extraction is mostly bound by inflate and the storage, so a few workers are plenty.
+static const int MAX_EXTRACT_WORKERS = 4;
+// Don't bother opening more archive handles for a handful of files.
+static const size_t MIN_JOBS_PER_EXTRACT_WORKER = 4;
+
+bool GameManager::ExtractFile(struct zip *z, int file_index, const Path &outFilename, std::atomic<size_t> *bytesCopied, size_t allBytes) {
 	struct zip_stat zstat;
 	zip_stat_index(z, file_index, 0, &zstat);
 	size_t size = zstat.size;
@@ -490,8 +498,11 @@ bool GameManager::ExtractFile(struct zip *z, int file_index, const Path &outFile
 
 	FILE *f = File::OpenCFile(outFilename, "wb");
 	if (f) {
+		// We always write whole blocks, so stdio buffering would only add a copy.
+		setvbuf(f, nullptr, _IONBF, 0);
+
 		size_t pos = 0;
-		const size_t blockSize = 1024 * 128;
+		const size_t blockSize = 1024 * 1024;
 		u8 *buffer = new u8[blockSize];
 		while (pos < size) {
 			size_t readSize = std::min(blockSize, size - pos);
@@ -515,8 +526,8 @@ bool GameManager::ExtractFile(struct zip *z, int file_index, const Path &outFile
 			}
 			pos += readSize;
 
-			*bytesCopied += readSize;
-			installProgress_ = (float)*bytesCopied / (float)allBytes;
+			size_t copied = bytesCopied->fetch_add(readSize) + readSize;
+			installProgress_ = (float)copied / (float)allBytes;
 		}
 		zip_fclose(zf);
 		fclose(f);
@@ -528,9 +539,72 @@ bool GameManager::ExtractFile(struct zip *z, int file_index, const Path &outFile
 	}
 }
 
+bool GameManager::ExtractFiles(struct zip *z, const Path &zipfile, const std::vector<ZipExtractJob> &jobs, size_t allBytes, std::vector<Path> &createdFiles) {
+	// libzip handles can't be shared between threads, so each worker reads through its own.
+	// The first one is the handle we already have.
+	std::vector<struct zip *> handles{ z };
+	int maxWorkers = g_threadManager.IsInitialized() ? std::min(g_threadManager.GetNumLooperThreads(), MAX_EXTRACT_WORKERS) : 1;
+	while ((int)handles.size() < maxWorkers && jobs.size() >= (handles.size() + 1) * MIN_JOBS_PER_EXTRACT_WORKER) {
+		struct zip *extra = ZipOpenPath(zipfile);
+		if (!extra)
+			break;
+		handles.push_back(extra);
+	}
+
+	// Give each worker a contiguous run of entries with about the same amount of data,
+	// so each handle still reads through the archive front to back.
+	const int numSlices = (int)handles.size();
+	uint64_t totalBytes = 0;
+	for (const ZipExtractJob &job : jobs)
+		totalBytes += job.size;
+	std::vector<size_t> sliceStart(numSlices + 1, jobs.size());
+	sliceStart[0] = 0;
+	uint64_t sliceBytes = 0;
+	int slice = 1;
+	for (size_t i = 0; i < jobs.size() && slice < numSlices; ++i) {
+		sliceBytes += jobs[i].size;
+		if (sliceBytes * numSlices >= totalBytes * slice)
+			sliceStart[slice++] = i + 1;
+	}
+
+	std::atomic<size_t> bytesCopied(0);
+	std::atomic<bool> failed(false);
+	std::vector<std::vector<Path>> sliceFiles(numSlices);
+	auto extractSlice = [&](int s) {
+		for (size_t i = sliceStart[s]; i < sliceStart[s + 1] && !failed; ++i) {
+			const ZipExtractJob &job = jobs[i];
+			if (!ExtractFile(handles[s], job.index, job.outFilename, &bytesCopied, allBytes)) {
+				failed = true;
+				break;
+			}
+			sliceFiles[s].push_back(job.outFilename);
+		}
+	};
+
+	double startTime = time_now_d();
+	if (numSlices == 1) {
+		extractSlice(0);
+	} else {
+		ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+			for (int s = lower; s < upper; ++s)
+				extractSlice(s);
+		}, 0, numSlices, 1);
+	}
+	double elapsed = time_now_d() - startTime;
+
+	for (size_t i = 1; i < handles.size(); ++i)
+		zip_close(handles[i]);
+	for (auto &files : sliceFiles)
+		createdFiles.insert(createdFiles.end(), files.begin(), files.end());
+
+	size_t copied = bytesCopied;
+	INFO_LOG(HLE, "Extracted %d files from zip (%lld bytes / %lld) in %0.2f s using %d workers (%0.1f MB/s).",
+		(int)createdFiles.size(), (long long)copied, (long long)allBytes, elapsed, numSlices, elapsed > 0.0 ? (double)copied / (1024.0 * 1024.0) / elapsed : 0.0);
+	return !failed;
+}
+
 bool GameManager::InstallMemstickGame(struct zip *z, const Path &zipfile, const Path &dest, const ZipFileInfo &info, bool allowRoot, bool deleteAfter) {
 	size_t allBytes = 0;
-	size_t bytesCopied = 0;
 
 	auto sy = GetI18NCategory("System");
 
@@ -579,8 +653,9 @@ bool GameManager::InstallMemstickGame(struct zip *z, const Path &zipfile, const
 		}
 	}
 
-	// Now, loop through again in a second pass, writing files.
+	// Now, loop through again in a second pass, collecting the files to write.
 	std::vector<Path> createdFiles;
+	std::vector<ZipExtractJob> jobs;
 	for (int i = 0; i < info.numFiles; i++) {
 		const char *fn = zip_get_name(z, i, 0);
 		// Note that we do NOT write files that are not in a directory, to avoid random
@@ -593,14 +668,15 @@ bool GameManager::InstallMemstickGame(struct zip *z, const Path &zipfile, const
 			if (isDir)
 				continue;
 
-			if (!ExtractFile(z, i, outFilename, &bytesCopied, allBytes)) {
-				goto bail;
-			} else {
-				createdFiles.push_back(outFilename);
-			}
+			struct zip_stat zstat;
+			size_t size = zip_stat_index(z, i, 0, &zstat) >= 0 ? (size_t)zstat.size : 0;
+			jobs.push_back(ZipExtractJob{ i, outFilename, size });
 		}
 	}
-	INFO_LOG(HLE, "Extracted %d files from zip (%d bytes / %d).", info.numFiles, (int)bytesCopied, (int)allBytes);
+
+	if (!ExtractFiles(z, zipfile, jobs, allBytes, createdFiles)) {
+		goto bail;
+	}
 
 	zip_close(z);
 	z = nullptr;
@@ -697,7 +773,7 @@ bool GameManager::InstallZippedISO(struct zip *z, int isoFileIndex, const Path &
 	}
 
 	Path outputISOFilename = Path(g_Config.currentDirectory) / fn.substr(nameOffset);
-	size_t bytesCopied = 0;
+	std::atomic<size_t> bytesCopied(0);
 	if (ExtractFile(z, isoFileIndex, outputISOFilename, &bytesCopied, allBytes)) {
 		INFO_LOG(IO, "Successfully extracted ISO file to '%s'", outputISOFilename.c_str());
 	}
@@ -22,7 +22,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <thread>
+#include <vector>
 
 #include "Common/Net/HTTPClient.h"
 #include "Common/File/Path.h"
@@ -36,6 +38,7 @@ enum class GameManagerState {
 struct zip;
 class FileLoader;
 struct ZipFileInfo;
+struct ZipExtractJob;
 
 class GameManager {
 public:
@@ -83,7 +86,8 @@ class GameManager {
 	bool InstallZippedISO(struct zip *z, int isoFileIndex, const Path &zipfile, bool deleteAfter);
 	bool InstallRawISO(const Path &zipFile, const std::string &originalName, bool deleteAfter);
 	void InstallDone();
-	bool ExtractFile(struct zip *z, int file_index, const Path &outFilename, size_t *bytesCopied, size_t allBytes);
+	bool ExtractFile(struct zip *z, int file_index, const Path &outFilename, std::atomic<size_t> *bytesCopied, size_t allBytes);
+	bool ExtractFiles(struct zip *z, const Path &zipfile, const std::vector<ZipExtractJob> &jobs, size_t allBytes, std::vector<Path> &createdFiles);
 	bool DetectTexturePackDest(struct zip *z, int iniIndex, Path &dest);
 	void SetInstallError(const std::string &err);
 
@@ -116,5 +120,11 @@ struct ZipFileInfo {
 	bool ignoreMetaFiles;
 };
 
+struct ZipExtractJob {
+	int index;
+	Path outFilename;
+	size_t size;
+};
+
 ZipFileContents DetectZipFileContents(struct zip *z, ZipFileInfo *info);
 ZipFileContents DetectZipFileContents(const Path &fileName, ZipFileInfo *info);
@@ -131,6 +131,37 @@ struct PPGeTextDrawerImage {
 };
 static std::map<PPGeTextDrawerCacheKey, PPGeTextDrawerImage> textDrawerImages;
 
+// Measuring wrapped text with the TextDrawer measures it word by word, which is slow for long
+// texts, and dialogs do it every frame.  So we keep the results while they're in use.
+struct PPGeTextLayoutCacheKey {
+	bool operator < (const PPGeTextLayoutCacheKey &other) const {
+		if (flags != other.flags)
+			return flags < other.flags;
+		if (scale != other.scale)
+			return scale < other.scale;
+		if (wrapWidth != other.wrapWidth)
+			return wrapWidth < other.wrapWidth;
+		if (wrapHeight != other.wrapHeight)
+			return wrapHeight < other.wrapHeight;
+		return text < other.text;
+	}
+	std::string text;
+	int flags;
+	float scale;
+	float wrapWidth;
+	// Zero for plain measurements.
+	float wrapHeight;
+};
+struct PPGeTextLayout {
+	// The text to draw (possibly cropped), and the scale to draw it at.
+	std::string text;
+	float scale;
+	float width;
+	float height;
+	int lastUsedFrame;
+};
+static std::map<PPGeTextLayoutCacheKey, PPGeTextLayout> textLayouts;
+
 void PPGeSetDrawContext(Draw::DrawContext *draw) {
 	g_draw = draw;
 }
@@ -143,7 +174,7 @@ void PPGePrepareText(const char *text, float x, float y, PPGeAlign align, float
 
 // Draw currently buffered text using the state from PPGeGetTextBoundingBox() call.
 // Clears the buffer and state when done.
-void PPGeDrawCurrentText(u32 color = 0xFFFFFFFF);
+void PPGeDrawCurrentText(u32 color = 0xFFFFFFFF, bool hasShadow = false, u32 shadowColor = 0);
 
 static void PPGeDecimateTextImages(int age = 97);
 
@@ -300,6 +331,7 @@ void __PPGeInit() {
 	textDrawerInited = PSP_CoreParameter().headLess;
 	textDrawer = nullptr;
 	textDrawerImages.clear();
+	textLayouts.clear();
 
 	atlasRequiresReset = false;
 
@@ -407,6 +439,7 @@ void __PPGeShutdown()
 	for (auto im : textDrawerImages)
 		kernelMemory.Free(im.second.ptr);
 	textDrawerImages.clear();
+	textLayouts.clear();
 }
 
 void PPGeBegin()
@@ -774,20 +807,28 @@ void PPGeMeasureText(float *w, float *h, const char *text, float scale, int Wrap
 	std::string s = PPGeSanitizeText(text);
 
 	if (HasTextDrawer()) {
-		std::string s2 = ReplaceAll(s, "&", "&&");
-
-		float mw, mh;
-		textDrawer->SetFontScale(scale, scale);
 		int dtalign = (WrapType & PPGE_LINE_WRAP_WORD) ? FLAG_WRAP_TEXT : 0;
 		if (WrapType & PPGE_LINE_USE_ELLIPSIS)
 			dtalign |= FLAG_ELLIPSIZE_TEXT;
-		Bounds b(0, 0, wrapWidth <= 0 ? 480.0f : wrapWidth, 272.0f);
-		textDrawer->MeasureStringRect(s2.c_str(), s2.size(), b, &mw, &mh, dtalign);
+
+		PPGeTextLayoutCacheKey key{ s, dtalign, scale, wrapWidth <= 0 ? 480.0f : (float)wrapWidth, 0.0f };
+		auto cacheItem = textLayouts.find(key);
+		if (cacheItem == textLayouts.end()) {
+			std::string s2 = ReplaceAll(s, "&", "&&");
+
+			PPGeTextLayout layout{};
+			textDrawer->SetFontScale(scale, scale);
+			Bounds b(0, 0, key.wrapWidth, 272.0f);
+			textDrawer->MeasureStringRect(s2.c_str(), s2.size(), b, &layout.width, &layout.height, dtalign);
+			layout.scale = scale;
+			cacheItem = textLayouts.emplace(key, layout).first;
+		}
+		cacheItem->second.lastUsedFrame = gpuStats.numFlips;
 
 		if (w)
-			*w = mw;
+			*w = cacheItem->second.width;
 		if (h)
-			*h = mh;
+			*h = cacheItem->second.height;
 		return;
 	}
 
@@ -821,27 +862,35 @@ static void PPGeResetCurrentText() {
 	char_lines_metrics = zeroBox;
 }
 
+static void PPGeCurrentTextVertices(float dx, float dy, u32 color) {
+	float scale = char_lines_metrics.scale;
+	for (auto i = char_lines.begin(); i != char_lines.end(); ++i)
+	{
+		for (auto j = i->begin(); j != i->end(); ++j)
+		{
+			float cx1 = j->x + dx;
+			float cy1 = j->y + dy;
+			const AtlasChar &c = *j->c;
+			float cx2 = cx1 + c.pw * scale;
+			float cy2 = cy1 + c.ph * scale;
+			Vertex(cx1, cy1, c.sx, c.sy, atlasWidth, atlasHeight, color);
+			Vertex(cx2, cy2, c.ex, c.ey, atlasWidth, atlasHeight, color);
+		}
+	}
+}
+
 // Draws some text using the one font we have.
-// Mostly rewritten.
-void PPGeDrawCurrentText(u32 color)
+// Mostly rewritten.  The shadow, if any, is part of the same draw.
+void PPGeDrawCurrentText(u32 color, bool hasShadow, u32 shadowColor)
 {
 	if (dlPtr)
 	{
-		float scale = char_lines_metrics.scale;
 		BeginVertexData();
-		for (auto i = char_lines.begin(); i != char_lines.end(); ++i)
-		{
-			for (auto j = i->begin(); j != i->end(); ++j)
-			{
-				float cx1 = j->x;
-				float cy1 = j->y;
-				const AtlasChar &c = *j->c;
-				float cx2 = cx1 + c.pw * scale;
-				float cy2 = cy1 + c.ph * scale;
-				Vertex(cx1, cy1, c.sx, c.sy, atlasWidth, atlasHeight, color);
-				Vertex(cx2, cy2, c.ex, c.ey, atlasWidth, atlasHeight, color);
-			}
+		if (hasShadow) {
+			// This doesn't have the nicer shadow because it's so many verts.
+			PPGeCurrentTextVertices(1.0f, 2.0f, shadowColor);
 		}
+		PPGeCurrentTextVertices(0.0f, 0.0f, color);
 		EndVertexDataAndDraw(GE_PRIM_RECTANGLES);
 	}
 	PPGeResetCurrentText();
@@ -1013,6 +1062,14 @@ static void PPGeDecimateTextImages(int age) {
 			++it;
 		}
 	}
+
+	for (auto it = textLayouts.begin(); it != textLayouts.end(); ) {
+		if (gpuStats.numFlips - it->second.lastUsedFrame >= age) {
+			it = textLayouts.erase(it);
+		} else {
+			++it;
+		}
+	}
 }
 
 void PPGeDrawText(const char *text, float x, float y, const PPGeStyle &style) {
@@ -1032,14 +1089,8 @@ void PPGeDrawText(const char *text, float x, float y, const PPGeStyle &style) {
 		}
 	}
 
-	if (style.hasShadow) {
-		// This doesn't have the nicer shadow because it's so many verts.
-		PPGePrepareText(text, x + 1, y + 2, style.align, style.scale, style.scale, PPGE_LINE_USE_ELLIPSIS);
-		PPGeDrawCurrentText(style.shadowColor);
-	}
-
 	PPGePrepareText(text, x, y, style.align, style.scale, style.scale, PPGE_LINE_USE_ELLIPSIS);
-	PPGeDrawCurrentText(style.color);
+	PPGeDrawCurrentText(style.color, style.hasShadow, style.shadowColor);
 }
 
 static std::string StripTrailingWhite(const std::string &s) {
@@ -1076,44 +1127,53 @@ void PPGeDrawTextWrapped(const char *text, float x, float y, float wrapWidth, fl
 	float maxScaleDown = zoom == 1 ? 1.3f : 2.0f;
 
 	if (HasTextDrawer()) {
-		std::string s2 = ReplaceAll(s, "&", "&&");
-
-		float actualWidth, actualHeight;
-		Bounds b(0, 0, wrapWidth <= 0 ? 480.0f - x : wrapWidth, wrapHeight);
-		int tdalign = 0;
-		textDrawer->SetFontScale(style.scale, style.scale);
-		textDrawer->MeasureStringRect(s2.c_str(), s2.size(), b, &actualWidth, &actualHeight, tdalign | FLAG_WRAP_TEXT);
+		float maxWidth = wrapWidth <= 0 ? 480.0f - x : wrapWidth;
+		// The scale down limit is part of the key, since it changes the cropping.
+		PPGeTextLayoutCacheKey key{ s, FLAG_WRAP_TEXT, style.scale, maxWidth, wrapHeight * maxScaleDown };
+		auto cacheItem = textLayouts.find(key);
+		if (cacheItem == textLayouts.end()) {
+			std::string s2 = ReplaceAll(s, "&", "&&");
+
+			float actualWidth, actualHeight;
+			Bounds b(0, 0, maxWidth, wrapHeight);
+			int tdalign = 0;
+			textDrawer->SetFontScale(style.scale, style.scale);
+			textDrawer->MeasureStringRect(s2.c_str(), s2.size(), b, &actualWidth, &actualHeight, tdalign | FLAG_WRAP_TEXT);
+
+			// Check if we need to scale the text down to fit better.
+			float scale = style.scale;
+			if (wrapHeight != 0.0f && actualHeight > wrapHeight) {
+				// Cheap way to get the line height.
+				float oneLine, twoLines;
+				textDrawer->MeasureString("|", 1, &actualWidth, &oneLine);
+				textDrawer->MeasureStringRect("|\n|", 3, Bounds(0, 0, 480, 272), &actualWidth, &twoLines);
+
+				float lineHeight = twoLines - oneLine;
+				if (actualHeight > wrapHeight * maxScaleDown) {
+					float maxLines = floor(wrapHeight * maxScaleDown / lineHeight);
+					actualHeight = (maxLines + 1) * lineHeight;
+					// Add an ellipsis if it's just too long to be readable.
+					// On a PSP, it does this without scaling it down.
+					s2 = StripTrailingWhite(CropLinesToCount(s2, (int)maxLines)) + "\n...";
+				}
 
-		// Check if we need to scale the text down to fit better.
-		PPGeStyle adjustedStyle = style;
-		if (wrapHeight != 0.0f && actualHeight > wrapHeight) {
-			// Cheap way to get the line height.
-			float oneLine, twoLines;
-			textDrawer->MeasureString("|", 1, &actualWidth, &oneLine);
-			textDrawer->MeasureStringRect("|\n|", 3, Bounds(0, 0, 480, 272), &actualWidth, &twoLines);
-
-			float lineHeight = twoLines - oneLine;
-			if (actualHeight > wrapHeight * maxScaleDown) {
-				float maxLines = floor(wrapHeight * maxScaleDown / lineHeight);
-				actualHeight = (maxLines + 1) * lineHeight;
-				// Add an ellipsis if it's just too long to be readable.
-				// On a PSP, it does this without scaling it down.
-				s2 = StripTrailingWhite(CropLinesToCount(s2, (int)maxLines)) + "\n...";
+				scale *= wrapHeight / actualHeight;
 			}
 
-			adjustedStyle.scale *= wrapHeight / actualHeight;
+			cacheItem = textLayouts.emplace(key, PPGeTextLayout{ s2, scale, actualWidth, actualHeight }).first;
 		}
+		cacheItem->second.lastUsedFrame = gpuStats.numFlips;
 
-		PPGeTextDrawerImage im = PPGeGetTextImage(s2.c_str(), adjustedStyle, wrapWidth <= 0 ? 480.0f - x : wrapWidth, true);
+		PPGeStyle adjustedStyle = style;
+		adjustedStyle.scale = cacheItem->second.scale;
+		PPGeTextDrawerImage im = PPGeGetTextImage(cacheItem->second.text.c_str(), adjustedStyle, maxWidth, true);
 		if (im.ptr) {
 			PPGeDrawTextImage(im, x, y, adjustedStyle);
 			return;
 		}
 	}
 
-	int sx = style.hasShadow ? 1 : 0;
-	int sy = style.hasShadow ? 2 : 0;
-	PPGePrepareText(s.c_str(), x + sx, y + sy, style.align, style.scale, style.scale, PPGE_LINE_USE_ELLIPSIS | PPGE_LINE_WRAP_WORD, wrapWidth);
+	PPGePrepareText(s.c_str(), x, y, style.align, style.scale, style.scale, PPGE_LINE_USE_ELLIPSIS | PPGE_LINE_WRAP_WORD, wrapWidth);
 
 	float scale = style.scale;
 	float lineHeightScale = style.scale;
@@ -1133,14 +1193,9 @@ void PPGeDrawTextWrapped(const char *text, float x, float y, float wrapWidth, fl
 		// Try to keep the font as large as possible, so reduce the line height some.
 		scale = reduced * 1.15f;
 		lineHeightScale = reduced;
-		PPGePrepareText(s.c_str(), x + sx, y + sy, style.align, scale, lineHeightScale, PPGE_LINE_USE_ELLIPSIS | PPGE_LINE_WRAP_WORD, wrapWidth);
-	}
-	if (style.hasShadow) {
-		// This doesn't have the nicer shadow because it's so many verts.
-		PPGeDrawCurrentText(style.shadowColor);
 		PPGePrepareText(s.c_str(), x, y, style.align, scale, lineHeightScale, PPGE_LINE_USE_ELLIPSIS | PPGE_LINE_WRAP_WORD, wrapWidth);
 	}
-	PPGeDrawCurrentText(style.color);
+	PPGeDrawCurrentText(style.color, style.hasShadow, style.shadowColor);
 }
 
 // Draws a "4-patch" for button-like things that can be resized
@@ -187,8 +187,12 @@ bool FramebufferManagerCommon::ReadbackDepthbuffer(Draw::Framebuffer *fbo, int x
 	float scaleX = (float)destW / w;
 	float scaleY = (float)destH / h;
 
-	bool useColorPath = gl_extensions.IsGLES || scaleX != 1.0f || scaleY != 1.0f;
+	// Delayed readbacks are cached per source framebuffer, so they can't go through the shared
+	// temp FBO of the color path. If the depth can be copied directly, skip the shader and
+	// pick the pixels out of the full resolution copy on the CPU instead.
+	bool useColorPath = gl_extensions.IsGLES || ((scaleX != 1.0f || scaleY != 1.0f) && mode != ReadbackMode::OLD_DATA_OK);
 	bool format16Bit = false;
+	bool success;
 
 	if (useColorPath) {
 		if (!depthReadbackPipeline_) {
@@ -203,12 +207,20 @@ bool FramebufferManagerCommon::ReadbackDepthbuffer(Draw::Framebuffer *fbo, int x
 			depthReadbackSampler_ = draw_->CreateSamplerState({});
 		}
 
+		if (mode == ReadbackMode::OLD_DATA_OK) {
+			mode = ReadbackMode::BLOCK;
+		}
+
 		shaderManager_->DirtyLastShader();
-		auto *blitFBO = GetTempFBO(TempFBO::Z_COPY, fbo->Width() * scaleX, fbo->Height() * scaleY);
+		const int blitW = fbo->Width() * scaleX;
+		const int blitH = fbo->Height() * scaleY;
+		auto *blitFBO = GetTempFBO(TempFBO::Z_COPY, blitW, blitH);
 		draw_->BindFramebufferAsRenderTarget(blitFBO, { RPAction::DONT_CARE, RPAction::DONT_CARE, RPAction::DONT_CARE }, "ReadbackDepthbufferSync");
-		Draw::Viewport viewport = { 0.0f, 0.0f, (float)destW, (float)destH, 0.0f, 1.0f };
+		// The viewport covers the whole target so it maps 1:1 to the source, but only the rows
+		// and columns we read back need to be shaded.
+		Draw::Viewport viewport = { 0.0f, 0.0f, (float)blitW, (float)blitH, 0.0f, 1.0f };
 		draw_->SetViewport(viewport);
-		draw_->SetScissorRect(0, 0, fbo->Width() * scaleX, fbo->Height() * scaleY);
+		draw_->SetScissorRect(x * scaleX, y * scaleY, destW, destH);
 
 		draw_->BindFramebufferAsTexture(fbo, TEX_SLOT_PSP_TEXTURE, FB_DEPTH_BIT, 0);
 		draw_->BindSamplerStates(TEX_SLOT_PSP_TEXTURE, 1, &depthReadbackSampler_);
@@ -241,7 +253,7 @@ bool FramebufferManagerCommon::ReadbackDepthbuffer(Draw::Framebuffer *fbo, int x
 		};
 		draw_->DrawUP(positions, 3);
 
-		draw_->CopyFramebufferToMemory(blitFBO, FB_COLOR_BIT,
+		success = draw_->CopyFramebufferToMemory(blitFBO, FB_COLOR_BIT,
 			x * scaleX, y * scaleY, w * scaleX, h * scaleY,
 			DataFormat::R8G8B8A8_UNORM, convBuf_, destW, mode, "ReadbackDepthbufferSync");
 
@@ -249,10 +261,22 @@ bool FramebufferManagerCommon::ReadbackDepthbuffer(Draw::Framebuffer *fbo, int x
 		// TODO: Use 4444 (or better, R16_UNORM) so we can copy lines directly (instead of 32 -> 16 on CPU)?
 		format16Bit = true;
 	} else {
-		draw_->CopyFramebufferToMemory(fbo, FB_DEPTH_BIT, x, y, w, h, DataFormat::D32F, convBuf_, w, mode, "ReadbackDepthbufferSync");
+		const u32 fullSize = w * h * 4;
+		if (convBufSize_ < fullSize) {
+			delete[] convBuf_;
+			convBuf_ = new u8[fullSize];
+			convBufSize_ = fullSize;
+		}
+		success = draw_->CopyFramebufferToMemory(fbo, FB_DEPTH_BIT, x, y, w, h, DataFormat::D32F, convBuf_, w, mode, "ReadbackDepthbufferSync");
 		format16Bit = false;
 	}
 
+	if (!success) {
+		// A delayed readback may have nothing ready yet, leave the memory alone.
+		gstate_c.Dirty(DIRTY_ALL_RENDER_STATE);
+		return false;
+	}
+
 	// TODO: Move this conversion into the backends.
 	if (format16Bit) {
 		// In this case, we used the shader to apply depth scale factors.
@@ -268,13 +292,15 @@ bool FramebufferManagerCommon::ReadbackDepthbuffer(Draw::Framebuffer *fbo, int x
 		}
 	} else {
 		// TODO: Apply this in the shader?  May have precision issues if it becomes important to match.
-		// We downloaded float values directly in this case.
+		// We downloaded float values directly in this case, at full resolution.
 		uint16_t *dest = pixels;
-		const float *packedf = (float *)convBuf_;
 		DepthScaleFactors depthScale = GetDepthScaleFactors(gstate_c.UseFlags());
+		const int stepX = std::max(1, w / destW);
+		const int stepY = std::max(1, h / destH);
 		for (int yp = 0; yp < destH; ++yp) {
+			const float *packedf = (const float *)convBuf_ + yp * stepY * w;
 			for (int xp = 0; xp < destW; ++xp) {
-				float scaled = depthScale.DecodeToU16(packedf[xp]);
+				float scaled = depthScale.DecodeToU16(packedf[xp * stepX]);
 				if (scaled <= 0.0f) {
 					dest[xp] = 0;
 				} else if (scaled >= 65535.0f) {
@@ -284,7 +310,6 @@ bool FramebufferManagerCommon::ReadbackDepthbuffer(Draw::Framebuffer *fbo, int x
 				}
 			}
 			dest += pixelsStride;
-			packedf += destW;
 		}
 	}
 
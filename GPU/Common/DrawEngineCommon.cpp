@@ -18,9 +18,12 @@
 #include <algorithm>
 #include <cfloat>
 
+#include "Common/Data/Collections/LinearArena.h"
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/Math/lin/matrix4x4.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Common/LogReporting.h"
 #include "Core/Config.h"
 #include "GPU/Common/DrawEngineCommon.h"
@@ -35,7 +38,7 @@ enum {
 	TRANSFORMED_VERTEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * sizeof(TransformedVertex)
 };
 
-DrawEngineCommon::DrawEngineCommon() : decoderMap_(16) {
+DrawEngineCommon::DrawEngineCommon() : decoderMap_(16), tessCache_(16), drawBounds_(64) {
 	if (g_Config.bVertexDecoderJit && g_Config.iCpuCore == (int)CPUCore::JIT) {
 		decJitCache_ = new VertexDecoderJitCache();
 	}
@@ -51,6 +54,8 @@ DrawEngineCommon::~DrawEngineCommon() {
 		delete decoder;
 	});
 	ClearSplineBezierWeights();
+	ClearTessellationCache();
+	ClearDrawBounds();
 }
 
 void DrawEngineCommon::Init() {
@@ -97,11 +102,59 @@ int DrawEngineCommon::ComputeNumVertsToDecode() const {
 	return vertsToDecode;
 }
 
+// Below this many vertices in a batch, it's not worth waking up the worker threads.
+static const int PARALLEL_DECODE_MIN_VERTS = 4096;
+static const int PARALLEL_DECODE_MIN_VERTS_PER_TASK = 1024;
+
+bool DrawEngineCommon::CanDecodeVertsInParallel() const {
+	if (!dec_->CanDecodeInParallel())
+		return false;
+
+	// The jit reads the UV scale from gstate_c, so it needs to be the same for the whole batch.
+	const UVScale &uvScale = drawCalls[decodeCounter_].uvScale;
+	int verts = 0;
+	for (int i = decodeCounter_; i < numDrawCalls; i++) {
+		const DeferredDrawCall &dc = drawCalls[i];
+		if (memcmp(&dc.uvScale, &uvScale, sizeof(uvScale)) != 0)
+			return false;
+		// Only an estimate, calls sharing vertex data will count their overlap twice.
+		verts += dc.indexUpperBound - dc.indexLowerBound + 1;
+	}
+	return verts >= PARALLEL_DECODE_MIN_VERTS;
+}
+
+void DrawEngineCommon::DecodeVertsParallel(u8 *dest) {
+	// First generate all the indices and lay out the decoded vertices, which must be serial.
+	deferredRanges_.clear();
+	const int firstVert = decodedVerts_;
+	for (; decodeCounter_ < numDrawCalls; decodeCounter_++) {
+		DecodeVertsStep(dest, decodeCounter_, decodedVerts_, &deferredRanges_);  // NOTE! DecodeVertsStep can modify decodeCounter_!
+	}
+
+	// The output ranges are contiguous, so we can split them up by vertex rather than by draw call.
+	const int stride = (int)dec_->GetDecVtxFmt().stride;
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		for (const DeferredVertexRange &range : deferredRanges_) {
+			int start = std::max(lower, range.outStart);
+			int end = std::min(upper, range.outStart + range.count);
+			if (start >= end)
+				continue;
+			int srcLower = range.indexLowerBound + (start - range.outStart);
+			dec_->DecodeVerts(dest + start * stride, range.verts, srcLower, srcLower + (end - start) - 1);
+		}
+	}, firstVert, decodedVerts_, PARALLEL_DECODE_MIN_VERTS_PER_TASK, TaskPriority::HIGH);
+}
+
 void DrawEngineCommon::DecodeVerts(u8 *dest) {
 	const UVScale origUV = gstate_c.uv;
-	for (; decodeCounter_ < numDrawCalls; decodeCounter_++) {
+	if (decodeCounter_ < numDrawCalls && CanDecodeVertsInParallel()) {
 		gstate_c.uv = drawCalls[decodeCounter_].uvScale;
-		DecodeVertsStep(dest, decodeCounter_, decodedVerts_);  // NOTE! DecodeVertsStep can modify decodeCounter_!
+		DecodeVertsParallel(dest);
+	} else {
+		for (; decodeCounter_ < numDrawCalls; decodeCounter_++) {
+			gstate_c.uv = drawCalls[decodeCounter_].uvScale;
+			DecodeVertsStep(dest, decodeCounter_, decodedVerts_);  // NOTE! DecodeVertsStep can modify decodeCounter_!
+		}
 	}
 	gstate_c.uv = origUV;
 
@@ -180,6 +233,8 @@ void DrawEngineCommon::NotifyConfigChanged() {
 	});
 	decoderMap_.Clear();
 	ClearTrackedVertexArrays();
+	ClearTessellationCache();
+	ClearDrawBounds();
 
 	useHWTransform_ = g_Config.bHardwareTransform;
 	useHWTessellation_ = UpdateUseHWTessellation(g_Config.bHardwareTessellation);
@@ -204,8 +259,7 @@ void DrawEngineCommon::DispatchSubmitImm(GEPrimitiveType prim, TransformedVertex
 		uint32_t color;
 		float xyz[3];
 	};
-	std::vector<ImmVertex> temp;
-	temp.resize(vertexCount);
+	ImmVertex *temp = gpuFrameArena.AllocateArray<ImmVertex>(vertexCount);
 	uint32_t color1Used = 0;
 	for (int i = 0; i < vertexCount; i++) {
 		// Since we're sending through, scale back up to w/h.
@@ -236,8 +290,9 @@ void DrawEngineCommon::DispatchSubmitImm(GEPrimitiveType prim, TransformedVertex
 
 	int bytesRead;
 	uint32_t vertTypeID = GetVertTypeID(vtype, 0, decOptions_.applySkinInDecode);
-	SubmitPrim(&temp[0], nullptr, prim, vertexCount, vertTypeID, cullMode, &bytesRead);
+	SubmitPrim(temp, nullptr, prim, vertexCount, vertTypeID, cullMode, &bytesRead);
 	DispatchFlush();
+	gpuFrameArena.Free(temp, sizeof(ImmVertex) * vertexCount);
 
 	if (!prevThrough) {
 		gstate.vertType &= ~GE_VTYPE_THROUGH;
@@ -245,58 +300,10 @@ void DrawEngineCommon::DispatchSubmitImm(GEPrimitiveType prim, TransformedVertex
 	}
 }
 
-// This code has plenty of potential for optimization.
-//
-// It does the simplest and safest test possible: If all points of a bbox is outside a single of
-// our clipping planes, we reject the box. Tighter bounds would be desirable but would take more calculations.
-bool DrawEngineCommon::TestBoundingBox(const void *control_points, const void *inds, int vertexCount, u32 vertType) {
-	SimpleVertex *corners = (SimpleVertex *)(decoded + 65536 * 12);
-	float *verts = (float *)(decoded + 65536 * 18);
-
-	// Although this may lead to drawing that shouldn't happen, the viewport is more complex on VR.
-	// Let's always say objects are within bounds.
-	if (gstate_c.Use(GPU_USE_VIRTUAL_REALITY))
-		return true;
-
-	// Try to skip NormalizeVertices if it's pure positions. No need to bother with a vertex decoder
-	// and a large vertex format.
-	if ((vertType & 0xFFFFFF) == GE_VTYPE_POS_FLOAT && !inds) {
-		verts = (float *)control_points;
-	} else if ((vertType & 0xFFFFFF) == GE_VTYPE_POS_8BIT && !inds) {
-		const s8 *vtx = (const s8 *)control_points;
-		for (int i = 0; i < vertexCount * 3; i++) {
-			verts[i] = vtx[i] * (1.0f / 128.0f);
-		}
-	} else if ((vertType & 0xFFFFFF) == GE_VTYPE_POS_16BIT && !inds) {
-		const s16 *vtx = (const s16*)control_points;
-		for (int i = 0; i < vertexCount * 3; i++) {
-			verts[i] = vtx[i] * (1.0f / 32768.0f);
-		}
-	} else {
-		// Simplify away indices, bones, and morph before proceeding.
-		u8 *temp_buffer = decoded + 65536 * 24;
-		int vertexSize = 0;
-
-		u16 indexLowerBound = 0;
-		u16 indexUpperBound = (u16)vertexCount - 1;
-		if (vertexCount > 0 && inds) {
-			GetIndexBounds(inds, vertexCount, vertType, &indexLowerBound, &indexUpperBound);
-		}
-
-		// Force software skinning.
-		bool wasApplyingSkinInDecode = decOptions_.applySkinInDecode;
-		decOptions_.applySkinInDecode = true;
-		NormalizeVertices((u8 *)corners, temp_buffer, (const u8 *)control_points, indexLowerBound, indexUpperBound, vertType);
-		decOptions_.applySkinInDecode = wasApplyingSkinInDecode;
-
-		IndexConverter conv(vertType, inds);
-		for (int i = 0; i < vertexCount; i++) {
-			verts[i * 3] = corners[conv(i)].pos.x;
-			verts[i * 3 + 1] = corners[conv(i)].pos.y;
-			verts[i * 3 + 2] = corners[conv(i)].pos.z;
-		}
-	}
-
+// Tests whether any of the points may be drawn, considering the current matrices, the scissor/region
+// and offset. If all points are outside a single one of the clipping planes, nothing can be.
+// Near/far can be skipped, since how the PSP handles depth outside the range depends on more than the planes.
+static bool TestPointsInCullbox(const float *verts, int vertexCount, bool checkDepth) {
 	Plane planes[6];
 
 	float world[16];
@@ -337,7 +344,7 @@ bool DrawEngineCommon::TestBoundingBox(const void *control_points, const void *i
 
 	PlanesFromMatrix(screenBounds, planes);
 	// Note: near/far are not checked without clamp/clip enabled, so we skip those planes.
-	int totalPlanes = gstate.isDepthClampEnabled() ? 6 : 4;
+	int totalPlanes = checkDepth && gstate.isDepthClampEnabled() ? 6 : 4;
 	for (int plane = 0; plane < totalPlanes; plane++) {
 		int inside = 0;
 		int out = 0;
@@ -373,6 +380,61 @@ bool DrawEngineCommon::TestBoundingBox(const void *control_points, const void *i
 	return true;
 }
 
+// This code has plenty of potential for optimization.
+//
+// It does the simplest and safest test possible: If all points of a bbox is outside a single of
+// our clipping planes, we reject the box. Tighter bounds would be desirable but would take more calculations.
+bool DrawEngineCommon::TestBoundingBox(const void *control_points, const void *inds, int vertexCount, u32 vertType) {
+	SimpleVertex *corners = (SimpleVertex *)(decoded + 65536 * 12);
+	float *verts = (float *)(decoded + 65536 * 18);
+
+	// Although this may lead to drawing that shouldn't happen, the viewport is more complex on VR.
+	// Let's always say objects are within bounds.
+	if (gstate_c.Use(GPU_USE_VIRTUAL_REALITY))
+		return true;
+
+	// Try to skip NormalizeVertices if it's pure positions. No need to bother with a vertex decoder
+	// and a large vertex format.
+	if ((vertType & 0xFFFFFF) == GE_VTYPE_POS_FLOAT && !inds) {
+		verts = (float *)control_points;
+	} else if ((vertType & 0xFFFFFF) == GE_VTYPE_POS_8BIT && !inds) {
+		const s8 *vtx = (const s8 *)control_points;
+		for (int i = 0; i < vertexCount * 3; i++) {
+			verts[i] = vtx[i] * (1.0f / 128.0f);
+		}
+	} else if ((vertType & 0xFFFFFF) == GE_VTYPE_POS_16BIT && !inds) {
+		const s16 *vtx = (const s16*)control_points;
+		for (int i = 0; i < vertexCount * 3; i++) {
+			verts[i] = vtx[i] * (1.0f / 32768.0f);
+		}
+	} else {
+		// Simplify away indices, bones, and morph before proceeding.
+		u8 *temp_buffer = decoded + 65536 * 24;
+		int vertexSize = 0;
+
+		u16 indexLowerBound = 0;
+		u16 indexUpperBound = (u16)vertexCount - 1;
+		if (vertexCount > 0 && inds) {
+			GetIndexBounds(inds, vertexCount, vertType, &indexLowerBound, &indexUpperBound);
+		}
+
+		// Force software skinning.
+		bool wasApplyingSkinInDecode = decOptions_.applySkinInDecode;
+		decOptions_.applySkinInDecode = true;
+		NormalizeVertices((u8 *)corners, temp_buffer, (const u8 *)control_points, indexLowerBound, indexUpperBound, vertType);
+		decOptions_.applySkinInDecode = wasApplyingSkinInDecode;
+
+		IndexConverter conv(vertType, inds);
+		for (int i = 0; i < vertexCount; i++) {
+			verts[i * 3] = corners[conv(i)].pos.x;
+			verts[i * 3 + 1] = corners[conv(i)].pos.y;
+			verts[i * 3 + 2] = corners[conv(i)].pos.z;
+		}
+	}
+
+	return TestPointsInCullbox(verts, vertexCount, true);
+}
+
 // TODO: This probably is not the best interface.
 bool DrawEngineCommon::GetCurrentSimpleVertices(int count, std::vector<GPUDebugVertex> &vertices, std::vector<u16> &indices) {
 	// This is always for the current vertices.
@@ -607,7 +669,7 @@ void DrawEngineCommon::ApplyFramebufferRead(FBOTexState *fboTexState) {
 	gstate_c.Dirty(DIRTY_SHADERBLEND);
 }
 
-void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
+void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts, std::vector<DeferredVertexRange> *ranges) {
 	PROFILE_THIS_SCOPE("vertdec");
 
 	const DeferredDrawCall &dc = drawCalls[i];
@@ -618,8 +680,12 @@ void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
 
 	if (dc.indexType == GE_VTYPE_IDX_NONE >> GE_VTYPE_IDX_SHIFT) {
 		// Decode the verts (and at the same time apply morphing/skinning). Simple.
-		dec_->DecodeVerts(dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
-			dc.verts, indexLowerBound, indexUpperBound);
+		if (ranges) {
+			ranges->push_back({ dc.verts, indexLowerBound, decodedVerts, indexUpperBound - indexLowerBound + 1 });
+		} else {
+			dec_->DecodeVerts(dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
+				dc.verts, indexLowerBound, indexUpperBound);
+		}
 		decodedVerts += indexUpperBound - indexLowerBound + 1;
 		
 		bool clockwise = true;
@@ -685,8 +751,12 @@ void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
 		}
 
 		// 3. Decode that range of vertex data.
-		dec_->DecodeVerts(dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
-			dc.verts, indexLowerBound, indexUpperBound);
+		if (ranges) {
+			ranges->push_back({ dc.verts, indexLowerBound, decodedVerts, vertexCount });
+		} else {
+			dec_->DecodeVerts(dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
+				dc.verts, indexLowerBound, indexUpperBound);
+		}
 		decodedVerts += vertexCount;
 
 		// 4. Advance indexgen vertex counter.
@@ -740,6 +810,38 @@ u32 DrawEngineCommon::ComputeMiniHash() {
 	return fullhash;
 }
 
+bool DrawEngineCommon::VertexCacheHashMatches(VertexArrayInfo *vai) {
+	if (vai->drawsUntilNextFullHash == 0) {
+		// Let's try to skip a full hash if mini would fail.
+		const u32 newMiniHash = ComputeMiniHash();
+		uint64_t newHash = vai->hash;
+		if (newMiniHash == vai->minihash) {
+			newHash = ComputeHash();
+		}
+		if (newMiniHash != vai->minihash || newHash != vai->hash) {
+			return false;
+		}
+		if (vai->numVerts > 64) {
+			// exponential backoff up to 16 draws, then every 24
+			vai->drawsUntilNextFullHash = std::min(24, vai->numFrames);
+		} else {
+			// Lower numbers seem much more likely to change.
+			vai->drawsUntilNextFullHash = 0;
+		}
+		// TODO: tweak
+		//if (vai->numFrames > 1000) {
+		//	vai->status = VertexArrayInfo::VAI_RELIABLE;
+		//}
+	} else {
+		vai->drawsUntilNextFullHash--;
+		u32 newMiniHash = ComputeMiniHash();
+		if (newMiniHash != vai->minihash) {
+			return false;
+		}
+	}
+	return true;
+}
+
 uint64_t DrawEngineCommon::ComputeHash() {
 	uint64_t fullhash = 0;
 	const int vertexSize = dec_->GetDecVtxFmt().stride;
@@ -777,6 +879,99 @@ uint64_t DrawEngineCommon::ComputeHash() {
 	return fullhash;
 }
 
+void DrawEngineCommon::ClearDrawBounds() {
+	drawBounds_.Iterate([&](u32 hash, DrawBounds *bounds) {
+		delete bounds;
+	});
+	drawBounds_.Clear();
+}
+
+bool DrawEngineCommon::IsDrawOffscreen(const void *verts, u32 vertTypeID, int indexLowerBound, int indexUpperBound) {
+	// Skinning and morphing move the positions around, so the raw positions don't bound anything.
+	if (vertTypeID & (GE_VTYPE_WEIGHT_MASK | GE_VTYPE_MORPHCOUNT_MASK | GE_VTYPE_THROUGH_MASK))
+		return false;
+	// Same as TestBoundingBox, the viewport is more complex in VR.
+	if (gstate_c.Use(GPU_USE_VIRTUAL_REALITY))
+		return false;
+
+	const int vertexSize = dec_->VertexSize();
+	const u8 *start = (const u8 *)verts + vertexSize * indexLowerBound;
+	const int count = indexUpperBound - indexLowerBound + 1;
+	const u32 minihash = ComputeMiniHashRange(start, vertexSize * count);
+
+	u32 key = __rotl((u32)(uintptr_t)verts, 13) ^ __rotl(vertTypeID, 7) ^ (indexLowerBound << 16) ^ indexUpperBound;
+	DrawBounds *bounds = drawBounds_.Get(key);
+	bool match = bounds && bounds->verts == verts && bounds->vertType == vertTypeID && bounds->indexLowerBound == indexLowerBound && bounds->indexUpperBound == indexUpperBound;
+	if (!match || bounds->minihash != minihash || bounds->drawsUntilRecompute-- <= 0) {
+		if (!bounds) {
+			// Games that stream geometry can create a lot of these, just start over.
+			if (drawBounds_.size() >= 4096)
+				ClearDrawBounds();
+			bounds = new DrawBounds();
+			drawBounds_.Insert(key, bounds);
+		}
+		bounds->verts = verts;
+		bounds->vertType = vertTypeID;
+		bounds->indexLowerBound = indexLowerBound;
+		bounds->indexUpperBound = indexUpperBound;
+		bounds->minihash = minihash;
+		bounds->drawsUntilRecompute = 16;
+
+		float mins[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float maxs[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		const u8 *pos = start + dec_->PositionOffset();
+		switch (vertTypeID & GE_VTYPE_POS_MASK) {
+		case GE_VTYPE_POS_8BIT:
+			for (int i = 0; i < count; i++, pos += vertexSize) {
+				const s8 *p = (const s8 *)pos;
+				for (int j = 0; j < 3; j++) {
+					mins[j] = std::min(mins[j], p[j] * (1.0f / 128.0f));
+					maxs[j] = std::max(maxs[j], p[j] * (1.0f / 128.0f));
+				}
+			}
+			break;
+		case GE_VTYPE_POS_16BIT:
+			for (int i = 0; i < count; i++, pos += vertexSize) {
+				const s16 *p = (const s16 *)pos;
+				for (int j = 0; j < 3; j++) {
+					mins[j] = std::min(mins[j], p[j] * (1.0f / 32768.0f));
+					maxs[j] = std::max(maxs[j], p[j] * (1.0f / 32768.0f));
+				}
+			}
+			break;
+		case GE_VTYPE_POS_FLOAT:
+			for (int i = 0; i < count; i++, pos += vertexSize) {
+				const float *p = (const float *)pos;
+				for (int j = 0; j < 3; j++) {
+					// Written so NaNs make the bounds infinite, rather than silently dropped.
+					mins[j] = p[j] >= mins[j] ? mins[j] : p[j];
+					maxs[j] = p[j] <= maxs[j] ? maxs[j] : p[j];
+				}
+			}
+			break;
+		default:
+			bounds->minihash = ~minihash;
+			return false;
+		}
+		memcpy(bounds->mins, mins, sizeof(mins));
+		memcpy(bounds->maxs, maxs, sizeof(maxs));
+	}
+
+	for (int j = 0; j < 3; j++) {
+		if (!(bounds->mins[j] <= bounds->maxs[j]) || bounds->mins[j] == -INFINITY || bounds->maxs[j] == INFINITY)
+			return false;
+	}
+
+	float corners[8 * 3];
+	for (int i = 0; i < 8; i++) {
+		corners[i * 3 + 0] = (i & 1) ? bounds->maxs[0] : bounds->mins[0];
+		corners[i * 3 + 1] = (i & 2) ? bounds->maxs[1] : bounds->mins[1];
+		corners[i * 3 + 2] = (i & 4) ? bounds->maxs[2] : bounds->mins[2];
+	}
+	// Only X/Y, to stay conservative for draws.
+	return !TestPointsInCullbox(corners, 8, false);
+}
+
 // Cheap bit scrambler from https://nullprogram.com/blog/2018/07/31/
 inline uint32_t lowbias32_r(uint32_t x) {
 	x ^= x >> 16;
@@ -790,6 +985,12 @@ inline uint32_t lowbias32_r(uint32_t x) {
 // vertTypeID is the vertex type but with the UVGen mode smashed into the top bits.
 void DrawEngineCommon::SubmitPrim(const void *verts, const void *inds, GEPrimitiveType prim, int vertexCount, u32 vertTypeID, int cullMode, int *bytesRead) {
 	if (!indexGen.PrimCompatible(prevPrim_, prim) || numDrawCalls >= MAX_DEFERRED_DRAW_CALLS || vertexCountInDrawCalls_ + vertexCount > VERTEX_BUFFER_MAX) {
+		if (numDrawCalls > 0) {
+			if (!indexGen.PrimCompatible(prevPrim_, prim))
+				gpuStats.numFlushesPrimChange++;
+			else
+				gpuStats.numFlushesBufferFull++;
+		}
 		DispatchFlush();
 	}
 
@@ -816,6 +1017,19 @@ void DrawEngineCommon::SubmitPrim(const void *verts, const void *inds, GEPrimiti
 	if ((vertexCount < 2 && prim > 0) || (vertexCount < 3 && prim > GE_PRIM_LINE_STRIP && prim != GE_PRIM_RECTANGLES))
 		return;
 
+	u16 indexLowerBound = 0;
+	u16 indexUpperBound = vertexCount - 1;
+	if (inds) {
+		GetIndexBounds(inds, vertexCount, vertTypeID, &indexLowerBound, &indexUpperBound);
+	}
+
+	if (g_Config.bCullOffscreenDraws && gstate_c.submitType == SubmitType::DRAW && CanUseHardwareTransform(prim)) {
+		if (IsDrawOffscreen(verts, vertTypeID, indexLowerBound, indexUpperBound)) {
+			gpuStats.numCulledDraws++;
+			return;
+		}
+	}
+
 	if (g_Config.bVertexCache) {
 		u32 dhash = dcid_;
 		dhash = __rotl(dhash ^ (u32)(uintptr_t)verts, 13);
@@ -833,12 +1047,8 @@ void DrawEngineCommon::SubmitPrim(const void *verts, const void *inds, GEPrimiti
 	dc.prim = prim;
 	dc.cullMode = cullMode;
 	dc.uvScale = gstate_c.uv;
-	if (inds) {
-		GetIndexBounds(inds, vertexCount, vertTypeID, &dc.indexLowerBound, &dc.indexUpperBound);
-	} else {
-		dc.indexLowerBound = 0;
-		dc.indexUpperBound = vertexCount - 1;
-	}
+	dc.indexLowerBound = indexLowerBound;
+	dc.indexUpperBound = indexUpperBound;
 
 	numDrawCalls++;
 	vertexCountInDrawCalls_ += vertexCount;
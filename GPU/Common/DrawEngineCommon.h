@@ -17,11 +17,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <utility>
 #include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Data/Collections/Hashmaps.h"
 
+#include "GPU/GPU.h"
 #include "GPU/GPUState.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Common/GPUDebugInterface.h"
@@ -58,7 +61,66 @@ inline uint32_t GetVertTypeID(uint32_t vertType, int uvGenMode, bool skinInDecod
 	return (vertType & 0xFFFFFF) | (uvGenMode << 24) | (skinInDecode << 26);
 }
 
+// How long cached vertex arrays live without being drawn, in frames.
+enum { VAI_KILL_AGE = 120, VAI_UNRELIABLE_KILL_AGE = 240, VAI_UNRELIABLE_KILL_MAX = 4 };
+
+enum {
+	VAI_FLAG_VERTEXFULLALPHA = 1,
+};
+
+// States transitions:
+// On creation: DRAWN_NEW
+// DRAWN_NEW -> DRAWN_HASHING
+// DRAWN_HASHING -> DRAWN_RELIABLE
+// DRAWN_HASHING -> DRAWN_UNRELIABLE
+// DRAWN_ONCE -> UNRELIABLE
+// DRAWN_RELIABLE -> DRAWN_SAFE
+// UNRELIABLE -> death
+// DRAWN_ONCE -> death
+// DRAWN_RELIABLE -> death
+
+// Shared by the backends' vertex caches, which subclass it to hold the decoded data in their GPU buffers.
+class VertexArrayInfo {
+public:
+	VertexArrayInfo() {
+		lastFrame = gpuStats.numFlips;
+	}
+
+	enum Status : uint8_t {
+		VAI_NEW,
+		VAI_HASHING,
+		VAI_RELIABLE,  // cache, don't hash
+		VAI_UNRELIABLE,  // never cache
+	};
+
+	void CountDraw() {
+		numDraws++;
+		if (lastFrame != gpuStats.numFlips) {
+			numFrames++;
+		}
+	}
+
+	uint64_t hash = 0;
+	u32 minihash = 0;
+
+	// Precalculated parameters for the draw.
+	u16 numVerts = 0;
+	u16 maxIndex = 0;
+	s8 prim = GE_PRIM_INVALID;
+	Status status = VAI_NEW;
+
+	// ID information
+	int numDraws = 0;
+	int numFrames = 0;
+	int lastFrame;  // So that we can forget.
+	u16 drawsUntilNextFullHash = 0;
+	u8 flags = 0;
+	// Size of the GPU buffers this owns, for the cache budget.
+	u32 gpuBytes = 0;
+};
+
 struct SimpleVertex;
+struct TessellationCacheEntry;
 namespace Spline { struct Weight2D; }
 
 class TessellationDataTransfer {
@@ -100,6 +162,8 @@ class DrawEngineCommon {
 	template<class Surface>
 	void SubmitCurve(const void *control_points, const void *indices, Surface &surface, u32 vertType, int *bytesRead, const char *scope);
 	void ClearSplineBezierWeights();
+	void ClearTessellationCache();
+	void ClearDrawBounds();
 
 	bool CanUseHardwareTransform(int prim);
 	bool CanUseHardwareTessellation(GEPatchPrimType prim);
@@ -141,9 +205,67 @@ class DrawEngineCommon {
 	// Utility for vertex caching
 	u32 ComputeMiniHash();
 	uint64_t ComputeHash();
+	// Checks a VAI_HASHING array against the current draw calls, with a backoff on full hashes.
+	// If this returns false, the data changed and the array should be made unreliable.
+	bool VertexCacheHashMatches(VertexArrayInfo *vai);
+
+	// Conservative CPU culling of hardware transformed draws, using cached object space bounds.
+	bool IsDrawOffscreen(const void *verts, u32 vertTypeID, int indexLowerBound, int indexUpperBound);
+
+	// Drops vertex arrays that haven't been drawn in a while. If budgetBytes is non-zero, then the least
+	// recently drawn are dropped until the GPU buffers fit in it.
+	template <typename T>
+	static void DecimateVertexArrays(SwissPrehashMap<T *, nullptr> &vais, size_t budgetBytes) {
+		const int threshold = gpuStats.numFlips - VAI_KILL_AGE;
+		const int unreliableThreshold = gpuStats.numFlips - VAI_UNRELIABLE_KILL_AGE;
+		int unreliableLeft = VAI_UNRELIABLE_KILL_MAX;
+		size_t totalBytes = 0;
+		vais.Iterate([&](uint32_t hash, T *vai) {
+			bool kill;
+			if (vai->status == VertexArrayInfo::VAI_UNRELIABLE) {
+				// We limit killing unreliable so we don't rehash too often.
+				kill = vai->lastFrame < unreliableThreshold && --unreliableLeft >= 0;
+			} else {
+				kill = vai->lastFrame < threshold;
+			}
+			if (kill) {
+				vais.Remove(hash);
+				delete vai;
+			} else {
+				totalBytes += vai->gpuBytes;
+			}
+		});
+
+		if (budgetBytes == 0 || totalBytes <= budgetBytes)
+			return;
+		std::vector<std::pair<int, uint32_t>> byAge;
+		vais.Iterate([&](uint32_t hash, T *vai) {
+			if (vai->gpuBytes != 0)
+				byAge.emplace_back(vai->lastFrame, hash);
+		});
+		std::sort(byAge.begin(), byAge.end());
+		for (const auto &it : byAge) {
+			if (totalBytes <= budgetBytes)
+				break;
+			T *vai = vais.Get(it.second);
+			totalBytes -= vai->gpuBytes;
+			vais.Remove(it.second);
+			delete vai;
+		}
+	}
 
 	// Vertex decoding
-	void DecodeVertsStep(u8 *dest, int &i, int &decodedVerts);
+	struct DeferredVertexRange {
+		const void *verts;
+		int indexLowerBound;
+		int outStart;
+		int count;
+	};
+
+	// If ranges is set, the vertex data isn't decoded, only the index generation is done.
+	void DecodeVertsStep(u8 *dest, int &i, int &decodedVerts, std::vector<DeferredVertexRange> *ranges = nullptr);
+	bool CanDecodeVertsInParallel() const;
+	void DecodeVertsParallel(u8 *dest);
 
 	void ApplyFramebufferRead(FBOTexState *fboTexState);
 
@@ -190,11 +312,24 @@ class DrawEngineCommon {
 
 	// Cached vertex decoders
 	u32 lastVType_ = -1;  // corresponds to dec_.  Could really just pick it out of dec_...
-	DenseHashMap<u32, VertexDecoder *, nullptr> decoderMap_;
+	SwissHashMap<u32, VertexDecoder *, nullptr> decoderMap_;
 	VertexDecoder *dec_ = nullptr;
 	VertexDecoderJitCache *decJitCache_ = nullptr;
 	VertexDecoderOptions decOptions_{};
 
+	struct DrawBounds {
+		const void *verts;
+		u32 vertType;
+		u16 indexLowerBound;
+		u16 indexUpperBound;
+		u32 minihash;
+		// Positions are also recomputed every so often, in case the mini hash misses a change.
+		int drawsUntilRecompute;
+		float mins[3];
+		float maxs[3];
+	};
+	SwissHashMap<u32, DrawBounds *, nullptr> drawBounds_;
+
 	TransformedVertex *transformed = nullptr;
 	TransformedVertex *transformedExpanded = nullptr;
 
@@ -223,6 +358,7 @@ class DrawEngineCommon {
 	// Vertex collector state
 	IndexGenerator indexGen;
 	int decodedVerts_ = 0;
+	std::vector<DeferredVertexRange> deferredRanges_;
 	GEPrimitiveType prevPrim_ = GE_PRIM_INVALID;
 
 	// Shader blending state
@@ -235,4 +371,10 @@ class DrawEngineCommon {
 
 	// Hardware tessellation
 	TessellationDataTransfer *tessDataTransfer;
+
+	// Software tessellation output of curves whose control points didn't change, by hash.
+	void DecimateTessellationCache();
+	SwissHashMap<uint64_t, TessellationCacheEntry *, nullptr> tessCache_;
+	size_t tessCacheBytes_ = 0;
+	int tessCacheFrame_ = -1;
 };
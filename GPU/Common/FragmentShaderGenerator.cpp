@@ -104,7 +104,12 @@ bool GenerateFragmentShader(const FShaderID &id, char *buffer, const ShaderLangu
 	bool enableColorTest = id.Bit(FS_BIT_COLOR_TEST);
 	bool colorTestAgainstZero = id.Bit(FS_BIT_COLOR_AGAINST_ZERO);
 	bool doTextureProjection = id.Bit(FS_BIT_DO_TEXTURE_PROJ);
+	bool ubershader = id.Bit(FS_BIT_UBERSHADER);
 
+	if (ubershader && compat.shaderLanguage != ShaderLanguage::GLSL_VULKAN) {
+		*errorString = "The fragment ubershader is only used in Vulkan";
+		return false;
+	}
 	if (texture3D && arrayTexture) {
 		*errorString = "Invalid combination of 3D texture and array texture, shouldn't happen";
 		return false;
@@ -818,35 +823,49 @@ bool GenerateFragmentShader(const FShaderID &id, char *buffer, const ShaderLangu
 
 			WRITE(p, "  vec4 p = v_color0;\n");
 
-			if (texFunc != GE_TEXFUNC_REPLACE) {
+			if (texFunc != GE_TEXFUNC_REPLACE && !ubershader) {
 				WRITE(p, "  t.a = max(t.a, u_texNoAlpha);\n");
 			}
 
-			switch (texFunc) {
-			case GE_TEXFUNC_MODULATE:
-				WRITE(p, "  vec4 v = p * t + s;\n");
-				break;
-			case GE_TEXFUNC_DECAL:
-				WRITE(p, "  vec4 v = vec4(mix(p.rgb, t.rgb, t.a), p.a) + s;\n");
-				break;
-			case GE_TEXFUNC_BLEND:
-				WRITE(p, "  vec4 v = vec4(mix(p.rgb, u_texenv.rgb, t.rgb), p.a * t.a) + s;\n");
-				break;
-			case GE_TEXFUNC_REPLACE:
-				WRITE(p, "  vec4 r = t;\n");
-				WRITE(p, "  r.a = mix(r.a, p.a, u_texNoAlpha);\n");
-				WRITE(p, "  vec4 v = r + s;\n");
-				break;
-			case GE_TEXFUNC_ADD:
-			case GE_TEXFUNC_UNKNOWN1:
-			case GE_TEXFUNC_UNKNOWN2:
-			case GE_TEXFUNC_UNKNOWN3:
-				WRITE(p, "  vec4 v = vec4(p.rgb + t.rgb, p.a * t.a) + s;\n");
-				break;
-			default:
-				// Doesn't happen
-				WRITE(p, "  vec4 v = p + s;\n"); break;
-				break;
+			if (ubershader) {
+				// Same as below, but picked at runtime.
+				WRITE(p, "  uint texFunc = u_fragmentUberControl & 0x7u;\n");
+				WRITE(p, "  if (texFunc != 3u) t.a = max(t.a, u_texNoAlpha);\n");
+				WRITE(p, "  vec4 v;\n");
+				WRITE(p, "  switch (texFunc) {\n");
+				WRITE(p, "  case 0u: v = p * t + s; break;\n");
+				WRITE(p, "  case 1u: v = vec4(mix(p.rgb, t.rgb, t.a), p.a) + s; break;\n");
+				WRITE(p, "  case 2u: v = vec4(mix(p.rgb, u_texenv.rgb, t.rgb), p.a * t.a) + s; break;\n");
+				WRITE(p, "  case 3u: v = vec4(t.rgb, mix(t.a, p.a, u_texNoAlpha)) + s; break;\n");
+				WRITE(p, "  default: v = vec4(p.rgb + t.rgb, p.a * t.a) + s; break;\n");
+				WRITE(p, "  }\n");
+			} else {
+				switch (texFunc) {
+				case GE_TEXFUNC_MODULATE:
+					WRITE(p, "  vec4 v = p * t + s;\n");
+					break;
+				case GE_TEXFUNC_DECAL:
+					WRITE(p, "  vec4 v = vec4(mix(p.rgb, t.rgb, t.a), p.a) + s;\n");
+					break;
+				case GE_TEXFUNC_BLEND:
+					WRITE(p, "  vec4 v = vec4(mix(p.rgb, u_texenv.rgb, t.rgb), p.a * t.a) + s;\n");
+					break;
+				case GE_TEXFUNC_REPLACE:
+					WRITE(p, "  vec4 r = t;\n");
+					WRITE(p, "  r.a = mix(r.a, p.a, u_texNoAlpha);\n");
+					WRITE(p, "  vec4 v = r + s;\n");
+					break;
+				case GE_TEXFUNC_ADD:
+				case GE_TEXFUNC_UNKNOWN1:
+				case GE_TEXFUNC_UNKNOWN2:
+				case GE_TEXFUNC_UNKNOWN3:
+					WRITE(p, "  vec4 v = vec4(p.rgb + t.rgb, p.a * t.a) + s;\n");
+					break;
+				default:
+					// Doesn't happen
+					WRITE(p, "  vec4 v = p + s;\n"); break;
+					break;
+				}
 			}
 
 			// This happens before fog is applied.
@@ -876,7 +895,23 @@ bool GenerateFragmentShader(const FShaderID &id, char *buffer, const ShaderLangu
 		if (enableAlphaTest) {
 			*fragmentShaderFlags |= FragmentShaderFlags::USES_DISCARD;
 
-			if (alphaTestAgainstZero) {
+			if (ubershader) {
+				WRITE(p, "  uint alphaTestFunc = (u_fragmentUberControl >> 3) & 0x7u;\n");
+				WRITE(p, "  int alphaMasked = roundAndScaleTo255i(v.a) & int(u_alphacolormask >> 0x18u);\n");
+				WRITE(p, "  int alphaRef = int(u_alphacolorref >> 0x18u);\n");
+				WRITE(p, "  bool alphaPass;\n");
+				WRITE(p, "  switch (alphaTestFunc) {\n");
+				WRITE(p, "  case 0u: alphaPass = false; break;\n");
+				WRITE(p, "  case 2u: alphaPass = alphaMasked == alphaRef; break;\n");
+				WRITE(p, "  case 3u: alphaPass = alphaMasked != alphaRef; break;\n");
+				WRITE(p, "  case 4u: alphaPass = alphaMasked < alphaRef; break;\n");
+				WRITE(p, "  case 5u: alphaPass = alphaMasked <= alphaRef; break;\n");
+				WRITE(p, "  case 6u: alphaPass = alphaMasked > alphaRef; break;\n");
+				WRITE(p, "  case 7u: alphaPass = alphaMasked >= alphaRef; break;\n");
+				WRITE(p, "  default: alphaPass = true; break;\n");
+				WRITE(p, "  }\n");
+				WRITE(p, "  if (!alphaPass) %s\n", discardStatement);
+			} else if (alphaTestAgainstZero) {
 				// When testing against 0 (extremely common), we can avoid some math.
 				// 0.002 is approximately half of 1.0 / 255.0.
 				if (alphaTestFunc == GE_COMP_NOTEQUAL || alphaTestFunc == GE_COMP_GREATER) {
@@ -915,7 +950,12 @@ bool GenerateFragmentShader(const FShaderID &id, char *buffer, const ShaderLangu
 		if (enableColorTest) {
 			*fragmentShaderFlags |= FragmentShaderFlags::USES_DISCARD;
 
-			if (colorTestAgainstZero) {
+			if (ubershader) {
+				WRITE(p, "  uint colorTestFunc = (u_fragmentUberControl >> 6) & 0x3u;\n");
+				WRITE(p, "  uint v_masked = roundAndScaleTo8x4(v.rgb) & u_alphacolormask;\n");
+				WRITE(p, "  uint colorTestRef = (u_alphacolorref & u_alphacolormask) & 0xFFFFFFu;\n");
+				WRITE(p, "  if (colorTestFunc == 0u || (colorTestFunc == 2u && v_masked != colorTestRef) || (colorTestFunc == 3u && v_masked == colorTestRef)) %s\n", discardStatement);
+			} else if (colorTestAgainstZero) {
 				// When testing against 0 (common), we can avoid some math.
 				// 0.002 is approximately half of 1.0 / 255.0.
 				if (colorTestFunc == GE_COMP_NOTEQUAL) {
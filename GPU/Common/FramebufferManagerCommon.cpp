@@ -19,8 +19,23 @@
 #include <sstream>
 #include <cmath>
 
+#include "ppsspp_config.h"
+
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 #include "Common/GPU/thin3d.h"
 #include "Common/GPU/OpenGL/GLFeatures.h"
+#include "Common/Data/Collections/LinearArena.h"
 #include "Common/Data/Collections/TinySet.h"
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/Data/Text/I18n.h"
@@ -100,13 +115,20 @@ bool FramebufferManagerCommon::UpdateRenderSize(int msaaLevel) {
 	}
 
 	bool newBuffered = !g_Config.bSkipBufferEffects;
-	const bool newSettings = bloomHack_ != effectiveBloomHack || useBufferedRendering_ != newBuffered;
+	// Turning dynamic resolution off would otherwise leave framebuffers at whatever scale they were last at.
+	const bool newSettings = bloomHack_ != effectiveBloomHack || useBufferedRendering_ != newBuffered || dynamicResolution_ != g_Config.bDynamicResolution;
 
 	renderWidth_ = (float)PSP_CoreParameter().renderWidth;
 	renderHeight_ = (float)PSP_CoreParameter().renderHeight;
 	renderScaleFactor_ = (float)PSP_CoreParameter().renderScaleFactor;
+	maxRenderScaleFactor_ = renderScaleFactor_;
 	msaaLevel_ = msaaLevel;
 
+	dynamicResolution_ = g_Config.bDynamicResolution;
+	dynamicOverBudgetFrames_ = 0;
+	dynamicUnderBudgetFrames_ = 0;
+	dynamicCooldownFrames_ = 0;
+
 	bloomHack_ = effectiveBloomHack;
 	useBufferedRendering_ = newBuffered;
 
@@ -123,10 +145,60 @@ void FramebufferManagerCommon::CheckPostShaders() {
 
 void FramebufferManagerCommon::BeginFrame() {
 	DecimateFBOs();
+	UpdateDynamicResolution();
 
 	currentRenderVfb_ = nullptr;
 }
 
+// Steps renderScaleFactor_ down when the GPU can't keep up, and back up when there's room again.
+// Nothing is recreated here, framebuffers get rescaled the next time they're rendered to.
+void FramebufferManagerCommon::UpdateDynamicResolution() {
+	if (!dynamicResolution_ || !useBufferedRendering_ || postShaderIsUpscalingFilter_ || postShaderIsSupersampling_)
+		return;
+	const int minScaleFactor = std::max(1, (maxRenderScaleFactor_ + 1) / 2);
+	if (maxRenderScaleFactor_ <= minScaleFactor)
+		return;
+
+	const float gpuMs = draw_->GetGPUFrameTimeMs();
+	if (gpuMs <= 0.0f)
+		return;
+	if (dynamicCooldownFrames_ > 0) {
+		// The measurement lags a few frames behind, and the resizes themselves cost some.
+		dynamicCooldownFrames_--;
+		return;
+	}
+
+	const float budgetMs = 1000.0f / 60.0f;
+	// GPU time roughly follows the pixel count, so predict what one step up would cost.
+	const float nextScale = (float)(renderScaleFactor_ + 1);
+	const float upCost = (nextScale * nextScale) / (float)(renderScaleFactor_ * renderScaleFactor_);
+	if (gpuMs > budgetMs * 0.9f) {
+		dynamicOverBudgetFrames_++;
+		dynamicUnderBudgetFrames_ = 0;
+	} else if (renderScaleFactor_ < maxRenderScaleFactor_ && gpuMs * upCost < budgetMs * 0.75f) {
+		dynamicUnderBudgetFrames_++;
+		dynamicOverBudgetFrames_ = 0;
+	} else {
+		dynamicOverBudgetFrames_ = 0;
+		dynamicUnderBudgetFrames_ = 0;
+	}
+
+	int scaleFactor = renderScaleFactor_;
+	if (dynamicOverBudgetFrames_ >= DYNAMIC_RES_DOWN_FRAMES && scaleFactor > minScaleFactor) {
+		scaleFactor--;
+	} else if (dynamicUnderBudgetFrames_ >= DYNAMIC_RES_UP_FRAMES && scaleFactor < maxRenderScaleFactor_) {
+		scaleFactor++;
+	}
+
+	if (scaleFactor != renderScaleFactor_) {
+		INFO_LOG(FRAMEBUF, "Dynamic resolution: %dx -> %dx (GPU frame %0.2f ms)", renderScaleFactor_, scaleFactor, gpuMs);
+		renderScaleFactor_ = scaleFactor;
+		dynamicOverBudgetFrames_ = 0;
+		dynamicUnderBudgetFrames_ = 0;
+		dynamicCooldownFrames_ = DYNAMIC_RES_COOLDOWN_FRAMES;
+	}
+}
+
 void FramebufferManagerCommon::SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat format) {
 	displayFramebufPtr_ = framebuf & 0x3FFFFFFF;
 	if (Memory::IsVRAMAddress(displayFramebufPtr_))
@@ -153,6 +225,52 @@ VirtualFramebuffer *FramebufferManagerCommon::GetVFBAt(u32 addr) const {
 	return match;
 }
 
+int FramebufferManagerCommon::GetColorBindSeqAt(u32 addr) const {
+	addr &= 0x3FFFFFFF;
+	if (Memory::IsVRAMAddress(addr))
+		addr &= 0x041FFFFF;
+	int seq = -1;
+	for (auto vfb : vfbs_) {
+		if (vfb->fb_address == addr)
+			seq = std::max(seq, vfb->colorBindSeq);
+	}
+	return seq;
+}
+
+void FramebufferManagerCommon::NotifyRenderSkipped(u32 addr, u32 skipDrawReason) {
+	addr &= 0x3FFFFFFF;
+	if (Memory::IsVRAMAddress(addr))
+		addr &= 0x041FFFFF;
+	for (auto vfb : vfbs_) {
+		if (vfb->fb_address == addr) {
+			vfb->last_frame_render = gpuStats.numFlips;
+			vfb->dirtyAfterDisplay = true;
+			if ((skipDrawReason & SKIPDRAW_SKIPFRAME) == 0)
+				vfb->reallyDirtyAfterDisplay = true;
+		}
+	}
+	frameLastFramebufUsed_ = gpuStats.numFlips;
+}
+
+bool FramebufferManagerCommon::MayOverlapFramebuffer(u32 addr, u32 size) const {
+	addr &= 0x3FFFFFFF;
+	if (!Memory::IsVRAMAddress(addr))
+		return false;
+	addr &= 0x041FFFFF;
+	const u32 end = addr + size;
+	for (auto vfb : vfbs_) {
+		const u32 colorEnd = vfb->fb_address + vfb->FbStrideInBytes() * vfb->height;
+		if (addr < colorEnd && end > vfb->fb_address)
+			return true;
+		if (vfb->z_address != 0) {
+			const u32 depthEnd = vfb->z_address + vfb->ZStrideInBytes() * vfb->height;
+			if (addr < depthEnd && end > vfb->z_address)
+				return true;
+		}
+	}
+	return false;
+}
+
 VirtualFramebuffer *FramebufferManagerCommon::GetExactVFB(u32 addr, int stride, GEBufferFormat format) const {
 	addr &= 0x3FFFFFFF;
 	if (Memory::IsVRAMAddress(addr))
@@ -487,7 +605,10 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(Framebuffer
 			vfb->lastFrameNewSize = gpuStats.numFlips;
 		}
 
-		if (!resized && renderScaleFactor_ != 1 && vfb->renderScaleFactor == 1) {
+		if (!resized && dynamicResolution_ && vfb->renderScaleFactor != TargetRenderScaleFactor(vfb)) {
+			// Dynamic resolution moved since this was last rendered to, rescale it along with its contents.
+			ResizeFramebufFBO(vfb, vfb->bufferWidth, vfb->bufferHeight, true);
+		} else if (!resized && renderScaleFactor_ != 1 && vfb->renderScaleFactor == 1) {
 			// Might be time to change this framebuffer - have we used depth?
 			if ((vfb->usageFlags & FB_USAGE_COLOR_MIXED_DEPTH) && !PSP_CoreParameter().compat.flags().ForceLowerResolutionForEffectsOn) {
 				ResizeFramebufFBO(vfb, vfb->width, vfb->height, true);
@@ -537,6 +658,7 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(Framebuffer
 		frameLastFramebufUsed_ = gpuStats.numFlips;
 		vfbs_.push_back(vfb);
 		currentRenderVfb_ = vfb;
+		gpuStats.numRenderTargetSwitches++;
 
 		// Assume that if we're clearing right when switching to a new framebuffer, we don't need to upload.
 		if (useBufferedRendering_ && params.isDrawing) {
@@ -561,6 +683,7 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(Framebuffer
 
 		VirtualFramebuffer *prev = currentRenderVfb_;
 		currentRenderVfb_ = vfb;
+		gpuStats.numRenderTargetSwitches++;
 		NotifyRenderFramebufferSwitched(prev, vfb, params.isClearingDepth);
 		CopyToColorFromOverlappingFramebuffers(vfb);
 		gstate_c.usingDepth = false;  // reset depth buffer tracking
@@ -655,11 +778,26 @@ struct CopySource {
 	}
 };
 
+// Whether copying or reinterpreting source into dst overwrites all of dst's color.
+static bool ColorCopyCoversFramebuffer(const CopySource &source, const VirtualFramebuffer *dst) {
+	const VirtualFramebuffer *src = source.vfb;
+	// Same as the scaleFactorX from GetReinterpretPipeline.
+	float widthFactor = 1.0f;
+	if (IsBufferFormat16Bit(src->fb_format) && !IsBufferFormat16Bit(dst->fb_format)) {
+		widthFactor = 0.5f;
+	} else if (!IsBufferFormat16Bit(src->fb_format) && IsBufferFormat16Bit(dst->fb_format)) {
+		widthFactor = 2.0f;
+	}
+	if (source.xOffset < 0 || source.yOffset < 0)
+		return false;
+	return (src->width - source.xOffset) * widthFactor >= dst->width && src->height - source.yOffset >= dst->height;
+}
+
 // Not sure if it's more profitable to always do these copies with raster (which may screw up early-Z due to explicit depth buffer write)
 // or to use image copies when possible (which may make it easier for the driver to preserve early-Z, but on the other hand, will cost additional memory
 // bandwidth on tilers due to the load operation, which we might otherwise be able to skip).
 void FramebufferManagerCommon::CopyToDepthFromOverlappingFramebuffers(VirtualFramebuffer *dest) {
-	std::vector<CopySource> sources;
+	ArenaVector<CopySource> sources{ ArenaAllocator<CopySource>(gpuFrameArena) };
 	for (auto src : vfbs_) {
 		if (src == dest)
 			continue;
@@ -755,7 +893,7 @@ void FramebufferManagerCommon::CopyToColorFromOverlappingFramebuffers(VirtualFra
 		return;
 	}
 
-	std::vector<CopySource> sources;
+	ArenaVector<CopySource> sources{ ArenaAllocator<CopySource>(gpuFrameArena) };
 	for (auto src : vfbs_) {
 		// Discard old and equal potential inputs.
 		if (src == dst || src->colorBindSeq < dst->colorBindSeq) {
@@ -827,11 +965,18 @@ void FramebufferManagerCommon::CopyToColorFromOverlappingFramebuffers(VirtualFra
 
 	std::sort(sources.begin(), sources.end());
 
+	// If a newer source covers all of dst, anything copied before it would just get overwritten.
+	for (size_t i = sources.size(); i-- > 1; ) {
+		if (ColorCopyCoversFramebuffer(sources[i], dst)) {
+			sources.erase(sources.begin(), sources.begin() + i);
+			break;
+		}
+	}
+
 	draw_->Invalidate(InvalidationFlags::CACHED_RENDER_STATE);
 
 	bool tookActions = false;
 
-	// TODO: Only do the latest one.
 	for (const CopySource &source : sources) {
 		VirtualFramebuffer *src = source.vfb;
 
@@ -1627,7 +1772,7 @@ void FramebufferManagerCommon::DecimateFBOs() {
 		int age = frameLastFramebufUsed_ - std::max(vfb->last_frame_render, vfb->last_frame_used);
 
 		if (ShouldDownloadFramebufferColor(vfb) && age == 0 && !vfb->memoryUpdated) {
-			ReadFramebufferToMemory(vfb, 0, 0, vfb->width, vfb->height, RASTER_COLOR, Draw::ReadbackMode::BLOCK);
+			ReadFramebufferToMemory(vfb, 0, 0, vfb->width, vfb->height, RASTER_COLOR, GameReadbackMode(RASTER_COLOR));
 			vfb->usageFlags = (vfb->usageFlags | FB_USAGE_DOWNLOAD | FB_USAGE_FIRST_FRAME_SAVED) & ~FB_USAGE_DOWNLOAD_CLEAR;
 		}
 
@@ -1666,27 +1811,7 @@ void FramebufferManagerCommon::DecimateFBOs() {
 }
 
 // Requires width/height to be set already.
-void FramebufferManagerCommon::ResizeFramebufFBO(VirtualFramebuffer *vfb, int w, int h, bool force, bool skipCopy) {
-	_dbg_assert_(w > 0);
-	_dbg_assert_(h > 0);
-	VirtualFramebuffer old = *vfb;
-
-	int oldWidth = vfb->bufferWidth;
-	int oldHeight = vfb->bufferHeight;
-
-	if (force) {
-		vfb->bufferWidth = w;
-		vfb->bufferHeight = h;
-	} else {
-		if (vfb->bufferWidth >= w && vfb->bufferHeight >= h) {
-			return;
-		}
-
-		// In case it gets thin and wide, don't resize down either side.
-		vfb->bufferWidth = std::max((int)vfb->bufferWidth, w);
-		vfb->bufferHeight = std::max((int)vfb->bufferHeight, h);
-	}
-
+int FramebufferManagerCommon::TargetRenderScaleFactor(const VirtualFramebuffer *vfb) const {
 	bool force1x = false;
 	switch (bloomHack_) {
 	case 1:
@@ -1707,16 +1832,34 @@ void FramebufferManagerCommon::ResizeFramebufFBO(VirtualFramebuffer *vfb, int w,
 		force1x = true;
 	}
 
-	if (force1x && g_Config.iInternalResolution != 1) {
-		vfb->renderScaleFactor = 1;
-		vfb->renderWidth = vfb->bufferWidth;
-		vfb->renderHeight = vfb->bufferHeight;
+	return force1x && g_Config.iInternalResolution != 1 ? 1 : renderScaleFactor_;
+}
+
+void FramebufferManagerCommon::ResizeFramebufFBO(VirtualFramebuffer *vfb, int w, int h, bool force, bool skipCopy) {
+	_dbg_assert_(w > 0);
+	_dbg_assert_(h > 0);
+	VirtualFramebuffer old = *vfb;
+
+	int oldWidth = vfb->bufferWidth;
+	int oldHeight = vfb->bufferHeight;
+
+	if (force) {
+		vfb->bufferWidth = w;
+		vfb->bufferHeight = h;
 	} else {
-		vfb->renderScaleFactor = renderScaleFactor_;
-		vfb->renderWidth = (u16)(vfb->bufferWidth * renderScaleFactor_);
-		vfb->renderHeight = (u16)(vfb->bufferHeight * renderScaleFactor_);
+		if (vfb->bufferWidth >= w && vfb->bufferHeight >= h) {
+			return;
+		}
+
+		// In case it gets thin and wide, don't resize down either side.
+		vfb->bufferWidth = std::max((int)vfb->bufferWidth, w);
+		vfb->bufferHeight = std::max((int)vfb->bufferHeight, h);
 	}
 
+	vfb->renderScaleFactor = TargetRenderScaleFactor(vfb);
+	vfb->renderWidth = (u16)(vfb->bufferWidth * vfb->renderScaleFactor);
+	vfb->renderHeight = (u16)(vfb->bufferHeight * vfb->renderScaleFactor);
+
 	bool creating = old.bufferWidth == 0;
 	if (creating) {
 		WARN_LOG(FRAMEBUF, "Creating %s FBO at %08x/%08x stride=%d %dx%d (force=%d)", GeBufferFormatToString(vfb->fb_format), vfb->fb_address, vfb->z_address, vfb->fb_stride, vfb->bufferWidth, vfb->bufferHeight, (int)force);
@@ -1747,6 +1890,7 @@ void FramebufferManagerCommon::ResizeFramebufFBO(VirtualFramebuffer *vfb, int w,
 	size_t len = FormatFramebufferName(vfb, tag, sizeof(tag));
 
 	vfb->fbo = draw_->CreateFramebuffer({ vfb->renderWidth, vfb->renderHeight, 1, GetFramebufferLayers(), msaaLevel_, true, tag });
+	gpuStats.numFramebufferCreations++;
 	if (Memory::IsVRAMAddress(vfb->fb_address) && vfb->fb_stride != 0) {
 		NotifyMemInfo(MemBlockFlags::ALLOC, vfb->fb_address, vfb->BufferByteSize(RASTER_COLOR), tag, len);
 	}
@@ -1936,7 +2080,7 @@ bool FramebufferManagerCommon::NotifyFramebufferCopy(u32 src, u32 dst, int size,
 		if (srcH == 0 || srcY + srcH > srcBuffer->bufferHeight) {
 			WARN_LOG_ONCE(btdcpyheight, G3D, "Memcpy fbo download %08x -> %08x skipped, %d+%d is taller than %d", src, dst, srcY, srcH, srcBuffer->bufferHeight);
 		} else if (!g_Config.bSkipGPUReadbacks && (!srcBuffer->memoryUpdated || channel == RASTER_DEPTH)) {
-			ReadFramebufferToMemory(srcBuffer, 0, srcY, srcBuffer->width, srcH, channel, Draw::ReadbackMode::BLOCK);
+			ReadFramebufferToMemory(srcBuffer, 0, srcY, srcBuffer->width, srcH, channel, GameReadbackMode(channel));
 			srcBuffer->usageFlags = (srcBuffer->usageFlags | FB_USAGE_DOWNLOAD) & ~FB_USAGE_DOWNLOAD_CLEAR;
 		}
 		return false;
@@ -2151,6 +2295,7 @@ VirtualFramebuffer *FramebufferManagerCommon::CreateRAMFramebuffer(uint32_t fbAd
 	textureCache_->NotifyFramebuffer(vfb, NOTIFY_FB_CREATED);
 	bool createDepthBuffer = format == GE_FORMAT_DEPTH16;
 	vfb->fbo = draw_->CreateFramebuffer({ vfb->renderWidth, vfb->renderHeight, 1, GetFramebufferLayers(), 0, createDepthBuffer, name });
+	gpuStats.numFramebufferCreations++;
 	vfbs_.push_back(vfb);
 
 	u32 byteSize = vfb->BufferByteSize(channel);
@@ -2209,6 +2354,7 @@ VirtualFramebuffer *FramebufferManagerCommon::FindDownloadTempBuffer(VirtualFram
 
 		// We always create a color-only framebuffer here - readbacks of depth convert to color while translating the values.
 		nvfb->fbo = draw_->CreateFramebuffer({ nvfb->bufferWidth, nvfb->bufferHeight, 1, 1, 0, false, name });
+		gpuStats.numFramebufferCreations++;
 		if (!nvfb->fbo) {
 			ERROR_LOG(FRAMEBUF, "Error creating FBO! %d x %d", nvfb->renderWidth, nvfb->renderHeight);
 			delete nvfb;
@@ -2226,6 +2372,56 @@ VirtualFramebuffer *FramebufferManagerCommon::FindDownloadTempBuffer(VirtualFram
 	return nvfb;
 }
 
+// Fills a row of pixels with a 32-bit pattern. For 16-bit formats, the pattern is the color
+// twice, so dst only needs to be aligned to the pixel size.
+static void ClearRowToMemory(u8 *dst, int byteWidth, u32 pattern) {
+	u8 *end = dst + byteWidth;
+	if ((uintptr_t)dst & 2) {
+		if (dst + 2 > end)
+			return;
+		*(u16 *)dst = (u16)pattern;
+		dst += 2;
+	}
+	while (((uintptr_t)dst & 15) != 0 && dst + 4 <= end) {
+		*(u32 *)dst = pattern;
+		dst += 4;
+	}
+#if defined(_M_SSE)
+	const __m128i value = _mm_set1_epi32((int)pattern);
+	while (dst + 64 <= end) {
+		_mm_store_si128((__m128i *)dst, value);
+		_mm_store_si128((__m128i *)(dst + 16), value);
+		_mm_store_si128((__m128i *)(dst + 32), value);
+		_mm_store_si128((__m128i *)(dst + 48), value);
+		dst += 64;
+	}
+	while (dst + 16 <= end) {
+		_mm_store_si128((__m128i *)dst, value);
+		dst += 16;
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint32x4_t value = vdupq_n_u32(pattern);
+	while (dst + 64 <= end) {
+		vst1q_u32((uint32_t *)dst, value);
+		vst1q_u32((uint32_t *)(dst + 16), value);
+		vst1q_u32((uint32_t *)(dst + 32), value);
+		vst1q_u32((uint32_t *)(dst + 48), value);
+		dst += 64;
+	}
+	while (dst + 16 <= end) {
+		vst1q_u32((uint32_t *)dst, value);
+		dst += 16;
+	}
+#endif
+	while (dst + 4 <= end) {
+		*(u32 *)dst = pattern;
+		dst += 4;
+	}
+	if (dst + 2 <= end) {
+		*(u16 *)dst = (u16)pattern;
+	}
+}
+
 void FramebufferManagerCommon::ApplyClearToMemory(int x1, int y1, int x2, int y2, u32 clearColor) {
 	if (currentRenderVfb_) {
 		if ((currentRenderVfb_->usageFlags & FB_USAGE_DOWNLOAD_CLEAR) != 0) {
@@ -2270,35 +2466,15 @@ void FramebufferManagerCommon::ApplyClearToMemory(int x1, int y1, int x2, int y2
 			memset(addr + y * byteStride, clearBits, byteWidth);
 		}
 	} else {
-		// This will most often be true - rarely is the width not aligned.
 		// TODO: We should really use non-temporal stores here to avoid the cache,
 		// as it's unlikely that these bytes will be read.
-		if ((width & 3) == 0 && (x1 & 3) == 0) {
-			u64 val64 = clearBits | ((u64)clearBits << 32);
-			int xstride = 8 / bpp;
-
-			u64 *addr64 = (u64 *)addr;
-			const int stride64 = stride / xstride;
-			const int x1_64 = x1 / xstride;
-			const int x2_64 = x2 / xstride;
-			for (int y = y1; y < y2; ++y) {
-				for (int x = x1_64; x < x2_64; ++x) {
-					addr64[y * stride64 + x] = val64;
-				}
-			}
-		} else if (bpp == 4) {
-			u32 *addr32 = (u32 *)addr;
-			for (int y = y1; y < y2; ++y) {
-				for (int x = x1; x < x2; ++x) {
-					addr32[y * stride + x] = clearBits;
-				}
-			}
-		} else if (bpp == 2) {
-			u16 *addr16 = (u16 *)addr;
+		addr += x1 * bpp;
+		if (byteWidth == byteStride) {
+			// Full width, so it's all one run.
+			ClearRowToMemory(addr + y1 * byteStride, byteWidth * (y2 - y1), clearBits);
+		} else {
 			for (int y = y1; y < y2; ++y) {
-				for (int x = x1; x < x2; ++x) {
-					addr16[y * stride + x] = (u16)clearBits;
-				}
+				ClearRowToMemory(addr + y * byteStride, byteWidth, clearBits);
 			}
 		}
 	}
@@ -2460,7 +2636,7 @@ bool FramebufferManagerCommon::NotifyBlockTransferBefore(u32 dstBasePtr, int dst
 				if (tooTall) {
 					WARN_LOG_ONCE(btdheight, G3D, "Block transfer download %08x -> %08x dangerous, %d+%d is taller than %d", srcBasePtr, dstBasePtr, srcRect.y, srcRect.h, srcRect.vfb->bufferHeight);
 				}
-				ReadFramebufferToMemory(srcRect.vfb, static_cast<int>(srcX * srcXFactor), srcY, static_cast<int>(srcRect.w_bytes * srcXFactor), srcRect.h, RASTER_COLOR, Draw::ReadbackMode::BLOCK);
+				ReadFramebufferToMemory(srcRect.vfb, static_cast<int>(srcX * srcXFactor), srcY, static_cast<int>(srcRect.w_bytes * srcXFactor), srcRect.h, RASTER_COLOR, GameReadbackMode(RASTER_COLOR));
 				srcRect.vfb->usageFlags = (srcRect.vfb->usageFlags | FB_USAGE_DOWNLOAD) & ~FB_USAGE_DOWNLOAD_CLEAR;
 			}
 		}
@@ -2625,6 +2801,7 @@ Draw::Framebuffer *FramebufferManagerCommon::GetTempFBO(TempFBO reason, u16 w, u
 	snprintf(name, sizeof(name), "tempfbo_%s_%dx%d", TempFBOReasonToString(reason), w / renderScaleFactor_, h / renderScaleFactor_);
 
 	Draw::Framebuffer *fbo = draw_->CreateFramebuffer({ w, h, 1, GetFramebufferLayers(), 0, z_stencil, name });
+	gpuStats.numFramebufferCreations++;
 	if (!fbo) {
 		return nullptr;
 	}
@@ -2902,10 +3079,71 @@ void FramebufferManagerCommon::ReadbackFramebuffer(VirtualFramebuffer *vfb, int
 	}
 }
 
+Draw::ReadbackMode FramebufferManagerCommon::GameReadbackMode(RasterChannel channel) {
+	// The delayed readback buffers are kept per framebuffer and channel, so depth works too.
+	if (!draw_->GetDeviceCaps().delayedReadbackSupported)
+		return Draw::ReadbackMode::BLOCK;
+	if (!PSP_CoreParameter().compat.flags().DelayedFramebufferReadbacks)
+		return Draw::ReadbackMode::BLOCK;
+	gpuStats.numDelayedReadbacks++;
+	return Draw::ReadbackMode::OLD_DATA_OK;
+}
+
 bool FramebufferManagerCommon::ReadbackStencilbuffer(Draw::Framebuffer *fbo, int x, int y, int w, int h, uint8_t *pixels, int pixelsStride, Draw::ReadbackMode mode) {
 	return draw_->CopyFramebufferToMemory(fbo, Draw::FB_DEPTH_BIT, x, y, w, h, Draw::DataFormat::S8, pixels, pixelsStride, mode, "ReadbackStencilbufferSync");
 }
 
+// 32 bands of 16 rows cover the 512 rows the GE can address.
+enum {
+	MEMORY_BAND_ROWS = 16,
+	MEMORY_BAND_COUNT = 32,
+};
+
+// Shrinks a full width color readback of rows [y, y + h) to the bands not yet in memory.
+// Returns false if there's nothing left to read.
+static bool TrimReadbackToMissingBands(VirtualFramebuffer *vfb, int &y, int &h) {
+	const int end = y + h;
+	const int firstBand = y / MEMORY_BAND_ROWS;
+	const int endBand = std::min((end + MEMORY_BAND_ROWS - 1) / MEMORY_BAND_ROWS, (int)MEMORY_BAND_COUNT);
+
+	int firstMissing = -1;
+	int lastMissing = -1;
+	for (int i = firstBand; i < endBand; ++i) {
+		if ((vfb->memoryUpdatedBands & (1U << i)) == 0) {
+			if (firstMissing == -1)
+				firstMissing = i;
+			lastMissing = i;
+		}
+	}
+
+	const int trackedEnd = MEMORY_BAND_COUNT * MEMORY_BAND_ROWS;
+	if (firstMissing == -1) {
+		if (end <= trackedEnd)
+			return false;
+		// Only the untracked rows past the last band are left.
+		h = end - std::max(y, trackedEnd);
+		y = std::max(y, trackedEnd);
+		return true;
+	}
+
+	// Read whole bands so they can be marked, it's only a few extra rows.
+	const int newY = firstMissing * MEMORY_BAND_ROWS;
+	int newEnd = std::min((lastMissing + 1) * MEMORY_BAND_ROWS, (int)vfb->bufferHeight);
+	if (end > trackedEnd)
+		newEnd = end;
+	for (int i = firstMissing; i <= lastMissing; ++i)
+		vfb->memoryUpdatedBands |= 1U << i;
+
+	y = newY;
+	h = std::max(newEnd - newY, 0);
+
+	const int heightBands = std::min(((int)vfb->height + MEMORY_BAND_ROWS - 1) / MEMORY_BAND_ROWS, (int)MEMORY_BAND_COUNT);
+	const u32 fullMask = heightBands >= 32 ? 0xFFFFFFFF : (1U << heightBands) - 1;
+	if (vfb->height <= trackedEnd && (vfb->memoryUpdatedBands & fullMask) == fullMask)
+		vfb->memoryUpdated = true;
+	return h > 0;
+}
+
 void FramebufferManagerCommon::ReadFramebufferToMemory(VirtualFramebuffer *vfb, int x, int y, int w, int h, RasterChannel channel, Draw::ReadbackMode mode) {
 	// Clamp to bufferWidth. Sometimes block transfers can cause this to hit.
 	if (x + w >= vfb->bufferWidth) {
@@ -2919,13 +3157,21 @@ void FramebufferManagerCommon::ReadFramebufferToMemory(VirtualFramebuffer *vfb,
 			w = vfb->width;
 			h = vfb->height;
 			vfb->memoryUpdated = true;
+			vfb->memoryUpdatedBands = 0xFFFFFFFF;
 			vfb->usageFlags |= FB_USAGE_DOWNLOAD;
 		} else if (x == 0 && y == 0 && w == vfb->width && h == vfb->height) {
 			// Mark it as fully downloaded until next render to it.
-			if (channel == RASTER_COLOR)
+			if (channel == RASTER_COLOR) {
 				vfb->memoryUpdated = true;
+				vfb->memoryUpdatedBands = 0xFFFFFFFF;
+			}
 			vfb->usageFlags |= FB_USAGE_DOWNLOAD;
 		} else {
+			if (channel == RASTER_COLOR && x == 0 && w >= vfb->width && !TrimReadbackToMissingBands(vfb, y, h)) {
+				// These rows were already read back since the last render.
+				return;
+			}
+
 			// Let's try to set the flag eventually, if the game copies a lot.
 			// Some games (like Grand Knights History) copy subranges very frequently.
 			const static int FREQUENT_SEQUENTIAL_COPIES = 3;
@@ -2995,7 +3241,7 @@ void FramebufferManagerCommon::DownloadFramebufferForClut(u32 fb_address, u32 lo
 			vfb->clutUpdatedBytes = loadBytes;
 
 			// This function now handles scaling down internally.
-			ReadbackFramebuffer(vfb, x, y, w, h, RASTER_COLOR, Draw::ReadbackMode::BLOCK);
+			ReadbackFramebuffer(vfb, x, y, w, h, RASTER_COLOR, GameReadbackMode(RASTER_COLOR));
 
 			textureCache_->ForgetLastTexture();
 			RebindFramebuffer("RebindFramebuffer - DownloadFramebufferForClut");
@@ -3327,6 +3573,7 @@ VirtualFramebuffer *FramebufferManagerCommon::ResolveFramebufferColorToFormat(Vi
 		char tag[128];
 		FormatFramebufferName(vfb, tag, sizeof(tag));
 		vfb->fbo = draw_->CreateFramebuffer({ vfb->renderWidth, vfb->renderHeight, 1, GetFramebufferLayers(), 0, true, tag });
+		gpuStats.numFramebufferCreations++;
 		vfbs_.push_back(vfb);
 	}
 
@@ -127,6 +127,9 @@ struct VirtualFramebuffer {
 
 	// Means that the whole image has already been read back to memory - used when combining small readbacks (gameUsesSequentialCopies_).
 	bool memoryUpdated;
+	// Full width bands of MEMORY_BAND_ROWS rows read back since the last render, one bit each.
+	// Lets partial readbacks skip rows that are already in memory.
+	u32 memoryUpdatedBands;
 
 	// TODO: Fold into usageFlags?
 	bool dirtyAfterDisplay;
@@ -394,6 +397,14 @@ class FramebufferManagerCommon {
 	// This will only return exact matches of addr+stride+format.
 	VirtualFramebuffer *GetExactVFB(u32 addr, int stride, GEBufferFormat format) const;
 
+	// Used to skip display lists that would draw the same thing again.
+	// Newest color bind sequence number of any framebuffer at addr, or -1 if there's none.
+	int GetColorBindSeqAt(u32 addr) const;
+	// Marks framebuffers at addr as rendered to this frame, without binding them.
+	void NotifyRenderSkipped(u32 addr, u32 skipDrawReason);
+	// Checks the color and depth memory of all framebuffers.
+	bool MayOverlapFramebuffer(u32 addr, u32 size) const;
+
 	// If this doesn't find the exact VFB, but one with a different color format with matching stride,
 	// it'll resolve the newest one at address to the format requested, and return that.
 	VirtualFramebuffer *ResolveVFB(u32 addr, int stride, GEBufferFormat format);
@@ -474,6 +485,8 @@ class FramebufferManagerCommon {
 
 protected:
 	virtual void ReadbackFramebuffer(VirtualFramebuffer *vfb, int x, int y, int w, int h, RasterChannel channel, Draw::ReadbackMode mode);
+	// For downloads the game asks for, which can be allowed to lag a frame behind per game.
+	Draw::ReadbackMode GameReadbackMode(RasterChannel channel);
 	// Used for when a shader is required, such as GLES.
 	virtual bool ReadbackDepthbuffer(Draw::Framebuffer *fbo, int x, int y, int w, int h, uint16_t *pixels, int pixelsStride, int destW, int destH, Draw::ReadbackMode mode);
 	virtual bool ReadbackStencilbuffer(Draw::Framebuffer *fbo, int x, int y, int w, int h, uint8_t *pixels, int pixelsStride, Draw::ReadbackMode mode);
@@ -485,6 +498,7 @@ class FramebufferManagerCommon {
 	void CopyToDepthFromOverlappingFramebuffers(VirtualFramebuffer *dest);
 
 	bool UpdateRenderSize(int msaaLevel);
+	void UpdateDynamicResolution();
 
 	void FlushBeforeCopy();
 	virtual void DecimateFBOs();  // keeping it virtual to let D3D do a little extra
@@ -503,6 +517,8 @@ class FramebufferManagerCommon {
 	void BlitFramebufferDepth(VirtualFramebuffer *src, VirtualFramebuffer *dst);
 
 	void ResizeFramebufFBO(VirtualFramebuffer *vfb, int w, int h, bool force = false, bool skipCopy = false);
+	// The scale vfb should be rendered at, 1 if the bloom hack or compat flags force it down.
+	int TargetRenderScaleFactor(const VirtualFramebuffer *vfb) const;
 	void ShowScreenResolution();
 
 	bool ShouldDownloadFramebufferColor(const VirtualFramebuffer *vfb) const;
@@ -522,6 +538,7 @@ class FramebufferManagerCommon {
 
 	static void SetColorUpdated(VirtualFramebuffer *dstBuffer, int skipDrawReason) {
 		dstBuffer->memoryUpdated = false;
+		dstBuffer->memoryUpdatedBands = 0;
 		dstBuffer->clutUpdatedBytes = 0;
 		dstBuffer->dirtyAfterDisplay = true;
 		dstBuffer->drawnWidth = dstBuffer->width;
@@ -578,6 +595,12 @@ class FramebufferManagerCommon {
 
 	int msaaLevel_ = 0;
 	int renderScaleFactor_ = 1;
+	// With dynamic resolution, renderScaleFactor_ moves below this, and framebuffers follow as they're rendered to.
+	int maxRenderScaleFactor_ = 1;
+	bool dynamicResolution_ = false;
+	int dynamicOverBudgetFrames_ = 0;
+	int dynamicUnderBudgetFrames_ = 0;
+	int dynamicCooldownFrames_ = 0;
 	int pixelWidth_ = 0;
 	int pixelHeight_ = 0;
 	int bloomHack_ = 0;
@@ -600,6 +623,14 @@ class FramebufferManagerCommon {
 		FBO_OLD_USAGE_FLAG = 15,
 	};
 
+	// Frames in a row over or under budget before dynamic resolution takes a step, and frames to wait after one.
+	// Going up is slower, to avoid bouncing back and forth.
+	enum {
+		DYNAMIC_RES_DOWN_FRAMES = 10,
+		DYNAMIC_RES_UP_FRAMES = 120,
+		DYNAMIC_RES_COOLDOWN_FRAMES = 30,
+	};
+
 	// Thin3D stuff for reinterpreting image data between the various 16-bit color formats.
 	// Safe, not optimal - there might be input attachment tricks, etc, but we can't use them
 	// since we don't want N different implementations.
@@ -45,6 +45,159 @@ const u8 IndexGenerator::indexedPrimitiveType[7] = {
 	GE_PRIM_RECTANGLES,
 };
 
+// 24 indices is both a whole number of 8-lane registers and of triangles, so the simple prims are
+// generated by repeating a pattern of 24, adding step to each lane for every repetition.
+alignas(16) static const u16 sequence_pattern[24] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23,
+};
+alignas(16) static const u16 list_counter_clockwise_pattern[24] = {
+	0, 2, 1, 3, 5, 4, 6, 8, 7, 9, 11, 10, 12, 14, 13, 15, 17, 16, 18, 20, 19, 21, 23, 22,
+};
+alignas(16) static const u16 step24[24] = {
+	24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24,
+};
+alignas(16) static const u16 line_strip_pattern[24] = {
+	0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12,
+};
+alignas(16) static const u16 step12[24] = {
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+};
+alignas(16) static const u16 fan_clockwise_pattern[24] = {
+	0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 5, 0, 5, 6, 0, 6, 7, 0, 7, 8, 0, 8, 9,
+};
+alignas(16) static const u16 fan_counter_clockwise_pattern[24] = {
+	0, 2, 1, 0, 3, 2, 0, 4, 3, 0, 5, 4, 0, 6, 5, 0, 7, 6, 0, 8, 7, 0, 9, 8,
+};
+// The center vertex stays put.
+alignas(16) static const u16 fan_step[24] = {
+	0, 8, 8, 0, 8, 8, 0, 8, 8, 0, 8, 8, 0, 8, 8, 0, 8, 8, 0, 8, 8, 0, 8, 8,
+};
+
+// Writes numChunks * 24 indices and returns the new end.
+static u16 *GeneratePattern24(u16 *out, int numChunks, int start, const u16 *pattern, const u16 *step) {
+#ifdef _M_SSE
+	const __m128i base = _mm_set1_epi16((short)start);
+	const __m128i *patterns = (const __m128i *)pattern;
+	const __m128i *steps = (const __m128i *)step;
+	__m128i v0 = _mm_add_epi16(base, _mm_load_si128(patterns));
+	__m128i v1 = _mm_add_epi16(base, _mm_load_si128(patterns + 1));
+	__m128i v2 = _mm_add_epi16(base, _mm_load_si128(patterns + 2));
+	const __m128i s0 = _mm_load_si128(steps);
+	const __m128i s1 = _mm_load_si128(steps + 1);
+	const __m128i s2 = _mm_load_si128(steps + 2);
+	for (int i = 0; i < numChunks; i++) {
+		__m128i *dst = (__m128i *)out;
+		_mm_storeu_si128(dst, v0);
+		_mm_storeu_si128(dst + 1, v1);
+		_mm_storeu_si128(dst + 2, v2);
+		v0 = _mm_add_epi16(v0, s0);
+		v1 = _mm_add_epi16(v1, s1);
+		v2 = _mm_add_epi16(v2, s2);
+		out += 24;
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t base = vdupq_n_u16((u16)start);
+	uint16x8_t v0 = vaddq_u16(base, vld1q_u16(pattern));
+	uint16x8_t v1 = vaddq_u16(base, vld1q_u16(pattern + 8));
+	uint16x8_t v2 = vaddq_u16(base, vld1q_u16(pattern + 16));
+	const uint16x8_t s0 = vld1q_u16(step);
+	const uint16x8_t s1 = vld1q_u16(step + 8);
+	const uint16x8_t s2 = vld1q_u16(step + 16);
+	for (int i = 0; i < numChunks; i++) {
+		vst1q_u16(out, v0);
+		vst1q_u16(out + 8, v1);
+		vst1q_u16(out + 16, v2);
+		v0 = vaddq_u16(v0, s0);
+		v1 = vaddq_u16(v1, s1);
+		v2 = vaddq_u16(v2, s2);
+		out += 24;
+	}
+#else
+	for (int i = 0; i < numChunks; i++) {
+		for (int j = 0; j < 24; j++)
+			out[j] = start + pattern[j] + step[j] * i;
+		out += 24;
+	}
+#endif
+	return out;
+}
+
+// out[i] = indexOffset + inds[i], for the prims where the order doesn't change.
+template <class ITypeLE>
+static inline void TranslateIndices(u16 *out, const ITypeLE *inds, int count, int indexOffset) {
+	for (int i = 0; i < count; i++)
+		out[i] = indexOffset + inds[i];
+}
+
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+// These are only picked over the template above when the _le types are plain integers.
+static inline void TranslateIndices(u16 *out, const u8 *inds, int count, int indexOffset) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i offset = _mm_set1_epi16((short)indexOffset);
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(inds + i)), zero);
+		_mm_storeu_si128((__m128i *)(out + i), _mm_add_epi16(v, offset));
+	}
+#else
+	const uint16x8_t offset = vdupq_n_u16((u16)indexOffset);
+	for (; i + 8 <= count; i += 8)
+		vst1q_u16(out + i, vaddq_u16(vmovl_u8(vld1_u8(inds + i)), offset));
+#endif
+	for (; i < count; i++)
+		out[i] = indexOffset + inds[i];
+}
+
+static inline void TranslateIndices(u16 *out, const u16 *inds, int count, int indexOffset) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i offset = _mm_set1_epi16((short)indexOffset);
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(inds + i));
+		_mm_storeu_si128((__m128i *)(out + i), _mm_add_epi16(v, offset));
+	}
+#else
+	const uint16x8_t offset = vdupq_n_u16((u16)indexOffset);
+	for (; i + 8 <= count; i += 8)
+		vst1q_u16(out + i, vaddq_u16(vld1q_u16(inds + i), offset));
+#endif
+	for (; i < count; i++)
+		out[i] = indexOffset + inds[i];
+}
+
+static inline void TranslateIndices(u16 *out, const u32 *inds, int count, int indexOffset) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i offset = _mm_set1_epi16((short)indexOffset);
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = _mm_loadu_si128((const __m128i *)(inds + i));
+		__m128i hi = _mm_loadu_si128((const __m128i *)(inds + i + 4));
+		// No unsigned 32 -> 16 pack in SSE2, so sign extend the low half first to make packs truncate.
+		lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+		hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+		_mm_storeu_si128((__m128i *)(out + i), _mm_add_epi16(_mm_packs_epi32(lo, hi), offset));
+	}
+#else
+	const uint16x8_t offset = vdupq_n_u16((u16)indexOffset);
+	for (; i + 8 <= count; i += 8) {
+		uint16x8_t v = vcombine_u16(vmovn_u32(vld1q_u32(inds + i)), vmovn_u32(vld1q_u32(inds + i + 4)));
+		vst1q_u16(out + i, vaddq_u16(v, offset));
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = indexOffset + inds[i];
+}
+#endif
+
+static u16 *GenerateSequence(u16 *out, int count, int start) {
+	const int numChunks = count / 24;
+	out = GeneratePattern24(out, numChunks, start, sequence_pattern, step24);
+	for (int i = numChunks * 24; i < count; i++)
+		*out++ = start + i;
+	return out;
+}
+
 void IndexGenerator::Setup(u16 *inds) {
 	this->indsBase_ = inds;
 	Reset();
@@ -63,11 +216,7 @@ void IndexGenerator::AddPrim(int prim, int vertexCount, bool clockwise) {
 }
 
 void IndexGenerator::AddPoints(int numVerts) {
-	u16 *outInds = inds_;
-	const int startIndex = index_;
-	for (int i = 0; i < numVerts; i++)
-		*outInds++ = startIndex + i;
-	inds_ = outInds;
+	inds_ = GenerateSequence(inds_, numVerts, index_);
 	// ignore overflow verts
 	index_ += numVerts;
 	count_ += numVerts;
@@ -76,16 +225,21 @@ void IndexGenerator::AddPoints(int numVerts) {
 }
 
 void IndexGenerator::AddList(int numVerts, bool clockwise) {
-	u16 *outInds = inds_;
 	const int startIndex = index_;
-	const int v1 = clockwise ? 1 : 2;
-	const int v2 = clockwise ? 2 : 1;
-	for (int i = 0; i < numVerts; i += 3) {
-		*outInds++ = startIndex + i;
-		*outInds++ = startIndex + i + v1;
-		*outInds++ = startIndex + i + v2;
+	// Partial triangles still get all three indices, but aren't counted.
+	const int numTris = (numVerts + 2) / 3;
+	if (clockwise) {
+		inds_ = GenerateSequence(inds_, numTris * 3, startIndex);
+	} else {
+		const int numChunks = numTris / 8;
+		u16 *outInds = GeneratePattern24(inds_, numChunks, startIndex, list_counter_clockwise_pattern, step24);
+		for (int i = numChunks * 24; i < numTris * 3; i += 3) {
+			*outInds++ = startIndex + i;
+			*outInds++ = startIndex + i + 2;
+			*outInds++ = startIndex + i + 1;
+		}
+		inds_ = outInds;
 	}
-	inds_ = outInds;
 	// ignore overflow verts
 	index_ += numVerts;
 	count_ += numVerts;
@@ -168,7 +322,7 @@ void IndexGenerator::AddStrip(int numVerts, bool clockwise) {
 	// Slow fallback loop.
 	int wind = clockwise ? 1 : 2;
 	int ibase = index_;
-	size_t numPairs = numTris / 2;
+	size_t numPairs = numTris > 0 ? numTris / 2 : 0;
 	u16 *outInds = inds_;
 	while (numPairs > 0) {
 		*outInds++ = ibase;
@@ -180,7 +334,7 @@ void IndexGenerator::AddStrip(int numVerts, bool clockwise) {
 		ibase += 2;
 		numPairs--;
 	}
-	if (numTris & 1) {
+	if (numTris > 0 && (numTris & 1)) {
 		*outInds++ = ibase;
 		*outInds++ = ibase + wind;
 		wind ^= 3;  // toggle between 1 and 2
@@ -206,18 +360,20 @@ void IndexGenerator::AddStrip(int numVerts, bool clockwise) {
 
 void IndexGenerator::AddFan(int numVerts, bool clockwise) {
 	const int numTris = numVerts - 2;
-	u16 *outInds = inds_;
 	const int startIndex = index_;
 	const int v1 = clockwise ? 1 : 2;
 	const int v2 = clockwise ? 2 : 1;
-	for (int i = 0; i < numTris; i++) {
+	const int numChunks = numTris > 0 ? numTris / 8 : 0;
+	u16 *outInds = GeneratePattern24(inds_, numChunks, startIndex, clockwise ? fan_clockwise_pattern : fan_counter_clockwise_pattern, fan_step);
+	for (int i = numChunks * 8; i < numTris; i++) {
 		*outInds++ = startIndex;
 		*outInds++ = startIndex + i + v1;
 		*outInds++ = startIndex + i + v2;
 	}
 	inds_ = outInds;
 	index_ += numVerts;
-	count_ += numTris * 3;
+	if (numTris > 0)
+		count_ += numTris * 3;
 	prim_ = GE_PRIM_TRIANGLES;
 	seenPrims_ |= 1 << GE_PRIM_TRIANGLE_FAN;
 	if (!clockwise) {
@@ -228,13 +384,8 @@ void IndexGenerator::AddFan(int numVerts, bool clockwise) {
 
 //Lines
 void IndexGenerator::AddLineList(int numVerts) {
-	u16 *outInds = inds_;
-	const int startIndex = index_;
-	for (int i = 0; i < numVerts; i += 2) {
-		*outInds++ = startIndex + i;
-		*outInds++ = startIndex + i + 1;
-	}
-	inds_ = outInds;
+	// A trailing half line still gets both indices.
+	inds_ = GenerateSequence(inds_, (numVerts + 1) & ~1, index_);
 	index_ += numVerts;
 	count_ += numVerts;
 	prim_ = GE_PRIM_LINES;
@@ -243,29 +394,25 @@ void IndexGenerator::AddLineList(int numVerts) {
 
 void IndexGenerator::AddLineStrip(int numVerts) {
 	const int numLines = numVerts - 1;
-	u16 *outInds = inds_;
 	const int startIndex = index_;
-	for (int i = 0; i < numLines; i++) {
+	const int numChunks = numLines > 0 ? numLines / 12 : 0;
+	u16 *outInds = GeneratePattern24(inds_, numChunks, startIndex, line_strip_pattern, step12);
+	for (int i = numChunks * 12; i < numLines; i++) {
 		*outInds++ = startIndex + i;
 		*outInds++ = startIndex + i + 1;
 	}
 	inds_ = outInds;
 	index_ += numVerts;
-	count_ += numLines * 2;
+	if (numLines > 0)
+		count_ += numLines * 2;
 	prim_ = GE_PRIM_LINES;
 	seenPrims_ |= 1 << GE_PRIM_LINE_STRIP;
 }
 
 void IndexGenerator::AddRectangles(int numVerts) {
-	u16 *outInds = inds_;
-	const int startIndex = index_;
 	//rectangles always need 2 vertices, disregard the last one if there's an odd number
 	numVerts = numVerts & ~1;
-	for (int i = 0; i < numVerts; i += 2) {
-		*outInds++ = startIndex + i;
-		*outInds++ = startIndex + i + 1;
-	}
-	inds_ = outInds;
+	inds_ = GenerateSequence(inds_, numVerts, index_);
 	index_ += numVerts;
 	count_ += numVerts;
 	prim_ = GE_PRIM_RECTANGLES;
@@ -275,10 +422,8 @@ void IndexGenerator::AddRectangles(int numVerts) {
 template <class ITypeLE, int flag>
 void IndexGenerator::TranslatePoints(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
-	for (int i = 0; i < numInds; i++)
-		*outInds++ = indexOffset + inds[i];
-	inds_ = outInds;
+	TranslateIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_POINTS;
 	seenPrims_ |= (1 << GE_PRIM_POINTS) | flag;
@@ -287,13 +432,9 @@ void IndexGenerator::TranslatePoints(int numInds, const ITypeLE *inds, int index
 template <class ITypeLE, int flag>
 void IndexGenerator::TranslateLineList(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
-		*outInds++ = indexOffset + inds[i];
-		*outInds++ = indexOffset + inds[i + 1];
-	}
-	inds_ = outInds;
+	TranslateIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_LINES;
 	seenPrims_ |= (1 << GE_PRIM_LINES) | flag;
@@ -309,7 +450,8 @@ void IndexGenerator::TranslateLineStrip(int numInds, const ITypeLE *inds, int in
 		*outInds++ = indexOffset + inds[i + 1];
 	}
 	inds_ = outInds;
-	count_ += numLines * 2;
+	if (numLines > 0)
+		count_ += numLines * 2;
 	prim_ = GE_PRIM_LINES;
 	seenPrims_ |= (1 << GE_PRIM_LINE_STRIP) | flag;
 }
@@ -323,6 +465,12 @@ void IndexGenerator::TranslateList(int numInds, const ITypeLE *inds, int indexOf
 		memcpy(inds_, inds, numInds * sizeof(ITypeLE));
 		inds_ += numInds;
 		count_ += numInds;
+	} else if (clockwise) {
+		int numTris = numInds / 3;  // Round to whole triangles
+		numInds = numTris * 3;
+		TranslateIndices(inds_, inds, numInds, indexOffset);
+		inds_ += numInds;
+		count_ += numInds;
 	} else {
 		u16 *outInds = inds_;
 		int numTris = numInds / 3;  // Round to whole triangles
@@ -354,7 +502,8 @@ void IndexGenerator::TranslateStrip(int numInds, const ITypeLE *inds, int indexO
 		*outInds++ = indexOffset + inds[i + wind];
 	}
 	inds_ = outInds;
-	count_ += numTris * 3;
+	if (numTris > 0)
+		count_ += numTris * 3;
 	prim_ = GE_PRIM_TRIANGLES;
 	seenPrims_ |= (1 << GE_PRIM_TRIANGLE_STRIP) | flag;
 }
@@ -373,7 +522,8 @@ void IndexGenerator::TranslateFan(int numInds, const ITypeLE *inds, int indexOff
 		*outInds++ = indexOffset + inds[i + v2];
 	}
 	inds_ = outInds;
-	count_ += numTris * 3;
+	if (numTris > 0)
+		count_ += numTris * 3;
 	prim_ = GE_PRIM_TRIANGLES;
 	seenPrims_ |= (1 << GE_PRIM_TRIANGLE_FAN) | flag;
 }
@@ -381,14 +531,10 @@ void IndexGenerator::TranslateFan(int numInds, const ITypeLE *inds, int indexOff
 template <class ITypeLE, int flag>
 inline void IndexGenerator::TranslateRectangles(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
 	//rectangles always need 2 vertices, disregard the last one if there's an odd number
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
-		*outInds++ = indexOffset + inds[i];
-		*outInds++ = indexOffset + inds[i+1];
-	}
-	inds_ = outInds;
+	TranslateIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_RECTANGLES;
 	seenPrims_ |= (1 << GE_PRIM_RECTANGLES) | flag;
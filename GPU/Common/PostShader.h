@@ -47,6 +47,8 @@ struct ShaderInfo {
 	bool requires60fps;
 	// Takes previous frame as input (for blending effects.)
 	bool usePreviousFrame;
+	// Only samples sampler0 at v_texcoord0, so it can be merged into the pass before it.
+	bool perPixel;
 
 	struct Setting {
 		std::string name;
@@ -15,9 +15,11 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cmath>
-#include <set>
 #include <cstdint>
+#include <cstring>
+#include <set>
 
 #include "Common/GPU/thin3d.h"
 
@@ -26,6 +28,7 @@
 #include "Common/File/VFS/VFS.h"
 #include "Common/VR/PPSSPPVR.h"
 #include "Common/Log.h"
+#include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
@@ -180,7 +183,7 @@ static float GetShaderSettingValue(const ShaderInfo *shaderInfo, int i, const ch
 	return shaderInfo->settings[i].value;
 }
 
-void PresentationCommon::CalculatePostShaderUniforms(int bufferWidth, int bufferHeight, int targetWidth, int targetHeight, const ShaderInfo *shaderInfo, PostShaderUniforms *uniforms) const {
+void PresentationCommon::CalculatePostShaderUniforms(int bufferWidth, int bufferHeight, int targetWidth, int targetHeight, const ShaderInfo *shaderInfo, PostShaderUniforms *uniforms, const std::vector<ShaderInfo> *fused) const {
 	float u_delta = 1.0f / bufferWidth;
 	float v_delta = 1.0f / bufferHeight;
 	float u_pixel_delta = 1.0f / targetWidth;
@@ -208,6 +211,17 @@ void PresentationCommon::CalculatePostShaderUniforms(int bufferWidth, int buffer
 	uniforms->setting[1] = GetShaderSettingValue(shaderInfo, 1, "SettingCurrentValue2");
 	uniforms->setting[2] = GetShaderSettingValue(shaderInfo, 2, "SettingCurrentValue3");
 	uniforms->setting[3] = GetShaderSettingValue(shaderInfo, 3, "SettingCurrentValue4");
+
+	memset(uniforms->fusedSetting, 0, sizeof(uniforms->fusedSetting));
+	if (fused) {
+		for (size_t i = 0; i < fused->size(); ++i) {
+			const ShaderInfo *fusedInfo = &(*fused)[i];
+			uniforms->fusedSetting[i][0] = GetShaderSettingValue(fusedInfo, 0, "SettingCurrentValue1");
+			uniforms->fusedSetting[i][1] = GetShaderSettingValue(fusedInfo, 1, "SettingCurrentValue2");
+			uniforms->fusedSetting[i][2] = GetShaderSettingValue(fusedInfo, 2, "SettingCurrentValue3");
+			uniforms->fusedSetting[i][3] = GetShaderSettingValue(fusedInfo, 3, "SettingCurrentValue4");
+		}
+	}
 }
 
 static std::string ReadShaderSrc(const Path &filename) {
@@ -222,6 +236,180 @@ static std::string ReadShaderSrc(const Path &filename) {
 	return src;
 }
 
+static bool IsIdentifierChar(char c) {
+	return isalnum((unsigned char)c) || c == '_';
+}
+
+static size_t FindWord(const std::string &src, const char *word, size_t pos = 0) {
+	size_t len = strlen(word);
+	while ((pos = src.find(word, pos)) != std::string::npos) {
+		bool startOK = pos == 0 || !IsIdentifierChar(src[pos - 1]);
+		bool endOK = pos + len >= src.size() || !IsIdentifierChar(src[pos + len]);
+		if (startOK && endOK)
+			return pos;
+		pos += len;
+	}
+	return std::string::npos;
+}
+
+static void ReplaceWord(std::string *src, const char *word, const std::string &replacement) {
+	size_t pos = 0;
+	while ((pos = FindWord(*src, word, pos)) != std::string::npos) {
+		src->replace(pos, strlen(word), replacement);
+		pos += replacement.size();
+	}
+}
+
+static std::string StripComments(const std::string &src) {
+	std::string out;
+	out.reserve(src.size());
+	for (size_t i = 0; i < src.size(); ++i) {
+		if (src[i] == '/' && i + 1 < src.size() && src[i + 1] == '/') {
+			while (i < src.size() && src[i] != '\n')
+				++i;
+			if (i < src.size())
+				out += '\n';
+		} else if (src[i] == '/' && i + 1 < src.size() && src[i + 1] == '*') {
+			size_t end = src.find("*/", i + 2);
+			i = end == std::string::npos ? src.size() : end + 1;
+			out += ' ';
+		} else {
+			out += src[i];
+		}
+	}
+	return out;
+}
+
+static std::string TrimWhitespace(const std::string &line) {
+	size_t start = line.find_first_not_of(" \t\r");
+	if (start == std::string::npos)
+		return "";
+	size_t end = line.find_last_not_of(" \t\r");
+	return line.substr(start, end - start + 1);
+}
+
+// The entry point gets renamed, so that a generated main() can call each shader in turn.
+static bool RenameMain(std::string *src, const std::string &name) {
+	size_t pos = FindWord(*src, "main");
+	if (pos == std::string::npos || FindWord(*src, "main", pos + 4) != std::string::npos)
+		return false;
+	src->replace(pos, 4, name);
+	return true;
+}
+
+// Rewrites a PerPixel shader to take its input from fused_color, and to read its settings from
+// u_settingN. Declarations the first shader already has are dropped.
+// Returns false if it turns out to look at anything but its own pixel.
+static bool PrepareFusedShader(std::string *src, const std::string &head, int index) {
+	std::string out;
+	std::vector<std::string> headLines;
+	SplitString(head, '\n', headLines);
+	for (std::string &line : headLines)
+		line = TrimWhitespace(line);
+
+	std::vector<std::string> lines;
+	SplitString(*src, '\n', lines);
+	for (const std::string &line : lines) {
+		std::string trimmed = TrimWhitespace(line);
+		bool isUniform = startsWith(trimmed, "uniform ");
+		bool isVarying = startsWith(trimmed, "varying ");
+		if (isUniform && FindWord(trimmed, "u_setting") != std::string::npos) {
+			out += StringFromFormat("uniform vec4 u_setting%d;\n", index);
+		} else if (isUniform && trimmed == "uniform sampler2D sampler0;") {
+			continue;
+		} else if (isUniform || isVarying) {
+			// Varyings have to come from the same vertex shader.
+			bool found = std::find(headLines.begin(), headLines.end(), trimmed) != headLines.end();
+			if (!found && isVarying)
+				return false;
+			if (!found)
+				out += line + "\n";
+		} else {
+			out += line + "\n";
+		}
+	}
+	ReplaceWord(&out, "u_setting", StringFromFormat("u_setting%d", index));
+
+	size_t pos = 0;
+	static const char *const textureCall = "texture2D";
+	while ((pos = FindWord(out, textureCall, pos)) != std::string::npos) {
+		size_t open = out.find_first_not_of(" \t", pos + strlen(textureCall));
+		if (open == std::string::npos || out[open] != '(')
+			return false;
+		size_t close = open;
+		int depth = 0;
+		for (; close < out.size(); ++close) {
+			if (out[close] == '(')
+				depth++;
+			else if (out[close] == ')' && --depth == 0)
+				break;
+		}
+		if (close >= out.size())
+			return false;
+
+		std::string args;
+		for (size_t i = open + 1; i < close; ++i) {
+			if (!isspace((unsigned char)out[i]))
+				args += out[i];
+		}
+		if (args != "sampler0,v_texcoord0" && args != "sampler0,v_texcoord0.xy")
+			return false;
+		out.replace(pos, close + 1 - pos, "fused_color");
+		pos += strlen("fused_color");
+	}
+
+	static const char *const forbidden[] = {
+		"sampler0", "sampler1", "sampler2", "texture2DProj", "texture2DLod",
+		"u_texelDelta", "u_pixelDelta", "gl_FragCoord", "gl_HalfPixel",
+	};
+	for (const char *word : forbidden) {
+		if (FindWord(out, word) != std::string::npos)
+			return false;
+	}
+
+	*src = out;
+	return true;
+}
+
+// Merges the PerPixel shaders after the first into one fragment shader, by calling each of their
+// mains in turn and feeding the previous gl_FragColor in place of their texture read.
+static bool BuildFusedFragmentShader(const std::vector<const ShaderInfo *> &group, std::string *fragmentSource) {
+	std::string head = StripComments(ReadShaderSrc(group[0]->fragmentShaderFile));
+	if (head.empty())
+		return false;
+	std::string src = head;
+	if (!RenameMain(&src, "fused_main0"))
+		return false;
+	src += "\nvec4 fused_color;\n";
+
+	std::string callMains = "void main() {\n\tfused_main0();\n";
+	for (size_t i = 1; i < group.size(); ++i) {
+		std::string shader = StripComments(ReadShaderSrc(group[i]->fragmentShaderFile));
+		std::string name = StringFromFormat("fused_main%d", (int)i);
+		if (shader.empty() || !PrepareFusedShader(&shader, head, (int)i) || !RenameMain(&shader, name))
+			return false;
+		src += shader + "\n";
+		callMains += "\tfused_color = gl_FragColor;\n\t" + name + "();\n";
+	}
+	src += callMains + "}\n";
+
+	std::string errorMessage;
+	if (!ValidateShader(src, GLSL_1xx, ShaderStage::Fragment, &errorMessage)) {
+		WARN_LOG(FRAMEBUF, "Unable to merge post shader %s with the following ones, running them separately:\n%s", group[0]->section.c_str(), errorMessage.c_str());
+		return false;
+	}
+
+	*fragmentSource = src;
+	return true;
+}
+
+static bool CanFusePostShader(const ShaderInfo *head, const ShaderInfo *shaderInfo) {
+	if (!shaderInfo->perPixel || shaderInfo->usePreviousFrame || shaderInfo->isUpscalingFilter || shaderInfo->SSAAFilterLevel >= 2 || shaderInfo->isStereo)
+		return false;
+	// It'll run at the resolution of the pass it's merged into.
+	return !shaderInfo->outputResolution || head->outputResolution;
+}
+
 // Note: called on resize and settings changes.
 // Also takes care of making sure the appropriate stereo shader is compiled.
 bool PresentationCommon::UpdatePostShader() {
@@ -253,20 +441,40 @@ bool PresentationCommon::UpdatePostShader() {
 
 	bool usePreviousFrame = false;
 	bool usePreviousAtOutputResolution = false;
-	for (size_t i = 0; i < shaderInfo.size(); ++i) {
-		const ShaderInfo *next = i + 1 < shaderInfo.size() ? shaderInfo[i + 1] : nullptr;
+	for (size_t i = 0; i < shaderInfo.size(); ) {
+		// Save a pass and a framebuffer for each simple color shader we can merge into this one.
+		std::vector<const ShaderInfo *> group{ shaderInfo[i] };
+		while (group.size() < MAX_FUSED_POST_SHADERS && i + group.size() < shaderInfo.size() && CanFusePostShader(shaderInfo[i], shaderInfo[i + group.size()]))
+			group.push_back(shaderInfo[i + group.size()]);
+
+		std::string fusedSource;
+		if (group.size() > 1 && !BuildFusedFragmentShader(group, &fusedSource))
+			group.resize(1);
+
 		Draw::Pipeline *postPipeline = nullptr;
-		if (!BuildPostShader(shaderInfo[i], next, &postPipeline)) {
+		const ShaderInfo *next = i + group.size() < shaderInfo.size() ? shaderInfo[i + group.size()] : nullptr;
+		bool success = BuildPostShader(shaderInfo[i], next, &postPipeline, group.size() > 1 ? &fusedSource : nullptr);
+		if (!success && group.size() > 1) {
+			WARN_LOG(FRAMEBUF, "Failed to compile merged post shader %s, running the chain separately", shaderInfo[i]->section.c_str());
+			group.resize(1);
+			next = i + 1 < shaderInfo.size() ? shaderInfo[i + 1] : nullptr;
+			success = BuildPostShader(shaderInfo[i], next, &postPipeline);
+		}
+		if (!success) {
 			DestroyPostShader();
 			return false;
 		}
 		_dbg_assert_(postPipeline);
 		postShaderPipelines_.push_back(postPipeline);
 		postShaderInfo_.push_back(*shaderInfo[i]);
+		postShaderFused_.push_back(std::vector<ShaderInfo>());
+		for (size_t j = 1; j < group.size(); ++j)
+			postShaderFused_.back().push_back(*group[j]);
 		if (shaderInfo[i]->usePreviousFrame) {
 			usePreviousFrame = true;
 			usePreviousAtOutputResolution = shaderInfo[i]->outputResolution;
 		}
+		i += group.size();
 	}
 
 	if (usePreviousFrame) {
@@ -290,11 +498,11 @@ bool PresentationCommon::UpdatePostShader() {
 	return true;
 }
 
-bool PresentationCommon::CompilePostShader(const ShaderInfo *shaderInfo, Draw::Pipeline **outPipeline) const {
+bool PresentationCommon::CompilePostShader(const ShaderInfo *shaderInfo, Draw::Pipeline **outPipeline, const std::string *fragmentSource) const {
 	_assert_(shaderInfo);
 
 	std::string vsSourceGLSL = ReadShaderSrc(shaderInfo->vertexShaderFile);
-	std::string fsSourceGLSL = ReadShaderSrc(shaderInfo->fragmentShaderFile);
+	std::string fsSourceGLSL = fragmentSource ? *fragmentSource : ReadShaderSrc(shaderInfo->fragmentShaderFile);
 	if (vsSourceGLSL.empty() || fsSourceGLSL.empty()) {
 		return false;
 	}
@@ -324,6 +532,9 @@ bool PresentationCommon::CompilePostShader(const ShaderInfo *shaderInfo, Draw::P
 		{ "u_timeDelta", 4, 4, UniformType::FLOAT4, offsetof(PostShaderUniforms, timeDelta) },
 		{ "u_setting", 5, 5, UniformType::FLOAT4, offsetof(PostShaderUniforms, setting) },
 		{ "u_video", 6, 6, UniformType::FLOAT1, offsetof(PostShaderUniforms, video) },
+		{ "u_setting1", 7, 7, UniformType::FLOAT4, offsetof(PostShaderUniforms, fusedSetting) },
+		{ "u_setting2", 8, 8, UniformType::FLOAT4, offsetof(PostShaderUniforms, fusedSetting) + 16 },
+		{ "u_setting3", 9, 9, UniformType::FLOAT4, offsetof(PostShaderUniforms, fusedSetting) + 32 },
 	} };
 
 	Draw::Pipeline *pipeline = CreatePipeline({ vs, fs }, true, &postShaderDesc);
@@ -338,8 +549,8 @@ bool PresentationCommon::CompilePostShader(const ShaderInfo *shaderInfo, Draw::P
 	return true;
 }
 
-bool PresentationCommon::BuildPostShader(const ShaderInfo * shaderInfo, const ShaderInfo * next, Draw::Pipeline **outPipeline) {
-	if (!CompilePostShader(shaderInfo, outPipeline)) {
+bool PresentationCommon::BuildPostShader(const ShaderInfo * shaderInfo, const ShaderInfo * next, Draw::Pipeline **outPipeline, const std::string *fragmentSource) {
+	if (!CompilePostShader(shaderInfo, outPipeline, fragmentSource)) {
 		return false;
 	}
 
@@ -541,6 +752,7 @@ void PresentationCommon::DestroyPostShader() {
 	DoReleaseVector(postShaderFramebuffers_);
 	DoReleaseVector(previousFramebuffers_);
 	postShaderInfo_.clear();
+	postShaderFused_.clear();
 	postShaderFBOUsage_.clear();
 }
 
@@ -721,7 +933,8 @@ void PresentationCommon::CopyToOutput(OutputFlags flags, int uvRotation, float u
 	Draw::Framebuffer *previousFramebuffer = previousFramebuffers_.empty() ? nullptr : previousFramebuffers_[previousIndex_];
 
 	PostShaderUniforms uniforms;
-	const auto performShaderPass = [&](const ShaderInfo *shaderInfo, Draw::Framebuffer *postShaderFramebuffer, Draw::Pipeline *postShaderPipeline) {
+	const auto performShaderPass = [&](size_t index, Draw::Framebuffer *postShaderFramebuffer) {
+		const ShaderInfo *shaderInfo = &postShaderInfo_[index];
 		if (postShaderOutput) {
 			draw_->BindFramebufferAsTexture(postShaderOutput, 0, Draw::FB_COLOR_BIT, 0);
 		} else {
@@ -737,9 +950,9 @@ void PresentationCommon::CopyToOutput(OutputFlags flags, int uvRotation, float u
 		draw_->SetViewport(viewport);
 		draw_->SetScissorRect(0, 0, nextWidth, nextHeight);
 
-		CalculatePostShaderUniforms(lastWidth, lastHeight, nextWidth, nextHeight, shaderInfo, &uniforms);
+		CalculatePostShaderUniforms(lastWidth, lastHeight, nextWidth, nextHeight, shaderInfo, &uniforms, &postShaderFused_[index]);
 
-		draw_->BindPipeline(postShaderPipeline);
+		draw_->BindPipeline(postShaderPipelines_[index]);
 		draw_->UpdateDynamicUniformBuffer(&uniforms, sizeof(uniforms));
 
 		Draw::SamplerState *sampler = useNearest || shaderInfo->isUpscalingFilter ? samplerNearest_ : samplerLinear_;
@@ -769,8 +982,6 @@ void PresentationCommon::CopyToOutput(OutputFlags flags, int uvRotation, float u
 		draw_->UpdateBuffer(vdata_, (const uint8_t *)verts, 0, sizeof(verts), Draw::UPDATE_DISCARD);
 
 		for (size_t i = 0; i < postShaderFramebuffers_.size(); ++i) {
-			Draw::Pipeline *postShaderPipeline = postShaderPipelines_[i];
-			const ShaderInfo *shaderInfo = &postShaderInfo_[i];
 			Draw::Framebuffer *postShaderFramebuffer = postShaderFramebuffers_[i];
 			if (!isFinalAtOutputResolution && i == postShaderFramebuffers_.size() - 1 && !previousFramebuffers_.empty()) {
 				// This is the last pass and we're going direct to the backbuffer after this.
@@ -782,7 +993,7 @@ void PresentationCommon::CopyToOutput(OutputFlags flags, int uvRotation, float u
 			}
 
 			draw_->BindFramebufferAsRenderTarget(postShaderFramebuffer, { Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE }, "PostShader");
-			performShaderPass(shaderInfo, postShaderFramebuffer, postShaderPipeline);
+			performShaderPass(i, postShaderFramebuffer);
 		}
 
 		if (isFinalAtOutputResolution && postShaderInfo_.back().isUpscalingFilter)
@@ -793,9 +1004,6 @@ void PresentationCommon::CopyToOutput(OutputFlags flags, int uvRotation, float u
 
 	// If we need to save the previous frame, we have to save any final pass in a framebuffer.
 	if (isFinalAtOutputResolution && !previousFramebuffers_.empty()) {
-		Draw::Pipeline *postShaderPipeline = postShaderPipelines_.back();
-		const ShaderInfo *shaderInfo = &postShaderInfo_.back();
-
 		// Pick the next to render to.
 		previousIndex_++;
 		if (previousIndex_ >= (int)previousFramebuffers_.size())
@@ -803,7 +1011,7 @@ void PresentationCommon::CopyToOutput(OutputFlags flags, int uvRotation, float u
 		Draw::Framebuffer *postShaderFramebuffer = previousFramebuffers_[previousIndex_];
 
 		draw_->BindFramebufferAsRenderTarget(postShaderFramebuffer, { Draw::RPAction::CLEAR, Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE }, "InterFrameBlit");
-		performShaderPass(shaderInfo, postShaderFramebuffer, postShaderPipeline);
+		performShaderPass(postShaderPipelines_.size() - 1, postShaderFramebuffer);
 	}
 
 	draw_->BindFramebufferAsRenderTarget(nullptr, { Draw::RPAction::CLEAR, Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE }, "FinalBlit");
@@ -833,7 +1041,7 @@ void PresentationCommon::CopyToOutput(OutputFlags flags, int uvRotation, float u
 	BindSource(1, false);
 
 	if (isFinalAtOutputResolution && previousFramebuffers_.empty()) {
-		CalculatePostShaderUniforms(lastWidth, lastHeight, (int)rc.w, (int)rc.h, &postShaderInfo_.back(), &uniforms);
+		CalculatePostShaderUniforms(lastWidth, lastHeight, (int)rc.w, (int)rc.h, &postShaderInfo_.back(), &uniforms, &postShaderFused_.back());
 		draw_->UpdateDynamicUniformBuffer(&uniforms, sizeof(uniforms));
 	} else if (useStereo) {
 		CalculatePostShaderUniforms(lastWidth, lastHeight, (int)rc.w, (int)rc.h, stereoShaderInfo_, &uniforms);
@@ -37,8 +37,13 @@ struct PostShaderUniforms {
 	float video; float pad[3];
 	// Used on Direct3D9.
 	float gl_HalfPixel[4];
+	// u_setting of the shaders merged into this pass, see MAX_FUSED_POST_SHADERS.
+	float fusedSetting[3][4];
 };
 
+// Shaders marked PerPixel are merged into the pass before them, up to this many in one pass.
+enum { MAX_FUSED_POST_SHADERS = 4 };
+
 // Could use UI::Bounds but don't want to depend on that here.
 struct FRect {
 	float x;
@@ -117,14 +122,14 @@ class PresentationCommon {
 
 	Draw::ShaderModule *CompileShaderModule(ShaderStage stage, ShaderLanguage lang, const std::string &src, std::string *errorString) const;
 	Draw::Pipeline *CreatePipeline(std::vector<Draw::ShaderModule *> shaders, bool postShader, const UniformBufferDesc *uniformDesc) const;
-	bool CompilePostShader(const ShaderInfo *shaderInfo, Draw::Pipeline **outPipeline) const;
-	bool BuildPostShader(const ShaderInfo *shaderInfo, const ShaderInfo *next, Draw::Pipeline **outPipeline);
+	bool CompilePostShader(const ShaderInfo *shaderInfo, Draw::Pipeline **outPipeline, const std::string *fragmentSource = nullptr) const;
+	bool BuildPostShader(const ShaderInfo *shaderInfo, const ShaderInfo *next, Draw::Pipeline **outPipeline, const std::string *fragmentSource = nullptr);
 	bool AllocateFramebuffer(int w, int h);
 
 	bool BindSource(int binding, bool bindStereo);
 
 	void GetCardboardSettings(CardboardSettings *cardboardSettings) const;
-	void CalculatePostShaderUniforms(int bufferWidth, int bufferHeight, int targetWidth, int targetHeight, const ShaderInfo *shaderInfo, PostShaderUniforms *uniforms) const;
+	void CalculatePostShaderUniforms(int bufferWidth, int bufferHeight, int targetWidth, int targetHeight, const ShaderInfo *shaderInfo, PostShaderUniforms *uniforms, const std::vector<ShaderInfo> *fused = nullptr) const;
 
 	Draw::DrawContext *draw_;
 	Draw::Pipeline *texColor_ = nullptr;
@@ -137,6 +142,8 @@ class PresentationCommon {
 	std::vector<Draw::Pipeline *> postShaderPipelines_;
 	std::vector<Draw::Framebuffer *> postShaderFramebuffers_;
 	std::vector<ShaderInfo> postShaderInfo_;
+	// Shaders merged into each pass after the one in postShaderInfo_, usually empty.
+	std::vector<std::vector<ShaderInfo>> postShaderFused_;
 	std::vector<Draw::Framebuffer *> previousFramebuffers_;
 	
 	Draw::Pipeline *stereoPipeline_ = nullptr;
@@ -92,13 +92,14 @@ enum : uint64_t {
 	DIRTY_MIPBIAS = 1ULL << 37,
 	DIRTY_LIGHT_CONTROL = 1ULL << 38,
 	DIRTY_TEX_ALPHA_MUL = 1ULL << 39,
+	DIRTY_FRAGMENT_UBER_CONTROL = 1ULL << 40,
 
-	// Bits 40-43 are free for new uniforms. Then we're really out and need to start merging.
+	// Bits 41-43 are free for new uniforms. Then we're really out and need to start merging.
 	// Don't forget to update DIRTY_ALL_UNIFORMS when you start using them.
 
 	DIRTY_BONE_UNIFORMS = 0xFF000000ULL,
 
-	DIRTY_ALL_UNIFORMS = 0x0FFFFFFFFFFULL,
+	DIRTY_ALL_UNIFORMS = 0x1FFFFFFFFFFULL,
 
 	// Other dirty elements that aren't uniforms
 	DIRTY_FRAMEBUF = 1ULL << 44,
@@ -116,9 +117,13 @@ enum : uint64_t {
 
 	// Note that the top 8 bits (54-63) cannot be dirtied through the commonCommandTable due to packing of other flags.
 
+	// Only the vertex format changed, so only that part of the vertex shader ID needs recomputing.
+	DIRTY_VERTEXSHADER_VTYPE = 1ULL << 54,
+	DIRTY_ANY_VERTEXSHADER = DIRTY_VERTEXSHADER_STATE | DIRTY_VERTEXSHADER_VTYPE,
+
 	// Everything that's not uniforms. Use this after using thin3d.
 	// TODO: Should we also add DIRTY_FRAMEBUF here? It kinda generally takes care of itself.
-	DIRTY_ALL_RENDER_STATE = DIRTY_BLEND_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_RASTER_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE | DIRTY_GEOMETRYSHADER_STATE | DIRTY_TEXTURE_IMAGE | DIRTY_TEXTURE_PARAMS,
+	DIRTY_ALL_RENDER_STATE = DIRTY_BLEND_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_RASTER_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_ANY_VERTEXSHADER | DIRTY_FRAGMENTSHADER_STATE | DIRTY_GEOMETRYSHADER_STATE | DIRTY_TEXTURE_IMAGE | DIRTY_TEXTURE_PARAMS,
 
 	DIRTY_ALL = 0xFFFFFFFFFFFFFFFF
 };
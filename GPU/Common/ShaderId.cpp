@@ -66,13 +66,58 @@ std::string VertexShaderDesc(const VShaderID &id) {
 	return desc.str();
 }
 
-void ComputeVertexShaderID(VShaderID *id_out, VertexDecoder *vertexDecoder, bool useHWTransform, bool useHWTessellation, bool weightsAsFloat, bool useSkinInDecode) {
+void ComputeVertexShaderStateID(VShaderID *id_out) {
+	// Everything here only depends on GE state, not the vertex format. Bits that only apply with
+	// hardware transform or outside through mode are set unconditionally, and masked off later.
+	bool doTexture = gstate.isTextureMapEnabled() && !gstate.isModeClear();
+	bool doShadeMapping = doTexture && (gstate.getUVGenMode() == GE_TEXMAP_ENVIRONMENT_MAP);
+
+	VShaderID id;
+	if (doTexture) {
+		// UV generation mode. doShadeMapping is implicitly stored here.
+		id.SetBits(VS_BIT_UVGEN_MODE, 2, gstate.getUVGenMode());
+	}
+
+	// The next bits are used differently depending on UVgen mode
+	if (gstate.getUVGenMode() == GE_TEXMAP_TEXTURE_MATRIX) {
+		id.SetBits(VS_BIT_UVPROJ_MODE, 2, gstate.getUVProjMode());
+	} else if (doShadeMapping) {
+		id.SetBits(VS_BIT_LS0, 2, gstate.getUVLS0());
+		id.SetBits(VS_BIT_LS1, 2, gstate.getUVLS1());
+	}
+
+	if (gstate.isLightingEnabled()) {
+		// doShadeMapping is stored as UVGenMode, and light type doesn't matter for shade mapping.
+		id.SetBit(VS_BIT_LIGHTING_ENABLE);
+		if (gstate_c.Use(GPU_USE_LIGHT_UBERSHADER)) {
+			id.SetBit(VS_BIT_LIGHT_UBERSHADER);
+		} else {
+			id.SetBits(VS_BIT_MATERIAL_UPDATE, 3, gstate.getMaterialUpdate());
+			// Light bits
+			for (int i = 0; i < 4; i++) {
+				bool chanEnabled = gstate.isLightChanEnabled(i) != 0;
+				id.SetBit(VS_BIT_LIGHT0_ENABLE + i, chanEnabled);
+				if (chanEnabled) {
+					id.SetBits(VS_BIT_LIGHT0_COMP + 4 * i, 2, gstate.getLightComputation(i));
+					id.SetBits(VS_BIT_LIGHT0_TYPE + 4 * i, 2, gstate.getLightType(i));
+				}
+			}
+		}
+	}
+
+	id.SetBit(VS_BIT_NORM_REVERSE, gstate.areNormalsReversed());
+	id.SetBit(VS_BIT_NORM_REVERSE_TESS, gstate.isPatchNormalsReversed());
+
+	id.SetBit(VS_BIT_LMODE, gstate.isUsingSecondaryColor() && gstate.isLightingEnabled() && !gstate.isModeClear());
+	id.SetBit(VS_BIT_FLATSHADE, gstate.getShadeMode() == GE_SHADE_FLAT && !gstate.isModeClear());
+
+	*id_out = id;
+}
+
+void ComputeVertexShaderID(VShaderID *id_out, const VShaderID &stateID, VertexDecoder *vertexDecoder, bool useHWTransform, bool useHWTessellation, bool weightsAsFloat, bool useSkinInDecode) {
 	u32 vertType = vertexDecoder->VertexType();
 
 	bool isModeThrough = (vertType & GE_VTYPE_THROUGH) != 0;
-	bool doTexture = gstate.isTextureMapEnabled() && !gstate.isModeClear();
-	bool doShadeMapping = doTexture && (gstate.getUVGenMode() == GE_TEXMAP_ENVIRONMENT_MAP);
-	bool doFlatShading = gstate.getShadeMode() == GE_SHADE_FLAT && !gstate.isModeClear();
 
 	bool vtypeHasColor = (vertType & GE_VTYPE_COL_MASK) != 0;
 	bool vtypeHasNormal = (vertType & GE_VTYPE_NRM_MASK) != 0;
@@ -85,7 +130,7 @@ void ComputeVertexShaderID(VShaderID *id_out, VertexDecoder *vertexDecoder, bool
 		_assert_(vtypeHasNormal);
 	}
 
-	bool lmode = gstate.isUsingSecondaryColor() && gstate.isLightingEnabled() && !isModeThrough && !gstate.isModeClear();
+	bool lmode = stateID.Bit(VS_BIT_LMODE) && !isModeThrough;
 	bool vertexRangeCulling = gstate_c.Use(GPU_USE_VS_RANGE_CULLING) &&
 		!isModeThrough && gstate_c.submitType == SubmitType::DRAW;  // neither hw nor sw spline/bezier. See #11692
 
@@ -98,25 +143,17 @@ void ComputeVertexShaderID(VShaderID *id_out, VertexDecoder *vertexDecoder, bool
 		id.SetBit(VS_BIT_SIMPLE_STEREO);
 	}
 
-	if (doTexture) {
-		// UV generation mode. doShadeMapping is implicitly stored here.
-		id.SetBits(VS_BIT_UVGEN_MODE, 2, gstate.getUVGenMode());
-	}
+	id.SetBits(VS_BIT_UVGEN_MODE, 2, stateID.Bits(VS_BIT_UVGEN_MODE, 2));
 
 	if (useHWTransform) {
 		id.SetBit(VS_BIT_USE_HW_TRANSFORM);
 		id.SetBit(VS_BIT_HAS_NORMAL, vtypeHasNormal);
 
-		// The next bits are used differently depending on UVgen mode
-		if (gstate.getUVGenMode() == GE_TEXMAP_TEXTURE_MATRIX) {
-			id.SetBits(VS_BIT_UVPROJ_MODE, 2, gstate.getUVProjMode());
-		} else if (doShadeMapping) {
-			id.SetBits(VS_BIT_LS0, 2, gstate.getUVLS0());
-			id.SetBits(VS_BIT_LS1, 2, gstate.getUVLS1());
-		}
+		// Covers UVPROJ_MODE too, which overlaps LS0.
+		id.SetBits(VS_BIT_LS0, 2, stateID.Bits(VS_BIT_LS0, 2));
+		id.SetBits(VS_BIT_LS1, 2, stateID.Bits(VS_BIT_LS1, 2));
 
 		// Bones.
-		u32 vertType = vertexDecoder->VertexType();
 		bool enableBones = !useSkinInDecode && vertTypeIsSkinningEnabled(vertType);
 		id.SetBit(VS_BIT_ENABLE_BONES, enableBones);
 		if (enableBones) {
@@ -126,27 +163,20 @@ void ComputeVertexShaderID(VShaderID *id_out, VertexDecoder *vertexDecoder, bool
 			id.SetBits(VS_BIT_WEIGHT_FMTSCALE, 2, weightsAsFloat ? 0 : (vertType & GE_VTYPE_WEIGHT_MASK) >> GE_VTYPE_WEIGHT_SHIFT);
 		}
 
-		if (gstate.isLightingEnabled()) {
-			// doShadeMapping is stored as UVGenMode, and light type doesn't matter for shade mapping.
+		if (stateID.Bit(VS_BIT_LIGHTING_ENABLE)) {
 			id.SetBit(VS_BIT_LIGHTING_ENABLE);
-			if (gstate_c.Use(GPU_USE_LIGHT_UBERSHADER)) {
+			if (stateID.Bit(VS_BIT_LIGHT_UBERSHADER)) {
 				lmode = false;  // handled dynamically.
 				id.SetBit(VS_BIT_LIGHT_UBERSHADER);
 			} else {
-				id.SetBits(VS_BIT_MATERIAL_UPDATE, 3, gstate.getMaterialUpdate());
-				// Light bits
-				for (int i = 0; i < 4; i++) {
-					bool chanEnabled = gstate.isLightChanEnabled(i) != 0;
-					id.SetBit(VS_BIT_LIGHT0_ENABLE + i, chanEnabled);
-					if (chanEnabled) {
-						id.SetBits(VS_BIT_LIGHT0_COMP + 4 * i, 2, gstate.getLightComputation(i));
-						id.SetBits(VS_BIT_LIGHT0_TYPE + 4 * i, 2, gstate.getLightType(i));
-					}
-				}
+				id.SetBits(VS_BIT_MATERIAL_UPDATE, 3, stateID.Bits(VS_BIT_MATERIAL_UPDATE, 3));
+				// Light enables, then the comp and type bits for all four lights.
+				id.SetBits(VS_BIT_LIGHT0_ENABLE, 4, stateID.Bits(VS_BIT_LIGHT0_ENABLE, 4));
+				id.SetBits(VS_BIT_LIGHT0_COMP, 16, stateID.Bits(VS_BIT_LIGHT0_COMP, 16));
 			}
 		}
 
-		id.SetBit(VS_BIT_NORM_REVERSE, gstate.areNormalsReversed());
+		id.SetBit(VS_BIT_NORM_REVERSE, stateID.Bit(VS_BIT_NORM_REVERSE));
 		id.SetBit(VS_BIT_HAS_TEXCOORD, vtypeHasTexcoord);
 
 		if (useHWTessellation) {
@@ -158,12 +188,12 @@ void ComputeVertexShaderID(VShaderID *id_out, VertexDecoder *vertexDecoder, bool
 				id.SetBit(VS_BIT_HAS_TEXCOORD_TESS, (gstate.vertType & GE_VTYPE_TC_MASK) != 0);
 				id.SetBit(VS_BIT_HAS_NORMAL_TESS, (gstate.vertType & GE_VTYPE_NRM_MASK) != 0 || gstate.isLightingEnabled());
 			}
-			id.SetBit(VS_BIT_NORM_REVERSE_TESS, gstate.isPatchNormalsReversed());
+			id.SetBit(VS_BIT_NORM_REVERSE_TESS, stateID.Bit(VS_BIT_NORM_REVERSE_TESS));
 		}
 	}
 
 	id.SetBit(VS_BIT_LMODE, lmode);
-	id.SetBit(VS_BIT_FLATSHADE, doFlatShading);
+	id.SetBit(VS_BIT_FLATSHADE, stateID.Bit(VS_BIT_FLATSHADE));
 
 	// These two bits cannot be combined, otherwise havoc occurs. We get reports that indicate this happened somehow... "ERROR: 0:14: 'u_proj' : undeclared identifier"
 	_dbg_assert_msg_(!id.Bit(VS_BIT_USE_HW_TRANSFORM) || !id.Bit(VS_BIT_IS_THROUGH), "Can't have both THROUGH and USE_HW_TRANSFORM together!");
@@ -171,6 +201,22 @@ void ComputeVertexShaderID(VShaderID *id_out, VertexDecoder *vertexDecoder, bool
 	*id_out = id;
 }
 
+void ComputeVertexShaderID(VShaderID *id_out, VertexDecoder *vertexDecoder, bool useHWTransform, bool useHWTessellation, bool weightsAsFloat, bool useSkinInDecode) {
+	VShaderID stateID;
+	ComputeVertexShaderStateID(&stateID);
+	ComputeVertexShaderID(id_out, stateID, vertexDecoder, useHWTransform, useHWTessellation, weightsAsFloat, useSkinInDecode);
+}
+
+void UpdateVertexShaderID(VShaderID *id, VShaderID *stateID, VertexDecoder *vertexDecoder, bool useHWTransform, bool useHWTessellation, bool weightsAsFloat, bool useSkinInDecode) {
+	if (gstate_c.IsDirty(DIRTY_VERTEXSHADER_STATE)) {
+		ComputeVertexShaderStateID(stateID);
+	} else if (!gstate_c.IsDirty(DIRTY_VERTEXSHADER_VTYPE)) {
+		return;
+	}
+	gstate_c.Clean(DIRTY_VERTEXSHADER_STATE | DIRTY_VERTEXSHADER_VTYPE);
+	ComputeVertexShaderID(id, *stateID, vertexDecoder, useHWTransform, useHWTessellation, weightsAsFloat, useSkinInDecode);
+}
+
 
 static const char * const alphaTestFuncs[] = { "NEVER", "ALWAYS", "==", "!=", "<", "<=", ">", ">=" };
 static const char * const logicFuncs[] = {
@@ -187,6 +233,7 @@ std::string FragmentShaderDesc(const FShaderID &id) {
 	std::stringstream desc;
 	desc << StringFromFormat("%08x:%08x ", id.d[1], id.d[0]);
 	if (id.Bit(FS_BIT_CLEARMODE)) desc << "Clear ";
+	if (id.Bit(FS_BIT_UBERSHADER)) desc << "Uber ";
 	if (id.Bit(FS_BIT_DO_TEXTURE)) desc << (id.Bit(FS_BIT_3D_TEXTURE) ? "Tex3D " : "Tex ");
 	if (id.Bit(FS_BIT_DO_TEXTURE_PROJ)) desc << "TexProj ";
 	if (id.Bit(FS_BIT_FLATSHADE)) desc << "Flat ";
@@ -240,7 +287,7 @@ std::string FragmentShaderDesc(const FShaderID &id) {
 	} else if (id.Bit(FS_BIT_REPLACE_ALPHA_WITH_STENCIL_TYPE)) {
 		desc << "StenOff ";
 	}
-	if (id.Bit(FS_BIT_DO_TEXTURE)) {
+	if (id.Bit(FS_BIT_DO_TEXTURE) && !id.Bit(FS_BIT_UBERSHADER)) {
 		switch (id.Bits(FS_BIT_TEXFUNC, 3)) {
 		case GE_TEXFUNC_ADD: desc << "TFuncAdd "; break;
 		case GE_TEXFUNC_BLEND: desc << "TFuncBlend "; break;
@@ -252,8 +299,10 @@ std::string FragmentShaderDesc(const FShaderID &id) {
 	}
 
 	if (id.Bit(FS_BIT_ALPHA_AGAINST_ZERO)) desc << "AlphaTest0 " << alphaTestFuncs[id.Bits(FS_BIT_ALPHA_TEST_FUNC, 3)] << " ";
+	else if (id.Bit(FS_BIT_ALPHA_TEST) && id.Bit(FS_BIT_UBERSHADER)) desc << "AlphaTest ";
 	else if (id.Bit(FS_BIT_ALPHA_TEST)) desc << "AlphaTest " << alphaTestFuncs[id.Bits(FS_BIT_ALPHA_TEST_FUNC, 3)] << " ";
 	if (id.Bit(FS_BIT_COLOR_AGAINST_ZERO)) desc << "ColorTest0 " << alphaTestFuncs[id.Bits(FS_BIT_COLOR_TEST_FUNC, 2)] << " ";  // first 4 match;
+	else if (id.Bit(FS_BIT_COLOR_TEST) && id.Bit(FS_BIT_UBERSHADER)) desc << "ColorTest ";
 	else if (id.Bit(FS_BIT_COLOR_TEST)) desc << "ColorTest " << alphaTestFuncs[id.Bits(FS_BIT_COLOR_TEST_FUNC, 2)] << " ";  // first 4 match
 	if (id.Bit(FS_BIT_TEST_DISCARD_TO_ZERO)) desc << "TestDiscardToZero ";
 	if (id.Bit(FS_BIT_NO_DEPTH_CANNOT_DISCARD_STENCIL)) desc << "StencilDiscardWorkaround ";
@@ -385,6 +434,24 @@ void ComputeFragmentShaderID(FShaderID *id_out, const ComputedPipelineState &pip
 	*id_out = id;
 }
 
+bool ComputeFragmentUberShaderID(FShaderID *id_out, const FShaderID &id) {
+	bool hasTests = id.Bit(FS_BIT_ALPHA_TEST) || id.Bit(FS_BIT_COLOR_TEST);
+	if (id.Bit(FS_BIT_CLEARMODE) || id.Bit(FS_BIT_UBERSHADER) || (!id.Bit(FS_BIT_DO_TEXTURE) && !hasTests))
+		return false;
+
+	// Only which tests are enabled stays baked in, so we don't add discards to shaders that had none.
+	// The against-zero variants are covered by the general comparisons.
+	FShaderID uber = id;
+	uber.SetBits(FS_BIT_TEXFUNC, 3, 0);
+	uber.SetBits(FS_BIT_ALPHA_TEST_FUNC, 3, 0);
+	uber.SetBit(FS_BIT_ALPHA_AGAINST_ZERO, false);
+	uber.SetBits(FS_BIT_COLOR_TEST_FUNC, 2, 0);
+	uber.SetBit(FS_BIT_COLOR_AGAINST_ZERO, false);
+	uber.SetBit(FS_BIT_UBERSHADER);
+	*id_out = uber;
+	return true;
+}
+
 std::string GeometryShaderDesc(const GShaderID &id) {
 	std::stringstream desc;
 	desc << StringFromFormat("%08x:%08x ", id.d[1], id.d[0]);
@@ -68,7 +68,7 @@ enum FShaderBit : uint8_t {
 	FS_BIT_CLEARMODE = 0,
 	FS_BIT_DO_TEXTURE = 1,
 	FS_BIT_TEXFUNC = 2,  // 3 bits
-	// 1 bit free at position 5
+	FS_BIT_UBERSHADER = 5,  // Texfunc and test funcs come from u_fragmentUberControl instead.
 	FS_BIT_3D_TEXTURE = 6,
 	FS_BIT_SHADER_TEX_CLAMP = 7,
 	FS_BIT_CLAMP_S = 8,
@@ -279,6 +279,12 @@ class Bugs;
 class VertexDecoder;
 
 void ComputeVertexShaderID(VShaderID *id, VertexDecoder *vertexDecoder, bool useHWTransform, bool useHWTessellation, bool weightsAsFloat, bool useSkinInDecode);
+// The part of the vertex shader ID that only depends on GE state, independent of the vertex format.
+void ComputeVertexShaderStateID(VShaderID *id);
+void ComputeVertexShaderID(VShaderID *id, const VShaderID &stateID, VertexDecoder *vertexDecoder, bool useHWTransform, bool useHWTessellation, bool weightsAsFloat, bool useSkinInDecode);
+// Updates id (and the cached stateID) according to the vertex shader dirty flags, and cleans them.
+// If only the vertex format changed, the GE state part is reused. Leaves id alone if nothing is dirty.
+void UpdateVertexShaderID(VShaderID *id, VShaderID *stateID, VertexDecoder *vertexDecoder, bool useHWTransform, bool useHWTessellation, bool weightsAsFloat, bool useSkinInDecode);
 // Generates a compact string that describes the shader. Useful in a list to get an overview
 // of the current flora of shaders.
 std::string VertexShaderDesc(const VShaderID &id);
@@ -286,6 +292,8 @@ std::string VertexShaderDesc(const VShaderID &id);
 struct ComputedPipelineState;
 void ComputeFragmentShaderID(FShaderID *id, const ComputedPipelineState &pipelineState, const Draw::Bugs &bugs);
 std::string FragmentShaderDesc(const FShaderID &id);
+// The more generic shader that can stand in for id while it's compiling. Returns false if there's none.
+bool ComputeFragmentUberShaderID(FShaderID *id_out, const FShaderID &id);
 
 void ComputeGeometryShaderID(GShaderID *id, const Draw::Bugs &bugs, int prim);
 std::string GeometryShaderDesc(const GShaderID &id);
@@ -207,6 +207,10 @@ void BaseUpdateUniforms(UB_VS_FS_Base *ub, uint64_t dirtyUniforms, bool flipView
 		ub->texMul = gstate.isColorDoublingEnabled() ? 2.0f : 1.0f;
 	}
 
+	if (dirtyUniforms & DIRTY_FRAGMENT_UBER_CONTROL) {
+		ub->fragmentUberControl = PackFragmentUberControlBits();
+	}
+
 	if (dirtyUniforms & DIRTY_STENCILREPLACEVALUE) {
 		ub->stencilReplaceValue = (float)gstate.getStencilTestRef() * (1.0 / 255.0);
 	}
@@ -310,6 +314,16 @@ uint32_t PackLightControlBits() {
 	return lightControl;
 }
 
+// For the fragment ubershader, which only bakes in which tests are enabled.
+uint32_t PackFragmentUberControlBits() {
+	// Bottom 3 bits are the texture function, then 3 bits of alpha test func
+	// and 2 bits of color test func.
+	uint32_t control = (u32)gstate.getTextureFunction();
+	control |= (u32)gstate.getAlphaTestFunction() << 3;
+	control |= (u32)gstate.getColorTestFunction() << 6;
+	return control;
+}
+
 void LightUpdateUniforms(UB_VS_Lights *ub, uint64_t dirtyUniforms) {
 	// Lighting
 	if (dirtyUniforms & DIRTY_AMBIENT) {
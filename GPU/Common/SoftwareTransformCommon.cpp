@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <cmath>
 #include "Common/CPUDetect.h"
+#include "Common/Data/Collections/LinearArena.h"
 #include "Common/Math/math_util.h"
 #include "Common/GPU/OpenGL/GLFeatures.h"
 
@@ -168,6 +169,62 @@ void SoftwareTransform::SetProjMatrix(const float mtx[14], bool invertedX, bool
 	projMatrix_.translateAndScale(trans, scale);
 }
 
+void SoftwareTransform::DecodeThroughSimple(const DecVtxFormat &decVtxFormat, int maxIndex, float uscale, float vscale) {
+	const u8 *decoded = params_.decoded;
+	TransformedVertex *transformed = params_.transformed;
+	const int stride = decVtxFormat.stride;
+	const u8 *posPtr = decoded + decVtxFormat.posoff;
+	const u8 *uvPtr = decVtxFormat.uvfmt != 0 ? decoded + decVtxFormat.uvoff : nullptr;
+	const u8 *c0Ptr = decVtxFormat.c0fmt != 0 ? decoded + decVtxFormat.c0off : nullptr;
+	const u32 materialAmbientRGBA = gstate.getMaterialAmbientRGBA();
+	if (!uvPtr) {
+		// The UVs are just zero, avoid 0 * inf if there's no texture size.
+		uscale = 1.0f;
+		vscale = 1.0f;
+	}
+
+	// Same as VertexReader::ReadPos() in through mode, Z is an integer passed in a float.
+	const float zscale = 1.0f / 65535.0f;
+#if defined(_M_SSE)
+	const __m128 uvScale = _mm_setr_ps(uscale, vscale, 1.0f, 1.0f);
+#elif PPSSPP_ARCH(ARM_NEON)
+	const float uvScaleArray[4] = { uscale, vscale, 1.0f, 1.0f };
+	const float32x4_t uvScale = vld1q_f32(uvScaleArray);
+#endif
+
+	for (int index = 0; index < maxIndex; index++) {
+		const float *f = (const float *)(posPtr + index * stride);
+		TransformedVertex &vert = transformed[index];
+		float uv[2] = { 0.0f, 0.0f };
+		if (uvPtr)
+			memcpy(uv, uvPtr + index * stride, sizeof(uv));
+
+		// Writes pos + pos_w, then u, v, uv_w and fog (always 1 in through mode) in two stores.
+#if defined(_M_SSE)
+		_mm_storeu_ps(vert.pos, _mm_setr_ps(f[0], f[1], (int)f[2] * zscale, 1.0f));
+		_mm_storeu_ps(vert.uv, _mm_mul_ps(_mm_setr_ps(uv[0], uv[1], 1.0f, 1.0f), uvScale));
+#elif PPSSPP_ARCH(ARM_NEON)
+		const float posArray[4] = { f[0], f[1], (int)f[2] * zscale, 1.0f };
+		const float uvArray[4] = { uv[0], uv[1], 1.0f, 1.0f };
+		vst1q_f32(vert.pos, vld1q_f32(posArray));
+		vst1q_f32(vert.uv, vmulq_f32(vld1q_f32(uvArray), uvScale));
+#else
+		vert.x = f[0];
+		vert.y = f[1];
+		vert.z = (int)f[2] * zscale;
+		vert.pos_w = 1.0f;
+		vert.u = uv[0] * uscale;
+		vert.v = uv[1] * vscale;
+		vert.uv_w = 1.0f;
+		vert.fog = 1.0f;
+#endif
+		if (c0Ptr)
+			memcpy(&vert.color0_32, c0Ptr + index * stride, 4);
+		else
+			vert.color0_32 = materialAmbientRGBA;
+	}
+}
+
 void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVtxFormat, int maxIndex, SoftwareTransformResult *result) {
 	u8 *decoded = params_.decoded;
 	TransformedVertex *transformed = params_.transformed;
@@ -204,7 +261,13 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 	}
 
 	VertexReader reader(decoded, decVtxFormat, vertType);
-	if (throughmode) {
+	// The decoder always produces these for through mode sprites, so they can skip the reader.
+	bool simpleThrough = throughmode && provokeIndOffset == 0 && decVtxFormat.posfmt == DEC_FLOAT_3;
+	simpleThrough = simpleThrough && (decVtxFormat.uvfmt == 0 || decVtxFormat.uvfmt == DEC_FLOAT_2);
+	simpleThrough = simpleThrough && (decVtxFormat.c0fmt == 0 || decVtxFormat.c0fmt == DEC_U8_4);
+	if (simpleThrough) {
+		DecodeThroughSimple(decVtxFormat, maxIndex, uscale, vscale);
+	} else if (throughmode) {
 		const u32 materialAmbientRGBA = gstate.getMaterialAmbientRGBA();
 		const bool hasColor = reader.hasColor0();
 		const bool hasUV = reader.hasUV();
@@ -246,11 +309,16 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 	} else {
 		const Vec4f materialAmbientRGBA = Vec4f::FromRGBA(gstate.getMaterialAmbientRGBA());
 		bool fogEnabled = gstate.isFogEnabled();
+		// Go straight from world to clip space, like the software renderer.  Fog only needs view Z.
+		float view[16];
+		float viewproj[16];
+		ConvertMatrix4x3To4x4(view, gstate.viewMatrix);
+		Matrix4ByMatrix4(viewproj, view, projMatrix_.m);
+		const float *viewZ = &gstate.viewMatrix[2];
 		// Okay, need to actually perform the full transform.
 		for (int index = 0; index < maxIndex; index++) {
 			reader.Goto(index);
 
-			float v[3] = {0, 0, 0};
 			Vec4f c0 = Vec4f(1, 1, 1, 1);
 			Vec4f c1 = Vec4f(0, 0, 0, 0);
 			float uv[3] = {0, 0, 1};
@@ -413,12 +481,14 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 			uv[0] = uv[0] * widthFactor;
 			uv[1] = uv[1] * heightFactor;
 
-			// Transform the coord by the view matrix.
-			Vec3ByMatrix43(v, out, gstate.viewMatrix);
-
 			// TODO: Write to a flexible buffer, we don't always need all four components.
-			Vec3ByMatrix44(transformed[index].pos, v, projMatrix_.m);
-			transformed[index].fog = fogEnabled ? (v[2] + fog_end) * fog_slope : 1.0f;
+			Vec3ByMatrix44(transformed[index].pos, out, viewproj);
+			if (fogEnabled) {
+				float viewz = out[0] * viewZ[0] + out[1] * viewZ[3] + out[2] * viewZ[6] + viewZ[9];
+				transformed[index].fog = (viewz + fog_end) * fog_slope;
+			} else {
+				transformed[index].fog = 1.0f;
+			}
 			memcpy(&transformed[index].uv, uv, 3 * sizeof(float));
 			transformed[index].color0_32 = c0.ToRGBA();
 			transformed[index].color1_32 = c1.ToRGBA();
@@ -599,8 +669,7 @@ void SoftwareTransform::BuildDrawingParams(int prim, int vertexCount, u32 vertTy
 			float minZValue, maxZValue;
 			CalcCullParams(minZValue, maxZValue);
 
-			std::vector<int> outsideZ;
-			outsideZ.resize(vertexCount);
+			int *outsideZ = gpuFrameArena.AllocateArray<int>(vertexCount);
 
 			// First, check inside/outside directions for each index.
 			for (int i = 0; i < vertexCount; ++i) {
@@ -645,6 +714,7 @@ void SoftwareTransform::BuildDrawingParams(int prim, int vertexCount, u32 vertTy
 
 				inds = newInds;
 			}
+			gpuFrameArena.Free(outsideZ, sizeof(int) * vertexCount);
 		}
 	}
 
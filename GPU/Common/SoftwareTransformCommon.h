@@ -72,6 +72,7 @@ class SoftwareTransform {
 
 protected:
 	void CalcCullParams(float &minZValue, float &maxZValue);
+	void DecodeThroughSimple(const DecVtxFormat &decVtxFormat, int maxIndex, float uscale, float vscale);
 	void ExpandRectangles(int vertexCount, int &maxIndex, u16 *&inds, const TransformedVertex *transformed, TransformedVertex *transformedExpanded, int &numTrans, bool throughmode);
 	void ExpandLines(int vertexCount, int &maxIndex, u16 *&inds, const TransformedVertex *transformed, TransformedVertex *transformedExpanded, int &numTrans, bool throughmode);
 	void ExpandPoints(int vertexCount, int &maxIndex, u16 *&inds, const TransformedVertex *transformed, TransformedVertex *transformedExpanded, int &numTrans, bool throughmode);
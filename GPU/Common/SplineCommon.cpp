@@ -20,7 +20,9 @@
 
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
+#include "Common/Data/Collections/LinearArena.h"
 #include "Common/Profiler/Profiler.h"
+#include "ext/xxhash.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/DrawEngineCommon.h"
@@ -239,8 +241,8 @@ class Spline3DWeight {
 		Weight *weights = new Weight[tess * num_patches + 1];
 
 	//	float *knots = new float[num_patches + 5];
-		float *knots = new float[num_patches + 2]; // Optimized with KnotDiv, must use +5 in theory 
-		KnotDiv *divs = new KnotDiv[num_patches];
+		float *knots = gpuFrameArena.AllocateArray<float>(num_patches + 2); // Optimized with KnotDiv, must use +5 in theory 
+		KnotDiv *divs = gpuFrameArena.NewArray<KnotDiv>(num_patches);
 		CalcKnots(num_patches, type, knots, divs);
 
 		const float inv_tess = 1.0f / (float)tess;
@@ -253,8 +255,8 @@ class Spline3DWeight {
 			}
 		}
 
-		delete[] knots;
-		delete[] divs;
+		gpuFrameArena.Free(divs, sizeof(KnotDiv) * num_patches);
+		gpuFrameArena.Free(knots, sizeof(float) * (num_patches + 2));
 
 		return weights;
 	}
@@ -485,6 +487,78 @@ void DrawEngineCommon::ClearSplineBezierWeights() {
 	Spline3DWeight::weightsCache.Clear();
 }
 
+// Cached tessellations are dropped after this many frames without being drawn.
+enum { TESS_CACHE_KILL_AGE = 30 };
+// Beyond this, new curves are just not cached until old ones age out.
+static const size_t TESS_CACHE_MAX_BYTES = 8 * 1024 * 1024;
+
+struct TessellationCacheEntry {
+	// Empty until the same curve is drawn a second time, most animated curves never are.
+	std::vector<SimpleVertex> vertices;
+	std::vector<u16> indices;
+	int lastFrame;
+
+	size_t Bytes() const {
+		return vertices.size() * sizeof(SimpleVertex) + indices.size() * sizeof(u16);
+	}
+};
+
+void DrawEngineCommon::ClearTessellationCache() {
+	tessCache_.Iterate([&](uint64_t hash, TessellationCacheEntry *entry) {
+		delete entry;
+	});
+	tessCache_.Clear();
+	tessCacheBytes_ = 0;
+}
+
+void DrawEngineCommon::DecimateTessellationCache() {
+	if (tessCacheFrame_ == gpuStats.numFlips)
+		return;
+	tessCacheFrame_ = gpuStats.numFlips;
+
+	const int threshold = gpuStats.numFlips - TESS_CACHE_KILL_AGE;
+	tessCache_.Iterate([&](uint64_t hash, TessellationCacheEntry *entry) {
+		if (entry->lastFrame < threshold) {
+			tessCacheBytes_ -= entry->Bytes();
+			tessCache_.Remove(hash);
+			delete entry;
+		}
+	});
+}
+
+// Everything that affects the output of SoftwareTessellation(). The control points are already
+// normalized, so skinning, morph and UV scale are included in them.
+template<class Surface>
+static bool HashCurve(uint64_t *hash, const Surface &surface, u32 origVertType, const SimpleVertex *const *points, int num_points, SimpleBufferManager &managedBuf) {
+	SimpleVertex *gathered = (SimpleVertex *)managedBuf.Allocate(sizeof(SimpleVertex) * num_points);
+	if (!gathered)
+		return false;
+	for (int i = 0; i < num_points; ++i)
+		gathered[i] = *points[i];
+
+	struct {
+		int tess_u, tess_v;
+		int num_points_u, num_points_v;
+		int type_u, type_v;
+		int primType;
+		u32 vertType;
+		u32 flags;
+	} key{};
+	key.tess_u = surface.tess_u;
+	key.tess_v = surface.tess_v;
+	key.num_points_u = surface.num_points_u;
+	key.num_points_v = surface.num_points_v;
+	key.type_u = surface.type_u;
+	key.type_v = surface.type_v;
+	key.primType = (int)surface.primType;
+	key.vertType = origVertType;
+	key.flags = (surface.patchFacing ? 1 : 0) | (gstate.isLightingEnabled() ? 2 : 0);
+
+	uint64_t seed = XXH3_64bits(&key, sizeof(key));
+	*hash = XXH3_64bits_withSeed(gathered, sizeof(SimpleVertex) * num_points, seed);
+	return true;
+}
+
 // Specialize to make instance (to avoid link error).
 template void DrawEngineCommon::SubmitCurve<BezierSurface>(const void *control_points, const void *indices, BezierSurface &surface, u32 vertType, int *bytesRead, const char *scope);
 template void DrawEngineCommon::SubmitCurve<SplineSurface>(const void *control_points, const void *indices, SplineSurface &surface, u32 vertType, int *bytesRead, const char *scope);
@@ -524,6 +598,9 @@ void DrawEngineCommon::SubmitCurve(const void *control_points, const void *indic
 		return;
 	}
 
+	// Not all fields are written for every vertex type, clear them so the tessellation cache hash is stable.
+	memset(simplified_control_points, 0, sizeof(SimpleVertex) * (index_upper_bound + 1));
+
 	u32 origVertType = vertType;
 	vertType = NormalizeVertices((u8 *)simplified_control_points, temp_buffer, (u8 *)control_points, index_lower_bound, index_upper_bound, vertType);
 
@@ -553,11 +630,40 @@ void DrawEngineCommon::SubmitCurve(const void *control_points, const void *indic
 	if (CanUseHardwareTessellation(surface.primType)) {
 		HardwareTessellation(output, surface, origVertType, points, tessDataTransfer);
 	} else {
-		ControlPoints cpoints(points, num_points, managedBuf);
-		if (cpoints.IsValid())
-			SoftwareTessellation(output, surface, origVertType, cpoints);
-		else
-			ERROR_LOG(G3D, "Failed to allocate space for control point values, skipping curve draw");
+		DecimateTessellationCache();
+
+		uint64_t curveHash = 0;
+		bool hashed = HashCurve(&curveHash, surface, origVertType, points, num_points, managedBuf);
+		TessellationCacheEntry *cached = hashed ? tessCache_.Get(curveHash) : nullptr;
+		if (cached && !cached->indices.empty()) {
+			memcpy(output.vertices, cached->vertices.data(), cached->vertices.size() * sizeof(SimpleVertex));
+			memcpy(output.indices, cached->indices.data(), cached->indices.size() * sizeof(u16));
+			output.count = (int)cached->indices.size();
+			cached->lastFrame = gpuStats.numFlips;
+		} else {
+			ControlPoints cpoints(points, num_points, managedBuf);
+			if (cpoints.IsValid())
+				SoftwareTessellation(output, surface, origVertType, cpoints);
+			else
+				ERROR_LOG(G3D, "Failed to allocate space for control point values, skipping curve draw");
+
+			if (!hashed || output.count == 0) {
+				// Nothing to remember.
+			} else if (!cached) {
+				cached = new TessellationCacheEntry();
+				cached->lastFrame = gpuStats.numFlips;
+				tessCache_.Insert(curveHash, cached);
+			} else if (tessCacheBytes_ < TESS_CACHE_MAX_BYTES) {
+				// Second time we see this exact curve, so it's probably static.  Keep the output.
+				int numVerts = *std::max_element(output.indices, output.indices + output.count) + 1;
+				cached->vertices.assign(output.vertices, output.vertices + numVerts);
+				cached->indices.assign(output.indices, output.indices + output.count);
+				cached->lastFrame = gpuStats.numFlips;
+				tessCacheBytes_ += cached->Bytes();
+			} else {
+				cached->lastFrame = gpuStats.numFlips;
+			}
+		}
 	}
 
 	u32 vertTypeWithIndex16 = (vertType & ~GE_VTYPE_IDX_MASK) | GE_VTYPE_IDX_16BIT;
@@ -24,54 +24,65 @@
 #include "GPU/Common/FramebufferManagerCommon.h"
 #include "GPU/Common/TextureCacheCommon.h"
 
-static u8 StencilBits5551(const u8 *ptr8, u32 numPixels) {
+// Besides the bits used by any pixel, these also return the bits set in every pixel.
+// Those can be cleared in directly instead of drawn one pass at a time.
+static u8 StencilBits5551(const u8 *ptr8, u32 numPixels, u8 &commonBits) {
 	const u32 *ptr = (const u32 *)ptr8;
+	u32 bits = 0;
+	u32 common = 0xFFFFFFFF;
 
 	for (u32 i = 0; i < numPixels / 2; ++i) {
-		if (ptr[i] & 0x80008000) {
-			return 1;
-		}
+		bits |= ptr[i];
+		common &= ptr[i];
 	}
-	return 0;
+
+	commonBits = (common & 0x80008000) == 0x80008000 ? 1 : 0;
+	return (bits & 0x80008000) != 0 ? 1 : 0;
 }
 
-static u8 StencilBits4444(const u8 *ptr8, u32 numPixels) {
+static u8 StencilBits4444(const u8 *ptr8, u32 numPixels, u8 &commonBits) {
 	const u32 *ptr = (const u32 *)ptr8;
 	u32 bits = 0;
+	u32 common = 0xFFFFFFFF;
 
 	for (u32 i = 0; i < numPixels / 2; ++i) {
 		bits |= ptr[i];
+		common &= ptr[i];
 	}
 
+	commonBits = ((common >> 12) & 0xF) & (common >> 28);
 	return ((bits >> 12) & 0xF) | (bits >> 28);
 }
 
-static u8 StencilBits8888(const u8 *ptr8, u32 numPixels) {
+static u8 StencilBits8888(const u8 *ptr8, u32 numPixels, u8 &commonBits) {
 	const u32 *ptr = (const u32 *)ptr8;
 	u32 bits = 0;
+	u32 common = 0xFFFFFFFF;
 
 	for (u32 i = 0; i < numPixels; ++i) {
 		bits |= ptr[i];
+		common &= ptr[i];
 	}
 
+	commonBits = common >> 24;
 	return bits >> 24;
 }
 
-static bool CheckStencilBits(const u8 *src, const VirtualFramebuffer *dstBuffer, int &values, u8 &usedBits) {
+static bool CheckStencilBits(const u8 *src, const VirtualFramebuffer *dstBuffer, int &values, u8 &usedBits, u8 &commonBits) {
 	switch (dstBuffer->fb_format) {
 	case GE_FORMAT_565:
 		// Well, this doesn't make much sense.
 		return false;
 	case GE_FORMAT_5551:
-		usedBits = StencilBits5551(src, dstBuffer->fb_stride * dstBuffer->bufferHeight);
+		usedBits = StencilBits5551(src, dstBuffer->fb_stride * dstBuffer->bufferHeight, commonBits);
 		values = 2;
 		break;
 	case GE_FORMAT_4444:
-		usedBits = StencilBits4444(src, dstBuffer->fb_stride * dstBuffer->bufferHeight);
+		usedBits = StencilBits4444(src, dstBuffer->fb_stride * dstBuffer->bufferHeight, commonBits);
 		values = 16;
 		break;
 	case GE_FORMAT_8888:
-		usedBits = StencilBits8888(src, dstBuffer->fb_stride * dstBuffer->bufferHeight);
+		usedBits = StencilBits8888(src, dstBuffer->fb_stride * dstBuffer->bufferHeight, commonBits);
 		values = 256;
 		break;
 	case GE_FORMAT_INVALID:
@@ -184,6 +195,7 @@ bool FramebufferManagerCommon::PerformWriteStencilFromMemory(u32 addr, int size,
 
 	int values = 0;
 	u8 usedBits = 0;
+	u8 commonBits = 0;
 	bool useExportShader = draw_->GetDeviceCaps().fragmentShaderStencilWriteSupported;
 
 	const u8 *src = Memory::GetPointer(addr);
@@ -191,7 +203,7 @@ bool FramebufferManagerCommon::PerformWriteStencilFromMemory(u32 addr, int size,
 		return false;
 
 	// Could skip this when doing useExportShader, but then we couldn't optimize usedBits == 0.
-	if (!CheckStencilBits(src, dstBuffer, values, usedBits))
+	if (!CheckStencilBits(src, dstBuffer, values, usedBits, commonBits))
 		return false;
 
 	if (usedBits == 0) {
@@ -295,12 +307,35 @@ bool FramebufferManagerCommon::PerformWriteStencilFromMemory(u32 addr, int size,
 	u16 w = useBlit ? dstBuffer->width : dstBuffer->renderWidth;
 	u16 h = useBlit ? dstBuffer->height : dstBuffer->renderHeight;
 
+	// Without an export shader it's one pass per bit. Bits set in every pixel (like an opaque
+	// 8888 image, which is all of them) can go straight into the clear instead.
+	uint8_t clearStencil = 0;
+	if (!useExportShader) {
+		if (dstBuffer->fb_format == GE_FORMAT_4444) {
+			clearStencil = (commonBits << 4) | commonBits;
+		} else if (dstBuffer->fb_format == GE_FORMAT_5551) {
+			clearStencil = commonBits ? 0xFF : 0;
+		} else {
+			clearStencil = commonBits;
+		}
+	}
+
+	if (!useExportShader && (flags & WriteStencil::IGNORE_ALPHA) && (usedBits & ~commonBits) == 0) {
+		// Nothing left to draw, the clear does it all.
+		if (dstBuffer->fbo) {
+			draw_->BindFramebufferAsRenderTarget(dstBuffer->fbo, { Draw::RPAction::KEEP, Draw::RPAction::KEEP, Draw::RPAction::CLEAR, 0, 0.0f, clearStencil }, "WriteStencilFromMemory_ClearValue");
+		}
+		draw_->Invalidate(InvalidationFlags::CACHED_RENDER_STATE);
+		gstate_c.Dirty(DIRTY_ALL_RENDER_STATE);
+		return true;
+	}
+
 	Draw::Framebuffer *blitFBO = nullptr;
 	if (useBlit) {
 		blitFBO = GetTempFBO(TempFBO::STENCIL, w, h);
-		draw_->BindFramebufferAsRenderTarget(blitFBO, { Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE, Draw::RPAction::CLEAR }, "WriteStencilFromMemory_Blit");
+		draw_->BindFramebufferAsRenderTarget(blitFBO, { Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE, Draw::RPAction::CLEAR, 0, 0.0f, clearStencil }, "WriteStencilFromMemory_Blit");
 	} else if (dstBuffer->fbo) {
-		draw_->BindFramebufferAsRenderTarget(dstBuffer->fbo, { Draw::RPAction::KEEP, Draw::RPAction::KEEP, Draw::RPAction::CLEAR }, "WriteStencilFromMemory_NoBlit");
+		draw_->BindFramebufferAsRenderTarget(dstBuffer->fbo, { Draw::RPAction::KEEP, Draw::RPAction::KEEP, Draw::RPAction::CLEAR, 0, 0.0f, clearStencil }, "WriteStencilFromMemory_NoBlit");
 	}
 
 	Draw::Viewport viewport = { 0.0f, 0.0f, (float)w, (float)h, 0.0f, 1.0f };
@@ -327,9 +362,14 @@ bool FramebufferManagerCommon::PerformWriteStencilFromMemory(u32 addr, int size,
 		draw_->UpdateDynamicUniformBuffer(&ub, sizeof(ub));
 		draw_->DrawUP(positions, 3);
 	} else {
+		// If alpha has to be written, keep one pass for a common bit since it touches every pixel.
+		u8 skipBits = commonBits;
+		if (!(flags & WriteStencil::IGNORE_ALPHA) && commonBits != 0) {
+			skipBits &= ~(commonBits & -commonBits);
+		}
 		for (int i = 1; i < values; i += i) {
-			if (!(usedBits & i)) {
-				// It's already zero, let's skip it.
+			if (!(usedBits & i) || (skipBits & i)) {
+				// It's already zero, or set by the clear, let's skip it.
 				continue;
 			}
 			StencilUB ub{};
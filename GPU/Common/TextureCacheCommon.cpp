@@ -18,19 +18,26 @@
 #include "ppsspp_config.h"
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
 
 #include "Common/Common.h"
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/Data/Collections/TinySet.h"
+#include "Common/Profiler/MemoryUsage.h"
 #include "Common/Profiler/Profiler.h"
 #include "Common/LogReporting.h"
 #include "Common/MemoryUtil.h"
 #include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Common/Math/math_util.h"
 #include "Common/GPU/thin3d.h"
 #include "Core/Config.h"
 #include "Core/Debugger/MemBlockInfo.h"
+#include "Core/HW/Display.h"
+#include "Core/MemFault.h"
 #include "Core/System.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
 #include "GPU/Common/TextureCacheCommon.h"
@@ -128,9 +135,16 @@ TextureCacheCommon::TextureCacheCommon(Draw::DrawContext *draw, Draw2D *draw2D)
 	replacer_.Init();
 
 	textureShaderCache_ = new TextureShaderCache(draw, draw2D_);
+
+	MemUsage_ListenPressure(MemoryCategory::TEXTURE_CACHE, &TextureCacheCommon::NotifyMemoryPressure, this);
+	MemUsage_ListenPressure(MemoryCategory::TEXTURE_REPLACEMENT, &TextureCacheCommon::NotifyMemoryPressure, this);
 }
 
 TextureCacheCommon::~TextureCacheCommon() {
+	MemUsage_ForgetPressure(MemoryCategory::TEXTURE_CACHE, &TextureCacheCommon::NotifyMemoryPressure, this);
+	MemUsage_ForgetPressure(MemoryCategory::TEXTURE_REPLACEMENT, &TextureCacheCommon::NotifyMemoryPressure, this);
+	MemUsage_Set(MemoryCategory::TEXTURE_CACHE, 0);
+
 	delete textureShaderCache_;
 
 	FreeAlignedMemory(clutBufConverted_);
@@ -152,9 +166,20 @@ void TextureCacheCommon::StartFrame() {
 	if (clearCacheNextFrame_) {
 		Clear(true);
 		clearCacheNextFrame_ = false;
+	} else if (memoryPressure_.exchange(false)) {
+		// Over the configured budget, so don't wait for the usual interval.
+		decimationCounter_ = 0;
+		Decimate(true);
 	} else {
 		Decimate(false);
 	}
+
+	MemUsage_Set(MemoryCategory::TEXTURE_CACHE, (int64_t)cacheSizeEstimate_ + secondCacheSizeEstimate_);
+}
+
+void TextureCacheCommon::NotifyMemoryPressure(MemoryCategory cat, void *userdata) {
+	TextureCacheCommon *texCache = (TextureCacheCommon *)userdata;
+	texCache->memoryPressure_ = true;
 }
 
 // Produces a signed 1.23.8 value.
@@ -338,8 +363,9 @@ SamplerCacheKey TextureCacheCommon::GetFramebufferSamplingParams(u16 bufferWidth
 }
 
 void TextureCacheCommon::UpdateMaxSeenV(TexCacheEntry *entry, bool throughMode) {
-	// If the texture is >= 512 pixels tall...
-	if (entry->dim >= 0x900) {
+	// If the texture is >= 512 pixels tall (or any size, if enabled)...
+	const int texHeight = dimHeight(entry->dim);
+	if (entry->dim >= 0x900 || (g_Config.bTexHashSampledRows && texHeight >= 64)) {
 		if (entry->cluthash != 0 && entry->maxSeenV == 0) {
 			const u64 cachekeyMin = (u64)(entry->addr & 0x3FFFFFFF) << 32;
 			const u64 cachekeyMax = cachekeyMin + (1ULL << 32);
@@ -358,7 +384,8 @@ void TextureCacheCommon::UpdateMaxSeenV(TexCacheEntry *entry, bool throughMode)
 		if (throughMode) {
 			if (entry->maxSeenV == 0 && gstate_c.vertBounds.maxV > 0) {
 				// Let's not hash less than 272, we might use more later and have to rehash.  272 is very common.
-				entry->maxSeenV = std::max((u16)272, gstate_c.vertBounds.maxV);
+				const u16 minRows = texHeight >= 512 ? 272 : (u16)(texHeight / 2);
+				entry->maxSeenV = std::max(minRows, gstate_c.vertBounds.maxV);
 			} else if (gstate_c.vertBounds.maxV > entry->maxSeenV) {
 				// The max height changed, so we're better off hashing the entire thing.
 				entry->maxSeenV = 512;
@@ -514,6 +541,12 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 			} else if (entry->GetHashStatus() == TexCacheEntry::STATUS_RELIABLE) {
 				rehash = false;
 			}
+
+			// When we know about every write, there's no need to guess. Skip the hash or do it right away.
+			if (match && entry->writeWatchStamp != 0) {
+				const u32 sizeInRAM = (textureBitsPerPixel[entry->format] * entry->bufw * dimHeight(entry->dim)) / 8;
+				rehash = Memory::MemWriteWatch_WrittenSince(entry->addr, sizeInRAM, entry->writeWatchStamp);
+			}
 		}
 
 		if (match && (entry->status & TexCacheEntry::STATUS_TO_SCALE) && standardScaleFactor_ != 1 && texelsScaledThisFrame_ < TEXCACHE_MAX_TEXELS_SCALED) {
@@ -544,6 +577,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 
 		if (match) {
 			// got one!
+			gpuStats.numTextureCacheHits++;
 			gstate_c.curTextureWidth = w;
 			gstate_c.curTextureHeight = h;
 			gstate_c.SetTextureIs3D((entry->status & TexCacheEntry::STATUS_3D) != 0);
@@ -595,6 +629,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 	}
 
 	// Didn't match a framebuffer, keep going.
+	gpuStats.numTextureCacheMisses++;
 
 	if (!entry) {
 		VERBOSE_LOG(G3D, "No texture in cache for %08x, decoding...", texaddr);
@@ -1643,6 +1678,20 @@ static void Expand4To8Bits(u8 *dest, const u8 *src, int srcWidth) {
 	}
 }
 
+// Large levels are decoded in bands of rows on the worker threads, writing straight into the output
+// (for Vulkan, that's the mapped push buffer.) Each band keeps its own alpha sum, combined at the end.
+// Small levels are decoded inline, since ParallelRangeLoop doesn't split ranges below minSize.
+static void DecodeRowBands(int w, int h, u32 *alphaSum, const std::function<void(int, int, u32 *)> &decodeRows) {
+	const int minRowsPerBand = std::max(8, 65536 / std::max(w, 1));
+	std::atomic<u32> sharedAlphaSum(*alphaSum);
+	ParallelRangeLoop(&g_threadManager, [&](int y1, int y2) {
+		u32 bandAlphaSum = 0xFFFFFFFF;
+		decodeRows(y1, y2, &bandAlphaSum);
+		sharedAlphaSum.fetch_and(bandAlphaSum);
+	}, 0, h, minRowsPerBand, TaskPriority::HIGH);
+	*alphaSum = sharedAlphaSum.load();
+}
+
 CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, TexDecodeFlags flags) {
 	u32 alphaSum = 0xFFFFFFFF;
 	u32 fullAlphaMask = 0x0;
@@ -1708,13 +1757,17 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 				// We don't bother with fullalpha here (clutAlphaLinear_)
 				// Here, reverseColors means the CLUT is already reversed.
 				if (reverseColors) {
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4Optimal((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
-					}
+					DecodeRowBands(w, h, &alphaSum, [&](int y1, int y2, u32 *bandAlphaSum) {
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4Optimal((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
+						}
+					});
 				} else {
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4OptimalRev((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
-					}
+					DecodeRowBands(w, h, &alphaSum, [&](int y1, int y2, u32 *bandAlphaSum) {
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4OptimalRev((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
+						}
+					});
 				}
 			} else {
 				// Need to have the "un-reversed" (raw) CLUT here since we are using a generic conversion function.
@@ -1729,16 +1782,20 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 						ConvertFormatToRGBA8888(clutformat, expandClut_, clut, 512);
 					}
 					fullAlphaMask = 0xFF000000;
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4<u32>((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, expandClut_, &alphaSum);
-					}
+					DecodeRowBands(w, h, &alphaSum, [&](int y1, int y2, u32 *bandAlphaSum) {
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4<u32>((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, expandClut_, bandAlphaSum);
+						}
+					});
 				} else {
 					// If we're reversing colors, the CLUT was already reversed, no special handling needed.
 					const u16 *clut = GetCurrentClut<u16>() + clutSharingOffset;
 					fullAlphaMask = ClutFormatToFullAlpha(clutformat, reverseColors);
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4<u16>((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut, &alphaSum);
-					}
+					DecodeRowBands(w, h, &alphaSum, [&](int y1, int y2, u32 *bandAlphaSum) {
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4<u16>((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut, bandAlphaSum);
+						}
+					});
 				}
 			}
 
@@ -1753,9 +1810,11 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 		{
 			const u32 *clut = GetCurrentClut<u32>() + clutSharingOffset;
 			fullAlphaMask = 0xFF000000;
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture4<u32>((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut, &alphaSum);
-			}
+			DecodeRowBands(w, h, &alphaSum, [&](int y1, int y2, u32 *bandAlphaSum) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture4<u32>((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut, bandAlphaSum);
+				}
+			});
 		}
 		break;
 
@@ -1948,21 +2007,27 @@ CheckAlphaResult TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int l
 	{
 		switch (bytesPerIndex) {
 		case 1:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut16, &alphaSum);
-			}
+			DecodeRowBands(w, h, &alphaSum, [&](int y1, int y2, u32 *bandAlphaSum) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u16 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut16, bandAlphaSum);
+				}
+			});
 			break;
 
 		case 2:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut16, &alphaSum);
-			}
+			DecodeRowBands(w, h, &alphaSum, [&](int y1, int y2, u32 *bandAlphaSum) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u16 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut16, bandAlphaSum);
+				}
+			});
 			break;
 
 		case 4:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut16, &alphaSum);
-			}
+			DecodeRowBands(w, h, &alphaSum, [&](int y1, int y2, u32 *bandAlphaSum) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u16 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut16, bandAlphaSum);
+				}
+			});
 			break;
 		}
 	}
@@ -1973,21 +2038,27 @@ CheckAlphaResult TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int l
 
 		switch (bytesPerIndex) {
 		case 1:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut32, &alphaSum);
-			}
+			DecodeRowBands(w, h, &alphaSum, [&](int y1, int y2, u32 *bandAlphaSum) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u32 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut32, bandAlphaSum);
+				}
+			});
 			break;
 
 		case 2:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut32, &alphaSum);
-			}
+			DecodeRowBands(w, h, &alphaSum, [&](int y1, int y2, u32 *bandAlphaSum) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u32 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut32, bandAlphaSum);
+				}
+			});
 			break;
 
 		case 4:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut32, &alphaSum);
-			}
+			DecodeRowBands(w, h, &alphaSum, [&](int y1, int y2, u32 *bandAlphaSum) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u32 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut32, bandAlphaSum);
+				}
+			});
 			break;
 		}
 	}
@@ -2040,6 +2111,7 @@ void TextureCacheCommon::ApplyTexture() {
 			// Update the hash on the texture.
 			int w = gstate.getTextureWidth(0);
 			int h = gstate.getTextureHeight(0);
+			WatchTextureWrites(entry, h);
 			entry->fullhash = QuickTexHash(replacer_, entry->addr, entry->bufw, w, h, GETextureFormat(entry->format), entry);
 
 			// TODO: Here we could check the secondary cache; maybe the texture is in there?
@@ -2154,8 +2226,9 @@ void TextureCacheCommon::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer
 	bool need_depalettize = CanDepalettize(texFormat, depth ? GE_FORMAT_DEPTH16 : framebuffer->fb_format);
 
 	// Shader depal is not supported during 3D texturing or depth texturing, and requires 32-bit integer instructions in the shader.
+	// Dynamic CLUTs work too, the shader just looks them up in dynamicClutFbo_ instead.
 	bool useShaderDepal = framebufferManager_->GetCurrentRenderVFB() != framebuffer &&
-		!depth && clutRenderAddress_ == 0xFFFFFFFF &&
+		!depth &&
 		!gstate_c.curTextureIs3D &&
 		draw_->GetShaderLanguageDesc().bitwiseOps;
 
@@ -2190,16 +2263,25 @@ void TextureCacheCommon::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer
 			float scaleFactorX = 1.0f;
 			Draw2DPipeline *reinterpret = framebufferManager_->GetReinterpretPipeline(clutRenderFormat_, expectedCLUTBufferFormat, &scaleFactorX);
 			framebufferManager_->BlitUsingRaster(dynamicClutTemp_, 0.0f, 0.0f, 512.0f, 1.0f, dynamicClutFbo_, 0.0f, 0.0f, scaleFactorX * 512.0f, 1.0f, false, 1.0f, reinterpret, "reinterpret_clut");
+			if (useShaderDepal) {
+				// The draw itself reads the CLUT, so get back to the render target now.
+				framebufferManager_->RebindFramebuffer("after_reinterpret_clut");
+			}
 		}
 
 		if (useShaderDepal) {
-			// Very icky conflation here of native and thin3d rendering. This will need careful work per backend in BindAsClutTexture.
-			BindAsClutTexture(clutTexture.texture, smoothedDepal);
-
 			framebufferManager_->BindFramebufferAsColorTexture(0, framebuffer, BINDFBCOLOR_MAY_COPY_WITH_UV | BINDFBCOLOR_APPLY_TEX_OFFSET, Draw::ALL_LAYERS);
 			// Vulkan needs to do some extra work here to pick out the native handle from Draw.
 			BoundFramebufferTexture();
 
+			// Very icky conflation here of native and thin3d rendering. This will need careful work per backend in BindAsClutTexture.
+			// Done after binding the framebuffer, in case that had to make a copy and switch render passes.
+			if (clutRenderAddress_ == 0xFFFFFFFF) {
+				BindAsClutTexture(clutTexture.texture, smoothedDepal);
+			} else {
+				BindAsClutFramebuffer(dynamicClutFbo_);
+			}
+
 			SamplerCacheKey samplerKey = GetFramebufferSamplingParams(framebuffer->bufferWidth, framebuffer->bufferHeight);
 			samplerKey.magFilt = false;
 			samplerKey.minFilt = false;
@@ -2445,6 +2527,17 @@ void TextureCacheCommon::DeleteTexture(TexCache::iterator it) {
 	cache_.erase(it);
 }
 
+// Protects the texture's RAM before it's hashed, so that any write after the hash is noticed.
+void TextureCacheCommon::WatchTextureWrites(TexCacheEntry *entry, int h) {
+	entry->writeWatchStamp = 0;
+	if (!g_Config.bTexWriteTracking || IsVideo(entry->addr) || (entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) != 0) {
+		// Frequent changes would just fault over and over, hashing is cheaper then.
+		return;
+	}
+	const u32 sizeInRAM = (textureBitsPerPixel[entry->format] * entry->bufw * h) / 8;
+	entry->writeWatchStamp = Memory::MemWriteWatch_Protect(entry->addr, sizeInRAM);
+}
+
 bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	int w = gstate.getTextureWidth(0);
 	int h = gstate.getTextureHeight(0);
@@ -2460,6 +2553,7 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	u32 fullhash;
 	{
 		PROFILE_THIS_SCOPE("texhash");
+		WatchTextureWrites(entry, h);
 		fullhash = QuickTexHash(replacer_, entry->addr, entry->bufw, w, h, GETextureFormat(entry->format), entry);
 	}
 
@@ -2780,6 +2874,14 @@ bool TextureCacheCommon::PrepareBuildTexture(BuildTexturePlan &plan, TexCacheEnt
 	if (canReplace) {
 		plan.replaced = &FindReplacement(entry, plan.w, plan.h, plan.depth);
 		plan.replaceValid = plan.replaced->Valid();
+		if (plan.replaceValid && Draw::DataFormatIsBlockCompressed(plan.replaced->Format(0), nullptr)) {
+			const Draw::DataFormat replacedFmt = plan.replaced->Format(0);
+			if (!SupportsCompressedReplacements() || (draw_->GetDataFormatSupport(replacedFmt) & Draw::FMT_TEXTURE) == 0) {
+				WARN_LOG_ONCE(compressedreplace, G3D, "Compressed texture replacement format %d not supported on this device, ignoring", (int)replacedFmt);
+				plan.replaced = &replacer_.FindNone();
+				plan.replaceValid = false;
+			}
+		}
 	} else {
 		plan.replaced = &replacer_.FindNone();
 		plan.replaceValid = false;
@@ -2846,11 +2948,13 @@ void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, i
 	int h = gstate.getTextureHeight(srcLevel);
 
 	PROFILE_THIS_SCOPE("decodetex");
+	FrameTimeScope frameTimeScope(FrameTimeCategory::TEXTURE);
 
 	if (plan.replaceValid && plan.replaced->GetSize(srcLevel, w, h)) {
 		double replaceStart = time_now_d();
 		plan.replaced->Load(srcLevel, data, stride);
 		replacementTimeThisFrame_ += time_now_d() - replaceStart;
+		gpuStats.numTextureDataBytesUploaded += stride * h;
 	} else {
 		GETextureFormat tfmt = (GETextureFormat)entry.format;
 		GEPaletteFormat clutformat = gstate.getClutPaletteFormat();
@@ -2895,6 +2999,7 @@ void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, i
 				decPitch = stride;
 			}
 		}
+		gpuStats.numTextureDataBytesUploaded += stride * h;
 
 		if (replacer_.Enabled() && plan.replaced->IsInvalid()) {
 			ReplacedTextureDecodeInfo replacedInfo;
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <vector>
 #include <memory>
@@ -32,6 +33,7 @@
 #include "GPU/Common/TextureShaderCommon.h"
 
 class Draw2D;
+enum class MemoryCategory;
 
 enum FramebufferNotification {
 	NOTIFY_FB_CREATED,
@@ -176,6 +178,8 @@ struct TexCacheEntry {
 	u32 framesUntilNextFullHash;
 	u32 fullhash;
 	u32 cluthash;
+	// From Memory::MemWriteWatch_Protect when last hashed, or 0 if writes to it aren't tracked.
+	u32 writeWatchStamp;
 	u16 maxSeenV;
 
 	TexStatus GetHashStatus() {
@@ -374,6 +378,8 @@ class TextureCacheCommon {
 	bool CheckFullHash(TexCacheEntry *entry, bool &doDelete);
 
 	virtual void BindAsClutTexture(Draw::Texture *tex, bool smooth) {}
+	// For shader depal with a dynamic CLUT, which lives in a framebuffer. Always sampled nearest.
+	virtual void BindAsClutFramebuffer(Draw::Framebuffer *fb) {}
 
 	CheckAlphaResult DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, TexDecodeFlags flags);
 	void UnswizzleFromMem(u32 *dest, u32 destPitch, const u8 *texptr, u32 bufw, u32 height, u32 bytesPerPixel);
@@ -407,10 +413,15 @@ class TextureCacheCommon {
 	bool GetCurrentFramebufferTextureDebug(GPUDebugBuffer &buffer, bool *isFramebuffer);
 
 	virtual void BoundFramebufferTexture() {}
+	// Whether BuildTexture can upload block compressed replacements (from DDS/KTX2 files) as is.
+	virtual bool SupportsCompressedReplacements() const { return false; }
 
 	void DecimateVideos();
+	static void NotifyMemoryPressure(MemoryCategory cat, void *userdata);
 	bool IsVideo(u32 texaddr) const;
 
+	void WatchTextureWrites(TexCacheEntry *entry, int h);
+
 	static CheckAlphaResult CheckCLUTAlpha(const uint8_t *pixelData, GEPaletteFormat clutFmt, int w);
 
 	inline u32 QuickTexHash(TextureReplacer &replacer, u32 addr, int bufw, int w, int h, GETextureFormat format, const TexCacheEntry *entry) const {
@@ -418,7 +429,8 @@ class TextureCacheCommon {
 			return replacer.ComputeHash(addr, bufw, w, h, format, entry->maxSeenV);
 		}
 
-		if (h == 512 && entry->maxSeenV < 512 && entry->maxSeenV != 0) {
+		// Only tracked for 512 tall textures, unless bTexHashSampledRows is on. See UpdateMaxSeenV.
+		if (entry->maxSeenV < h && entry->maxSeenV != 0) {
 			h = (int)entry->maxSeenV;
 		}
 
@@ -428,7 +440,7 @@ class TextureCacheCommon {
 		gpuStats.numTextureDataBytesHashed += sizeInRAM;
 
 		if (Memory::IsValidAddress(addr + sizeInRAM)) {
-			return StableQuickTexHash(checkp, sizeInRAM);
+			return CacheTexHash(checkp, sizeInRAM);
 		} else {
 			return 0;
 		}
@@ -449,6 +461,8 @@ class TextureCacheCommon {
 
 	bool clearCacheNextFrame_ = false;
 	bool lowMemoryMode_ = false;
+	// Set from MemUsage when over budget, possibly from another thread.
+	std::atomic<bool> memoryPressure_{};
 
 	int decimationCounter_;
 	int texelsScaledThisFrame_ = 0;
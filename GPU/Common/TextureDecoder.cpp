@@ -31,6 +31,7 @@
 #ifdef _M_SSE
 #include <emmintrin.h>
 #include <smmintrin.h>
+#include <nmmintrin.h>
 #endif
 
 #if PPSSPP_ARCH(ARM_NEON)
@@ -279,6 +280,57 @@ u32 StableQuickTexHash(const void *checkp, u32 size) {
 #endif
 }
 
+#ifdef _M_SSE
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SSE42_TARGET __attribute__((target("sse4.2")))
+#else
+#define SSE42_TARGET
+#endif
+
+// Four interleaved CRC32C streams to hide the latency of the instruction, so it's not a real CRC
+// of the buffer - but we only need it to change when the data does.
+SSE42_TARGET static u32 CacheTexHashCRC32(const void *checkp, u32 size) {
+	const u8 *p = (const u8 *)checkp;
+#if PPSSPP_ARCH(AMD64)
+	u64 crc0 = 0xFFFFFFFF, crc1 = 0x9E3779B9, crc2 = 0x7F4A7C15, crc3 = 0xF39CC060;
+	for (; size >= 32; size -= 32, p += 32) {
+		crc0 = _mm_crc32_u64(crc0, *(const u64 *)(p + 0));
+		crc1 = _mm_crc32_u64(crc1, *(const u64 *)(p + 8));
+		crc2 = _mm_crc32_u64(crc2, *(const u64 *)(p + 16));
+		crc3 = _mm_crc32_u64(crc3, *(const u64 *)(p + 24));
+	}
+	u32 check0 = (u32)crc0, check1 = (u32)crc1, check2 = (u32)crc2, check3 = (u32)crc3;
+#else
+	u32 check0 = 0xFFFFFFFF, check1 = 0x9E3779B9, check2 = 0x7F4A7C15, check3 = 0xF39CC060;
+	for (; size >= 16; size -= 16, p += 16) {
+		check0 = _mm_crc32_u32(check0, *(const u32 *)(p + 0));
+		check1 = _mm_crc32_u32(check1, *(const u32 *)(p + 4));
+		check2 = _mm_crc32_u32(check2, *(const u32 *)(p + 8));
+		check3 = _mm_crc32_u32(check3, *(const u32 *)(p + 12));
+	}
+#endif
+	for (; size >= 4; size -= 4, p += 4)
+		check0 = _mm_crc32_u32(check0, *(const u32 *)p);
+	for (; size > 0; --size, ++p)
+		check0 = _mm_crc32_u8(check0, *p);
+
+	// Rotate so identical streams (like a solid color) don't cancel out.
+	return check0 ^ ((check1 << 8) | (check1 >> 24)) ^ ((check2 << 16) | (check2 >> 16)) ^ ((check3 << 24) | (check3 >> 8));
+}
+
+#endif
+
+u32 CacheTexHash(const void *checkp, u32 size) {
+#ifdef _M_SSE
+	if (cpu_info.bSSE4_2) {
+		return CacheTexHashCRC32(checkp, size);
+	}
+#endif
+	// XXH3 uses SSE2/NEON internally, it's the best we have without a CRC instruction.
+	return (u32)XXH3_64bits(checkp, size);
+}
+
 void DoSwizzleTex16(const u32 *ysrcp, u8 *texptr, int bxc, int byc, u32 pitch) {
 	// ysrcp is in 32-bits, so this is convenient.
 	const u32 pitchBy32 = pitch >> 2;
@@ -38,6 +38,10 @@ void DoUnswizzleTex16(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch
 
 u32 StableQuickTexHash(const void *checkp, u32 size);
 
+// Faster than StableQuickTexHash, but picks the kernel at runtime based on the CPU, so the result
+// is only for detecting changes within a session. Never use it for anything that's saved.
+u32 CacheTexHash(const void *checkp, u32 size);
+
 // outMask is an in/out parameter.
 void CopyAndSumMask16(u16 *dst, const u16 *src, int width, u32 *outMask);
 void CopyAndSumMask32(u32 *dst, const u32 *src, int width, u32 *outMask);
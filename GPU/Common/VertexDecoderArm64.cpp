@@ -236,23 +236,46 @@ JittedVertexDecoder VertexDecoderJitCache::Compile(const VertexDecoder &dec, int
 		LDRH(INDEX_UNSIGNED, boundsMaxVReg, scratchReg64, offsetof(KnownVertexBounds, maxV));
 	}
 
+	// Without skinning or morph, the steps are small enough to decode two vertices per iteration.
+	// That halves the loop overhead and gives the CPU two independent vertices to overlap.
+	bool unroll = !dec.skinInDecode && dec.morphcount == 1;
+
+	FixupBranch skipPairs;
+	if (unroll) {
+		CMP(counterReg, 2);
+		skipPairs = B(CC_LO);
+	}
+
 	const u8 *loopStart = GetCodePtr();
-	for (int i = 0; i < dec.numSteps_; i++) {
-		if (!CompileStep(dec, i)) {
+	for (int v = 0; v < (unroll ? 2 : 1); v++) {
+		if (!CompileSteps(dec)) {
 			EndWrite();
 			// Reset the code ptr (effectively undoing what we generated) and return zero to indicate that we failed.
 			ResetCodePtr(GetOffset(start));
 			char temp[1024] = {0};
 			dec.ToString(temp);
-			ERROR_LOG(G3D, "Could not compile vertex decoder, failed at step %d: %s", i, temp);
+			ERROR_LOG(G3D, "Could not compile vertex decoder: %s", temp);
 			return nullptr;
 		}
+
+		ADDI2R(srcReg, srcReg, dec.VertexSize(), scratchReg);
+		ADDI2R(dstReg, dstReg, dec.decFmt.stride, scratchReg);
 	}
 
-	ADDI2R(srcReg, srcReg, dec.VertexSize(), scratchReg);
-	ADDI2R(dstReg, dstReg, dec.decFmt.stride, scratchReg);
-	SUBS(counterReg, counterReg, 1);
-	B(CC_NEQ, loopStart);
+	if (unroll) {
+		SUB(counterReg, counterReg, 2);
+		CMP(counterReg, 2);
+		B(CC_HS, loopStart);
+
+		// There may be one left over.
+		SetJumpTarget(skipPairs);
+		FixupBranch skipLast = CBZ(counterReg);
+		CompileSteps(dec);
+		SetJumpTarget(skipLast);
+	} else {
+		SUBS(counterReg, counterReg, 1);
+		B(CC_NEQ, loopStart);
+	}
 
 	if (dec.col) {
 		MOVP2R(tempRegPtr, &gstate_c.vertexFullAlpha);
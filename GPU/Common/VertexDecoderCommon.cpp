@@ -25,6 +25,7 @@
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/Log.h"
 #include "Common/LogReporting.h"
+#include "Common/Profiler/PerfMap.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/MemMap.h"
@@ -1278,15 +1279,15 @@ void VertexDecoder::SetVertexType(u32 fmt, const VertexDecoderOptions &options,
 		jitted_ = jitCache->Compile(*this, &jittedSize_);
 		if (!jitted_) {
 			WARN_LOG(G3D, "Vertex decoder JIT failed! fmt = %08x (%s)", fmt_, GetString(SHADER_STRING_SHORT_DESC).c_str());
+		} else if (PerfMap_IsEnabled()) {
+			PerfMap_AddSymbol((const void *)jitted_, jittedSize_, "VertexDecoder " + GetString(SHADER_STRING_SHORT_DESC));
 		}
 	}
 }
 
 void VertexDecoder::DecodeVerts(u8 *decodedptr, const void *verts, int indexLowerBound, int indexUpperBound) const {
 	// Decode the vertices within the found bounds, once each
-	// decoded_ and ptr_ are used in the steps, so can't be turned into locals for speed.
-	decoded_ = decodedptr;
-	ptr_ = (const u8*)verts + indexLowerBound * size;
+	const u8 *startPtr = (const u8*)verts + indexLowerBound * size;
 
 	int count = indexUpperBound - indexLowerBound + 1;
 	int stride = decFmt.stride;
@@ -1300,9 +1301,13 @@ void VertexDecoder::DecodeVerts(u8 *decodedptr, const void *verts, int indexLowe
 
 	if (jitted_) {
 		// We've compiled the steps into optimized machine code, so just jump!
-		jitted_(ptr_, decoded_, count);
+		// This path must not touch decoded_/ptr_, see CanDecodeInParallel().
+		jitted_(startPtr, decodedptr, count);
 	} else {
 		// Interpret the decode steps
+		// decoded_ and ptr_ are used in the steps, so can't be turned into locals for speed.
+		decoded_ = decodedptr;
+		ptr_ = startPtr;
 		for (; count; count--) {
 			for (int i = 0; i < numSteps_; i++) {
 				((*this).*steps_[i])();
@@ -1398,6 +1403,14 @@ VertexDecoderJitCache::VertexDecoderJitCache()
 #endif
 }
 
+bool VertexDecoderJitCache::CompileSteps(const VertexDecoder &dec) {
+	for (int i = 0; i < dec.numSteps_; i++) {
+		if (!CompileStep(dec, i))
+			return false;
+	}
+	return true;
+}
+
 void VertexDecoderJitCache::Clear() {
 	if (g_Config.iCpuCore == (int)CPUCore::JIT) {
 		ClearCodeSpace(0);
@@ -340,7 +340,12 @@ class VertexDecoder {
 
 	void DecodeVerts(u8 *decoded, const void *verts, int indexLowerBound, int indexUpperBound) const;
 
+	// The jitted decoders don't touch any mutable state, except for the through mode UV bounds
+	// and the skinning matrices, so separate ranges can then be decoded on different threads.
+	bool CanDecodeInParallel() const { return jitted_ != nullptr && !throughmode && !skinInDecode; }
+
 	int VertexSize() const { return size; }  // PSP format size
+	int PositionOffset() const { return posoff; }  // In the PSP format
 
 	std::string GetString(DebugShaderStringType stringType);
 
@@ -582,6 +587,7 @@ class VertexDecoderJitCache : public VERTEXDECODER_JIT_BACKEND {
 
 private:
 	bool CompileStep(const VertexDecoder &dec, int i);
+	bool CompileSteps(const VertexDecoder &dec);
 	void Jit_ApplyWeights();
 	void Jit_WriteMatrixMul(int outOff, bool pos);
 	void Jit_WriteMorphColor(int outOff, bool checkAlpha = true);
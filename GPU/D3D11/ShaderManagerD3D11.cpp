@@ -89,6 +89,11 @@ std::string D3D11VertexShader::GetShaderString(DebugShaderStringType type) const
 
 static constexpr size_t CODE_BUFFER_SIZE = 32768;
 
+// Each uniform block gets a slot of this size in the ring. Offsets and sizes must be
+// multiples of 16 constants (256 bytes) with VSSetConstantBuffers1.
+static constexpr UINT UNIFORM_RING_SLOT = 512;
+static constexpr size_t UNIFORM_PUSH_SIZE = 1024 * 1024 * 2;
+
 ShaderManagerD3D11::ShaderManagerD3D11(Draw::DrawContext *draw, ID3D11Device *device, ID3D11DeviceContext *context, D3D_FEATURE_LEVEL featureLevel)
 	: ShaderManagerCommon(draw), device_(device), context_(context), featureLevel_(featureLevel) {
 	codeBuffer_ = new char[CODE_BUFFER_SIZE];
@@ -106,12 +111,23 @@ ShaderManagerD3D11::ShaderManagerD3D11(Draw::DrawContext *draw, ID3D11Device *de
 	ASSERT_SUCCESS(device_->CreateBuffer(&desc, nullptr, &push_lights));
 	desc.ByteWidth = sizeof(ub_bones);
 	ASSERT_SUCCESS(device_->CreateBuffer(&desc, nullptr, &push_bones));
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+	context1_ = (ID3D11DeviceContext1 *)draw->GetNativeObject(Draw::NativeObject::CONTEXT_EX);
+	if (context1_ && SUCCEEDED(device_->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))) {
+		if (options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer) {
+			uniformPush_ = new PushBufferD3D11(device_, UNIFORM_PUSH_SIZE, D3D11_BIND_CONSTANT_BUFFER);
+			// The first map of a constant buffer must discard.
+			uniformPush_->Reset();
+		}
+	}
 }
 
 ShaderManagerD3D11::~ShaderManagerD3D11() {
 	push_base->Release();
 	push_lights->Release();
 	push_bones->Release();
+	delete uniformPush_;
 	ClearShaders();
 	delete[] codeBuffer_;
 }
@@ -146,7 +162,32 @@ void ShaderManagerD3D11::DirtyLastShader() {
 
 uint64_t ShaderManagerD3D11::UpdateUniforms(bool useBufferedRendering) {
 	uint64_t dirty = gstate_c.GetDirtyUniforms();
-	if (dirty != 0) {
+	if (dirty != 0 && uniformPush_) {
+		// One map for all the blocks. Always reserves room for all three, so if the ring wrapped
+		// (discarding the old contents) we can write the clean ones again too.
+		UINT offset;
+		uint8_t *dest = uniformPush_->BeginPush(context_, &offset, UNIFORM_RING_SLOT * 3, UNIFORM_RING_SLOT);
+		bool discarded = offset == 0;
+		if (dirty & DIRTY_BASE_UNIFORMS)
+			BaseUpdateUniforms(&ub_base, dirty, true, useBufferedRendering);
+		if ((dirty & DIRTY_BASE_UNIFORMS) || discarded) {
+			memcpy(dest, &ub_base, sizeof(ub_base));
+			baseOffset_ = offset;
+		}
+		if (dirty & DIRTY_LIGHT_UNIFORMS)
+			LightUpdateUniforms(&ub_lights, dirty);
+		if ((dirty & DIRTY_LIGHT_UNIFORMS) || discarded) {
+			memcpy(dest + UNIFORM_RING_SLOT, &ub_lights, sizeof(ub_lights));
+			lightsOffset_ = offset + UNIFORM_RING_SLOT;
+		}
+		if (dirty & DIRTY_BONE_UNIFORMS)
+			BoneUpdateUniforms(&ub_bones, dirty);
+		if ((dirty & DIRTY_BONE_UNIFORMS) || discarded) {
+			memcpy(dest + UNIFORM_RING_SLOT * 2, &ub_bones, sizeof(ub_bones));
+			bonesOffset_ = offset + UNIFORM_RING_SLOT * 2;
+		}
+		uniformPush_->EndPush(context_);
+	} else if (dirty != 0) {
 		D3D11_MAPPED_SUBRESOURCE map;
 		if (dirty & DIRTY_BASE_UNIFORMS) {
 			BaseUpdateUniforms(&ub_base, dirty, true, useBufferedRendering);
@@ -172,6 +213,17 @@ uint64_t ShaderManagerD3D11::UpdateUniforms(bool useBufferedRendering) {
 }
 
 void ShaderManagerD3D11::BindUniforms() {
+	if (uniformPush_) {
+		ID3D11Buffer *buf = uniformPush_->Buf();
+		ID3D11Buffer *vs_cbs[3] = { buf, buf, buf };
+		// In units of 16-byte constants.
+		UINT firstConstant[3] = { baseOffset_ / 16, lightsOffset_ / 16, bonesOffset_ / 16 };
+		UINT numConstants[3] = { UNIFORM_RING_SLOT / 16, UNIFORM_RING_SLOT / 16, UNIFORM_RING_SLOT / 16 };
+		context1_->VSSetConstantBuffers1(0, 3, vs_cbs, firstConstant, numConstants);
+		context1_->PSSetConstantBuffers1(0, 1, vs_cbs, firstConstant, numConstants);
+		return;
+	}
+
 	ID3D11Buffer *vs_cbs[3] = { push_base, push_lights, push_bones };
 	ID3D11Buffer *ps_cbs[1] = { push_base };
 	context_->VSSetConstantBuffers(0, 3, vs_cbs);
@@ -179,15 +231,10 @@ void ShaderManagerD3D11::BindUniforms() {
 }
 
 void ShaderManagerD3D11::GetShaders(int prim, VertexDecoder *decoder, D3D11VertexShader **vshader, D3D11FragmentShader **fshader, const ComputedPipelineState &pipelineState, bool useHWTransform, bool useHWTessellation, bool weightsAsFloat, bool useSkinInDecode) {
-	VShaderID VSID;
+	VShaderID VSID = lastVSID_;
 	FShaderID FSID;
 
-	if (gstate_c.IsDirty(DIRTY_VERTEXSHADER_STATE)) {
-		gstate_c.Clean(DIRTY_VERTEXSHADER_STATE);
-		ComputeVertexShaderID(&VSID, decoder, useHWTransform, useHWTessellation, weightsAsFloat, useSkinInDecode);
-	} else {
-		VSID = lastVSID_;
-	}
+	UpdateVertexShaderID(&VSID, &lastVSStateID_, decoder, useHWTransform, useHWTessellation, weightsAsFloat, useSkinInDecode);
 
 	if (gstate_c.IsDirty(DIRTY_FRAGMENTSHADER_STATE)) {
 		gstate_c.Clean(DIRTY_FRAGMENTSHADER_STATE);
@@ -215,6 +262,7 @@ void ShaderManagerD3D11::GetShaders(int prim, VertexDecoder *decoder, D3D11Verte
 		GenerateVertexShader(VSID, codeBuffer_, draw_->GetShaderLanguageDesc(), draw_->GetBugs(), &attrMask, &uniformMask, &flags, &genErrorString);
 		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "VS length error: %d", (int)strlen(codeBuffer_));
 		vs = new D3D11VertexShader(device_, featureLevel_, VSID, codeBuffer_, useHWTransform);
+		gpuStats.numShaderCompiles++;
 		vsCache_[VSID] = vs;
 	} else {
 		vs = vsIter->second;
@@ -231,6 +279,7 @@ void ShaderManagerD3D11::GetShaders(int prim, VertexDecoder *decoder, D3D11Verte
 		GenerateFragmentShader(FSID, codeBuffer_, draw_->GetShaderLanguageDesc(), draw_->GetBugs(), &uniformMask, &flags, &genErrorString);
 		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "FS length error: %d", (int)strlen(codeBuffer_));
 		fs = new D3D11FragmentShader(device_, featureLevel_, FSID, codeBuffer_, useHWTransform);
+		gpuStats.numShaderCompiles++;
 		fsCache_[FSID] = fs;
 	} else {
 		fs = fsIter->second;
@@ -20,6 +20,7 @@
 #include <map>
 
 #include <d3d11.h>
+#include <d3d11_1.h>
 
 #include "Common/CommonTypes.h"
 #include "GPU/Common/ShaderCommon.h"
@@ -28,7 +29,7 @@
 #include "GPU/Common/FragmentShaderGenerator.h"
 
 class D3D11Context;
-class D3D11PushBuffer;
+class PushBufferD3D11;
 
 class D3D11FragmentShader {
 public:
@@ -126,14 +127,23 @@ class ShaderManagerD3D11 : public ShaderManagerCommon {
 	UB_VS_Lights ub_lights;
 	UB_VS_Bones ub_bones;
 
-	// Not actual pushbuffers, requires D3D11.1, let's try to live without that first.
+	// Not actual pushbuffers, used when we don't have D3D11.1 constant buffer offsetting.
 	ID3D11Buffer *push_base;
 	ID3D11Buffer *push_lights;
 	ID3D11Buffer *push_bones;
 
+	// With D3D11.1, the uniforms instead go into a ring, mapped with NO_OVERWRITE, and are bound by offset.
+	ID3D11DeviceContext1 *context1_ = nullptr;
+	PushBufferD3D11 *uniformPush_ = nullptr;
+	UINT baseOffset_ = 0;
+	UINT lightsOffset_ = 0;
+	UINT bonesOffset_ = 0;
+
 	D3D11FragmentShader *lastFShader_ = nullptr;
 	D3D11VertexShader *lastVShader_ = nullptr;
 
 	FShaderID lastFSID_;
 	VShaderID lastVSID_;
+	// GE state part of the vertex shader ID, reused when only the vertex format changes.
+	VShaderID lastVSStateID_;
 };
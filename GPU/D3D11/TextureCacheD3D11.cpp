@@ -254,6 +254,11 @@ void TextureCacheD3D11::BindAsClutTexture(Draw::Texture *tex, bool smooth) {
 	context_->PSSetSamplers(3, 1, smooth ? &stockD3D11.samplerLinear2DClamp : &stockD3D11.samplerPoint2DClamp);
 }
 
+void TextureCacheD3D11::BindAsClutFramebuffer(Draw::Framebuffer *fb) {
+	draw_->BindFramebufferAsTexture(fb, TEX_SLOT_CLUT, Draw::FB_COLOR_BIT, 0);
+	context_->PSSetSamplers(3, 1, &stockD3D11.samplerPoint2DClamp);
+}
+
 void TextureCacheD3D11::BuildTexture(TexCacheEntry *const entry) {
 	BuildTexturePlan plan;
 	if (!PrepareBuildTexture(plan, entry)) {
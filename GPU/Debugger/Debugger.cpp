@@ -15,6 +15,9 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
@@ -41,6 +44,12 @@ static double lastStepTime = -1.0;
 static std::vector<std::pair<int, int>> restrictPrimRanges;
 static std::string restrictPrimRule;
 
+static bool profiling = false;
+// Read from the UI thread while the GPU thread adds to them.
+static std::mutex profileLock;
+static std::unordered_map<u32, CommandCost> commandCosts;
+static std::unordered_map<u32, ListCost> listCosts;
+
 static void Init() {
 	if (!inited) {
 		GPUBreakpoints::Init([](bool flag) {
@@ -56,6 +65,7 @@ void SetActive(bool flag) {
 
 	active = flag;
 	if (!active) {
+		profiling = false;
 		breakNext = BreakNext::NONE;
 		breakAtCount = -1;
 		GPUStepping::ResumeFromStepping();
@@ -272,4 +282,86 @@ const char *GetRestrictPrims() {
 	return restrictPrimRule.c_str();
 }
 
+
+void SetProfiling(bool flag) {
+	if (flag)
+		SetActive(true);
+	profiling = flag;
+}
+
+bool IsProfiling() {
+	return profiling;
+}
+
+void ResetProfile() {
+	std::lock_guard<std::mutex> guard(profileLock);
+	commandCosts.clear();
+	listCosts.clear();
+}
+
+void NotifyCommandCost(u32 pc, u32 op, double seconds, double flushSeconds, u64 cycles) {
+	if (!profiling)
+		return;
+
+	std::lock_guard<std::mutex> guard(profileLock);
+	CommandCost &cost = commandCosts[pc];
+	// Display lists are often rebuilt in place, only keep the newest command.
+	if (cost.count == 0 || cost.op != op) {
+		cost = CommandCost{ pc, op };
+	}
+	cost.count++;
+	cost.seconds += seconds;
+	cost.flushSeconds += flushSeconds;
+	cost.cycles += cycles;
+}
+
+void NotifyListCost(u32 startpc, double seconds, u64 cycles) {
+	if (!profiling)
+		return;
+
+	std::lock_guard<std::mutex> guard(profileLock);
+	ListCost &cost = listCosts[startpc];
+	cost.startpc = startpc;
+	cost.count++;
+	cost.seconds += seconds;
+	cost.cycles += cycles;
+}
+
+bool GetCommandCost(u32 pc, CommandCost *cost) {
+	std::lock_guard<std::mutex> guard(profileLock);
+	auto it = commandCosts.find(pc);
+	if (it == commandCosts.end())
+		return false;
+	*cost = it->second;
+	return true;
+}
+
+std::vector<CommandCost> GetCommandCosts() {
+	std::vector<CommandCost> costs;
+	{
+		std::lock_guard<std::mutex> guard(profileLock);
+		costs.reserve(commandCosts.size());
+		for (const auto &it : commandCosts)
+			costs.push_back(it.second);
+	}
+	std::sort(costs.begin(), costs.end(), [](const CommandCost &a, const CommandCost &b) {
+		return a.seconds > b.seconds;
+	});
+	return costs;
+}
+
+std::vector<ListCost> GetListCosts() {
+	std::vector<ListCost> costs;
+	{
+		std::lock_guard<std::mutex> guard(profileLock);
+		costs.reserve(listCosts.size());
+		for (const auto &it : listCosts)
+			costs.push_back(it.second);
+	}
+	std::sort(costs.begin(), costs.end(), [](const ListCost &a, const ListCost &b) {
+		return a.seconds > b.seconds;
+	});
+	return costs;
+}
+
 }
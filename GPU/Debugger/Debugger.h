@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <vector>
 #include "Common/CommonTypes.h"
 
 namespace GPUDebug {
@@ -52,4 +53,37 @@ int PrimsLastFrame();
 bool SetRestrictPrims(const char *rule);
 const char *GetRestrictPrims();
 
+// Costs are summed by address across frames, until reset.
+struct CommandCost {
+	u32 pc;
+	u32 op;
+	int count;
+	// Host time running the command, including any flushes or framebuffer work it caused.
+	double seconds;
+	// Part of seconds spent flushing draws before a state change.
+	double flushSeconds;
+	// Estimated PSP GE cycles, as used for timing.
+	u64 cycles;
+};
+
+struct ListCost {
+	u32 startpc;
+	int count;
+	double seconds;
+	u64 cycles;
+};
+
+// Profiling turns on the debugger (without stepping), since per command timing needs the slow run loop.
+void SetProfiling(bool flag);
+bool IsProfiling();
+void ResetProfile();
+
+void NotifyCommandCost(u32 pc, u32 op, double seconds, double flushSeconds, u64 cycles);
+void NotifyListCost(u32 startpc, double seconds, u64 cycles);
+
+bool GetCommandCost(u32 pc, CommandCost *cost);
+// Sorted by most time first.
+std::vector<CommandCost> GetCommandCosts();
+std::vector<ListCost> GetListCosts();
+
 }
@@ -745,6 +745,38 @@ static bool ReadCompressed(u32 fp, void *dest, size_t sz, uint32_t version) {
 		return false;
 	}
 
+	if (version >= 5) {
+		// Decompress as we read, so we never hold the whole compressed blob alongside the result.
+		ZSTD_DCtx *ctx = ZSTD_createDCtx();
+		std::vector<u8> chunk(ZSTD_DStreamInSize());
+		ZSTD_outBuffer out{ dest, sz, 0 };
+		bool success = true;
+		size_t ret = 1;
+		while (compressed_size > 0 && success) {
+			u32 chunk_size = std::min(compressed_size, (u32)chunk.size());
+			if (pspFileSystem.ReadFile(fp, chunk.data(), chunk_size) != chunk_size) {
+				success = false;
+				break;
+			}
+			compressed_size -= chunk_size;
+
+			ZSTD_inBuffer in{ chunk.data(), chunk_size, 0 };
+			while (in.pos < in.size) {
+				size_t inPos = in.pos;
+				size_t outPos = out.pos;
+				ret = ZSTD_decompressStream(ctx, &out, &in);
+				// No progress means the data doesn't fit in dest, i.e. it's corrupt.
+				if (ZSTD_isError(ret) || (in.pos == inPos && out.pos == outPos)) {
+					success = false;
+					break;
+				}
+			}
+		}
+		ZSTD_freeDCtx(ctx);
+
+		return success && ret == 0 && out.pos == sz;
+	}
+
 	u8 *compressed = new u8[compressed_size];
 	if (pspFileSystem.ReadFile(fp, compressed, compressed_size) != compressed_size) {
 		delete[] compressed;
@@ -752,10 +784,7 @@ static bool ReadCompressed(u32 fp, void *dest, size_t sz, uint32_t version) {
 	}
 
 	size_t real_size = sz;
-	if (version < 5)
-		snappy_uncompress((const char *)compressed, compressed_size, (char *)dest, &real_size);
-	else
-		real_size = ZSTD_decompress(dest, real_size, compressed, compressed_size);
+	snappy_uncompress((const char *)compressed, compressed_size, (char *)dest, &real_size);
 	delete[] compressed;
 
 	return real_size == sz;
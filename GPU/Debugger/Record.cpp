@@ -20,9 +20,11 @@
 #include <cstring>
 #include <functional>
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include <mutex>
 #include <zstd.h>
+#include "ext/xxhash.h"
 
 #include "Common/CommonTypes.h"
 #include "Common/File/FileUtil.h"
@@ -59,6 +61,9 @@ static std::vector<u8> pushbuf;
 static std::vector<Command> commands;
 static std::vector<u32> lastRegisters;
 static std::vector<u32> lastTextures;
+// Content hash of each block of RAM emitted into pushbuf -> its offset, so repeated uploads
+// (the same texture or vertex data every frame) are found without scanning the whole buffer.
+static std::unordered_multimap<u64, u32> emittedBlocks;
 static std::set<u32> lastRenderTargets;
 static std::vector<u8> lastVRAM;
 
@@ -155,6 +160,7 @@ static void BeginRecording() {
 	active = true;
 	nextFrame = false;
 	lastTextures.clear();
+	emittedBlocks.clear();
 	lastRenderTargets.clear();
 	flipLastAction = gpuStats.numFlips;
 	flipFinishAt = -1;
@@ -181,15 +187,35 @@ static void BeginRecording() {
 }
 
 static void WriteCompressed(FILE *fp, const void *p, size_t sz) {
-	size_t compressed_size = ZSTD_compressBound(sz);
-	u8 *compressed = new u8[compressed_size];
-	compressed_size = ZSTD_compress(compressed, compressed_size, p, sz, 6);
-
-	u32 write_size = (u32)compressed_size;
+	// Stream it out in chunks rather than allocating a worst case buffer for the whole thing,
+	// multi-frame dumps can be hundreds of MB.  The size goes in front, so patch it after.
+	long sizePos = ftell(fp);
+	u32 write_size = 0;
 	fwrite(&write_size, sizeof(write_size), 1, fp);
-	fwrite(compressed, compressed_size, 1, fp);
 
-	delete [] compressed;
+	ZSTD_CCtx *ctx = ZSTD_createCCtx();
+	ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, 6);
+
+	std::vector<u8> chunk(ZSTD_CStreamOutSize());
+	ZSTD_inBuffer in{ p, sz, 0 };
+	size_t remaining;
+	do {
+		ZSTD_outBuffer out{ chunk.data(), chunk.size(), 0 };
+		remaining = ZSTD_compressStream2(ctx, &out, &in, ZSTD_e_end);
+		if (ZSTD_isError(remaining)) {
+			ERROR_LOG(G3D, "Failed to compress GE dump: %s", ZSTD_getErrorName(remaining));
+			break;
+		}
+		fwrite(chunk.data(), out.pos, 1, fp);
+		write_size += (u32)out.pos;
+	} while (remaining != 0);
+
+	ZSTD_freeCCtx(ctx);
+
+	long endPos = ftell(fp);
+	fseek(fp, sizePos, SEEK_SET);
+	fwrite(&write_size, sizeof(write_size), 1, fp);
+	fseek(fp, endPos, SEEK_SET);
 }
 
 static Path WriteRecording() {
@@ -292,6 +318,22 @@ static const u8 *mymemmem(const u8 *haystack, size_t off, size_t hlen, const u8
 	return result;
 }
 
+static u64 HashEmittedBlock(const void *p, u32 sz) {
+	return XXH3_64bits_withSeed(p, sz, sz);
+}
+
+static const u8 *FindEmittedBlock(u64 hash, const void *p, u32 sz, u32 align) {
+	auto range = emittedBlocks.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		u32 ptr = it->second;
+		if ((ptr & (align - 1)) != 0 || ptr + sz > pushbuf.size())
+			continue;
+		if (memcmp(pushbuf.data() + ptr, p, sz) == 0)
+			return pushbuf.data() + ptr;
+	}
+	return nullptr;
+}
+
 static Command EmitCommandWithRAM(CommandType t, const void *p, u32 sz, u32 align) {
 	FlushRegisters();
 
@@ -299,10 +341,12 @@ static Command EmitCommandWithRAM(CommandType t, const void *p, u32 sz, u32 alig
 
 	if (sz) {
 		// If at all possible, try to find it already in the buffer.
-		const u8 *prev = nullptr;
+		// Exact repeats of a previous block are the common case, check those by hash first.
+		u64 hash = HashEmittedBlock(p, sz);
+		const u8 *prev = FindEmittedBlock(hash, p, sz, align);
 		const size_t NEAR_WINDOW = std::max((int)sz * 2, 1024 * 10);
 		// Let's try nearby first... it will often be nearby.
-		if (pushbuf.size() > NEAR_WINDOW) {
+		if (!prev && pushbuf.size() > NEAR_WINDOW) {
 			prev = mymemmem(pushbuf.data(), pushbuf.size() - NEAR_WINDOW, pushbuf.size(), (const u8 *)p, sz, align);
 		}
 		if (!prev) {
@@ -323,6 +367,7 @@ static Command EmitCommandWithRAM(CommandType t, const void *p, u32 sz, u32 alig
 				memset(pushbuf.data() + cmd.ptr - pad, 0, pad);
 			}
 			memcpy(pushbuf.data() + cmd.ptr, p, sz);
+			emittedBlocks.emplace(hash, cmd.ptr);
 		}
 	}
 
@@ -450,6 +495,11 @@ static void EmitTextureData(int level, u32 texaddr) {
 		FlushRegisters();
 
 		// Dumps are huge - let's try to find this already emitted.
+		const u8 *prev = FindEmittedBlock(HashEmittedBlock(p, bytes), p, bytes, 16);
+		if (prev) {
+			commands.push_back({ type, bytes, (u32)(prev - pushbuf.data()) });
+			return;
+		}
 		for (u32 prevptr : lastTextures) {
 			if (pushbuf.size() < prevptr + bytes) {
 				continue;
@@ -620,6 +670,7 @@ static void FinishRecording() {
 	Path filename = WriteRecording();
 	commands.clear();
 	pushbuf.clear();
+	emittedBlocks.clear();
 	lastVRAM.clear();
 
 	NOTICE_LOG(SYSTEM, "Recording finished");
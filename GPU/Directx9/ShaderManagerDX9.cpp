@@ -559,13 +559,8 @@ void ShaderManagerDX9::DirtyLastShader() {
 }
 
 VSShader *ShaderManagerDX9::ApplyShader(bool useHWTransform, bool useHWTessellation, VertexDecoder *decoder, bool weightsAsFloat, bool useSkinInDecode, const ComputedPipelineState &pipelineState) {
-	VShaderID VSID;
-	if (gstate_c.IsDirty(DIRTY_VERTEXSHADER_STATE)) {
-		gstate_c.Clean(DIRTY_VERTEXSHADER_STATE);
-		ComputeVertexShaderID(&VSID, decoder, useHWTransform, useHWTessellation, weightsAsFloat, useSkinInDecode);
-	} else {
-		VSID = lastVSID_;
-	}
+	VShaderID VSID = lastVSID_;
+	UpdateVertexShaderID(&VSID, &lastVSStateID_, decoder, useHWTransform, useHWTessellation, weightsAsFloat, useSkinInDecode);
 
 	FShaderID FSID;
 	if (gstate_c.IsDirty(DIRTY_FRAGMENTSHADER_STATE)) {
@@ -598,6 +593,7 @@ VSShader *ShaderManagerDX9::ApplyShader(bool useHWTransform, bool useHWTessellat
 		VertexShaderFlags flags;
 		if (GenerateVertexShader(VSID, codeBuffer_, draw_->GetShaderLanguageDesc(), draw_->GetBugs(), &attrMask, &uniformMask, &flags, &genErrorString)) {
 			vs = new VSShader(device_, VSID, codeBuffer_, useHWTransform);
+			gpuStats.numShaderCompiles++;
 		}
 		if (!vs || vs->Failed()) {
 			auto gr = GetI18NCategory("Graphics");
@@ -624,6 +620,7 @@ VSShader *ShaderManagerDX9::ApplyShader(bool useHWTransform, bool useHWTessellat
 			bool success = GenerateVertexShader(VSID, codeBuffer_, draw_->GetShaderLanguageDesc(), draw_->GetBugs(), &attrMask, &uniformMask, &flags, &genErrorString);
 			_assert_(success);
 			vs = new VSShader(device_, VSID, codeBuffer_, false);
+			gpuStats.numShaderCompiles++;
 		}
 
 		vsCache_[VSID] = vs;
@@ -643,6 +640,7 @@ VSShader *ShaderManagerDX9::ApplyShader(bool useHWTransform, bool useHWTessellat
 		// We're supposed to handle all possible cases.
 		_assert_(success);
 		fs = new PSShader(device_, FSID, codeBuffer_);
+		gpuStats.numShaderCompiles++;
 		fsCache_[FSID] = fs;
 	} else {
 		fs = fsIter->second;
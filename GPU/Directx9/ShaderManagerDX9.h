@@ -116,6 +116,8 @@ class ShaderManagerDX9 : public ShaderManagerCommon {
 
 	FShaderID lastFSID_;
 	VShaderID lastVSID_;
+	// GE state part of the vertex shader ID, reused when only the vertex format changes.
+	VShaderID lastVSStateID_;
 
 	char *codeBuffer_;
 
@@ -24,6 +24,7 @@
 #include "Core/System.h"
 #include "Core/Config.h"
 #include "Core/CoreTiming.h"
+#include "Core/HW/Display.h"
 
 #include "Common/GPU/OpenGL/GLDebugLog.h"
 #include "Common/Profiler/Profiler.h"
@@ -256,6 +257,7 @@ void DrawEngineGLES::Invalidate(InvalidationCallbackFlags flags) {
 
 void DrawEngineGLES::DoFlush() {
 	PROFILE_THIS_SCOPE("flush");
+	FrameTimeScope frameTimeScope(FrameTimeCategory::FLUSH);
 	FrameData &frameData = frameData_[render_->GetCurFrame()];
 	
 	bool textureNeedsApply = false;
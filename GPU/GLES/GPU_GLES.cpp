@@ -298,10 +298,16 @@ void GPU_GLES::GetStats(char *buffer, size_t bufsize) {
 	bufsize -= offset;
 	if ((int)bufsize < 0)
 		return;
+	GLRenderManager *render = (GLRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
+	const GLRStallStats &stallStats = render->StallStats();
 	snprintf(buffer, bufsize,
-		"Vertex, Fragment, Programs loaded: %d, %d, %d\n",
+		"Vertex, Fragment, Programs loaded: %d, %d, %d\n"
+		"Buffer strategy %d, driver stalls: subdata %0.2f ms, map %0.2f ms, fence %0.2f ms (max frame %0.2f ms)\n",
 		shaderManagerGL_->GetNumVertexShaders(),
 		shaderManagerGL_->GetNumFragmentShaders(),
-		shaderManagerGL_->GetNumPrograms()
+		shaderManagerGL_->GetNumPrograms(),
+		(int)render->GetBufferStrategy(),
+		stallStats.lastFrameSubDataUs / 1000.0, stallStats.lastFrameMapUs / 1000.0, stallStats.lastFrameFenceUs / 1000.0,
+		stallStats.maxFrameUs / 1000.0
 	);
 }
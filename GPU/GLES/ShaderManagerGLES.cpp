@@ -32,6 +32,7 @@
 #include "Common/Math/lin/matrix4x4.h"
 #include "Common/Profiler/Profiler.h"
 #include "Common/GPU/Shader.h"
+#include "Common/GPU/ShaderCompileLog.h"
 #include "Common/GPU/thin3d.h"
 #include "Common/GPU/OpenGL/GLRenderManager.h"
 #include "Common/System/Display.h"
@@ -746,30 +747,36 @@ void ShaderManagerGLES::DirtyLastShader() {
 	lastVShaderSame_ = false;
 }
 
-Shader *ShaderManagerGLES::CompileFragmentShader(FShaderID FSID) {
+Shader *ShaderManagerGLES::CompileFragmentShader(FShaderID FSID, bool precompile) {
 	uint64_t uniformMask;
 	std::string errorString;
 	FragmentShaderFlags flags;
+	double start = time_now_d();
 	if (!GenerateFragmentShader(FSID, codeBuffer_, draw_->GetShaderLanguageDesc(), draw_->GetBugs(), &uniformMask, &flags, &errorString)) {
 		ERROR_LOG(G3D, "Shader gen error: %s", errorString.c_str());
 		return nullptr;
 	}
+	if (ShaderCompileLog_IsActive())
+		ShaderCompileLog_Record(ShaderCompileStage::FRAGMENT_GEN, ShaderCompileLog_HexID(&FSID, sizeof(FSID)), time_now_d() - start, !precompile);
 	_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "FS length error: %d", (int)strlen(codeBuffer_));
 	std::string desc = FragmentShaderDesc(FSID);
 	ShaderDescGLES params{ GL_FRAGMENT_SHADER, 0, uniformMask };
 	return new Shader(render_, codeBuffer_, desc, params);
 }
 
-Shader *ShaderManagerGLES::CompileVertexShader(VShaderID VSID) {
+Shader *ShaderManagerGLES::CompileVertexShader(VShaderID VSID, bool precompile) {
 	bool useHWTransform = VSID.Bit(VS_BIT_USE_HW_TRANSFORM);
 	uint32_t attrMask;
 	uint64_t uniformMask;
 	std::string errorString;
 	VertexShaderFlags flags;
+	double start = time_now_d();
 	if (!GenerateVertexShader(VSID, codeBuffer_, draw_->GetShaderLanguageDesc(), draw_->GetBugs(), &attrMask, &uniformMask, &flags, &errorString)) {
 		ERROR_LOG(G3D, "Shader gen error: %s", errorString.c_str());
 		return nullptr;
 	}
+	if (ShaderCompileLog_IsActive())
+		ShaderCompileLog_Record(ShaderCompileStage::VERTEX_GEN, ShaderCompileLog_HexID(&VSID, sizeof(VSID)), time_now_d() - start, !precompile);
 	_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "VS length error: %d", (int)strlen(codeBuffer_));
 	std::string desc = VertexShaderDesc(VSID);
 	ShaderDescGLES params{ GL_VERTEX_SHADER, attrMask, uniformMask };
@@ -778,12 +785,8 @@ Shader *ShaderManagerGLES::CompileVertexShader(VShaderID VSID) {
 }
 
 Shader *ShaderManagerGLES::ApplyVertexShader(bool useHWTransform, bool useHWTessellation, VertexDecoder *decoder, bool weightsAsFloat, bool useSkinInDecode, VShaderID *VSID) {
-	if (gstate_c.IsDirty(DIRTY_VERTEXSHADER_STATE)) {
-		gstate_c.Clean(DIRTY_VERTEXSHADER_STATE);
-		ComputeVertexShaderID(VSID, decoder, useHWTransform, useHWTessellation, weightsAsFloat, useSkinInDecode);
-	} else {
-		*VSID = lastVSID_;
-	}
+	*VSID = lastVSID_;
+	UpdateVertexShaderID(VSID, &lastVSStateID_, decoder, useHWTransform, useHWTessellation, weightsAsFloat, useSkinInDecode);
 
 	if (lastShader_ != nullptr && *VSID == lastVSID_) {
 		lastVShaderSame_ = true;
@@ -797,6 +800,7 @@ Shader *ShaderManagerGLES::ApplyVertexShader(bool useHWTransform, bool useHWTess
 	if (!vs)	{
 		// Vertex shader not in cache. Let's compile it.
 		vs = CompileVertexShader(*VSID);
+		gpuStats.numShaderCompiles++;
 		if (!vs || vs->Failed()) {
 			auto gr = GetI18NCategory("Graphics");
 			ERROR_LOG(G3D, "Vertex shader generation failed, falling back to software transform");
@@ -813,6 +817,7 @@ Shader *ShaderManagerGLES::ApplyVertexShader(bool useHWTransform, bool useHWTess
 			VShaderID vsidTemp;
 			ComputeVertexShaderID(&vsidTemp, decoder, false, false, weightsAsFloat, true);
 			vs = CompileVertexShader(vsidTemp);
+			gpuStats.numShaderCompiles++;
 		}
 
 		vsCache_.Insert(*VSID, vs);
@@ -851,6 +856,7 @@ LinkedShader *ShaderManagerGLES::ApplyFragmentShader(VShaderID VSID, Shader *vs,
 		// Can't really tell if we succeeded since the compile is on the GPU thread later.
 		// Could fail to generate, in which case we're kinda screwed.
 		fs = CompileFragmentShader(FSID);
+		gpuStats.numShaderCompiles++;
 		fsCache_.Insert(FSID, fs);
 		diskCacheDirty_ = true;
 	}
@@ -874,6 +880,7 @@ LinkedShader *ShaderManagerGLES::ApplyFragmentShader(VShaderID VSID, Shader *vs,
 
 		// Check if we can link these.
 		ls = new LinkedShader(render_, VSID, vs, FSID, fs, vs->UseHWTransform());
+		gpuStats.numPipelineCreations++;
 		ls->use(VSID);
 		const LinkedShaderCacheEntry entry(vs, fs, ls);
 		linkedShaderCache_.push_back(entry);
@@ -1076,7 +1083,7 @@ bool ShaderManagerGLES::ContinuePrecompile(float sliceTime) {
 				return false;
 			}
 
-			Shader *vs = CompileVertexShader(id);
+			Shader *vs = CompileVertexShader(id, true);
 			if (vs->Failed()) {
 				// Give up on using the cache, just bail. We can't safely create the fallback shaders here
 				// without trying to deduce the vertType from the VSID.
@@ -1099,7 +1106,7 @@ bool ShaderManagerGLES::ContinuePrecompile(float sliceTime) {
 
 		const FShaderID &id = pending.frag[i];
 		if (!fsCache_.Get(id)) {
-			fsCache_.Insert(id, CompileFragmentShader(id));
+			fsCache_.Insert(id, CompileFragmentShader(id, true));
 		} else {
 			WARN_LOG(G3D, "Duplicate fragment shader found in GL shader cache, ignoring");
 		}
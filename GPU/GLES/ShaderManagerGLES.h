@@ -193,8 +193,9 @@ class ShaderManagerGLES : public ShaderManagerCommon {
 
 private:
 	void Clear();
-	Shader *CompileFragmentShader(FShaderID id);
-	Shader *CompileVertexShader(VShaderID id);
+	// precompile is only used to tell the compile log this isn't stalling a frame.
+	Shader *CompileFragmentShader(FShaderID id, bool precompile = false);
+	Shader *CompileVertexShader(VShaderID id, bool precompile = false);
 
 	struct LinkedShaderCacheEntry {
 		LinkedShaderCacheEntry(Shader *vs_, Shader *fs_, LinkedShader *ls_)
@@ -213,6 +214,8 @@ class ShaderManagerGLES : public ShaderManagerCommon {
 
 	FShaderID lastFSID_;
 	VShaderID lastVSID_;
+	// GE state part of the vertex shader ID, reused when only the vertex format changes.
+	VShaderID lastVSStateID_;
 
 	LinkedShader *lastShader_ = nullptr;
 	u64 shaderSwitchDirtyUniforms_ = 0;
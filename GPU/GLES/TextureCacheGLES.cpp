@@ -228,6 +228,11 @@ void TextureCacheGLES::BindAsClutTexture(Draw::Texture *tex, bool smooth) {
 	render_->SetTextureSampler(TEX_SLOT_CLUT, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, smooth ? GL_LINEAR : GL_NEAREST, smooth ? GL_LINEAR : GL_NEAREST, 0.0f);
 }
 
+void TextureCacheGLES::BindAsClutFramebuffer(Draw::Framebuffer *fb) {
+	draw_->BindFramebufferAsTexture(fb, TEX_SLOT_CLUT, Draw::FB_COLOR_BIT, 0);
+	render_->SetTextureSampler(TEX_SLOT_CLUT, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST, 0.0f);
+}
+
 void TextureCacheGLES::BuildTexture(TexCacheEntry *const entry) {
 	BuildTexturePlan plan;
 	if (!PrepareBuildTexture(plan, entry)) {
@@ -63,6 +63,7 @@ class TextureCacheGLES : public TextureCacheCommon {
 	void ReleaseTexture(TexCacheEntry *entry, bool delete_them) override;
 
 	void BindAsClutTexture(Draw::Texture *tex, bool smooth) override;
+	void BindAsClutFramebuffer(Draw::Framebuffer *fb) override;
 	void *GetNativeTextureView(const TexCacheEntry *entry) override;
 
 private:
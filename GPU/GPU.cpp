@@ -21,6 +21,7 @@
 #include "Common/GraphicsContext.h"
 #include "Core/Core.h"
 
+#include "Common/Data/Collections/LinearArena.h"
 #include "GPU/GPU.h"
 #include "GPU/GPUInterface.h"
 
@@ -39,6 +40,7 @@
 #endif
 
 GPUStatistics gpuStats;
+LinearArena gpuFrameArena;
 GPUInterface *gpu;
 GPUDebugInterface *gpuDebug;
 
@@ -88,10 +88,23 @@ struct GPUStatistics {
 		numTextureDataBytesHashed = 0;
 		numShaderSwitches = 0;
 		numFlushes = 0;
+		numFlushesStateChange = 0;
+		numFlushesPrimChange = 0;
+		numFlushesBufferFull = 0;
+		numCulledDraws = 0;
+		numSkippedStaticLists = 0;
 		numTexturesDecoded = 0;
+		numTextureCacheHits = 0;
+		numTextureCacheMisses = 0;
+		numShaderCompiles = 0;
+		numPipelineCreations = 0;
+		numTextureDataBytesUploaded = 0;
+		numFramebufferCreations = 0;
+		numRenderTargetSwitches = 0;
 		numFramebufferEvaluations = 0;
 		numBlockingReadbacks = 0;
 		numReadbacks = 0;
+		numDelayedReadbacks = 0;
 		numUploads = 0;
 		numDepal = 0;
 		numClears = 0;
@@ -111,6 +124,12 @@ struct GPUStatistics {
 	int numListSyncs;
 	int numCachedDrawCalls;
 	int numFlushes;
+	// Flushes with pending draws, by cause. The rest are from transfers, framebuffer changes, etc.
+	int numFlushesStateChange;
+	int numFlushesPrimChange;
+	int numFlushesBufferFull;
+	int numCulledDraws;
+	int numSkippedStaticLists;
 	int numVertsSubmitted;
 	int numCachedVertsDrawn;
 	int numUncachedVertsDrawn;
@@ -122,9 +141,17 @@ struct GPUStatistics {
 	int numTextureSwitches;
 	int numShaderSwitches;
 	int numTexturesDecoded;
+	int numTextureCacheHits;
+	int numTextureCacheMisses;
+	int numShaderCompiles;
+	int numPipelineCreations;
+	int numTextureDataBytesUploaded;
+	int numFramebufferCreations;
+	int numRenderTargetSwitches;
 	int numFramebufferEvaluations;
 	int numBlockingReadbacks;
 	int numReadbacks;
+	int numDelayedReadbacks;
 	int numUploads;
 	int numDepal;
 	int numClears;
@@ -142,6 +169,9 @@ struct GPUStatistics {
 };
 
 extern GPUStatistics gpuStats;
+// Scratch memory for the GPU thread that only needs to live until the next frame. Reset in BeginFrame.
+class LinearArena;
+extern LinearArena gpuFrameArena;
 extern GPUInterface *gpu;
 extern GPUDebugInterface *gpuDebug;
 
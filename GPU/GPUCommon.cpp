@@ -15,6 +15,7 @@
 
 #include "Common/Profiler/Profiler.h"
 
+#include "Common/Data/Collections/LinearArena.h"
 #include "Common/GraphicsContext.h"
 #include "Common/LogReporting.h"
 #include "Common/Serialize/Serializer.h"
@@ -42,8 +43,10 @@
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
 #include "GPU/Common/TextureCacheCommon.h"
+#include "GPU/Common/TextureDecoder.h"
 #include "GPU/Debugger/Debugger.h"
 #include "GPU/Debugger/Record.h"
+#include "ext/xxhash.h"
 
 void GPUCommon::Flush() {
 	drawEngineCommon_->DispatchFlush();
@@ -109,6 +112,7 @@ void GPUCommon::Reinitialize() {
 	busyTicks = 0;
 	timeSpentStepping_ = 0.0;
 	interruptsEnabled_ = true;
+	ClearStaticLists();
 
 	if (textureCache_)
 		textureCache_->Clear(true);
@@ -222,6 +226,7 @@ void GPUCommon::CheckConfigChanged() {
 		drawEngineCommon_->NotifyConfigChanged();
 		textureCache_->NotifyConfigChanged();
 		framebufferManager_->NotifyConfigChanged();
+		ClearStaticLists();
 		BuildReportingInfo();
 		configChanged_ = false;
 	}
@@ -674,12 +679,12 @@ u32 GPUCommon::Break(int mode) {
 }
 
 void GPUCommon::NotifySteppingEnter() {
-	if (coreCollectDebugStats) {
+	if (coreCollectDebugStats || GPUDebug::IsProfiling()) {
 		timeSteppingStarted_ = time_now_d();
 	}
 }
 void GPUCommon::NotifySteppingExit() {
-	if (coreCollectDebugStats) {
+	if (coreCollectDebugStats || GPUDebug::IsProfiling()) {
 		if (timeSteppingStarted_ <= 0.0) {
 			ERROR_LOG(G3D, "Mismatched stepping enter/exit.");
 		}
@@ -691,11 +696,15 @@ void GPUCommon::NotifySteppingExit() {
 }
 
 bool GPUCommon::InterpretList(DisplayList &list) {
+	PROFILE_THIS_SCOPE("gelist");
+	FrameTimeScope frameTimeScope(FrameTimeCategory::GE);
 	// Initialized to avoid a race condition with bShowDebugStats changing.
 	double start = 0.0;
-	if (coreCollectDebugStats) {
+	const bool profiling = GPUDebug::IsProfiling();
+	if (coreCollectDebugStats || profiling) {
 		start = time_now_d();
 	}
+	const int startCycles = cyclesExecuted;
 
 	if (list.state == PSP_GE_DL_STATE_PAUSED)
 		return false;
@@ -724,6 +733,7 @@ bool GPUCommon::InterpretList(DisplayList &list) {
 	// To enable breakpoints, we don't do fast matrix loads while debugger active.
 	debugRecording_ = GPUDebug::IsActive() || GPURecord::IsActive();
 	const bool useFastRunLoop = !dumpThisFrame_ && !debugRecording_;
+	UpdateStaticList(list);
 	while (gpuState == GPUSTATE_RUNNING) {
 		{
 			if (list.pc == list.stall) {
@@ -757,21 +767,28 @@ bool GPUCommon::InterpretList(DisplayList &list) {
 		UpdatePC(list.pc - 4, list.pc);
 	}
 
+	if (staticRecording_ || staticReplaying_)
+		EndStaticList(list);
+
 	list.offsetAddr = gstate_c.offsetAddr;
 
+	if (profiling) {
+		GPUDebug::NotifyListCost(list.startpc, time_now_d() - start - timeSpentStepping_, cyclesExecuted - startCycles);
+	}
 	if (coreCollectDebugStats) {
 		double total = time_now_d() - start - timeSpentStepping_;
 		_dbg_assert_msg_(total >= 0.0, "Time spent DL processing became negative");
 		hleSetSteppingTime(timeSpentStepping_);
 		DisplayNotifySleep(timeSpentStepping_);
-		timeSpentStepping_ = 0.0;
 		gpuStats.msProcessingDisplayLists += total;
 	}
+	timeSpentStepping_ = 0.0;
 	return gpuState == GPUSTATE_DONE || gpuState == GPUSTATE_ERROR;
 }
 
 void GPUCommon::BeginFrame() {
 	immCount_ = 0;
+	gpuFrameArena.Reset();
 	if (dumpNextFrame_) {
 		NOTICE_LOG(G3D, "DUMPING THIS FRAME");
 		dumpThisFrame_ = true;
@@ -785,15 +802,23 @@ void GPUCommon::BeginFrame() {
 
 void GPUCommon::SlowRunLoop(DisplayList &list) {
 	const bool dumpThisFrame = dumpThisFrame_;
+	const bool profiling = GPUDebug::IsProfiling();
 	while (downcount > 0) {
 		bool process = GPUDebug::NotifyCommand(list.pc);
 		if (process) {
 			GPURecord::NotifyCommand(list.pc);
+			const u32 pc = list.pc;
 			u32 op = Memory::ReadUnchecked_U32(list.pc);
 			u32 cmd = op >> 24;
 
+			// Jumps and prims change these, so grab them first.
+			double opStart = profiling ? time_now_d() : 0.0;
+			const double steppingStart = timeSpentStepping_;
+			const int cyclesStart = cyclesExecuted;
+
 			u32 diff = op ^ gstate.cmdmem[cmd];
 			PreExecuteOp(op, diff);
+			double flushEnd = profiling ? time_now_d() : 0.0;
 			if (dumpThisFrame) {
 				char temp[256];
 				u32 prev;
@@ -808,6 +833,12 @@ void GPUCommon::SlowRunLoop(DisplayList &list) {
 			gstate.cmdmem[cmd] = op;
 
 			ExecuteOp(op, diff);
+
+			if (profiling) {
+				// Don't count time waiting in the debugger, when stepping by draw.
+				double seconds = time_now_d() - opStart - (timeSpentStepping_ - steppingStart);
+				GPUDebug::NotifyCommandCost(pc, op, seconds, flushEnd - opStart, cyclesExecuted - cyclesStart);
+			}
 		}
 
 		list.pc += 4;
@@ -822,6 +853,13 @@ void GPUCommon::UpdatePC(u32 currentPC, u32 newPC) {
 	cyclesExecuted += 2 * executed;
 	cycleLastPC = newPC;
 
+	// Anything but a short skip ahead is a jump, call or return, so a new range of commands starts.
+	if (staticRecording_ && (newPC < currentPC || newPC > currentPC + 0x1000)) {
+		if (currentPC >= staticSegmentStart_)
+			AddStaticListRange(staticSegmentStart_, currentPC + 4 - staticSegmentStart_);
+		staticSegmentStart_ = newPC;
+	}
+
 	// Exit the runloop and recalculate things.  This happens a lot in some games.
 	if (currentList)
 		downcount = currentList->stall == 0 ? 0x0FFFFFFF : (currentList->stall - newPC) / 4;
@@ -829,6 +867,198 @@ void GPUCommon::UpdatePC(u32 currentPC, u32 newPC) {
 		downcount = 0;
 }
 
+static u64 ComputeStaticListStateHash() {
+	const u64 hash = XXH3_64bits(&gstate, sizeof(gstate));
+	const u32 addrs[3] = { gstate_c.vertexAddr, gstate_c.indexAddr, gstate_c.offsetAddr };
+	return XXH3_64bits_withSeed(addrs, sizeof(addrs), hash);
+}
+
+void GPUCommon::UpdateStaticList(const DisplayList &list) {
+	if (staticMode_ != StaticListMode::NONE && list.id != staticListId_) {
+		// If another list runs while recording, we can't tell what it did to our targets.
+		// A replayed list keeps going if it's just paused, but it might also have been dequeued.
+		const DisplayListState state = dls[staticListId_].state;
+		if (staticMode_ == StaticListMode::RECORDING || state == PSP_GE_DL_STATE_COMPLETED || state == PSP_GE_DL_STATE_NONE) {
+			staticMode_ = StaticListMode::NONE;
+			staticListId_ = -1;
+			staticReplayRecord_ = nullptr;
+		}
+	}
+
+	// Only from the start, and not if it's just been enqueued with nothing to run yet.
+	if (staticMode_ == StaticListMode::NONE && list.pc == list.startpc && list.pc != list.stall) {
+		if (g_Config.bSkipStaticDisplayLists && framebufferManager_ && !debugRecording_ && !dumpThisFrame_)
+			BeginStaticList(list);
+	}
+
+	staticRecording_ = staticMode_ == StaticListMode::RECORDING && list.id == staticListId_;
+	staticReplaying_ = staticMode_ == StaticListMode::REPLAYING && list.id == staticListId_;
+	if (staticRecording_)
+		staticSegmentStart_ = list.pc;
+}
+
+void GPUCommon::BeginStaticList(const DisplayList &list) {
+	const u64 stateHash = ComputeStaticListStateHash();
+
+	auto matches = [&](const StaticListRecord &record) {
+		if (record.stateHash != stateHash)
+			return false;
+		// The whole list has to be there already, we can't check what the game hasn't written yet.
+		if (list.stall != 0 && list.stall < record.endpc)
+			return false;
+		// Anything else drawing to a target since means we'd have to draw again.
+		for (const StaticListTarget &target : record.targets) {
+			if (framebufferManager_->GetColorBindSeqAt(target.fbAddress) != target.bindSeq)
+				return false;
+		}
+		for (const StaticListRange &range : record.ranges) {
+			if (!Memory::IsValidRange(range.addr, range.size))
+				return false;
+			if (XXH3_64bits(Memory::GetPointerUnchecked(range.addr), range.size) != range.hash)
+				return false;
+		}
+		return true;
+	};
+
+	staticListId_ = list.id;
+	staticListStart_ = list.startpc;
+
+	auto it = staticLists_.find(list.startpc);
+	if (it != staticLists_.end()) {
+		for (StaticListRecord &record : it->second) {
+			if (matches(record)) {
+				record.lastUsed = ++staticListCounter_;
+				staticReplayRecord_ = &record;
+				staticMode_ = StaticListMode::REPLAYING;
+				return;
+			}
+		}
+	}
+
+	staticMode_ = StaticListMode::RECORDING;
+	staticRecordFailed_ = false;
+	staticRecord_.stateHash = stateHash;
+	staticRecord_.ranges.clear();
+	staticRecord_.targets.clear();
+}
+
+void GPUCommon::EndStaticList(const DisplayList &list) {
+	if (staticRecording_ && list.pc > staticSegmentStart_)
+		AddStaticListRange(staticSegmentStart_, list.pc - staticSegmentStart_);
+
+	// Otherwise, it's stalled or paused and we'll keep going next time.
+	if (gpuState != GPUSTATE_DONE && gpuState != GPUSTATE_ERROR)
+		return;
+
+	if (gpuState == GPUSTATE_ERROR) {
+		// Don't keep anything around.
+	} else if (staticReplaying_) {
+		// The output is still there, but presentation needs to know it was "drawn" this frame.
+		for (const StaticListTarget &target : staticReplayRecord_->targets)
+			framebufferManager_->NotifyRenderSkipped(target.fbAddress, gstate_c.skipDrawReason);
+		gpuStats.numSkippedStaticLists++;
+	} else if (!staticRecordFailed_ && !staticRecord_.targets.empty()) {
+		for (StaticListTarget &target : staticRecord_.targets)
+			target.bindSeq = framebufferManager_->GetColorBindSeqAt(target.fbAddress);
+		staticRecord_.endpc = list.pc;
+		staticRecord_.lastUsed = ++staticListCounter_;
+
+		if (staticLists_.size() >= 256)
+			staticLists_.clear();
+		// Keep a few per list, for games that alternate between buffers.
+		std::vector<StaticListRecord> &records = staticLists_[staticListStart_];
+		if (records.size() >= 4) {
+			auto oldest = std::min_element(records.begin(), records.end(), [](const StaticListRecord &a, const StaticListRecord &b) {
+				return a.lastUsed < b.lastUsed;
+			});
+			*oldest = std::move(staticRecord_);
+		} else {
+			records.push_back(std::move(staticRecord_));
+		}
+		staticRecord_ = StaticListRecord();
+	}
+
+	staticMode_ = StaticListMode::NONE;
+	staticListId_ = -1;
+	staticReplayRecord_ = nullptr;
+	staticRecording_ = false;
+	staticReplaying_ = false;
+}
+
+void GPUCommon::RecordStaticListDraw(const VirtualFramebuffer *vfb, u32 vertType, int count, int bytesRead) {
+	if (!staticRecording_ || staticRecordFailed_)
+		return;
+
+	if ((vertType & GE_VTYPE_IDX_MASK) != GE_VTYPE_IDX_NONE) {
+		const int indexShift = ((vertType & GE_VTYPE_IDX_MASK) >> GE_VTYPE_IDX_SHIFT) - 1;
+		const u32 indexBytes = count << indexShift;
+		if (!Memory::IsValidRange(gstate_c.indexAddr, indexBytes)) {
+			AbortStaticListRecording();
+			return;
+		}
+		u16 lowerBound, upperBound;
+		GetIndexBounds(Memory::GetPointerUnchecked(gstate_c.indexAddr), count, vertType, &lowerBound, &upperBound);
+		AddStaticListRange(gstate_c.indexAddr, indexBytes);
+		AddStaticListRange(gstate_c.vertexAddr, (upperBound + 1) * (bytesRead / count));
+	} else {
+		AddStaticListRange(gstate_c.vertexAddr, bytesRead);
+	}
+
+	if (gstate.isTextureMapEnabled() && !gstate.isModeClear()) {
+		const GETextureFormat format = gstate.getTextureFormat();
+		const int maxLevel = gstate.getTextureMaxLevel();
+		for (int level = 0; level <= maxLevel; ++level) {
+			const u32 texaddr = gstate.getTextureAddress(level);
+			const u32 bufw = GetTextureBufw(level, texaddr, format);
+			const u32 bytes = (textureBitsPerPixel[format] * bufw * gstate.getTextureHeight(level)) / 8;
+			// Render to texture can change without the memory changing.
+			if (framebufferManager_->MayOverlapFramebuffer(texaddr, bytes)) {
+				AbortStaticListRecording();
+				return;
+			}
+			AddStaticListRange(texaddr, bytes);
+		}
+		if (IsClutFormat(format))
+			AddStaticListRange(gstate.getClutAddress(), gstate.getClutLoadBytes());
+	}
+
+	if (vfb) {
+		for (const StaticListTarget &target : staticRecord_.targets) {
+			if (target.fbAddress == vfb->fb_address)
+				return;
+		}
+		staticRecord_.targets.push_back(StaticListTarget{ vfb->fb_address, -1 });
+	}
+}
+
+void GPUCommon::AddStaticListRange(u32 addr, u32 size) {
+	if (!staticRecording_ || staticRecordFailed_ || size == 0)
+		return;
+
+	std::vector<StaticListRange> &ranges = staticRecord_.ranges;
+	// Draws tend to reuse the same textures and buffers, no need to hash those again.
+	const size_t checkFrom = ranges.size() > 8 ? ranges.size() - 8 : 0;
+	for (size_t i = checkFrom; i < ranges.size(); ++i) {
+		if (ranges[i].addr == addr && ranges[i].size == size)
+			return;
+	}
+
+	if (ranges.size() >= 4096 || !Memory::IsValidRange(addr, size)) {
+		AbortStaticListRecording();
+		return;
+	}
+	ranges.push_back(StaticListRange{ addr, size, XXH3_64bits(Memory::GetPointerUnchecked(addr), size) });
+}
+
+void GPUCommon::ClearStaticLists() {
+	staticLists_.clear();
+	staticMode_ = StaticListMode::NONE;
+	staticListId_ = -1;
+	staticReplayRecord_ = nullptr;
+	staticRecording_ = false;
+	staticReplaying_ = false;
+}
+
 void GPUCommon::ReapplyGfxState() {
 	// The commands are embedded in the command memory so we can just reexecute the words. Convenient.
 	// To be safe we pass 0xFFFFFFFF as the diff.
@@ -1238,6 +1468,8 @@ void GPUCommon::Execute_BoundingBox(u32 op, u32 diff) {
 		currentList->bboxResult = false;
 		return;
 	}
+	// The result depends on vertex data we don't track.
+	AbortStaticListRecording();
 
 	// Approximate based on timings of several counts on a PSP.
 	cyclesExecuted += count * 22;
@@ -1348,6 +1580,7 @@ void GPUCommon::Execute_ImmVertexAlphaPrim(u32 op, u32 diff) {
 void GPUCommon::FlushImm() {
 	if (immCount_ == 0 || immPrim_ == GE_PRIM_INVALID)
 		return;
+	AbortStaticListRecording();
 
 	SetDrawType(DRAW_PRIM, immPrim_);
 	if (framebufferManager_)
@@ -1428,6 +1661,7 @@ void GPUCommon::FastLoadBoneMatrix(u32 target) {
 		gstate_c.deferredVertTypeDirty |= uniformsToDirty;
 	}
 	gstate.FastLoadBoneMatrix(target);
+	AddStaticListRange(target, 13 * 4);
 
 	cyclesExecuted += 2 * 14;  // one to reset the counter, 12 to load the matrix, and a return.
 
@@ -1558,6 +1792,10 @@ void GPUCommon::DoState(PointerWrap &p) {
 	if (s >= 6) {
 		Do(p, edramTranslation_);
 	}
+
+	// Framebuffers get recreated, and the memory might not match anymore.
+	if (p.mode == PointerWrap::MODE_READ)
+		ClearStaticLists();
 }
 
 void GPUCommon::InterruptStart(int listid) {
@@ -1715,6 +1953,8 @@ void GPUCommon::SetCmdValue(u32 op) {
 }
 
 void GPUCommon::DoBlockTransfer(u32 skipDrawReason) {
+	AbortStaticListRecording();
+
 	u32 srcBasePtr = gstate.getTransferSrcAddress();
 	u32 srcStride = gstate.getTransferSrcStride();
 
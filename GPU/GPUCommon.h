@@ -1,6 +1,10 @@
 #pragma once
 
 #include "ppsspp_config.h"
+
+#include <unordered_map>
+#include <vector>
+
 #include "Common/Common.h"
 #include "Common/MemoryUtil.h"
 #include "GPU/GPUInterface.h"
@@ -271,6 +275,18 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 		}
 	}
 
+	// See bSkipStaticDisplayLists. Records what a list read while drawing, and skips its draws when
+	// it runs again with the same state and data, and its targets haven't been drawn to since.
+	void UpdateStaticList(const DisplayList &list);
+	void BeginStaticList(const DisplayList &list);
+	void EndStaticList(const DisplayList &list);
+	void RecordStaticListDraw(const VirtualFramebuffer *vfb, u32 vertType, int count, int bytesRead);
+	void AddStaticListRange(u32 addr, u32 size);
+	void AbortStaticListRecording() {
+		staticRecordFailed_ = true;
+	}
+	void ClearStaticLists();
+
 	virtual void BuildReportingInfo() = 0;
 
 	virtual void UpdateMSAALevel(Draw::DrawContext *draw) {}
@@ -329,6 +345,42 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 
 	uint32_t edramTranslation_ = 0x400;
 
+	struct StaticListRange {
+		u32 addr;
+		u32 size;
+		u64 hash;
+	};
+	struct StaticListTarget {
+		u32 fbAddress;
+		int bindSeq;
+	};
+	struct StaticListRecord {
+		u64 stateHash;
+		u32 endpc;
+		int lastUsed;
+		std::vector<StaticListRange> ranges;
+		std::vector<StaticListTarget> targets;
+	};
+	enum class StaticListMode {
+		NONE,
+		RECORDING,
+		REPLAYING,
+	};
+
+	// Keyed by list start address, a few per list for double buffering.
+	std::unordered_map<u32, std::vector<StaticListRecord>> staticLists_;
+	StaticListRecord staticRecord_;
+	StaticListMode staticMode_ = StaticListMode::NONE;
+	int staticListId_ = -1;
+	u32 staticListStart_ = 0;
+	u32 staticSegmentStart_ = 0;
+	const StaticListRecord *staticReplayRecord_ = nullptr;
+	int staticListCounter_ = 0;
+	bool staticRecordFailed_ = false;
+	// Whether the list currently being interpreted is being recorded or replayed.
+	bool staticRecording_ = false;
+	bool staticReplaying_ = false;
+
 	// When matrix data overflows, the CPU visible values wrap and bleed between matrices.
 	// But this doesn't actually change the values used by rendering.
 	// The CPU visible values affect the GPU when list contexts are restored.
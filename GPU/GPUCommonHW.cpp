@@ -1,11 +1,13 @@
 #include "Common/Profiler/Profiler.h"
 
+#include "Common/GPU/ShaderCompileLog.h"
 #include "Common/GPU/thin3d.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/System/System.h"
 
 #include "Core/System.h"
 #include "Core/Config.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/Util/PPGeDraw.h"
 
 #include "GPU/GPUCommonHW.h"
@@ -81,8 +83,8 @@ const CommonCommandTableEntry commonCommandTable[] = {
 	{ GE_CMD_TEXSHADELS, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE },
 	// Raster state for Direct3D 9, uncommon.
 	{ GE_CMD_SHADEMODE, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE | DIRTY_RASTER_STATE },
-	{ GE_CMD_TEXFUNC, FLAG_FLUSHBEFOREONCHANGE, DIRTY_FRAGMENTSHADER_STATE | DIRTY_TEX_ALPHA_MUL },
-	{ GE_CMD_COLORTEST, FLAG_FLUSHBEFOREONCHANGE, DIRTY_FRAGMENTSHADER_STATE },
+	{ GE_CMD_TEXFUNC, FLAG_FLUSHBEFOREONCHANGE, DIRTY_FRAGMENTSHADER_STATE | DIRTY_TEX_ALPHA_MUL | DIRTY_FRAGMENT_UBER_CONTROL },
+	{ GE_CMD_COLORTEST, FLAG_FLUSHBEFOREONCHANGE, DIRTY_FRAGMENTSHADER_STATE | DIRTY_FRAGMENT_UBER_CONTROL },
 	{ GE_CMD_ALPHATESTENABLE, FLAG_FLUSHBEFOREONCHANGE, DIRTY_FRAGMENTSHADER_STATE },
 	{ GE_CMD_COLORTESTENABLE, FLAG_FLUSHBEFOREONCHANGE, DIRTY_FRAGMENTSHADER_STATE },
 	{ GE_CMD_COLORTESTMASK, FLAG_FLUSHBEFOREONCHANGE, DIRTY_ALPHACOLORMASK | DIRTY_FRAGMENTSHADER_STATE },
@@ -107,7 +109,7 @@ const CommonCommandTableEntry commonCommandTable[] = {
 	{ GE_CMD_TEXWRAP, FLAG_FLUSHBEFOREONCHANGE, DIRTY_TEXTURE_PARAMS | DIRTY_FRAGMENTSHADER_STATE },
 
 	// Uniform changes. though the fragmentshader optimizes based on these sometimes.
-	{ GE_CMD_ALPHATEST, FLAG_FLUSHBEFOREONCHANGE, DIRTY_ALPHACOLORREF | DIRTY_ALPHACOLORMASK | DIRTY_FRAGMENTSHADER_STATE },
+	{ GE_CMD_ALPHATEST, FLAG_FLUSHBEFOREONCHANGE, DIRTY_ALPHACOLORREF | DIRTY_ALPHACOLORMASK | DIRTY_FRAGMENTSHADER_STATE | DIRTY_FRAGMENT_UBER_CONTROL },
 	{ GE_CMD_COLORREF, FLAG_FLUSHBEFOREONCHANGE, DIRTY_ALPHACOLORREF | DIRTY_FRAGMENTSHADER_STATE },
 	{ GE_CMD_TEXENVCOLOR, FLAG_FLUSHBEFOREONCHANGE, DIRTY_TEXENV },
 
@@ -387,9 +389,16 @@ GPUCommonHW::GPUCommonHW(GraphicsContext *gfxCtx, Draw::DrawContext *draw) : GPU
 
 	UpdateCmdInfo();
 	UpdateMSAALevel(draw);
+
+	std::string discID = g_paramSFO.GetDiscID();
+	if (g_Config.bShaderCompileLog && !discID.empty()) {
+		ShaderCompileLog_Start(GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".shadercompile.csv"));
+	}
 }
 
 GPUCommonHW::~GPUCommonHW() {
+	ShaderCompileLog_Stop();
+
 	// Clear features so they're not visible in system info.
 	gstate_c.SetUseFlags(0);
 
@@ -495,6 +504,8 @@ void GPUCommonHW::CheckFlushOp(int cmd, u32 diff) {
 		if (dumpThisFrame_) {
 			NOTICE_LOG(G3D, "================ FLUSH ================");
 		}
+		if (drawEngineCommon_->GetNumDrawCalls())
+			gpuStats.numFlushesStateChange++;
 		drawEngineCommon_->DispatchFlush();
 	}
 }
@@ -812,6 +823,7 @@ void GPUCommonHW::FastRunLoop(DisplayList &list) {
 			uint64_t flags = info.flags;
 			if (flags & FLAG_FLUSHBEFOREONCHANGE) {
 				if (drawEngineCommon_->GetNumDrawCalls()) {
+					gpuStats.numFlushesStateChange++;
 					drawEngineCommon_->DispatchFlush();
 				}
 			}
@@ -833,7 +845,7 @@ void GPUCommonHW::FastRunLoop(DisplayList &list) {
 
 void GPUCommonHW::Execute_VertexType(u32 op, u32 diff) {
 	if (diff)
-		gstate_c.Dirty(DIRTY_VERTEXSHADER_STATE);
+		gstate_c.Dirty(DIRTY_VERTEXSHADER_VTYPE);
 	if (diff & (GE_VTYPE_TC_MASK | GE_VTYPE_THROUGH_MASK)) {
 		gstate_c.Dirty(DIRTY_UVSCALEOFFSET);
 		// Switching between through and non-through, we need to invalidate a bunch of stuff.
@@ -857,7 +869,7 @@ void GPUCommonHW::Execute_VertexTypeSkinning(u32 op, u32 diff) {
 			gstate_c.Dirty(gstate_c.deferredVertTypeDirty);
 			gstate_c.deferredVertTypeDirty = 0;
 		}
-		gstate_c.Dirty(DIRTY_VERTEXSHADER_STATE);
+		gstate_c.Dirty(DIRTY_VERTEXSHADER_VTYPE);
 	}
 	if (diff & GE_VTYPE_THROUGH_MASK)
 		gstate_c.Dirty(DIRTY_RASTER_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_FRAGMENTSHADER_STATE | DIRTY_GEOMETRYSHADER_STATE | DIRTY_CULLRANGE | DIRTY_FOGCOEFENABLE);
@@ -896,6 +908,14 @@ void GPUCommonHW::Execute_Prim(u32 op, u32 diff) {
 		return;
 	}
 
+	if (staticReplaying_) {
+		// The list draws exactly what's already in the framebuffer, just keep the addresses and timing right.
+		uint32_t vertTypeID = GetVertTypeID(gstate.vertType, gstate.getUVGenMode(), g_Config.bSoftwareSkinning);
+		AdvanceVerts(gstate.vertType, count, count * drawEngineCommon_->GetVertexDecoder(vertTypeID)->VertexSize());
+		cyclesExecuted += EstimatePerVertexCost() * count;
+		return;
+	}
+
 	// See the documentation for gstate_c.blueToAlpha.
 	bool blueToAlpha = false;
 	if (PSP_CoreParameter().compat.flags().BlueToAlpha) {
@@ -927,6 +947,7 @@ void GPUCommonHW::Execute_Prim(u32 op, u32 diff) {
 
 	// Must check this after SetRenderFrameBuffer so we know SKIPDRAW_NON_DISPLAYED_FB.
 	if (gstate_c.skipDrawReason & (SKIPDRAW_SKIPFRAME | SKIPDRAW_NON_DISPLAYED_FB)) {
+		AbortStaticListRecording();
 		// Rough estimate, not sure what's correct.
 		cyclesExecuted += EstimatePerVertexCost() * count;
 		if (gstate.isModeClear()) {
@@ -949,7 +970,7 @@ void GPUCommonHW::Execute_Prim(u32 op, u32 diff) {
 		inds = Memory::GetPointerUnchecked(indexAddr);
 	}
 
-	if (gstate_c.dirty & DIRTY_VERTEXSHADER_STATE) {
+	if (gstate_c.dirty & DIRTY_ANY_VERTEXSHADER) {
 		vertexCost_ = EstimatePerVertexCost();
 	}
 
@@ -961,6 +982,7 @@ void GPUCommonHW::Execute_Prim(u32 op, u32 diff) {
 
 	uint32_t vertTypeID = GetVertTypeID(vertexType, gstate.getUVGenMode(), g_Config.bSoftwareSkinning);
 	drawEngineCommon_->SubmitPrim(verts, inds, prim, count, vertTypeID, cullMode, &bytesRead);
+	RecordStaticListDraw(vfb, vertexType, count, bytesRead);
 	// After drawing, we advance the vertexAddr (when non indexed) or indexAddr (when indexed).
 	// Some games rely on this, they don't bother reloading VADDR and IADDR.
 	// The VADDR/IADDR registers are NOT updated.
@@ -1005,6 +1027,7 @@ void GPUCommonHW::Execute_Prim(u32 op, u32 diff) {
 			}
 
 			drawEngineCommon_->SubmitPrim(verts, inds, newPrim, count, vertTypeID, cullMode, &bytesRead);
+			RecordStaticListDraw(vfb, vertexType, count, bytesRead);
 			AdvanceVerts(vertexType, count, bytesRead);
 			totalVertCount += count;
 			break;
@@ -1100,8 +1123,21 @@ void GPUCommonHW::Execute_Prim(u32 op, u32 diff) {
 			break;
 
 		default:
+		{
+			// Games set a lot of state redundantly between draws. Those writes don't affect the batch,
+			// and neither do changes to commands that don't flush, execute or dirty anything.
 			// All other commands might need a flush or something, stop this inner loop.
-			goto bail;
+			const u32 cmd = data >> 24;
+			const uint64_t flags = cmdInfo_[cmd].flags;
+			if (flags & (FLAG_EXECUTE | FLAG_READS_PC | FLAG_WRITES_PC))
+				goto bail;
+			if (data != gstate.cmdmem[cmd]) {
+				if ((flags & (FLAG_FLUSHBEFOREONCHANGE | FLAG_EXECUTEONCHANGE)) || (flags >> 8) != 0)
+					goto bail;
+				gstate.cmdmem[cmd] = data;
+			}
+			break;
+		}
 		}
 		cmdCount++;
 		src++;
@@ -1129,6 +1165,8 @@ void GPUCommonHW::Execute_Prim(u32 op, u32 diff) {
 }
 
 void GPUCommonHW::Execute_Bezier(u32 op, u32 diff) {
+	AbortStaticListRecording();
+
 	// We don't dirty on normal changes anymore as we prescale, but it's needed for splines/bezier.
 	gstate_c.Dirty(DIRTY_UVSCALEOFFSET);
 
@@ -1202,6 +1240,8 @@ void GPUCommonHW::Execute_Bezier(u32 op, u32 diff) {
 }
 
 void GPUCommonHW::Execute_Spline(u32 op, u32 diff) {
+	AbortStaticListRecording();
+
 	// We don't dirty on normal changes anymore as we prescale, but it's needed for splines/bezier.
 	gstate_c.Dirty(DIRTY_UVSCALEOFFSET);
 
@@ -1323,6 +1363,7 @@ void GPUCommonHW::Execute_TexLevel(u32 op, u32 diff) {
 void GPUCommonHW::Execute_LoadClut(u32 op, u32 diff) {
 	gstate_c.Dirty(DIRTY_TEXTURE_PARAMS);
 	textureCache_->LoadClut(gstate.getClutAddress(), gstate.getClutLoadBytes());
+	AddStaticListRange(gstate.getClutAddress(), gstate.getClutLoadBytes());
 }
 
 
@@ -1629,22 +1670,24 @@ void GPUCommonHW::Execute_TexFlush(u32 op, u32 diff) {
 size_t GPUCommonHW::FormatGPUStatsCommon(char *buffer, size_t size) {
 	float vertexAverageCycles = gpuStats.numVertsSubmitted > 0 ? (float)gpuStats.vertexGPUCycles / (float)gpuStats.numVertsSubmitted : 0.0f;
 	return snprintf(buffer, size,
-		"DL processing time: %0.2f ms, %d drawsync, %d listsync\n"
-		"Draw calls: %d, flushes %d, clears %d (cached: %d)\n"
+		"DL processing time: %0.2f ms, %d drawsync, %d listsync, %d skipped\n"
+		"Draw calls: %d, flushes %d, clears %d (cached: %d, culled: %d)\n"
 		"Num Tracked Vertex Arrays: %d\n"
 		"Vertices: %d cached: %d uncached: %d\n"
 		"FBOs active: %d (evaluations: %d)\n"
 		"Textures: %d, dec: %d, invalidated: %d, hashed: %d kB\n"
-		"readbacks %d (%d non-block), uploads %d, depal %d\n"
+		"readbacks %d (%d non-block, %d delayed), uploads %d, depal %d\n"
 		"Copies: depth %d, color %d, reint %d, blend %d, selftex %d\n"
 		"GPU cycles executed: %d (%f per vertex)\n",
 		gpuStats.msProcessingDisplayLists * 1000.0f,
 		gpuStats.numDrawSyncs,
 		gpuStats.numListSyncs,
+		gpuStats.numSkippedStaticLists,
 		gpuStats.numDrawCalls,
 		gpuStats.numFlushes,
 		gpuStats.numClears,
 		gpuStats.numCachedDrawCalls,
+		gpuStats.numCulledDraws,
 		gpuStats.numTrackedVertexArrays,
 		gpuStats.numVertsSubmitted,
 		gpuStats.numCachedVertsDrawn,
@@ -1657,6 +1700,7 @@ size_t GPUCommonHW::FormatGPUStatsCommon(char *buffer, size_t size) {
 		gpuStats.numTextureDataBytesHashed / 1024,
 		gpuStats.numBlockingReadbacks,
 		gpuStats.numReadbacks,
+		gpuStats.numDelayedReadbacks,
 		gpuStats.numUploads,
 		gpuStats.numDepal,
 		gpuStats.numDepthCopies,
@@ -19,6 +19,7 @@
 #include <condition_variable>
 #include <mutex>
 #include "Common/Profiler/Profiler.h"
+#include "Common/StringUtils.h"
 #include "Common/Thread/ThreadManager.h"
 #include "Common/TimeUtil.h"
 #include "Core/System.h"
@@ -97,8 +98,8 @@ static inline void DrawBinItem(const BinItem &item, const RasterizerState &state
 
 class DrawBinItemsTask : public Task {
 public:
-	DrawBinItemsTask(BinWaitable *notify, BinManager::BinItemQueue &items, std::atomic<bool> &status, const BinManager::BinStateQueue &states)
-		: notify_(notify), items_(items), status_(status), states_(states) {
+	DrawBinItemsTask(BinManager *binner, int index)
+		: binner_(binner), index_(index) {
 	}
 
 	TaskType Type() const override {
@@ -111,11 +112,15 @@ class DrawBinItemsTask : public Task {
 	}
 
 	void Run() override {
-		ProcessItems();
-		status_ = false;
+		double st = time_now_d();
+		ProcessItems(index_);
+		binner_->taskStatus_[index_] = false;
 		// In case of any atomic issues, do another pass.
-		ProcessItems();
-		notify_->Drain();
+		ProcessItems(index_);
+		// Bins never overlap, so help out with any whose thread is busy.
+		StealItems();
+		binner_->threadBusyNanos_[index_] += (int64_t)((time_now_d() - st) * 1000000000.0);
+		binner_->waitable_->Drain();
 	}
 
 	void Release() override {
@@ -123,18 +128,47 @@ class DrawBinItemsTask : public Task {
 	}
 
 private:
-	void ProcessItems() {
-		while (!items_.Empty()) {
-			const BinItem &item = items_.PeekNext();
-			DrawBinItem(item, states_[item.stateIndex]);
-			items_.SkipNext();
+	// Returns true if any items were drawn.
+	bool ProcessItems(int bin) {
+		BinManager::BinItemQueue &items = binner_->taskQueues_[bin];
+		std::atomic<bool> &claim = binner_->binClaims_[bin];
+		const BinManager::BinStateQueue &states = binner_->states_;
+
+		bool drew = false;
+		while (!items.Empty()) {
+			// Items within a bin must draw in order, so only one task can have it at a time.
+			// If someone else has it, they check again after releasing, so nothing is missed.
+			bool expected = false;
+			if (!claim.compare_exchange_strong(expected, true))
+				break;
+
+			double st = time_now_d();
+			while (!items.Empty()) {
+				const BinItem &item = items.PeekNext();
+				DrawBinItem(item, states[item.stateIndex]);
+				items.SkipNext();
+			}
+			binner_->binCostNanos_[bin] += (int64_t)((time_now_d() - st) * 1000000000.0);
+			drew = true;
+
+			claim = false;
 		}
+		return drew;
 	}
 
-	BinWaitable *notify_;
-	BinManager::BinItemQueue &items_;
-	std::atomic<bool> &status_;
-	const BinManager::BinStateQueue &states_;
+	void StealItems() {
+		const int count = binner_->activeBins_;
+		for (int i = 1; i < count; ++i) {
+			int bin = (index_ + i) % count;
+			if (binner_->taskQueues_[bin].Empty() || binner_->binClaims_[bin])
+				continue;
+			if (ProcessItems(bin))
+				binner_->steals_++;
+		}
+	}
+
+	BinManager *binner_;
+	int index_;
 };
 
 constexpr int BinManager::MAX_POSSIBLE_TASKS;
@@ -148,12 +182,21 @@ BinManager::BinManager() {
 	waitable_ = new BinWaitable();
 	for (auto &s : taskStatus_)
 		s = false;
-
-	int maxInitTasks = std::min(g_threadManager.GetNumLooperThreads(), MAX_POSSIBLE_TASKS);
-	for (int i = 0; i < maxInitTasks; ++i) {
+	for (auto &c : binClaims_)
+		c = false;
+	for (auto &n : binCostNanos_)
+		n = 0;
+	for (auto &n : threadBusyNanos_)
+		n = 0;
+	activeBins_ = 0;
+	steals_ = 0;
+	statsStartTime_ = time_now_d();
+
+	numTaskThreads_ = std::min(g_threadManager.GetNumLooperThreads(), MAX_POSSIBLE_TASKS);
+	for (int i = 0; i < numTaskThreads_; ++i) {
 		taskQueues_[i].Setup();
 		for (DrawBinItemsTask *&task : taskLists_[i].tasks)
-			task = new DrawBinItemsTask(waitable_, taskQueues_[i], taskStatus_[i], states_);
+			task = new DrawBinItemsTask(this, i);
 	}
 	states_.Setup();
 	cluts_.Setup();
@@ -187,6 +230,10 @@ void BinManager::UpdateState() {
 	if (lastFlipstats_ != gpuStats.numFlips) {
 		lastFlipstats_ = gpuStats.numFlips;
 		ResetStats();
+
+		// The last frame's costs decide how we size bins this frame.
+		memcpy(lastBinStripCosts_, binStripCosts_, sizeof(binStripCosts_));
+		memset(binStripCosts_, 0, sizeof(binStripCosts_));
 	}
 
 	const auto &state = State();
@@ -462,6 +509,9 @@ void BinManager::Drain(bool flushing) {
 
 	// If the waitable has fully drained, we can update our binning decisions.
 	if (!tasksSplit_ || waitable_->Empty()) {
+		// First, remember what the old bins cost so we can balance better.
+		HarvestBinCosts();
+
 		int w2 = (queueRange_.x2 - queueRange_.x1 + (SCREEN_SCALE_FACTOR * 2 - 1)) / (SCREEN_SCALE_FACTOR * 2);
 		int h2 = (queueRange_.y2 - queueRange_.y1 + (SCREEN_SCALE_FACTOR * 2 - 1)) / (SCREEN_SCALE_FACTOR * 2);
 
@@ -478,21 +528,15 @@ void BinManager::Drain(bool flushing) {
 		}
 
 		taskRanges_.clear();
+		const BinCoords full{ tl.x, tl.y, br.x - 1, br.y - 1 };
 		if (h2 >= 18 && w2 >= h2 * 4) {
 			int bin_w = std::max(4, (w2 + maxTasks_ - 1) / maxTasks_) * SCREEN_SCALE_FACTOR * 2;
-			taskRanges_.push_back(BinCoords{ tl.x, tl.y, queueRange_.x1 + bin_w - 1, br.y - 1 });
-			for (int x = queueRange_.x1 + bin_w; x <= queueRange_.x2; x += bin_w) {
-				int x2 = x + bin_w > queueRange_.x2 ? br.x : x + bin_w;
-				taskRanges_.push_back(BinCoords{ x, tl.y, x2 - 1, br.y - 1 });
-			}
+			SplitTaskRanges(0, queueRange_.x1, queueRange_.x2, bin_w, full);
 		} else if (h2 >= 18 && w2 >= 18) {
 			int bin_h = std::max(4, (h2 + maxTasks_ - 1) / maxTasks_) * SCREEN_SCALE_FACTOR * 2;
-			taskRanges_.push_back(BinCoords{ tl.x, tl.y, br.x - 1, queueRange_.y1 + bin_h - 1 });
-			for (int y = queueRange_.y1 + bin_h; y <= queueRange_.y2; y += bin_h) {
-				int y2 = y + bin_h > queueRange_.y2 ? br.y : y + bin_h;
-				taskRanges_.push_back(BinCoords{ tl.x, y, br.x - 1, y2 - 1 });
-			}
+			SplitTaskRanges(1, queueRange_.y1, queueRange_.y2, bin_h, full);
 		}
+		activeBins_ = taskRanges_.size() <= 1 ? 0 : (int)taskRanges_.size();
 
 		tasksSplit_ = true;
 	}
@@ -564,7 +608,9 @@ void BinManager::Flush(const char *reason) {
 		st = time_now_d();
 	Drain(true);
 	waitable_->Wait();
+	HarvestBinCosts();
 	taskRanges_.clear();
+	activeBins_ = 0;
 	tasksSplit_ = false;
 
 	queue_.Reset();
@@ -591,6 +637,7 @@ void BinManager::Flush(const char *reason) {
 
 	if (coreCollectDebugStats) {
 		double et = time_now_d();
+		g_softGPUBenchStats.flushWait += et - st;
 		flushReasonTimes_[reason] += et - st;
 		if (et - st > slowestFlushTime_) {
 			slowestFlushTime_ = et - st;
@@ -599,6 +646,111 @@ void BinManager::Flush(const char *reason) {
 	}
 }
 
+void BinManager::SplitTaskRanges(int axis, int lo, int hi, int binSize, const BinCoords &full) {
+	// Bin starts along the axis, after the first bin (which always starts at the edge.)
+	std::vector<int> splits;
+	const int minSize = 4 * SCREEN_SCALE_FACTOR * 2;
+	if (!ComputeBalancedSplits(axis, lo, hi, minSize, splits)) {
+		// No costs from last frame, so just split evenly.
+		for (int pos = lo + binSize; pos <= hi; pos += binSize)
+			splits.push_back(pos);
+	}
+
+	taskSplitAxis_ = axis;
+	taskSplitRange_ = queueRange_;
+
+	int start = axis == 0 ? full.x1 : full.y1;
+	if (axis == 0) {
+		// Side by side bins share cache lines on every row at their edges, so align those.
+		// Rows never share lines (strides are large), so y splits are fine as is.
+		int last = start;
+		int end = full.x2;
+		size_t kept = 0;
+		for (size_t i = 0; i < splits.size(); ++i) {
+			int pos = splits[i] & ~(BIN_CACHE_ALIGN_X - 1);
+			if (pos <= last || pos > end)
+				continue;
+			splits[kept++] = pos;
+			last = pos;
+		}
+		splits.resize(kept);
+	}
+
+	for (size_t i = 0; i <= splits.size(); ++i) {
+		int end = i == splits.size() ? (axis == 0 ? full.x2 : full.y2) : splits[i] - 1;
+		if (axis == 0)
+			taskRanges_.push_back(BinCoords{ start, full.y1, end, full.y2 });
+		else
+			taskRanges_.push_back(BinCoords{ full.x1, start, full.x2, end });
+		start = end + 1;
+	}
+}
+
+static inline int BinCostStrip(int pos) {
+	constexpr int stripSize = 1024 * SCREEN_SCALE_FACTOR / 64;
+	return std::min(std::max(pos / stripSize, 0), 63);
+}
+
+bool BinManager::ComputeBalancedSplits(int axis, int lo, int hi, int minSize, std::vector<int> &splits) {
+	static_assert(BIN_COST_STRIPS == 64, "BinCostStrip() assumes 64 strips");
+	constexpr int stripSize = 1024 * SCREEN_SCALE_FACTOR / BIN_COST_STRIPS;
+	const double *costs = lastBinStripCosts_[axis];
+	const int firstStrip = BinCostStrip(lo);
+	const int lastStrip = BinCostStrip(hi);
+
+	double total = 0.0;
+	for (int s = firstStrip; s <= lastStrip; ++s)
+		total += costs[s];
+	if (total <= 0.0)
+		return false;
+
+	// Place each split where the running cost crosses the next even share.
+	const double share = total / maxTasks_;
+	double accum = 0.0;
+	int prev = lo;
+	for (int s = firstStrip; s <= lastStrip && (int)splits.size() < maxTasks_ - 1; ++s) {
+		while (costs[s] > 0.0 && accum + costs[s] >= share * (splits.size() + 1) && (int)splits.size() < maxTasks_ - 1) {
+			double frac = (share * (splits.size() + 1) - accum) / costs[s];
+			int pos = s * stripSize + (int)(frac * stripSize);
+			// Keep bins aligned and not too thin, or they'd cost more than they help.
+			pos &= ~(SCREEN_SCALE_FACTOR * 2 - 1);
+			pos = std::max(pos, prev + minSize);
+			if (pos > hi)
+				return true;
+			splits.push_back(pos);
+			prev = pos;
+		}
+		accum += costs[s];
+	}
+
+	return true;
+}
+
+void BinManager::HarvestBinCosts() {
+	if (taskRanges_.size() <= 1)
+		return;
+
+	// Spread each bin's cost over the drawn strips it covered.
+	double *costs = binStripCosts_[taskSplitAxis_];
+	for (int i = 0; i < (int)taskRanges_.size(); ++i) {
+		int64_t nanos = binCostNanos_[i].exchange(0);
+		if (nanos == 0)
+			continue;
+
+		const BinCoords &range = taskRanges_[i];
+		int lo = taskSplitAxis_ == 0 ? std::max(range.x1, taskSplitRange_.x1) : std::max(range.y1, taskSplitRange_.y1);
+		int hi = taskSplitAxis_ == 0 ? std::min(range.x2, taskSplitRange_.x2) : std::min(range.y2, taskSplitRange_.y2);
+		if (hi < lo)
+			hi = lo;
+
+		const int firstStrip = BinCostStrip(lo);
+		const int lastStrip = BinCostStrip(hi);
+		double perStrip = (double)nanos * 0.000000001 / (lastStrip - firstStrip + 1);
+		for (int s = firstStrip; s <= lastStrip; ++s)
+			costs[s] += perStrip;
+	}
+}
+
 void BinManager::OptimizePendingStates(uint16_t first, uint16_t last) {
 	// We can sometimes hit this when compiling new funcs while creating a state.
 	// At that point, the state isn't loaded fully yet, so don't touch it.
@@ -694,17 +846,26 @@ void BinManager::GetStats(char *buffer, size_t bufsize) {
 		recentTotal += it.second;
 	}
 
+	// Utilization is over the last frame, per looper thread.
+	std::string utilization;
+	for (int i = 0; i < numTaskThreads_; ++i) {
+		double percent = lastStatsPeriod_ > 0.0 ? lastThreadBusy_[i] * 100.0 / lastStatsPeriod_ : 0.0;
+		utilization += StringFromFormat(i == 0 ? "%d%%" : " %d%%", (int)percent);
+	}
+
 	snprintf(buffer, bufsize,
 		"Slowest individual flush: %s (%0.4f)\n"
 		"Slowest frame flush: %s (%0.4f)\n"
 		"Slowest recent flush: %s (%0.4f)\n"
 		"Total flush time: %0.4f (%05.2f%%, last 2: %05.2f%%)\n"
-		"Thread enqueues: %d, count %d",
+		"Thread enqueues: %d, count %d, steals %d\n"
+		"Thread utilization: %s",
 		slowestFlushReason_, slowestFlushTime_,
 		slowestTotalReason, slowestTotalTime,
 		slowestRecentReason, slowestRecentTime,
 		allTotal, allTotal * (6000.0 / 1.001), recentTotal * (3000.0 / 1.001),
-		enqueues_, mostThreads_);
+		enqueues_, mostThreads_, lastSteals_,
+		utilization.c_str());
 }
 
 void BinManager::ResetStats() {
@@ -714,6 +875,13 @@ void BinManager::ResetStats() {
 	slowestFlushTime_ = 0.0;
 	enqueues_ = 0;
 	mostThreads_ = 0;
+
+	double now = time_now_d();
+	lastStatsPeriod_ = now - statsStartTime_;
+	statsStartTime_ = now;
+	for (int i = 0; i < MAX_POSSIBLE_TASKS; ++i)
+		lastThreadBusy_[i] = (double)threadBusyNanos_[i].exchange(0) * 0.000000001;
+	lastSteals_ = steals_.exchange(0);
 }
 
 inline BinCoords BinCoords::Intersect(const BinCoords &range) const {
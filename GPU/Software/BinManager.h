@@ -234,6 +234,10 @@ class BinManager {
 	static constexpr int QUEUED_CLUTS = 512;
 	// About 360 KB, but we have usually 16 or less of them, so 5 MB - 22 MB.
 	static constexpr int QUEUED_PRIMS = 2048;
+	// Costs are tracked in strips of 16 pixels, across the full 1024 pixel range.
+	static constexpr int BIN_COST_STRIPS = 64;
+	// In screen coords, 32 pixels is a 64 byte cache line for both 16-bit color and depth.
+	static constexpr int BIN_CACHE_ALIGN_X = 32 * SCREEN_SCALE_FACTOR;
 
 	typedef BinQueue<Rasterizer::RasterizerState, QUEUED_STATES> BinStateQueue;
 	typedef BinQueue<BinClut, QUEUED_CLUTS> BinClutQueue;
@@ -250,13 +254,25 @@ class BinManager {
 	SoftDirty dirty_ = SoftDirty::NONE;
 
 	int maxTasks_ = 1;
+	int numTaskThreads_ = 0;
 	bool tasksSplit_ = false;
 	std::vector<BinCoords> taskRanges_;
+	// Which axis taskRanges_ splits on (0 = x, 1 = y), and the drawn area at the time.
+	int taskSplitAxis_ = 0;
+	BinCoords taskSplitRange_{};
+	std::atomic<int> activeBins_;
 	BinItemQueue taskQueues_[MAX_POSSIBLE_TASKS];
 	BinTaskList taskLists_[MAX_POSSIBLE_TASKS];
 	std::atomic<bool> taskStatus_[MAX_POSSIBLE_TASKS];
+	// Held by whichever task is drawing from the bin, so idle tasks can steal bins.
+	std::atomic<bool> binClaims_[MAX_POSSIBLE_TASKS];
+	std::atomic<int64_t> binCostNanos_[MAX_POSSIBLE_TASKS];
 	BinWaitable *waitable_ = nullptr;
 
+	// Per strip drawing costs in seconds, along each axis, for this frame and the last.
+	double binStripCosts_[2][BIN_COST_STRIPS]{};
+	double lastBinStripCosts_[2][BIN_COST_STRIPS]{};
+
 	BinDirtyRange pendingWrites_[2]{};
 	std::unordered_map<uint32_t, BinDirtyRange> pendingReads_;
 
@@ -271,12 +287,21 @@ class BinManager {
 	int lastFlipstats_ = 0;
 	int enqueues_ = 0;
 	int mostThreads_ = 0;
+	std::atomic<int64_t> threadBusyNanos_[MAX_POSSIBLE_TASKS];
+	std::atomic<int> steals_;
+	double lastThreadBusy_[MAX_POSSIBLE_TASKS]{};
+	double lastStatsPeriod_ = 0.0;
+	double statsStartTime_ = 0.0;
+	int lastSteals_ = 0;
 
 	void MarkPendingReads(const Rasterizer::RasterizerState &state);
 	void MarkPendingWrites(const Rasterizer::RasterizerState &state);
 	bool HasTextureWrite(const Rasterizer::RasterizerState &state);
 	bool IsExactSelfRender(const Rasterizer::RasterizerState &state, const BinItem &item);
 	void OptimizePendingStates(uint16_t first, uint16_t last);
+	void SplitTaskRanges(int axis, int lo, int hi, int minSize, const BinCoords &full);
+	bool ComputeBalancedSplits(int axis, int lo, int hi, int minSize, std::vector<int> &splits);
+	void HarvestBinCosts();
 	BinCoords Scissor(BinCoords range);
 	BinCoords Range(const VertexData &v0, const VertexData &v1, const VertexData &v2);
 	BinCoords Range(const VertexData &v0, const VertexData &v1);
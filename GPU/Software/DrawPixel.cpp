@@ -19,6 +19,9 @@
 #include <mutex>
 #include "Common/Common.h"
 #include "Common/Data/Convert/ColorConv.h"
+#include "Common/Profiler/PerfMap.h"
+#include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "GPU/GPUState.h"
 #include "GPU/Software/BinManager.h"
@@ -47,6 +50,14 @@ void Shutdown() {
 	jitCache = nullptr;
 }
 
+void GetJitKeys(std::vector<uint64_t> &keys) {
+	jitCache->GetKeys(keys);
+}
+
+void PrecompileJit(const std::vector<uint64_t> &keys) {
+	jitCache->Precompile(keys);
+}
+
 bool DescribeCodePtr(const u8 *ptr, std::string &name) {
 	if (!jitCache->IsInSpace(ptr)) {
 		return false;
@@ -850,6 +861,30 @@ void PixelJitCache::Flush() {
 	compileQueue_.clear();
 }
 
+void PixelJitCache::GetKeys(std::vector<uint64_t> &keys) {
+	std::unique_lock<std::mutex> guard(jitCacheLock);
+	keys.reserve(keys.size() + addresses_.size());
+	for (const auto &it : addresses_)
+		keys.push_back(it.first.fullKey);
+}
+
+void PixelJitCache::Precompile(const std::vector<uint64_t> &keys) {
+	if (!g_Config.bSoftwareRenderingJit)
+		return;
+
+	// The key is all that's used to compile, cached values are only read at runtime.
+	std::unique_lock<std::mutex> guard(jitCacheLock);
+	for (uint64_t key : keys) {
+		PixelFuncID id;
+		id.fullKey = key;
+		// Don't trust the file too much.
+		if (startsWith(DescribePixelFuncID(id), "INVALID"))
+			continue;
+		if (!cache_.Get(std::hash<PixelFuncID>()(id)))
+			Compile(id);
+	}
+}
+
 SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id, BinManager *binner) {
 	if (!g_Config.bSoftwareRenderingJit)
 		return nullptr;
@@ -898,10 +933,15 @@ void PixelJitCache::Compile(const PixelFuncID &id) {
 		Clear();
 	}
 
-#if PPSSPP_ARCH(AMD64) && !PPSSPP_PLATFORM(UWP)
-	addresses_[id] = GetCodePointer();
+#if (PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(ARM64_NEON)) && !PPSSPP_PLATFORM(UWP)
+	double st = time_now_d();
+	const u8 *start = GetCodePointer();
+	addresses_[id] = start;
 	SingleFunc func = CompileSingle(id);
 	cache_.Insert(std::hash<PixelFuncID>()(id), func);
+	if (func && PerfMap_IsEnabled())
+		PerfMap_AddSymbol(start, GetCodePointer() - start, "PixelFunc " + DescribePixelFuncID(id));
+	g_softGPUBenchStats.pixelJit += time_now_d() - st;
 #endif
 }
 
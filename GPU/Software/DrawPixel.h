@@ -46,6 +46,10 @@ void Init();
 void FlushJit();
 void Shutdown();
 
+// For the on-disk cache: keys of the funcs compiled so far, and compiling them ahead of use.
+void GetJitKeys(std::vector<uint64_t> &keys);
+void PrecompileJit(const std::vector<uint64_t> &keys);
+
 bool CheckDepthTestPassed(GEComparison func, int x, int y, int stride, u16 z);
 
 bool DescribeCodePtr(const u8 *ptr, std::string &name);
@@ -70,6 +74,9 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 	void Clear() override;
 	void Flush();
 
+	void GetKeys(std::vector<uint64_t> &keys);
+	void Precompile(const std::vector<uint64_t> &keys);
+
 	std::string DescribeCodePtr(const u8 *ptr) override;
 
 private:
@@ -144,6 +151,13 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 	std::vector<Gen::FixupBranch> skipStandardWrites_;
 	int stackIDOffset_ = 0;
 	bool colorIs16Bit_ = false;
+#elif PPSSPP_ARCH(ARM64_NEON)
+	void Discard();
+	void Discard(CCFlags cc);
+
+	// Used for any test failure.
+	std::vector<Arm64Gen::FixupBranch> discards_;
+	bool colorIs16Bit_ = false;
 #endif
 };
 
@@ -0,0 +1,1367 @@
+// Copyright (c) 2017- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(ARM64_NEON)
+
+#include "Common/Arm64Emitter.h"
+#include "Common/LogReporting.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/SoftGpu.h"
+#include "GPU/ge_constants.h"
+
+using namespace Arm64Gen;
+
+namespace Rasterizer {
+
+SingleFunc PixelJitCache::CompileSingle(const PixelFuncID &id) {
+	// Setup the reg cache and disallow spill for arguments.
+	// There are plenty of regs, so we simply keep the args around until the end.
+	regCache_.SetupABI({
+		RegCache::GEN_ARG_X,
+		RegCache::GEN_ARG_Y,
+		RegCache::GEN_ARG_Z,
+		RegCache::GEN_ARG_FOG,
+		RegCache::VEC_ARG_COLOR,
+		RegCache::GEN_ARG_ID,
+	});
+
+	BeginWrite(64);
+	Describe("Init");
+	const u8 *resetPos = AlignCode16();
+	EndWrite();
+	bool success = true;
+
+	// Everything the reg cache hands out is caller saved.
+	WriteProlog(0, {}, {});
+
+	// Start with the depth range.
+	success = success && Jit_ApplyDepthRange(id);
+
+	// Next, let's clamp the color (might affect alpha test, and everything expects it clamped.)
+	// The args are 32-bit signed lanes, so narrow once signed and once unsigned to get RGBA8.
+	Describe("ClampColor");
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	fp.SQXTUN(16, EncodeRegToDouble(argColorReg), argColorReg);
+	fp.UQXTN(8, EncodeRegToDouble(argColorReg), argColorReg);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+	colorIs16Bit_ = false;
+
+	success = success && Jit_AlphaTest(id);
+	// Fog is applied prior to color test.  Maybe before alpha test too, but it doesn't affect it...
+	success = success && Jit_ApplyFog(id);
+	success = success && Jit_ColorTest(id);
+
+	if (id.stencilTest && !id.clearMode)
+		success = success && Jit_StencilAndDepthTest(id);
+	else if (!id.clearMode)
+		success = success && Jit_DepthTest(id);
+	success = success && Jit_WriteDepth(id);
+
+	success = success && Jit_AlphaBlend(id);
+	success = success && Jit_Dither(id);
+	success = success && Jit_WriteColor(id);
+
+	for (auto &fixup : discards_) {
+		SetJumpTarget(fixup);
+	}
+	discards_.clear();
+
+	static const RegCache::Purpose args[] = {
+		RegCache::GEN_ARG_X,
+		RegCache::GEN_ARG_Y,
+		RegCache::GEN_ARG_Z,
+		RegCache::GEN_ARG_FOG,
+		RegCache::VEC_ARG_COLOR,
+		RegCache::GEN_ARG_ID,
+	};
+	for (RegCache::Purpose p : args) {
+		if (regCache_.Has(p))
+			regCache_.ForceRelease(p);
+	}
+
+	if (!success) {
+		ERROR_LOG_REPORT(G3D, "Could not compile pixel func: %s", DescribePixelFuncID(id).c_str());
+
+		regCache_.Reset(false);
+		EndWrite();
+		ResetCodePtr(GetOffset(resetPos));
+		return nullptr;
+	}
+
+	const u8 *start = WriteFinalizedEpilog();
+	regCache_.Reset(true);
+	return (SingleFunc)start;
+}
+
+RegCache::Reg PixelJitCache::GetPixelID() {
+	// Always in a reg on ARM64.
+	return regCache_.Find(RegCache::GEN_ARG_ID);
+}
+
+void PixelJitCache::UnlockPixelID(RegCache::Reg &r) {
+	regCache_.Unlock(r, RegCache::GEN_ARG_ID);
+}
+
+RegCache::Reg PixelJitCache::GetColorOff(const PixelFuncID &id) {
+	if (!regCache_.Has(RegCache::GEN_COLOR_OFF)) {
+		Describe("GetColorOff");
+		ARM64Reg argXReg = regCache_.Find(RegCache::GEN_ARG_X);
+		ARM64Reg argYReg = regCache_.Find(RegCache::GEN_ARG_Y);
+		ARM64Reg r = regCache_.Alloc(RegCache::GEN_COLOR_OFF);
+
+		if (id.useStandardStride) {
+			ADD(DecodeReg(r), DecodeReg(argXReg), DecodeReg(argYReg), ArithOption(DecodeReg(argYReg), ST_LSL, 9));
+		} else {
+			ARM64Reg idReg = GetPixelID();
+			LDRH(INDEX_UNSIGNED, DecodeReg(r), idReg, offsetof(PixelFuncID, cached.framebufStride));
+			UnlockPixelID(idReg);
+			MADD(DecodeReg(r), DecodeReg(r), DecodeReg(argYReg), DecodeReg(argXReg));
+		}
+		regCache_.Unlock(argXReg, RegCache::GEN_ARG_X);
+		regCache_.Unlock(argYReg, RegCache::GEN_ARG_Y);
+
+		// The framebuffer can move, so we read the pointer each time.
+		ARM64Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP_HELPER);
+		MOVP2R(tempReg, &fb.data);
+		LDR(INDEX_UNSIGNED, tempReg, tempReg, 0);
+		ADD(r, tempReg, r, ArithOption(r, ST_LSL, id.FBFormat() == GE_FORMAT_8888 ? 2 : 1));
+		regCache_.Release(tempReg, RegCache::GEN_TEMP_HELPER);
+		return r;
+	}
+	return regCache_.Find(RegCache::GEN_COLOR_OFF);
+}
+
+RegCache::Reg PixelJitCache::GetDepthOff(const PixelFuncID &id) {
+	if (!regCache_.Has(RegCache::GEN_DEPTH_OFF)) {
+		Describe("GetDepthOff");
+		ARM64Reg argXReg = regCache_.Find(RegCache::GEN_ARG_X);
+		ARM64Reg argYReg = regCache_.Find(RegCache::GEN_ARG_Y);
+		ARM64Reg r = regCache_.Alloc(RegCache::GEN_DEPTH_OFF);
+
+		if (id.useStandardStride) {
+			ADD(DecodeReg(r), DecodeReg(argXReg), DecodeReg(argYReg), ArithOption(DecodeReg(argYReg), ST_LSL, 9));
+		} else {
+			ARM64Reg idReg = GetPixelID();
+			LDRH(INDEX_UNSIGNED, DecodeReg(r), idReg, offsetof(PixelFuncID, cached.depthbufStride));
+			UnlockPixelID(idReg);
+			MADD(DecodeReg(r), DecodeReg(r), DecodeReg(argYReg), DecodeReg(argXReg));
+		}
+		regCache_.Unlock(argXReg, RegCache::GEN_ARG_X);
+		regCache_.Unlock(argYReg, RegCache::GEN_ARG_Y);
+
+		ARM64Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP_HELPER);
+		MOVP2R(tempReg, &depthbuf.data);
+		LDR(INDEX_UNSIGNED, tempReg, tempReg, 0);
+		ADD(r, tempReg, r, ArithOption(r, ST_LSL, 1));
+		regCache_.Release(tempReg, RegCache::GEN_TEMP_HELPER);
+		return r;
+	}
+	return regCache_.Find(RegCache::GEN_DEPTH_OFF);
+}
+
+RegCache::Reg PixelJitCache::GetDestStencil(const PixelFuncID &id) {
+	// Skip if 565, since stencil is fixed zero.  We still give back a reg to keep things simple.
+	ARM64Reg stencilReg = regCache_.Alloc(RegCache::GEN_STENCIL);
+	if (id.FBFormat() == GE_FORMAT_565) {
+		MOVI2R(DecodeReg(stencilReg), 0);
+		return stencilReg;
+	}
+
+	ARM64Reg colorOffReg = GetColorOff(id);
+	Describe("GetDestStencil");
+	if (id.FBFormat() == GE_FORMAT_8888) {
+		LDRB(INDEX_UNSIGNED, DecodeReg(stencilReg), colorOffReg, 3);
+	} else if (id.FBFormat() == GE_FORMAT_5551) {
+		LDRB(INDEX_UNSIGNED, DecodeReg(stencilReg), colorOffReg, 1);
+		// Replicate the top bit across the whole byte.
+		SBFM(DecodeReg(stencilReg), DecodeReg(stencilReg), 7, 7);
+		UXTB(DecodeReg(stencilReg), DecodeReg(stencilReg));
+	} else if (id.FBFormat() == GE_FORMAT_4444) {
+		LDRB(INDEX_UNSIGNED, DecodeReg(stencilReg), colorOffReg, 1);
+		LSR(DecodeReg(stencilReg), DecodeReg(stencilReg), 4);
+		ORR(DecodeReg(stencilReg), DecodeReg(stencilReg), DecodeReg(stencilReg), ArithOption(DecodeReg(stencilReg), ST_LSL, 4));
+	}
+	regCache_.Unlock(colorOffReg, RegCache::GEN_COLOR_OFF);
+
+	return stencilReg;
+}
+
+void PixelJitCache::Discard() {
+	discards_.push_back(B());
+}
+
+void PixelJitCache::Discard(CCFlags cc) {
+	discards_.push_back(B(cc));
+}
+
+// Returns the condition for which a comparison of (left, right) passes.
+static CCFlags ComparisonPassCC(GEComparison func) {
+	switch (func) {
+	case GE_COMP_EQUAL: return CC_EQ;
+	case GE_COMP_NOTEQUAL: return CC_NEQ;
+	case GE_COMP_LESS: return CC_LO;
+	case GE_COMP_LEQUAL: return CC_LS;
+	case GE_COMP_GREATER: return CC_HI;
+	case GE_COMP_GEQUAL: return CC_HS;
+	default:
+		_assert_(false);
+		return CC_AL;
+	}
+}
+
+bool PixelJitCache::Jit_ApplyDepthRange(const PixelFuncID &id) {
+	if (id.applyDepthRange && !id.earlyZChecks) {
+		Describe("ApplyDepthR");
+		ARM64Reg argZReg = regCache_.Find(RegCache::GEN_ARG_Z);
+		ARM64Reg idReg = GetPixelID();
+		ARM64Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+
+		// We expanded this to 32 bits, so it's convenient to compare.
+		LDR(INDEX_UNSIGNED, DecodeReg(tempReg), idReg, offsetof(PixelFuncID, cached.minz));
+		CMP(DecodeReg(argZReg), DecodeReg(tempReg));
+		Discard(CC_LT);
+
+		LDR(INDEX_UNSIGNED, DecodeReg(tempReg), idReg, offsetof(PixelFuncID, cached.maxz));
+		CMP(DecodeReg(argZReg), DecodeReg(tempReg));
+		Discard(CC_GT);
+
+		regCache_.Release(tempReg, RegCache::GEN_TEMP0);
+		UnlockPixelID(idReg);
+		regCache_.Unlock(argZReg, RegCache::GEN_ARG_Z);
+	}
+
+	return true;
+}
+
+bool PixelJitCache::Jit_AlphaTest(const PixelFuncID &id) {
+	if (id.clearMode || id.AlphaTestFunc() == GE_COMP_ALWAYS)
+		return true;
+
+	Describe("AlphaTest");
+	if (id.AlphaTestFunc() == GE_COMP_NEVER) {
+		// Hopefully rare, trivial.
+		Discard();
+		return true;
+	}
+
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	ARM64Reg alphaReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	fp.UMOV(8, DecodeReg(alphaReg), argColorReg, 3);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+
+	if (id.hasAlphaTestMask) {
+		ARM64Reg idReg = GetPixelID();
+		ARM64Reg maskReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+		LDRB(INDEX_UNSIGNED, DecodeReg(maskReg), idReg, offsetof(PixelFuncID, cached.alphaTestMask));
+		AND(DecodeReg(alphaReg), DecodeReg(alphaReg), DecodeReg(maskReg));
+		regCache_.Release(maskReg, RegCache::GEN_TEMP1);
+		UnlockPixelID(idReg);
+	}
+
+	// The test is against the ref on the right, so we can use an immediate.
+	CMP(DecodeReg(alphaReg), id.alphaTestRef);
+	Discard(InvertCond(ComparisonPassCC(id.AlphaTestFunc())));
+	regCache_.Release(alphaReg, RegCache::GEN_TEMP0);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_ColorTest(const PixelFuncID &id) {
+	if (!id.colorTest || id.clearMode)
+		return true;
+
+	Describe("ColorTest");
+	ARM64Reg idReg = GetPixelID();
+	ARM64Reg funcReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	ARM64Reg maskedReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	ARM64Reg refReg = regCache_.Alloc(RegCache::GEN_TEMP2);
+
+	// First, load the color and mask it.
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	fp.UMOV(32, DecodeReg(maskedReg), argColorReg, 0);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+
+	LDR(INDEX_UNSIGNED, DecodeReg(refReg), idReg, offsetof(PixelFuncID, cached.colorTestMask));
+	AND(DecodeReg(maskedReg), DecodeReg(maskedReg), DecodeReg(refReg));
+	LDR(INDEX_UNSIGNED, DecodeReg(refReg), idReg, offsetof(PixelFuncID, cached.colorTestRef));
+	// The func is runtime, since it's only stored in the cached part.
+	LDRB(INDEX_UNSIGNED, DecodeReg(funcReg), idReg, offsetof(PixelFuncID, cached.colorTestFunc));
+	UnlockPixelID(idReg);
+
+	// NEVER discards, and anything past NOTEQUAL passes like ALWAYS.
+	CMP(DecodeReg(funcReg), GE_COMP_NEVER);
+	Discard(CC_EQ);
+	CMP(DecodeReg(funcReg), GE_COMP_NOTEQUAL);
+	FixupBranch skipInvalid = B(CC_HI);
+	CMP(DecodeReg(funcReg), GE_COMP_EQUAL);
+	FixupBranch skipAlways = B(CC_LO);
+	FixupBranch doEqual = B(CC_EQ);
+
+	// Only NOTEQUAL is left here.
+	CMP(DecodeReg(maskedReg), DecodeReg(refReg));
+	Discard(CC_EQ);
+	FixupBranch skipNotEqual = B();
+
+	SetJumpTarget(doEqual);
+	CMP(DecodeReg(maskedReg), DecodeReg(refReg));
+	Discard(CC_NEQ);
+
+	SetJumpTarget(skipInvalid);
+	SetJumpTarget(skipAlways);
+	SetJumpTarget(skipNotEqual);
+
+	regCache_.Release(funcReg, RegCache::GEN_TEMP0);
+	regCache_.Release(maskedReg, RegCache::GEN_TEMP1);
+	regCache_.Release(refReg, RegCache::GEN_TEMP2);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_ApplyFog(const PixelFuncID &id) {
+	if (!id.applyFog || id.clearMode)
+		return true;
+
+	Describe("ApplyFog");
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	ARM64Reg colorReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	ARM64Reg fogColorReg = regCache_.Alloc(RegCache::VEC_TEMP1);
+	ARM64Reg fogMulReg = regCache_.Alloc(RegCache::VEC_TEMP2);
+
+	// Expand everything to 16-bit lanes, the products fit.
+	ARM64Reg idReg = GetPixelID();
+	fp.LDR(32, INDEX_UNSIGNED, fogColorReg, idReg, offsetof(PixelFuncID, cached.fogColor));
+	UnlockPixelID(idReg);
+	fp.UXTL(8, fogColorReg, fogColorReg);
+	fp.UXTL(8, colorReg, argColorReg);
+
+	// Now multiply: prim_color.rgb() * fog + fogColor * (255 - fog) + 255.
+	ARM64Reg argFogReg = regCache_.Find(RegCache::GEN_ARG_FOG);
+	ARM64Reg invFogReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	fp.DUP(16, fogMulReg, DecodeReg(argFogReg));
+	fp.MUL(16, colorReg, colorReg, fogMulReg);
+	MOVI2R(DecodeReg(invFogReg), 255);
+	SUB(DecodeReg(invFogReg), DecodeReg(invFogReg), DecodeReg(argFogReg));
+	fp.DUP(16, fogMulReg, DecodeReg(invFogReg));
+	fp.MLA(16, colorReg, fogColorReg, fogMulReg);
+	MOVI2R(DecodeReg(invFogReg), 255);
+	fp.DUP(16, fogMulReg, DecodeReg(invFogReg));
+	fp.ADD(16, colorReg, colorReg, fogMulReg);
+	regCache_.Release(invFogReg, RegCache::GEN_TEMP0);
+	regCache_.Unlock(argFogReg, RegCache::GEN_ARG_FOG);
+
+	// Divide by 256 and pack back, then put the original alpha back in.
+	fp.USHR(16, colorReg, colorReg, 8);
+	fp.XTN(8, EncodeRegToDouble(colorReg), colorReg);
+	fp.INS(8, colorReg, 3, argColorReg, 3);
+	fp.MOV(argColorReg, colorReg);
+
+	regCache_.Release(colorReg, RegCache::VEC_TEMP0);
+	regCache_.Release(fogColorReg, RegCache::VEC_TEMP1);
+	regCache_.Release(fogMulReg, RegCache::VEC_TEMP2);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_StencilAndDepthTest(const PixelFuncID &id) {
+	_assert_(!id.clearMode && id.stencilTest);
+
+	ARM64Reg stencilReg = GetDestStencil(id);
+	Describe("StencilAndDepth");
+	ARM64Reg maskedReg = stencilReg;
+	if (id.hasStencilTestMask) {
+		ARM64Reg idReg = GetPixelID();
+		maskedReg = regCache_.Alloc(RegCache::GEN_TEMP3);
+		LDRB(INDEX_UNSIGNED, DecodeReg(maskedReg), idReg, offsetof(PixelFuncID, cached.stencilTestMask));
+		AND(DecodeReg(maskedReg), DecodeReg(maskedReg), DecodeReg(stencilReg));
+		UnlockPixelID(idReg);
+	}
+
+	bool success = true;
+	success = success && Jit_StencilTest(id, stencilReg, maskedReg);
+	if (maskedReg != stencilReg)
+		regCache_.Release(maskedReg, RegCache::GEN_TEMP3);
+
+	// Next up, the depth test.
+	if (!id.earlyZChecks)
+		success = success && Jit_DepthTestForStencil(id, stencilReg);
+
+	success = success && Jit_ApplyStencilOp(id, id.ZPass(), stencilReg);
+
+	// At this point, stencilReg can't be spilled.  It contains the updated value.
+	regCache_.Unlock(stencilReg, RegCache::GEN_STENCIL);
+	regCache_.ForceRetain(RegCache::GEN_STENCIL);
+
+	return success;
+}
+
+bool PixelJitCache::Jit_StencilTest(const PixelFuncID &id, RegCache::Reg stencilReg, RegCache::Reg maskedReg) {
+	if (id.StencilTestFunc() == GE_COMP_ALWAYS)
+		return true;
+
+	bool success = true;
+	FixupBranch passed;
+	if (id.StencilTestFunc() != GE_COMP_NEVER) {
+		// The ref is on the left, so the conditions are mirrored for the immediate compare.
+		CCFlags cc = CC_AL;
+		switch (id.StencilTestFunc()) {
+		case GE_COMP_EQUAL: cc = CC_EQ; break;
+		case GE_COMP_NOTEQUAL: cc = CC_NEQ; break;
+		case GE_COMP_LESS: cc = CC_HI; break;
+		case GE_COMP_LEQUAL: cc = CC_HS; break;
+		case GE_COMP_GREATER: cc = CC_LO; break;
+		case GE_COMP_GEQUAL: cc = CC_LS; break;
+		default: break;
+		}
+		CMP(DecodeReg(maskedReg), id.stencilTestRef);
+		passed = B(cc);
+	}
+
+	// Failed, so apply the sfail op and write just the stencil.
+	success = success && Jit_ApplyStencilOp(id, id.SFail(), stencilReg);
+	success = success && Jit_WriteStencilOnly(id, stencilReg);
+	Discard();
+
+	if (id.StencilTestFunc() != GE_COMP_NEVER)
+		SetJumpTarget(passed);
+
+	return success;
+}
+
+bool PixelJitCache::Jit_DepthTestForStencil(const PixelFuncID &id, RegCache::Reg stencilReg) {
+	if (id.DepthTestFunc() == GE_COMP_ALWAYS)
+		return true;
+
+	ARM64Reg depthOffReg = GetDepthOff(id);
+	Describe("DepthTestStencil");
+	ARM64Reg argZReg = regCache_.Find(RegCache::GEN_ARG_Z);
+	ARM64Reg depthReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	ARM64Reg zReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+
+	FixupBranch passed;
+	if (id.DepthTestFunc() != GE_COMP_NEVER) {
+		LDRH(INDEX_UNSIGNED, DecodeReg(depthReg), depthOffReg, 0);
+		// Only the low 16 bits are compared, same as the u16 in the generic path.
+		UXTH(DecodeReg(zReg), DecodeReg(argZReg));
+		CMP(DecodeReg(zReg), DecodeReg(depthReg));
+		passed = B(ComparisonPassCC(id.DepthTestFunc()));
+	}
+	regCache_.Release(depthReg, RegCache::GEN_TEMP0);
+	regCache_.Release(zReg, RegCache::GEN_TEMP1);
+	regCache_.Unlock(argZReg, RegCache::GEN_ARG_Z);
+	regCache_.Unlock(depthOffReg, RegCache::GEN_DEPTH_OFF);
+
+	bool success = true;
+	success = success && Jit_ApplyStencilOp(id, id.ZFail(), stencilReg);
+	success = success && Jit_WriteStencilOnly(id, stencilReg);
+	Discard();
+
+	if (id.DepthTestFunc() != GE_COMP_NEVER)
+		SetJumpTarget(passed);
+
+	return success;
+}
+
+bool PixelJitCache::Jit_ApplyStencilOp(const PixelFuncID &id, GEStencilOp op, RegCache::Reg stencilReg) {
+	_assert_(stencilReg != INVALID_REG);
+	ARM64Reg s = DecodeReg(stencilReg);
+
+	Describe("ApplyStencil");
+	ARM64Reg tempReg = INVALID_REG;
+	switch (op) {
+	case GE_STENCILOP_KEEP:
+		break;
+
+	case GE_STENCILOP_ZERO:
+		MOVI2R(s, 0);
+		break;
+
+	case GE_STENCILOP_REPLACE:
+		if (id.hasStencilTestMask) {
+			// Load the unmasked value.
+			ARM64Reg idReg = GetPixelID();
+			LDRB(INDEX_UNSIGNED, s, idReg, offsetof(PixelFuncID, cached.stencilRef));
+			UnlockPixelID(idReg);
+		} else {
+			MOVI2R(s, id.stencilTestRef);
+		}
+		break;
+
+	case GE_STENCILOP_INVERT:
+		MVN(s, s);
+		UXTB(s, s);
+		break;
+
+	case GE_STENCILOP_INCR:
+		switch (id.fbFormat) {
+		case GE_FORMAT_565:
+			break;
+
+		case GE_FORMAT_5551:
+			MOVI2R(s, 0xFF);
+			break;
+
+		case GE_FORMAT_4444:
+			tempReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+			ADD(DecodeReg(tempReg), s, 0x10);
+			CMP(s, 0xF0);
+			CSEL(s, DecodeReg(tempReg), s, CC_LO);
+			regCache_.Release(tempReg, RegCache::GEN_TEMP0);
+			break;
+
+		case GE_FORMAT_8888:
+			CMP(s, 0xFF);
+			CSINC(s, s, s, CC_EQ);
+			break;
+		}
+		break;
+
+	case GE_STENCILOP_DECR:
+		switch (id.fbFormat) {
+		case GE_FORMAT_565:
+			break;
+
+		case GE_FORMAT_5551:
+			MOVI2R(s, 0);
+			break;
+
+		case GE_FORMAT_4444:
+			tempReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+			SUBS(DecodeReg(tempReg), s, 0x10);
+			CSEL(s, DecodeReg(tempReg), s, CC_HS);
+			regCache_.Release(tempReg, RegCache::GEN_TEMP0);
+			break;
+
+		case GE_FORMAT_8888:
+			tempReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+			SUBS(DecodeReg(tempReg), s, 1);
+			CSEL(s, DecodeReg(tempReg), s, CC_HS);
+			regCache_.Release(tempReg, RegCache::GEN_TEMP0);
+			break;
+		}
+		break;
+	}
+
+	return true;
+}
+
+bool PixelJitCache::Jit_WriteStencilOnly(const PixelFuncID &id, RegCache::Reg stencilReg) {
+	_assert_(stencilReg != INVALID_REG);
+
+	// It's okay to destroy stencilReg here, we know we're the last writing it.
+	ARM64Reg s = DecodeReg(stencilReg);
+	ARM64Reg colorOffReg = GetColorOff(id);
+	Describe("WriteStencilOnly");
+
+	ARM64Reg maskReg = INVALID_REG;
+	ARM64Reg idReg = INVALID_REG;
+	if (id.applyColorWriteMask) {
+		idReg = GetPixelID();
+		maskReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	}
+
+	switch (id.fbFormat) {
+	case GE_FORMAT_565:
+		break;
+
+	case GE_FORMAT_5551:
+	{
+		FixupBranch skip;
+		if (id.applyColorWriteMask) {
+			LDR(INDEX_UNSIGNED, DecodeReg(maskReg), idReg, offsetof(PixelFuncID, cached.colorWriteMask));
+			skip = TBNZ(DecodeReg(maskReg), 15);
+		}
+
+		ARM64Reg pixelReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+		LDRH(INDEX_UNSIGNED, DecodeReg(pixelReg), colorOffReg, 0);
+		LSR(s, s, 7);
+		BFI(DecodeReg(pixelReg), s, 15, 1);
+		STRH(INDEX_UNSIGNED, DecodeReg(pixelReg), colorOffReg, 0);
+		regCache_.Release(pixelReg, RegCache::GEN_TEMP0);
+
+		if (id.applyColorWriteMask)
+			SetJumpTarget(skip);
+		break;
+	}
+
+	case GE_FORMAT_4444:
+	{
+		ARM64Reg pixelReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+		LDRH(INDEX_UNSIGNED, DecodeReg(pixelReg), colorOffReg, 0);
+		if (id.applyColorWriteMask) {
+			LDR(INDEX_UNSIGNED, DecodeReg(maskReg), idReg, offsetof(PixelFuncID, cached.colorWriteMask));
+			ORRI2R(DecodeReg(maskReg), DecodeReg(maskReg), 0x0FFF);
+			LSL(s, s, 8);
+			AND(DecodeReg(pixelReg), DecodeReg(pixelReg), DecodeReg(maskReg));
+			BIC(s, s, DecodeReg(maskReg));
+			ORR(DecodeReg(pixelReg), DecodeReg(pixelReg), s);
+		} else {
+			LSR(s, s, 4);
+			BFI(DecodeReg(pixelReg), s, 12, 4);
+		}
+		STRH(INDEX_UNSIGNED, DecodeReg(pixelReg), colorOffReg, 0);
+		regCache_.Release(pixelReg, RegCache::GEN_TEMP0);
+		break;
+	}
+
+	case GE_FORMAT_8888:
+		if (id.applyColorWriteMask) {
+			// Only the top byte of the mask matters here.
+			ARM64Reg pixelReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+			LDRB(INDEX_UNSIGNED, DecodeReg(maskReg), idReg, offsetof(PixelFuncID, cached.colorWriteMask) + 3);
+			LDRB(INDEX_UNSIGNED, DecodeReg(pixelReg), colorOffReg, 3);
+			AND(DecodeReg(pixelReg), DecodeReg(pixelReg), DecodeReg(maskReg));
+			BIC(s, s, DecodeReg(maskReg));
+			ORR(s, s, DecodeReg(pixelReg));
+			regCache_.Release(pixelReg, RegCache::GEN_TEMP0);
+		}
+		STRB(INDEX_UNSIGNED, s, colorOffReg, 3);
+		break;
+	}
+
+	if (maskReg != INVALID_REG)
+		regCache_.Release(maskReg, RegCache::GEN_TEMP1);
+	if (idReg != INVALID_REG)
+		UnlockPixelID(idReg);
+	regCache_.Unlock(colorOffReg, RegCache::GEN_COLOR_OFF);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_DepthTest(const PixelFuncID &id) {
+	if (id.DepthTestFunc() == GE_COMP_ALWAYS || id.earlyZChecks)
+		return true;
+
+	if (id.DepthTestFunc() == GE_COMP_NEVER) {
+		Discard();
+		return true;
+	}
+
+	ARM64Reg depthOffReg = GetDepthOff(id);
+	Describe("DepthTest");
+	ARM64Reg argZReg = regCache_.Find(RegCache::GEN_ARG_Z);
+	ARM64Reg depthReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	ARM64Reg zReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+
+	LDRH(INDEX_UNSIGNED, DecodeReg(depthReg), depthOffReg, 0);
+	UXTH(DecodeReg(zReg), DecodeReg(argZReg));
+	CMP(DecodeReg(zReg), DecodeReg(depthReg));
+	Discard(InvertCond(ComparisonPassCC(id.DepthTestFunc())));
+
+	regCache_.Release(depthReg, RegCache::GEN_TEMP0);
+	regCache_.Release(zReg, RegCache::GEN_TEMP1);
+	regCache_.Unlock(argZReg, RegCache::GEN_ARG_Z);
+	regCache_.Unlock(depthOffReg, RegCache::GEN_DEPTH_OFF);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_WriteDepth(const PixelFuncID &id) {
+	// Clear mode shares depthWrite for DepthClear().
+	if (id.depthWrite) {
+		ARM64Reg depthOffReg = GetDepthOff(id);
+		Describe("WriteDepth");
+		ARM64Reg argZReg = regCache_.Find(RegCache::GEN_ARG_Z);
+		STRH(INDEX_UNSIGNED, DecodeReg(argZReg), depthOffReg, 0);
+		regCache_.Unlock(argZReg, RegCache::GEN_ARG_Z);
+		regCache_.Unlock(depthOffReg, RegCache::GEN_DEPTH_OFF);
+	}
+
+	return true;
+}
+
+bool PixelJitCache::Jit_AlphaBlend(const PixelFuncID &id) {
+	if (!id.alphaBlend || id.clearMode)
+		return true;
+
+	bool success = true;
+	PixelBlendState blendState;
+	ComputePixelBlendState(blendState, id);
+
+	// Everything below works on 32-bit lanes, same as the generic NEON path.
+	ARM64Reg dstReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	if (blendState.readsDstPixel) {
+		ARM64Reg colorOffReg = GetColorOff(id);
+		Describe("AlphaBlend");
+
+		if (id.FBFormat() == GE_FORMAT_8888) {
+			fp.LDR(32, INDEX_UNSIGNED, dstReg, colorOffReg, 0);
+		} else {
+			ARM64Reg pixelReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+			ARM64Reg temp1Reg = regCache_.Alloc(RegCache::GEN_TEMP1);
+			ARM64Reg temp2Reg = regCache_.Alloc(RegCache::GEN_TEMP2);
+			LDRH(INDEX_UNSIGNED, DecodeReg(pixelReg), colorOffReg, 0);
+
+			switch (id.fbFormat) {
+			case GE_FORMAT_565:
+				success = success && Jit_ConvertFrom565(id, pixelReg, temp1Reg, temp2Reg);
+				break;
+
+			case GE_FORMAT_5551:
+				success = success && Jit_ConvertFrom5551(id, pixelReg, temp1Reg, temp2Reg, blendState.usesDstAlpha);
+				break;
+
+			case GE_FORMAT_4444:
+				success = success && Jit_ConvertFrom4444(id, pixelReg, temp1Reg, temp2Reg, blendState.usesDstAlpha);
+				break;
+
+			case GE_FORMAT_8888:
+				break;
+			}
+
+			fp.INS(32, dstReg, 0, DecodeReg(pixelReg));
+			regCache_.Release(pixelReg, RegCache::GEN_TEMP0);
+			regCache_.Release(temp1Reg, RegCache::GEN_TEMP1);
+			regCache_.Release(temp2Reg, RegCache::GEN_TEMP2);
+		}
+		regCache_.Unlock(colorOffReg, RegCache::GEN_COLOR_OFF);
+
+		fp.UXTL(8, dstReg, dstReg);
+		fp.UXTL(16, dstReg, dstReg);
+	} else {
+		Describe("AlphaBlend");
+	}
+
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	fp.UXTL(8, argColorReg, argColorReg);
+	fp.UXTL(16, argColorReg, argColorReg);
+
+	if (blendState.usesFactors) {
+		ARM64Reg srcFactorReg = regCache_.Alloc(RegCache::VEC_TEMP1);
+		ARM64Reg dstFactorReg = regCache_.Alloc(RegCache::VEC_TEMP2);
+		success = success && Jit_BlendFactor(id, srcFactorReg, dstReg, id.AlphaBlendSrc());
+		success = success && Jit_DstBlendFactor(id, srcFactorReg, dstFactorReg, dstReg);
+
+		// Now for the multiply: ((2 * color + 1) * (2 * factor + 1)) / 1024.
+		ARM64Reg oneReg = regCache_.Alloc(RegCache::VEC_TEMP3);
+		ARM64Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+		MOVI2R(DecodeReg(tempReg), 1);
+		fp.DUP(32, oneReg, DecodeReg(tempReg));
+		regCache_.Release(tempReg, RegCache::GEN_TEMP0);
+
+		auto applyFactor = [&](ARM64Reg colorReg, ARM64Reg factorReg, PixelBlendFactor factor) {
+			if (factor == PixelBlendFactor::ZERO) {
+				fp.EOR(colorReg, colorReg, colorReg);
+			} else if (factor != PixelBlendFactor::ONE) {
+				fp.ADD(32, colorReg, colorReg, colorReg);
+				fp.ADD(32, colorReg, colorReg, oneReg);
+				fp.ADD(32, factorReg, factorReg, factorReg);
+				fp.ADD(32, factorReg, factorReg, oneReg);
+				fp.MUL(32, colorReg, colorReg, factorReg);
+				fp.USHR(32, colorReg, colorReg, 10);
+			}
+		};
+		applyFactor(argColorReg, srcFactorReg, id.AlphaBlendSrc());
+		applyFactor(dstReg, dstFactorReg, id.AlphaBlendDst());
+
+		regCache_.Release(oneReg, RegCache::VEC_TEMP3);
+		regCache_.Release(srcFactorReg, RegCache::VEC_TEMP1);
+		regCache_.Release(dstFactorReg, RegCache::VEC_TEMP2);
+	}
+
+	switch (id.AlphaBlendEq()) {
+	case GE_BLENDMODE_MUL_AND_ADD:
+		fp.ADD(32, argColorReg, argColorReg, dstReg);
+		break;
+
+	case GE_BLENDMODE_MUL_AND_SUBTRACT:
+		fp.UQSUB(32, argColorReg, argColorReg, dstReg);
+		break;
+
+	case GE_BLENDMODE_MUL_AND_SUBTRACT_REVERSE:
+		fp.UQSUB(32, argColorReg, dstReg, argColorReg);
+		break;
+
+	case GE_BLENDMODE_MIN:
+		fp.UMIN(32, argColorReg, argColorReg, dstReg);
+		break;
+
+	case GE_BLENDMODE_MAX:
+		fp.UMAX(32, argColorReg, argColorReg, dstReg);
+		break;
+
+	case GE_BLENDMODE_ABSDIFF:
+		fp.UABD(32, argColorReg, argColorReg, dstReg);
+		break;
+
+	default:
+		break;
+	}
+
+	// This can't overflow 16 bits, and it leaves room for a signed dither.
+	fp.XTN(16, EncodeRegToDouble(argColorReg), argColorReg);
+	colorIs16Bit_ = true;
+
+	regCache_.Release(dstReg, RegCache::VEC_TEMP0);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+
+	return success;
+}
+
+// Returns a vector with 255 in each 32-bit lane.
+static void LoadBlendInvert(ARM64XEmitter *emit, ARM64FloatEmitter *fp, RegCache &regCache, ARM64Reg vecReg) {
+	ARM64Reg tempReg = regCache.Alloc(RegCache::GEN_TEMP0);
+	emit->MOVI2R(DecodeReg(tempReg), 255);
+	fp->DUP(32, vecReg, DecodeReg(tempReg));
+	regCache.Release(tempReg, RegCache::GEN_TEMP0);
+}
+
+bool PixelJitCache::Jit_BlendFactor(const PixelFuncID &id, RegCache::Reg factorReg, RegCache::Reg dstReg, PixelBlendFactor factor) {
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	ARM64Reg idReg = INVALID_REG;
+
+	// Between source and dest factors, only DSTCOLOR, INVDSTCOLOR, and FIXA differ.
+	// In those cases, it uses SRCCOLOR, INVSRCCOLOR, and FIXB respectively.
+	switch (factor) {
+	case PixelBlendFactor::OTHERCOLOR:
+		fp.MOV(factorReg, dstReg);
+		break;
+
+	case PixelBlendFactor::INVOTHERCOLOR:
+		LoadBlendInvert(this, &fp, regCache_, factorReg);
+		fp.UQSUB(32, factorReg, factorReg, dstReg);
+		break;
+
+	case PixelBlendFactor::SRCALPHA:
+		fp.DUP(32, factorReg, argColorReg, 3);
+		break;
+
+	case PixelBlendFactor::INVSRCALPHA:
+	case PixelBlendFactor::DOUBLEINVSRCALPHA:
+	{
+		ARM64Reg alphaReg = regCache_.Alloc(RegCache::VEC_TEMP4);
+		fp.DUP(32, alphaReg, argColorReg, 3);
+		if (factor == PixelBlendFactor::DOUBLEINVSRCALPHA)
+			fp.ADD(32, alphaReg, alphaReg, alphaReg);
+		// Saturating, so the double variant clamps to zero.
+		LoadBlendInvert(this, &fp, regCache_, factorReg);
+		fp.UQSUB(32, factorReg, factorReg, alphaReg);
+		regCache_.Release(alphaReg, RegCache::VEC_TEMP4);
+		break;
+	}
+
+	case PixelBlendFactor::DSTALPHA:
+		fp.DUP(32, factorReg, dstReg, 3);
+		break;
+
+	case PixelBlendFactor::INVDSTALPHA:
+	case PixelBlendFactor::DOUBLEINVDSTALPHA:
+	{
+		ARM64Reg alphaReg = regCache_.Alloc(RegCache::VEC_TEMP4);
+		fp.DUP(32, alphaReg, dstReg, 3);
+		if (factor == PixelBlendFactor::DOUBLEINVDSTALPHA)
+			fp.ADD(32, alphaReg, alphaReg, alphaReg);
+		LoadBlendInvert(this, &fp, regCache_, factorReg);
+		fp.UQSUB(32, factorReg, factorReg, alphaReg);
+		regCache_.Release(alphaReg, RegCache::VEC_TEMP4);
+		break;
+	}
+
+	case PixelBlendFactor::DOUBLESRCALPHA:
+		fp.DUP(32, factorReg, argColorReg, 3);
+		fp.ADD(32, factorReg, factorReg, factorReg);
+		break;
+
+	case PixelBlendFactor::DOUBLEDSTALPHA:
+		fp.DUP(32, factorReg, dstReg, 3);
+		fp.ADD(32, factorReg, factorReg, factorReg);
+		break;
+
+	case PixelBlendFactor::ZERO:
+	case PixelBlendFactor::ONE:
+		// Handled when applying the factor.
+		break;
+
+	case PixelBlendFactor::FIX:
+	default:
+		idReg = GetPixelID();
+		fp.LDR(32, INDEX_UNSIGNED, factorReg, idReg, offsetof(PixelFuncID, cached.alphaBlendSrc));
+		fp.UXTL(8, factorReg, factorReg);
+		fp.UXTL(16, factorReg, factorReg);
+		break;
+	}
+
+	if (idReg != INVALID_REG)
+		UnlockPixelID(idReg);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_DstBlendFactor(const PixelFuncID &id, RegCache::Reg srcFactorReg, RegCache::Reg dstFactorReg, RegCache::Reg dstReg) {
+	bool success = true;
+	ARM64Reg idReg = INVALID_REG;
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+
+	PixelBlendState blendState;
+	ComputePixelBlendState(blendState, id);
+
+	// We might be able to reuse srcFactorReg for dst, in some cases.
+	switch (id.AlphaBlendDst()) {
+	case PixelBlendFactor::OTHERCOLOR:
+		fp.MOV(dstFactorReg, argColorReg);
+		break;
+
+	case PixelBlendFactor::INVOTHERCOLOR:
+		LoadBlendInvert(this, &fp, regCache_, dstFactorReg);
+		fp.UQSUB(32, dstFactorReg, dstFactorReg, argColorReg);
+		break;
+
+	case PixelBlendFactor::SRCALPHA:
+	case PixelBlendFactor::INVSRCALPHA:
+	case PixelBlendFactor::DSTALPHA:
+	case PixelBlendFactor::INVDSTALPHA:
+	case PixelBlendFactor::DOUBLESRCALPHA:
+	case PixelBlendFactor::DOUBLEINVSRCALPHA:
+	case PixelBlendFactor::DOUBLEDSTALPHA:
+	case PixelBlendFactor::DOUBLEINVDSTALPHA:
+	case PixelBlendFactor::ZERO:
+	case PixelBlendFactor::ONE:
+		// These are all equivalent for src factor, so reuse that logic.
+		if (id.AlphaBlendSrc() == id.AlphaBlendDst()) {
+			fp.MOV(dstFactorReg, srcFactorReg);
+		} else if (blendState.dstFactorIsInverse) {
+			LoadBlendInvert(this, &fp, regCache_, dstFactorReg);
+			fp.UQSUB(32, dstFactorReg, dstFactorReg, srcFactorReg);
+		} else {
+			success = success && Jit_BlendFactor(id, dstFactorReg, dstReg, id.AlphaBlendDst());
+		}
+		break;
+
+	case PixelBlendFactor::FIX:
+	default:
+		idReg = GetPixelID();
+		fp.LDR(32, INDEX_UNSIGNED, dstFactorReg, idReg, offsetof(PixelFuncID, cached.alphaBlendDst));
+		fp.UXTL(8, dstFactorReg, dstFactorReg);
+		fp.UXTL(16, dstFactorReg, dstFactorReg);
+		break;
+	}
+
+	if (idReg != INVALID_REG)
+		UnlockPixelID(idReg);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+
+	return success;
+}
+
+bool PixelJitCache::Jit_Dither(const PixelFuncID &id) {
+	if (!id.dithering)
+		return true;
+
+	Describe("Dither");
+	ARM64Reg argXReg = regCache_.Find(RegCache::GEN_ARG_X);
+	ARM64Reg argYReg = regCache_.Find(RegCache::GEN_ARG_Y);
+	ARM64Reg valueReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+
+	// Load the dither value, (y & 3) * 4 + (x & 3), sign extended.
+	UBFIZ(DecodeReg(valueReg), DecodeReg(argYReg), 2, 2);
+	BFI(DecodeReg(valueReg), DecodeReg(argXReg), 0, 2);
+	regCache_.Unlock(argXReg, RegCache::GEN_ARG_X);
+	regCache_.Unlock(argYReg, RegCache::GEN_ARG_Y);
+
+	ARM64Reg idReg = GetPixelID();
+	ADD(valueReg, valueReg, idReg);
+	LDRSB(INDEX_UNSIGNED, DecodeReg(valueReg), valueReg, offsetof(PixelFuncID, cached.ditherMatrix));
+	UnlockPixelID(idReg);
+
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	if (!colorIs16Bit_) {
+		fp.UXTL(8, argColorReg, argColorReg);
+		colorIs16Bit_ = true;
+	}
+
+	// Now add and clamp.  Alpha is ignored, so it's fine to dither that too.
+	ARM64Reg ditherReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	fp.DUP(16, ditherReg, DecodeReg(valueReg));
+	fp.SQADD(16, argColorReg, argColorReg, ditherReg);
+	fp.SQXTUN(8, EncodeRegToDouble(argColorReg), argColorReg);
+	colorIs16Bit_ = false;
+
+	regCache_.Release(ditherReg, RegCache::VEC_TEMP0);
+	regCache_.Release(valueReg, RegCache::GEN_TEMP0);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_WriteColor(const PixelFuncID &id) {
+	// Clear mode with neither color nor stencil writes nothing.
+	if (id.clearMode && !id.ColorClear() && !id.StencilClear()) {
+		return true;
+	}
+
+	ARM64Reg colorOffReg = GetColorOff(id);
+	Describe("WriteColor");
+
+	ARM64Reg argColorReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	if (colorIs16Bit_) {
+		fp.UQXTN(8, EncodeRegToDouble(argColorReg), argColorReg);
+		colorIs16Bit_ = false;
+	}
+
+	ARM64Reg colorReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	fp.UMOV(32, DecodeReg(colorReg), argColorReg, 0);
+	regCache_.Unlock(argColorReg, RegCache::VEC_ARG_COLOR);
+
+	// Clear mode already has the alpha as stencil.  Otherwise it's the updated stencil.
+	if (id.stencilTest && !id.clearMode) {
+		ARM64Reg stencilReg = regCache_.Find(RegCache::GEN_STENCIL);
+		BFI(DecodeReg(colorReg), DecodeReg(stencilReg), 24, 8);
+		regCache_.Unlock(stencilReg, RegCache::GEN_STENCIL);
+	}
+
+	// Bits of the old pixel we keep, in the framebuffer format.
+	uint32_t rgbBits = 0x00FFFFFF;
+	uint32_t stencilBits = 0xFF000000;
+	uint32_t formatBits = 0xFFFFFFFF;
+	ARM64Reg temp1Reg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	ARM64Reg temp2Reg = regCache_.Alloc(RegCache::GEN_TEMP2);
+	bool success = true;
+	switch (id.fbFormat) {
+	case GE_FORMAT_565:
+		success = success && Jit_ConvertTo565(id, colorReg, temp1Reg, temp2Reg);
+		rgbBits = 0xFFFF;
+		stencilBits = 0;
+		formatBits = 0xFFFF;
+		break;
+
+	case GE_FORMAT_5551:
+		success = success && Jit_ConvertTo5551(id, colorReg, temp1Reg, temp2Reg, true);
+		rgbBits = 0x7FFF;
+		stencilBits = 0x8000;
+		formatBits = 0xFFFF;
+		break;
+
+	case GE_FORMAT_4444:
+		success = success && Jit_ConvertTo4444(id, colorReg, temp1Reg, temp2Reg, true);
+		rgbBits = 0x0FFF;
+		stencilBits = 0xF000;
+		formatBits = 0xFFFF;
+		break;
+
+	case GE_FORMAT_8888:
+		break;
+	}
+
+	uint32_t fixedKeepMask = 0;
+	if (id.clearMode) {
+		if (!id.ColorClear())
+			fixedKeepMask |= rgbBits;
+		if (!id.StencilClear())
+			fixedKeepMask |= stencilBits;
+	} else if (!id.stencilTest) {
+		// Without a stencil test, the stencil stays as it was.
+		fixedKeepMask |= stencilBits;
+	}
+
+	bool needsOld = fixedKeepMask != 0 || id.applyColorWriteMask || (id.applyLogicOp && !id.clearMode);
+	ARM64Reg oldReg = INVALID_REG;
+	if (needsOld) {
+		oldReg = regCache_.Alloc(RegCache::GEN_TEMP3);
+		if (id.FBFormat() == GE_FORMAT_8888)
+			LDR(INDEX_UNSIGNED, DecodeReg(oldReg), colorOffReg, 0);
+		else
+			LDRH(INDEX_UNSIGNED, DecodeReg(oldReg), colorOffReg, 0);
+	}
+
+	if (id.applyLogicOp && !id.clearMode) {
+		// The conversions are just bit selection, so we can do this in the framebuffer format.
+		success = success && Jit_ApplyLogicOp(id, colorReg, oldReg);
+	}
+
+	if (id.applyColorWriteMask) {
+		ARM64Reg idReg = GetPixelID();
+		LDR(INDEX_UNSIGNED, DecodeReg(temp1Reg), idReg, offsetof(PixelFuncID, cached.colorWriteMask));
+		UnlockPixelID(idReg);
+		if (fixedKeepMask != 0)
+			ORRI2R(DecodeReg(temp1Reg), DecodeReg(temp1Reg), fixedKeepMask, DecodeReg(temp2Reg));
+
+		BIC(DecodeReg(colorReg), DecodeReg(colorReg), DecodeReg(temp1Reg));
+		AND(DecodeReg(oldReg), DecodeReg(oldReg), DecodeReg(temp1Reg));
+		ORR(DecodeReg(colorReg), DecodeReg(colorReg), DecodeReg(oldReg));
+	} else if (fixedKeepMask != 0) {
+		ANDI2R(DecodeReg(colorReg), DecodeReg(colorReg), formatBits & ~fixedKeepMask, DecodeReg(temp2Reg));
+		ANDI2R(DecodeReg(oldReg), DecodeReg(oldReg), fixedKeepMask, DecodeReg(temp2Reg));
+		ORR(DecodeReg(colorReg), DecodeReg(colorReg), DecodeReg(oldReg));
+	}
+
+	if (id.FBFormat() == GE_FORMAT_8888)
+		STR(INDEX_UNSIGNED, DecodeReg(colorReg), colorOffReg, 0);
+	else
+		STRH(INDEX_UNSIGNED, DecodeReg(colorReg), colorOffReg, 0);
+
+	if (oldReg != INVALID_REG)
+		regCache_.Release(oldReg, RegCache::GEN_TEMP3);
+	regCache_.Release(temp1Reg, RegCache::GEN_TEMP1);
+	regCache_.Release(temp2Reg, RegCache::GEN_TEMP2);
+	regCache_.Release(colorReg, RegCache::GEN_TEMP0);
+	regCache_.Unlock(colorOffReg, RegCache::GEN_COLOR_OFF);
+	if (regCache_.Has(RegCache::GEN_STENCIL))
+		regCache_.ForceRelease(RegCache::GEN_STENCIL);
+
+	return success;
+}
+
+bool PixelJitCache::Jit_ApplyLogicOp(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg oldReg) {
+	Describe("LogicOp");
+	ARM64Reg n = DecodeReg(colorReg);
+	ARM64Reg o = DecodeReg(oldReg);
+
+	// The result goes in a temp, since we need both the old and new values until the end.
+	ARM64Reg opReg = regCache_.Alloc(RegCache::GEN_TEMP4);
+	ARM64Reg resultReg = regCache_.Alloc(RegCache::GEN_TEMP5);
+	ARM64Reg r = DecodeReg(resultReg);
+
+	ARM64Reg idReg = GetPixelID();
+	LDRB(INDEX_UNSIGNED, DecodeReg(opReg), idReg, offsetof(PixelFuncID, cached.logicOp));
+	UnlockPixelID(idReg);
+
+	// The op is only known at runtime, so jump into a table of fixed size slots.
+	static constexpr int SLOT_SIZE = 16;
+	ADR(resultReg, 12);
+	ADD(resultReg, resultReg, opReg, ArithOption(opReg, ST_LSL, 4));
+	BR(resultReg);
+
+	std::vector<FixupBranch> finishes;
+	finishes.reserve(16);
+	for (int op = GE_LOGIC_CLEAR; op <= GE_LOGIC_SET; ++op) {
+		const u8 *slotStart = GetCodePointer();
+		switch ((GELogicOp)op) {
+		case GE_LOGIC_CLEAR:
+			MOVI2R(r, 0);
+			break;
+
+		case GE_LOGIC_AND:
+			AND(r, n, o);
+			break;
+
+		case GE_LOGIC_AND_REVERSE:
+			BIC(r, n, o);
+			break;
+
+		case GE_LOGIC_COPY:
+			MOV(r, n);
+			break;
+
+		case GE_LOGIC_AND_INVERTED:
+			BIC(r, o, n);
+			break;
+
+		case GE_LOGIC_NOOP:
+			MOV(r, o);
+			break;
+
+		case GE_LOGIC_XOR:
+			EOR(r, n, o);
+			break;
+
+		case GE_LOGIC_OR:
+			ORR(r, n, o);
+			break;
+
+		case GE_LOGIC_NOR:
+			ORR(r, n, o);
+			MVN(r, r);
+			break;
+
+		case GE_LOGIC_EQUIV:
+			EON(r, n, o);
+			break;
+
+		case GE_LOGIC_INVERTED:
+			MVN(r, o);
+			break;
+
+		case GE_LOGIC_OR_REVERSE:
+			ORN(r, n, o);
+			break;
+
+		case GE_LOGIC_COPY_INVERTED:
+			MVN(r, n);
+			break;
+
+		case GE_LOGIC_OR_INVERTED:
+			ORN(r, o, n);
+			break;
+
+		case GE_LOGIC_NAND:
+			AND(r, n, o);
+			MVN(r, r);
+			break;
+
+		case GE_LOGIC_SET:
+			MVN(r, WZR);
+			break;
+		}
+
+		finishes.push_back(B());
+		_assert_(GetCodePointer() <= slotStart + SLOT_SIZE);
+		while (GetCodePointer() < slotStart + SLOT_SIZE)
+			HINT(HINT_NOP);
+	}
+
+	for (FixupBranch &fixup : finishes)
+		SetJumpTarget(fixup);
+
+	// Logic ops don't affect stencil, so keep those bits from the new color.
+	switch (id.fbFormat) {
+	case GE_FORMAT_565:
+		ANDI2R(n, r, 0xFFFF);
+		break;
+
+	case GE_FORMAT_5551:
+		ANDI2R(r, r, 0x7FFF);
+		ANDI2R(n, n, 0x8000);
+		ORR(n, n, r);
+		break;
+
+	case GE_FORMAT_4444:
+		ANDI2R(r, r, 0x0FFF);
+		ANDI2R(n, n, 0xF000);
+		ORR(n, n, r);
+		break;
+
+	case GE_FORMAT_8888:
+		ANDI2R(r, r, 0x00FFFFFF);
+		ANDI2R(n, n, 0xFF000000);
+		ORR(n, n, r);
+		break;
+	}
+
+	regCache_.Release(opReg, RegCache::GEN_TEMP4);
+	regCache_.Release(resultReg, RegCache::GEN_TEMP5);
+
+	return true;
+}
+
+bool PixelJitCache::Jit_ConvertTo565(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg temp1Reg, RegCache::Reg temp2Reg) {
+	Describe("ConvertTo565");
+	ARM64Reg c = DecodeReg(colorReg);
+	ARM64Reg t1 = DecodeReg(temp1Reg);
+	ARM64Reg t2 = DecodeReg(temp2Reg);
+
+	// Take the top bits of each channel and pack them in place.
+	UBFX(t1, c, 3, 5);
+	LSR(t2, c, 10);
+	BFI(t1, t2, 5, 6);
+	LSR(t2, c, 19);
+	BFI(t1, t2, 11, 5);
+	MOV(c, t1);
+	return true;
+}
+
+bool PixelJitCache::Jit_ConvertTo5551(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg temp1Reg, RegCache::Reg temp2Reg, bool keepAlpha) {
+	Describe("ConvertTo5551");
+	ARM64Reg c = DecodeReg(colorReg);
+	ARM64Reg t1 = DecodeReg(temp1Reg);
+	ARM64Reg t2 = DecodeReg(temp2Reg);
+
+	UBFX(t1, c, 3, 5);
+	LSR(t2, c, 11);
+	BFI(t1, t2, 5, 5);
+	LSR(t2, c, 19);
+	BFI(t1, t2, 10, 5);
+	if (keepAlpha) {
+		LSR(t2, c, 31);
+		BFI(t1, t2, 15, 1);
+	}
+	MOV(c, t1);
+	return true;
+}
+
+bool PixelJitCache::Jit_ConvertTo4444(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg temp1Reg, RegCache::Reg temp2Reg, bool keepAlpha) {
+	Describe("ConvertTo4444");
+	ARM64Reg c = DecodeReg(colorReg);
+	ARM64Reg t1 = DecodeReg(temp1Reg);
+	ARM64Reg t2 = DecodeReg(temp2Reg);
+
+	UBFX(t1, c, 4, 4);
+	LSR(t2, c, 12);
+	BFI(t1, t2, 4, 4);
+	LSR(t2, c, 20);
+	BFI(t1, t2, 8, 4);
+	if (keepAlpha) {
+		LSR(t2, c, 28);
+		BFI(t1, t2, 12, 4);
+	}
+	MOV(c, t1);
+	return true;
+}
+
+// Expands a channel of the 16-bit pixel in srcReg to 8 bits, replicating the top bits into the bottom.
+static void ExpandChannel(ARM64XEmitter *emit, ARM64Reg dstReg, ARM64Reg srcReg, ARM64Reg tempReg, int srcShift, int bits, int dstShift) {
+	emit->UBFX(tempReg, srcReg, srcShift, bits);
+	emit->LSL(tempReg, tempReg, 8 - bits);
+	emit->ORR(tempReg, tempReg, tempReg, ArithOption(tempReg, ST_LSR, bits));
+	emit->BFI(dstReg, tempReg, dstShift, 8);
+}
+
+bool PixelJitCache::Jit_ConvertFrom565(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg temp1Reg, RegCache::Reg temp2Reg) {
+	Describe("ConvertFrom565");
+	ARM64Reg c = DecodeReg(colorReg);
+	ARM64Reg t1 = DecodeReg(temp1Reg);
+	ARM64Reg t2 = DecodeReg(temp2Reg);
+
+	// There's no alpha, so it ends up zero.
+	MOV(t1, c);
+	MOVI2R(c, 0);
+	ExpandChannel(this, c, t1, t2, 0, 5, 0);
+	ExpandChannel(this, c, t1, t2, 5, 6, 8);
+	ExpandChannel(this, c, t1, t2, 11, 5, 16);
+	return true;
+}
+
+bool PixelJitCache::Jit_ConvertFrom5551(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg temp1Reg, RegCache::Reg temp2Reg, bool keepAlpha) {
+	Describe("ConvertFrom5551");
+	ARM64Reg c = DecodeReg(colorReg);
+	ARM64Reg t1 = DecodeReg(temp1Reg);
+	ARM64Reg t2 = DecodeReg(temp2Reg);
+
+	MOV(t1, c);
+	MOVI2R(c, 0);
+	ExpandChannel(this, c, t1, t2, 0, 5, 0);
+	ExpandChannel(this, c, t1, t2, 5, 5, 8);
+	ExpandChannel(this, c, t1, t2, 10, 5, 16);
+	if (keepAlpha) {
+		// Spread the single alpha bit to all 8 bits.
+		SBFM(t2, t1, 15, 15);
+		BFI(c, t2, 24, 8);
+	}
+	return true;
+}
+
+bool PixelJitCache::Jit_ConvertFrom4444(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg temp1Reg, RegCache::Reg temp2Reg, bool keepAlpha) {
+	Describe("ConvertFrom4444");
+	ARM64Reg c = DecodeReg(colorReg);
+	ARM64Reg t1 = DecodeReg(temp1Reg);
+	ARM64Reg t2 = DecodeReg(temp2Reg);
+
+	MOV(t1, c);
+	MOVI2R(c, 0);
+	ExpandChannel(this, c, t1, t2, 0, 4, 0);
+	ExpandChannel(this, c, t1, t2, 4, 4, 8);
+	ExpandChannel(this, c, t1, t2, 8, 4, 16);
+	if (keepAlpha)
+		ExpandChannel(this, c, t1, t2, 12, 4, 24);
+	return true;
+}
+
+};
+
+#endif
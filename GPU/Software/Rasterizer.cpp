@@ -878,6 +878,50 @@ static inline Vec4<float> EdgeRecip(const Vec4<int> &w0, const Vec4<int> &w1, co
 #endif
 }
 
+// Interpolates a color for all four pixels of a quad at once, one channel per vector.
+// This avoids a broadcast and convert per pixel, and gives identical results to Interpolate().
+static inline void InterpolateQuad(const Vec4<int> &c0, const Vec4<int> &c1, const Vec4<int> &c2, const Vec4<int> &w0, const Vec4<int> &w1, const Vec4<int> &w2, const Vec4<float> &wsum_recip, const Vec4<int> &mask, Vec4<int> result[4]) {
+#if (defined(_M_SSE) || PPSSPP_ARCH(ARM64_NEON)) && !PPSSPP_ARCH(X86)
+	Vec4<float> r = Interpolate((float)c0.x, (float)c1.x, (float)c2.x, w0, w1, w2, wsum_recip);
+	Vec4<float> g = Interpolate((float)c0.y, (float)c1.y, (float)c2.y, w0, w1, w2, wsum_recip);
+	Vec4<float> b = Interpolate((float)c0.z, (float)c1.z, (float)c2.z, w0, w1, w2, wsum_recip);
+	Vec4<float> a = Interpolate((float)c0.w, (float)c1.w, (float)c2.w, w0, w1, w2, wsum_recip);
+
+	// Masked lanes may be garbage, but they're never read.
+#if defined(_M_SSE)
+	_MM_TRANSPOSE4_PS(r.vec, g.vec, b.vec, a.vec);
+	result[0].ivec = _mm_cvtps_epi32(r.vec);
+	result[1].ivec = _mm_cvtps_epi32(g.vec);
+	result[2].ivec = _mm_cvtps_epi32(b.vec);
+	result[3].ivec = _mm_cvtps_epi32(a.vec);
+#else
+	float32x4x2_t rg = vtrnq_f32(r.vec, g.vec);
+	float32x4x2_t ba = vtrnq_f32(b.vec, a.vec);
+	result[0].ivec = vcvtq_s32_f32(vcombine_f32(vget_low_f32(rg.val[0]), vget_low_f32(ba.val[0])));
+	result[1].ivec = vcvtq_s32_f32(vcombine_f32(vget_low_f32(rg.val[1]), vget_low_f32(ba.val[1])));
+	result[2].ivec = vcvtq_s32_f32(vcombine_f32(vget_high_f32(rg.val[0]), vget_high_f32(ba.val[0])));
+	result[3].ivec = vcvtq_s32_f32(vcombine_f32(vget_high_f32(rg.val[1]), vget_high_f32(ba.val[1])));
+#endif
+#else
+	for (int i = 0; i < 4; ++i) {
+		if (mask[i] >= 0)
+			result[i] = Interpolate(c0, c1, c2, w0[i], w1[i], w2[i], wsum_recip[i]);
+	}
+#endif
+}
+
+static inline void InterpolateQuad(const Vec3<int> &c0, const Vec3<int> &c1, const Vec3<int> &c2, const Vec4<int> &w0, const Vec4<int> &w1, const Vec4<int> &w2, const Vec4<float> &wsum_recip, const Vec4<int> &mask, Vec3<int> result[4]) {
+	Vec4<int> full[4];
+	InterpolateQuad(Vec4<int>(c0, 0), Vec4<int>(c1, 0), Vec4<int>(c2, 0), w0, w1, w2, wsum_recip, mask, full);
+	for (int i = 0; i < 4; ++i) {
+#if (defined(_M_SSE) || PPSSPP_ARCH(ARM64_NEON)) && !PPSSPP_ARCH(X86)
+		result[i] = Vec3<int>(full[i].ivec);
+#else
+		result[i] = full[i].rgb();
+#endif
+	}
+}
+
 template <bool clearMode, bool useSSE4>
 void DrawTriangleSlice(
 	const VertexData& v0, const VertexData& v1, const VertexData& v2,
@@ -964,13 +1008,16 @@ void DrawTriangleSlice(
 			Vec4<int> mask = MakeMask(w0, w1, w2, bias0, bias1, bias2, scissor_mask);
 			if (AnyMask<useSSE4>(mask)) {
 				Vec4<float> wsum_recip = EdgeRecip(w0, w1, w2);
+				const Vec4<float> w0f = w0.Cast<float>();
+				const Vec4<float> w1f = w1.Cast<float>();
+				const Vec4<float> w2f = w2.Cast<float>();
 
 				Vec4<int> z;
 				if (flatZ) {
 					z = Vec4<int>::AssignToAll(v2.screenpos.z);
 				} else {
 					// Z is interpolated pretty much directly.
-					Vec4<float> zfloats = w0.Cast<float>() * v0.screenpos.z + w1.Cast<float>() * v1.screenpos.z + w2.Cast<float>() * v2.screenpos.z;
+					Vec4<float> zfloats = w0f * v0.screenpos.z + w1f * v1.screenpos.z + w2f * v2.screenpos.z;
 					z = (zfloats * wsum_recip).Cast<int>();
 				}
 
@@ -994,10 +1041,7 @@ void DrawTriangleSlice(
 				// Color interpolation is not perspective corrected on the PSP.
 				Vec4<int> prim_color[4];
 				if (!flatColor0) {
-					for (int i = 0; i < 4; ++i) {
-						if (mask[i] >= 0)
-							prim_color[i] = Interpolate(v0_c0, v1_c0, v2_c0, w0[i], w1[i], w2[i], wsum_recip[i]);
-					}
+					InterpolateQuad(v0_c0, v1_c0, v2_c0, w0, w1, w2, wsum_recip, mask, prim_color);
 				} else {
 					for (int i = 0; i < 4; ++i) {
 						prim_color[i] = v2_c0;
@@ -1005,10 +1049,7 @@ void DrawTriangleSlice(
 				}
 				Vec3<int> sec_color[4];
 				if (!flatColor1) {
-					for (int i = 0; i < 4; ++i) {
-						if (mask[i] >= 0)
-							sec_color[i] = Interpolate(v0_c1, v1_c1, v2_c1, w0[i], w1[i], w2[i], wsum_recip[i]);
-					}
+					InterpolateQuad(v0_c1, v1_c1, v2_c1, w0, w1, w2, wsum_recip, mask, sec_color);
 				} else {
 					for (int i = 0; i < 4; ++i) {
 						sec_color[i] = v2_c1;
@@ -1058,7 +1099,7 @@ void DrawTriangleSlice(
 
 				Vec4<int> fog = Vec4<int>::AssignToAll(255);
 				if (!noFog) {
-					Vec4<float> fogdepths = w0.Cast<float>() * v0.fogdepth + w1.Cast<float>() * v1.fogdepth + w2.Cast<float>() * v2.fogdepth;
+					Vec4<float> fogdepths = w0f * v0.fogdepth + w1f * v1.fogdepth + w2f * v2.fogdepth;
 					fogdepths = fogdepths * wsum_recip;
 					for (int i = 0; i < 4; ++i) {
 						fog[i] = ClampFogDepth(fogdepths[i]);
@@ -152,6 +152,53 @@ static inline void DrawSinglePixel32(u32 *pixel, const u32 color_in) {
 	*pixel = new_color;
 }
 
+#if defined(_M_SSE)
+// Same math as StandardAlphaBlend(), but for the two pixels in the low half of each.
+static inline __m128i StandardAlphaBlend2(__m128i source, __m128i dst) {
+	const __m128i z = _mm_setzero_si128();
+	const __m128i sourcevec = _mm_unpacklo_epi8(source, z);
+	const __m128i dstvec = _mm_unpacklo_epi8(dst, z);
+
+	// Spread each pixel's alpha over its lanes, keeping the alpha lane of the srcfactor zero.
+	const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sourcevec, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	const __m128i srcfactor = _mm_and_si128(alpha, _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1));
+	const __m128i dstfactor = _mm_sub_epi16(_mm_set1_epi16(255), srcfactor);
+
+	const __m128i half = _mm_set1_epi16(1 << 3);
+
+	const __m128i srgb = _mm_add_epi16(_mm_slli_epi16(sourcevec, 4), half);
+	const __m128i sf = _mm_add_epi16(_mm_slli_epi16(srcfactor, 4), half);
+	const __m128i s = _mm_mulhi_epi16(srgb, sf);
+
+	const __m128i drgb = _mm_add_epi16(_mm_slli_epi16(dstvec, 4), half);
+	const __m128i df = _mm_add_epi16(_mm_slli_epi16(dstfactor, 4), half);
+	const __m128i d = _mm_mulhi_epi16(drgb, df);
+
+	const __m128i blended16 = _mm_adds_epi16(s, d);
+	return _mm_packus_epi16(blended16, blended16);
+}
+
+// Same as DrawSinglePixel32<true>() on four pixels, but skipping zero alpha like the sprite loops do.
+static inline void DrawFourPixels32(u32 *pixel, const u32 colors[4]) {
+	const __m128i src = _mm_loadu_si128((const __m128i *)colors);
+	const __m128i dst = _mm_loadu_si128((const __m128i *)pixel);
+	const __m128i blendLow = StandardAlphaBlend2(src, dst);
+	const __m128i blendHigh = StandardAlphaBlend2(_mm_srli_si128(src, 8), _mm_srli_si128(dst, 8));
+	const __m128i blended = _mm_unpacklo_epi64(blendLow, blendHigh);
+
+	const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+	const __m128i srcAlpha = _mm_and_si128(src, alphaMask);
+	const __m128i opaque = _mm_cmpeq_epi32(srcAlpha, alphaMask);
+	const __m128i clear = _mm_cmpeq_epi32(srcAlpha, _mm_setzero_si128());
+
+	// Opaque pixels skip blending and take the source color directly.
+	__m128i color = _mm_or_si128(_mm_and_si128(opaque, _mm_andnot_si128(alphaMask, src)), _mm_andnot_si128(opaque, blended));
+	color = _mm_or_si128(color, _mm_and_si128(dst, alphaMask));
+	color = _mm_or_si128(_mm_and_si128(clear, dst), _mm_andnot_si128(clear, color));
+	_mm_storeu_si128((__m128i *)pixel, color);
+}
+#endif
+
 // Check if we can safely ignore the alpha test, assuming standard alpha blending.
 static inline bool AlphaTestIsNeedless(const PixelFuncID &pixelID) {
 	switch (pixelID.AlphaTestFunc()) {
@@ -242,7 +289,25 @@ static void DrawSpriteTex(const DrawingCoords &pos0, const DrawingCoords &pos1,
 		int s = s_start;
 		u16 *pixel16 = fb.Get16Ptr(pos0.x, y, state.pixelID.cached.framebufStride);
 		u32 *pixel32 = fb.Get32Ptr(pos0.x, y, state.pixelID.cached.framebufStride);
-		for (int x = pos0.x; x < pos1.x; x++) {
+		int x = pos0.x;
+#if defined(_M_SSE)
+		// Text and UI are mostly partly transparent, so blend four at a time.
+		if (fmt == GE_FORMAT_8888 && alphaBlend) {
+			for (; x + 4 <= pos1.x; x += 4) {
+				u32 colors[4];
+				for (int i = 0; i < 4; ++i) {
+					Vec4<int> tex_color = fetchFunc(s, t, texptr, texbufw, 0, state.samplerID);
+					if (!isWhite)
+						tex_color = Vec4<int>(ModulateRGBA(ToVec4IntArg(c0), ToVec4IntArg(tex_color), state.samplerID));
+					colors[i] = tex_color.ToRGBA();
+					s += ds;
+				}
+				DrawFourPixels32(pixel32, colors);
+				pixel32 += 4;
+			}
+		}
+#endif
+		for (; x < pos1.x; x++) {
 			Vec4<int> tex_color = fetchFunc(s, t, texptr, texbufw, 0, state.samplerID);
 			if (isWhite) {
 				if (!alphaBlend || tex_color.a() != 0) {
@@ -301,7 +366,17 @@ static void DrawSpriteNoTex(const DrawingCoords &pos0, const DrawingCoords &pos1
 	for (int y = pos0.y; y < pos1.y; y++) {
 		if (fmt == GE_FORMAT_8888) {
 			u32 *pixel = fb.Get32Ptr(pos0.x, y, state.pixelID.cached.framebufStride);
-			for (int x = pos0.x; x < pos1.x; x++) {
+			int x = pos0.x;
+#if defined(_M_SSE)
+			if (alphaBlend) {
+				const u32 colors[4] = { color0, color0, color0, color0 };
+				for (; x + 4 <= pos1.x; x += 4) {
+					DrawFourPixels32(pixel, colors);
+					pixel += 4;
+				}
+			}
+#endif
+			for (; x < pos1.x; x++) {
 				DrawSinglePixel32<alphaBlend>(pixel, color0);
 				pixel++;
 			}
@@ -447,6 +447,33 @@ int CodeBlock::WriteProlog(int extraStack, const std::vector<RegCache::Reg> &vec
 		nextOffset += 16;
 	}
 
+	lastPrologEnd_ = GetWritableCodePtr();
+#elif PPSSPP_ARCH(ARM64_NEON)
+	using namespace Arm64Gen;
+
+	BeginWrite(32768);
+	AlignCode16();
+	lastPrologStart_ = GetWritableCodePtr();
+
+	// SP must stay 16 byte aligned, and so must the vector saves.
+	firstVecStack_ = (extraStack + 15) & ~15;
+	savedStack_ = (firstVecStack_ + 16 * (int)vec.size() + 8 * (int)gen.size() + 15) & ~15;
+	totalStack = savedStack_;
+	if (savedStack_ != 0)
+		SUB(SP, SP, savedStack_);
+
+	int nextOffset = firstVecStack_;
+	for (ARM64Reg r : vec) {
+		fp.STR(128, INDEX_UNSIGNED, r, SP, nextOffset);
+		regCache_.Add(r, RegCache::VEC_INVALID);
+		nextOffset += 16;
+	}
+	for (ARM64Reg r : gen) {
+		STR(INDEX_UNSIGNED, r, SP, nextOffset);
+		regCache_.Add(r, RegCache::GEN_INVALID);
+		nextOffset += 8;
+	}
+
 	lastPrologEnd_ = GetWritableCodePtr();
 #else
 	_assert_msg_(false, "Not yet implemented");
@@ -534,6 +561,27 @@ const u8 *CodeBlock::WriteFinalizedEpilog() {
 			ProtectMemoryPages(prologPtr, 128, MEM_PROT_READ | MEM_PROT_EXEC);
 		}
 	}
+#elif PPSSPP_ARCH(ARM64_NEON)
+	using namespace Arm64Gen;
+
+	// Saves are cheap here and we rarely need any, so we don't bother rewriting the prolog.
+	int nextOffset = firstVecStack_;
+	for (ARM64Reg r : prologVec_) {
+		if (regCache_.UsedReg(r, RegCache::VEC_INVALID))
+			fp.LDR(128, INDEX_UNSIGNED, r, SP, nextOffset);
+		nextOffset += 16;
+	}
+	for (ARM64Reg r : prologGen_) {
+		if (regCache_.UsedReg(r, RegCache::GEN_INVALID))
+			LDR(INDEX_UNSIGNED, r, SP, nextOffset);
+		nextOffset += 8;
+	}
+	if (savedStack_ != 0)
+		ADD(SP, SP, savedStack_);
+
+	RET();
+	FlushIcache();
+	EndWrite();
 #else
 	_assert_msg_(false, "Not yet implemented");
 #endif
@@ -548,6 +596,10 @@ RegCache::Reg CodeBlock::GetZeroVec() {
 		X64Reg r = regCache_.Alloc(RegCache::VEC_ZERO);
 		PXOR(r, R(r));
 		return r;
+#elif PPSSPP_ARCH(ARM64_NEON)
+		Arm64Gen::ARM64Reg r = regCache_.Alloc(RegCache::VEC_ZERO);
+		fp.EOR(r, r, r);
+		return r;
 #else
 		return RegCache::REG_INVALID_VALUE;
 #endif
@@ -597,6 +649,10 @@ void CodeBlock::WriteDynamicConst16x8(const u8 *&ptr, uint8_t value) {
 	ptr = AlignCode16();
 	for (int i = 0; i < 16; ++i)
 		Write8(value);
+#elif PPSSPP_ARCH(ARM64_NEON)
+	ptr = AlignCode16();
+	for (int i = 0; i < 4; ++i)
+		Write32(value * 0x01010101);
 #else
 	_assert_msg_(false, "Not yet implemented");
 #endif
@@ -607,13 +663,17 @@ void CodeBlock::WriteDynamicConst8x16(const u8 *&ptr, uint16_t value) {
 	ptr = AlignCode16();
 	for (int i = 0; i < 8; ++i)
 		Write16(value);
+#elif PPSSPP_ARCH(ARM64_NEON)
+	ptr = AlignCode16();
+	for (int i = 0; i < 4; ++i)
+		Write32(value | ((uint32_t)value << 16));
 #else
 	_assert_msg_(false, "Not yet implemented");
 #endif
 }
 
 void CodeBlock::WriteDynamicConst4x32(const u8 *&ptr, uint32_t value) {
-#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(ARM64_NEON)
 	ptr = AlignCode16();
 	for (int i = 0; i < 4; ++i)
 		Write32(value);
@@ -21,7 +21,9 @@
 #include "Common/Common.h"
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/LogReporting.h"
+#include "Common/Profiler/PerfMap.h"
 #include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/GPUState.h"
@@ -29,6 +31,7 @@
 #include "GPU/Software/Rasterizer.h"
 #include "GPU/Software/RasterizerRegCache.h"
 #include "GPU/Software/Sampler.h"
+#include "GPU/Software/SoftGpu.h"
 
 #if defined(_M_SSE)
 #include <emmintrin.h>
@@ -67,6 +70,14 @@ void Shutdown() {
 	jitCache = nullptr;
 }
 
+void GetJitKeys(std::vector<uint32_t> &keys) {
+	jitCache->GetKeys(keys);
+}
+
+void PrecompileJit(const std::vector<uint32_t> &keys) {
+	jitCache->Precompile(keys);
+}
+
 bool DescribeCodePtr(const u8 *ptr, std::string &name) {
 	if (!jitCache->IsInSpace(ptr)) {
 		return false;
@@ -172,6 +183,31 @@ void SamplerJitCache::Flush() {
 	compileQueue_.clear();
 }
 
+void SamplerJitCache::GetKeys(std::vector<uint32_t> &keys) {
+	std::unique_lock<std::mutex> guard(jitCacheLock);
+	for (const auto &it : addresses_) {
+		// Compile() always does all three variants, so only record one.
+		if (!it.first.linear && !it.first.fetch)
+			keys.push_back(it.first.fullKey);
+	}
+}
+
+void SamplerJitCache::Precompile(const std::vector<uint32_t> &keys) {
+	if (!g_Config.bSoftwareRenderingJit)
+		return;
+
+	std::unique_lock<std::mutex> guard(jitCacheLock);
+	for (uint32_t key : keys) {
+		SamplerID id;
+		id.fullKey = key;
+		// Don't trust the file too much.
+		if (startsWith(DescribeSamplerID(id), "INVALID"))
+			continue;
+		if (!cache_.Get(std::hash<SamplerID>()(id)))
+			Compile(id);
+	}
+}
+
 NearestFunc SamplerJitCache::GetByID(const SamplerID &id, size_t key, BinManager *binner) {
 	std::unique_lock<std::mutex> guard(jitCacheLock);
 	auto it = cache_.Get(key);
@@ -242,6 +278,11 @@ FetchFunc SamplerJitCache::GetFetch(const SamplerID &id, BinManager *binner) {
 	return (FetchFunc)func;
 }
 
+void SamplerJitCache::AddPerfMapSymbol(const u8 *start, bool compiled, const char *kind, const SamplerID &id) {
+	if (compiled && PerfMap_IsEnabled())
+		PerfMap_AddSymbol(start, GetCodePointer() - start, std::string(kind) + " " + DescribeSamplerID(id));
+}
+
 void SamplerJitCache::Compile(const SamplerID &id) {
 	// This should be sufficient.
 	if (GetSpaceLeft() < 16384) {
@@ -250,24 +291,33 @@ void SamplerJitCache::Compile(const SamplerID &id) {
 
 	// We compile them together so the cache can't possibly be cleared in between.
 	// We might vary between nearest and linear, so we can't clear between.
-#if PPSSPP_ARCH(AMD64) && !PPSSPP_PLATFORM(UWP)
+#if (PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(ARM64_NEON)) && !PPSSPP_PLATFORM(UWP)
+	// If any can't be compiled, keep the generic func so we don't retry every lookup.
+	double st = time_now_d();
 	SamplerID fetchID = id;
 	fetchID.linear = false;
 	fetchID.fetch = true;
 	addresses_[fetchID] = GetCodePointer();
-	cache_.Insert(std::hash<SamplerID>()(fetchID), (NearestFunc)CompileFetch(fetchID));
+	FetchFunc fetchFunc = CompileFetch(fetchID);
+	AddPerfMapSymbol(addresses_[fetchID], fetchFunc != nullptr, "SamplerFetch", fetchID);
+	cache_.Insert(std::hash<SamplerID>()(fetchID), (NearestFunc)(fetchFunc ? fetchFunc : &SampleFetch));
 
 	SamplerID nearestID = id;
 	nearestID.linear = false;
 	nearestID.fetch = false;
 	addresses_[nearestID] = GetCodePointer();
-	cache_.Insert(std::hash<SamplerID>()(nearestID), (NearestFunc)CompileNearest(nearestID));
+	NearestFunc nearestFunc = CompileNearest(nearestID);
+	AddPerfMapSymbol(addresses_[nearestID], nearestFunc != nullptr, "SamplerNearest", nearestID);
+	cache_.Insert(std::hash<SamplerID>()(nearestID), nearestFunc ? nearestFunc : &SampleNearest);
 
 	SamplerID linearID = id;
 	linearID.linear = true;
 	linearID.fetch = false;
 	addresses_[linearID] = GetCodePointer();
-	cache_.Insert(std::hash<SamplerID>()(linearID), (NearestFunc)CompileLinear(linearID));
+	LinearFunc linearFunc = CompileLinear(linearID);
+	AddPerfMapSymbol(addresses_[linearID], linearFunc != nullptr, "SamplerLinear", linearID);
+	cache_.Insert(std::hash<SamplerID>()(linearID), (NearestFunc)(linearFunc ? linearFunc : &SampleLinear));
+	g_softGPUBenchStats.samplerJit += time_now_d() - st;
 #endif
 }
 
@@ -21,6 +21,7 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include "Common/Data/Collections/Hashmaps.h"
 #include "GPU/Math3D.h"
 #include "GPU/Software/FuncId.h"
@@ -50,6 +51,10 @@ void Init();
 void FlushJit();
 void Shutdown();
 
+// For the on-disk cache: keys of the funcs compiled so far, and compiling them ahead of use.
+void GetJitKeys(std::vector<uint32_t> &keys);
+void PrecompileJit(const std::vector<uint32_t> &keys);
+
 bool DescribeCodePtr(const u8 *ptr, std::string &name);
 
 class SamplerJitCache : public Rasterizer::CodeBlock {
@@ -63,10 +68,14 @@ class SamplerJitCache : public Rasterizer::CodeBlock {
 	void Clear() override;
 	void Flush();
 
+	void GetKeys(std::vector<uint32_t> &keys);
+	void Precompile(const std::vector<uint32_t> &keys);
+
 	std::string DescribeCodePtr(const u8 *ptr) override;
 
 private:
 	void Compile(const SamplerID &id);
+	void AddPerfMapSymbol(const u8 *start, bool compiled, const char *kind, const SamplerID &id);
 	NearestFunc GetByID(const SamplerID &id, size_t key, BinManager *binner);
 	FetchFunc CompileFetch(const SamplerID &id);
 	NearestFunc CompileNearest(const SamplerID &id);
@@ -112,6 +121,16 @@ class SamplerJitCache : public Rasterizer::CodeBlock {
 	int stackIDOffset_ = -1;
 	int stackLevelOffset_ = -1;
 	int stackUV1Offset_ = 0;
+#elif PPSSPP_ARCH(ARM64_NEON)
+	void Jit_PrepareLevel(bool level1);
+	bool Jit_SampleNearestLevel(const SamplerID &id, bool level1);
+	bool Jit_SampleLinearLevel(const SamplerID &id, bool level1);
+	bool Jit_BlendLevels(const SamplerID &id);
+	void Jit_ExpandTexel(Rasterizer::RegCache::Purpose dest);
+	void Jit_FinishResult();
+	bool Jit_GetTexelCoord(const SamplerID &id, bool isV, Rasterizer::RegCache::Reg coordReg, Rasterizer::RegCache::Reg coord1Reg, Rasterizer::RegCache::Reg fracReg);
+	bool Jit_ReadTexel(const SamplerID &id, Rasterizer::RegCache::Reg uReg, Rasterizer::RegCache::Reg vReg);
+	bool Jit_LoadTexelData(const SamplerID &id, int bitsPerTexel, Rasterizer::RegCache::Reg uReg, Rasterizer::RegCache::Reg vReg);
 #endif
 
 	const u8 *constWidthHeight256f_ = nullptr;
@@ -0,0 +1,908 @@
+// Copyright (c) 2017- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(ARM64_NEON)
+
+#include "Common/Arm64Emitter.h"
+#include "GPU/GPUState.h"
+#include "GPU/Common/TextureDecoder.h"
+#include "GPU/Software/Sampler.h"
+#include "GPU/ge_constants.h"
+
+using namespace Arm64Gen;
+using namespace Rasterizer;
+
+namespace Sampler {
+
+FetchFunc SamplerJitCache::CompileFetch(const SamplerID &id) {
+	_assert_msg_(id.fetch && !id.linear, "Only fetch should be set on sampler id");
+	// DXT is left to the generic sampler for now.
+	if (IsDXTFormat(id.TexFmt()))
+		return nullptr;
+
+	regCache_.SetupABI({
+		RegCache::GEN_ARG_U,
+		RegCache::GEN_ARG_V,
+		RegCache::GEN_ARG_TEXPTR,
+		RegCache::GEN_ARG_BUFW,
+		RegCache::GEN_ARG_LEVEL,
+		RegCache::GEN_ARG_ID,
+	});
+	regCache_.ChangeReg(Q0, RegCache::VEC_RESULT);
+
+	BeginWrite(2048);
+	Describe("Init");
+	const u8 *start = AlignCode16();
+
+	RegCache::Reg resultReg = regCache_.Alloc(RegCache::GEN_RESULT);
+	regCache_.Unlock(resultReg, RegCache::GEN_RESULT);
+	regCache_.ForceRetain(RegCache::GEN_RESULT);
+
+	// This reads the pixel data into resultReg from the args.
+	if (!Jit_ReadTextureFormat(id)) {
+		regCache_.Reset(false);
+		EndWrite();
+		ResetCodePtr(GetOffset(start));
+		ERROR_LOG(G3D, "Failed to compile fetch %s", DescribeSamplerID(id).c_str());
+		return nullptr;
+	}
+
+	Jit_ExpandTexel(RegCache::VEC_RESULT);
+	regCache_.ForceRelease(RegCache::GEN_RESULT);
+
+	for (auto p : { RegCache::GEN_ARG_U, RegCache::GEN_ARG_V, RegCache::GEN_ARG_TEXPTR, RegCache::GEN_ARG_BUFW, RegCache::GEN_ARG_LEVEL, RegCache::GEN_ARG_ID })
+		regCache_.ForceRelease(p);
+
+	Describe("Init");
+	RET();
+
+	regCache_.Reset(true);
+
+	EndWrite();
+	return (FetchFunc)start;
+}
+
+NearestFunc SamplerJitCache::CompileNearest(const SamplerID &id) {
+	_assert_msg_(!id.fetch && !id.linear, "Fetch and linear should be cleared on sampler id");
+	if (IsDXTFormat(id.TexFmt()))
+		return nullptr;
+
+	BeginWrite(2048);
+	Describe("Init");
+	const u8 *start = AlignCode16();
+
+	regCache_.SetupABI({
+		RegCache::VEC_ARG_S,
+		RegCache::VEC_ARG_T,
+		RegCache::VEC_ARG_COLOR,
+		RegCache::GEN_ARG_TEXPTR_PTR,
+		RegCache::GEN_ARG_BUFW_PTR,
+		RegCache::GEN_ARG_LEVEL,
+		RegCache::GEN_ARG_LEVELFRAC,
+		RegCache::GEN_ARG_ID,
+	});
+
+	bool success = Jit_SampleNearestLevel(id, false);
+
+	if (id.hasAnyMips) {
+		RegCache::Reg levelFracReg = regCache_.Find(RegCache::GEN_ARG_LEVELFRAC);
+		FixupBranch skip = CBZ(DecodeReg(levelFracReg));
+		regCache_.Unlock(levelFracReg, RegCache::GEN_ARG_LEVELFRAC);
+
+		// This modifies the level in place, but we don't need the old value afterward.
+		success = success && Jit_SampleNearestLevel(id, true);
+		success = success && Jit_BlendLevels(id);
+
+		SetJumpTarget(skip);
+	}
+
+	success = success && Jit_ApplyTextureFunc(id);
+	if (!success) {
+		regCache_.Reset(false);
+		EndWrite();
+		ResetCodePtr(GetOffset(start));
+		ERROR_LOG(G3D, "Failed to compile nearest %s", DescribeSamplerID(id).c_str());
+		return nullptr;
+	}
+
+	Jit_FinishResult();
+
+	Describe("Init");
+	RET();
+
+	regCache_.Reset(true);
+
+	EndWrite();
+	return (NearestFunc)start;
+}
+
+LinearFunc SamplerJitCache::CompileLinear(const SamplerID &id) {
+	_assert_msg_(id.linear && !id.fetch, "Only linear should be set on sampler id");
+	if (IsDXTFormat(id.TexFmt()))
+		return nullptr;
+
+	BeginWrite(4096);
+	Describe("Init");
+	const u8 *start = AlignCode16();
+
+	regCache_.SetupABI({
+		RegCache::VEC_ARG_S,
+		RegCache::VEC_ARG_T,
+		RegCache::VEC_ARG_COLOR,
+		RegCache::GEN_ARG_TEXPTR_PTR,
+		RegCache::GEN_ARG_BUFW_PTR,
+		RegCache::GEN_ARG_LEVEL,
+		RegCache::GEN_ARG_LEVELFRAC,
+		RegCache::GEN_ARG_ID,
+	});
+
+	bool success = Jit_SampleLinearLevel(id, false);
+
+	if (id.hasAnyMips) {
+		RegCache::Reg levelFracReg = regCache_.Find(RegCache::GEN_ARG_LEVELFRAC);
+		FixupBranch skip = CBZ(DecodeReg(levelFracReg));
+		regCache_.Unlock(levelFracReg, RegCache::GEN_ARG_LEVELFRAC);
+
+		success = success && Jit_SampleLinearLevel(id, true);
+		success = success && Jit_BlendLevels(id);
+
+		SetJumpTarget(skip);
+	}
+
+	success = success && Jit_ApplyTextureFunc(id);
+	if (!success) {
+		regCache_.Reset(false);
+		EndWrite();
+		ResetCodePtr(GetOffset(start));
+		ERROR_LOG(G3D, "Failed to compile linear %s", DescribeSamplerID(id).c_str());
+		return nullptr;
+	}
+
+	Jit_FinishResult();
+
+	Describe("Init");
+	RET();
+
+	regCache_.Reset(true);
+
+	EndWrite();
+	return (LinearFunc)start;
+}
+
+RegCache::Reg SamplerJitCache::GetSamplerID() {
+	// On ARM64, the ID always fits in an arg register.
+	return regCache_.Find(RegCache::GEN_ARG_ID);
+}
+
+void SamplerJitCache::UnlockSamplerID(RegCache::Reg &r) {
+	regCache_.Unlock(r, RegCache::GEN_ARG_ID);
+}
+
+void SamplerJitCache::Jit_PrepareLevel(bool level1) {
+	RegCache::Reg bufwReg = regCache_.Alloc(RegCache::GEN_ARG_BUFW);
+	RegCache::Reg bufwPtrReg = regCache_.Find(RegCache::GEN_ARG_BUFW_PTR);
+	LDRH(INDEX_UNSIGNED, DecodeReg(bufwReg), bufwPtrReg, level1 ? 2 : 0);
+	regCache_.Unlock(bufwPtrReg, RegCache::GEN_ARG_BUFW_PTR);
+	regCache_.Unlock(bufwReg, RegCache::GEN_ARG_BUFW);
+	regCache_.ForceRetain(RegCache::GEN_ARG_BUFW);
+
+	RegCache::Reg srcReg = regCache_.Alloc(RegCache::GEN_ARG_TEXPTR);
+	RegCache::Reg srcPtrReg = regCache_.Find(RegCache::GEN_ARG_TEXPTR_PTR);
+	LDR(INDEX_UNSIGNED, srcReg, srcPtrReg, level1 ? 8 : 0);
+	regCache_.Unlock(srcPtrReg, RegCache::GEN_ARG_TEXPTR_PTR);
+	regCache_.Unlock(srcReg, RegCache::GEN_ARG_TEXPTR);
+	regCache_.ForceRetain(RegCache::GEN_ARG_TEXPTR);
+
+	if (level1) {
+		// Modify the level, so the new level value is used for sizes and the CLUT.
+		RegCache::Reg levelReg = regCache_.Find(RegCache::GEN_ARG_LEVEL);
+		ADD(DecodeReg(levelReg), DecodeReg(levelReg), 1);
+		regCache_.Unlock(levelReg, RegCache::GEN_ARG_LEVEL);
+	}
+}
+
+bool SamplerJitCache::Jit_SampleNearestLevel(const SamplerID &id, bool level1) {
+	Jit_PrepareLevel(level1);
+
+	RegCache::Reg uReg = regCache_.Alloc(RegCache::GEN_ARG_U);
+	RegCache::Reg vReg = regCache_.Alloc(RegCache::GEN_ARG_V);
+	bool success = Jit_GetTexelCoord(id, false, uReg, RegCache::REG_INVALID_VALUE, RegCache::REG_INVALID_VALUE);
+	success = success && Jit_GetTexelCoord(id, true, vReg, RegCache::REG_INVALID_VALUE, RegCache::REG_INVALID_VALUE);
+	regCache_.Unlock(uReg, RegCache::GEN_ARG_U);
+	regCache_.Unlock(vReg, RegCache::GEN_ARG_V);
+
+	RegCache::Reg resultReg = regCache_.Alloc(RegCache::GEN_RESULT);
+	regCache_.Unlock(resultReg, RegCache::GEN_RESULT);
+	regCache_.ForceRetain(RegCache::GEN_RESULT);
+
+	success = success && Jit_ReadTextureFormat(id);
+
+	uReg = regCache_.Find(RegCache::GEN_ARG_U);
+	regCache_.Release(uReg, RegCache::GEN_ARG_U);
+	vReg = regCache_.Find(RegCache::GEN_ARG_V);
+	regCache_.Release(vReg, RegCache::GEN_ARG_V);
+	regCache_.ForceRelease(RegCache::GEN_ARG_TEXPTR);
+	regCache_.ForceRelease(RegCache::GEN_ARG_BUFW);
+
+	RegCache::Reg vecResultReg = regCache_.Alloc(level1 ? RegCache::VEC_RESULT1 : RegCache::VEC_RESULT);
+	regCache_.Unlock(vecResultReg, level1 ? RegCache::VEC_RESULT1 : RegCache::VEC_RESULT);
+	Jit_ExpandTexel(level1 ? RegCache::VEC_RESULT1 : RegCache::VEC_RESULT);
+	regCache_.ForceRelease(RegCache::GEN_RESULT);
+
+	return success;
+}
+
+bool SamplerJitCache::Jit_SampleLinearLevel(const SamplerID &id, bool level1) {
+	Jit_PrepareLevel(level1);
+
+	// We keep all four coordinates in regs, and the fractions in a vector.
+	RegCache::Reg u0Reg = regCache_.Alloc(RegCache::GEN_ARG_U);
+	RegCache::Reg u1Reg = regCache_.Alloc(RegCache::GEN_TEMP3);
+	RegCache::Reg v0Reg = regCache_.Alloc(RegCache::GEN_ARG_V);
+	RegCache::Reg v1Reg = regCache_.Alloc(RegCache::GEN_TEMP4);
+	RegCache::Reg fracReg = regCache_.Alloc(RegCache::VEC_FRAC);
+
+	RegCache::Reg fracTempReg = regCache_.Alloc(RegCache::GEN_TEMP5);
+	bool success = Jit_GetTexelCoord(id, false, u0Reg, u1Reg, fracTempReg);
+	fp.INS(32, fracReg, 0, DecodeReg(fracTempReg));
+	success = success && Jit_GetTexelCoord(id, true, v0Reg, v1Reg, fracTempReg);
+	fp.INS(32, fracReg, 1, DecodeReg(fracTempReg));
+	regCache_.Release(fracTempReg, RegCache::GEN_TEMP5);
+
+	RegCache::Reg resultReg = regCache_.Alloc(RegCache::GEN_RESULT);
+	regCache_.Unlock(resultReg, RegCache::GEN_RESULT);
+	regCache_.ForceRetain(RegCache::GEN_RESULT);
+
+	// Left holds top left and bottom left, right holds top right and bottom right.
+	// This way, blending horizontally gives us top and bottom in one go.
+	RegCache::Reg leftReg = regCache_.Alloc(RegCache::VEC_TEMP1);
+	RegCache::Reg rightReg = regCache_.Alloc(RegCache::VEC_TEMP2);
+
+	auto readTexel = [&](RegCache::Reg uReg, RegCache::Reg vReg, RegCache::Reg destReg, int lane) {
+		success = success && Jit_ReadTexel(id, uReg, vReg);
+		RegCache::Reg texelReg = regCache_.Find(RegCache::GEN_RESULT);
+		fp.INS(32, destReg, lane, DecodeReg(texelReg));
+		regCache_.Unlock(texelReg, RegCache::GEN_RESULT);
+	};
+
+	Describe("FetchQuad");
+	readTexel(u0Reg, v0Reg, leftReg, 0);
+	readTexel(u1Reg, v0Reg, rightReg, 0);
+	readTexel(u0Reg, v1Reg, leftReg, 1);
+	readTexel(u1Reg, v1Reg, rightReg, 1);
+
+	regCache_.ForceRelease(RegCache::GEN_RESULT);
+	regCache_.Release(u0Reg, RegCache::GEN_ARG_U);
+	regCache_.Release(u1Reg, RegCache::GEN_TEMP3);
+	regCache_.Release(v0Reg, RegCache::GEN_ARG_V);
+	regCache_.Release(v1Reg, RegCache::GEN_TEMP4);
+	regCache_.ForceRelease(RegCache::GEN_ARG_TEXPTR);
+	regCache_.ForceRelease(RegCache::GEN_ARG_BUFW);
+
+	Describe("BlendQuad");
+	RegCache::Reg weightReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	RegCache::Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	ARM64Reg tempW = DecodeReg(tempReg);
+
+	// Horizontally first, in 16-bit lanes: tl * (16 - fu) + tr * fu, and the same for the bottom.
+	fp.UXTL(8, leftReg, leftReg);
+	fp.UXTL(8, rightReg, rightReg);
+	fp.UMOV(32, tempW, fracReg, 0);
+	fp.DUP(16, weightReg, tempW);
+	fp.MUL(16, rightReg, rightReg, weightReg);
+	NEG(tempW, tempW);
+	ADD(tempW, tempW, 16);
+	fp.DUP(16, weightReg, tempW);
+	fp.MLA(16, rightReg, leftReg, weightReg);
+
+	// Now vertically, which needs 32-bit lanes: top * (16 - fv) + bot * fv.
+	RegCache::Reg destReg = regCache_.Alloc(level1 ? RegCache::VEC_RESULT1 : RegCache::VEC_RESULT);
+	fp.UXTL2(16, leftReg, rightReg);
+	fp.UXTL(16, rightReg, rightReg);
+	fp.UMOV(32, tempW, fracReg, 1);
+	fp.DUP(32, weightReg, tempW);
+	fp.MUL(32, leftReg, leftReg, weightReg);
+	NEG(tempW, tempW);
+	ADD(tempW, tempW, 16);
+	fp.DUP(32, weightReg, tempW);
+	fp.MLA(32, leftReg, rightReg, weightReg);
+	fp.USHR(32, destReg, leftReg, 8);
+	regCache_.Unlock(destReg, level1 ? RegCache::VEC_RESULT1 : RegCache::VEC_RESULT);
+
+	regCache_.Release(tempReg, RegCache::GEN_TEMP0);
+	regCache_.Release(weightReg, RegCache::VEC_TEMP0);
+	regCache_.Release(leftReg, RegCache::VEC_TEMP1);
+	regCache_.Release(rightReg, RegCache::VEC_TEMP2);
+	regCache_.Release(fracReg, RegCache::VEC_FRAC);
+
+	return success;
+}
+
+bool SamplerJitCache::Jit_BlendLevels(const SamplerID &id) {
+	Describe("BlendMips");
+	RegCache::Reg levelFracReg = regCache_.Find(RegCache::GEN_ARG_LEVELFRAC);
+	RegCache::Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	RegCache::Reg weightReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	RegCache::Reg vecResultReg = regCache_.Find(RegCache::VEC_RESULT);
+	RegCache::Reg vecResult1Reg = regCache_.Find(RegCache::VEC_RESULT1);
+
+	// c0 = (c1 * levelFrac + c0 * (16 - levelFrac)) / 16
+	fp.DUP(32, weightReg, DecodeReg(levelFracReg));
+	fp.MUL(32, vecResult1Reg, vecResult1Reg, weightReg);
+	MOVI2R(DecodeReg(tempReg), 16);
+	SUB(DecodeReg(tempReg), DecodeReg(tempReg), DecodeReg(levelFracReg));
+	fp.DUP(32, weightReg, DecodeReg(tempReg));
+	fp.MLA(32, vecResult1Reg, vecResultReg, weightReg);
+	fp.USHR(32, vecResultReg, vecResult1Reg, 4);
+
+	regCache_.Release(vecResult1Reg, RegCache::VEC_RESULT1);
+	regCache_.Unlock(vecResultReg, RegCache::VEC_RESULT);
+	regCache_.Release(weightReg, RegCache::VEC_TEMP0);
+	regCache_.Release(tempReg, RegCache::GEN_TEMP0);
+	regCache_.Unlock(levelFracReg, RegCache::GEN_ARG_LEVELFRAC);
+	return true;
+}
+
+void SamplerJitCache::Jit_ExpandTexel(RegCache::Purpose dest) {
+	// From RGBA8888 in a GPR to 32-bit lanes.
+	RegCache::Reg resultReg = regCache_.Find(RegCache::GEN_RESULT);
+	RegCache::Reg vecReg = regCache_.Find(dest);
+	fp.INS(32, vecReg, 0, DecodeReg(resultReg));
+	fp.UXTL(8, vecReg, vecReg);
+	fp.UXTL(16, vecReg, vecReg);
+	regCache_.Unlock(vecReg, dest);
+	regCache_.Unlock(resultReg, RegCache::GEN_RESULT);
+}
+
+void SamplerJitCache::Jit_FinishResult() {
+	// The S arg is in Q0, which is also where the result goes.
+	for (auto p : { RegCache::VEC_ARG_S, RegCache::VEC_ARG_T, RegCache::VEC_ARG_COLOR })
+		regCache_.ForceRelease(p);
+	for (auto p : { RegCache::GEN_ARG_TEXPTR_PTR, RegCache::GEN_ARG_BUFW_PTR, RegCache::GEN_ARG_LEVEL, RegCache::GEN_ARG_LEVELFRAC, RegCache::GEN_ARG_ID })
+		regCache_.ForceRelease(p);
+
+	RegCache::Reg vecResultReg = regCache_.Find(RegCache::VEC_RESULT);
+	if (vecResultReg != Q0)
+		fp.MOV(Q0, vecResultReg);
+	regCache_.Release(vecResultReg, RegCache::VEC_RESULT);
+}
+
+bool SamplerJitCache::Jit_GetTexelCoord(const SamplerID &id, bool isV, RegCache::Reg coordReg, RegCache::Reg coord1Reg, RegCache::Reg fracReg) {
+	Describe(isV ? "TexelCoordV" : "TexelCoordU");
+	const bool quad = coord1Reg != RegCache::REG_INVALID_VALUE;
+	const bool clamp = isV ? id.clampT : id.clampS;
+	ARM64Reg coord = DecodeReg(coordReg);
+	ARM64Reg coord1 = quad ? DecodeReg(coord1Reg) : INVALID_REG;
+
+	RegCache::Reg sizeReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	RegCache::Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	ARM64Reg size = DecodeReg(sizeReg);
+	ARM64Reg temp = DecodeReg(tempReg);
+
+	// Grab the width or height for this level, from sizes[level].
+	RegCache::Reg idReg = GetSamplerID();
+	RegCache::Reg levelReg = regCache_.Find(RegCache::GEN_ARG_LEVEL);
+	LSL(temp, DecodeReg(levelReg), 2);
+	ADD(EncodeRegTo64(temp), idReg, EncodeRegTo64(temp));
+	LDRH(INDEX_UNSIGNED, size, EncodeRegTo64(temp), offsetof(SamplerID, cached.sizes[0].w) + (isV ? 2 : 0));
+	regCache_.Unlock(levelReg, RegCache::GEN_ARG_LEVEL);
+	UnlockSamplerID(idReg);
+
+	// Now (int)(s * w * 256.0f), truncating like the C++ cast.
+	RegCache::Reg stReg = regCache_.Find(isV ? RegCache::VEC_ARG_T : RegCache::VEC_ARG_S);
+	RegCache::Reg vecTempReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	LSL(temp, size, 8);
+	fp.SCVTF(EncodeRegToSingle(vecTempReg), temp);
+	fp.FMUL(EncodeRegToSingle(vecTempReg), EncodeRegToSingle(vecTempReg), EncodeRegToSingle(stReg));
+	fp.FCVTS(coord, EncodeRegToSingle(vecTempReg), ROUND_Z);
+	regCache_.Release(vecTempReg, RegCache::VEC_TEMP0);
+	regCache_.Unlock(stReg, isV ? RegCache::VEC_ARG_T : RegCache::VEC_ARG_S);
+
+	if (quad) {
+		// Linear takes the texel center, and the fraction in 1/16ths of a texel.
+		SUB(coord, coord, 128);
+		UBFX(DecodeReg(fracReg), coord, 4, 4);
+		ASR(coord, coord, 8);
+		ADD(coord1, coord, 1);
+	} else {
+		ASR(coord, coord, 8);
+	}
+
+	SUB(size, size, 1);
+	if (clamp && quad) {
+		// The high bound is size - 1, except above 512.
+		MOVI2R(temp, 511);
+		CMP(size, temp);
+		CSEL(size, temp, size, CC_GT);
+		for (ARM64Reg r : { coord, coord1 }) {
+			CMP(r, size);
+			CSEL(r, size, r, CC_GT);
+			CMP(r, 0);
+			CSEL(r, WZR, r, CC_LT);
+		}
+	} else if (clamp) {
+		// This matches ClampUV(), which lets size - 1 win over 511.
+		MOVI2R(temp, 511);
+		CMP(coord, temp);
+		CSEL(temp, temp, coord, CC_GE);
+		CMP(temp, 0);
+		CSEL(temp, WZR, temp, CC_LT);
+		CMP(coord, size);
+		CSEL(coord, size, temp, CC_GE);
+	} else {
+		ANDI2R(size, size, 511);
+		AND(coord, coord, size);
+		if (quad)
+			AND(coord1, coord1, size);
+	}
+
+	regCache_.Release(tempReg, RegCache::GEN_TEMP1);
+	regCache_.Release(sizeReg, RegCache::GEN_TEMP0);
+	return true;
+}
+
+bool SamplerJitCache::Jit_ReadTextureFormat(const SamplerID &id) {
+	RegCache::Reg uReg = regCache_.Find(RegCache::GEN_ARG_U);
+	RegCache::Reg vReg = regCache_.Find(RegCache::GEN_ARG_V);
+	bool success = Jit_ReadTexel(id, uReg, vReg);
+	regCache_.Unlock(uReg, RegCache::GEN_ARG_U);
+	regCache_.Unlock(vReg, RegCache::GEN_ARG_V);
+	return success;
+}
+
+bool SamplerJitCache::Jit_ReadTexel(const SamplerID &id, RegCache::Reg uReg, RegCache::Reg vReg) {
+	GETextureFormat fmt = id.TexFmt();
+	if (IsDXTFormat(fmt))
+		return false;
+
+	const int bitsPerTexel = textureBitsPerPixel[fmt];
+	ARM64Reg u = DecodeReg(uReg);
+
+	RegCache::Reg resultReg = regCache_.Find(RegCache::GEN_RESULT);
+	ARM64Reg result = DecodeReg(resultReg);
+	RegCache::Reg srcReg = regCache_.Find(RegCache::GEN_ARG_TEXPTR);
+
+	FixupBranch zeroSrc;
+	if (id.hasInvalidPtr) {
+		Describe("NullCheck");
+		MOVI2R(result, 0);
+		zeroSrc = CBZ(srcReg);
+	}
+
+	bool success = Jit_LoadTexelData(id, bitsPerTexel, uReg, vReg);
+	if (fmt == GE_TFMT_CLUT4) {
+		// Pick the right nibble based on u.
+		RegCache::Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+		UBFIZ(DecodeReg(tempReg), u, 2, 1);
+		LSRV(result, result, DecodeReg(tempReg));
+		ANDI2R(result, result, 0xF);
+		regCache_.Release(tempReg, RegCache::GEN_TEMP0);
+	}
+
+	switch (fmt) {
+	case GE_TFMT_5650:
+		success = success && Jit_Decode5650(id);
+		break;
+
+	case GE_TFMT_5551:
+		success = success && Jit_Decode5551(id);
+		break;
+
+	case GE_TFMT_4444:
+		success = success && Jit_Decode4444(id);
+		break;
+
+	case GE_TFMT_8888:
+		break;
+
+	case GE_TFMT_CLUT32:
+	case GE_TFMT_CLUT16:
+	case GE_TFMT_CLUT8:
+	case GE_TFMT_CLUT4:
+		success = success && Jit_TransformClutIndex(id, bitsPerTexel);
+		success = success && Jit_ReadClutColor(id);
+		break;
+
+	default:
+		success = false;
+	}
+
+	if (id.hasInvalidPtr)
+		SetJumpTarget(zeroSrc);
+
+	regCache_.Unlock(srcReg, RegCache::GEN_ARG_TEXPTR);
+	regCache_.Unlock(resultReg, RegCache::GEN_RESULT);
+	return success;
+}
+
+bool SamplerJitCache::Jit_LoadTexelData(const SamplerID &id, int bitsPerTexel, RegCache::Reg uReg, RegCache::Reg vReg) {
+	Describe(id.swizzle ? "TexDataS" : "TexData");
+	ARM64Reg u = DecodeReg(uReg);
+	ARM64Reg v = DecodeReg(vReg);
+
+	RegCache::Reg srcReg = regCache_.Find(RegCache::GEN_ARG_TEXPTR);
+	RegCache::Reg bufwReg = regCache_.Find(RegCache::GEN_ARG_BUFW);
+	RegCache::Reg resultReg = regCache_.Find(RegCache::GEN_RESULT);
+	RegCache::Reg offsetReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	RegCache::Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	RegCache::Reg temp2Reg = regCache_.Alloc(RegCache::GEN_TEMP2);
+	ARM64Reg bufw = DecodeReg(bufwReg);
+	ARM64Reg offset = DecodeReg(offsetReg);
+	ARM64Reg temp = DecodeReg(tempReg);
+	ARM64Reg temp2 = DecodeReg(temp2Reg);
+
+	// All of this is 32-bit, so the upper bits of the offset end up zero for the 64-bit add.
+	if (!id.swizzle) {
+		if (bitsPerTexel == 4) {
+			// v * (bufw / 2) + u / 2.
+			LSR(temp, bufw, 1);
+			MUL(offset, v, temp);
+			ADD(offset, offset, u, ArithOption(u, ST_LSR, 1));
+			ADD(EncodeRegTo64(offset), srcReg, EncodeRegTo64(offset));
+		} else {
+			MADD(offset, v, bufw, u);
+			int shift = bitsPerTexel == 32 ? 2 : (bitsPerTexel == 16 ? 1 : 0);
+			ADD(EncodeRegTo64(offset), srcReg, EncodeRegTo64(offset), ArithOption(EncodeRegTo64(offset), ST_LSL, shift));
+		}
+	} else {
+		// Swizzled textures are in 16 byte by 8 row tiles, see GetPixelDataOffset().
+		// First, the position within the tile row: (v & 7) * 16.
+		UBFIZ(offset, v, 4, 3);
+
+		// Then the tile row: (v / 8) * (bufw * bits / 32) * 32.
+		int rowShift = bitsPerTexel == 4 ? 3 : (bitsPerTexel == 8 ? 2 : (bitsPerTexel == 16 ? 1 : 0));
+		LSR(temp, v, 3);
+		if (rowShift != 0) {
+			LSR(temp2, bufw, rowShift);
+			MUL(temp, temp, temp2);
+		} else {
+			MUL(temp, temp, bufw);
+		}
+		ADD(offset, offset, temp, ArithOption(temp, ST_LSL, 5));
+
+		// And now the byte in the row: (byteu / 16) * 128 + (byteu & 15).
+		if (bitsPerTexel == 4)
+			LSR(temp, u, 1);
+		else if (bitsPerTexel == 8)
+			MOV(temp, u);
+		else
+			LSL(temp, u, bitsPerTexel == 32 ? 2 : 1);
+		LSR(temp2, temp, 4);
+		ADD(offset, offset, temp2, ArithOption(temp2, ST_LSL, 7));
+		ANDI2R(temp, temp, 15);
+		ADD(offset, offset, temp);
+		ADD(EncodeRegTo64(offset), srcReg, EncodeRegTo64(offset));
+	}
+
+	ARM64Reg result = DecodeReg(resultReg);
+	switch (bitsPerTexel) {
+	case 32:
+		LDR(INDEX_UNSIGNED, result, EncodeRegTo64(offset), 0);
+		break;
+
+	case 16:
+		LDRH(INDEX_UNSIGNED, result, EncodeRegTo64(offset), 0);
+		break;
+
+	case 8:
+	case 4:
+		LDRB(INDEX_UNSIGNED, result, EncodeRegTo64(offset), 0);
+		break;
+
+	default:
+		_assert_msg_(false, "Unexpected bits per texel %d", bitsPerTexel);
+	}
+
+	regCache_.Release(temp2Reg, RegCache::GEN_TEMP2);
+	regCache_.Release(tempReg, RegCache::GEN_TEMP1);
+	regCache_.Release(offsetReg, RegCache::GEN_TEMP0);
+	regCache_.Unlock(resultReg, RegCache::GEN_RESULT);
+	regCache_.Unlock(bufwReg, RegCache::GEN_ARG_BUFW);
+	regCache_.Unlock(srcReg, RegCache::GEN_ARG_TEXPTR);
+	return true;
+}
+
+static void ExpandChannel(ARM64XEmitter *emit, ARM64Reg dstReg, ARM64Reg srcReg, ARM64Reg tempReg, int srcShift, int bits, int dstShift) {
+	emit->UBFX(tempReg, srcReg, srcShift, bits);
+	emit->LSL(tempReg, tempReg, 8 - bits);
+	emit->ORR(tempReg, tempReg, tempReg, ArithOption(tempReg, ST_LSR, bits));
+	emit->BFI(dstReg, tempReg, dstShift, 8);
+}
+
+bool SamplerJitCache::Jit_Decode5650(const SamplerID &id) {
+	Describe("5650");
+	RegCache::Reg resultReg = regCache_.Find(RegCache::GEN_RESULT);
+	RegCache::Reg temp1Reg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	RegCache::Reg temp2Reg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	ARM64Reg c = DecodeReg(resultReg);
+	ARM64Reg t1 = DecodeReg(temp1Reg);
+	ARM64Reg t2 = DecodeReg(temp2Reg);
+
+	MOV(t1, c);
+	MOVI2R(c, 0xFF000000);
+	ExpandChannel(this, c, t1, t2, 0, 5, 0);
+	ExpandChannel(this, c, t1, t2, 5, 6, 8);
+	ExpandChannel(this, c, t1, t2, 11, 5, 16);
+
+	regCache_.Release(temp2Reg, RegCache::GEN_TEMP1);
+	regCache_.Release(temp1Reg, RegCache::GEN_TEMP0);
+	regCache_.Unlock(resultReg, RegCache::GEN_RESULT);
+	return true;
+}
+
+bool SamplerJitCache::Jit_Decode5551(const SamplerID &id) {
+	Describe("5551");
+	RegCache::Reg resultReg = regCache_.Find(RegCache::GEN_RESULT);
+	RegCache::Reg temp1Reg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	RegCache::Reg temp2Reg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	ARM64Reg c = DecodeReg(resultReg);
+	ARM64Reg t1 = DecodeReg(temp1Reg);
+	ARM64Reg t2 = DecodeReg(temp2Reg);
+
+	MOV(t1, c);
+	MOVI2R(c, 0);
+	ExpandChannel(this, c, t1, t2, 0, 5, 0);
+	ExpandChannel(this, c, t1, t2, 5, 5, 8);
+	ExpandChannel(this, c, t1, t2, 10, 5, 16);
+	// Spread the single alpha bit to all 8 bits.
+	SBFM(t2, t1, 15, 15);
+	BFI(c, t2, 24, 8);
+
+	regCache_.Release(temp2Reg, RegCache::GEN_TEMP1);
+	regCache_.Release(temp1Reg, RegCache::GEN_TEMP0);
+	regCache_.Unlock(resultReg, RegCache::GEN_RESULT);
+	return true;
+}
+
+bool SamplerJitCache::Jit_Decode4444(const SamplerID &id) {
+	Describe("4444");
+	RegCache::Reg resultReg = regCache_.Find(RegCache::GEN_RESULT);
+	RegCache::Reg temp1Reg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	RegCache::Reg temp2Reg = regCache_.Alloc(RegCache::GEN_TEMP1);
+	ARM64Reg c = DecodeReg(resultReg);
+	ARM64Reg t1 = DecodeReg(temp1Reg);
+	ARM64Reg t2 = DecodeReg(temp2Reg);
+
+	MOV(t1, c);
+	MOVI2R(c, 0);
+	ExpandChannel(this, c, t1, t2, 0, 4, 0);
+	ExpandChannel(this, c, t1, t2, 4, 4, 8);
+	ExpandChannel(this, c, t1, t2, 8, 4, 16);
+	ExpandChannel(this, c, t1, t2, 12, 4, 24);
+
+	regCache_.Release(temp2Reg, RegCache::GEN_TEMP1);
+	regCache_.Release(temp1Reg, RegCache::GEN_TEMP0);
+	regCache_.Unlock(resultReg, RegCache::GEN_RESULT);
+	return true;
+}
+
+bool SamplerJitCache::Jit_TransformClutIndex(const SamplerID &id, int bitsPerIndex) {
+	Describe("TrCLUT");
+	RegCache::Reg resultReg = regCache_.Find(RegCache::GEN_RESULT);
+	ARM64Reg index = DecodeReg(resultReg);
+
+	if (id.hasClutShift || id.hasClutMask || id.hasClutOffset) {
+		RegCache::Reg formatReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+		RegCache::Reg tempReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+		ARM64Reg format = DecodeReg(formatReg);
+		ARM64Reg temp = DecodeReg(tempReg);
+
+		RegCache::Reg idReg = GetSamplerID();
+		LDR(INDEX_UNSIGNED, format, idReg, offsetof(SamplerID, cached.clutFormat));
+		UnlockSamplerID(idReg);
+
+		if (id.hasClutShift) {
+			UBFX(temp, format, 2, 5);
+			LSRV(index, index, temp);
+		}
+
+		if (id.hasClutMask) {
+			UBFX(temp, format, 8, 8);
+			AND(index, index, temp);
+		} else if (bitsPerIndex > 8) {
+			ANDI2R(index, index, 0xFF);
+		}
+
+		if (id.hasClutOffset) {
+			// We need to wrap any entries beyond the first 1024 bytes.
+			UBFX(temp, format, 16, 5);
+			LSL(temp, temp, 4);
+			ANDI2R(temp, temp, id.ClutFmt() == GE_CMODE_32BIT_ABGR8888 ? 0xFF : 0x1FF);
+			ORR(index, index, temp);
+		}
+
+		regCache_.Release(tempReg, RegCache::GEN_TEMP1);
+		regCache_.Release(formatReg, RegCache::GEN_TEMP0);
+	} else if (bitsPerIndex > 8) {
+		ANDI2R(index, index, 0xFF);
+	}
+
+	// Only CLUT4 uses separate mipmap palettes.
+	if (id.TexFmt() == GE_TFMT_CLUT4 && !id.useSharedClut) {
+		RegCache::Reg levelReg = regCache_.Find(RegCache::GEN_ARG_LEVEL);
+		ADD(index, index, DecodeReg(levelReg), ArithOption(DecodeReg(levelReg), ST_LSL, 4));
+		regCache_.Unlock(levelReg, RegCache::GEN_ARG_LEVEL);
+	}
+
+	regCache_.Unlock(resultReg, RegCache::GEN_RESULT);
+	return true;
+}
+
+bool SamplerJitCache::Jit_ReadClutColor(const SamplerID &id) {
+	Describe("ReadCLUT");
+	RegCache::Reg resultReg = regCache_.Find(RegCache::GEN_RESULT);
+	RegCache::Reg clutBaseReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+
+	RegCache::Reg idReg = GetSamplerID();
+	LDR(INDEX_UNSIGNED, clutBaseReg, idReg, offsetof(SamplerID, cached.clut));
+	UnlockSamplerID(idReg);
+
+	// The index is zero extended, so this scales it by the entry size.
+	ARM64Reg index = EncodeRegTo64(resultReg);
+	if (id.ClutFmt() == GE_CMODE_32BIT_ABGR8888)
+		LDR(DecodeReg(resultReg), clutBaseReg, ArithOption(index, true));
+	else
+		LDRH(DecodeReg(resultReg), clutBaseReg, ArithOption(index, true));
+	regCache_.Release(clutBaseReg, RegCache::GEN_TEMP0);
+	regCache_.Unlock(resultReg, RegCache::GEN_RESULT);
+
+	switch (id.ClutFmt()) {
+	case GE_CMODE_16BIT_BGR5650:
+		return Jit_Decode5650(id);
+
+	case GE_CMODE_16BIT_ABGR5551:
+		return Jit_Decode5551(id);
+
+	case GE_CMODE_16BIT_ABGR4444:
+		return Jit_Decode4444(id);
+
+	case GE_CMODE_32BIT_ABGR8888:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+bool SamplerJitCache::Jit_ApplyTextureFunc(const SamplerID &id) {
+	Describe("TexFunc");
+	const bool rgba = id.useTextureAlpha;
+	const bool doubling = id.useColorDoubling;
+
+	RegCache::Reg resultReg = regCache_.Find(RegCache::VEC_RESULT);
+	RegCache::Reg primReg = regCache_.Find(RegCache::VEC_ARG_COLOR);
+	RegCache::Reg temp0Reg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	RegCache::Reg temp1Reg = regCache_.Alloc(RegCache::VEC_TEMP1);
+	RegCache::Reg temp2Reg = regCache_.Alloc(RegCache::VEC_TEMP2);
+	RegCache::Reg genTempReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+
+	auto dup32 = [&](ARM64Reg dest, u32 value) {
+		MOVI2R(DecodeReg(genTempReg), value);
+		fp.DUP(32, dest, DecodeReg(genTempReg));
+	};
+	// Doubling only applies to RGB, so shift all and put the alpha lane back.
+	auto doubleRGB = [&](ARM64Reg reg) {
+		fp.SHL(32, temp2Reg, reg, 1);
+		fp.INS(32, temp2Reg, 3, reg, 3);
+		fp.MOV(reg, temp2Reg);
+	};
+	// The common way to blend alpha: ((prim.a + 1) * tex.a) / 256, into the alpha lane of dest.
+	auto blendAlpha = [&](ARM64Reg dest) {
+		if (rgba) {
+			dup32(temp2Reg, 1);
+			fp.ADD(32, temp2Reg, primReg, temp2Reg);
+			fp.MUL(32, temp2Reg, temp2Reg, resultReg);
+			fp.USHR(32, temp2Reg, temp2Reg, 8);
+			fp.INS(32, dest, 3, temp2Reg, 3);
+		} else {
+			fp.INS(32, dest, 3, primReg, 3);
+		}
+	};
+
+	switch (id.TexFunc()) {
+	case GE_TEXFUNC_MODULATE:
+		// Modulate weights slightly on the tex color, by adding one to prim and dividing by 256.
+		dup32(temp0Reg, 1);
+		fp.ADD(32, temp0Reg, primReg, temp0Reg);
+		if (doubling)
+			doubleRGB(resultReg);
+		fp.MUL(32, resultReg, resultReg, temp0Reg);
+		fp.USHR(32, resultReg, resultReg, 8);
+		if (!rgba)
+			fp.INS(32, resultReg, 3, primReg, 3);
+		break;
+
+	case GE_TEXFUNC_DECAL:
+		if (rgba) {
+			// Both colors are boosted here: (prim + 1) * (255 - t) + (tex + 1) * t.
+			fp.DUP(32, temp0Reg, resultReg, 3);
+			dup32(temp1Reg, 255);
+			fp.SUB(32, temp1Reg, temp1Reg, temp0Reg);
+			dup32(temp2Reg, 1);
+			fp.ADD(32, resultReg, resultReg, temp2Reg);
+			fp.ADD(32, temp2Reg, primReg, temp2Reg);
+			fp.MUL(32, temp1Reg, temp1Reg, temp2Reg);
+			fp.MLA(32, temp1Reg, resultReg, temp0Reg);
+			// Keep the bits of accuracy when doubling.
+			fp.USHR(32, resultReg, temp1Reg, doubling ? 7 : 8);
+		} else if (doubling) {
+			fp.SHL(32, resultReg, resultReg, 1);
+		}
+		fp.INS(32, resultReg, 3, primReg, 3);
+		break;
+
+	case GE_TEXFUNC_BLEND:
+	{
+		// Expand the env color to 32-bit lanes.
+		RegCache::Reg idReg = GetSamplerID();
+		LDR(INDEX_UNSIGNED, DecodeReg(genTempReg), idReg, offsetof(SamplerID, cached.texBlendColor));
+		UnlockSamplerID(idReg);
+		fp.INS(32, temp0Reg, 0, DecodeReg(genTempReg));
+		fp.UXTL(8, temp0Reg, temp0Reg);
+		fp.UXTL(16, temp0Reg, temp0Reg);
+
+		// Unlike the others (and even alpha), this one simply always rounds up.
+		dup32(temp1Reg, 255);
+		fp.SUB(32, temp1Reg, temp1Reg, resultReg);
+		fp.MUL(32, temp1Reg, temp1Reg, primReg);
+		fp.MLA(32, temp1Reg, resultReg, temp0Reg);
+		dup32(temp2Reg, 255);
+		fp.ADD(32, temp1Reg, temp1Reg, temp2Reg);
+		// Must divide by less to keep the precision for doubling to be accurate.
+		fp.USHR(32, temp1Reg, temp1Reg, doubling ? 7 : 8);
+
+		blendAlpha(temp1Reg);
+		fp.MOV(resultReg, temp1Reg);
+		break;
+	}
+
+	case GE_TEXFUNC_REPLACE:
+		// Doubling even happens for replace.
+		if (doubling)
+			doubleRGB(resultReg);
+		if (!rgba)
+			fp.INS(32, resultReg, 3, primReg, 3);
+		break;
+
+	case GE_TEXFUNC_ADD:
+	case GE_TEXFUNC_UNKNOWN1:
+	case GE_TEXFUNC_UNKNOWN2:
+	case GE_TEXFUNC_UNKNOWN3:
+		// Don't need to clamp afterward, we always clamp before tests.
+		fp.ADD(32, temp1Reg, primReg, resultReg);
+		if (doubling)
+			fp.SHL(32, temp1Reg, temp1Reg, 1);
+
+		// Alpha is still blended the common way.
+		blendAlpha(temp1Reg);
+		fp.MOV(resultReg, temp1Reg);
+		break;
+	}
+
+	regCache_.Release(genTempReg, RegCache::GEN_TEMP0);
+	regCache_.Release(temp2Reg, RegCache::VEC_TEMP2);
+	regCache_.Release(temp1Reg, RegCache::VEC_TEMP1);
+	regCache_.Release(temp0Reg, RegCache::VEC_TEMP0);
+	regCache_.Unlock(primReg, RegCache::VEC_ARG_COLOR);
+	regCache_.Unlock(resultReg, RegCache::VEC_RESULT);
+	return true;
+}
+
+};
+
+#endif
@@ -24,13 +24,17 @@
 #include "GPU/Common/TextureDecoder.h"
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/GraphicsContext.h"
+#include "Common/File/FileUtil.h"
 #include "Common/LogReporting.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/Core.h"
 #include "Core/Debugger/MemBlockInfo.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/MemMap.h"
 #include "Core/MemMapHelpers.h"
+#include "Core/System.h"
 #include "Core/HLE/sceKernelInterrupt.h"
 #include "Core/HLE/sceGe.h"
 #include "Core/MIPS/MIPS.h"
@@ -56,6 +60,7 @@ const int FB_HEIGHT = 272;
 uint8_t clut[1024];
 FormatBuffer fb;
 FormatBuffer depthbuf;
+SoftGPUBenchStats g_softGPUBenchStats;
 
 struct CommandInfo {
 	uint64_t flags;
@@ -432,6 +437,15 @@ SoftGPU::SoftGPU(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 
 	Rasterizer::Init();
 	Sampler::Init();
+
+	// Compile the funcs this game used last time now, rather than stalling mid-frame later.
+	std::string discID = g_paramSFO.GetDiscID();
+	if (discID.size()) {
+		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+		jitCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".softjitcache");
+		LoadJitCache(jitCachePath_);
+	}
+
 	drawEngine_ = new SoftwareDrawEngine();
 	if (!drawEngine_)
 		return;
@@ -482,10 +496,92 @@ SoftGPU::~SoftGPU() {
 	delete presentation_;
 	delete drawEngine_;
 
+	if (!jitCachePath_.empty())
+		SaveJitCache(jitCachePath_);
 	Sampler::Shutdown();
 	Rasterizer::Shutdown();
 }
 
+// Only the func IDs are stored, so this is valid on any CPU - it's just a list to compile.
+static const uint32_t SOFT_JIT_CACHE_MAGIC = 0x54494A53;  // SJIT
+static const uint32_t SOFT_JIT_CACHE_VERSION = 1;
+
+struct SoftJitCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t pixelIDSize;
+	uint32_t samplerIDSize;
+	uint32_t numPixelKeys;
+	uint32_t numSamplerKeys;
+};
+
+void SoftGPU::LoadJitCache(const Path &filename) {
+	if (!g_Config.bShaderCache || !g_Config.bSoftwareRenderingJit)
+		return;
+
+	FILE *f = File::OpenCFile(filename, "rb");
+	if (!f)
+		return;
+
+	SoftJitCacheHeader header{};
+	bool result = fread(&header, sizeof(header), 1, f) == 1;
+	// If the ID layout changed, the keys would mean something else.
+	result = result && header.magic == SOFT_JIT_CACHE_MAGIC && header.version == SOFT_JIT_CACHE_VERSION;
+	result = result && header.pixelIDSize == sizeof(PixelFuncID) && header.samplerIDSize == sizeof(SamplerID);
+	// Sanity check, there are never this many.
+	result = result && header.numPixelKeys < 0x10000 && header.numSamplerKeys < 0x10000;
+
+	std::vector<uint64_t> pixelKeys;
+	std::vector<uint32_t> samplerKeys;
+	if (result) {
+		pixelKeys.resize(header.numPixelKeys);
+		samplerKeys.resize(header.numSamplerKeys);
+		result = fread(pixelKeys.data(), sizeof(uint64_t), pixelKeys.size(), f) == pixelKeys.size();
+		result = result && fread(samplerKeys.data(), sizeof(uint32_t), samplerKeys.size(), f) == samplerKeys.size();
+	}
+	fclose(f);
+
+	if (!result) {
+		WARN_LOG(G3D, "Incompatible software renderer jit cache - rebuilding.");
+		File::Delete(filename);
+		return;
+	}
+
+	PROFILE_THIS_SCOPE("jitcache");
+	Rasterizer::PrecompileJit(pixelKeys);
+	Sampler::PrecompileJit(samplerKeys);
+	INFO_LOG(G3D, "Precompiled %d pixel and %d sampler funcs from cache", (int)pixelKeys.size(), (int)samplerKeys.size());
+}
+
+void SoftGPU::SaveJitCache(const Path &filename) {
+	if (!g_Config.bShaderCache || !g_Config.bSoftwareRenderingJit)
+		return;
+
+	std::vector<uint64_t> pixelKeys;
+	std::vector<uint32_t> samplerKeys;
+	Rasterizer::GetJitKeys(pixelKeys);
+	Sampler::GetJitKeys(samplerKeys);
+	if (pixelKeys.empty() && samplerKeys.empty())
+		return;
+
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f)
+		return;
+
+	SoftJitCacheHeader header{};
+	header.magic = SOFT_JIT_CACHE_MAGIC;
+	header.version = SOFT_JIT_CACHE_VERSION;
+	header.pixelIDSize = sizeof(PixelFuncID);
+	header.samplerIDSize = sizeof(SamplerID);
+	header.numPixelKeys = (uint32_t)pixelKeys.size();
+	header.numSamplerKeys = (uint32_t)samplerKeys.size();
+	fwrite(&header, sizeof(header), 1, f);
+	fwrite(pixelKeys.data(), sizeof(uint64_t), pixelKeys.size(), f);
+	fwrite(samplerKeys.data(), sizeof(uint32_t), samplerKeys.size(), f);
+	fclose(f);
+	INFO_LOG(G3D, "Saved software renderer jit cache");
+}
+
 void SoftGPU::SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat format) {
 	// Seems like this can point into RAM, but should be VRAM if not in RAM.
 	displayFramebuf_ = (framebuf & 0xFF000000) == 0 ? 0x44000000 | framebuf : framebuf;
@@ -504,27 +600,32 @@ void SoftGPU::ConvertTextureDescFrom16(Draw::TextureDesc &desc, int srcwidth, in
 	if (!displayBuffer)
 		displayBuffer = (const uint16_t *)Memory::GetPointer(displayFramebuf_);
 
-	for (int y = 0; y < srcheight; ++y) {
-		u32 *buf_line = &fbTexBuffer_[y * srcwidth];
-		const u16 *fb_line = &displayBuffer[y * displayStride_];
+	void (*convertLine)(u32 *dst, const u16 *src, u32 numPixels) = nullptr;
+	switch (displayFormat_) {
+	case GE_FORMAT_565:
+		convertLine = &ConvertRGB565ToRGBA8888;
+		break;
 
-		switch (displayFormat_) {
-		case GE_FORMAT_565:
-			ConvertRGB565ToRGBA8888(buf_line, fb_line, srcwidth);
-			break;
+	case GE_FORMAT_5551:
+		convertLine = &ConvertRGBA5551ToRGBA8888;
+		break;
 
-		case GE_FORMAT_5551:
-			ConvertRGBA5551ToRGBA8888(buf_line, fb_line, srcwidth);
-			break;
+	case GE_FORMAT_4444:
+		convertLine = &ConvertRGBA4444ToRGBA8888;
+		break;
 
-		case GE_FORMAT_4444:
-			ConvertRGBA4444ToRGBA8888(buf_line, fb_line, srcwidth);
-			break;
+	default:
+		ERROR_LOG_REPORT(G3D, "Software: Unexpected framebuffer format: %d", displayFormat_);
+		break;
+	}
 
-		default:
-			ERROR_LOG_REPORT(G3D, "Software: Unexpected framebuffer format: %d", displayFormat_);
-			break;
-		}
+	if (convertLine) {
+		// Bands of rows, a full frame is split in a few pieces at most.
+		ParallelRangeLoop(&g_threadManager, [&](int y1, int y2) {
+			for (int y = y1; y < y2; ++y) {
+				convertLine(&fbTexBuffer_[y * srcwidth], &displayBuffer[y * displayStride_], srcwidth);
+			}
+		}, 0, srcheight, 68, TaskPriority::HIGH);
 	}
 
 	desc.width = srcwidth;
@@ -600,15 +701,29 @@ void SoftGPU::CopyToCurrentFboFromDisplayRam(int srcwidth, int srcheight) {
 		desc.height = srcheight;
 		desc.initData.push_back(data);
 		desc.format = Draw::DataFormat::R8G8B8A8_UNORM;
-	} else if (displayFormat_ == GE_FORMAT_5551) {
+	} else if (displayFormat_ == GE_FORMAT_5551 || displayFormat_ == GE_FORMAT_565 || displayFormat_ == GE_FORMAT_4444) {
+		// Upload the 16-bit data as is where we can, to skip converting on this thread.
+		Draw::DataFormat perfectFormat = Draw::DataFormat::UNDEFINED;
+		Draw::DataFormat swappedFormat = Draw::DataFormat::UNDEFINED;
+		if (displayFormat_ == GE_FORMAT_5551) {
+			perfectFormat = Draw::DataFormat::A1B5G5R5_UNORM_PACK16;
+			swappedFormat = Draw::DataFormat::A1R5G5B5_UNORM_PACK16;
+		} else if (displayFormat_ == GE_FORMAT_565) {
+			perfectFormat = Draw::DataFormat::B5G6R5_UNORM_PACK16;
+			swappedFormat = Draw::DataFormat::R5G6B5_UNORM_PACK16;
+		} else {
+			// Nothing has a 4444 format with A on top and R at the bottom.
+			swappedFormat = Draw::DataFormat::A4R4G4B4_UNORM_PACK16;
+		}
+
 		const u8 *data = Memory::GetPointer(displayFramebuf_);
 		bool fillDesc = true;
-		if (draw_->GetDataFormatSupport(Draw::DataFormat::A1B5G5R5_UNORM_PACK16) & Draw::FMT_TEXTURE) {
+		if (perfectFormat != Draw::DataFormat::UNDEFINED && (draw_->GetDataFormatSupport(perfectFormat) & Draw::FMT_TEXTURE)) {
 			// The perfect one.
-			desc.format = Draw::DataFormat::A1B5G5R5_UNORM_PACK16;
-		} else if (!hasPostShader && (draw_->GetDataFormatSupport(Draw::DataFormat::A1R5G5B5_UNORM_PACK16) & Draw::FMT_TEXTURE)) {
+			desc.format = perfectFormat;
+		} else if (!hasPostShader && (draw_->GetDataFormatSupport(swappedFormat) & Draw::FMT_TEXTURE)) {
 			// RB swapped, compensate with a shader.
-			desc.format = Draw::DataFormat::A1R5G5B5_UNORM_PACK16;
+			desc.format = swappedFormat;
 			outputFlags |= OutputFlags::RB_SWIZZLE;
 		} else {
 			ConvertTextureDescFrom16(desc, srcwidth, srcheight);
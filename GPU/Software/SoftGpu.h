@@ -18,6 +18,7 @@
 #pragma once
 
 #include <cstdint>
+#include "Common/File/Path.h"
 #include "GPU/GPUCommon.h"
 #include "GPU/Common/GPUDebugInterface.h"
 #include "Common/GPU/thin3d.h"
@@ -217,6 +218,9 @@ class SoftGPU : public GPUCommon {
 	bool ClearDirty(uint32_t addr, uint32_t stride, uint32_t height, GEBufferFormat fmt, SoftGPUVRAMDirty value);
 	bool ClearDirty(uint32_t addr, uint32_t bytes, SoftGPUVRAMDirty value);
 
+	void LoadJitCache(const Path &filename);
+	void SaveJitCache(const Path &filename);
+
 	uint8_t vramDirty_[2048];
 	uint32_t lastDirtyAddr_ = 0;
 	uint32_t lastDirtySize_ = 0;
@@ -232,6 +236,8 @@ class SoftGPU : public GPUCommon {
 
 	Draw::Texture *fbTex = nullptr;
 	std::vector<u32> fbTexBuffer_;
+
+	Path jitCachePath_;
 };
 
 // TODO: These shouldn't be global.
@@ -239,6 +245,22 @@ extern uint8_t clut[1024];
 extern FormatBuffer fb;
 extern FormatBuffer depthbuf;
 
+// Cumulative time spent per stage, for benchmarks.  Only collected with debug stats on,
+// except jit compiles which are rare enough to always time.  All in seconds.
+struct SoftGPUBenchStats {
+	// Read, transform, light, clip, and bin (excluding waits for flushes.)
+	double transform = 0.0;
+	// Waiting on rasterization and sampling on the bin threads.
+	double flushWait = 0.0;
+	double pixelJit = 0.0;
+	double samplerJit = 0.0;
+
+	void Reset() {
+		*this = SoftGPUBenchStats();
+	}
+};
+extern SoftGPUBenchStats g_softGPUBenchStats;
+
 // Type for the DarkStalkers stretch replacement.
 enum class DSStretch {
 	Off = 0,
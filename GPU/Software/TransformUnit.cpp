@@ -23,7 +23,10 @@
 #include "Common/Math/math_util.h"
 #include "Common/MemoryUtil.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
+#include "Core/System.h"
 #include "GPU/GPUState.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/VertexDecoderCommon.h"
@@ -79,6 +82,13 @@ void SoftwareDrawEngine::DispatchFlush() {
 
 void SoftwareDrawEngine::DispatchSubmitPrim(const void *verts, const void *inds, GEPrimitiveType prim, int vertexCount, u32 vertTypeID, int cullMode, int *bytesRead) {
 	_assert_msg_(cullMode == gstate.getCullMode(), "Mixed cull mode not supported.");
+	if (coreCollectDebugStats) {
+		double st = time_now_d();
+		double waitBefore = g_softGPUBenchStats.flushWait;
+		transformUnit.SubmitPrimitive(verts, inds, prim, vertexCount, vertTypeID, bytesRead, this);
+		g_softGPUBenchStats.transform += time_now_d() - st - (g_softGPUBenchStats.flushWait - waitBefore);
+		return;
+	}
 	transformUnit.SubmitPrimitive(verts, inds, prim, vertexCount, vertTypeID, bytesRead, this);
 }
 
@@ -341,28 +351,29 @@ void ComputeTransformState(TransformState *state, const VertexReader &vreader) {
 		state->roundToScreen = &ClipToScreenInternal<false, false>;
 }
 
-ClipVertexData TransformUnit::ReadVertex(const VertexReader &vreader, const TransformState &state) {
-	PROFILE_THIS_SCOPE("read_vert");
-	// If we ever thread this, we'll have to change this.
-	ClipVertexData vertex;
+// Attributes that carry over from the previous vertex (even across draws) when missing.
+struct VertexCarry {
+	Vec3Packedf lastTC;
+	Vec3f lastnormal;
+};
 
-	ModelCoords pos;
+static VertexCarry vertexCarry;
+
+static inline void ReadVertexAttributes(const VertexReader &vreader, const TransformState &state, VertexCarry &carry, ClipVertexData &vertex, ModelCoords &pos, Vec3f &normal) {
 	// VertexDecoder normally scales z, but we want it unscaled.
 	vreader.ReadPosThroughZ16(pos.AsArray());
 
-	static Vec3Packedf lastTC;
 	if (state.readUV) {
 		vreader.ReadUV(vertex.v.texturecoords.AsArray());
 		vertex.v.texturecoords.q() = 0.0f;
-		lastTC = vertex.v.texturecoords;
+		carry.lastTC = vertex.v.texturecoords;
 	} else {
-		vertex.v.texturecoords = lastTC;
+		vertex.v.texturecoords = carry.lastTC;
 	}
 
-	static Vec3f lastnormal;
 	if (vreader.hasNormal())
-		vreader.ReadNrm(lastnormal.AsArray());
-	Vec3f normal = lastnormal;
+		vreader.ReadNrm(carry.lastnormal.AsArray());
+	normal = carry.lastnormal;
 	if (state.negateNormals)
 		normal = -normal;
 
@@ -373,6 +384,71 @@ ClipVertexData TransformUnit::ReadVertex(const VertexReader &vreader, const Tran
 	}
 
 	vertex.v.color1 = 0;
+}
+
+// Everything after the clip position and screen scaling for a transformed vertex.
+static inline void FinishTransformedVertex(ClipVertexData &vertex, const ModelCoords &pos, const WorldCoords &worldpos, const Vec3f &normal, const Vec3f &screenScaled, const TransformState &state) {
+	bool outside_range_flag = false;
+	vertex.v.screenpos = state.roundToScreen(screenScaled, vertex.clippos, &outside_range_flag);
+	if (outside_range_flag) {
+		// We use this, essentially, as the flag.
+		vertex.v.screenpos.x = 0x7FFFFFFF;
+		return;
+	}
+
+	if (state.enableFog) {
+		vertex.v.fogdepth = Dot(state.posToFog, Vec4f(pos, 1.0f));
+	} else {
+		vertex.v.fogdepth = 1.0f;
+	}
+	vertex.v.clipw = vertex.clippos.w;
+
+	Vec3<float> worldnormal;
+	if (state.enableLighting || state.uvGenMode == GE_TEXMAP_ENVIRONMENT_MAP) {
+		worldnormal = TransformUnit::ModelToWorldNormal(normal);
+		worldnormal.NormalizeOr001();
+	}
+
+	// Time to generate some texture coords.  Lighting will handle shade mapping.
+	if (state.uvGenMode == GE_TEXMAP_TEXTURE_MATRIX) {
+		Vec3f source;
+		switch (gstate.getUVProjMode()) {
+		case GE_PROJMAP_POSITION:
+			source = pos;
+			break;
+
+		case GE_PROJMAP_UV:
+			source = Vec3f(vertex.v.texturecoords.uv(), 0.0f);
+			break;
+
+		case GE_PROJMAP_NORMALIZED_NORMAL:
+			// This does not use 0, 0, 1 if length is zero.
+			source = normal.Normalized(cpu_info.bSSE4_1);
+			break;
+
+		case GE_PROJMAP_NORMAL:
+			source = normal;
+			break;
+		}
+
+		// Note that UV scale/offset are not used in this mode.
+		Vec3<float> stq = Vec3ByMatrix43(source, gstate.tgenMatrix);
+		vertex.v.texturecoords = Vec3Packedf(stq.x, stq.y, stq.z);
+	} else if (state.uvGenMode == GE_TEXMAP_ENVIRONMENT_MAP) {
+		Lighting::GenerateLightST(vertex.v, worldnormal);
+	}
+
+	PROFILE_THIS_SCOPE("light");
+	if (state.enableLighting)
+		Lighting::Process(vertex.v, worldpos, worldnormal, state.lightingState);
+}
+
+static ClipVertexData ReadVertexInternal(const VertexReader &vreader, const TransformState &state, VertexCarry &carry) {
+	ClipVertexData vertex;
+
+	ModelCoords pos;
+	Vec3f normal;
+	ReadVertexAttributes(vreader, state, carry, vertex, pos, normal);
 
 	if (state.enableTransform) {
 		WorldCoords worldpos;
@@ -396,68 +472,104 @@ ClipVertexData TransformUnit::ReadVertex(const VertexReader &vreader, const Tran
 #else
 		screenScaled = vertex.clippos.xyz() * state.screenScale / vertex.clippos.w + state.screenAdd;
 #endif
-		bool outside_range_flag = false;
-		vertex.v.screenpos = state.roundToScreen(screenScaled, vertex.clippos, &outside_range_flag);
-		if (outside_range_flag) {
-			// We use this, essentially, as the flag.
-			vertex.v.screenpos.x = 0x7FFFFFFF;
-			return vertex;
-		}
+		FinishTransformedVertex(vertex, pos, worldpos, normal, screenScaled, state);
+	} else {
+		vertex.v.screenpos.x = (int)(pos[0] * SCREEN_SCALE_FACTOR);
+		vertex.v.screenpos.y = (int)(pos[1] * SCREEN_SCALE_FACTOR);
+		vertex.v.screenpos.z = pos[2];
+		vertex.v.clipw = 1.0f;
+		vertex.v.fogdepth = 1.0f;
+	}
 
-		if (state.enableFog) {
-			vertex.v.fogdepth = Dot(state.posToFog, Vec4f(pos, 1.0f));
-		} else {
-			vertex.v.fogdepth = 1.0f;
-		}
-		vertex.v.clipw = vertex.clippos.w;
+	return vertex;
+}
 
-		Vec3<float> worldnormal;
-		if (state.enableLighting || state.uvGenMode == GE_TEXMAP_ENVIRONMENT_MAP) {
-			worldnormal = TransformUnit::ModelToWorldNormal(normal);
-			worldnormal.NormalizeOr001();
-		}
+ClipVertexData TransformUnit::ReadVertex(const VertexReader &vreader, const TransformState &state) {
+	PROFILE_THIS_SCOPE("read_vert");
+	return ReadVertexInternal(vreader, state, vertexCarry);
+}
 
-		// Time to generate some texture coords.  Lighting will handle shade mapping.
-		if (state.uvGenMode == GE_TEXMAP_TEXTURE_MATRIX) {
-			Vec3f source;
-			switch (gstate.getUVProjMode()) {
-			case GE_PROJMAP_POSITION:
-				source = pos;
-				break;
+bool TransformUnit::CanReadVerticesBatched(const TransformState &state) {
+#if defined(_M_SSE) && PPSSPP_ARCH(64BIT)
+	// Lighting with positional lights needs world positions, which we don't batch (yet.)
+	return state.enableTransform && MatrixMode(state.matrixMode) == MatrixMode::POS_TO_CLIP;
+#else
+	return false;
+#endif
+}
 
-			case GE_PROJMAP_UV:
-				source = Vec3f(vertex.v.texturecoords.uv(), 0.0f);
-				break;
+static void ReadVertexRange(VertexReader &vreader, const TransformState &state, VertexCarry &carry, int first, int count, ClipVertexData *out) {
+	int i = 0;
+#if defined(_M_SSE) && PPSSPP_ARCH(64BIT)
+	if (TransformUnit::CanReadVerticesBatched(state)) {
+		PROFILE_THIS_SCOPE("read_vert4");
+		const WorldCoords worldpos{};
+		for (; i + 4 <= count; i += 4) {
+			ModelCoords pos[4];
+			Vec3f normal[4];
+			for (int j = 0; j < 4; ++j) {
+				vreader.Goto(first + i + j);
+				ReadVertexAttributes(vreader, state, carry, out[i + j], pos[j], normal[j]);
+			}
 
-			case GE_PROJMAP_NORMALIZED_NORMAL:
-				// This does not use 0, 0, 1 if length is zero.
-				source = normal.Normalized(cpu_info.bSSE4_1);
-				break;
+			// Transpose to one vector per component, so we can do four verts per op.
+			__m128 px = pos[0].vec, py = pos[1].vec, pz = pos[2].vec, pw = pos[3].vec;
+			_MM_TRANSPOSE4_PS(px, py, pz, pw);
 
-			case GE_PROJMAP_NORMAL:
-				source = normal;
-				break;
+			// Same operations (and order) as Vec3ByMatrix44, so results are identical.
+			__m128 clip[4];
+			for (int k = 0; k < 4; ++k) {
+				__m128 xy = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(state.matrix[k]), px), _mm_mul_ps(_mm_set1_ps(state.matrix[4 + k]), py));
+				__m128 zw = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(state.matrix[8 + k]), pz), _mm_set1_ps(state.matrix[12 + k]));
+				clip[k] = _mm_add_ps(xy, zw);
 			}
 
-			// Note that UV scale/offset are not used in this mode.
-			Vec3<float> stq = Vec3ByMatrix43(source, gstate.tgenMatrix);
-			vertex.v.texturecoords = Vec3Packedf(stq.x, stq.y, stq.z);
-		} else if (state.uvGenMode == GE_TEXMAP_ENVIRONMENT_MAP) {
-			Lighting::GenerateLightST(vertex.v, worldnormal);
+			__m128 scaled[4];
+			for (int k = 0; k < 3; ++k) {
+				scaled[k] = _mm_mul_ps(clip[k], _mm_set1_ps(state.screenScale[k]));
+				scaled[k] = _mm_div_ps(scaled[k], clip[3]);
+				scaled[k] = _mm_add_ps(scaled[k], _mm_set1_ps(state.screenAdd[k]));
+			}
+			scaled[3] = _mm_setzero_ps();
+
+			_MM_TRANSPOSE4_PS(clip[0], clip[1], clip[2], clip[3]);
+			_MM_TRANSPOSE4_PS(scaled[0], scaled[1], scaled[2], scaled[3]);
+			for (int j = 0; j < 4; ++j) {
+				ClipVertexData &vertex = out[i + j];
+				vertex.clippos.vec = clip[j];
+				Vec3f screenScaled;
+				screenScaled.vec = scaled[j];
+				FinishTransformedVertex(vertex, pos[j], worldpos, normal[j], screenScaled, state);
+			}
 		}
+	}
+#endif
 
-		PROFILE_THIS_SCOPE("light");
-		if (state.enableLighting)
-			Lighting::Process(vertex.v, worldpos, worldnormal, state.lightingState);
-	} else {
-		vertex.v.screenpos.x = (int)(pos[0] * SCREEN_SCALE_FACTOR);
-		vertex.v.screenpos.y = (int)(pos[1] * SCREEN_SCALE_FACTOR);
-		vertex.v.screenpos.z = pos[2];
-		vertex.v.clipw = 1.0f;
-		vertex.v.fogdepth = 1.0f;
+	for (; i < count; ++i) {
+		vreader.Goto(first + i);
+		out[i] = ReadVertexInternal(vreader, state, carry);
 	}
+}
 
-	return vertex;
+void TransformUnit::ReadVertices(VertexReader &vreader, const TransformState &state, int first, int count, ClipVertexData *out) {
+	// Below this, it's not worth waking up other threads.
+	static constexpr int MIN_VERTS_PER_THREAD = 512;
+	if (count < MIN_VERTS_PER_THREAD * 2 || g_threadManager.GetNumLooperThreads() <= 1) {
+		ReadVertexRange(vreader, state, vertexCarry, first, count, out);
+		return;
+	}
+
+	// Each vert is independent, except for the carried UV and normal.
+	// Within a draw those are either always read, or never change, so every range starts from the same carry.
+	const VertexCarry startCarry = vertexCarry;
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		VertexReader reader = vreader;
+		VertexCarry carry = startCarry;
+		ReadVertexRange(reader, state, carry, first + l, h - l, out + l);
+		// Only the range with the last vert can update the carry for the next draw.
+		if (h == count)
+			vertexCarry = carry;
+	}, 0, count, MIN_VERTS_PER_THREAD);
 }
 
 void TransformUnit::SetDirty(SoftDirty flags) {
@@ -472,6 +584,7 @@ class SoftwareVertexReader {
 	SoftwareVertexReader(u8 *base, VertexDecoder &vdecoder, u32 vertex_type, int vertex_count, const void *vertices, const void *indices, const TransformState &transformState, TransformUnit &transform)
 	: vreader_(base, vdecoder.GetDecVtxFmt(), vertex_type), conv_(vertex_type, indices), transformState_(transformState), transform_(transform) {
 		useIndices_ = indices != nullptr;
+		vertexCount_ = vertex_count;
 		lowerBound_ = 0;
 		upperBound_ = vertex_count == 0 ? 0 : vertex_count - 1;
 
@@ -496,13 +609,16 @@ class SoftwareVertexReader {
 	}
 
 	void UpdateCache() {
+		// Linear draws can also go through the cache, if it lets us transform in batches.
+		if (!useIndices_ && vertexCount_ >= 8 && transform_.CanReadVerticesBatched(transformState_)) {
+			useCache_ = true;
+			if (cached_.size() < (size_t)vertexCount_)
+				cached_.resize(std::max(128, vertexCount_));
+		}
 		if (!useCache_)
 			return;
 
-		for (int i = 0; i < upperBound_ - lowerBound_ + 1; ++i) {
-			vreader_.Goto(i);
-			cached_[i] = transform_.ReadVertex(vreader_, transformState_);
-		}
+		transform_.ReadVertices(vreader_, transformState_, 0, upperBound_ - lowerBound_ + 1, cached_.data());
 	}
 
 	inline ClipVertexData Read(int vtx) {
@@ -512,6 +628,8 @@ class SoftwareVertexReader {
 			}
 			vreader_.Goto(conv_(vtx) - lowerBound_);
 		} else {
+			if (useCache_)
+				return cached_[vtx];
 			vreader_.Goto(vtx);
 		}
 
@@ -525,6 +643,7 @@ class SoftwareVertexReader {
 	TransformUnit &transform_;
 	uint16_t lowerBound_;
 	uint16_t upperBound_;
+	int vertexCount_;
 	static std::vector<ClipVertexData> cached_;
 	bool useIndices_ = false;
 	bool useCache_ = false;
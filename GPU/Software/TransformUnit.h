@@ -150,8 +150,13 @@ class TransformUnit {
 	void SetDirty(SoftDirty flags);
 	SoftDirty GetDirty();
 
+	// Whether ReadVertices() can transform several verts at once in this state.
+	static bool CanReadVerticesBatched(const TransformState &state);
+
 private:
 	ClipVertexData ReadVertex(const VertexReader &vreader, const TransformState &state);
+	// Reads and transforms count verts starting at first, four at a time and on several threads when possible.
+	void ReadVertices(VertexReader &vreader, const TransformState &state, int first, int count, ClipVertexData *out);
 	void SendTriangle(CullType cullType, const ClipVertexData *verts, int provoking = 2);
 
 	u8 *decoded_ = nullptr;
@@ -30,6 +30,7 @@
 #include "Core/System.h"
 #include "Core/Config.h"
 #include "Core/CoreTiming.h"
+#include "Core/HW/Display.h"
 
 #include "GPU/Math3D.h"
 #include "GPU/GPUState.h"
@@ -59,9 +60,9 @@ enum {
 };
 
 #define VERTEXCACHE_DECIMATION_INTERVAL 17
-#define DESCRIPTORSET_DECIMATION_INTERVAL 1  // Temporarily cut to 1. Handle reuse breaks this when textures get deleted.
+// Descriptor sets are also dropped as soon as anything they might point to is deleted, see BeginFrame.
+#define DESCRIPTORSET_DECIMATION_INTERVAL 60
 
-enum { VAI_KILL_AGE = 120, VAI_UNRELIABLE_KILL_AGE = 240, VAI_UNRELIABLE_KILL_MAX = 4 };
 
 enum {
 	TRANSFORMED_VERTEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * sizeof(TransformedVertex)
@@ -174,6 +175,8 @@ void DrawEngineVulkan::InitDeviceObjects() {
 		frame_[i].pushUBO = new VulkanPushBuffer(vulkan, "pushUBO", 8 * 1024 * 1024, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, PushBufferType::CPU_TO_GPU);
 		frame_[i].pushVertex = new VulkanPushBuffer(vulkan, "pushVertex", 2 * 1024 * 1024, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, PushBufferType::CPU_TO_GPU);
 		frame_[i].pushIndex = new VulkanPushBuffer(vulkan, "pushIndex", 1 * 1024 * 1024, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, PushBufferType::CPU_TO_GPU);
+		if (vulkan->HasAsyncTransferQueue())
+			frame_[i].pushTransfer = new VulkanPushBuffer(vulkan, "pushTransfer", 4 * 1024 * 1024, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, PushBufferType::CPU_TO_GPU);
 	}
 
 	VkPipelineLayoutCreateInfo pl{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
@@ -237,6 +240,11 @@ void DrawEngineVulkan::FrameData::Destroy(VulkanContext *vulkan) {
 		delete pushIndex;
 		pushIndex = nullptr;
 	}
+	if (pushTransfer) {
+		pushTransfer->Destroy(vulkan);
+		delete pushTransfer;
+		pushTransfer = nullptr;
+	}
 }
 
 void DrawEngineVulkan::DestroyDeviceObjects() {
@@ -304,12 +312,16 @@ void DrawEngineVulkan::BeginFrame() {
 	frame->pushUBO->Reset();
 	frame->pushVertex->Reset();
 	frame->pushIndex->Reset();
+	if (frame->pushTransfer)
+		frame->pushTransfer->Reset();
 
 	VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
 
 	frame->pushUBO->Begin(vulkan);
 	frame->pushVertex->Begin(vulkan);
 	frame->pushIndex->Begin(vulkan);
+	if (frame->pushTransfer)
+		frame->pushTransfer->Begin(vulkan);
 
 	tessDataTransferVulkan->SetPushBuffer(frame->pushUBO);
 
@@ -328,31 +340,21 @@ void DrawEngineVulkan::BeginFrame() {
 
 	vertexCache_->BeginNoReset();
 
-	if (--descDecimationCounter_ <= 0) {
+	// Cached descriptor sets are kept across frames, which saves most of the vkUpdateDescriptorSets
+	// work in steady state. But once a buffer, image view or sampler has been deleted, a new one
+	// could get the same handle and wrongly match a cached set, so start over.
+	const uint32_t descGeneration = VulkanDeleteList::DescriptorResourceGeneration();
+	if (--frame->descDecimationCounter <= 0 || frame->descResourceGeneration != descGeneration) {
 		frame->descPool.Reset();
-		descDecimationCounter_ = DESCRIPTORSET_DECIMATION_INTERVAL;
+		frame->descDecimationCounter = DESCRIPTORSET_DECIMATION_INTERVAL;
+		frame->descResourceGeneration = descGeneration;
 	}
 
 	if (--decimationCounter_ <= 0) {
 		decimationCounter_ = VERTEXCACHE_DECIMATION_INTERVAL;
 
-		const int threshold = gpuStats.numFlips - VAI_KILL_AGE;
-		const int unreliableThreshold = gpuStats.numFlips - VAI_UNRELIABLE_KILL_AGE;
-		int unreliableLeft = VAI_UNRELIABLE_KILL_MAX;
-		vai_.Iterate([&](uint32_t hash, VertexArrayInfoVulkan *vai) {
-			bool kill;
-			if (vai->status == VertexArrayInfoVulkan::VAI_UNRELIABLE) {
-				// We limit killing unreliable so we don't rehash too often.
-				kill = vai->lastFrame < unreliableThreshold && --unreliableLeft >= 0;
-			} else {
-				kill = vai->lastFrame < threshold;
-			}
-			if (kill) {
-				// This is actually quite safe.
-				vai_.Remove(hash);
-				delete vai;
-			}
-		});
+		// The memory is in vertexCache_, which gets wiped as a whole above, so no budget here.
+		DecimateVertexArrays(vai_, 0);
 	}
 	vai_.Maintain();
 }
@@ -365,6 +367,8 @@ void DrawEngineVulkan::EndFrame() {
 	frame->pushUBO->End();
 	frame->pushVertex->End();
 	frame->pushIndex->End();
+	if (frame->pushTransfer)
+		frame->pushTransfer->End();
 	vertexCache_->End();
 }
 
@@ -403,7 +407,7 @@ VkDescriptorSet DrawEngineVulkan::GetOrCreateDescriptorSet(VkImageView imageView
 	}
 
 	// Didn't find one in the frame descriptor set cache, let's make a new one.
-	// We wipe the cache on every frame.
+	// The cache is wiped on decimation, or when something it might refer to gets deleted.
 	VkDescriptorSet desc = frame.descPool.Allocate(1, &descriptorSetLayout_, "game_descset");
 
 	// Even in release mode, this is bad.
@@ -563,6 +567,7 @@ void DrawEngineVulkan::DoFlush() {
 	VulkanRenderManager *renderManager = (VulkanRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
 
 	PROFILE_THIS_SCOPE("Flush");
+	FrameTimeScope frameTimeScope(FrameTimeCategory::FLUSH);
 	FrameData &frameData = GetCurFrame();
 
 	bool tess = gstate_c.submitType == SubmitType::HW_BEZIER || gstate_c.submitType == SubmitType::HW_SPLINE;
@@ -624,7 +629,7 @@ void DrawEngineVulkan::DoFlush() {
 				vai->numVerts = indexGen.VertexCount();
 				vai->prim = indexGen.Prim();
 				vai->maxIndex = indexGen.MaxIndex();
-				vai->flags = gstate_c.vertexFullAlpha ? VAIVULKAN_FLAG_VERTEXFULLALPHA : 0;
+				vai->flags = gstate_c.vertexFullAlpha ? VAI_FLAG_VERTEXFULLALPHA : 0;
 				goto rotateVBO;
 			}
 
@@ -633,41 +638,11 @@ void DrawEngineVulkan::DoFlush() {
 			case VertexArrayInfoVulkan::VAI_HASHING:
 			{
 				PROFILE_THIS_SCOPE("vcachehash");
-				vai->numDraws++;
-				if (vai->lastFrame != gpuStats.numFlips) {
-					vai->numFrames++;
-				}
-				if (vai->drawsUntilNextFullHash == 0) {
-					// Let's try to skip a full hash if mini would fail.
-					const u32 newMiniHash = ComputeMiniHash();
-					uint64_t newHash = vai->hash;
-					if (newMiniHash == vai->minihash) {
-						newHash = ComputeHash();
-					}
-					if (newMiniHash != vai->minihash || newHash != vai->hash) {
-						MarkUnreliable(vai);
-						DecodeVertsToPushBuffer(frameData.pushVertex, &vbOffset, &vbuf);
-						goto rotateVBO;
-					}
-					if (vai->numVerts > 64) {
-						// exponential backoff up to 16 draws, then every 24
-						vai->drawsUntilNextFullHash = std::min(24, vai->numFrames);
-					} else {
-						// Lower numbers seem much more likely to change.
-						vai->drawsUntilNextFullHash = 0;
-					}
-					// TODO: tweak
-					//if (vai->numFrames > 1000) {
-					//	vai->status = VertexArrayInfo::VAI_RELIABLE;
-					//}
-				} else {
-					vai->drawsUntilNextFullHash--;
-					u32 newMiniHash = ComputeMiniHash();
-					if (newMiniHash != vai->minihash) {
-						MarkUnreliable(vai);
-						DecodeVertsToPushBuffer(frameData.pushVertex, &vbOffset, &vbuf);
-						goto rotateVBO;
-					}
+				vai->CountDraw();
+				if (!VertexCacheHashMatches(vai)) {
+					MarkUnreliable(vai);
+					DecodeVertsToPushBuffer(frameData.pushVertex, &vbOffset, &vbuf);
+					goto rotateVBO;
 				}
 
 				if (!vai->vb) {
@@ -676,7 +651,7 @@ void DrawEngineVulkan::DoFlush() {
 					_dbg_assert_msg_(gstate_c.vertBounds.minV >= gstate_c.vertBounds.maxV, "Should not have checked UVs when caching.");
 					vai->numVerts = indexGen.VertexCount();
 					vai->maxIndex = indexGen.MaxIndex();
-					vai->flags = gstate_c.vertexFullAlpha ? VAIVULKAN_FLAG_VERTEXFULLALPHA : 0;
+					vai->flags = gstate_c.vertexFullAlpha ? VAI_FLAG_VERTEXFULLALPHA : 0;
 					if (forceIndexed) {
 						vai->prim = indexGen.GeneralPrim();
 						useElements = true;
@@ -700,7 +675,7 @@ void DrawEngineVulkan::DoFlush() {
 					gpuStats.numCachedDrawCalls++;
 					useElements = vai->ib ? true : false;
 					gpuStats.numCachedVertsDrawn += vai->numVerts;
-					gstate_c.vertexFullAlpha = vai->flags & VAIVULKAN_FLAG_VERTEXFULLALPHA;
+					gstate_c.vertexFullAlpha = vai->flags & VAI_FLAG_VERTEXFULLALPHA;
 				}
 				vbuf = vai->vb;
 				ibuf = vai->ib;
@@ -714,10 +689,7 @@ void DrawEngineVulkan::DoFlush() {
 			// Reliable - we don't even bother hashing anymore. Right now we don't go here until after a very long time.
 			case VertexArrayInfoVulkan::VAI_RELIABLE:
 			{
-				vai->numDraws++;
-				if (vai->lastFrame != gpuStats.numFlips) {
-					vai->numFrames++;
-				}
+				vai->CountDraw();
 				gpuStats.numCachedDrawCalls++;
 				gpuStats.numCachedVertsDrawn += vai->numVerts;
 				vbuf = vai->vb;
@@ -727,16 +699,13 @@ void DrawEngineVulkan::DoFlush() {
 				vertexCount = vai->numVerts;
 				prim = static_cast<GEPrimitiveType>(vai->prim);
 
-				gstate_c.vertexFullAlpha = vai->flags & VAIVULKAN_FLAG_VERTEXFULLALPHA;
+				gstate_c.vertexFullAlpha = vai->flags & VAI_FLAG_VERTEXFULLALPHA;
 				break;
 			}
 
 			case VertexArrayInfoVulkan::VAI_UNRELIABLE:
 			{
-				vai->numDraws++;
-				if (vai->lastFrame != gpuStats.numFlips) {
-					vai->numFrames++;
-				}
+				vai->CountDraw();
 				DecodeVertsToPushBuffer(frameData.pushVertex, &vbOffset, &vbuf);
 				goto rotateVBO;
 			}
@@ -786,7 +755,7 @@ void DrawEngineVulkan::DoFlush() {
 				sampler = nullSampler_;
 		}
 
-		if (!lastPipeline_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE | DIRTY_GEOMETRYSHADER_STATE) || prim != lastPrim_) {
+		if (!lastPipeline_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_ANY_VERTEXSHADER | DIRTY_FRAGMENTSHADER_STATE | DIRTY_GEOMETRYSHADER_STATE) || prim != lastPrim_) {
 			if (prim != lastPrim_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE)) {
 				ConvertStateToVulkanKey(*framebufferManager_, shaderManager_, prim, pipelineKey_, dynState_);
 			}
@@ -807,6 +776,9 @@ void DrawEngineVulkan::DoFlush() {
 				// Already logged, let's bail out.
 				return;
 			}
+			if (!pipeline->fallbackChecked) {
+				AttachFallbackPipeline(renderManager, pipeline, vshader, fshader, gshader, true);
+			}
 			BindShaderBlendTex();  // This might cause copies so important to do before BindPipeline.
 
 			renderManager->BindPipeline(pipeline->pipeline, pipeline->pipelineFlags, pipelineLayout_);
@@ -920,7 +892,7 @@ void DrawEngineVulkan::DoFlush() {
 				if (sampler == VK_NULL_HANDLE)
 					sampler = nullSampler_;
 			}
-			if (!lastPipeline_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE | DIRTY_GEOMETRYSHADER_STATE) || prim != lastPrim_) {
+			if (!lastPipeline_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_ANY_VERTEXSHADER | DIRTY_FRAGMENTSHADER_STATE | DIRTY_GEOMETRYSHADER_STATE) || prim != lastPrim_) {
 				if (prim != lastPrim_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE)) {
 					ConvertStateToVulkanKey(*framebufferManager_, shaderManager_, prim, pipelineKey_, dynState_);
 				}
@@ -940,6 +912,9 @@ void DrawEngineVulkan::DoFlush() {
 					decOptions_.applySkinInDecode = g_Config.bSoftwareSkinning;
 					return;
 				}
+				if (!pipeline->fallbackChecked) {
+					AttachFallbackPipeline(renderManager, pipeline, vshader, fshader, gshader, false);
+				}
 				BindShaderBlendTex();  // This might cause copies so super important to do before BindPipeline.
 
 				renderManager->BindPipeline(pipeline->pipeline, pipeline->pipelineFlags, pipelineLayout_);
@@ -1030,6 +1005,24 @@ void DrawEngineVulkan::DoFlush() {
 	GPUDebug::NotifyDraw();
 }
 
+// New pipelines take a while to compile. Meanwhile, the render thread can draw with one
+// using the fragment ubershader instead, which is shared by lots of pipelines so is usually ready.
+void DrawEngineVulkan::AttachFallbackPipeline(VulkanRenderManager *renderManager, VulkanPipeline *pipeline, VulkanVertexShader *vshader, VulkanFragmentShader *fshader, VulkanGeometryShader *gshader, bool useHWTransform) {
+	pipeline->fallbackChecked = true;
+
+	FShaderID uberID;
+	if (!ComputeFragmentUberShaderID(&uberID, fshader->GetID()))
+		return;
+
+	VulkanFragmentShader *uberShader = shaderManager_->GetOrCreateFragmentShader(uberID);
+	VulkanPipeline *fallback = pipelineManager_->GetOrCreatePipeline(renderManager, pipelineLayout_, pipelineKey_, &dec_->decFmt, vshader, uberShader, gshader, useHWTransform, 0, framebufferManager_->GetMSAALevel(), false);
+	if (fallback && fallback != pipeline) {
+		// The ubershader has no fallback of its own.
+		fallback->fallbackChecked = true;
+		pipeline->pipeline->fallback = fallback->pipeline;
+	}
+}
+
 void DrawEngineVulkan::UpdateUBOs(FrameData *frame) {
 	if ((dirtyUniforms_ & DIRTY_BASE_UNIFORMS) || baseBuf == VK_NULL_HANDLE) {
 		baseUBOOffset = shaderManager_->PushBaseBuffer(frame->pushUBO, &baseBuf);
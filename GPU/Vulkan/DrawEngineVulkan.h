@@ -49,6 +49,9 @@ struct DecVtxFormat;
 struct UVScale;
 
 class ShaderManagerVulkan;
+class VulkanVertexShader;
+class VulkanFragmentShader;
+class VulkanGeometryShader;
 class PipelineManagerVulkan;
 class TextureCacheVulkan;
 class FramebufferManagerVulkan;
@@ -63,47 +66,15 @@ struct DrawEngineVulkanStats {
 	int pushIndexSpaceUsed;
 };
 
-enum {
-	VAIVULKAN_FLAG_VERTEXFULLALPHA = 1,
-};
-
-// Try to keep this POD.
-class VertexArrayInfoVulkan {
+// No destructor needed - we always fully wipe.
+class VertexArrayInfoVulkan : public VertexArrayInfo {
 public:
-	VertexArrayInfoVulkan() {
-		lastFrame = gpuStats.numFlips;
-	}
-	// No destructor needed - we always fully wipe.
-
-	enum VAIStatus : uint8_t {
-		VAI_NEW,
-		VAI_HASHING,
-		VAI_RELIABLE,  // cache, don't hash
-		VAI_UNRELIABLE,  // never cache
-	};
-
-	uint64_t hash = 0;
-	u32 minihash = 0;
-
 	// These will probably always be the same, but whatever.
 	VkBuffer vb = VK_NULL_HANDLE;
 	VkBuffer ib = VK_NULL_HANDLE;
 	// Offsets into the cache buffer.
 	uint32_t vbOffset = 0;
 	uint32_t ibOffset = 0;
-
-	// Precalculated parameter for vkDrawIndexed
-	u16 numVerts = 0;
-	u16 maxIndex = 0;
-	s8 prim = GE_PRIM_INVALID;
-	VAIStatus status = VAI_NEW;
-
-	// ID information
-	int numDraws = 0;
-	int numFrames = 0;
-	int lastFrame;  // So that we can forget.
-	u16 drawsUntilNextFullHash = 0;
-	u8 flags = 0;
 };
 
 class VulkanRenderManager;
@@ -195,6 +166,10 @@ class DrawEngineVulkan : public DrawEngineCommon {
 	VulkanPushBuffer *GetPushBufferForTextureData() {
 		return GetCurFrame().pushUBO;
 	}
+	// Staging memory only read by the transfer queue. Null if the device doesn't have one.
+	VulkanPushBuffer *GetPushBufferForAsyncTextureData() {
+		return GetCurFrame().pushTransfer;
+	}
 
 	const DrawEngineVulkanStats &GetStats() const {
 		return stats_;
@@ -215,6 +190,7 @@ class DrawEngineVulkan : public DrawEngineCommon {
 	void ApplyDrawStateLate(VulkanRenderManager *renderManager, bool applyStencilRef, uint8_t stencilRef, bool useBlendConstant);
 	void ConvertStateToVulkanKey(FramebufferManagerVulkan &fbManager, ShaderManagerVulkan *shaderManager, int prim, VulkanPipelineRasterStateKey &key, VulkanDynamicState &dynState);
 	void BindShaderBlendTex();
+	void AttachFallbackPipeline(VulkanRenderManager *renderManager, VulkanPipeline *pipeline, VulkanVertexShader *vshader, VulkanFragmentShader *fshader, VulkanGeometryShader *gshader, bool useHWTransform);
 
 	void DestroyDeviceObjects();
 
@@ -246,9 +222,8 @@ class DrawEngineVulkan : public DrawEngineCommon {
 	VkSampler samplerSecondaryLinear_ = VK_NULL_HANDLE;
 	VkSampler samplerSecondaryNearest_ = VK_NULL_HANDLE;
 
-	PrehashMap<VertexArrayInfoVulkan *, nullptr> vai_;
+	SwissPrehashMap<VertexArrayInfoVulkan *, nullptr> vai_;
 	VulkanPushBuffer *vertexCache_;
-	int descDecimationCounter_ = 0;
 
 	struct DescriptorSetKey {
 		VkImageView imageView_;
@@ -271,9 +246,12 @@ class DrawEngineVulkan : public DrawEngineCommon {
 		VulkanPushBuffer *pushUBO = nullptr;
 		VulkanPushBuffer *pushVertex = nullptr;
 		VulkanPushBuffer *pushIndex = nullptr;
+		VulkanPushBuffer *pushTransfer = nullptr;
 
-		// We do rolling allocation and reset instead of caching across frames. That we might do later.
+		// Kept across frames until decimation, or until VulkanDeleteList::DescriptorResourceGeneration() changes.
 		DenseHashMap<DescriptorSetKey, VkDescriptorSet, (VkDescriptorSet)VK_NULL_HANDLE> descSets;
+		int descDecimationCounter = 0;
+		uint32_t descResourceGeneration = 0;
 
 		void Destroy(VulkanContext *vulkan);
 	};
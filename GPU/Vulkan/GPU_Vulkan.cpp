@@ -22,6 +22,7 @@
 
 #include "Common/Log.h"
 #include "Common/File/FileUtil.h"
+#include "Common/File/VFS/VFS.h"
 #include "Common/GraphicsContext.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/TimeUtil.h"
@@ -96,6 +97,18 @@ GPU_Vulkan::GPU_Vulkan(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 		shaderCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".vkshadercache");
 		shaderCacheLoaded_ = false;
 
+		// The cache only stores shader IDs and pipeline keys, not driver binaries, so one made on
+		// any device works. If we ship one for this game, use it for the first run.
+		if (g_Config.bShaderCache && !File::Exists(shaderCachePath_)) {
+			size_t size = 0;
+			uint8_t *data = g_VFS.ReadFile(("shadercache/" + discID + ".vkshadercache").c_str(), &size);
+			if (data) {
+				INFO_LOG(G3D, "Using bundled shader cache for %s", discID.c_str());
+				File::WriteDataToFile(false, data, (unsigned int)size, shaderCachePath_);
+				delete[] data;
+			}
+		}
+
 		std::thread th([&] {
 			LoadCache(shaderCachePath_);
 			shaderCacheLoaded_ = true;
@@ -303,6 +316,9 @@ void GPU_Vulkan::BeginHostFrame() {
 	framebufferManager_->BeginFrame();
 	textureCacheVulkan_->SetPushBuffer(frameData_[curFrame].push_);
 
+	VulkanRenderManager *rm = (VulkanRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
+	rm->SetAdaptiveInflightFrames(g_Config.bAdaptiveInflightFrames);
+
 	shaderManagerVulkan_->DirtyShader();
 	gstate_c.Dirty(DIRTY_ALL);
 
@@ -477,13 +493,24 @@ void GPU_Vulkan::GetStats(char *buffer, size_t bufsize) {
 	const DrawEngineVulkanStats &drawStats = drawEngine_.GetStats();
 	char texStats[256];
 	textureCacheVulkan_->GetStats(texStats, sizeof(texStats));
+	VulkanRenderManager *rm = (VulkanRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
+	const VKRPipelineStats &pipelineStats = rm->PipelineStats();
+	const VKRStepOptimizerStats &stepStats = rm->StepOptimizerStats();
+	int compiles = pipelineStats.compiled + pipelineStats.failed;
 	snprintf(buffer, bufsize,
 		"Vertex, Fragment, Pipelines loaded: %i, %i, %i\n"
+		"Pipeline compiles: %d (%d failed), %d pending (max %d), avg %0.2f ms, max %0.2f ms\n"
+		"Unready pipeline binds: %d waited, %d used fallback, %d skipped\n"
+		"Steps removed last frame: %d merged, %d dead passes, %d dead copies (%lld total)\n"
 		"Pushbuffer space used: UBO %d, Vtx %d, Idx %d\n"
 		"%s\n",
 		shaderManagerVulkan_->GetNumVertexShaders(),
 		shaderManagerVulkan_->GetNumFragmentShaders(),
 		pipelineManager_->GetNumPipelines(),
+		compiles, (int)pipelineStats.failed, (int)pipelineStats.pending, (int)pipelineStats.maxPending,
+		compiles ? (double)pipelineStats.totalCompileUs / compiles / 1000.0 : 0.0, pipelineStats.maxCompileUs / 1000.0,
+		(int)pipelineStats.waited, (int)pipelineStats.usedFallback, (int)pipelineStats.skipped,
+		(int)stepStats.lastFrameMerged, (int)stepStats.lastFrameDead, (int)stepStats.lastFrameDeadCopies, (long long)stepStats.totalRemoved,
 		drawStats.pushUBOSpaceUsed,
 		drawStats.pushVertexSpaceUsed,
 		drawStats.pushIndexSpaceUsed,
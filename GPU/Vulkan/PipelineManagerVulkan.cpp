@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <cstring>
+#include <map>
 #include <memory>
-#include <set>
 #include <sstream>
 
+#include "Common/GPU/ShaderCompileLog.h"
 #include "Common/Profiler/Profiler.h"
 
 #include "Common/Log.h"
@@ -318,6 +320,12 @@ static VulkanPipeline *CreateVulkanPipeline(VulkanRenderManager *renderManager,
 #ifdef _DEBUG
 	tag = FragmentShaderDesc(fs->GetID()) + " VS " + VertexShaderDesc(vs->GetID());
 #endif
+	if (ShaderCompileLog_IsActive()) {
+		// The compile log only has the tag, so give it the IDs.
+		const VShaderID vsid = vs->GetID();
+		const FShaderID fsid = fs->GetID();
+		tag = "vs:" + ShaderCompileLog_HexID(&vsid, sizeof(vsid)) + " fs:" + ShaderCompileLog_HexID(&fsid, sizeof(fsid));
+	}
 
 	VKRGraphicsPipeline *pipeline = renderManager->CreateGraphicsPipeline(desc, pipelineFlags, variantBitmask, sampleCount, cacheLoad, tag.c_str());
 
@@ -352,8 +360,10 @@ VulkanPipeline *PipelineManagerVulkan::GetOrCreatePipeline(VulkanRenderManager *
 	key.vtxFmtId = useHwTransform ? decFmt->id : 0;
 
 	auto iter = pipelines_.Get(key);
-	if (iter)
+	if (iter) {
+		iter->useCount++;
 		return iter;
+	}
 
 	PipelineFlags pipelineFlags = (PipelineFlags)0;
 	if (fs->Flags() & FragmentShaderFlags::INPUT_ATTACHMENT) {
@@ -374,6 +384,10 @@ VulkanPipeline *PipelineManagerVulkan::GetOrCreatePipeline(VulkanRenderManager *
 
 	// If the above failed, we got a null pipeline. We still insert it to keep track.
 	pipelines_.Insert(key, pipeline);
+	if (pipeline && !cacheLoad)
+		pipeline->useCount = 1;
+	if (!cacheLoad)
+		gpuStats.numPipelineCreations++;
 
 	// Don't return placeholder null pipelines.
 	if (pipeline && pipeline->pipeline) {
@@ -605,7 +619,7 @@ struct StoredVulkanPipelineKey {
 	uint32_t variants;
 	bool useHWTransform;  // TODO: Still needed?
 
-	// For std::set. Better zero-initialize the struct properly for this to work.
+	// For std::map. Better zero-initialize the struct properly for this to work.
 	bool operator < (const StoredVulkanPipelineKey &other) const {
 		return memcmp(this, &other, sizeof(*this)) < 0;
 	}
@@ -644,7 +658,7 @@ void PipelineManagerVulkan::SavePipelineCache(FILE *file, bool saveRawPipelineCa
 	// Since we don't include the full pipeline key, there can be duplicates,
 	// caused by things like switching from buffered to non-buffered rendering.
 	// Make sure the set of pipelines we write is "unique".
-	std::set<StoredVulkanPipelineKey> keys;
+	std::map<StoredVulkanPipelineKey, u32> keyUseCounts;
 
 	pipelines_.Iterate([&](const VulkanPipelineKey &pkey, VulkanPipeline *value) {
 		if (failed)
@@ -672,7 +686,14 @@ void PipelineManagerVulkan::SavePipelineCache(FILE *file, bool saveRawPipelineCa
 			// NOTE: This is not a vtype, but a decoded vertex format.
 			key.vtxFmtId = pkey.vtxFmtId;
 		}
-		keys.insert(key);
+		keyUseCounts[key] += value->useCount;
+	});
+
+	// The pipelines are recreated in file order when loading, so put the most used ones first.
+	// That way the ones a game needs right away are likely to be ready first.
+	std::vector<std::pair<StoredVulkanPipelineKey, u32>> keys(keyUseCounts.begin(), keyUseCounts.end());
+	std::stable_sort(keys.begin(), keys.end(), [](const std::pair<StoredVulkanPipelineKey, u32> &a, const std::pair<StoredVulkanPipelineKey, u32> &b) {
+		return a.second > b.second;
 	});
 
 	// Write the number of pipelines.
@@ -681,7 +702,7 @@ void PipelineManagerVulkan::SavePipelineCache(FILE *file, bool saveRawPipelineCa
 
 	// Write the pipelines.
 	for (auto &key : keys) {
-		writeFailed = writeFailed || fwrite(&key, sizeof(key), 1, file) != 1;
+		writeFailed = writeFailed || fwrite(&key.first, sizeof(key.first), 1, file) != 1;
 	}
 
 	if (failed) {
@@ -70,6 +70,10 @@ struct VulkanPipeline {
 	VKRGraphicsPipeline *pipeline;
 	VKRGraphicsPipelineDesc *desc;
 	PipelineFlags pipelineFlags;  // PipelineFlags enum above.
+	// Number of lookups, so the most used pipelines can be stored first in the cache file.
+	u32 useCount = 0;
+	// Whether we've looked for an ubershader fallback yet, see DrawEngineVulkan.
+	bool fallbackChecked = false;
 
 	bool UsesBlendConstant() const { return (pipelineFlags & PipelineFlags::USES_BLEND_CONSTANT) != 0; }
 	bool UsesDepthStencil() const { return (pipelineFlags & PipelineFlags::USES_DEPTH_STENCIL) != 0; }
@@ -105,7 +109,7 @@ class PipelineManagerVulkan {
 	void CancelCache();
 
 private:
-	DenseHashMap<VulkanPipelineKey, VulkanPipeline *, nullptr> pipelines_;
+	SwissHashMap<VulkanPipelineKey, VulkanPipeline *, nullptr> pipelines_;
 	VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
 	VulkanContext *vulkan_;
 	bool cancelCache_ = false;
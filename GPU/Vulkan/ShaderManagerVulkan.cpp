@@ -25,9 +25,12 @@
 #include "Common/Data/Convert/SmallDataConvert.h"
 #include "Common/Profiler/Profiler.h"
 #include "Common/GPU/thin3d.h"
+#include "Common/GPU/ShaderCompileLog.h"
 #include "Common/Data/Encoding/Utf8.h"
 #include "Common/TimeUtil.h"
 
+#include "ext/xxhash.h"
+
 #include "Common/StringUtils.h"
 #include "Common/GPU/Vulkan/VulkanContext.h"
 #include "Common/GPU/Vulkan/VulkanMemory.h"
@@ -44,17 +47,36 @@
 #include "GPU/Vulkan/DrawEngineVulkan.h"
 #include "GPU/Vulkan/FramebufferManagerVulkan.h"
 
+#if defined(_DEBUG)
+// Don't parallelize in debug mode, pathological behavior due to mutex locks in allocator which is HEAVILY used by glslang.
+static const bool singleThreadedCompile = true;
+#else
+static const bool singleThreadedCompile = false;
+#endif
+
+template <typename T>
+static std::string CompileLogID(const T &id) {
+	return ShaderCompileLog_IsActive() ? ShaderCompileLog_HexID(&id, sizeof(id)) : std::string();
+}
+
 // Most drivers treat vkCreateShaderModule as pretty much a memcpy. What actually
 // takes time here, and makes this worthy of parallelization, is GLSLtoSPV.
-// Takes ownership over tag.
-static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan, VkShaderStageFlagBits stage, const char *code, std::string *tag) {
+// Takes ownership over tag.  logId is only used if the compile log is active.
+// If spirv already has contents (from the shader cache) they're used directly, otherwise it
+// receives the compiled SPIR-V. It must stay alive until the promise is ready.
+static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan, VkShaderStageFlagBits stage, const char *code, std::string *tag, const std::string &logId, bool singleThreaded, std::vector<uint32_t> *spirvOut) {
 	auto compile = [=] {
 		PROFILE_THIS_SCOPE("shadercomp");
 
 		std::string errorMessage;
-		std::vector<uint32_t> spirv;
+		std::vector<uint32_t> &spirv = *spirvOut;
 
-		bool success = GLSLtoSPV(stage, code, GLSLVariant::VULKAN, spirv, &errorMessage);
+		bool success = true;
+		if (spirv.empty()) {
+			double start = time_now_d();
+			success = GLSLtoSPV(stage, code, GLSLVariant::VULKAN, spirv, &errorMessage);
+			ShaderCompileLog_Record(ShaderCompileStage::SPIRV, logId, time_now_d() - start, singleThreaded);
+		}
 
 		if (!errorMessage.empty()) {
 			if (success) {
@@ -93,16 +115,11 @@ static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan,
 			if (tag)
 				delete tag;
 		}
+		if (!success)
+			spirv.clear();
 		return shaderModule;
 	};
 
-#if defined(_DEBUG)
-	// Don't parallelize in debug mode, pathological behavior due to mutex locks in allocator which is HEAVILY used by glslang.
-	bool singleThreaded = true;
-#else
-	bool singleThreaded = false;
-#endif
-
 	if (singleThreaded) {
 		return Promise<VkShaderModule>::AlreadyDone(compile());
 	} else {
@@ -110,10 +127,12 @@ static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan,
 	}
 }
 
-VulkanFragmentShader::VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code)
+VulkanFragmentShader::VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code, std::vector<uint32_t> *cachedSpirv)
 	: vulkan_(vulkan), id_(id), flags_(flags) {
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_FRAGMENT_BIT, source_.c_str(), new std::string(FragmentShaderDesc(id)));
+	if (cachedSpirv)
+		spirv_.swap(*cachedSpirv);
+	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_FRAGMENT_BIT, source_.c_str(), new std::string(FragmentShaderDesc(id)), CompileLogID(id), singleThreadedCompile, &spirv_);
 	if (!module_) {
 		failed_ = true;
 	} else {
@@ -145,10 +164,18 @@ std::string VulkanFragmentShader::GetShaderString(DebugShaderStringType type) co
 	}
 }
 
-VulkanVertexShader::VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform)
+const std::vector<uint32_t> &VulkanFragmentShader::GetSpirv() {
+	if (module_)
+		module_->BlockUntilReady();
+	return spirv_;
+}
+
+VulkanVertexShader::VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform, std::vector<uint32_t> *cachedSpirv)
 	: vulkan_(vulkan), useHWTransform_(useHWTransform), flags_(flags), id_(id) {
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_VERTEX_BIT, source_.c_str(), new std::string(VertexShaderDesc(id)));
+	if (cachedSpirv)
+		spirv_.swap(*cachedSpirv);
+	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_VERTEX_BIT, source_.c_str(), new std::string(VertexShaderDesc(id)), CompileLogID(id), singleThreadedCompile, &spirv_);
 	if (!module_) {
 		failed_ = true;
 	} else {
@@ -180,10 +207,18 @@ std::string VulkanVertexShader::GetShaderString(DebugShaderStringType type) cons
 	}
 }
 
-VulkanGeometryShader::VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code)
+const std::vector<uint32_t> &VulkanVertexShader::GetSpirv() {
+	if (module_)
+		module_->BlockUntilReady();
+	return spirv_;
+}
+
+VulkanGeometryShader::VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code, std::vector<uint32_t> *cachedSpirv)
 	: vulkan_(vulkan), id_(id) {
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_GEOMETRY_BIT, source_.c_str(), new std::string(GeometryShaderDesc(id).c_str()));
+	if (cachedSpirv)
+		spirv_.swap(*cachedSpirv);
+	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_GEOMETRY_BIT, source_.c_str(), new std::string(GeometryShaderDesc(id).c_str()), CompileLogID(id), singleThreadedCompile, &spirv_);
 	if (!module_) {
 		failed_ = true;
 	} else {
@@ -215,6 +250,12 @@ std::string VulkanGeometryShader::GetShaderString(DebugShaderStringType type) co
 	}
 }
 
+const std::vector<uint32_t> &VulkanGeometryShader::GetSpirv() {
+	if (module_)
+		module_->BlockUntilReady();
+	return spirv_;
+}
+
 static constexpr size_t CODE_BUFFER_SIZE = 32768;
 
 ShaderManagerVulkan::ShaderManagerVulkan(Draw::DrawContext *draw)
@@ -301,13 +342,8 @@ uint64_t ShaderManagerVulkan::UpdateUniforms(bool useBufferedRendering) {
 }
 
 void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVertexShader **vshader, VulkanFragmentShader **fshader, VulkanGeometryShader **gshader, const ComputedPipelineState &pipelineState, bool useHWTransform, bool useHWTessellation, bool weightsAsFloat, bool useSkinInDecode) {
-	VShaderID VSID;
-	if (gstate_c.IsDirty(DIRTY_VERTEXSHADER_STATE)) {
-		gstate_c.Clean(DIRTY_VERTEXSHADER_STATE);
-		ComputeVertexShaderID(&VSID, decoder, useHWTransform, useHWTessellation, weightsAsFloat, useSkinInDecode);
-	} else {
-		VSID = lastVSID_;
-	}
+	VShaderID VSID = lastVSID_;
+	UpdateVertexShaderID(&VSID, &lastVSStateID_, decoder, useHWTransform, useHWTessellation, weightsAsFloat, useSkinInDecode);
 
 	FShaderID FSID;
 	if (gstate_c.IsDirty(DIRTY_FRAGMENTSHADER_STATE)) {
@@ -345,7 +381,9 @@ void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVer
 		uint64_t uniformMask = 0;  // Not used
 		uint32_t attributeMask = 0;  // Not used
 		VertexShaderFlags flags{};
+		double start = time_now_d();
 		bool success = GenerateVertexShader(VSID, codeBuffer_, compat_, draw_->GetBugs(), &attributeMask, &uniformMask, &flags, &genErrorString);
+		ShaderCompileLog_Record(ShaderCompileStage::VERTEX_GEN, CompileLogID(VSID), time_now_d() - start, true);
 		_assert_msg_(success, "VS gen error: %s", genErrorString.c_str());
 		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "VS length error: %d", (int)strlen(codeBuffer_));
 
@@ -353,27 +391,12 @@ void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVer
 		vs = vsCache_.Get(VSID);
 		if (!vs) {
 			vs = new VulkanVertexShader(vulkan, VSID, flags, codeBuffer_, useHWTransform);
+			gpuStats.numShaderCompiles++;
 			vsCache_.Insert(VSID, vs);
 		}
 	}
 
-	VulkanFragmentShader *fs = fsCache_.Get(FSID);
-	if (!fs) {
-		// Fragment shader not in cache. Let's compile it.
-		std::string genErrorString;
-		uint64_t uniformMask = 0;  // Not used
-		FragmentShaderFlags flags{};
-		bool success = GenerateFragmentShader(FSID, codeBuffer_, compat_, draw_->GetBugs(), &uniformMask, &flags, &genErrorString);
-		_assert_msg_(success, "FS gen error: %s", genErrorString.c_str());
-		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "FS length error: %d", (int)strlen(codeBuffer_));
-
-		std::lock_guard<std::mutex> guard(cacheLock_);
-		fs = fsCache_.Get(FSID);
-		if (!fs) {
-			fs = new VulkanFragmentShader(vulkan, FSID, flags, codeBuffer_);
-			fsCache_.Insert(FSID, fs);
-		}
-	}
+	VulkanFragmentShader *fs = GetOrCreateFragmentShader(FSID);
 
 	VulkanGeometryShader *gs;
 	if (GSID.Bit(GS_BIT_ENABLED)) {
@@ -381,7 +404,9 @@ void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVer
 		if (!gs) {
 			// Geometry shader not in cache. Let's compile it.
 			std::string genErrorString;
+			double start = time_now_d();
 			bool success = GenerateGeometryShader(GSID, codeBuffer_, compat_, draw_->GetBugs(), &genErrorString);
+			ShaderCompileLog_Record(ShaderCompileStage::GEOMETRY_GEN, CompileLogID(GSID), time_now_d() - start, true);
 			_assert_msg_(success, "GS gen error: %s", genErrorString.c_str());
 			_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "GS length error: %d", (int)strlen(codeBuffer_));
 
@@ -389,6 +414,7 @@ void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVer
 			gs = gsCache_.Get(GSID);
 			if (!gs) {
 				gs = new VulkanGeometryShader(vulkan, GSID, codeBuffer_);
+				gpuStats.numShaderCompiles++;
 				gsCache_.Insert(GSID, gs);
 			}
 		}
@@ -410,6 +436,31 @@ void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVer
 	_dbg_assert_msg_((*vshader)->UseHWTransform() == useHWTransform, "Bad vshader was computed");
 }
 
+VulkanFragmentShader *ShaderManagerVulkan::GetOrCreateFragmentShader(const FShaderID &FSID) {
+	VulkanFragmentShader *fs = fsCache_.Get(FSID);
+	if (!fs) {
+		// Fragment shader not in cache. Let's compile it.
+		VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
+		std::string genErrorString;
+		uint64_t uniformMask = 0;  // Not used
+		FragmentShaderFlags flags{};
+		double start = time_now_d();
+		bool success = GenerateFragmentShader(FSID, codeBuffer_, compat_, draw_->GetBugs(), &uniformMask, &flags, &genErrorString);
+		ShaderCompileLog_Record(ShaderCompileStage::FRAGMENT_GEN, CompileLogID(FSID), time_now_d() - start, true);
+		_assert_msg_(success, "FS gen error: %s", genErrorString.c_str());
+		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "FS length error: %d", (int)strlen(codeBuffer_));
+
+		std::lock_guard<std::mutex> guard(cacheLock_);
+		fs = fsCache_.Get(FSID);
+		if (!fs) {
+			fs = new VulkanFragmentShader(vulkan, FSID, flags, codeBuffer_);
+			gpuStats.numShaderCompiles++;
+			fsCache_.Insert(FSID, fs);
+		}
+	}
+	return fs;
+}
+
 std::vector<std::string> ShaderManagerVulkan::DebugGetShaderIDs(DebugShaderType type) {
 	std::vector<std::string> ids;
 	switch (type) {
@@ -507,7 +558,7 @@ VulkanGeometryShader *ShaderManagerVulkan::GetGeometryShaderFromModule(VkShaderM
 //
 // We simply store the IDs of the shaders used during gameplay. On next startup of
 // the same game, we simply compile all the shaders from the start, so we don't have to
-// compile them on the fly later. We also store the Vulkan pipeline cache, so if it contains
+// compile them on the fly later. Their SPIR-V is stored too, so that mostly skips glslang. We also store the Vulkan pipeline cache, so if it contains
 // pipelines compiled from SPIR-V matching these shaders, pipeline creation will be practically
 // instantaneous.
 
@@ -516,7 +567,7 @@ enum class VulkanCacheDetectFlags {
 };
 
 #define CACHE_HEADER_MAGIC 0xff51f420 
-#define CACHE_VERSION 41
+#define CACHE_VERSION 42
 
 struct VulkanCacheHeader {
 	uint32_t magic;
@@ -528,6 +579,33 @@ struct VulkanCacheHeader {
 	int numGeometryShaders;
 };
 
+// Each shader ID is followed by the SPIR-V it compiled to, tagged with a hash of the
+// GLSL. If the generator still produces the same GLSL, glslang can be skipped entirely.
+static bool ReadCachedSpirv(FILE *f, uint64_t *sourceHash, std::vector<uint32_t> *spirv) {
+	uint32_t words = 0;
+	if (fread(sourceHash, sizeof(*sourceHash), 1, f) != 1 || fread(&words, sizeof(words), 1, f) != 1)
+		return false;
+	// Sanity check, real ones are far smaller.
+	if (words > 1024 * 1024)
+		return false;
+	spirv->resize(words);
+	return words == 0 || fread(spirv->data(), sizeof(uint32_t), words, f) == words;
+}
+
+static bool WriteCachedSpirv(FILE *f, const std::string &source, const std::vector<uint32_t> &spirv) {
+	uint64_t sourceHash = XXH3_64bits(source.data(), source.size());
+	uint32_t words = (uint32_t)spirv.size();
+	bool success = fwrite(&sourceHash, sizeof(sourceHash), 1, f) == 1 && fwrite(&words, sizeof(words), 1, f) == 1;
+	return success && (words == 0 || fwrite(spirv.data(), sizeof(uint32_t), words, f) == words);
+}
+
+// Returns the cached SPIR-V if it's usable for the code just generated.
+static std::vector<uint32_t> *MatchCachedSpirv(const char *code, uint64_t sourceHash, std::vector<uint32_t> &spirv) {
+	if (spirv.empty() || XXH3_64bits(code, strlen(code)) != sourceHash)
+		return nullptr;
+	return &spirv;
+}
+
 bool ShaderManagerVulkan::LoadCacheFlags(FILE *f, DrawEngineVulkan *drawEngine) {
 	VulkanCacheHeader header{};
 	long pos = ftell(f);
@@ -565,6 +643,9 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 	}
 
 	int failCount = 0;
+	int spirvHits = 0;
+	uint64_t sourceHash = 0;
+	std::vector<uint32_t> spirv;
 
 	VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
 	for (int i = 0; i < header.numVertexShaders; i++) {
@@ -573,19 +654,29 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 			ERROR_LOG(G3D, "Vulkan shader cache truncated (in VertexShaders)");
 			return false;
 		}
+		if (!ReadCachedSpirv(f, &sourceHash, &spirv)) {
+			ERROR_LOG(G3D, "Vulkan shader cache truncated (in VertexShaders)");
+			return false;
+		}
 		bool useHWTransform = id.Bit(VS_BIT_USE_HW_TRANSFORM);
 		std::string genErrorString;
 		uint32_t attributeMask = 0;
 		uint64_t uniformMask = 0;
 		VertexShaderFlags flags;
+		double start = time_now_d();
 		if (!GenerateVertexShader(id, codeBuffer_, compat_, draw_->GetBugs(), &attributeMask, &uniformMask, &flags, &genErrorString)) {
 			WARN_LOG(G3D, "Failed to generate vertex shader during cache load");
 			// We just ignore this one and carry on.
 			failCount++;
 			continue;
 		}
+		// Loading happens on a separate thread.
+		ShaderCompileLog_Record(ShaderCompileStage::VERTEX_GEN, CompileLogID(id), time_now_d() - start, false);
 		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "VS length error: %d", (int)strlen(codeBuffer_));
-		VulkanVertexShader *vs = new VulkanVertexShader(vulkan, id, flags, codeBuffer_, useHWTransform);
+		std::vector<uint32_t> *cachedSpirv = MatchCachedSpirv(codeBuffer_, sourceHash, spirv);
+		if (cachedSpirv)
+			spirvHits++;
+		VulkanVertexShader *vs = new VulkanVertexShader(vulkan, id, flags, codeBuffer_, useHWTransform, cachedSpirv);
 		// Remove first, just to be safe (we are loading on a background thread.)
 		std::lock_guard<std::mutex> guard(cacheLock_);
 		VulkanVertexShader *old = vsCache_.Get(id);
@@ -603,17 +694,26 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 			ERROR_LOG(G3D, "Vulkan shader cache truncated (in FragmentShaders)");
 			return false;
 		}
+		if (!ReadCachedSpirv(f, &sourceHash, &spirv)) {
+			ERROR_LOG(G3D, "Vulkan shader cache truncated (in FragmentShaders)");
+			return false;
+		}
 		std::string genErrorString;
 		uint64_t uniformMask = 0;
 		FragmentShaderFlags flags;
+		double start = time_now_d();
 		if (!GenerateFragmentShader(id, codeBuffer_, compat_, draw_->GetBugs(), &uniformMask, &flags, &genErrorString)) {
 			WARN_LOG(G3D, "Failed to generate fragment shader during cache load");
 			// We just ignore this one and carry on.
 			failCount++;
 			continue;
 		}
+		ShaderCompileLog_Record(ShaderCompileStage::FRAGMENT_GEN, CompileLogID(id), time_now_d() - start, false);
 		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "FS length error: %d", (int)strlen(codeBuffer_));
-		VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan, id, flags, codeBuffer_);
+		std::vector<uint32_t> *cachedSpirv = MatchCachedSpirv(codeBuffer_, sourceHash, spirv);
+		if (cachedSpirv)
+			spirvHits++;
+		VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan, id, flags, codeBuffer_, cachedSpirv);
 		std::lock_guard<std::mutex> guard(cacheLock_);
 		VulkanFragmentShader *old = fsCache_.Get(id);
 		if (old) {
@@ -629,15 +729,24 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 			ERROR_LOG(G3D, "Vulkan shader cache truncated (in GeometryShaders)");
 			return false;
 		}
+		if (!ReadCachedSpirv(f, &sourceHash, &spirv)) {
+			ERROR_LOG(G3D, "Vulkan shader cache truncated (in GeometryShaders)");
+			return false;
+		}
 		std::string genErrorString;
+		double start = time_now_d();
 		if (!GenerateGeometryShader(id, codeBuffer_, compat_, draw_->GetBugs(), &genErrorString)) {
 			WARN_LOG(G3D, "Failed to generate geometry shader during cache load");
 			// We just ignore this one and carry on.
 			failCount++;
 			continue;
 		}
+		ShaderCompileLog_Record(ShaderCompileStage::GEOMETRY_GEN, CompileLogID(id), time_now_d() - start, false);
 		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "GS length error: %d", (int)strlen(codeBuffer_));
-		VulkanGeometryShader *gs = new VulkanGeometryShader(vulkan, id, codeBuffer_);
+		std::vector<uint32_t> *cachedSpirv = MatchCachedSpirv(codeBuffer_, sourceHash, spirv);
+		if (cachedSpirv)
+			spirvHits++;
+		VulkanGeometryShader *gs = new VulkanGeometryShader(vulkan, id, codeBuffer_, cachedSpirv);
 		std::lock_guard<std::mutex> guard(cacheLock_);
 		VulkanGeometryShader *old = gsCache_.Get(id);
 		if (old) {
@@ -647,7 +756,7 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 		gsCache_.Insert(id, gs);
 	}
 
-	NOTICE_LOG(G3D, "ShaderCache: Loaded %d vertex, %d fragment shaders and %d geometry shaders (failed %d)", header.numVertexShaders, header.numFragmentShaders, header.numGeometryShaders, failCount);
+	NOTICE_LOG(G3D, "ShaderCache: Loaded %d vertex, %d fragment shaders and %d geometry shaders (failed %d, %d from cached SPIR-V)", header.numVertexShaders, header.numFragmentShaders, header.numGeometryShaders, failCount, spirvHits);
 	return true;
 }
 
@@ -665,12 +774,15 @@ void ShaderManagerVulkan::SaveCache(FILE *f, DrawEngineVulkan *drawEngine) {
 	bool writeFailed = fwrite(&header, sizeof(header), 1, f) != 1;
 	vsCache_.Iterate([&](const VShaderID &id, VulkanVertexShader *vs) {
 		writeFailed = writeFailed || fwrite(&id, sizeof(id), 1, f) != 1;
+		writeFailed = writeFailed || !WriteCachedSpirv(f, vs->source(), vs->GetSpirv());
 	});
 	fsCache_.Iterate([&](const FShaderID &id, VulkanFragmentShader *fs) {
 		writeFailed = writeFailed || fwrite(&id, sizeof(id), 1, f) != 1;
+		writeFailed = writeFailed || !WriteCachedSpirv(f, fs->source(), fs->GetSpirv());
 	});
 	gsCache_.Iterate([&](const GShaderID &id, VulkanGeometryShader *gs) {
 		writeFailed = writeFailed || fwrite(&id, sizeof(id), 1, f) != 1;
+		writeFailed = writeFailed || !WriteCachedSpirv(f, gs->source(), gs->GetSpirv());
 	});
 	if (writeFailed) {
 		ERROR_LOG(G3D, "Failed to write Vulkan shader cache, disk full?");
@@ -38,7 +38,8 @@ class VulkanPushBuffer;
 
 class VulkanFragmentShader {
 public:
-	VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code);
+	// If cachedSpirv is set, it must have been compiled from exactly this code.
+	VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code, std::vector<uint32_t> *cachedSpirv = nullptr);
 	~VulkanFragmentShader();
 
 	const std::string &source() const { return source_; }
@@ -48,11 +49,15 @@ class VulkanFragmentShader {
 	std::string GetShaderString(DebugShaderStringType type) const;
 	Promise<VkShaderModule> *GetModule() { return module_; }
 	const FShaderID &GetID() const { return id_; }
+	// Blocks until compiled. Empty on failure.
+	const std::vector<uint32_t> &GetSpirv();
 
 	FragmentShaderFlags Flags() const { return flags_;  }
 
 protected:	
 	Promise<VkShaderModule> *module_ = nullptr;
+	// Kept for the shader cache, so the next run can skip GLSLtoSPV.
+	std::vector<uint32_t> spirv_;
 
 	VulkanContext *vulkan_;
 	std::string source_;
@@ -63,7 +68,7 @@ class VulkanFragmentShader {
 
 class VulkanVertexShader {
 public:
-	VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform);
+	VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform, std::vector<uint32_t> *cachedSpirv = nullptr);
 	~VulkanVertexShader();
 
 	const std::string &source() const { return source_; }
@@ -75,9 +80,12 @@ class VulkanVertexShader {
 	std::string GetShaderString(DebugShaderStringType type) const;
 	Promise<VkShaderModule> *GetModule() { return module_; }
 	const VShaderID &GetID() const { return id_; }
+	const std::vector<uint32_t> &GetSpirv();
 
 protected:
 	Promise<VkShaderModule> *module_ = nullptr;
+	// Kept for the shader cache, so the next run can skip GLSLtoSPV.
+	std::vector<uint32_t> spirv_;
 
 	VulkanContext *vulkan_;
 	std::string source_;
@@ -89,7 +97,7 @@ class VulkanVertexShader {
 
 class VulkanGeometryShader {
 public:
-	VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code);
+	VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code, std::vector<uint32_t> *cachedSpirv = nullptr);
 	~VulkanGeometryShader();
 
 	const std::string &source() const { return source_; }
@@ -99,9 +107,12 @@ class VulkanGeometryShader {
 	std::string GetShaderString(DebugShaderStringType type) const;
 	Promise<VkShaderModule> *GetModule() const { return module_; }
 	const GShaderID &GetID() { return id_; }
+	const std::vector<uint32_t> &GetSpirv();
 
 protected:
 	Promise<VkShaderModule> *module_ = nullptr;
+	// Kept for the shader cache, so the next run can skip GLSLtoSPV.
+	std::vector<uint32_t> spirv_;
 
 	VulkanContext *vulkan_;
 	std::string source_;
@@ -118,6 +129,7 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 	void DeviceRestore(Draw::DrawContext *draw) override;
 
 	void GetShaders(int prim, VertexDecoder *decoder, VulkanVertexShader **vshader, VulkanFragmentShader **fshader, VulkanGeometryShader **gshader, const ComputedPipelineState &pipelineState, bool useHWTransform, bool useHWTessellation, bool weightsAsFloat, bool useSkinInDecode);
+	VulkanFragmentShader *GetOrCreateFragmentShader(const FShaderID &id);
 	void ClearShaders() override;
 	void DirtyShader();
 	void DirtyLastShader() override;
@@ -165,13 +177,13 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 
 	ShaderLanguageDesc compat_;
 
-	typedef DenseHashMap<FShaderID, VulkanFragmentShader *, nullptr> FSCache;
+	typedef SwissHashMap<FShaderID, VulkanFragmentShader *, nullptr> FSCache;
 	FSCache fsCache_;
 
-	typedef DenseHashMap<VShaderID, VulkanVertexShader *, nullptr> VSCache;
+	typedef SwissHashMap<VShaderID, VulkanVertexShader *, nullptr> VSCache;
 	VSCache vsCache_;
 
-	typedef DenseHashMap<GShaderID, VulkanGeometryShader *, nullptr> GSCache;
+	typedef SwissHashMap<GShaderID, VulkanGeometryShader *, nullptr> GSCache;
 	GSCache gsCache_;
 
 	char *codeBuffer_;
@@ -189,5 +201,7 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 
 	FShaderID lastFSID_;
 	VShaderID lastVSID_;
+	// GE state part of the vertex shader ID, reused when only the vertex format changes.
+	VShaderID lastVSStateID_;
 	GShaderID lastGSID_;
 };
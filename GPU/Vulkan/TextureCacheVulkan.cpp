@@ -31,6 +31,7 @@
 #include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
+#include "Core/Debugger/MemBlockInfo.h"
 #include "Core/Host.h"
 #include "Core/MemMap.h"
 #include "Core/System.h"
@@ -107,6 +108,74 @@ void main() {
 
 )";
 
+// Decodes CLUT4/CLUT8 textures straight from PSP memory, handling swizzle and the CLUT index transform.
+// The buffers are the raw texture bytes and the raw CLUT, as uploaded from RAM.
+const char *decodeShader = R"(
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+uniform layout(set = 0, binding = 0, rgba8) writeonly image2D img;
+
+layout(std430, set = 0, binding = 1) buffer Buf {
+	uint data[];
+} buf;
+
+layout(std430, set = 0, binding = 2) buffer Clut {
+	uint data[];
+} clut;
+
+// flags: bits 0-4 index shift, 5-12 index mask, 13-21 start pos, 22-23 palette format, 24 clut8, 25 swizzled.
+layout(push_constant) uniform Params {
+	int width;
+	int height;
+	uint bufwBytes;
+	uint flags;
+} params;
+
+uint readByte(uint addr) {
+	return (buf.data[addr >> 2] >> ((addr & 3u) * 8u)) & 0xFFu;
+}
+
+vec4 readClut(uint index) {
+	uint fmt = (params.flags >> 22) & 3u;
+	if (fmt == 3u)
+		return unpackUnorm4x8(clut.data[index]);
+
+	uint c = (clut.data[index >> 1] >> ((index & 1u) * 16u)) & 0xFFFFu;
+	if (fmt == 0u)
+		return vec4(float(c & 0x1Fu) / 31.0, float((c >> 5) & 0x3Fu) / 63.0, float((c >> 11) & 0x1Fu) / 31.0, 1.0);
+	if (fmt == 1u)
+		return vec4(float(c & 0x1Fu) / 31.0, float((c >> 5) & 0x1Fu) / 31.0, float((c >> 10) & 0x1Fu) / 31.0, float(c >> 15));
+	return vec4(float(c & 0xFu), float((c >> 4) & 0xFu), float((c >> 8) & 0xFu), float(c >> 12)) / 15.0;
+}
+
+void main() {
+	uvec2 xy = gl_GlobalInvocationID.xy;
+	if (xy.x >= params.width || xy.y >= params.height)
+		return;
+
+	bool clut8 = (params.flags & (1u << 24)) != 0u;
+	uint byteX = clut8 ? xy.x : (xy.x >> 1);
+	uint addr;
+	if ((params.flags & (1u << 25)) != 0u) {
+		// Swizzled textures are stored in blocks of 16 bytes x 8 rows.
+		uint blocksPerRow = params.bufwBytes >> 4;
+		addr = ((xy.y >> 3) * blocksPerRow + (byteX >> 4)) * 128u + (xy.y & 7u) * 16u + (byteX & 15u);
+	} else {
+		addr = xy.y * params.bufwBytes + byteX;
+	}
+
+	uint index = readByte(addr);
+	if (!clut8)
+		index = (xy.x & 1u) != 0u ? (index >> 4) : (index & 0xFu);
+	index = ((index >> (params.flags & 0x1Fu)) & ((params.flags >> 5) & 0xFFu)) | ((params.flags >> 13) & 0x1FFu);
+	imageStore(img, ivec2(xy), readClut(index));
+}
+
+)";
+
 static int VkFormatBytesPerPixel(VkFormat format) {
 	switch (format) {
 	case VULKAN_8888_FORMAT: return 4;
@@ -222,6 +291,8 @@ void TextureCacheVulkan::DeviceLost() {
 
 	if (uploadCS_ != VK_NULL_HANDLE)
 		vulkan->Delete().QueueDeleteShaderModule(uploadCS_);
+	if (decodeCS_ != VK_NULL_HANDLE)
+		vulkan->Delete().QueueDeleteShaderModule(decodeCS_);
 
 	computeShaderManager_.DeviceLost();
 
@@ -250,6 +321,11 @@ void TextureCacheVulkan::DeviceRestore(Draw::DrawContext *draw) {
 
 	CompileScalingShader();
 
+	std::string error;
+	decodeCS_ = CompileShaderModule(vulkan, VK_SHADER_STAGE_COMPUTE_BIT, decodeShader, &error);
+	if (decodeCS_ == VK_NULL_HANDLE)
+		WARN_LOG(G3D, "Failed to compile texture decode shader, decoding on the CPU: %s", error.c_str());
+
 	computeShaderManager_.DeviceRestore(draw);
 }
 
@@ -290,7 +366,8 @@ void TextureCacheVulkan::CompileScalingShader() {
 	if (!shaderInfo || shaderInfo->computeShaderFile.empty())
 		return;
 
-	std::string shaderSource = ReadShaderSrc(shaderInfo->computeShaderFile);
+	// Lets shaders like the bicubic one support several scale factors.
+	std::string shaderSource = StringFromFormat("#define SCALE %d\n", shaderInfo->scaleFactor) + ReadShaderSrc(shaderInfo->computeShaderFile);
 	std::string fullUploadShader = StringFromFormat(uploadShader, shaderSource.c_str());
 
 	std::string error;
@@ -397,6 +474,13 @@ void TextureCacheVulkan::BindAsClutTexture(Draw::Texture *tex, bool smooth) {
 	drawEngine_->SetDepalTexture(clutTexture, smooth);
 }
 
+void TextureCacheVulkan::BindAsClutFramebuffer(Draw::Framebuffer *fb) {
+	// Binding through Draw takes care of the layout transition, then we grab the view from there.
+	draw_->BindFramebufferAsTexture(fb, 1, Draw::FB_COLOR_BIT, 0);
+	VkImageView clutTexture = (VkImageView)draw_->GetNativeObject(Draw::NativeObject::BOUND_TEXTURE1_IMAGEVIEW);
+	drawEngine_->SetDepalTexture(clutTexture, false);
+}
+
 static Draw::DataFormat FromVulkanFormat(VkFormat fmt) {
 	switch (fmt) {
 	case VULKAN_8888_FORMAT: default: return Draw::DataFormat::R8G8B8A8_UNORM;
@@ -405,6 +489,14 @@ static Draw::DataFormat FromVulkanFormat(VkFormat fmt) {
 
 static VkFormat ToVulkanFormat(Draw::DataFormat fmt) {
 	switch (fmt) {
+	// Block compressed formats only come from DDS/KTX2 replacements.
+	case Draw::DataFormat::BC1_RGBA_UNORM_BLOCK: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+	case Draw::DataFormat::BC2_UNORM_BLOCK: return VK_FORMAT_BC2_UNORM_BLOCK;
+	case Draw::DataFormat::BC3_UNORM_BLOCK: return VK_FORMAT_BC3_UNORM_BLOCK;
+	case Draw::DataFormat::BC7_UNORM_BLOCK: return VK_FORMAT_BC7_UNORM_BLOCK;
+	case Draw::DataFormat::ETC2_R8G8B8_UNORM_BLOCK: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+	case Draw::DataFormat::ETC2_R8G8B8A8_UNORM_BLOCK: return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+	case Draw::DataFormat::ASTC_4x4_UNORM_BLOCK: return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
 	case Draw::DataFormat::R8G8B8A8_UNORM: default: return VULKAN_8888_FORMAT;
 	}
 }
@@ -440,6 +532,12 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 		plan.levelsToCreate = plan.maxPossibleLevels;
 	}
 
+	// Indexed textures can skip CPU decoding entirely, the shader always outputs 8888.
+	bool computeDecode = CanDecodeOnGPU(plan, entry);
+	if (computeDecode) {
+		dstFmt = VULKAN_8888_FORMAT;
+	}
+
 	// Any texture scaling is gonna move away from the original 16-bit format, if any.
 	VkFormat actualFmt = plan.scaleFactor > 1 ? VULKAN_8888_FORMAT : dstFmt;
 	if (plan.replaceValid) {
@@ -475,7 +573,7 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 		}
 	}
 
-	if (computeUpload) {
+	if (computeUpload || computeDecode) {
 		usage |= VK_IMAGE_USAGE_STORAGE_BIT;
 		imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 	}
@@ -484,7 +582,21 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 		actualFmt = VULKAN_8888_FORMAT;
 	}
 
-	bool allocSuccess = image->CreateDirect(cmdInit, plan.createW, plan.createH, plan.depth, plan.levelsToCreate, actualFmt, imageLayout, usage, mapping);
+	// Plain copies of whole 2D levels can go on the transfer queue if there is one, so they don't
+	// have to wait for rendering to finish. Mip generation and compute need the graphics queue.
+	VkCommandBuffer cmdUpload = cmdInit;
+	VulkanPushBuffer *uploadPush = drawEngine_->GetPushBufferForTextureData();
+	bool asyncUpload = false;
+	if (!computeUpload && !computeDecode && plan.depth == 1 && plan.levelsToLoad >= plan.levelsToCreate && drawEngine_->GetPushBufferForAsyncTextureData()) {
+		VkCommandBuffer cmdTransfer = (VkCommandBuffer)draw_->GetNativeObject(Draw::NativeObject::TRANSFER_COMMANDBUFFER);
+		if (cmdTransfer) {
+			cmdUpload = cmdTransfer;
+			uploadPush = drawEngine_->GetPushBufferForAsyncTextureData();
+			asyncUpload = true;
+		}
+	}
+
+	bool allocSuccess = image->CreateDirect(cmdUpload, plan.createW, plan.createH, plan.depth, plan.levelsToCreate, actualFmt, imageLayout, usage, mapping, asyncUpload);
 	if (!allocSuccess && !lowMemoryMode_) {
 		WARN_LOG_REPORT(G3D, "Texture cache ran out of GPU memory; switching to low memory mode");
 		lowMemoryMode_ = true;
@@ -507,8 +619,10 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 		plan.createH /= plan.scaleFactor;
 		plan.scaleFactor = 1;
 		actualFmt = dstFmt;
+		// No storage usage below, so decode on the CPU (dstFmt is still fine for that.)
+		computeDecode = false;
 
-		allocSuccess = image->CreateDirect(cmdInit, plan.createW, plan.createH, plan.depth, plan.levelsToCreate, actualFmt, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, mapping);
+		allocSuccess = image->CreateDirect(cmdUpload, plan.createW, plan.createH, plan.depth, plan.levelsToCreate, actualFmt, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, mapping, asyncUpload);
 	}
 
 	if (!allocSuccess) {
@@ -542,9 +656,20 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 
 		int bpp = VkFormatBytesPerPixel(actualFmt);
 		int optimalStrideAlignment = std::max(4, (int)vulkan->GetPhysicalDeviceProperties().properties.limits.optimalBufferCopyRowPitchAlignment);
-		int byteStride = RoundUpToPowerOf2(mipWidth * bpp, optimalStrideAlignment);  // output stride
-		int pixelStride = byteStride / bpp;
-		int uploadSize = byteStride * mipHeight;
+		int byteStride;
+		int pixelStride;
+		int uploadSize;
+		int blockSize = 0;
+		if (plan.replaceValid && Draw::DataFormatIsBlockCompressed(plan.replaced->Format(plan.baseLevelSrc + i), &blockSize)) {
+			// Compressed data is uploaded tightly packed, in rows of 4x4 blocks.
+			byteStride = ((mipWidth + 3) / 4) * blockSize;
+			pixelStride = ((mipWidth + 3) / 4) * 4;
+			uploadSize = byteStride * ((mipHeight + 3) / 4);
+		} else {
+			byteStride = RoundUpToPowerOf2(mipWidth * bpp, optimalStrideAlignment);  // output stride
+			pixelStride = byteStride / bpp;
+			uploadSize = byteStride * mipHeight;
+		}
 
 		uint32_t bufferOffset;
 		VkBuffer texBuf;
@@ -558,29 +683,31 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 				saveData.resize(sz);
 				data = &saveData[0];
 			} else {
-				data = drawEngine_->GetPushBufferForTextureData()->PushAligned(sz, &bufferOffset, &texBuf, pushAlignment);
+				data = uploadPush->PushAligned(sz, &bufferOffset, &texBuf, pushAlignment);
 			}
 			LoadVulkanTextureLevel(*entry, (uint8_t *)data, lstride, srcLevel, lfactor, actualFmt);
 			if (plan.saveTexture)
-				bufferOffset = drawEngine_->GetPushBufferForTextureData()->PushAligned(&saveData[0], sz, pushAlignment, &texBuf);
+				bufferOffset = uploadPush->PushAligned(&saveData[0], sz, pushAlignment, &texBuf);
 		};
 
 		bool dataScaled = true;
 		if (plan.replaceValid) {
 			// Directly load the replaced image.
-			data = drawEngine_->GetPushBufferForTextureData()->PushAligned(uploadSize, &bufferOffset, &texBuf, pushAlignment);
+			data = uploadPush->PushAligned(uploadSize, &bufferOffset, &texBuf, pushAlignment);
 			double replaceStart = time_now_d();
 			plan.replaced->Load(plan.baseLevelSrc + i, data, byteStride);  // if it fails, it'll just be garbage data... OK for now.
 			replacementTimeThisFrame_ += time_now_d() - replaceStart;
 			VK_PROFILE_BEGIN(vulkan, cmdInit, VK_PIPELINE_STAGE_TRANSFER_BIT,
 				"Copy Upload (replaced): %dx%d", mipWidth, mipHeight);
-			entry->vkTex->UploadMip(cmdInit, i, mipWidth, mipHeight, 0, texBuf, bufferOffset, pixelStride);
+			entry->vkTex->UploadMip(cmdUpload, i, mipWidth, mipHeight, 0, texBuf, bufferOffset, pixelStride);
 			VK_PROFILE_END(vulkan, cmdInit, VK_PIPELINE_STAGE_TRANSFER_BIT);
 		} else {
 			if (plan.depth != 1) {
 				// 3D texturing.
 				loadLevel(uploadSize, i, byteStride, plan.scaleFactor);
-				entry->vkTex->UploadMip(cmdInit, 0, mipWidth, mipHeight, i, texBuf, bufferOffset, pixelStride);
+				entry->vkTex->UploadMip(cmdUpload, 0, mipWidth, mipHeight, i, texBuf, bufferOffset, pixelStride);
+			} else if (computeDecode) {
+				DecodeLevelOnGPU(cmdInit, entry, i, pushAlignment);
 			} else if (computeUpload) {
 				int srcBpp = VkFormatBytesPerPixel(dstFmt);
 				int srcStride = mipUnscaledWidth * srcBpp;
@@ -604,7 +731,7 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 				loadLevel(uploadSize, i == 0 ? plan.baseLevelSrc : i, byteStride, plan.scaleFactor);
 				VK_PROFILE_BEGIN(vulkan, cmdInit, VK_PIPELINE_STAGE_TRANSFER_BIT,
 					"Copy Upload: %dx%d", mipWidth, mipHeight);
-				entry->vkTex->UploadMip(cmdInit, i, mipWidth, mipHeight, 0, texBuf, bufferOffset, pixelStride);
+				entry->vkTex->UploadMip(cmdUpload, i, mipWidth, mipHeight, 0, texBuf, bufferOffset, pixelStride);
 				VK_PROFILE_END(vulkan, cmdInit, VK_PIPELINE_STAGE_TRANSFER_BIT);
 			}
 			// Format might be wrong in lowMemoryMode_, so don't save.
@@ -627,20 +754,25 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 		}
 	}
 
-	VkImageLayout layout = computeUpload ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	VkPipelineStageFlags prevStage = computeUpload ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT;
+	bool computeWritten = computeUpload || computeDecode;
+	VkImageLayout layout = computeWritten ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	VkPipelineStageFlags prevStage = computeWritten ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT;
 
 	// Generate any additional mipmap levels.
 	// This will transition the whole stack to GENERAL if it wasn't already.
 	if (plan.levelsToLoad < plan.levelsToCreate) {
 		VK_PROFILE_BEGIN(vulkan, cmdInit, VK_PIPELINE_STAGE_TRANSFER_BIT, "Mipgen up to level %d", plan.levelsToCreate);
-		entry->vkTex->GenerateMips(cmdInit, plan.levelsToLoad, computeUpload);
+		entry->vkTex->GenerateMips(cmdInit, plan.levelsToLoad, computeWritten);
 		layout = VK_IMAGE_LAYOUT_GENERAL;
 		prevStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 		VK_PROFILE_END(vulkan, cmdInit, VK_PIPELINE_STAGE_TRANSFER_BIT);
 	}
 
-	entry->vkTex->EndCreate(cmdInit, false, prevStage, layout);
+	if (asyncUpload) {
+		entry->vkTex->EndCreateOnTransferQueue(cmdUpload);
+	} else {
+		entry->vkTex->EndCreate(cmdInit, false, prevStage, layout);
+	}
 	VK_PROFILE_END(vulkan, cmdInit, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 
 	// Signal that we support depth textures so use it as one.
@@ -653,6 +785,112 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 	}
 }
 
+static int DecodeSourceBytes(GETextureFormat format, int bufw, int h, bool swizzled) {
+	int bufwBytes = format == GE_TFMT_CLUT4 ? bufw / 2 : bufw;
+	// Swizzled data is always in whole blocks of 8 rows.
+	return bufwBytes * (swizzled ? ((h + 7) & ~7) : h);
+}
+
+bool TextureCacheVulkan::CanDecodeOnGPU(const BuildTexturePlan &plan, const TexCacheEntry *entry) {
+	if (!g_Config.bTexGPUDecode || decodeCS_ == VK_NULL_HANDLE)
+		return false;
+	// Everything else has to go through the CPU decode, this only covers a straight decode.
+	if (plan.scaleFactor > 1 || plan.replaceValid || plan.saveTexture || replacer_.Enabled() || plan.depth != 1 || plan.decodeToClut8)
+		return false;
+
+	GETextureFormat format = (GETextureFormat)entry->format;
+	if (format != GE_TFMT_CLUT4 && format != GE_TFMT_CLUT8)
+		return false;
+	// Separate CLUTs per mip level index at an offset, let the CPU handle those.
+	if (plan.levelsToLoad > 1 && !gstate.isClutSharedForMipmaps())
+		return false;
+
+	bool swizzled = gstate.isTextureSwizzled();
+	for (int i = 0; i < plan.levelsToLoad; i++) {
+		u32 texaddr = gstate.getTextureAddress(i);
+		// Mirrors might flip the swizzle, see DecodeTextureLevel().
+		if ((texaddr & 0x00600000) != 0 && Memory::IsVRAMAddress(texaddr))
+			return false;
+		int bufw = GetTextureBufw(i, texaddr, format);
+		int h = gstate.getTextureHeight(i);
+		if (!Memory::IsValidRange(texaddr, DecodeSourceBytes(format, bufw, h, swizzled)))
+			return false;
+	}
+	return true;
+}
+
+// Same as DecodeTextureLevel() would find, but only looking at the reachable CLUT entries.
+static CheckAlphaResult CheckClutAlpha(const u32 *rawClut, GEPaletteFormat clutFormat, int numIndices) {
+	if (clutFormat == GE_CMODE_16BIT_BGR5650)
+		return CHECKALPHA_FULL;
+
+	const u16 *clut16 = (const u16 *)rawClut;
+	for (int i = 0; i < numIndices; ++i) {
+		u32 index = gstate.transformClutIndex(i);
+		bool full;
+		switch (clutFormat) {
+		case GE_CMODE_32BIT_ABGR8888: full = (rawClut[index] & 0xFF000000) == 0xFF000000; break;
+		case GE_CMODE_16BIT_ABGR5551: full = (clut16[index] & 0x8000) != 0; break;
+		default: full = (clut16[index] & 0xF000) == 0xF000; break;
+		}
+		if (!full)
+			return CHECKALPHA_ANY;
+	}
+	return CHECKALPHA_FULL;
+}
+
+void TextureCacheVulkan::DecodeLevelOnGPU(VkCommandBuffer cmd, TexCacheEntry *entry, int level, int pushAlignment) {
+	VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
+
+	GETextureFormat format = (GETextureFormat)entry->format;
+	GEPaletteFormat clutFormat = gstate.getClutPaletteFormat();
+	u32 texaddr = gstate.getTextureAddress(level);
+	int w = gstate.getTextureWidth(level);
+	int h = gstate.getTextureHeight(level);
+	int bufw = GetTextureBufw(level, texaddr, format);
+	bool swizzled = gstate.isTextureSwizzled();
+	const int clutBytes = 2048;
+
+	int srcSize = DecodeSourceBytes(format, bufw, h, swizzled);
+	char buf[128];
+	size_t len = snprintf(buf, sizeof(buf), "Tex_%08x_%dx%d_%s", texaddr, w, h, GeTextureFormatToString(format, clutFormat));
+	NotifyMemInfo(MemBlockFlags::TEXTURE, texaddr, srcSize, buf, len);
+
+	pushAlignment = std::max(pushAlignment, (int)vulkan->GetPhysicalDeviceProperties().properties.limits.minStorageBufferOffsetAlignment);
+	VulkanPushBuffer *pushBuffer = drawEngine_->GetPushBufferForTextureData();
+	uint32_t texOffset, clutOffset;
+	VkBuffer texBuf, clutBuf;
+	// The shader reads whole words.
+	int srcAllocSize = (srcSize + 3) & ~3;
+	u8 *srcData = (u8 *)pushBuffer->PushAligned(srcAllocSize, &texOffset, &texBuf, pushAlignment);
+	memcpy(srcData, Memory::GetPointerUnchecked(texaddr), srcSize);
+	clutOffset = pushBuffer->PushAligned(clutBufRaw_, clutBytes, pushAlignment, &clutBuf);
+
+	int bufwBytes = format == GE_TFMT_CLUT4 ? bufw / 2 : bufw;
+	u32 shift = gstate.getClutIndexShift();
+	u32 mask = gstate.getClutIndexMask();
+	u32 startPos = gstate.getClutIndexStartPos() & (clutFormat == GE_CMODE_32BIT_ABGR8888 ? 0xFF : 0x1FF);
+	u32 flags = shift | (mask << 5) | (startPos << 13) | ((u32)clutFormat << 22);
+	if (format == GE_TFMT_CLUT8)
+		flags |= 1 << 24;
+	if (swizzled)
+		flags |= 1 << 25;
+
+	VkImageView view = entry->vkTex->CreateViewForMip(level);
+	VkDescriptorSet descSet = computeShaderManager_.GetDescriptorSet(view, texBuf, texOffset, srcAllocSize, clutBuf, clutOffset, clutBytes);
+	struct Params { int w; int h; u32 bufwBytes; u32 flags; } params{ w, h, (u32)bufwBytes, flags };
+	VK_PROFILE_BEGIN(vulkan, cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		"Compute Decode: %dx%d %s", w, h, GeTextureFormatToString(format, clutFormat));
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, computeShaderManager_.GetPipeline(decodeCS_));
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, computeShaderManager_.GetPipelineLayout(), 0, 1, &descSet, 0, nullptr);
+	vkCmdPushConstants(cmd, computeShaderManager_.GetPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+	vkCmdDispatch(cmd, (w + 7) / 8, (h + 7) / 8, 1);
+	VK_PROFILE_END(vulkan, cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	vulkan->Delete().QueueDeleteImageView(view);
+
+	entry->SetAlphaStatus(CheckClutAlpha(clutBufRaw_, clutFormat, format == GE_TFMT_CLUT8 ? 256 : 16), level);
+}
+
 VkFormat TextureCacheVulkan::GetDestFormat(GETextureFormat format, GEPaletteFormat clutFormat) const {
 	if (!gstate_c.Use(GPU_USE_16BIT_FORMATS)) {
 		return VK_FORMAT_R8G8B8A8_UNORM;
@@ -92,8 +92,10 @@ class TextureCacheVulkan : public TextureCacheCommon {
 	void Unbind() override;
 	void ReleaseTexture(TexCacheEntry *entry, bool delete_them) override;
 	void BindAsClutTexture(Draw::Texture *tex, bool smooth) override;
+	void BindAsClutFramebuffer(Draw::Framebuffer *fb) override;
 	void ApplySamplingParams(const SamplerCacheKey &key) override;
 	void BoundFramebufferTexture() override;
+	bool SupportsCompressedReplacements() const override { return true; }
 	void *GetNativeTextureView(const TexCacheEntry *entry) override;
 
 private:
@@ -104,6 +106,8 @@ class TextureCacheVulkan : public TextureCacheCommon {
 	void BuildTexture(TexCacheEntry *const entry) override;
 
 	void CompileScalingShader();
+	bool CanDecodeOnGPU(const BuildTexturePlan &plan, const TexCacheEntry *entry);
+	void DecodeLevelOnGPU(VkCommandBuffer cmd, TexCacheEntry *entry, int level, int pushAlignment);
 
 	VulkanDeviceAllocator *allocator_ = nullptr;
 	VulkanPushBuffer *push_ = nullptr;
@@ -116,6 +120,7 @@ class TextureCacheVulkan : public TextureCacheCommon {
 
 	std::string textureShader_;
 	VkShaderModule uploadCS_ = VK_NULL_HANDLE;
+	VkShaderModule decodeCS_ = VK_NULL_HANDLE;
 
 	// Bound state to emulate an API similar to the others
 	VkImageView imageView_ = VK_NULL_HANDLE;
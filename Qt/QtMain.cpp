@@ -41,6 +41,7 @@
 
 #include "QtMain.h"
 #include "Common/Data/Text/I18n.h"
+#include "Common/Thread/CorePlacement.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/Data/Encoding/Utf8.h"
 #include "Common/StringUtils.h"
@@ -343,6 +344,7 @@ static int mainInternal(QApplication &a) {
 
 void MainUI::EmuThreadFunc() {
 	SetCurrentThreadName("Emu");
+	SetCurrentThreadRole(ThreadRole::EMU);
 
 	// There's no real requirement that NativeInit happen on this thread, though it can't hurt...
 	// We just call the update/render loop here. NativeInitGraphics should be here though.
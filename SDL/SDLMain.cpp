@@ -50,6 +50,7 @@ SDLJoystick *joystick = NULL;
 #include "Common/Input/KeyCodes.h"
 #include "Common/Data/Collections/ConstMap.h"
 #include "Common/Data/Encoding/Utf8.h"
+#include "Common/Thread/CorePlacement.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Core/System.h"
 #include "Core/Core.h"
@@ -497,6 +498,7 @@ static std::atomic<int> emuThreadState((int)EmuThreadState::DISABLED);
 
 static void EmuThreadFunc(GraphicsContext *graphicsContext) {
 	SetCurrentThreadName("Emu");
+	SetCurrentThreadRole(ThreadRole::EMU);
 
 	// There's no real requirement that NativeInit happen on this thread.
 	// We just call the update/render loop here.
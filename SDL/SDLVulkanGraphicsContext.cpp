@@ -26,6 +26,11 @@ static const bool g_Validate = false;
 static uint32_t FlagsFromConfig() {
 	uint32_t flags = 0;
 	flags = g_Config.bVSync ? VULKAN_FLAG_PRESENT_FIFO : VULKAN_FLAG_PRESENT_MAILBOX;
+	if (g_Config.bLowLatencyPresent) {
+		// Mailbox still waits for vblank but never queues up old frames.  Without vsync, tearing is fine.
+		flags |= g_Config.bVSync ? VULKAN_FLAG_PRESENT_MAILBOX : VULKAN_FLAG_PRESENT_IMMEDIATE;
+		flags |= VULKAN_FLAG_LOW_LATENCY;
+	}
 	if (g_Validate) {
 		flags |= VULKAN_FLAG_VALIDATE;
 	}
@@ -38,24 +38,31 @@
 #endif
 #include "Common/File/AndroidStorage.h"
 #include "Common/Data/Text/I18n.h"
+#include "Common/Data/Text/Parsers.h"
+#include "Common/File/FileUtil.h"
 #include "Common/Net/HTTPClient.h"
 #include "Common/UI/Context.h"
 #include "Common/UI/View.h"
 #include "Common/UI/ViewGroup.h"
 #include "Common/UI/UI.h"
+#include "Common/Profiler/MemoryUsage.h"
 #include "Common/Profiler/Profiler.h"
 
 #include "Common/LogManager.h"
 #include "Common/CPUDetect.h"
 #include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
 
 #include "Core/MemMap.h"
+#include "Core/Debugger/GuestProfiler.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/System.h"
 #include "Core/Reporting.h"
 #include "Core/CoreParameter.h"
 #include "Core/MIPS/MIPSTables.h"
+#include "Core/MIPS/IR/IRPassSimplify.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitState.h"
@@ -66,6 +73,7 @@
 #include "UI/MainScreen.h"
 #include "UI/ControlMappingScreen.h"
 #include "UI/GameSettingsScreen.h"
+#include "UI/OnScreenDisplay.h"
 
 
 #ifdef _WIN32
@@ -100,6 +108,8 @@ void DevMenuScreen::CreatePopupContents(UI::ViewGroup *parent) {
 	items->Add(new Choice(sy->T("Developer Tools")))->OnClick.Handle(this, &DevMenuScreen::OnDeveloperTools);
 	items->Add(new Choice(dev->T("Jit Compare")))->OnClick.Handle(this, &DevMenuScreen::OnJitCompare);
 	items->Add(new Choice(dev->T("Shader Viewer")))->OnClick.Handle(this, &DevMenuScreen::OnShaderView);
+	items->Add(new Choice(dev->T("Guest Profiler")))->OnClick.Handle(this, &DevMenuScreen::OnGuestProfiler);
+	items->Add(new Choice(dev->T("Memory Usage")))->OnClick.Handle(this, &DevMenuScreen::OnMemoryUsage);
 	if (g_Config.iGPUBackend == (int)GPUBackend::VULKAN) {
 		items->Add(new CheckBox(&g_Config.bShowAllocatorDebug, dev->T("Allocator Viewer")));
 		items->Add(new CheckBox(&g_Config.bShowGpuProfile, dev->T("GPU Profile")));
@@ -164,6 +174,18 @@ UI::EventReturn DevMenuScreen::OnShaderView(UI::EventParams &e) {
 	return UI::EVENT_DONE;
 }
 
+UI::EventReturn DevMenuScreen::OnGuestProfiler(UI::EventParams &e) {
+	UpdateUIState(UISTATE_PAUSEMENU);
+	screenManager()->push(new GuestProfilerScreen());
+	return UI::EVENT_DONE;
+}
+
+UI::EventReturn DevMenuScreen::OnMemoryUsage(UI::EventParams &e) {
+	UpdateUIState(UISTATE_PAUSEMENU);
+	screenManager()->push(new MemoryUsageScreen());
+	return UI::EVENT_DONE;
+}
+
 UI::EventReturn DevMenuScreen::OnFreezeFrame(UI::EventParams &e) {
 	if (PSP_CoreParameter().frozen) {
 		PSP_CoreParameter().frozen = false;
@@ -387,6 +409,7 @@ static const JitDisableFlag jitDisableFlags[] = {
 	{ MIPSComp::JitDisable::CACHE_POINTERS, "Cached pointers" },
 	{ MIPSComp::JitDisable::REGALLOC_GPR, "GPR Regalloc across instructions" },
 	{ MIPSComp::JitDisable::REGALLOC_FPR, "FPR Regalloc across instructions" },
+	{ MIPSComp::JitDisable::IDLE_LOOPS, "Idle loop skipping" },
 };
 
 void JitDebugScreen::CreateViews() {
@@ -1017,6 +1040,19 @@ UI::EventReturn JitCompareScreen::OnShowStats(UI::EventParams &e) {
 	NOTICE_LOG(JIT, "Average Bloat: %0.2f%%", 100 * bcStats.avgBloat);
 	NOTICE_LOG(JIT, "Min Bloat: %0.2f%%  (%08x)", 100 * bcStats.minBloat, bcStats.minBloatBlock);
 	NOTICE_LOG(JIT, "Max Bloat: %0.2f%%  (%08x)", 100 * bcStats.maxBloat, bcStats.maxBloatBlock);
+	if (bcStats.tierThreshold != 0) {
+		NOTICE_LOG(JIT, "Native after %d runs: %d native, %d pending", bcStats.tierThreshold, bcStats.numNativeBlocks, bcStats.numPendingNativeBlocks);
+		NOTICE_LOG(JIT, "Native evictions: %d (%d blocks dropped)", bcStats.numNativeEvictions, bcStats.numEvictedNativeBlocks);
+	}
+	if (bcStats.numTraceBlocks != 0) {
+		NOTICE_LOG(JIT, "Traces: %d", bcStats.numTraceBlocks);
+		for (auto iter : bcStats.traceLengthHistogram)
+			NOTICE_LOG(JIT, "  <= %d instructions: %d", iter.first, iter.second);
+	}
+	// Only the IR based cores fill these in.
+	for (const IRPassStats &pass : IRGetPassStats()) {
+		NOTICE_LOG(JIT, "Pass %s: %d runs, %d changed, %lld -> %lld insts, %0.3f ms", pass.name, (int)pass.runs, (int)pass.changed, (long long)pass.instructionsIn, (long long)pass.instructionsOut, pass.seconds * 1000.0);
+	}
 
 	int ctr = 0, sz = (int)bcStats.bloatMap.size();
 	for (auto iter : bcStats.bloatMap) {
@@ -1201,6 +1237,141 @@ UI::EventReturn ShaderListScreen::OnShaderClick(UI::EventParams &e) {
 	return EVENT_DONE;
 }
 
+void GuestProfilerScreen::CreateViews() {
+	using namespace UI;
+
+	auto di = GetI18NCategory("Dialog");
+	auto dev = GetI18NCategory("Developer");
+
+	LinearLayout *layout = new LinearLayout(ORIENT_VERTICAL);
+	root_ = layout;
+
+	LinearLayout *buttons = layout->Add(new LinearLayout(ORIENT_HORIZONTAL));
+	buttons->Add(new Choice(GuestProfiler::IsActive() ? dev->T("Stop") : dev->T("Start")))->OnClick.Handle(this, &GuestProfilerScreen::OnToggle);
+	buttons->Add(new Choice(dev->T("Refresh")))->OnClick.Handle(this, &GuestProfilerScreen::OnRefresh);
+	buttons->Add(new Choice(di->T("Reset")))->OnClick.Handle(this, &GuestProfilerScreen::OnReset);
+	buttons->Add(new Choice(dev->T("Export")))->OnClick.Handle(this, &GuestProfilerScreen::OnExport);
+
+	int total = GuestProfiler::TotalSamples();
+	layout->Add(new TextView(StringFromFormat("%d samples", total), FLAG_DYNAMIC_ASCII, false));
+
+	TabHolder *tabs = new TabHolder(ORIENT_HORIZONTAL, 40, new LinearLayoutParams(1.0));
+	tabs->SetTag("DevGuestProfiler");
+	layout->Add(tabs);
+	layout->Add(new Button(di->T("Back")))->OnClick.Handle<UIScreen>(this, &UIScreen::OnBack);
+
+	// The lists can get long, and only the top matters.
+	const size_t MAX_ROWS = 200;
+	const float scale = total > 0 ? 100.0f / total : 0.0f;
+
+	ScrollView *funcScroll = new ScrollView(ORIENT_VERTICAL, new LinearLayoutParams(1.0));
+	LinearLayout *funcList = new LinearLayoutList(ORIENT_VERTICAL, new LayoutParams(FILL_PARENT, WRAP_CONTENT));
+	funcList->Add(new TextView("  self   total  address   function", FLAG_DYNAMIC_ASCII, true));
+	std::vector<GuestProfiler::FunctionStats> funcs = GuestProfiler::GetFunctionStats();
+	for (size_t i = 0; i < funcs.size() && i < MAX_ROWS; ++i) {
+		const auto &f = funcs[i];
+		funcList->Add(new TextView(StringFromFormat("%5.1f%%  %5.1f%%  %08x  %s", f.selfSamples * scale, f.totalSamples * scale, f.address, f.name.c_str()), FLAG_DYNAMIC_ASCII, true));
+	}
+	funcScroll->Add(funcList);
+	tabs->AddTab(dev->T("Functions"), funcScroll);
+
+	ScrollView *blockScroll = new ScrollView(ORIENT_VERTICAL, new LinearLayoutParams(1.0));
+	LinearLayout *blockList = new LinearLayoutList(ORIENT_VERTICAL, new LayoutParams(FILL_PARENT, WRAP_CONTENT));
+	std::vector<GuestProfiler::BlockStats> blocks = GuestProfiler::GetBlockStats();
+	for (size_t i = 0; i < blocks.size() && i < MAX_ROWS; ++i) {
+		const auto &b = blocks[i];
+		blockList->Add(new TextView(StringFromFormat("%5.1f%%  %08x", b.samples * scale, b.address), FLAG_DYNAMIC_ASCII, true));
+	}
+	blockScroll->Add(blockList);
+	tabs->AddTab(dev->T("JIT blocks"), blockScroll);
+}
+
+UI::EventReturn GuestProfilerScreen::OnToggle(UI::EventParams &e) {
+	if (GuestProfiler::IsActive())
+		GuestProfiler::Stop();
+	else
+		GuestProfiler::Start();
+	RecreateViews();
+	return UI::EVENT_DONE;
+}
+
+UI::EventReturn GuestProfilerScreen::OnReset(UI::EventParams &e) {
+	GuestProfiler::Reset();
+	RecreateViews();
+	return UI::EVENT_DONE;
+}
+
+UI::EventReturn GuestProfilerScreen::OnRefresh(UI::EventParams &e) {
+	RecreateViews();
+	return UI::EVENT_DONE;
+}
+
+UI::EventReturn GuestProfilerScreen::OnExport(UI::EventParams &e) {
+	auto dev = GetI18NCategory("Developer");
+	Path dumpDir = GetSysDirectory(DIRECTORY_DUMP);
+	File::CreateFullPath(dumpDir);
+	Path filename = dumpDir / (g_paramSFO.GetDiscID() + "_profile.txt");
+	if (GuestProfiler::ExportCollapsedStacks(filename))
+		osm.Show(StringFromFormat("%s: %s", dev->T("Exported"), filename.ToVisualString().c_str()), 3.0f);
+	else
+		osm.Show(dev->T("Export failed"), 3.0f, 0xFF3030FF);
+	return UI::EVENT_DONE;
+}
+
+void MemoryUsageScreen::CreateViews() {
+	using namespace UI;
+
+	auto di = GetI18NCategory("Dialog");
+	auto dev = GetI18NCategory("Developer");
+
+	LinearLayout *layout = new LinearLayout(ORIENT_VERTICAL);
+	root_ = layout;
+
+	LinearLayout *buttons = layout->Add(new LinearLayout(ORIENT_HORIZONTAL));
+	buttons->Add(new Choice(dev->T("Reset peaks")))->OnClick.Handle(this, &MemoryUsageScreen::OnResetPeaks);
+
+	ScrollView *scroll = new ScrollView(ORIENT_VERTICAL, new LinearLayoutParams(1.0));
+	LinearLayout *list = new LinearLayoutList(ORIENT_VERTICAL, new LayoutParams(FILL_PARENT, WRAP_CONTENT));
+	list->Add(new TextView("category                 current        peak      budget", FLAG_DYNAMIC_ASCII, true));
+	rows_.clear();
+	for (int i = 0; i < (int)MemoryCategory::COUNT; ++i) {
+		rows_.push_back(list->Add(new TextView("", FLAG_DYNAMIC_ASCII, true)));
+	}
+	scroll->Add(list);
+	layout->Add(scroll);
+	layout->Add(new Button(di->T("Back")))->OnClick.Handle<UIScreen>(this, &UIScreen::OnBack);
+
+	UpdateRows();
+}
+
+void MemoryUsageScreen::update() {
+	UIDialogScreenWithBackground::update();
+
+	double now = time_now_d();
+	if (now - lastUpdate_ >= 0.5) {
+		UpdateRows();
+	}
+}
+
+void MemoryUsageScreen::UpdateRows() {
+	lastUpdate_ = time_now_d();
+
+	for (int i = 0; i < (int)rows_.size(); ++i) {
+		MemoryCategory cat = (MemoryCategory)i;
+		int64_t budget = MemUsage_GetBudget(cat);
+		std::string budgetText = budget == 0 ? "-" : NiceSizeFormat(budget);
+
+		rows_[i]->SetText(StringFromFormat("%-20s %10s  %10s  %10s", MemUsageCategoryName(cat), NiceSizeFormat(MemUsage_Get(cat)).c_str(), NiceSizeFormat(MemUsage_GetPeak(cat)).c_str(), budgetText.c_str()));
+		rows_[i]->SetTextColor(MemUsage_IsOverBudget(cat) ? 0xFF3030FF : 0xFFFFFFFF);
+	}
+}
+
+UI::EventReturn MemoryUsageScreen::OnResetPeaks(UI::EventParams &e) {
+	MemUsage_ResetPeaks();
+	UpdateRows();
+	return UI::EVENT_DONE;
+}
+
 void ShaderViewScreen::CreateViews() {
 	using namespace UI;
 
@@ -42,6 +42,8 @@ class DevMenuScreen : public PopupScreen {
 	UI::EventReturn OnLogConfig(UI::EventParams &e);
 	UI::EventReturn OnJitCompare(UI::EventParams &e);
 	UI::EventReturn OnShaderView(UI::EventParams &e);
+	UI::EventReturn OnGuestProfiler(UI::EventParams &e);
+	UI::EventReturn OnMemoryUsage(UI::EventParams &e);
 	UI::EventReturn OnFreezeFrame(UI::EventParams &e);
 	UI::EventReturn OnDumpFrame(UI::EventParams &e);
 	UI::EventReturn OnDeveloperTools(UI::EventParams &e);
@@ -188,6 +190,34 @@ class ShaderListScreen : public UIDialogScreenWithBackground {
 	UI::TabHolder *tabs_;
 };
 
+class GuestProfilerScreen : public UIDialogScreenWithBackground {
+public:
+	void CreateViews() override;
+
+	const char *tag() const override { return "GuestProfiler"; }
+
+private:
+	UI::EventReturn OnToggle(UI::EventParams &e);
+	UI::EventReturn OnReset(UI::EventParams &e);
+	UI::EventReturn OnRefresh(UI::EventParams &e);
+	UI::EventReturn OnExport(UI::EventParams &e);
+};
+
+class MemoryUsageScreen : public UIDialogScreenWithBackground {
+public:
+	void CreateViews() override;
+	void update() override;
+
+	const char *tag() const override { return "MemoryUsage"; }
+
+private:
+	void UpdateRows();
+	UI::EventReturn OnResetPeaks(UI::EventParams &e);
+
+	std::vector<UI::TextView *> rows_;
+	double lastUpdate_ = 0.0;
+};
+
 class ShaderViewScreen : public UIDialogScreenWithBackground {
 public:
 	ShaderViewScreen(std::string id, DebugShaderType type)
@@ -66,6 +66,7 @@ using namespace std::placeholders;
 #include "GPU/Vulkan/DebugVisVulkan.h"
 #endif
 #include "Core/HLE/sceCtrl.h"
+#include "Core/HLE/sceDisplay.h"
 #include "Core/HLE/sceSas.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/SaveState.h"
@@ -1136,6 +1137,7 @@ static const char *CPUCoreAsString(int core) {
 	case 0: return "Interpreter";
 	case 1: return "JIT";
 	case 2: return "IR Interpreter";
+	case 3: return "JIT using IR";
 	default: return "N/A";
 	}
 }
@@ -1325,13 +1327,48 @@ static void DrawFrameTimes(UIContext *ctx, const Bounds &bounds) {
 	int scale = 7000;
 	int width = 600;
 
+	// Emulated CPU is whatever remains unattributed, drawn first.
+	static const struct {
+		FrameTimeCategory cat;
+		const char *name;
+		uint32_t color;
+	} categories[] = {
+		{ FrameTimeCategory::HLE, "HLE", 0xFF3FFFFF },
+		{ FrameTimeCategory::GE, "GE", 0xFF3F9FFF },
+		{ FrameTimeCategory::FLUSH, "Flush", 0xFFFFFF3F },
+		{ FrameTimeCategory::TEXTURE, "Texture", 0xFFFF3FFF },
+		{ FrameTimeCategory::PRESENT, "Present", 0xFFFF7F3F },
+	};
+	const uint32_t cpuColor = 0xFF3FFF3F;
+	const uint32_t sleepColor = 0x7F3FFF3F;
+	double *breakdown[ARRAY_SIZE(categories)];
+	double totals[ARRAY_SIZE(categories)]{};
+	double cpuTotal = 0.0;
+	double sleepTotal = 0.0;
+	for (size_t c = 0; c < ARRAY_SIZE(categories); ++c)
+		breakdown[c] = __DisplayGetFrameBreakdown(categories[c].cat);
+
 	ctx->Flush();
 	ctx->BeginNoTex();
 	int bottom = bounds.y2();
 	for (int i = 0; i < valid; ++i) {
 		double activeTime = history[i] - sleepHistory[i];
-		ctx->Draw()->vLine(bounds.x + i, bottom, bottom - activeTime * scale, 0xFF3FFF3F);
-		ctx->Draw()->vLine(bounds.x + i, bottom - activeTime * scale, bottom - history[i] * scale, 0x7F3FFF3F);
+		double attributed = 0.0;
+		for (size_t c = 0; c < ARRAY_SIZE(categories); ++c)
+			attributed += breakdown[c][i];
+		double cpuTime = std::max(0.0, activeTime - attributed);
+
+		double y = bottom;
+		ctx->Draw()->vLine(bounds.x + i, y, y - cpuTime * scale, cpuColor);
+		y -= cpuTime * scale;
+		for (size_t c = 0; c < ARRAY_SIZE(categories); ++c) {
+			ctx->Draw()->vLine(bounds.x + i, y, y - breakdown[c][i] * scale, categories[c].color);
+			y -= breakdown[c][i] * scale;
+			totals[c] += breakdown[c][i];
+		}
+		ctx->Draw()->vLine(bounds.x + i, y, bottom - history[i] * scale, sleepColor);
+		cpuTotal += cpuTime;
+		sleepTotal += sleepHistory[i];
 	}
 	ctx->Draw()->vLine(bounds.x + pos, bottom, bottom - 512, 0xFFff3F3f);
 
@@ -1344,6 +1381,56 @@ static void DrawFrameTimes(UIContext *ctx, const Bounds &bounds) {
 	ctx->Draw()->SetFontScale(0.5f, 0.5f);
 	ctx->Draw()->DrawText(ubuntu24, "33.3ms", bounds.x + width, bottom - 0.0333 * scale, 0xFF3f3Fff, ALIGN_BOTTOMLEFT | FLAG_DYNAMIC_ASCII);
 	ctx->Draw()->DrawText(ubuntu24, "16.7ms", bounds.x + width, bottom - 0.0167 * scale, 0xFF3f3Fff, ALIGN_BOTTOMLEFT | FLAG_DYNAMIC_ASCII);
+
+	if (valid > 0) {
+		// Legend with average per-frame time in each category.
+		char temp[128];
+		float legendX = bounds.x + width + 60;
+		float legendY = bottom - 0.0333 * scale - 140;
+		auto legendLine = [&](const char *name, double total, uint32_t color) {
+			snprintf(temp, sizeof(temp), "%s: %0.2fms", name, total * 1000.0 / valid);
+			ctx->Draw()->DrawText(ubuntu24, temp, legendX, legendY, color, FLAG_DYNAMIC_ASCII);
+			legendY += 14;
+		};
+		legendLine("CPU", cpuTotal, cpuColor);
+		for (size_t c = 0; c < ARRAY_SIZE(categories); ++c)
+			legendLine(categories[c].name, totals[c], categories[c].color);
+		legendLine("Wait", sleepTotal, sleepColor);
+
+		FrameTimeStats stats;
+		__DisplayGetFrameTimeStats(&stats);
+		if (stats.frames > 0) {
+			legendY += 6;
+			snprintf(temp, sizeof(temp), "Avg: %0.2fms (%0.1f fps)", stats.averageMs, 1000.0 / stats.averageMs);
+			ctx->Draw()->DrawText(ubuntu24, temp, legendX, legendY, 0xFFFFFFFF, FLAG_DYNAMIC_ASCII);
+			legendY += 14;
+			snprintf(temp, sizeof(temp), "1%% low: %0.2fms (%0.1f fps)", stats.slowestPercentMs, 1000.0 / stats.slowestPercentMs);
+			ctx->Draw()->DrawText(ubuntu24, temp, legendX, legendY, 0xFFFFFFFF, FLAG_DYNAMIC_ASCII);
+			legendY += 14;
+			snprintf(temp, sizeof(temp), "Worst: %0.2fms", stats.worstMs);
+			ctx->Draw()->DrawText(ubuntu24, temp, legendX, legendY, 0xFFFFFFFF, FLAG_DYNAMIC_ASCII);
+			legendY += 14;
+
+			// Rough input-to-screen time: the frame reads input when it starts emulating.
+			double emulationMs, flipWaitMs;
+			__DisplayGetLatencyEstimate(&emulationMs, &flipWaitMs);
+			float presentMs = ctx->GetDrawContext()->GetPresentLatencyMs();
+			if (presentMs >= 0.0f) {
+				snprintf(temp, sizeof(temp), "Latency: ~%0.1fms (emu %0.1f + wait %0.1f + present %0.1f)", emulationMs + flipWaitMs + presentMs, emulationMs, flipWaitMs, presentMs);
+			} else {
+				snprintf(temp, sizeof(temp), "Latency: >%0.1fms (emu %0.1f + wait %0.1f + present ?)", emulationMs + flipWaitMs, emulationMs, flipWaitMs);
+			}
+			ctx->Draw()->DrawText(ubuntu24, temp, legendX, legendY, 0xFFFFFFFF, FLAG_DYNAMIC_ASCII);
+			legendY += 20;
+
+			static const char *const bucketNames[] = { "<16.7", "<20", "<25", "<33.3", "<50", "<100", ">100" };
+			for (size_t b = 0; b < ARRAY_SIZE(bucketNames); ++b) {
+				snprintf(temp, sizeof(temp), "%s ms: %d", bucketNames[b], stats.histogram[b]);
+				ctx->Draw()->DrawText(ubuntu24, temp, legendX, legendY, 0xFFC0C0C0, FLAG_DYNAMIC_ASCII);
+				legendY += 14;
+			}
+		}
+	}
 	ctx->Draw()->SetFontScale(1.0f, 1.0f);
 	ctx->Flush();
 	ctx->RebindTexture();
@@ -21,12 +21,16 @@
 #include <map>
 #include <memory>
 #include <algorithm>
+#include <set>
 
 #include "Common/GPU/thin3d.h"
 #include "Common/Thread/ThreadManager.h"
 #include "Common/File/VFS/VFS.h"
 #include "Common/File/FileUtil.h"
 #include "Common/File/Path.h"
+#include "Common/File/DirListing.h"
+#include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
 #include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Common/Render/ManagedTexture.h"
@@ -39,6 +43,7 @@
 #include "Core/Loaders.h"
 #include "Core/Util/GameManager.h"
 #include "Core/Config.h"
+#include "Core/Reporting.h"
 #include "UI/GameInfoCache.h"
 
 GameInfoCache *g_gameInfoCache;
@@ -327,11 +332,177 @@ static bool ReadVFSToString(const char *filename, std::string *contents, std::mu
 	return data != nullptr;
 }
 
+// Used when the game doesn't have an ICON0.PNG of its own.
+static void ReadFallbackIcon(GameInfo *info) {
+	Path screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info->id + "_00000.jpg");
+	Path screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info->id + "_00000.png");
+	// Try using png/jpg screenshots first
+	if (File::Exists(screenshot_png)) {
+		File::ReadFileToString(false, screenshot_png, info->icon.data);
+	} else if (File::Exists(screenshot_jpg)) {
+		File::ReadFileToString(false, screenshot_jpg, info->icon.data);
+	} else {
+		// Read standard icon
+		VERBOSE_LOG(LOADER, "Loading unknown.png because no icon was found");
+		ReadVFSToString("unknown.png", &info->icon.data, &info->lock);
+	}
+}
+
+bool GameInfoDatabase::GetKey(const Path &path, u64 *fileSize, u64 *mtime) {
+	if (path.Type() != PathType::NATIVE && path.Type() != PathType::CONTENT_URI)
+		return false;
+
+	File::FileInfo info;
+	if (!File::GetFileInfo(path, &info) || !info.exists)
+		return false;
+	if (info.isDirectory) {
+		// For PBP directories, the EBOOT is what changes. Other directories aren't worth it.
+		Path ebootPath = ResolvePBPFile(path);
+		if (ebootPath == path || !File::GetFileInfo(ebootPath, &info) || !info.exists || info.isDirectory)
+			return false;
+	}
+	*fileSize = info.size;
+	*mtime = info.mtime;
+	return true;
+}
+
+bool GameInfoDatabase::Lookup(const Path &path, u64 fileSize, u64 mtime, Entry *entry) {
+	std::lock_guard<std::mutex> guard(lock_);
+	auto it = entries_.find(path.ToString());
+	if (it == entries_.end() || it->second.fileSize != fileSize || it->second.mtime != mtime)
+		return false;
+	*entry = it->second;
+	return true;
+}
+
+bool GameInfoDatabase::IsFresh(const Path &path) {
+	u64 fileSize, mtime;
+	if (!GetKey(path, &fileSize, &mtime))
+		return true;  // Can't cache it, so nothing to refresh.
+	std::lock_guard<std::mutex> guard(lock_);
+	auto it = entries_.find(path.ToString());
+	return it != entries_.end() && it->second.fileSize == fileSize && it->second.mtime == mtime;
+}
+
+void GameInfoDatabase::Store(const Path &path, Entry &&entry) {
+	std::lock_guard<std::mutex> guard(lock_);
+	Entry &dest = entries_[path.ToString()];
+	// Keep a CRC we already have for the same file.
+	if (!entry.hasCRC && dest.hasCRC && dest.fileSize == entry.fileSize && dest.mtime == entry.mtime) {
+		entry.hasCRC = true;
+		entry.crc = dest.crc;
+	}
+	dest = std::move(entry);
+	dirty_ = true;
+}
+
+void GameInfoDatabase::SetCRC(const Path &path, u32 crc) {
+	u64 fileSize, mtime;
+	if (!GetKey(path, &fileSize, &mtime))
+		return;
+	std::lock_guard<std::mutex> guard(lock_);
+	auto it = entries_.find(path.ToString());
+	if (it == entries_.end() || it->second.fileSize != fileSize || it->second.mtime != mtime)
+		return;
+	if (!it->second.hasCRC || it->second.crc != crc) {
+		it->second.hasCRC = true;
+		it->second.crc = crc;
+		dirty_ = true;
+	}
+}
+
+void GameInfoDatabase::Prune(const Path &dir, const std::vector<Path> &present) {
+	std::set<std::string> keep;
+	for (const Path &path : present)
+		keep.insert(path.ToString());
+
+	std::lock_guard<std::mutex> guard(lock_);
+	for (auto it = entries_.begin(); it != entries_.end(); ) {
+		if (!keep.count(it->first) && Path(it->first).NavigateUp() == dir) {
+			it = entries_.erase(it);
+			dirty_ = true;
+		} else {
+			++it;
+		}
+	}
+}
+
+void GameInfoDatabase::Load(const Path &filename) {
+	if (!File::Exists(filename))
+		return;
+
+	std::lock_guard<std::mutex> guard(lock_);
+	std::string gitVersion;
+	std::string errorString;
+	if (CChunkFileReader::Load(filename, &gitVersion, *this, &errorString) != CChunkFileReader::ERROR_NONE) {
+		WARN_LOG(LOADER, "Discarding game info database: %s", errorString.c_str());
+		entries_.clear();
+	}
+	dirty_ = false;
+}
+
+void GameInfoDatabase::SaveIfDirty(const Path &filename) {
+	std::lock_guard<std::mutex> guard(lock_);
+	if (!dirty_)
+		return;
+
+	File::CreateFullPath(filename.NavigateUp());
+	if (CChunkFileReader::Save(filename, "GameInfoDatabase", PPSSPP_GIT_VERSION, *this) == CChunkFileReader::ERROR_NONE) {
+		dirty_ = false;
+	} else {
+		ERROR_LOG(LOADER, "Failed to save game info database to %s", filename.c_str());
+	}
+}
+
+static void DoEntry(PointerWrap &p, int version, std::string &path, GameInfoDatabase::Entry &e) {
+	Do(p, path);
+	Do(p, e.fileSize);
+	Do(p, e.mtime);
+	Do(p, e.fileType);
+	Do(p, e.paramSFO);
+	Do(p, e.title);
+	Do(p, e.id);
+	Do(p, e.id_version);
+	Do(p, e.disc_total);
+	Do(p, e.disc_number);
+	Do(p, e.region);
+	Do(p, e.icon);
+	Do(p, e.gameSize);
+	if (version >= 2) {
+		Do(p, e.hasCRC);
+		Do(p, e.crc);
+	}
+}
+
+// Caller holds lock_.
+void GameInfoDatabase::DoState(PointerWrap &p) {
+	auto s = p.Section("GameInfoDatabase", 1, 2);
+	if (!s)
+		return;
+
+	int count = (int)entries_.size();
+	Do(p, count);
+	if (p.mode == PointerWrap::MODE_READ) {
+		entries_.clear();
+		for (int i = 0; i < count && p.error != PointerWrap::ERROR_FAILURE; i++) {
+			std::string path;
+			Entry entry;
+			DoEntry(p, s.Version(), path, entry);
+			entries_[path] = std::move(entry);
+		}
+	} else {
+		for (auto &it : entries_) {
+			std::string path = it.first;
+			DoEntry(p, s.Version(), path, it.second);
+		}
+	}
+}
+
 
 class GameInfoWorkItem : public Task {
 public:
-	GameInfoWorkItem(const Path &gamePath, std::shared_ptr<GameInfo> &info)
-		: gamePath_(gamePath), info_(info) {
+	GameInfoWorkItem(const Path &gamePath, std::shared_ptr<GameInfo> &info, std::shared_ptr<GameInfoDatabase> db)
+		: gamePath_(gamePath), info_(info), db_(db) {
 	}
 
 	~GameInfoWorkItem() {
@@ -364,6 +535,18 @@ class GameInfoWorkItem : public Task {
 			return;
 		}
 
+		u64 fileSize = 0;
+		u64 mtime = 0;
+		bool cacheable = db_ && GameInfoDatabase::GetKey(gamePath_, &fileSize, &mtime);
+		// The database doesn't keep backgrounds or sounds, those still need the file.
+		if (cacheable && (info_->wantFlags & (GAMEINFO_WANTBG | GAMEINFO_WANTSND)) == 0) {
+			GameInfoDatabase::Entry entry;
+			if (db_->Lookup(gamePath_, fileSize, mtime, &entry)) {
+				ApplyEntry(entry);
+				return;
+			}
+		}
+
 		// In case of a remote file, check if it actually exists before locking.
 		if (!info_->GetFileLoader()->Exists()) {
 			return;
@@ -398,6 +581,7 @@ class GameInfoWorkItem : public Task {
 				std::vector<u8> sfoData;
 				if (pbp.GetSubFile(PBP_PARAM_SFO, &sfoData)) {
 					std::lock_guard<std::mutex> lock(info_->lock);
+					rawSFO_.assign((const char *)sfoData.data(), sfoData.size());
 					info_->paramSFO.ReadSFO(sfoData);
 					info_->ParseParamSFO();
 
@@ -415,17 +599,9 @@ class GameInfoWorkItem : public Task {
 				if (pbp.GetSubFileSize(PBP_ICON0_PNG) > 0) {
 					std::lock_guard<std::mutex> lock(info_->lock);
 					pbp.GetSubFileAsString(PBP_ICON0_PNG, &info_->icon.data);
+					ownIcon_ = true;
 				} else {
-					Path screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.jpg");
-					Path screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.png");
-					// Try using png/jpg screenshots first
-					if (File::Exists(screenshot_png))
-						File::ReadFileToString(false, screenshot_png, info_->icon.data);
-					else if (File::Exists(screenshot_jpg))
-						File::ReadFileToString(false, screenshot_jpg, info_->icon.data);
-					else
-						// Read standard icon
-						ReadVFSToString("unknown.png", &info_->icon.data, &info_->lock);
+					ReadFallbackIcon(info_.get());
 				}
 				info_->icon.dataLoaded = true;
 
@@ -462,21 +638,8 @@ class GameInfoWorkItem : public Task {
 
 				info_->paramSFOLoaded = true;
 			}
-			{
-				Path screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.jpg");
-				Path screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.png");
-				// Try using png/jpg screenshots first
-				if (File::Exists(screenshot_png)) {
-					File::ReadFileToString(false, screenshot_png, info_->icon.data);
-				} else if (File::Exists(screenshot_jpg)) {
-					File::ReadFileToString(false, screenshot_jpg, info_->icon.data);
-				} else {
-					// Read standard icon
-					VERBOSE_LOG(LOADER, "Loading unknown.png because there was an ELF");
-					ReadVFSToString("unknown.png", &info_->icon.data, &info_->lock);
-				}
-				info_->icon.dataLoaded = true;
-			}
+			ReadFallbackIcon(info_.get());
+			info_->icon.dataLoaded = true;
 			break;
 
 		case IdentifiedFileType::PSP_SAVEDATA_DIRECTORY:
@@ -586,6 +749,7 @@ class GameInfoWorkItem : public Task {
 				std::string paramSFOcontents;
 				if (ReadFileToString(&umd, "/PSP_GAME/PARAM.SFO", &paramSFOcontents, nullptr)) {
 					std::lock_guard<std::mutex> lock(info_->lock);
+					rawSFO_ = paramSFOcontents;
 					info_->paramSFO.ReadSFO((const u8 *)paramSFOcontents.data(), paramSFOcontents.size());
 					info_->ParseParamSFO();
 
@@ -602,18 +766,10 @@ class GameInfoWorkItem : public Task {
 				}
 
 				// Fall back to unknown icon if ISO is broken/is a homebrew ISO, override is allowed though
-				if (!ReadFileToString(&umd, "/PSP_GAME/ICON0.PNG", &info_->icon.data, &info_->lock)) {
-					Path screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.jpg");
-					Path screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.png");
-					// Try using png/jpg screenshots first
-					if (File::Exists(screenshot_png))
-						File::ReadFileToString(false, screenshot_png, info_->icon.data);
-					else if (File::Exists(screenshot_jpg))
-						File::ReadFileToString(false, screenshot_jpg, info_->icon.data);
-					else {
-						DEBUG_LOG(LOADER, "Loading unknown.png because no icon was found");
-						ReadVFSToString("unknown.png", &info_->icon.data, &info_->lock);
-					}
+				if (ReadFileToString(&umd, "/PSP_GAME/ICON0.PNG", &info_->icon.data, &info_->lock)) {
+					ownIcon_ = true;
+				} else {
+					ReadFallbackIcon(info_.get());
 				}
 				info_->icon.dataLoaded = true;
 				break;
@@ -658,15 +814,121 @@ class GameInfoWorkItem : public Task {
 			info_->installDataSize = info_->GetInstallDataSizeInBytes();
 		}
 
+		if (cacheable && info_->paramSFOLoaded) {
+			switch (info_->fileType) {
+			case IdentifiedFileType::PSP_PBP:
+			case IdentifiedFileType::PSP_PBP_DIRECTORY:
+			case IdentifiedFileType::PSP_ISO:
+			case IdentifiedFileType::PSP_ELF:
+				StoreEntry(fileSize, mtime);
+				break;
+			default:
+				break;
+			}
+		}
+
 		// INFO_LOG(SYSTEM, "Completed writing info for %s", info_->GetTitle().c_str());
 	}
 
 private:
+	void ApplyEntry(const GameInfoDatabase::Entry &entry) {
+		info_->SetTitle(entry.title);
+		{
+			std::lock_guard<std::mutex> lock(info_->lock);
+			info_->fileType = (IdentifiedFileType)entry.fileType;
+			if (!entry.paramSFO.empty())
+				info_->paramSFO.ReadSFO((const u8 *)entry.paramSFO.data(), entry.paramSFO.size());
+			info_->id = entry.id;
+			info_->id_version = entry.id_version;
+			info_->disc_total = entry.disc_total;
+			info_->disc_number = entry.disc_number;
+			info_->region = entry.region;
+			info_->paramSFOLoaded = true;
+			info_->icon.data = entry.icon;
+		}
+		if (entry.hasCRC)
+			Reporting::SetKnownCRC(gamePath_, entry.crc);
+		// Screenshots may have appeared since, so fallbacks aren't stored.
+		if (entry.icon.empty())
+			ReadFallbackIcon(info_.get());
+		info_->icon.dataLoaded = true;
+
+		info_->hasConfig = g_Config.hasGameConfig(info_->id);
+
+		if (info_->wantFlags & GAMEINFO_WANTSIZE) {
+			std::lock_guard<std::mutex> lock(info_->lock);
+			info_->gameSize = entry.gameSize != 0 ? entry.gameSize : info_->GetGameSizeInBytes();
+			info_->saveDataSize = info_->GetSaveDataSizeInBytes();
+			info_->installDataSize = info_->GetInstallDataSizeInBytes();
+		}
+	}
+
+	void StoreEntry(u64 fileSize, u64 mtime) {
+		GameInfoDatabase::Entry entry;
+		entry.fileSize = fileSize;
+		entry.mtime = mtime;
+		entry.title = info_->GetTitle();
+		{
+			std::lock_guard<std::mutex> lock(info_->lock);
+			entry.fileType = (int)info_->fileType;
+			entry.paramSFO = rawSFO_;
+			entry.id = info_->id;
+			entry.id_version = info_->id_version;
+			entry.disc_total = info_->disc_total;
+			entry.disc_number = info_->disc_number;
+			entry.region = info_->region;
+			if (ownIcon_)
+				entry.icon = info_->icon.data;
+			entry.gameSize = info_->gameSize;
+		}
+		db_->Store(gamePath_, std::move(entry));
+	}
+
 	Path gamePath_;
 	std::shared_ptr<GameInfo> info_;
+	std::shared_ptr<GameInfoDatabase> db_;
+	std::string rawSFO_;
+	bool ownIcon_ = false;
 	DISALLOW_COPY_AND_ASSIGN(GameInfoWorkItem);
 };
 
+// Fills in database entries for a batch of paths, without keeping the GameInfo around.
+class GameInfoScanTask : public Task {
+public:
+	GameInfoScanTask(std::vector<Path> &&paths, std::shared_ptr<GameInfoDatabase> db)
+		: paths_(std::move(paths)), db_(db) {
+	}
+
+	TaskType Type() const override {
+		return TaskType::IO_BLOCKING;
+	}
+
+	TaskPriority Priority() const override {
+		// Behind whatever the UI is actually showing.
+		return TaskPriority::LOW;
+	}
+
+	void Run() override {
+		for (const Path &path : paths_) {
+			if (db_->scanCancelled)
+				break;
+			if (db_->IsFresh(path))
+				continue;
+			auto info = std::make_shared<GameInfo>();
+			GameInfoWorkItem item(path, info, db_);
+			item.Run();
+		}
+	}
+
+private:
+	std::vector<Path> paths_;
+	std::shared_ptr<GameInfoDatabase> db_;
+};
+
+static Path GameInfoDatabasePath() {
+	return GetSysDirectory(DIRECTORY_APP_CACHE) / "gameinfo.ppdb";
+}
+
 GameInfoCache::GameInfoCache() {
 	Init();
 }
@@ -676,10 +938,14 @@ GameInfoCache::~GameInfoCache() {
 	Shutdown();
 }
 
-void GameInfoCache::Init() {}
+void GameInfoCache::Init() {
+	db_ = std::make_shared<GameInfoDatabase>();
+	db_->Load(GameInfoDatabasePath());
+}
 
 void GameInfoCache::Shutdown() {
 	CancelAll();
+	db_->SaveIfDirty(GameInfoDatabasePath());
 }
 
 void GameInfoCache::Clear() {
@@ -689,6 +955,7 @@ void GameInfoCache::Clear() {
 }
 
 void GameInfoCache::CancelAll() {
+	db_->scanCancelled = true;
 	for (auto info : info_) {
 		// GetFileLoader will create one if there isn't one already.
 		// Avoid that by checking.
@@ -730,6 +997,22 @@ void GameInfoCache::WaitUntilDone(std::shared_ptr<GameInfo> &info) {
 	info->readyEvent.Wait();
 }
 
+void GameInfoCache::StoreCRC(const Path &gamePath, u32 crc) {
+	db_->SetCRC(gamePath, crc);
+}
+
+void GameInfoCache::ScanInBackground(const Path &dir, const std::vector<Path> &paths) {
+	static const size_t SCAN_BATCH_SIZE = 16;
+
+	db_->scanCancelled = false;
+	db_->Prune(dir, paths);
+	for (size_t i = 0; i < paths.size(); i += SCAN_BATCH_SIZE) {
+		size_t end = std::min(paths.size(), i + SCAN_BATCH_SIZE);
+		std::vector<Path> batch(paths.begin() + i, paths.begin() + end);
+		g_threadManager.EnqueueTask(new GameInfoScanTask(std::move(batch), db_));
+	}
+}
+
 // Runs on the main thread. Only call from render() and similar, not update()!
 // Can also be called from the audio thread for menu background music.
 std::shared_ptr<GameInfo> GameInfoCache::GetInfo(Draw::DrawContext *draw, const Path &gamePath, int wantFlags) {
@@ -774,7 +1057,7 @@ std::shared_ptr<GameInfo> GameInfoCache::GetInfo(Draw::DrawContext *draw, const
 		info->pending = true;
 	}
 
-	GameInfoWorkItem *item = new GameInfoWorkItem(gamePath, info);
+	GameInfoWorkItem *item = new GameInfoWorkItem(gamePath, info, db_);
 	g_threadManager.EnqueueTask(item);
 
 	// Don't re-insert if we already have it.
@@ -19,6 +19,8 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include <memory>
 #include <mutex>
 #include <atomic>
@@ -59,6 +61,7 @@ enum GameInfoWantFlags {
 };
 
 class FileLoader;
+class PointerWrap;
 enum class IdentifiedFileType;
 
 struct GameInfoTex {
@@ -162,6 +165,53 @@ class GameInfo {
 	DISALLOW_COPY_AND_ASSIGN(GameInfo);
 };
 
+// Persistent store of the cheap-to-show parts of GameInfo (title, IDs, icon, size), keyed by
+// path and validated against the file's size and mtime. Lets the game browser show a large
+// library without opening every file again on each start.
+class GameInfoDatabase {
+public:
+	struct Entry {
+		u64 fileSize = 0;
+		u64 mtime = 0;
+		int fileType = 0;
+		std::string paramSFO;  // Raw PARAM.SFO, may be empty (ELF.)
+		std::string title;
+		std::string id;
+		std::string id_version;
+		int disc_total = 0;
+		int disc_number = 0;
+		int region = -1;
+		std::string icon;  // Raw icon file data. Empty means use the usual fallbacks.
+		u64 gameSize = 0;
+		bool hasCRC = false;
+		u32 crc = 0;
+	};
+
+	// Gets the size and mtime to validate entries with. False if the path can't be cached.
+	static bool GetKey(const Path &path, u64 *fileSize, u64 *mtime);
+
+	// Returns false if there's no entry or it doesn't match fileSize/mtime.
+	bool Lookup(const Path &path, u64 fileSize, u64 mtime, Entry *entry);
+	bool IsFresh(const Path &path);
+	void Store(const Path &path, Entry &&entry);
+	// Only sticks if there's a current entry for the path.
+	void SetCRC(const Path &path, u32 crc);
+	// Drops entries directly inside dir that aren't in present.
+	void Prune(const Path &dir, const std::vector<Path> &present);
+
+	void Load(const Path &filename);
+	void SaveIfDirty(const Path &filename);
+	void DoState(PointerWrap &p);
+
+	// Checked by background scan tasks so they can bail out on shutdown.
+	std::atomic<bool> scanCancelled{};
+
+private:
+	std::mutex lock_;
+	std::unordered_map<std::string, Entry> entries_;
+	bool dirty_ = false;
+};
+
 class GameInfoCache {
 public:
 	GameInfoCache();
@@ -181,6 +231,12 @@ class GameInfoCache {
 	void CancelAll();
 	void WaitUntilDone(std::shared_ptr<GameInfo> &info);
 
+	// Refreshes database entries for a directory listing on background threads, so the
+	// GameInfo for each of them can later be filled in without touching the files.
+	void ScanInBackground(const Path &dir, const std::vector<Path> &paths);
+	// Remembers a disc CRC (see Reporting) across runs.
+	void StoreCRC(const Path &gamePath, u32 crc);
+
 private:
 	void Init();
 	void Shutdown();
@@ -189,6 +245,8 @@ class GameInfoCache {
 	// Maps ISO path to info. Need to use shared_ptr as we can return these pointers - 
 	// and if they get destructed while being in use, that's bad.
 	std::map<std::string, std::shared_ptr<GameInfo> > info_;
+	// Shared with work items, which may outlive the cache during shutdown.
+	std::shared_ptr<GameInfoDatabase> db_;
 };
 
 // This one can be global, no good reason not to.
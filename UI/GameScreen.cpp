@@ -72,6 +72,7 @@ void GameScreen::update() {
 		// Wait until the CRC32 is ready.  It might take time on some devices.
 		if (Reporting::HasCRC(gamePath_)) {
 			uint32_t crcvalue = Reporting::RetrieveCRC(gamePath_);
+			g_gameInfoCache->StoreCRC(gamePath_, crcvalue);
 			CRC32string = int2hexstr(crcvalue);
 			tvCRC_->SetVisibility(UI::V_VISIBLE);
 			tvCRC_->SetText(CRC32string);
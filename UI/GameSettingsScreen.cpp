@@ -37,6 +37,7 @@
 #include "Common/Math/curves.h"
 #include "Common/Data/Text/I18n.h"
 #include "Common/Data/Encoding/Utf8.h"
+#include "Common/LogManager.h"
 #include "UI/EmuScreen.h"
 #include "UI/GameSettingsScreen.h"
 #include "UI/GameInfoCache.h"
@@ -345,6 +346,15 @@ void GameSettingsScreen::CreateGraphicsSettings(UI::ViewGroup *graphicsSettings)
 		return !g_Config.bSoftwareRendering && !g_Config.bSkipBufferEffects;
 	});
 
+	// Needs GPU timestamps, which we only measure on Vulkan for now.
+	if (GetGPUBackend() == GPUBackend::VULKAN) {
+		CheckBox *dynamicResolution = graphicsSettings->Add(new CheckBox(&g_Config.bDynamicResolution, gr->T("Dynamic resolution")));
+		dynamicResolution->OnClick.Handle(this, &GameSettingsScreen::OnResolutionChange);
+		dynamicResolution->SetEnabledFunc([] {
+			return !g_Config.bSoftwareRendering && !g_Config.bSkipBufferEffects;
+		});
+	}
+
 	int deviceType = System_GetPropertyInt(SYSPROP_DEVICE_TYPE);
 
 	if (deviceType != DEVICE_TYPE_VR) {
@@ -387,6 +397,12 @@ void GameSettingsScreen::CreateGraphicsSettings(UI::ViewGroup *graphicsSettings)
 			NativeResized();
 			return UI::EVENT_CONTINUE;
 		});
+		CheckBox *lowLatency = graphicsSettings->Add(new CheckBox(&g_Config.bLowLatencyPresent, gr->T("Low latency mode")));
+		lowLatency->OnClick.Add([=](EventParams &e) {
+			// Recreates the swapchain, which picks the present mode.
+			NativeResized();
+			return UI::EVENT_CONTINUE;
+		});
 #endif
 
 #if PPSSPP_PLATFORM(ANDROID)
@@ -452,6 +468,24 @@ void GameSettingsScreen::CreateGraphicsSettings(UI::ViewGroup *graphicsSettings)
 		return !g_Config.bSoftwareRendering && g_Config.bHardwareTransform && g_Config.iGPUBackend != (int)GPUBackend::OPENGL;
 	});
 
+	CheckBox *cullDraws = graphicsSettings->Add(new CheckBox(&g_Config.bCullOffscreenDraws, gr->T("Cull offscreen draws")));
+	cullDraws->OnClick.Add([=](EventParams &e) {
+		settingInfo_->Show(gr->T("CullOffscreenDraws Tip", "Skips geometry that is fully outside the screen before decoding it. May rarely cause missing objects"), e.v);
+		return UI::EVENT_CONTINUE;
+	});
+	cullDraws->SetEnabledFunc([] {
+		return !g_Config.bSoftwareRendering && g_Config.bHardwareTransform;
+	});
+
+	CheckBox *skipStaticLists = graphicsSettings->Add(new CheckBox(&g_Config.bSkipStaticDisplayLists, gr->T("Skip unchanged display lists")));
+	skipStaticLists->OnClick.Add([=](EventParams &e) {
+		settingInfo_->Show(gr->T("SkipStaticDisplayLists Tip", "Doesn't redraw display lists that would draw exactly the same thing again, like static menus. Only works in some games, and may cause glitches"), e.v);
+		return UI::EVENT_CONTINUE;
+	});
+	skipStaticLists->SetEnabledFunc([] {
+		return !g_Config.bSoftwareRendering;
+	});
+
 	CheckBox *texBackoff = graphicsSettings->Add(new CheckBox(&g_Config.bTextureBackoffCache, gr->T("Lazy texture caching", "Lazy texture caching (speedup)")));
 	texBackoff->SetDisabledPtr(&g_Config.bSoftwareRendering);
 	texBackoff->OnClick.Add([=](EventParams& e) {
@@ -484,6 +518,13 @@ void GameSettingsScreen::CreateGraphicsSettings(UI::ViewGroup *graphicsSettings)
 		inflightChoice->OnChoice.Handle(this, &GameSettingsScreen::OnInflightFramesChoice);
 	}
 
+	if (GetGPUBackend() == GPUBackend::VULKAN) {
+		CheckBox *adaptiveInflight = graphicsSettings->Add(new CheckBox(&g_Config.bAdaptiveInflightFrames, gr->T("Reduce buffering when GPU keeps up")));
+		adaptiveInflight->SetEnabledFunc([] {
+			return g_Config.iInflightFrames > 1;
+		});
+	}
+
 	if (GetGPUBackend() == GPUBackend::VULKAN) {
 		const bool usable = !draw->GetBugs().Has(Draw::Bugs::GEOMETRY_SHADERS_SLOW_OR_BROKEN);
 		const bool vertexSupported = draw->GetDeviceCaps().clipDistanceSupported && draw->GetDeviceCaps().cullDistanceSupported;
@@ -657,6 +698,10 @@ void GameSettingsScreen::CreateAudioSettings(UI::ViewGroup *audioSettings) {
 		audioSettings->Add(new CheckBox(&g_Config.bAutoAudioDevice, a->T("Use new audio devices automatically")));
 	}
 
+	static const char *resamplers[] = { "Linear", "Windowed sinc" };
+	PopupMultiChoice *resampler = audioSettings->Add(new PopupMultiChoice(&g_Config.iAudioResampler, a->T("Resampler"), resamplers, 0, ARRAY_SIZE(resamplers), a->GetName(), screenManager()));
+	resampler->SetEnabledPtr(&g_Config.bEnableSound);
+
 #if PPSSPP_PLATFORM(ANDROID)
 	CheckBox *extraAudio = audioSettings->Add(new CheckBox(&g_Config.bExtraAudioBuffering, a->T("AudioBufferingForBluetooth", "Bluetooth-friendly buffer (slower)")));
 	extraAudio->SetEnabledPtr(&g_Config.bEnableSound);
@@ -1033,6 +1078,8 @@ void GameSettingsScreen::CreateSystemSettings(UI::ViewGroup *systemSettings) {
 	systemSettings->Add(new CheckBox(&g_Config.bMemStickInserted, sy->T("Memory Stick inserted")));
 	UI::PopupSliderChoice *sizeChoice = systemSettings->Add(new PopupSliderChoice(&g_Config.iMemStickSizeGB, 1, 32, sy->T("Memory Stick size", "Memory Stick size"), screenManager(), "GB"));
 	sizeChoice->SetFormat("%d GB");
+	CheckBox *writeBack = systemSettings->Add(new CheckBox(&g_Config.bMemStickWriteBack, sy->T("Memory Stick write-back cache")));
+	writeBack->SetEnabled(!PSP_IsInited());
 
 	systemSettings->Add(new ItemHeader(sy->T("Help the PPSSPP team")));
 	if (!enableReportsSet_)
@@ -1143,6 +1190,10 @@ void GameSettingsScreen::CreateVRSettings(UI::ViewGroup *vrSettings) {
 
 	vrSettings->Add(new ItemHeader(vr->T("Experts only")));
 	vrSettings->Add(new CheckBox(&g_Config.bManualForceVR, vr->T("Manual switching between flat screen and VR using SCREEN key")));
+	if (GetGPUBackend() == GPUBackend::OPENGL) {
+		CheckBox *vrMultiview = vrSettings->Add(new CheckBox(&g_Config.bVRMultiview, vr->T("Render both eyes in one pass (multiview, needs restart)")));
+		vrMultiview->SetEnabledPtr(&g_Config.bEnableStereo);
+	}
 	static const char *vrHeadRotations[] = { vr->T("Disabled"), vr->T("Horizontal only"), vr->T("Horizontal and vertical") };
 	vrSettings->Add(new PopupMultiChoice(&g_Config.iHeadRotation, vr->T("Map HMD rotations on keys instead of VR camera"), vrHeadRotations, 0, ARRAY_SIZE(vrHeadRotations), vr->GetName(), screenManager()));
 	PopupSliderChoiceFloat *vrHeadRotationScale = vrSettings->Add(new PopupSliderChoiceFloat(&g_Config.fHeadRotationScale, 0.1f, 10.0f, vr->T("Game camera rotation step per frame"), 0.1f, screenManager(), "°"));
@@ -1771,7 +1822,7 @@ void DeveloperToolsScreen::CreateViews() {
 	// iOS can now use JIT on all modes, apparently.
 	// The bool may come in handy for future non-jit platforms though (UWP XB1?)
 
-	static const char *cpuCores[] = {"Interpreter", "Dynarec (JIT)", "IR Interpreter"};
+	static const char *cpuCores[] = {"Interpreter", "Dynarec (JIT)", "IR Interpreter", "JIT using IR"};
 	PopupMultiChoice *core = list->Add(new PopupMultiChoice(&g_Config.iCpuCore, gr->T("CPU Core"), cpuCores, 0, ARRAY_SIZE(cpuCores), sy->GetName(), screenManager()));
 	core->OnChoice.Handle(this, &DeveloperToolsScreen::OnJitAffectingSetting);
 	core->OnChoice.Add([](UI::EventParams &) {
@@ -1780,7 +1831,12 @@ void DeveloperToolsScreen::CreateViews() {
 	});
 	if (!canUseJit) {
 		core->HideChoice(1);
+		core->HideChoice(3);
 	}
+#if !PPSSPP_ARCH(AMD64) && !PPSSPP_ARCH(RISCV64)
+	// No native IR backend yet on other platforms.
+	core->HideChoice(3);
+#endif
 
 	list->Add(new Choice(dev->T("JIT debug tools")))->OnClick.Handle(this, &DeveloperToolsScreen::OnJitDebugTools);
 	list->Add(new CheckBox(&g_Config.bShowDeveloperMenu, dev->T("Show Developer Menu")));
@@ -1809,6 +1865,13 @@ void DeveloperToolsScreen::CreateViews() {
 
 	list->Add(new CheckBox(&g_Config.bShowOnScreenMessages, dev->T("Show on-screen messages")));
 	list->Add(new CheckBox(&g_Config.bEnableLogging, dev->T("Enable Logging")))->OnClick.Handle(this, &DeveloperToolsScreen::OnLoggingChanged);
+	CheckBox *asyncLogging = list->Add(new CheckBox(&g_Config.bAsyncLogging, dev->T("Asynchronous logging")));
+	asyncLogging->OnClick.Add([](UI::EventParams &e) {
+		if (LogManager::GetInstance())
+			LogManager::GetInstance()->SetAsync(g_Config.bAsyncLogging);
+		return UI::EVENT_DONE;
+	});
+	asyncLogging->SetEnabledPtr(&g_Config.bEnableLogging);
 	list->Add(new Choice(dev->T("Logging Channels")))->OnClick.Handle(this, &DeveloperToolsScreen::OnLogConfig);
 	list->Add(new CheckBox(&g_Config.bLogFrameDrops, dev->T("Log Dropped Frame Statistics")));
 	if (GetGPUBackend() == GPUBackend::VULKAN) {
@@ -1817,6 +1880,8 @@ void DeveloperToolsScreen::CreateViews() {
 	list->Add(new ItemHeader(dev->T("Texture Replacement")));
 	list->Add(new CheckBox(&g_Config.bSaveNewTextures, dev->T("Save new textures")));
 	list->Add(new CheckBox(&g_Config.bReplaceTextures, dev->T("Replace textures")));
+	PopupSliderChoice *prefetchBudget = list->Add(new PopupSliderChoice(&g_Config.iReplacementPrefetchMB, 0, 2048, dev->T("Texture replacement prefetch budget"), 64, screenManager(), dev->T("MB, 0:off")));
+	prefetchBudget->SetEnabledPtr(&g_Config.bReplaceTextures);
 
 	Choice *createTextureIni = list->Add(new Choice(dev->T("Create/Open textures.ini file for current game")));
 	createTextureIni->OnClick.Handle(this, &DeveloperToolsScreen::OnOpenTexturesIniFile);
@@ -1833,6 +1898,12 @@ void DeveloperToolsScreen::CreateViews() {
 		return true;
 	});
 
+	Choice *createTexturePack = list->Add(new Choice(dev->T("Create textures.pack for current game")));
+	createTexturePack->OnClick.Handle(this, &DeveloperToolsScreen::OnCreateTexturePack);
+	createTexturePack->SetEnabledFunc([&] {
+		return PSP_IsInited();
+	});
+
 	Draw::DrawContext *draw = screenManager()->getDrawContext();
 
 	// Experimental, will move to main graphics settings later.
@@ -1944,6 +2015,22 @@ UI::EventReturn DeveloperToolsScreen::OnOpenTexturesIniFile(UI::EventParams &e)
 	return UI::EVENT_DONE;
 }
 
+UI::EventReturn DeveloperToolsScreen::OnCreateTexturePack(UI::EventParams &e) {
+	std::string gameID = g_paramSFO.GetDiscID();
+	Path generatedFilename;
+
+	auto dev = GetI18NCategory("Developer");
+	if (TextureReplacer::GeneratePack(gameID, generatedFilename)) {
+		System_Toast((generatedFilename.ToVisualString() + ": " + dev->T("Texture pack file created")).c_str());
+		// Switch over to the new pack right away.
+		if (g_Config.bReplaceTextures)
+			NativeMessageReceived("gpu_configChanged", "");
+	} else {
+		System_Toast(dev->T("Failed to create texture pack"));
+	}
+	return UI::EVENT_DONE;
+}
+
 UI::EventReturn DeveloperToolsScreen::OnLogConfig(UI::EventParams &e) {
 	screenManager()->push(new LogConfigScreen());
 	return UI::EVENT_DONE;
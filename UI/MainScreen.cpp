@@ -764,7 +764,8 @@ void GameBrowser::Refresh() {
 		}
 	} else if (!listingPending_) {
 		std::vector<File::FileInfo> fileInfo;
-		path_.GetListing(fileInfo, "iso:cso:pbp:elf:prx:ppdmp:");
+		std::vector<Path> gamePaths;
+		path_.GetListing(fileInfo, "iso:cso:zso:pbp:elf:prx:ppdmp:");
 		for (size_t i = 0; i < fileInfo.size(); i++) {
 			bool isGame = !fileInfo[i].isDirectory;
 			bool isSaveData = false;
@@ -782,8 +783,11 @@ void GameBrowser::Refresh() {
 				}
 			} else {
 				gameButtons.push_back(new GameButton(fileInfo[i].fullName, *gridStyle_, new UI::LinearLayoutParams(*gridStyle_ == true ? UI::WRAP_CONTENT : UI::FILL_PARENT, UI::WRAP_CONTENT)));
+				if (isGame)
+					gamePaths.push_back(fileInfo[i].fullName);
 			}
 		}
+		g_gameInfoCache->ScanInBackground(path_.GetPath(), gamePaths);
 		// Put RAR/ZIP files at the end to get them out of the way. They're only shown so that people
 		// can click them and get an explanation that they need to unpack them. This is necessary due
 		// to a flood of support email...
@@ -78,6 +78,7 @@
 #include "Common/GraphicsContext.h"
 #include "Common/OSVersion.h"
 #include "Common/GPU/ShaderTranslation.h"
+#include "Common/Thread/CorePlacement.h"
 #include "Common/VR/PPSSPPVR.h"
 
 #include "Core/ControlMapper.h"
@@ -329,6 +330,10 @@ void PostLoadConfig() {
 	else
 		i18nrepo.LoadIni(g_Config.sLanguageIni, langOverridePath);
 
+	SetCorePlacementPolicy(g_Config.bThreadCorePlacement, g_Config.sPerformanceCores, g_Config.sEfficiencyCores);
+	if (LogManager::GetInstance())
+		LogManager::GetInstance()->SetAsync(g_Config.bAsyncLogging);
+
 #if PPSSPP_PLATFORM(ANDROID)
 	CreateDirectoriesAndroid();
 #endif
@@ -1031,10 +1036,16 @@ void TakeScreenshot() {
 		File::CreateDir(path);
 	}
 
-	// First, find a free filename.
-	int i = 0;
-
+	// First, find a free filename. Start after the last one we used, since that may still be
+	// getting written in the background.
+	static std::string lastGameId;
+	static int nextIndex = 0;
 	std::string gameId = g_paramSFO.GetDiscID();
+	if (gameId != lastGameId) {
+		lastGameId = gameId;
+		nextIndex = 0;
+	}
+	int i = nextIndex;
 
 	Path filename;
 	while (i < 10000){
@@ -1048,10 +1059,18 @@ void TakeScreenshot() {
 		i++;
 	}
 
-	bool success = TakeGameScreenshot(filename, g_Config.bScreenshotsAsPNG ? ScreenshotFormat::PNG : ScreenshotFormat::JPG, SCREENSHOT_OUTPUT);
-	if (success) {
-		osm.Show(filename.ToVisualString());
-	} else {
+	nextIndex = i + 1;
+
+	// Only the readback happens here, the encode and write happen on a worker thread.
+	bool success = TakeGameScreenshotAsync(filename, g_Config.bScreenshotsAsPNG ? ScreenshotFormat::PNG : ScreenshotFormat::JPG, SCREENSHOT_OUTPUT, [filename](bool saved) {
+		if (saved) {
+			osm.Show(filename.ToVisualString());
+		} else {
+			auto err = GetI18NCategory("Error");
+			osm.Show(err->T("Could not save screenshot file"));
+		}
+	});
+	if (!success) {
 		auto err = GetI18NCategory("Error");
 		osm.Show(err->T("Could not save screenshot file"));
 	}
@@ -1135,7 +1154,8 @@ void NativeRender(GraphicsContext *graphicsContext) {
 	screenManager->getUIContext()->SetTintSaturation(g_Config.fUITint, g_Config.fUISaturation);
 
 	Draw::DebugFlags debugFlags = Draw::DebugFlags::NONE;
-	if (g_Config.bShowGpuProfile)
+	// Dynamic resolution is driven by the GPU frame time.
+	if (g_Config.bShowGpuProfile || g_Config.bDynamicResolution)
 		debugFlags |= Draw::DebugFlags::PROFILE_TIMESTAMPS;
 	if (g_Config.bGpuLogProfiler)
 		debugFlags |= Draw::DebugFlags::PROFILE_SCOPES;
@@ -722,8 +722,13 @@ void GameIconView::Draw(UIContext &dc) {
 		return;
 	}
 
-	textureWidth_ = info->icon.texture->Width() * scale_;
-	textureHeight_ = info->icon.texture->Height() * scale_;
+	float textureWidth = info->icon.texture->Width() * scale_;
+	float textureHeight = info->icon.texture->Height() * scale_;
+	if (textureWidth != textureWidth_ || textureHeight != textureHeight_) {
+		textureWidth_ = textureWidth;
+		textureHeight_ = textureHeight;
+		InvalidateLayout();
+	}
 
 	// Fade icon with the backgrounds.
 	double loadTime = info->icon.timeLoaded;
@@ -115,6 +115,7 @@ void HttpImageFileView::SetFilename(std::string filename) {
 		textureFailed_ = false;
 		path_ = filename;
 		texture_.reset(nullptr);
+		UI::InvalidateLayout();
 	}
 }
 
@@ -145,6 +146,7 @@ void HttpImageFileView::Draw(UIContext &dc) {
 			textureFailed_ = true;
 		textureData_.clear();
 		download_.reset();
+		UI::InvalidateLayout();
 	}
 
 	if (HasFocus()) {
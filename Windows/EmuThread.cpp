@@ -11,6 +11,7 @@
 #include "Common/StringUtils.h"
 #include "Common/GraphicsContext.h"
 #include "Common/TimeUtil.h"
+#include "Common/Thread/CorePlacement.h"
 #include "Common/Thread/ThreadUtil.h"
 
 #include "Windows/EmuThread.h"
@@ -70,6 +71,7 @@ bool MainThread_Ready() {
 
 static void EmuThreadFunc(GraphicsContext *graphicsContext) {
 	SetCurrentThreadName("Emu");
+	SetCurrentThreadRole(ThreadRole::EMU);
 
 	// There's no real requirement that NativeInit happen on this thread.
 	// We just call the update/render loop here.
@@ -116,9 +118,11 @@ void MainThreadFunc() {
 	if (useEmuThread) {
 		// We'll start up a separate thread we'll call Emu
 		SetCurrentThreadName("Render");
+		SetCurrentThreadRole(ThreadRole::RENDER);
 	} else {
 		// This is both Emu and Render.
 		SetCurrentThreadName("Emu");
+		SetCurrentThreadRole(ThreadRole::EMU);
 	}
 
 	host = new WindowsHost(MainWindow::GetHInstance(), MainWindow::GetHWND(), MainWindow::GetDisplayHWND());
@@ -142,11 +146,13 @@ void MainThreadFunc() {
 			// Okay, we must've switched to OpenGL.  Let's flip the emu thread on.
 			useEmuThread = true;
 			SetCurrentThreadName("Render");
+			SetCurrentThreadRole(ThreadRole::RENDER);
 		}
 	} else if (useEmuThread) {
 		// We must've failed over from OpenGL, flip the emu thread off.
 		useEmuThread = false;
 		SetCurrentThreadName("Emu");
+		SetCurrentThreadRole(ThreadRole::EMU);
 	}
 
 	if (g_Config.sFailedGPUBackends.find("ALL") != std::string::npos) {
@@ -11,6 +11,7 @@
 #include "Windows/main.h"
 #include "Core/Config.h"
 #include "GPU/Debugger/Breakpoints.h"
+#include "GPU/Debugger/Debugger.h"
 #include "GPU/GPUState.h"
 
 LPCTSTR CtrlDisplayListView::windowClass = _T("CtrlDisplayListView");
@@ -181,6 +182,7 @@ void CtrlDisplayListView::onPaint(WPARAM wParam, LPARAM lParam)
 	HICON breakPoint = (HICON)LoadIcon(GetModuleHandle(0),(LPCWSTR)IDI_STOP);
 
 	auto disasm = gpuDebug->DissassembleOpRange(windowStart, windowStart + (visibleRows + 2) * instructionSize);
+	const bool showCosts = GPUDebug::IsProfiling();
 
 	for (int i = 0; i < visibleRows+2; i++)
 	{
@@ -240,6 +242,19 @@ void CtrlDisplayListView::onPaint(WPARAM wParam, LPARAM lParam)
 		SelectObject(hdc,stall ? boldfont : font);
 		TextOutA(hdc,pixelPositions.opcodeStart,rowY1+2,opcode,(int)strlen(opcode));
 		SelectObject(hdc,font);
+
+		GPUDebug::CommandCost cost;
+		if (showCosts && GPUDebug::GetCommandCost(address, &cost) && cost.op == op.op) {
+			char costText[64];
+			if (cost.flushSeconds > 0.0)
+				snprintf(costText, sizeof(costText), "%0.3f ms (%0.3f flush) x%d", cost.seconds * 1000.0, cost.flushSeconds * 1000.0, cost.count);
+			else
+				snprintf(costText, sizeof(costText), "%0.3f ms x%d", cost.seconds * 1000.0, cost.count);
+			SIZE size;
+			GetTextExtentPoint32A(hdc, costText, (int)strlen(costText), &size);
+			SetTextColor(hdc, address >= selectRangeStart && address < selectRangeEnd && hasFocus ? textColor : 0x808080);
+			TextOutA(hdc, rect.right - size.cx - 4, rowY1 + 2, costText, (int)strlen(costText));
+		}
 	}
 
 	SelectObject(hdc,oldFont);
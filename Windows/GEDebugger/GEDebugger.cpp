@@ -1244,6 +1244,23 @@ BOOL CGEDebugger::DlgProc(UINT message, WPARAM wParam, LPARAM lParam) {
 			}
 			break;
 
+		case IDC_GEDBG_PROFILE:
+			GPUDebug::SetProfiling(!GPUDebug::IsProfiling());
+			UpdateMenus();
+			break;
+
+		case IDC_GEDBG_PROFILE_RESET:
+			GPUDebug::ResetProfile();
+			for (GEDebuggerTab &tabState : tabStates_) {
+				if (tabState.type != GETabType::LIST_DISASM)
+					continue;
+				for (auto &state : tabState.state) {
+					if (state.displayList)
+						state.displayList->redraw();
+				}
+			}
+			break;
+
 		case IDC_GEDBG_SETPRIMFILTER:
 		{
 			std::string value = GPUDebug::GetRestrictPrims();
@@ -1383,4 +1400,5 @@ void CGEDebugger::CheckTabMessage(TabControl *t, GETabPosition pos, LPARAM lPara
 
 void CGEDebugger::UpdateMenus() {
 	CheckMenuItem(GetMenu(m_hDlg), IDC_GEDBG_FLUSHAUTO, MF_BYCOMMAND | (autoFlush_ ? MF_CHECKED : MF_UNCHECKED));
+	CheckMenuItem(GetMenu(m_hDlg), IDC_GEDBG_PROFILE, MF_BYCOMMAND | (GPUDebug::IsProfiling() ? MF_CHECKED : MF_UNCHECKED));
 }
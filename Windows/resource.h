@@ -335,6 +335,8 @@
 #define ID_GEDBG_TRACK_PIXEL             40226
 #define ID_GEDBG_TRACK_PIXEL_STOP        40227
 #define ID_DISASM_NOPINSTRUCTION         40228
+#define IDC_GEDBG_PROFILE                40229
+#define IDC_GEDBG_PROFILE_RESET          40230
 
 
 // Dummy option to let the buffered rendering hotkey cycle through all the options.
@@ -348,7 +350,7 @@
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        256
-#define _APS_NEXT_COMMAND_VALUE         40228
+#define _APS_NEXT_COMMAND_VALUE         40231
 #define _APS_NEXT_CONTROL_VALUE         1202
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
@@ -28,6 +28,9 @@ static uint32_t FlagsFromConfig() {
 	} else {
 		flags = VULKAN_FLAG_PRESENT_MAILBOX | VULKAN_FLAG_PRESENT_FIFO_RELAXED;
 	}
+	if (g_Config.bLowLatencyPresent) {
+		flags |= VULKAN_FLAG_LOW_LATENCY;
+	}
 #ifdef _DEBUG
 	flags |= VULKAN_FLAG_VALIDATE;
 #endif
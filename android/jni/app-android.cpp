@@ -61,6 +61,7 @@ struct JNIEnv {};
 #include "Common/System/Display.h"
 #include "Common/System/NativeApp.h"
 #include "Common/System/System.h"
+#include "Common/Thread/CorePlacement.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/File/Path.h"
 #include "Common/File/DirListing.h"
@@ -298,6 +299,7 @@ static void EmuThreadFunc() {
 	JNIEnv *env;
 
 	SetCurrentThreadName("EmuThread");
+	SetCurrentThreadRole(ThreadRole::EMU);
 
 	// Name the thread in the JVM, because why not (might result in better debug output in Play Console).
 	// TODO: Do something clever with getEnv() and stored names from SetCurrentThreadName?
@@ -1089,6 +1091,7 @@ extern "C" void Java_org_ppsspp_ppsspp_NativeRenderer_displayRender(JNIEnv *env,
 	if (!hasSetThreadName) {
 		hasSetThreadName = true;
 		SetCurrentThreadName("AndroidRender");
+		SetCurrentThreadRole(ThreadRole::EMU);
 	}
 
 	if (IsVREnabled() && !StartVRRender())
@@ -1391,6 +1394,7 @@ extern "C" bool JNICALL Java_org_ppsspp_ppsspp_NativeActivity_runVulkanRenderLoo
 		if (!hasSetThreadName) {
 			hasSetThreadName = true;
 			SetCurrentThreadName("AndroidRender");
+			SetCurrentThreadRole(ThreadRole::EMU);
 		}
 	}
 
@@ -19,10 +19,14 @@
 #include "Common/CommonWindows.h"
 #if PPSSPP_PLATFORM(WINDOWS)
 #include <timeapi.h>
+#include <psapi.h>
 #else
 #include <csignal>
+#include <sys/resource.h>
 #endif
 #include "Common/CPUDetect.h"
+#include "Common/Data/Format/JSONWriter.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/VFS/VFS.h"
 #include "Common/File/VFS/ZipFileReader.h"
 #include "Common/File/VFS/DirectoryReader.h"
@@ -36,10 +40,17 @@
 #include "Core/CoreTiming.h"
 #include "Core/System.h"
 #include "Core/WebServer.h"
+#include "Core/HLE/sceDisplay.h"
+#include "Core/HLE/sceRtc.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/Host.h"
+#include "Core/HW/Display.h"
+#include "Core/MIPS/JitCommon/JitBlockCache.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/SaveState.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
+#include "GPU/GPU.h"
+#include "GPU/Software/SoftGpu.h"
 #include "Log.h"
 #include "LogManager.h"
 
@@ -140,9 +151,21 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  -v, --verbose         show the full passed/failed result\n");
 	fprintf(stderr, "  -i                    use the interpreter\n");
 	fprintf(stderr, "  --ir                  use ir interpreter\n");
+	fprintf(stderr, "  --irjit               use ir converted to native code\n");
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
 	fprintf(stderr, "  --bench               run multiple times and output speed\n");
+	fprintf(stderr, "  --bench-json=FILE     with --bench, also write per-stage timings as json\n");
+	fprintf(stderr, "  --frames=N            stop each run after N frames\n");
+	fprintf(stderr, "  --fixed-time=SECONDS  start the PSP clock at a fixed time (default with --bench-json)\n");
+	fprintf(stderr, "  --threads=N           limit worker threads (default: all cores)\n");
+	fprintf(stderr, "  --res=N               internal resolution multiplier (hardware backends)\n");
+	fprintf(stderr, "  --determinism-record=FILE   save hashes of each state section to FILE\n");
+	fprintf(stderr, "  --determinism-compare=FILE  check state sections against a recording\n");
+	fprintf(stderr, "  --determinism-interval=MS   emulated time between hashes (default 1000)\n");
+	fprintf(stderr, "  --skip-rendering      run GE lists without drawing (no screenshot compare)\n");
+	fprintf(stderr, "  --perf-map            write /tmp/perf-PID.map for JIT code (Linux)\n");
+	fprintf(stderr, "\nDirectories are expanded to the .ppdmp GE dumps inside them.\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
@@ -165,11 +188,74 @@ static HeadlessHost *getHost(GPUCore gpuCore) {
 struct AutoTestOptions {
 	double timeout;
 	double maxScreenshotError;
+	int frames;
+	// Negative to use the host's clock.
+	int64_t fixedTime;
 	bool compare : 1;
 	bool verbose : 1;
 	bool bench : 1;
 };
 
+// Frames presented since the last reset, for --bench.
+static int benchFrames = 0;
+
+// Summed over runs since the last reset, for --bench-json.
+struct BenchCounters {
+	int64_t drawCalls;
+	int64_t flushes;
+	int64_t vertsSubmitted;
+	int64_t textureCacheHits;
+	int64_t textureCacheMisses;
+	int64_t texturesDecoded;
+	int64_t shaderCompiles;
+	int64_t jitBlocks;
+	double jitBloat;
+	int jitRuns;
+};
+static BenchCounters benchCounters;
+
+static void CollectBenchCounters() {
+	// gpuStats isn't reset per frame in headless, so these are totals for the run.
+	benchCounters.drawCalls += gpuStats.numDrawCalls;
+	benchCounters.flushes += gpuStats.numFlushes;
+	benchCounters.vertsSubmitted += gpuStats.numVertsSubmitted;
+	benchCounters.textureCacheHits += gpuStats.numTextureCacheHits;
+	benchCounters.textureCacheMisses += gpuStats.numTextureCacheMisses;
+	benchCounters.texturesDecoded += gpuStats.numTexturesDecoded;
+	benchCounters.shaderCompiles += gpuStats.numShaderCompiles;
+
+	std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+	JitBlockCacheDebugInterface *blockCache = MIPSComp::jit ? MIPSComp::jit->GetBlockCacheDebugInterface() : nullptr;
+	if (blockCache) {
+		BlockCacheStats bcStats{};
+		blockCache->ComputeStats(bcStats);
+		benchCounters.jitBlocks += bcStats.numBlocks;
+		if (bcStats.numBlocks > 0) {
+			benchCounters.jitBloat += bcStats.avgBloat;
+			benchCounters.jitRuns++;
+		}
+	}
+}
+
+static int64_t GetPeakMemoryKB() {
+#if PPSSPP_PLATFORM(WINDOWS)
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return (int64_t)(counters.PeakWorkingSetSize / 1024);
+	return 0;
+#else
+	struct rusage usage{};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#if PPSSPP_PLATFORM(MAC) || PPSSPP_PLATFORM(IOS)
+	// Reported in bytes here, but KB on Linux.
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
 bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const AutoTestOptions &opt) {
 	// Kinda ugly, trying to guesstimate the test name from filename...
 	currentTestName = GetTestName(coreParameter.fileToStart);
@@ -189,7 +275,8 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 
 	TeamCityPrint("testStarted name='%s' captureStandardOutput='true'", currentTestName.c_str());
 
-	if (opt.compare)
+	// Nothing gets drawn, so there's nothing to compare.
+	if (opt.compare && !__DisplayIsSkippingRendering())
 		headlessHost->SetComparisonScreenshot(ExpectedScreenshotFromFilename(coreParameter.fileToStart), opt.maxScreenshotError);
 
 	while (!PSP_InitUpdate(&error_string))
@@ -201,6 +288,9 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 		return false;
 	}
 
+	if (opt.fixedTime >= 0)
+		RtcSetBaseTime((int32_t)opt.fixedTime);
+
 	host->BootDone();
 
 	Core_UpdateDebugStats(g_Config.bShowDebugStats || g_Config.bLogFrameDrops);
@@ -211,6 +301,7 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 		draw->BeginFrame();
 
 	bool passed = true;
+	int runFrames = 0;
 	double deadline = time_now_d() + opt.timeout;
 	coreState = coreParameter.startBreak ? CORE_STEPPING : CORE_RUNNING;
 	while (coreState == CORE_RUNNING || coreState == CORE_STEPPING)
@@ -222,6 +313,9 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 		if (coreState == CORE_NEXTFRAME) {
 			coreState = CORE_RUNNING;
 			headlessHost->SwapBuffers();
+			benchFrames++;
+			if (opt.frames > 0 && ++runFrames >= opt.frames)
+				Core_Stop();
 		}
 		if (coreState == CORE_STEPPING && !coreParameter.startBreak) {
 			break;
@@ -242,6 +336,9 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 	}
 	PSP_EndHostFrame();
 
+	if (opt.bench)
+		CollectBenchCounters();
+
 	if (draw) {
 		draw->BindFramebufferAsRenderTarget(nullptr, { Draw::RPAction::CLEAR, Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE }, "Headless");
 		// Vulkan may get angry if we don't do a final present.
@@ -282,6 +379,7 @@ int main(int argc, const char* argv[])
 
 	AutoTestOptions testOptions{};
 	testOptions.timeout = std::numeric_limits<double>::infinity();
+	testOptions.fixedTime = -1;
 	bool fullLog = false;
 	const char *stateToLoad = 0;
 	GPUCore gpuCore = GPUCORE_SOFTWARE;
@@ -292,6 +390,14 @@ int main(int argc, const char* argv[])
 	const char *mountIso = nullptr;
 	const char *mountRoot = nullptr;
 	const char *screenshotFilename = nullptr;
+	const char *benchJsonFilename = nullptr;
+	int numThreads = 0;
+	int internalResolution = 1;
+	const char *determinismFilename = nullptr;
+	bool determinismCompare = false;
+	int determinismInterval = 1000;
+	bool skipRendering = false;
+	bool perfMap = false;
 
 	for (int i = 1; i < argc; i++)
 	{
@@ -315,10 +421,34 @@ int main(int argc, const char* argv[])
 			cpuCore = CPUCore::JIT;
 		else if (!strcmp(argv[i], "--ir"))
 			cpuCore = CPUCore::IR_JIT;
+		else if (!strcmp(argv[i], "--irjit"))
+			cpuCore = CPUCore::JIT_IR;
 		else if (!strcmp(argv[i], "-c") || !strcmp(argv[i], "--compare"))
 			testOptions.compare = true;
 		else if (!strcmp(argv[i], "--bench"))
 			testOptions.bench = true;
+		else if (!strncmp(argv[i], "--bench-json=", strlen("--bench-json=")) && strlen(argv[i]) > strlen("--bench-json="))
+			benchJsonFilename = argv[i] + strlen("--bench-json=");
+		else if (!strncmp(argv[i], "--frames=", strlen("--frames=")) && strlen(argv[i]) > strlen("--frames="))
+			testOptions.frames = (int)strtoul(argv[i] + strlen("--frames="), NULL, 10);
+		else if (!strncmp(argv[i], "--fixed-time=", strlen("--fixed-time=")) && strlen(argv[i]) > strlen("--fixed-time="))
+			testOptions.fixedTime = strtoll(argv[i] + strlen("--fixed-time="), NULL, 10);
+		else if (!strncmp(argv[i], "--threads=", strlen("--threads=")) && strlen(argv[i]) > strlen("--threads="))
+			numThreads = (int)strtoul(argv[i] + strlen("--threads="), NULL, 10);
+		else if (!strncmp(argv[i], "--res=", strlen("--res=")) && strlen(argv[i]) > strlen("--res="))
+			internalResolution = std::max(1, (int)strtoul(argv[i] + strlen("--res="), NULL, 10));
+		else if (!strncmp(argv[i], "--determinism-record=", strlen("--determinism-record=")) && strlen(argv[i]) > strlen("--determinism-record=")) {
+			determinismFilename = argv[i] + strlen("--determinism-record=");
+			determinismCompare = false;
+		} else if (!strncmp(argv[i], "--determinism-compare=", strlen("--determinism-compare=")) && strlen(argv[i]) > strlen("--determinism-compare=")) {
+			determinismFilename = argv[i] + strlen("--determinism-compare=");
+			determinismCompare = true;
+		} else if (!strncmp(argv[i], "--determinism-interval=", strlen("--determinism-interval=")) && strlen(argv[i]) > strlen("--determinism-interval="))
+			determinismInterval = std::max(1, (int)strtoul(argv[i] + strlen("--determinism-interval="), NULL, 10));
+		else if (!strcmp(argv[i], "--skip-rendering"))
+			skipRendering = true;
+		else if (!strcmp(argv[i], "--perf-map"))
+			perfMap = true;
 		else if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "--verbose"))
 			testOptions.verbose = true;
 		else if (!strncmp(argv[i], "--graphics=", strlen("--graphics=")) && strlen(argv[i]) > strlen("--graphics="))
@@ -374,8 +504,26 @@ int main(int argc, const char* argv[])
 			testFilenames.push_back(temp);
 	}
 
+	// Expand directories of GE dumps, so a whole set can be benchmarked at once.
+	for (size_t i = 0; i < testFilenames.size(); ++i) {
+		Path dir(testFilenames[i]);
+		if (!File::IsDirectory(dir))
+			continue;
+
+		std::vector<File::FileInfo> dumps;
+		File::GetFilesInDir(dir, &dumps, "ppdmp");
+		testFilenames.erase(testFilenames.begin() + i);
+		for (const File::FileInfo &info : dumps) {
+			if (!info.isDirectory)
+				testFilenames.insert(testFilenames.begin() + i++, info.fullName.ToString());
+		}
+		--i;
+	}
+
 	if (testFilenames.empty())
 		return printUsage(argv[0], argc <= 1 ? NULL : "No executables specified");
+	if (benchJsonFilename && !testOptions.bench)
+		return printUsage(argv[0], "--bench-json requires --bench");
 
 	LogManager::Init(&g_Config.bEnableLogging);
 	LogManager *logman = LogManager::GetInstance();
@@ -390,7 +538,10 @@ int main(int argc, const char* argv[])
 	logman->AddListener(printfLogger);
 
 	// Needs to be after log so we don't interfere with test output.
-	g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+	if (numThreads > 0)
+		g_threadManager.Init(numThreads, 1);
+	else
+		g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
 
 	HeadlessHost *headlessHost = getHost(gpuCore);
 	headlessHost->SetGraphicsCore(gpuCore);
@@ -410,9 +561,9 @@ int main(int argc, const char* argv[])
 	coreParameter.startBreak = false;
 	coreParameter.printfEmuLog = !testOptions.compare;
 	coreParameter.headLess = true;
-	coreParameter.renderScaleFactor = 1;
-	coreParameter.renderWidth = 480;
-	coreParameter.renderHeight = 272;
+	coreParameter.renderScaleFactor = internalResolution;
+	coreParameter.renderWidth = 480 * internalResolution;
+	coreParameter.renderHeight = 272 * internalResolution;
 	coreParameter.pixelWidth = 480;
 	coreParameter.pixelHeight = 272;
 	coreParameter.fastForward = true;
@@ -437,13 +588,14 @@ int main(int argc, const char* argv[])
 	g_Config.iDateFormat = PSP_SYSTEMPARAM_DATE_FORMAT_DDMMYYYY;
 	g_Config.iButtonPreference = PSP_SYSTEMPARAM_BUTTON_CROSS;
 	g_Config.iLockParentalLevel = 9;
-	g_Config.iInternalResolution = 1;
+	g_Config.iInternalResolution = internalResolution;
 	g_Config.iFastForwardMode = (int)FastForwardMode::CONTINUOUS;
 	g_Config.bEnableLogging = fullLog;
 	g_Config.bSoftwareSkinning = true;
 	g_Config.bVertexDecoderJit = true;
 	g_Config.bSoftwareRendering = coreParameter.gpuCore == GPUCORE_SOFTWARE;
 	g_Config.bSoftwareRenderingJit = true;
+	g_Config.bJitPerfMap = perfMap;
 	g_Config.iSplineBezierQuality = 2;
 	g_Config.bHighQualityDepth = true;
 	g_Config.bMemStickInserted = true;
@@ -500,9 +652,33 @@ int main(int argc, const char* argv[])
 		StartWebServer(WebServerFlags::DEBUGGER);
 	}
 
+	__DisplaySetSkipRendering(skipRendering);
+
 	if (stateToLoad != NULL)
 		SaveState::Load(Path(stateToLoad), -1);
 
+	if (determinismFilename && !SaveState::DeterminismCheckBegin(Path(std::string(determinismFilename)), determinismCompare, determinismInterval)) {
+		fprintf(stderr, "Failed to open %s\n", determinismFilename);
+		return 1;
+	}
+
+	json::JsonWriter benchJson(json::JsonWriter::PRETTY);
+	if (benchJsonFilename) {
+		// Per-stage timings are only collected with debug stats on.
+		Core_ForceDebugStats(true);
+		// Games often seed their RNG from the clock, keep runs comparable across commits.
+		if (testOptions.fixedTime < 0)
+			testOptions.fixedTime = 1262304000;
+		benchJson.begin();
+		benchJson.writeInt("threads", g_threadManager.GetNumLooperThreads());
+		benchJson.writeInt("resolution", internalResolution);
+		benchJson.writeInt("gpuCore", (int)gpuCore);
+		benchJson.writeInt("cpuCore", (int)cpuCore);
+		benchJson.writeInt("frames", testOptions.frames);
+		benchJson.writeFloat("fixedTime", (double)testOptions.fixedTime);
+		benchJson.pushArray("results");
+	}
+
 	std::vector<std::string> failedTests;
 	std::vector<std::string> passedTests;
 	for (size_t i = 0; i < testFilenames.size(); ++i)
@@ -512,6 +688,10 @@ int main(int argc, const char* argv[])
 			printf("%s:\n", coreParameter.fileToStart.c_str());
 		bool passed = RunAutoTest(headlessHost, coreParameter, testOptions);
 		if (testOptions.bench) {
+			benchFrames = 0;
+			benchCounters = {};
+			g_softGPUBenchStats.Reset();
+			__DisplayResetFrameBreakdownTotals();
 			double st = time_now_d();
 			double deadline = st + testOptions.timeout;
 			double runs = 0.0;
@@ -526,6 +706,50 @@ int main(int argc, const char* argv[])
 
 			std::string testName = GetTestName(coreParameter.fileToStart);
 			printf("  %s - %f seconds average\n", testName.c_str(), (et - st) / runs);
+
+			if (benchJsonFilename) {
+				const SoftGPUBenchStats &stats = g_softGPUBenchStats;
+				benchJson.pushDict();
+				benchJson.writeString("name", testName);
+				benchJson.writeInt("runs", (int)runs);
+				benchJson.writeFloat("seconds", (et - st) / runs);
+				benchJson.writeFloat("fps", benchFrames / (et - st));
+				benchJson.writeFloat("transformSeconds", stats.transform / runs);
+				// Rasterization and sampling happen together on the bin threads, so they're one number.
+				benchJson.writeFloat("rasterWaitSeconds", stats.flushWait / runs);
+				benchJson.writeFloat("pixelJitSeconds", stats.pixelJit / runs);
+				benchJson.writeFloat("samplerJitSeconds", stats.samplerJit / runs);
+				benchJson.writeFloat("frames", benchFrames / runs);
+
+				// Host time on the emu thread, per run.
+				double breakdown[(int)FrameTimeCategory::COUNT];
+				__DisplayGetFrameBreakdownTotals(breakdown);
+				benchJson.pushDict("subsystemSeconds");
+				benchJson.writeFloat("hle", breakdown[(int)FrameTimeCategory::HLE] / runs);
+				benchJson.writeFloat("ge", breakdown[(int)FrameTimeCategory::GE] / runs);
+				benchJson.writeFloat("flush", breakdown[(int)FrameTimeCategory::FLUSH] / runs);
+				benchJson.writeFloat("texture", breakdown[(int)FrameTimeCategory::TEXTURE] / runs);
+				benchJson.writeFloat("present", breakdown[(int)FrameTimeCategory::PRESENT] / runs);
+				benchJson.pop();
+
+				const BenchCounters &counters = benchCounters;
+				benchJson.pushDict("gpu");
+				benchJson.writeFloat("drawCalls", counters.drawCalls / runs);
+				benchJson.writeFloat("flushes", counters.flushes / runs);
+				benchJson.writeFloat("vertsSubmitted", counters.vertsSubmitted / runs);
+				benchJson.writeFloat("textureCacheHits", counters.textureCacheHits / runs);
+				benchJson.writeFloat("textureCacheMisses", counters.textureCacheMisses / runs);
+				benchJson.writeFloat("texturesDecoded", counters.texturesDecoded / runs);
+				benchJson.writeFloat("shaderCompiles", counters.shaderCompiles / runs);
+				benchJson.pop();
+
+				benchJson.pushDict("jit");
+				benchJson.writeFloat("blocks", counters.jitBlocks / runs);
+				benchJson.writeFloat("avgBloat", counters.jitRuns > 0 ? counters.jitBloat / counters.jitRuns : 0.0);
+				benchJson.pop();
+
+				benchJson.pop();
+			}
 		}
 		if (testOptions.compare) {
 			std::string testName = GetTestName(coreParameter.fileToStart);
@@ -549,6 +773,26 @@ int main(int argc, const char* argv[])
 		}
 	}
 
+	bool determinismFailed = false;
+	if (determinismFilename) {
+		std::string message;
+		if (!SaveState::DeterminismCheckEnd(&message)) {
+			printf("Determinism check failed: %s\n", message.c_str());
+			determinismFailed = true;
+		} else if (determinismCompare) {
+			printf("Determinism check passed.\n");
+		}
+	}
+
+	if (benchJsonFilename) {
+		benchJson.pop();
+		benchJson.writeFloat("peakMemoryKB", (double)GetPeakMemoryKB());
+		benchJson.end();
+		if (!File::WriteStringToFile(true, benchJson.str(), Path(std::string(benchJsonFilename))))
+			fprintf(stderr, "Failed to write %s\n", benchJsonFilename);
+		Core_ForceDebugStats(false);
+	}
+
 	if (debuggerPort > 0) {
 		ShutdownWebServer();
 	}
@@ -568,7 +812,7 @@ int main(int argc, const char* argv[])
 
 	g_threadManager.Teardown();
 
-	if (!failedTests.empty() && !teamCityMode)
+	if ((!failedTests.empty() || determinismFailed) && !teamCityMode)
 		return 1;
 	return 0;
 }
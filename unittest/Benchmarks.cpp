@@ -0,0 +1,478 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+// Microbenchmarks for hot paths, run with "PPSSPPUnitTest bench [filter] [--json=FILE]".
+// Each benchmark is warmed up, then timed in batches, reporting the median and interquartile
+// range per iteration so a noisy run is visible rather than silently skewing an average.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/Data/Collections/Hashmaps.h"
+#include "Common/Data/Convert/ColorConv.h"
+#include "Common/Data/Format/JSONWriter.h"
+#include "Common/File/FileUtil.h"
+#include "Common/Serialize/Serializer.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/Util/AudioFormat.h"
+#include "GPU/Common/IndexGenerator.h"
+#include "GPU/Common/TextureDecoder.h"
+#include "GPU/Common/VertexDecoderCommon.h"
+#include "GPU/ge_constants.h"
+#include "GPU/GPUState.h"
+
+struct BenchmarkResult {
+	std::string name;
+	int samples;
+	int iterationsPerSample;
+	double medianSeconds;
+	double q1Seconds;
+	double q3Seconds;
+	// Zero if the benchmark isn't measured in bytes.
+	double bytesPerIteration;
+};
+
+class BenchmarkRunner {
+public:
+	BenchmarkRunner(const char *filter) : filter_(filter ? filter : "") {}
+
+	void Run(const char *name, double bytesPerIteration, const std::function<void()> &func);
+
+	const std::vector<BenchmarkResult> &Results() const { return results_; }
+
+private:
+	static constexpr int SAMPLES = 31;
+	static constexpr double WARMUP_SECONDS = 0.05;
+	static constexpr double SAMPLE_SECONDS = 0.01;
+
+	std::string filter_;
+	std::vector<BenchmarkResult> results_;
+};
+
+void BenchmarkRunner::Run(const char *name, double bytesPerIteration, const std::function<void()> &func) {
+	if (!filter_.empty() && !strstr(name, filter_.c_str()))
+		return;
+
+	// Warm up caches and branch predictors, and figure out how many iterations make a sample.
+	int warmupIterations = 0;
+	double st = time_now_d();
+	do {
+		func();
+		warmupIterations++;
+	} while (time_now_d() - st < WARMUP_SECONDS);
+	double perIteration = (time_now_d() - st) / warmupIterations;
+	int batch = std::max(1, (int)(SAMPLE_SECONDS / perIteration));
+
+	std::vector<double> samples(SAMPLES);
+	for (int s = 0; s < SAMPLES; ++s) {
+		double sampleStart = time_now_d();
+		for (int i = 0; i < batch; ++i)
+			func();
+		samples[s] = (time_now_d() - sampleStart) / batch;
+	}
+	std::sort(samples.begin(), samples.end());
+
+	BenchmarkResult result;
+	result.name = name;
+	result.samples = SAMPLES;
+	result.iterationsPerSample = batch;
+	result.medianSeconds = samples[SAMPLES / 2];
+	result.q1Seconds = samples[SAMPLES / 4];
+	result.q3Seconds = samples[(SAMPLES * 3) / 4];
+	result.bytesPerIteration = bytesPerIteration;
+
+	double iqrPercent = 100.0 * (result.q3Seconds - result.q1Seconds) / result.medianSeconds;
+	if (bytesPerIteration > 0.0) {
+		printf("%-36s %10.2f us  (IQR %4.1f%%)  %8.2f GB/s\n", name, result.medianSeconds * 1000000.0, iqrPercent, bytesPerIteration / result.medianSeconds / 1000000000.0);
+	} else {
+		printf("%-36s %10.2f us  (IQR %4.1f%%)\n", name, result.medianSeconds * 1000000.0, iqrPercent);
+	}
+	results_.push_back(result);
+}
+
+// Prevents the compiler from throwing away results.
+static volatile u32 benchmarkSink;
+
+static std::vector<u8> RandomBytes(size_t size, u32 seed) {
+	std::vector<u8> data(size);
+	for (size_t i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (u8)(seed >> 16);
+	}
+	return data;
+}
+
+static void BenchTextures(BenchmarkRunner &runner) {
+	// A 512x512 texture, the largest the PSP can use.
+	static const int W = 512;
+	static const int H = 512;
+	std::vector<u8> src = RandomBytes(W * H * 4, 1);
+	std::vector<u32> dst(W * H);
+	std::vector<u32> clut32(256);
+	for (int i = 0; i < 256; ++i)
+		clut32[i] = 0xFF000000 | (i * 0x010101);
+
+	const u32 oldClutFormat = gstate.clutformat;
+	// Simple index, ABGR8888.
+	gstate.clutformat = 0xC500FF03;
+
+	runner.Run("StableQuickTexHash 512x512 CLUT8", W * H, [&] {
+		benchmarkSink = StableQuickTexHash(src.data(), W * H);
+	});
+
+	runner.Run("DeIndexTexture CLUT8 512x512", W * H, [&] {
+		u32 alphaSum = 0xFFFFFFFF;
+		DeIndexTexture(dst.data(), src.data(), W * H, clut32.data(), &alphaSum);
+		benchmarkSink = alphaSum;
+	});
+
+	runner.Run("DeIndexTexture4 CLUT4 512x512", W * H / 2, [&] {
+		u32 alphaSum = 0xFFFFFFFF;
+		DeIndexTexture4(dst.data(), src.data(), W * H, clut32.data(), &alphaSum);
+		benchmarkSink = alphaSum;
+	});
+
+	runner.Run("ConvertRGBA4444ToRGBA8888 512x512", W * H * 2, [&] {
+		ConvertRGBA4444ToRGBA8888(dst.data(), (const u16 *)src.data(), W * H);
+	});
+
+	runner.Run("DecodeDXT1Block 512x512", W * H / 2, [&] {
+		const DXT1Block *blocks = (const DXT1Block *)src.data();
+		u32 alpha = 0xFFFFFFFF;
+		for (int y = 0; y < H; y += 4) {
+			for (int x = 0; x < W; x += 4)
+				DecodeDXT1Block(&dst[y * W + x], blocks++, W, 4, 4, &alpha);
+		}
+		benchmarkSink = alpha;
+	});
+
+	runner.Run("DecodeDXT5Block 512x512", W * H, [&] {
+		const DXT5Block *blocks = (const DXT5Block *)src.data();
+		for (int y = 0; y < H; y += 4) {
+			for (int x = 0; x < W; x += 4)
+				DecodeDXT5Block(&dst[y * W + x], blocks++, W, 4, 4);
+		}
+	});
+
+	gstate.clutformat = oldClutFormat;
+}
+
+static void BenchVertexDecoder(BenchmarkRunner &runner) {
+	static const int COUNT = 4096;
+	static const struct {
+		const char *name;
+		u32 vtype;
+	} formats[] = {
+		{ "through 2D sprite", GE_VTYPE_THROUGH | GE_VTYPE_TC_16BIT | GE_VTYPE_COL_8888 | GE_VTYPE_POS_16BIT },
+		{ "float tc/nrm/pos", GE_VTYPE_TC_FLOAT | GE_VTYPE_NRM_FLOAT | GE_VTYPE_POS_FLOAT },
+		{ "8-bit tc/nrm/pos", GE_VTYPE_TC_8BIT | GE_VTYPE_NRM_8BIT | GE_VTYPE_POS_8BIT },
+		{ "16-bit tc/col565/pos", GE_VTYPE_TC_16BIT | GE_VTYPE_COL_565 | GE_VTYPE_POS_16BIT },
+		{ "4 weights skinned", GE_VTYPE_WEIGHT_FLOAT | (3 << GE_VTYPE_WEIGHTCOUNT_SHIFT) | GE_VTYPE_NRM_FLOAT | GE_VTYPE_POS_FLOAT },
+	};
+
+	gstate_c.uv.uScale = 1.0f;
+	gstate_c.uv.vScale = 1.0f;
+
+	std::unique_ptr<VertexDecoderJitCache> cache(new VertexDecoderJitCache());
+	// Random bits would make lots of NaNs and denormals, which isn't what games send.
+	std::vector<u8> src(COUNT * 64, 0x3F);
+	std::vector<u8> dst(COUNT * 128);
+	VertexDecoderOptions options{};
+
+	for (const auto &format : formats) {
+		for (int jit = 0; jit <= 1; ++jit) {
+			VertexDecoder dec;
+			dec.SetVertexType(format.vtype, options, jit ? cache.get() : nullptr);
+			std::string name = std::string("VertexDecoder ") + (jit ? "jit " : "interp ") + format.name;
+			runner.Run(name.c_str(), (double)dec.VertexSize() * COUNT, [&] {
+				dec.DecodeVerts(dst.data(), src.data(), 0, COUNT - 1);
+			});
+		}
+	}
+}
+
+static void BenchIRInterpreter(BenchmarkRunner &runner) {
+	// A synthetic block of integer and float ALU ops, looped a few times like a hot inner loop.
+	IRWriter ir;
+	for (int i = 0; i < 64; ++i) {
+		u8 r = 8 + (i & 7);
+		ir.Write(IROp::Add, r, r, 9 + ((i + 1) & 7));
+		ir.Write(IROp::XorConst, r, r, ir.AddConstant(0x1234 + i));
+		ir.Write(IROp::ShlImm, r + 8, r, i & 31);
+		ir.Write(IROp::Sub, r, r, r + 8);
+		ir.Write(IROp::FAdd, i & 15, i & 15, 16 + (i & 15));
+		ir.Write(IROp::FMul, 16 + (i & 15), 16 + (i & 15), i & 15);
+	}
+	ir.Write(IROp::ExitToConst, 0, ir.AddConstant(0x08804000));
+	const std::vector<IRInst> &insts = ir.GetInstructions();
+
+	std::unique_ptr<MIPSState> mips(new MIPSState());
+	memset(mips->r, 0, sizeof(mips->r));
+	for (int i = 0; i < 32; ++i)
+		mips->f[i] = 1.0f + i * 0.001f;
+
+	runner.Run("IRInterpret ALU block (385 ops)", 0.0, [&] {
+		benchmarkSink = IRInterpret(mips.get(), insts.data(), (int)insts.size());
+	});
+}
+
+static void BenchAudio(BenchmarkRunner &runner) {
+	// 32 voices of the largest SAS grain, roughly a worst case sceSasCore frame.
+	static const int GRAIN = 2048;
+	std::vector<u8> bytes = RandomBytes(GRAIN * sizeof(s16), 3);
+	const s16 *samples = (const s16 *)bytes.data();
+	std::vector<int> mixed(GRAIN * 2);
+	std::vector<s16> output(GRAIN * 2);
+
+	runner.Run("SAS mix 32 voices x 2048", 32.0 * GRAIN * sizeof(s16), [&] {
+		std::fill(mixed.begin(), mixed.end(), 0);
+		for (int v = 0; v < 32; ++v)
+			AccumulateStereoVolume12(mixed.data(), samples, GRAIN, 0x800 + v, 0x800 - v);
+		ClampS32ToS16(output.data(), mixed.data(), GRAIN * 2);
+	});
+}
+
+// About the size of a pipeline or shader ID.
+struct BenchHashKey {
+	u32 words[8];
+};
+
+template <class Map>
+static void BenchKeyedMap(BenchmarkRunner &runner, const char *mapName, int count) {
+	std::vector<BenchHashKey> keys(count * 2);
+	std::vector<u8> bytes = RandomBytes(keys.size() * sizeof(BenchHashKey), 5);
+	memcpy(keys.data(), bytes.data(), bytes.size());
+
+	// Only the first half goes in, the rest are for misses.
+	Map map(16);
+	for (int i = 0; i < count; ++i)
+		map.Insert(keys[i], (uintptr_t)(i + 1));
+
+	std::string name = StringFromFormat("%s Get hits %d", mapName, count);
+	runner.Run(name.c_str(), 0.0, [&] {
+		uintptr_t sum = 0;
+		for (int i = 0; i < count; ++i)
+			sum += map.Get(keys[i]);
+		benchmarkSink = (u32)sum;
+	});
+	name = StringFromFormat("%s Get misses %d", mapName, count);
+	runner.Run(name.c_str(), 0.0, [&] {
+		uintptr_t sum = 0;
+		for (int i = count; i < count * 2; ++i)
+			sum += map.Get(keys[i]);
+		benchmarkSink = (u32)sum;
+	});
+}
+
+template <class Map>
+static void BenchPrehashMap(BenchmarkRunner &runner, const char *mapName, int count) {
+	std::vector<u8> bytes = RandomBytes(count * 2 * sizeof(u32), 6);
+	const u32 *hashes = (const u32 *)bytes.data();
+
+	// Like the vertex array cache: constant turnover, tidied up with Maintain() once in a while.
+	Map map(16);
+	for (int i = 0; i < count; ++i)
+		map.Insert(hashes[i], (uintptr_t)(i + 1));
+	for (int i = 0; i < count; ++i) {
+		map.Remove(hashes[i]);
+		map.Insert(hashes[i + count], (uintptr_t)(i + 1));
+		map.Insert(hashes[i], (uintptr_t)(i + 1));
+		map.Remove(hashes[i + count]);
+		if ((i & 255) == 0)
+			map.Maintain();
+	}
+
+	std::string name = StringFromFormat("%s Get after churn %d", mapName, count);
+	runner.Run(name.c_str(), 0.0, [&] {
+		uintptr_t sum = 0;
+		for (int i = 0; i < count * 2; ++i)
+			sum += map.Get(hashes[i]);
+		benchmarkSink = (u32)sum;
+	});
+}
+
+static void BenchHashMaps(BenchmarkRunner &runner) {
+	for (int count : { 64, 4096 }) {
+		BenchKeyedMap<DenseHashMap<BenchHashKey, uintptr_t, 0>>(runner, "DenseHashMap", count);
+		BenchKeyedMap<SwissHashMap<BenchHashKey, uintptr_t, 0>>(runner, "SwissHashMap", count);
+	}
+	BenchPrehashMap<PrehashMap<uintptr_t, 0>>(runner, "PrehashMap", 4096);
+	BenchPrehashMap<SwissPrehashMap<uintptr_t, 0>>(runner, "SwissPrehashMap", 4096);
+}
+
+static void BenchIndexGenerator(BenchmarkRunner &runner) {
+	// A typical flush worth of small draws.
+	static const int DRAWS = 256;
+	static const int VERTS = 30;
+	std::vector<u16> buffer(DRAWS * VERTS * 3 + 64);
+	std::vector<u8> src = RandomBytes(VERTS * 4, 5);
+	std::vector<u8> inds8(VERTS);
+	std::vector<u16_le> inds16(VERTS);
+	std::vector<u32_le> inds32(VERTS);
+	for (int i = 0; i < VERTS; ++i) {
+		inds8[i] = src[i] % VERTS;
+		inds16[i] = src[i] % VERTS;
+		inds32[i] = src[i] % VERTS;
+	}
+
+	IndexGenerator gen;
+	static const struct {
+		const char *name;
+		int prim;
+	} prims[] = {
+		{ "list", GE_PRIM_TRIANGLES },
+		{ "strip", GE_PRIM_TRIANGLE_STRIP },
+		{ "fan", GE_PRIM_TRIANGLE_FAN },
+		{ "line strip", GE_PRIM_LINE_STRIP },
+		{ "rectangles", GE_PRIM_RECTANGLES },
+	};
+	for (const auto &p : prims) {
+		std::string name = StringFromFormat("IndexGenerator add %s", p.name);
+		runner.Run(name.c_str(), 0.0, [&] {
+			gen.Setup(buffer.data());
+			for (int i = 0; i < DRAWS; ++i)
+				gen.AddPrim(p.prim, VERTS, false);
+			benchmarkSink = gen.VertexCount();
+		});
+	}
+
+	runner.Run("IndexGenerator translate list u8", 0.0, [&] {
+		gen.Setup(buffer.data());
+		for (int i = 0; i < DRAWS; ++i) {
+			gen.TranslatePrim(GE_PRIM_TRIANGLES, VERTS, inds8.data(), 0, true);
+			gen.Advance(VERTS);
+		}
+		benchmarkSink = gen.VertexCount();
+	});
+	runner.Run("IndexGenerator translate list u16", 0.0, [&] {
+		gen.Setup(buffer.data());
+		for (int i = 0; i < DRAWS; ++i) {
+			gen.TranslatePrim(GE_PRIM_TRIANGLES, VERTS, inds16.data(), 0, true);
+			gen.Advance(VERTS);
+		}
+		benchmarkSink = gen.VertexCount();
+	});
+	runner.Run("IndexGenerator translate list u32", 0.0, [&] {
+		gen.Setup(buffer.data());
+		for (int i = 0; i < DRAWS; ++i) {
+			gen.TranslatePrim(GE_PRIM_TRIANGLES, VERTS, inds32.data(), 0, true);
+			gen.Advance(VERTS);
+		}
+		benchmarkSink = gen.VertexCount();
+	});
+}
+
+static void BenchMemory(BenchmarkRunner &runner) {
+	// About the size of PSP RAM, which is what savestates and rewind mostly copy.
+	static const size_t SIZE = 32 * 1024 * 1024;
+	std::vector<u8> src = RandomBytes(SIZE, 4);
+	std::vector<u8> dst(SIZE);
+
+	runner.Run("memcpy 32MB", SIZE, [&] {
+		memcpy(dst.data(), src.data(), SIZE);
+	});
+	runner.Run("ParallelMemcpy 32MB", SIZE, [&] {
+		ParallelMemcpy(&g_threadManager, dst.data(), src.data(), SIZE);
+	});
+
+	// Savestates are mostly zeros and repetitive data, so mix in a compressible pattern.
+	for (size_t i = 0; i < SIZE; i += 4096) {
+		size_t len = std::min((size_t)4096, SIZE - i);
+		if ((i / 4096) % 4 != 0)
+			memset(&src[i], (int)((i / 4096) & 0xFF), len);
+	}
+	std::vector<u8> compressed(CChunkFileReader::CompressBound(SIZE));
+	size_t compressedSize = 0;
+	runner.Run("Savestate zstd compress 32MB", SIZE, [&] {
+		compressedSize = CChunkFileReader::Compress(compressed.data(), compressed.size(), src.data(), SIZE);
+	});
+	if (compressedSize == 0) {
+		printf("Savestate zstd compress failed, skipping decompress\n");
+		return;
+	}
+	runner.Run("Savestate zstd decompress 32MB", SIZE, [&] {
+		benchmarkSink = CChunkFileReader::Decompress(dst.data(), SIZE, compressed.data(), compressedSize);
+	});
+}
+
+static void WriteBenchmarkJson(const std::vector<BenchmarkResult> &results, const char *filename) {
+	json::JsonWriter writer(json::JsonWriter::PRETTY);
+	writer.begin();
+	writer.writeString("cpu", cpu_info.brand_string);
+	writer.writeInt("threads", g_threadManager.GetNumLooperThreads());
+	writer.pushArray("results");
+	for (const BenchmarkResult &result : results) {
+		writer.pushDict();
+		writer.writeString("name", result.name);
+		writer.writeInt("samples", result.samples);
+		writer.writeInt("iterationsPerSample", result.iterationsPerSample);
+		writer.writeFloat("medianSeconds", result.medianSeconds);
+		writer.writeFloat("q1Seconds", result.q1Seconds);
+		writer.writeFloat("q3Seconds", result.q3Seconds);
+		if (result.bytesPerIteration > 0.0)
+			writer.writeFloat("bytesPerSecond", result.bytesPerIteration / result.medianSeconds);
+		writer.pop();
+	}
+	writer.pop();
+	writer.end();
+
+	if (!File::WriteStringToFile(true, writer.str(), Path(std::string(filename))))
+		fprintf(stderr, "Failed to write %s\n", filename);
+}
+
+int RunBenchmarks(int argc, const char *argv[]) {
+	const char *filter = nullptr;
+	const char *jsonFilename = nullptr;
+	for (int i = 0; i < argc; ++i) {
+		if (!strncmp(argv[i], "--json=", strlen("--json=")) && strlen(argv[i]) > strlen("--json="))
+			jsonFilename = argv[i] + strlen("--json=");
+		else
+			filter = argv[i];
+	}
+
+	if (!g_threadManager.IsInitialized())
+		g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+
+	BenchmarkRunner runner(filter);
+	BenchTextures(runner);
+	BenchVertexDecoder(runner);
+	BenchIRInterpreter(runner);
+	BenchAudio(runner);
+	BenchHashMaps(runner);
+	BenchIndexGenerator(runner);
+	BenchMemory(runner);
+
+	if (runner.Results().empty()) {
+		fprintf(stderr, "No benchmarks matched '%s'\n", filter ? filter : "");
+		return 1;
+	}
+	if (jsonFilename)
+		WriteBenchmarkJson(runner.Results(), jsonFilename);
+	return 0;
+}
@@ -174,6 +174,10 @@ bool TestJit() {
 	double jit_speed = 0.0, interp_speed = 0.0;
 	if (compileSuccess) {
 		interp_speed = ExecCPUTest();
+#if PPSSPP_ARCH(RISCV64)
+		// There's no direct RISC-V jit, only the native IR backend.
+		std::vector<std::string> lines;
+#else
 		mipsr4k.UpdateCore(CPUCore::JIT);
 		jit_speed = ExecCPUTest();
 
@@ -186,10 +190,9 @@ bool TestJit() {
 		std::vector<std::string> lines = DisassembleArm64(block->normalEntry, block->codeSize);
 #elif PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
 		std::vector<std::string> lines = DisassembleX86(block->normalEntry, block->codeSize);
-#elif PPSSPP_ARCH(RISCV64)
-		std::vector<std::string> lines = DisassembleRV64(block->normalEntry, block->codeSize);
 #else
 		std::vector<std::string> lines;
+#endif
 #endif
 		// Cut off at 25 due to the repetition above. Might need tweaking for large instructions.
 		const int cutoff = 25;
@@ -198,7 +201,26 @@ bool TestJit() {
 		}
 		if (lines.size() > cutoff)
 			printf("...\n");
-		printf("Jit was %fx faster than interp.\n\n", jit_speed / interp_speed);
+		if (jit_speed != 0.0)
+			printf("Jit was %fx faster than interp.\n\n", jit_speed / interp_speed);
+
+#if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(RISCV64)
+		// Also cover the native IR backend, the block is converted once it's hot.
+		mipsr4k.UpdateCore(CPUCore::JIT_IR);
+		double jit_ir_speed = ExecCPUTest();
+
+		JitBlockDebugInfo info = MIPSComp::jit->GetBlockCacheDebugInterface()->GetBlockDebugInfo(0);
+		for (int i = 0; i < std::min((int)info.targetDisasm.size(), cutoff); i++) {
+			printf("%s\n", info.targetDisasm[i].c_str());
+		}
+		if (info.targetDisasm.size() > cutoff)
+			printf("...\n");
+		if (info.targetDisasm.empty())
+			printf("ERROR: Block was not converted to native code\n");
+		printf("Jit using IR was %fx faster than interp.\n\n", jit_ir_speed / interp_speed);
+		if (jit_speed == 0.0)
+			jit_speed = jit_ir_speed;
+#endif
 	}
 
 	printf("\n");
@@ -69,6 +69,31 @@ bool TestArm64Emitter() {
 	fp.SMAX(16, D0, D3, D4);
 	RET(CheckLast(emitter, "0e646460 smax.16 d0, d3, d4"));
 
+	fp.ADD(16, Q0, Q1, Q2);
+	RET(CheckLast(emitter, "4e628420 add.16 q0, q1, q2"));
+	fp.SUB(32, D3, D4, D5);
+	RET(CheckLast(emitter, "2ea58483 sub.32 d3, d4, d5"));
+	fp.MUL(16, D0, D1, D2);
+	RET(CheckLast(emitter, "0e629c20 mul.16 d0, d1, d2"));
+	fp.MLA(16, Q0, Q1, Q2);
+	RET(CheckLast(emitter, "4e629420 mla.16 q0, q1, q2"));
+	fp.UQADD(8, D0, D1, D2);
+	RET(CheckLast(emitter, "2e220c20 uqadd.8 d0, d1, d2"));
+	fp.SQADD(16, D0, D1, D2);
+	RET(CheckLast(emitter, "0e620c20 sqadd.16 d0, d1, d2"));
+	fp.UQSUB(16, Q0, Q1, Q2);
+	RET(CheckLast(emitter, "6e622c20 uqsub.16 q0, q1, q2"));
+	fp.UABD(8, D0, D1, D2);
+	RET(CheckLast(emitter, "2e227420 uabd.8 d0, d1, d2"));
+	fp.CMEQ(32, Q0, Q1, Q2);
+	RET(CheckLast(emitter, "6ea28c20 cmeq.32 q0, q1, q2"));
+	fp.CMHI(16, D0, D1, D2);
+	RET(CheckLast(emitter, "2e623420 cmhi.16 d0, d1, d2"));
+	fp.BIC(Q0, Q1, Q2);
+	RET(CheckLast(emitter, "4e621c20 bic q0, q1, q2"));
+	fp.SQXTUN(16, D0, Q1);
+	RET(CheckLast(emitter, "2e612820 sqxtun.16.32 d0, q1"));
+
 	fp.SHL(32, D0, D3, 18);
 	RET(CheckLast(emitter, "0f325460 shl.32 d0, d3, #18"));
 	fp.USHR(16, Q0, Q3, 7);
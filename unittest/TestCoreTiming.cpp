@@ -0,0 +1,168 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <vector>
+
+#include "Common/Serialize/Serializer.h"
+#include "Common/TimeUtil.h"
+#include "Core/CoreTiming.h"
+#include "Core/MIPS/MIPS.h"
+
+#include "UnitTest.h"
+
+static std::vector<u64> firedEvents;
+static int orderEvent = -1;
+static int benchEvent = -1;
+static u32 benchSeed = 0;
+static int benchFired = 0;
+
+static void OrderCallback(u64 userdata, int cyclesLate) {
+	firedEvents.push_back(userdata);
+}
+
+static u32 NextBenchDelay() {
+	// Simple LCG, we just want a spread of alarm-like delays.
+	benchSeed = benchSeed * 1103515245 + 12345;
+	return 1000 + ((benchSeed >> 8) & 0xFFFF);
+}
+
+static void BenchCallback(u64 userdata, int cyclesLate) {
+	benchFired++;
+	CoreTiming::ScheduleEvent(NextBenchDelay(), benchEvent, userdata);
+}
+
+// Pretends the CPU ran until the next event, then runs it.
+static void RunToNextEvent() {
+	currentMIPS->downcount = 0;
+	CoreTiming::Advance();
+}
+
+static bool CheckOrder(const std::vector<u64> &expected) {
+	firedEvents.clear();
+	for (int i = 0; i < 16 && firedEvents.size() < expected.size(); ++i)
+		RunToNextEvent();
+	EXPECT_EQ_INT((int)firedEvents.size(), (int)expected.size());
+	for (size_t i = 0; i < expected.size(); ++i) {
+		EXPECT_EQ_INT((int)firedEvents[i], (int)expected[i]);
+	}
+	return true;
+}
+
+// Like the HLE modules, the events need to be registered again after any DoState.
+static void DoCoreTimingState(PointerWrap &p) {
+	CoreTiming::DoState(p);
+	CoreTiming::RestoreRegisterEvent(orderEvent, "TestCoreTimingOrder", &OrderCallback);
+	CoreTiming::RestoreRegisterEvent(benchEvent, "TestCoreTimingBench", &BenchCallback);
+}
+
+static std::vector<u8> SaveCoreTiming() {
+	u8 *ptr = nullptr;
+	PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+	DoCoreTimingState(measure);
+
+	std::vector<u8> data(measure.Offset());
+	ptr = data.data();
+	PointerWrap save(&ptr, PointerWrap::MODE_WRITE);
+	DoCoreTimingState(save);
+	return data;
+}
+
+static bool TestEventOrder() {
+	// Events at the same time must run in the order they were scheduled.
+	CoreTiming::ScheduleEvent(100000, orderEvent, 0);
+	CoreTiming::ScheduleEvent(50000, orderEvent, 1);
+	CoreTiming::ScheduleEvent(70000, orderEvent, 2);
+	CoreTiming::ScheduleEvent(50000, orderEvent, 3);
+	CoreTiming::ScheduleEvent_Threadsafe(60000, orderEvent, 4);
+	RET(CheckOrder({ 1, 3, 4, 2, 0 }));
+
+	CoreTiming::ScheduleEvent(30000, orderEvent, 5);
+	CoreTiming::ScheduleEvent(20000, orderEvent, 6);
+	CoreTiming::ScheduleEvent(40000, orderEvent, 7);
+	CoreTiming::ScheduleEvent(10000, orderEvent, 6);
+	EXPECT_TRUE(CoreTiming::IsScheduled(orderEvent));
+	// With duplicates, the result is from the one that would have run last.
+	EXPECT_EQ_INT((int)CoreTiming::UnscheduleEvent(orderEvent, 6), 20000);
+	EXPECT_EQ_INT((int)CoreTiming::UnscheduleEvent(orderEvent, 6), 0);
+	RET(CheckOrder({ 5, 7 }));
+
+	EXPECT_FALSE(CoreTiming::IsScheduled(orderEvent));
+	return true;
+}
+
+static bool TestEventState() {
+	for (int i = 0; i < 20; ++i)
+		CoreTiming::ScheduleEvent(5000 + (i % 7) * 1000, orderEvent, 100 + i);
+	CoreTiming::ScheduleEvent_Threadsafe(6500, orderEvent, 200);
+
+	std::vector<u8> saved = SaveCoreTiming();
+	std::vector<u64> expected;
+	for (int t = 0; t < 7; ++t) {
+		for (int i = t; i < 20; i += 7)
+			expected.push_back(100 + i);
+		if (t == 1)
+			expected.push_back(200);
+	}
+	RET(CheckOrder(expected));
+
+	u8 *ptr = saved.data();
+	PointerWrap load(&ptr, PointerWrap::MODE_READ);
+	DoCoreTimingState(load);
+	EXPECT_TRUE(load.error == PointerWrap::ERROR_NONE);
+
+	// Saving again must give the exact same bytes.
+	std::vector<u8> resaved = SaveCoreTiming();
+	EXPECT_TRUE(saved == resaved);
+	RET(CheckOrder(expected));
+	return true;
+}
+
+static void BenchmarkAdvance() {
+	const int pendingCounts[] = { 8, 64, 512 };
+	for (int pending : pendingCounts) {
+		benchSeed = 0x1234;
+		benchFired = 0;
+		for (int i = 0; i < pending; ++i)
+			CoreTiming::ScheduleEvent(NextBenchDelay(), benchEvent, i);
+
+		double st = time_now_d();
+		do {
+			for (int j = 0; j < 10000; ++j)
+				RunToNextEvent();
+		} while (time_now_d() - st < 0.5);
+		double elapsed = time_now_d() - st;
+
+		printf("CoreTiming::Advance with %d pending events: %0.2f M events/sec\n", pending, benchFired / elapsed / 1000000.0);
+		CoreTiming::RemoveAllEvents(benchEvent);
+	}
+}
+
+bool TestCoreTiming() {
+	currentMIPS = &mipsr4k;
+	CoreTiming::Init();
+	orderEvent = CoreTiming::RegisterEvent("TestCoreTimingOrder", &OrderCallback);
+	benchEvent = CoreTiming::RegisterEvent("TestCoreTimingBench", &BenchCallback);
+
+	bool success = TestEventOrder() && TestEventState();
+	if (success)
+		BenchmarkAdvance();
+
+	CoreTiming::Shutdown();
+	currentMIPS = nullptr;
+	return success;
+}
@@ -22,6 +22,7 @@
 #include "GPU/Software/DrawPixel.h"
 #include "GPU/Software/Sampler.h"
 #include "GPU/Software/SoftGpu.h"
+#include "unittest/UnitTest.h"
 
 static bool TestSamplerJit() {
 	using namespace Sampler;
@@ -161,6 +162,70 @@ static bool TestPixelJit() {
 	return successes == count && !HitAnyAsserts();
 }
 
+static bool TestJitPrecompile() {
+	using namespace Rasterizer;
+	using namespace Sampler;
+	GMRng rng;
+	BinManager binner;
+
+	PixelJitCache *pixelCache = new PixelJitCache();
+	SamplerJitCache *samplerCache = new SamplerJitCache();
+	for (int i = 0; i < 50; ) {
+		PixelFuncID pixelID;
+		pixelID.fullKey = (uint64_t)rng.R32() | ((uint64_t)rng.R32() << 32);
+		if (startsWith(DescribePixelFuncID(pixelID), "INVALID"))
+			continue;
+		SamplerID samplerID;
+		samplerID.fullKey = rng.R32();
+		samplerID.linear = false;
+		samplerID.fetch = false;
+		if (startsWith(DescribeSamplerID(samplerID), "INVALID"))
+			continue;
+		i++;
+
+		pixelCache->GetSingle(pixelID, &binner);
+		samplerCache->GetNearest(samplerID, &binner);
+	}
+
+	std::vector<uint64_t> pixelKeys;
+	std::vector<uint32_t> samplerKeys;
+	pixelCache->GetKeys(pixelKeys);
+	samplerCache->GetKeys(samplerKeys);
+	delete pixelCache;
+	delete samplerCache;
+
+	// A fresh cache should end up with the same funcs, and without needing a binner to compile.
+	pixelCache = new PixelJitCache();
+	samplerCache = new SamplerJitCache();
+	pixelCache->Precompile(pixelKeys);
+	samplerCache->Precompile(samplerKeys);
+
+	std::vector<uint64_t> pixelKeys2;
+	std::vector<uint32_t> samplerKeys2;
+	pixelCache->GetKeys(pixelKeys2);
+	samplerCache->GetKeys(samplerKeys2);
+
+	bool success = true;
+	for (uint64_t key : pixelKeys) {
+		PixelFuncID id;
+		id.fullKey = key;
+		if (!pixelCache->GetSingle(id, nullptr))
+			success = false;
+	}
+	for (uint32_t key : samplerKeys) {
+		SamplerID id;
+		id.fullKey = key;
+		if (!samplerCache->GetNearest(id, nullptr))
+			success = false;
+	}
+	delete pixelCache;
+	delete samplerCache;
+
+	EXPECT_EQ_INT((int)pixelKeys2.size(), (int)pixelKeys.size());
+	EXPECT_EQ_INT((int)samplerKeys2.size(), (int)samplerKeys.size());
+	return success && !HitAnyAsserts();
+}
+
 bool TestSoftwareGPUJit() {
 	g_Config.bSoftwareRenderingJit = true;
 	ResetHitAnyAsserts();
@@ -173,5 +238,9 @@ bool TestSoftwareGPUJit() {
 		return false;
 	}
 
+	if (!TestJitPrecompile()) {
+		return false;
+	}
+
 	return true;
 }
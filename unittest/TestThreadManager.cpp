@@ -4,6 +4,7 @@
 #include "Common/Log.h"
 #include "Common/TimeUtil.h"
 #include "Common/Thread/Barrier.h"
+#include "Common/Thread/TaskGraph.h"
 #include "Common/Thread/ThreadManager.h"
 #include "Common/Thread/Channel.h"
 #include "Common/Thread/Promise.h"
@@ -123,6 +124,68 @@ bool TestMultithreadedScheduling() {
 	return true;
 }
 
+static std::atomic<uint32_t> g_throughputSink;
+
+static void TinyRangeFunc(int lower, int upper) {
+	uint32_t sum = 0;
+	for (int i = lower; i < upper; ++i)
+		sum += (uint32_t)i * 2654435761U;
+	g_throughputSink += sum;
+}
+
+// Lots of tiny parallel loops, like the software renderer's bins.  Mostly measures scheduling overhead.
+bool TestSchedulingThroughput(ThreadManager *threadMan) {
+	const int LOOPS = 20000;
+	const int RANGE = 256;
+
+	g_throughputSink = 0;
+	auto start = Instant::Now();
+	for (int i = 0; i < LOOPS; ++i) {
+		ParallelRangeLoop(threadMan, TinyRangeFunc, 0, RANGE, 4);
+	}
+	double elapsed = start.Elapsed();
+
+	// Every loop should have covered the full range exactly once.
+	uint32_t expected = 0;
+	for (int i = 0; i < RANGE; ++i)
+		expected += (uint32_t)i * 2654435761U;
+	EXPECT_EQ_INT(g_throughputSink.load(), expected * (uint32_t)LOOPS);
+
+	printf("Throughput: %d loops in %0.3f s, %0.2f us per loop\n", LOOPS, elapsed, elapsed * 1000000.0 / LOOPS);
+	return true;
+}
+
+bool TestTaskGraph(ThreadManager *threadMan) {
+	// A diamond, each stage checking its inputs finished first, then a chain of continuations added while running.
+	std::atomic<int> a{ 0 }, b{ 0 }, c{ 0 }, d{ 0 };
+	std::atomic<int> chain{ 0 };
+	std::atomic<bool> ordered{ true };
+
+	TaskGraph graph(threadMan);
+	TaskGraph::Node *nodeA = graph.Add([&] { sleep_ms(10); a = 1; });
+	TaskGraph::Node *nodeB = graph.Add([&] { if (a != 1) ordered = false; b = 1; }, { nodeA });
+	TaskGraph::Node *nodeC = graph.Add([&] { if (a != 1) ordered = false; c = 1; }, { nodeA }, TaskType::IO_BLOCKING);
+	TaskGraph::Node *nodeD = graph.Add([&] { if (b != 1 || c != 1) ordered = false; d = 1; }, { nodeB, nodeC }, TaskType::CPU_COMPUTE, TaskPriority::HIGH);
+
+	TaskGraph::Node *prev = nodeD;
+	for (int i = 0; i < 100; ++i) {
+		prev = graph.Add([&, i] { if (chain != i) ordered = false; chain++; }, { prev });
+	}
+
+	graph.Wait(nodeD);
+	EXPECT_EQ_INT(d, 1);
+	graph.Wait();
+	EXPECT_TRUE(graph.IsDone(prev));
+	EXPECT_EQ_INT(chain, 100);
+	EXPECT_TRUE(ordered);
+
+	// Depending on already finished nodes should just run right away.
+	TaskGraph::Node *late = graph.Add([&] { chain++; }, { nodeA, nodeD });
+	graph.Wait(late);
+	EXPECT_EQ_INT(chain, 101);
+	return true;
+}
+
 bool TestThreadManager() {
 	ThreadManager manager;
 	manager.Init(8, 1);
@@ -151,5 +214,15 @@ bool TestThreadManager() {
 		return false;
 	}
 
+	if (!TestSchedulingThroughput(&manager)) {
+		return false;
+	}
+
+	if (!TestTaskGraph(&manager)) {
+		return false;
+	}
+
+	manager.Teardown();
+
 	return true;
 }
@@ -15,7 +15,9 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <cstring>
 #include <math.h>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/TimeUtil.h"
@@ -636,6 +638,40 @@ static bool TestVertexFloatSkin() {
 	return !dec.HasFailed();
 }
 
+// The jit decodes pairs of vertices per iteration for most formats, so check odd and even counts.
+static bool TestVertexMultiple() {
+	VertexDecoderTestHarness dec;
+	int vtype = GE_VTYPE_POS_FLOAT | GE_VTYPE_NRM_8BIT | GE_VTYPE_TC_16BIT | GE_VTYPE_COL_8888;
+	bool failed = false;
+
+	for (int count = 1; count <= 5; ++count) {
+		for (int i = 0; i < count; ++i) {
+			dec.Add16(1000 * i, 32767 - i);
+			dec.Add8(i, 2 * i, 3 * i, 255 - i);
+			dec.Add8(i, -i, 127);
+			dec.Add8(0);
+			dec.AddFloat(0.5f * i, -1.0f * i, 2.0f + i);
+		}
+
+		std::vector<u8> expected;
+		for (int jit = 0; jit <= 1; ++jit) {
+			memset(dec.GetData(), 0xCD, 64 * 6);
+			dec.Execute(vtype, count - 1, jit == 1);
+			// Include the next vertex, which shouldn't be touched.
+			size_t size = dec.GetDstStride() * (count + 1);
+			u8 *data = (u8 *)dec.GetData();
+			if (jit == 0) {
+				expected.assign(data, data + size);
+			} else if (memcmp(data, expected.data(), size) != 0) {
+				printf("TestVertexMultiple: jit mismatch with %d vertices\n", count);
+				failed = true;
+			}
+		}
+	}
+
+	return !dec.HasFailed() && !failed;
+}
+
 // TODO: Morph (col, pos, nrm), weights (no skin), morph + weights?
 
 typedef bool (*VertexTestFunc)();
@@ -657,6 +693,8 @@ static VertexTestFunc vertdecTestFuncs[] = {
 	&TestVertex8Skin,
 	&TestVertex16Skin,
 	&TestVertexFloatSkin,
+
+	&TestVertexMultiple,
 };
 
 bool TestVertexJit() {
@@ -25,7 +25,7 @@
 // Or just integrate with an existing testing framework.
 //
 // To use, set command line parameter to one or more of the tests below, or "all".
-// Search for "availableTests".
+// Search for "availableTests". Use "bench" to run the microbenchmarks in Benchmarks.cpp.
 
 #include "ppsspp_config.h"
 
@@ -33,6 +33,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
+#include <limits>
 #include <vector>
 #include <string>
 #include <sstream>
@@ -41,8 +43,11 @@
 #include <jni.h>
 #endif
 
+#include "Common/Data/Collections/Hashmaps.h"
+#include "Common/Data/Collections/LinearArena.h"
 #include "Common/Data/Collections/TinySet.h"
 #include "Common/Data/Convert/SmallDataConvert.h"
+#include "Common/Data/Hash/Hash.h"
 #include "Common/Data/Text/Parsers.h"
 #include "Common/Data/Text/WrapText.h"
 #include "Common/Data/Encoding/Utf8.h"
@@ -57,15 +62,22 @@
 #include "Common/BitScan.h"
 #include "Common/CPUDetect.h"
 #include "Common/Log.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/FileSystems/ISOFileSystem.h"
+#include "Core/HW/SasAudio.h"
+#include "Core/HW/SasReverb.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
+#include "Core/Util/AudioFormat.h"
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/Common/GPUStateUtils.h"
+#include "GPU/Common/IndexGenerator.h"
 
 #include "android/jni/AndroidContentURI.h"
 
+#include "zlib.h"
+
 #include "unittest/JitHarness.h"
 #include "unittest/TestVertexJit.h"
 #include "unittest/UnitTest.h"
@@ -350,6 +362,80 @@ bool TestTinySet() {
 	return true;
 }
 
+bool TestSwissHashMap() {
+	// Few enough slots that removals have to shift entries across the wrap-around.
+	SwissPrehashMap<uintptr_t, 0> map(16);
+	for (uint32_t i = 0; i < 12; i++) {
+		EXPECT_TRUE(map.Insert(i * 16 + 15, i + 1));
+	}
+	EXPECT_EQ_INT((int)map.size(), 12);
+	EXPECT_TRUE(map.Remove(15));
+	EXPECT_TRUE(map.Remove(16 * 5 + 15));
+	EXPECT_FALSE(map.Remove(15));
+	for (uint32_t i = 0; i < 12; i++) {
+		uintptr_t expected = i == 0 || i == 5 ? 0 : i + 1;
+		EXPECT_EQ_INT((int)map.Get(i * 16 + 15), (int)expected);
+	}
+
+	// Removing during iteration is deferred, and everything should still be visited once.
+	int visited = 0;
+	map.Iterate([&](uint32_t hash, uintptr_t value) {
+		visited++;
+		if (value & 1)
+			map.Remove(hash);
+	});
+	EXPECT_EQ_INT(visited, 10);
+	EXPECT_EQ_INT((int)map.size(), 5);
+	for (uint32_t i = 0; i < 12; i++) {
+		uintptr_t expected = i == 0 || i == 5 || ((i + 1) & 1) ? 0 : i + 1;
+		EXPECT_EQ_INT((int)map.Get(i * 16 + 15), (int)expected);
+	}
+
+	SwissHashMap<uint64_t, uintptr_t, 0> keyed(16);
+	for (uint64_t i = 0; i < 1000; i++)
+		keyed.Insert(i * 0x100000001ULL, (uintptr_t)i + 1);
+	for (uint64_t i = 0; i < 1000; i += 2)
+		keyed.Remove(i * 0x100000001ULL);
+	EXPECT_EQ_INT((int)keyed.size(), 500);
+	for (uint64_t i = 0; i < 1000; i++) {
+		uintptr_t expected = (i & 1) ? (uintptr_t)i + 1 : 0;
+		EXPECT_EQ_INT((int)keyed.Get(i * 0x100000001ULL), (int)expected);
+	}
+	return true;
+}
+
+bool TestLinearArena() {
+	LinearArena arena(256);
+	uint8_t *a = (uint8_t *)arena.Allocate(10);
+	uint8_t *b = (uint8_t *)arena.Allocate(10, 64);
+	EXPECT_EQ_INT((int)((uintptr_t)a & 15), 0);
+	EXPECT_EQ_INT((int)((uintptr_t)b & 63), 0);
+	EXPECT_TRUE(b >= a + 10);
+
+	// Only the last allocation can be given back.
+	arena.Free(a, 10);
+	size_t used = arena.BytesUsed();
+	arena.Free(b, 10);
+	EXPECT_TRUE(arena.BytesUsed() < used);
+
+	// Spilling into more blocks, which should be merged into one on Reset().
+	ArenaVector<int> values{ ArenaAllocator<int>(arena) };
+	for (int i = 0; i < 1000; i++)
+		values.push_back(i);
+	EXPECT_EQ_INT(values[999], 999);
+	size_t reserved = arena.BytesReserved();
+	EXPECT_TRUE(reserved > 256);
+	values.clear();
+	values.shrink_to_fit();
+
+	arena.Reset();
+	EXPECT_EQ_INT((int)arena.BytesUsed(), 0);
+	EXPECT_EQ_INT((int)arena.BytesReserved(), (int)reserved);
+	arena.Allocate(reserved / 2);
+	EXPECT_EQ_INT((int)arena.BytesReserved(), (int)reserved);
+	return true;
+}
+
 bool TestVFPUSinCos() {
 	float sine, cosine;
 	InitVFPUSinCos();
@@ -389,6 +475,59 @@ bool TestVFPUSinCos() {
 	return true;
 }
 
+static float RandomVFPUTestFloat(uint32_t &seed) {
+	seed = seed * 1664525 + 1013904223;
+	switch (seed >> 28) {
+	case 0: return 0.0f;
+	case 1: return -0.0f;
+	case 2: return (seed & 0x100) ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+	case 3: return (seed & 0x100) ? 1e-40f : -1e-40f;
+	default: break;
+	}
+	// Spread the exponents around, so rounding and cancellation both happen.
+	float f = (float)(int)(seed & 0xFFFFF) / (float)0x80000 - 1.0f;
+	return ldexpf(f, (int)((seed >> 20) & 0x3F) - 32);
+}
+
+static uint32_t VFPUTestBits(float f) {
+	uint32_t u;
+	memcpy(&u, &f, sizeof(u));
+	return u;
+}
+
+bool TestVFPUMatrixKernels() {
+	uint32_t seed = 0x12345678;
+	for (int iter = 0; iter < 2000; iter++) {
+		float s[16], t[16], d[16];
+		for (int i = 0; i < 16; i++) {
+			s[i] = RandomVFPUTestFloat(seed);
+			t[i] = RandomVFPUTestFloat(seed);
+		}
+
+		// These mirror the loops in Int_Vmmul and Int_Vtfm.
+		vfpu_mmul_q(d, s, t);
+		for (int a = 0; a < 4; a++) {
+			for (int b = 0; b < 4; b++) {
+				float sum = 0.0f;
+				for (int c = 0; c < 4; c++) {
+					sum += s[b * 4 + c] * t[a * 4 + c];
+				}
+				EXPECT_EQ_HEX(VFPUTestBits(d[a * 4 + b]), VFPUTestBits(sum));
+			}
+		}
+
+		vfpu_tfm_q(d, s, t);
+		for (int i = 0; i < 4; i++) {
+			float sum = s[i * 4] * t[0];
+			for (int k = 1; k < 4; k++) {
+				sum += s[i * 4 + k] * t[k];
+			}
+			EXPECT_EQ_HEX(VFPUTestBits(d[i]), VFPUTestBits(sum));
+		}
+	}
+	return true;
+}
+
 bool TestMatrixTranspose() {
 	MatrixSize sz = M_4x4;
 	int matrix = 0;  // M000
@@ -546,6 +685,160 @@ bool TestQuickTexHash() {
 	}
 	EXPECT_EQ_HEX(StableQuickTexHash(buf, BUF_SIZE), 0x58de8dbc);
 
+	// CacheTexHash isn't stable between CPUs, so just check it notices changes, including in the tail.
+	const u32 cacheHash = CacheTexHash(buf, BUF_SIZE);
+	EXPECT_EQ_HEX(CacheTexHash(buf, BUF_SIZE), cacheHash);
+	for (int i : { 0, 9, 511, BUF_SIZE - 33, BUF_SIZE - 1 }) {
+		char *p = buf;
+		p[i] ^= 0x10;
+		EXPECT_TRUE(CacheTexHash(buf, BUF_SIZE) != cacheHash);
+		EXPECT_TRUE(CacheTexHash(buf, BUF_SIZE - 3) != CacheTexHash(buf, BUF_SIZE - 2));
+		p[i] ^= 0x10;
+	}
+
+	// A 512x512 CLUT8 texture, the common worst case when rehashing every frame.
+	static const int BENCH_SIZE = 512 * 512;
+	AlignedMem bench(BENCH_SIZE, 16);
+	memset(bench, 0x5A, BENCH_SIZE);
+	auto benchmark = [&](const char *name, u32 (*func)(const void *, u32)) {
+		u32 sum = 0;
+		int count = 0;
+		double st = time_now_d();
+		do {
+			for (int j = 0; j < 100; ++j)
+				sum += func(bench, BENCH_SIZE);
+			count += 100;
+		} while (time_now_d() - st < 0.25);
+		double elapsed = time_now_d() - st;
+		printf("%s: %0.2f GB/sec (%08x)\n", name, (double)BENCH_SIZE * count / elapsed / 1000000000.0, sum);
+	};
+	benchmark("StableQuickTexHash", &StableQuickTexHash);
+	benchmark("CacheTexHash", &CacheTexHash);
+
+	return true;
+}
+
+bool TestCrc32() {
+	static const int BUF_SIZE = 4096 + 64;
+	std::vector<u8> buf(BUF_SIZE);
+	u32 j = 91;
+	for (int i = 0; i < BUF_SIZE; ++i) {
+		j = j * 1103515245 + 12345;
+		buf[i] = (u8)(j >> 16);
+	}
+
+	// Must match zlib for any length and alignment, whichever path gets picked.
+	for (int len : { 0, 1, 15, 16, 63, 64, 65, 80, 127, 129, 1000, 4096 }) {
+		for (int off : { 0, 1, 7 }) {
+			const u32 expected = (u32)crc32(0x1234ABCD, &buf[off], len);
+			EXPECT_EQ_HEX(hash::Crc32(0x1234ABCD, &buf[off], len), expected);
+		}
+	}
+
+	// Chaining must also work.
+	const u32 whole = hash::Crc32(0, buf.data(), BUF_SIZE);
+	EXPECT_EQ_HEX(hash::Crc32(hash::Crc32(0, buf.data(), 100), &buf[100], BUF_SIZE - 100), whole);
+	EXPECT_EQ_HEX(whole, (u32)crc32(0, buf.data(), BUF_SIZE));
+	return true;
+}
+
+bool TestAudioMix() {
+	// One full SAS grain plus some odd tail, like a voice starting after its keyon delay.
+	static const int COUNT = 2048 + 13;
+	std::vector<s16> samples(COUNT);
+	u32 j = 17;
+	for (int i = 0; i < COUNT; ++i) {
+		j = j * 1103515245 + 12345;
+		samples[i] = (s16)(j >> 16);
+	}
+	samples[0] = -32768;
+	samples[1] = 32767;
+
+	std::vector<int> mixed(COUNT * 2, 1234);
+	std::vector<int> expected(COUNT * 2, 1234);
+	for (int vol : { 0x1000, -0x1000, 0x0FFF, 0x123, -0x8000 }) {
+		AccumulateStereoVolume12(mixed.data(), samples.data(), COUNT, vol, 0x1000 - vol);
+		for (int i = 0; i < COUNT; ++i) {
+			expected[i * 2] += (samples[i] * vol) >> 12;
+			expected[i * 2 + 1] += (samples[i] * (0x1000 - vol)) >> 12;
+		}
+		for (int i = 0; i < COUNT * 2; ++i) {
+			EXPECT_EQ_INT(mixed[i], expected[i]);
+		}
+	}
+
+	// The sceAudio channel mix: widen, accumulate, then saturate back down.
+	std::vector<s32> wide(COUNT, 1234);
+	std::vector<s16> narrow(COUNT);
+	ConvertS16ToS32(wide.data(), samples.data(), COUNT);
+	for (int k = 0; k < 3; ++k)
+		AccumulateS16ToS32(wide.data(), samples.data(), COUNT);
+	ClampS32ToS16(narrow.data(), wide.data(), COUNT);
+	for (int i = 0; i < COUNT; ++i) {
+		EXPECT_EQ_INT(wide[i], samples[i] * 4);
+		EXPECT_EQ_INT(narrow[i], clamp_s16(samples[i] * 4));
+	}
+
+	// 32 voices of the largest grain, roughly a worst case frame of sceSasCore.
+	int sum = 0;
+	int count = 0;
+	double st = time_now_d();
+	do {
+		std::fill(mixed.begin(), mixed.end(), 0);
+		for (int v = 0; v < 32; ++v)
+			AccumulateStereoVolume12(mixed.data(), samples.data(), 2048, 0x800 + v, 0x800 - v);
+		sum += mixed[count & 1023];
+		count++;
+	} while (time_now_d() - st < 0.25);
+	double elapsed = time_now_d() - st;
+	printf("AccumulateStereoVolume12: %0.2f Msamples/sec (%08x)\n", 32.0 * 2048 * count / elapsed / 1000000.0, sum);
+	return true;
+}
+
+bool TestSasReverb() {
+	const int oldReverbVolume = g_Config.iReverbVolume;
+	g_Config.iReverbVolume = 10;
+
+	// Grain sizes vary, so feed a few odd sizes through to cross block boundaries.
+	static const int MAX_SAMPLES = 1024;
+	std::vector<s16> input(MAX_SAMPLES * 2);
+	std::vector<s16> blockOutput(MAX_SAMPLES * 4);
+	std::vector<s16> refOutput(MAX_SAMPLES * 4);
+	for (int preset = PSP_SAS_EFFECT_TYPE_ROOM; preset <= PSP_SAS_EFFECT_TYPE_MAX; ++preset) {
+		SasReverb blocks;
+		SasReverb reference;
+		blocks.SetPreset(preset);
+		reference.SetPreset(preset);
+		reference.SetUseBlocks(false);
+
+		u32 j = 17;
+		double blockTime = 0.0;
+		double refTime = 0.0;
+		for (int grain = 0; grain < 400; ++grain) {
+			int samples = 32 + (grain % 16) * 61;
+			for (int i = 0; i < samples * 2; ++i) {
+				j = j * 1103515245 + 12345;
+				// Silence now and then, to let the tail ring out.
+				input[i] = grain % 50 < 10 ? 0 : (s16)(j >> 16);
+			}
+
+			double st = time_now_d();
+			blocks.ProcessReverb(blockOutput.data(), input.data(), samples, 0x8000, 0x7000);
+			double mid = time_now_d();
+			reference.ProcessReverb(refOutput.data(), input.data(), samples, 0x8000, 0x7000);
+			blockTime += mid - st;
+			refTime += time_now_d() - mid;
+
+			if (memcmp(blockOutput.data(), refOutput.data(), samples * 4 * sizeof(s16)) != 0) {
+				printf("Reverb mismatch: preset %d, grain %d\n", preset, grain);
+				g_Config.iReverbVolume = oldReverbVolume;
+				return false;
+			}
+		}
+		printf("%s: %0.2f ms (per sample loop: %0.2f ms)\n", SasReverb::GetPresetName(preset), blockTime * 1000.0, refTime * 1000.0);
+	}
+
+	g_Config.iReverbVolume = oldReverbVolume;
 	return true;
 }
 
@@ -797,6 +1090,111 @@ static bool TestSmallDataConvert() {
 	return true;
 }
 
+// Straightforward versions of what IndexGenerator should output, for each primitive.
+static void ReferenceIndices(std::vector<u16> &out, int prim, int count, bool clockwise, int start, const int *inds) {
+	auto at = [&](int i) { return (u16)(start + (inds ? inds[i] : i)); };
+	const int v1 = clockwise ? 1 : 2;
+	const int v2 = clockwise ? 2 : 1;
+	switch (prim) {
+	case GE_PRIM_POINTS:
+		for (int i = 0; i < count; i++)
+			out.push_back(at(i));
+		break;
+	case GE_PRIM_LINES:
+	case GE_PRIM_RECTANGLES:
+		for (int i = 0; i < (count & ~1); i++)
+			out.push_back(at(i));
+		break;
+	case GE_PRIM_LINE_STRIP:
+		for (int i = 0; i < count - 1; i++) {
+			out.push_back(at(i));
+			out.push_back(at(i + 1));
+		}
+		break;
+	case GE_PRIM_TRIANGLES:
+		for (int i = 0; i + 3 <= count; i += 3) {
+			out.push_back(at(i));
+			out.push_back(at(i + v1));
+			out.push_back(at(i + v2));
+		}
+		break;
+	case GE_PRIM_TRIANGLE_STRIP:
+		for (int i = 0; i < count - 2; i++) {
+			bool flip = (i & 1) != 0;
+			out.push_back(at(i));
+			out.push_back(at(i + (flip ? v2 : v1)));
+			out.push_back(at(i + (flip ? v1 : v2)));
+		}
+		break;
+	case GE_PRIM_TRIANGLE_FAN:
+		for (int i = 0; i < count - 2; i++) {
+			out.push_back(at(0));
+			out.push_back(at(i + v1));
+			out.push_back(at(i + v2));
+		}
+		break;
+	}
+}
+
+static bool TestIndexGenerator() {
+	// Some slack, since strips may write a bit past the end.
+	std::vector<u16> buffer(4096);
+	std::vector<u16> expected;
+	std::vector<int> source(512);
+	for (size_t i = 0; i < source.size(); i++)
+		source[i] = (int)((i * 37) % 251);
+	u8 inds8[512];
+	u16_le inds16[512];
+	u32_le inds32[512];
+	for (size_t i = 0; i < source.size(); i++) {
+		inds8[i] = (u8)source[i];
+		inds16[i] = (u16)source[i];
+		inds32[i] = (u32)source[i];
+	}
+
+	IndexGenerator gen;
+	for (int prim = GE_PRIM_POINTS; prim <= GE_PRIM_RECTANGLES; prim++) {
+		for (int count : { 0, 1, 3, 5, 24, 26, 49, 100, 301 }) {
+			for (bool clockwise : { true, false }) {
+				// Start at a non-zero index, and with data already in the buffer.
+				const int start = 7;
+				for (int type = 0; type < 4; type++) {
+					gen.Setup(buffer.data());
+					gen.AddPrim(GE_PRIM_POINTS, start, true);
+					expected.clear();
+					ReferenceIndices(expected, GE_PRIM_POINTS, start, true, 0, nullptr);
+
+					const int *ref = type == 0 ? nullptr : source.data();
+					if (type == 0) {
+						gen.AddPrim(prim, count, clockwise);
+					} else if (type == 1) {
+						gen.TranslatePrim(prim, count, inds8, 0, clockwise);
+					} else if (type == 2) {
+						gen.TranslatePrim(prim, count, inds16, 0, clockwise);
+					} else {
+						gen.TranslatePrim(prim, count, inds32, 0, clockwise);
+					}
+					ReferenceIndices(expected, prim, count, clockwise, start, ref);
+
+					bool partial = (prim == GE_PRIM_TRIANGLES && count % 3 != 0) || (prim == GE_PRIM_LINES && count % 2 != 0);
+					if (type == 0 && partial) {
+						// AddList() and AddLineList() count partial prims as used verts, skip those.
+						continue;
+					}
+					EXPECT_EQ_INT(gen.VertexCount(), (int)expected.size());
+					for (size_t i = 0; i < expected.size(); i++) {
+						if (buffer[i] != expected[i]) {
+							printf("prim %d count %d cw %d type %d: index %d is %d, expected %d\n", prim, count, clockwise ? 1 : 0, type, (int)i, buffer[i], expected[i]);
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
 float DepthSliceFactor(u32 useFlags);
 
 static bool TestDepthMath() {
@@ -854,6 +1252,8 @@ bool TestShaderGenerators();
 bool TestSoftwareGPUJit();
 bool TestIRPassSimplify();
 bool TestThreadManager();
+bool TestCoreTiming();
+int RunBenchmarks(int argc, const char *argv[]);
 
 TestItem availableTests[] = {
 #if PPSSPP_ARCH(ARM64) || PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
@@ -872,6 +1272,7 @@ TestItem availableTests[] = {
 	TEST_ITEM(Asin),
 	TEST_ITEM(SinCos),
 	TEST_ITEM(VFPUSinCos),
+	TEST_ITEM(VFPUMatrixKernels),
 	TEST_ITEM(MathUtil),
 	TEST_ITEM(Parsers),
 	TEST_ITEM(IRPassSimplify),
@@ -879,6 +1280,9 @@ TestItem availableTests[] = {
 	TEST_ITEM(MatrixTranspose),
 	TEST_ITEM(ParseLBN),
 	TEST_ITEM(QuickTexHash),
+	TEST_ITEM(Crc32),
+	TEST_ITEM(AudioMix),
+	TEST_ITEM(SasReverb),
 	TEST_ITEM(CLZ),
 	TEST_ITEM(MemMap),
 	TEST_ITEM(ShaderGenerators),
@@ -886,10 +1290,14 @@ TestItem availableTests[] = {
 	TEST_ITEM(Path),
 	TEST_ITEM(AndroidContentURI),
 	TEST_ITEM(ThreadManager),
+	TEST_ITEM(CoreTiming),
 	TEST_ITEM(WrapText),
 	TEST_ITEM(TinySet),
+	TEST_ITEM(SwissHashMap),
+	TEST_ITEM(LinearArena),
 	TEST_ITEM(SmallDataConvert),
 	TEST_ITEM(DepthMath),
+	TEST_ITEM(IndexGenerator),
 };
 
 int main(int argc, const char *argv[]) {
@@ -899,6 +1307,9 @@ int main(int argc, const char *argv[]) {
 	cpu_info.bVFPv4 = true;
 	g_Config.bEnableLogging = true;
 
+	if (argc >= 2 && !strcasecmp(argv[1], "bench"))
+		return RunBenchmarks(argc - 2, argv + 2);
+
 	bool allTests = false;
 	TestFunc testFunc = nullptr;
 	if (argc >= 2) {
@@ -937,6 +1348,8 @@ int main(int argc, const char *argv[]) {
 		for (auto f : availableTests) {
 			fprintf(stderr, "  * %s\n", f.name);
 		}
+		fprintf(stderr, "\n");
+		fprintf(stderr, "Or \"bench [filter] [--json=FILE]\" to run benchmarks.\n");
 		return 1;
 	} else {
 		if (!testFunc()) {